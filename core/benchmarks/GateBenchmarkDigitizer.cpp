@@ -0,0 +1,147 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "G4DynamicParticle.hh"
+#include "G4Gamma.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "GateBenchmarkHelpers.h"
+#include "digitizer/GateDigiCollection.h"
+#include "digitizer/GateDigiCollectionManager.h"
+#include "digitizer/GateDigiEventBuffer.h"
+#include "digitizer/GateDigitizerAdderActor.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+
+using namespace pybind11::literals;
+
+// Digitizer: hits collection filled at each step (FillHits), grouping of the
+// hits of an event per volume (adder) and filling of the ROOT tuple
+
+namespace {
+// typical attribute sets: dose-like scoring, and detector hits (with the
+// volume ID used by the adder)
+const std::vector<std::string> basic_attributes = {
+    "TotalEnergyDeposit", "PostPosition", "GlobalTime",
+    "PreKineticEnergy",   "TrackID",      "Weight"};
+const std::vector<std::string> detector_attributes = {
+    "TotalEnergyDeposit", "PostPosition", "GlobalTime",
+    "PreStepUniqueVolumeID"};
+
+// The collections are created once (the names must be unique), the
+// benchmark functions are called several times
+GateDigiCollection *GetCollection(const std::string &name,
+                                  const std::vector<std::string> &attributes,
+                                  const std::string &filename = "") {
+  static std::map<std::string, GateDigiCollection *> collections;
+  auto it = collections.find(name);
+  if (it != collections.end())
+    return it->second;
+  auto *hc = GateDigiCollectionManager::GetInstance()->NewDigiCollection(name);
+  hc->SetFilenameAndInitRoot(filename);
+  hc->InitDigiAttributesFromNames(attributes);
+  hc->RootInitializeTupleForMaster();
+  collections[name] = hc;
+  return hc;
+}
+
+// A step of a 140 keV gamma, its pre step point is in one of the crystals
+struct BenchmarkStep {
+  G4Step fStep;
+  G4Track *fTrack;
+  std::vector<G4TouchableHandle> fHandles;
+  std::vector<G4ThreeVector> fPositions;
+
+  BenchmarkStep() {
+    auto *particle =
+        new G4DynamicParticle(G4Gamma::Definition(), G4ThreeVector(0, 0, 1),
+                              140 * keV);
+    fTrack = new G4Track(particle, 0, G4ThreeVector());
+    fTrack->SetTrackID(1);
+    fTrack->SetParentID(0);
+    fStep.SetTrack(fTrack);
+    fStep.SetTotalEnergyDeposit(20 * keV);
+    fStep.GetPreStepPoint()->SetKineticEnergy(140 * keV);
+    fStep.GetPostStepPoint()->SetKineticEnergy(120 * keV);
+    fStep.GetPostStepPoint()->SetGlobalTime(1 * ns);
+    // (the handles own copies of the touchables)
+    for (const auto &c : BenchmarkCrystalTouchables(16))
+      fHandles.emplace_back(new G4TouchableHistory(*c->GetHistory()));
+    fPositions = BenchmarkRandomPoints(1 << 12, 3 * cm, 3 * cm, 10 * cm);
+  }
+
+  ~BenchmarkStep() { delete fTrack; }
+
+  // the i-th hit: position and crystal (several hits per crystal)
+  G4Step *Get(size_t i, int hits_per_crystal = 4) {
+    fStep.GetPostStepPoint()->SetPosition(
+        fPositions[i & (fPositions.size() - 1)]);
+    auto c = (i / hits_per_crystal * 7919) % fHandles.size();
+    fStep.GetPreStepPoint()->SetTouchableHandle(fHandles[c]);
+    return &fStep;
+  }
+};
+} // namespace
+
+static void BM_FillHits(benchmark::State &state) {
+  BenchmarkStep step;
+  auto *hc = state.range(0) == 0
+                 ? GetCollection("benchmark_basic", basic_attributes)
+                 : GetCollection("benchmark_detector", detector_attributes);
+  // clear every 1000 hits, as the actor does every clear_every events
+  size_t i = 0;
+  for (auto _ : state) {
+    hc->FillHits(step.Get(i));
+    if (++i % 1000 == 0)
+      hc->FillToRootIfNeeded(true);
+  }
+  hc->FillToRootIfNeeded(true);
+  state.SetItemsProcessed(state.iterations());
+}
+// basic and detector attributes
+BENCHMARK(BM_FillHits)->Arg(0)->Arg(1);
+
+static void BM_AdderGrouping(benchmark::State &state) {
+  // events of n hits, 4 hits per crystal (EnergyWinnerPosition)
+  const auto n = static_cast<size_t>(state.range(0));
+  BenchmarkStep step;
+  auto *hc = GetCollection("benchmark_adder", detector_attributes);
+  hc->FillToRootIfNeeded(true);
+  for (size_t i = 0; i < n; i++)
+    hc->FillHits(step.Get(i));
+  py::dict user_info("name"_a = "benchmark_adder_actor");
+  GateDigitizerAdderActor adder(user_info);
+  GateDigiEventBuffer buffer;
+  for (auto _ : state) {
+    buffer.Reset(hc, 0, n);
+    adder.ProcessEventBuffer(buffer);
+    benchmark::DoNotOptimize(buffer.GetSize());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_AdderGrouping)->Arg(16)->Arg(256);
+
+static void BM_FillToRoot(benchmark::State &state) {
+  // hits written in a ROOT tuple (in the temporary folder), by batches of n
+  // (the file is not closed: only the filling is measured)
+  const auto n = static_cast<size_t>(state.range(0));
+  auto path = std::filesystem::temp_directory_path() / "gate_benchmark.root";
+  BenchmarkStep step;
+  auto *hc = GetCollection("benchmark_root", basic_attributes, path.string());
+  size_t i = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (size_t k = 0; k < n; k++)
+      hc->FillHits(step.Get(i++));
+    state.ResumeTiming();
+    hc->FillToRootIfNeeded(true);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_FillToRoot)->Arg(1000);
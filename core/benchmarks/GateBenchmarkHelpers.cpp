@@ -0,0 +1,78 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateBenchmarkHelpers.h"
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4NistManager.hh"
+#include "G4PVPlacement.hh"
+#include "G4SystemOfUnits.hh"
+#include <random>
+
+std::vector<G4ThreeVector> BenchmarkRandomPoints(size_t n, double hx,
+                                                 double hy, double hz) {
+  std::mt19937_64 engine(42);
+  std::uniform_real_distribution<double> u(-1.0, 1.0);
+  std::vector<G4ThreeVector> points(n);
+  for (auto &p : points)
+    p.set(u(engine) * hx, u(engine) * hy, u(engine) * hz);
+  return points;
+}
+
+std::vector<std::shared_ptr<G4TouchableHistory>>
+BenchmarkCrystalTouchables(int n) {
+  // the volumes are owned by the Geant4 stores
+  static G4VPhysicalVolume *world_pv = nullptr;
+  static int crystals = 0;
+  const double crystal_size = 4 * mm;
+  const double module_size = n * crystal_size;
+  if (world_pv == nullptr || crystals != n) {
+    auto *air = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
+    auto *bgo = G4NistManager::Instance()->FindOrBuildMaterial("G4_BGO");
+    auto *world_box = new G4Box("world", 1 * m, 1 * m, 1 * m);
+    auto *world_lv = new G4LogicalVolume(world_box, air, "world");
+    world_pv = new G4PVPlacement(nullptr, G4ThreeVector(), world_lv, "world",
+                                 nullptr, false, 0);
+    auto *module_box = new G4Box("module", module_size / 2, module_size / 2,
+                                 crystal_size / 2);
+    auto *module_lv = new G4LogicalVolume(module_box, air, "module");
+    auto *crystal_box = new G4Box("crystal", crystal_size / 2,
+                                  crystal_size / 2, crystal_size / 2);
+    auto *crystal_lv = new G4LogicalVolume(crystal_box, bgo, "crystal");
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        G4ThreeVector t((i + 0.5) * crystal_size - module_size / 2,
+                        (j + 0.5) * crystal_size - module_size / 2, 0);
+        new G4PVPlacement(nullptr, t, crystal_lv, "crystal", module_lv, false,
+                          i * n + j);
+      }
+    }
+    for (int k = 0; k < 2; k++) {
+      G4ThreeVector t(0, 0, (k == 0 ? -1 : 1) * 10 * cm);
+      new G4PVPlacement(nullptr, t, module_lv, "module", world_lv, false, k);
+    }
+    crystals = n;
+  }
+
+  // one touchable per crystal
+  G4Navigator navigator;
+  navigator.SetWorldVolume(world_pv);
+  std::vector<std::shared_ptr<G4TouchableHistory>> touchables;
+  for (int k = 0; k < 2; k++) {
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        G4ThreeVector p((i + 0.5) * crystal_size - module_size / 2,
+                        (j + 0.5) * crystal_size - module_size / 2,
+                        (k == 0 ? -1 : 1) * 10 * cm);
+        navigator.LocateGlobalPointAndSetup(p);
+        touchables.emplace_back(navigator.CreateTouchableHistory());
+      }
+    }
+  }
+  return touchables;
+}
@@ -0,0 +1,27 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateBenchmarkHelpers_h
+#define GateBenchmarkHelpers_h
+
+#include "G4ThreeVector.hh"
+#include "G4TouchableHistory.hh"
+#include <memory>
+#include <vector>
+
+// Uniform random points in a box of half size [hx, hy, hz] (fixed seed: the
+// benchmarks always process the same points)
+std::vector<G4ThreeVector> BenchmarkRandomPoints(size_t n, double hx,
+                                                 double hy, double hz);
+
+// Touchables of the crystals of a small detector: a world with n x n
+// crystals placed in a module, the module being placed twice (the touchables
+// have a depth of 2). The geometry is built once and kept until the end.
+std::vector<std::shared_ptr<G4TouchableHistory>>
+BenchmarkCrystalTouchables(int n);
+
+#endif // GateBenchmarkHelpers_h
@@ -0,0 +1,121 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "G4SystemOfUnits.hh"
+#include "GateBenchmarkHelpers.h"
+#include "GateHelpersImage.h"
+#include <benchmark/benchmark.h>
+
+// Scoring in an image: voxel index of a (random) hit, then add a value in
+// the image, as the DoseActor does at each step
+
+typedef itk::Image<double, 3> ImageType;
+
+namespace {
+const double spacing = 2 * mm;
+// power of two: the index of the next point is a mask
+const size_t nb_points = 1 << 16;
+
+// image of size^3 voxels centered on the origin
+ImageType::Pointer CreateImage(int size) {
+  auto image = ImageType::New();
+  ImageType::SizeType s;
+  s.Fill(size);
+  ImageType::RegionType region;
+  region.SetSize(s);
+  image->SetRegions(region);
+  ImageType::SpacingType sp;
+  sp.Fill(spacing);
+  image->SetSpacing(sp);
+  auto o = -size * spacing / 2 + spacing / 2;
+  ImageType::PointType origin;
+  origin.Fill(o);
+  image->SetOrigin(origin);
+  image->Allocate();
+  image->FillBuffer(0);
+  return image;
+}
+
+// points in the image and 10% around it
+std::vector<G4ThreeVector> ImagePoints(int size) {
+  auto h = 1.1 * size * spacing / 2;
+  return BenchmarkRandomPoints(nb_points, h, h, h);
+}
+} // namespace
+
+static void BM_ImageIndexTransform(benchmark::State &state) {
+  auto image = CreateImage(state.range(0));
+  GateImageIndexTransform transform;
+  transform.Update(image.GetPointer());
+  auto points = ImagePoints(state.range(0));
+  size_t p = 0;
+  ImageType::IndexType index;
+  for (auto _ : state) {
+    auto inside = transform.TransformPointToIndex(points[p], index);
+    benchmark::DoNotOptimize(inside);
+    benchmark::DoNotOptimize(index);
+    p = (p + 1) & (nb_points - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImageIndexTransform)->Arg(64)->Arg(256);
+
+// Same as BM_ImageIndexTransform with ITK (reference)
+static void BM_ImageIndexITK(benchmark::State &state) {
+  auto image = CreateImage(state.range(0));
+  auto points = ImagePoints(state.range(0));
+  size_t p = 0;
+  ImageType::PointType point;
+  ImageType::IndexType index;
+  for (auto _ : state) {
+    point[0] = points[p].x();
+    point[1] = points[p].y();
+    point[2] = points[p].z();
+    auto inside = image->TransformPhysicalPointToIndex(point, index);
+    benchmark::DoNotOptimize(inside);
+    benchmark::DoNotOptimize(index);
+    p = (p + 1) & (nb_points - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImageIndexITK)->Arg(64)->Arg(256);
+
+static void BM_ImageAddValue(benchmark::State &state) {
+  auto image = CreateImage(state.range(0));
+  GateImageIndexTransform transform;
+  transform.Update(image.GetPointer());
+  auto points = ImagePoints(state.range(0));
+  size_t p = 0;
+  ImageType::IndexType index;
+  for (auto _ : state) {
+    if (transform.TransformPointToIndex(points[p], index))
+      ImageAddValue<ImageType>(image.GetPointer(), index, 1.0);
+    p = (p + 1) & (nb_points - 1);
+  }
+  benchmark::DoNotOptimize(image->GetBufferPointer()[0]);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImageAddValue)->Arg(64)->Arg(256);
+
+static void BM_ImageAtomicAddValue(benchmark::State &state) {
+  auto image = CreateImage(state.range(0));
+  GateImageIndexTransform transform;
+  transform.Update(image.GetPointer());
+  auto points = ImagePoints(state.range(0));
+  size_t p = 0;
+  ImageType::IndexType index;
+  for (auto _ : state) {
+    if (transform.TransformPointToIndex(points[p], index)) {
+      auto offset = image->ComputeOffset(index);
+      ImageAtomicAddValueAtOffset<ImageType>(image.GetPointer(), offset, 1.0);
+    }
+    p = (p + 1) & (nb_points - 1);
+  }
+  benchmark::DoNotOptimize(image->GetBufferPointer()[0]);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImageAtomicAddValue)->Arg(64)->Arg(256);
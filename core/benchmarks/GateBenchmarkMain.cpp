@@ -0,0 +1,31 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <benchmark/benchmark.h>
+#include <pybind11/embed.h>
+
+namespace py = pybind11;
+
+/*
+    Micro-benchmarks of the hot paths of opengate_core (image scoring, voxel
+    sources, mu tables, volume IDs, digitizer), built with the cmake option
+    OPENGATE_BUILD_BENCHMARKS (Google Benchmark). Each benchmark reports the
+    time per item, e.g. per hit or per sampled position.
+
+    The sources of opengate_core use pybind11 (e.g. the py::dict of the user
+    info), so a Python interpreter is embedded for the whole run.
+ */
+
+int main(int argc, char **argv) {
+  py::scoped_interpreter guard{};
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
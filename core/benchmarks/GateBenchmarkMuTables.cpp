@@ -0,0 +1,124 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "G4NistManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "GateMuTables.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <random>
+
+// Lookups of mu_en/rho (TLE, forced detection): binary search in the table of
+// one material (GateMuTable), or direct bin in the flat table of all the
+// materials (GateMuLookupTable)
+
+namespace {
+const size_t nb_energies = 1 << 14;
+const int nb_materials = 8;
+
+// Synthetic tables (log values, as PutValue expects), one per material, on
+// 1 keV - 10 MeV
+struct MuTables {
+  std::vector<std::unique_ptr<G4MaterialCutsCouple>> fCouples;
+  std::vector<std::unique_ptr<GateMuTable>> fTables;
+  GateMuLookupTable fLookup;
+
+  MuTables() {
+    const char *names[nb_materials] = {"G4_WATER",
+                                       "G4_AIR",
+                                       "G4_BONE_COMPACT_ICRU",
+                                       "G4_LUNG_ICRP",
+                                       "G4_MUSCLE_SKELETAL_ICRP",
+                                       "G4_ADIPOSE_TISSUE_ICRP",
+                                       "G4_Pb",
+                                       "G4_BGO"};
+    std::vector<const GateMuTable *> tables;
+    const int size = 120;
+    for (int m = 0; m < nb_materials; m++) {
+      auto *nist = G4NistManager::Instance();
+      auto *material = nist->FindOrBuildMaterial(names[m]);
+      fCouples.emplace_back(new G4MaterialCutsCouple(material));
+      fTables.emplace_back(new GateMuTable(fCouples.back().get(), size));
+      for (int i = 0; i < size; i++) {
+        auto e = std::exp(std::log(1 * keV) +
+                          i * (std::log(10 * MeV) - std::log(1 * keV)) /
+                              (size - 1));
+        auto mu = (m + 1) * 0.2 * std::pow(e / MeV, -0.8);
+        fTables.back()->PutValue(i, std::log(e), std::log(mu),
+                                 std::log(0.5 * mu));
+      }
+      tables.push_back(fTables.back().get());
+    }
+    fLookup.Build(tables, 50);
+  }
+};
+
+MuTables &GetMuTables() {
+  static MuTables tables;
+  return tables;
+}
+
+// random (log uniform) energies and materials
+void RandomHits(std::vector<double> &energies, std::vector<int> &couples) {
+  std::mt19937_64 engine(42);
+  std::uniform_real_distribution<double> u(std::log(10 * keV),
+                                           std::log(1 * MeV));
+  std::uniform_int_distribution<int> c(0, nb_materials - 1);
+  energies.resize(nb_energies);
+  couples.resize(nb_energies);
+  for (size_t i = 0; i < nb_energies; i++) {
+    energies[i] = std::exp(u(engine));
+    couples[i] = c(engine);
+  }
+}
+} // namespace
+
+static void BM_MuTableGetMuEnOverRho(benchmark::State &state) {
+  auto &t = GetMuTables();
+  std::vector<double> energies;
+  std::vector<int> couples;
+  RandomHits(energies, couples);
+  size_t p = 0;
+  for (auto _ : state) {
+    auto v = t.fTables[couples[p]]->GetMuEnOverRho(energies[p]);
+    benchmark::DoNotOptimize(v);
+    p = (p + 1) & (nb_energies - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MuTableGetMuEnOverRho);
+
+static void BM_MuLookupTableGetMuEnOverRho(benchmark::State &state) {
+  auto &t = GetMuTables();
+  std::vector<double> energies;
+  std::vector<int> couples;
+  RandomHits(energies, couples);
+  size_t p = 0;
+  for (auto _ : state) {
+    auto v = t.fLookup.GetMuEnOverRho(couples[p], energies[p]);
+    benchmark::DoNotOptimize(v);
+    p = (p + 1) & (nb_energies - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MuLookupTableGetMuEnOverRho);
+
+static void BM_MuLookupTableGetMuEnOverRhoBatch(benchmark::State &state) {
+  auto &t = GetMuTables();
+  std::vector<double> energies;
+  std::vector<int> couples;
+  RandomHits(energies, couples);
+  std::vector<double> values(nb_energies);
+  for (auto _ : state) {
+    t.fLookup.GetMuEnOverRho(nb_energies, couples.data(), energies.data(),
+                             values.data());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * nb_energies);
+}
+BENCHMARK(BM_MuLookupTableGetMuEnOverRhoBatch);
@@ -0,0 +1,114 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "G4SystemOfUnits.hh"
+#include "GateSPSVoxelsPosDistribution.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+// Position of the primaries of a voxelized source (VoxelSource): sampling of
+// a voxel, with the 3 cumulative distribution functions (Z, then Y knowing
+// Z, then X knowing Z and Y) or with the alias table
+
+namespace {
+// activity (numpy order Z Y X) of size^3 voxels: a low background and a hot
+// sphere
+std::vector<double> Activity(int size) {
+  std::mt19937_64 engine(42);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::vector<double> activity(static_cast<size_t>(size) * size * size);
+  auto c = size / 2.0;
+  size_t v = 0;
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      for (int k = 0; k < size; k++) {
+        auto d2 = (i - c) * (i - c) + (j - c) * (j - c) + (k - c) * (k - c);
+        activity[v++] = d2 < c * c / 4 ? 10 + u(engine) : 0.1 * u(engine);
+      }
+    }
+  }
+  return activity;
+}
+
+// same as the VoxelSource (python side), from the activity
+void SetCDF(GateSPSVoxelsPosDistribution &pos,
+            const std::vector<double> &activity, int size) {
+  typedef GateSPSVoxelsPosDistribution G;
+  G::VD vz(size);
+  G::VD2 vy(size, G::VD(size));
+  G::VD3 vx(size, G::VD2(size, G::VD(size)));
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      const auto *a = &activity[(static_cast<size_t>(i) * size + j) * size];
+      double sum = 0;
+      for (int k = 0; k < size; k++) {
+        sum += a[k];
+        vx[i][j][k] = sum;
+      }
+      for (int k = 0; k < size; k++)
+        vx[i][j][k] /= sum;
+      vy[i][j] = sum;
+    }
+    double sum = 0;
+    for (int j = 0; j < size; j++) {
+      sum += vy[i][j];
+      vy[i][j] = sum;
+    }
+    for (int j = 0; j < size; j++)
+      vy[i][j] /= sum;
+    vz[i] = sum;
+  }
+  double sum = 0;
+  for (int i = 0; i < size; i++) {
+    sum += vz[i];
+    vz[i] = sum;
+  }
+  for (int i = 0; i < size; i++)
+    vz[i] /= sum;
+  pos.SetCumulativeDistributionFunction(vz, vy, vx);
+}
+
+void SetImage(GateSPSVoxelsPosDistribution &pos, int size) {
+  // no pixel data, only the geometry
+  typedef GateSPSVoxelsPosDistribution::ImageType ImageType;
+  ImageType::SizeType s;
+  s.Fill(size);
+  ImageType::RegionType region;
+  region.SetSize(s);
+  pos.cpp_image->SetRegions(region);
+  ImageType::SpacingType spacing;
+  spacing.Fill(2 * mm);
+  pos.cpp_image->SetSpacing(spacing);
+}
+} // namespace
+
+static void BM_VoxelsPosGenerateOneCDF(benchmark::State &state) {
+  auto size = static_cast<int>(state.range(0));
+  GateSPSVoxelsPosDistribution pos;
+  SetImage(pos, size);
+  SetCDF(pos, Activity(size), size);
+  for (auto _ : state) {
+    auto p = pos.VGenerateOne();
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VoxelsPosGenerateOneCDF)->Arg(32)->Arg(128);
+
+static void BM_VoxelsPosGenerateOneAlias(benchmark::State &state) {
+  auto size = static_cast<int>(state.range(0));
+  GateSPSVoxelsPosDistribution pos;
+  SetImage(pos, size);
+  auto activity = Activity(size);
+  pos.SetAliasTable(activity.data(), size, size, size);
+  for (auto _ : state) {
+    auto p = pos.VGenerateOne();
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VoxelsPosGenerateOneAlias)->Arg(32)->Arg(128);
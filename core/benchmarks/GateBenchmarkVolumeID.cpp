@@ -0,0 +1,48 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateBenchmarkHelpers.h"
+#include "GateUniqueVolumeIDManager.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+// Volume ID of the touchable of a hit (PreStepUniqueVolumeID attribute):
+// random crystals, or consecutive hits in the same crystal (the last volume
+// ID of the thread is checked first)
+
+namespace {
+// crystal of each hit, in random order
+std::vector<const G4VTouchable *>
+RandomCrystals(const std::vector<std::shared_ptr<G4TouchableHistory>> &t,
+               size_t n, int hits_per_crystal) {
+  std::mt19937_64 engine(42);
+  std::uniform_int_distribution<size_t> u(0, t.size() - 1);
+  std::vector<const G4VTouchable *> hits;
+  while (hits.size() < n) {
+    const auto *crystal = t[u(engine)].get();
+    for (int i = 0; i < hits_per_crystal && hits.size() < n; i++)
+      hits.push_back(crystal);
+  }
+  return hits;
+}
+} // namespace
+
+static void BM_GetVolumeID(benchmark::State &state) {
+  auto touchables = BenchmarkCrystalTouchables(16);
+  const size_t nb_hits = 1 << 14;
+  auto hits = RandomCrystals(touchables, nb_hits, state.range(0));
+  auto *m = GateUniqueVolumeIDManager::GetInstance();
+  size_t p = 0;
+  for (auto _ : state) {
+    const auto &id = m->GetVolumeID(hits[p]);
+    benchmark::DoNotOptimize(id.get());
+    p = (p + 1) & (nb_hits - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+// random crystals, and 4 consecutive hits per crystal
+BENCHMARK(BM_GetVolumeID)->Arg(1)->Arg(4);
@@ -48,6 +48,8 @@ void init_G4Material(py::module &m) {
       .def("GetState", &G4Material::GetState)
       .def("GetTemperature", &G4Material::GetTemperature)
       .def("GetPressure", &G4Material::GetPressure)
+      .def("GetBaseMaterial", &G4Material::GetBaseMaterial,
+           py::return_value_policy::reference)
 
       .def("GetElementVector", &G4Material::GetElementVector,
            py::return_value_policy::reference_internal)
@@ -58,6 +58,14 @@ void init_G4NistManager(py::module &m) {
             return mm->ConstructNewMaterial(name, elm, weight, dens);
           },
           py::return_value_policy::reference_internal)
+
+      .def(
+          "BuildMaterialWithNewDensity",
+          [](G4NistManager *mm, const G4String &name,
+             const G4String &basename, G4double dens) {
+            return mm->BuildMaterialWithNewDensity(name, basename, dens);
+          },
+          py::return_value_policy::reference_internal)
       .def("FindMaterial", &G4NistManager::FindMaterial)
       .def("GetNumberOfElements", &G4NistManager::GetNumberOfElements)
       .def("GetZ", &G4NistManager::GetZ)
@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -30,7 +31,16 @@ void init_Randomize(py::module &m) {
           [](long seed, int lux) { return (HepRandom::setTheSeed(seed, lux)); },
           py::arg("seed"), py::arg("lux"));
 
-  py::class_<HepRandomEngine>(m, "HepRandomEngine");
+  // put/get: the full state of the engine, as a list of integers
+  // (e.g. to resume a simulation from a checkpoint)
+  py::class_<HepRandomEngine>(m, "HepRandomEngine")
+      .def("put",
+           [](const HepRandomEngine &e) -> std::vector<unsigned long> {
+             return e.put();
+           })
+      .def("get", [](HepRandomEngine &e, const std::vector<unsigned long> &v) {
+        return e.get(v);
+      });
 
   py::class_<MTwistEngine, HepRandomEngine>(m, "MTwistEngine").def(py::init());
 
@@ -284,6 +284,8 @@ void init_GateCheckDeex(py::module &);
 
 void init_GateInfo(py::module &);
 
+void init_GateParallelWorldPhysics(py::module &);
+
 void init_GateVActor(py::module &);
 
 void init_GateActorManager(py::module &);
@@ -318,16 +320,44 @@ void init_GateARFTrainingDatasetActor(py::module &m);
 
 void init_GateKillActor(py::module &);
 
+void init_GateStepBatchActor(py::module &);
+
 void init_GateKillAccordingProcessesActor(py::module &);
 
+void init_GateRangeRejectionActor(py::module &);
+
+void init_GateRussianRouletteActor(py::module &);
+
+void init_GateOpticalFastResponseActor(py::module &);
+
 void init_GateAttenuationImageActor(py::module &);
 
+void init_GateForcedDetectionActor(py::module &);
+
+void init_GateFlatGeometryActor(py::module &);
+
+void init_GateBeamletDoseActor(py::module &);
+void init_GateROIDoseActor(py::module &);
+void init_GateDoseRateActor(py::module &);
+void init_GateCutsTuningActor(py::module &);
+void init_GateWoodcockTrackingActor(py::module &);
+
+void init_GateDynamicGeometryActor(py::module &);
+
+void init_GateWeightWindowActor(py::module &);
+
 void init_itk_image(py::module &);
 
 void init_GateImageNestedParameterisation(py::module &);
 
+void init_GateImageRegularParameterisation(py::module &);
+
+void init_GateImageRunParameterisation(py::module &);
+
 void init_GateRepeatParameterisation(py::module &);
 
+void init_GateRepeatedDetectorIndex(py::module &);
+
 void init_GateRunAction(py::module &);
 
 void init_GateEventAction(py::module &);
@@ -338,6 +368,8 @@ void init_GateSimulationStatisticsActor(py::module &);
 
 void init_GatePhaseSpaceActor(py::module &);
 
+void init_GatePhaseSpacePlaneActor(py::module &);
+
 void init_GateOptrComptSplittingActor(py::module &m);
 
 void init_GateBOptrBremSplittingActor(py::module &m);
@@ -353,6 +385,8 @@ void init_GateHitsCollectionActor(py::module &);
 
 void init_GateHitsAdderActor(py::module &);
 
+void init_GateDigitizerOnlineAdderActor(py::module &m);
+
 void init_GateDigitizerReadoutActor(py::module &m);
 
 void init_GateDigitizerBlurringActor(py::module &m);
@@ -365,12 +399,26 @@ void init_GateDigitizerEnergyWindowsActor(py::module &m);
 
 void init_GateDigitizerProjectionActor(py::module &m);
 
+void init_GateVDigitizerTimeOrderedActor(py::module &m);
+
+void init_GateDigitizerCoincidenceSorterActor(py::module &m);
+
+void init_GateDigitizerDeadTimeActor(py::module &m);
+
+void init_GateDigitizerPileupActor(py::module &m);
+
+void init_GateDigitizerFusedChainActor(py::module &m);
+
 void init_GateDigiAttributeManager(py::module &m);
 
+void init_GateDigiCollectionsRootManager(py::module &m);
+
 void init_GateVDigiAttribute(py::module &m);
 
 void init_GateUniqueVolumeIDManager(py::module &);
 
+void init_GateDeferredCallbackQueue(py::module &);
+
 void init_GateUniqueVolumeID(py::module &);
 
 void init_GateVolumeDepthID(py::module &m);
@@ -390,10 +438,26 @@ void init_GatePencilBeamSource(py::module &m);
 
 void init_GateVoxelSource(py::module &);
 
+void init_GateMultiChannelVoxelSource(py::module &);
+
 void init_GateGANSource(py::module &);
 
 void init_GatePhaseSpaceSource(py::module &);
 
+void init_GateParticleBank(py::module &);
+
+void init_GateParticleBankSource(py::module &);
+
+void init_GatePrimaryCache(py::module &);
+
+void init_GateEventScheduler(py::module &);
+
+void init_GatePhiloxEngine(py::module &);
+
+void init_GateHugePages(py::module &);
+
+void init_GateMotionTable(py::module &);
+
 void init_GateGANPairSource(py::module &);
 
 // Gate misc
@@ -557,6 +621,7 @@ PYBIND11_MODULE(opengate_core, m) {
   // Gate
   init_GateCheckDeex(m);
   init_GateInfo(m);
+  init_GateParallelWorldPhysics(m);
   init_GateVActor(m);
   init_GateActorManager(m);
   init_GateVFilter(m);
@@ -567,7 +632,10 @@ PYBIND11_MODULE(opengate_core, m) {
   init_GateThresholdAttributeFilter(m);
   init_itk_image(m);
   init_GateImageNestedParameterisation(m);
+  init_GateImageRegularParameterisation(m);
+  init_GateImageRunParameterisation(m);
   init_GateRepeatParameterisation(m);
+  init_GateRepeatedDetectorIndex(m);
   init_GateVSource(m);
   init_GateSourceManager(m);
   init_GateGenericSource(m);
@@ -575,8 +643,16 @@ PYBIND11_MODULE(opengate_core, m) {
   init_GateTemplateSource(m);
   init_GatePencilBeamSource(m);
   init_GateVoxelSource(m);
+  init_GateMultiChannelVoxelSource(m);
   init_GateGANSource(m);
   init_GatePhaseSpaceSource(m);
+  init_GateParticleBank(m);
+  init_GateParticleBankSource(m);
+  init_GatePrimaryCache(m);
+  init_GateEventScheduler(m);
+  init_GatePhiloxEngine(m);
+  init_GateHugePages(m);
+  init_GateMotionTable(m);
   init_GateGANPairSource(m);
   init_GateSPSPosDistribution(m);
   init_GateSPSVoxelsPosDistribution(m);
@@ -590,30 +666,52 @@ PYBIND11_MODULE(opengate_core, m) {
   init_GateProductionAndStoppingActor(m);
   init_GateSimulationStatisticsActor(m);
   init_GatePhaseSpaceActor(m);
+  init_GatePhaseSpacePlaneActor(m);
   init_GateBOptrBremSplittingActor(m);
   init_GateOptrComptSplittingActor(m);
   init_GateOptrFreeFlightActor(m);
   init_GateHitsCollectionActor(m);
   init_GateVDigitizerWithOutputActor(m);
   init_GateHitsAdderActor(m);
+  init_GateDigitizerOnlineAdderActor(m);
   init_GateDigitizerReadoutActor(m);
   init_GateDigitizerBlurringActor(m);
   init_GateDigitizerEfficiencyActor(m);
   init_GateDigitizerSpatialBlurringActor(m);
   init_GateDigitizerEnergyWindowsActor(m);
   init_GateDigitizerProjectionActor(m);
+  init_GateVDigitizerTimeOrderedActor(m);
+  init_GateDigitizerCoincidenceSorterActor(m);
+  init_GateDigitizerDeadTimeActor(m);
+  init_GateDigitizerPileupActor(m);
+  init_GateDigitizerFusedChainActor(m);
   init_GateARFActor(m);
   init_GateARFTrainingDatasetActor(m);
   init_GateKillActor(m);
+  init_GateStepBatchActor(m);
   init_GateKillAccordingProcessesActor(m);
+  init_GateRangeRejectionActor(m);
+  init_GateRussianRouletteActor(m);
+  init_GateOpticalFastResponseActor(m);
   init_GateAttenuationImageActor(m);
+  init_GateForcedDetectionActor(m);
+  init_GateFlatGeometryActor(m);
+  init_GateBeamletDoseActor(m);
+  init_GateROIDoseActor(m);
+  init_GateDoseRateActor(m);
+  init_GateCutsTuningActor(m);
+  init_GateWoodcockTrackingActor(m);
+  init_GateDynamicGeometryActor(m);
+  init_GateWeightWindowActor(m);
   init_GateDigiAttributeManager(m);
+  init_GateDigiCollectionsRootManager(m);
   init_GateVDigiAttribute(m);
   init_GateExceptionHandler(m);
   init_GateNTuple(m);
   init_GateHelpers(m);
   init_GateVolumeVoxelizer(m);
   init_GateUniqueVolumeIDManager(m);
+  init_GateDeferredCallbackQueue(m);
   init_GateUniqueVolumeID(m);
   init_GateVolumeDepthID(m);
 }
@@ -7,8 +7,13 @@
 
 #include "GateARFActor.h"
 #include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
+#include "GateTimeline.h"
+#include <chrono>
+#include <cmath>
+#include <sstream>
 
 GateARFActor::GateARFActor(py::dict &user_info) : GateVActor(user_info, true) {
   fActions.insert("SteppingAction");
@@ -16,6 +21,15 @@ GateARFActor::GateARFActor(py::dict &user_info) : GateVActor(user_info, true) {
   fActions.insert("EndOfRunAction");
   fBatchSize = 0;
   fKeepNegativeSide = true;
+  fDeferredApply = false;
+  fMaxDeferredBatches = 2;
+  fCoalescedBatchSize = 0;
+  fDistanceToCrystal = 0;
+  fEnableHitSlice = false;
+  fNumberOfRuns = 0;
+  fNumberOfSlicesPerRun = 0;
+  fNumberOfNativeBatches = 0;
+  fNumberOfNativeHits = 0;
 }
 
 void GateARFActor::InitializeUserInfo(py::dict &user_info) {
@@ -23,31 +37,271 @@ void GateARFActor::InitializeUserInfo(py::dict &user_info) {
   fBatchSize = DictGetInt(user_info, "batch_size");
   fKeepNegativeSide = DictGetBool(user_info, "flip_plane");
   fPlaneAxis = DictGetVecInt(user_info, "plane_axis");
+  fDeferredApply = DictGetBool(user_info, "deferred_apply");
+  fCoalescedBatchSize = 0;
+  if (fDeferredApply)
+    fCoalescedBatchSize = DictGetInt(user_info, "coalesced_batch_size");
+  fImageSize = DictGetVecInt(user_info, "image_size");
+  fImageSpacing = DictGetVecDouble(user_info, "image_spacing");
+  fDistanceToCrystal = DictGetDouble(user_info, "distance_to_crystal");
+  fEnableHitSlice = DictGetBool(user_info, "enable_hit_slice");
+  // (see InitializeNativeInference)
+  fInference = nullptr;
 }
 
 void GateARFActor::SetARFFunction(ARFFunctionType &f) { fApply = f; }
 
+void GateARFActor::InitializeNativeInference(const std::string &filename,
+                                             const std::string &gpu_mode,
+                                             int number_of_runs) {
+  fInference = std::make_shared<GateGANInference>();
+  fInference->Initialize(filename, gpu_mode, "ARF");
+  if (fInference->GetInputDimension() != 3 ||
+      fInference->GetOutputDimension() < 2) {
+    std::ostringstream oss;
+    oss << "The ARF model '" << filename << "' of the actor '" << GetName()
+        << "' must have 3 inputs (theta, phi, energy) and at least 2 outputs "
+           "(the probabilities of the energy windows), while it has "
+        << fInference->GetInputDimension() << " and "
+        << fInference->GetOutputDimension()
+        << ". Use export_arf_to_onnx to export the network.";
+    Fatal(oss.str());
+  }
+  // the first output (outside the windows) is replaced by the hits slice
+  // or ignored
+  fNumberOfSlicesPerRun = GetNumberOfEnergyWindows();
+  if (!fEnableHitSlice)
+    fNumberOfSlicesPerRun--;
+  fNumberOfRuns = number_of_runs;
+  fProjection.assign(fNumberOfRuns * fNumberOfSlicesPerRun * fImageSize[0] *
+                         fImageSize[1],
+                     0.0);
+  fNumberOfNativeBatches = 0;
+  fNumberOfNativeHits = 0;
+}
+
+size_t GateARFActor::GetNumberOfEnergyWindows() const {
+  if (fInference == nullptr)
+    return 0;
+  return fInference->GetOutputDimension();
+}
+
 void GateARFActor::BeginOfRunAction(const G4Run *run) {
   auto &l = fThreadLocalData.Get();
   l.fCurrentRunId = run->GetRunID();
   l.fCurrentNumberOfHits = 0;
+  l.fBatch.reserve(fBatchSize * fNumberOfColumns);
+  if (fInference != nullptr) {
+    l.fInput.reserve(fBatchSize * 3);
+    l.fOutput.reserve(fBatchSize * GetNumberOfEnergyWindows());
+    l.fPixels.reserve(fBatchSize);
+  }
 }
 
 void GateARFActor::EndOfRunAction(const G4Run * /*run*/) {
   auto &l = fThreadLocalData.Get();
   // When the run ends, we send the current remaining hits to the ARF
-  if (l.fCurrentNumberOfHits > 0) {
+  if (l.fCurrentNumberOfHits > 0)
+    ApplyCurrentBatch();
+  // all the hits of the run must be in the image before the end of the run
+  WaitForDeferredBatches(0);
+  if (fCoalescedBatchSize > 0) {
+    // (also the hits of the other threads gathered meanwhile)
+    {
+      std::lock_guard<std::mutex> lock(fCoalescedMutex);
+      if (fCoalescedBatch.fCurrentNumberOfHits > 0)
+        EnqueueCoalescedBatch();
+    }
+    WaitForCoalescedBatches(0);
+  }
+}
+
+void GateARFActor::ApplyCurrentBatch() {
+  auto &l = fThreadLocalData.Get();
+  if (fInference != nullptr) {
+    // no Python: the thread runs the network itself
+    GateTimelineScope timeline("ARF batch", "inference");
+    ApplyNativeInference();
+    l.fBatch.clear();
+    l.fCurrentNumberOfHits = 0;
+    return;
+  }
+
+  if (!fDeferredApply) {
+    GateTimelineScope timeline("ARF batch", "callback");
     fApply(this);
-    l.fEnergy.clear();
-    l.fPositionX.clear();
-    l.fPositionY.clear();
-    // l.fPositionZ.clear();
-    l.fDirectionX.clear();
-    l.fDirectionY.clear();
-    // l.fDirectionZ.clear();
-    l.fWeights.clear();
+    // (the capacity is kept for the next batch)
+    l.fBatch.clear();
     l.fCurrentNumberOfHits = 0;
+    return;
   }
+
+  if (fCoalescedBatchSize > 0) {
+    AddToCoalescedBatch();
+    return;
+  }
+
+  // The hits are moved into the task, and the thread continues.
+  WaitForDeferredBatches(fMaxDeferredBatches - 1);
+  auto batch = std::make_shared<threadLocalT>();
+  MoveBatch(l, *batch);
+  l.fBatch.reserve(fBatchSize * fNumberOfColumns);
+  l.fDeferredBatches.push_back(EnqueueBatch(batch));
+}
+
+void GateARFActor::ApplyNativeInference() {
+  auto &l = fThreadLocalData.Get();
+  const size_t n = l.fCurrentNumberOfHits;
+  if (n == 0)
+    return;
+  const size_t nwin = GetNumberOfEnergyWindows();
+
+  // input of the network: theta, phi and energy of each hit
+  l.fInput.resize(n * 3);
+  l.fOutput.resize(n * nwin);
+  for (size_t i = 0; i < n; i++) {
+    const auto *row = &l.fBatch[i * fNumberOfColumns];
+    l.fInput[i * 3] = static_cast<float>(row[2]);
+    l.fInput[i * 3 + 1] = static_cast<float>(row[3]);
+    l.fInput[i * 3 + 2] = static_cast<float>(row[4]);
+  }
+  fInference->Run(l.fInput.data(), l.fOutput.data(), n);
+
+  // pixel of each hit: the hit is moved along its direction up to the
+  // crystal, at distance_to_crystal from the detector plane
+  const long size_u = fImageSize[0];
+  const long size_v = fImageSize[1];
+  const double half_u = size_u * fImageSpacing[0] / 2.0;
+  const double half_v = size_v * fImageSpacing[1] / 2.0;
+  l.fPixels.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    const auto *row = &l.fBatch[i * fNumberOfColumns];
+    l.fPixels[i] = -1;
+    // (theta = acos(dy) and phi = acos(dx), see SteppingAction)
+    const double dx = std::cos(row[3] * CLHEP::degree);
+    const double dy = std::cos(row[2] * CLHEP::degree);
+    const double dz2 = 1.0 - dx * dx - dy * dy;
+    if (dz2 <= 0)
+      continue;
+    const double t = fDistanceToCrystal / std::sqrt(dz2);
+    const auto u = static_cast<long>(
+        std::floor((row[0] + t * dx + half_u) / fImageSpacing[0]));
+    const auto v = static_cast<long>(
+        std::floor((row[1] + t * dy + half_v) / fImageSpacing[1]));
+    if (u < 0 || u >= size_u || v < 0 || v >= size_v)
+      continue;
+    l.fPixels[i] = u * size_v + v;
+  }
+
+  // add the hits to the slices of the run, weighted by the probability of
+  // each energy window (and by the weight of the hit)
+  const size_t slice = size_u * size_v;
+  const auto run = static_cast<size_t>(l.fCurrentRunId);
+  if (l.fCurrentRunId < 0 || l.fCurrentRunId >= fNumberOfRuns) {
+    std::ostringstream oss;
+    oss << "The actor '" << GetName() << "' has a projection for "
+        << fNumberOfRuns << " runs, cannot add the hits of the run "
+        << l.fCurrentRunId;
+    Fatal(oss.str());
+  }
+  const size_t first_window = fEnableHitSlice ? 0 : 1;
+  std::lock_guard<std::mutex> lock(fProjectionMutex);
+  auto *projection = &fProjection[run * fNumberOfSlicesPerRun * slice];
+  for (size_t i = 0; i < n; i++) {
+    const auto pixel = l.fPixels[i];
+    if (pixel < 0)
+      continue;
+    const double w = l.fBatch[i * fNumberOfColumns + 5];
+    const auto *p = &l.fOutput[i * nwin];
+    if (fEnableHitSlice)
+      projection[pixel] += w;
+    for (size_t k = 1; k < nwin; k++)
+      projection[(k - first_window) * slice + pixel] += w * p[k];
+  }
+  fNumberOfNativeBatches++;
+  fNumberOfNativeHits += n;
+}
+
+std::shared_future<void>
+GateARFActor::EnqueueBatch(std::shared_ptr<threadLocalT> batch) {
+  // The task is executed by the Python thread: the getters (GetBatch, etc)
+  // then read the thread local data of this Python thread.
+  auto task = [this, batch]() {
+    auto &ll = fThreadLocalData.Get();
+    MoveBatch(*batch, ll);
+    GateTimelineScope timeline("ARF batch", "callback");
+    fApply(this);
+    MoveBatch(ll, *batch);
+  };
+  auto *queue = GateDeferredCallbackQueue::GetInstance();
+  return queue->Enqueue(task);
+}
+
+void GateARFActor::AddToCoalescedBatch() {
+  auto &l = fThreadLocalData.Get();
+  {
+    std::lock_guard<std::mutex> lock(fCoalescedMutex);
+    auto &c = fCoalescedBatch;
+    // (a batch only contains the hits of one run)
+    if (c.fCurrentNumberOfHits > 0 && c.fCurrentRunId != l.fCurrentRunId)
+      EnqueueCoalescedBatch();
+    c.fCurrentRunId = l.fCurrentRunId;
+    c.fBatch.insert(c.fBatch.end(), l.fBatch.begin(), l.fBatch.end());
+    c.fCurrentNumberOfHits += l.fCurrentNumberOfHits;
+    if (c.fCurrentNumberOfHits >= static_cast<int>(fCoalescedBatchSize))
+      EnqueueCoalescedBatch();
+  }
+  // (the capacity is kept for the next batch)
+  l.fBatch.clear();
+  l.fCurrentNumberOfHits = 0;
+  WaitForCoalescedBatches(fMaxDeferredBatches);
+}
+
+void GateARFActor::EnqueueCoalescedBatch() {
+  auto batch = std::make_shared<threadLocalT>();
+  MoveBatch(fCoalescedBatch, *batch);
+  fCoalescedBatch.fBatch.reserve((fCoalescedBatchSize + fBatchSize) *
+                                 fNumberOfColumns);
+  fCoalescedBatches.push_back(EnqueueBatch(batch));
+}
+
+void GateARFActor::WaitForCoalescedBatches(size_t n) {
+  // (the shared batches are waited without the lock, the other threads may
+  // add new ones meanwhile)
+  while (true) {
+    std::shared_future<void> front;
+    {
+      std::lock_guard<std::mutex> lock(fCoalescedMutex);
+      auto &batches = fCoalescedBatches;
+      while (!batches.empty() &&
+             batches.front().wait_for(std::chrono::seconds(0)) ==
+                 std::future_status::ready) {
+        GateDeferredCallbackQueue::Wait(batches.front(), GetName());
+        batches.pop_front();
+      }
+      if (batches.size() <= n)
+        return;
+      front = batches.front();
+    }
+    GateDeferredCallbackQueue::Wait(front, GetName());
+  }
+}
+
+void GateARFActor::WaitForDeferredBatches(size_t n) {
+  // (the number of batches in memory is bounded)
+  auto &l = fThreadLocalData.Get();
+  while (l.fDeferredBatches.size() > n) {
+    GateDeferredCallbackQueue::Wait(l.fDeferredBatches.front(), GetName());
+    l.fDeferredBatches.pop_front();
+  }
+}
+
+void GateARFActor::MoveBatch(threadLocalT &from, threadLocalT &to) {
+  to.fBatch = std::move(from.fBatch);
+  to.fCurrentNumberOfHits = from.fCurrentNumberOfHits;
+  to.fCurrentRunId = from.fCurrentRunId;
+  from.fBatch.clear();
+  from.fCurrentNumberOfHits = 0;
 }
 
 void GateARFActor::SteppingAction(G4Step *step) {
@@ -64,35 +318,23 @@ void GateARFActor::SteppingAction(G4Step *step) {
   if (fKeepNegativeSide && dir[fPlaneAxis[2]] > 0)
     return;
 
-  l.fCurrentNumberOfHits++;
-  l.fDirectionX.push_back(dir[fPlaneAxis[0]]);
-  l.fDirectionY.push_back(dir[fPlaneAxis[1]]);
-  // l.fDirectionZ.push_back(dir[2]); // not used
-  l.fWeights.push_back(pre->GetWeight());
-
-  // get energy
-  l.fEnergy.push_back(pre->GetKineticEnergy());
-
   // get position and transform to local
   auto pos =
       pre->GetTouchable()->GetHistory()->GetTopTransform().TransformPoint(
           pre->GetPosition());
-  l.fPositionX.push_back(pos[fPlaneAxis[0]]);
-  l.fPositionY.push_back(pos[fPlaneAxis[1]]);
+
+  // one row of the batch: the input of the network
+  l.fCurrentNumberOfHits++;
+  l.fBatch.push_back(pos[fPlaneAxis[0]]);
+  l.fBatch.push_back(pos[fPlaneAxis[1]]);
+  l.fBatch.push_back(std::acos(dir[fPlaneAxis[1]]) / CLHEP::degree);
+  l.fBatch.push_back(std::acos(dir[fPlaneAxis[0]]) / CLHEP::degree);
+  l.fBatch.push_back(pre->GetKineticEnergy());
+  l.fBatch.push_back(pre->GetWeight());
 
   // trigger the "apply" (ARF) if the number of hits in the batch is reached
-  if (l.fCurrentNumberOfHits >= fBatchSize) {
-    fApply(this);
-    l.fEnergy.clear();
-    l.fPositionX.clear();
-    l.fPositionY.clear();
-    // l.fPositionZ.clear();
-    l.fDirectionX.clear();
-    l.fDirectionY.clear();
-    // l.fDirectionZ.clear();
-    l.fWeights.clear();
-    l.fCurrentNumberOfHits = 0;
-  }
+  if (l.fCurrentNumberOfHits >= fBatchSize)
+    ApplyCurrentBatch();
 }
 
 int GateARFActor::GetCurrentNumberOfHits() const {
@@ -103,30 +345,48 @@ int GateARFActor::GetCurrentRunId() const {
   return fThreadLocalData.Get().fCurrentRunId;
 }
 
-std::vector<double> GateARFActor::GetEnergy() const {
-  return fThreadLocalData.Get().fEnergy;
+const std::vector<double> &GateARFActor::GetBatch() const {
+  return fThreadLocalData.Get().fBatch;
 }
 
+std::vector<double> GateARFActor::GetColumn(size_t column) const {
+  const auto &batch = fThreadLocalData.Get().fBatch;
+  std::vector<double> values;
+  values.reserve(batch.size() / fNumberOfColumns);
+  for (size_t i = column; i < batch.size(); i += fNumberOfColumns)
+    values.push_back(batch[i]);
+  return values;
+}
+
+std::vector<double> GateARFActor::GetEnergy() const { return GetColumn(4); }
+
 std::vector<double> GateARFActor::GetPositionX() const {
-  return fThreadLocalData.Get().fPositionX;
+  return GetColumn(0);
 }
 
 std::vector<double> GateARFActor::GetPositionY() const {
-  return fThreadLocalData.Get().fPositionY;
+  return GetColumn(1);
 }
 
 std::vector<double> GateARFActor::GetDirectionX() const {
-  return fThreadLocalData.Get().fDirectionX;
+  // (the batch only contains the angle phi = acos(dx))
+  auto values = GetColumn(3);
+  for (auto &v : values)
+    v = std::cos(v * CLHEP::degree);
+  return values;
 }
 
 std::vector<double> GateARFActor::GetDirectionY() const {
-  return fThreadLocalData.Get().fDirectionY;
+  // (the batch only contains the angle theta = acos(dy))
+  auto values = GetColumn(2);
+  for (auto &v : values)
+    v = std::cos(v * CLHEP::degree);
+  return values;
 }
 
 std::vector<double> GateARFActor::GetDirectionZ() const {
-  return fThreadLocalData.Get().fDirectionZ;
+  // not stored
+  return {};
 }
 
-std::vector<double> GateARFActor::GetWeights() const {
-  return fThreadLocalData.Get().fWeights;
-}
+std::vector<double> GateARFActor::GetWeights() const { return GetColumn(5); }
@@ -8,12 +8,30 @@
 #ifndef GateARFActor_h
 #define GateARFActor_h
 
+#include "GateDeferredCallbackQueue.h"
+#include "GateGANInference.h"
 #include "GateHelpers.h"
 #include "GateVActor.h"
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
 
+/*
+ * The hits of a thread are stored in one batch, directly in the layout of the
+ * input of the ARF network: one row per hit with the fNumberOfColumns values
+ * x, y (position in the detector plane), theta, phi (angles of the direction,
+ * in degree), energy and weight. The Python "apply" function reads the batch
+ * as a numpy array without copy (GetBatch in pyGateARFActor.cpp).
+ *
+ * With the native inference (InitializeNativeInference), the ARF network
+ * exported to ONNX is run by the Geant4 thread itself, and the detection
+ * probabilities are added to the projection (GetProjection) in C++: Python
+ * is not called during the run.
+ */
+
 class GateARFActor : public GateVActor {
 
 public:
@@ -35,6 +53,13 @@ public:
 
   int GetCurrentRunId() const;
 
+  // Number of values per hit in the batch
+  static constexpr size_t fNumberOfColumns = 6;
+
+  // Current batch of hits of the calling thread (row major)
+  const std::vector<double> &GetBatch() const;
+
+  // (copies of the columns of the batch)
   std::vector<double> GetEnergy() const;
 
   std::vector<double> GetPositionX() const;
@@ -55,27 +80,104 @@ public:
   // set the user "apply" function (python)
   void SetARFFunction(ARFFunctionType &f);
 
+  // Native inference of the ARF network (ONNX), instead of the "apply"
+  // function. The projection has number_of_runs groups of slices.
+  void InitializeNativeInference(const std::string &filename,
+                                 const std::string &gpu_mode,
+                                 int number_of_runs);
+
+  bool IsNativeInference() const { return fInference != nullptr; }
+
+  // Number of outputs of the network (the first one is outside the windows)
+  size_t GetNumberOfEnergyWindows() const;
+
+  // Projection of the native inference, row major: (number of runs x slices
+  // per run) x image_size[0] x image_size[1]
+  const std::vector<double> &GetProjection() const { return fProjection; }
+
+  size_t GetNumberOfSlicesPerRun() const { return fNumberOfSlicesPerRun; }
+
+  const std::vector<int> &GetImageSize() const { return fImageSize; }
+
+  long GetNumberOfNativeBatches() const { return fNumberOfNativeBatches; }
+
+  long GetNumberOfNativeHits() const { return fNumberOfNativeHits; }
+
 protected:
+  // Give the current batch of hits to the "apply" function
+  void ApplyCurrentBatch();
+
+  // Run the network on the current batch and add it to the projection
+  void ApplyNativeInference();
+
+  // Wait until at most n deferred batches of this thread are pending
+  void WaitForDeferredBatches(size_t n);
+
+  // Coalescing: add the current batch to the batch shared by the threads
+  void AddToCoalescedBatch();
+
+  // Coalescing: give the shared batch to the Python thread (lock held)
+  void EnqueueCoalescedBatch();
+
+  // Coalescing: wait until at most n shared batches are pending
+  void WaitForCoalescedBatches(size_t n);
+
   int fBatchSize;
   ARFFunctionType fApply;
   bool fKeepNegativeSide;
   std::vector<int> fPlaneAxis;
+  // the batches are given to the Python thread of GateDeferredCallbackQueue
+  bool fDeferredApply;
+  size_t fMaxDeferredBatches;
+  // deferred batches of all the threads are gathered up to this number of
+  // hits before being applied at once (0: no coalescing)
+  size_t fCoalescedBatchSize;
+
+  // Copy of one column of the batch
+  std::vector<double> GetColumn(size_t column) const;
 
   // For MT, all threads local variables are gathered here
   struct threadLocalT {
-    std::vector<double> fEnergy;
-    std::vector<double> fPositionX;
-    std::vector<double> fPositionY;
-    std::vector<double> fDirectionX;
-    std::vector<double> fDirectionY;
-    std::vector<double> fDirectionZ;
-    std::vector<double> fWeights;
+    // x y theta phi energy weight of each hit
+    std::vector<double> fBatch;
     // number of particle hitting the detector
-    int fCurrentNumberOfHits;
+    int fCurrentNumberOfHits = 0;
     // Current run id (to detect if run has changed)
-    int fCurrentRunId;
+    int fCurrentRunId = 0;
+    // batches of this thread not yet processed by the Python thread
+    std::deque<std::shared_future<void>> fDeferredBatches;
+    // native inference: input (theta phi energy) and output (probabilities)
+    // of the network, and pixel of each hit in the projection (-1: outside)
+    std::vector<float> fInput;
+    std::vector<float> fOutput;
+    std::vector<long> fPixels;
   };
+  static void MoveBatch(threadLocalT &from, threadLocalT &to);
+
+  // Give a batch to the Python thread
+  std::shared_future<void> EnqueueBatch(std::shared_ptr<threadLocalT> batch);
+
   G4Cache<threadLocalT> fThreadLocalData;
+
+  // Coalescing: the batch shared by the threads (one run at a time) and the
+  // shared batches not yet processed by the Python thread
+  std::mutex fCoalescedMutex;
+  threadLocalT fCoalescedBatch;
+  std::deque<std::shared_future<void>> fCoalescedBatches;
+
+  // Native inference: the network (shared by the threads), the geometry of
+  // the projection and the projection itself (one lock per batch)
+  std::shared_ptr<GateGANInference> fInference;
+  std::vector<int> fImageSize;
+  std::vector<double> fImageSpacing;
+  double fDistanceToCrystal;
+  bool fEnableHitSlice;
+  int fNumberOfRuns;
+  size_t fNumberOfSlicesPerRun;
+  std::mutex fProjectionMutex;
+  std::vector<double> fProjection;
+  long fNumberOfNativeBatches;
+  long fNumberOfNativeHits;
 };
 
 #endif // GateARFActor_h
@@ -10,8 +10,13 @@
 #include "G4RunManager.hh"
 #include "GateActorManager.h"
 #include "GateHelpersDict.h"
+#include "GateMutex.h"
 #include "digitizer/GateDigiCollectionManager.h"
 #include "digitizer/GateTDigiAttribute.h"
+#include <cstdint>
+#include <fstream>
+
+GATE_MUTEX(ARFTrainingDatasetActorMutex);
 
 GateARFTrainingDatasetActor::GateARFTrainingDatasetActor(py::dict &user_info)
     : GateDigitizerHitsCollectionActor(user_info) {
@@ -42,6 +47,13 @@ void GateARFTrainingDatasetActor::StartSimulationAction() {
   } else {
     outputPath = GetOutputPath(fOutputNameRoot);
   }
+  // compact output: no root file, the chunks are appended to the file
+  fCompactFilename.clear();
+  if (IsCompactFilename(outputPath)) {
+    fCompactFilename = outputPath;
+    outputPath = "";
+    std::ofstream(fCompactFilename, std::ios::binary | std::ios::trunc);
+  }
   fHits->SetFilenameAndInitRoot(outputPath);
   // create the attributes
   auto *att_e = new GateTDigiAttribute<double>("E");
@@ -106,6 +118,10 @@ void GateARFTrainingDatasetActor::EndOfEventAction(const G4Event * /*event*/) {
     if (x > fRussianRouletteFactor)
       return;
   }
+  if (!fCompactFilename.empty()) {
+    FillCompact(l, w, w == 0 ? fRussianRouletteValue : 1);
+    return;
+  }
   // Fill E, theta, phi and w
   fAtt_E->FillDValue(l.fE);
   fAtt_Theta->FillDValue(l.fTheta);
@@ -113,6 +129,47 @@ void GateARFTrainingDatasetActor::EndOfEventAction(const G4Event * /*event*/) {
   fAtt_W->FillDValue(w);
 }
 
+bool GateARFTrainingDatasetActor::IsCompactFilename(
+    const std::string &filename) {
+  const std::string ext = ".bin";
+  return filename.size() > ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void GateARFTrainingDatasetActor::FillCompact(threadLocalT &l, int window,
+                                              double weight) {
+  if (l.fChunk.empty())
+    l.fChunk.resize(fChunkSize * fNumberOfColumns);
+  auto *row = l.fChunk.data() + l.fRows;
+  row[0] = static_cast<float>(l.fE);
+  row[fChunkSize] = static_cast<float>(l.fTheta);
+  row[2 * fChunkSize] = static_cast<float>(l.fPhi);
+  row[3 * fChunkSize] = static_cast<float>(window);
+  row[4 * fChunkSize] = static_cast<float>(weight);
+  l.fRows++;
+  if (l.fRows == fChunkSize)
+    WriteChunk(l);
+}
+
+void GateARFTrainingDatasetActor::WriteChunk(threadLocalT &l) {
+  if (l.fRows == 0)
+    return;
+  GateAutoLock mutex(&ARFTrainingDatasetActorMutex);
+  std::ofstream f(fCompactFilename, std::ios::binary | std::ios::app);
+  const auto rows = static_cast<std::uint32_t>(l.fRows);
+  f.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+  for (size_t c = 0; c < fNumberOfColumns; c++)
+    f.write(reinterpret_cast<const char *>(l.fChunk.data() + c * fChunkSize),
+            static_cast<std::streamsize>(l.fRows * sizeof(float)));
+  l.fRows = 0;
+}
+
+void GateARFTrainingDatasetActor::EndOfRunAction(const G4Run *run) {
+  GateDigitizerHitsCollectionActor::EndOfRunAction(run);
+  if (!fCompactFilename.empty())
+    WriteChunk(fThreadLocalData.Get());
+}
+
 void GateARFTrainingDatasetActor::EndSimulationAction() {
   GateDigitizerHitsCollectionActor::EndSimulationAction();
 }
@@ -16,6 +16,19 @@
 
 namespace py = pybind11;
 
+/*
+ * Training dataset of the ARF: energy, angles and energy window of the
+ * photons that reach the detector plane. The photons outside the windows
+ * are kept with a probability 1/russian_roulette.
+ *
+ * Compact output (filename with the .bin extension): the dataset is not
+ * written through the digi collection, each thread appends its samples as
+ * float32 columns and writes them by chunks of fChunkSize rows in the same
+ * file (lock per chunk). Chunk: number of rows (uint32), then the E, Theta,
+ * Phi, window and weight columns. The weight is russian_roulette for the
+ * kept samples outside the windows, 1 for the others.
+ */
+
 class GateARFTrainingDatasetActor : public GateDigitizerHitsCollectionActor {
 
 public:
@@ -33,8 +46,17 @@ public:
 
   void EndOfEventAction(const G4Event *event) override;
 
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
   void EndSimulationAction() override;
 
+  static bool IsCompactFilename(const std::string &filename);
+
+  // Number of rows of the chunks of the compact output
+  static constexpr size_t fChunkSize = 1 << 16;
+  static constexpr size_t fNumberOfColumns = 5;
+
   GateDigitizerEnergyWindowsActor *fEnergyWindowsActor;
   std::string fInputActorName;
   int fRussianRouletteValue;
@@ -44,14 +66,24 @@ public:
   GateVDigiAttribute *fAtt_Theta;
   GateVDigiAttribute *fAtt_Phi;
   GateVDigiAttribute *fAtt_W;
+  std::string fCompactFilename;
 
   // During computation
   struct threadLocalT {
     double fE;
     double fTheta;
     double fPhi;
+    // compact output: columns of the current chunk
+    std::vector<float> fChunk;
+    size_t fRows = 0;
   };
   G4Cache<threadLocalT> fThreadLocalData;
+
+protected:
+  void FillCompact(threadLocalT &l, int window, double weight);
+
+  // Append the rows of the chunk of the thread to the file (lock)
+  void WriteChunk(threadLocalT &l);
 };
 
 #endif // GateARFTrainingDatasetActor_h
@@ -7,13 +7,16 @@
 
 #include "GateAcceptanceAngleTester.h"
 #include "G4LogicalVolumeStore.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
 #include "G4Navigator.hh"
 #include "G4PhysicalVolumeStore.hh"
-#include "GateHelpersDict.h"
 #include "GateHelpersImage.h"
+#include <algorithm>
+#include <cmath>
 
-GateAcceptanceAngleTester::GateAcceptanceAngleTester(
-    std::string volume, std::map<std::string, std::string> &param) {
+GateAcceptanceAngleTester::GateAcceptanceAngleTester(const std::string &volume,
+                                                     const Param &param) {
   fAcceptanceAngleVolumeName = volume;
   fAASolid = nullptr;
   fAANavigator = nullptr;
@@ -31,10 +34,19 @@ GateAcceptanceAngleTester::GateAcceptanceAngleTester(
   fAANavigator->SetWorldVolume(world);
 
   // parameters
-  fIntersectionFlag = StrToBool(param["intersection_flag"]);
-  fNormalFlag = StrToBool(param["normal_flag"]);
-  fNormalAngleTolerance = StrToDouble(param["normal_tolerance"]);
-  fNormalVector = StrToG4ThreeVector(param["normal_vector"]);
+  fIntersectionFlag = param.fIntersectionFlag;
+  fNormalFlag = param.fNormalFlag;
+  fNormalAngleTolerance = param.fNormalTolerance;
+  fNormalVector = param.fNormalVector;
+  // angle > tolerance <=> cos(angle) < cos(tolerance), without acos
+  fCosNormalAngleTolerance = std::cos(std::min(fNormalAngleTolerance, pi));
+
+  // Local bounding box of the solid (slightly enlarged, to never reject a
+  // direction accepted by DistanceToIn)
+  fAASolid->BoundingLimits(fBoundingBoxMin, fBoundingBoxMax);
+  const G4ThreeVector margin(1 * um, 1 * um, 1 * um);
+  fBoundingBoxMin -= margin;
+  fBoundingBoxMax += margin;
 }
 
 GateAcceptanceAngleTester::~GateAcceptanceAngleTester() { delete fAARotation; }
@@ -42,25 +54,62 @@ GateAcceptanceAngleTester::~GateAcceptanceAngleTester() { delete fAARotation; }
 void GateAcceptanceAngleTester::UpdateTransform() {
   // Get the transformation
   G4ThreeVector tr;
-  fAARotation = new G4RotationMatrix; // FIXME to delete each run ?
+  if (fAARotation == nullptr)
+    fAARotation = new G4RotationMatrix;
   ComputeTransformationFromWorldToVolume(fAcceptanceAngleVolumeName, tr,
-                                         *fAARotation);
+                                         *fAARotation, true);
   // It is not fully clear why the AffineTransform need the inverse
   fAATransform = G4AffineTransform(fAARotation->inverse(), tr);
 }
 
 bool GateAcceptanceAngleTester::TestIfAccept(
     const G4ThreeVector &position, const G4ThreeVector &momentum_direction) {
-  auto localPosition = fAATransform.TransformPoint(position);
+  SetPosition(position);
+  return TestIfAcceptDirection(momentum_direction);
+}
+
+void GateAcceptanceAngleTester::SetPosition(const G4ThreeVector &position) {
+  fLocalPosition = fAATransform.TransformPoint(position);
+}
+
+bool GateAcceptanceAngleTester::TestIfAcceptDirection(
+    const G4ThreeVector &momentum_direction) const {
   auto localDirection = (*fAARotation) * (momentum_direction);
+  // the cheapest tests first (the direction is a unit vector)
+  if (fNormalFlag) {
+    if (fNormalVector.dot(localDirection) < fCosNormalAngleTolerance)
+      return false;
+  }
   if (fIntersectionFlag) {
-    auto dist = fAASolid->DistanceToIn(localPosition, localDirection);
+    if (!IntersectBoundingBox(localDirection))
+      return false;
+    auto dist = fAASolid->DistanceToIn(fLocalPosition, localDirection);
     if (dist == kInfinity)
       return false;
   }
-  if (fNormalFlag) {
-    auto angle = fNormalVector.angle(localDirection);
-    if (angle > fNormalAngleTolerance)
+  return true;
+}
+
+bool GateAcceptanceAngleTester::IntersectBoundingBox(
+    const G4ThreeVector &direction) const {
+  // slab test of the ray (local position, direction) with the bounding box
+  double tmin = 0;
+  double tmax = kInfinity;
+  for (int i = 0; i < 3; i++) {
+    const double p = fLocalPosition[i];
+    const double d = direction[i];
+    if (d == 0) {
+      if (p < fBoundingBoxMin[i] || p > fBoundingBoxMax[i])
+        return false;
+      continue;
+    }
+    double t1 = (fBoundingBoxMin[i] - p) / d;
+    double t2 = (fBoundingBoxMax[i] - p) / d;
+    if (t1 > t2)
+      std::swap(t1, t2);
+    tmin = std::max(tmin, t1);
+    tmax = std::min(tmax, t2);
+    if (tmin > tmax)
       return false;
   }
   return true;
@@ -13,22 +13,43 @@
 
 class GateAcceptanceAngleTester {
 public:
-  GateAcceptanceAngleTester(std::string volume,
-                            std::map<std::string, std::string> &param);
+  // Typed parameters of the test (see GateAcceptanceAngleTesterManager)
+  struct Param {
+    bool fIntersectionFlag = false;
+    bool fNormalFlag = false;
+    double fNormalTolerance = 0;
+    // unit vector
+    G4ThreeVector fNormalVector{0, 0, 1};
+  };
+
+  GateAcceptanceAngleTester(const std::string &volume, const Param &param);
 
   ~GateAcceptanceAngleTester();
 
   bool TestIfAccept(const G4ThreeVector &position,
                     const G4ThreeVector &momentum_direction);
 
+  // The position is transformed once, then several directions are tested
+  // from this position (rejection loop)
+  void SetPosition(const G4ThreeVector &position);
+
+  bool TestIfAcceptDirection(const G4ThreeVector &momentum_direction) const;
+
   void UpdateTransform();
 
 protected:
+  // Cheap test before DistanceToIn: false if the ray misses the bounding box
+  bool IntersectBoundingBox(const G4ThreeVector &direction) const;
+
   std::string fAcceptanceAngleVolumeName;
   bool fIntersectionFlag;
   bool fNormalFlag;
   double fNormalAngleTolerance;
+  double fCosNormalAngleTolerance;
   G4ThreeVector fNormalVector;
+  G4ThreeVector fBoundingBoxMin;
+  G4ThreeVector fBoundingBoxMax;
+  G4ThreeVector fLocalPosition;
   G4AffineTransform fAATransform;
   G4RotationMatrix *fAARotation;
   G4VSolid *fAASolid;
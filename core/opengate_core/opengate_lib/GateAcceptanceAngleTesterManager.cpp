@@ -9,30 +9,32 @@
 #include "G4RunManager.hh"
 #include "GateAcceptanceAngleTester.h"
 #include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
 
 GateAcceptanceAngleTesterManager::GateAcceptanceAngleTesterManager() {
   fEnabledFlag = false;
   fNotAcceptedEvents = 0;
   fAALastRunId = -1;
+  fAALastGeometryVersion = 0;
   fPolicy = AASkipEvent;
   fMaxNotAcceptedEvents = 100000;
+  fCurrentPositionIsSet = false;
 }
 
-void GateAcceptanceAngleTesterManager::Initialize(py::dict puser_info,
-                                                  bool is_valid_type) {
-  fAcceptanceAngleVolumeNames = DictGetVecStr(puser_info, "volumes");
-  fEnabledFlag = !fAcceptanceAngleVolumeNames.empty();
-  if (!fEnabledFlag)
-    return;
-  // (we cannot use py::dict here as it is lost at the end of the function)
-  fAcceptanceAngleParam = DictToMap(puser_info);
+GateAcceptanceAngleTesterManager::ConfigPointer
+GateAcceptanceAngleTesterManager::ParseConfig(py::dict puser_info,
+                                              bool is_valid_type) {
+  auto config = std::make_shared<Config>();
+  config->fVolumes = DictGetVecStr(puser_info, "volumes");
+  if (config->fVolumes.empty())
+    return config;
   auto s = DictGetStr(puser_info, "skip_policy");
-  fPolicy = AAUndefined;
+  config->fPolicy = AAUndefined;
   if (s == "ZeroEnergy")
-    fPolicy = AAZeroEnergy;
+    config->fPolicy = AAZeroEnergy;
   if (s == "SkipEvents")
-    fPolicy = AASkipEvent;
-  if (fPolicy == AAUndefined) {
+    config->fPolicy = AASkipEvent;
+  if (config->fPolicy == AAUndefined) {
     std::ostringstream oss;
     oss << "Unknown '" << s << "' mode for GateAcceptanceAngleTesterManager. "
         << "Expected: ZeroEnergy or SkipEvents";
@@ -40,12 +42,42 @@ void GateAcceptanceAngleTesterManager::Initialize(py::dict puser_info,
   }
 
   // Cannot use SkipEvent with not a valid type of source
-  if (!is_valid_type && fPolicy == AASkipEvent) {
+  if (!is_valid_type && config->fPolicy == AASkipEvent) {
     std::ostringstream oss;
     oss << "Cannot use 'SkipEvent' mode without 'iso' or 'histogram' direction "
            "type";
     Fatal(oss.str());
   }
+
+  // parameters of the testers
+  auto &p = config->fParam;
+  p.fIntersectionFlag = DictGetBool(puser_info, "intersection_flag");
+  p.fNormalFlag = DictGetBool(puser_info, "normal_flag");
+  p.fNormalTolerance = DictGetDouble(puser_info, "normal_tolerance");
+  auto n = DictGetG4ThreeVector(puser_info, "normal_vector");
+  if (p.fNormalFlag && n.mag2() == 0)
+    Fatal("The acceptance angle normal_vector must not be null");
+  if (n.mag2() > 0)
+    p.fNormalVector = n.unit();
+  return config;
+}
+
+void GateAcceptanceAngleTesterManager::Initialize(ConfigPointer config) {
+  // the testers of a previous configuration are not valid anymore
+  if (config != fConfig) {
+    for (auto *t : fAATesters)
+      delete t;
+    fAATesters.clear();
+    fAALastRunId = -1;
+  }
+  fConfig = config;
+  fPolicy = fConfig->fPolicy;
+  fEnabledFlag = !fConfig->fVolumes.empty();
+}
+
+void GateAcceptanceAngleTesterManager::Initialize(py::dict puser_info,
+                                                  bool is_valid_type) {
+  Initialize(ParseConfig(puser_info, is_valid_type));
 }
 
 void GateAcceptanceAngleTesterManager::InitializeAcceptanceAngle() {
@@ -53,8 +85,8 @@ void GateAcceptanceAngleTesterManager::InitializeAcceptanceAngle() {
     return;
   // Create the testers (only the first time)
   if (fAATesters.empty()) {
-    for (const auto &name : fAcceptanceAngleVolumeNames) {
-      auto *t = new GateAcceptanceAngleTester(name, fAcceptanceAngleParam);
+    for (const auto &name : fConfig->fVolumes) {
+      auto *t = new GateAcceptanceAngleTester(name, fConfig->fParam);
       fAATesters.push_back(t);
     }
   }
@@ -62,10 +94,12 @@ void GateAcceptanceAngleTesterManager::InitializeAcceptanceAngle() {
   // Update the transform (all runs!)
   for (auto *t : fAATesters)
     t->UpdateTransform();
+  fCurrentPositionIsSet = false;
 
   // store the ID of this Run
   fAALastRunId = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
-  fEnabledFlag = !fAcceptanceAngleVolumeNames.empty();
+  fAALastGeometryVersion = GetVolumeTransformCacheVersion();
+  fEnabledFlag = !fConfig->fVolumes.empty();
 }
 
 unsigned long
@@ -77,9 +111,17 @@ bool GateAcceptanceAngleTesterManager::TestIfAccept(
     const G4ThreeVector &position, const G4ThreeVector &momentum_direction) {
   if (!fEnabledFlag)
     return true;
+  // The position is often the same for all the directions of the loop: it
+  // is only transformed (for each volume) when it changes
+  if (!fCurrentPositionIsSet || position != fCurrentPosition) {
+    for (auto *tester : fAATesters)
+      tester->SetPosition(position);
+    fCurrentPosition = position;
+    fCurrentPositionIsSet = true;
+  }
   // Loop on all volume to check if it at least one volume is accepted
   for (auto *tester : fAATesters) {
-    bool accept = tester->TestIfAccept(position, momentum_direction);
+    bool accept = tester->TestIfAcceptDirection(momentum_direction);
     if (accept)
       return true;
   }
@@ -99,6 +141,7 @@ void GateAcceptanceAngleTesterManager::StartAcceptLoop() {
     return;
   fNotAcceptedEvents = 0;
   if (fAALastRunId !=
-      G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID())
+          G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID() ||
+      fAALastGeometryVersion != GetVolumeTransformCacheVersion())
     InitializeAcceptanceAngle();
 }
@@ -11,6 +11,7 @@
 #include "G4AffineTransform.hh"
 #include "GateAcceptanceAngleTester.h"
 #include "GateHelpers.h"
+#include <memory>
 
 class GateAcceptanceAngleTesterManager {
 public:
@@ -18,7 +19,22 @@ public:
 
   enum AAPolicyType { AAZeroEnergy, AASkipEvent, AAUndefined };
 
-  void Initialize(py::dict puser_info, bool is_iso);
+  // Typed configuration, parsed and checked once from the user info (no
+  // py::dict nor string conversion afterwards). It is read only: the same
+  // one is shared by the managers of all the threads.
+  struct Config {
+    std::vector<std::string> fVolumes;
+    AAPolicyType fPolicy = AASkipEvent;
+    GateAcceptanceAngleTester::Param fParam;
+  };
+
+  typedef std::shared_ptr<const Config> ConfigPointer;
+
+  static ConfigPointer ParseConfig(py::dict puser_info, bool is_valid_type);
+
+  void Initialize(ConfigPointer config);
+
+  void Initialize(py::dict puser_info, bool is_valid_type);
 
   void InitializeAcceptanceAngle();
 
@@ -35,13 +51,17 @@ public:
 
 protected:
   AAPolicyType fPolicy;
-  std::map<std::string, std::string> fAcceptanceAngleParam;
+  ConfigPointer fConfig;
   std::vector<GateAcceptanceAngleTester *> fAATesters{};
-  std::vector<std::string> fAcceptanceAngleVolumeNames;
   bool fEnabledFlag;
   unsigned long fNotAcceptedEvents;
   unsigned long fMaxNotAcceptedEvents;
   int fAALastRunId;
+  // the volumes can move during a run (sub-runs, see GateMotionTable)
+  unsigned long fAALastGeometryVersion;
+  // the position given to the testers (the same one during a rejection loop)
+  G4ThreeVector fCurrentPosition;
+  bool fCurrentPositionIsSet;
 };
 
 #endif // GateAcceptanceAngleTesterManager_h
@@ -0,0 +1,123 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateActorProfiler.h"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include <map>
+
+using namespace pybind11::literals;
+
+std::atomic<bool> GateActorProfiler::fEnabled{false};
+int GateActorProfiler::fSamplingInterval = 1;
+std::mutex GateActorProfiler::fMutex;
+std::deque<GateActorProfiler::Tables> GateActorProfiler::fTables;
+std::atomic<int> GateActorProfiler::fGeneration{0};
+
+namespace {
+const char *CallbackName(int callback) {
+  switch (callback) {
+  case GateActorProfiler::SteppingAction:
+    return "SteppingAction";
+  case GateActorProfiler::Filters:
+    return "Filters";
+  case GateActorProfiler::BeginOfEventAction:
+    return "BeginOfEventAction";
+  case GateActorProfiler::EndOfEventAction:
+    return "EndOfEventAction";
+  case GateActorProfiler::PreUserTrackingAction:
+    return "PreUserTrackingAction";
+  case GateActorProfiler::PostUserTrackingAction:
+    return "PostUserTrackingAction";
+  case GateActorProfiler::GeneratePrimaries:
+    return "GeneratePrimaries";
+  default:
+    return "unknown";
+  }
+}
+} // namespace
+
+void GateActorProfiler::Enable(bool flag, int sampling_interval) {
+  fSamplingInterval = sampling_interval > 0 ? sampling_interval : 1;
+  fEnabled.store(flag, std::memory_order_relaxed);
+}
+
+void GateActorProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fTables.clear();
+  fGeneration++;
+}
+
+GateActorProfiler::Tables &GateActorProfiler::GetTables() {
+  static G4ThreadLocal Tables *tables = nullptr;
+  static G4ThreadLocal int generation = -1;
+  auto current = fGeneration.load(std::memory_order_acquire);
+  if (generation != current) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fTables.emplace_back();
+    tables = &fTables.back();
+    generation = current;
+  }
+  return *tables;
+}
+
+GateActorProfiler::Entry *
+GateActorProfiler::Count(const void *object, int callback,
+                         std::string (*name)(const void *)) {
+  auto &table = GetTables().fTables[callback];
+  auto it = table.find(object);
+  if (it == table.end()) {
+    it = table.emplace(object, Entry()).first;
+    it->second.fName = name(object);
+  }
+  auto &entry = it->second;
+  // the first call is always timed
+  if (entry.fCalls++ % fSamplingInterval != 0)
+    return nullptr;
+  return &entry;
+}
+
+py::dict GateActorProfiler::GetResults() {
+  // sum of the threads (and of the copies of the actors), by name
+  std::map<std::string, std::map<int, Entry>> sums;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (const auto &tables : fTables) {
+      for (int c = 0; c < NumberOfCallbacks; c++) {
+        for (const auto &e : tables.fTables[c]) {
+          auto &s = sums[e.second.fName][c];
+          s.fCalls += e.second.fCalls;
+          s.fSampledCalls += e.second.fSampledCalls;
+          s.fSampledTime += e.second.fSampledTime;
+        }
+      }
+    }
+  }
+  py::dict results;
+  for (const auto &s : sums) {
+    py::dict callbacks;
+    for (const auto &c : s.second) {
+      const auto &e = c.second;
+      double per_call =
+          e.fSampledCalls > 0 ? e.fSampledTime / e.fSampledCalls : 0;
+      callbacks[CallbackName(c.first)] =
+          py::dict("calls"_a = e.fCalls,
+                   "time"_a = per_call * e.fCalls * CLHEP::ns,
+                   "time_per_call"_a = per_call * CLHEP::ns);
+    }
+    results[s.first.c_str()] = callbacks;
+  }
+  return results;
+}
+
+std::string GateActorProfilerScope::ActorName(const void *actor) {
+  return static_cast<const GateVActor *>(actor)->GetName();
+}
+
+std::string GateActorProfilerScope::SourceName(const void *source) {
+  return static_cast<const GateVSource *>(source)->fName;
+}
@@ -0,0 +1,134 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateActorProfiler_h
+#define GateActorProfiler_h
+
+#include "GateVActor.h"
+#include "GateVSource.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <pybind11/pybind11.h>
+#include <string>
+#include <unordered_map>
+
+namespace py = pybind11;
+
+/*
+    Optional timing of the callbacks of the actors (and of their filters)
+    and of the sources, enabled by the SimulationStatisticsActor (option
+    profile_actors).
+
+    Each thread counts the calls of each callback of each actor in its own
+    table (no lock), and measures the duration of one call every
+    fSamplingInterval calls (steady_clock). The time of all the calls is
+    estimated from the sampled ones. When the profiler is disabled, the cost
+    is one test per call.
+ */
+
+class GateActorProfiler {
+public:
+  enum Callback {
+    SteppingAction = 0,
+    Filters,
+    BeginOfEventAction,
+    EndOfEventAction,
+    PreUserTrackingAction,
+    PostUserTrackingAction,
+    GeneratePrimaries,
+    NumberOfCallbacks
+  };
+
+  struct Entry {
+    std::string fName;
+    unsigned long fCalls = 0;
+    unsigned long fSampledCalls = 0;
+    // duration of the sampled calls (ns)
+    double fSampledTime = 0;
+  };
+
+  // Enable (or disable) the profiler, one call every sampling_interval is
+  // timed
+  static void Enable(bool flag, int sampling_interval);
+
+  inline static bool IsEnabled() {
+    return fEnabled.load(std::memory_order_relaxed);
+  }
+
+  // Remove the counts (master thread, when the simulation starts)
+  static void Reset();
+
+  // Count a call, return the entry if this call must be timed (nullptr
+  // otherwise)
+  // (the name is only asked at the first call of the thread)
+  static Entry *Count(const void *object, int callback,
+                      std::string (*name)(const void *));
+
+  // {name: {callback: {calls, time, time_per_call}}}, all threads, time in
+  // Geant4 units
+  static py::dict GetResults();
+
+protected:
+  static std::atomic<bool> fEnabled;
+  static int fSamplingInterval;
+
+  typedef std::unordered_map<const void *, Entry> TableType;
+  struct Tables {
+    TableType fTables[NumberOfCallbacks];
+  };
+
+  // Tables of the calling thread (created at its first call)
+  static Tables &GetTables();
+
+  static std::mutex fMutex;
+  // the tables are never moved (deque), and kept until the next Reset
+  static std::deque<Tables> fTables;
+  // incremented by Reset, the threads then take new tables
+  static std::atomic<int> fGeneration;
+};
+
+// Time the scope (a callback of an actor or a source) if the profiler is
+// enabled
+class GateActorProfilerScope {
+public:
+  GateActorProfilerScope(const GateVActor *actor, int callback) {
+    if (GateActorProfiler::IsEnabled())
+      Start(GateActorProfiler::Count(actor, callback, &ActorName));
+  }
+
+  GateActorProfilerScope(const GateVSource *source, int callback) {
+    if (GateActorProfiler::IsEnabled())
+      Start(GateActorProfiler::Count(source, callback, &SourceName));
+  }
+
+  ~GateActorProfilerScope() {
+    if (fEntry == nullptr)
+      return;
+    auto d = std::chrono::steady_clock::now() - fStart;
+    fEntry->fSampledTime +=
+        std::chrono::duration<double, std::nano>(d).count();
+    fEntry->fSampledCalls++;
+  }
+
+protected:
+  void Start(GateActorProfiler::Entry *entry) {
+    fEntry = entry;
+    if (fEntry != nullptr)
+      fStart = std::chrono::steady_clock::now();
+  }
+
+  static std::string ActorName(const void *actor);
+
+  static std::string SourceName(const void *source);
+
+  GateActorProfiler::Entry *fEntry = nullptr;
+  std::chrono::steady_clock::time_point fStart;
+};
+
+#endif // GateActorProfiler_h
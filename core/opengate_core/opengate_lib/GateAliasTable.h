@@ -0,0 +1,69 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateAliasTable_h
+#define GateAliasTable_h
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Alias tables (Walker/Vose) of the discrete distributions of the sources
+    (energy spectra, angular histograms, voxel activities), O(1) per sample:
+    a random entry is selected, then kept with its probability, otherwise
+    its alias is taken.
+
+    The entries are any struct with the members fProbability (double) and
+    fAlias (std::uint32_t), e.g. with the voxel index in addition.
+ */
+
+class GateAliasTable {
+public:
+  struct Entry {
+    double fProbability;
+    std::uint32_t fAlias;
+  };
+
+  // Vose method: the n probabilities (fProbability) must be scaled so that
+  // their mean is 1. The alias of each entry is set, and the probabilities
+  // are replaced by the probabilities to keep the entries.
+  template <class T> static void Build(T *table, size_t n) {
+    // each "small" entry (below 1) is filled up by a "large" one
+    std::vector<std::uint32_t> small;
+    std::vector<std::uint32_t> large;
+    for (size_t a = 0; a < n; a++) {
+      table[a].fAlias = a;
+      if (table[a].fProbability < 1.0)
+        small.push_back(a);
+      else
+        large.push_back(a);
+    }
+    while (!small.empty() && !large.empty()) {
+      auto s = small.back();
+      small.pop_back();
+      auto l = large.back();
+      table[s].fAlias = l;
+      auto &pl = table[l].fProbability;
+      pl = (pl + table[s].fProbability) - 1.0;
+      if (pl < 1.0) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // the remaining ones are (up to rounding errors) equal to 1
+    for (auto a : large)
+      table[a].fProbability = 1.0;
+    for (auto a : small)
+      table[a].fProbability = 1.0;
+  }
+
+  template <class T> static void Build(std::vector<T> &table) {
+    Build(table.data(), table.size());
+  }
+};
+
+#endif // GateAliasTable_h
@@ -0,0 +1,201 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateAttenuationRayMarcher.h"
+#include "G4ProductionCutsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <cmath>
+
+void GateAttenuationRayMarcher::Initialize(
+    const LabelImageType *labels, const std::vector<G4Material *> &materials,
+    const std::string &phantom_volume_name,
+    std::shared_ptr<GateMaterialMuHandler> mu_handler) {
+  // geometry of the labels (the image may change between runs)
+  if (fGeometry.IsNull())
+    fGeometry = LabelImageType::New();
+  fGeometry->SetRegions(labels->GetLargestPossibleRegion());
+  fGeometry->SetSpacing(labels->GetSpacing());
+  AttachImageToVolume<LabelImageType>(fGeometry, phantom_volume_name);
+  fTransform.Update(fGeometry.GetPointer());
+  const auto size = labels->GetLargestPossibleRegion().GetSize();
+  fSizeX = size[0];
+  fSliceSize = size[0] * size[1];
+  const auto &spacing = labels->GetSpacing();
+  fDiagonal = G4ThreeVector(size[0] * spacing[0], size[1] * spacing[1],
+                            size[2] * spacing[2])
+                  .mag();
+  fLabels = labels->GetBufferPointer();
+
+  // couple of the material of each label (the mu table is built the first
+  // time it is used)
+  fMuHandler = mu_handler;
+  fMuTable = &fMuHandler->GetLookupTable();
+  const auto *table = G4ProductionCutsTable::GetProductionCutsTable();
+  fCoupleOfLabel.assign(materials.size(), -1);
+  for (size_t label = 0; label < materials.size(); label++) {
+    for (size_t i = 0; i < table->GetTableSize(); i++) {
+      const auto *couple = table->GetMaterialCutsCouple(static_cast<int>(i));
+      if (couple->GetMaterial() == materials[label]) {
+        fCoupleOfLabel[label] = couple->GetIndex();
+        break;
+      }
+    }
+    if (fCoupleOfLabel[label] < 0) {
+      std::ostringstream oss;
+      oss << "No material cuts couple for the material "
+          << materials[label]->GetName() << " of the volume "
+          << phantom_volume_name << ", cannot compute its attenuation.";
+      Fatal(oss.str());
+    }
+  }
+  ComputeBinMu();
+}
+
+void GateAttenuationRayMarcher::SetEnergyBins(double energy_min,
+                                              double energy_max, size_t n) {
+  if (n == 0 || energy_min <= 0 || energy_max < energy_min) {
+    std::ostringstream oss;
+    oss << "Invalid energy bins of the attenuation: " << n << " bins in ["
+        << energy_min << ", " << energy_max << "]";
+    Fatal(oss.str());
+  }
+  fBinEnergies.resize(n);
+  const auto r = n > 1 ? std::log(energy_max / energy_min) / (n - 1) : 0;
+  for (size_t i = 0; i < n; i++)
+    fBinEnergies[i] = energy_min * std::exp(r * i);
+  if (fMuTable != nullptr)
+    ComputeBinMu();
+}
+
+void GateAttenuationRayMarcher::ComputeBinMu() {
+  const auto nb = fBinEnergies.size();
+  fMuOverBins.resize(fCoupleOfLabel.size() * nb);
+  for (size_t label = 0; label < fCoupleOfLabel.size(); label++) {
+    for (size_t i = 0; i < nb; i++)
+      fMuOverBins[label * nb + i] =
+          GetMu(static_cast<unsigned short>(label), fBinEnergies[i]);
+  }
+}
+
+double GateAttenuationRayMarcher::GetMu(unsigned short label,
+                                        double energy) const {
+  const auto couple = fCoupleOfLabel[label];
+  // (cm2/g * g/cm3 -> 1/cm)
+  return fMuTable->GetMuOverRho(couple, energy) *
+         fMuTable->GetDensity(couple) / CLHEP::cm;
+}
+
+double GateAttenuationRayMarcher::GetMaxMu(double energy) const {
+  double mu_max = 0;
+  for (size_t label = 0; label < fCoupleOfLabel.size(); label++)
+    mu_max =
+        std::max(mu_max, GetMu(static_cast<unsigned short>(label), energy));
+  return mu_max;
+}
+
+int GateAttenuationRayMarcher::GetLabel(const G4ThreeVector &p) const {
+  LabelImageType::IndexType index;
+  if (!fTransform.TransformPointToIndex(p, index))
+    return -1;
+  return fLabels[index[2] * fSliceSize + index[1] * fSizeX + index[0]];
+}
+
+void GateAttenuationRayMarcher::Traverse(const G4ThreeVector &a,
+                                         const G4ThreeVector &b) const {
+  auto &l = fThreadLocalData.Get();
+  // (the lengths of the previous segment are back to zero)
+  l.fLengths.resize(fCoupleOfLabel.size(), 0);
+  l.fCrossed.clear();
+  const auto length = (b - a).mag();
+  fTransform.ForEachVoxelOnSegment<LabelImageType::IndexType>(
+      a, b, [&](const LabelImageType::IndexType &index, double fraction) {
+        if (fraction <= 0)
+          return;
+        const auto label =
+            fLabels[index[2] * fSliceSize + index[1] * fSizeX + index[0]];
+        if (l.fLengths[label] == 0)
+          l.fCrossed.push_back(label);
+        l.fLengths[label] += fraction * length;
+      });
+}
+
+void GateAttenuationRayMarcher::ComputePathLengths(
+    const G4ThreeVector &a, const G4ThreeVector &b,
+    std::vector<double> &lengths) const {
+  Traverse(a, b);
+  auto &l = fThreadLocalData.Get();
+  lengths.assign(fCoupleOfLabel.size(), 0);
+  for (auto label : l.fCrossed) {
+    lengths[label] = l.fLengths[label];
+    l.fLengths[label] = 0;
+  }
+}
+
+double GateAttenuationRayMarcher::LineIntegral(const G4ThreeVector &a,
+                                               const G4ThreeVector &b,
+                                               double energy) const {
+  Traverse(a, b);
+  auto &l = fThreadLocalData.Get();
+  double mu_l = 0;
+  for (auto label : l.fCrossed) {
+    mu_l += GetMu(label, energy) * l.fLengths[label];
+    l.fLengths[label] = 0;
+  }
+  return mu_l;
+}
+
+double GateAttenuationRayMarcher::LineIntegralToExit(const G4ThreeVector &p,
+                                                     const G4ThreeVector &d,
+                                                     double energy,
+                                                     double &length) const {
+  // (the part of the segment outside the phantom is skipped)
+  Traverse(p, p + fDiagonal * d);
+  auto &l = fThreadLocalData.Get();
+  double mu_l = 0;
+  length = 0;
+  for (auto label : l.fCrossed) {
+    mu_l += GetMu(label, energy) * l.fLengths[label];
+    length += l.fLengths[label];
+    l.fLengths[label] = 0;
+  }
+  return mu_l;
+}
+
+void GateAttenuationRayMarcher::LineIntegralOverBins(const G4ThreeVector &a,
+                                                     const G4ThreeVector &b,
+                                                     double *out) const {
+  Traverse(a, b);
+  auto &l = fThreadLocalData.Get();
+  const auto nb = fBinEnergies.size();
+  std::fill(out, out + nb, 0.0);
+  for (auto label : l.fCrossed) {
+    const auto length = l.fLengths[label];
+    const auto *mu = fMuOverBins.data() + label * nb;
+    for (size_t i = 0; i < nb; i++)
+      out[i] += mu[i] * length;
+    l.fLengths[label] = 0;
+  }
+}
+
+void GateAttenuationRayMarcher::LineIntegrals(size_t n, const G4ThreeVector *a,
+                                              const G4ThreeVector *b,
+                                              const double *energies,
+                                              double *out) const {
+  for (size_t i = 0; i < n; i++)
+    out[i] = LineIntegral(a[i], b[i], energies[i]);
+}
+
+void GateAttenuationRayMarcher::LineIntegralsOverBins(size_t n,
+                                                      const G4ThreeVector *a,
+                                                      const G4ThreeVector *b,
+                                                      double *out) const {
+  const auto nb = fBinEnergies.size();
+  for (size_t i = 0; i < n; i++)
+    LineIntegralOverBins(a[i], b[i], out + i * nb);
+}
@@ -0,0 +1,136 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateAttenuationRayMarcher_h
+#define GateAttenuationRayMarcher_h
+
+#include "G4ThreeVector.hh"
+#include "GateHelpersImage.h"
+#include "GateImageNestedParameterisation.h"
+#include "GateImageRegularParameterisation.h"
+#include "GateImageRunParameterisation.h"
+#include "GateMaterialMuHandler.h"
+#include "GateThreadContext.h"
+#include <memory>
+
+/*
+ * Line integrals of the attenuation coefficient (sum of mu * length) along
+ * segments through a voxelized phantom, from the label image of its
+ * parameterisation (GateImageNestedParameterisation,
+ * GateImageRegularParameterisation or GateImageRunParameterisation) and the
+ * mu tables of GateMaterialMuHandler.
+ *
+ * A segment is traversed once (Amanatides-Woo, parts outside the phantom
+ * are skipped) to get the length crossed in each label. The integral is
+ * then a short sum over the crossed labels, for one energy (exact mu of the
+ * table) or for all the energy bins at once (mu of each label precomputed
+ * at the bin energies, contiguous so that the loop over the bins is
+ * vectorized).
+ *
+ * Initialize is called in the master thread, once the geometry is placed
+ * (e.g. in BeginOfRunActionMasterThread). The other functions are then
+ * const and may be called by all the threads.
+ */
+class GateAttenuationRayMarcher {
+public:
+  typedef GateImageNestedParameterisation::ImageType LabelImageType;
+
+  // Position of the phantom volume, labels and couple of each label. The
+  // label image is not copied: it must not be freed before the last use.
+  void Initialize(const LabelImageType *labels,
+                  const std::vector<G4Material *> &materials,
+                  const std::string &phantom_volume_name,
+                  std::shared_ptr<GateMaterialMuHandler> mu_handler);
+
+  // Energy bins, log-spaced in [energy_min, energy_max] (before Initialize
+  // or followed by it)
+  void SetEnergyBins(double energy_min, double energy_max, size_t n);
+
+  size_t GetNumberOfEnergyBins() const { return fBinEnergies.size(); }
+
+  const std::vector<double> &GetBinEnergies() const { return fBinEnergies; }
+
+  size_t GetNumberOfLabels() const { return fCoupleOfLabel.size(); }
+
+  // mu (1/mm) of each label at the bin energies, [label * nb + bin]
+  const std::vector<double> &GetMuOverBins() const { return fMuOverBins; }
+
+  // Geometry of the labels (size, spacing, origin and direction in the
+  // world), without buffer
+  const LabelImageType *GetGeometry() const { return fGeometry.GetPointer(); }
+
+  // mu (1/mm) of a label
+  double GetMu(unsigned short label, double energy) const;
+
+  // Largest mu (1/mm) of all the labels
+  double GetMaxMu(double energy) const;
+
+  // Label of the voxel of the point, -1 outside the phantom
+  int GetLabel(const G4ThreeVector &p) const;
+
+  // Distance from p along the unit direction d to the phantom boundary
+  double DistanceToExit(const G4ThreeVector &p, const G4ThreeVector &d) const {
+    return fTransform.DistanceToExit(p, d);
+  }
+
+  // Length (mm) crossed in each label by the segment [a, b] (the vector is
+  // resized to the number of labels)
+  void ComputePathLengths(const G4ThreeVector &a, const G4ThreeVector &b,
+                          std::vector<double> &lengths) const;
+
+  // Sum of mu * length on [a, b] at one energy
+  double LineIntegral(const G4ThreeVector &a, const G4ThreeVector &b,
+                      double energy) const;
+
+  // Same from p along the unit direction d up to the phantom boundary, the
+  // length inside the phantom is set in length
+  double LineIntegralToExit(const G4ThreeVector &p, const G4ThreeVector &d,
+                            double energy, double &length) const;
+
+  // LineIntegral at all the energy bins (GetNumberOfEnergyBins() values)
+  void LineIntegralOverBins(const G4ThreeVector &a, const G4ThreeVector &b,
+                            double *out) const;
+
+  // Batches of n segments [a[i], b[i]], at the energy of each segment or at
+  // all the bins (out[i * GetNumberOfEnergyBins() + bin])
+  void LineIntegrals(size_t n, const G4ThreeVector *a, const G4ThreeVector *b,
+                     const double *energies, double *out) const;
+  void LineIntegralsOverBins(size_t n, const G4ThreeVector *a,
+                             const G4ThreeVector *b, double *out) const;
+
+protected:
+  // Lengths of the labels crossed by [a, b] in the scratch of the thread
+  void Traverse(const G4ThreeVector &a, const G4ThreeVector &b) const;
+
+  void ComputeBinMu();
+
+  const unsigned short *fLabels = nullptr;
+  size_t fSizeX = 0;
+  size_t fSliceSize = 0;
+  // diagonal of the phantom, longer than any segment inside
+  double fDiagonal = 0;
+  // world to voxel index of the phantom (the label image itself is not
+  // moved, only this copy of its geometry without buffer)
+  LabelImageType::Pointer fGeometry;
+  GateImageIndexTransform fTransform;
+
+  std::shared_ptr<GateMaterialMuHandler> fMuHandler;
+  const GateMuLookupTable *fMuTable = nullptr;
+  std::vector<int> fCoupleOfLabel;
+  // mu (1/mm) at the bin energies, fMuOverBins[label * nb + bin]
+  std::vector<double> fBinEnergies;
+  std::vector<double> fMuOverBins;
+
+  // length of each label, and list of the labels crossed by the segment
+  struct threadLocalT {
+    std::vector<double> fLengths;
+    std::vector<unsigned short> fCrossed;
+  };
+  GateThreadLocal<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateAttenuationRayMarcher_h
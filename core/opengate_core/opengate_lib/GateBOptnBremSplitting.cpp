@@ -31,11 +31,15 @@
 #include "G4BiasingProcessInterface.hh"
 
 #include "G4ParticleChangeForLoss.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4VEnergyLossProcess.hh"
+#include "Randomize.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 GateBOptnBremSplitting::GateBOptnBremSplitting(G4String name)
-    : G4VBiasingOperation(name), fSplittingFactor(1), fParticleChange() {}
+    : G4VBiasingOperation(name), fSplittingFactor(1), fRussianRoulette(false),
+      fVectorDirector(0, 0, 1), fCosMaxTheta(-1), fParticleChange() {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -107,12 +111,17 @@ G4VParticleChange *GateBOptnBremSplitting::ApplyFinalStateBiasing(
 
   // -- Store first gamma:
   G4Track *gammaTrack = actualParticleChange->GetSecondary(0);
-  gammaTrack->SetWeight(gammaWeight);
-  fParticleChange.AddSecondary(gammaTrack);
+  AddGamma(gammaTrack, gammaWeight);
   // -- and clean-up the brem. process particle change:
   actualParticleChange->Clear();
 
-  // -- now start the fSplittingFactor-1 calls to the brem. process to store
+  // -- the fSplittingFactor-1 other gammas are sampled in bulk by the brem.
+  // -- model:
+  if (SampleGammas(callingProcess, track, step, fSplittingFactor - 1,
+                   gammaWeight))
+    return &fParticleChange;
+
+  // -- otherwise, fSplittingFactor-1 calls to the brem. process to store
   // each
   // -- related gamma:
   G4int nCalls = 1;
@@ -124,8 +133,7 @@ G4VParticleChange *GateBOptnBremSplitting::ApplyFinalStateBiasing(
         callingProcess->GetWrappedProcess()->PostStepDoIt(*track, *step);
     if (processFinalState->GetNumberOfSecondaries() == 1) {
       gammaTrack = processFinalState->GetSecondary(0);
-      gammaTrack->SetWeight(gammaWeight);
-      fParticleChange.AddSecondary(gammaTrack);
+      AddGamma(gammaTrack, gammaWeight);
       nCalls++;
     }
     // -- very rare special case: we ignore for now.
@@ -141,3 +149,60 @@ G4VParticleChange *GateBOptnBremSplitting::ApplyFinalStateBiasing(
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GateBOptnBremSplitting::SampleGammas(
+    const G4BiasingProcessInterface *callingProcess, const G4Track *track,
+    const G4Step *step, G4int n, G4double gammaWeight) {
+  auto *process =
+      dynamic_cast<G4VEnergyLossProcess *>(callingProcess->GetWrappedProcess());
+  if (process == nullptr)
+    return false;
+
+  // -- same model and cut as the brem. process for this interaction:
+  const auto *couple = step->GetPreStepPoint()->GetMaterialCutsCouple();
+  std::size_t coupleIndex = couple->GetIndex();
+  auto *model =
+      process->SelectModelForMaterial(track->GetKineticEnergy(), coupleIndex);
+  if (model == nullptr)
+    return false;
+  const auto *cuts =
+      G4ProductionCutsTable::GetProductionCutsTable()->GetEnergyCutsVector(
+          idxG4GammaCut);
+  const auto cut = (*cuts)[couple->GetIndex()];
+
+  // -- (the model also proposes a new electron state, ignored here: the
+  // -- electron state is the one of the first call)
+  fGammas.clear();
+  fGammas.reserve(n);
+  G4int nCalls = 0;
+  while (static_cast<G4int>(fGammas.size()) < n && nCalls < 10 * n) {
+    model->SampleSecondaries(&fGammas, couple, track->GetDynamicParticle(),
+                             cut);
+    nCalls++;
+  }
+  for (auto *gamma : fGammas) {
+    auto *gammaTrack =
+        new G4Track(gamma, track->GetGlobalTime(), track->GetPosition());
+    gammaTrack->SetTouchableHandle(track->GetTouchableHandle());
+    AddGamma(gammaTrack, gammaWeight);
+  }
+  fGammas.clear();
+  return true;
+}
+
+void GateBOptnBremSplitting::AddGamma(G4Track *gammaTrack,
+                                      G4double gammaWeight) {
+  // -- russian roulette of the gammas outside the direction of interest:
+  if (fRussianRoulette &&
+      fVectorDirector * gammaTrack->GetMomentumDirection() < fCosMaxTheta) {
+    if (G4UniformRand() * fSplittingFactor > 1) {
+      delete gammaTrack;
+      return;
+    }
+    gammaWeight *= fSplittingFactor;
+  }
+  gammaTrack->SetWeight(gammaWeight);
+  fParticleChange.AddSecondary(gammaTrack);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -43,6 +43,8 @@
 
 #include "G4ParticleChange.hh"
 #include "G4VBiasingOperation.hh"
+#include <cmath>
+#include <vector>
 
 class GateBOptnBremSplitting : public G4VBiasingOperation {
 public:
@@ -87,9 +89,36 @@ public:
   }
   G4int GetSplittingFactor() const { return fSplittingFactor; }
 
+  // -- Directional splitting: the gammas outside the cone of half angle
+  // -- maxTheta around vectorDirector are kept with the probability
+  // -- 1/splittingFactor (and the weight of the electron):
+  void SetRussianRoulette(G4bool russianRoulette) {
+    fRussianRoulette = russianRoulette;
+  }
+  void SetVectorDirector(const G4ThreeVector &vectorDirector) {
+    fVectorDirector = vectorDirector.unit();
+  }
+  void SetMaxTheta(G4double maxTheta) { fCosMaxTheta = std::cos(maxTheta); }
+
 private:
+  // -- Sample n gammas directly with the brem. model (one model call per
+  // -- gamma, without the process overhead). False if the wrapped process
+  // -- is not an energy loss process.
+  G4bool SampleGammas(const G4BiasingProcessInterface *callingProcess,
+                      const G4Track *track, const G4Step *step, G4int n,
+                      G4double gammaWeight);
+
+  // -- Add the gamma to the final state, after the russian roulette (the
+  // -- track is deleted if it is killed):
+  void AddGamma(G4Track *gammaTrack, G4double gammaWeight);
+
   G4int fSplittingFactor;
+  G4bool fRussianRoulette;
+  G4ThreeVector fVectorDirector;
+  G4double fCosMaxTheta;
   G4ParticleChange fParticleChange;
+  // -- gammas of the model calls (storage reused at each interaction):
+  std::vector<G4DynamicParticle *> fGammas;
 };
 
 #endif
@@ -52,6 +52,9 @@ void GateBOptrBremSplittingActor::InitializeUserInfo(py::dict &user_info) {
   fSplittingFactor = DictGetInt(user_info, "splitting_factor");
   fBiasPrimaryOnly = DictGetBool(user_info, "bias_primary_only");
   fBiasOnlyOnce = DictGetBool(user_info, "bias_only_once");
+  fRussianRoulette = DictGetBool(user_info, "russian_roulette");
+  fVectorDirector = DictGetG4ThreeVector(user_info, "vector_director");
+  fMaxTheta = DictGetDouble(user_info, "max_theta");
 }
 
 void GateBOptrBremSplittingActor::InitializeCpp() {
@@ -68,6 +71,9 @@ StartRun(run);
 */
 void GateBOptrBremSplittingActor::StartRun() {
   fBremSplittingOperation->SetSplittingFactor(fSplittingFactor);
+  fBremSplittingOperation->SetRussianRoulette(fRussianRoulette);
+  fBremSplittingOperation->SetVectorDirector(fVectorDirector);
+  fBremSplittingOperation->SetMaxTheta(fMaxTheta);
   G4LogicalVolume *biasingVolume =
       G4LogicalVolumeStore::GetInstance()->GetVolume(fAttachedToVolumeName);
   if (fBiasPrimaryOnly)
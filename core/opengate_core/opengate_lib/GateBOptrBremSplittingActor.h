@@ -58,6 +58,9 @@ public:
   G4bool fBiasPrimaryOnly;
   G4bool fBiasOnlyOnce;
   G4int fNInteractions;
+  G4bool fRussianRoulette;
+  G4ThreeVector fVectorDirector;
+  G4double fMaxTheta;
   // Unused but mandatory
 
   void StartRun() override;
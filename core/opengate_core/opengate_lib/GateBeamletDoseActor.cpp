@@ -0,0 +1,131 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateBeamletDoseActor.h"
+#include "GateHelpers.h"
+#include "GateHelpersDict.h"
+#include "GateHelpersImage.h"
+#include "GateMutex.h"
+#include "GateSpotInformation.h"
+#include <algorithm>
+#include <sstream>
+
+// Mutex that will be used by thread to merge their matrix
+GATE_MUTEX(SetBeamletMatrixMutex);
+
+GateBeamletDoseActor::GateBeamletDoseActor(py::dict &user_info)
+    : GateVActor(user_info, true) {}
+
+void GateBeamletDoseActor::InitializeUserInfo(py::dict &user_info) {
+  // IMPORTANT: call the base class method
+  GateVActor::InitializeUserInfo(user_info);
+
+  fInitialTranslation = DictGetG4ThreeVector(user_info, "translation");
+  fDoseFlag = DictGetStr(user_info, "quantity") == "dose";
+  // Hit type (random, pre, post etc)
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+  // the hit position function is resolved once, not at every step
+  switch (fHitType) {
+  case HitType::Pre:
+    fHitPosition = &GetHitPosition<HitType::Pre>;
+    break;
+  case HitType::Post:
+    fHitPosition = &GetHitPosition<HitType::Post>;
+    break;
+  case HitType::Middle:
+    fHitPosition = &GetHitPosition<HitType::Middle>;
+    break;
+  case HitType::Random:
+    fHitPosition = &GetHitPosition<HitType::Random>;
+    break;
+  case HitType::Segment:
+    Fatal("Error in GateBeamletDoseActor: hit_type 'segment' is not "
+          "available, use 'pre', 'post', 'middle' or 'random'.");
+    break;
+  }
+}
+
+void GateBeamletDoseActor::InitializeCpp() {
+  // Create the image pointer
+  // (the size and allocation will be performed on the py side)
+  cpp_dose_image = ImageType::New();
+}
+
+void GateBeamletDoseActor::StartSimulationAction() { fMatrix.clear(); }
+
+void GateBeamletDoseActor::BeginOfRunActionMasterThread(int run_id) {
+  // the flat voxel index is stored in 32 bits (see Key)
+  auto n = cpp_dose_image->GetLargestPossibleRegion().GetNumberOfPixels();
+  if (n > 0xFFFFFFFFu) {
+    std::ostringstream oss;
+    oss << "Error in GateBeamletDoseActor: the image has " << n
+        << " voxels, the maximum is " << 0xFFFFFFFFu;
+    Fatal(oss.str());
+  }
+  // Important ! The volume may have moved, so we re-attach each run
+  AttachImageToVolume<ImageType>(cpp_dose_image, fPhysicalVolumeName,
+                                 fInitialTranslation);
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(cpp_dose_image.GetPointer());
+  auto sp = cpp_dose_image->GetSpacing();
+  fVoxelVolume = sp[0] * sp[1] * sp[2];
+}
+
+void GateBeamletDoseActor::BeginOfEventAction(const G4Event *event) {
+  // -1 if the event does not come from a treatment plan source
+  auto &l = fThreadLocalData.Get();
+  l.current_spot = GateSpotInformation::GetSpotIndex(event);
+}
+
+void GateBeamletDoseActor::SteppingAction(G4Step *step) {
+  auto &l = fThreadLocalData.Get();
+  if (l.current_spot < 0)
+    return;
+  auto edep = step->GetTotalEnergyDeposit();
+  if (edep == 0)
+    return;
+
+  // pre, post, middle or random position
+  auto position = fHitPosition(step);
+  ImageType::IndexType index;
+  if (!fIndexTransform.TransformPointToIndex(position, index))
+    return;
+
+  auto value = edep * step->GetTrack()->GetWeight();
+  if (fDoseFlag) {
+    auto density = step->GetPreStepPoint()->GetMaterial()->GetDensity();
+    value /= density * fVoxelVolume;
+  }
+  // no lock: each thread writes in its own matrix, and the sum over the
+  // spots is added with atomic additions
+  auto offset = cpp_dose_image->ComputeOffset(index);
+  l.matrix[Key(l.current_spot, offset)] += value;
+  ImageAtomicAddValueAtOffset<ImageType>(cpp_dose_image, offset, value);
+}
+
+void GateBeamletDoseActor::EndOfRunAction(const G4Run *) {
+  // merge the matrix of this thread in the shared one
+  auto &l = fThreadLocalData.Get();
+  {
+    GateAutoLock mutex(&SetBeamletMatrixMutex);
+    if (fMatrix.empty()) {
+      fMatrix.swap(l.matrix);
+    } else {
+      for (const auto &e : l.matrix)
+        fMatrix[e.first] += e.second;
+    }
+  }
+  MatrixType().swap(l.matrix);
+}
+
+std::vector<std::pair<std::uint64_t, double>>
+GateBeamletDoseActor::GetSortedElements() const {
+  std::vector<std::pair<std::uint64_t, double>> elements(fMatrix.begin(),
+                                                         fMatrix.end());
+  std::sort(elements.begin(), elements.end());
+  return elements;
+}
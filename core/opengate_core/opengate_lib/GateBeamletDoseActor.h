@@ -0,0 +1,111 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateBeamletDoseActor_h
+#define GateBeamletDoseActor_h
+
+#include "G4Cache.hh"
+#include "GateHelpersImage.h"
+#include "GateVActor.h"
+#include "itkImage.h"
+#include <cstdint>
+#include <pybind11/stl.h>
+#include <unordered_map>
+#include <vector>
+
+namespace py = pybind11;
+
+/*
+    Dose (or edep) of each spot of a treatment plan in each voxel: the dose
+    influence matrix (voxel, spot) used for the plan optimization, scored in
+    a single simulation. The spot of an event is the one of its first primary
+    vertex (see GateSpotInformation), the events without spot are ignored.
+
+    Each thread accumulates a sparse matrix (hash map of the non zero
+    elements), merged in the shared matrix at the end of each run. The sum
+    over the spots is also scored in the image (same geometry).
+ */
+
+class GateBeamletDoseActor : public GateVActor {
+
+public:
+  // Constructor
+  GateBeamletDoseActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  void BeginOfEventAction(const G4Event *event) override;
+
+  void SteppingAction(G4Step *step) override;
+
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  inline std::string GetPhysicalVolumeName() const {
+    return fPhysicalVolumeName;
+  }
+
+  inline void SetPhysicalVolumeName(std::string s) { fPhysicalVolumeName = s; }
+
+  // Number of non zero elements of the matrix
+  size_t GetNumberOfElements() const { return fMatrix.size(); }
+
+  // Non zero elements of the matrix (key, value), sorted by spot then voxel
+  std::vector<std::pair<std::uint64_t, double>> GetSortedElements() const;
+
+  // key of an element: spot in the high bits, flat voxel index (same as the
+  // image, x fastest) in the low bits
+  static std::uint64_t Key(int spot, itk::OffsetValueType voxel) {
+    return (static_cast<std::uint64_t>(spot) << 32) |
+           static_cast<std::uint64_t>(voxel);
+  }
+
+  static int KeyToSpot(std::uint64_t key) {
+    return static_cast<int>(key >> 32);
+  }
+
+  static std::uint64_t KeyToVoxel(std::uint64_t key) {
+    return key & 0xFFFFFFFFu;
+  }
+
+  typedef itk::Image<double, 3> ImageType;
+
+  // Sum over the spots (shared by all threads)
+  ImageType::Pointer cpp_dose_image;
+
+  std::string fPhysicalVolumeName;
+
+protected:
+  typedef std::unordered_map<std::uint64_t, double> MatrixType;
+
+  // Option: score the dose (edep / mass) instead of the edep
+  bool fDoseFlag = true;
+
+  G4ThreeVector fInitialTranslation;
+  HitType fHitType = HitType::Random;
+  G4ThreeVector (*fHitPosition)(const G4Step *){};
+  GateImageIndexTransform fIndexTransform;
+  double fVoxelVolume = 0;
+
+  // merged matrix of all threads and runs
+  MatrixType fMatrix;
+
+  struct threadLocalT {
+    // spot of the current event (-1: not scored)
+    int current_spot = -1;
+    MatrixType matrix;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateBeamletDoseActor_h
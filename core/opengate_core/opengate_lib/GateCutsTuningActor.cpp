@@ -0,0 +1,192 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateCutsTuningActor.h"
+#include "G4Electron.hh"
+#include "G4EmProcessSubType.hh"
+#include "G4Gamma.hh"
+#include "G4Material.hh"
+#include "G4ParticleTable.hh"
+#include "G4Positron.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Region.hh"
+#include "G4VProcess.hh"
+#include "GateHelpers.h"
+#include "GateHelpersDict.h"
+#include "GateMutex.h"
+
+#include <cmath>
+
+GATE_MUTEX(CutsTuningMergeMutex);
+
+GateCutsTuningActor::GateCutsTuningActor(py::dict &user_info)
+    : GateVActor(user_info, true) {}
+
+void GateCutsTuningActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fEnergyMin = DictGetDouble(user_info, "energy_min");
+  fEnergyMax = DictGetDouble(user_info, "energy_max");
+  fNbBins = DictGetInt(user_info, "number_of_energy_bins");
+  if (fEnergyMin <= 0 || fEnergyMax <= fEnergyMin || fNbBins < 1) {
+    std::ostringstream oss;
+    oss << "Error in GateCutsTuningActor: the energy range must be positive "
+           "and increasing, with at least one bin, while "
+        << fEnergyMin << " " << fEnergyMax << " " << fNbBins << " are read.";
+    Fatal(oss.str());
+  }
+  fLogEnergyMin = std::log(fEnergyMin);
+  fBinsPerLogEnergy = fNbBins / (std::log(fEnergyMax) - fLogEnergyMin);
+}
+
+void GateCutsTuningActor::StartSimulationAction() {
+  fParticles[0] = G4Gamma::Gamma();
+  fParticles[1] = G4Electron::Electron();
+  fParticles[2] = G4Positron::Positron();
+  fRegions.clear();
+}
+
+void GateCutsTuningActor::BeginOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  l.regions.clear();
+  l.track_counts = nullptr;
+  l.track_slot = -1;
+}
+
+int GateCutsTuningActor::GetParticleIndex(
+    const G4ParticleDefinition *p) const {
+  for (int i = 0; i < fNbParticles; i++)
+    if (p == fParticles[i])
+      return i;
+  return -1;
+}
+
+int GateCutsTuningActor::GetEnergyBin(double energy) const {
+  // the energies out of the range are in the first or last bin
+  if (energy <= fEnergyMin)
+    return 0;
+  auto b = int((std::log(energy) - fLogEnergyMin) * fBinsPerLogEnergy);
+  return std::min(b, fNbBins - 1);
+}
+
+GateCutsTuningActor::RegionCounts &
+GateCutsTuningActor::GetRegionCounts(const G4Region *region) {
+  auto &regions = fThreadLocalData.Get().regions;
+  auto it = regions.find(region);
+  if (it != regions.end())
+    return it->second;
+  auto &c = regions[region];
+  auto n = fNbParticles * fNbBins;
+  c.secondaries.assign(n, 0);
+  c.secondary_energy.assign(n, 0.0);
+  c.secondary_steps.assign(n, 0);
+  return c;
+}
+
+void GateCutsTuningActor::PreUserTrackingAction(const G4Track *track) {
+  auto &l = fThreadLocalData.Get();
+  l.track_counts = nullptr;
+  l.track_slot = -1;
+  if (track->GetParentID() == 0)
+    return;
+
+  // only the secondaries of the processes that apply the production cuts
+  auto *process = track->GetCreatorProcess();
+  if (process == nullptr || process->GetProcessType() != fElectromagnetic)
+    return;
+  auto sub_type = process->GetProcessSubType();
+  if (sub_type != fIonisation && sub_type != fBremsstrahlung)
+    return;
+  auto p = GetParticleIndex(track->GetParticleDefinition());
+  if (p < 0)
+    return;
+
+  auto energy = track->GetVertexKineticEnergy();
+  auto slot = p * fNbBins + GetEnergyBin(energy);
+  auto &c = GetRegionCounts(track->GetLogicalVolumeAtVertex()->GetRegion());
+  c.secondaries[slot]++;
+  c.secondary_energy[slot] += energy * track->GetWeight();
+  l.track_counts = &c;
+  l.track_slot = slot;
+}
+
+void GateCutsTuningActor::SteppingAction(G4Step *step) {
+  auto *pre = step->GetPreStepPoint();
+  auto *region = pre->GetPhysicalVolume()->GetLogicalVolume()->GetRegion();
+  auto &c = GetRegionCounts(region);
+  c.steps++;
+  c.edep += step->GetTotalEnergyDeposit() * step->GetTrack()->GetWeight();
+  c.materials.insert(pre->GetMaterial());
+
+  // steps of the secondary, counted in the region where it was created
+  auto &l = fThreadLocalData.Get();
+  if (l.track_slot >= 0)
+    l.track_counts->secondary_steps[l.track_slot]++;
+}
+
+void GateCutsTuningActor::EndOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&CutsTuningMergeMutex);
+  for (auto &r : l.regions) {
+    auto &m = fRegions[r.first->GetName()];
+    if (m.secondaries.empty()) {
+      m.secondaries.assign(r.second.secondaries.size(), 0);
+      m.secondary_energy.assign(r.second.secondaries.size(), 0.0);
+      m.secondary_steps.assign(r.second.secondaries.size(), 0);
+    }
+    m.steps += r.second.steps;
+    m.edep += r.second.edep;
+    for (auto *mat : r.second.materials)
+      m.materials.insert(mat->GetName());
+    for (size_t i = 0; i < m.secondaries.size(); i++) {
+      m.secondaries[i] += r.second.secondaries[i];
+      m.secondary_energy[i] += r.second.secondary_energy[i];
+      m.secondary_steps[i] += r.second.secondary_steps[i];
+    }
+  }
+  l.regions.clear();
+}
+
+py::dict GateCutsTuningActor::GetRegionStatistics() const {
+  const char *names[fNbParticles] = {"gamma", "e-", "e+"};
+  py::dict regions;
+  for (auto &r : fRegions) {
+    py::dict d;
+    d["steps"] = r.second.steps;
+    d["edep"] = r.second.edep;
+    d["materials"] = std::vector<std::string>(r.second.materials.begin(),
+                                              r.second.materials.end());
+    py::dict secondaries, energy, steps;
+    for (int p = 0; p < fNbParticles; p++) {
+      auto b = r.second.secondaries.begin() + p * fNbBins;
+      auto e = r.second.secondary_energy.begin() + p * fNbBins;
+      auto s = r.second.secondary_steps.begin() + p * fNbBins;
+      secondaries[names[p]] = std::vector<long>(b, b + fNbBins);
+      energy[names[p]] = std::vector<double>(e, e + fNbBins);
+      steps[names[p]] = std::vector<long>(s, s + fNbBins);
+    }
+    d["secondaries"] = secondaries;
+    d["secondary_energy"] = energy;
+    d["secondary_steps"] = steps;
+    regions[r.first.c_str()] = d;
+  }
+  return regions;
+}
+
+double GateCutsTuningActor::ConvertRangeToEnergy(const std::string &particle,
+                                                 const std::string &material,
+                                                 double range) {
+  auto *p = G4ParticleTable::GetParticleTable()->FindParticle(particle);
+  auto *m = G4Material::GetMaterial(material);
+  if (p == nullptr || m == nullptr) {
+    std::ostringstream oss;
+    oss << "Error in GateCutsTuningActor: unknown particle '" << particle
+        << "' or material '" << material << "'.";
+    Fatal(oss.str());
+  }
+  return G4ProductionCutsTable::GetProductionCutsTable()->ConvertRangeToEnergy(
+      p, m, range);
+}
@@ -0,0 +1,107 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateCutsTuningActor_h
+#define GateCutsTuningActor_h
+
+#include "G4Cache.hh"
+#include "GateVActor.h"
+#include <map>
+#include <pybind11/stl.h>
+#include <set>
+#include <unordered_map>
+
+namespace py = pybind11;
+
+class G4Material;
+class G4ParticleDefinition;
+class G4Region;
+
+/*
+    Pilot run statistics per region, to tune the production cuts: steps and
+    edep of the region, and the secondaries that a production cut would
+    suppress (delta rays and bremsstrahlung photons, gamma, e- and e+), per
+    bin of their initial energy (log bins): number, energy and number of
+    steps of these secondaries. The cuts are proposed on the py side.
+ */
+
+class GateCutsTuningActor : public GateVActor {
+
+public:
+  explicit GateCutsTuningActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void PreUserTrackingAction(const G4Track *track) override;
+
+  void SteppingAction(G4Step *step) override;
+
+  void EndOfRunAction(const G4Run *run) override;
+
+  // {region: {steps, edep, materials, secondaries, secondary_energy,
+  // secondary_steps}}, the last three as {particle: [values per bin]}
+  py::dict GetRegionStatistics() const;
+
+  // Energy threshold of a range cut for the particle in the material
+  static double ConvertRangeToEnergy(const std::string &particle,
+                                     const std::string &material,
+                                     double range);
+
+protected:
+  // gamma, e-, e+ (the particles of the production cuts, except proton)
+  static constexpr int fNbParticles = 3;
+
+  int GetParticleIndex(const G4ParticleDefinition *p) const;
+
+  int GetEnergyBin(double energy) const;
+
+  struct RegionCounts {
+    long steps = 0;
+    double edep = 0;
+    std::set<const G4Material *> materials;
+    // index: particle * number of bins + bin
+    std::vector<long> secondaries;
+    std::vector<double> secondary_energy;
+    std::vector<long> secondary_steps;
+  };
+
+  RegionCounts &GetRegionCounts(const G4Region *region);
+
+  double fEnergyMin = 0;
+  double fEnergyMax = 0;
+  int fNbBins = 0;
+  double fLogEnergyMin = 0;
+  double fBinsPerLogEnergy = 0;
+  const G4ParticleDefinition *fParticles[fNbParticles]{};
+
+  struct threadLocalT {
+    // node based: the references to the counts stay valid
+    std::unordered_map<const G4Region *, RegionCounts> regions;
+    // counts of the region where the current track was created, and its
+    // (particle, bin) slot (-1: not a secondary that a cut would suppress)
+    RegionCounts *track_counts = nullptr;
+    int track_slot = -1;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+
+  // merged by region name (end of each run)
+  struct MergedCounts {
+    long steps = 0;
+    double edep = 0;
+    std::set<std::string> materials;
+    std::vector<long> secondaries;
+    std::vector<double> secondary_energy;
+    std::vector<long> secondary_steps;
+  };
+  std::map<std::string, MergedCounts> fRegions;
+};
+
+#endif // GateCutsTuningActor_h
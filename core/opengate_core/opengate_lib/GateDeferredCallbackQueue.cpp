@@ -0,0 +1,97 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDeferredCallbackQueue.h"
+#include "GateHelpers.h"
+#include <pybind11/pybind11.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+GateDeferredCallbackQueue *GateDeferredCallbackQueue::fInstance = nullptr;
+
+GateDeferredCallbackQueue *GateDeferredCallbackQueue::GetInstance() {
+  static std::once_flag once;
+  std::call_once(once, []() { fInstance = new GateDeferredCallbackQueue(); });
+  return fInstance;
+}
+
+GateDeferredCallbackQueue::GateDeferredCallbackQueue() { fRunning = false; }
+
+std::shared_future<void> GateDeferredCallbackQueue::Enqueue(TaskType task) {
+  Task t{std::move(task), std::promise<void>()};
+  auto future = t.fDone.get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fRunning) {
+      fTasks.push_back(std::move(t));
+      fCondition.notify_one();
+      return future;
+    }
+  }
+  // no consumer thread: direct callback
+  t.fTask();
+  t.fDone.set_value();
+  return future;
+}
+
+void GateDeferredCallbackQueue::Wait(std::shared_future<void> &future,
+                                     const std::string &name) {
+  try {
+    future.get();
+  } catch (const std::exception &e) {
+    std::ostringstream oss;
+    oss << "Error in the Python callback of '" << name << "': " << e.what();
+    Fatal(oss.str());
+  }
+}
+
+void GateDeferredCallbackQueue::Start() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = true;
+}
+
+void GateDeferredCallbackQueue::Stop() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = false;
+  fCondition.notify_all();
+}
+
+bool GateDeferredCallbackQueue::IsRunning() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fRunning;
+}
+
+void GateDeferredCallbackQueue::RunConsumer() {
+  while (true) {
+    Task t;
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fCondition.wait(lock, [this] { return !fRunning || !fTasks.empty(); });
+      // the remaining tasks are executed after Stop
+      if (fTasks.empty())
+        return;
+      t = std::move(fTasks.front());
+      fTasks.pop_front();
+    }
+    // the task acquires the GIL when it calls Python
+    try {
+      t.fTask();
+      t.fDone.set_value();
+    } catch (const std::exception &e) {
+      // the error is given to the waiting thread, without Python object
+      std::string message;
+      {
+        py::gil_scoped_acquire acquire;
+        message = e.what();
+      }
+      t.fDone.set_exception(
+          std::make_exception_ptr(std::runtime_error(message)));
+    }
+  }
+}
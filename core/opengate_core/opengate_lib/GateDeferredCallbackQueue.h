@@ -0,0 +1,67 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDeferredCallbackQueue_h
+#define GateDeferredCallbackQueue_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+
+/*
+    Global singleton class that runs the Python callbacks of the Geant4
+    threads in a single consumer thread (started on the Python side during
+    the run, see SourceEngine.start). A Geant4 thread enqueues a task (which
+    owns the batch of data it needs) and continues: it never waits for the
+    GIL. The returned future is ready once the task is done, and rethrows
+    its error. Without consumer thread, the task is executed immediately by
+    the calling thread (as a direct callback).
+ */
+
+class GateDeferredCallbackQueue {
+public:
+  using TaskType = std::function<void()>;
+
+  static GateDeferredCallbackQueue *GetInstance();
+
+  // Called by the Geant4 threads (never acquire the GIL)
+  std::shared_future<void> Enqueue(TaskType task);
+
+  // Wait for a task, Fatal with its error if any (never acquire the GIL)
+  static void Wait(std::shared_future<void> &future, const std::string &name);
+
+  // The tasks are deferred from Start to Stop
+  void Start();
+
+  void Stop();
+
+  bool IsRunning();
+
+  // Loop of the consumer thread: execute the tasks until Stop
+  // (must be called with the GIL released)
+  void RunConsumer();
+
+protected:
+  GateDeferredCallbackQueue();
+
+  static GateDeferredCallbackQueue *fInstance;
+
+  struct Task {
+    TaskType fTask;
+    std::promise<void> fDone;
+  };
+
+  std::mutex fMutex;
+  std::condition_variable fCondition;
+  std::deque<Task> fTasks;
+  bool fRunning;
+};
+
+#endif // GateDeferredCallbackQueue_h
@@ -0,0 +1,123 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDepositQueue_h
+#define GateDepositQueue_h
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+    Per-thread queue of voxel deposits, applied to the images by batches.
+
+    Each deposit is a record (flat voxel index, N values), e.g. edep, dose
+    and count for the dose actor. The records are only appended during the
+    steps; when the queue is full (or at the end of the run), they are sorted
+    by tile of TileSize^3 voxels (same tiles as GateSparseImage) then by
+    voxel, the deposits in the same voxel are summed, and the function
+    apply(flat_index, values) is called once per voxel. The images are thus
+    written in a cache-friendly order, and the caller can take a single lock
+    (or do one atomic addition per voxel) for the whole batch instead of one
+    per step.
+
+    This class is not thread safe: it is intended to be used as a thread
+    local buffer.
+ */
+
+template <int N> class GateDepositQueue {
+public:
+  // Tiles of 8x8x8 voxels
+  static constexpr int TileShift = 3;
+  static constexpr int TileMask = (1 << TileShift) - 1;
+
+  typedef std::array<double, N> Values;
+
+  // Set the image size (in voxels) and the number of deposits per batch,
+  // the queue is emptied
+  void Initialize(long size_x, long size_y, long size_z, size_t capacity) {
+    fSize[0] = size_x;
+    fSize[1] = size_y;
+    fSize[2] = size_z;
+    for (int i = 0; i < 3; i++)
+      fNumberOfTiles[i] = (fSize[i] + TileMask) >> TileShift;
+    fCapacity = std::max<size_t>(capacity, 1);
+    fRecords.clear();
+    fRecords.reserve(fCapacity);
+    fNumberOfFlushes = 0;
+  }
+
+  // Add a deposit, return true when the queue is full (see Flush)
+  bool Push(long x, long y, long z, const Values &values) {
+    auto flat = x + fSize[0] * (y + fSize[1] * z);
+    fRecords.push_back({Key(x, y, z, flat), flat, values});
+    return fRecords.size() >= fCapacity;
+  }
+
+  bool IsEmpty() const { return fRecords.empty(); }
+
+  size_t GetNumberOfDeposits() const { return fRecords.size(); }
+
+  // Number of batches applied since Initialize (for the tests)
+  size_t GetNumberOfFlushes() const { return fNumberOfFlushes; }
+
+  // Sort the deposits by tile and voxel, and call apply(flat_index, values)
+  // once per voxel with the sum of its deposits. The queue is emptied.
+  template <class F> void Flush(F apply) {
+    if (fRecords.empty())
+      return;
+    std::sort(fRecords.begin(), fRecords.end(),
+              [](const Record &a, const Record &b) { return a.key < b.key; });
+    auto current = fRecords.front();
+    for (size_t i = 1; i < fRecords.size(); i++) {
+      const auto &r = fRecords[i];
+      if (r.key == current.key) {
+        for (int j = 0; j < N; j++)
+          current.values[j] += r.values[j];
+        continue;
+      }
+      apply(current.flat, current.values);
+      current = r;
+    }
+    apply(current.flat, current.values);
+    fRecords.clear();
+    fNumberOfFlushes++;
+  }
+
+  // Release the memory of the queue (the size is kept)
+  void Clear() { std::vector<Record>().swap(fRecords); }
+
+  size_t GetMemoryBytes() const { return fRecords.capacity() * sizeof(Record); }
+
+protected:
+  struct Record {
+    uint64_t key;
+    long flat;
+    Values values;
+  };
+
+  // Sort key: tile index first (z, y, x of the tile), then the flat index of
+  // the voxel inside the tile
+  uint64_t Key(long x, long y, long z, long flat) const {
+    uint64_t tile =
+        (x >> TileShift) +
+        fNumberOfTiles[0] *
+            ((y >> TileShift) + fNumberOfTiles[1] * (z >> TileShift));
+    uint64_t voxel = ((z & TileMask) << (2 * TileShift)) |
+                     ((y & TileMask) << TileShift) | (x & TileMask);
+    return (tile << (3 * TileShift)) | voxel;
+  }
+
+  long fSize[3] = {0, 0, 0};
+  long fNumberOfTiles[3] = {0, 0, 0};
+  size_t fCapacity = 1;
+  size_t fNumberOfFlushes = 0;
+  std::vector<Record> fRecords;
+};
+
+#endif // GateDepositQueue_h
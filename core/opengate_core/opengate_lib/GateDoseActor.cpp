@@ -17,22 +17,30 @@
 #include "GateDoseActor.h"
 #include "GateHelpersDict.h"
 #include "GateHelpersImage.h"
+#include "GateHugePages.h"
+#include "GateMemoryAccounting.h"
+#include "GateMutex.h"
+#include "GateProgressMonitor.h"
+#include "GateStepContext.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <itkAddImageFilter.h>
 #include <itkImageRegionIterator.h>
-#include <queue>
 #include <vector>
 
 // Mutex that will be used by thread to write in the edep/dose image
-G4Mutex SetWorkerEndRunMutex = G4MUTEX_INITIALIZER;
-G4Mutex SetPixelMutex = G4MUTEX_INITIALIZER;
-G4Mutex ComputeUncertaintyMutex = G4MUTEX_INITIALIZER;
-G4Mutex SetNbEventMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetPixelMutex);
+GATE_MUTEX(ComputeUncertaintyMutex);
+GATE_MUTEX(SetNbEventMutex);
 
 GateDoseActor::GateDoseActor(py::dict &user_info)
-    : GateVActor(user_info, true) {}
+    : GateVActor(user_info, true) {
+  fScoringMode = ScoringMode::Mutex;
+}
 
 void GateDoseActor::InitializeUserInfo(py::dict &user_info) {
   // IMPORTANT: call the base class method
@@ -41,13 +49,81 @@ void GateDoseActor::InitializeUserInfo(py::dict &user_info) {
   // translation
   fTranslation = DictGetG4ThreeVector(user_info, "translation");
   // Hit type (random, pre, post etc)
-  fHitType = DictGetStr(user_info, "hit_type");
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+  // Tabulated stopping power ratios (dose to water)
+  fStoppingPowerTableFlag = DictGetBool(user_info, "stopping_power_table");
+  // Number of events per sample for the squared values
+  fBatchSize = DictGetInt(user_info, "uncertainty_batch_size");
+  if (fBatchSize < 1) {
+    std::ostringstream oss;
+    oss << "Error in GateDoseActor: uncertainty_batch_size must be at least 1"
+        << " while " << fBatchSize << " is read.";
+    Fatal(oss.str());
+  }
+
+  // Scoring mode: shared images (mutex or atomic) or per-thread buffers
+  auto mode = DictGetStr(user_info, "scoring_mode");
+  if (mode == "mutex")
+    fScoringMode = ScoringMode::Mutex;
+  else if (mode == "thread_local")
+    fScoringMode = ScoringMode::ThreadLocal;
+  else if (mode == "atomic")
+    fScoringMode = ScoringMode::Atomic;
+  else if (mode == "sparse")
+    fScoringMode = ScoringMode::Sparse;
+  else if (mode == "queue")
+    fScoringMode = ScoringMode::Queue;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateDoseActor: unknown scoring_mode. Must be "
+           "'mutex', 'thread_local', 'atomic', 'sparse' or 'queue'"
+        << " while '" << mode << "' is read.";
+    Fatal(oss.str());
+  }
+
+  // Number of deposits per batch (Queue scoring mode)
+  fQueueSize = DictGetInt(user_info, "queue_size");
+  if (fQueueSize < 1) {
+    std::ostringstream oss;
+    oss << "Error in GateDoseActor: queue_size must be at least 1"
+        << " while " << fQueueSize << " is read.";
+    Fatal(oss.str());
+  }
+
+  // Precision of the per-thread buffers (ThreadLocal scoring mode)
+  auto precision = DictGetStr(user_info, "buffer_precision");
+  if (precision != "double" && precision != "float") {
+    std::ostringstream oss;
+    oss << "Error in GateDoseActor: unknown buffer_precision. Must be "
+           "'double' or 'float'"
+        << " while '" << precision << "' is read.";
+    Fatal(oss.str());
+  }
+  fFloatBufferFlag = precision == "float";
+
+  // One frame per run in a memory-mapped file
+  fEdepPerRunFlag = DictGetBool(user_info, "write_edep_per_run");
+
+  // One frame per time interval in a memory-mapped file (0 frame: none)
+  fEdepTimeFrames.Configure(DictGetDouble(user_info, "time_frame_start"),
+                            DictGetDouble(user_info, "time_frame_duration"),
+                            DictGetInt(user_info, "number_of_time_frames"),
+                            DictGetInt(user_info, "time_frame_buffer"));
+
+  // Intermediate images taken during the run (0: no snapshot)
+  auto snapshot_events = DictGetInt(user_info, "snapshot_event_interval");
+  auto snapshot_time = DictGetDouble(user_info, "snapshot_time_interval");
+  fEdepSnapshot.SetIntervals(snapshot_events, snapshot_time);
+  fDoseSnapshot.SetIntervals(snapshot_events, snapshot_time);
 }
 
 void GateDoseActor::InitializeCpp() {
   GateVActor::InitializeCpp();
   NbOfThreads = G4Threading::GetNumberOfRunningWorkerThreads();
 
+  // The flags are set from the py side before this point
+  SelectSteppingKernel();
+
   // Create the image pointers
   // (the size and allocation will be performed on the py side)
   cpp_edep_image = Image3DType::New();
@@ -69,10 +145,18 @@ void GateDoseActor::InitializeCpp() {
 void GateDoseActor::BeginOfRunActionMasterThread(int run_id) {
   // Reset the number of events (per run)
   NbOfEvent = 0;
+  NbOfBatches = 0;
+  fNbQueueFlushes = 0;
 
   // for stop on target uncertainty. As we reset the nb of events, we reset also
   // this variable
   NbEventsNextCheck = NbEventsFirstCheck;
+  fSharedSquaredFlag = fUncertaintyGoal > 0;
+
+  // The material is searched once, not at every step
+  if (fToWaterFlag) {
+    fWaterMaterial = G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
+  }
 
   // Important ! The volume may have moved, so we re-attach each run
   AttachImageToVolume<Image3DType>(cpp_edep_image, fPhysicalVolumeName,
@@ -83,6 +167,10 @@ void GateDoseActor::BeginOfRunActionMasterThread(int run_id) {
   // compute volume of a dose voxel
   Image3DType::RegionType region = cpp_edep_image->GetLargestPossibleRegion();
   size_edep = region.GetSize();
+  fStripedMerge.Initialize(size_edep[2], GateSparseImage<double>::TileSize);
+
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(cpp_edep_image.GetPointer());
 
   if (fEdepSquaredFlag) {
     AttachImageToVolume<Image3DType>(cpp_edep_squared_image,
@@ -100,230 +188,565 @@ void GateDoseActor::BeginOfRunActionMasterThread(int run_id) {
     AttachImageToVolume<Image3DType>(cpp_counts_image, fPhysicalVolumeName,
                                      fTranslation);
   }
+
+  // the time frames are defined for the whole simulation, with the geometry
+  // of the first run
+  if (fEdepTimeFrames.IsEnabled() && !fEdepTimeFrames.IsOpen()) {
+    size_t size[3];
+    double spacing[3];
+    double origin[3];
+    for (int i = 0; i < 3; i++) {
+      size[i] = size_edep[i];
+      spacing[i] = cpp_edep_image->GetSpacing()[i];
+      origin[i] = cpp_edep_image->GetOrigin()[i];
+    }
+    fEdepTimeFrames.Open(GetOutputPath("edep_per_time_frame"), size, spacing,
+                         origin);
+  }
+
+  // the dense images are not allocated during the run (see the py side)
+  if (fScoringMode == ScoringMode::Sparse) {
+    for (auto *sparse : {&fEdepSparseImage, &fEdepSquaredSparseImage,
+                         &fDoseSparseImage, &fDoseSquaredSparseImage,
+                         &fCountsSparseImage}) {
+      sparse->Initialize(size_edep[0], size_edep[1], size_edep[2]);
+    }
+  }
+
+  // the per-thread buffers are registered by the workers (BeginOfRunAction)
+  if (fEdepSnapshot.IsEnabled()) {
+    auto n = size_edep[0] * size_edep[1] * size_edep[2];
+    fEdepSnapshot.Reset(n);
+    fDoseSnapshot.Reset(fDoseFlag ? n : 0);
+  }
+  UpdateImagesMemoryAccounting();
+}
+
+namespace {
+size_t ImageMemoryBytes(const GateDoseActor::Image3DType::Pointer &image) {
+  if (image.IsNull() || image->GetBufferPointer() == nullptr)
+    return 0;
+  return image->GetPixelContainer()->Size() * sizeof(double);
 }
 
-void GateDoseActor::PrepareLocalDataForRun(threadLocalT &data,
-                                           int numberOfVoxels) {
-  data.squared_worker_flatimg.resize(numberOfVoxels);
-  std::fill(data.squared_worker_flatimg.begin(),
-            data.squared_worker_flatimg.end(), 0.0);
-  data.lastid_worker_flatimg.resize(numberOfVoxels);
-  std::fill(data.lastid_worker_flatimg.begin(),
-            data.lastid_worker_flatimg.end(), 0);
+template <class T> size_t VectorMemoryBytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+} // namespace
+
+void GateDoseActor::UpdateImagesMemoryAccounting() const {
+  if (!GateMemoryAccounting::IsEnabled())
+    return;
+  auto bytes = ImageMemoryBytes(cpp_edep_image) +
+               ImageMemoryBytes(cpp_edep_squared_image) +
+               ImageMemoryBytes(cpp_dose_image) +
+               ImageMemoryBytes(cpp_dose_squared_image) +
+               ImageMemoryBytes(cpp_density_image) +
+               ImageMemoryBytes(cpp_counts_image);
+  GateMemoryAccounting::Update("dose_images", GetName(), bytes);
+}
+
+void GateDoseActor::UpdateThreadLocalMemoryAccounting() {
+  if (!GateMemoryAccounting::IsEnabled())
+    return;
+  size_t bytes = 0;
+  for (auto *data : {&fThreadLocalDataEdep.Get(), &fThreadLocalDataDose.Get(),
+                     &fThreadLocalDataCounts.Get()}) {
+    bytes += data->sample_worker_sparseimg.GetMemoryBytes() +
+             VectorMemoryBytes(data->sample_voxels) +
+             data->sum_squared_worker_sparseimg.GetMemoryBytes() +
+             VectorMemoryBytes(data->value_worker_flatimg) +
+             VectorMemoryBytes(data->value_worker_flatimg_float) +
+             data->value_worker_sparseimg.GetMemoryBytes() +
+             data->deposit_queue.GetMemoryBytes();
+  }
+  GateMemoryAccounting::Update("dose_buffers", GetName(), bytes);
+}
+
+void GateDoseActor::PrepareSquaredLocalDataForRun(threadLocalT &data) {
+  // (the tiles are allocated when a voxel is touched for the first time)
+  data.sample_worker_sparseimg.Initialize(size_edep[0], size_edep[1],
+                                          size_edep[2]);
+  data.sample_voxels.clear();
+  data.sum_squared_worker_sparseimg.Initialize(size_edep[0], size_edep[1],
+                                               size_edep[2]);
+}
+
+void GateDoseActor::PrepareSparseLocalDataForRun(threadLocalT &data) {
+  data.value_worker_sparseimg.Initialize(size_edep[0], size_edep[1],
+                                         size_edep[2]);
 }
 
 void GateDoseActor::BeginOfRunAction(const G4Run *run) {
-  int N_voxels = size_edep[0] * size_edep[1] * size_edep[2];
+  // the tables are filled on the fly, for each particle/material
+  fThreadLocalDataEdep.Get().dedx_table.SetUseTable(fStoppingPowerTableFlag);
+  fThreadLocalDataEdep.Get().number_of_events = 0;
   if (fEdepSquaredFlag) {
-    PrepareLocalDataForRun(fThreadLocalDataEdep.Get(), N_voxels);
+    PrepareSquaredLocalDataForRun(fThreadLocalDataEdep.Get());
   }
   if (fDoseSquaredFlag) {
-    PrepareLocalDataForRun(fThreadLocalDataDose.Get(), N_voxels);
+    PrepareSquaredLocalDataForRun(fThreadLocalDataDose.Get());
+  }
+  if (fScoringMode == ScoringMode::Sparse) {
+    // tiles are allocated on the fly, when a voxel is hit for the first time
+    PrepareSparseLocalDataForRun(fThreadLocalDataEdep.Get());
+    PrepareSparseLocalDataForRun(fThreadLocalDataDose.Get());
+    PrepareSparseLocalDataForRun(fThreadLocalDataCounts.Get());
+    return;
+  }
+  if (fScoringMode == ScoringMode::Queue) {
+    // the deposits are applied to the shared images by batches
+    fThreadLocalDataEdep.Get().deposit_queue.Initialize(
+        size_edep[0], size_edep[1], size_edep[2], fQueueSize);
+    return;
+  }
+  int N_voxels = size_edep[0] * size_edep[1] * size_edep[2];
+  if (fScoringMode == ScoringMode::ThreadLocal && fFloatBufferFlag) {
+    // same in float (no snapshot in this case, see the py side)
+    GateHugePages::Assign(fThreadLocalDataEdep.Get().value_worker_flatimg_float,
+                          N_voxels, 0.0f, "dose_buffers");
+    if (fDoseFlag) {
+      GateHugePages::Assign(
+          fThreadLocalDataDose.Get().value_worker_flatimg_float, N_voxels,
+          0.0f, "dose_buffers");
+    }
+    if (fCountsFlag) {
+      GateHugePages::Assign(
+          fThreadLocalDataCounts.Get().value_worker_flatimg_float, N_voxels,
+          0.0f, "dose_buffers");
+    }
+  } else if (fScoringMode == ScoringMode::ThreadLocal) {
+    // one flat buffer per scored quantity, merged at the end of the run
+    GateHugePages::Assign(fThreadLocalDataEdep.Get().value_worker_flatimg,
+                          N_voxels, 0.0, "dose_buffers");
+    if (fDoseFlag) {
+      GateHugePages::Assign(fThreadLocalDataDose.Get().value_worker_flatimg,
+                            N_voxels, 0.0, "dose_buffers");
+    }
+    if (fCountsFlag) {
+      GateHugePages::Assign(fThreadLocalDataCounts.Get().value_worker_flatimg,
+                            N_voxels, 0.0, "dose_buffers");
+    }
+    // the snapshots read the buffers not yet merged in the shared images
+    if (fEdepSnapshot.IsEnabled()) {
+      fEdepSnapshot.RegisterBuffer(
+          fThreadLocalDataEdep.Get().value_worker_flatimg.data());
+      if (fDoseFlag) {
+        fDoseSnapshot.RegisterBuffer(
+            fThreadLocalDataDose.Get().value_worker_flatimg.data());
+      }
+    }
   }
 }
 
 void GateDoseActor::BeginOfEventAction(const G4Event *event) {
-  G4AutoLock mutex(&SetNbEventMutex);
-  NbOfEvent++;
+  fThreadLocalDataEdep.Get().number_of_events++;
+  NbOfEvent.fetch_add(1, std::memory_order_relaxed);
 }
 
 void GateDoseActor::GetVoxelPosition(G4Step *step, G4ThreeVector &position,
                                      bool &isInside,
                                      Image3DType::IndexType &index) const {
-  auto preGlobal = step->GetPreStepPoint()->GetPosition();
-  auto postGlobal = step->GetPostStepPoint()->GetPosition();
-  auto touchable = step->GetPreStepPoint()->GetTouchable();
+  // pre, post, middle or random position (resolved in InitializeCpp)
+  position = fHitPosition(step);
+  ComputeVoxelIndex(step, position, isInside, index);
+}
+
+void GateDoseActor::ComputeVoxelIndex(G4Step *step,
+                                      const G4ThreeVector &position,
+                                      bool &isInside,
+                                      Image3DType::IndexType &index) const {
+  // The image is placed in the world frame (see AttachImageToVolume), and
+  // the level 0 of the touchable history is the world (identity transform),
+  // so the global position is directly converted to the voxel index.
+  isInside = fIndexTransform.TransformPointToIndex(position, index);
+}
 
-  // consider random position between pre and post
-  if (fHitType == "pre") {
-    position = preGlobal;
+void GateDoseActor::SteppingAction(G4Step *step) {
+  // kernel specialized for the current options, see SelectSteppingKernel
+  (this->*fSteppingKernel)(step);
+}
+
+template <bool ToWater, bool Dose>
+void GateDoseActor::ComputeDeposit(G4Step *step, double &edep,
+                                   double &dose) {
+  // get edep in MeV (take weight into account)
+  auto w = step->GetTrack()->GetWeight();
+  edep = step->GetTotalEnergyDeposit() / CLHEP::MeV * w;
+  dose = 0;
+
+  // (material and dE/dx shared with the other actors of this step)
+  auto &context = GateStepContext::Get(step);
+  if constexpr (ToWater) {
+    // ratio dedx_water / dedx_currstep (zero if one of them is zero), at the
+    // mean energy of the step (electron dE/dx for gamma)
+    auto &table = fThreadLocalDataEdep.Get().dedx_table;
+    edep *= context.GetDEDXRatio(table, context.GetMaterial(), fWaterMaterial);
   }
-  if (fHitType == "random") {
-    auto x = G4UniformRand();
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + x * direction;
+
+  if constexpr (Dose) {
+    double density;
+    if constexpr (ToWater) {
+      density = fWaterMaterial->GetDensity();
+    } else {
+      density = context.GetDensity();
+    }
+    dose = edep / density;
+  }
+}
+
+void GateDoseActor::ScoreVoxel(Image3DType::IndexType index, double edep,
+                               double dose, bool count, double time) {
+  ScoreValues(index, edep, dose, count);
+  if (fEdepTimeFrames.IsEnabled()) {
+    fEdepTimeFrames.AddValue(time, index[0], index[1], index[2], edep);
   }
-  if (fHitType == "middle") {
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + 0.5 * direction;
+  if (fScoreFramesFlag) {
+    ScoreFrames(index, dose);
   }
 
-  auto localPosition =
-      touchable->GetHistory()->GetTransform(0).TransformPoint(position);
+  // (per-thread values of the sample, see EndOfSample)
+  if (fEdepSquaredFlag) {
+    ScoreSquaredValue(fThreadLocalDataEdep.Get(), edep, index);
+  }
+  if (fDoseSquaredFlag) {
+    ScoreSquaredValue(fThreadLocalDataDose.Get(), dose, index);
+  }
+}
 
-  // convert G4ThreeVector to itk PointType
-  Image3DType::PointType point;
-  point[0] = localPosition[0];
-  point[1] = localPosition[1];
-  point[2] = localPosition[2];
+template <HitType H, bool ToWater, bool Dose>
+void GateDoseActor::SteppingKernel(G4Step *step) {
+  // FIXME If the volume has multiple copy, touchable->GetCopyNumber(0) ?
 
-  isInside = cpp_edep_image->TransformPhysicalPointToIndex(point, index);
+  double edep;
+  double dose;
+  if constexpr (H == HitType::Segment) {
+    // the deposit is spread over the voxels crossed by the step,
+    // proportionally to the length of the step inside each voxel
+    ComputeDeposit<ToWater, Dose>(step, edep, dose);
+    auto time = GetStepTime(step);
+    fIndexTransform.ForEachVoxelOnSegment<Image3DType::IndexType>(
+        step->GetPreStepPoint()->GetPosition(),
+        step->GetPostStepPoint()->GetPosition(),
+        [&](const Image3DType::IndexType &index, double fraction) {
+          ScoreVoxel(index, edep * fraction, dose * fraction, fCountsFlag,
+                     time);
+        });
+  } else {
+    // Get the voxel index (shared by the actors with the same image
+    // geometry, see GateStepContext)
+    Image3DType::IndexType index;
+    bool isInside = GateStepContext::Get(step).GetVoxelIndex<H>(
+        fIndexTransform, index);
+    if (isInside) {
+      ComputeDeposit<ToWater, Dose>(step, edep, dose);
+      ScoreVoxel(index, edep, dose, fCountsFlag, GetStepTime(step));
+    }
+  }
 }
 
-void GateDoseActor::SteppingAction(G4Step *step) {
-  auto event_id =
-      G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
-  auto preGlobal = step->GetPreStepPoint()->GetPosition();
-  auto postGlobal = step->GetPostStepPoint()->GetPosition();
-  auto touchable = step->GetPreStepPoint()->GetTouchable();
+// Resolve the boolean template parameters of the kernel one at a time
+template <HitType H, bool... Flags> struct GateDoseActorKernelSelector {
+  static GateDoseActor::SteppingKernelType
+  Select(const std::array<bool, 2> &flags) {
+    if constexpr (sizeof...(Flags) == 2) {
+      return &GateDoseActor::SteppingKernel<H, Flags...>;
+    } else {
+      if (flags[sizeof...(Flags)]) {
+        return GateDoseActorKernelSelector<H, Flags..., true>::Select(flags);
+      }
+      return GateDoseActorKernelSelector<H, Flags..., false>::Select(flags);
+    }
+  }
+};
 
-  // FIXME If the volume has multiple copy, touchable->GetCopyNumber(0) ?
+void GateDoseActor::SelectSteppingKernel() {
+  const std::array<bool, 2> flags = {fToWaterFlag,
+                                     fDoseFlag || fDoseSquaredFlag};
+  switch (fHitType) {
+  case HitType::Pre:
+    fHitPosition = &GetHitPosition<HitType::Pre>;
+    fSteppingKernel =
+        GateDoseActorKernelSelector<HitType::Pre>::Select(flags);
+    break;
+  case HitType::Post:
+    fHitPosition = &GetHitPosition<HitType::Post>;
+    fSteppingKernel =
+        GateDoseActorKernelSelector<HitType::Post>::Select(flags);
+    break;
+  case HitType::Middle:
+    fHitPosition = &GetHitPosition<HitType::Middle>;
+    fSteppingKernel =
+        GateDoseActorKernelSelector<HitType::Middle>::Select(flags);
+    break;
+  case HitType::Random:
+    fHitPosition = &GetHitPosition<HitType::Random>;
+    fSteppingKernel =
+        GateDoseActorKernelSelector<HitType::Random>::Select(flags);
+    break;
+  case HitType::Segment:
+    // (a single position is only needed by GetVoxelPosition)
+    fHitPosition = &GetHitPosition<HitType::Random>;
+    fSteppingKernel =
+        GateDoseActorKernelSelector<HitType::Segment>::Select(flags);
+    break;
+  }
+}
 
-  // Get the voxel index
-  G4ThreeVector position;
-  bool isInside;
-  Image3DType::IndexType index;
-  GetVoxelPosition(step, position, isInside, index);
-
-  if (isInside) {
-
-    // get edep in MeV (take weight into account)
-    auto w = step->GetTrack()->GetWeight();
-    auto edep = step->GetTotalEnergyDeposit() / CLHEP::MeV * w;
-    double dose;
-
-    if (fToWaterFlag) {
-      auto *current_material = step->GetPreStepPoint()->GetMaterial();
-      double dedx_cut = DBL_MAX;
-      double dedx_currstep = 0., dedx_water = 0.;
-      const G4ParticleDefinition *p = step->GetTrack()->GetParticleDefinition();
-      static G4Material *water =
-          G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
-      auto energy1 = step->GetPreStepPoint()->GetKineticEnergy();
-      auto energy2 = step->GetPostStepPoint()->GetKineticEnergy();
-      auto energy = (energy1 + energy2) / 2;
-      if (p == G4Gamma::Gamma())
-        p = G4Electron::Electron();
-      auto &emc = fThreadLocalDataEdep.Get().emcalc;
-      dedx_currstep =
-          emc.ComputeTotalDEDX(energy, p, current_material, dedx_cut);
-      dedx_water = emc.ComputeTotalDEDX(energy, p, water, dedx_cut);
-      if (dedx_currstep == 0 || dedx_water == 0) {
-        edep = 0.;
-      } else {
-        edep *= (dedx_water / dedx_currstep);
-      }
+void GateDoseActor::ScoreValues(Image3DType::IndexType index, double edep,
+                                double dose, bool count) {
+  if (fScoringMode == ScoringMode::Sparse) {
+    // no lock: each thread writes in its own sparse image
+    fThreadLocalDataEdep.Get().value_worker_sparseimg.GetValue(
+        index[0], index[1], index[2]) += edep;
+    if (fDoseFlag) {
+      fThreadLocalDataDose.Get().value_worker_sparseimg.GetValue(
+          index[0], index[1], index[2]) += dose;
+    }
+    if (count) {
+      fThreadLocalDataCounts.Get().value_worker_sparseimg.GetValue(
+          index[0], index[1], index[2]) += 1;
+    }
+    return;
+  }
+
+  if (fScoringMode == ScoringMode::Queue) {
+    // no lock: the deposit is applied later, with the other ones of the batch
+    auto &data = fThreadLocalDataEdep.Get();
+    if (data.deposit_queue.Push(index[0], index[1], index[2],
+                                {edep, dose, count ? 1.0 : 0.0})) {
+      FlushDepositQueue(data);
     }
+    return;
+  }
 
-    if (fDoseFlag || fDoseSquaredFlag) {
-      double density;
-      if (fToWaterFlag) {
-        auto *water =
-            G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
-        density = water->GetDensity();
-      } else {
-        auto *current_material = step->GetPreStepPoint()->GetMaterial();
-        density = current_material->GetDensity();
-      }
-      dose = edep / density;
+  if (fScoringMode == ScoringMode::ThreadLocal && fFloatBufferFlag) {
+    // no lock: each thread writes in its own buffer
+    int index_flat = sub2ind(index);
+    fThreadLocalDataEdep.Get().value_worker_flatimg_float[index_flat] += edep;
+    if (fDoseFlag) {
+      fThreadLocalDataDose.Get().value_worker_flatimg_float[index_flat] += dose;
+    }
+    if (count) {
+      fThreadLocalDataCounts.Get().value_worker_flatimg_float[index_flat] += 1;
     }
+    return;
+  }
 
-    // all ImageAddValue calls in a mutexed {}-scope
-    {
-      G4AutoLock mutex(&SetPixelMutex);
-      ImageAddValue<Image3DType>(cpp_edep_image, index, edep);
-      if (fDoseFlag) {
-        ImageAddValue<Image3DType>(cpp_dose_image, index, dose);
-      }
-      if (fCountsFlag) {
-        ImageAddValue<Image3DType>(cpp_counts_image, index, 1);
-      }
-    } // mutex scope
+  if (fScoringMode == ScoringMode::ThreadLocal) {
+    // no lock: each thread writes in its own buffer
+    int index_flat = sub2ind(index);
+    fThreadLocalDataEdep.Get().value_worker_flatimg[index_flat] += edep;
+    if (fDoseFlag) {
+      fThreadLocalDataDose.Get().value_worker_flatimg[index_flat] += dose;
+    }
+    if (count) {
+      fThreadLocalDataCounts.Get().value_worker_flatimg[index_flat] += 1;
+    }
+    return;
+  }
 
-    // ScoreSquaredValue() is thread-safe because it contains a mutex
-    if (fEdepSquaredFlag || fDoseSquaredFlag) {
-      if (fEdepSquaredFlag) {
-        ScoreSquaredValue(fThreadLocalDataEdep.Get(), cpp_edep_squared_image,
-                          edep, event_id, index);
-      }
-      if (fDoseSquaredFlag) {
-        ScoreSquaredValue(fThreadLocalDataDose.Get(), cpp_dose_squared_image,
-                          dose, event_id, index);
-      }
+  // all images share the same geometry: the offset is computed once
+  auto offset = cpp_edep_image->ComputeOffset(index);
+
+  if (fScoringMode == ScoringMode::Atomic) {
+    // no lock: lock-free additions in the shared images
+    ImageAtomicAddValueAtOffset<Image3DType>(cpp_edep_image, offset, edep);
+    if (fDoseFlag) {
+      ImageAtomicAddValueAtOffset<Image3DType>(cpp_dose_image, offset, dose);
     }
-  } // if(isInside) clause
+    if (count) {
+      ImageAtomicAddValueAtOffset<Image3DType>(cpp_counts_image, offset, 1);
+    }
+    return;
+  }
+
+  // all ImageAddValue calls in a mutexed {}-scope
+  GateAutoLock mutex(&SetPixelMutex);
+  ImageAddValueAtOffset<Image3DType>(cpp_edep_image, offset, edep);
+  if (fDoseFlag) {
+    ImageAddValueAtOffset<Image3DType>(cpp_dose_image, offset, dose);
+  }
+  if (count) {
+    ImageAddValueAtOffset<Image3DType>(cpp_counts_image, offset, 1);
+  }
 }
 
 void GateDoseActor::EndOfEventAction(const G4Event *event) {
+  // the uncertainty goal reads the shared images during the run: the queued
+  // deposits are applied at each event (still sorted, with a single lock)
+  if (fScoringMode == ScoringMode::Queue && fUncertaintyGoal > 0) {
+    FlushDepositQueue(fThreadLocalDataEdep.Get());
+  }
+
+  // end of the sample (the event, or the last event of a batch): the squared
+  // values of the voxels touched by the sample are summed
+  if ((fEdepSquaredFlag || fDoseSquaredFlag) &&
+      fThreadLocalDataEdep.Get().number_of_events % fBatchSize == 0) {
+    if (fEdepSquaredFlag) {
+      EndOfSample(fThreadLocalDataEdep.Get(), cpp_edep_squared_image);
+    }
+    if (fDoseSquaredFlag) {
+      EndOfSample(fThreadLocalDataDose.Get(), cpp_dose_squared_image);
+    }
+  }
 
-  // flush thread local data into global image (postponed for now)
+  // nothing to do if the user set neither uncertainty goal nor snapshot
+  if (fUncertaintyGoal == 0 && !fEdepSnapshot.IsEnabled()) {
+    return;
+  }
+
+  // get thread idx. Ideally, only one thread should do the uncertainty
+  // calculation don't ask for thread idx if no MT
+  if (G4Threading::IsMultithreadedApplication() &&
+      G4Threading::G4GetThreadId() != 0) {
+    return;
+  }
 
-  // if the user didn't set uncertainty goal, do nothing
+  // intermediate images, the other threads keep on scoring
+  if (fEdepSnapshot.IsEnabled() &&
+      fEdepSnapshot.IsDue(GetNumberOfEvents())) {
+    TakeSnapshot();
+  }
   if (fUncertaintyGoal == 0) {
     return;
   }
 
-  // check if we reached the Nb of events for next evaluation
-  if (NbOfEvent >= NbEventsNextCheck) {
-    // get thread idx. Ideally, only one thread should do the uncertainty
-    // calculation don't ask for thread idx if no MT
-    if (!G4Threading::IsMultithreadedApplication() ||
-        G4Threading::G4GetThreadId() == 0) {
-      // check stop criteria
-      std::cout << "NbEventsNextCheck: " << NbEventsNextCheck << std::endl;
-      double UncCurrent = ComputeMeanUncertainty();
-      if (UncCurrent <= fUncertaintyGoal) {
-        // fStopRunFlag = true;
-        fSourceManager->SetRunTerminationFlag(true);
-      } else {
-        // estimate Nevents at which next check should occour
-        NbEventsNextCheck = (UncCurrent / fUncertaintyGoal) *
-                            (UncCurrent / fUncertaintyGoal) * NbOfEvent *
-                            Overshoot;
-      }
+  // an evaluation is running in the background: check if it is done
+  if (fUncertaintyFuture.valid()) {
+    if (fUncertaintyFuture.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return;
     }
+    auto result = fUncertaintyFuture.get();
+    fUncertaintyActiveVoxels = std::move(result.active_voxels);
+    double UncCurrent = result.mean_uncertainty;
+    GateProgressMonitor::SetUncertainty(UncCurrent);
+    std::cout << "unc: " << UncCurrent << std::endl;
+    if (UncCurrent <= fUncertaintyGoal) {
+      // fStopRunFlag = true;
+      fSourceManager->SetRunTerminationFlag(true);
+    } else {
+      // estimate Nevents at which next check should occour
+      // (from the number of events when the snapshot was taken)
+      NbEventsNextCheck = (UncCurrent / fUncertaintyGoal) *
+                          (UncCurrent / fUncertaintyGoal) *
+                          result.number_of_events * Overshoot;
+    }
+    return;
+  }
+
+  // check if we reached the Nb of events for next evaluation
+  if (GetNumberOfEvents() >= NbEventsNextCheck) {
+    std::cout << "NbEventsNextCheck: " << NbEventsNextCheck << std::endl;
+    StartUncertaintyEvaluation();
   }
 }
 
-double GateDoseActor::ComputeMeanUncertainty() {
-  G4AutoLock mutex(&ComputeUncertaintyMutex);
-  itk::ImageRegionIterator<Image3DType> edep_iterator3D(
-      cpp_edep_image, cpp_edep_image->GetLargestPossibleRegion());
-  double mean_unc = 0.0;
-  int n_voxel_unc = 0;
-  double n = 2.0;
-  n = NbOfEvent;
+void GateDoseActor::StartUncertaintyEvaluation() {
+  // The active voxels (above the threshold at the previous evaluation) are
+  // copied, so that the evaluation can be performed by a background thread
+  // while the workers keep on scoring. From time to time, or when no voxel is
+  // active yet, the full image is considered to update the active voxels.
+  double n = GetNumberOfEvents();
+  bool full_scan = fUncertaintyActiveVoxels.empty() ||
+                   fNbUncertaintyEvaluations % fUncertaintyFullScanPeriod == 0;
+  fNbUncertaintyEvaluations++;
+  std::vector<int> voxels;
+  std::vector<double> edep;
+  std::vector<double> edep_squared;
+  // the copies are taken under the lock of the workers, so that the values
+  // and squared values of a voxel are consistent (the atomic additions are
+  // not locked, but each value is read atomically)
+  GateAutoLock mutex(&SetPixelMutex);
+  if (full_scan) {
+    auto nb_voxels = size_edep[0] * size_edep[1] * size_edep[2];
+    edep.assign(cpp_edep_image->GetBufferPointer(),
+                cpp_edep_image->GetBufferPointer() + nb_voxels);
+    edep_squared.assign(cpp_edep_squared_image->GetBufferPointer(),
+                        cpp_edep_squared_image->GetBufferPointer() + nb_voxels);
+  } else {
+    voxels = fUncertaintyActiveVoxels;
+    auto *edep_buffer = cpp_edep_image->GetBufferPointer();
+    auto *edep_squared_buffer = cpp_edep_squared_image->GetBufferPointer();
+    edep.reserve(voxels.size());
+    edep_squared.reserve(voxels.size());
+    for (auto i : voxels) {
+      edep.push_back(edep_buffer[i]);
+      edep_squared.push_back(edep_squared_buffer[i]);
+    }
+  }
+  mutex.unlock();
+  auto evaluate = [this, n, voxels = std::move(voxels), edep = std::move(edep),
+                   edep_squared = std::move(edep_squared)]() {
+    return EvaluateUncertainty(voxels, edep, edep_squared, n);
+  };
+  fUncertaintyFuture = std::async(std::launch::async, std::move(evaluate));
+}
 
+GateDoseActor::UncertaintyResult GateDoseActor::EvaluateUncertainty(
+    const std::vector<int> &voxels, const std::vector<double> &edep,
+    const std::vector<double> &edep_squared, double n) const {
+  // voxels is empty when edep is the full image, otherwise edep[i] is the
+  // value of the voxel voxels[i]
+  UncertaintyResult result;
+  result.number_of_events = n;
   if (n < 2.0) {
     n = 2.0;
   }
-  double max_edep = GetMaxValueOfImage(cpp_edep_image);
-
-  for (edep_iterator3D.GoToBegin(); !edep_iterator3D.IsAtEnd();
-       ++edep_iterator3D) {
-    Image3DType::IndexType index_f = edep_iterator3D.GetIndex();
-    double val = cpp_edep_image->GetPixel(index_f);
-
+  double max_edep = 0.0;
+  for (auto v : edep) {
+    max_edep = std::max(max_edep, v);
+  }
+  double mean_unc = 0.0;
+  int n_voxel_unc = 0;
+  for (size_t i = 0; i < edep.size(); i++) {
+    double val = edep[i];
     if (val > max_edep * fThreshEdepPerc) {
+      result.active_voxels.push_back(voxels.empty() ? static_cast<int>(i)
+                                                    : voxels[i]);
       val /= n;
-      n_voxel_unc++;
-      double val_squared_mean = cpp_edep_squared_image->GetPixel(index_f) / n;
-
+      double val_squared_mean = edep_squared[i] / n;
       double unc_i = (1.0 / (n - 1.0)) * (val_squared_mean - pow(val, 2));
-      if (unc_i < 0) {
-        std::cout << "unc_i: " << unc_i << std::endl;
-        std::cout << "edep: " << val << std::endl;
-        std::cout << "edep_squared_mean: " << val_squared_mean << std::endl;
-      }
-
-      unc_i = sqrt(unc_i) / (val);
-
-      if (unc_i > 1) {
-        std::cout << "unc_i: " << unc_i << std::endl;
-        std::cout << "edep: " << val << std::endl;
-        std::cout << "edep_squared_mean: " << val_squared_mean << std::endl;
-      }
+      // negative value may only occur because of rounding errors
+      unc_i = sqrt(std::max(unc_i, 0.0)) / (val);
       mean_unc += unc_i;
+      n_voxel_unc++;
     }
-  };
-
+  }
   if (n_voxel_unc > 0 && mean_unc > 0) {
     mean_unc = mean_unc / n_voxel_unc;
   } else {
     mean_unc = 1.;
   }
-  std::cout << "unc: " << mean_unc << std::endl;
-  return mean_unc;
+  result.mean_uncertainty = mean_unc;
+  return result;
+}
+
+void GateDoseActor::WaitForUncertaintyEvaluation() {
+  if (fUncertaintyFuture.valid()) {
+    fUncertaintyFuture.wait();
+    fUncertaintyFuture = std::future<UncertaintyResult>();
+  }
+  fUncertaintyActiveVoxels.clear();
+  fNbUncertaintyEvaluations = 0;
+}
+
+double GateDoseActor::ComputeMeanUncertainty() {
+  // synchronous evaluation on the full image
+  GateAutoLock mutex(&ComputeUncertaintyMutex);
+  auto nb_voxels = size_edep[0] * size_edep[1] * size_edep[2];
+  GateAutoLock pixel_mutex(&SetPixelMutex);
+  std::vector<double> edep(cpp_edep_image->GetBufferPointer(),
+                           cpp_edep_image->GetBufferPointer() + nb_voxels);
+  std::vector<double> edep_squared(
+      cpp_edep_squared_image->GetBufferPointer(),
+      cpp_edep_squared_image->GetBufferPointer() + nb_voxels);
+  pixel_mutex.unlock();
+  auto result =
+      EvaluateUncertainty({}, edep, edep_squared, GetNumberOfEvents());
+  std::cout << "unc: " << result.mean_uncertainty << std::endl;
+  return result.mean_uncertainty;
 }
 
 int GateDoseActor::sub2ind(Image3DType::IndexType index3D) {
@@ -342,7 +765,69 @@ void GateDoseActor::ind2sub(int index_flat, Image3DType::IndexType &index3D) {
 }
 
 void GateDoseActor::EndOfRunAction(const G4Run *run) {
-  // FlushSquaredValue() is thread-safe because it contains a mutex
+  // (before the merge: the sparse tiles and squared buffers are released)
+  UpdateThreadLocalMemoryAccounting();
+
+  // number of samples used for the squared values (batch of events)
+  if (fBatchSize > 1) {
+    auto n = fThreadLocalDataEdep.Get().number_of_events;
+    GateAutoLock mutex(&SetNbEventMutex);
+    NbOfBatches += (n + fBatchSize - 1) / fBatchSize;
+  }
+
+  // the time frames still active in this thread are added to the file
+  if (fEdepTimeFrames.IsEnabled()) {
+    fEdepTimeFrames.Flush();
+  }
+
+  // merge the per-thread sparse images (including squared values) in the
+  // shared sparse images
+  if (fScoringMode == ScoringMode::Sparse) {
+    FlushSparseValue(fThreadLocalDataEdep.Get().value_worker_sparseimg,
+                     fEdepSparseImage);
+    if (fDoseFlag) {
+      FlushSparseValue(fThreadLocalDataDose.Get().value_worker_sparseimg,
+                       fDoseSparseImage);
+    }
+    if (fCountsFlag) {
+      FlushSparseValue(fThreadLocalDataCounts.Get().value_worker_sparseimg,
+                       fCountsSparseImage);
+    }
+    if (fEdepSquaredFlag) {
+      FlushSparseSquaredValue(fThreadLocalDataEdep.Get(),
+                              fEdepSquaredSparseImage);
+    }
+    if (fDoseSquaredFlag) {
+      FlushSparseSquaredValue(fThreadLocalDataDose.Get(),
+                              fDoseSquaredSparseImage);
+    }
+    return;
+  }
+
+  // the last batch of deposits of the thread
+  if (fScoringMode == ScoringMode::Queue) {
+    auto &data = fThreadLocalDataEdep.Get();
+    FlushDepositQueue(data);
+    data.deposit_queue.Clear();
+  }
+
+  // merge the per-thread buffers into the shared images
+  if (fScoringMode == ScoringMode::ThreadLocal) {
+    FlushThreadLocalValue(fThreadLocalDataEdep.Get(), cpp_edep_image,
+                          fEdepSnapshot);
+    if (fDoseFlag) {
+      FlushThreadLocalValue(fThreadLocalDataDose.Get(), cpp_dose_image,
+                            fDoseSnapshot);
+    }
+    if (fCountsFlag) {
+      // no snapshot of the counts: nothing is registered
+      GateImageSnapshot no_snapshot;
+      FlushThreadLocalValue(fThreadLocalDataCounts.Get(), cpp_counts_image,
+                            no_snapshot);
+    }
+  }
+  // FlushSquaredValue() is thread-safe because it locks the stripes of the
+  // image (or uses atomic additions)
   if (fEdepSquaredFlag) {
     GateDoseActor::FlushSquaredValue(fThreadLocalDataEdep.Get(),
                                      cpp_edep_squared_image);
@@ -353,63 +838,221 @@ void GateDoseActor::EndOfRunAction(const G4Run *run) {
   }
 }
 
-void GateDoseActor::ScoreSquaredValue(threadLocalT &data,
-                                      Image3DType::Pointer cpp_image,
-                                      double value, int event_id,
+void GateDoseActor::ScoreSquaredValue(threadLocalT &data, double value,
                                       Image3DType::IndexType index) {
-  int index_flat = sub2ind(index);
-  auto previous_id = data.lastid_worker_flatimg[index_flat];
-  data.lastid_worker_flatimg[index_flat] = event_id;
-  if (event_id == previous_id) {
-    // Same event: sum the deposited value associated with this event ID
-    // and square once a new event ID is found (case below)
-    data.squared_worker_flatimg[index_flat] += value;
+  // (a null value does not change the sample)
+  if (value == 0) {
+    return;
+  }
+  auto &current =
+      data.sample_worker_sparseimg.GetValue(index[0], index[1], index[2]);
+  if (current == 0) {
+    // first value of this voxel in the sample
+    data.sample_voxels.push_back(index);
+  }
+  current += value;
+}
+
+void GateDoseActor::EndOfSample(threadLocalT &data,
+                                Image3DType::Pointer cpp_image) {
+  if (data.sample_voxels.empty()) {
+    return;
+  }
+  if (!fSharedSquaredFlag) {
+    // no lock: summed per thread and merged at the end of the run
+    for (const auto &index : data.sample_voxels) {
+      auto &v =
+          data.sample_worker_sparseimg.GetValue(index[0], index[1], index[2]);
+      data.sum_squared_worker_sparseimg.GetValue(index[0], index[1],
+                                                 index[2]) += v * v;
+      v = 0;
+    }
+  } else if (fScoringMode == ScoringMode::Atomic) {
+    for (const auto &index : data.sample_voxels) {
+      auto &v =
+          data.sample_worker_sparseimg.GetValue(index[0], index[1], index[2]);
+      // (the flat index is the offset in the itk buffer, see sub2ind)
+      ImageAtomicAddValueAtOffset<Image3DType>(cpp_image, sub2ind(index),
+                                               v * v);
+      v = 0;
+    }
   } else {
-    // Different event : square deposited quantity from the last event ID
-    // and start accumulating deposited quantity for this new event ID
-    auto v = data.squared_worker_flatimg[index_flat];
-    {
-      G4AutoLock mutex(&SetPixelMutex);
-      ImageAddValue<Image3DType>(cpp_image, index, v * v);
+    // a single lock for all the voxels of the sample
+    GateAutoLock mutex(&SetPixelMutex);
+    for (const auto &index : data.sample_voxels) {
+      auto &v =
+          data.sample_worker_sparseimg.GetValue(index[0], index[1], index[2]);
+      ImageAddValueAtOffset<Image3DType>(cpp_image, sub2ind(index), v * v);
+      v = 0;
     }
-    // new temp value
-    data.squared_worker_flatimg[index_flat] = value;
   }
+  data.sample_voxels.clear();
 }
 
 void GateDoseActor::FlushSquaredValue(threadLocalT &data,
                                       Image3DType::Pointer cpp_image) {
-  G4AutoLock mutex(&SetPixelMutex);
-  itk::ImageRegionIterator<Image3DType> iterator3D(
-      cpp_image, cpp_image->GetLargestPossibleRegion());
-  for (iterator3D.GoToBegin(); !iterator3D.IsAtEnd(); ++iterator3D) {
-    Image3DType::IndexType index_f = iterator3D.GetIndex();
-    Image3DType::PixelType pixelValue3D =
-        data.squared_worker_flatimg[sub2ind(index_f)];
-    ImageAddValue<Image3DType>(cpp_image, index_f, pixelValue3D * pixelValue3D);
+  // the last sample of the thread (e.g. an incomplete batch)
+  EndOfSample(data, cpp_image);
+  if (!fSharedSquaredFlag) {
+    // only the touched tiles are added to the image
+    auto *buffer = cpp_image->GetBufferPointer();
+    fStripedMerge.Merge(G4Threading::G4GetThreadId(), [&](long z0, long z1) {
+      data.sum_squared_worker_sparseimg.AddToBuffer(buffer, z0, z1);
+    });
+  }
+  // release the tiles, they are allocated again at the next run
+  data.sum_squared_worker_sparseimg.Clear();
+  data.sample_worker_sparseimg.Clear();
+  std::vector<Image3DType::IndexType>().swap(data.sample_voxels);
+}
+
+void GateDoseActor::FlushThreadLocalValue(threadLocalT &data,
+                                          Image3DType::Pointer cpp_image,
+                                          GateImageSnapshot &snapshot) {
+  // the flat buffer has the same memory layout as the itk image (see sub2ind)
+  auto *buffer = cpp_image->GetBufferPointer();
+  long slice = size_edep[0] * size_edep[1];
+  if (fFloatBufferFlag) {
+    // the float values are summed in the double image
+    const auto &values = data.value_worker_flatimg_float;
+    long n = values.size();
+    fStripedMerge.Merge(G4Threading::G4GetThreadId(), [&](long z0, long z1) {
+      for (long i = z0 * slice; i < std::min(z1 * slice, n); i++) {
+        buffer[i] += values[i];
+      }
+    });
+    std::vector<float>().swap(data.value_worker_flatimg_float);
+    return;
+  }
+  const auto &values = data.value_worker_flatimg;
+  long n = values.size();
+  auto merge = [&]() {
+    fStripedMerge.Merge(G4Threading::G4GetThreadId(), [&](long z0, long z1) {
+      for (long i = z0 * slice; i < std::min(z1 * slice, n); i++) {
+        buffer[i] += values[i];
+      }
+    });
+  };
+  if (snapshot.IsEnabled()) {
+    // The merge is done with the lock of the snapshot, so that the buffer is
+    // counted either in the shared image or as a registered buffer.
+    snapshot.MergeBuffer(values.data(), merge);
+  } else {
+    merge();
+  }
+  // release the memory, the buffer is re-allocated at the next run
+  std::vector<double>().swap(data.value_worker_flatimg);
+}
+
+void GateDoseActor::WriteEdepPerRun(int run_id) {
+  if (!fEdepPerRunFlag)
+    return;
+  if (!fEdepPerRunFile.IsOpen()) {
+    // the geometry of the frames is the one of the first run
+    size_t size[3];
+    double spacing[3];
+    double origin[3];
+    for (int i = 0; i < 3; i++) {
+      size[i] = size_edep[i];
+      spacing[i] = cpp_edep_image->GetSpacing()[i];
+      origin[i] = cpp_edep_image->GetOrigin()[i];
+    }
+    fEdepPerRunFile.Open(GetOutputPath("edep_per_run"), size, spacing, origin);
+  }
+  fEdepPerRunFile.AddFrame(run_id, cpp_edep_image->GetBufferPointer());
+}
+
+void GateDoseActor::EndSimulationAction() {
+  fEdepPerRunFile.Close();
+  fEdepTimeFrames.Close();
+}
+
+void GateDoseActor::TakeSnapshot() {
+  if (!fEdepSnapshot.IsEnabled()) {
+    return;
+  }
+  auto n = GetNumberOfEvents();
+  fEdepSnapshot.Take(cpp_edep_image->GetBufferPointer(), n);
+  if (fDoseFlag) {
+    fDoseSnapshot.Take(cpp_dose_image->GetBufferPointer(), n);
   }
 }
 
-int GateDoseActor::EndOfRunActionMasterThread(int run_id) { return 0; }
+void GateDoseActor::FlushSparseValue(GateSparseImage<double> &worker,
+                                     GateSparseImage<double> &shared) {
+  // the tiles are moved (or added when already allocated in shared)
+  GateAutoLock mutex(&SetPixelMutex);
+  shared.Merge(worker);
+}
+
+void GateDoseActor::FlushSparseSquaredValue(threadLocalT &data,
+                                            GateSparseImage<double> &shared) {
+  // the last sample of the thread (per thread: no uncertainty goal in this
+  // mode, so no shared image is needed)
+  EndOfSample(data, nullptr);
+  FlushSparseValue(data.sum_squared_worker_sparseimg, shared);
+  data.sample_worker_sparseimg.Clear();
+  std::vector<Image3DType::IndexType>().swap(data.sample_voxels);
+}
+
+void GateDoseActor::FlushDepositQueue(threadLocalT &data) {
+  if (data.deposit_queue.IsEmpty()) {
+    return;
+  }
+  // (the flat index is the offset in the itk buffers, see sub2ind)
+  auto *edep_buffer = cpp_edep_image->GetBufferPointer();
+  auto *dose_buffer = fDoseFlag ? cpp_dose_image->GetBufferPointer() : nullptr;
+  auto *counts_buffer =
+      fCountsFlag ? cpp_counts_image->GetBufferPointer() : nullptr;
+  GateAutoLock mutex(&SetPixelMutex);
+  data.deposit_queue.Flush(
+      [&](long offset, const GateDepositQueue<3>::Values &values) {
+        edep_buffer[offset] += values[0];
+        if (dose_buffer != nullptr) {
+          dose_buffer[offset] += values[1];
+        }
+        if (counts_buffer != nullptr) {
+          counts_buffer[offset] += values[2];
+        }
+      });
+  fNbQueueFlushes++;
+}
+
+int GateDoseActor::EndOfRunActionMasterThread(int run_id) {
+  // an evaluation may still be running when the run ends (the workers are
+  // done at this point)
+  WaitForUncertaintyEvaluation();
+  // the dense images are created from the merged sparse images, for the
+  // output of the run
+  if (fScoringMode == ScoringMode::Sparse) {
+    AllocateImageFromSparseImage(cpp_edep_image.GetPointer(),
+                                 fEdepSparseImage);
+    if (fEdepSquaredFlag) {
+      AllocateImageFromSparseImage(cpp_edep_squared_image.GetPointer(),
+                                   fEdepSquaredSparseImage);
+    }
+    if (fDoseFlag) {
+      AllocateImageFromSparseImage(cpp_dose_image.GetPointer(),
+                                   fDoseSparseImage);
+    }
+    if (fDoseSquaredFlag) {
+      AllocateImageFromSparseImage(cpp_dose_squared_image.GetPointer(),
+                                   fDoseSquaredSparseImage);
+    }
+    if (fCountsFlag) {
+      AllocateImageFromSparseImage(cpp_counts_image.GetPointer(),
+                                   fCountsSparseImage);
+    }
+  }
+  return 0;
+}
 
 double GateDoseActor::GetMaxValueOfImage(Image3DType::Pointer imageP) {
-  itk::ImageRegionIterator<Image3DType> iterator3D(
-      imageP, imageP->GetLargestPossibleRegion());
+  auto nb_voxels = imageP->GetLargestPossibleRegion().GetNumberOfPixels();
+  auto *buffer = imageP->GetBufferPointer();
   Image3DType::PixelType max = 0;
-  Image3DType::IndexType index_max;
-  // keep track of the 10 highest values of the image
-  std::priority_queue<double, std::vector<double>, std::greater<double>> pq;
-  for (iterator3D.GoToBegin(); !iterator3D.IsAtEnd(); ++iterator3D) {
-    Image3DType::IndexType index_f = iterator3D.GetIndex();
-    Image3DType::PixelType val = imageP->GetPixel(index_f);
-    if (val > max) {
-      max = val;
-      index_max = index_f;
-      pq.push(max);
-      if (pq.size() > 10) {
-        pq.pop();
-      }
-    }
+  for (size_t i = 0; i < nb_voxels; i++) {
+    max = std::max(max, buffer[i]);
   }
   return max;
 }
@@ -10,9 +10,19 @@
 
 #include "G4Cache.hh"
 #include "G4VPrimitiveScorer.hh"
+#include "GateDepositQueue.h"
+#include "GateSparseImage.h"
+#include "GateStripedMerge.h"
+#include "GateStoppingPowerTable.h"
+#include "GateTimeFrameScorer.h"
+#include "GateHelpersImage.h"
+#include "GateImageSnapshot.h"
+#include "GateMappedImageFile.h"
 #include "GateVActor.h"
 #include "itkImage.h"
 #include <G4Threading.hh>
+#include <atomic>
+#include <future>
 #include <iostream>
 #include <pybind11/stl.h>
 
@@ -24,6 +34,9 @@ namespace py = pybind11;
 class GateDoseActor : public GateVActor {
 
 public:
+  // How the voxel deposits are accumulated in the shared images
+  enum ScoringMode { Mutex, ThreadLocal, Atomic, Sparse, Queue };
+
   // Constructor
   GateDoseActor(py::dict &user_info);
 
@@ -48,6 +61,8 @@ public:
   // Called every time a Run ends (all threads)
   void EndOfRunAction(const G4Run *run) override;
 
+  void EndSimulationAction() override;
+
   inline bool GetToWaterFlag() const { return fToWaterFlag; }
 
   inline void SetToWaterFlag(const bool b) { fToWaterFlag = b; }
@@ -92,6 +107,25 @@ public:
   double GetMaxValueOfImage(Image3DType::Pointer imageP);
   double ComputeMeanUncertainty();
 
+  // Result of an evaluation of the mean relative uncertainty, with the
+  // voxels above the edep threshold that were considered
+  struct UncertaintyResult {
+    double mean_uncertainty = 1.0;
+    double number_of_events = 0;
+    std::vector<int> active_voxels;
+  };
+
+  // Copy the edep values needed by the evaluation and launch it in the
+  // background, see EndOfEventAction
+  void StartUncertaintyEvaluation();
+
+  UncertaintyResult EvaluateUncertainty(const std::vector<int> &voxels,
+                                        const std::vector<double> &edep,
+                                        const std::vector<double> &edep_squared,
+                                        double n) const;
+
+  void WaitForUncertaintyEvaluation();
+
   // The image is accessible on py side (shared by all threads)
   Image3DType::Pointer cpp_edep_image;
   Image3DType::Pointer cpp_edep_squared_image;
@@ -102,24 +136,153 @@ public:
   Image3DType::SizeType size_edep{};
 
   struct threadLocalT {
-    G4EmCalculator emcalc;
-    std::vector<double> squared_worker_flatimg;
-    std::vector<int> lastid_worker_flatimg;
+    GateStoppingPowerTable dedx_table;
+    // value of the current sample (event or batch of events) in the voxels
+    // it touched, and the list of these voxels: the values are squared and
+    // reset at the end of the sample (memory of the touched tiles only)
+    GateSparseImage<double> sample_worker_sparseimg;
+    std::vector<Image3DType::IndexType> sample_voxels;
+    // per-thread sum of the squared values, merged at the end of the run
+    GateSparseImage<double> sum_squared_worker_sparseimg;
+    // number of events simulated by this thread (to define the batches)
+    int number_of_events = 0;
+    // per-thread copy of the scored image (ThreadLocal scoring mode only),
+    // in double or in float (see fFloatBufferFlag)
+    std::vector<double> value_worker_flatimg;
+    std::vector<float> value_worker_flatimg_float;
+    // sparse per-thread counterpart (Sparse scoring mode only)
+    GateSparseImage<double> value_worker_sparseimg;
+    // deferred (edep, dose, count) deposits, applied by batches sorted by
+    // tile (Queue scoring mode only, in the edep data)
+    GateDepositQueue<3> deposit_queue;
   };
 
-  void ScoreSquaredValue(threadLocalT &data, Image3DType::Pointer cpp_image,
-                         double value, int event_id,
+  // Add the deposit of the current step to the edep/dose/counts images,
+  // either in the shared images (mutex or atomic) or in the per-thread
+  // buffers (dense or sparse)
+  void ScoreValues(Image3DType::IndexType index, double edep, double dose,
+                   bool count);
+
+  void FlushThreadLocalValue(threadLocalT &data, Image3DType::Pointer cpp_image,
+                             GateImageSnapshot &snapshot);
+
+  // Copy the current edep (and dose) into the snapshots, while the workers
+  // keep on scoring. Called by the first thread at the snapshot intervals,
+  // or from the py side.
+  void TakeSnapshot();
+
+  // Edep and dose images of the last snapshot (same layout as the images)
+  GateImageSnapshot fEdepSnapshot;
+  GateImageSnapshot fDoseSnapshot;
+
+  // Sparse scoring mode: the sparse images of the threads are merged (with a
+  // lock) in the shared sparse images below, and the dense images are only
+  // allocated at the end of the run, for the output
+  void FlushSparseValue(GateSparseImage<double> &worker,
+                        GateSparseImage<double> &shared);
+
+  void FlushSparseSquaredValue(threadLocalT &data,
+                               GateSparseImage<double> &shared);
+
+  GateSparseImage<double> fEdepSparseImage;
+  GateSparseImage<double> fEdepSquaredSparseImage;
+  GateSparseImage<double> fDoseSparseImage;
+  GateSparseImage<double> fDoseSquaredSparseImage;
+  GateSparseImage<double> fCountsSparseImage;
+
+  // The per-thread buffers (flat, or sparse squared values) are added to the
+  // shared images by stripes of slices, concurrently by the workers (end of
+  // run)
+  GateStripedMerge fStripedMerge;
+
+  // Apply the queued deposits of the thread to the shared images, under a
+  // single lock for the whole batch (Queue scoring mode)
+  void FlushDepositQueue(threadLocalT &data);
+
+  unsigned long GetNumberOfQueueFlushes() const { return fNbQueueFlushes; }
+
+  // Add the edep of the run as frame run_id of the file (master thread, end
+  // of run, before the image is read on the py side)
+  void WriteEdepPerRun(int run_id);
+
+  // Option: the edep of each run is written in a memory-mapped 4D image
+  // (output "edep_per_run"), instead of being kept in memory
+  bool fEdepPerRunFlag{};
+  GateMappedImageFile fEdepPerRunFile;
+
+  // Option: the edep is also scored per time frame of the global time of
+  // the steps (output "edep_per_time_frame"), see GateTimeFrameScorer
+  GateTimeFrameScorer fEdepTimeFrames;
+
+  // Hook for the derived actors that also score the dose of each voxel in
+  // several frames (e.g. GateDoseRateActor), only called when
+  // fScoreFramesFlag is set
+  virtual void ScoreFrames(Image3DType::IndexType index, double dose) {}
+  bool fScoreFramesFlag{};
+
+  // Global time of the middle of the step (time frames)
+  static double GetStepTime(const G4Step *step) {
+    return 0.5 * (step->GetPreStepPoint()->GetGlobalTime() +
+                  step->GetPostStepPoint()->GetGlobalTime());
+  }
+
+  // Accumulate the value of the voxel for the current sample (event or batch
+  // of events), the voxel is added to the list of the sample the first time
+  void ScoreSquaredValue(threadLocalT &data, double value,
                          Image3DType::IndexType index);
 
+  // End of the sample: sum the squared values of the touched voxels (per
+  // thread, or in the shared image for the uncertainty goal) and reset them
+  void EndOfSample(threadLocalT &data, Image3DType::Pointer cpp_image);
+
   void FlushSquaredValue(threadLocalT &data, Image3DType::Pointer cpp_image);
 
-  void PrepareLocalDataForRun(threadLocalT &data, int numberOfVoxels);
+  void PrepareSquaredLocalDataForRun(threadLocalT &data);
+
+  void PrepareSparseLocalDataForRun(threadLocalT &data);
+
+  // Report the bytes of the shared images (master) or of the buffers of the
+  // thread (workers) to GateMemoryAccounting (if enabled)
+  void UpdateImagesMemoryAccounting() const;
+
+  void UpdateThreadLocalMemoryAccounting();
 
   void GetVoxelPosition(G4Step *step, G4ThreeVector &position, bool &isInside,
                         Image3DType::IndexType &index) const;
 
+  void ComputeVoxelIndex(G4Step *step, const G4ThreeVector &position,
+                         bool &isInside, Image3DType::IndexType &index) const;
+
+  // Energy deposited by the step (and dose), converted to water if needed
+  template <bool ToWater, bool Dose>
+  void ComputeDeposit(G4Step *step, double &edep, double &dose);
+
+  // Score the values (and squared values) of one voxel, and the edep in
+  // the time frame of the step time (if enabled)
+  void ScoreVoxel(Image3DType::IndexType index, double edep, double dose,
+                  bool count, double time);
+
+  // Stepping kernel specialized for the hit type and the enabled outputs,
+  // selected once in InitializeCpp (no string compare or flag test per step)
+  template <HitType H, bool ToWater, bool Dose>
+  void SteppingKernel(G4Step *step);
+
+  void SelectSteppingKernel();
+
+  typedef void (GateDoseActor::*SteppingKernelType)(G4Step *);
+  SteppingKernelType fSteppingKernel{};
+  G4ThreeVector (*fHitPosition)(const G4Step *){};
+
+  // world to voxel index transform of the scored images (same geometry)
+  GateImageIndexTransform fIndexTransform;
+
   // Option: indicate we must convert to dose to water
   bool fToWaterFlag{};
+  G4Material *fWaterMaterial{};
+
+  // Option: use tabulated stopping powers (ratios) instead of computing them
+  // at each step
+  bool fStoppingPowerTableFlag{};
 
   // Option: indicate if we must compute edep squared
   bool fEdepSquaredFlag{};
@@ -133,29 +296,65 @@ public:
 
   double fVoxelVolume{};
 
+  // Option: accumulate in shared images (mutex or atomic) or per-thread
+  // buffers (dense or sparse)
+  ScoringMode fScoringMode;
+
+  // Option: number of deposits per thread applied at once (Queue scoring
+  // mode), and number of batches applied by all threads
+  int fQueueSize = 4096;
+  std::atomic<unsigned long> fNbQueueFlushes{0};
+
+  // Option: the per-thread buffers of the ThreadLocal scoring mode are
+  // stored in float (half of the memory), the shared images stay in double
+  bool fFloatBufferFlag{};
+
   // Option: set target statistical uncertainty for each run
   double fUncertaintyGoal;
   double fThreshEdepPerc;
   double Overshoot;
 
-  int NbOfEvent = 0;
+  // Number of events of the current run, incremented by all threads without
+  // lock. Read it during the run with GetNumberOfEvents().
+  std::atomic<int> NbOfEvent{0};
+
+  int GetNumberOfEvents() const {
+    return NbOfEvent.load(std::memory_order_relaxed);
+  }
+
+  // Option: number of events per sample for the squared values (1 means
+  // history by history). The number of samples is then NbOfBatches.
+  int fBatchSize = 1;
+  int NbOfBatches = 0;
+
+  // The squared values are accumulated in the shared image during the run
+  // only when the uncertainty goal needs them, otherwise per thread
+  bool fSharedSquaredFlag{};
   // set from python side. It will be overwritten by an estimation of the Nb of
   // events needed to achieve the goal uncertainty.
   int NbEventsFirstCheck;
   int NbEventsNextCheck;
   int NbOfThreads = 0;
 
+  // background evaluation of the uncertainty and voxels kept from the last
+  // evaluation (the full image is considered every fUncertaintyFullScanPeriod)
+  std::future<UncertaintyResult> fUncertaintyFuture;
+  std::vector<int> fUncertaintyActiveVoxels;
+  int fNbUncertaintyEvaluations = 0;
+  int fUncertaintyFullScanPeriod = 10;
+
   double goalUncertainty;
   double threshEdepPerc{};
 
   std::string fPhysicalVolumeName;
 
   G4ThreeVector fTranslation;
-  std::string fHitType;
+  HitType fHitType = HitType::Random;
 
 protected:
   G4Cache<threadLocalT> fThreadLocalDataEdep;
   G4Cache<threadLocalT> fThreadLocalDataDose;
+  G4Cache<threadLocalT> fThreadLocalDataCounts;
 };
 
 #endif // GateDoseActor_h
@@ -0,0 +1,123 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDoseRateActor.h"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "GateHelpers.h"
+#include "GateHelpersDict.h"
+#include "GateMutex.h"
+
+GATE_MUTEX(DoseRateMergeMutex);
+
+GateDoseRateActor::GateDoseRateActor(py::dict &user_info)
+    : GateTLEDoseActor(user_info) {}
+
+void GateDoseRateActor::InitializeUserInfo(py::dict &user_info) {
+  GateTLEDoseActor::InitializeUserInfo(user_info);
+  fActivityTranslation =
+      DictGetG4ThreeVector(user_info, "activity_translation");
+}
+
+void GateDoseRateActor::InitializeCpp() {
+  GateTLEDoseActor::InitializeCpp();
+  // the frames need the dose of each step (edep / density)
+  if (!fDoseFlag) {
+    Fatal("Error in GateDoseRateActor: the dose must be scored "
+          "(SetDoseFlag).");
+  }
+  if (fActivityImage.IsNull())
+    fActivityImage = Image3DType::New();
+}
+
+void GateDoseRateActor::SetFrameWeights(const double *weights, int sx,
+                                        int sy, int sz, int nb_frames,
+                                        const std::vector<double> &spacing) {
+  if (fActivityImage.IsNull())
+    fActivityImage = Image3DType::New();
+  Image3DType::RegionType region;
+  Image3DType::SizeType size;
+  size[0] = sx;
+  size[1] = sy;
+  size[2] = sz;
+  region.SetSize(size);
+  fActivityImage->SetRegions(region);
+  Image3DType::SpacingType sp;
+  for (auto i = 0; i < 3; i++)
+    sp[i] = spacing[i];
+  fActivityImage->SetSpacing(sp);
+  fActivitySize = size;
+  fNbFrames = nb_frames;
+  fFrameWeights.assign(weights, weights + size_t(sx) * sy * sz * nb_frames);
+  fScoreFramesFlag = nb_frames > 0;
+}
+
+void GateDoseRateActor::StartSimulationAction() {
+  // the events are counted over all the runs (normalization)
+  fNbOfSimulatedEvents = 0;
+}
+
+void GateDoseRateActor::PrepareFramesForRun() {
+  // the dose image is allocated by the base class
+  auto n = size_edep[0] * size_edep[1] * size_edep[2];
+  fFrameDose.assign(n * fNbFrames, 0.0);
+  // Important ! The volume may have moved, so we re-attach each run
+  AttachImageToVolume<Image3DType>(fActivityImage, fPhysicalVolumeName,
+                                   fActivityTranslation);
+  fActivityIndexTransform.Update(fActivityImage.GetPointer());
+}
+
+void GateDoseRateActor::BeginOfRunAction(const G4Run *run) {
+  GateTLEDoseActor::BeginOfRunAction(run);
+  auto &l = fFrameLocalData.Get();
+  l.frames.resize(fNbFrames);
+  for (auto &f : l.frames)
+    f.Initialize(size_edep[0], size_edep[1], size_edep[2]);
+}
+
+void GateDoseRateActor::BeginOfEventAction(const G4Event *event) {
+  GateTLEDoseActor::BeginOfEventAction(event);
+  fNbOfSimulatedEvents.fetch_add(1, std::memory_order_relaxed);
+
+  // weights of the voxel of the activity image where the event starts
+  auto &l = fFrameLocalData.Get();
+  l.weights = nullptr;
+  auto *vertex = event->GetPrimaryVertex(0);
+  Image3DType::IndexType index;
+  if (vertex == nullptr ||
+      !fActivityIndexTransform.TransformPointToIndex(vertex->GetPosition(),
+                                                     index))
+    return;
+  auto voxel =
+      index[0] + fActivitySize[0] * (index[1] + fActivitySize[1] * index[2]);
+  l.weights = fFrameWeights.data() + voxel * fNbFrames;
+}
+
+void GateDoseRateActor::ScoreFrames(Image3DType::IndexType index,
+                                    double dose) {
+  auto &l = fFrameLocalData.Get();
+  if (l.weights == nullptr)
+    return;
+  for (int k = 0; k < fNbFrames; k++) {
+    if (l.weights[k] != 0)
+      l.frames[k].GetValue(index[0], index[1], index[2]) +=
+          dose * l.weights[k];
+  }
+}
+
+void GateDoseRateActor::EndOfRunAction(const G4Run *run) {
+  GateTLEDoseActor::EndOfRunAction(run);
+  // only the allocated tiles of the thread are added to the frames
+  auto &l = fFrameLocalData.Get();
+  auto n = size_edep[0] * size_edep[1] * size_edep[2];
+  {
+    GateAutoLock mutex(&DoseRateMergeMutex);
+    for (int k = 0; k < fNbFrames; k++)
+      l.frames[k].AddToBuffer(fFrameDose.data() + k * n);
+  }
+  l.frames.clear();
+}
@@ -0,0 +1,88 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDoseRateActor_h
+#define GateDoseRateActor_h
+
+#include "G4Cache.hh"
+#include "GateSparseImage.h"
+#include "GateTLEDoseActor.h"
+#include <atomic>
+
+/*
+    TLE dose actor that also scores the dose rate at the times of a sequence
+    of activity images A_k (k < nb_frames), in a single simulation.
+
+    The source emits from the time-integrated activity image I (sum of the
+    A_k times the trapezoid weights of their times). An event emitted in the
+    voxel v of the activity image contributes to the frame k with the weight
+    A_k(v) / I(v) (in 1/s): the frame k is then the dose rate at the time of
+    A_k, up to the number of decays per simulated event (applied on the py
+    side). The weights are set once with SetFrameWeights, the weights of the
+    source voxel are looked up at the start of each event.
+ */
+
+class GateDoseRateActor : public GateTLEDoseActor {
+
+public:
+  explicit GateDoseRateActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void BeginOfEventAction(const G4Event *event) override;
+
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Weights of the frames for each voxel of the activity image (voxel
+  // major: the nb_frames weights of a voxel are contiguous), and geometry
+  // of the activity image
+  void SetFrameWeights(const double *weights, int sx, int sy, int sz,
+                       int nb_frames, const std::vector<double> &spacing);
+
+  // Master thread, after the dose images are prepared for the run (called
+  // from the py side): allocate the frames and attach the activity image
+  void PrepareFramesForRun();
+
+  int GetNumberOfFrames() const { return fNbFrames; }
+
+  // Dose of the frames of the current run (frame major, same voxels as the
+  // dose image), in the units of cpp_dose_image
+  const std::vector<double> &GetFrameDose() const { return fFrameDose; }
+
+  // Number of events of the simulation (all the runs)
+  long GetNumberOfSimulatedEvents() const { return fNbOfSimulatedEvents; }
+
+protected:
+  void ScoreFrames(Image3DType::IndexType index, double dose) override;
+
+  // geometry of the activity image (no pixel buffer)
+  Image3DType::Pointer fActivityImage;
+  GateImageIndexTransform fActivityIndexTransform;
+  G4ThreeVector fActivityTranslation;
+  Image3DType::SizeType fActivitySize{};
+
+  int fNbFrames = 0;
+  std::vector<double> fFrameWeights;
+  std::vector<double> fFrameDose;
+  std::atomic<long> fNbOfSimulatedEvents{0};
+
+  struct frameLocalT {
+    // weights of the source voxel of the current event (null if the event
+    // is not emitted in the activity image)
+    const double *weights = nullptr;
+    std::vector<GateSparseImage<double>> frames;
+  };
+  G4Cache<frameLocalT> fFrameLocalData;
+};
+
+#endif // GateDoseRateActor_h
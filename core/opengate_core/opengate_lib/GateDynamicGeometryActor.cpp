@@ -0,0 +1,31 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDynamicGeometryActor.h"
+
+GateDynamicGeometryActor::GateDynamicGeometryActor(py::dict &user_info)
+    : GateVActor(user_info, false) {
+  fActions.insert("BeginOfRunActionMasterThread");
+  fPythonChangesFlag = false;
+}
+
+void GateDynamicGeometryActor::SetMotionTable(
+    std::shared_ptr<GateMotionTable> table) {
+  fMotionTable = table;
+}
+
+void GateDynamicGeometryActor::SetPythonChangesFlag(bool flag) {
+  fPythonChangesFlag = flag;
+}
+
+void GateDynamicGeometryActor::BeginOfRunActionMasterThread(int run_id) {
+  if (fMotionTable != nullptr)
+    fMotionTable->SetStep(run_id);
+  // (the GIL is only taken when needed)
+  if (fPythonChangesFlag)
+    ApplyPythonChanges(run_id);
+}
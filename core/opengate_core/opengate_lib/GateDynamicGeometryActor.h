@@ -0,0 +1,48 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDynamicGeometryActor_h
+#define GateDynamicGeometryActor_h
+
+#include "GateMotionTable.h"
+#include "GateVActor.h"
+
+namespace py = pybind11;
+
+/*
+ * Apply the changes of the dynamic geometry before each run (master
+ * thread). The translations and rotations of all the runs are given in bulk
+ * with a motion table (see GateMotionTable) and applied in C++; the other
+ * changes (e.g. the images) are applied by the Python side, with
+ * ApplyPythonChanges, only if there are some.
+ *
+ * With sub-runs, the motion table is used by the source manager during the
+ * run instead.
+ */
+
+class GateDynamicGeometryActor : public GateVActor {
+
+public:
+  explicit GateDynamicGeometryActor(py::dict &user_info);
+
+  // [py side] translations and rotations of the volumes (one step per run)
+  void SetMotionTable(std::shared_ptr<GateMotionTable> table);
+
+  // [py side] some changes must be applied by the Python side
+  void SetPythonChangesFlag(bool flag);
+
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  // Changes of the Python side (overloaded in Python)
+  virtual void ApplyPythonChanges(int run_id) {}
+
+protected:
+  std::shared_ptr<GateMotionTable> fMotionTable;
+  bool fPythonChangesFlag;
+};
+
+#endif // GateDynamicGeometryActor_h
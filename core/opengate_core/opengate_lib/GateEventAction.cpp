@@ -6,6 +6,8 @@
    -------------------------------------------------- */
 
 #include "GateEventAction.h"
+#include "GateActorProfiler.h"
+#include "GateTimeline.h"
 
 GateEventAction::GateEventAction() : G4UserEventAction() {}
 
@@ -19,13 +21,17 @@ void GateEventAction::RegisterActor(GateVActor *actor) {
 }
 
 void GateEventAction::BeginOfEventAction(const G4Event *event) {
+  GateTimeline::BeginOfEvent();
   for (auto actor : fBeginOfEventAction_actors) {
+    GateActorProfilerScope profile(actor,
+                                   GateActorProfiler::BeginOfEventAction);
     actor->BeginOfEventAction(event);
   }
 }
 
 void GateEventAction::EndOfEventAction(const G4Event *event) {
   for (auto actor : fEndOfEventAction_actors) {
+    GateActorProfilerScope profile(actor, GateActorProfiler::EndOfEventAction);
     actor->EndOfEventAction(event);
   }
 }
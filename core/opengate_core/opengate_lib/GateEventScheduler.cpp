@@ -0,0 +1,79 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateEventScheduler.h"
+#include "GatePhiloxEngine.h"
+#include "Randomize.hh"
+#include <algorithm>
+
+namespace {
+
+// the chunks are never smaller (one lock per chunk)
+const unsigned long kMinimumChunkSize = 10;
+
+// splitmix64 (one step): well mixed seeds from consecutive values
+std::uint64_t Mix(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+GateEventScheduler::GateEventScheduler(int number_of_threads,
+                                       std::int64_t seed) {
+  fNumberOfThreads = std::max(1, number_of_threads);
+  fSeed = seed;
+  fRunId = -1;
+  fTotal = 0;
+  fNext = 0;
+  fNumberOfChunks = 0;
+}
+
+bool GateEventScheduler::NextChunk(int run_id, unsigned long total,
+                                   unsigned long &first,
+                                   unsigned long &count) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  // the master starts a run once all the threads ended the previous one
+  if (run_id != fRunId) {
+    fRunId = run_id;
+    fTotal = total;
+    fNext = 0;
+  }
+  if (fNext >= fTotal)
+    return false;
+  // guided: a part of the remaining events for each thread
+  auto remaining = fTotal - fNext;
+  count = std::max(kMinimumChunkSize, remaining / (2 * fNumberOfThreads));
+  count = std::min(count, remaining);
+  first = fNext;
+  fNext += count;
+  fNumberOfChunks++;
+  return true;
+}
+
+void GateEventScheduler::SeedEvent(int run_id, unsigned long event) const {
+  // counter-based engine: the stream of the event, no hash needed
+  auto *philox = dynamic_cast<GatePhiloxEngine *>(G4Random::getTheEngine());
+  if (philox != nullptr) {
+    philox->SetStream(static_cast<std::uint64_t>(fSeed), run_id, event);
+    return;
+  }
+  auto h = Mix(static_cast<std::uint64_t>(fSeed));
+  h = Mix(h ^ static_cast<std::uint64_t>(run_id));
+  h = Mix(h ^ static_cast<std::uint64_t>(event));
+  // two positive 31 bits seeds, like the ones of G4MTRunManager
+  long seeds[3] = {static_cast<long>(h & 0x7fffffff) + 1,
+                   static_cast<long>((h >> 32) & 0x7fffffff) + 1, 0};
+  G4Random::setTheSeeds(seeds, -1);
+}
+
+unsigned long GateEventScheduler::GetNumberOfChunks() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fNumberOfChunks;
+}
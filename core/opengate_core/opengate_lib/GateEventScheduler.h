@@ -0,0 +1,59 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateEventScheduler_h
+#define GateEventScheduler_h
+
+#include <cstdint>
+#include <mutex>
+
+/*
+    Guided scheduling of the events of a run between the threads (see
+    GateSourceManager, option event_scheduling).
+
+    The events of the sources defined by a number of events (n per thread)
+    are numbered from 0 to n x threads, for all the threads. Each thread
+    takes the next chunk of events when it has simulated its own chunk. The
+    chunks become smaller near the end of the run (a fraction of the
+    remaining events), so the threads end their run at the same time even
+    when the events are very heterogeneous.
+
+    The random engine of the thread is seeded for each event from the seed
+    of the simulation, the run and the number of the event: the events do
+    not depend on the thread that simulates them. With the GatePhiloxEngine,
+    the stream of the engine is directly (seed, run, event).
+ */
+
+class GateEventScheduler {
+public:
+  GateEventScheduler(int number_of_threads, std::int64_t seed);
+
+  // Take the next chunk [first, first + count) of the events of the run
+  // (thread safe). The total number of events is the one given by the first
+  // thread of the run. Return false if there is no event left.
+  bool NextChunk(int run_id, unsigned long total, unsigned long &first,
+                 unsigned long &count);
+
+  // Seed the random engine of the calling thread for this event
+  void SeedEvent(int run_id, unsigned long event) const;
+
+  int GetNumberOfThreads() const { return fNumberOfThreads; }
+
+  unsigned long GetNumberOfChunks();
+
+protected:
+  int fNumberOfThreads;
+  std::int64_t fSeed;
+
+  std::mutex fMutex;
+  int fRunId;
+  unsigned long fTotal;
+  unsigned long fNext;
+  unsigned long fNumberOfChunks;
+};
+
+#endif // GateEventScheduler_h
@@ -0,0 +1,54 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateFilterProgram.h"
+#include "G4AutoLock.hh"
+#include "GateKineticEnergyFilter.h"
+#include "GateMutex.h"
+#include "GateParticleFilter.h"
+#include <algorithm>
+
+GATE_MUTEX(CompileFiltersMutex);
+
+void GateFilterProgram::Compile(const std::vector<GateVFilter *> &filters,
+                                bool operatorIsAnd) {
+  // (the filters may be shared by several actors, compiled by all threads)
+  GateAutoLock mutex(&CompileFiltersMutex);
+  if (fCompiled)
+    return;
+  fInstructions.clear();
+  fOperatorIsAnd = operatorIsAnd;
+  for (auto *f : filters) {
+    if (!f->fCompiled) {
+      f->Compile();
+      f->fCompiled = true;
+    }
+    Instruction i{OpCode::Filter, f->GetCost(), nullptr, true, 0, 0, f};
+    if (const auto *pf = dynamic_cast<const GateParticleFilter *>(f)) {
+      if (pf->fParticleDefinition != nullptr) {
+        i.fOp = OpCode::Particle;
+        i.fCost = 0;
+        i.fParticle = pf->fParticleDefinition;
+        i.fAccept = pf->fAcceptParticle;
+      }
+    } else if (const auto *ef =
+                   dynamic_cast<const GateKineticEnergyFilter *>(f)) {
+      i.fOp = OpCode::KineticEnergy;
+      i.fCost = 0;
+      i.fMin = ef->fEnergyMin;
+      i.fMax = ef->fEnergyMax;
+    } else if (i.fCost >= 2) {
+      i.fOp = OpCode::FilterOncePerStep;
+    }
+    fInstructions.push_back(i);
+  }
+  std::stable_sort(fInstructions.begin(), fInstructions.end(),
+                   [](const Instruction &a, const Instruction &b) {
+                     return a.fCost < b.fCost;
+                   });
+  fCompiled = true;
+}
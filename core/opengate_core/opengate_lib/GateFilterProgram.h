@@ -0,0 +1,72 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateFilterProgram_h
+#define GateFilterProgram_h
+
+#include "G4ParticleDefinition.hh"
+#include "GateVFilter.h"
+
+/*
+ * The step filters of an actor, compiled once into a flat list of
+ * instructions evaluated with short-circuit ("and" or "or"). The particle and
+ * kinetic energy tests are evaluated inline (cached particle definition), the
+ * other filters with their Accept, and the costly ones only once per step
+ * even when they are used by several actors. The instructions are ordered by
+ * cost (see GateVFilter::GetCost), the order of the user is kept otherwise.
+ */
+class GateFilterProgram {
+public:
+  void Compile(const std::vector<GateVFilter *> &filters, bool operatorIsAnd);
+
+  bool IsCompiled() const { return fCompiled; }
+
+  bool Accept(G4Step *step) const {
+    for (const auto &i : fInstructions) {
+      // the first false for "and", the first true for "or"
+      if (Evaluate(i, step) != fOperatorIsAnd)
+        return !fOperatorIsAnd;
+    }
+    return fOperatorIsAnd || fInstructions.empty();
+  }
+
+protected:
+  enum class OpCode { Particle, KineticEnergy, Filter, FilterOncePerStep };
+
+  struct Instruction {
+    OpCode fOp;
+    int fCost;
+    const G4ParticleDefinition *fParticle;
+    bool fAccept;
+    double fMin;
+    double fMax;
+    const GateVFilter *fFilter;
+  };
+
+  static bool Evaluate(const Instruction &i, G4Step *step) {
+    switch (i.fOp) {
+    case OpCode::Particle:
+      return (step->GetTrack()->GetParticleDefinition() == i.fParticle) ==
+             i.fAccept;
+    case OpCode::KineticEnergy: {
+      const auto e = step->GetPreStepPoint()->GetKineticEnergy();
+      return e >= i.fMin && e <= i.fMax;
+    }
+    case OpCode::Filter:
+      return i.fFilter->Accept(step);
+    case OpCode::FilterOncePerStep:
+      return i.fFilter->AcceptOncePerStep(step);
+    }
+    return true;
+  }
+
+  std::vector<Instruction> fInstructions;
+  bool fOperatorIsAnd = true;
+  bool fCompiled = false;
+};
+
+#endif // GateFilterProgram_h
@@ -0,0 +1,129 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateFlatGeometryActor.h"
+#include "G4Box.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Run.hh"
+#include "GateHelpersDict.h"
+
+GateFlatGeometryActor::GateFlatGeometryActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("BeginOfRunAction");
+  fEnergyMin = 0;
+  fEnergyMax = 0;
+  fNumberOfEnergyBins = 0;
+  fIsBuilt = false;
+}
+
+void GateFlatGeometryActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fDatabase = DictGetStr(user_info, "database");
+  fEnergyMin = DictGetDouble(user_info, "energy_min");
+  fEnergyMax = DictGetDouble(user_info, "energy_max");
+  fNumberOfEnergyBins = DictGetInt(user_info, "energy_bins");
+  fDetectorVolumeNames = DictGetVecStr(user_info, "detector");
+  // (checked again by SetEnergyBins)
+  fAttenuation.SetEnergyBins(fEnergyMin, fEnergyMax, fNumberOfEnergyBins);
+}
+
+void GateFlatGeometryActor::SetPhantomVolumeName(std::string name) {
+  fPhantomVolumeName = name;
+}
+
+void GateFlatGeometryActor::SetImageParameterisation(
+    GateImageNestedParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateFlatGeometryActor::SetImageParameterisation(
+    GateImageRegularParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->GetLabelMaterials();
+}
+
+void GateFlatGeometryActor::SetImageParameterisation(
+    GateImageRunParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateFlatGeometryActor::BeginOfRunAction(const G4Run * /*run*/) {
+  // once, by the master thread (the couples exist once the run starts)
+  if (fIsBuilt || !G4Threading::IsMasterThread())
+    return;
+  Build();
+  fIsBuilt = true;
+}
+
+void GateFlatGeometryActor::Build() {
+  // mu of the labels on the energy bins, and geometry of the labels in the
+  // world
+  fAttenuation.Initialize(
+      fLabelImage, *fLabelMaterials, fPhantomVolumeName,
+      GateMaterialMuHandler::GetInstance(fDatabase, fEnergyMax));
+  const auto *geometry = fAttenuation.GetGeometry();
+  const auto size = geometry->GetLargestPossibleRegion().GetSize();
+  const auto &spacing = geometry->GetSpacing();
+  const auto &origin = geometry->GetOrigin();
+  const auto &direction = geometry->GetDirection();
+  fSize.resize(3);
+  fSpacing.resize(3);
+  fOrigin.resize(3);
+  fDirection.resize(9);
+  for (auto i = 0; i < 3; i++) {
+    fSize[i] = size[i];
+    fSpacing[i] = spacing[i];
+    fOrigin[i] = origin[i];
+    for (auto j = 0; j < 3; j++)
+      fDirection[i * 3 + j] = direction[i][j];
+  }
+  const auto *labels = fLabelImage->GetBufferPointer();
+  fLabels.assign(labels, labels + size[0] * size[1] * size[2]);
+
+  fMaterialNames.clear();
+  for (const auto *m : *fLabelMaterials)
+    fMaterialNames.push_back(m->GetName());
+  fEnergies = fAttenuation.GetBinEnergies();
+  fMu = fAttenuation.GetMuOverBins();
+
+  if (!fDetectorVolumeNames.empty())
+    BuildDetector();
+}
+
+void GateFlatGeometryActor::BuildDetector() {
+  fDetectorIndex.Initialize(fDetectorVolumeNames);
+  const auto *lv = G4LogicalVolumeStore::GetInstance()->GetVolume(
+      fDetectorVolumeNames.back(), false);
+  const auto *box = dynamic_cast<const G4Box *>(lv->GetSolid());
+  if (box == nullptr) {
+    std::ostringstream oss;
+    oss << "The crystal volume " << fDetectorVolumeNames.back()
+        << " of the FlatGeometryActor '" << GetName() << "' is not a box.";
+    Fatal(oss.str());
+  }
+  fCrystalHalfSize = {box->GetXHalfLength(), box->GetYHalfLength(),
+                      box->GetZHalfLength()};
+
+  // center and rotation (columns: world axes of the crystal) of each crystal
+  const auto n = fDetectorIndex.GetNumberOfCrystals();
+  fCrystalCenters.resize(n * 3);
+  fCrystalRotations.resize(n * 9);
+  const G4ThreeVector axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  for (size_t i = 0; i < n; i++) {
+    const auto t = fDetectorIndex.GetLocalToWorldTransform(i);
+    const auto c = t.TransformPoint(G4ThreeVector());
+    for (auto k = 0; k < 3; k++)
+      fCrystalCenters[i * 3 + k] = c[k];
+    for (auto col = 0; col < 3; col++) {
+      const auto a = t.TransformAxis(axes[col]);
+      for (auto row = 0; row < 3; row++)
+        fCrystalRotations[i * 9 + row * 3 + col] = a[row];
+    }
+  }
+}
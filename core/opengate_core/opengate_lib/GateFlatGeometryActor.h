@@ -0,0 +1,94 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateFlatGeometryActor_h
+#define GateFlatGeometryActor_h
+
+#include "GateAttenuationRayMarcher.h"
+#include "GateRepeatedDetectorIndex.h"
+#include "GateVActor.h"
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Flat, self-contained copy of the geometry of a photon imaging simulation,
+ * for an external photon transport kernel (CPU SIMD or GPU): the labels of
+ * a voxelized phantom, the mu of each label on log-spaced energy bins, and
+ * the boxes of a detector made of nested repeated volumes (see
+ * GateRepeatedDetectorIndex), one per crystal.
+ *
+ * Everything is plain arrays in the world frame, in Geant4 units (mm, MeV):
+ *  - phantom: size, spacing, origin (center of the first voxel) and
+ *    direction of the label image, labels (x fastest)
+ *  - materials: name of each label, bin energies, mu[label * nb + bin]
+ *  - crystals: half size of the crystal box, center and rotation (local to
+ *    world, row major) of each crystal, by dense crystal index
+ *
+ * The arrays are built at the beginning of the first run (master thread),
+ * once the material cuts couples exist. The photons leaving the kernel
+ * (e.g. reaching the detector) are handed back to Geant4 with a
+ * ParticleBankSource.
+ */
+
+class GateFlatGeometryActor : public GateVActor {
+
+public:
+  explicit GateFlatGeometryActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void SetPhantomVolumeName(std::string name);
+
+  void SetImageParameterisation(GateImageNestedParameterisation *param);
+
+  void SetImageParameterisation(GateImageRegularParameterisation *param);
+
+  void SetImageParameterisation(GateImageRunParameterisation *param);
+
+  bool IsBuilt() const { return fIsBuilt; }
+
+  // phantom
+  std::vector<size_t> fSize;
+  std::vector<double> fSpacing;
+  std::vector<double> fOrigin;
+  std::vector<double> fDirection;
+  std::vector<unsigned short> fLabels;
+
+  // materials
+  std::vector<std::string> fMaterialNames;
+  std::vector<double> fEnergies;
+  std::vector<double> fMu;
+
+  // crystals of the detector
+  std::vector<double> fCrystalHalfSize;
+  std::vector<double> fCrystalCenters;
+  std::vector<double> fCrystalRotations;
+
+protected:
+  void Build();
+
+  void BuildDetector();
+
+  std::string fPhantomVolumeName;
+  std::string fDatabase;
+  double fEnergyMin;
+  double fEnergyMax;
+  size_t fNumberOfEnergyBins;
+  std::vector<std::string> fDetectorVolumeNames;
+  bool fIsBuilt;
+
+  const GateAttenuationRayMarcher::LabelImageType *fLabelImage = nullptr;
+  const std::vector<G4Material *> *fLabelMaterials = nullptr;
+  GateAttenuationRayMarcher fAttenuation;
+  GateRepeatedDetectorIndex fDetectorIndex;
+};
+
+#endif // GateFlatGeometryActor_h
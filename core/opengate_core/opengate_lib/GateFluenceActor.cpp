@@ -12,14 +12,17 @@
 #include "GateFluenceActor.h"
 #include "GateHelpersDict.h"
 #include "GateHelpersImage.h"
+#include "GateMutex.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
 #include <itkAddImageFilter.h>
 #include <itkImageRegionIterator.h>
 
 // Mutex that will be used by thread to write the output image
-G4Mutex SetPixelFluenceMutex = G4MUTEX_INITIALIZER;
-G4Mutex SetNbEventMutexFluence = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetPixelFluenceMutex);
 
 GateFluenceActor::GateFluenceActor(py::dict &user_info)
     : GateVActor(user_info, true) {
@@ -27,12 +30,124 @@ GateFluenceActor::GateFluenceActor(py::dict &user_info)
   // Action for this actor: during stepping
   fActions.insert("SteppingAction");
   fActions.insert("BeginOfRunAction");
+  fActions.insert("EndOfRunAction");
+  fActions.insert("EndOfEventAction");
 }
 
 void GateFluenceActor::InitializeUserInfo(py::dict &user_info) {
   // IMPORTANT: call the base class method
   GateVActor::InitializeUserInfo(user_info);
   fTranslation = DictGetG4ThreeVector(user_info, "translation");
+  // With 'segment', the track length in each voxel is scored, otherwise the
+  // particles entering the image
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+
+  // Scoring mode: shared image (mutex or atomic), per-thread sparse image or
+  // per-thread queue of deposits
+  auto mode = DictGetStr(user_info, "scoring_mode");
+  if (mode == "mutex")
+    fScoringMode = ScoringMode::Mutex;
+  else if (mode == "atomic")
+    fScoringMode = ScoringMode::Atomic;
+  else if (mode == "sparse")
+    fScoringMode = ScoringMode::Sparse;
+  else if (mode == "queue")
+    fScoringMode = ScoringMode::Queue;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateFluenceActor: unknown scoring_mode. Must be "
+           "'mutex', 'atomic', 'sparse' or 'queue'"
+        << " while '" << mode << "' is read.";
+    Fatal(oss.str());
+  }
+
+  // Number of deposits per batch (Queue scoring mode)
+  fQueueSize = DictGetInt(user_info, "queue_size");
+  if (fQueueSize < 1) {
+    std::ostringstream oss;
+    oss << "Error in GateFluenceActor: queue_size must be at least 1"
+        << " while " << fQueueSize << " is read.";
+    Fatal(oss.str());
+  }
+
+  // Energy bins of the spectral fluence
+  fEnergyBinEdges.clear();
+  if (!user_info["energy_bins"].is_none()) {
+    fEnergyBinEdges = DictGetVecDouble(user_info, "energy_bins");
+  }
+  fSpectralFlag = !fEnergyBinEdges.empty();
+  fLogUniformBins = false;
+  if (fSpectralFlag) {
+    if (fEnergyBinEdges.size() < 2 ||
+        !std::is_sorted(fEnergyBinEdges.begin(), fEnergyBinEdges.end(),
+                        std::less_equal<>())) {
+      Fatal("Error in GateFluenceActor: energy_bins must contain at least "
+            "two strictly increasing bin edges.");
+    }
+    // detect log-uniform edges (the usual case for spectra)
+    auto n = fEnergyBinEdges.size() - 1;
+    if (fEnergyBinEdges[0] > 0) {
+      auto e0 = std::log(fEnergyBinEdges[0]);
+      auto width = (std::log(fEnergyBinEdges[n]) - e0) / n;
+      fLogUniformBins = true;
+      for (size_t i = 1; i < n; i++) {
+        auto expected = std::exp(e0 + i * width);
+        if (std::abs(fEnergyBinEdges[i] - expected) > 1e-9 * expected)
+          fLogUniformBins = false;
+      }
+      fLogEnergyMin = e0;
+      fInvLogBinWidth = 1.0 / width;
+    }
+  }
+
+  // Intermediate image taken during the run (0: no snapshot)
+  fFluenceSnapshot.SetIntervals(
+      DictGetInt(user_info, "snapshot_event_interval"),
+      DictGetDouble(user_info, "snapshot_time_interval"));
+
+  // One frame per time interval in a memory-mapped file (0 frame: none)
+  fFluenceTimeFrames.Configure(DictGetDouble(user_info, "time_frame_start"),
+                               DictGetDouble(user_info, "time_frame_duration"),
+                               DictGetInt(user_info, "number_of_time_frames"),
+                               DictGetInt(user_info, "time_frame_buffer"));
+}
+
+size_t GateFluenceActor::GetNumberOfEnergyBins() const {
+  return fSpectralFlag ? fEnergyBinEdges.size() - 1 : 0;
+}
+
+int GateFluenceActor::GetEnergyBin(double energy) const {
+  auto n = static_cast<int>(fEnergyBinEdges.size()) - 1;
+  if (energy < fEnergyBinEdges[0] || energy >= fEnergyBinEdges[n])
+    return -1;
+  if (fLogUniformBins) {
+    auto bin = static_cast<int>((std::log(energy) - fLogEnergyMin) *
+                                fInvLogBinWidth);
+    // rounding close to an edge
+    bin = std::min(std::max(bin, 0), n - 1);
+    if (energy < fEnergyBinEdges[bin])
+      bin--;
+    else if (energy >= fEnergyBinEdges[bin + 1])
+      bin++;
+    return bin;
+  }
+  auto it = std::upper_bound(fEnergyBinEdges.begin(), fEnergyBinEdges.end(),
+                             energy);
+  return static_cast<int>(it - fEnergyBinEdges.begin()) - 1;
+}
+
+void GateFluenceActor::ScoreSpectralFluence(itk::OffsetValueType offset,
+                                            double energy, double value) {
+  auto bin = GetEnergyBin(energy);
+  if (bin < 0)
+    return;
+  auto nb_bins = fEnergyBinEdges.size() - 1;
+  AtomicAddValue(&fSpectralFluence[offset * nb_bins + bin], value);
+}
+
+void GateFluenceActor::ClearSpectralFluence() {
+  fSpectralFluence.clear();
+  fSpectralFluence.shrink_to_fit();
 }
 
 void GateFluenceActor::InitializeCpp() {
@@ -41,52 +156,251 @@ void GateFluenceActor::InitializeCpp() {
   // Create the image pointer
   // (the size and allocation will be performed on the py side)
   cpp_fluence_image = Image3DType::New();
+
+  // The scoring mode is resolved once, not at every step
+  if (fHitType == HitType::Segment) {
+    if (fScoringMode == ScoringMode::Mutex)
+      fSteppingKernel =
+          &GateFluenceActor::TrackLengthKernel<ScoringMode::Mutex>;
+    if (fScoringMode == ScoringMode::Atomic)
+      fSteppingKernel =
+          &GateFluenceActor::TrackLengthKernel<ScoringMode::Atomic>;
+    if (fScoringMode == ScoringMode::Sparse)
+      fSteppingKernel =
+          &GateFluenceActor::TrackLengthKernel<ScoringMode::Sparse>;
+    if (fScoringMode == ScoringMode::Queue)
+      fSteppingKernel =
+          &GateFluenceActor::TrackLengthKernel<ScoringMode::Queue>;
+    return;
+  }
+  switch (fScoringMode) {
+  case ScoringMode::Mutex:
+    fSteppingKernel = &GateFluenceActor::SteppingKernel<ScoringMode::Mutex>;
+    break;
+  case ScoringMode::Atomic:
+    fSteppingKernel = &GateFluenceActor::SteppingKernel<ScoringMode::Atomic>;
+    break;
+  case ScoringMode::Sparse:
+    fSteppingKernel = &GateFluenceActor::SteppingKernel<ScoringMode::Sparse>;
+    break;
+  case ScoringMode::Queue:
+    fSteppingKernel = &GateFluenceActor::SteppingKernel<ScoringMode::Queue>;
+    break;
+  }
 }
 
 void GateFluenceActor::BeginOfEventAction(const G4Event *event) {
-  G4AutoLock mutex(&SetNbEventMutexFluence);
-  NbOfEvent++;
+  NbOfEvent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GateFluenceActor::EndOfEventAction(const G4Event *event) {
+  if (!fFluenceSnapshot.IsEnabled()) {
+    return;
+  }
+  // only one thread takes the snapshots, the other ones keep on scoring
+  if (G4Threading::IsMultithreadedApplication() &&
+      G4Threading::G4GetThreadId() != 0) {
+    return;
+  }
+  if (fFluenceSnapshot.IsDue(GetNumberOfEvents())) {
+    TakeSnapshot();
+  }
+}
+
+void GateFluenceActor::TakeSnapshot() {
+  if (!fFluenceSnapshot.IsEnabled()) {
+    return;
+  }
+  // the fluence is only scored in the shared image (sparse mode excluded)
+  fFluenceSnapshot.Take(cpp_fluence_image->GetBufferPointer(),
+                        GetNumberOfEvents());
 }
 
 void GateFluenceActor::BeginOfRunActionMasterThread(int run_id) {
   // Important ! The volume may have moved, so we (re-)attach each run
   AttachImageToVolume<Image3DType>(cpp_fluence_image, fPhysicalVolumeName,
                                    fTranslation);
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(cpp_fluence_image.GetPointer());
   NbOfEvent = 0;
+
+  // the dense image is not allocated during the run (see the py side)
+  if (fScoringMode == ScoringMode::Sparse) {
+    auto size = cpp_fluence_image->GetLargestPossibleRegion().GetSize();
+    fFluenceSparseImage.Initialize(size[0], size[1], size[2]);
+  }
+
+  // the spectral fluence of the run, copied to the py side at the end of run
+  if (fSpectralFlag) {
+    auto region = cpp_fluence_image->GetLargestPossibleRegion();
+    fSpectralFluence.assign(region.GetNumberOfPixels() *
+                                GetNumberOfEnergyBins(),
+                            0.0);
+  }
+
+  if (fFluenceSnapshot.IsEnabled()) {
+    auto region = cpp_fluence_image->GetLargestPossibleRegion();
+    fFluenceSnapshot.Reset(region.GetNumberOfPixels());
+  }
+
+  // the time frames are defined for the whole simulation, with the geometry
+  // of the first run
+  if (fFluenceTimeFrames.IsEnabled() && !fFluenceTimeFrames.IsOpen()) {
+    auto region = cpp_fluence_image->GetLargestPossibleRegion();
+    size_t size[3];
+    double spacing[3];
+    double origin[3];
+    for (int i = 0; i < 3; i++) {
+      size[i] = region.GetSize()[i];
+      spacing[i] = cpp_fluence_image->GetSpacing()[i];
+      origin[i] = cpp_fluence_image->GetOrigin()[i];
+    }
+    fFluenceTimeFrames.Open(GetOutputPath("fluence_per_time_frame"), size,
+                            spacing, origin);
+  }
+}
+
+void GateFluenceActor::BeginOfRunAction(const G4Run *run) {
+  auto size = cpp_fluence_image->GetLargestPossibleRegion().GetSize();
+  if (fScoringMode == ScoringMode::Sparse) {
+    fThreadLocalData.Get().fluence_worker_sparseimg.Initialize(
+        size[0], size[1], size[2]);
+  }
+  if (fScoringMode == ScoringMode::Queue) {
+    fThreadLocalData.Get().deposit_queue.Initialize(size[0], size[1], size[2],
+                                                    fQueueSize);
+  }
+}
+
+void GateFluenceActor::EndOfRunAction(const G4Run *run) {
+  // the time frames still active in this thread are added to the file
+  if (fFluenceTimeFrames.IsEnabled())
+    fFluenceTimeFrames.Flush();
+  if (fScoringMode == ScoringMode::Queue) {
+    // the last batch of deposits of the thread
+    FlushDepositQueue();
+    fThreadLocalData.Get().deposit_queue.Clear();
+  }
+  if (fScoringMode != ScoringMode::Sparse)
+    return;
+  // move the allocated tiles of this thread to the shared sparse image
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock FluenceMutex(&SetPixelFluenceMutex);
+  fFluenceSparseImage.Merge(l.fluence_worker_sparseimg);
+}
+
+int GateFluenceActor::EndOfRunActionMasterThread(int run_id) {
+  // the workers are done: the dense image of the run is created from the
+  // merged sparse image
+  if (fScoringMode == ScoringMode::Sparse) {
+    AllocateImageFromSparseImage(cpp_fluence_image.GetPointer(),
+                                 fFluenceSparseImage);
+  }
+  return 0;
+}
+
+void GateFluenceActor::QueueDeposit(const Image3DType::IndexType &index,
+                                    double value) {
+  // no lock: the deposit is applied later, with the other ones of the batch
+  auto &queue = fThreadLocalData.Get().deposit_queue;
+  if (queue.Push(index[0], index[1], index[2], {value}))
+    FlushDepositQueue();
+}
+
+void GateFluenceActor::FlushDepositQueue() {
+  auto &queue = fThreadLocalData.Get().deposit_queue;
+  if (queue.IsEmpty())
+    return;
+  // (the flat index is the offset in the itk buffer)
+  auto *buffer = cpp_fluence_image->GetBufferPointer();
+  GateAutoLock FluenceMutex(&SetPixelFluenceMutex);
+  queue.Flush([&](long offset, const GateDepositQueue<1>::Values &values) {
+    buffer[offset] += values[0];
+  });
 }
 
+void GateFluenceActor::EndSimulationAction() { fFluenceTimeFrames.Close(); }
+
 void GateFluenceActor::SteppingAction(G4Step *step) {
+  // kernel specialized for the scoring mode, see InitializeCpp
+  (this->*fSteppingKernel)(step);
+}
+
+template <GateFluenceActor::ScoringMode M>
+void GateFluenceActor::SteppingKernel(G4Step *step) {
   // same method to consider only entering tracks
   if (step->GetPreStepPoint()->GetStepStatus() == fGeomBoundary) {
     // the pre-position is at the edge
     auto preGlobal = step->GetPreStepPoint()->GetPosition();
     auto dir = step->GetPreStepPoint()->GetMomentumDirection();
-    auto touchable = step->GetPreStepPoint()->GetTouchable();
 
-    // consider position in the local volume, slightly shifted by 0.1 nm because
-    // otherwise, it can be considered as outside the volume by isInside.
+    // consider position slightly shifted by 0.1 nm because otherwise, it can
+    // be considered as outside the volume by isInside.
     auto position = preGlobal + 0.1 * CLHEP::nm * dir;
-    auto localPosition =
-        touchable->GetHistory()->GetTransform(0).TransformPoint(position);
-
-    // convert G4ThreeVector to itk PointType
-    Image3DType::PointType point;
-    point[0] = localPosition[0];
-    point[1] = localPosition[1];
-    point[2] = localPosition[2];
 
     // get weight
     auto w = step->GetTrack()->GetWeight();
 
-    // get pixel index
+    // get pixel index (the image is placed in the world frame)
     Image3DType::IndexType index;
-    bool isInside =
-        cpp_fluence_image->TransformPhysicalPointToIndex(point, index);
+    bool isInside = fIndexTransform.TransformPointToIndex(position, index);
 
     // set value
     if (isInside) {
-      G4AutoLock FluenceMutex(&SetPixelFluenceMutex);
-      ImageAddValue<Image3DType>(cpp_fluence_image, index, w);
+      if (fSpectralFlag) {
+        ScoreSpectralFluence(cpp_fluence_image->ComputeOffset(index),
+                             step->GetPreStepPoint()->GetKineticEnergy(), w);
+      }
+      if (fFluenceTimeFrames.IsEnabled()) {
+        fFluenceTimeFrames.AddValue(step->GetPreStepPoint()->GetGlobalTime(),
+                                    index[0], index[1], index[2], w);
+      }
+      if constexpr (M == ScoringMode::Sparse) {
+        fThreadLocalData.Get().fluence_worker_sparseimg.GetValue(
+            index[0], index[1], index[2]) += w;
+      } else if constexpr (M == ScoringMode::Queue) {
+        QueueDeposit(index, w);
+      } else if constexpr (M == ScoringMode::Atomic) {
+        ImageAtomicAddValue<Image3DType>(cpp_fluence_image, index, w);
+      } else {
+        GateAutoLock FluenceMutex(&SetPixelFluenceMutex);
+        ImageAddValue<Image3DType>(cpp_fluence_image, index, w);
+      }
     } // else : outside the image
   }
 }
+
+template <GateFluenceActor::ScoringMode M>
+void GateFluenceActor::TrackLengthKernel(G4Step *step) {
+  // track length estimator: the length of the step inside each crossed voxel
+  // (weighted), divided by the voxel volume on the py side
+  auto w = step->GetTrack()->GetWeight();
+  auto length = step->GetStepLength() * w;
+  auto energy = step->GetPreStepPoint()->GetKineticEnergy();
+  auto time = 0.5 * (step->GetPreStepPoint()->GetGlobalTime() +
+                     step->GetPostStepPoint()->GetGlobalTime());
+  fIndexTransform.ForEachVoxelOnSegment<Image3DType::IndexType>(
+      step->GetPreStepPoint()->GetPosition(),
+      step->GetPostStepPoint()->GetPosition(),
+      [&](const Image3DType::IndexType &index, double fraction) {
+        auto v = length * fraction;
+        if (fSpectralFlag) {
+          ScoreSpectralFluence(cpp_fluence_image->ComputeOffset(index),
+                               energy, v);
+        }
+        if (fFluenceTimeFrames.IsEnabled()) {
+          fFluenceTimeFrames.AddValue(time, index[0], index[1], index[2], v);
+        }
+        if constexpr (M == ScoringMode::Sparse) {
+          fThreadLocalData.Get().fluence_worker_sparseimg.GetValue(
+              index[0], index[1], index[2]) += v;
+        } else if constexpr (M == ScoringMode::Queue) {
+          QueueDeposit(index, v);
+        } else if constexpr (M == ScoringMode::Atomic) {
+          ImageAtomicAddValue<Image3DType>(cpp_fluence_image, index, v);
+        } else {
+          GateAutoLock FluenceMutex(&SetPixelFluenceMutex);
+          ImageAddValue<Image3DType>(cpp_fluence_image, index, v);
+        }
+      });
+}
@@ -10,8 +10,14 @@
 
 #include "G4Cache.hh"
 #include "G4VPrimitiveScorer.hh"
+#include "GateDepositQueue.h"
+#include "GateHelpersImage.h"
+#include "GateImageSnapshot.h"
+#include "GateSparseImage.h"
+#include "GateTimeFrameScorer.h"
 #include "GateVActor.h"
 #include "itkImage.h"
+#include <atomic>
 #include <iostream>
 #include <pybind11/stl.h>
 
@@ -20,6 +26,9 @@ namespace py = pybind11;
 class GateFluenceActor : public GateVActor {
 
 public:
+  // How the voxel values are accumulated in the shared image
+  enum ScoringMode { Mutex, Atomic, Sparse, Queue };
+
   // Constructor
   GateFluenceActor(py::dict &user_info);
 
@@ -33,13 +42,32 @@ public:
 
   void BeginOfEventAction(const G4Event *event) override;
 
+  void EndOfEventAction(const G4Event *event) override;
+
   void BeginOfRunActionMasterThread(int run_id) override;
 
+  // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
+
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Sparse scoring mode: the dense image is created here (output)
+  int EndOfRunActionMasterThread(int run_id) override;
+
+  void EndSimulationAction() override;
+
   inline std::string GetPhysicalVolumeName() { return fPhysicalVolumeName; }
 
   inline void SetPhysicalVolumeName(std::string s) { fPhysicalVolumeName = s; }
 
-  int NbOfEvent = 0;
+  // Number of events of the current run, incremented by all threads without
+  // lock. Read it during the run with GetNumberOfEvents().
+  std::atomic<int> NbOfEvent{0};
+
+  int GetNumberOfEvents() const {
+    return NbOfEvent.load(std::memory_order_relaxed);
+  }
 
   // Image type is 3D float by default
   typedef itk::Image<float, 3> Image3DType;
@@ -51,10 +79,90 @@ public:
   // The image is accessible on py side (shared by all threads)
   Image3DType::Pointer cpp_fluence_image;
 
+  // Spectral fluence (option energy_bins), one value per voxel and energy bin
+  // with the bins of a voxel side by side ([voxel][bin] layout)
+  size_t GetNumberOfEnergyBins() const;
+
+  const std::vector<double> &GetSpectralFluence() const {
+    return fSpectralFluence;
+  }
+
+  void ClearSpectralFluence();
+
+  // Copy the current fluence into the snapshot, while the workers keep on
+  // scoring (see GateDoseActor::TakeSnapshot)
+  void TakeSnapshot();
+
+  GateImageSnapshot fFluenceSnapshot;
+
+  // Option: the fluence is also scored per time frame of the global time
+  // (output "fluence_per_time_frame"), see GateTimeFrameScorer
+  GateTimeFrameScorer fFluenceTimeFrames;
+
 private:
   std::string fPhysicalVolumeName;
   G4ThreeVector fTranslation;
-  std::string fHitType;
+  HitType fHitType = HitType::Random;
+
+  // Option: mutex, lock-free atomic additions, per-thread sparse images or
+  // per-thread queues of deposits
+  ScoringMode fScoringMode = ScoringMode::Mutex;
+
+  // Option: number of deposits per thread applied at once (Queue scoring
+  // mode)
+  int fQueueSize = 4096;
+
+  // Add the deposit to the queue of the thread, the queue is applied to the
+  // shared image (with a single lock) when full
+  void QueueDeposit(const Image3DType::IndexType &index, double value);
+
+  void FlushDepositQueue();
+
+  // Sparse scoring mode: the sparse images of the threads are merged in this
+  // one, the dense image is only allocated at the end of the run
+  GateSparseImage<double> fFluenceSparseImage;
+
+  // Stepping kernel specialized for the scoring mode
+  template <ScoringMode M> void SteppingKernel(G4Step *step);
+
+  // Same with the track length estimator (hit_type 'segment')
+  template <ScoringMode M> void TrackLengthKernel(G4Step *step);
+
+  typedef void (GateFluenceActor::*SteppingKernelType)(G4Step *);
+  SteppingKernelType fSteppingKernel{};
+
+  // world to voxel index transform of the fluence image
+  GateImageIndexTransform fIndexTransform;
+
+  // Option: edges of the energy bins of the spectral fluence (empty: only
+  // the integral fluence)
+  std::vector<double> fEnergyBinEdges;
+  bool fSpectralFlag = false;
+
+  // Log-uniform edges: the bin is computed directly, otherwise it is found
+  // by binary search
+  bool fLogUniformBins = false;
+  double fLogEnergyMin = 0;
+  double fInvLogBinWidth = 0;
+
+  // bin of the energy, -1 if outside the edges
+  int GetEnergyBin(double energy) const;
+
+  // add a value to the spectral fluence of the voxel (lock-free)
+  void ScoreSpectralFluence(itk::OffsetValueType offset, double energy,
+                            double value);
+
+  // shared by all threads, see GetSpectralFluence
+  std::vector<double> fSpectralFluence;
+
+  struct threadLocalT {
+    // per-thread sparse image (Sparse scoring mode only)
+    GateSparseImage<double> fluence_worker_sparseimg;
+    // deferred deposits, applied by batches sorted by tile (Queue scoring
+    // mode only)
+    GateDepositQueue<1> deposit_queue;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
 };
 
 #endif // GateFluenceActor_h
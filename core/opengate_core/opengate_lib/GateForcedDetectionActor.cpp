@@ -0,0 +1,220 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateForcedDetectionActor.h"
+#include "G4Gamma.hh"
+#include "G4PhysicalConstants.hh"
+#include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
+#include "GateHelpersImage.h"
+#include "GateMutex.h"
+
+namespace {
+GATE_MUTEX(ForcedDetectionActorMutex);
+}
+
+GateForcedDetectionActor::GateForcedDetectionActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("BeginOfRunAction");
+  fActions.insert("SteppingAction");
+  fActions.insert("EndOfRunAction");
+  fEnergyMin = 0;
+  fEnergyMax = 0;
+  fScoreCompton = true;
+  fScoreRayleigh = false;
+  fScorePrimary = false;
+}
+
+void GateForcedDetectionActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fDatabase = DictGetStr(user_info, "database");
+  fEnergyMin = DictGetDouble(user_info, "energy_min");
+  fEnergyMax = DictGetDouble(user_info, "energy_max");
+  if (fEnergyMin >= fEnergyMax) {
+    std::ostringstream oss;
+    oss << "The energy window of the ForcedDetectionActor '" << GetName()
+        << "' is empty: energy_min = " << fEnergyMin
+        << " energy_max = " << fEnergyMax;
+    Fatal(oss.str());
+  }
+  fScorePrimary = DictGetBool(user_info, "primary");
+  fScoreCompton = false;
+  fScoreRayleigh = false;
+  for (const auto &p : DictGetVecStr(user_info, "interactions")) {
+    if (p == "compt")
+      fScoreCompton = true;
+    else if (p == "Rayl")
+      fScoreRayleigh = true;
+    else {
+      std::ostringstream oss;
+      oss << "The ForcedDetectionActor '" << GetName()
+          << "' can only score the 'compt' and 'Rayl' interactions, while "
+          << "'" << p << "' is given.";
+      Fatal(oss.str());
+    }
+  }
+  auto r = DictGetMatrix(user_info, "detector_orientation_matrix");
+  fDetectorOrientationMatrix = ConvertToG4RotationMatrix(r);
+}
+
+void GateForcedDetectionActor::InitializeCpp() {
+  fImage = ImageType::New();
+}
+
+void GateForcedDetectionActor::SetPhantomVolumeName(std::string name) {
+  fPhantomVolumeName = name;
+}
+
+void GateForcedDetectionActor::SetDetectorVolumeName(std::string name) {
+  fDetectorVolumeName = name;
+}
+
+void GateForcedDetectionActor::SetImageParameterisation(
+    GateImageNestedParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateForcedDetectionActor::SetImageParameterisation(
+    GateImageRegularParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->GetLabelMaterials();
+}
+
+void GateForcedDetectionActor::SetImageParameterisation(
+    GateImageRunParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateForcedDetectionActor::BeginOfRunActionMasterThread(int /*run_id*/) {
+  // projection image at the position/orientation of the detector
+  AttachImageToVolume<ImageType>(fImage, fDetectorVolumeName, G4ThreeVector(),
+                                 fDetectorOrientationMatrix);
+  fIndexTransform.Update(fImage.GetPointer());
+  const auto size = fImage->GetLargestPossibleRegion().GetSize();
+  fSizeX = size[0];
+  fSliceSize = size[0] * size[1];
+  const auto &dir = fImage->GetDirection();
+  fDetectorNormal = G4ThreeVector(dir[0][2], dir[1][2], dir[2][2]).unit();
+  G4RotationMatrix rotation;
+  ComputeTransformationFromVolumeToWorld(fDetectorVolumeName, fDetectorCenter,
+                                         rotation, true);
+
+  // phantom geometry and labels (the image may change between runs)
+  fAttenuation.Initialize(
+      fLabelImage, *fLabelMaterials, fPhantomVolumeName,
+      GateMaterialMuHandler::GetInstance(fDatabase, fEnergyMax));
+}
+
+void GateForcedDetectionActor::BeginOfRunAction(const G4Run * /*run*/) {
+  auto &l = fThreadLocalData.Get();
+  l.fStack.assign(fSliceSize, 0);
+}
+
+void GateForcedDetectionActor::SteppingAction(G4Step *step) {
+  const auto *track = step->GetTrack();
+  if (track->GetParticleDefinition() != G4Gamma::Gamma())
+    return;
+  if (fScorePrimary && track->GetParentID() == 0 &&
+      track->GetCurrentStepNumber() == 1)
+    ScorePrimary(step);
+  const auto *post = step->GetPostStepPoint();
+  const auto *process = post->GetProcessDefinedStep();
+  if (process == nullptr)
+    return;
+  const auto &name = process->GetProcessName();
+  const bool compton = fScoreCompton && name == "compt";
+  const bool rayleigh = fScoreRayleigh && name == "Rayl";
+  if (!compton && !rayleigh)
+    return;
+
+  const auto &position = post->GetPosition();
+  const auto direction = GetDirectionToDetector(position);
+
+  // incident photon (the pre-step point is before the interaction)
+  const auto *pre = step->GetPreStepPoint();
+  const auto energy = pre->GetKineticEnergy();
+  const auto cos_theta = pre->GetMomentumDirection().dot(direction);
+  auto scattered_energy = energy;
+  const auto density = compton
+                           ? KleinNishinaDensity(energy, cos_theta,
+                                                 scattered_energy)
+                           : ThomsonDensity(cos_theta);
+  if (scattered_energy < fEnergyMin || scattered_energy > fEnergyMax)
+    return;
+  ScoreToDetector(position, direction, scattered_energy,
+                  step->GetTrack()->GetWeight() * density);
+}
+
+G4ThreeVector GateForcedDetectionActor::GetDirectionToDetector(
+    const G4ThreeVector &position) const {
+  // the only accepted direction is the detector normal, toward the detector
+  if ((fDetectorCenter - position).dot(fDetectorNormal) < 0)
+    return -fDetectorNormal;
+  return fDetectorNormal;
+}
+
+void GateForcedDetectionActor::ScorePrimary(const G4Step *step) {
+  // emission point of the primary photon (isotropic emission)
+  const auto *pre = step->GetPreStepPoint();
+  const auto energy = pre->GetKineticEnergy();
+  if (energy < fEnergyMin || energy > fEnergyMax)
+    return;
+  const auto &position = pre->GetPosition();
+  ScoreToDetector(position, GetDirectionToDetector(position), energy,
+                  step->GetTrack()->GetWeight() / (4.0 * CLHEP::pi));
+}
+
+void GateForcedDetectionActor::EndOfRunAction(const G4Run *run) {
+  // add the stack of the thread to the slice of this run
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&ForcedDetectionActorMutex);
+  auto *buffer = fImage->GetBufferPointer() + run->GetRunID() * fSliceSize;
+  for (size_t i = 0; i < l.fStack.size(); i++)
+    buffer[i] += l.fStack[i];
+}
+
+void GateForcedDetectionActor::ScoreToDetector(const G4ThreeVector &position,
+                                               const G4ThreeVector &direction,
+                                               double energy, double weight) {
+  // pixel hit in the detector plane
+  const auto p =
+      position + (fDetectorCenter - position).dot(direction) * direction;
+  ImageType::IndexType index;
+  if (!fIndexTransform.TransformPointToIndex(p, index))
+    return;
+  const auto mu_l = fAttenuation.LineIntegral(position, p, energy);
+  auto &l = fThreadLocalData.Get();
+  l.fStack[index[1] * fSizeX + index[0]] += weight * std::exp(-mu_l);
+}
+
+double GateForcedDetectionActor::KleinNishinaDensity(double energy,
+                                                     double cos_theta,
+                                                     double &scattered_energy) {
+  const auto k = energy / CLHEP::electron_mass_c2;
+  const auto epsilon = 1.0 / (1.0 + k * (1.0 - cos_theta));
+  scattered_energy = epsilon * energy;
+  // (Thomson limit at low energy, where the total cross section formula is
+  // numerically unstable)
+  if (k < 1e-4)
+    return ThomsonDensity(cos_theta);
+  // dsigma/dOmega and sigma in units of the classical electron radius^2
+  const auto sin2 = 1.0 - cos_theta * cos_theta;
+  const auto dsigma =
+      0.5 * epsilon * epsilon * (epsilon + 1.0 / epsilon - sin2);
+  const auto l2k = std::log(1.0 + 2.0 * k);
+  const auto sigma =
+      CLHEP::twopi *
+      ((1.0 + k) / (k * k) * (2.0 * (1.0 + k) / (1.0 + 2.0 * k) - l2k / k) +
+       l2k / (2.0 * k) - (1.0 + 3.0 * k) / ((1.0 + 2.0 * k) * (1.0 + 2.0 * k)));
+  return dsigma / sigma;
+}
+
+double GateForcedDetectionActor::ThomsonDensity(double cos_theta) {
+  return 3.0 / (16.0 * CLHEP::pi) * (1.0 + cos_theta * cos_theta);
+}
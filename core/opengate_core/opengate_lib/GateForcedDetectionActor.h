@@ -0,0 +1,137 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateForcedDetectionActor_h
+#define GateForcedDetectionActor_h
+
+#include "G4Cache.hh"
+#include "GateAttenuationRayMarcher.h"
+#include "GateHelpersImage.h"
+#include "GateVActor.h"
+#include "itkImage.h"
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Forced detection (next-event estimator) of the scattered photons in a
+ * voxelized phantom. At each Compton (or Rayleigh) interaction of a photon
+ * in the phantom, the probability that the photon is scattered toward the
+ * detector and reaches it without any other interaction is scored in the
+ * pixel it would hit:
+ *
+ *   weight * (1/sigma dsigma/dOmega)(theta) * exp(-sum mu_i l_i)
+ *
+ * The detector is an ideal parallel collimator: the only accepted direction
+ * is the normal of the detector plane. The angular density is the one of
+ * Klein-Nishina (Compton) or Thomson (Rayleigh), the mu are the attenuation
+ * of the phantom materials at the scattered energy, summed over the voxels
+ * crossed from the interaction to the phantom boundary (see
+ * GateAttenuationRayMarcher, no attenuation outside the phantom). The
+ * projection is thus in counts per steradian, per primary weight.
+ *
+ * With the primary option, the primary photons emitted in the phantom are
+ * projected analytically: at the emission point (first step of the primary
+ * track), the probability of an isotropic emission along the accepted
+ * direction without any interaction,
+ *
+ *   weight * 1 / (4 pi) * exp(-sum mu_i l_i)
+ *
+ * at the primary energy (if in the energy window) is scored in the same way,
+ * so that the projection is primary + scatter with one line integral per
+ * primary. The tracking of the primaries is not changed (they still produce
+ * the scatter).
+ *
+ * Each thread scores in its own projection stack, added to the image at
+ * the end of the run (one slice per run).
+ */
+
+class GateForcedDetectionActor : public GateVActor {
+
+public:
+  explicit GateForcedDetectionActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  // Called every time a Run starts (master thread)
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
+
+  // Called every time a step occurs in the phantom (all threads)
+  void SteppingAction(G4Step *step) override;
+
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  void SetPhantomVolumeName(std::string name);
+
+  void SetDetectorVolumeName(std::string name);
+
+  void SetImageParameterisation(GateImageNestedParameterisation *param);
+
+  void SetImageParameterisation(GateImageRegularParameterisation *param);
+
+  void SetImageParameterisation(GateImageRunParameterisation *param);
+
+  // Image type is 3D float by default
+  typedef itk::Image<float, 3> ImageType;
+  ImageType::Pointer fImage;
+
+protected:
+  // Score the photon scattered at the position with the new energy, the
+  // angular density being already included in the weight
+  void ScoreToDetector(const G4ThreeVector &position,
+                       const G4ThreeVector &direction, double energy,
+                       double weight);
+
+  // Accepted direction at the position: the detector normal, toward the
+  // detector
+  G4ThreeVector GetDirectionToDetector(const G4ThreeVector &position) const;
+
+  // Analytical projection of the primary photon emitted at the pre step
+  void ScorePrimary(const G4Step *step);
+
+  // Angular densities per steradian of the scattering at cos_theta
+  static double KleinNishinaDensity(double energy, double cos_theta,
+                                    double &scattered_energy);
+  static double ThomsonDensity(double cos_theta);
+
+  std::string fPhantomVolumeName;
+  std::string fDetectorVolumeName;
+  std::string fDatabase;
+  double fEnergyMin;
+  double fEnergyMax;
+  bool fScoreCompton;
+  bool fScoreRayleigh;
+  bool fScorePrimary;
+  G4RotationMatrix fDetectorOrientationMatrix;
+
+  // labels and materials of the phantom voxels, and line integrals of mu
+  const GateAttenuationRayMarcher::LabelImageType *fLabelImage = nullptr;
+  const std::vector<G4Material *> *fLabelMaterials = nullptr;
+  GateAttenuationRayMarcher fAttenuation;
+
+  // world to pixel index of the projection, the detector plane (center and
+  // normal) and the number of pixels of one projection
+  GateImageIndexTransform fIndexTransform;
+  G4ThreeVector fDetectorCenter;
+  G4ThreeVector fDetectorNormal;
+  size_t fSizeX = 0;
+  size_t fSliceSize = 0;
+
+  struct threadLocalT {
+    // projection of the run
+    std::vector<float> fStack;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateForcedDetectionActor_h
@@ -0,0 +1,150 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateGANInference.h"
+#include "GateHelpers.h"
+#include <iostream>
+#include <sstream>
+
+#ifdef USE_ONNXRUNTIME
+#include <array>
+#include <onnxruntime_cxx_api.h>
+#include <vector>
+
+struct GateGANInference::Impl {
+  Ort::Env fEnv{ORT_LOGGING_LEVEL_WARNING, "opengate"};
+  Ort::SessionOptions fOptions;
+  std::unique_ptr<Ort::Session> fSession;
+  Ort::MemoryInfo fMemoryInfo =
+      Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  std::string fInputName;
+  std::string fOutputName;
+};
+
+namespace {
+size_t GetLastDimension(const Ort::TypeInfo &info, const std::string &filename,
+                        const std::string &model_type,
+                        const std::string &what) {
+  auto shape = info.GetTensorTypeAndShapeInfo().GetShape();
+  if (shape.size() != 2 || shape[1] <= 0) {
+    std::ostringstream oss;
+    oss << "The " << what << " of the " << model_type << " model '"
+        << filename
+        << "' must be a 2D tensor (batch x dimension) with a fixed dimension";
+    Fatal(oss.str());
+  }
+  return static_cast<size_t>(shape[1]);
+}
+} // namespace
+
+#else
+struct GateGANInference::Impl {};
+#endif
+
+GateGANInference::GateGANInference() {
+  fInputDimension = 0;
+  fOutputDimension = 0;
+}
+
+GateGANInference::~GateGANInference() = default;
+
+bool GateGANInference::IsAvailable() {
+#ifdef USE_ONNXRUNTIME
+  return true;
+#else
+  return false;
+#endif
+}
+
+void GateGANInference::Initialize(const std::string &filename,
+                                  const std::string &gpu_mode,
+                                  const std::string &model_type) {
+  fFilename = filename;
+  fModelType = model_type;
+#ifdef USE_ONNXRUNTIME
+  fImpl = std::make_unique<Impl>();
+  if (gpu_mode != "cpu") {
+    try {
+      OrtCUDAProviderOptions cuda_options;
+      fImpl->fOptions.AppendExecutionProvider_CUDA(cuda_options);
+    } catch (const Ort::Exception &e) {
+      // not a fatal error (like with torch, the CPU is used instead)
+      if (gpu_mode == "gpu")
+        std::cout << "WARNING: cannot use the GPU for the " << model_type
+                  << " model '" << filename << "', the CPU is used ("
+                  << e.what() << ")" << std::endl;
+    }
+  }
+  try {
+    // (the path is a wide string on Windows)
+    std::basic_string<ORTCHAR_T> path(filename.begin(), filename.end());
+    fImpl->fSession = std::make_unique<Ort::Session>(
+        fImpl->fEnv, path.c_str(), fImpl->fOptions);
+  } catch (const Ort::Exception &e) {
+    std::ostringstream oss;
+    oss << "Cannot read the " << model_type << " model '" << filename
+        << "': " << e.what();
+    Fatal(oss.str());
+  }
+  auto &session = *fImpl->fSession;
+  if (session.GetInputCount() != 1 || session.GetOutputCount() != 1) {
+    std::ostringstream oss;
+    oss << "The " << model_type << " model '" << filename
+        << "' must have exactly one input and one output, while it has "
+        << session.GetInputCount() << " and " << session.GetOutputCount();
+    Fatal(oss.str());
+  }
+  Ort::AllocatorWithDefaultOptions allocator;
+  fImpl->fInputName = session.GetInputNameAllocated(0, allocator).get();
+  fImpl->fOutputName = session.GetOutputNameAllocated(0, allocator).get();
+  fInputDimension =
+      GetLastDimension(session.GetInputTypeInfo(0), filename, model_type,
+                       "input");
+  fOutputDimension =
+      GetLastDimension(session.GetOutputTypeInfo(0), filename, model_type,
+                       "output");
+#else
+  std::ostringstream oss;
+  oss << "Cannot use the " << model_type << " model '" << filename
+      << "' (gpu_mode = " << gpu_mode
+      << "): opengate_core is compiled without ONNX Runtime. "
+      << "Use the torch backend, or compile opengate_core with "
+      << "OPENGATE_USE_ONNXRUNTIME";
+  Fatal(oss.str());
+#endif
+}
+
+void GateGANInference::Run(const float *z, float *output, size_t n) const {
+#ifdef USE_ONNXRUNTIME
+  if (n == 0)
+    return;
+  std::array<int64_t, 2> input_shape{static_cast<int64_t>(n),
+                                     static_cast<int64_t>(fInputDimension)};
+  std::array<int64_t, 2> output_shape{static_cast<int64_t>(n),
+                                      static_cast<int64_t>(fOutputDimension)};
+  // the tensors wrap the buffers of the caller (no copy, no allocation)
+  auto input = Ort::Value::CreateTensor<float>(
+      fImpl->fMemoryInfo, const_cast<float *>(z), n * fInputDimension,
+      input_shape.data(), input_shape.size());
+  auto out = Ort::Value::CreateTensor<float>(
+      fImpl->fMemoryInfo, output, n * fOutputDimension, output_shape.data(),
+      output_shape.size());
+  const char *input_names[] = {fImpl->fInputName.c_str()};
+  const char *output_names[] = {fImpl->fOutputName.c_str()};
+  try {
+    fImpl->fSession->Run(Ort::RunOptions{nullptr}, input_names, &input, 1,
+                         output_names, &out, 1);
+  } catch (const Ort::Exception &e) {
+    std::ostringstream oss;
+    oss << "Error during the inference of the " << fModelType << " model '"
+        << fFilename << "': " << e.what();
+    Fatal(oss.str());
+  }
+#else
+  Fatal("GateGANInference: opengate_core is compiled without ONNX Runtime");
+#endif
+}
@@ -0,0 +1,54 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateGANInference_h
+#define GateGANInference_h
+
+#include <memory>
+#include <string>
+
+/*
+ * Batched inference of an exported GAN generator (ONNX file), without
+ * Python. The model has one float input (n x input dimension, the random
+ * vectors z) and one float output (n x output dimension, the particles).
+ * Also used for the ARF network of GateARFActor (input: angles and energy,
+ * output: probabilities of the energy windows).
+ * Run can be called concurrently by several threads, each one with its own
+ * buffers. Only available when opengate_core is compiled with ONNX Runtime
+ * (OPENGATE_USE_ONNXRUNTIME), see IsAvailable.
+ */
+
+class GateGANInference {
+public:
+  GateGANInference();
+
+  ~GateGANInference();
+
+  // gpu_mode: "cpu", "gpu" or "auto" (the CPU is used if CUDA is missing),
+  // model_type is only used in the messages
+  void Initialize(const std::string &filename, const std::string &gpu_mode,
+                  const std::string &model_type = "GAN");
+
+  size_t GetInputDimension() const { return fInputDimension; }
+
+  size_t GetOutputDimension() const { return fOutputDimension; }
+
+  // z: n x input dimension, output: n x output dimension (pre-allocated)
+  void Run(const float *z, float *output, size_t n) const;
+
+  static bool IsAvailable();
+
+protected:
+  struct Impl;
+  std::unique_ptr<Impl> fImpl;
+  std::string fFilename;
+  std::string fModelType;
+  size_t fInputDimension;
+  size_t fOutputDimension;
+};
+
+#endif // GateGANInference_h
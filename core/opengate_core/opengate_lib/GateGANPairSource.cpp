@@ -7,31 +7,28 @@
 
 #include "GateGANPairSource.h"
 #include "G4ParticleTable.hh"
+#include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
 #include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
 
-GateGANPairSource::GateGANPairSource() : GateGANSource() {}
+GateGANPairSource::GateGANPairSource() : GateGANSource() {
+  fPairAcceptanceFlag = false;
+  fAcceptanceRunId = -1;
+  fAcceptanceGeometryVersion = 0;
+  fConsecutiveRejectedPairs = 0;
+}
 
 GateGANPairSource::~GateGANPairSource() = default;
 
 void GateGANPairSource::InitializeUserInfo(py::dict &user_info) {
   GateGANSource::InitializeUserInfo(user_info);
+  // the acceptance angle and the SkipEvents energy policy are applied to the
+  // whole batch, to both particles of the pairs
   auto &l = GetThreadLocalDataGenericSource();
-  if (l.fAAManager->IsEnabled()) {
-    std::ostringstream oss;
-    oss << "Error, cannot use AngularAcceptance with GAN pairs (yet), for the "
-           "source '"
-        << fName << "'";
-    Fatal(oss.str());
-  }
-
-  if (fSkipEnergyPolicy == GateAcceptanceAngleTesterManager::AASkipEvent) {
-    std::ostringstream oss;
-    oss << "Error, cannot use SkipEvent mode with GAN pairs (yet), for the "
-           "source '"
-        << fName << "'. Use ZeroEnergy";
-    Fatal(oss.str());
-  }
+  fPairAcceptanceFlag =
+      l.fAAManager->IsEnabled() ||
+      fSkipEnergyPolicy == GateAcceptanceAngleTesterManager::AASkipEvent;
 }
 
 void GateGANPairSource::SetGeneratorInfo(py::dict &user_info) {
@@ -61,13 +58,50 @@ void GateGANPairSource::SetGeneratorInfo(py::dict &user_info) {
   }
 }
 
+std::vector<double> *
+GateGANPairSource::GetNativeOutputVector(const std::string &name) {
+  if (name == "PositionX2")
+    return &fPositionX2;
+  if (name == "PositionY2")
+    return &fPositionY2;
+  if (name == "PositionZ2")
+    return &fPositionZ2;
+  if (name == "DirectionX2")
+    return &fDirectionX2;
+  if (name == "DirectionY2")
+    return &fDirectionY2;
+  if (name == "DirectionZ2")
+    return &fDirectionZ2;
+  if (name == "Energy2")
+    return &fEnergy2;
+  if (name == "Time2")
+    return &fTime2;
+  if (name == "Weight2")
+    return &fWeight2;
+  return GateGANSource::GetNativeOutputVector(name);
+}
+
+void GateGANPairSource::MoveBackwardNative(size_t n) {
+  // the time of the first particle only, see
+  // GANSourceDefaultPairsGenerator.move_backward
+  GateGANSource::MoveBackwardNative(n);
+  for (size_t i = 0; i < n; i++) {
+    fPositionX2[i] -= fBackwardDistance * fDirectionX2[i];
+    fPositionY2[i] -= fBackwardDistance * fDirectionY2[i];
+    fPositionZ2[i] -= fBackwardDistance * fDirectionZ2[i];
+  }
+}
+
 void GateGANPairSource::GeneratePrimaries(G4Event *event,
                                           double current_simulation_time) {
   if (fCurrentIndex >= fCurrentBatchSize)
-    GenerateBatchOfParticles();
+    NextBatch();
 
   // Generate one or two primaries
-  GeneratePrimariesPair(event, current_simulation_time);
+  if (fPairAcceptanceFlag)
+    GenerateAcceptedPair(event, current_simulation_time);
+  else
+    GeneratePrimariesPair(event, current_simulation_time);
 
   // update the index;
   fCurrentIndex++;
@@ -77,11 +111,129 @@ void GateGANPairSource::GeneratePrimaries(G4Event *event,
   l.fNumberOfGeneratedEvents++;
 }
 
+void GateGANPairSource::NextBatch() {
+  GenerateBatchOfParticles();
+  if (fPairAcceptanceFlag)
+    TestBatchAcceptance(0);
+}
+
+void GateGANPairSource::TestBatchAcceptance(size_t first) {
+  auto &l = fThreadLocalData.Get();
+  auto &ll = GetThreadLocalDataGenericSource();
+  auto *aa = ll.fAAManager;
+  const bool skip_energy =
+      fSkipEnergyPolicy == GateAcceptanceAngleTesterManager::AASkipEvent;
+  const auto aa_status =
+      aa->GetPolicy() == GateAcceptanceAngleTesterManager::AASkipEvent
+          ? PairSkipped
+          : PairZeroEnergy;
+  fPairStatus.resize(fCurrentBatchSize);
+  for (size_t i = first; i < fCurrentBatchSize; i++) {
+    fPairStatus[i] = PairAccepted;
+    // energy thresholds of both particles
+    if (skip_energy) {
+      auto e1 = fEnergy[i];
+      auto e2 = fEnergy2[i];
+      if (e1 < fEnergyMinThreshold || e1 > fEnergyMaxThreshold ||
+          e2 < fEnergyMinThreshold || e2 > fEnergyMaxThreshold) {
+        fPairStatus[i] = PairSkipped;
+        continue;
+      }
+    }
+    if (!aa->IsEnabled())
+      continue;
+    // acceptance angle of both particles, in the world coordinate system
+    // (the count of not accepted events of the manager is per pair)
+    aa->StartAcceptLoop();
+    G4ThreeVector p1(fPositionX[i], fPositionY[i], fPositionZ[i]);
+    p1 = fLocalRotation * p1 + fLocalTranslation;
+    p1 = l.fGlobalRotation * p1 + l.fGlobalTranslation;
+    G4ThreeVector d1(fDirectionX[i], fDirectionY[i], fDirectionZ[i]);
+    d1 = l.fGlobalRotation * (d1 / d1.mag());
+    if (!aa->TestIfAccept(p1, d1)) {
+      fPairStatus[i] = aa_status;
+      continue;
+    }
+    G4ThreeVector p2(fPositionX2[i], fPositionY2[i], fPositionZ2[i]);
+    p2 = l.fGlobalRotation * p2 + l.fGlobalTranslation;
+    G4ThreeVector d2(fDirectionX2[i], fDirectionY2[i], fDirectionZ2[i]);
+    d2 = l.fGlobalRotation * (d2 / d2.mag());
+    if (!aa->TestIfAccept(p2, d2))
+      fPairStatus[i] = aa_status;
+  }
+  fAcceptanceRunId =
+      G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  fAcceptanceGeometryVersion = GetVolumeTransformCacheVersion();
+}
+
+void GateGANPairSource::GenerateAcceptedPair(G4Event *event,
+                                             double current_simulation_time) {
+  // the volumes of the acceptance angle may have moved since the batch was
+  // tested (new run, or sub-run): the remaining pairs are tested again
+  if (fAcceptanceRunId !=
+          G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID() ||
+      fAcceptanceGeometryVersion != GetVolumeTransformCacheVersion())
+    TestBatchAcceptance(fCurrentIndex);
+
+  // skip the rejected pairs (they are counted as events, for the time and
+  // the number of events of the source, but not tracked)
+  auto &ll = GetThreadLocalDataGenericSource();
+  ll.fCurrentZeroEvents = 0;
+  ll.fCurrentSkippedEvents = 0;
+  while (fPairStatus[fCurrentIndex] == PairSkipped) {
+    ll.fCurrentSkippedEvents++;
+    if (++fConsecutiveRejectedPairs > 100000) {
+      std::ostringstream oss;
+      oss << "Error, for the GAN pairs source '" << fName << "', "
+          << fConsecutiveRejectedPairs
+          << " pairs have been rejected (acceptance angle or energy "
+             "thresholds); probably no possible pair. Abort.";
+      Fatal(oss.str());
+    }
+    fCurrentIndex++;
+    if (fCurrentIndex >= fCurrentBatchSize)
+      NextBatch();
+  }
+  fConsecutiveRejectedPairs = 0;
+  const bool zero_energy = fPairStatus[fCurrentIndex] == PairZeroEnergy;
+
+  // first particle (the energy of each particle may still be set to zero
+  // with the ZeroEnergy policy)
+  auto position = GeneratePrimariesPosition();
+  auto direction = GeneratePrimariesDirection();
+  double energy = zero_energy ? 0 : GeneratePrimariesEnergy();
+  if (zero_energy || energy < fEnergyMinThreshold ||
+      energy > fEnergyMaxThreshold) {
+    energy = 0;
+    ll.fCurrentZeroEvents = 1;
+  }
+  auto time = GeneratePrimariesTime(current_simulation_time);
+  // time of the skipped pairs, when it is not given by the GAN
+  if ((!fTime_is_set_by_GAN || ll.fCurrentZeroEvents > 0) &&
+      ll.fCurrentSkippedEvents > 0) {
+    UpdateEffectiveEventTime(current_simulation_time,
+                             ll.fCurrentSkippedEvents);
+    time = ll.fEffectiveEventTime;
+  }
+  auto weight = GeneratePrimariesWeight();
+  AddOnePrimaryVertex(event, position, direction, energy, time, weight);
+
+  // second particle
+  AddSecondPrimary(event, current_simulation_time, zero_energy);
+}
+
 void GateGANPairSource::GeneratePrimariesPair(G4Event *event,
                                               double current_simulation_time) {
   // First particle
   GenerateOnePrimary(event, current_simulation_time);
 
+  // Second particle
+  AddSecondPrimary(event, current_simulation_time, false);
+}
+
+void GateGANPairSource::AddSecondPrimary(G4Event *event,
+                                         double current_simulation_time,
+                                         bool zero_energy) {
   // position of the second particle
   G4ThreeVector position(fPositionX2[fCurrentIndex], fPositionY2[fCurrentIndex],
                          fPositionZ2[fCurrentIndex]);
@@ -102,8 +254,8 @@ void GateGANPairSource::GeneratePrimariesPair(G4Event *event,
   double energy = fEnergy2[fCurrentIndex];
 
   // check if valid
-  bool accept_energy =
-      energy > fEnergyMinThreshold && energy < fEnergyMaxThreshold;
+  bool accept_energy = !zero_energy && energy > fEnergyMinThreshold &&
+                       energy < fEnergyMaxThreshold;
   if (!accept_energy) {
     energy = 0;
     // at least one of the two vertices has been skipped with zeroE
@@ -121,9 +273,10 @@ void GateGANPairSource::GeneratePrimariesPair(G4Event *event,
       time = fTime2[fCurrentIndex];
     // consider the earliest one
     ll.fEffectiveEventTime = min(time, ll.fEffectiveEventTime);
-  } else {
+  } else if (ll.fCurrentSkippedEvents == 0) {
     ll.fEffectiveEventTime = current_simulation_time;
   }
+  // (otherwise the time of the first particle, after the skipped pairs)
 
   // weights
   double w = 1.0;
@@ -31,6 +31,11 @@ public:
 
   void GeneratePrimariesPair(G4Event *event, double current_simulation_time);
 
+  // With the acceptance angle or the SkipEvents energy policy: the pairs of
+  // the batch are tested once, the rejected ones are skipped (or generated
+  // with zero energy) before any primary is created
+  void GenerateAcceptedPair(G4Event *event, double current_simulation_time);
+
   // For pairs of particles
   std::vector<double> fPositionX2;
   std::vector<double> fPositionY2;
@@ -43,6 +48,30 @@ public:
   std::vector<double> fEnergy2;
   std::vector<double> fWeight2;
   std::vector<double> fTime2;
+
+protected:
+  std::vector<double> *GetNativeOutputVector(const std::string &name) override;
+
+  void MoveBackwardNative(size_t n) override;
+
+  void NextBatch();
+
+  // Test the pairs [first, end of the batch]: both photons must be accepted
+  // by the acceptance angle and be in the energy thresholds
+  void TestBatchAcceptance(size_t first);
+
+  void AddSecondPrimary(G4Event *event, double current_simulation_time,
+                        bool zero_energy);
+
+  enum PairStatus : char { PairAccepted, PairSkipped, PairZeroEnergy };
+
+  bool fPairAcceptanceFlag;
+  std::vector<PairStatus> fPairStatus;
+  // the acceptance of the batch depends on the position of the volumes
+  int fAcceptanceRunId;
+  unsigned long fAcceptanceGeometryVersion;
+  // consecutive rejected pairs (to detect an impossible acceptance)
+  unsigned long fConsecutiveRejectedPairs;
 };
 
 #endif // GateGANPairSource_h
@@ -7,8 +7,12 @@
 
 #include "GateGANSource.h"
 #include "G4ParticleTable.hh"
+#include "G4PhysicalConstants.hh"
 #include "G4UnitsTable.hh"
 #include "GateHelpersDict.h"
+#include "GateTimeline.h"
+#include "Randomize.hh"
+#include <algorithm>
 
 GateGANSource::GateGANSource() : GateGenericSource() {
   fCurrentIndex = INT_MAX;
@@ -24,7 +28,10 @@ GateGANSource::GateGANSource() : GateGenericSource() {
   fWeight_is_set_by_GAN = false;
   fSkipEnergyPolicy = SEPolicyType::AAUndefined;
   fCurrentBatchSize = 0;
-  fCurrentBatchSize = 0;
+  fUseNativeGenerator = false;
+  fNativeBatchSize = 0;
+  fUniformZ = false;
+  fBackwardDistance = 0;
 }
 
 GateGANSource::~GateGANSource() = default;
@@ -47,11 +54,8 @@ void GateGANSource::InitializeUserInfo(py::dict &user_info) {
 
   // set the angle acceptance volume if needed
   // AAManager is already set in GenericSource BUT MUST be iso direction here ?
-  auto d = py::dict(user_info["direction"]);
-  auto dd = py::dict(d["acceptance_angle"]);
+  InitializeAcceptanceAngle(user_info, true);
   auto &ll = GetThreadLocalDataGenericSource();
-  ll.fAAManager->Initialize(dd, true);
-  ll.fSPS->SetAAManager(ll.fAAManager);
 
   // energy threshold mode
   auto s = DictGetStr(user_info, "skip_policy");
@@ -116,7 +120,128 @@ void GateGANSource::SetGeneratorInfo(py::dict &user_info) {
   fRelativeTiming = DictGetBool(user_info, "timing_is_relative");
 }
 
+void GateGANSource::SetNativeGeneratorInfo(py::dict &user_info) {
+  fUseNativeGenerator = true;
+  fNativeBatchSize = DictGetInt(user_info, "batch_size");
+  fUniformZ = DictGetBool(user_info, "z_uniform");
+  fBackwardDistance = DictGetDouble(user_info, "backward_distance");
+
+  // the model is read once, the session is shared by all threads
+  {
+    std::lock_guard<std::mutex> lock(fInferenceMutex);
+    if (fInference == nullptr) {
+      auto inference = std::make_shared<GateGANInference>();
+      inference->Initialize(DictGetStr(user_info, "model"),
+                            DictGetStr(user_info, "gpu_mode"));
+      fInference = inference;
+    }
+  }
+
+  // the columns of the GAN output copied to the vectors of the source
+  auto columns = py::list(user_info["columns"]);
+  fNativeColumns.clear();
+  for (auto item : columns) {
+    auto column = item.cast<py::tuple>();
+    auto name = column[0].cast<std::string>();
+    NativeColumn c{};
+    c.fValues = GetNativeOutputVector(name);
+    c.fIndex = column[1].cast<int>();
+    c.fValue = column[2].cast<double>();
+    if (c.fValues == nullptr ||
+        c.fIndex >= static_cast<int>(fInference->GetOutputDimension())) {
+      std::ostringstream oss;
+      oss << "Cannot use the column '" << name << "' (index " << c.fIndex
+          << ") of the GAN model for the source '" << fName
+          << "', the output dimension of the model is "
+          << fInference->GetOutputDimension();
+      Fatal(oss.str());
+    }
+    fNativeColumns.push_back(c);
+  }
+}
+
+std::vector<double> *
+GateGANSource::GetNativeOutputVector(const std::string &name) {
+  if (name == "PositionX")
+    return &fPositionX;
+  if (name == "PositionY")
+    return &fPositionY;
+  if (name == "PositionZ")
+    return &fPositionZ;
+  if (name == "DirectionX")
+    return &fDirectionX;
+  if (name == "DirectionY")
+    return &fDirectionY;
+  if (name == "DirectionZ")
+    return &fDirectionZ;
+  if (name == "Energy")
+    return &fEnergy;
+  if (name == "Time")
+    return &fTime;
+  if (name == "Weight")
+    return &fWeight;
+  return nullptr;
+}
+
+void GateGANSource::GenerateBatchOfParticlesNative() {
+  auto &l = fThreadLocalDataGAN.Get();
+  const auto n = fNativeBatchSize;
+  const auto z_dim = fInference->GetInputDimension();
+  const auto x_dim = fInference->GetOutputDimension();
+
+  // random input, with the Geant4 engine of the thread (reproducible)
+  l.fZ.resize(n * z_dim);
+  if (fUniformZ)
+    for (auto &z : l.fZ)
+      z = static_cast<float>(G4UniformRand());
+  else
+    for (auto &z : l.fZ)
+      z = static_cast<float>(G4RandGauss::shoot(0.0, 1.0));
+
+  // inference (the buffers are only allocated for the first batch)
+  l.fOutput.resize(n * x_dim);
+  fInference->Run(l.fZ.data(), l.fOutput.data(), n);
+
+  // copy the output columns (or the fixed values) to the source
+  for (const auto &c : fNativeColumns) {
+    auto &values = *c.fValues;
+    values.resize(n);
+    if (c.fIndex < 0) {
+      std::fill(values.begin(), values.end(), c.fValue);
+      continue;
+    }
+    const float *output = l.fOutput.data() + c.fIndex;
+    for (size_t i = 0; i < n; i++)
+      values[i] = output[i * x_dim];
+  }
+  if (fBackwardDistance != 0)
+    MoveBackwardNative(n);
+  fCurrentIndex = 0;
+  fCurrentBatchSize = n;
+}
+
+void GateGANSource::MoveBackwardNative(size_t n) {
+  // like GANSourceDefaultGenerator.move_backward on the Python side
+  for (size_t i = 0; i < n; i++) {
+    fPositionX[i] -= fBackwardDistance * fDirectionX[i];
+    fPositionY[i] -= fBackwardDistance * fDirectionY[i];
+    fPositionZ[i] -= fBackwardDistance * fDirectionZ[i];
+  }
+  if (fTime_is_set_by_GAN) {
+    const double dt = fBackwardDistance / c_light;
+    for (size_t i = 0; i < n; i++)
+      fTime[i] -= dt;
+  }
+}
+
 void GateGANSource::GenerateBatchOfParticles() {
+  GateTimelineScope timeline("GAN batch", "callback");
+  // the native inference does not need Python (nor the GIL)
+  if (fUseNativeGenerator) {
+    GenerateBatchOfParticlesNative();
+    return;
+  }
+
   // I don't know if we should acquire the GIL or not
   // (does not seem needed)
   // py::gil_scoped_acquire acquire;
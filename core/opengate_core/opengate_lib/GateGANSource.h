@@ -8,9 +8,12 @@
 #ifndef GateGANSource_h
 #define GateGANSource_h
 
+#include "GateGANInference.h"
 #include "GateGenericSource.h"
 #include "GateSPSVoxelsPosDistribution.h"
 #include "GateSingleParticleSource.h"
+#include <memory>
+#include <mutex>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -30,6 +33,15 @@ public:
 
   void PrepareNextRun() override;
 
+  // the time of the events may be given by the GAN (and events skipped)
+  bool CanShareTimeProfile() const override { return false; }
+
+  // the primaries are generated by the GAN (see GenerateBatchOfParticles)
+  bool GeneratePrimaryBatch(GatePrimaryBatch & /*batch*/,
+                            size_t /*n*/) override {
+    return false;
+  }
+
   void GeneratePrimaries(G4Event *event,
                          double current_simulation_time) override;
 
@@ -52,6 +64,10 @@ public:
 
   virtual void SetGeneratorInfo(py::dict &user_info);
 
+  // Native (C++) inference of the exported GAN, instead of the Python
+  // generator function
+  void SetNativeGeneratorInfo(py::dict &user_info);
+
   void GenerateBatchOfParticles();
 
   bool fPosition_is_set_by_GAN;
@@ -85,6 +101,37 @@ public:
   size_t fCurrentIndex;
   double fCharge;
   double fMass;
+
+protected:
+  void GenerateBatchOfParticlesNative();
+
+  // the vector of the source filled by a native column ("PositionX", etc)
+  virtual std::vector<double> *GetNativeOutputVector(const std::string &name);
+
+  virtual void MoveBackwardNative(size_t n);
+
+  // one column of the output of the native GAN: the values of the GAN output
+  // at this index, or a fixed value (index = -1)
+  struct NativeColumn {
+    std::vector<double> *fValues;
+    int fIndex;
+    double fValue;
+  };
+
+  bool fUseNativeGenerator;
+  std::shared_ptr<GateGANInference> fInference;
+  std::mutex fInferenceMutex;
+  size_t fNativeBatchSize;
+  bool fUniformZ;
+  double fBackwardDistance;
+  std::vector<NativeColumn> fNativeColumns;
+
+  // buffers of the native inference, for each thread
+  struct threadLocalGANT {
+    std::vector<float> fZ;
+    std::vector<float> fOutput;
+  };
+  G4Cache<threadLocalGANT> fThreadLocalDataGAN;
 };
 
 #endif // GateGANSource_h
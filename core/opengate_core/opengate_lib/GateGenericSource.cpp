@@ -9,6 +9,7 @@
 #include "G4IonTable.hh"
 #include "G4ParticleTable.hh"
 #include "G4RandomTools.hh"
+#include "G4Threading.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
 #include "fmt/core.h"
@@ -29,6 +30,7 @@ GateGenericSource::GateGenericSource() : GateVSource() {
   fDirectionRelativeToAttachedVolume = false;
   fUserParticleLifeTime = -1;
   fBackToBackMode = false;
+  fBatchSize = 1;
 }
 
 GateGenericSource::~GateGenericSource() {
@@ -67,8 +69,7 @@ void GateGenericSource::SetProbabilityCDF(const std::vector<double> &cdf) {
 
 void GateGenericSource::SetTAC(const std::vector<double> &times,
                                const std::vector<double> &activities) {
-  fTAC_Times = times;
-  fTAC_Activities = activities;
+  fTAC = GateTimeActivityCurve::Get(times, activities);
 }
 
 void GateGenericSource::InitializeUserInfo(py::dict &user_info) {
@@ -93,36 +94,34 @@ void GateGenericSource::InitializeUserInfo(py::dict &user_info) {
   // init number of events
   fDirectionRelativeToAttachedVolume =
       DictGetBool(user_info, "direction_relative_to_attached_volume");
+
+  // batch of primaries
+  fBatchSize = DictGetInt(user_info, "batch_size");
 }
 
 void GateGenericSource::UpdateActivity(double time) {
-  if (!fTAC_Times.empty())
+  if (fTAC != nullptr)
     return UpdateActivityWithTAC(time);
   GateVSource::UpdateActivity(time);
 }
 
 void GateGenericSource::UpdateActivityWithTAC(double time) {
-  // Below/above the TAC ?
-  if (time < fTAC_Times.front() || time > fTAC_Times.back()) {
-    fActivity = 0;
-    return;
-  }
-
-  // Search for the time bin
-  auto lower = std::lower_bound(fTAC_Times.begin(), fTAC_Times.end(), time);
-  auto i = std::distance(fTAC_Times.begin(), lower);
-
-  // Last element ?
-  if (i >= fTAC_Times.size() - 1) {
-    fActivity = fTAC_Activities.back();
-    return;
-  }
+  // (zero below/above the TAC)
+  auto &ll = GetThreadLocalDataGenericSource();
+  fActivity = fTAC->GetActivity(time, ll.fTACCursor);
+}
 
-  // linear interpolation
-  double bin_time = fTAC_Times[i + 1] - fTAC_Times[i];
-  double w1 = (time - fTAC_Times[i]) / bin_time;
-  double w2 = (fTAC_Times[i + 1] - time) / bin_time;
-  fActivity = fTAC_Activities[i] * w1 + fTAC_Activities[i + 1] * w2;
+double GateGenericSource::SampleNextEventTime(double time) {
+  if (fTAC == nullptr)
+    return CalcNextTime(time);
+  // exact inhomogeneous Poisson process: inversion of the integral of the
+  // TAC, instead of the activity at the current time (-1 if no more decay)
+  auto &ll = GetThreadLocalDataGenericSource();
+  double next_time =
+      fTAC->SampleNextTime(time, G4UniformRand(), ll.fTACCursor);
+  if (next_time < 0)
+    return fEndTime;
+  return next_time;
 }
 
 double GateGenericSource::PrepareNextTime(double current_simulation_time) {
@@ -133,11 +132,7 @@ double GateGenericSource::PrepareNextTime(double current_simulation_time) {
     ll.fEffectiveEventTime = current_simulation_time;
   }
   UpdateActivity(ll.fEffectiveEventTime);
-  fTotalSkippedEvents += ll.fCurrentSkippedEvents; // FIXME lock ?
-  fTotalZeroEvents += ll.fCurrentZeroEvents;
-  ll.fCurrentZeroEvents = 0;
-  auto cse = ll.fCurrentSkippedEvents;
-  ll.fCurrentSkippedEvents = 0;
+  auto cse = CollectEventCounters();
 
   // if MaxN is below zero, we check the time
   if (fMaxN <= 0) {
@@ -146,8 +141,8 @@ double GateGenericSource::PrepareNextTime(double current_simulation_time) {
     if (ll.fEffectiveEventTime >= fEndTime)
       return -1;
 
-    // get next time according to current fActivity
-    double next_time = CalcNextTime(ll.fEffectiveEventTime);
+    // get next time according to current fActivity (or the TAC)
+    double next_time = SampleNextEventTime(ll.fEffectiveEventTime);
     if (next_time >= fEndTime)
       return -1;
     return next_time;
@@ -161,6 +156,27 @@ double GateGenericSource::PrepareNextTime(double current_simulation_time) {
   return fStartTime;
 }
 
+unsigned long GateGenericSource::CollectEventCounters() {
+  // (called for each event: the shared totals are only updated when needed)
+  auto &ll = GetThreadLocalDataGenericSource();
+  if (ll.fCurrentSkippedEvents > 0)
+    fTotalSkippedEvents += ll.fCurrentSkippedEvents;
+  if (ll.fCurrentZeroEvents > 0)
+    fTotalZeroEvents += ll.fCurrentZeroEvents;
+  ll.fCurrentZeroEvents = 0;
+  auto cse = ll.fCurrentSkippedEvents;
+  ll.fCurrentSkippedEvents = 0;
+  return cse;
+}
+
+bool GateGenericSource::CanShareTimeProfile() const {
+  return fMaxN == 0 && fTAC == nullptr && fInitialActivity > 0;
+}
+
+bool GateGenericSource::CanShareEvents() const { return fMaxN > 0; }
+
+void GateGenericSource::PrepareNextTimeInGroup() { CollectEventCounters(); }
+
 void GateGenericSource::PrepareNextRun() {
   // The following function computes the global transformation from
   // the local volume (mother) to the world
@@ -198,6 +214,12 @@ void GateGenericSource::PrepareNextRun() {
     ang->SetFocusPoint(new_f);
     ang->fDirectionRelativeToAttachedVolume = false;
   }
+
+  // samplers of this run (a confined position is sampled by the SPS)
+  ll.fSPS->SelectSamplers(fConfineVolume.empty());
+
+  // the primaries of the previous run are in the previous coordinate system
+  ll.fBatch.Clear();
 }
 
 void GateGenericSource::UpdateEffectiveEventTime(
@@ -206,12 +228,20 @@ void GateGenericSource::UpdateEffectiveEventTime(
   unsigned long n = 0;
   ll.fEffectiveEventTime = current_simulation_time;
   while (n < skipped_particle) {
-    ll.fEffectiveEventTime =
-        ll.fEffectiveEventTime - log(G4UniformRand()) * (1.0 / fActivity);
+    ll.fEffectiveEventTime = SampleNextEventTime(ll.fEffectiveEventTime);
     n++;
   }
 }
 
+bool GateGenericSource::GeneratePrimaryBatch(GatePrimaryBatch &batch,
+                                             size_t n) {
+  auto &ll = GetThreadLocalDataGenericSource();
+  if (!ll.fSPS->CanGenerateBatch() || ll.fAAManager->IsEnabled())
+    return false;
+  ll.fSPS->GenerateBatch(batch, n);
+  return true;
+}
+
 void GateGenericSource::GeneratePrimaries(G4Event *event,
                                           double current_simulation_time) {
   auto &ll = GetThreadLocalDataGenericSource();
@@ -233,10 +263,20 @@ void GateGenericSource::GeneratePrimaries(G4Event *event,
     ll.fInitConfine = false;
   }
 
+  // the primaries may be generated in advance, by batch
+  bool from_batch = false;
+  if (fBatchSize > 1) {
+    from_batch = !ll.fBatch.IsEmpty() ||
+                 GeneratePrimaryBatch(ll.fBatch, fBatchSize);
+  }
+
   // sample the particle properties with SingleParticleSource
   // (acceptance angle is included)
   ll.fSPS->SetParticleTime(current_simulation_time);
-  ll.fSPS->GeneratePrimaryVertex(event);
+  if (from_batch)
+    ll.fSPS->GeneratePrimaryVertexFromBatch(event, ll.fBatch);
+  else
+    ll.fSPS->GeneratePrimaryVertex(event);
 
   // update the time according to skipped events
   ll.fEffectiveEventTime = current_simulation_time;
@@ -294,6 +334,31 @@ void GateGenericSource::InitializeParticle(py::dict &user_info) {
   }
   ll.fSPS->SetParticleDefinition(fParticleDefinition);
   SetLifeTime(fParticleDefinition);
+  // Precomputed decay of an ion (the particle is the e+)
+  if (!DictGetVecDict(user_info, "decay_branches").empty())
+    InitializeDecayBranches(user_info);
+}
+
+void GateGenericSource::InitializeDecayBranches(py::dict &user_info) {
+  auto &ll = fThreadLocalDataGenericSource.Get();
+  std::vector<GateSingleParticleSource::DecayBranch> branches;
+  double total = 0;
+  for (auto &d : DictGetVecDict(user_info, "decay_branches")) {
+    GateSingleParticleSource::DecayBranch b;
+    b.fProbability = DictGetDouble(d, "probability");
+    b.fParticle = DictGetBool(d, "positron");
+    b.fGammaEnergies = DictGetVecDouble(d, "gammas");
+    total += b.fProbability;
+    branches.push_back(b);
+  }
+  if (total <= 0)
+    Fatal("The decay branches of the source " + fName + " are empty");
+  ll.fSPS->SetDecayBranches(branches);
+  // ! important !
+  // The activity is the one of the radionuclide: only the fraction of the
+  // decays with an emission is simulated
+  fActivity *= total;
+  fInitialActivity = fActivity;
 }
 
 void GateGenericSource::InitializeIon(py::dict &user_info) {
@@ -315,6 +380,10 @@ void GateGenericSource::InitializeBackToBackMode(py::dict &user_info) {
     double accolinearityFWHM = DictGetDouble(u, "accolinearity_fwhm");
     ll.fSPS->SetAccolinearityFWHM(accolinearityFWHM);
   }
+  // positron range kernel (probability, k1, k2), computed on the python side
+  auto kernel = DictGetVecDouble(user_info, "positron_range_kernel");
+  if (kernel.size() == 3)
+    ll.fSPS->SetPositronRange(kernel[0], kernel[1], kernel[2]);
   // this is photon
   auto *particle_table = G4ParticleTable::GetParticleTable();
   fParticleDefinition = particle_table->FindParticle("gamma");
@@ -405,8 +474,8 @@ void GateGenericSource::InitializeDirection(py::dict puser_info) {
   auto *ang = ll.fSPS->GetAngDist();
   auto ang_type = DictGetStr(user_info, "type");
   fangType = ang_type;
-  std::vector<std::string> llt = {"iso", "histogram", "momentum", "focused",
-                                  "beam2d"};
+  std::vector<std::string> llt = {"iso",     "histogram", "histogram2d",
+                                  "momentum", "focused",   "beam2d"};
   CheckIsIn(ang_type, llt);
 
   if (ang_type == "iso") {
@@ -474,13 +543,37 @@ void GateGenericSource::InitializeDirection(py::dict puser_info) {
       ang->UserDefAngPhi({phi_e[i], phi_w[i - 1], 0});
   }
 
+  if (ang_type == "histogram2d") {
+    // (theta, phi) bins sampled with alias tables, see SetHistogram2D
+    ang->SetAngDistType("user");
+    auto theta_e = DictGetVecDouble(user_info, "histogram2d_theta_angles");
+    auto phi_e = DictGetVecDouble(user_info, "histogram2d_phi_angles");
+    // 2D (theta, phi) or 3D (energy, theta, phi) weights, flattened
+    auto w = py::array_t<double, py::array::c_style | py::array::forcecast>(
+        user_info["histogram2d_weights"]);
+    std::vector<double> weights(w.data(), w.data() + w.size());
+    ang->SetHistogram2D(theta_e, phi_e, weights, ll.fSPS->GetEneDist());
+  }
+
   // set the angle acceptance volume if needed
-  auto d = py::dict(puser_info["direction"]);
-  auto dd = py::dict(d["acceptance_angle"]);
   auto is_valid_type =
       ang->GetDistType() == "iso" || ang->GetDistType() == "user";
   ll.fAAManager = new GateAcceptanceAngleTesterManager;
-  ll.fAAManager->Initialize(dd, is_valid_type);
+  InitializeAcceptanceAngle(puser_info, is_valid_type);
+}
+
+void GateGenericSource::InitializeAcceptanceAngle(py::dict &user_info,
+                                                  bool is_valid_type) {
+  // The master thread initializes the sources first (and again for a new
+  // job in server mode): the workers use its configuration
+  if (G4Threading::IsMasterThread() || fAAConfig == nullptr) {
+    auto d = py::dict(user_info["direction"]);
+    auto dd = py::dict(d["acceptance_angle"]);
+    fAAConfig =
+        GateAcceptanceAngleTesterManager::ParseConfig(dd, is_valid_type);
+  }
+  auto &ll = GetThreadLocalDataGenericSource();
+  ll.fAAManager->Initialize(fAAConfig);
   ll.fSPS->SetAAManager(ll.fAAManager);
 }
 
@@ -657,6 +750,9 @@ void GateGenericSource::InitializeEnergy(py::dict puser_info) {
     ene->fProbabilityCDF = fProbabilityCDF;
     // CDF should be set from py side
   }
+
+  // alias/guide/inverse CDF tables, built once (not for each particle)
+  ene->InitializeSamplingTables();
 }
 
 void GateGenericSource::SetLifeTime(G4ParticleDefinition *p) {
@@ -10,7 +10,9 @@
 
 #include "GateAcceptanceAngleTesterManager.h"
 #include "GateSingleParticleSource.h"
+#include "GateTimeActivityCurve.h"
 #include "GateVSource.h"
+#include <atomic>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -28,10 +30,23 @@ public:
 
   double PrepareNextTime(double current_simulation_time) override;
 
+  // Activity sources without TAC may share a Poisson process
+  bool CanShareTimeProfile() const override;
+
+  bool CanShareEvents() const override;
+
+  void PrepareNextTimeInGroup() override;
+
   void PrepareNextRun() override;
 
+  // (PrepareNextRun only updates the transform, see the derived sources)
+  void UpdateTransformOfAttachedVolume() override { PrepareNextRun(); }
+
   void GeneratePrimaries(G4Event *event, double time) override;
 
+  // Without acceptance angle (and not for pencil beams)
+  bool GeneratePrimaryBatch(GatePrimaryBatch &batch, size_t n) override;
+
   void SetEnergyCDF(const std::vector<double> &cdf);
 
   void SetProbabilityCDF(const std::vector<double> &cdf);
@@ -45,6 +60,10 @@ public:
   unsigned long GetTotalZeroEvents() const;
 
 protected:
+  // Sum the skipped and zero events of the last event, return the number
+  // of skipped events
+  unsigned long CollectEventCounters();
+
   //  We cannot not use a std::unique_ptr
   //  (or maybe by controlling the deletion during the CleanWorkerThread ?)
   G4ParticleDefinition *fParticleDefinition;
@@ -54,11 +73,13 @@ protected:
   G4String fangType;
   double fUserParticleLifeTime;
 
-  // Time Curve Activity
-  std::vector<double> fTAC_Times;
-  std::vector<double> fTAC_Activities;
+  // Time Curve Activity (shared by the sources with the same TAC)
+  std::shared_ptr<const GateTimeActivityCurve> fTAC;
   void UpdateActivityWithTAC(double time);
 
+  // Time of the next event after this time (TAC or current activity)
+  double SampleNextEventTime(double time);
+
   // generic ion is controlled separately
   // (maybe initialized once Run is started)
   // bool fInitGenericIon;
@@ -71,6 +92,9 @@ protected:
   // back to back source
   bool fBackToBackMode;
 
+  // number of primaries generated at once (1 = one per event)
+  int fBatchSize;
+
   // Force the rotation of momentum and focal point to follow rotation of the
   // source, eg: needed for motion actor
   bool fDirectionRelativeToAttachedVolume;
@@ -82,14 +106,23 @@ protected:
     bool fInitConfine = false;
     bool fInitGenericIon = false;
     double fEffectiveEventTime = -1;
+    size_t fTACCursor = 0;
     unsigned long fCurrentSkippedEvents = 0;
     unsigned long fCurrentZeroEvents = 0;
+    GatePrimaryBatch fBatch;
   };
   G4Cache<threadLocalGenericSource> fThreadLocalDataGenericSource;
 
-  // sum of all threads
-  unsigned long fTotalSkippedEvents = 0;
-  unsigned long fTotalZeroEvents = 0;
+  // Acceptance angle configuration, parsed by the master thread and shared
+  // (read only) by the workers
+  GateAcceptanceAngleTesterManager::ConfigPointer fAAConfig;
+
+  // Set the acceptance angle manager of the thread
+  void InitializeAcceptanceAngle(py::dict &user_info, bool is_valid_type);
+
+  // sum of all threads (the threads only add their counts when not zero)
+  std::atomic<unsigned long> fTotalSkippedEvents{0};
+  std::atomic<unsigned long> fTotalZeroEvents{0};
 
   threadLocalGenericSource &GetThreadLocalDataGenericSource();
 
@@ -107,6 +140,8 @@ protected:
 
   virtual void InitializeIon(py::dict &user_info);
 
+  virtual void InitializeDecayBranches(py::dict &user_info);
+
   virtual void SetLifeTime(G4ParticleDefinition *p);
 
   virtual void InitializePosition(py::dict user_info);
@@ -8,6 +8,64 @@
 #include "GateHelpersDict.h"
 #include "GateHelpers.h"
 
+namespace {
+
+// snapshot used by the DictGet functions of the thread (if any)
+thread_local GateUserInfoSnapshot *tSnapshot = nullptr;
+thread_local bool tReplay = false;
+
+template <class T, class F>
+T DictGetCached(py::dict &user_info, const std::string &key, F convert) {
+  if (tSnapshot == nullptr)
+    return convert();
+  return tSnapshot->Get<T>(user_info, key, tReplay, convert);
+}
+
+// float(str(x)) for the python and numpy floats and the ints is float(x):
+// no conversion to a string (the other values, e.g. float32, keep the
+// string conversion)
+double ToDouble(const py::handle &x) {
+  auto o = py::reinterpret_borrow<py::object>(x);
+  if (PyFloat_Check(o.ptr()) || PyLong_Check(o.ptr()))
+    return py::float_(o);
+  return py::float_(py::str(o));
+}
+
+std::vector<double> ToVecDouble(const py::object &o) {
+  // (contiguous float64 array: a single copy)
+  if (py::isinstance<py::array_t<double>>(o)) {
+    auto a = py::array_t<double, py::array::c_style>::ensure(o);
+    if (a && a.ndim() == 1)
+      return {a.data(), a.data() + a.size()};
+  }
+  std::vector<double> l;
+  auto com = py::list(o);
+  l.reserve(com.size());
+  for (auto x : com)
+    l.push_back(ToDouble(x));
+  return l;
+}
+
+} // namespace
+
+GateUserInfoSnapshot::~GateUserInfoSnapshot() {
+  py::gil_scoped_acquire gil;
+  fDictRefs.clear();
+}
+
+GateUserInfoSnapshotScope::GateUserInfoSnapshotScope(
+    GateUserInfoSnapshot *snapshot, bool replay) {
+  fPreviousSnapshot = tSnapshot;
+  fPreviousReplay = tReplay;
+  tSnapshot = snapshot;
+  tReplay = replay;
+}
+
+GateUserInfoSnapshotScope::~GateUserInfoSnapshotScope() {
+  tSnapshot = fPreviousSnapshot;
+  tReplay = fPreviousReplay;
+}
+
 void DictCheckKey(py::dict &user_info, const std::string &key) {
   if (user_info.contains(key.c_str()))
     return;
@@ -19,25 +77,24 @@ void DictCheckKey(py::dict &user_info, const std::string &key) {
 
 std::vector<std::vector<double>> DictGetVecofVecDouble(py::dict &user_info,
                                                        const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<std::vector<double>> vec;
-  auto com = py::list(user_info[key.c_str()]);
-
-  for (auto x : com) {
-    std::vector<double> l;
-    for (auto y : x) {
-      l.push_back(py::float_(py::str(y)));
-    }
-    vec.push_back(l);
-  }
-  return vec;
+  return DictGetCached<std::vector<std::vector<double>>>(
+      user_info, key, [&] {
+        DictCheckKey(user_info, key);
+        std::vector<std::vector<double>> vec;
+        auto com = py::list(user_info[key.c_str()]);
+        for (auto x : com)
+          vec.push_back(ToVecDouble(py::reinterpret_borrow<py::object>(x)));
+        return vec;
+      });
 }
 
 G4ThreeVector DictGetG4ThreeVector(py::dict &user_info,
                                    const std::string &key) {
-  DictCheckKey(user_info, key);
-  auto x = py::list(user_info[key.c_str()]);
-  return {py::float_(x[0]), py::float_(x[1]), py::float_(x[2])};
+  return DictGetCached<G4ThreeVector>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    auto x = py::list(user_info[key.c_str()]);
+    return G4ThreeVector(py::float_(x[0]), py::float_(x[1]), py::float_(x[2]));
+  });
 }
 
 py::array_t<double> DictGetMatrix(py::dict &user_info, const std::string &key) {
@@ -54,8 +111,10 @@ py::array_t<double> DictGetMatrix(py::dict &user_info, const std::string &key) {
 
 G4RotationMatrix DictGetG4RotationMatrix(py::dict &user_info,
                                          const std::string &key) {
-  auto m = DictGetMatrix(user_info, key);
-  return ConvertToG4RotationMatrix(m);
+  return DictGetCached<G4RotationMatrix>(user_info, key, [&] {
+    auto m = DictGetMatrix(user_info, key);
+    return ConvertToG4RotationMatrix(m);
+  });
 }
 
 G4RotationMatrix ConvertToG4RotationMatrix(py::array_t<double> &rotation) {
@@ -72,55 +131,69 @@ G4RotationMatrix ConvertToG4RotationMatrix(py::array_t<double> &rotation) {
 }
 
 bool DictGetBool(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  return py::bool_(user_info[key.c_str()]);
+  return DictGetCached<bool>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    return static_cast<bool>(py::bool_(user_info[key.c_str()]));
+  });
 }
 
 double DictGetDouble(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  return py::float_(user_info[key.c_str()]);
+  return DictGetCached<double>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    return static_cast<double>(py::float_(user_info[key.c_str()]));
+  });
 }
 
 int DictGetInt(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  return py::int_(user_info[key.c_str()]);
+  return DictGetCached<int>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    return static_cast<int>(py::int_(user_info[key.c_str()]));
+  });
 }
 
 std::string DictGetStr(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  return py::str(user_info[key.c_str()]);
+  return DictGetCached<std::string>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    return static_cast<std::string>(py::str(user_info[key.c_str()]));
+  });
 }
 
 std::vector<std::string> DictGetVecStr(py::dict &user_info,
                                        const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<std::string> l;
-  auto com = py::list(user_info[key.c_str()]);
-  for (auto x : com) {
-    l.push_back(std::string(py::str(x)));
-  }
-  return l;
+  return DictGetCached<std::vector<std::string>>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    std::vector<std::string> l;
+    auto com = py::list(user_info[key.c_str()]);
+    for (auto x : com) {
+      l.push_back(std::string(py::str(x)));
+    }
+    return l;
+  });
 }
 
 std::vector<double> DictGetVecDouble(py::dict &user_info,
                                      const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<double> l;
-  auto com = py::list(user_info[key.c_str()]);
-  for (auto x : com) {
-    l.push_back(py::float_(py::str(x)));
-  }
-  return l;
+  return DictGetCached<std::vector<double>>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    return ToVecDouble(user_info[key.c_str()]);
+  });
 }
 
 std::vector<int> DictGetVecInt(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<int> l;
-  auto com = py::list(user_info[key.c_str()]);
-  for (auto x : com) {
-    l.push_back(py::int_(py::str(x)));
-  }
-  return l;
+  return DictGetCached<std::vector<int>>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    std::vector<int> l;
+    auto com = py::list(user_info[key.c_str()]);
+    l.reserve(com.size());
+    for (auto x : com) {
+      // (no conversion to a string for the python ints)
+      if (PyLong_Check(x.ptr()))
+        l.push_back(py::int_(py::reinterpret_borrow<py::object>(x)));
+      else
+        l.push_back(py::int_(py::str(x)));
+    }
+    return l;
+  });
 }
 
 std::vector<py::dict> DictGetVecDict(py::dict &user_info,
@@ -145,31 +218,35 @@ std::vector<py::list> DictGetVecList(py::dict &user_info,
 
 std::vector<G4ThreeVector> DictGetVecG4ThreeVector(py::dict &user_info,
                                                    const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<G4ThreeVector> l;
-  auto com = py::list(user_info[key.c_str()]);
-  for (auto a : com) {
-    auto x = a.cast<py::list>();
-    double xx = py::float_(x[0]);
-    double yy = py::float_(x[1]);
-    double zz = py::float_(x[2]);
-    G4ThreeVector v(xx, yy, zz);
-    l.push_back(v);
-  }
-  return l;
+  return DictGetCached<std::vector<G4ThreeVector>>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    std::vector<G4ThreeVector> l;
+    auto com = py::list(user_info[key.c_str()]);
+    for (auto a : com) {
+      auto x = a.cast<py::list>();
+      double xx = py::float_(x[0]);
+      double yy = py::float_(x[1]);
+      double zz = py::float_(x[2]);
+      G4ThreeVector v(xx, yy, zz);
+      l.push_back(v);
+    }
+    return l;
+  });
 }
 
 std::vector<G4RotationMatrix>
 DictGetVecG4RotationMatrix(py::dict &user_info, const std::string &key) {
-  DictCheckKey(user_info, key);
-  std::vector<G4RotationMatrix> l;
-  auto com = py::list(user_info[key.c_str()]);
-  for (auto a : com) {
-    auto m = a.cast<py::array_t<double>>();
-    auto ar = ConvertToG4RotationMatrix(m);
-    l.push_back(ar);
-  }
-  return l;
+  return DictGetCached<std::vector<G4RotationMatrix>>(user_info, key, [&] {
+    DictCheckKey(user_info, key);
+    std::vector<G4RotationMatrix> l;
+    auto com = py::list(user_info[key.c_str()]);
+    for (auto a : com) {
+      auto m = a.cast<py::array_t<double>>();
+      auto ar = ConvertToG4RotationMatrix(m);
+      l.push_back(ar);
+    }
+    return l;
+  });
 }
 
 bool IsIn(const std::string &s, std::vector<std::string> &v) {
@@ -10,12 +10,72 @@
 
 #include <G4RotationMatrix.hh>
 #include <G4ThreeVector.hh>
+#include <any>
+#include <atomic>
 #include <iostream>
+#include <map>
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
+#include <set>
+#include <tuple>
+#include <typeindex>
 
 namespace py = pybind11;
 
+/*
+ * Snapshot of the values read by an InitializeUserInfo, e.g. the one of a
+ * source, that is called once per thread with the same user info.
+ *
+ * While a GateUserInfoSnapshotScope is alive in a thread, the DictGet
+ * functions that return C++ values (not the ones that return Python objects)
+ * go through the snapshot: the first initialization (master thread) records
+ * the converted values, the next ones (worker threads) read them back,
+ * without casting the Python objects again. The snapshot is then only read,
+ * by all the workers at the same time.
+ *
+ * A value is identified by the address of its dict (the dicts are kept
+ * alive by the snapshot), its key and its C++ type, so the user info must
+ * not change between the initializations of the threads. A value that has
+ * not been recorded is converted as usual.
+ */
+class GateUserInfoSnapshot {
+public:
+  template <class T, class F>
+  T Get(py::dict &user_info, const std::string &key, bool replay, F convert);
+
+  size_t GetNumberOfValues() const { return fValues.size(); }
+
+  // Number of values read back from the snapshot (all threads)
+  long GetNumberOfReplayedValues() const { return fNumberOfReplayedValues; }
+
+  // The dicts are released with the GIL
+  ~GateUserInfoSnapshot();
+
+protected:
+  typedef std::tuple<PyObject *, std::string, std::type_index> Key;
+  std::map<Key, std::any> fValues;
+  std::set<PyObject *> fDicts;
+  std::vector<py::dict> fDictRefs;
+  std::atomic<long> fNumberOfReplayedValues{0};
+};
+
+// Use the snapshot (if not null) for the DictGet functions of the thread,
+// recording (first thread) or replaying (next threads) the values
+class GateUserInfoSnapshotScope {
+public:
+  GateUserInfoSnapshotScope(GateUserInfoSnapshot *snapshot, bool replay);
+
+  ~GateUserInfoSnapshotScope();
+
+  GateUserInfoSnapshotScope(const GateUserInfoSnapshotScope &) = delete;
+  GateUserInfoSnapshotScope &
+  operator=(const GateUserInfoSnapshotScope &) = delete;
+
+protected:
+  GateUserInfoSnapshot *fPreviousSnapshot;
+  bool fPreviousReplay;
+};
+
 void DictCheckKey(py::dict &user_info, const std::string &key);
 
 void CheckIsIn(const std::string &s, std::vector<std::string> &v);
@@ -70,4 +130,23 @@ double StrToDouble(std::string &s);
 
 G4ThreeVector StrToG4ThreeVector(std::string &s);
 
+template <class T, class F>
+T GateUserInfoSnapshot::Get(py::dict &user_info, const std::string &key,
+                            bool replay, F convert) {
+  Key k(user_info.ptr(), key, std::type_index(typeid(T)));
+  if (replay) {
+    // (read only: the workers share the snapshot)
+    auto it = fValues.find(k);
+    if (it == fValues.end())
+      return convert();
+    fNumberOfReplayedValues++;
+    return std::any_cast<const T &>(it->second);
+  }
+  T value = convert();
+  if (fDicts.insert(user_info.ptr()).second)
+    fDictRefs.push_back(user_info);
+  fValues[k] = value;
+  return value;
+}
+
 #endif // OPENGATE_CORE_OPENGATEHELPERSDICT_H
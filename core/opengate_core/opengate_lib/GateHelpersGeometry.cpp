@@ -5,16 +5,28 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include "G4AutoLock.hh"
 #include "GateHelpersImage.h"
+#include "GateMutex.h"
+#include <atomic>
+#include <unordered_map>
 
-void ComputeTransformationFromVolumeToWorld(const std::string &phys_volume_name,
-                                            G4ThreeVector &translation,
-                                            G4RotationMatrix &rotation,
-                                            bool initialize) {
-  if (initialize) {
-    translation = {0, 0, 0};
-    rotation = G4RotationMatrix::IDENTITY;
-  }
+namespace {
+
+struct VolumeTransform {
+  G4ThreeVector fTranslation;
+  G4RotationMatrix fRotation;
+};
+
+GATE_MUTEX(VolumeTransformCacheMutex);
+std::unordered_map<std::string, VolumeTransform> VolumeTransformCache;
+std::atomic<unsigned long> VolumeTransformCacheVersion(0);
+
+// Walk up the volume tree, return false if the transform must not be cached
+bool WalkTransformationFromVolumeToWorld(const std::string &phys_volume_name,
+                                         G4ThreeVector &translation,
+                                         G4RotationMatrix &rotation) {
+  bool cacheable = true;
   std::string name = phys_volume_name;
   auto pvs = G4PhysicalVolumeStore::GetInstance();
   while (name != "world") {
@@ -30,6 +42,9 @@ void ComputeTransformationFromVolumeToWorld(const std::string &phys_volume_name,
       oss << std::endl;
       Fatal(oss.str());
     }
+    // (the transform of a parameterised volume is the one of its last copy)
+    if (phys->IsParameterised() || phys->IsReplicated())
+      cacheable = false;
     auto tr = phys->GetObjectTranslation();
     // auto rot = *phys->GetObjectRotation();
     auto rot = phys->GetObjectRotationValue();
@@ -41,6 +56,50 @@ void ComputeTransformationFromVolumeToWorld(const std::string &phys_volume_name,
     else
       name = phys->GetMotherLogical()->GetName();
   }
+  return cacheable;
+}
+
+} // namespace
+
+void InvalidateVolumeTransformCache() {
+  GateAutoLock mutex(&VolumeTransformCacheMutex);
+  VolumeTransformCache.clear();
+  VolumeTransformCacheVersion++;
+}
+
+unsigned long GetVolumeTransformCacheVersion() {
+  return VolumeTransformCacheVersion.load();
+}
+
+void ComputeTransformationFromVolumeToWorld(const std::string &phys_volume_name,
+                                            G4ThreeVector &translation,
+                                            G4RotationMatrix &rotation,
+                                            bool initialize) {
+  VolumeTransform t;
+  bool found = false;
+  {
+    GateAutoLock mutex(&VolumeTransformCacheMutex);
+    auto it = VolumeTransformCache.find(phys_volume_name);
+    if (it != VolumeTransformCache.end()) {
+      t = it->second;
+      found = true;
+    }
+  }
+  if (!found) {
+    if (WalkTransformationFromVolumeToWorld(phys_volume_name, t.fTranslation,
+                                            t.fRotation)) {
+      GateAutoLock mutex(&VolumeTransformCacheMutex);
+      VolumeTransformCache[phys_volume_name] = t;
+    }
+  }
+  // volume to world, after the given transform
+  if (initialize) {
+    translation = t.fTranslation;
+    rotation = t.fRotation;
+  } else {
+    translation = t.fRotation * translation + t.fTranslation;
+    rotation = t.fRotation * rotation;
+  }
 }
 
 void ComputeTransformationFromWorldToVolume(const std::string &phys_volume_name,
@@ -12,6 +12,8 @@
 #include "G4PhysicalVolumeStore.hh"
 #include "GateHelpers.h"
 
+// Transform of the volume to world, composed with the given one (or alone
+// if initialize)
 void ComputeTransformationFromVolumeToWorld(const std::string &phys_volume_name,
                                             G4ThreeVector &translation,
                                             G4RotationMatrix &rotation,
@@ -22,4 +24,12 @@ void ComputeTransformationFromWorldToVolume(const std::string &phys_volume_name,
                                             G4RotationMatrix &rotation,
                                             bool initialize = false);
 
+// The volume to world transforms are cached by volume name (except through
+// parameterised or replicated volumes). The cache must be invalidated when
+// the geometry is built or moved (e.g. by the dynamic geometry changers).
+void InvalidateVolumeTransformCache();
+
+// Number of invalidations of the cache: it changes when the volumes move
+unsigned long GetVolumeTransformCacheVersion();
+
 #endif // OPENGATE_CORE_OPENGATEHELPERSGEOMETRY_H
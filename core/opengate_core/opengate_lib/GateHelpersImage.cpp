@@ -6,3 +6,74 @@
    -------------------------------------------------- */
 
 #include "GateHelpersImage.h"
+#include "G4AutoLock.hh"
+#include "GateMutex.h"
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace {
+GATE_MUTEX(IndexTransformIdMutex);
+}
+
+HitType StrToHitType(const std::string &hit_type) {
+  if (hit_type == "pre")
+    return HitType::Pre;
+  if (hit_type == "post")
+    return HitType::Post;
+  if (hit_type == "middle")
+    return HitType::Middle;
+  if (hit_type == "random")
+    return HitType::Random;
+  if (hit_type == "segment")
+    return HitType::Segment;
+  std::ostringstream oss;
+  oss << "Error: unknown hit_type. Must be 'pre', 'post', 'middle', "
+         "'random' or 'segment' while '"
+      << hit_type << "' is read.";
+  Fatal(oss.str());
+  return HitType::Post;
+}
+
+bool GateImageIndexTransform::HasSameGeometry(
+    const GateImageIndexTransform &t) const {
+  for (auto i = 0; i < 3; i++) {
+    if (fOrigin[i] != t.fOrigin[i] || fStart[i] != t.fStart[i] ||
+        fEnd[i] != t.fEnd[i])
+      return false;
+    for (auto j = 0; j < 3; j++)
+      if (fMatrix[i][j] != t.fMatrix[i][j])
+        return false;
+  }
+  return true;
+}
+
+double GateImageIndexTransform::DistanceToExit(
+    const G4ThreeVector &point, const G4ThreeVector &direction) const {
+  // the image is [start - 0.5, end - 0.5[ in continuous index
+  double c[3];
+  TransformPointToContinuousIndex(point, c);
+  auto t = std::numeric_limits<double>::infinity();
+  for (auto i = 0; i < 3; i++) {
+    const auto d = fMatrix[i][0] * direction[0] +
+                   fMatrix[i][1] * direction[1] +
+                   fMatrix[i][2] * direction[2];
+    if (d > 0)
+      t = std::min(t, (fEnd[i] - 0.5 - c[i]) / d);
+    else if (d < 0)
+      t = std::min(t, (fStart[i] - 0.5 - c[i]) / d);
+  }
+  return std::max(t, 0.0);
+}
+
+int GateImageIndexTransform::FindOrAddId(const GateImageIndexTransform &t) {
+  // all the geometries seen so far (a few, one per scored volume)
+  GateAutoLock mutex(&IndexTransformIdMutex);
+  static std::vector<GateImageIndexTransform> geometries;
+  for (size_t i = 0; i < geometries.size(); i++)
+    if (geometries[i].HasSameGeometry(t))
+      return static_cast<int>(i);
+  geometries.push_back(t);
+  return static_cast<int>(geometries.size() - 1);
+}
@@ -10,20 +10,102 @@
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4Step.hh"
 #include "GateHelpers.h"
+#include "GateSparseImage.h"
 #include "itkImage.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
 
 template <class ImageType>
-void ImageAddValue(typename ImageType::Pointer image,
-                   typename ImageType::IndexType index,
+void ImageAddValue(ImageType *image, typename ImageType::IndexType index,
                    typename ImageType::PixelType value);
 
+// Same as ImageAddValue, with an offset in the pixel buffer computed by the
+// caller (image->ComputeOffset(index)), e.g. once for several images that
+// share the same geometry
+template <class ImageType>
+void ImageAddValueAtOffset(ImageType *image, itk::OffsetValueType offset,
+                           typename ImageType::PixelType value);
+
+// Lock-free version of ImageAddValue: several threads may add values to the
+// same image concurrently (relaxed compare-and-swap on the pixel value)
+template <class ImageType>
+void ImageAtomicAddValue(ImageType *image, typename ImageType::IndexType index,
+                         typename ImageType::PixelType value);
+
+template <class ImageType>
+void ImageAtomicAddValueAtOffset(ImageType *image, itk::OffsetValueType offset,
+                                 typename ImageType::PixelType value);
+
+template <class T> void AtomicAddValue(T *address, T value);
+
+// Allocate the image (filled with zeros), add the values of the sparse image
+// (same size) and release its tiles
+template <class ImageType, class T>
+void AllocateImageFromSparseImage(ImageType *image,
+                                  GateSparseImage<T> &sparse);
+
 template <class ImageType>
 void AttachImageToVolume(typename ImageType::Pointer image,
                          std::string volumeName,
                          G4ThreeVector initial_translation = G4ThreeVector(),
                          G4RotationMatrix img_rotation = G4RotationMatrix());
 
+// Transform from world coordinates to the voxel index of an image, computed
+// once per run (after AttachImageToVolume) from the origin, spacing and
+// direction of the image. It gives the same index as ITK's
+// TransformPhysicalPointToIndex, with a fast path for axis-aligned images.
+class GateImageIndexTransform {
+public:
+  template <class ImageType> void Update(const ImageType *image);
+
+  template <class IndexType>
+  inline bool TransformPointToIndex(const G4ThreeVector &point,
+                                    IndexType &index) const;
+
+  // Call f(index, fraction) for each voxel crossed by the segment [a, b],
+  // fraction being the part of the segment length inside this voxel
+  // (Amanatides-Woo traversal, parts outside the image are skipped)
+  template <class IndexType, class F>
+  void ForEachVoxelOnSegment(const G4ThreeVector &a, const G4ThreeVector &b,
+                             F f) const;
+
+  // Distance from the point along the unit direction to the boundary of the
+  // image (0 if the point is outside)
+  double DistanceToExit(const G4ThreeVector &point,
+                        const G4ThreeVector &direction) const;
+
+  // Same id for the transforms of the images with the same geometry (e.g.
+  // several actors attached to the same volume), see GateStepContext
+  int GetId() const { return fId; }
+
+  bool HasSameGeometry(const GateImageIndexTransform &t) const;
+
+private:
+  inline void TransformPointToContinuousIndex(const G4ThreeVector &point,
+                                              double c[3]) const;
+
+  double fOrigin[3]{};
+  double fMatrix[3][3]{};
+  double fStart[3]{};
+  double fEnd[3]{};
+  bool fAxisAligned = true;
+  int fId = -1;
+
+  static int FindOrAddId(const GateImageIndexTransform &t);
+};
+
+// Position of the step used to find the scoring voxel (hit_type option)
+// (with Segment, the quantity is spread over the voxels crossed by the step)
+enum class HitType { Pre, Post, Middle, Random, Segment };
+
+HitType StrToHitType(const std::string &hit_type);
+
+template <HitType H> G4ThreeVector GetHitPosition(const G4Step *step);
+
 #include "GateHelpersImage.txx"
 
 #endif // OPENGATE_CORE_OPENGATEHELPERSIMAGE_H
@@ -7,13 +7,54 @@
 
 #include "G4LogicalVolume.hh"
 #include "GateHelpersGeometry.h"
+#include "Randomize.hh"
 
 template<class ImageType>
-void ImageAddValue(typename ImageType::Pointer image,
-                   typename ImageType::IndexType index,
+void ImageAddValue(ImageType *image, typename ImageType::IndexType index,
                    typename ImageType::PixelType value) {
-  auto v = image->GetPixel(index); // FIXME maybe 2 x FastComputeOffset can be spared ?
-  image->SetPixel(index, v + value);
+  // single offset computation, direct access to the pixel buffer
+  ImageAddValueAtOffset<ImageType>(image, image->ComputeOffset(index), value);
+}
+
+template<class ImageType>
+void ImageAddValueAtOffset(ImageType *image, itk::OffsetValueType offset,
+                           typename ImageType::PixelType value) {
+  image->GetBufferPointer()[offset] += value;
+}
+
+template<class T>
+void AtomicAddValue(T *address, T value) {
+  // the pixel buffer is not made of std::atomic, but they share the same
+  // representation, so the value is reinterpreted as atomic for the addition
+  static_assert(sizeof(std::atomic<T>) == sizeof(T),
+                "std::atomic<T> must have the same size than T");
+  auto *a = reinterpret_cast<std::atomic<T> *>(address);
+  auto old = a->load(std::memory_order_relaxed);
+  while (!a->compare_exchange_weak(old, old + value,
+                                   std::memory_order_relaxed)) {
+    // old has been updated with the current value, try again
+  }
+}
+
+template<class ImageType, class T>
+void AllocateImageFromSparseImage(ImageType *image,
+                                  GateSparseImage<T> &sparse) {
+  image->Allocate(true);
+  sparse.AddToBuffer(image->GetBufferPointer());
+  sparse.Clear();
+}
+
+template<class ImageType>
+void ImageAtomicAddValue(ImageType *image, typename ImageType::IndexType index,
+                         typename ImageType::PixelType value) {
+  ImageAtomicAddValueAtOffset<ImageType>(image, image->ComputeOffset(index),
+                                         value);
+}
+
+template<class ImageType>
+void ImageAtomicAddValueAtOffset(ImageType *image, itk::OffsetValueType offset,
+                                 typename ImageType::PixelType value) {
+  AtomicAddValue(image->GetBufferPointer() + offset, value);
 }
 
 template<class ImageType>
@@ -53,3 +94,149 @@ void AttachImageToVolume(typename ImageType::Pointer image,
   image->SetOrigin(o);
   image->SetDirection(dir);
 }
+
+template <HitType H> G4ThreeVector GetHitPosition(const G4Step *step) {
+  auto preGlobal = step->GetPreStepPoint()->GetPosition();
+  auto postGlobal = step->GetPostStepPoint()->GetPosition();
+  if constexpr (H == HitType::Pre) {
+    return preGlobal;
+  } else if constexpr (H == HitType::Post) {
+    return postGlobal;
+  } else if constexpr (H == HitType::Middle) {
+    return preGlobal + 0.5 * (postGlobal - preGlobal);
+  } else {
+    // random position between pre and post (also used for Segment when a
+    // single position is needed)
+    auto x = G4UniformRand();
+    return preGlobal + x * (postGlobal - preGlobal);
+  }
+}
+
+template <class ImageType>
+void GateImageIndexTransform::Update(const ImageType *image) {
+  const auto &origin = image->GetOrigin();
+  const auto &m = image->GetPhysicalPointToIndexMatrix();
+  const auto &region = image->GetLargestPossibleRegion();
+  fAxisAligned = true;
+  for (auto i = 0; i < 3; i++) {
+    fOrigin[i] = origin[i];
+    fStart[i] = region.GetIndex()[i];
+    fEnd[i] = fStart[i] + region.GetSize()[i];
+    for (auto j = 0; j < 3; j++) {
+      fMatrix[i][j] = m[i][j];
+      if (i != j && m[i][j] != 0)
+        fAxisAligned = false;
+    }
+  }
+  fId = FindOrAddId(*this);
+}
+
+void GateImageIndexTransform::TransformPointToContinuousIndex(
+    const G4ThreeVector &point, double c[3]) const {
+  const double p[3] = {point[0] - fOrigin[0], point[1] - fOrigin[1],
+                       point[2] - fOrigin[2]};
+  for (auto i = 0; i < 3; i++) {
+    if (fAxisAligned) {
+      c[i] = fMatrix[i][i] * p[i];
+    } else {
+      c[i] = fMatrix[i][0] * p[0] + fMatrix[i][1] * p[1] + fMatrix[i][2] * p[2];
+    }
+  }
+}
+
+template <class IndexType>
+bool GateImageIndexTransform::TransformPointToIndex(const G4ThreeVector &point,
+                                                    IndexType &index) const {
+  double c[3];
+  TransformPointToContinuousIndex(point, c);
+  for (auto i = 0; i < 3; i++) {
+    // same rounding as itk (RoundHalfIntegerUp)
+    auto r = std::floor(c[i] + 0.5);
+    if (!(r >= fStart[i] && r < fEnd[i]))
+      return false;
+    index[i] = static_cast<typename IndexType::IndexValueType>(r);
+  }
+  return true;
+}
+
+template <class IndexType, class F>
+void GateImageIndexTransform::ForEachVoxelOnSegment(const G4ThreeVector &a,
+                                                    const G4ThreeVector &b,
+                                                    F f) const {
+  // continuous index shifted by 0.5: voxel i is [i, i+1[ along each axis
+  double ca[3], cb[3], d[3];
+  TransformPointToContinuousIndex(a, ca);
+  TransformPointToContinuousIndex(b, cb);
+  for (auto i = 0; i < 3; i++) {
+    ca[i] += 0.5;
+    cb[i] += 0.5;
+    d[i] = cb[i] - ca[i];
+  }
+
+  // a step with no length is given entirely to its voxel
+  if (d[0] == 0 && d[1] == 0 && d[2] == 0) {
+    IndexType index;
+    if (TransformPointToIndex(a, index))
+      f(index, 1.0);
+    return;
+  }
+
+  // clip the parametric segment t in [0, 1] to the image
+  double t0 = 0;
+  double t1 = 1;
+  for (auto i = 0; i < 3; i++) {
+    if (d[i] == 0) {
+      if (ca[i] < fStart[i] || ca[i] >= fEnd[i])
+        return;
+      continue;
+    }
+    auto ta = (fStart[i] - ca[i]) / d[i];
+    auto tb = (fEnd[i] - ca[i]) / d[i];
+    if (ta > tb)
+      std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+  }
+  if (t0 >= t1)
+    return;
+
+  // first voxel, then step from one voxel boundary to the next
+  constexpr auto inf = std::numeric_limits<double>::infinity();
+  IndexType index;
+  long step[3];
+  double t_max[3], t_delta[3];
+  for (auto i = 0; i < 3; i++) {
+    auto v = std::floor(ca[i] + t0 * d[i]);
+    v = std::min(std::max(v, fStart[i]), fEnd[i] - 1);
+    index[i] = static_cast<typename IndexType::IndexValueType>(v);
+    step[i] = d[i] > 0 ? 1 : -1;
+    if (d[i] == 0) {
+      t_max[i] = inf;
+      t_delta[i] = inf;
+    } else {
+      t_max[i] = (v + (d[i] > 0 ? 1 : 0) - ca[i]) / d[i];
+      t_delta[i] = std::abs(1.0 / d[i]);
+    }
+  }
+  auto t = t0;
+  while (t < t1) {
+    auto axis = 0;
+    if (t_max[1] < t_max[axis])
+      axis = 1;
+    if (t_max[2] < t_max[axis])
+      axis = 2;
+    auto t_next = std::min(t_max[axis], t1);
+    if (t_next > t) {
+      // (skip the parts only due to rounding, at the end of the segment)
+      if (t_next - t > 1e-12)
+        f(index, t_next - t);
+      t = t_next;
+    }
+    if (t >= t1)
+      break;
+    index[axis] += step[axis];
+    if (index[axis] < fStart[axis] || index[axis] >= fEnd[axis])
+      break;
+    t_max[axis] += t_delta[axis];
+  }
+}
@@ -0,0 +1,43 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateHugePages.h"
+#include "GateMemoryAccounting.h"
+#include <cstdint>
+#include <map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+std::atomic<bool> GateHugePages::fEnabled{false};
+
+void GateHugePages::Enable(bool flag) {
+  fEnabled.store(flag, std::memory_order_relaxed);
+}
+
+void GateHugePages::Advise(void *data, size_t bytes, const std::string &name) {
+  if (!IsEnabled() || data == nullptr || bytes < 2 * PageSize)
+    return;
+  // the 2 MB aligned pages inside the buffer
+  auto begin = reinterpret_cast<std::uintptr_t>(data);
+  auto first = (begin + PageSize - 1) / PageSize * PageSize;
+  auto last = (begin + bytes) / PageSize * PageSize;
+  if (last <= first)
+    return;
+  auto length = static_cast<size_t>(last - first);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (madvise(reinterpret_cast<void *>(first), length, MADV_HUGEPAGE) != 0)
+    return;
+#else
+  return;
+#endif
+  // total of the thread since the start, for each kind of buffer
+  static thread_local std::map<std::string, size_t> total;
+  total[name] += length;
+  GateMemoryAccounting::Update("huge_pages", name, total[name]);
+}
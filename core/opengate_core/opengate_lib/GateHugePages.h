@@ -0,0 +1,61 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateHugePages_h
+#define GateHugePages_h
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*
+    Optional transparent huge pages (Linux, madvise(MADV_HUGEPAGE)) for the
+    large buffers read or written at random positions during the tracking:
+    the ITK images of the actors and of the voxelized volumes (cpp images),
+    the flat mu tables and the alias tables of the voxel sources. With 2 MB
+    pages instead of 4 kB, these buffers need far fewer TLB entries.
+
+    The advice is given when the buffer is allocated, before its pages are
+    first touched; only the 2 MB aligned part of the buffer can be backed by
+    huge pages, so the buffers smaller than 4 MB are ignored. When the system
+    does not support it (or the option is off), nothing is changed.
+
+    The bytes given to the huge pages are reported by the memory accounting
+    (type "huge_pages"), as the total since the start of the simulation for
+    each kind of buffer.
+ */
+
+class GateHugePages {
+public:
+  static void Enable(bool flag);
+
+  inline static bool IsEnabled() {
+    return fEnabled.load(std::memory_order_relaxed);
+  }
+
+  // Advice for the (not yet touched) buffer, name is the kind of buffer
+  static void Advise(void *data, size_t bytes, const std::string &name);
+
+  // Allocate n elements set to value, with the advice before they are set
+  template <class T>
+  static void Assign(std::vector<T> &v, size_t n, const T &value,
+                     const std::string &name) {
+    if (IsEnabled() && v.capacity() < n) {
+      std::vector<T>().swap(v);
+      v.reserve(n);
+      Advise(v.data(), n * sizeof(T), name);
+    }
+    v.assign(n, value);
+  }
+
+  static constexpr size_t PageSize = 2 * 1024 * 1024;
+
+protected:
+  static std::atomic<bool> fEnabled;
+};
+
+#endif // GateHugePages_h
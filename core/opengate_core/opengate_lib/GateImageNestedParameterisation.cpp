@@ -12,6 +12,8 @@ GateImageNestedParameterisation::GateImageNestedParameterisation()
   // Create the image pointer
   // size and allocation will be performed on the py side
   cpp_image = ImageType::New();
+  // FIXME AIR ?? really ?
+  fOutsideMaterial = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
 }
 
 void GateImageNestedParameterisation::initialize_image() {
@@ -26,6 +28,12 @@ void GateImageNestedParameterisation::initialize_image() {
     auto zp = offset + iz * spacing_z;
     fpZ.push_back(zp * CLHEP::mm);
   }
+  const auto size = cpp_image->GetLargestPossibleRegion().GetSize();
+  for (int i = 0; i < 3; i++)
+    fSize[i] = static_cast<unsigned int>(size[i]);
+  fSizeX = size[0];
+  fSliceSize = size[0] * size[1];
+  fLabels = cpp_image->GetBufferPointer();
 }
 
 void GateImageNestedParameterisation::initialize_material(
@@ -34,9 +42,9 @@ void GateImageNestedParameterisation::initialize_material(
   for (auto s : materials) {
     auto m = G4Material::GetMaterial(s);
     if (m == nullptr) {
-      std::cout << "GateImageNestedParameterisation: cannot find the material "
-                << s << std::endl;
-      exit(0);
+      std::ostringstream oss;
+      oss << "GateImageNestedParameterisation: cannot find the material " << s;
+      Fatal(oss.str());
     }
     fMaterials.push_back(m);
   }
@@ -45,31 +53,19 @@ void GateImageNestedParameterisation::initialize_material(
 G4Material *GateImageNestedParameterisation::ComputeMaterial(
     G4VPhysicalVolume * /*currentVol*/, const G4int repNo,
     const G4VTouchable *parentTouch) {
-  if (parentTouch == nullptr) {
-    return G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
-    // FIXME AIR ?? really ?
-  }
+  if (parentTouch == nullptr)
+    return fOutsideMaterial;
 
-  // Get voxel index
-  G4int ix = parentTouch->GetReplicaNumber(0);
-  G4int iy = parentTouch->GetReplicaNumber(1);
-  G4int iz = repNo;
-  ImageType::IndexType index;
-  index[0] = ix;
-  index[1] = iy;
-  index[2] = iz;
+  // Get voxel index (negative index are large unsigned values)
+  const auto ix = static_cast<unsigned int>(parentTouch->GetReplicaNumber(0));
+  const auto iy = static_cast<unsigned int>(parentTouch->GetReplicaNumber(1));
+  const auto iz = static_cast<unsigned int>(repNo);
 
-  // Check if inside
-  if (cpp_image->GetLargestPossibleRegion().IsInside(index)) {
-    int i = int(cpp_image->GetPixel(index));
-    auto mat = fMaterials[i];
-    return mat;
-  } else {
-    // Outside the image. Should almost never be here (except rounding issue)
-    auto m =
-        G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR"); // FIXME AIR
-    return m;
-  }
+  // Check if inside. Outside the image: should almost never be here (except
+  // rounding issue)
+  if (ix >= fSize[0] || iy >= fSize[1] || iz >= fSize[2])
+    return fOutsideMaterial;
+  return fMaterials[fLabels[ix + fSizeX * iy + fSliceSize * iz]];
 }
 
 G4int GateImageNestedParameterisation::GetNumberOfMaterials() const {
@@ -47,6 +47,16 @@ public:
 
   void ComputeTransformation(const G4int no,
                              G4VPhysicalVolume *currentPV) const override;
+
+protected:
+  // buffer and size of the image (set in initialize_image): the material of
+  // the voxel is fMaterials[fLabels[ix + fSizeX * iy + fSliceSize * iz]]
+  const unsigned short *fLabels = nullptr;
+  unsigned int fSize[3] = {0, 0, 0};
+  size_t fSizeX = 0;
+  size_t fSliceSize = 0;
+  // material outside the image (looked up once)
+  G4Material *fOutsideMaterial = nullptr;
 };
 
 #endif // GateImageNestedParameterisation_h
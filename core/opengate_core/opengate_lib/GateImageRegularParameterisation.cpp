@@ -0,0 +1,55 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateImageRegularParameterisation.h"
+#include "G4Material.hh"
+#include "G4SystemOfUnits.hh"
+#include "GateHelpers.h"
+
+GateImageRegularParameterisation::GateImageRegularParameterisation()
+    : G4PhantomParameterisation() {
+  // size and allocation will be performed on the py side
+  cpp_image = ImageType::New();
+  SetSkipEqualMaterials(true);
+}
+
+void GateImageRegularParameterisation::initialize_image() {
+  const auto size = cpp_image->GetLargestPossibleRegion().GetSize();
+  const auto &spacing = cpp_image->GetSpacing();
+  SetVoxelDimensions(spacing[0] / 2.0 * CLHEP::mm, spacing[1] / 2.0 * CLHEP::mm,
+                     spacing[2] / 2.0 * CLHEP::mm);
+  SetNoVoxels(size[0], size[1], size[2]);
+  fLabels = cpp_image->GetBufferPointer();
+}
+
+void GateImageRegularParameterisation::initialize_material(
+    std::vector<std::string> materials) {
+  std::vector<G4Material *> mats;
+  for (const auto &s : materials) {
+    auto *m = G4Material::GetMaterial(s);
+    if (m == nullptr) {
+      std::ostringstream oss;
+      oss << "GateImageRegularParameterisation: cannot find the material "
+          << s;
+      Fatal(oss.str());
+    }
+    mats.push_back(m);
+  }
+  SetMaterials(mats);
+}
+
+void GateImageRegularParameterisation::initialize_container(
+    G4VSolid *container) {
+  BuildContainerSolid(container);
+}
+
+G4Material *GateImageRegularParameterisation::ComputeMaterial(
+    const G4int repNo, G4VPhysicalVolume * /*currentVol*/,
+    const G4VTouchable * /*parentTouch*/) {
+  // the copy number is the index of the voxel in the buffer
+  return fMaterials[fLabels[repNo]];
+}
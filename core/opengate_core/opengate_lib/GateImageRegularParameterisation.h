@@ -0,0 +1,57 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateImageRegularParameterisation_h
+#define GateImageRegularParameterisation_h
+
+#include "G4PhantomParameterisation.hh"
+#include "G4VSolid.hh"
+#include "itkImage.h"
+
+/*
+ * Parameterisation of an image volume for the regular navigation of Geant4
+ * (G4RegularNavigation): all the voxels are placed with one
+ * G4PVParameterised (axis kUndefined, regular structure id 1) directly in
+ * the image volume. With SetSkipEqualMaterials (on by default), the
+ * navigator does not stop at the boundaries between two voxels of the same
+ * material, a step crosses all the voxels of the same label at once.
+ *
+ * The material of a voxel is read directly in the label image buffer
+ * (copy number = ix + iy * nx + iz * nx * ny, the order of the itk buffer),
+ * the label image is not copied in a size_t index array.
+ */
+class GateImageRegularParameterisation : public G4PhantomParameterisation {
+
+public:
+  // Labels of the voxels (same type as GateImageNestedParameterisation)
+  typedef itk::Image<unsigned short, 3> ImageType;
+  ImageType::Pointer cpp_image;
+
+  GateImageRegularParameterisation();
+
+  // Voxel size and number of voxels, from the image (again when the labels
+  // of the image change)
+  void initialize_image();
+
+  void initialize_material(std::vector<std::string> materials);
+
+  // Solid of the image volume, containing all the voxels
+  void initialize_container(G4VSolid *container);
+
+  G4Material *ComputeMaterial(const G4int repNo, G4VPhysicalVolume *currentVol,
+                              const G4VTouchable *parentTouch) override;
+
+  // List of pixel value <-> material
+  const std::vector<G4Material *> &GetLabelMaterials() const {
+    return fMaterials;
+  }
+
+protected:
+  const unsigned short *fLabels = nullptr;
+};
+
+#endif // GateImageRegularParameterisation_h
@@ -0,0 +1,101 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateImageRunParameterisation.h"
+#include "G4Material.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VPhysicalVolume.hh"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <limits>
+
+GateImageRunParameterisation::GateImageRunParameterisation()
+    : G4VPVParameterisation() {
+  // size and allocation will be performed on the py side
+  cpp_image = ImageType::New();
+}
+
+void GateImageRunParameterisation::initialize_image() {
+  const auto size = cpp_image->GetLargestPossibleRegion().GetSize();
+  const auto &spacing = cpp_image->GetSpacing();
+  for (int i = 0; i < 3; i++) {
+    fSpacing[i] = spacing[i] * CLHEP::mm;
+    fHalfSize[i] = size[i] * fSpacing[i] / 2.0;
+  }
+  fSizeX = size[0];
+  fSizeY = size[1];
+  fLabels = cpp_image->GetBufferPointer();
+
+  // run-length encoding of the rows
+  size_t max_length = std::numeric_limits<unsigned short>::max();
+  if (fMaxRunLength > 0)
+    max_length = std::min(max_length, static_cast<size_t>(fMaxRunLength));
+  fRunStart.clear();
+  fRunLength.clear();
+  const auto nb_rows = size[1] * size[2];
+  for (size_t row = 0; row < nb_rows; row++) {
+    const auto first = row * fSizeX;
+    size_t start = 0;
+    while (start < fSizeX) {
+      const auto label = fLabels[first + start];
+      size_t length = 1;
+      while (start + length < fSizeX && length < max_length &&
+             fLabels[first + start + length] == label)
+        length++;
+      fRunStart.push_back(first + start);
+      fRunLength.push_back(static_cast<unsigned short>(length));
+      start += length;
+    }
+  }
+  if (fRunStart.size() >
+      static_cast<size_t>(std::numeric_limits<G4int>::max())) {
+    std::ostringstream oss;
+    oss << "GateImageRunParameterisation: too many runs (" << fRunStart.size()
+        << ") in the image, use a larger max_run_length";
+    Fatal(oss.str());
+  }
+}
+
+void GateImageRunParameterisation::initialize_material(
+    std::vector<std::string> materials) {
+  fMaterials.resize(0);
+  for (const auto &s : materials) {
+    auto *m = G4Material::GetMaterial(s);
+    if (m == nullptr) {
+      std::ostringstream oss;
+      oss << "GateImageRunParameterisation: cannot find the material " << s;
+      Fatal(oss.str());
+    }
+    fMaterials.push_back(m);
+  }
+}
+
+G4Material *GateImageRunParameterisation::ComputeMaterial(
+    const G4int repNo, G4VPhysicalVolume * /*currentVol*/,
+    const G4VTouchable * /*parentTouch*/) {
+  return fMaterials[fLabels[fRunStart[repNo]]];
+}
+
+void GateImageRunParameterisation::ComputeTransformation(
+    const G4int no, G4VPhysicalVolume *currentPV) const {
+  const auto start = fRunStart[no];
+  const auto ix = start % fSizeX;
+  const auto iy = (start / fSizeX) % fSizeY;
+  const auto iz = start / (fSizeX * fSizeY);
+  // center of the run, in the image volume
+  G4ThreeVector t((ix + fRunLength[no] / 2.0) * fSpacing[0] - fHalfSize[0],
+                  (iy + 0.5) * fSpacing[1] - fHalfSize[1],
+                  (iz + 0.5) * fSpacing[2] - fHalfSize[2]);
+  currentPV->SetTranslation(t);
+}
+
+void GateImageRunParameterisation::ComputeDimensions(
+    G4Box &box, const G4int no, const G4VPhysicalVolume * /*currentPV*/) const {
+  box.SetXHalfLength(fRunLength[no] * fSpacing[0] / 2.0);
+  box.SetYHalfLength(fSpacing[1] / 2.0);
+  box.SetZHalfLength(fSpacing[2] / 2.0);
+}
@@ -0,0 +1,70 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateImageRunParameterisation_h
+#define GateImageRunParameterisation_h
+
+#include "G4Box.hh"
+#include "G4VPVParameterisation.hh"
+#include "itkImage.h"
+
+/*
+ * Parameterisation of an image volume where the voxels are merged in runs
+ * of identical material along X (run-length encoding of the rows of the
+ * label image). Each copy of the G4PVParameterised is a box covering one
+ * run, so that the navigator crosses a homogeneous part of a row in one
+ * step. The runs never cross a row, and are at most max_run_length voxels
+ * long (0: no limit) to keep a user-selectable granularity.
+ *
+ * The runs are computed from the label image in initialize_image. A run
+ * only stores its first voxel (index in the buffer) and its length, the
+ * material is the one of the label of the first voxel.
+ */
+class GateImageRunParameterisation : public G4VPVParameterisation {
+
+public:
+  // Labels of the voxels (same type as GateImageNestedParameterisation)
+  typedef itk::Image<unsigned short, 3> ImageType;
+  ImageType::Pointer cpp_image;
+  // List of pixel value <-> material
+  std::vector<G4Material *> fMaterials;
+  // Maximum number of voxels of a run (0: whole rows)
+  int fMaxRunLength = 0;
+
+  GateImageRunParameterisation();
+
+  // Compute the runs from the image
+  void initialize_image();
+
+  void initialize_material(std::vector<std::string> materials);
+
+  size_t GetNumberOfRuns() const { return fRunStart.size(); }
+
+  G4Material *ComputeMaterial(const G4int repNo, G4VPhysicalVolume *currentVol,
+                              const G4VTouchable *parentTouch) override;
+
+  void ComputeTransformation(const G4int no,
+                             G4VPhysicalVolume *currentPV) const override;
+
+  // This line to avoid Woverloaded-virtual warning
+  using G4VPVParameterisation::ComputeDimensions;
+
+  void ComputeDimensions(G4Box &box, const G4int no,
+                         const G4VPhysicalVolume *currentPV) const override;
+
+protected:
+  const unsigned short *fLabels = nullptr;
+  size_t fSizeX = 0;
+  size_t fSizeY = 0;
+  double fSpacing[3] = {0, 0, 0};
+  double fHalfSize[3] = {0, 0, 0};
+  // first voxel (index in the buffer) and number of voxels of each run
+  std::vector<size_t> fRunStart;
+  std::vector<unsigned short> fRunLength;
+};
+
+#endif // GateImageRunParameterisation_h
@@ -0,0 +1,40 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateImageSnapshot.h"
+#include <algorithm>
+
+void GateImageSnapshot::SetIntervals(int nb_events, double seconds) {
+  fEventInterval = std::max(nb_events, 0);
+  fTimeInterval = std::max(seconds, 0.0);
+}
+
+void GateImageSnapshot::Reset(size_t nb_voxels) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fValues.assign(nb_voxels, 0.0);
+  fBuffers.clear();
+  fNumberOfEvents = 0;
+  fNumberOfSnapshots = 0;
+  fLastTime = std::chrono::steady_clock::now();
+}
+
+void GateImageSnapshot::RegisterBuffer(const double *buffer, size_t stride,
+                                       size_t component) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fBuffers.push_back({buffer, stride, component});
+}
+
+bool GateImageSnapshot::IsDue(int nb_events) const {
+  if (fEventInterval > 0 && nb_events - fNumberOfEvents >= fEventInterval)
+    return true;
+  if (fTimeInterval > 0) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - fLastTime;
+    return elapsed.count() >= fTimeInterval;
+  }
+  return false;
+}
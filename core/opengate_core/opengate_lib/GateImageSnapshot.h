@@ -0,0 +1,82 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateImageSnapshot_h
+#define GateImageSnapshot_h
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+/*
+    Intermediate copy of a scored image, taken during a run while the worker
+    threads keep on scoring. It is the sum of the shared image and of the
+    per-thread buffers that are not merged into it yet (registered by the
+    workers at the beginning of the run).
+
+    The values are read without lock (relaxed atomic loads): a buffer is
+    either counted before or after its merge, never twice, but the deposits
+    of the steps scored at the same time may be missed. This is intended for
+    monitoring, the final image is still the one of the end of run.
+ */
+
+class GateImageSnapshot {
+public:
+  // Take a snapshot every nb_events events and/or every seconds seconds of
+  // wall clock time (0: no snapshot)
+  void SetIntervals(int nb_events, double seconds);
+
+  bool IsEnabled() const { return fEventInterval > 0 || fTimeInterval > 0; }
+
+  // Master thread, begin of run: clear the snapshot and the buffers
+  void Reset(size_t nb_voxels);
+
+  // Worker thread, begin of run: per-thread buffer with stride values per
+  // voxel, the value of this image is at position component
+  void RegisterBuffer(const double *buffer, size_t stride = 1,
+                      size_t component = 0);
+
+  // Worker thread, end of run: merge() adds the buffer to the shared image,
+  // it is called with the lock of the snapshot, then the buffer is removed
+  template <class F> void MergeBuffer(const double *buffer, F merge);
+
+  // True if a new snapshot is due (to be called by a single thread)
+  bool IsDue(int nb_events) const;
+
+  // Sum the shared image and the registered buffers into the snapshot
+  template <class PixelType> void Take(const PixelType *shared, int nb_events);
+
+  // Values of the last snapshot (same layout as the image, x fastest)
+  const std::vector<double> &GetValues() const { return fValues; }
+
+  double *GetValuesPointer() { return fValues.data(); }
+
+  // Number of events when the last snapshot was taken
+  int GetNumberOfEvents() const { return fNumberOfEvents; }
+
+  int GetNumberOfSnapshots() const { return fNumberOfSnapshots; }
+
+protected:
+  struct Buffer {
+    const double *data;
+    size_t stride;
+    size_t component;
+  };
+
+  int fEventInterval = 0;
+  double fTimeInterval = 0;
+  int fNumberOfEvents = 0;
+  int fNumberOfSnapshots = 0;
+  std::chrono::steady_clock::time_point fLastTime;
+  std::vector<double> fValues;
+  std::vector<Buffer> fBuffers;
+  std::mutex fMutex;
+};
+
+#include "GateImageSnapshot.txx"
+
+#endif // GateImageSnapshot_h
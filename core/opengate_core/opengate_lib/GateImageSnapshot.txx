@@ -0,0 +1,44 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <algorithm>
+#include <atomic>
+
+template <class T> inline T SnapshotLoad(const T *address) {
+  // the buffers are not made of std::atomic, but they share the same
+  // representation (see AtomicAddValue)
+  static_assert(sizeof(std::atomic<T>) == sizeof(T),
+                "std::atomic<T> must have the same size than T");
+  return reinterpret_cast<const std::atomic<T> *>(address)->load(
+      std::memory_order_relaxed);
+}
+
+template <class F>
+void GateImageSnapshot::MergeBuffer(const double *buffer, F merge) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  merge();
+  fBuffers.erase(std::remove_if(fBuffers.begin(), fBuffers.end(),
+                                [&](const Buffer &b) {
+                                  return b.data == buffer;
+                                }),
+                 fBuffers.end());
+}
+
+template <class PixelType>
+void GateImageSnapshot::Take(const PixelType *shared, int nb_events) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto n = fValues.size();
+  for (size_t i = 0; i < n; i++)
+    fValues[i] = SnapshotLoad(shared + i);
+  for (const auto &b : fBuffers) {
+    for (size_t i = 0; i < n; i++)
+      fValues[i] += SnapshotLoad(b.data + i * b.stride + b.component);
+  }
+  fNumberOfEvents = nb_events;
+  fNumberOfSnapshots++;
+  fLastTime = std::chrono::steady_clock::now();
+}
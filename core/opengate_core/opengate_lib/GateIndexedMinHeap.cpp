@@ -0,0 +1,84 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateIndexedMinHeap.h"
+#include <utility>
+
+void GateIndexedMinHeap::Reset(size_t nb_items) {
+  fHeap.clear();
+  fHeap.reserve(nb_items);
+  fPosition.assign(nb_items, -1);
+  fKeys.assign(nb_items, 0.0);
+}
+
+void GateIndexedMinHeap::Update(int item, double key) {
+  auto pos = fPosition[item];
+  if (pos < 0) {
+    fKeys[item] = key;
+    fPosition[item] = static_cast<int>(fHeap.size());
+    fHeap.push_back(item);
+    SiftUp(fHeap.size() - 1);
+    return;
+  }
+  auto previous = fKeys[item];
+  fKeys[item] = key;
+  if (key < previous)
+    SiftUp(pos);
+  else
+    SiftDown(pos);
+}
+
+void GateIndexedMinHeap::Remove(int item) {
+  auto pos = fPosition[item];
+  if (pos < 0)
+    return;
+  auto last = fHeap.size() - 1;
+  if (static_cast<size_t>(pos) != last) {
+    Swap(pos, last);
+  }
+  fHeap.pop_back();
+  fPosition[item] = -1;
+  if (static_cast<size_t>(pos) < fHeap.size()) {
+    // the moved item may go either way
+    auto moved = fHeap[pos];
+    SiftUp(pos);
+    SiftDown(fPosition[moved]);
+  }
+}
+
+void GateIndexedMinHeap::Swap(size_t i, size_t j) {
+  std::swap(fHeap[i], fHeap[j]);
+  fPosition[fHeap[i]] = static_cast<int>(i);
+  fPosition[fHeap[j]] = static_cast<int>(j);
+}
+
+void GateIndexedMinHeap::SiftUp(size_t pos) {
+  while (pos > 0) {
+    auto parent = (pos - 1) / 2;
+    if (!Less(fHeap[pos], fHeap[parent]))
+      return;
+    Swap(pos, parent);
+    pos = parent;
+  }
+}
+
+void GateIndexedMinHeap::SiftDown(size_t pos) {
+  auto n = fHeap.size();
+  while (true) {
+    auto smallest = pos;
+    auto left = 2 * pos + 1;
+    auto right = left + 1;
+    if (left < n && Less(fHeap[left], fHeap[smallest]))
+      smallest = left;
+    if (right < n && Less(fHeap[right], fHeap[smallest]))
+      smallest = right;
+    if (smallest == pos)
+      return;
+    Swap(pos, smallest);
+    pos = smallest;
+  }
+}
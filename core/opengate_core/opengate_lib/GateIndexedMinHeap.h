@@ -0,0 +1,63 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateIndexedMinHeap_h
+#define GateIndexedMinHeap_h
+
+#include <cstddef>
+#include <vector>
+
+/*
+    Binary min-heap of items 0..N-1, each with a key (e.g. the next time of a
+    source). The position of each item in the heap is stored, so the key of
+    any item can be changed (or the item removed) in O(log N).
+
+    Items with the same key are ordered by item index: the smallest index is
+    on top, like a linear search for the first minimum.
+ */
+
+class GateIndexedMinHeap {
+public:
+  // Remove all items, and set the number of possible items
+  void Reset(size_t nb_items);
+
+  // Insert the item, or change its key if it is already in the heap
+  void Update(int item, double key);
+
+  // Remove the item (nothing if it is not in the heap)
+  void Remove(int item);
+
+  bool Contains(int item) const { return fPosition[item] >= 0; }
+
+  bool Empty() const { return fHeap.empty(); }
+
+  size_t Size() const { return fHeap.size(); }
+
+  // Item with the smallest key (the heap must not be empty)
+  int Top() const { return fHeap.front(); }
+
+  double TopKey() const { return fKeys[fHeap.front()]; }
+
+protected:
+  bool Less(int a, int b) const {
+    return fKeys[a] < fKeys[b] || (fKeys[a] == fKeys[b] && a < b);
+  }
+
+  void Swap(size_t i, size_t j);
+
+  void SiftUp(size_t pos);
+
+  void SiftDown(size_t pos);
+
+  // items, the top is the smallest key
+  std::vector<int> fHeap;
+  // position of each item in fHeap, -1 if not in the heap
+  std::vector<int> fPosition;
+  std::vector<double> fKeys;
+};
+
+#endif // GateIndexedMinHeap_h
@@ -7,6 +7,7 @@
 
 #include "GateInfo.h"
 #include "G4Version.hh"
+#include "GateGANInference.h"
 #include <itkVersion.h>
 #include <streambuf>
 
@@ -62,6 +63,8 @@ bool GateInfo::get_G4GDML() {
 #endif
 }
 
+bool GateInfo::get_ONNXRuntime() { return GateGANInference::IsAvailable(); }
+
 #include "G4LinInterpolator.hh"
 #include "G4PixeCrossSectionHandler.hh"
 #include "G4PixeShellDataSet.hh"
@@ -23,5 +23,7 @@ public:
 
   static bool get_G4GDML();
 
+  static bool get_ONNXRuntime();
+
   static void test();
 };
@@ -9,13 +9,15 @@
 #include "G4LogicalVolumeStore.hh"
 #include "G4ParticleTable.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4Positron.hh"
 #include "G4ProcessManager.hh"
 #include "G4VProcess.hh"
 #include "G4ios.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
+#include "GateMutex.h"
 
-G4Mutex SetNbKillAccordingProcessesMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetNbKillAccordingProcessesMutex);
 
 GateKillAccordingProcessesActor::GateKillAccordingProcessesActor(
     py::dict &user_info)
@@ -52,8 +54,11 @@ void GateKillAccordingProcessesActor::InitializeUserInfo(py::dict &user_info) {
       DictGetBool(user_info, "is_rayleigh_an_interaction");
 }
 
-void GateKillAccordingProcessesActor::BeginOfRunAction(const G4Run *run) {
+void GateKillAccordingProcessesActor::StartSimulationAction() {
   fNbOfKilledParticles = 0;
+}
+
+void GateKillAccordingProcessesActor::BeginOfRunAction(const G4Run *run) {
   std::vector<G4String> listOfAllProcesses = GetListOfPhysicsListProcesses();
   listOfAllProcesses.push_back("all");
   for (auto process : fProcessesToKill) {
@@ -77,6 +82,38 @@ void GateKillAccordingProcessesActor::BeginOfRunAction(const G4Run *run) {
       fKillIfAnyInteraction = true;
     }
   }
+  ResolveProcessesToKill();
+}
+
+void GateKillAccordingProcessesActor::ResolveProcessesToKill() {
+  // The processes are resolved once per run and per thread (each thread has
+  // its own process objects), the steps then only compare pointers
+  auto &l = fThreadLocalData.Get();
+  l.fProcessesToKill.clear();
+  auto isToKill = [&](const std::string &name) {
+    if (fKillIfAnyInteraction)
+      return name != "Transportation" &&
+             (fIsRayleighAnInteraction || name != "Rayl");
+    return std::find(fProcessesToKill.begin(), fProcessesToKill.end(),
+                     name) != fProcessesToKill.end();
+  };
+  auto *particleTable = G4ParticleTable::GetParticleTable();
+  for (G4int i = 0; i < particleTable->size(); ++i) {
+    const auto *processManager =
+        particleTable->GetParticle(i)->GetProcessManager();
+    if (!processManager)
+      continue;
+    const auto *processList = processManager->GetProcessList();
+    for (size_t j = 0; j < processList->size(); ++j) {
+      const G4VProcess *process = (*processList)[j];
+      if (isToKill(process->GetProcessName()))
+        l.fProcessesToKill.insert(process);
+    }
+  }
+  // (steps without process, and positrons at rest for the annihilation)
+  l.fKillWithoutProcess = fKillIfAnyInteraction;
+  l.fKillPositronAtRest = isToKill("annihil");
+  l.fPositron = G4Positron::Definition();
 }
 
 void GateKillAccordingProcessesActor::PreUserTrackingAction(
@@ -85,44 +122,33 @@ void GateKillAccordingProcessesActor::PreUserTrackingAction(
 }
 
 void GateKillAccordingProcessesActor::SteppingAction(G4Step *step) {
-
-  G4String logNameMotherVolume = G4LogicalVolumeStore::GetInstance()
-                                     ->GetVolume(fAttachedToVolumeName)
-                                     ->GetName();
-  G4String physicalVolumeNamePreStep = "None";
-
-  G4String processName = "None";
+  const auto &l = fThreadLocalData.Get();
+  auto *track = step->GetTrack();
   const G4VProcess *process = step->GetPostStepPoint()->GetProcessDefinedStep();
-  if (process != 0)
-    processName = process->GetProcessName();
 
   // Positron exception to retrieve the annihilation process, since it's an at
   // rest process most of the time
+  bool kill;
+  if (track->GetParticleDefinition() == l.fPositron &&
+      track->GetTrackStatus() == fStopButAlive)
+    kill = l.fKillPositronAtRest;
+  else if (process == nullptr)
+    kill = l.fKillWithoutProcess;
+  else
+    kill = l.fProcessesToKill.count(process) > 0;
 
-  if ((step->GetTrack()->GetParticleDefinition()->GetParticleName() == "e+") &&
-      (step->GetTrack()->GetTrackStatus() == 1))
-    processName = "annihil";
-
-  if (fKillIfAnyInteraction) {
-    if (processName != "Transportation") {
-      if (fIsRayleighAnInteraction == true) {
-        step->GetTrack()->SetTrackStatus(fKillTrackAndSecondaries);
-        G4AutoLock mutex(&SetNbKillAccordingProcessesMutex);
-        fNbOfKilledParticles++;
-      } else {
-        if (processName != "Rayl") {
-          step->GetTrack()->SetTrackStatus(fKillTrackAndSecondaries);
-          G4AutoLock mutex(&SetNbKillAccordingProcessesMutex);
-          fNbOfKilledParticles++;
-        }
-      }
-    }
-  } else {
-    if (std::find(fProcessesToKill.begin(), fProcessesToKill.end(),
-                  processName) != fProcessesToKill.end()) {
-      step->GetTrack()->SetTrackStatus(fKillTrackAndSecondaries);
-      G4AutoLock mutex(&SetNbKillAccordingProcessesMutex);
-      fNbOfKilledParticles++;
-    }
+  if (kill) {
+    track->SetTrackStatus(fKillTrackAndSecondaries);
+    fThreadLocalNbOfKilledParticles.Get()++;
   }
 }
+
+void GateKillAccordingProcessesActor::EndOfRunAction(const G4Run * /*run*/) {
+  // the counts of the thread are added once per run
+  auto &n = fThreadLocalNbOfKilledParticles.Get();
+  if (n == 0)
+    return;
+  GateAutoLock mutex(&SetNbKillAccordingProcessesMutex);
+  fNbOfKilledParticles += n;
+  n = 0;
+}
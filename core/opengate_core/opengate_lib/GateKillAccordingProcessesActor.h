@@ -9,8 +9,10 @@
 #define GateKillAccordingProcessesActor_h
 
 #include "G4Cache.hh"
+#include "GateThreadContext.h"
 #include "GateVActor.h"
 #include <pybind11/stl.h>
+#include <unordered_set>
 
 namespace py = pybind11;
 
@@ -23,8 +25,13 @@ public:
 
   void InitializeUserInfo(py::dict &user_info) override;
 
+  void StartSimulationAction() override;
+
   void BeginOfRunAction(const G4Run *) override;
 
+  // The kills of the thread are added to the count (all threads)
+  void EndOfRunAction(const G4Run *) override;
+
   // Main function called every step in attached volume
   void SteppingAction(G4Step *) override;
 
@@ -38,6 +45,22 @@ public:
   G4bool fIsRayleighAnInteraction = false;
 
   long fNbOfKilledParticles{};
+  // kills of the current run in each thread, without lock
+  GateThreadLocal<long> fThreadLocalNbOfKilledParticles;
+
+  inline long GetNumberOfKilledParticles() { return fNbOfKilledParticles; }
+
+protected:
+  // Processes to kill of the thread, from their names
+  void ResolveProcessesToKill();
+
+  struct threadLocalT {
+    std::unordered_set<const G4VProcess *> fProcessesToKill;
+    bool fKillWithoutProcess = false;
+    bool fKillPositronAtRest = false;
+    const G4ParticleDefinition *fPositron = nullptr;
+  };
+  GateThreadLocal<threadLocalT> fThreadLocalData;
 };
 
 #endif
@@ -9,22 +9,78 @@
 #include "G4ios.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
+#include "GateMutex.h"
+#include <algorithm>
 
-G4Mutex SetNbKillMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetNbKillMutex);
 
 GateKillActor::GateKillActor(py::dict &user_info)
     : GateVActor(user_info, true) {
   fNbOfKilledParticles = 0;
 }
 
+void GateKillActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fEnergyBinEdges.clear();
+  if (!user_info["energy_bins"].is_none())
+    fEnergyBinEdges = DictGetVecDouble(user_info, "energy_bins");
+  if (!fEnergyBinEdges.empty() &&
+      (fEnergyBinEdges.size() < 2 ||
+       !std::is_sorted(fEnergyBinEdges.begin(), fEnergyBinEdges.end(),
+                       std::less_equal<>()))) {
+    Fatal("Error in GateKillActor: energy_bins must contain at least "
+          "two strictly increasing bin edges.");
+  }
+}
+
 void GateKillActor::StartSimulationAction() {
   fNbOfKilledParticles = 0;
-  std::cout << "lol" << std::endl;
+  fSpectra.clear();
 }
 
 void GateKillActor::SteppingAction(G4Step *step) {
   auto track = step->GetTrack();
   track->SetTrackStatus(fStopAndKill);
-  G4AutoLock mutex(&SetNbKillMutex);
-  fNbOfKilledParticles++;
+  auto &l = fThreadLocalData.Get();
+  l.fNbOfKilledParticles++;
+  if (fEnergyBinEdges.empty())
+    return;
+  // energy when entering the volume
+  const auto energy = step->GetPreStepPoint()->GetKineticEnergy();
+  const auto it = std::upper_bound(fEnergyBinEdges.begin(),
+                                   fEnergyBinEdges.end(), energy);
+  if (it == fEnergyBinEdges.begin() || it == fEnergyBinEdges.end())
+    return;
+  auto &spectrum = l.fSpectra[track->GetParticleDefinition()];
+  if (spectrum.empty())
+    spectrum.resize(fEnergyBinEdges.size() - 1, 0);
+  spectrum[it - fEnergyBinEdges.begin() - 1]++;
+}
+
+void GateKillActor::EndOfRunAction(const G4Run * /*run*/) {
+  auto &l = fThreadLocalData.Get();
+  if (l.fNbOfKilledParticles == 0)
+    return;
+  GateAutoLock mutex(&SetNbKillMutex);
+  fNbOfKilledParticles += l.fNbOfKilledParticles;
+  AddSpectra(l.fSpectra);
+  l.fNbOfKilledParticles = 0;
+  l.fSpectra.clear();
+}
+
+void GateKillActor::AddSpectra(const SpectraType &spectra) {
+  for (const auto &[particle, spectrum] : spectra) {
+    auto &s = fSpectra[particle];
+    if (s.empty())
+      s.resize(spectrum.size(), 0);
+    for (size_t i = 0; i < spectrum.size(); i++)
+      s[i] += spectrum[i];
+  }
+}
+
+std::map<std::string, std::vector<long>> GateKillActor::GetKillSpectra() const {
+  std::map<std::string, std::vector<long>> spectra;
+  for (const auto &[particle, spectrum] : fSpectra)
+    spectra[particle->GetParticleName()] = spectrum;
+  return spectra;
 }
@@ -8,8 +8,10 @@
 #ifndef GateKillActor_h
 #define GateKillActor_h
 
-#include "G4Cache.hh"
+#include "G4ParticleDefinition.hh"
+#include "GateThreadContext.h"
 #include "GateVActor.h"
+#include <map>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -20,15 +22,40 @@ public:
   // Constructor
   GateKillActor(py::dict &user_info);
 
+  void InitializeUserInfo(py::dict &user_info) override;
+
   void StartSimulationAction() override;
 
   // Main function called every step in attached volume
   void SteppingAction(G4Step *) override;
 
+  // The counts of the thread are added to the ones of the actor (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  // (the counts of the threads are added at the end of each run)
   inline long GetNumberOfKilledParticles() { return fNbOfKilledParticles; }
 
+  // Number of killed particles in each energy bin, for each particle name
+  std::map<std::string, std::vector<long>> GetKillSpectra() const;
+
 private:
+  typedef std::map<const G4ParticleDefinition *, std::vector<long>>
+      SpectraType;
+
+  void AddSpectra(const SpectraType &spectra);
+
+  // edges of the energy bins of the spectra (none if empty)
+  std::vector<double> fEnergyBinEdges;
+
   long fNbOfKilledParticles{};
+  SpectraType fSpectra;
+
+  // counts of the current run in each thread, without lock
+  struct threadLocalT {
+    long fNbOfKilledParticles = 0;
+    SpectraType fSpectra;
+  };
+  GateThreadLocal<threadLocalT> fThreadLocalData;
 };
 
 #endif
@@ -9,9 +9,13 @@
 #include "G4Navigator.hh"
 #include "G4RandomTools.hh"
 #include "G4RunManager.hh"
+#include "G4Threading.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
 #include "GateHelpersImage.h"
+#include "GateHugePages.h"
+#include "GateMutex.h"
+#include "GateStepContext.h"
 
 #include "G4Deuteron.hh"
 #include "G4Electron.hh"
@@ -24,16 +28,24 @@
 #include "G4Positron.hh"
 #include "G4Proton.hh"
 
+#include <algorithm>
+#include <cmath>
+
 // Mutex that will be used by thread to write in the edep/dose image
-G4Mutex SetLETPixelMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetLETPixelMutex);
+
+GATE_MUTEX(SetLETNbEventMutex);
 
-G4Mutex SetLETNbEventMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetLETSpectrumMutex);
 
 GateLETActor::GateLETActor(py::dict &user_info) : GateVActor(user_info, true) {
   // Action for this actor: during stepping
   fActions.insert("SteppingAction");
   fActions.insert("BeginOfRunAction");
+  fActions.insert("EndOfRunAction");
+  fActions.insert("EndOfEventAction");
   fActions.insert("EndSimulationAction");
+  fActions.insert("StartSimulationAction");
 }
 
 void GateLETActor::InitializeUserInfo(py::dict &user_info) {
@@ -41,23 +53,107 @@ void GateLETActor::InitializeUserInfo(py::dict &user_info) {
   GateVActor::InitializeUserInfo(user_info);
 
   fAveragingMethod = DictGetStr(user_info, "averaging_method");
+  fdoseAverage = fAveragingMethod == "dose_average";
+  ftrackAverage = fAveragingMethod == "track_average";
+  if (!fdoseAverage && !ftrackAverage) {
+    std::ostringstream oss;
+    oss << "Error in GateLETActor: unknown averaging_method. Must be "
+           "'dose_average' or 'track_average'"
+        << " while '" << fAveragingMethod << "' is read.";
+    Fatal(oss.str());
+  }
   fScoreIn = DictGetStr(user_info, "score_in");
   if (fScoreIn != "material") {
     fScoreInOtherMaterial = true;
   }
 
+  fStoppingPowerTableFlag = DictGetBool(user_info, "stopping_power_table");
+
   fInitialTranslation = DictGetG4ThreeVector(user_info, "translation");
   // Hit type (random, pre, post etc)
-  fHitType = DictGetStr(user_info, "hit_type");
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+
+  // Scoring mode: shared images (mutex or atomic), per-thread images, sparse
+  // images or queues of deposits
+  auto mode = DictGetStr(user_info, "scoring_mode");
+  if (mode == "mutex")
+    fScoringMode = ScoringMode::Mutex;
+  else if (mode == "thread_local")
+    fScoringMode = ScoringMode::ThreadLocal;
+  else if (mode == "atomic")
+    fScoringMode = ScoringMode::Atomic;
+  else if (mode == "sparse")
+    fScoringMode = ScoringMode::Sparse;
+  else if (mode == "queue")
+    fScoringMode = ScoringMode::Queue;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateLETActor: unknown scoring_mode. Must be "
+           "'mutex', 'thread_local', 'atomic', 'sparse' or 'queue'"
+        << " while '" << mode << "' is read.";
+    Fatal(oss.str());
+  }
+
+  // Number of deposits per batch (Queue scoring mode)
+  fQueueSize = DictGetInt(user_info, "queue_size");
+  if (fQueueSize < 1) {
+    std::ostringstream oss;
+    oss << "Error in GateLETActor: queue_size must be at least 1"
+        << " while " << fQueueSize << " is read.";
+    Fatal(oss.str());
+  }
+
+  // Precision of the per-thread buffer (ThreadLocal scoring mode)
+  auto precision = DictGetStr(user_info, "buffer_precision");
+  if (precision != "double" && precision != "float") {
+    std::ostringstream oss;
+    oss << "Error in GateLETActor: unknown buffer_precision. Must be "
+           "'double' or 'float'"
+        << " while '" << precision << "' is read.";
+    Fatal(oss.str());
+  }
+  fFloatBufferFlag = precision == "float";
+
+  // Spectrum of the LET in each voxel (0 bin: none)
+  fSpectrumNumberOfBins = DictGetInt(user_info, "spectrum_number_of_bins");
+  fSpectrumMin = DictGetDouble(user_info, "spectrum_let_min") /
+                 (CLHEP::MeV / CLHEP::mm);
+  fSpectrumMax = DictGetDouble(user_info, "spectrum_let_max") /
+                 (CLHEP::MeV / CLHEP::mm);
+  if (fSpectrumNumberOfBins > 0xFFFF || fSpectrumNumberOfBins < 0 ||
+      (fSpectrumNumberOfBins > 0 &&
+       (fSpectrumMin <= 0 || fSpectrumMax <= fSpectrumMin))) {
+    std::ostringstream oss;
+    oss << "Error in GateLETActor: the LET spectrum needs between 0 and "
+        << 0xFFFF << " bins and 0 < spectrum_let_min < spectrum_let_max, "
+        << "while " << fSpectrumNumberOfBins << " bins in [" << fSpectrumMin
+        << ", " << fSpectrumMax << "] MeV/mm are read.";
+    Fatal(oss.str());
+  }
+  if (fSpectrumNumberOfBins > 0) {
+    fSpectrumLogMin = std::log(fSpectrumMin);
+    fSpectrumLogBinWidth =
+        (std::log(fSpectrumMax) - fSpectrumLogMin) / fSpectrumNumberOfBins;
+  }
+
+  // Intermediate images taken during the run (0: no snapshot)
+  auto snapshot_events = DictGetInt(user_info, "snapshot_event_interval");
+  auto snapshot_time = DictGetDouble(user_info, "snapshot_time_interval");
+  fNumeratorSnapshot.SetIntervals(snapshot_events, snapshot_time);
+  fDenominatorSnapshot.SetIntervals(snapshot_events, snapshot_time);
 }
 
 void GateLETActor::InitializeCpp() {
+  SelectSteppingKernel();
+
   // Create the image pointer
   // (the size and allocation will be performed on the py side)
   cpp_numerator_image = ImageType::New();
   cpp_denominator_image = ImageType::New();
 }
 
+void GateLETActor::StartSimulationAction() { fSpectrum.clear(); }
+
 void GateLETActor::BeginOfRunActionMasterThread(int run_id) {
   // Reset the number of events (per run)
   NbOfEvent = 0;
@@ -67,74 +163,228 @@ void GateLETActor::BeginOfRunActionMasterThread(int run_id) {
                                  fInitialTranslation);
   AttachImageToVolume<ImageType>(cpp_denominator_image, fPhysicalVolumeName,
                                  fInitialTranslation);
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(cpp_numerator_image.GetPointer());
   // compute volume of a dose voxel
   auto sp = cpp_numerator_image->GetSpacing();
   fVoxelVolume = sp[0] * sp[1] * sp[2];
+
+  // the dense images are not allocated during the run (see the py side)
+  if (fScoringMode == ScoringMode::Sparse) {
+    auto size = cpp_numerator_image->GetLargestPossibleRegion().GetSize();
+    fNumeratorSparseImage.Initialize(size[0], size[1], size[2]);
+    fDenominatorSparseImage.Initialize(size[0], size[1], size[2]);
+  }
+
+  // the per-thread buffers are registered by the workers (BeginOfRunAction)
+  fSnapshotNbOfEvent = 0;
+  if (fNumeratorSnapshot.IsEnabled()) {
+    auto region = cpp_numerator_image->GetLargestPossibleRegion();
+    auto n = region.GetNumberOfPixels();
+    fNumeratorSnapshot.Reset(n);
+    fDenominatorSnapshot.Reset(n);
+  }
 }
 
 void GateLETActor::BeginOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  l.dedx_table.SetUseTable(fStoppingPowerTableFlag);
   if (fScoreInOtherMaterial) {
-    auto &l = fThreadLocalData.Get();
     l.materialToScoreIn =
         G4NistManager::Instance()->FindOrBuildMaterial(fScoreIn);
   }
+  if (fScoringMode == ScoringMode::Sparse) {
+    auto size = cpp_numerator_image->GetLargestPossibleRegion().GetSize();
+    l.numerator_worker_sparseimg.Initialize(size[0], size[1], size[2]);
+    l.denominator_worker_sparseimg.Initialize(size[0], size[1], size[2]);
+  }
+  if (fScoringMode == ScoringMode::Queue) {
+    auto size = cpp_numerator_image->GetLargestPossibleRegion().GetSize();
+    l.deposit_queue.Initialize(size[0], size[1], size[2], fQueueSize);
+  }
+  if (fScoringMode == ScoringMode::ThreadLocal && fFloatBufferFlag) {
+    // same in float (no snapshot in this case, see the py side)
+    auto region = cpp_numerator_image->GetLargestPossibleRegion();
+    GateHugePages::Assign(l.numden_worker_flatimg_float,
+                          2 * region.GetNumberOfPixels(), 0.0f,
+                          "dose_buffers");
+  } else if (fScoringMode == ScoringMode::ThreadLocal) {
+    auto region = cpp_numerator_image->GetLargestPossibleRegion();
+    GateHugePages::Assign(l.numden_worker_flatimg,
+                          2 * region.GetNumberOfPixels(), 0.0, "dose_buffers");
+    // interleaved buffer: numerator then denominator for each voxel
+    if (fNumeratorSnapshot.IsEnabled()) {
+      fNumeratorSnapshot.RegisterBuffer(l.numden_worker_flatimg.data(), 2, 0);
+      fDenominatorSnapshot.RegisterBuffer(l.numden_worker_flatimg.data(), 2,
+                                          1);
+    }
+  }
+  l.number_of_events = 0;
 }
 
-void GateLETActor::BeginOfEventAction(const G4Event *event) {
-  G4AutoLock mutex(&SetLETNbEventMutex);
-  NbOfEvent++;
+void GateLETActor::EndOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  {
+    // the per-thread event counts are summed once per run
+    GateAutoLock mutex(&SetLETNbEventMutex);
+    NbOfEvent += l.number_of_events;
+  }
+  if (fScoringMode == ScoringMode::Sparse) {
+    // move the allocated tiles of this thread to the shared sparse images
+    GateAutoLock mutex(&SetLETPixelMutex);
+    fNumeratorSparseImage.Merge(l.numerator_worker_sparseimg);
+    fDenominatorSparseImage.Merge(l.denominator_worker_sparseimg);
+  }
+  if (fScoringMode == ScoringMode::Queue) {
+    // the last batch of deposits of the thread
+    FlushDepositQueue(l);
+    l.deposit_queue.Clear();
+  }
+  if (fScoringMode == ScoringMode::ThreadLocal && fFloatBufferFlag) {
+    // the float values are summed in the double images
+    GateAutoLock mutex(&SetLETPixelMutex);
+    auto *num = cpp_numerator_image->GetBufferPointer();
+    auto *den = cpp_denominator_image->GetBufferPointer();
+    auto n = l.numden_worker_flatimg_float.size() / 2;
+    for (size_t i = 0; i < n; i++) {
+      num[i] += l.numden_worker_flatimg_float[2 * i];
+      den[i] += l.numden_worker_flatimg_float[2 * i + 1];
+    }
+    std::vector<float>().swap(l.numden_worker_flatimg_float);
+  } else if (fScoringMode == ScoringMode::ThreadLocal) {
+    // the buffer has the memory layout of the images (see sub2ind), with
+    // the numerator and denominator of a voxel side by side. The merge is
+    // done with the locks of the snapshots (see GateImageSnapshot).
+    auto *data = l.numden_worker_flatimg.data();
+    fNumeratorSnapshot.MergeBuffer(data, [&]() {
+      fDenominatorSnapshot.MergeBuffer(data, [&]() {
+        GateAutoLock mutex(&SetLETPixelMutex);
+        auto *num = cpp_numerator_image->GetBufferPointer();
+        auto *den = cpp_denominator_image->GetBufferPointer();
+        auto n = l.numden_worker_flatimg.size() / 2;
+        for (size_t i = 0; i < n; i++) {
+          num[i] += l.numden_worker_flatimg[2 * i];
+          den[i] += l.numden_worker_flatimg[2 * i + 1];
+        }
+      });
+    });
+    l.numden_worker_flatimg.clear();
+    l.numden_worker_flatimg.shrink_to_fit();
+  }
+  if (fSpectrumNumberOfBins > 0) {
+    // merge the spectra of this thread in the shared ones
+    {
+      GateAutoLock mutex(&SetLETSpectrumMutex);
+      if (fSpectrum.empty()) {
+        fSpectrum.swap(l.spectrum);
+      } else {
+        for (const auto &e : l.spectrum)
+          fSpectrum[e.first] += e.second;
+      }
+    }
+    SpectrumType().swap(l.spectrum);
+  }
 }
 
-void GateLETActor::SteppingAction(G4Step *step) {
+void GateLETActor::FlushDepositQueue(threadLocalT &l) {
+  if (l.deposit_queue.IsEmpty()) {
+    return;
+  }
+  // (the flat index is the offset in the itk buffers)
+  auto *num = cpp_numerator_image->GetBufferPointer();
+  auto *den = cpp_denominator_image->GetBufferPointer();
+  GateAutoLock mutex(&SetLETPixelMutex);
+  l.deposit_queue.Flush(
+      [&](long offset, const GateDepositQueue<2>::Values &values) {
+        num[offset] += values[0];
+        den[offset] += values[1];
+      });
+}
 
-  auto preGlobal = step->GetPreStepPoint()->GetPosition();
-  auto postGlobal = step->GetPostStepPoint()->GetPosition();
-  auto touchable = step->GetPreStepPoint()->GetTouchable();
+int GateLETActor::EndOfRunActionMasterThread(int run_id) {
+  // the workers are done: the dense images of the run are created from the
+  // merged sparse images
+  if (fScoringMode == ScoringMode::Sparse) {
+    AllocateImageFromSparseImage(cpp_numerator_image.GetPointer(),
+                                 fNumeratorSparseImage);
+    AllocateImageFromSparseImage(cpp_denominator_image.GetPointer(),
+                                 fDenominatorSparseImage);
+  }
+  return 0;
+}
 
-  // FIXME If the volume has multiple copy, touchable->GetCopyNumber(0) ?
+int GateLETActor::GetSpectrumBin(double let) const {
+  if (let <= fSpectrumMin)
+    return 0;
+  auto bin = static_cast<int>((std::log(let) - fSpectrumLogMin) /
+                              fSpectrumLogBinWidth);
+  return std::min(bin, fSpectrumNumberOfBins - 1);
+}
+
+std::vector<std::pair<std::uint64_t, double>>
+GateLETActor::GetSortedSpectrumElements() const {
+  std::vector<std::pair<std::uint64_t, double>> elements(fSpectrum.begin(),
+                                                         fSpectrum.end());
+  std::sort(elements.begin(), elements.end());
+  return elements;
+}
 
-  // consider random position between pre and post
-  auto position = postGlobal;
-  if (fHitType == "pre") {
-    position = preGlobal;
+void GateLETActor::BeginOfEventAction(const G4Event *event) {
+  // per-thread count, no lock (see EndOfRunAction)
+  fThreadLocalData.Get().number_of_events++;
+  if (fNumeratorSnapshot.IsEnabled()) {
+    fSnapshotNbOfEvent.fetch_add(1, std::memory_order_relaxed);
   }
-  if (fHitType == "random") {
-    auto x = G4UniformRand();
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + x * direction;
+}
+
+void GateLETActor::EndOfEventAction(const G4Event *) {
+  if (!fNumeratorSnapshot.IsEnabled()) {
+    return;
   }
-  if (fHitType == "middle") {
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + 0.5 * direction;
+  // only one thread takes the snapshots, the other ones keep on scoring
+  if (G4Threading::IsMultithreadedApplication() &&
+      G4Threading::G4GetThreadId() != 0) {
+    return;
   }
-  auto localPosition =
-      touchable->GetHistory()->GetTransform(0).TransformPoint(position);
+  auto n = fSnapshotNbOfEvent.load(std::memory_order_relaxed);
+  if (fNumeratorSnapshot.IsDue(n)) {
+    TakeSnapshot();
+  }
+}
 
-  // convert G4ThreeVector to itk PointType
-  ImageType::PointType point;
-  point[0] = localPosition[0];
-  point[1] = localPosition[1];
-  point[2] = localPosition[2];
+void GateLETActor::TakeSnapshot() {
+  if (!fNumeratorSnapshot.IsEnabled()) {
+    return;
+  }
+  auto n = fSnapshotNbOfEvent.load(std::memory_order_relaxed);
+  fNumeratorSnapshot.Take(cpp_numerator_image->GetBufferPointer(), n);
+  fDenominatorSnapshot.Take(cpp_denominator_image->GetBufferPointer(), n);
+}
 
-  // get pixel index
+void GateLETActor::SteppingAction(G4Step *step) {
+  // kernel specialized for the current options, see SelectSteppingKernel
+  (this->*fSteppingKernel)(step);
+}
+
+template <HitType H, bool OtherMaterial, bool DoseAverage>
+void GateLETActor::SteppingKernel(G4Step *step) {
+  // FIXME If the volume has multiple copy, touchable->GetCopyNumber(0) ?
+
+  // get pixel index of the pre, post, middle or random position (the image
+  // is placed in the world frame, the index is shared by the actors with the
+  // same image geometry, see GateStepContext)
+  auto &context = GateStepContext::Get(step);
   ImageType::IndexType index;
-  bool isInside =
-      cpp_numerator_image->TransformPhysicalPointToIndex(point, index);
+  bool isInside = context.GetVoxelIndex<H>(fIndexTransform, index);
 
   // set value
   if (isInside) {
     // get edep in MeV (take weight into account)
     auto w = step->GetTrack()->GetWeight();
     auto edep = step->GetTotalEnergyDeposit() / CLHEP::MeV * w;
-    double dedx_cut = DBL_MAX;
 
-    auto *current_material = step->GetPreStepPoint()->GetMaterial();
-    auto density = current_material->GetDensity() / CLHEP::g * CLHEP::cm3;
-    const G4ParticleDefinition *p = step->GetTrack()->GetParticleDefinition();
-
-    auto energy1 = step->GetPreStepPoint()->GetKineticEnergy() / CLHEP::MeV;
-    auto energy2 = step->GetPostStepPoint()->GetKineticEnergy() / CLHEP::MeV;
-    auto energy = (energy1 + energy2) / 2;
+    auto *current_material = context.GetMaterial();
+    auto density = context.GetDensity() / CLHEP::g * CLHEP::cm3;
     // Accounting for particles with dedx=0; i.e. gamma and neutrons
     // For gamma we consider the dedx of electrons instead - testing
     // with 1.3 MeV photon beam or 150 MeV protons or 1500 MeV carbon ion
@@ -145,19 +395,16 @@ void GateLETActor::SteppingAction(G4Step *step) {
     //		when comparing dose and dosetowater in the material
     // G4_WATER (we are systematically missing a little bit of dose of
     // course with this solution)
-
-    if (p == G4Gamma::Gamma()) {
-      p = G4Electron::Electron();
-    }
+    // (see GateStepContext::GetDEDXParticle, the dE/dx is computed at the
+    // mean energy of the step)
     auto &l = fThreadLocalData.Get();
-    auto dedx_currstep =
-        l.emcalc.ComputeElectronicDEDX(energy, p, current_material, dedx_cut) /
-        CLHEP::MeV * CLHEP::mm;
+    auto dedx_currstep = context.GetDEDX(l.dedx_table, current_material) /
+                         CLHEP::MeV * CLHEP::mm;
 
-    if (fScoreInOtherMaterial) {
-      auto dedx_other_material = l.emcalc.ComputeElectronicDEDX(
-                                     energy, p, l.materialToScoreIn, dedx_cut) /
-                                 CLHEP::MeV * CLHEP::mm;
+    if constexpr (OtherMaterial) {
+      auto dedx_other_material =
+          context.GetDEDX(l.dedx_table, l.materialToScoreIn) / CLHEP::MeV *
+          CLHEP::mm;
 
       // Do we not need to consider the density ratio as well?
       //      auto density_other_material = l.materialToScoreIn->GetDensity() /
@@ -174,21 +421,91 @@ void GateLETActor::SteppingAction(G4Step *step) {
     double scor_val_num = 0.;
     double scor_val_den = 0.;
 
-    if (fAveragingMethod == "dose_average") {
+    if constexpr (DoseAverage) {
       scor_val_num = edep * dedx_currstep / CLHEP::MeV / CLHEP::MeV * CLHEP::mm;
       scor_val_den = edep / CLHEP::MeV;
-    } else if (fAveragingMethod == "track_average") {
+    } else {
       auto steplength = step->GetStepLength() / CLHEP::mm;
       scor_val_num = steplength * dedx_currstep * w / CLHEP::MeV;
       scor_val_den = steplength * w / CLHEP::mm;
     }
-    // Call ImageAddValue() in a mutexed {}-scope
-    {
-      G4AutoLock mutex(&SetLETPixelMutex);
-      ImageAddValue<ImageType>(cpp_numerator_image, index, scor_val_num);
-      ImageAddValue<ImageType>(cpp_denominator_image, index, scor_val_den);
+    if (fSpectrumNumberOfBins > 0 && scor_val_den > 0) {
+      // (the offset is the flat index of the voxel, x fastest)
+      auto voxel = cpp_numerator_image->ComputeOffset(index);
+      l.spectrum[SpectrumKey(voxel, GetSpectrumBin(dedx_currstep))] +=
+          scor_val_den;
+    }
+    if (fScoringMode == ScoringMode::Sparse) {
+      l.numerator_worker_sparseimg.GetValue(index[0], index[1], index[2]) +=
+          scor_val_num;
+      l.denominator_worker_sparseimg.GetValue(index[0], index[1], index[2]) +=
+          scor_val_den;
+    } else if (fScoringMode == ScoringMode::Queue) {
+      // no lock: the deposit is applied later, with the other ones of the
+      // batch
+      if (l.deposit_queue.Push(index[0], index[1], index[2],
+                               {scor_val_num, scor_val_den})) {
+        FlushDepositQueue(l);
+      }
+    } else {
+      // both images share the same geometry: the offset is computed once
+      auto offset = cpp_numerator_image->ComputeOffset(index);
+      if (fScoringMode == ScoringMode::ThreadLocal && fFloatBufferFlag) {
+        l.numden_worker_flatimg_float[2 * offset] += scor_val_num;
+        l.numden_worker_flatimg_float[2 * offset + 1] += scor_val_den;
+      } else if (fScoringMode == ScoringMode::ThreadLocal) {
+        l.numden_worker_flatimg[2 * offset] += scor_val_num;
+        l.numden_worker_flatimg[2 * offset + 1] += scor_val_den;
+      } else if (fScoringMode == ScoringMode::Atomic) {
+        ImageAtomicAddValueAtOffset<ImageType>(cpp_numerator_image, offset,
+                                               scor_val_num);
+        ImageAtomicAddValueAtOffset<ImageType>(cpp_denominator_image, offset,
+                                               scor_val_den);
+      } else {
+        // Call ImageAddValueAtOffset() in a mutexed {}-scope
+        GateAutoLock mutex(&SetLETPixelMutex);
+        ImageAddValueAtOffset<ImageType>(cpp_numerator_image, offset,
+                                         scor_val_num);
+        ImageAddValueAtOffset<ImageType>(cpp_denominator_image, offset,
+                                         scor_val_den);
+      }
     }
   } // else : outside the image
 }
 
+template <HitType H> void GateLETActor::SelectSteppingKernel() {
+  if (fScoreInOtherMaterial) {
+    if (fdoseAverage)
+      fSteppingKernel = &GateLETActor::SteppingKernel<H, true, true>;
+    else
+      fSteppingKernel = &GateLETActor::SteppingKernel<H, true, false>;
+  } else {
+    if (fdoseAverage)
+      fSteppingKernel = &GateLETActor::SteppingKernel<H, false, true>;
+    else
+      fSteppingKernel = &GateLETActor::SteppingKernel<H, false, false>;
+  }
+}
+
+void GateLETActor::SelectSteppingKernel() {
+  switch (fHitType) {
+  case HitType::Pre:
+    SelectSteppingKernel<HitType::Pre>();
+    break;
+  case HitType::Post:
+    SelectSteppingKernel<HitType::Post>();
+    break;
+  case HitType::Middle:
+    SelectSteppingKernel<HitType::Middle>();
+    break;
+  case HitType::Random:
+    SelectSteppingKernel<HitType::Random>();
+    break;
+  case HitType::Segment:
+    Fatal("Error in GateLETActor: hit_type 'segment' is not available, use "
+          "'pre', 'post', 'middle' or 'random'.");
+    break;
+  }
+}
+
 void GateLETActor::EndSimulationAction() {}
@@ -12,15 +12,26 @@
 #include "G4EmCalculator.hh"
 #include "G4NistManager.hh"
 #include "G4VPrimitiveScorer.hh"
+#include "GateDepositQueue.h"
+#include "GateHelpersImage.h"
+#include "GateImageSnapshot.h"
+#include "GateSparseImage.h"
+#include "GateStoppingPowerTable.h"
 #include "GateVActor.h"
 #include "itkImage.h"
+#include <atomic>
+#include <cstdint>
 #include <pybind11/stl.h>
+#include <unordered_map>
 
 namespace py = pybind11;
 
 class GateLETActor : public GateVActor {
 
 public:
+  // How the voxel values are accumulated in the shared images
+  enum ScoringMode { Mutex, ThreadLocal, Atomic, Sparse, Queue };
+
   // Constructor
   GateLETActor(py::dict &user_info);
 
@@ -28,16 +39,26 @@ public:
 
   void InitializeCpp() override;
 
+  void StartSimulationAction() override;
+
   // Main function called every step in attached volume
   void SteppingAction(G4Step *) override;
 
   void BeginOfEventAction(const G4Event *event) override;
 
+  void EndOfEventAction(const G4Event *event) override;
+
   // Called every time a Run starts (all threads)
   void BeginOfRunAction(const G4Run *run) override;
 
   void BeginOfRunActionMasterThread(int run_id) override;
 
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Sparse scoring mode: the dense images are created here (output)
+  int EndOfRunActionMasterThread(int run_id) override;
+
   void EndSimulationAction() override;
 
   inline std::string GetPhysicalVolumeName() const {
@@ -65,19 +86,122 @@ public:
 
   int NbOfEvent = 0;
 
+  // Copy the current numerator and denominator into the snapshots, while the
+  // workers keep on scoring (see GateDoseActor::TakeSnapshot)
+  void TakeSnapshot();
+
+  GateImageSnapshot fNumeratorSnapshot;
+  GateImageSnapshot fDenominatorSnapshot;
+
+  // Number of events of the current run, only counted when the snapshots
+  // are enabled (NbOfEvent is known at the end of the run)
+  std::atomic<int> fSnapshotNbOfEvent{0};
+
+  // Option: LET spectrum of each voxel, with fSpectrumNumberOfBins bins
+  // (0: disabled) of constant width in log(LET) between fSpectrumMin and
+  // fSpectrumMax (in MeV/mm). The values are the denominator of the
+  // averaging method (edep or track length), as for the mean LET.
+  int fSpectrumNumberOfBins = 0;
+  double fSpectrumMin = 0;
+  double fSpectrumMax = 0;
+
+  // Bin of the LET (MeV/mm), the LET outside the range are counted in the
+  // first or last bin
+  int GetSpectrumBin(double let) const;
+
+  // Number of non zero elements of the spectra
+  size_t GetNumberOfSpectrumElements() const { return fSpectrum.size(); }
+
+  // Non zero elements of the spectra (key, value), sorted by voxel then bin
+  std::vector<std::pair<std::uint64_t, double>>
+  GetSortedSpectrumElements() const;
+
+  // key of an element: flat voxel index (same as the image, x fastest) in
+  // the high bits, bin in the low 16 bits
+  static std::uint64_t SpectrumKey(itk::OffsetValueType voxel, int bin) {
+    return (static_cast<std::uint64_t>(voxel) << 16) |
+           static_cast<std::uint64_t>(bin);
+  }
+
+  static std::uint64_t SpectrumKeyToVoxel(std::uint64_t key) {
+    return key >> 16;
+  }
+
+  static int SpectrumKeyToBin(std::uint64_t key) {
+    return static_cast<int>(key & 0xFFFFu);
+  }
+
 private:
   double fVoxelVolume;
 
   G4ThreeVector fInitialTranslation;
-  std::string fHitType;
+  HitType fHitType = HitType::Random;
+
+  // Stepping kernel specialized for the hit type, the material to score in
+  // and the averaging method, selected once in InitializeCpp
+  template <HitType H, bool OtherMaterial, bool DoseAverage>
+  void SteppingKernel(G4Step *step);
+
+  template <HitType H> void SelectSteppingKernel();
+
+  void SelectSteppingKernel();
+
+  typedef void (GateLETActor::*SteppingKernelType)(G4Step *);
+  SteppingKernelType fSteppingKernel{};
+
+  // world to voxel index transform of the scored images
+  GateImageIndexTransform fIndexTransform;
 
   bool fScoreInOtherMaterial = false;
 
+  // Option: use tabulated stopping powers instead of computing them at each
+  // step
+  bool fStoppingPowerTableFlag = true;
+
+  // Option: mutex, per-thread images, lock-free atomic additions,
+  // per-thread sparse images or per-thread queues of deposits
+  ScoringMode fScoringMode = ScoringMode::Mutex;
+
+  // Option: number of deposits per thread applied at once (Queue scoring
+  // mode)
+  int fQueueSize = 4096;
+
+  // Sparse scoring mode: the sparse images of the threads are merged in
+  // these ones, the dense images are only allocated at the end of the run
+  GateSparseImage<double> fNumeratorSparseImage;
+  GateSparseImage<double> fDenominatorSparseImage;
+
+  // Option: the per-thread buffer of the ThreadLocal scoring mode is stored
+  // in float (half of the memory), the shared images stay in double
+  bool fFloatBufferFlag = false;
+
+  // merged spectra of all threads and runs (sparse, see SpectrumKey)
+  typedef std::unordered_map<std::uint64_t, double> SpectrumType;
+  SpectrumType fSpectrum;
+  double fSpectrumLogMin = 0;
+  double fSpectrumLogBinWidth = 1;
+
   struct threadLocalT {
-    G4EmCalculator emcalc;
+    GateStoppingPowerTable dedx_table{GateStoppingPowerTable::Electronic};
     G4Material *materialToScoreIn;
+    // per-thread sparse images (Sparse scoring mode only)
+    GateSparseImage<double> numerator_worker_sparseimg;
+    GateSparseImage<double> denominator_worker_sparseimg;
+    // per-thread numerator and denominator, interleaved per voxel
+    // (ThreadLocal scoring mode only)
+    std::vector<double> numden_worker_flatimg;
+    std::vector<float> numden_worker_flatimg_float;
+    // deferred numerator and denominator deposits, applied by batches
+    // sorted by tile (Queue scoring mode only)
+    GateDepositQueue<2> deposit_queue;
+    // number of events of this thread in the current run
+    int number_of_events = 0;
+    // spectra of this thread, merged at the end of the run
+    SpectrumType spectrum;
   };
   G4Cache<threadLocalT> fThreadLocalData;
+
+  void FlushDepositQueue(threadLocalT &l);
 };
 
 #endif // GateLETActor_h
@@ -0,0 +1,223 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateMappedImageFile.h"
+#include "GateHelpers.h"
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// the mapping offsets must be multiples of this size
+size_t MappingGranularity() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwAllocationGranularity;
+#else
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::string RawFilename(const std::string &filename) {
+  auto n = filename.size();
+  if (n > 4 && filename.compare(n - 4, 4, ".mhd") == 0)
+    return filename.substr(0, n - 4) + ".raw";
+  return filename + ".raw";
+}
+} // namespace
+
+GateMappedImageFile::GateMappedImageFile() {
+  fNumberOfPixels = 0;
+  fNumberOfFrames = 0;
+  fMapping = nullptr;
+  fMappingSize = 0;
+  for (int i = 0; i < 3; i++) {
+    fSize[i] = 0;
+    fSpacing[i] = 1.0;
+    fOrigin[i] = 0.0;
+  }
+#ifdef _WIN32
+  fFileHandle = nullptr;
+  fMappingHandle = nullptr;
+#else
+  fFileDescriptor = -1;
+#endif
+}
+
+GateMappedImageFile::~GateMappedImageFile() { Close(); }
+
+void GateMappedImageFile::Open(const std::string &filename,
+                               const size_t size[3], const double spacing[3],
+                               const double origin[3]) {
+  Close();
+  fFilename = filename;
+  fRawFilename = RawFilename(filename);
+  for (int i = 0; i < 3; i++) {
+    fSize[i] = size[i];
+    fSpacing[i] = spacing[i];
+    fOrigin[i] = origin[i];
+  }
+  std::ostringstream oss;
+  oss << "Cannot create the image file '" << fRawFilename << "'";
+#ifdef _WIN32
+  auto file = CreateFileA(fRawFilename.c_str(), GENERIC_READ | GENERIC_WRITE,
+                          0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                          nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    Fatal(oss.str());
+  fFileHandle = file;
+#else
+  fFileDescriptor =
+      open(fRawFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fFileDescriptor < 0)
+    Fatal(oss.str());
+#endif
+  fNumberOfPixels = size[0] * size[1] * size[2];
+  fNumberOfFrames = 0;
+  WriteHeader();
+}
+
+void GateMappedImageFile::Close() {
+  Unmap();
+  if (IsOpen())
+    WriteHeader();
+#ifdef _WIN32
+  if (fFileHandle != nullptr)
+    CloseHandle(fFileHandle);
+  fFileHandle = nullptr;
+#else
+  if (fFileDescriptor >= 0)
+    close(fFileDescriptor);
+  fFileDescriptor = -1;
+#endif
+  fNumberOfPixels = 0;
+  fNumberOfFrames = 0;
+}
+
+void GateMappedImageFile::AddFrame(size_t frame, const double *values) {
+  UpdateFrame(frame, [&](double *pixels) {
+    // the zero values are skipped, their pages are not touched
+    for (size_t i = 0; i < fNumberOfPixels; i++) {
+      if (values[i] != 0)
+        pixels[i] += values[i];
+    }
+  });
+}
+
+void GateMappedImageFile::UpdateFrame(
+    size_t frame, const std::function<void(double *)> &update) {
+  if (!IsOpen())
+    Fatal("GateMappedImageFile: frame updated before Open");
+  auto frame_size = fNumberOfPixels * sizeof(double);
+  bool new_frames = frame >= fNumberOfFrames;
+  if (new_frames) {
+    // the new bytes are zeros (holes in sparse files)
+    Resize((frame + 1) * frame_size);
+    fNumberOfFrames = frame + 1;
+  }
+  update(reinterpret_cast<double *>(Map(frame * frame_size, frame_size)));
+  Unmap();
+  if (new_frames)
+    WriteHeader();
+}
+
+void GateMappedImageFile::WriteHeader() {
+  std::ofstream f(fFilename);
+  if (!f)
+    Fatal("Cannot write the image header '" + fFilename + "'");
+  auto raw = fRawFilename.substr(fRawFilename.find_last_of("/\\") + 1);
+  f.precision(17);
+  f << "ObjectType = Image\n"
+    << "NDims = 4\n"
+    << "BinaryData = True\n"
+    << "BinaryDataByteOrderMSB = False\n"
+    << "CompressedData = False\n"
+    << "TransformMatrix = 1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1\n"
+    << "Offset = " << fOrigin[0] << " " << fOrigin[1] << " " << fOrigin[2]
+    << " 0\n"
+    << "ElementSpacing = " << fSpacing[0] << " " << fSpacing[1] << " "
+    << fSpacing[2] << " 1\n"
+    << "DimSize = " << fSize[0] << " " << fSize[1] << " " << fSize[2] << " "
+    << fNumberOfFrames << "\n"
+    << "ElementType = MET_DOUBLE\n"
+    << "ElementDataFile = " << raw << "\n";
+}
+
+char *GateMappedImageFile::Map(size_t offset, size_t size) {
+  auto aligned = offset - offset % MappingGranularity();
+  fMappingSize = size + (offset - aligned);
+#ifdef _WIN32
+  fMappingHandle =
+      CreateFileMappingA(fFileHandle, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (fMappingHandle != nullptr)
+    fMapping = static_cast<char *>(MapViewOfFile(
+        fMappingHandle, FILE_MAP_WRITE, static_cast<DWORD>(aligned >> 32),
+        static_cast<DWORD>(aligned & 0xFFFFFFFF), fMappingSize));
+#else
+  auto *p = mmap(nullptr, fMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fFileDescriptor, static_cast<off_t>(aligned));
+  if (p != MAP_FAILED)
+    fMapping = static_cast<char *>(p);
+#endif
+  if (fMapping == nullptr) {
+    Unmap();
+    Fatal("Cannot map the image file '" + fRawFilename + "' in memory");
+  }
+  return fMapping + (offset - aligned);
+}
+
+void GateMappedImageFile::Unmap() {
+  // the dirty pages are written asynchronously, the call does not wait
+#ifdef _WIN32
+  if (fMapping != nullptr) {
+    FlushViewOfFile(fMapping, 0);
+    UnmapViewOfFile(fMapping);
+  }
+  if (fMappingHandle != nullptr)
+    CloseHandle(fMappingHandle);
+  fMappingHandle = nullptr;
+#else
+  if (fMapping != nullptr) {
+    msync(fMapping, fMappingSize, MS_ASYNC);
+    munmap(fMapping, fMappingSize);
+  }
+#endif
+  fMapping = nullptr;
+  fMappingSize = 0;
+}
+
+void GateMappedImageFile::Resize(size_t size) {
+  bool ok;
+#ifdef _WIN32
+  LARGE_INTEGER s;
+  s.QuadPart = static_cast<LONGLONG>(size);
+  ok = SetFilePointerEx(fFileHandle, s, nullptr, FILE_BEGIN) &&
+       SetEndOfFile(fFileHandle);
+#else
+  ok = ftruncate(fFileDescriptor, static_cast<off_t>(size)) == 0;
+#endif
+  if (!ok) {
+    std::ostringstream oss;
+    oss << "Cannot extend the image file '" << fRawFilename << "' to " << size
+        << " bytes";
+    Fatal(oss.str());
+  }
+}
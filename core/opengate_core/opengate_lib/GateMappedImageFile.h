@@ -0,0 +1,90 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateMappedImageFile_h
+#define GateMappedImageFile_h
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/*
+    Image written on disk frame by frame, as a 4D MHD header (x, y, z, frame)
+    and a raw file of double values. The raw file grows by one frame at a
+    time and only the current frame is memory-mapped: the values are added
+    in the mapped pages, and the system writes them to disk asynchronously
+    (the pages are released when the frame is done). Only the non zero
+    values are written, so the pages that are never touched stay holes of
+    the file on the file systems that support sparse files.
+
+    This is intended for outputs larger than the memory, e.g. one image per
+    run. Not thread safe: the frames are added by the master thread.
+ */
+
+class GateMappedImageFile {
+public:
+  GateMappedImageFile();
+
+  ~GateMappedImageFile();
+
+  GateMappedImageFile(const GateMappedImageFile &) = delete;
+
+  GateMappedImageFile &operator=(const GateMappedImageFile &) = delete;
+
+  // Create (or overwrite) the mhd and raw files, with no frame (Fatal if the
+  // files cannot be created). The raw file is next to the mhd file.
+  void Open(const std::string &filename, const size_t size[3],
+            const double spacing[3], const double origin[3]);
+
+  // Write the header and release the files
+  void Close();
+
+  bool IsOpen() const { return fNumberOfPixels > 0; }
+
+  const std::string &GetFilename() const { return fFilename; }
+
+  size_t GetNumberOfFrames() const { return fNumberOfFrames; }
+
+  // Add the values of an image (same size) to the frame, the file is
+  // extended if needed (the new frames are filled with zeros)
+  void AddFrame(size_t frame, const double *values);
+
+  // Call update(pixels) with the values of the frame mapped in memory (the
+  // file is extended if needed), e.g. to add a sparse image
+  void UpdateFrame(size_t frame, const std::function<void(double *)> &update);
+
+protected:
+  void WriteHeader();
+
+  // Map the bytes [offset, offset + size[ of the raw file
+  char *Map(size_t offset, size_t size);
+
+  void Unmap();
+
+  void Resize(size_t size);
+
+  std::string fFilename;
+  std::string fRawFilename;
+  size_t fSize[3];
+  double fSpacing[3];
+  double fOrigin[3];
+  size_t fNumberOfPixels;
+  size_t fNumberOfFrames;
+
+  // current mapping (the offset is aligned on the allocation granularity)
+  char *fMapping;
+  size_t fMappingSize;
+
+#ifdef _WIN32
+  void *fFileHandle;
+  void *fMappingHandle;
+#else
+  int fFileDescriptor;
+#endif
+};
+
+#endif // GateMappedImageFile_h
@@ -10,12 +10,27 @@
 #include "GateMuDatabase.h"
 #include "GateMuTables.h"
 
+#include "G4AutoLock.hh"
 #include "G4Gamma.hh"
 #include "G4ProcessManager.hh"
 #include "G4ProcessVector.hh"
 #include "G4ProductionCutsTable.hh"
 #include "G4VAtomDeexcitation.hh"
 #include "G4VEmProcess.hh"
+#include "GateMemoryAccounting.h"
+#include "GateMutex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <thread>
+
+GATE_MUTEX(MuHandlerInitMutex);
 
 // GateMaterialMuHandler *GateMaterialMuHandler::fSingletonMaterialMuHandler =
 // nullptr;
@@ -52,14 +67,13 @@ GateMaterialMuHandler::GateMaterialMuHandler() {
   fPrecision = 0.01;
   fLastCouple = nullptr;
   fLastMuTable = nullptr;
+  fLookupBinsPerDecade = 200;
 }
 
 GateMaterialMuHandler::~GateMaterialMuHandler() { delete[] fElementsTable; }
 
 void GateMaterialMuHandler::CheckLastCall(const G4MaterialCutsCouple *couple) {
-  if (!fIsInitialized) {
-    Initialize();
-  }
+  CheckInitialized();
   if (couple != fLastCouple) {
     fLastCouple = couple;
     fLastMuTable = fCoupleTable[fLastCouple];
@@ -67,32 +81,55 @@ void GateMaterialMuHandler::CheckLastCall(const G4MaterialCutsCouple *couple) {
 }
 
 double GateMaterialMuHandler::GetDensity(const G4MaterialCutsCouple *couple) {
-  CheckLastCall(couple);
-  return fLastMuTable->GetDensity();
+  CheckInitialized();
+  return GetNodeLookupTable().GetDensity(couple->GetIndex());
 }
 
 double GateMaterialMuHandler::GetMuEnOverRho(const G4MaterialCutsCouple *couple,
                                              double energy) {
-  CheckLastCall(couple);
-  return fLastMuTable->GetMuEnOverRho(energy);
+  CheckInitialized();
+  return GetNodeLookupTable().GetMuEnOverRho(couple->GetIndex(), energy);
 }
 
 double GateMaterialMuHandler::GetMuEn(const G4MaterialCutsCouple *couple,
                                       double energy) {
-  CheckLastCall(couple);
-  return fLastMuTable->GetMuEn(energy);
+  CheckInitialized();
+  auto index = couple->GetIndex();
+  const auto &table = GetNodeLookupTable();
+  return table.GetMuEnOverRho(index, energy) * table.GetDensity(index);
 }
 
 double GateMaterialMuHandler::GetMuOverRho(const G4MaterialCutsCouple *couple,
                                            double energy) {
-  CheckLastCall(couple);
-  return fLastMuTable->GetMuOverRho(energy);
+  CheckInitialized();
+  return GetNodeLookupTable().GetMuOverRho(couple->GetIndex(), energy);
 }
 
 double GateMaterialMuHandler::GetMu(const G4MaterialCutsCouple *couple,
                                     double energy) {
-  CheckLastCall(couple);
-  return fLastMuTable->GetMu(energy);
+  CheckInitialized();
+  auto index = couple->GetIndex();
+  const auto &table = GetNodeLookupTable();
+  return table.GetMuOverRho(index, energy) * table.GetDensity(index);
+}
+
+std::vector<double> GateMaterialMuHandler::GetMuOfAllCouples(double energy) {
+  const auto &table = GetLookupTable();
+  auto n = static_cast<size_t>(table.GetNumberOfCouples());
+  std::vector<int> indices(n);
+  std::vector<double> energies(n, energy);
+  std::vector<double> mu(n);
+  for (size_t i = 0; i < n; i++)
+    indices[i] = static_cast<int>(i);
+  table.GetMuOverRho(n, indices.data(), energies.data(), mu.data());
+  for (size_t i = 0; i < n; i++)
+    mu[i] *= table.GetDensity(static_cast<int>(i));
+  return mu;
+}
+
+const GateMuLookupTable &GateMaterialMuHandler::GetLookupTable() {
+  CheckInitialized();
+  return GetNodeLookupTable();
 }
 
 GateMuTable *
@@ -107,6 +144,8 @@ inline double interpolation(double Xa, double Xb, double Ya, double Yb,
 }
 
 void GateMaterialMuHandler::Initialize() {
+  // the tables may be requested concurrently by several worker threads
+  GateAutoLock mutex(&MuHandlerInitMutex);
   if (fIsInitialized)
     return;
 
@@ -117,31 +156,33 @@ void GateMaterialMuHandler::Initialize() {
 
     G4ProductionCutsTable *productionCutList =
         G4ProductionCutsTable::GetProductionCutsTable();
-    std::map<const G4MaterialCutsCouple *, GateMuTable *>::iterator it;
 
+    // one table per composition, shared by all the couples of this material
+    // and of the materials that only differ by their density (same base
+    // material): mu/rho does not depend on the density
+    std::map<const G4Material *, const G4MaterialCutsCouple *> firstCouple;
+    for (auto &ct : fCoupleTable)
+      firstCouple.emplace(GetTableMaterial(ct.first), ct.first);
+    std::vector<const G4MaterialCutsCouple *> couplesToConstruct;
     for (G4int m = 0; m < productionCutList->GetTableSize(); m++) {
       const G4MaterialCutsCouple *couple =
           productionCutList->GetMaterialCutsCouple(m);
-      it = fCoupleTable.find(couple);
-      if (it == fCoupleTable.end()) {
-        const G4Material *material = couple->GetMaterial();
-        bool materialNotExist = true;
-        auto it2 = fCoupleTable.begin();
-
-        while (it2 != fCoupleTable.end()) {
-          if (it2->first->GetMaterial() == material) {
-            fCoupleTable.insert(
-                std::pair<const G4MaterialCutsCouple *, GateMuTable *>(
-                    couple, it2->second));
-            materialNotExist = false;
-            break;
-          }
-          it2++;
-        }
+      if (firstCouple.emplace(GetTableMaterial(couple), couple).second)
+        couplesToConstruct.push_back(couple);
+    }
 
-        if (materialNotExist) {
-          ConstructMaterial(couple);
-        }
+    // the materials are independent: build their tables in parallel, then
+    // insert them
+    auto tables = ConstructMaterials(couplesToConstruct);
+    for (size_t i = 0; i < tables.size(); i++)
+      fCoupleTable.emplace(couplesToConstruct[i], tables[i]);
+
+    for (G4int m = 0; m < productionCutList->GetTableSize(); m++) {
+      const G4MaterialCutsCouple *couple =
+          productionCutList->GetMaterialCutsCouple(m);
+      if (fCoupleTable.find(couple) == fCoupleTable.end()) {
+        auto *table = fCoupleTable[firstCouple[GetTableMaterial(couple)]];
+        fCoupleTable.emplace(couple, table);
       }
     }
   } else {
@@ -154,11 +195,78 @@ void GateMaterialMuHandler::Initialize() {
     Fatal(oss.str());
   }
 
+  BuildLookupTable();
   fIsInitialized = true;
 }
 
-void GateMaterialMuHandler::ConstructMaterial(
-    const G4MaterialCutsCouple *couple) {
+const G4Material *
+GateMaterialMuHandler::GetTableMaterial(const G4MaterialCutsCouple *couple) {
+  const auto *material = couple->GetMaterial();
+  const auto *base = material->GetBaseMaterial();
+  return base != nullptr ? base : material;
+}
+
+void GateMaterialMuHandler::BuildLookupTable() {
+  // couple tables and densities ordered by couple index (a table may be
+  // shared by materials of different densities)
+  G4ProductionCutsTable *productionCutList =
+      G4ProductionCutsTable::GetProductionCutsTable();
+  auto n = static_cast<size_t>(productionCutList->GetTableSize());
+  std::vector<const GateMuTable *> tables(n, nullptr);
+  std::vector<double> densities(n, -1.0);
+  for (G4int m = 0; m < productionCutList->GetTableSize(); m++) {
+    const G4MaterialCutsCouple *couple =
+        productionCutList->GetMaterialCutsCouple(m);
+    auto it = fCoupleTable.find(couple);
+    if (it != fCoupleTable.end()) {
+      tables[couple->GetIndex()] = it->second;
+      densities[couple->GetIndex()] =
+          couple->GetMaterial()->GetDensity() / (CLHEP::g / CLHEP::cm3);
+    }
+  }
+  fLookupTable.Build(tables, densities, fLookupBinsPerDecade);
+  fLookupTableReplica.Clear();
+
+  // tables of the materials (energy, mu, mu_en) and flat lookup table
+  if (GateMemoryAccounting::IsEnabled()) {
+    std::set<const GateMuTable *> distinct(tables.begin(), tables.end());
+    auto bytes = fLookupTable.GetMemoryBytes();
+    for (const auto *t : distinct) {
+      if (t != nullptr)
+        bytes += 3 * t->GetSize() * sizeof(double);
+    }
+    GateMemoryAccounting::Update("mu_tables", fDatabaseName, bytes);
+  }
+}
+
+std::vector<GateMuTable *> GateMaterialMuHandler::ConstructMaterials(
+    const std::vector<const G4MaterialCutsCouple *> &couples) const {
+  std::vector<GateMuTable *> tables(couples.size(), nullptr);
+  auto nb_threads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), couples.size());
+  if (nb_threads <= 1) {
+    for (size_t i = 0; i < couples.size(); i++)
+      tables[i] = ConstructMaterial(couples[i]);
+    return tables;
+  }
+
+  // ConstructMaterial only reads the element tables, each thread takes the
+  // next material to build until there is none left
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (auto i = next++; i < couples.size(); i = next++)
+      tables[i] = ConstructMaterial(couples[i]);
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < nb_threads; t++)
+    threads.emplace_back(worker);
+  for (auto &t : threads)
+    t.join();
+  return tables;
+}
+
+GateMuTable *GateMaterialMuHandler::ConstructMaterial(
+    const G4MaterialCutsCouple *couple) const {
   const G4Material *material = couple->GetMaterial();
 
   int nb_e = 0;
@@ -251,9 +359,6 @@ void GateMaterialMuHandler::ConstructMaterial(
     table->PutValue(i, log(energies[i]), log(Mu[i]), log(MuEn[i]));
   }
 
-  fCoupleTable.insert(
-      std::pair<const G4MaterialCutsCouple *, GateMuTable *>(couple, table));
-
   delete[] energies;
   delete[] index;
   delete[] e_tables;
@@ -261,6 +366,7 @@ void GateMaterialMuHandler::ConstructMaterial(
   delete[] mu_en_tables;
   delete[] MuEn;
   delete[] Mu;
+  return table;
 }
 
 void GateMaterialMuHandler::InitElementTable() {
@@ -303,12 +409,77 @@ void GateMaterialMuHandler::SimulateMaterialTable() {
         G4LossTableManager::Instance()->AtomDeexcitation()->IsFluoActive();
   }
 
-  // Find photoelectric (PE), compton scattering (CS) (+ particleChange) and
-  // rayleigh scattering (RS) models
+  // Find the photoelectric (PE), compton scattering (CS) and rayleigh
+  // scattering (RS) processes. With the Geant4 "general gamma process" (the
+  // default of most physics lists), they are sub-processes of it.
+  auto findProcess = [&](std::initializer_list<const char *> names) {
+    for (G4int i = 0; i < processListForGamma->size(); i++) {
+      auto *emProcess = dynamic_cast<G4VEmProcess *>((*processListForGamma)[i]);
+      if (emProcess == nullptr)
+        continue;
+      for (auto name : names) {
+        auto *p = emProcess->GetEmProcess(name);
+        if (p != nullptr)
+          return p;
+      }
+    }
+    return static_cast<G4VEmProcess *>(nullptr);
+  };
+  G4VEmProcess *processPE = findProcess({"phot", "PhotoElectric"});
+  G4VEmProcess *processCS = findProcess({"compt", "Compton"});
+  G4VEmProcess *processRS = findProcess({"Rayl", "RayleighScattering"});
+  if (processPE == nullptr && processCS == nullptr) {
+    std::ostringstream oss;
+    oss << "GateMaterialMuHandler -- the 'simulated' mu/mu_en database needs "
+           "the photoelectric or the compton process of the gammas, none "
+           "found in the physics list";
+    Fatal(oss.str());
+  }
+
+  // Get the G4VParticleChange of compton scattering (filled by its models)
+  // by running a fictive step (no simple 'get' function available)
+  G4ParticleChangeForGamma *particleChangeCS = nullptr;
+  if (processCS != nullptr) {
+    G4Track myTrack(
+        new G4DynamicParticle(gamma, G4ThreeVector(1., 0., 0.), 0.01), 0.,
+        G4ThreeVector(0., 0., 0.));
+    myTrack.SetTrackStatus(fStopButAlive); // to get a fast return (see
+                                           // G4VEmProcess::PostStepDoIt(...))
+    G4Step myStep;
+    particleChangeCS = dynamic_cast<G4ParticleChangeForGamma *>(
+        processCS->PostStepDoIt((const G4Track)(myTrack), myStep));
+    if (particleChangeCS == nullptr) {
+      std::ostringstream oss;
+      oss << "GateMaterialMuHandler -- cannot get the particle change of the "
+             "compton process '"
+          << processCS->GetProcessName()
+          << "', the 'simulated' mu/mu_en database cannot be used";
+      Fatal(oss.str());
+    }
+  }
+
+  // Identify the gamma physics (processes and models) for the table cache
+  std::string physicsKey;
+  if (!fCacheFolder.empty()) {
+    std::ostringstream oss;
+    oss << "fluo=" << isFluoActive;
+    for (auto *emProcess : {processPE, processCS, processRS}) {
+      if (emProcess == nullptr)
+        continue;
+      oss << "," << emProcess->GetProcessName();
+      for (G4int j = 0; j < emProcess->NumberOfModels(); j++) {
+        auto *model = emProcess->GetModelByIndex(j);
+        if (model != nullptr)
+          oss << ":" << model->GetName();
+      }
+    }
+    physicsKey = oss.str();
+  }
+
+  // Models of the processes, selected according to the gamma energy
   G4VEmModel *modelPE = nullptr;
   G4VEmModel *modelCS = nullptr;
   G4VEmModel *modelRS = nullptr;
-  G4ParticleChangeForGamma *particleChangeCS = nullptr;
 
   // Useful members for the loops
   // cuts and materials
@@ -361,6 +532,20 @@ void GateMaterialMuHandler::SimulateMaterialTable() {
       double energyCutForGamma = productionCutList->ConvertRangeToEnergy(
           gamma, material,
           couple->GetProductionCuts()->GetProductionCut("gamma"));
+
+      // Reuse the table of a previous job if available
+      std::string cacheKey;
+      if (!fCacheFolder.empty()) {
+        cacheKey = SimulatedTableKey(couple, energyCutForGamma, physicsKey);
+        auto *cached = LoadCachedTable(couple, cacheKey);
+        if (cached != nullptr) {
+          fCoupleTable.insert(
+              std::pair<const G4MaterialCutsCouple *, GateMuTable *>(couple,
+                                                                     cached));
+          continue;
+        }
+      }
+
       // Construct energy list (energy, atomicShellEnergy)
       ConstructEnergyList(&muStorage, material);
 
@@ -370,37 +555,16 @@ void GateMaterialMuHandler::SimulateMaterialTable() {
         primary.SetKineticEnergy(incidentEnergy);
 
         // find the physical models according to the gamma energy
-        for (G4int i = 0; i < processListForGamma->size(); i++) {
-          size_t physicRegionNumber = 0;
-          G4String processName = (*processListForGamma)[i]->GetProcessName();
-          if (processName == "PhotoElectric" || processName == "phot") {
-            modelPE = (dynamic_cast<G4VEmProcess *>((*processListForGamma)[i]))
-                          ->SelectModelForMaterial(incidentEnergy,
-                                                   physicRegionNumber);
-          } else if (processName == "Compton" || processName == "compt") {
-            auto *processCS =
-                dynamic_cast<G4VEmProcess *>((*processListForGamma)[i]);
-            modelCS = processCS->SelectModelForMaterial(incidentEnergy,
-                                                        physicRegionNumber);
-
-            // Get the G4VParticleChange of compton scattering by running a
-            // fictive step (no simple 'get' function available)
-            G4Track myTrack(
-                new G4DynamicParticle(gamma, G4ThreeVector(1., 0., 0.), 0.01),
-                0., G4ThreeVector(0., 0., 0.));
-            myTrack.SetTrackStatus(
-                fStopButAlive); // to get a fast return (see
-                                // G4VEmProcess::PostStepDoIt(...))
-            G4Step myStep;
-            particleChangeCS = dynamic_cast<G4ParticleChangeForGamma *>(
-                processCS->PostStepDoIt((const G4Track)(myTrack), myStep));
-          } else if (processName == "RayleighScattering" ||
-                     processName == "Rayl") {
-            modelRS = (dynamic_cast<G4VEmProcess *>((*processListForGamma)[i]))
-                          ->SelectModelForMaterial(incidentEnergy,
-                                                   physicRegionNumber);
-          }
-        }
+        size_t physicRegionNumber = 0;
+        if (processPE != nullptr)
+          modelPE = processPE->SelectModelForMaterial(incidentEnergy,
+                                                      physicRegionNumber);
+        if (processCS != nullptr)
+          modelCS = processCS->SelectModelForMaterial(incidentEnergy,
+                                                      physicRegionNumber);
+        if (processRS != nullptr)
+          modelRS = processRS->SelectModelForMaterial(incidentEnergy,
+                                                      physicRegionNumber);
 
         // Cross-section calculation
         double density = material->GetDensity() / (CLHEP::g / CLHEP::cm3);
@@ -542,8 +706,102 @@ void GateMaterialMuHandler::SimulateMaterialTable() {
       fCoupleTable.insert(
           std::pair<const G4MaterialCutsCouple *, GateMuTable *>(couple,
                                                                  table));
+      if (!fCacheFolder.empty())
+        SaveCachedTable(table, cacheKey);
+    }
+  }
+}
+
+std::string GateMaterialMuHandler::SimulatedTableKey(
+    const G4MaterialCutsCouple *couple, double energyCutForGamma,
+    const std::string &physicsKey) const {
+  // everything the simulated table depends on, in a stable textual form
+  const G4Material *material = couple->GetMaterial();
+  std::ostringstream oss;
+  oss << std::setprecision(17) << "GateMuTable v1;" << fDatabaseName << ";"
+      << fEnergyMin << ";" << fEnergyMax << ";" << fEnergyNumber << ";"
+      << fAtomicShellEnergyMin << ";" << fPrecision << ";" << physicsKey
+      << ";cut=" << energyCutForGamma << ";rho=" << material->GetDensity();
+  const G4double *fractions = material->GetFractionVector();
+  for (size_t i = 0; i < material->GetNumberOfElements(); i++) {
+    const G4Element *element = material->GetElement(i);
+    oss << ";" << element->GetZ() << "/" << element->GetN() << "/"
+        << fractions[i];
+  }
+  return oss.str();
+}
+
+std::string
+GateMaterialMuHandler::CachedTableFilename(const std::string &key) const {
+  // 64 bits FNV-1a hash: stable across runs and platforms
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  std::ostringstream oss;
+  oss << "mu_" << std::hex << std::setw(16) << std::setfill('0') << hash
+      << ".bin";
+  return (std::filesystem::path(fCacheFolder) / oss.str()).string();
+}
+
+GateMuTable *
+GateMaterialMuHandler::LoadCachedTable(const G4MaterialCutsCouple *couple,
+                                       const std::string &key) const {
+  std::ifstream is(CachedTableFilename(key), std::ios::binary);
+  if (!is)
+    return nullptr;
+  // the full key is stored to discard hash collisions
+  std::uint64_t key_size = 0;
+  is.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
+  if (!is || key_size != key.size())
+    return nullptr;
+  std::string stored_key(key_size, '\0');
+  is.read(&stored_key[0], static_cast<std::streamsize>(key_size));
+  std::int32_t size = 0;
+  is.read(reinterpret_cast<char *>(&size), sizeof(size));
+  if (!is || stored_key != key || size <= 0)
+    return nullptr;
+  std::vector<double> values(3 * static_cast<size_t>(size));
+  is.read(reinterpret_cast<char *>(values.data()),
+          static_cast<std::streamsize>(values.size() * sizeof(double)));
+  if (!is)
+    return nullptr;
+  auto *table = new GateMuTable(couple, size);
+  for (int e = 0; e < size; e++)
+    table->PutValue(e, values[3 * e], values[3 * e + 1], values[3 * e + 2]);
+  return table;
+}
+
+void GateMaterialMuHandler::SaveCachedTable(const GateMuTable *table,
+                                            const std::string &key) const {
+  std::error_code ec;
+  std::filesystem::create_directories(fCacheFolder, ec);
+  auto filename = CachedTableFilename(key);
+  // write in a temporary file then rename it, so that concurrent jobs never
+  // read a partially written table
+  std::ostringstream tmp;
+  tmp << filename << "." << std::this_thread::get_id() << ".tmp";
+  {
+    std::ofstream os(tmp.str(), std::ios::binary);
+    if (!os)
+      return;
+    std::uint64_t key_size = key.size();
+    os.write(reinterpret_cast<const char *>(&key_size), sizeof(key_size));
+    os.write(key.data(), static_cast<std::streamsize>(key_size));
+    std::int32_t size = table->GetSize();
+    os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    for (int e = 0; e < size; e++) {
+      double v[3] = {table->GetEnergies()[e], table->GetMuTable()[e],
+                     table->GetMuEnTable()[e]};
+      os.write(reinterpret_cast<const char *>(v), sizeof(v));
     }
+    if (!os)
+      return;
   }
+  std::filesystem::rename(tmp.str(), filename, ec);
+  if (ec)
+    std::filesystem::remove(tmp.str(), ec);
 }
 
 double GateMaterialMuHandler::ProcessOneShot(
@@ -660,3 +918,11 @@ void GateMaterialMuHandler::SetAtomicShellEMin(double e) {
 }
 
 void GateMaterialMuHandler::SetPrecision(double p) { fPrecision = p; }
+
+void GateMaterialMuHandler::SetCacheFolder(std::string folder) {
+  fCacheFolder = std::move(folder);
+}
+
+void GateMaterialMuHandler::SetLookupBinsPerDecade(int n) {
+  fLookupBinsPerDecade = n;
+}
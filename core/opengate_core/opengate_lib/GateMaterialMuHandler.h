@@ -14,9 +14,13 @@
 #include "G4UnitsTable.hh"
 
 #include "GateMuTables.h"
+#include "GateNuma.h"
+#include <atomic>
 #include <map>
 #include <memory>
+#include <string>
 #include <tuple>
+#include <vector>
 
 struct MuStorageStruct {
   double energy;
@@ -56,8 +60,16 @@ public:
 
   double GetMu(const G4MaterialCutsCouple *, double);
 
+  // mu (1/cm) of all the couples (ordered by couple index) at one energy
+  std::vector<double> GetMuOfAllCouples(double energy);
+
+  // Flat tables indexed by couple index (initialized if needed)
+  const GateMuLookupTable &GetLookupTable();
+
   [[nodiscard]] G4String GetDatabaseName() const;
 
+  // mu/rho table of the couple (shared with the materials of the same base
+  // material: use GetDensity for the density of the couple)
   GateMuTable *GetMuTable(const G4MaterialCutsCouple *);
 
   void SetDatabaseName(G4String name);
@@ -72,6 +84,11 @@ public:
 
   void SetPrecision(double p);
 
+  void SetLookupBinsPerDecade(int n);
+
+  // Folder of the on-disk cache of the simulated tables (empty: no cache)
+  void SetCacheFolder(std::string folder);
+
   GateMaterialMuHandler();
 
   // Initialization
@@ -80,11 +97,29 @@ public:
   // Precalculated coefficients (by element)
   void InitElementTable();
 
-  void ConstructMaterial(const G4MaterialCutsCouple *);
+  // Mix the element tables into the table of the material of the couple
+  GateMuTable *ConstructMaterial(const G4MaterialCutsCouple *) const;
+
+  // Same for several couples (of different materials), in parallel
+  std::vector<GateMuTable *>
+  ConstructMaterials(const std::vector<const G4MaterialCutsCouple *> &) const;
 
   // Complete simulation of coefficients
   void SimulateMaterialTable();
 
+  // On-disk cache of the simulated tables, one file per couple, named after
+  // a hash of the key (composition, database, energy range, physics, cut)
+  std::string SimulatedTableKey(const G4MaterialCutsCouple *couple,
+                                double energyCutForGamma,
+                                const std::string &physicsKey) const;
+
+  std::string CachedTableFilename(const std::string &key) const;
+
+  GateMuTable *LoadCachedTable(const G4MaterialCutsCouple *couple,
+                               const std::string &key) const;
+
+  void SaveCachedTable(const GateMuTable *table, const std::string &key) const;
+
   void ConstructEnergyList(std::vector<MuStorageStruct> *, const G4Material *);
 
   static void MergeAtomicShell(std::vector<MuStorageStruct> *);
@@ -97,6 +132,23 @@ public:
 
   void CheckLastCall(const G4MaterialCutsCouple *);
 
+  void CheckInitialized() {
+    if (!fIsInitialized)
+      Initialize();
+  }
+
+  // Material of the table of the couple: its base material, if any (the
+  // materials that only differ by their density share the same table)
+  static const G4Material *GetTableMaterial(const G4MaterialCutsCouple *);
+
+  // Resample all couple tables into the flat lookup table
+  void BuildLookupTable();
+
+  // Lookup table of the NUMA node of the thread (see GateNuma)
+  const GateMuLookupTable &GetNodeLookupTable() {
+    return fLookupTableReplica.Get(fLookupTable);
+  }
+
   // static GateMaterialMuHandler *fSingletonMaterialMuHandler;
   static std::map<std::tuple<std::string, double>,
                   std::shared_ptr<GateMaterialMuHandler>>
@@ -106,7 +158,7 @@ public:
   GateMuTable **fElementsTable;
   int fElementNumber;
   G4String fDatabaseName;
-  bool fIsInitialized;
+  std::atomic<bool> fIsInitialized;
   double fEnergyMin;
   double fEnergyMax;
   int fEnergyNumber;
@@ -114,6 +166,10 @@ public:
   double fPrecision;
   const G4MaterialCutsCouple *fLastCouple;
   GateMuTable *fLastMuTable;
+  GateMuLookupTable fLookupTable;
+  GateNumaReplica<GateMuLookupTable> fLookupTableReplica;
+  int fLookupBinsPerDecade;
+  std::string fCacheFolder;
 };
 
 #endif
@@ -0,0 +1,58 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateMemoryAccounting.h"
+#include "G4Threading.hh"
+#include <algorithm>
+
+using namespace pybind11::literals;
+
+std::atomic<bool> GateMemoryAccounting::fEnabled{false};
+std::mutex GateMemoryAccounting::fMutex;
+std::map<std::pair<std::string, std::string>, GateMemoryAccounting::Component>
+    GateMemoryAccounting::fComponents;
+
+void GateMemoryAccounting::Enable(bool flag) {
+  fEnabled.store(flag, std::memory_order_relaxed);
+}
+
+void GateMemoryAccounting::Reset() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fComponents.clear();
+}
+
+void GateMemoryAccounting::Update(const std::string &type,
+                                  const std::string &name, size_t bytes) {
+  if (!IsEnabled())
+    return;
+  const auto id = G4Threading::G4GetThreadId();
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto &c = fComponents[{type, name}];
+  auto &t = c.fThreads[id];
+  c.fTotal.fCurrent = c.fTotal.fCurrent - t.fCurrent + bytes;
+  c.fTotal.fPeak = std::max(c.fTotal.fPeak, c.fTotal.fCurrent);
+  t.fCurrent = bytes;
+  t.fPeak = std::max(t.fPeak, bytes);
+}
+
+py::dict GateMemoryAccounting::GetResults() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  py::dict results;
+  for (const auto &[key, c] : fComponents) {
+    const auto &[type, name] = key;
+    if (!results.contains(type))
+      results[type.c_str()] = py::dict();
+    py::dict threads;
+    for (const auto &[id, t] : c.fThreads)
+      threads[py::int_(id)] =
+          py::dict("current"_a = t.fCurrent, "peak"_a = t.fPeak);
+    py::dict d("current"_a = c.fTotal.fCurrent, "peak"_a = c.fTotal.fPeak,
+               "threads"_a = threads);
+    results[type.c_str()][name.c_str()] = d;
+  }
+  return results;
+}
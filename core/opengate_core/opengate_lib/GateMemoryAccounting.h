@@ -0,0 +1,69 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateMemoryAccounting_h
+#define GateMemoryAccounting_h
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <pybind11/pybind11.h>
+#include <string>
+
+namespace py = pybind11;
+
+/*
+    Optional accounting of the memory allocated by the components (digi
+    collections, dose images and per-thread buffers, phase space batches, mu
+    tables), enabled by the SimulationStatisticsActor (option memory_flag).
+
+    Each component reports its current number of bytes for the calling
+    thread when it (re)allocates: the accounting keeps, per component and
+    per thread, the current and the peak bytes, and the current and peak of
+    the total of the component (all threads). The components report at
+    coarse points only (begin of run, flush of a collection, new batch, ...)
+    so the lock is not on the tracking path. When disabled, the cost is one
+    test per report.
+ */
+
+class GateMemoryAccounting {
+public:
+  static void Enable(bool flag);
+
+  inline static bool IsEnabled() {
+    return fEnabled.load(std::memory_order_relaxed);
+  }
+
+  // Remove the counts (master thread, when the simulation starts)
+  static void Reset();
+
+  // Current bytes of the component for the calling thread (e.g. type
+  // "digi_collection", name "Hits")
+  static void Update(const std::string &type, const std::string &name,
+                     size_t bytes);
+
+  // {type: {name: {current, peak, threads: {id: {current, peak}}}}}, bytes
+  // (thread id -1 is the master thread)
+  static py::dict GetResults();
+
+protected:
+  struct Counts {
+    size_t fCurrent = 0;
+    size_t fPeak = 0;
+  };
+
+  struct Component {
+    Counts fTotal;
+    std::map<int, Counts> fThreads;
+  };
+
+  static std::atomic<bool> fEnabled;
+  static std::mutex fMutex;
+  static std::map<std::pair<std::string, std::string>, Component> fComponents;
+};
+
+#endif // GateMemoryAccounting_h
@@ -0,0 +1,149 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateMotionTable.h"
+#include "G4GeometryManager.hh"
+#include "GateHelpers.h"
+#include "GateHelpersGeometry.h"
+#include <algorithm>
+#include <set>
+
+GateMotionTable::GateMotionTable() {
+  fOpenClose = true;
+  fOptimise = true;
+  fCurrentStep = -1;
+  fNumberOfMoves = 0;
+}
+
+void GateMotionTable::SetStepTimes(const std::vector<double> &times) {
+  if (times.empty() || !std::is_sorted(times.begin(), times.end()))
+    Fatal("GateMotionTable: the step times must be sorted (at least one)");
+  fStepTimes = times;
+  Reset();
+}
+
+void GateMotionTable::SetGeometryOpenClose(bool open_close, bool optimise) {
+  fOpenClose = open_close;
+  fOptimise = optimise;
+}
+
+GateMotionTable::Motion &GateMotionTable::GetMotion(G4VPhysicalVolume *pv) {
+  if (pv == nullptr)
+    Fatal("GateMotionTable: no physical volume");
+  for (auto &m : fMotions) {
+    if (m.fVolume == pv)
+      return m;
+  }
+  Motion m;
+  m.fVolume = pv;
+  fMotions.push_back(std::move(m));
+  return fMotions.back();
+}
+
+void GateMotionTable::CheckNumberOfSteps(const G4VPhysicalVolume *pv,
+                                         size_t n) const {
+  if (n == fStepTimes.size())
+    return;
+  std::ostringstream oss;
+  oss << "GateMotionTable: " << n << " positions of the volume "
+      << pv->GetName() << " but " << fStepTimes.size() << " steps";
+  Fatal(oss.str());
+}
+
+void GateMotionTable::AddTranslations(
+    G4VPhysicalVolume *pv, const std::vector<G4ThreeVector> &translations) {
+  auto &m = GetMotion(pv);
+  CheckNumberOfSteps(pv, translations.size());
+  m.fTranslations = translations;
+}
+
+void GateMotionTable::AddRotations(
+    G4VPhysicalVolume *pv, const std::vector<G4RotationMatrix> &rotations) {
+  auto &m = GetMotion(pv);
+  CheckNumberOfSteps(pv, rotations.size());
+  // a placement keeps the rotation of the frame
+  m.fFrameRotations.clear();
+  for (const auto &r : rotations)
+    m.fFrameRotations.push_back(r.inverse());
+}
+
+size_t GateMotionTable::FindStep(double time) const {
+  auto it = std::upper_bound(fStepTimes.begin(), fStepTimes.end(), time);
+  if (it == fStepTimes.begin())
+    return 0;
+  return it - fStepTimes.begin() - 1;
+}
+
+bool GateMotionTable::Update(double time) {
+  // (the events are sorted by time)
+  return SetStep(FindStep(time));
+}
+
+bool GateMotionTable::SetStep(size_t step) {
+  if (step >= fStepTimes.size()) {
+    std::ostringstream oss;
+    oss << "GateMotionTable: no step " << step << " (" << fStepTimes.size()
+        << " steps)";
+    Fatal(oss.str());
+  }
+  if (static_cast<long>(step) == fCurrentStep)
+    return false;
+  Apply(step);
+  fCurrentStep = static_cast<long>(step);
+  fNumberOfMoves++;
+  return true;
+}
+
+bool GateMotionTable::HasMoved(const Motion &m, size_t step) const {
+  if (fCurrentStep < 0)
+    return true;
+  const auto previous = static_cast<size_t>(fCurrentStep);
+  if (!m.fTranslations.empty() &&
+      m.fTranslations[step] != m.fTranslations[previous])
+    return true;
+  return !m.fFrameRotations.empty() &&
+         m.fFrameRotations[step] != m.fFrameRotations[previous];
+}
+
+void GateMotionTable::Reset() {
+  fCurrentStep = -1;
+  fNumberOfMoves = 0;
+}
+
+void GateMotionTable::Apply(size_t step) {
+  // the volumes that do not move during this step are ignored
+  std::vector<G4VPhysicalVolume *> moved;
+  for (auto &m : fMotions) {
+    if (!HasMoved(m, step))
+      continue;
+    moved.push_back(m.fVolume);
+    if (!m.fTranslations.empty())
+      m.fVolume->SetTranslation(m.fTranslations[step]);
+    if (!m.fFrameRotations.empty()) {
+      // (the volume does not own this rotation)
+      if (m.fRotation == nullptr)
+        m.fRotation = std::make_unique<G4RotationMatrix>();
+      *m.fRotation = m.fFrameRotations[step];
+      m.fVolume->SetRotation(m.fRotation.get());
+    }
+  }
+
+  // Only the optimisation of the mothers of the moved volumes is built
+  // again (once per mother)
+  if (fOpenClose) {
+    auto *gm = G4GeometryManager::GetInstance();
+    std::set<const G4LogicalVolume *> mothers;
+    for (auto *pv : moved) {
+      if (!mothers.insert(pv->GetMotherLogical()).second)
+        continue;
+      gm->OpenGeometry(pv);
+      gm->CloseGeometry(fOptimise, false, pv);
+    }
+  }
+  if (!moved.empty())
+    InvalidateVolumeTransformCache();
+}
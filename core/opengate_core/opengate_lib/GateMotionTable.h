@@ -0,0 +1,105 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateMotionTable_h
+#define GateMotionTable_h
+
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include <memory>
+#include <vector>
+
+/*
+    Precomputed motion of the dynamic volumes, for the sub-runs (see
+    GateSourceManager, option dynamic_sub_runs).
+
+    All the run timing intervals are simulated in one single Geant4 run.
+    The table contains the translation and/or the rotation of each moving
+    volume for each interval (step), and the start time of each step. Before
+    each event, the source manager gives the time of the event: when a new
+    step starts, the volumes are moved, the geometry of their mothers is
+    optimised again, and the cached volume transforms are invalidated (see
+    InvalidateVolumeTransformCache). Only the volumes whose position
+    differs from the previous step are moved.
+
+    The volumes are moved between two events: only for a sequential
+    (mono-thread) simulation, the geometry is shared by the threads.
+
+    The same table is used without sub-runs (one step per run, see
+    GateDynamicGeometryActor): the volumes are moved by the master thread
+    before each run, without Python.
+ */
+
+class GateMotionTable {
+public:
+  GateMotionTable();
+
+  // [py side] start time of each step (sorted)
+  void SetStepTimes(const std::vector<double> &times);
+
+  // [py side] open and close (optimise) the geometry when moving volumes
+  void SetGeometryOpenClose(bool open_close, bool optimise);
+
+  // [py side] translation of the volume for each step
+  void AddTranslations(G4VPhysicalVolume *pv,
+                       const std::vector<G4ThreeVector> &translations);
+
+  // [py side] rotation (of the object, as the user rotation) of the volume
+  // for each step
+  void AddRotations(G4VPhysicalVolume *pv,
+                    const std::vector<G4RotationMatrix> &rotations);
+
+  // Step of the time (the first one before the first step time)
+  size_t FindStep(double time) const;
+
+  // Move the volumes if the time is in a new step. Return true if the
+  // step has changed.
+  bool Update(double time);
+
+  // Move the volumes to the given step (e.g. one step per run), return true
+  // if the step has changed
+  bool SetStep(size_t step);
+
+  // The next Update moves the volumes, whatever the time
+  void Reset();
+
+  size_t GetNumberOfSteps() const { return fStepTimes.size(); }
+
+  size_t GetNumberOfVolumes() const { return fMotions.size(); }
+
+  // Number of steps applied since the last Reset
+  unsigned long GetNumberOfMoves() const { return fNumberOfMoves; }
+
+protected:
+  struct Motion {
+    G4VPhysicalVolume *fVolume = nullptr;
+    std::vector<G4ThreeVector> fTranslations;
+    // frame rotations (inverse of the object rotations)
+    std::vector<G4RotationMatrix> fFrameRotations;
+    // rotation given to the volume, updated at each step
+    std::unique_ptr<G4RotationMatrix> fRotation;
+  };
+
+  Motion &GetMotion(G4VPhysicalVolume *pv);
+
+  void CheckNumberOfSteps(const G4VPhysicalVolume *pv, size_t n) const;
+
+  // The volume is not at its position of the step
+  bool HasMoved(const Motion &m, size_t step) const;
+
+  void Apply(size_t step);
+
+  std::vector<double> fStepTimes;
+  std::vector<Motion> fMotions;
+  bool fOpenClose;
+  bool fOptimise;
+  long fCurrentStep;
+  unsigned long fNumberOfMoves;
+};
+
+#endif // GateMotionTable_h
@@ -6,6 +6,11 @@
    ------------------------------------ -------------- */
 
 #include "GateMuTables.h"
+#include "GateHelpers.h"
+#include "GateHugePages.h"
+
+#include <algorithm>
+#include <limits>
 
 GateMuTable::GateMuTable(const G4MaterialCutsCouple *couple, G4int size) {
   fEnergy = new double[size];
@@ -44,32 +49,32 @@ inline double interpol(double x1, double x, double x2, double y1, double y2) {
   //   storage
 }
 
-double GateMuTable::GetMuEnOverRho(double energy) {
-  if (energy != fLastEnergyMuEn) {
-    fLastEnergyMuEn = energy;
-
-    energy = log(energy);
-
-    int inf = 0;
-    int sup = fSize - 1;
-    while (sup - inf > 1) {
-      int tmp_bound = (inf + sup) / 2;
-      if (fEnergy[tmp_bound] > energy) {
-        sup = tmp_bound;
-      } else {
-        inf = tmp_bound;
-      }
-    }
-    double e_inf = fEnergy[inf];
-    double e_sup = fEnergy[sup];
-
-    if (energy > e_inf && energy < e_sup) {
-      fLastMuEn = exp(interpol(e_inf, energy, e_sup, fMuEn[inf], fMuEn[sup]));
+double GateMuTable::InterpolateLog(const double *log_table,
+                                   double log_energy) const {
+  int inf = 0;
+  int sup = fSize - 1;
+  while (sup - inf > 1) {
+    int tmp_bound = (inf + sup) / 2;
+    if (fEnergy[tmp_bound] > log_energy) {
+      sup = tmp_bound;
     } else {
-      fLastMuEn = exp(fMuEn[inf]);
+      inf = tmp_bound;
     }
   }
+  double e_inf = fEnergy[inf];
+  double e_sup = fEnergy[sup];
+
+  if (log_energy > e_inf && log_energy < e_sup) {
+    return interpol(e_inf, log_energy, e_sup, log_table[inf], log_table[sup]);
+  }
+  return log_table[inf];
+}
 
+double GateMuTable::GetMuEnOverRho(double energy) {
+  if (energy != fLastEnergyMuEn) {
+    fLastEnergyMuEn = energy;
+    fLastMuEn = exp(InterpolateLog(fMuEn, log(energy)));
+  }
   return fLastMuEn;
 }
 
@@ -80,29 +85,8 @@ double GateMuTable::GetMuEn(double energy) {
 double GateMuTable::GetMuOverRho(double energy) {
   if (energy != fLastEnergyMu) {
     fLastEnergyMu = energy;
-
-    energy = log(energy);
-
-    int inf = 0;
-    int sup = fSize - 1;
-    while (sup - inf > 1) {
-      int tmp_bound = (inf + sup) / 2;
-      if (fEnergy[tmp_bound] > energy) {
-        sup = tmp_bound;
-      } else {
-        inf = tmp_bound;
-      }
-    }
-    double e_inf = fEnergy[inf];
-    double e_sup = fEnergy[sup];
-
-    if (energy > e_inf && energy < e_sup) {
-      fLastMu = exp(interpol(e_inf, energy, e_sup, fMu[inf], fMu[sup]));
-    } else {
-      fLastMu = exp(fMu[inf]);
-    }
+    fLastMu = exp(InterpolateLog(fMu, log(energy)));
   }
-
   return fLastMu;
 }
 
@@ -125,3 +109,72 @@ double *GateMuTable::GetEnergies() const { return fEnergy; }
 double *GateMuTable::GetMuEnTable() const { return fMuEn; }
 
 double *GateMuTable::GetMuTable() const { return fMu; }
+
+void GateMuLookupTable::Build(const std::vector<const GateMuTable *> &tables,
+                              const std::vector<double> &densities,
+                              int bins_per_decade) {
+  fNbCouples = static_cast<int>(tables.size());
+  fDensity.assign(fNbCouples, -1.0);
+  fLogMu.clear();
+  fLogMuEn.clear();
+  fNbNodes = 0;
+  if (fNbCouples == 0)
+    return;
+
+  // common (log) energy range of all the tables
+  double log_e_min = std::numeric_limits<double>::max();
+  double log_e_max = std::numeric_limits<double>::lowest();
+  for (const auto *table : tables) {
+    if (table == nullptr || table->GetSize() == 0)
+      continue;
+    log_e_min = std::min(log_e_min, table->GetEnergies()[0]);
+    log_e_max =
+        std::max(log_e_max, table->GetEnergies()[table->GetSize() - 1]);
+  }
+  if (log_e_max <= log_e_min) {
+    Fatal("GateMuLookupTable: empty energy range for the mu tables");
+  }
+
+  // log-uniform bins, the nodes are the bins boundaries
+  auto nb_decades = (log_e_max - log_e_min) / log(10.0);
+  auto nb_bins = std::max(1, static_cast<int>(ceil(nb_decades *
+                                                   bins_per_decade)));
+  fNbNodes = nb_bins + 1;
+  fLogEnergyMin = log_e_min;
+  fLogStep = (log_e_max - log_e_min) / nb_bins;
+  fInvLogStep = 1.0 / fLogStep;
+
+  // resample every table on the common nodes (log-log interpolation)
+  auto n = static_cast<size_t>(fNbCouples) * fNbNodes;
+  GateHugePages::Assign(fLogMu, n, 0.0, "mu_tables");
+  GateHugePages::Assign(fLogMuEn, n, 0.0, "mu_tables");
+  for (int c = 0; c < fNbCouples; c++) {
+    const auto *table = tables[c];
+    if (table == nullptr)
+      continue;
+    fDensity[c] = densities[c];
+    auto offset = static_cast<size_t>(c) * fNbNodes;
+    for (int i = 0; i < fNbNodes; i++) {
+      auto log_e = fLogEnergyMin + i * fLogStep;
+      fLogMu[offset + i] = table->InterpolateLog(table->GetMuTable(), log_e);
+      fLogMuEn[offset + i] =
+          table->InterpolateLog(table->GetMuEnTable(), log_e);
+    }
+  }
+}
+
+void GateMuLookupTable::GetMuOverRho(size_t n, const int *couple_indices,
+                                     const double *energies,
+                                     double *values) const {
+  const auto *table = fLogMu.data();
+  for (size_t i = 0; i < n; i++)
+    values[i] = Interpolate(table, couple_indices[i], energies[i]);
+}
+
+void GateMuLookupTable::GetMuEnOverRho(size_t n, const int *couple_indices,
+                                       const double *energies,
+                                       double *values) const {
+  const auto *table = fLogMuEn.data();
+  for (size_t i = 0; i < n; i++)
+    values[i] = Interpolate(table, couple_indices[i], energies[i]);
+}
@@ -12,6 +12,10 @@
 #include "G4MaterialCutsCouple.hh"
 #include "G4UnitsTable.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 class GateMuTable {
 
 public:
@@ -29,6 +33,9 @@ public:
 
   double GetMuOverRho(double energy);
 
+  // Log of the value of a (log) table at the given log energy, no memo
+  double InterpolateLog(const double *log_table, double log_energy) const;
+
   const G4MaterialCutsCouple *GetMaterialCutsCouple() const;
 
   const G4Material *GetMaterial() const;
@@ -56,4 +63,68 @@ public:
   G4int fSize;
 };
 
+// Flat (structure of arrays) mu/rho and mu_en/rho tables of all the material
+// cuts couples, indexed by the couple index and resampled on common
+// log-uniform energy nodes. A lookup is a direct bin computation followed by
+// a linear interpolation in log-log space. The table is read-only once built
+// and can be shared by all threads.
+class GateMuLookupTable {
+
+public:
+  // tables[i] is the table of the couple of index i and densities[i] the
+  // density of its material, in g/cm3 (a table may be shared by several
+  // couples of different densities)
+  void Build(const std::vector<const GateMuTable *> &tables,
+             const std::vector<double> &densities, int bins_per_decade);
+
+  [[nodiscard]] int GetNumberOfCouples() const { return fNbCouples; }
+
+  [[nodiscard]] double GetDensity(int couple_index) const {
+    return fDensity[couple_index];
+  }
+
+  [[nodiscard]] double GetMuOverRho(int couple_index, double energy) const {
+    return Interpolate(fLogMu.data(), couple_index, energy);
+  }
+
+  [[nodiscard]] double GetMuEnOverRho(int couple_index, double energy) const {
+    return Interpolate(fLogMuEn.data(), couple_index, energy);
+  }
+
+  // Batch versions, for n (couple, energy) pairs
+  void GetMuOverRho(size_t n, const int *couple_indices,
+                    const double *energies, double *values) const;
+
+  void GetMuEnOverRho(size_t n, const int *couple_indices,
+                      const double *energies, double *values) const;
+
+  // Bytes of the flat tables
+  [[nodiscard]] size_t GetMemoryBytes() const {
+    return (fDensity.capacity() + fLogMu.capacity() + fLogMuEn.capacity()) *
+           sizeof(double);
+  }
+
+protected:
+  // branch-free (apart from the clamping) lookup, energies outside the
+  // table range get the value of the closest end
+  double Interpolate(const double *table, int couple_index,
+                     double energy) const {
+    auto t = (std::log(energy) - fLogEnergyMin) * fInvLogStep;
+    t = std::min(std::max(t, 0.0), static_cast<double>(fNbNodes - 1));
+    auto i = std::min(static_cast<int>(t), fNbNodes - 2);
+    auto f = t - i;
+    const auto *v = table + static_cast<size_t>(couple_index) * fNbNodes + i;
+    return std::exp(v[0] + f * (v[1] - v[0]));
+  }
+
+  int fNbCouples = 0;
+  int fNbNodes = 0;
+  double fLogEnergyMin = 0;
+  double fLogStep = 1;
+  double fInvLogStep = 1;
+  std::vector<double> fDensity;
+  std::vector<double> fLogMu;
+  std::vector<double> fLogMuEn;
+};
+
 #endif
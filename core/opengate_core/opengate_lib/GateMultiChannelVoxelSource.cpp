@@ -0,0 +1,32 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateMultiChannelVoxelSource.h"
+#include "G4RunManager.hh"
+#include "GateHelpers.h"
+
+GateMultiChannelVoxelSource::GateMultiChannelVoxelSource()
+    : GateVoxelSource() {}
+
+GateMultiChannelVoxelSource::~GateMultiChannelVoxelSource() = default;
+
+void GateMultiChannelVoxelSource::SetRunChannelActivities(
+    const std::vector<std::vector<double>> &activities) {
+  if (activities.empty())
+    Fatal("No channel activities for the multi-channel voxel source");
+  fRunChannelActivities = activities;
+}
+
+void GateMultiChannelVoxelSource::PrepareNextRun() {
+  GateVoxelSource::PrepareNextRun();
+  // the alias table of the channels of this thread is only built again if
+  // the activities are not the same as in the previous run
+  auto run_id = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  auto i = std::min(static_cast<size_t>(run_id),
+                    fRunChannelActivities.size() - 1);
+  fVoxelPositionGenerator->SetChannelActivities(fRunChannelActivities[i]);
+}
@@ -0,0 +1,43 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateMultiChannelVoxelSource_h
+#define GateMultiChannelVoxelSource_h
+
+#include "GateVoxelSource.h"
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Voxel source with several channels (e.g. one per organ) in a single label
+ * image, instead of one voxel source per channel. The voxels of each
+ * channel are stored once (shared by all the threads) and the channel of a
+ * particle is sampled from the activities of the channels in the current
+ * run (they may change between runs, e.g. with TACs). There is only one SPS
+ * per thread, and one source to schedule.
+ */
+
+class GateMultiChannelVoxelSource : public GateVoxelSource {
+
+public:
+  GateMultiChannelVoxelSource();
+
+  ~GateMultiChannelVoxelSource() override;
+
+  // Activities of the channels for each run (the last ones are used for the
+  // next runs, if any)
+  void
+  SetRunChannelActivities(const std::vector<std::vector<double>> &activities);
+
+  void PrepareNextRun() override;
+
+protected:
+  std::vector<std::vector<double>> fRunChannelActivities;
+};
+
+#endif // GateMultiChannelVoxelSource_h
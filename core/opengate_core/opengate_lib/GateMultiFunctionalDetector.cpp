@@ -7,6 +7,7 @@
 
 #include "GateMultiFunctionalDetector.h"
 #include "G4VPrimitiveScorer.hh"
+#include "GateThreadContext.h"
 
 GateMultiFunctionalDetector::GateMultiFunctionalDetector(G4String s)
     : G4MultiFunctionalDetector(s) {}
@@ -19,3 +20,10 @@ GateMultiFunctionalDetector::~GateMultiFunctionalDetector() {
 
   primitives.clear();
 }
+
+G4bool GateMultiFunctionalDetector::ProcessHits(G4Step *step,
+                                                G4TouchableHistory *history) {
+  // a new step for the filters of all the actors of this volume
+  GateThreadContext::Current().fStepSerial++;
+  return G4MultiFunctionalDetector::ProcessHits(step, history);
+}
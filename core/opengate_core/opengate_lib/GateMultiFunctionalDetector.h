@@ -19,6 +19,9 @@ public:
   GateMultiFunctionalDetector(G4String);
 
   virtual ~GateMultiFunctionalDetector();
+
+protected:
+  G4bool ProcessHits(G4Step *step, G4TouchableHistory *history) override;
 };
 
 #endif
@@ -0,0 +1,153 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateMutex.h"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include <map>
+
+using namespace pybind11::literals;
+
+#ifdef OPENGATE_MUTEX_STATISTICS
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+
+namespace {
+typedef std::unordered_map<const GateMutex *, GateMutex::Entry> TableType;
+
+// (function statics: the mutexes are global objects, they may be used during
+// the static initialization)
+std::mutex &TablesMutex() {
+  static std::mutex m;
+  return m;
+}
+
+// the tables are never moved (deque), and kept until the next Reset
+std::deque<TableType> &Tables() {
+  static std::deque<TableType> tables;
+  return tables;
+}
+
+// incremented by Reset, the threads then take new tables
+std::atomic<int> &Generation() {
+  static std::atomic<int> generation{0};
+  return generation;
+}
+
+// Table of the calling thread (created at its first lock)
+TableType &GetTable() {
+  static G4ThreadLocal TableType *table = nullptr;
+  static G4ThreadLocal int generation = -1;
+  auto current = Generation().load(std::memory_order_acquire);
+  if (generation != current) {
+    std::lock_guard<std::mutex> lock(TablesMutex());
+    Tables().emplace_back();
+    table = &Tables().back();
+    generation = current;
+  }
+  return *table;
+}
+
+double Nanoseconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double, std::nano>(d).count();
+}
+} // namespace
+
+GateMutex::Entry &GateMutex::GetEntry() {
+  auto &table = GetTable();
+  auto it = table.find(this);
+  if (it == table.end()) {
+    it = table.emplace(this, Entry()).first;
+    it->second.fName = fName;
+    it->second.fThreadId = G4Threading::G4GetThreadId();
+  }
+  return it->second;
+}
+
+void GateMutex::lock() {
+  auto &entry = GetEntry();
+  auto start = std::chrono::steady_clock::now();
+  if (fMutex.try_lock()) {
+    fLockTime = start;
+  } else {
+    fMutex.lock();
+    fLockTime = std::chrono::steady_clock::now();
+    entry.fContended++;
+    entry.fWaitTime += Nanoseconds(fLockTime - start);
+  }
+  entry.fAcquisitions++;
+  fHolderEntry = &entry;
+}
+
+bool GateMutex::try_lock() {
+  auto &entry = GetEntry();
+  if (!fMutex.try_lock()) {
+    entry.fContended++;
+    return false;
+  }
+  fLockTime = std::chrono::steady_clock::now();
+  entry.fAcquisitions++;
+  fHolderEntry = &entry;
+  return true;
+}
+
+void GateMutex::unlock() {
+  auto *entry = fHolderEntry;
+  auto d = std::chrono::steady_clock::now() - fLockTime;
+  entry->fHoldTime += Nanoseconds(d);
+  fMutex.unlock();
+}
+
+bool IsMutexStatisticsEnabled() { return true; }
+
+void ResetMutexStatistics() {
+  std::lock_guard<std::mutex> lock(TablesMutex());
+  Tables().clear();
+  Generation()++;
+}
+
+py::dict GetMutexStatistics() {
+  // sum of the mutexes with the same name, per thread
+  std::map<std::string, std::map<int, GateMutex::Entry>> sums;
+  {
+    std::lock_guard<std::mutex> lock(TablesMutex());
+    for (const auto &table : Tables()) {
+      for (const auto &e : table) {
+        auto &s = sums[e.second.fName][e.second.fThreadId];
+        s.fAcquisitions += e.second.fAcquisitions;
+        s.fContended += e.second.fContended;
+        s.fWaitTime += e.second.fWaitTime;
+        s.fHoldTime += e.second.fHoldTime;
+      }
+    }
+  }
+  py::dict results;
+  for (const auto &s : sums) {
+    py::dict threads;
+    for (const auto &t : s.second) {
+      const auto &e = t.second;
+      threads[py::int_(t.first)] = py::dict(
+          "acquisitions"_a = e.fAcquisitions, "contended"_a = e.fContended,
+          "wait"_a = e.fWaitTime * CLHEP::ns,
+          "hold"_a = e.fHoldTime * CLHEP::ns);
+    }
+    results[s.first.c_str()] = threads;
+  }
+  return results;
+}
+
+#else
+
+bool IsMutexStatisticsEnabled() { return false; }
+
+void ResetMutexStatistics() {}
+
+py::dict GetMutexStatistics() { return py::dict(); }
+
+#endif
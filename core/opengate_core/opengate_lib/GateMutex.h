@@ -0,0 +1,95 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateMutex_h
+#define GateMutex_h
+
+#include "G4AutoLock.hh"
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/*
+    Named mutexes shared by the threads (actors, helpers), declared with
+    GATE_MUTEX(name) and locked with GateAutoLock, like G4Mutex/G4AutoLock.
+
+    With the CMake option OPENGATE_MUTEX_STATISTICS, each lock counts the
+    acquisitions, the contended acquisitions (the mutex was already locked),
+    the wait time and the hold time, per mutex and per thread. Each thread
+    counts in its own table (no additional lock). The statistics are read
+    with GetMutexStatistics when the threads are stopped (end of the
+    simulation). Without the option (default), GateMutex is a G4Mutex and
+    GateAutoLock a G4AutoLock: there is no cost.
+ */
+
+#ifdef OPENGATE_MUTEX_STATISTICS
+
+#include <chrono>
+#include <mutex>
+
+class GateMutex {
+public:
+  struct Entry {
+    const char *fName = nullptr;
+    int fThreadId = 0;
+    unsigned long fAcquisitions = 0;
+    unsigned long fContended = 0;
+    // (ns)
+    double fWaitTime = 0;
+    double fHoldTime = 0;
+  };
+
+  explicit GateMutex(const char *name) : fName(name) {}
+
+  GateMutex(const GateMutex &) = delete;
+  GateMutex &operator=(const GateMutex &) = delete;
+
+  void lock();
+
+  void unlock();
+
+  bool try_lock();
+
+protected:
+  // entry of the calling thread for this mutex
+  Entry &GetEntry();
+
+  std::mutex fMutex;
+  const char *fName;
+  // set by the thread holding the mutex
+  Entry *fHolderEntry = nullptr;
+  std::chrono::steady_clock::time_point fLockTime;
+};
+
+class GateAutoLock : public std::unique_lock<GateMutex> {
+public:
+  explicit GateAutoLock(GateMutex *mutex)
+      : std::unique_lock<GateMutex>(*mutex) {}
+};
+
+#define GATE_MUTEX(name) GateMutex name(#name)
+
+#else
+
+typedef G4Mutex GateMutex;
+typedef G4AutoLock GateAutoLock;
+
+#define GATE_MUTEX(name) G4Mutex name = G4MUTEX_INITIALIZER
+
+#endif
+
+// True if compiled with OPENGATE_MUTEX_STATISTICS
+bool IsMutexStatisticsEnabled();
+
+// Remove the statistics (master thread, when the simulation starts)
+void ResetMutexStatistics();
+
+// {mutex name: {thread id: {acquisitions, contended, wait, hold}}}, time in
+// Geant4 units (empty without OPENGATE_MUTEX_STATISTICS)
+py::dict GetMutexStatistics();
+
+#endif // GateMutex_h
@@ -0,0 +1,120 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateNuma.h"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+std::vector<std::vector<int>> GateNuma::fNodeCpus;
+std::string GateNuma::fPolicy;
+bool GateNuma::fReplicate = false;
+thread_local int GateNuma::fCurrentNode = 0;
+
+void GateNuma::Configure(const std::string &policy, bool replicate) {
+  fNodeCpus.clear();
+  fPolicy = policy;
+  fReplicate = replicate;
+  if (policy.empty())
+    return;
+  if (policy != "compact" && policy != "spread") {
+    std::ostringstream oss;
+    oss << "Unknown NUMA policy '" << policy
+        << "', use 'compact' or 'spread'.";
+    Fatal(oss.str());
+  }
+  auto nodes = ReadTopology();
+  // nothing to place with a single node
+  if (nodes.size() > 1)
+    fNodeCpus = nodes;
+}
+
+int GateNuma::GetNumberOfNodes() {
+  return std::max<int>(1, static_cast<int>(fNodeCpus.size()));
+}
+
+int GateNuma::GetNodeOfThread(int thread_id) {
+  if (!IsEnabled() || thread_id < 0)
+    return 0;
+  const auto nb_nodes = static_cast<int>(fNodeCpus.size());
+  if (fPolicy == "spread")
+    return thread_id % nb_nodes;
+  // compact: the n-th cpu of all the nodes, one after the other (more
+  // threads than cpus: start again from the first node)
+  size_t nb_cpus = 0;
+  for (const auto &cpus : fNodeCpus)
+    nb_cpus += cpus.size();
+  auto n = static_cast<size_t>(thread_id) % nb_cpus;
+  for (int node = 0; node < nb_nodes; node++) {
+    if (n < fNodeCpus[node].size())
+      return node;
+    n -= fNodeCpus[node].size();
+  }
+  return 0;
+}
+
+void GateNuma::PinCurrentThread(int thread_id) {
+  if (!IsEnabled())
+    return;
+  const auto node = GetNodeOfThread(thread_id);
+#ifdef __linux__
+  // all the cpus of the node: the system balances the threads of a node
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : fNodeCpus[node])
+    CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    return;
+#endif
+  fCurrentNode = std::min(node, MaxNodes - 1);
+}
+
+std::vector<std::vector<int>> GateNuma::ReadTopology() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  namespace fs = std::filesystem;
+  const fs::path root("/sys/devices/system/node");
+  std::error_code ec;
+  for (int n = 0; n < MaxNodes; n++) {
+    auto filename = root / ("node" + std::to_string(n)) / "cpulist";
+    if (!fs::exists(filename, ec))
+      continue;
+    std::ifstream is(filename);
+    std::string list;
+    std::getline(is, list);
+    auto cpus = ParseCpuList(list);
+    // (memory-only nodes have no cpu)
+    if (!cpus.empty())
+      nodes.push_back(cpus);
+  }
+#endif
+  return nodes;
+}
+
+std::vector<int> GateNuma::ParseCpuList(const std::string &list) {
+  // e.g. "0-15,32-47"
+  std::vector<int> cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    if (range.empty())
+      continue;
+    auto dash = range.find('-');
+    auto first = std::stoi(range.substr(0, dash));
+    auto last = dash == std::string::npos ? first
+                                          : std::stoi(range.substr(dash + 1));
+    for (auto cpu = first; cpu <= last; cpu++)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
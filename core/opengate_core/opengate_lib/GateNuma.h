@@ -0,0 +1,110 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateNuma_h
+#define GateNuma_h
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    NUMA placement of the worker threads (Linux, nodes read from
+    /sys/devices/system/node). With a policy, each worker thread is pinned to
+    the cpus of one node when it starts, before its run manager, physics
+    tables and per-thread buffers (actors, sources, digi attributes) are
+    allocated: with the default first-touch policy of the system, the memory
+    of a thread is then on its own node.
+
+    - "compact": the threads fill the cpus of the first node, then of the
+      next one (fewest nodes).
+    - "spread": the threads are placed on the nodes in turn (all the memory
+      bandwidth with few threads).
+
+    Shared read-only tables (e.g. mu tables) can also be replicated on each
+    node, see GateNumaReplica. Without policy, or with a single node,
+    nothing is changed.
+ */
+
+class GateNuma {
+public:
+  // Master thread, before the workers are created: policy "" (none),
+  // "compact" or "spread", and replication of the shared tables
+  static void Configure(const std::string &policy, bool replicate);
+
+  static bool IsEnabled() { return !fNodeCpus.empty(); }
+
+  static bool IsReplicationEnabled() { return IsEnabled() && fReplicate; }
+
+  static int GetNumberOfNodes();
+
+  // Pin the calling worker thread (Geant4 thread id) to its node
+  static void PinCurrentThread(int thread_id);
+
+  // Node of the calling thread (0 when it is not pinned)
+  static int GetCurrentNode() { return fCurrentNode; }
+
+  // Node of the thread id with the current policy
+  static int GetNodeOfThread(int thread_id);
+
+  static constexpr int MaxNodes = 64;
+
+protected:
+  // cpus of each node (only the nodes with cpus)
+  static std::vector<std::vector<int>> ReadTopology();
+
+  static std::vector<int> ParseCpuList(const std::string &list);
+
+  static std::vector<std::vector<int>> fNodeCpus;
+  static std::string fPolicy;
+  static bool fReplicate;
+  static thread_local int fCurrentNode;
+};
+
+/*
+    Copy of a read-only object on each NUMA node: the first thread of a node
+    that needs it copies the original (the pages are first-touched on its
+    node), the other threads of the node share this copy. Without
+    replication, Get returns the original.
+ */
+template <class T> class GateNumaReplica {
+public:
+  const T &Get(const T &original) {
+    if (!GateNuma::IsReplicationEnabled())
+      return original;
+    auto &slot = fCopies[GateNuma::GetCurrentNode()];
+    const auto *copy = slot.load(std::memory_order_acquire);
+    if (copy != nullptr)
+      return *copy;
+    std::lock_guard<std::mutex> lock(fMutex);
+    copy = slot.load(std::memory_order_relaxed);
+    if (copy == nullptr) {
+      fOwned.emplace_back(std::make_unique<T>(original));
+      copy = fOwned.back().get();
+      slot.store(copy, std::memory_order_release);
+    }
+    return *copy;
+  }
+
+  // The original has changed (master thread, no worker is running)
+  void Clear() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (auto &slot : fCopies)
+      slot.store(nullptr, std::memory_order_relaxed);
+    fOwned.clear();
+  }
+
+protected:
+  std::array<std::atomic<const T *>, GateNuma::MaxNodes> fCopies{};
+  std::vector<std::unique_ptr<T>> fOwned;
+  std::mutex fMutex;
+};
+
+#endif // GateNuma_h
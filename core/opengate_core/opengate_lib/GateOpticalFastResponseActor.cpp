@@ -0,0 +1,386 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateOpticalFastResponseActor.h"
+#include "CLHEP/Random/RandBinomial.h"
+#include "G4LogicalVolumeStore.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Poisson.hh"
+#include "G4ProcessTable.hh"
+#include "G4RandomTools.hh"
+#include "G4Scintillation.hh"
+#include "G4VProcess.hh"
+#include "GateHelpersDict.h"
+#include "GateMutex.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+GATE_MUTEX(OpticalFastResponseMutex);
+
+GateOpticalFastResponseActor::GateOpticalFastResponseActor(
+    py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("BeginOfRunAction");
+  fActions.insert("BeginOfEventAction");
+  fActions.insert("EndOfEventAction");
+  fActions.insert("EndOfRunAction");
+  fCalibrationMode = false;
+  fBins[0] = fBins[1] = fBins[2] = 1;
+  fTimeBins = 1;
+  fTimeMax = 0;
+  fNumberOfTimes = 1;
+}
+
+void GateOpticalFastResponseActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fCalibrationMode = DictGetStr(user_info, "mode") == "calibration";
+  fDetectorVolumeNames = DictGetVecStr(user_info, "detector_volumes");
+  auto bins = DictGetVecInt(user_info, "bins");
+  fTimeBins = DictGetInt(user_info, "time_bins");
+  fTimeMax = DictGetDouble(user_info, "time_max");
+  fNumberOfTimes = DictGetInt(user_info, "number_of_times");
+  if (bins.size() != 3 || *std::min_element(bins.begin(), bins.end()) < 1 ||
+      fTimeBins < 1 || fTimeMax <= 0 || fNumberOfTimes < 1) {
+    std::ostringstream oss;
+    oss << "Invalid parameters of the OpticalFastResponseActor '" << GetName()
+        << "': bins, time_bins, time_max and number_of_times must be "
+           "positive (3 bins).";
+    Fatal(oss.str());
+  }
+  std::copy(bins.begin(), bins.end(), fBins);
+  // the optical photons are only tracked in the calibration mode
+  if (fCalibrationMode) {
+    fActions.insert("PreUserTrackingAction");
+    fActions.insert("PostUserTrackingAction");
+  } else {
+    fActions.insert("SteppingAction");
+  }
+  // (the photons end in the detector volumes, out of the crystal)
+  fTrackingActionsInVolumesOnly = false;
+}
+
+void GateOpticalFastResponseActor::InitializeCpp() {
+  fCreated.clear();
+  fDetected.clear();
+  fTransit.clear();
+  fRecords.clear();
+}
+
+void GateOpticalFastResponseActor::SetLookupTable(
+    std::vector<double> pmin, std::vector<double> pmax,
+    std::vector<int> bins, double time_max, std::vector<double> probability,
+    std::vector<double> transit) {
+  const size_t n = pmin.size() == 3 && pmax.size() == 3 && bins.size() == 3
+                       ? size_t(bins[0]) * bins[1] * bins[2]
+                       : 0;
+  if (n == 0 || probability.size() != n || transit.empty() ||
+      transit.size() % n != 0) {
+    std::ostringstream oss;
+    oss << "Invalid lookup table for the OpticalFastResponseActor '"
+        << GetName() << "': " << probability.size() << " probabilities and "
+        << transit.size() << " transit time bins.";
+    Fatal(oss.str());
+  }
+  fTableMin = G4ThreeVector(pmin[0], pmin[1], pmin[2]);
+  fTableMax = G4ThreeVector(pmax[0], pmax[1], pmax[2]);
+  std::copy(bins.begin(), bins.end(), fBins);
+  fTimeBins = static_cast<int>(transit.size() / n);
+  fTimeMax = time_max;
+  fProbability = probability;
+  // cumulative distribution of the transit times of each bin
+  fTransitCDF = transit;
+  for (size_t i = 0; i < n; i++) {
+    auto first = fTransitCDF.begin() + i * fTimeBins;
+    std::partial_sum(first, first + fTimeBins, first);
+  }
+}
+
+void GateOpticalFastResponseActor::BeginOfRunActionMasterThread(
+    int /*run_id*/) {
+  auto *store = G4LogicalVolumeStore::GetInstance();
+  fCrystal = store->GetVolume(fAttachedToVolumeName);
+  fCrystal->GetSolid()->BoundingLimits(fBoxMin, fBoxMax);
+  fDetectors.clear();
+  for (const auto &name : fDetectorVolumeNames) {
+    const auto *lv = store->GetVolume(name, false);
+    if (lv == nullptr) {
+      std::ostringstream oss;
+      oss << "The detector volume '" << name << "' of the "
+          << "OpticalFastResponseActor '" << GetName() << "' does not exist.";
+      Fatal(oss.str());
+    }
+    fDetectors.insert(lv);
+  }
+
+  const size_t n = size_t(fBins[0]) * fBins[1] * fBins[2];
+  if (fCalibrationMode) {
+    if (fDetectors.empty()) {
+      Fatal("The OpticalFastResponseActor '" + GetName() +
+            "' needs at least one detector volume in calibration mode.");
+    }
+    fCreated.resize(n, 0);
+    fDetected.resize(n, 0);
+    fTransit.resize(n * fTimeBins, 0);
+    return;
+  }
+
+  // fast mode: the table must be the one of this crystal
+  if (fProbability.size() != n) {
+    Fatal("No lookup table for the OpticalFastResponseActor '" + GetName() +
+          "' (see SetLookupTable).");
+  }
+  const double tolerance = 1e-6 * CLHEP::mm;
+  if ((fTableMin - fBoxMin).mag() > tolerance ||
+      (fTableMax - fBoxMax).mag() > tolerance) {
+    std::ostringstream oss;
+    oss << "The lookup table of the OpticalFastResponseActor '" << GetName()
+        << "' has been computed for a crystal " << fTableMin << " "
+        << fTableMax << " while the crystal '" << fAttachedToVolumeName
+        << "' is " << fBoxMin << " " << fBoxMax;
+    Fatal(oss.str());
+  }
+  InitializeScintillation(fCrystal->GetMaterial());
+}
+
+void GateOpticalFastResponseActor::InitializeScintillation(
+    const G4Material *material) {
+  auto *mpt = material->GetMaterialPropertiesTable();
+  if (mpt == nullptr || !mpt->ConstPropertyExists("SCINTILLATIONYIELD")) {
+    Fatal("The material " + material->GetName() + " of the crystal '" +
+          fAttachedToVolumeName +
+          "' has no SCINTILLATIONYIELD (OpticalFastResponseActor '" +
+          GetName() + "').");
+  }
+  fYield = mpt->GetConstProperty("SCINTILLATIONYIELD");
+  fResolutionScale = 1;
+  if (mpt->ConstPropertyExists("RESOLUTIONSCALE"))
+    fResolutionScale = mpt->GetConstProperty("RESOLUTIONSCALE");
+
+  // decay time components, with their relative yields
+  fTimeConstants.clear();
+  fComponentsCDF.clear();
+  double sum = 0;
+  for (int i = 1; i <= 3; i++) {
+    auto tau = "SCINTILLATIONTIMECONSTANT" + std::to_string(i);
+    auto yield = "SCINTILLATIONYIELD" + std::to_string(i);
+    if (!mpt->ConstPropertyExists(tau.c_str()))
+      continue;
+    fTimeConstants.push_back(mpt->GetConstProperty(tau.c_str()));
+    sum += mpt->ConstPropertyExists(yield.c_str())
+               ? mpt->GetConstProperty(yield.c_str())
+               : 1;
+    fComponentsCDF.push_back(sum);
+  }
+}
+
+void GateOpticalFastResponseActor::BeginOfRunAction(const G4Run * /*run*/) {
+  auto &l = fThreadLocalData.Get();
+  if (fCalibrationMode) {
+    l.fCreated.assign(fCreated.size(), 0);
+    l.fDetected.assign(fDetected.size(), 0);
+    l.fTransit.assign(fTransit.size(), 0);
+    return;
+  }
+  // fast mode: the scintillation photons are counted by G4Scintillation
+  // but not created (processes of this thread)
+  auto *processes =
+      G4ProcessTable::GetProcessTable()->FindProcesses("Scintillation");
+  for (size_t i = 0; i < processes->size(); i++) {
+    auto *scintillation = dynamic_cast<G4Scintillation *>((*processes)[i]);
+    if (scintillation != nullptr)
+      scintillation->SetStackPhotons(false);
+  }
+  delete processes;
+}
+
+void GateOpticalFastResponseActor::BeginOfEventAction(
+    const G4Event * /*event*/) {
+  fThreadLocalData.Get().fEventTimes.clear();
+}
+
+bool GateOpticalFastResponseActor::GetLocalPosition(
+    const G4VTouchable *touchable, const G4ThreeVector &position,
+    G4ThreeVector &local, int &copy) const {
+  const auto depth = touchable->GetHistoryDepth();
+  for (int d = 0; d <= depth; d++) {
+    if (touchable->GetVolume(d)->GetLogicalVolume() != fCrystal)
+      continue;
+    copy = touchable->GetCopyNumber(d);
+    local = touchable->GetHistory()
+                ->GetTransform(depth - d)
+                .TransformPoint(position);
+    return true;
+  }
+  return false;
+}
+
+int GateOpticalFastResponseActor::GetBin(const G4ThreeVector &local) const {
+  int index[3];
+  for (int i = 0; i < 3; i++) {
+    const double size = fBoxMax[i] - fBoxMin[i];
+    auto b = static_cast<int>((local[i] - fBoxMin[i]) / size * fBins[i]);
+    index[i] = std::clamp(b, 0, fBins[i] - 1);
+  }
+  return (index[2] * fBins[1] + index[1]) * fBins[0] + index[0];
+}
+
+double GateOpticalFastResponseActor::SampleTransitTime(int bin) const {
+  auto first = fTransitCDF.begin() + size_t(bin) * fTimeBins;
+  auto last = first + fTimeBins;
+  const double total = *(last - 1);
+  if (total <= 0)
+    return 0;
+  auto it = std::upper_bound(first, last, G4UniformRand() * total);
+  auto t = std::min(static_cast<int>(it - first), fTimeBins - 1);
+  return (t + G4UniformRand()) * fTimeMax / fTimeBins;
+}
+
+double GateOpticalFastResponseActor::SampleDecayTime() const {
+  if (fTimeConstants.empty())
+    return 0;
+  size_t i = 0;
+  if (fTimeConstants.size() > 1) {
+    auto u = G4UniformRand() * fComponentsCDF.back();
+    auto it =
+        std::upper_bound(fComponentsCDF.begin(), fComponentsCDF.end(), u);
+    i = std::min(static_cast<size_t>(it - fComponentsCDF.begin()),
+                 fTimeConstants.size() - 1);
+  }
+  return -fTimeConstants[i] * std::log(G4UniformRand());
+}
+
+void GateOpticalFastResponseActor::SteppingAction(G4Step *step) {
+  const auto edep = step->GetTotalEnergyDeposit();
+  if (edep <= 0)
+    return;
+  const auto *pre = step->GetPreStepPoint();
+  const auto *post = step->GetPostStepPoint();
+  const auto middle = (pre->GetPosition() + post->GetPosition()) / 2;
+  G4ThreeVector local;
+  int copy;
+  if (!GetLocalPosition(pre->GetTouchable(), middle, local, copy))
+    return;
+
+  // number of scintillation photons (as G4Scintillation)
+  const double mean = fYield * edep;
+  long n;
+  if (mean > 10) {
+    const double sigma = fResolutionScale * std::sqrt(mean);
+    n = static_cast<long>(G4RandGauss::shoot(mean, sigma) + 0.5);
+  } else {
+    n = G4Poisson(mean);
+  }
+  const auto bin = GetBin(local);
+  const auto p = fProbability[bin];
+  if (n <= 0 || p <= 0)
+    return;
+
+  // detected photons and their times
+  const auto detected = static_cast<long>(
+      CLHEP::RandBinomial::shoot(G4Random::getTheEngine(), n, p));
+  if (detected <= 0)
+    return;
+  auto &times = fThreadLocalData.Get().fEventTimes[copy];
+  const double t0 = pre->GetGlobalTime();
+  const double dt = post->GetGlobalTime() - t0;
+  for (long i = 0; i < detected; i++) {
+    times.push_back(t0 + G4UniformRand() * dt + SampleDecayTime() +
+                    SampleTransitTime(bin));
+  }
+}
+
+void GateOpticalFastResponseActor::PreUserTrackingAction(
+    const G4Track *track) {
+  auto &l = fThreadLocalData.Get();
+  l.fTrackBin = -1;
+  if (track->GetDefinition() != G4OpticalPhoton::Definition())
+    return;
+  const auto *creator = track->GetCreatorProcess();
+  if (creator == nullptr || creator->GetProcessName() != "Scintillation")
+    return;
+  G4ThreeVector local;
+  int copy;
+  if (!GetLocalPosition(track->GetTouchable(), track->GetPosition(), local,
+                        copy))
+    return;
+  l.fTrackBin = GetBin(local);
+  l.fTrackCopy = copy;
+  l.fCreated[l.fTrackBin]++;
+}
+
+void GateOpticalFastResponseActor::PostUserTrackingAction(
+    const G4Track *track) {
+  auto &l = fThreadLocalData.Get();
+  if (l.fTrackBin < 0)
+    return;
+  const auto bin = l.fTrackBin;
+  l.fTrackBin = -1;
+  // volume where the photon ends (absorbed, or killed at its boundary)
+  const auto *pv = track->GetNextVolume();
+  if (pv == nullptr || fDetectors.count(pv->GetLogicalVolume()) == 0)
+    return;
+  l.fDetected[bin]++;
+  auto t = static_cast<int>(track->GetLocalTime() / fTimeMax * fTimeBins);
+  l.fTransit[size_t(bin) * fTimeBins + std::min(t, fTimeBins - 1)]++;
+  l.fEventTimes[l.fTrackCopy].push_back(track->GetGlobalTime());
+}
+
+void GateOpticalFastResponseActor::EndOfEventAction(const G4Event *event) {
+  auto &l = fThreadLocalData.Get();
+  for (auto &[copy, times] : l.fEventTimes) {
+    if (times.empty())
+      continue;
+    Record r{event->GetEventID(), copy, static_cast<long>(times.size()), {}};
+    const auto k = std::min(times.size(), size_t(fNumberOfTimes));
+    std::partial_sort(times.begin(), times.begin() + k, times.end());
+    r.fTimes.assign(times.begin(), times.begin() + k);
+    r.fTimes.resize(fNumberOfTimes, -1);
+    l.fRecords.push_back(std::move(r));
+  }
+  l.fEventTimes.clear();
+}
+
+void GateOpticalFastResponseActor::EndOfRunAction(const G4Run * /*run*/) {
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&OpticalFastResponseMutex);
+  for (size_t i = 0; i < l.fCreated.size(); i++) {
+    fCreated[i] += l.fCreated[i];
+    fDetected[i] += l.fDetected[i];
+  }
+  for (size_t i = 0; i < l.fTransit.size(); i++)
+    fTransit[i] += l.fTransit[i];
+  std::move(l.fRecords.begin(), l.fRecords.end(),
+            std::back_inserter(fRecords));
+  l.fRecords.clear();
+}
+
+std::vector<double> GateOpticalFastResponseActor::GetBoxMin() const {
+  return {fBoxMin.x(), fBoxMin.y(), fBoxMin.z()};
+}
+
+std::vector<double> GateOpticalFastResponseActor::GetBoxMax() const {
+  return {fBoxMax.x(), fBoxMax.y(), fBoxMax.z()};
+}
+
+py::dict GateOpticalFastResponseActor::GetResults() const {
+  std::vector<int> event_id, copy;
+  std::vector<long> photons;
+  std::vector<double> times;
+  for (const auto &r : fRecords) {
+    event_id.push_back(r.fEventId);
+    copy.push_back(r.fCopy);
+    photons.push_back(r.fPhotons);
+    times.insert(times.end(), r.fTimes.begin(), r.fTimes.end());
+  }
+  py::dict d;
+  d["event_id"] = event_id;
+  d["copy"] = copy;
+  d["photons"] = photons;
+  d["times"] = times;
+  return d;
+}
@@ -0,0 +1,162 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateOpticalFastResponseActor_h
+#define GateOpticalFastResponseActor_h
+
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "GateThreadContext.h"
+#include "GateVActor.h"
+#include <map>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Light collection of scintillation crystals, without tracking the optical
+ * photons. The actor is attached to the crystal (all the crystals are
+ * copies of the same logical volume, they share a single table). The
+ * crystal is divided into bins (bounding box, local coordinates).
+ *
+ * - "calibration" mode: full optical simulation. The scintillation photons
+ *   created in the crystal are counted in the bin where they are created;
+ *   the ones that end in a detector volume (e.g. the photosensor, which
+ *   absorbs them) are detected, and their transit time is histogrammed.
+ *   The table (detection probability and transit time distribution of
+ *   each bin) is written on the Python side.
+ * - "fast" mode: the scintillation photons are not created (their stacking
+ *   is disabled in all the volumes). At each step with an energy deposit in
+ *   the crystal, the number of photons is sampled from the yield and the
+ *   resolution scale of the material (as G4Scintillation does, without the
+ *   Birks saturation), then the number of detected photons from the
+ *   probability of the bin (binomial). The time of a detected photon is the
+ *   time of the step, plus the scintillation decay time (one component per
+ *   SCINTILLATIONTIMECONSTANTi), plus a transit time from the histogram.
+ *
+ * In both modes, the number of detected photons and the times of the first
+ * ones are recorded for each event and each crystal (copy number).
+ */
+
+class GateOpticalFastResponseActor : public GateVActor {
+
+public:
+  explicit GateOpticalFastResponseActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  // Table of the fast mode: probability[bin], transit[bin * time_bins + t]
+  // (normalized or not), bins in [pmin, pmax] (local coordinates)
+  void SetLookupTable(std::vector<double> pmin, std::vector<double> pmax,
+                      std::vector<int> bins, double time_max,
+                      std::vector<double> probability,
+                      std::vector<double> transit);
+
+  // Called every time a Run starts (master thread)
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void BeginOfEventAction(const G4Event *event) override;
+
+  void EndOfEventAction(const G4Event *event) override;
+
+  void PreUserTrackingAction(const G4Track *track) override;
+
+  void PostUserTrackingAction(const G4Track *track) override;
+
+  // Main function called every step in attached volume
+  void SteppingAction(G4Step *step) override;
+
+  // The results of the thread are added to the ones of the actor
+  void EndOfRunAction(const G4Run *run) override;
+
+  // calibration: number of created and detected photons per bin, and
+  // histograms of the transit times (bin * time_bins + t)
+  std::vector<double> GetCreatedPhotons() const { return fCreated; }
+  std::vector<double> GetDetectedPhotons() const { return fDetected; }
+  std::vector<double> GetTransitHistograms() const { return fTransit; }
+
+  // bounding box of the crystal (local coordinates)
+  std::vector<double> GetBoxMin() const;
+  std::vector<double> GetBoxMax() const;
+
+  // event_id, copy, photons, times (number_of_times per record, -1 if
+  // fewer photons are detected)
+  py::dict GetResults() const;
+
+protected:
+  struct Record {
+    int fEventId;
+    int fCopy;
+    long fPhotons;
+    std::vector<double> fTimes;
+  };
+
+  // Local position and copy number of the crystal of the touchable, false if
+  // it is not in the crystal
+  bool GetLocalPosition(const G4VTouchable *touchable,
+                        const G4ThreeVector &position, G4ThreeVector &local,
+                        int &copy) const;
+
+  // Index of the bin of the local position (clamped to the box)
+  int GetBin(const G4ThreeVector &local) const;
+
+  double SampleTransitTime(int bin) const;
+
+  double SampleDecayTime() const;
+
+  void InitializeScintillation(const G4Material *material);
+
+  bool fCalibrationMode;
+  std::vector<std::string> fDetectorVolumeNames;
+  int fBins[3];
+  int fTimeBins;
+  double fTimeMax;
+  int fNumberOfTimes;
+
+  const G4LogicalVolume *fCrystal = nullptr;
+  std::set<const G4LogicalVolume *> fDetectors;
+  G4ThreeVector fBoxMin;
+  G4ThreeVector fBoxMax;
+
+  // table of the fast mode, cumulative transit distributions
+  std::vector<double> fProbability;
+  std::vector<double> fTransitCDF;
+  G4ThreeVector fTableMin;
+  G4ThreeVector fTableMax;
+
+  // scintillation of the crystal material
+  double fYield = 0;
+  double fResolutionScale = 1;
+  std::vector<double> fTimeConstants;
+  std::vector<double> fComponentsCDF;
+
+  // calibration tables and results (all threads)
+  std::vector<double> fCreated;
+  std::vector<double> fDetected;
+  std::vector<double> fTransit;
+  std::vector<Record> fRecords;
+
+  struct threadLocalT {
+    std::vector<double> fCreated;
+    std::vector<double> fDetected;
+    std::vector<double> fTransit;
+    std::vector<Record> fRecords;
+    // detected photon times of the current event, per copy
+    std::map<int, std::vector<double>> fEventTimes;
+    // bin and copy of the current optical photon (calibration), -1 if none
+    int fTrackBin = -1;
+    int fTrackCopy = -1;
+  };
+  GateThreadLocal<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateOpticalFastResponseActor_h
@@ -31,8 +31,10 @@
 #include "G4BiasingProcessInterface.hh"
 
 #include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
 #include "G4Exception.hh"
 #include "G4Gamma.hh"
+#include "G4PhysicalConstants.hh"
 #include "G4ParticleChange.hh"
 #include "G4ParticleChangeForGamma.hh"
 #include "G4SystemOfUnits.hh"
@@ -43,7 +45,7 @@
 
 GateOptnComptSplitting::GateOptnComptSplitting(G4String name)
     : G4VBiasingOperation(name), fSplittingFactor(1), fRussianRoulette(false),
-      fParticleChange() {}
+      fKleinNishina(false), fParticleChange() {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -73,6 +75,12 @@ G4VParticleChange *GateOptnComptSplitting::ApplyFinalStateBiasing(
   G4VParticleChange *processFinalState = nullptr;
   G4ParticleChangeForGamma *castedProcessInitFinalState = nullptr;
 
+  // Klein-Nishina mode: the photons are sampled without calling the wrapped
+  // process (it is still used when there is no splitting, see below)
+  if (fKleinNishina && !(fSplittingFactor == 1 && fRussianRoulette == false) &&
+      track->GetWeight() > fMinWeightOfParticle)
+    return ApplyKleinNishinaSplitting(track, step);
+
   while (isRightAngle == false) {
     gammaWeight = track->GetWeight() / fSplittingFactor;
     processFinalState =
@@ -248,3 +256,122 @@ G4VParticleChange *GateOptnComptSplitting::ApplyFinalStateBiasing(
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange *
+GateOptnComptSplitting::ApplyKleinNishinaSplitting(const G4Track *track,
+                                                   const G4Step *step) {
+  // Same splitting and russian roulette as above, but each photon costs one
+  // sampling of the Klein-Nishina cross-section instead of a full call of
+  // the model (no Doppler broadening, no atomic shell, no fluorescence).
+  // The first kept photon continues the track, the other ones (and all the
+  // electrons) are secondaries.
+  G4double globalTime = step->GetTrack()->GetGlobalTime();
+  const G4ThreeVector position = step->GetPostStepPoint()->GetPosition();
+  const G4double energy = track->GetKineticEnergy();
+  const G4ThreeVector direction = track->GetMomentumDirection();
+  G4int splittingFactor = ceil(fSplittingFactor);
+  G4double survivalProbabilitySplitting =
+      1 - (splittingFactor - fSplittingFactor) / splittingFactor;
+  const G4double cosMaxTheta = std::cos(fMaxTheta);
+  // Below this energy, the electron is not tracked (as in the G4 models)
+  const G4double lowestElectronEnergy = 100.0 * eV;
+
+  fParticleChange.Initialize(*track);
+  fParticleChange.SetSecondaryWeightByProcess(true);
+  G4bool hasPrimary = false;
+  G4double primaryWeight = track->GetWeight();
+  G4double weightedLocalEnergyDeposit = 0;
+
+  for (G4int i = 0; i < splittingFactor; i++) {
+    if (survivalProbabilitySplitting != 1 &&
+        G4UniformRand() > survivalProbabilitySplitting)
+      continue;
+    G4double gammaEnergy;
+    G4ThreeVector gammaDirection;
+    SampleKleinNishina(energy, direction, gammaEnergy, gammaDirection);
+
+    // Russian roulette outside the acceptance angle, with a probability
+    // 1/split to survive (and a weight multiplied by split)
+    G4double gammaWeight = track->GetWeight() / fSplittingFactor;
+    if (fRussianRoulette && fVectorDirector * gammaDirection < cosMaxTheta) {
+      if (G4UniformRand() >= 1 / fSplittingFactor)
+        continue;
+      gammaWeight = gammaWeight * fSplittingFactor;
+    }
+
+    if (!hasPrimary) {
+      fParticleChange.ProposeWeight(gammaWeight);
+      fParticleChange.ProposeEnergy(gammaEnergy);
+      fParticleChange.ProposeMomentumDirection(gammaDirection);
+      primaryWeight = gammaWeight;
+      hasPrimary = true;
+    } else {
+      G4Track *gammaTrack = new G4Track(*track);
+      gammaTrack->SetWeight(gammaWeight);
+      gammaTrack->SetKineticEnergy(gammaEnergy);
+      gammaTrack->SetMomentumDirection(gammaDirection);
+      gammaTrack->SetPosition(position);
+      fParticleChange.AddSecondary(gammaTrack);
+    }
+
+    // The Compton electron takes the rest of the momentum
+    G4double electronEnergy = energy - gammaEnergy;
+    if (electronEnergy > lowestElectronEnergy) {
+      G4ThreeVector electronDirection =
+          (energy * direction - gammaEnergy * gammaDirection).unit();
+      auto *electron = new G4DynamicParticle(
+          G4Electron::Electron(), electronDirection, electronEnergy);
+      G4Track *electronTrack = new G4Track(electron, globalTime, position);
+      electronTrack->SetWeight(gammaWeight);
+      fParticleChange.AddSecondary(electronTrack);
+    } else {
+      weightedLocalEnergyDeposit += electronEnergy * gammaWeight;
+    }
+  }
+
+  // No photon kept by the russian roulette: the track is killed
+  if (!hasPrimary)
+    fParticleChange.ProposeTrackStatus(G4TrackStatus::fStopAndKill);
+
+  // (the deposit is counted with the weight of the track)
+  if (weightedLocalEnergyDeposit > 0)
+    fParticleChange.ProposeLocalEnergyDeposit(weightedLocalEnergyDeposit /
+                                              primaryWeight);
+  return &fParticleChange;
+}
+
+void GateOptnComptSplitting::SampleKleinNishina(
+    G4double energy, const G4ThreeVector &direction,
+    G4double &scatteredEnergy, G4ThreeVector &scatteredDirection) {
+  // Same sampling as G4KleinNishinaCompton (Butcher & Messel): epsilon is
+  // the ratio of the scattered to the incident photon energy
+  G4double e0m = energy / electron_mass_c2;
+  G4double eps0 = 1. / (1. + 2. * e0m);
+  G4double eps0sq = eps0 * eps0;
+  G4double alpha1 = -std::log(eps0);
+  G4double alpha2 = alpha1 + 0.5 * (1. - eps0sq);
+
+  G4double epsilon, epsilonsq, onecost, sint2, greject;
+  do {
+    if (alpha1 > alpha2 * G4UniformRand()) {
+      epsilon = std::exp(-alpha1 * G4UniformRand());
+      epsilonsq = epsilon * epsilon;
+    } else {
+      epsilonsq = eps0sq + (1. - eps0sq) * G4UniformRand();
+      epsilon = std::sqrt(epsilonsq);
+    }
+    onecost = (1. - epsilon) / (epsilon * e0m);
+    sint2 = onecost * (2. - onecost);
+    greject = 1. - epsilon * sint2 / (1. + epsilonsq);
+  } while (greject < G4UniformRand());
+
+  G4double cosTeta = 1. - onecost;
+  G4double sinTeta = std::sqrt(std::max(sint2, 0.));
+  G4double phi = twopi * G4UniformRand();
+  scatteredDirection = G4ThreeVector(sinTeta * std::cos(phi),
+                                     sinTeta * std::sin(phi), cosTeta);
+  scatteredDirection.rotateUz(direction);
+  scatteredEnergy = energy * epsilon;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
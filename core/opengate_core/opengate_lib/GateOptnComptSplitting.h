@@ -99,18 +99,36 @@ public:
 
   G4double GetMinWeightOfParticle() const { return fMinWeightOfParticle; }
 
+  // -- If true, the split photons are sampled from the Klein-Nishina
+  // -- cross-section instead of calling the wrapped process for each one:
+  void SetKleinNishina(G4bool kleinNishina) { fKleinNishina = kleinNishina; }
+
+  G4bool GetKleinNishina() const { return fKleinNishina; }
+
   G4VParticleChange *GetParticleChange() {
     G4VParticleChange *particleChange = &fParticleChange;
     return particleChange;
   }
 
 private:
+  // All the photons (and electrons) of the interaction, from the
+  // Klein-Nishina cross-section (free electron at rest)
+  G4VParticleChange *ApplyKleinNishinaSplitting(const G4Track *track,
+                                                const G4Step *step);
+
+  // Energy and direction of a scattered photon
+  static void SampleKleinNishina(G4double energy,
+                                 const G4ThreeVector &direction,
+                                 G4double &scatteredEnergy,
+                                 G4ThreeVector &scatteredDirection);
+
   G4double fSplittingFactor;
   G4ParticleChange fParticleChange;
   G4bool fRussianRoulette;
   G4ThreeVector fVectorDirector;
   G4double fMaxTheta;
   G4double fMinWeightOfParticle;
+  G4bool fKleinNishina;
   // G4DynamicParticle* fSplitParticle;
   // G4Track* fGammaTrack;
 };
@@ -64,6 +64,15 @@ void GateOptrComptSplittingActor::InitializeUserInfo(py::dict &user_info) {
   fRussianRoulette = DictGetBool(user_info, "russian_roulette");
   fVectorDirector = DictGetG4ThreeVector(user_info, "vector_director");
   fMaxTheta = DictGetDouble(user_info, "max_theta");
+  auto mode = DictGetStr(user_info, "splitting_mode");
+  if (mode != "model" && mode != "klein_nishina") {
+    std::ostringstream oss;
+    oss << "Error in GateOptrComptSplittingActor: unknown splitting_mode. "
+           "Must be 'model' or 'klein_nishina' while '"
+        << mode << "' is read.";
+    Fatal(oss.str());
+  }
+  fKleinNishina = mode == "klein_nishina";
 }
 
 void GateOptrComptSplittingActor::InitializeCpp() {
@@ -98,6 +107,7 @@ void GateOptrComptSplittingActor::StartRun() {
   fComptSplittingOperation->SetMaxTheta(fMaxTheta);
   fComptSplittingOperation->SetRussianRoulette(fRussianRoulette);
   fComptSplittingOperation->SetMinWeightOfParticle(fMinWeightOfParticle);
+  fComptSplittingOperation->SetKleinNishina(fKleinNishina);
 
   // The way to behave of the russian roulette is the following :
   // we provide a vector director and the theta angle acceptance, where theta =
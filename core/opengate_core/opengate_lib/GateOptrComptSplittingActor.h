@@ -65,6 +65,7 @@ public:
   G4bool fRotationVectorDirector;
   G4ThreeVector fVectorDirector;
   G4double fMaxTheta;
+  G4bool fKleinNishina;
   // Unused but mandatory
 
   void StartRun() override;
@@ -7,6 +7,8 @@ Copyright (C): OpenGATE Collaboration
 
 #include "GateOptrFreeFlightActor.h"
 #include "G4BiasingProcessInterface.hh"
+#include "G4Gamma.hh"
+#include "G4PhysicalConstants.hh"
 #include "GateHelpersDict.h"
 #include "GateHelpersImage.h"
 
@@ -25,18 +27,36 @@ void GateOptrFreeFlightActor::InitializeCpp() {}
 
 void GateOptrFreeFlightActor::InitializeUserInfo(py::dict &user_info) {
   GateVActor::InitializeUserInfo(user_info);
+  const auto mode = DictGetStr(user_info, "free_flight_mode");
+  if (mode != "biasing" && mode != "voxel") {
+    std::ostringstream oss;
+    oss << "The free_flight_mode of the actor " << GetName()
+        << " must be 'biasing' or 'voxel', while it is '" << mode << "'";
+    Fatal(oss.str());
+  }
+  fVoxelMode = mode == "voxel";
+  if (fVoxelMode) {
+    fDatabase = DictGetStr(user_info, "database");
+    fEnergyMax = DictGetDouble(user_info, "energy_max");
+    fActions.insert("SteppingAction");
+  }
 }
 
 void GateOptrFreeFlightActor::Configure() {
+  // (in voxel mode, the photons are moved by the actor)
+  if (fVoxelMode)
+    return;
   auto *biasedVolume =
       G4LogicalVolumeStore::GetInstance()->GetVolume(fAttachedToVolumeName);
   AttachAllLogicalDaughtersVolumes(biasedVolume);
 }
 
 void GateOptrFreeFlightActor::ConfigureForWorker() {
-  auto *biasedVolume =
-      G4LogicalVolumeStore::GetInstance()->GetVolume(fAttachedToVolumeName);
-  AttachAllLogicalDaughtersVolumes(biasedVolume);
+  if (!fVoxelMode) {
+    auto *biasedVolume =
+        G4LogicalVolumeStore::GetInstance()->GetVolume(fAttachedToVolumeName);
+    AttachAllLogicalDaughtersVolumes(biasedVolume);
+  }
   // set to null, will be created the first time in StartTracking
   threadLocal_t &l = threadLocalData.Get();
   l.fFreeFlightOperation = nullptr;
@@ -84,3 +104,77 @@ G4VBiasingOperation *GateOptrFreeFlightActor::ProposeFinalStateBiasingOperation(
 void GateOptrFreeFlightActor::PreUserTrackingAction(const G4Track *track) {
   StartTracking(track);
 }
+
+void GateOptrFreeFlightActor::SetPhantomVolumeName(std::string name) {
+  fPhantomVolumeName = name;
+}
+
+void GateOptrFreeFlightActor::SetImageParameterisation(
+    GateImageNestedParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateOptrFreeFlightActor::SetImageParameterisation(
+    GateImageRegularParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->GetLabelMaterials();
+}
+
+void GateOptrFreeFlightActor::SetImageParameterisation(
+    GateImageRunParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateOptrFreeFlightActor::BeginOfRunActionMasterThread(int /*run_id*/) {
+  if (!fVoxelMode)
+    return;
+  // phantom geometry and labels (the image may change between runs)
+  fAttenuation.Initialize(
+      fLabelImage, *fLabelMaterials, fPhantomVolumeName,
+      GateMaterialMuHandler::GetInstance(fDatabase, fEnergyMax));
+}
+
+void GateOptrFreeFlightActor::SteppingAction(G4Step *step) {
+  // (voxel mode only) the first step of a photon in the phantom: the
+  // photon is then replaced, there is no other step in the phantom
+  if (step->GetTrack()->GetParticleDefinition() != G4Gamma::Gamma())
+    return;
+  FreeFlightToExit(step);
+}
+
+void GateOptrFreeFlightActor::FreeFlightToExit(G4Step *step) const {
+  auto *track = step->GetTrack();
+  const auto *pre = step->GetPreStepPoint();
+  const auto &position = pre->GetPosition();
+  const auto &direction = pre->GetMomentumDirection();
+  const auto energy = pre->GetKineticEnergy();
+  double length = 0;
+  const auto mu_l =
+      fAttenuation.LineIntegralToExit(position, direction, energy, length);
+
+  // the interaction of this step (if any) is suppressed: its secondaries
+  // are removed (they are the last ones of the track) and its deposit is
+  // ignored by the next actors
+  auto *secondaries = step->GetfSecondary();
+  for (auto n = step->GetNumberOfSecondariesInCurrentStep(); n > 0; n--) {
+    delete secondaries->back();
+    secondaries->pop_back();
+  }
+  step->ResetTotalEnergyDeposit();
+  track->SetTrackStatus(fStopAndKill);
+
+  // the same photon at the exit, just outside the phantom (so that it is
+  // not located in the phantom again)
+  auto *particle = new G4DynamicParticle(G4Gamma::Gamma(), direction, energy);
+  particle->SetPolarization(pre->GetPolarization());
+  const auto exit = position + (length + CLHEP::nanometer) * direction;
+  auto *photon =
+      new G4Track(particle, pre->GetGlobalTime() + length / CLHEP::c_light,
+                  exit);
+  photon->SetWeight(pre->GetWeight() * std::exp(-mu_l));
+  photon->SetParentID(track->GetTrackID());
+  photon->SetCreatorProcess(track->GetCreatorProcess());
+  secondaries->push_back(photon);
+}
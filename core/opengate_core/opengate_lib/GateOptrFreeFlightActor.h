@@ -11,11 +11,25 @@ Copyright (C): OpenGATE Collaboration
 #include "G4BOptnForceFreeFlight.hh"
 #include "G4EmCalculator.hh"
 #include "G4VBiasingOperator.hh"
+#include "GateAttenuationRayMarcher.h"
 #include "GateVActor.h"
 #include <iostream>
 #include <pybind11/stl.h>
 namespace py = pybind11;
 
+/*
+ * Free flight of the photons: the interactions are suppressed and the
+ * weight is the probability to cross the volume without interaction.
+ *
+ * The default mode uses G4BOptnForceFreeFlight on the processes of the
+ * attached volume and all its daughters, the weight being updated at every
+ * step. In a voxelized phantom (ImageVolume), the "voxel" mode computes
+ * the weight exp(-sum mu l) at once along the straight line to the phantom
+ * exit (GateAttenuationRayMarcher), and the photon is moved there: the
+ * photon entering (or created in) the phantom is replaced by a new one at
+ * the exit, with the same energy and direction. The operator is then not
+ * attached to the volumes (no per voxel biasing).
+ */
 class GateOptrFreeFlightActor : public G4VBiasingOperator, public GateVActor {
 
 public:
@@ -32,6 +46,19 @@ public:
 
   void PreUserTrackingAction(const G4Track *track) override;
 
+  // Voxel mode only
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  void SteppingAction(G4Step *step) override;
+
+  void SetPhantomVolumeName(std::string name);
+
+  void SetImageParameterisation(GateImageNestedParameterisation *param);
+
+  void SetImageParameterisation(GateImageRegularParameterisation *param);
+
+  void SetImageParameterisation(GateImageRunParameterisation *param);
+
 protected:
   G4VBiasingOperation *
   ProposeNonPhysicsBiasingOperation(const G4Track *,
@@ -46,6 +73,17 @@ protected:
       const G4Track *track,
       const G4BiasingProcessInterface *callingProcess) override;
 
+  // Move the photon of the step to the phantom exit (voxel mode)
+  void FreeFlightToExit(G4Step *step) const;
+
+  bool fVoxelMode = false;
+  std::string fDatabase;
+  double fEnergyMax = 0;
+  std::string fPhantomVolumeName;
+  const GateAttenuationRayMarcher::LabelImageType *fLabelImage = nullptr;
+  const std::vector<G4Material *> *fLabelMaterials = nullptr;
+  GateAttenuationRayMarcher fAttenuation;
+
   struct threadLocal_t {
     G4BOptnForceFreeFlight *fFreeFlightOperation;
   };
@@ -0,0 +1,41 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateParallelWorldPhysics.h"
+#include "G4ParallelWorldProcess.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessManager.hh"
+#include "GateHelpers.h"
+
+GateParallelWorldPhysics::GateParallelWorldPhysics(
+    const std::string &world_name, bool layered_mass,
+    const std::vector<std::string> &particle_names)
+    : G4VPhysicsConstructor(world_name), fWorldName(world_name),
+      fLayeredMass(layered_mass), fParticleNames(particle_names) {}
+
+void GateParallelWorldPhysics::ConstructProcess() {
+  // (same process ordering as G4ParallelWorldPhysics)
+  auto *process = new G4ParallelWorldProcess(fWorldName);
+  process->SetParallelWorld(fWorldName);
+  process->SetLayeredMaterialFlag(fLayeredMass);
+  auto *table = G4ParticleTable::GetParticleTable();
+  for (const auto &name : fParticleNames) {
+    auto *particle = table->FindParticle(name);
+    if (particle == nullptr) {
+      std::ostringstream oss;
+      oss << "Error in the physics of the parallel world " << fWorldName
+          << ": unknown particle '" << name << "'";
+      Fatal(oss.str());
+    }
+    auto *manager = particle->GetProcessManager();
+    manager->AddProcess(process);
+    if (process->IsAtRestRequired(particle))
+      manager->SetProcessOrdering(process, idxAtRest, 9900);
+    manager->SetProcessOrderingToSecond(process, idxAlongStep);
+    manager->SetProcessOrdering(process, idxPostStep, 9900);
+  }
+}
@@ -0,0 +1,38 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateParallelWorldPhysics_h
+#define GateParallelWorldPhysics_h
+
+#include "G4VPhysicsConstructor.hh"
+#include <string>
+#include <vector>
+
+/*
+ * Same as G4ParallelWorldPhysics, but the parallel world process is only
+ * added to the given particles: the other particles do not see the
+ * parallel world (neither its volumes nor its layered materials). For
+ * example, the electrons may cross a full resolution copy of an image
+ * volume in a parallel world, while the photons only cross a coarse grid
+ * in the mass world.
+ */
+class GateParallelWorldPhysics : public G4VPhysicsConstructor {
+public:
+  GateParallelWorldPhysics(const std::string &world_name, bool layered_mass,
+                           const std::vector<std::string> &particle_names);
+
+  void ConstructParticle() override {}
+
+  void ConstructProcess() override;
+
+protected:
+  std::string fWorldName;
+  bool fLayeredMass;
+  std::vector<std::string> fParticleNames;
+};
+
+#endif // GateParallelWorldPhysics_h
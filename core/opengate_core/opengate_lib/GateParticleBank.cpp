@@ -0,0 +1,91 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateParticleBank.h"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <chrono>
+
+GateParticleBank::GateParticleBank(size_t capacity) {
+  if (capacity == 0)
+    Fatal("The capacity of a particle bank must be at least 1");
+  fBuffer.resize(capacity);
+  fHead = 0;
+  fCount = 0;
+  fClosed = false;
+  fNumberOfPushed = 0;
+  fNumberOfPopped = 0;
+}
+
+size_t GateParticleBank::Push(const Particle *particles, size_t n) {
+  size_t pushed = 0;
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (pushed < n) {
+    fNotFull.wait(lock, [this] { return fClosed || fCount < fBuffer.size(); });
+    if (fClosed)
+      break;
+    // copy as many particles as possible, the consumers are then notified
+    size_t m = std::min(n - pushed, fBuffer.size() - fCount);
+    for (size_t i = 0; i < m; i++) {
+      fBuffer[(fHead + fCount) % fBuffer.size()] = particles[pushed + i];
+      fCount++;
+    }
+    pushed += m;
+    fNumberOfPushed += m;
+    fNotEmpty.notify_all();
+  }
+  return pushed;
+}
+
+size_t GateParticleBank::Pop(Particle *particles, size_t n, double timeout) {
+  std::unique_lock<std::mutex> lock(fMutex);
+  auto ready = [this] { return fClosed || fCount > 0; };
+  if (timeout > 0) {
+    auto duration = std::chrono::duration<double>(timeout);
+    if (!fNotEmpty.wait_for(lock, duration, ready))
+      return 0;
+  } else {
+    fNotEmpty.wait(lock, ready);
+  }
+  size_t m = std::min(n, fCount);
+  for (size_t i = 0; i < m; i++) {
+    particles[i] = fBuffer[fHead];
+    fHead = (fHead + 1) % fBuffer.size();
+    fCount--;
+  }
+  fNumberOfPopped += m;
+  if (m > 0)
+    fNotFull.notify_all();
+  return m;
+}
+
+void GateParticleBank::Close() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fClosed = true;
+  fNotFull.notify_all();
+  fNotEmpty.notify_all();
+}
+
+bool GateParticleBank::IsClosed() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fClosed;
+}
+
+size_t GateParticleBank::GetSize() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fCount;
+}
+
+unsigned long GateParticleBank::GetNumberOfPushedParticles() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fNumberOfPushed;
+}
+
+unsigned long GateParticleBank::GetNumberOfPoppedParticles() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fNumberOfPopped;
+}
@@ -0,0 +1,72 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateParticleBank_h
+#define GateParticleBank_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+    Bounded ring buffer of particles, filled by an external producer (e.g. a
+    beamline code, in Python or C++) while the Geant4 threads drain it (see
+    GateParticleBankSource), without any file.
+
+    Push waits while the bank is full (back-pressure on the producer), Pop
+    waits while it is empty. Once the producer calls Close (end of stream),
+    Pop returns the remaining particles, then 0.
+ */
+
+class GateParticleBank {
+public:
+  struct Particle {
+    std::int32_t fPDGCode = 0; // 0: the particle of the source
+    double fEnergy = 0;
+    double fPosition[3] = {0, 0, 0};
+    double fDirection[3] = {0, 0, 1};
+    double fWeight = 1;
+    double fTime = -1; // < 0: the time of the source
+  };
+
+  explicit GateParticleBank(size_t capacity);
+
+  // Add n particles, wait while the bank is full. Return the number of
+  // particles added (less than n if the bank is closed meanwhile)
+  size_t Push(const Particle *particles, size_t n);
+
+  // Remove at most n particles, wait while the bank is empty (at most
+  // timeout seconds if > 0). Return 0 at the end of the stream (or timeout)
+  size_t Pop(Particle *particles, size_t n, double timeout = 0);
+
+  // End of the stream: no more particles will be pushed
+  void Close();
+
+  bool IsClosed();
+
+  size_t GetSize();
+
+  size_t GetCapacity() const { return fBuffer.size(); }
+
+  unsigned long GetNumberOfPushedParticles();
+
+  unsigned long GetNumberOfPoppedParticles();
+
+protected:
+  std::vector<Particle> fBuffer;
+  size_t fHead;  // index of the first particle
+  size_t fCount; // number of particles in the bank
+  bool fClosed;
+  unsigned long fNumberOfPushed;
+  unsigned long fNumberOfPopped;
+  std::mutex fMutex;
+  std::condition_variable fNotFull;
+  std::condition_variable fNotEmpty;
+};
+
+#endif // GateParticleBank_h
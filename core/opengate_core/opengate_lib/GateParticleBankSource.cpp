@@ -0,0 +1,137 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateParticleBankSource.h"
+#include "G4IonTable.hh"
+#include "G4ParticleTable.hh"
+#include "G4Threading.hh"
+#include "GateHelpersDict.h"
+#include <algorithm>
+#include <sstream>
+
+GateParticleBankSource::GateParticleBankSource() : GateVSource() {
+  fParticleDefinition = nullptr;
+  fGlobalFlag = false;
+  fBatchSize = 1000;
+  fTimeout = 0;
+}
+
+GateParticleBankSource::~GateParticleBankSource() = default;
+
+void GateParticleBankSource::InitializeUserInfo(py::dict &user_info) {
+  GateVSource::InitializeUserInfo(user_info);
+  fGlobalFlag = DictGetBool(user_info, "global_flag");
+  fBatchSize = std::max(1, DictGetInt(user_info, "batch_size"));
+  fTimeout = DictGetDouble(user_info, "timeout");
+
+  // particle of the source, used when the pdg code of a particle is 0
+  auto pname = DictGetStr(user_info, "particle");
+  fParticleDefinition = nullptr;
+  if (!pname.empty() && pname != "None") {
+    fParticleDefinition =
+        G4ParticleTable::GetParticleTable()->FindParticle(pname);
+    if (fParticleDefinition == nullptr) {
+      std::ostringstream oss;
+      oss << "GateParticleBankSource: unknown particle '" << pname << "'";
+      Fatal(oss.str());
+    }
+  }
+
+  auto &l = fThreadLocalDataBank.Get();
+  l.fBatch.resize(fBatchSize);
+  l.fCurrentIndex = 0;
+  l.fCurrentBatchSize = 0;
+  l.fNumberOfGeneratedEvents = 0;
+  l.fPDGCode = 0;
+  l.fParticleDefinition = nullptr;
+}
+
+void GateParticleBankSource::SetBank(std::shared_ptr<GateParticleBank> bank) {
+  fBank = bank;
+}
+
+double
+GateParticleBankSource::PrepareNextTime(double current_simulation_time) {
+  // in MT, the particles are only for the workers
+  if (G4Threading::IsMultithreadedApplication() &&
+      G4Threading::IsMasterThread())
+    return -1;
+  auto &l = fThreadLocalDataBank.Get();
+  if (fMaxN > 0 && l.fNumberOfGeneratedEvents >= fMaxN)
+    return -1;
+  // the next batch (wait for the producer if the bank is empty)
+  if (l.fCurrentIndex >= l.fCurrentBatchSize) {
+    if (fBank == nullptr)
+      Fatal("GateParticleBankSource: no particle bank (see SetBank)");
+    l.fCurrentBatchSize = fBank->Pop(l.fBatch.data(), fBatchSize, fTimeout);
+    l.fCurrentIndex = 0;
+    // end of the stream (or no particle before the timeout)
+    if (l.fCurrentBatchSize == 0)
+      return -1;
+  }
+  // the time of the particle, otherwise the start of the source. A particle
+  // after the end of the run is kept for the next run.
+  double t = l.fBatch[l.fCurrentIndex].fTime;
+  if (t < 0)
+    t = fStartTime;
+  if (t >= fEndTime)
+    return -1;
+  return std::max(t, current_simulation_time);
+}
+
+G4ParticleDefinition *
+GateParticleBankSource::FindParticleDefinition(std::int32_t pdg) {
+  if (pdg == 0) {
+    if (fParticleDefinition == nullptr)
+      Fatal("GateParticleBankSource: a particle without PDGCode, and no "
+            "particle for the source");
+    return fParticleDefinition;
+  }
+  auto &l = fThreadLocalDataBank.Get();
+  if (l.fParticleDefinition != nullptr && l.fPDGCode == pdg)
+    return l.fParticleDefinition;
+  auto *particle_table = G4ParticleTable::GetParticleTable();
+  auto *definition = particle_table->FindParticle(pdg);
+  // if not found, it may be an ion
+  if (definition == nullptr)
+    definition = particle_table->GetIonTable()->GetIon(pdg);
+  if (definition == nullptr) {
+    std::ostringstream oss;
+    oss << "GateParticleBankSource: PDGCode " << pdg << " not found";
+    Fatal(oss.str());
+  }
+  l.fPDGCode = pdg;
+  l.fParticleDefinition = definition;
+  return definition;
+}
+
+void GateParticleBankSource::GeneratePrimaries(G4Event *event,
+                                               double current_simulation_time) {
+  auto &l = fThreadLocalDataBank.Get();
+  const auto &p = l.fBatch[l.fCurrentIndex];
+  G4ThreeVector position(p.fPosition[0], p.fPosition[1], p.fPosition[2]);
+  G4ThreeVector direction(p.fDirection[0], p.fDirection[1], p.fDirection[2]);
+  direction = direction.unit();
+
+  // transform according to mother
+  if (!fGlobalFlag) {
+    auto &ls = fThreadLocalData.Get();
+    position = ls.fGlobalRotation * position + ls.fGlobalTranslation;
+    direction = ls.fGlobalRotation * direction;
+  }
+
+  auto *particle = new G4PrimaryParticle(FindParticleDefinition(p.fPDGCode));
+  particle->SetKineticEnergy(p.fEnergy);
+  particle->SetMomentumDirection(direction);
+  auto *vertex = new G4PrimaryVertex(position, current_simulation_time);
+  vertex->SetPrimary(particle);
+  vertex->SetWeight(p.fWeight);
+  event->AddPrimaryVertex(vertex);
+
+  l.fCurrentIndex++;
+  l.fNumberOfGeneratedEvents++;
+}
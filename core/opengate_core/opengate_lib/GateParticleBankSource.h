@@ -0,0 +1,64 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateParticleBankSource_h
+#define GateParticleBankSource_h
+
+#include "GateParticleBank.h"
+#include "GateVSource.h"
+#include <memory>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/*
+    Source of the particles of a GateParticleBank, pushed in memory by an
+    external producer during the simulation. Each thread pops batches of
+    particles. At the end of the stream (bank closed and empty), the source
+    is no longer active: the run stops (see GateSourceManager).
+ */
+
+class GateParticleBankSource : public GateVSource {
+
+public:
+  GateParticleBankSource();
+
+  ~GateParticleBankSource() override;
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void SetBank(std::shared_ptr<GateParticleBank> bank);
+
+  double PrepareNextTime(double current_simulation_time) override;
+
+  void GeneratePrimaries(G4Event *event,
+                         double current_simulation_time) override;
+
+protected:
+  G4ParticleDefinition *FindParticleDefinition(std::int32_t pdg);
+
+  // the bank is shared by all threads
+  std::shared_ptr<GateParticleBank> fBank;
+  G4ParticleDefinition *fParticleDefinition;
+  bool fGlobalFlag;
+  size_t fBatchSize;
+  double fTimeout;
+
+  // For MT, all threads local variables are gathered here
+  struct threadLocalTBank {
+    std::vector<GateParticleBank::Particle> fBatch;
+    size_t fCurrentIndex = 0;
+    size_t fCurrentBatchSize = 0;
+    unsigned long fNumberOfGeneratedEvents = 0;
+    // last particle type (most of the time, the same for all particles)
+    std::int32_t fPDGCode = 0;
+    G4ParticleDefinition *fParticleDefinition = nullptr;
+  };
+  G4Cache<threadLocalTBank> fThreadLocalDataBank;
+};
+
+#endif // GateParticleBankSource_h
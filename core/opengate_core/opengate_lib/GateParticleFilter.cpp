@@ -6,25 +6,31 @@
    -------------------------------------------------- */
 
 #include "GateParticleFilter.h"
+#include "G4ParticleTable.hh"
 #include "GateHelpersDict.h"
 
 void GateParticleFilter::InitializeUserInfo(py::dict &user_info) {
   fParticleName = DictGetStr(user_info, "particle");
   fPolicy = DictGetStr(user_info, "policy");
+  fAcceptParticle = fPolicy == "accept";
+}
+
+void GateParticleFilter::Compile() {
+  fParticleDefinition =
+      G4ParticleTable::GetParticleTable()->FindParticle(fParticleName);
 }
 
 bool GateParticleFilter::Accept(const G4Track *track) const {
-  auto p = track->GetParticleDefinition()->GetParticleName();
-  if (p == fParticleName)
-    return true;
-  return false;
+  const auto *d = track->GetParticleDefinition();
+  if (fParticleDefinition != nullptr)
+    return d == fParticleDefinition;
+  return d->GetParticleName() == fParticleName;
 }
 
 bool GateParticleFilter::Accept(G4Step *step) const {
-  auto p = step->GetTrack()->GetParticleDefinition()->GetParticleName();
-  if (fPolicy == "accept" && p == fParticleName)
-    return true;
-  if (fPolicy == "reject" && p != fParticleName)
-    return true;
-  return false;
+  const auto *d = step->GetTrack()->GetParticleDefinition();
+  bool same = fParticleDefinition != nullptr
+                  ? d == fParticleDefinition
+                  : d->GetParticleName() == fParticleName;
+  return same == fAcceptParticle;
 }
@@ -28,8 +28,13 @@ public:
 
   bool Accept(G4Step *step) const override;
 
+  void Compile() override;
+
   G4String fParticleName;
   std::string fPolicy;
+  bool fAcceptParticle = true;
+  // (nullptr if the particle is not in the particle table, e.g. an ion)
+  const G4ParticleDefinition *fParticleDefinition = nullptr;
 };
 
 #endif // GateParticleFilter_h
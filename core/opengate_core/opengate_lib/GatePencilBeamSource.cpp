@@ -36,6 +36,8 @@ void GatePencilBeamSource::PrepareNextRun() {
   auto &l = fThreadLocalData.Get();
   auto &lll = GetThreadLocalDataPencilBeamSource();
   lll.fSPS_PB->SetSourceRotTransl(l.fGlobalTranslation, l.fGlobalRotation);
+  // the primaries of the previous run are in the previous coordinate system
+  GetThreadLocalDataGenericSource().fBatch.Clear();
 }
 
 void GatePencilBeamSource::InitializeDirection(py::dict puser_info) {
@@ -0,0 +1,218 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePerfCounters.h"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+
+using namespace pybind11::literals;
+
+std::atomic<bool> GatePerfCounters::fEnabled{false};
+
+void GatePerfCounters::Enable(bool flag) {
+  fEnabled.store(flag && IsAvailable(), std::memory_order_relaxed);
+}
+
+#if defined(OPENGATE_PERF_COUNTERS) && defined(__linux__)
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <map>
+#include <mutex>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+// cycles, instructions, cache misses, branch misses
+constexpr std::array<unsigned long long, 4> kEvents = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+constexpr double kCacheLineBytes = 64;
+
+struct Values {
+  double fTime = 0; // ns
+  std::array<unsigned long long, 4> fCounts = {};
+};
+
+struct Group {
+  std::array<int, 4> fFds = {-1, -1, -1, -1};
+  // values at the start of each phase
+  std::map<std::string, Values> fStart;
+};
+
+std::mutex &CountersMutex() {
+  static std::mutex m;
+  return m;
+}
+
+// groups of counters per thread id
+std::map<int, Group> &Groups() {
+  static std::map<int, Group> groups;
+  return groups;
+}
+
+// accumulated values per phase and thread id
+std::map<std::string, std::map<int, Values>> &Results() {
+  static std::map<std::string, std::map<int, Values>> results;
+  return results;
+}
+
+long PerfEventOpen(perf_event_attr *attr, int group_fd) {
+  // pid 0, cpu -1: the calling thread, on any cpu
+  return syscall(__NR_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+void Close(Group &g) {
+  for (auto &fd : g.fFds) {
+    if (fd >= 0)
+      close(fd);
+    fd = -1;
+  }
+}
+
+// Open the counters of the calling thread. On failure (e.g. restricted by
+// /proc/sys/kernel/perf_event_paranoid), the counters are disabled.
+bool Open(Group &g) {
+  for (size_t i = 0; i < kEvents.size(); i++) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kEvents[i];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    auto fd = PerfEventOpen(&attr, g.fFds[0]);
+    if (fd < 0) {
+      std::cout << "WARNING: hardware performance counters not available ("
+                << std::strerror(errno)
+                << "), see /proc/sys/kernel/perf_event_paranoid" << std::endl;
+      Close(g);
+      return false;
+    }
+    g.fFds[i] = static_cast<int>(fd);
+  }
+  ioctl(g.fFds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(g.fFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+Values Read(const Group &g) {
+  Values v;
+  v.fTime = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+  for (size_t i = 0; i < kEvents.size(); i++) {
+    const auto n = sizeof(v.fCounts[i]);
+    if (read(g.fFds[i], &v.fCounts[i], n) != static_cast<ssize_t>(n))
+      v.fCounts[i] = 0;
+  }
+  return v;
+}
+} // namespace
+
+bool GatePerfCounters::IsAvailable() { return true; }
+
+void GatePerfCounters::Reset() {
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  for (auto &g : Groups())
+    Close(g.second);
+  Groups().clear();
+  Results().clear();
+}
+
+void GatePerfCounters::StartPhase(const std::string &phase) {
+  StartPhase(phase, G4Threading::G4GetThreadId());
+}
+
+void GatePerfCounters::StartPhase(const std::string &phase, int thread_id) {
+  if (!IsEnabled())
+    return;
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  auto it = Groups().find(thread_id);
+  if (it == Groups().end()) {
+    // the counters can only be opened by their thread
+    if (thread_id != G4Threading::G4GetThreadId())
+      return;
+    Group g;
+    if (!Open(g)) {
+      Enable(false);
+      return;
+    }
+    it = Groups().emplace(thread_id, g).first;
+  }
+  it->second.fStart[phase] = Read(it->second);
+}
+
+void GatePerfCounters::StopPhase(const std::string &phase) {
+  StopPhase(phase, G4Threading::G4GetThreadId());
+}
+
+void GatePerfCounters::StopPhase(const std::string &phase, int thread_id) {
+  if (!IsEnabled())
+    return;
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  auto it = Groups().find(thread_id);
+  if (it == Groups().end())
+    return;
+  auto start = it->second.fStart.find(phase);
+  if (start == it->second.fStart.end())
+    return;
+  auto v = Read(it->second);
+  auto &r = Results()[phase][thread_id];
+  r.fTime += v.fTime - start->second.fTime;
+  for (size_t i = 0; i < kEvents.size(); i++)
+    r.fCounts[i] += v.fCounts[i] - start->second.fCounts[i];
+  it->second.fStart.erase(start);
+}
+
+py::dict GatePerfCounters::GetResults() {
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  py::dict results;
+  for (const auto &[phase, threads] : Results()) {
+    py::dict d;
+    for (const auto &[id, v] : threads) {
+      const auto cycles = v.fCounts[0];
+      const auto instructions = v.fCounts[1];
+      const auto cache_misses = v.fCounts[2];
+      double ipc = cycles > 0 ? double(instructions) / cycles : 0;
+      double bandwidth =
+          v.fTime > 0 ? cache_misses * kCacheLineBytes / (v.fTime * 1e-9) : 0;
+      d[py::int_(id)] = py::dict(
+          "time"_a = v.fTime * CLHEP::ns, "cycles"_a = cycles,
+          "instructions"_a = instructions, "cache_misses"_a = cache_misses,
+          "branch_misses"_a = v.fCounts[3], "ipc"_a = ipc,
+          "bandwidth"_a = bandwidth);
+    }
+    results[phase.c_str()] = d;
+  }
+  return results;
+}
+
+#else
+
+bool GatePerfCounters::IsAvailable() { return false; }
+
+void GatePerfCounters::Reset() {}
+
+void GatePerfCounters::StartPhase(const std::string & /*phase*/) {}
+
+void GatePerfCounters::StartPhase(const std::string & /*phase*/,
+                                  int /*thread_id*/) {}
+
+void GatePerfCounters::StopPhase(const std::string & /*phase*/) {}
+
+void GatePerfCounters::StopPhase(const std::string & /*phase*/,
+                                 int /*thread_id*/) {}
+
+py::dict GatePerfCounters::GetResults() { return py::dict(); }
+
+#endif
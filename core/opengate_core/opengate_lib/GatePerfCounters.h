@@ -0,0 +1,69 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePerfCounters_h
+#define GatePerfCounters_h
+
+#include <atomic>
+#include <pybind11/pybind11.h>
+#include <string>
+
+namespace py = pybind11;
+
+/*
+    Optional hardware performance counters (Linux perf_event), per thread and
+    per phase of the simulation, enabled by the SimulationStatisticsActor
+    (option perf_counters_flag). Only available when compiled with the CMake
+    option OPENGATE_PERF_COUNTERS (Linux only).
+
+    Each thread opens a group of counters (cycles, instructions, cache
+    misses, branch misses) counting only this thread. A phase is measured
+    between StartPhase and StopPhase and accumulated (e.g. over the runs).
+    The counters of a thread can be read by another thread (e.g. the end of
+    the initialization of the master thread is the start of the first run of
+    a worker). The counters are read at coarse points only (start/end of
+    run): the cost is a few system calls per run.
+
+    The memory bandwidth is estimated from the cache misses (last level
+    cache, 64 bytes lines) and the duration of the phase.
+ */
+
+class GatePerfCounters {
+public:
+  // True if compiled with OPENGATE_PERF_COUNTERS
+  static bool IsAvailable();
+
+  static void Enable(bool flag);
+
+  inline static bool IsEnabled() {
+    return fEnabled.load(std::memory_order_relaxed);
+  }
+
+  // Close the counters and remove the values (master thread, when the
+  // simulation starts)
+  static void Reset();
+
+  // Start (or restart) a phase for the calling thread (its counters are
+  // opened if needed) or for the given thread (its counters must be open)
+  static void StartPhase(const std::string &phase);
+  static void StartPhase(const std::string &phase, int thread_id);
+
+  // Accumulate the values since the start of the phase, for the calling
+  // thread or for the given thread (-1 is the master thread)
+  static void StopPhase(const std::string &phase);
+  static void StopPhase(const std::string &phase, int thread_id);
+
+  // {phase: {thread id: {time, cycles, instructions, cache_misses,
+  // branch_misses, ipc, bandwidth}}}, time in Geant4 units, bandwidth in
+  // bytes/s (empty when not available)
+  static py::dict GetResults();
+
+protected:
+  static std::atomic<bool> fEnabled;
+};
+
+#endif // GatePerfCounters_h
@@ -9,17 +9,29 @@
 #include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
 #include "GateHelpersDict.h"
+#include "GateMutex.h"
 #include "digitizer/GateDigiCollectionManager.h"
 #include "digitizer/GateHelpersDigitizer.h"
-
-G4Mutex TotalEntriesMutex = G4MUTEX_INITIALIZER;
+#include <cstring>
+#include <map>
+#include <sstream>
+
+GATE_MUTEX(TotalEntriesMutex);
+
+namespace {
+std::uint32_t FloatBits(double v) {
+  auto f = static_cast<float>(v);
+  std::uint32_t b;
+  std::memcpy(&b, &f, sizeof(b));
+  return b;
+}
+} // namespace
 
 GatePhaseSpaceActor::GatePhaseSpaceActor(py::dict &user_info)
     : GateVActor(user_info, true) {
   fActions.insert("StartSimulationAction");
   fActions.insert("BeginOfRunAction");
   fActions.insert("BeginOfEventAction");
-  fActions.insert("PreUserTrackingAction");
   fActions.insert("SteppingAction");
   fActions.insert("EndOfRunAction");
   fActions.insert("EndOfEventAction");
@@ -32,6 +44,10 @@ GatePhaseSpaceActor::GatePhaseSpaceActor(py::dict &user_info)
   fStoreFirstStepInVolume = false;
   fDebug = false;
   fStoreAbsorbedEvent = false;
+  fNativeOutput = false;
+  fQuantizeDirections = false;
+  fChunkSize = 0;
+  fFixedRecord = false;
 }
 
 GatePhaseSpaceActor::~GatePhaseSpaceActor() {
@@ -44,12 +60,13 @@ void GatePhaseSpaceActor::InitializeUserInfo(py::dict &user_info) {
   fUserDigiAttributeNames = DictGetVecStr(user_info, "attributes");
   fStoreAbsorbedEvent = DictGetBool(user_info, "store_absorbed_event");
   fDebug = DictGetBool(user_info, "debug");
-
-  // Special case to store event information even if the event do not step in
-  // the mother volume
-  if (fStoreAbsorbedEvent) {
-    fActions.insert("EndOfEventAction");
-  }
+  // (the tracks are only printed in debug mode)
+  if (fDebug)
+    fActions.insert("PreUserTrackingAction");
+  fQuantizeDirections = DictGetBool(user_info, "quantize_directions");
+  fChunkSize = DictGetInt(user_info, "chunk_size");
+  // run ended once this number of entries is stored (see GateVActor)
+  fTerminationTarget = DictGetInt(user_info, "termination_count");
 }
 
 void GatePhaseSpaceActor::InitializeCpp() {
@@ -69,9 +86,17 @@ void GatePhaseSpaceActor::StartSimulationAction() {
   } else {
     outputPath = GetOutputPath(fOutputNameRoot);
   }
-  fHits->SetFilenameAndInitRoot(outputPath);
-  fHits->InitDigiAttributesFromNames(fUserDigiAttributeNames);
+  // the .gphsp file is written by chunks, not by the root manager
+  const std::string ext = ".gphsp";
+  fNativeOutput = outputPath.size() > ext.size() &&
+                  outputPath.compare(outputPath.size() - ext.size(),
+                                     ext.size(), ext) == 0;
+  fFixedRecord = false;
+  fHits->SetFilenameAndInitRoot(fNativeOutput ? "" : outputPath);
+  InitializeDigiAttributes();
   fHits->RootInitializeTupleForMaster();
+  if (fNativeOutput)
+    InitializeNativeOutput(outputPath);
   if (fStoreAbsorbedEvent) {
     CheckRequiredAttribute(fHits, "EventID");
     CheckRequiredAttribute(fHits, "EventPosition");
@@ -82,15 +107,200 @@ void GatePhaseSpaceActor::StartSimulationAction() {
   fTotalNumberOfEntries = 0;
 }
 
+void GatePhaseSpaceActor::InitializeDigiAttributes() {
+  fHits->InitDigiAttributesFromNames(fUserDigiAttributeNames);
+}
+
+void GatePhaseSpaceActor::InitializeNativeOutput(
+    const std::string &outputPath) {
+  using Type = GatePhaseSpaceFileReader::ColumnType;
+  std::vector<std::string> names;
+  std::vector<Type> types;
+  fNativeColumns.clear();
+  for (auto *att : fHits->GetDigiAttributes()) {
+    auto name = att->GetDigiAttributeName();
+    auto type = att->GetDigiAttributeType();
+    if (type == 'D' || type == 'I') {
+      names.push_back(name);
+      types.push_back(type == 'D' ? Type::Float32 : Type::Int32);
+      fNativeColumns.emplace_back(att, 0);
+    } else if (type == '3' && fQuantizeDirections &&
+               name.find("Direction") != std::string::npos) {
+      names.push_back(name);
+      types.push_back(Type::Direction);
+      fNativeColumns.emplace_back(att, kQuantizedDirection);
+    } else if (type == '3') {
+      const char *suffixes[] = {"_X", "_Y", "_Z"};
+      for (int k = 0; k < 3; k++) {
+        names.push_back(name + suffixes[k]);
+        types.push_back(Type::Float32);
+        fNativeColumns.emplace_back(att, k);
+      }
+    } else {
+      std::ostringstream oss;
+      oss << "The attribute '" << name << "' of the actor '" << GetName()
+          << "' cannot be stored in a .gphsp file (only the numerical and "
+             "3-vector attributes)";
+      Fatal(oss.str());
+    }
+  }
+  fNativeWriter = std::make_unique<GatePhaseSpaceFileWriter>();
+  fNativeWriter->Open(outputPath, names, types);
+  fFixedRecord = InitializeFixedRecord();
+}
+
+bool GatePhaseSpaceActor::InitializeFixedRecord() {
+  // the absorbed events and the debug output need the digi collection
+  fFixedColumns.clear();
+  if (fStoreAbsorbedEvent || fDebug)
+    return false;
+  static const std::map<std::string, FixedField> fields = {
+      {"PrePosition", FixedField::PrePosition},
+      {"PostPosition", FixedField::PostPosition},
+      {"PreDirection", FixedField::PreDirection},
+      {"PostDirection", FixedField::PostDirection},
+      {"KineticEnergy", FixedField::PreKineticEnergy},
+      {"PreKineticEnergy", FixedField::PreKineticEnergy},
+      {"PostKineticEnergy", FixedField::PostKineticEnergy},
+      {"Weight", FixedField::Weight},
+      {"PDGCode", FixedField::PDGCode},
+      {"EventID", FixedField::EventID}};
+  // same columns (and same order) as the ones of the digi attributes
+  for (const auto &[att, k] : fNativeColumns) {
+    auto it = fields.find(att->GetDigiAttributeName());
+    if (it == fields.end()) {
+      fFixedColumns.clear();
+      return false;
+    }
+    fFixedColumns.emplace_back(it->second, k);
+  }
+  return !fFixedColumns.empty();
+}
+
+void GatePhaseSpaceActor::FillFixedRecord(const G4Step *step) {
+  auto &l = fThreadLocalData.Get();
+  const auto *pre = step->GetPreStepPoint();
+  const auto *post = step->GetPostStepPoint();
+  const auto *track = step->GetTrack();
+  auto bits3 = [](const G4ThreeVector &v, int k) {
+    if (k == kQuantizedDirection)
+      return GatePhaseSpaceFileReader::EncodeDirection(v);
+    return FloatBits(v[k]);
+  };
+  for (size_t c = 0; c < fFixedColumns.size(); c++) {
+    const auto k = fFixedColumns[c].second;
+    std::uint32_t v = 0;
+    switch (fFixedColumns[c].first) {
+    case FixedField::PrePosition:
+      v = bits3(pre->GetPosition(), k);
+      break;
+    case FixedField::PostPosition:
+      v = bits3(post->GetPosition(), k);
+      break;
+    case FixedField::PreDirection:
+      v = bits3(pre->GetMomentumDirection(), k);
+      break;
+    case FixedField::PostDirection:
+      v = bits3(post->GetMomentumDirection(), k);
+      break;
+    case FixedField::PreKineticEnergy:
+      v = FloatBits(pre->GetKineticEnergy());
+      break;
+    case FixedField::PostKineticEnergy:
+      v = FloatBits(post->GetKineticEnergy());
+      break;
+    case FixedField::Weight:
+      v = FloatBits(track->GetWeight());
+      break;
+    case FixedField::PDGCode:
+      v = static_cast<std::uint32_t>(
+          track->GetParticleDefinition()->GetPDGEncoding());
+      break;
+    case FixedField::EventID:
+      v = static_cast<std::uint32_t>(l.fEventID);
+      break;
+    }
+    l.fNativeChunk[c].push_back(v);
+  }
+  l.fNumberOfFixedRecords++;
+}
+
+void GatePhaseSpaceActor::WriteChunkOfFixedRecords() {
+  auto &l = fThreadLocalData.Get();
+  auto n = l.fNumberOfFixedRecords;
+  if (n == 0)
+    return;
+  std::vector<const void *> columns;
+  for (const auto &values : l.fNativeChunk)
+    columns.push_back(values.data());
+  fNativeWriter->WriteChunk(columns, n);
+  {
+    GateAutoLock mutex(&TotalEntriesMutex);
+    fTotalNumberOfEntries += n;
+  }
+  // (the capacity is kept for the next chunk)
+  for (auto &values : l.fNativeChunk)
+    values.clear();
+  l.fNumberOfFixedRecords = 0;
+}
+
+void GatePhaseSpaceActor::WriteChunkOfHits() {
+  auto n = fHits->GetSize();
+  if (n == 0)
+    return;
+  auto &chunk = fThreadLocalData.Get().fNativeChunk;
+  chunk.resize(fNativeColumns.size());
+  std::vector<const void *> columns;
+  for (size_t c = 0; c < fNativeColumns.size(); c++) {
+    auto *att = fNativeColumns[c].first;
+    auto k = fNativeColumns[c].second;
+    auto &values = chunk[c];
+    values.resize(n);
+    if (att->GetDigiAttributeType() == 'D') {
+      const auto &v = att->GetDValues();
+      for (size_t i = 0; i < n; i++)
+        values[i] = FloatBits(v[i]);
+    } else if (att->GetDigiAttributeType() == 'I') {
+      const auto &v = att->GetIValues();
+      for (size_t i = 0; i < n; i++)
+        values[i] = static_cast<std::uint32_t>(v[i]);
+    } else if (k == kQuantizedDirection) {
+      const auto &v = att->Get3Values();
+      for (size_t i = 0; i < n; i++)
+        values[i] = GatePhaseSpaceFileReader::EncodeDirection(v[i]);
+    } else {
+      const auto &v = att->Get3Values();
+      for (size_t i = 0; i < n; i++)
+        values[i] = FloatBits(v[i][k]);
+    }
+    columns.push_back(values.data());
+  }
+  fNativeWriter->WriteChunk(columns, n);
+  {
+    GateAutoLock mutex(&TotalEntriesMutex);
+    fTotalNumberOfEntries += n;
+  }
+  fHits->Clear();
+}
+
 // Called every time a Run starts
 void GatePhaseSpaceActor::BeginOfRunAction(const G4Run *run) {
   if (run->GetRunID() == 0)
     fHits->RootInitializeTupleForWorker();
+  if (fFixedRecord) {
+    auto &l = fThreadLocalData.Get();
+    l.fNativeChunk.resize(fFixedColumns.size());
+    l.fNumberOfFixedRecords = 0;
+  }
 }
 
-void GatePhaseSpaceActor::BeginOfEventAction(const G4Event * /*event*/) {
+void GatePhaseSpaceActor::BeginOfEventAction(const G4Event *event) {
+  fHits->BeginOfEvent(event);
   auto &l = fThreadLocalData.Get();
-  l.fFirstStepInVolume = true;
+  l.fLastTrackID = 0;
+  l.fEventID = event->GetEventID();
+  l.fEntriesBeforeEvent =
+      fFixedRecord ? l.fNumberOfFixedRecords : fHits->GetSize();
   if (fStoreAbsorbedEvent) {
     // The current event still have to be stored
     l.fCurrentEventHasBeenStored = false;
@@ -102,8 +312,7 @@ void GatePhaseSpaceActor::BeginOfEventAction(const G4Event * /*event*/) {
 }
 
 void GatePhaseSpaceActor::PreUserTrackingAction(const G4Track *track) {
-  auto &l = fThreadLocalData.Get();
-  l.fFirstStepInVolume = true;
+  // (only with the debug option)
   if (fDebug) {
     auto id = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
     std::cout << "New track "
@@ -138,10 +347,12 @@ void GatePhaseSpaceActor::SteppingAction(G4Step *step) {
   bool exiting = step->GetPostStepPoint()->GetStepStatus() == fGeomBoundary ||
                  step->GetPostStepPoint()->GetStepStatus() == fWorldBoundary;
 
-  // When this is the first time we see this particle fFirstStepInVolume is true
-  // We then set it to false
-  bool first_step_in_volume = l.fFirstStepInVolume;
-  l.fFirstStepInVolume = false;
+  // This is the first time we see this particle if the previous step in the
+  // volume was for another track (the tracks are processed one by one, so
+  // the tracking actions are not needed)
+  const auto track_id = step->GetTrack()->GetTrackID();
+  bool first_step_in_volume = track_id != l.fLastTrackID;
+  l.fLastTrackID = track_id;
 
   // Keep or ignore ?
   bool ok = entering && fStoreEnteringStep;
@@ -150,6 +361,12 @@ void GatePhaseSpaceActor::SteppingAction(G4Step *step) {
   if (!ok)
     return;
 
+  // Fixed record: the values are written directly, without the attributes
+  if (fFixedRecord) {
+    FillFixedRecord(step);
+    return;
+  }
+
   // Fill the hits
   fHits->FillHits(step);
 
@@ -219,12 +436,32 @@ void GatePhaseSpaceActor::EndOfEventAction(const G4Event *event) {
     // increase the nb of absorbed events
     fNumberOfAbsorbedEvents++;
   }
+
+  // entries of the event, for the termination criterion
+  if (fTerminationTarget > 0) {
+    auto n = fFixedRecord ? l.fNumberOfFixedRecords : fHits->GetSize();
+    AddTerminationCount(static_cast<long>(n - l.fEntriesBeforeEvent));
+  }
+
+  // the memory used by the native output is bounded by the chunk size
+  if (fFixedRecord) {
+    if (l.fNumberOfFixedRecords >= fChunkSize)
+      WriteChunkOfFixedRecords();
+  } else if (fNativeOutput && fHits->GetSize() >= fChunkSize)
+    WriteChunkOfHits();
 }
 
 // Called every time a Run ends
 void GatePhaseSpaceActor::EndOfRunAction(const G4Run * /*unused*/) {
+  if (fNativeOutput) {
+    if (fFixedRecord)
+      WriteChunkOfFixedRecords();
+    else
+      WriteChunkOfHits();
+    return;
+  }
   {
-    G4AutoLock mutex(&TotalEntriesMutex);
+    GateAutoLock mutex(&TotalEntriesMutex);
     fTotalNumberOfEntries += fHits->GetSize();
   }
   fHits->FillToRootIfNeeded(true);
@@ -240,6 +477,8 @@ void GatePhaseSpaceActor::EndOfSimulationWorkerAction(
 void GatePhaseSpaceActor::EndSimulationAction() {
   fHits->Write();
   fHits->Close();
+  if (fNativeWriter)
+    fNativeWriter->Close();
 }
 
 int GatePhaseSpaceActor::GetNumberOfAbsorbedEvents() const {
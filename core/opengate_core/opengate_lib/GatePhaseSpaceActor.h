@@ -8,11 +8,13 @@
 #ifndef GatePhaseSpaceActor_h
 #define GatePhaseSpaceActor_h
 
-#include "G4Cache.hh"
 #include "G4GenericAnalysisManager.hh"
 #include "GateHelpers.h"
+#include "GatePhaseSpaceFileWriter.h"
+#include "GateThreadContext.h"
 #include "GateVActor.h"
 #include "digitizer/GateDigiCollection.h"
+#include <memory>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -66,12 +68,50 @@ public:
   void SetStoreFirstStepInVolumeFlag(bool b) { fStoreFirstStepInVolume = true; }
 
 protected:
+  // Create the attributes of the digi collection (from their names)
+  virtual void InitializeDigiAttributes();
+
+  void InitializeNativeOutput(const std::string &outputPath);
+
+  // Write the hits of the thread as one chunk of the .gphsp file, then clear
+  void WriteChunkOfHits();
+
+  // Fixed record of the linac scoring plane: each column is read directly
+  // from the step (no digi attribute), see InitializeFixedRecord
+  enum class FixedField {
+    PrePosition,
+    PostPosition,
+    PreDirection,
+    PostDirection,
+    PreKineticEnergy,
+    PostKineticEnergy,
+    Weight,
+    PDGCode,
+    EventID
+  };
+
+  bool InitializeFixedRecord();
+
+  void FillFixedRecord(const G4Step *step);
+
+  // Write the fixed records of the thread as one chunk, then clear
+  void WriteChunkOfFixedRecords();
+
   // Local data for the threads (each one has a copy)
   struct threadLocalT {
     bool fCurrentEventHasBeenStored;
-    bool fFirstStepInVolume;
+    // track of the last step in the volume (0 at the start of an event)
+    int fLastTrackID = 0;
+    // values of the columns of the current chunk (4 bytes each)
+    std::vector<std::vector<std::uint32_t>> fNativeChunk;
+    // number of fixed records in the current chunk, and the current event
+    size_t fNumberOfFixedRecords = 0;
+    int fEventID = 0;
+    // entries (hits or fixed records) before the current event, for the
+    // termination criterion
+    size_t fEntriesBeforeEvent = 0;
   };
-  G4Cache<threadLocalT> fThreadLocalData;
+  GateThreadLocal<threadLocalT> fThreadLocalData;
 
   std::string fDigiCollectionName;
   std::vector<std::string> fUserDigiAttributeNames;
@@ -82,6 +122,20 @@ protected:
   bool fStoreExitingStep;
   bool fStoreFirstStepInVolume;
 
+  // native columnar output (output filename with the .gphsp extension):
+  // for each column, the attribute and its component (0 1 2 for the
+  // 3-vectors, kQuantizedDirection for a quantized direction)
+  static constexpr int kQuantizedDirection = 3;
+  bool fNativeOutput;
+  bool fQuantizeDirections;
+  size_t fChunkSize;
+  std::unique_ptr<GatePhaseSpaceFileWriter> fNativeWriter;
+  std::vector<std::pair<GateVDigiAttribute *, int>> fNativeColumns;
+  // when all the attributes are in the fixed record, the digi collection
+  // is not filled at all
+  bool fFixedRecord;
+  std::vector<std::pair<FixedField, int>> fFixedColumns;
+
   int fNumberOfAbsorbedEvents;
   int fTotalNumberOfEntries;
 };
@@ -0,0 +1,294 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePhaseSpaceFileReader.h"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char kMagic[8] = {'G', 'A', 'T', 'E', 'P', 'H', 'S', 'P'};
+const std::uint32_t kVersion = 2;
+const size_t kNameLength = 64;
+const size_t kFileHeaderSize = 40;
+const size_t kColumnHeaderSize = kNameLength + 8;
+const size_t kChunkIndexSize = 32;
+
+template <class T> T ReadValue(const char *p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  return v;
+}
+
+// all types are 4 bytes, each column is padded to 8 bytes
+std::uint64_t PaddedColumnSize(std::uint64_t n) { return (n * 4 + 7) / 8 * 8; }
+
+// quantization of [-1, 1] in int16
+const double kDirectionScale = 32767.0;
+
+double SignNotZero(double v) { return v >= 0 ? 1.0 : -1.0; }
+} // namespace
+
+GatePhaseSpaceFileReader::GatePhaseSpaceFileReader() {
+  fNumberOfEntries = 0;
+  fData = nullptr;
+  fFileSize = 0;
+#ifdef _WIN32
+  fFileHandle = nullptr;
+  fMappingHandle = nullptr;
+#else
+  fFileDescriptor = -1;
+#endif
+}
+
+GatePhaseSpaceFileReader::~GatePhaseSpaceFileReader() { Close(); }
+
+void GatePhaseSpaceFileReader::Open(const std::string &filename) {
+  Close();
+  fFilename = filename;
+  std::ostringstream oss;
+  oss << "Cannot open the phase-space file '" << filename << "'";
+#ifdef _WIN32
+  auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                          nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                          nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    Fatal(oss.str());
+  fFileHandle = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    Close();
+    Fatal(oss.str());
+  }
+  fFileSize = static_cast<size_t>(size.QuadPart);
+  if (fFileSize > 0) {
+    fMappingHandle =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (fMappingHandle != nullptr)
+      fData = static_cast<const char *>(
+          MapViewOfFile(fMappingHandle, FILE_MAP_READ, 0, 0, 0));
+  }
+#else
+  fFileDescriptor = open(filename.c_str(), O_RDONLY);
+  if (fFileDescriptor < 0)
+    Fatal(oss.str());
+  struct stat st {};
+  if (fstat(fFileDescriptor, &st) != 0) {
+    Close();
+    Fatal(oss.str());
+  }
+  fFileSize = static_cast<size_t>(st.st_size);
+  if (fFileSize > 0) {
+    auto *p =
+        mmap(nullptr, fFileSize, PROT_READ, MAP_PRIVATE, fFileDescriptor, 0);
+    if (p != MAP_FAILED)
+      fData = static_cast<const char *>(p);
+  }
+#endif
+  if (fData == nullptr) {
+    Close();
+    oss << " (cannot map the file in memory)";
+    Fatal(oss.str());
+  }
+  ReadHeader();
+}
+
+void GatePhaseSpaceFileReader::Close() {
+#ifdef _WIN32
+  if (fData != nullptr)
+    UnmapViewOfFile(fData);
+  if (fMappingHandle != nullptr)
+    CloseHandle(fMappingHandle);
+  if (fFileHandle != nullptr)
+    CloseHandle(fFileHandle);
+  fMappingHandle = nullptr;
+  fFileHandle = nullptr;
+#else
+  if (fData != nullptr)
+    munmap(const_cast<char *>(fData), fFileSize);
+  if (fFileDescriptor >= 0)
+    close(fFileDescriptor);
+  fFileDescriptor = -1;
+#endif
+  fData = nullptr;
+  fFileSize = 0;
+  fNumberOfEntries = 0;
+  fColumnNames.clear();
+  fColumnTypes.clear();
+  fChunks.clear();
+}
+
+void GatePhaseSpaceFileReader::ReadError(const std::string &message) {
+  std::ostringstream oss;
+  oss << "The file '" << fFilename
+      << "' is not a valid phase-space file: " << message;
+  Close();
+  Fatal(oss.str());
+}
+
+void GatePhaseSpaceFileReader::ReadHeader() {
+  if (fFileSize < kFileHeaderSize ||
+      std::memcmp(fData, kMagic, sizeof(kMagic)) != 0)
+    ReadError("wrong header");
+  auto version = ReadValue<std::uint32_t>(fData + 8);
+  auto nb_columns = ReadValue<std::uint32_t>(fData + 12);
+  auto nb_entries = ReadValue<std::uint64_t>(fData + 16);
+  auto nb_chunks = ReadValue<std::uint64_t>(fData + 24);
+  auto index_offset = ReadValue<std::uint64_t>(fData + 32);
+  if (version != kVersion) {
+    std::ostringstream oss;
+    oss << "version " << version << " is not supported (only " << kVersion
+        << ")";
+    ReadError(oss.str());
+  }
+  if (fFileSize < kFileHeaderSize + nb_columns * kColumnHeaderSize)
+    ReadError("truncated header");
+  if (index_offset > fFileSize ||
+      (fFileSize - index_offset) / kChunkIndexSize < nb_chunks)
+    ReadError("truncated chunk index");
+
+  // columns
+  for (std::uint32_t c = 0; c < nb_columns; c++) {
+    const auto *h = fData + kFileHeaderSize + c * kColumnHeaderSize;
+    auto name = std::string(h, strnlen(h, kNameLength));
+    auto type = ReadValue<std::uint32_t>(h + kNameLength);
+    if (type != Float32 && type != Int32 && type != Direction) {
+      std::ostringstream oss;
+      oss << "unknown type " << type << " for the column '" << name << "'";
+      ReadError(oss.str());
+    }
+    fColumnNames.push_back(name);
+    fColumnTypes.push_back(static_cast<ColumnType>(type));
+  }
+
+  // chunks, contiguous and in the order of the entries
+  std::uint64_t first = 0;
+  for (std::uint64_t i = 0; i < nb_chunks; i++) {
+    const auto *h = fData + index_offset + i * kChunkIndexSize;
+    auto chunk_first = ReadValue<std::uint64_t>(h);
+    auto n = ReadValue<std::uint64_t>(h + 8);
+    auto offset = ReadValue<std::uint64_t>(h + 16);
+    auto size = ReadValue<std::uint64_t>(h + 24);
+    if (chunk_first != first || n == 0 || offset % 8 != 0 ||
+        offset > fFileSize || size > fFileSize - offset ||
+        size < nb_columns * PaddedColumnSize(n)) {
+      std::ostringstream oss;
+      oss << "wrong index for the chunk " << i;
+      ReadError(oss.str());
+    }
+    Chunk chunk;
+    chunk.fFirstEntry = static_cast<size_t>(first);
+    chunk.fNumberOfEntries = static_cast<size_t>(n);
+    for (std::uint32_t c = 0; c < nb_columns; c++)
+      chunk.fOffsets.push_back(offset + c * PaddedColumnSize(n));
+    fChunks.push_back(chunk);
+    first += n;
+  }
+  if (first != nb_entries)
+    ReadError("the chunks do not match the number of entries");
+  fNumberOfEntries = static_cast<size_t>(nb_entries);
+}
+
+size_t GatePhaseSpaceFileReader::FindChunk(size_t entry) const {
+  auto it = std::upper_bound(
+      fChunks.begin(), fChunks.end(), entry,
+      [](size_t e, const Chunk &c) { return e < c.fFirstEntry; });
+  return static_cast<size_t>(it - fChunks.begin()) - 1;
+}
+
+int GatePhaseSpaceFileReader::GetColumnIndex(const std::string &name) const {
+  for (size_t c = 0; c < fColumnNames.size(); c++)
+    if (fColumnNames[c] == name)
+      return static_cast<int>(c);
+  return -1;
+}
+
+int GatePhaseSpaceFileReader::GetColumnIndex(const std::string &name,
+                                             ColumnType type) const {
+  auto c = GetColumnIndex(name);
+  if (c < 0) {
+    std::ostringstream oss;
+    oss << "No column '" << name << "' in the phase-space file '" << fFilename
+        << "'";
+    Fatal(oss.str());
+  }
+  if (fColumnTypes[c] != type) {
+    const char *names[] = {"float32", "int32", "direction"};
+    std::ostringstream oss;
+    oss << "The column '" << name << "' of the phase-space file '"
+        << fFilename << "' is not " << names[type];
+    Fatal(oss.str());
+  }
+  return c;
+}
+
+void GatePhaseSpaceFileReader::Prefetch(size_t chunk, size_t first,
+                                        size_t n) const {
+#ifdef _WIN32
+  // (no prefetch, the pages are read on first access)
+  (void)chunk;
+  (void)first;
+  (void)n;
+#else
+  static const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const auto &c = fChunks[chunk];
+  for (auto offset : c.fOffsets) {
+    auto begin = (offset + first * 4) / page_size * page_size;
+    auto end = offset + (first + n) * 4;
+    madvise(const_cast<char *>(fData) + begin, end - begin, MADV_WILLNEED);
+  }
+#endif
+}
+
+std::uint32_t
+GatePhaseSpaceFileReader::EncodeDirection(const G4ThreeVector &d) {
+  // projection on the octahedron |x| + |y| + |z| = 1, the lower half is
+  // folded over the upper one
+  auto norm = std::abs(d.x()) + std::abs(d.y()) + std::abs(d.z());
+  if (norm == 0)
+    norm = 1;
+  auto u = d.x() / norm;
+  auto v = d.y() / norm;
+  if (d.z() < 0) {
+    auto fu = (1 - std::abs(v)) * SignNotZero(u);
+    v = (1 - std::abs(u)) * SignNotZero(v);
+    u = fu;
+  }
+  auto qu = static_cast<std::int16_t>(std::lround(u * kDirectionScale));
+  auto qv = static_cast<std::int16_t>(std::lround(v * kDirectionScale));
+  return static_cast<std::uint32_t>(static_cast<std::uint16_t>(qu)) |
+         (static_cast<std::uint32_t>(static_cast<std::uint16_t>(qv)) << 16);
+}
+
+G4ThreeVector GatePhaseSpaceFileReader::DecodeDirection(std::uint32_t code) {
+  auto u = static_cast<std::int16_t>(code & 0xFFFF) / kDirectionScale;
+  auto v = static_cast<std::int16_t>(code >> 16) / kDirectionScale;
+  auto z = 1 - std::abs(u) - std::abs(v);
+  if (z < 0) {
+    auto fu = (1 - std::abs(v)) * SignNotZero(u);
+    v = (1 - std::abs(u)) * SignNotZero(v);
+    u = fu;
+  }
+  return G4ThreeVector(u, v, z).unit();
+}
@@ -0,0 +1,127 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePhaseSpaceFileReader_h
+#define GatePhaseSpaceFileReader_h
+
+#include "G4ThreeVector.hh"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    Read-only, memory-mapped, columnar phase-space file (.gphsp). The file is
+    mapped once and the chunks are used in place (no copy): the same reader
+    can be shared by all threads, each one reading its own entries.
+
+    File format (little endian), written by GatePhaseSpaceFileWriter and by
+    write_phsp_columnar in opengate/sources/phspsources.py:
+    - "GATEPHSP" (8 bytes)
+    - uint32 version (2), uint32 number of columns
+    - uint64 number of entries, uint64 number of chunks
+    - uint64 offset of the chunk index
+    - for each column: char name[64] (zero padded), uint32 type, uint32 (0)
+    - the chunks: the values of each column for the entries of the chunk,
+      one column after the other, each one padded to 8 bytes
+    - the chunk index, for each chunk: uint64 first entry, uint64 number of
+      entries, uint64 offset of the data, uint64 size of the data (bytes)
+    All types are 4 bytes: float32, int32, or a unit vector (direction)
+    quantized with the octahedral encoding in two int16.
+    The chunks are stored raw (the index gives their size, so that they may
+    be compressed in a later version).
+ */
+
+class GatePhaseSpaceFileReader {
+public:
+  enum ColumnType { Float32 = 0, Int32 = 1, Direction = 2 };
+
+  GatePhaseSpaceFileReader();
+
+  ~GatePhaseSpaceFileReader();
+
+  GatePhaseSpaceFileReader(const GatePhaseSpaceFileReader &) = delete;
+
+  GatePhaseSpaceFileReader &
+  operator=(const GatePhaseSpaceFileReader &) = delete;
+
+  // Map the file and read the header (Fatal if not a valid file)
+  void Open(const std::string &filename);
+
+  void Close();
+
+  bool IsOpen() const { return fData != nullptr; }
+
+  const std::string &GetFilename() const { return fFilename; }
+
+  size_t GetNumberOfEntries() const { return fNumberOfEntries; }
+
+  size_t GetNumberOfChunks() const { return fChunks.size(); }
+
+  // Chunk that contains this entry (entry < number of entries)
+  size_t FindChunk(size_t entry) const;
+
+  size_t GetChunkFirstEntry(size_t chunk) const {
+    return fChunks[chunk].fFirstEntry;
+  }
+
+  size_t GetChunkNumberOfEntries(size_t chunk) const {
+    return fChunks[chunk].fNumberOfEntries;
+  }
+
+  // Index of the column, -1 if it does not exist
+  int GetColumnIndex(const std::string &name) const;
+
+  ColumnType GetColumnType(int column) const { return fColumnTypes[column]; }
+
+  // Index of the column, Fatal if it does not exist or has another type
+  int GetColumnIndex(const std::string &name, ColumnType type) const;
+
+  // Values of the column for the entries of the chunk
+  const void *GetColumnData(int column, size_t chunk) const {
+    return fData + fChunks[chunk].fOffsets[column];
+  }
+
+  // Ask the system to read in advance the pages of these entries of the
+  // chunk (asynchronous, the call does not wait)
+  void Prefetch(size_t chunk, size_t first, size_t n) const;
+
+  // Unit vector quantized in 2 int16 (octahedral encoding)
+  static std::uint32_t EncodeDirection(const G4ThreeVector &d);
+
+  static G4ThreeVector DecodeDirection(std::uint32_t code);
+
+protected:
+  void ReadHeader();
+
+  void ReadError(const std::string &message);
+
+  std::vector<std::string> fColumnNames;
+  std::vector<ColumnType> fColumnTypes;
+
+  struct Chunk {
+    size_t fFirstEntry;
+    size_t fNumberOfEntries;
+    // offset of each column in the file
+    std::vector<std::uint64_t> fOffsets;
+  };
+  std::vector<Chunk> fChunks;
+
+  std::string fFilename;
+  size_t fNumberOfEntries;
+  const char *fData;
+  size_t fFileSize;
+
+#ifdef _WIN32
+  void *fFileHandle;
+  void *fMappingHandle;
+#else
+  int fFileDescriptor;
+#endif
+};
+
+#endif // GatePhaseSpaceFileReader_h
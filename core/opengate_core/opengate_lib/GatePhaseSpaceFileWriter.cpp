@@ -0,0 +1,121 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePhaseSpaceFileWriter.h"
+#include "GateHelpers.h"
+#include <cstring>
+#include <sstream>
+
+namespace {
+const char kMagic[8] = {'G', 'A', 'T', 'E', 'P', 'H', 'S', 'P'};
+const std::uint32_t kVersion = 2;
+const size_t kNameLength = 64;
+
+template <class T> void WriteValue(std::ofstream &f, T v) {
+  f.write(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+void WritePadding(std::ofstream &f, std::uint64_t size) {
+  const char zeros[8] = {};
+  f.write(zeros, static_cast<std::streamsize>((8 - size % 8) % 8));
+}
+} // namespace
+
+GatePhaseSpaceFileWriter::GatePhaseSpaceFileWriter() { fNumberOfEntries = 0; }
+
+GatePhaseSpaceFileWriter::~GatePhaseSpaceFileWriter() { Close(); }
+
+void GatePhaseSpaceFileWriter::Open(const std::string &filename,
+                                    const std::vector<std::string> &names,
+                                    const std::vector<ColumnType> &types) {
+  Close();
+  for (const auto &name : names) {
+    if (name.size() >= kNameLength) {
+      std::ostringstream oss;
+      oss << "The name of the column '" << name << "' is too long for the "
+          << "phase-space file '" << filename << "' (max " << kNameLength - 1
+          << " characters)";
+      Fatal(oss.str());
+    }
+  }
+  fFilename = filename;
+  fNames = names;
+  fTypes = types;
+  fNumberOfEntries = 0;
+  fIndex.clear();
+  fFile.open(filename, std::ios::binary | std::ios::trunc);
+  if (!fFile) {
+    std::ostringstream oss;
+    oss << "Cannot write the phase-space file '" << filename << "'";
+    Fatal(oss.str());
+  }
+  // the header is written again by Close, with the chunk index
+  WriteHeader();
+}
+
+void GatePhaseSpaceFileWriter::WriteHeader() {
+  fFile.seekp(0);
+  fFile.write(kMagic, sizeof(kMagic));
+  WriteValue<std::uint32_t>(fFile, kVersion);
+  WriteValue<std::uint32_t>(fFile, static_cast<std::uint32_t>(fNames.size()));
+  WriteValue<std::uint64_t>(fFile, fNumberOfEntries);
+  WriteValue<std::uint64_t>(fFile, fIndex.size() / 4);
+  WriteValue<std::uint64_t>(fFile, 0); // offset of the index, set by Close
+  for (size_t c = 0; c < fNames.size(); c++) {
+    char name[kNameLength] = {};
+    std::memcpy(name, fNames[c].data(), fNames[c].size());
+    fFile.write(name, kNameLength);
+    WriteValue<std::uint32_t>(fFile, static_cast<std::uint32_t>(fTypes[c]));
+    WriteValue<std::uint32_t>(fFile, 0);
+  }
+}
+
+void GatePhaseSpaceFileWriter::WriteChunk(
+    const std::vector<const void *> &columns, size_t n) {
+  if (n == 0)
+    return;
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (columns.size() != fNames.size())
+    Fatal("GatePhaseSpaceFileWriter: wrong number of columns");
+  fFile.seekp(0, std::ios::end);
+  std::uint64_t offset = fFile.tellp();
+  WritePadding(fFile, offset);
+  offset = fFile.tellp();
+  for (const auto *column : columns) {
+    fFile.write(static_cast<const char *>(column),
+                static_cast<std::streamsize>(n * 4));
+    WritePadding(fFile, n * 4);
+  }
+  std::uint64_t size = static_cast<std::uint64_t>(fFile.tellp()) - offset;
+  fIndex.insert(fIndex.end(), {fNumberOfEntries, n, offset, size});
+  fNumberOfEntries += n;
+  if (!fFile) {
+    std::ostringstream oss;
+    oss << "Error while writing the phase-space file '" << fFilename << "'";
+    Fatal(oss.str());
+  }
+}
+
+void GatePhaseSpaceFileWriter::Close() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (!fFile.is_open())
+    return;
+  fFile.seekp(0, std::ios::end);
+  WritePadding(fFile, fFile.tellp());
+  std::uint64_t index_offset = fFile.tellp();
+  for (auto v : fIndex)
+    WriteValue<std::uint64_t>(fFile, v);
+  WriteHeader();
+  fFile.seekp(32);
+  WriteValue<std::uint64_t>(fFile, index_offset);
+  fFile.close();
+  if (fFile.fail()) {
+    std::ostringstream oss;
+    oss << "Error while writing the phase-space file '" << fFilename << "'";
+    Fatal(oss.str());
+  }
+}
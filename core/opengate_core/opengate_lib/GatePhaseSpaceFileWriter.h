@@ -0,0 +1,65 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePhaseSpaceFileWriter_h
+#define GatePhaseSpaceFileWriter_h
+
+#include "GatePhaseSpaceFileReader.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    Write a columnar phase-space file (.gphsp, see GatePhaseSpaceFileReader
+    for the format). The entries are written by chunks: each chunk holds the
+    values of all the columns for a set of entries. Chunks can be written by
+    several threads (one at a time), the order of the chunks in the file is
+    the order of the calls. The index and the header are written by Close.
+ */
+
+class GatePhaseSpaceFileWriter {
+public:
+  using ColumnType = GatePhaseSpaceFileReader::ColumnType;
+
+  GatePhaseSpaceFileWriter();
+
+  ~GatePhaseSpaceFileWriter();
+
+  GatePhaseSpaceFileWriter(const GatePhaseSpaceFileWriter &) = delete;
+
+  GatePhaseSpaceFileWriter &
+  operator=(const GatePhaseSpaceFileWriter &) = delete;
+
+  void Open(const std::string &filename, const std::vector<std::string> &names,
+            const std::vector<ColumnType> &types);
+
+  // One array of n values (4 bytes each) per column, in the order of Open
+  void WriteChunk(const std::vector<const void *> &columns, size_t n);
+
+  void Close();
+
+  bool IsOpen() const { return fFile.is_open(); }
+
+  size_t GetNumberOfEntries() const { return fNumberOfEntries; }
+
+protected:
+  void WriteHeader();
+
+  std::string fFilename;
+  std::ofstream fFile;
+  std::mutex fMutex;
+  std::vector<std::string> fNames;
+  std::vector<ColumnType> fTypes;
+  size_t fNumberOfEntries;
+
+  // first entry, number of entries, offset, size
+  std::vector<std::uint64_t> fIndex;
+};
+
+#endif // GatePhaseSpaceFileWriter_h
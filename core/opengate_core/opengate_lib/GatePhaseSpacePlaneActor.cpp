@@ -0,0 +1,134 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePhaseSpacePlaneActor.h"
+#include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
+#include "digitizer/GateTDigiAttribute.h"
+#include <map>
+
+GatePhaseSpacePlaneActor::GatePhaseSpacePlaneActor(py::dict &user_info)
+    : GatePhaseSpaceActor(user_info) {
+  fPlaneNormal = {0, 0, 1};
+  fStoreBothDirections = false;
+}
+
+void GatePhaseSpacePlaneActor::InitializeUserInfo(py::dict &user_info) {
+  GatePhaseSpaceActor::InitializeUserInfo(user_info);
+  fPlanePosition = DictGetG4ThreeVector(user_info, "plane_position");
+  fPlaneNormal = DictGetG4ThreeVector(user_info, "plane_normal");
+  if (fPlaneNormal.mag2() == 0) {
+    std::ostringstream oss;
+    oss << "The plane_normal of the actor '" << GetName()
+        << "' must not be a null vector";
+    Fatal(oss.str());
+  }
+  fPlaneNormal = fPlaneNormal.unit();
+  fStoreBothDirections = DictGetBool(user_info, "both_directions");
+}
+
+void GatePhaseSpacePlaneActor::InitializeDigiAttributes() {
+  static const std::map<std::string, PlaneField> fields = {
+      {"Position", PlaneField::Position},
+      {"Direction", PlaneField::Direction},
+      {"KineticEnergy", PlaneField::KineticEnergy},
+      {"Weight", PlaneField::Weight},
+      {"PDGCode", PlaneField::PDGCode},
+      {"EventID", PlaneField::EventID},
+      {"TrackID", PlaneField::TrackID},
+      {"GlobalTime", PlaneField::GlobalTime}};
+  fPlaneAttributes.clear();
+  for (const auto &name : fUserDigiAttributeNames) {
+    auto it = fields.find(name);
+    if (it == fields.end()) {
+      std::ostringstream oss;
+      oss << "The attribute '" << name << "' of the actor '" << GetName()
+          << "' is not available for a plane crossing. Must be one of: ";
+      for (const auto &f : fields)
+        oss << f.first << " ";
+      Fatal(oss.str());
+    }
+    // (the attributes are filled explicitly, not from the step)
+    if (it->second == PlaneField::Position ||
+        it->second == PlaneField::Direction) {
+      auto *att = new GateTDigiAttribute<G4ThreeVector>(name);
+      fHits->InitDigiAttribute(att);
+    } else
+      fHits->InitDigiAttributeFromName(name);
+    fPlaneAttributes.emplace_back(fHits->GetDigiAttribute(name), it->second);
+  }
+}
+
+void GatePhaseSpacePlaneActor::StartSimulationAction() {
+  GatePhaseSpaceActor::StartSimulationAction();
+  // the fixed record reads the step values, not the crossing ones
+  fFixedRecord = false;
+}
+
+void GatePhaseSpacePlaneActor::BeginOfRunAction(const G4Run *run) {
+  GatePhaseSpaceActor::BeginOfRunAction(run);
+  // (the geometry may change between runs)
+  G4ThreeVector translation;
+  G4RotationMatrix rotation;
+  ComputeTransformationFromVolumeToWorld(fAttachedToVolumeName, translation,
+                                         rotation, true);
+  const G4AffineTransform volumeToWorld(rotation.inverse(), translation);
+  fWorldPlanePosition = volumeToWorld.TransformPoint(fPlanePosition);
+  fWorldPlaneNormal = volumeToWorld.TransformAxis(fPlaneNormal);
+}
+
+void GatePhaseSpacePlaneActor::SteppingAction(G4Step *step) {
+  // signed distances of the pre and post step points to the plane
+  const auto *pre = step->GetPreStepPoint();
+  const auto *post = step->GetPostStepPoint();
+  const auto &p0 = pre->GetPosition();
+  const auto &p1 = post->GetPosition();
+  const double s0 = (p0 - fWorldPlanePosition).dot(fWorldPlaneNormal);
+  const double s1 = (p1 - fWorldPlanePosition).dot(fWorldPlaneNormal);
+
+  // a step that ends on the plane is a crossing, the next one (that starts
+  // on the plane) is not
+  const bool forward = s0 < 0 && s1 >= 0;
+  const bool backward = fStoreBothDirections && s0 > 0 && s1 <= 0;
+  if (!forward && !backward)
+    return;
+
+  // the step is a straight line between the two points, the other values are
+  // the ones of the pre step point
+  const double t = s0 / (s0 - s1);
+  const auto *track = step->GetTrack();
+  auto &l = fThreadLocalData.Get();
+  for (auto &[att, field] : fPlaneAttributes) {
+    switch (field) {
+    case PlaneField::Position:
+      att->Fill3Value(p0 + t * (p1 - p0));
+      break;
+    case PlaneField::Direction:
+      att->Fill3Value(pre->GetMomentumDirection());
+      break;
+    case PlaneField::KineticEnergy:
+      att->FillDValue(pre->GetKineticEnergy());
+      break;
+    case PlaneField::Weight:
+      att->FillDValue(pre->GetWeight());
+      break;
+    case PlaneField::PDGCode:
+      att->FillIValue(track->GetParticleDefinition()->GetPDGEncoding());
+      break;
+    case PlaneField::EventID:
+      att->FillIValue(l.fEventID);
+      break;
+    case PlaneField::TrackID:
+      att->FillIValue(track->GetTrackID());
+      break;
+    case PlaneField::GlobalTime:
+      att->FillDValue(pre->GetGlobalTime() +
+                      t * (post->GetGlobalTime() - pre->GetGlobalTime()));
+      break;
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePhaseSpacePlaneActor_h
+#define GatePhaseSpacePlaneActor_h
+
+#include "G4AffineTransform.hh"
+#include "GatePhaseSpaceActor.h"
+
+namespace py = pybind11;
+
+/*
+ * Phase-space of the particles crossing a virtual plane: no scoring volume
+ * (and no extra step) is needed, the crossings are computed from the pre and
+ * post step points of the steps in the attached volume (and its daughters).
+ * The plane is defined in the coordinate system of the attached volume.
+ */
+class GatePhaseSpacePlaneActor : public GatePhaseSpaceActor {
+
+public:
+  explicit GatePhaseSpacePlaneActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void SteppingAction(G4Step *step) override;
+
+protected:
+  void InitializeDigiAttributes() override;
+
+  // the values that can be stored for each crossing
+  enum class PlaneField {
+    Position,
+    Direction,
+    KineticEnergy,
+    Weight,
+    PDGCode,
+    EventID,
+    TrackID,
+    GlobalTime
+  };
+  std::vector<std::pair<GateVDigiAttribute *, PlaneField>> fPlaneAttributes;
+
+  // plane in the attached volume, and in the world (updated for each run)
+  G4ThreeVector fPlanePosition;
+  G4ThreeVector fPlaneNormal;
+  G4ThreeVector fWorldPlanePosition;
+  G4ThreeVector fWorldPlaneNormal;
+  bool fStoreBothDirections;
+};
+
+#endif // GatePhaseSpacePlaneActor_h
@@ -11,6 +11,11 @@
 #include "G4UnitsTable.hh"
 #include "GateHelpersDict.h"
 #include "GateHelpersPyBind.h"
+#include "GateMemoryAccounting.h"
+#include "GateTimeline.h"
+#include <Randomize.hh>
+#include <algorithm>
+#include <sstream>
 
 GatePhaseSpaceSource::GatePhaseSpaceSource() : GateVSource() {
   fCharge = 0;
@@ -19,6 +24,14 @@ GatePhaseSpaceSource::GatePhaseSpaceSource() : GateVSource() {
   fVerbose = false;
   fParticleTable = nullptr;
   fUseParticleTypeFromFile = false;
+  fNativeBatchSize = 0;
+  fNativeCycleCount = 0;
+  fTranslatePosition = false;
+  fRotateDirection = false;
+  fTransformInCpp = false;
+  fRecycling = 1;
+  fRecyclingRotation = false;
+  fRecyclingMirror = false;
   auto &l = fThreadLocalDataPhsp.Get();
   l.fParticleDefinition = nullptr;
 }
@@ -67,6 +80,23 @@ void GatePhaseSpaceSource::InitializeUserInfo(py::dict &user_info) {
   l.fPrimaryLowerEnergyThreshold =
       DictGetDouble(user_info, "primary_lower_energy_threshold");
   l.fPrimaryPDGCode = DictGetInt(user_info, "primary_PDGCode");
+
+  // recycling: each particle is used several times, the symmetries are
+  // applied in the coordinate system of the phsp (Z is the beam axis)
+  fRecycling = DictGetInt(user_info, "recycling");
+  fRecyclingRotation = DictGetBool(user_info, "recycling_rotation");
+  fRecyclingMirror = DictGetBool(user_info, "recycling_mirror");
+  l.fRecyclingIndex = 0;
+
+  // the translation/rotation of the phsp are applied here (and not on the
+  // batch in Python) for the native reader or with symmetries
+  fTransformInCpp = DictGetStr(user_info, "reader") == "native" ||
+                    fRecyclingRotation || fRecyclingMirror;
+  fTranslatePosition = DictGetBool(user_info, "translate_position");
+  fRotateDirection = DictGetBool(user_info, "rotate_direction");
+  auto position = py::dict(user_info["position"]);
+  fPhspTranslation = DictGetG4ThreeVector(position, "translation");
+  fPhspRotation = DictGetG4RotationMatrix(position, "rotation");
 }
 
 void GatePhaseSpaceSource::PrepareNextRun() {
@@ -102,7 +132,144 @@ void GatePhaseSpaceSource::SetGeneratorFunction(
   l.fGenerator = f;
 }
 
+void GatePhaseSpaceSource::InitializeNativeReader(
+    py::dict &user_info, const std::string &filename) {
+  {
+    // the reader is opened by the first thread, then shared
+    std::lock_guard<std::mutex> lock(fNativeReaderMutex);
+    if (!fNativeReader || fNativeReader->GetFilename() != filename) {
+      auto reader = std::make_shared<GatePhaseSpaceFileReader>();
+      reader->Open(filename);
+      if (reader->GetNumberOfEntries() == 0) {
+        std::ostringstream oss;
+        oss << "GatePhaseSpaceSource: the phase-space '" << filename
+            << "' is empty";
+        Fatal(oss.str());
+      }
+      using Type = GatePhaseSpaceFileReader::ColumnType;
+      auto column = [&](const std::string &key, Type type) {
+        return reader->GetColumnIndex(DictGetStr(user_info, key), type);
+      };
+      auto &c = fNativeColumns;
+      c.fPositionX = column("position_key_x", Type::Float32);
+      c.fPositionY = column("position_key_y", Type::Float32);
+      c.fPositionZ = column("position_key_z", Type::Float32);
+      c.fEnergy = column("energy_key", Type::Float32);
+
+      // the direction is quantized (a single column), or in 3 columns
+      auto direction_key = DictGetStr(user_info, "direction_key");
+      if (reader->GetColumnIndex(direction_key) >= 0)
+        c.fDirection = reader->GetColumnIndex(direction_key, Type::Direction);
+      else {
+        c.fDirection = -1;
+        c.fDirectionX = column("direction_key_x", Type::Float32);
+        c.fDirectionY = column("direction_key_y", Type::Float32);
+        c.fDirectionZ = column("direction_key_z", Type::Float32);
+      }
+
+      // without weight key, the weight is 1
+      auto weight_key = DictGetStr(user_info, "weight_key");
+      c.fWeight = -1;
+      if (!weight_key.empty() && weight_key != "None")
+        c.fWeight = reader->GetColumnIndex(weight_key, Type::Float32);
+
+      // the PDGCode is needed for the particle type or the primaries
+      auto pdg_key = DictGetStr(user_info, "PDGCode_key");
+      c.fPDGCode = -1;
+      if (reader->GetColumnIndex(pdg_key) >= 0)
+        c.fPDGCode = reader->GetColumnIndex(pdg_key, Type::Int32);
+      else if (fUseParticleTypeFromFile ||
+               DictGetBool(user_info, "generate_until_next_primary")) {
+        std::ostringstream oss;
+        oss << "GatePhaseSpaceSource: no PDGCode key (" << pdg_key
+            << ") in the phsp file " << filename;
+        Fatal(oss.str());
+      }
+
+      fNativeBatchSize = DictGetInt(user_info, "batch_size");
+      fNativeCycleCount = 0;
+      fNativeReader = reader;
+    }
+  }
+  auto &l = fThreadLocalDataPhsp.Get();
+  l.fNativeEntry = 0;
+  l.fQuantizedDirection = nullptr;
+  l.fRecyclingIndex = 0;
+  l.fCurrentBatchSize = 0;
+  l.fCurrentIndex = 0;
+}
+
+void GatePhaseSpaceSource::SetEntryStart(size_t entry_start) {
+  auto &l = fThreadLocalDataPhsp.Get();
+  l.fNativeEntry = entry_start % GetNumberOfEntries();
+}
+
+size_t GatePhaseSpaceSource::GetNumberOfEntries() const {
+  return fNativeReader ? fNativeReader->GetNumberOfEntries() : 0;
+}
+
 void GatePhaseSpaceSource::GenerateBatchOfParticles() {
+  GateTimelineScope timeline("phsp batch", "callback");
+  if (fNativeReader) {
+    // the next batch points to the mapped data of the thread entries
+    auto &l = fThreadLocalDataPhsp.Get();
+    auto n = fNativeReader->GetNumberOfEntries();
+    if (l.fNativeEntry >= n) {
+      auto cycle = ++fNativeCycleCount;
+      l.fNativeEntry = 0;
+      // (not a G4Exception, it would abort with the Gate exception handler)
+      std::cout << "WARNING: End of the phase-space " << n
+                << " elements, restart from beginning. Cycle count = "
+                << cycle << std::endl;
+    }
+    // a batch does not cross the end of the chunk
+    const auto &r = *fNativeReader;
+    auto start = l.fNativeEntry;
+    auto chunk = r.FindChunk(start);
+    auto first = r.GetChunkFirstEntry(chunk);
+    auto size = std::min(fNativeBatchSize,
+                         first + r.GetChunkNumberOfEntries(chunk) - start);
+    const auto &c = fNativeColumns;
+    auto data = [&](int column) {
+      return column < 0 ? nullptr : r.GetColumnData(column, chunk);
+    };
+    auto floats = [&](int column) {
+      return static_cast<const std::float_t *>(data(column)) + (start - first);
+    };
+    l.fPDGCode = c.fPDGCode < 0 ? nullptr
+                                : static_cast<const std::int32_t *>(
+                                      data(c.fPDGCode)) +
+                                      (start - first);
+    l.fPositionX = floats(c.fPositionX);
+    l.fPositionY = floats(c.fPositionY);
+    l.fPositionZ = floats(c.fPositionZ);
+    if (c.fDirection >= 0)
+      l.fQuantizedDirection =
+          static_cast<const std::uint32_t *>(data(c.fDirection)) +
+          (start - first);
+    else {
+      l.fDirectionX = floats(c.fDirectionX);
+      l.fDirectionY = floats(c.fDirectionY);
+      l.fDirectionZ = floats(c.fDirectionZ);
+    }
+    l.fEnergy = floats(c.fEnergy);
+    l.fWeight = c.fWeight < 0 ? nullptr : floats(c.fWeight);
+    l.fCurrentBatchSize = size;
+    l.fCurrentIndex = 0;
+    l.fNativeEntry = start + size;
+
+    // the pages of the next batch are read by the system in the background
+    auto next = l.fNativeEntry < n ? l.fNativeEntry : 0;
+    auto next_chunk = r.FindChunk(next);
+    auto next_first = r.GetChunkFirstEntry(next_chunk);
+    r.Prefetch(next_chunk, next - next_first,
+               std::min(fNativeBatchSize,
+                        next_first + r.GetChunkNumberOfEntries(next_chunk) -
+                            next));
+    UpdateMemoryAccounting();
+    return;
+  }
+
   // I don't know if we should acquire the GIL or not
   // (does not seem needed)
   // py::gil_scoped_acquire acquire;
@@ -114,6 +281,26 @@ void GatePhaseSpaceSource::GenerateBatchOfParticles() {
   auto &l = fThreadLocalDataPhsp.Get();
   l.fCurrentBatchSize = l.fGenerator(this, G4Threading::G4GetThreadId());
   l.fCurrentIndex = 0;
+  UpdateMemoryAccounting();
+}
+
+void GatePhaseSpaceSource::UpdateMemoryAccounting() {
+  if (!GateMemoryAccounting::IsEnabled())
+    return;
+  // bytes of the columns of the current batch (numpy arrays from the py
+  // side, or mapped pages of the file with the native reader)
+  const auto &l = fThreadLocalDataPhsp.Get();
+  size_t entry = 3 * sizeof(std::float_t) + sizeof(std::float_t);
+  if (l.fPDGCode != nullptr)
+    entry += sizeof(std::int32_t);
+  if (l.fQuantizedDirection != nullptr)
+    entry += sizeof(std::uint32_t);
+  else
+    entry += 3 * sizeof(std::float_t);
+  if (l.fWeight != nullptr)
+    entry += sizeof(std::float_t);
+  GateMemoryAccounting::Update("phsp_batch", fName,
+                               l.fCurrentBatchSize * entry);
 }
 
 void GatePhaseSpaceSource::GeneratePrimaries(G4Event *event,
@@ -163,8 +350,13 @@ void GatePhaseSpaceSource::GeneratePrimaries(G4Event *event,
     // Go
     GenerateOnePrimary(event, current_simulation_time);
 
-    // update the root file index;
-    l.fCurrentIndex++;
+    // update the root file index, once the particle has been used
+    // fRecycling times
+    l.fRecyclingIndex++;
+    if (l.fRecyclingIndex >= fRecycling) {
+      l.fRecyclingIndex = 0;
+      l.fCurrentIndex++;
+    }
 
     // update the number of generated event
     l.fNumberOfGeneratedEvents++;
@@ -178,14 +370,38 @@ void GatePhaseSpaceSource::GenerateOnePrimary(G4Event *event,
   auto position = G4ThreeVector(l.fPositionX[l.fCurrentIndex],
                                 l.fPositionY[l.fCurrentIndex],
                                 l.fPositionZ[l.fCurrentIndex]);
-  auto direction = G4ParticleMomentum(l.fDirectionX[l.fCurrentIndex],
-                                      l.fDirectionY[l.fCurrentIndex],
-                                      l.fDirectionZ[l.fCurrentIndex]);
+  auto direction =
+      l.fQuantizedDirection == nullptr
+          ? G4ParticleMomentum(l.fDirectionX[l.fCurrentIndex],
+                               l.fDirectionY[l.fCurrentIndex],
+                               l.fDirectionZ[l.fCurrentIndex])
+          : GatePhaseSpaceFileReader::DecodeDirection(
+                l.fQuantizedDirection[l.fCurrentIndex]);
   auto energy = l.fEnergy[l.fCurrentIndex];
-  auto weight = l.fWeight[l.fCurrentIndex];
+  double weight = l.fWeight == nullptr ? 1.0 : l.fWeight[l.fCurrentIndex];
 
   // FIXME auto time = fTime[l.fCurrentIndex];
 
+  // symmetries of the phsp around the beam axis (Z)
+  if (fRecyclingRotation) {
+    auto angle = CLHEP::twopi * G4UniformRand();
+    position.rotateZ(angle);
+    direction.rotateZ(angle);
+  }
+  if (fRecyclingMirror && G4UniformRand() < 0.5) {
+    position.setX(-position.x());
+    direction.setX(-direction.x());
+  }
+
+  // with the native reader or with symmetries, the data are used as is in
+  // the file (otherwise, this is done on the batch by the Python generator)
+  if (fTransformInCpp) {
+    if (fTranslatePosition)
+      position += fPhspTranslation;
+    if (fRotateDirection)
+      direction = fPhspRotation * direction;
+  }
+
   // transform according to mother
   if (!fGlobalFag) {
     auto &ls = fThreadLocalData.Get();
@@ -208,17 +424,11 @@ void GatePhaseSpaceSource::AddOnePrimaryVertex(G4Event *event,
   if (fUseParticleTypeFromFile) {
     auto pdg = l.fPDGCode[l.fCurrentIndex];
     if (l.fPDGCode[l.fCurrentIndex] != 0) {
-      // find if particle exists
-      l.fParticleDefinition = fParticleTable->FindParticle(pdg);
-      // if not, find if it is an ion
-      if (l.fParticleDefinition == nullptr) {
-        G4IonTable *ionTable = fParticleTable->GetIonTable();
-        l.fParticleDefinition = ionTable->GetIon(pdg);
-      }
-      if (l.fParticleDefinition == nullptr) {
-        Fatal("GatePhaseSpaceSource: PDGCode not found. Aborting.");
-      }
-      particle->SetParticleDefinition(l.fParticleDefinition);
+      const auto &p = GetParticleOfPDGCode(pdg);
+      l.fParticleDefinition = p.fDefinition;
+      particle->SetParticleDefinition(p.fDefinition);
+      particle->SetMass(p.fMass);
+      particle->SetCharge(p.fCharge);
     } else {
       Fatal("GatePhaseSpaceSource: PDGCode not available. Aborting.");
     }
@@ -245,6 +455,35 @@ void GatePhaseSpaceSource::AddOnePrimaryVertex(G4Event *event,
   }
 }
 
+const GatePhaseSpaceSource::ParticleOfPDGCode &
+GatePhaseSpaceSource::GetParticleOfPDGCode(std::int32_t pdg) {
+  auto &l = fThreadLocalDataPhsp.Get();
+  auto &particles = l.fParticlesOfPDGCode;
+  // (consecutive particles of a phsp are often of the same type)
+  if (l.fLastParticleOfPDGCode < particles.size() &&
+      particles[l.fLastParticleOfPDGCode].fPDGCode == pdg)
+    return particles[l.fLastParticleOfPDGCode];
+  for (size_t i = 0; i < particles.size(); i++) {
+    if (particles[i].fPDGCode == pdg) {
+      l.fLastParticleOfPDGCode = i;
+      return particles[i];
+    }
+  }
+  // first time: find if particle exists, if not, find if it is an ion
+  auto *definition = fParticleTable->FindParticle(pdg);
+  if (definition == nullptr) {
+    G4IonTable *ionTable = fParticleTable->GetIonTable();
+    definition = ionTable->GetIon(pdg);
+  }
+  if (definition == nullptr) {
+    Fatal("GatePhaseSpaceSource: PDGCode not found. Aborting.");
+  }
+  particles.push_back({pdg, definition, definition->GetPDGCharge(),
+                       definition->GetPDGMass()});
+  l.fLastParticleOfPDGCode = particles.size() - 1;
+  return particles.back();
+}
+
 void GatePhaseSpaceSource::SetPDGCodeBatch(
     const py::array_t<std::int32_t> &fPDGCode) const {
   auto &l = fThreadLocalDataPhsp.Get();
@@ -8,9 +8,13 @@
 #ifndef GatePhaseSpaceSource_h
 #define GatePhaseSpaceSource_h
 
+#include "GatePhaseSpaceFileReader.h"
 #include "GateSPSVoxelsPosDistribution.h"
 #include "GateSingleParticleSource.h"
 #include "GateVSource.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -45,10 +49,39 @@ public:
 
   void SetGeneratorFunction(ParticleGeneratorType &f) const;
 
+  // Particle of a PDG code (or ion), with its charge and mass, searched in
+  // the particle/ion tables only the first time for this thread
+  struct ParticleOfPDGCode {
+    std::int32_t fPDGCode;
+    G4ParticleDefinition *fDefinition;
+    double fCharge;
+    double fMass;
+  };
+
+  const ParticleOfPDGCode &GetParticleOfPDGCode(std::int32_t pdg);
+
   bool ParticleIsPrimary() const;
 
   void GenerateBatchOfParticles();
 
+  // Report the bytes of the current batch of the thread to
+  // GateMemoryAccounting (if enabled)
+  void UpdateMemoryAccounting();
+
+  // Native reader: the columnar phsp file is memory-mapped once and shared
+  // by all threads, the batches point directly to the mapped data (no
+  // Python callback, no copy). Called by all threads.
+  void InitializeNativeReader(py::dict &user_info,
+                              const std::string &filename);
+
+  // Entry of the phsp where the current thread starts (native reader)
+  void SetEntryStart(size_t entry_start);
+
+  size_t GetNumberOfEntries() const;
+
+  // number of restarts of the phsp, all threads (native reader)
+  unsigned long GetCycleCount() const { return fNativeCycleCount; }
+
   G4ParticleTable *fParticleTable;
   std::float_t fCharge;
   std::float_t fMass;
@@ -74,6 +107,38 @@ public:
 
   void SetDirectionZBatch(const py::array_t<std::float_t> &fDirectionZ) const;
 
+  // each particle is used fRecycling times, with a random rotation around
+  // the beam axis and/or a random mirroring (x -> -x)
+  size_t fRecycling;
+  bool fRecyclingRotation;
+  bool fRecyclingMirror;
+  // translation/rotation of the phsp, done in C++ (not on the Python batch)
+  bool fTransformInCpp;
+  bool fTranslatePosition;
+  bool fRotateDirection;
+  G4ThreeVector fPhspTranslation;
+  G4RotationMatrix fPhspRotation;
+
+  // native reader, shared by all threads
+  std::shared_ptr<GatePhaseSpaceFileReader> fNativeReader;
+  std::mutex fNativeReaderMutex;
+  std::atomic<unsigned long> fNativeCycleCount;
+  size_t fNativeBatchSize;
+  // index of the columns in the file, -1 if not used
+  struct NativeColumns {
+    int fPDGCode = -1;
+    int fPositionX = -1;
+    int fPositionY = -1;
+    int fPositionZ = -1;
+    int fDirection = -1; // quantized direction, else X Y Z
+    int fDirectionX = -1;
+    int fDirectionY = -1;
+    int fDirectionZ = -1;
+    int fEnergy = -1;
+    int fWeight = -1; // -1: weight is 1
+  };
+  NativeColumns fNativeColumns;
+
   // For MT, all threads local variables are gathered here
   struct threadLocalTPhsp {
     G4ParticleDefinition *fParticleDefinition;
@@ -87,19 +152,31 @@ public:
     size_t fCurrentIndex;
     size_t fCurrentBatchSize;
 
-    std::int32_t *fPDGCode;
+    // native reader: next entry of the phsp
+    size_t fNativeEntry = 0;
 
-    std::float_t *fPositionX;
-    std::float_t *fPositionY;
-    std::float_t *fPositionZ;
+    // number of uses of the current particle (recycling)
+    size_t fRecyclingIndex = 0;
 
-    std::float_t *fDirectionX;
-    std::float_t *fDirectionY;
-    std::float_t *fDirectionZ;
+    const std::int32_t *fPDGCode;
 
-    std::float_t *fEnergy;
-    std::float_t *fWeight;
+    const std::float_t *fPositionX;
+    const std::float_t *fPositionY;
+    const std::float_t *fPositionZ;
+
+    const std::float_t *fDirectionX;
+    const std::float_t *fDirectionY;
+    const std::float_t *fDirectionZ;
+    const std::uint32_t *fQuantizedDirection = nullptr;
+
+    const std::float_t *fEnergy;
+    const std::float_t *fWeight; // nullptr: weight is 1
     // double * fTime; // FIXME todo
+
+    // particles of the PDG codes already read by this thread (a few
+    // particle types in a phsp: linear search, last one first)
+    std::vector<ParticleOfPDGCode> fParticlesOfPDGCode;
+    size_t fLastParticleOfPDGCode = 0;
   };
   G4Cache<threadLocalTPhsp> fThreadLocalDataPhsp;
 };
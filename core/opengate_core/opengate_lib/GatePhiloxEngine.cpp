@@ -0,0 +1,224 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePhiloxEngine.h"
+#include "CLHEP/Random/engineIDulong.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Philox4x32 constants (multipliers and Weyl sequence of the key)
+constexpr std::uint32_t kM0 = 0xD2511F53;
+constexpr std::uint32_t kM1 = 0xCD9E8D57;
+constexpr std::uint32_t kW0 = 0x9E3779B9;
+constexpr std::uint32_t kW1 = 0xBB67AE85;
+
+inline void MulHiLo(std::uint32_t a, std::uint32_t b, std::uint32_t &hi,
+                    std::uint32_t &lo) {
+  auto p = static_cast<std::uint64_t>(a) * b;
+  hi = static_cast<std::uint32_t>(p >> 32);
+  lo = static_cast<std::uint32_t>(p);
+}
+
+// 10 rounds of Philox4x32
+inline std::array<std::uint32_t, 4>
+Philox(std::array<std::uint32_t, 4> c, std::array<std::uint32_t, 2> k) {
+  for (int round = 0; round < 10; round++) {
+    std::uint32_t hi0, lo0, hi1, lo1;
+    MulHiLo(kM0, c[0], hi0, lo0);
+    MulHiLo(kM1, c[2], hi1, lo1);
+    c = {hi1 ^ c[1] ^ k[0], lo1, hi0 ^ c[3] ^ k[1], lo0};
+    k[0] += kW0;
+    k[1] += kW1;
+  }
+  return c;
+}
+
+// 52 random bits in ]0, 1[ (never 0 or 1, like the CLHEP engines)
+inline double ToDouble(std::uint32_t hi, std::uint32_t lo) {
+  auto x = ((static_cast<std::uint64_t>(hi) << 32) | lo) >> 12;
+  return (static_cast<double>(x) + 0.5) * 0x1.0p-52;
+}
+
+} // namespace
+
+GatePhiloxEngine::GatePhiloxEngine() : GatePhiloxEngine(19780503L) {}
+
+GatePhiloxEngine::GatePhiloxEngine(long seed) { setSeed(seed, 0); }
+
+void GatePhiloxEngine::SetKey(std::uint64_t key) {
+  fKey = {static_cast<std::uint32_t>(key),
+          static_cast<std::uint32_t>(key >> 32)};
+  fCounter = {0, 0, 0, 0};
+  fOutput = {0, 0, 0, 0};
+  fIndex = 4;
+}
+
+void GatePhiloxEngine::NextBlock() {
+  fOutput = Philox(fCounter, fKey);
+  fIndex = 0;
+  IncrementCounter();
+}
+
+void GatePhiloxEngine::IncrementCounter() {
+  // 48 bits position (first word and low half of the second word)
+  if (++fCounter[0] == 0)
+    fCounter[1] = (fCounter[1] & 0xFFFF0000) | ((fCounter[1] + 1) & 0xFFFF);
+}
+
+double GatePhiloxEngine::flat() {
+  // two words per double
+  if (fIndex > 2)
+    NextBlock();
+  auto r = ToDouble(fOutput[fIndex], fOutput[fIndex + 1]);
+  fIndex += 2;
+  return r;
+}
+
+void GatePhiloxEngine::flatArray(const int size, double *vect) {
+  int i = 0;
+  // end of the current block
+  while (i < size && fIndex < 4)
+    vect[i++] = flat();
+  // whole blocks
+  while (i + 1 < size) {
+    auto out = Philox(fCounter, fKey);
+    IncrementCounter();
+    vect[i++] = ToDouble(out[0], out[1]);
+    vect[i++] = ToDouble(out[2], out[3]);
+  }
+  if (i < size)
+    vect[i] = flat();
+}
+
+void GatePhiloxEngine::setSeed(long seed, int) {
+  theSeed = seed;
+  SetKey(static_cast<std::uint64_t>(seed));
+}
+
+void GatePhiloxEngine::setSeeds(const long *seeds, int) {
+  if (seeds == nullptr || seeds[0] == 0)
+    return;
+  theSeed = seeds[0];
+  std::uint64_t key = static_cast<std::uint32_t>(seeds[0]);
+  if (seeds[1] != 0)
+    key |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(seeds[1]))
+           << 32;
+  SetKey(key);
+}
+
+void GatePhiloxEngine::SetStream(std::uint64_t seed, int run_id,
+                                 std::uint64_t event, std::uint16_t stream) {
+  SetKey(seed);
+  theSeed = static_cast<long>(seed);
+  fCounter[1] = static_cast<std::uint32_t>(stream) << 16;
+  fCounter[2] = static_cast<std::uint32_t>(event);
+  fCounter[3] = (static_cast<std::uint32_t>(event >> 32) << 24) |
+                (static_cast<std::uint32_t>(run_id) & 0xFFFFFF);
+}
+
+GatePhiloxEngine::operator unsigned int() {
+  if (fIndex >= 4)
+    NextBlock();
+  return fOutput[fIndex++];
+}
+
+std::string GatePhiloxEngine::name() const { return engineName(); }
+
+std::vector<unsigned long> GatePhiloxEngine::put() const {
+  std::vector<unsigned long> v;
+  v.reserve(kVectorSize);
+  v.push_back(CLHEP::engineIDulong<GatePhiloxEngine>());
+  v.insert(v.end(), fKey.begin(), fKey.end());
+  v.insert(v.end(), fCounter.begin(), fCounter.end());
+  v.insert(v.end(), fOutput.begin(), fOutput.end());
+  v.push_back(fIndex);
+  return v;
+}
+
+bool GatePhiloxEngine::get(const std::vector<unsigned long> &v) {
+  if (v.empty() || v[0] != CLHEP::engineIDulong<GatePhiloxEngine>()) {
+    std::cerr << "GatePhiloxEngine get: the state is not a Philox state"
+              << std::endl;
+    return false;
+  }
+  return getState(v);
+}
+
+bool GatePhiloxEngine::getState(const std::vector<unsigned long> &v) {
+  if (v.size() != kVectorSize) {
+    std::cerr << "GatePhiloxEngine getState: wrong size " << v.size()
+              << " instead of " << kVectorSize << std::endl;
+    return false;
+  }
+  size_t i = 1;
+  for (auto &k : fKey)
+    k = static_cast<std::uint32_t>(v[i++]);
+  for (auto &c : fCounter)
+    c = static_cast<std::uint32_t>(v[i++]);
+  for (auto &o : fOutput)
+    o = static_cast<std::uint32_t>(v[i++]);
+  fIndex = std::min(4u, static_cast<unsigned int>(v[i]));
+  return true;
+}
+
+std::ostream &GatePhiloxEngine::put(std::ostream &os) const {
+  os << engineName() << "-begin\n";
+  for (auto x : put())
+    os << x << "\n";
+  os << engineName() << "-end\n";
+  return os;
+}
+
+std::istream &GatePhiloxEngine::get(std::istream &is) {
+  std::string tag;
+  is >> tag;
+  if (tag != engineName() + "-begin") {
+    is.clear(std::ios::badbit | is.rdstate());
+    std::cerr << "GatePhiloxEngine get: the stream is not a Philox state"
+              << std::endl;
+    return is;
+  }
+  return getState(is);
+}
+
+std::istream &GatePhiloxEngine::getState(std::istream &is) {
+  std::vector<unsigned long> v(kVectorSize);
+  for (auto &x : v)
+    is >> x;
+  std::string tag;
+  is >> tag;
+  if (!is || tag != engineName() + "-end" || !getState(v))
+    is.clear(std::ios::badbit | is.rdstate());
+  return is;
+}
+
+void GatePhiloxEngine::saveStatus(const char filename[]) const {
+  std::ofstream os(filename, std::ios::out);
+  if (!os.bad())
+    put(os);
+}
+
+void GatePhiloxEngine::restoreStatus(const char filename[]) {
+  std::ifstream is(filename, std::ios::in);
+  if (!is) {
+    std::cerr << "GatePhiloxEngine restoreStatus: cannot open " << filename
+              << std::endl;
+    return;
+  }
+  get(is);
+}
+
+void GatePhiloxEngine::showStatus() const {
+  std::cout << "----- " << engineName() << " status -----" << std::endl
+            << " key     = " << fKey[0] << " " << fKey[1] << std::endl
+            << " counter = " << fCounter[0] << " " << fCounter[1] << " "
+            << fCounter[2] << " " << fCounter[3] << std::endl
+            << "----------------------------------------" << std::endl;
+}
@@ -0,0 +1,102 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePhiloxEngine_h
+#define GatePhiloxEngine_h
+
+#include "CLHEP/Random/RandomEngine.h"
+#include <array>
+#include <cstdint>
+
+/*
+    Counter-based random engine Philox4x32-10 (Salmon et al., "Parallel
+    random numbers: as easy as 1, 2, 3", SC11), option random_engine =
+    "Philox" of the Simulation.
+
+    The numbers are a function of a key (the seed) and of a counter: there is
+    no state to advance, any stream can be started in O(1) and the streams
+    are independent. The counter holds the position in the stream, a stream
+    number, the event and the run (see SetStream): with the guided
+    scheduling, the events are simulated with the same numbers whatever the
+    thread and the number of threads. Each call of the block function gives
+    two doubles, with a few multiplications only (faster than MixMax for
+    bulk generation, see flatArray).
+
+    The workers engines are created by GateWorkerThreadInitialization
+    (Geant4 only knows how to clone its own engines).
+ */
+
+class GatePhiloxEngine : public CLHEP::HepRandomEngine {
+public:
+  GatePhiloxEngine();
+
+  explicit GatePhiloxEngine(long seed);
+
+  ~GatePhiloxEngine() override = default;
+
+  double flat() override;
+
+  void flatArray(const int size, double *vect) override;
+
+  // key = seed, counter = 0
+  void setSeed(long seed, int) override;
+
+  // key = the two first seeds (zero terminated, as G4 workers do)
+  void setSeeds(const long *seeds, int) override;
+
+  // Start the stream of an event: key = seed, counter = (0, stream, event,
+  // run). Events up to 2^40 per run, runs up to 2^24.
+  void SetStream(std::uint64_t seed, int run_id, std::uint64_t event,
+                 std::uint16_t stream = 0);
+
+  void saveStatus(const char filename[] = "Philox.conf") const override;
+
+  void restoreStatus(const char filename[] = "Philox.conf") override;
+
+  void showStatus() const override;
+
+  std::string name() const override;
+
+  static std::string engineName() { return "GatePhiloxEngine"; }
+
+  // state as a vector (used by the checkpoints)
+  std::vector<unsigned long> put() const override;
+
+  bool get(const std::vector<unsigned long> &v) override;
+
+  bool getState(const std::vector<unsigned long> &v) override;
+
+  std::ostream &put(std::ostream &os) const override;
+
+  std::istream &get(std::istream &is) override;
+
+  std::istream &getState(std::istream &is) override;
+
+  operator double() override { return flat(); }
+
+  operator float() override { return float(flat()); }
+
+  operator unsigned int() override;
+
+protected:
+  // fill fOutput from the counter, then increment the counter
+  void NextBlock();
+
+  void IncrementCounter();
+
+  void SetKey(std::uint64_t key);
+
+  static constexpr unsigned int kVectorSize = 12;
+
+  std::array<std::uint32_t, 2> fKey;
+  std::array<std::uint32_t, 4> fCounter;
+  std::array<std::uint32_t, 4> fOutput;
+  // next word of fOutput (4: block consumed)
+  unsigned int fIndex;
+};
+
+#endif // GatePhiloxEngine_h
@@ -0,0 +1,103 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePrimaryBatch_h
+#define GatePrimaryBatch_h
+
+#include "G4ThreeVector.hh"
+#include <cstddef>
+#include <vector>
+
+/*
+    Properties of a batch of primary particles (structure of arrays),
+    generated in bulk by a source and then used one per event.
+    See GateVSource::GeneratePrimaryBatch.
+ */
+
+class GatePrimaryBatch {
+public:
+  // Allocate n primaries, none of them is available until filled (pairs:
+  // also the direction of the second particle, e.g. back to back photons)
+  void Resize(size_t n, bool pairs = false);
+
+  // Set the number of filled primaries, the next one is the first
+  void SetFilled(size_t n) {
+    fSize = n;
+    fNext = 0;
+  }
+
+  // Remaining primaries are discarded (e.g. when the source moves)
+  void Clear() { SetFilled(0); }
+
+  bool IsEmpty() const { return fNext >= fSize; }
+
+  // Index of the next primary (then consumed)
+  size_t Next() { return fNext++; }
+
+  G4ThreeVector GetPosition(size_t i) const {
+    return {fPositionX[i], fPositionY[i], fPositionZ[i]};
+  }
+
+  G4ThreeVector GetDirection(size_t i) const {
+    return {fDirectionX[i], fDirectionY[i], fDirectionZ[i]};
+  }
+
+  void SetPosition(size_t i, const G4ThreeVector &p) {
+    fPositionX[i] = p.x();
+    fPositionY[i] = p.y();
+    fPositionZ[i] = p.z();
+  }
+
+  void SetDirection(size_t i, const G4ThreeVector &d) {
+    fDirectionX[i] = d.x();
+    fDirectionY[i] = d.y();
+    fDirectionZ[i] = d.z();
+  }
+
+  G4ThreeVector GetDirection2(size_t i) const {
+    return {fDirection2X[i], fDirection2Y[i], fDirection2Z[i]};
+  }
+
+  void SetDirection2(size_t i, const G4ThreeVector &d) {
+    fDirection2X[i] = d.x();
+    fDirection2Y[i] = d.y();
+    fDirection2Z[i] = d.z();
+  }
+
+  std::vector<double> fPositionX;
+  std::vector<double> fPositionY;
+  std::vector<double> fPositionZ;
+  std::vector<double> fDirectionX;
+  std::vector<double> fDirectionY;
+  std::vector<double> fDirectionZ;
+  std::vector<double> fEnergy;
+  std::vector<double> fDirection2X;
+  std::vector<double> fDirection2Y;
+  std::vector<double> fDirection2Z;
+
+protected:
+  size_t fSize = 0;
+  size_t fNext = 0;
+};
+
+inline void GatePrimaryBatch::Resize(size_t n, bool pairs) {
+  fPositionX.resize(n);
+  fPositionY.resize(n);
+  fPositionZ.resize(n);
+  fDirectionX.resize(n);
+  fDirectionY.resize(n);
+  fDirectionZ.resize(n);
+  fEnergy.resize(n);
+  if (pairs) {
+    fDirection2X.resize(n);
+    fDirection2Y.resize(n);
+    fDirection2Z.resize(n);
+  }
+  Clear();
+}
+
+#endif // GatePrimaryBatch_h
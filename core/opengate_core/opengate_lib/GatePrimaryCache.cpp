@@ -0,0 +1,225 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePrimaryCache.h"
+#include "G4IonTable.hh"
+#include "G4ParticleTable.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "GateHelpers.h"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+// file header: magic word and version of the format
+const char kMagic[8] = {'G', 'A', 'T', 'E', 'P', 'R', 'I', 'M'};
+const std::uint32_t kVersion = 1;
+
+// sizes (in bytes) of the records
+// event: run id, time, number of vertices
+const size_t kEventSize = 2 * sizeof(std::int32_t) + sizeof(double);
+// vertex: position, time, weight, number of primaries
+const size_t kVertexSize = 5 * sizeof(double) + sizeof(std::int32_t);
+// primary: pdg code, energy, direction, charge, weight
+const size_t kPrimarySize = sizeof(std::int32_t) + 6 * sizeof(double);
+
+template <typename T> void Write(std::string &buffer, T value) {
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> T Read(const char *&p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return value;
+}
+
+} // namespace
+
+GatePrimaryCache::GatePrimaryCache() {
+  fRecording = false;
+  fReplaying = false;
+  fNumberOfEvents = 0;
+}
+
+GatePrimaryCache::~GatePrimaryCache() { Close(); }
+
+void GatePrimaryCache::OpenForRecording(const std::string &filename) {
+  fFilename = filename;
+  fFile.open(filename, std::ios::binary | std::ios::trunc);
+  if (!fFile) {
+    std::ostringstream oss;
+    oss << "GatePrimaryCache: cannot write the file '" << filename << "'";
+    Fatal(oss.str());
+  }
+  fFile.write(kMagic, sizeof(kMagic));
+  fFile.write(reinterpret_cast<const char *>(&kVersion), sizeof(kVersion));
+  fNumberOfEvents = 0;
+  fRecording = true;
+}
+
+void GatePrimaryCache::OpenForReplay(const std::string &filename) {
+  fFilename = filename;
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file) {
+    std::ostringstream oss;
+    oss << "GatePrimaryCache: cannot read the file '" << filename << "'";
+    Fatal(oss.str());
+  }
+  auto size = static_cast<size_t>(file.tellg());
+  fData.resize(size);
+  file.seekg(0);
+  file.read(fData.data(), static_cast<std::streamsize>(size));
+
+  // check the header
+  const size_t header = sizeof(kMagic) + sizeof(kVersion);
+  std::uint32_t version = 0;
+  if (size >= header)
+    std::memcpy(&version, fData.data() + sizeof(kMagic), sizeof(version));
+  if (size < header || std::memcmp(fData.data(), kMagic, sizeof(kMagic)) ||
+      version != kVersion) {
+    std::ostringstream oss;
+    oss << "GatePrimaryCache: '" << filename
+        << "' is not a cache of primaries (or another version)";
+    Fatal(oss.str());
+  }
+
+  // index of the events, per run
+  fOffsets.clear();
+  fRuns.clear();
+  size_t offset = header;
+  auto truncated = [&]() {
+    std::ostringstream oss;
+    oss << "GatePrimaryCache: the file '" << filename << "' is truncated";
+    Fatal(oss.str());
+  };
+  while (offset < size) {
+    if (offset + kEventSize > size)
+      truncated();
+    const char *p = fData.data() + offset;
+    auto run_id = Read<std::int32_t>(p);
+    Read<double>(p);
+    auto n = Read<std::int32_t>(p);
+    size_t end = offset + kEventSize;
+    for (int i = 0; i < n; i++) {
+      if (end + kVertexSize > size)
+        truncated();
+      p = fData.data() + end + kVertexSize - sizeof(std::int32_t);
+      auto np = Read<std::int32_t>(p);
+      end += kVertexSize + np * kPrimarySize;
+    }
+    if (end > size)
+      truncated();
+    fRuns[run_id].fEvents.push_back(static_cast<long>(fOffsets.size()));
+    fOffsets.push_back(offset);
+    offset = end;
+  }
+  fNumberOfEvents = fOffsets.size();
+  fReplaying = true;
+}
+
+void GatePrimaryCache::Close() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (fFile.is_open())
+    fFile.close();
+}
+
+void GatePrimaryCache::Record(int run_id, double time, const G4Event *event) {
+  // the event is serialized without the lock
+  std::string buffer;
+  auto n = event->GetNumberOfPrimaryVertex();
+  Write<std::int32_t>(buffer, run_id);
+  Write<double>(buffer, time);
+  Write<std::int32_t>(buffer, n);
+  for (int i = 0; i < n; i++) {
+    const auto *vertex = event->GetPrimaryVertex(i);
+    Write<double>(buffer, vertex->GetX0());
+    Write<double>(buffer, vertex->GetY0());
+    Write<double>(buffer, vertex->GetZ0());
+    Write<double>(buffer, vertex->GetT0());
+    Write<double>(buffer, vertex->GetWeight());
+    Write<std::int32_t>(buffer, vertex->GetNumberOfParticle());
+    for (int j = 0; j < vertex->GetNumberOfParticle(); j++) {
+      const auto *particle = vertex->GetPrimary(j);
+      const auto &d = particle->GetMomentumDirection();
+      Write<std::int32_t>(buffer, particle->GetPDGcode());
+      Write<double>(buffer, particle->GetKineticEnergy());
+      Write<double>(buffer, d.x());
+      Write<double>(buffer, d.y());
+      Write<double>(buffer, d.z());
+      Write<double>(buffer, particle->GetCharge());
+      Write<double>(buffer, particle->GetWeight());
+    }
+  }
+  std::lock_guard<std::mutex> lock(fMutex);
+  fFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  fNumberOfEvents++;
+}
+
+long GatePrimaryCache::Next(int run_id) {
+  auto it = fRuns.find(run_id);
+  if (it == fRuns.end())
+    return -1;
+  auto &run = it->second;
+  auto i = run.fNext.fetch_add(1);
+  if (i >= run.fEvents.size())
+    return -1;
+  return run.fEvents[i];
+}
+
+double GatePrimaryCache::GetTime(long index) const {
+  const char *p = fData.data() + fOffsets[index] + sizeof(std::int32_t);
+  return Read<double>(p);
+}
+
+void GatePrimaryCache::Replay(long index, G4Event *event) const {
+  auto *particle_table = G4ParticleTable::GetParticleTable();
+  const char *p = fData.data() + fOffsets[index] + sizeof(std::int32_t);
+  Read<double>(p);
+  auto n = Read<std::int32_t>(p);
+  for (int i = 0; i < n; i++) {
+    auto x = Read<double>(p);
+    auto y = Read<double>(p);
+    auto z = Read<double>(p);
+    auto t = Read<double>(p);
+    auto *vertex = new G4PrimaryVertex(x, y, z, t);
+    vertex->SetWeight(Read<double>(p));
+    auto np = Read<std::int32_t>(p);
+    for (int j = 0; j < np; j++) {
+      auto pdg = Read<std::int32_t>(p);
+      auto *definition = particle_table->FindParticle(pdg);
+      // if not found, it may be an ion
+      if (definition == nullptr)
+        definition = particle_table->GetIonTable()->GetIon(pdg);
+      if (definition == nullptr) {
+        std::ostringstream oss;
+        oss << "GatePrimaryCache: PDGCode " << pdg << " not found in '"
+            << fFilename << "'";
+        Fatal(oss.str());
+      }
+      auto *particle = new G4PrimaryParticle(definition);
+      particle->SetKineticEnergy(Read<double>(p));
+      auto dx = Read<double>(p);
+      auto dy = Read<double>(p);
+      auto dz = Read<double>(p);
+      particle->SetMomentumDirection(G4ThreeVector(dx, dy, dz));
+      particle->SetCharge(Read<double>(p));
+      particle->SetWeight(Read<double>(p));
+      vertex->SetPrimary(particle);
+    }
+    event->AddPrimaryVertex(vertex);
+  }
+}
+
+unsigned long GatePrimaryCache::GetNumberOfEvents(int run_id) const {
+  auto it = fRuns.find(run_id);
+  if (it == fRuns.end())
+    return 0;
+  return it->second.fEvents.size();
+}
@@ -0,0 +1,88 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GatePrimaryCache_h
+#define GatePrimaryCache_h
+
+#include <G4Event.hh>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    Binary cache of the primaries of a simulation (see GateSourceManager).
+
+    Record: the primary vertices of each event (position, time, weight) and
+    their primary particles (PDG code, kinetic energy, direction, charge,
+    weight) are appended to the file, with the run id and the time of the
+    event. All the threads write in the same file.
+
+    Replay: the whole file is read in memory, then the threads take the
+    events of the current run one after the other (shared counter), so the
+    events are replayed once, whatever the number of threads. The sources
+    are not used anymore.
+ */
+
+class GatePrimaryCache {
+public:
+  GatePrimaryCache();
+
+  ~GatePrimaryCache();
+
+  void OpenForRecording(const std::string &filename);
+
+  void OpenForReplay(const std::string &filename);
+
+  // Write the remaining data and close the file (recording)
+  void Close();
+
+  bool IsRecording() const { return fRecording; }
+
+  bool IsReplaying() const { return fReplaying; }
+
+  // [recording] append the primaries of the event (thread safe)
+  void Record(int run_id, double time, const G4Event *event);
+
+  // [replay] reserve the next event of the run, return -1 if none
+  long Next(int run_id);
+
+  // [replay] time of a reserved event
+  double GetTime(long index) const;
+
+  // [replay] add the primary vertices of a reserved event to the G4 event
+  void Replay(long index, G4Event *event) const;
+
+  unsigned long GetNumberOfRecordedEvents() const { return fNumberOfEvents; }
+
+  unsigned long GetNumberOfEvents(int run_id) const;
+
+protected:
+  struct RunEvents {
+    std::vector<long> fEvents; // indices of the events of the run
+    std::atomic<size_t> fNext{0};
+  };
+
+  std::string fFilename;
+  bool fRecording;
+  bool fReplaying;
+
+  // recording
+  std::ofstream fFile;
+  std::mutex fMutex;
+  unsigned long fNumberOfEvents;
+
+  // replay
+  std::vector<char> fData;
+  std::map<int, RunEvents> fRuns;
+  std::vector<size_t> fOffsets; // position of each event in fData
+};
+
+#endif // GatePrimaryCache_h
@@ -6,10 +6,37 @@
    -------------------------------------------------- */
 
 #include "GatePrimaryScatterFilter.h"
-#include "G4RunManager.hh"
+#include "G4Event.hh"
+#include "G4EventManager.hh"
 #include "G4Step.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
+#include <vector>
+
+namespace {
+// Primaries of the current event of the thread that have already scattered
+// (indexed by track id): they are not compared again at the next steps
+struct PrimaryScatterState {
+  const G4Event *fEvent = nullptr;
+  G4int fEventID = -1;
+  std::vector<char> fScattered;
+};
+
+G4ThreadLocal PrimaryScatterState *gPrimaryScatterState = nullptr;
+
+PrimaryScatterState &GetPrimaryScatterState(const G4Event *event) {
+  if (gPrimaryScatterState == nullptr)
+    gPrimaryScatterState = new PrimaryScatterState;
+  auto &state = *gPrimaryScatterState;
+  // new event: the capacity is kept
+  if (event != state.fEvent || event->GetEventID() != state.fEventID) {
+    state.fEvent = event;
+    state.fEventID = event->GetEventID();
+    state.fScattered.clear();
+  }
+  return state;
+}
+} // namespace
 
 int IsUnscatteredPrimary(const G4Step *step) {
   /*
@@ -17,35 +44,45 @@ int IsUnscatteredPrimary(const G4Step *step) {
   step.
   - momentum : direction and energy
   - particles that are not primary are considered as "scatter"
+  - all the primaries of the event are considered (e.g. back to back)
   */
-  if (step->GetTrack()->GetParentID() > 0)
+  const auto *track = step->GetTrack();
+  if (track->GetParentID() > 0)
     return 0;
-  if (step->GetTrack()->GetTrackID() != 1)
+  const auto *event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  auto &state = GetPrimaryScatterState(event);
+  auto track_id = static_cast<size_t>(track->GetTrackID());
+  if (track_id < state.fScattered.size() && state.fScattered[track_id])
     return 0;
-  auto *dp = step->GetTrack()->GetDynamicParticle();
+  auto *dp = track->GetDynamicParticle();
   if (dp->GetPrimaryParticle() == nullptr) {
     Fatal("Error in IsUnscatteredPrimary, no DynamicParticle?");
     return -1;
   }
   auto event_mom = dp->GetPrimaryParticle()->GetMomentum();
   auto track_mom = step->GetPreStepPoint()->GetMomentum();
-  return (event_mom.isNear(track_mom));
+  if (event_mom.isNear(track_mom))
+    return 1;
+  // (the momentum cannot be the initial one again)
+  if (track_id >= state.fScattered.size())
+    state.fScattered.resize(track_id + 1, 0);
+  state.fScattered[track_id] = 1;
+  return 0;
 }
 
 void GateUnscatteredPrimaryFilter::InitializeUserInfo(py::dict &user_info) {
   fPolicy = DictGetStr(user_info, "policy");
+  if (fPolicy != "accept" && fPolicy != "reject") {
+    std::ostringstream oss;
+    oss << "The policy '" << fPolicy
+        << "' for the ScatterFilter is unknown."
+           " Use 'accept' or 'reject'";
+    Fatal(oss.str());
+  }
+  fAcceptUnscattered = fPolicy == "accept";
 }
 
 bool GateUnscatteredPrimaryFilter::Accept(G4Step *step) const {
   auto b = IsUnscatteredPrimary(step);
-  if (fPolicy == "accept")
-    return b == 1;
-  if (fPolicy == "reject")
-    return b == 0;
-  std::ostringstream oss;
-  oss << "The policy '" << fPolicy
-      << "' for the ScatterFilter is unknown."
-         " Use 'accept' or 'reject'";
-  Fatal(oss.str());
-  return false;
+  return fAcceptUnscattered ? b == 1 : b == 0;
 }
@@ -26,7 +26,10 @@ public:
 
   bool Accept(G4Step *step) const override;
 
+  int GetCost() const override { return 2; }
+
   std::string fPolicy;
+  bool fAcceptUnscattered = true;
 };
 
 int IsUnscatteredPrimary(const G4Step *step);
@@ -23,9 +23,10 @@
 #include "G4ParticleTable.hh"
 #include "G4Positron.hh"
 #include "G4Proton.hh"
+#include "GateMutex.h"
 
 // Mutex that will be used by thread to write in the values to the image
-G4Mutex SetProdStopPixelMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetProdStopPixelMutex);
 
 GateProductionAndStoppingActor::GateProductionAndStoppingActor(
     py::dict &user_info)
@@ -33,6 +34,10 @@ GateProductionAndStoppingActor::GateProductionAndStoppingActor(
   // Action for this actor: during stepping
   fActions.insert("SteppingAction");
   fActions.insert("PostUserTrackingAction");
+  fActions.insert("BeginOfRunAction");
+  fActions.insert("EndOfRunAction");
+  // the stopping image only needs the tracks that end in the volume
+  fTrackingActionsInVolumesOnly = true;
 }
 
 void GateProductionAndStoppingActor::InitializeUserInfo(py::dict &user_info) {
@@ -51,7 +56,42 @@ void GateProductionAndStoppingActor::InitializeUserInfo(py::dict &user_info) {
 
   fInitialTranslation = DictGetG4ThreeVector(user_info, "translation");
   // Hit type (random, pre, post etc)
-  fHitType = DictGetStr(user_info, "hit_type");
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+  // the hit position function is resolved once, not at every step
+  switch (fHitType) {
+  case HitType::Pre:
+    fHitPosition = &GetHitPosition<HitType::Pre>;
+    break;
+  case HitType::Post:
+    fHitPosition = &GetHitPosition<HitType::Post>;
+    break;
+  case HitType::Middle:
+    fHitPosition = &GetHitPosition<HitType::Middle>;
+    break;
+  case HitType::Random:
+    fHitPosition = &GetHitPosition<HitType::Random>;
+    break;
+  case HitType::Segment:
+    Fatal("Error in GateProductionAndStoppingActor: hit_type 'segment' is not "
+          "available, use 'pre', 'post', 'middle' or 'random'.");
+    break;
+  }
+
+  // Scoring mode: shared image (mutex or atomic) or per-thread images
+  auto mode = DictGetStr(user_info, "scoring_mode");
+  if (mode == "mutex")
+    fScoringMode = ScoringMode::Mutex;
+  else if (mode == "thread_local")
+    fScoringMode = ScoringMode::ThreadLocal;
+  else if (mode == "atomic")
+    fScoringMode = ScoringMode::Atomic;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateProductionAndStoppingActor: unknown scoring_mode. "
+           "Must be 'mutex', 'thread_local' or 'atomic'"
+        << " while '" << mode << "' is read.";
+    Fatal(oss.str());
+  }
 }
 
 void GateProductionAndStoppingActor::InitializeCpp() {
@@ -64,11 +104,34 @@ void GateProductionAndStoppingActor::BeginOfRunActionMasterThread(int run_id) {
   // Important ! The volume may have moved, so we re-attach each run
   AttachImageToVolume<ImageType>(cpp_value_image, fPhysicalVolumeName,
                                  fInitialTranslation);
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(cpp_value_image.GetPointer());
   // compute volume of a dose voxel
   auto sp = cpp_value_image->GetSpacing();
   fVoxelVolume = sp[0] * sp[1] * sp[2];
 }
 
+void GateProductionAndStoppingActor::BeginOfRunAction(const G4Run *) {
+  if (fScoringMode == ScoringMode::ThreadLocal) {
+    auto region = cpp_value_image->GetLargestPossibleRegion();
+    fThreadLocalData.Get().value_worker_flatimg.assign(
+        region.GetNumberOfPixels(), 0.0);
+  }
+}
+
+void GateProductionAndStoppingActor::EndOfRunAction(const G4Run *) {
+  if (fScoringMode != ScoringMode::ThreadLocal)
+    return;
+  // the flat buffer has the same memory layout as the itk image
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&SetProdStopPixelMutex);
+  auto *buffer = cpp_value_image->GetBufferPointer();
+  for (size_t i = 0; i < l.value_worker_flatimg.size(); i++)
+    buffer[i] += l.value_worker_flatimg[i];
+  l.value_worker_flatimg.clear();
+  l.value_worker_flatimg.shrink_to_fit();
+}
+
 void GateProductionAndStoppingActor::SteppingAction(G4Step *step) {
   //
   if (fProductionImageEnabled) {
@@ -86,42 +149,23 @@ void GateProductionAndStoppingActor::PostUserTrackingAction(
 }
 
 void GateProductionAndStoppingActor::AddValueToImage(const G4Step *step) {
-  auto preGlobal = step->GetPreStepPoint()->GetPosition();
-  auto postGlobal = step->GetPostStepPoint()->GetPosition();
-  auto touchable = step->GetPreStepPoint()->GetTouchable();
-
-  // consider random position between pre and post
-  auto position = postGlobal;
-  if (fHitType == "pre") {
-    position = preGlobal;
-  }
-  if (fHitType == "random") {
-    auto x = G4UniformRand();
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + x * direction;
-  }
-  if (fHitType == "middle") {
-    auto direction = postGlobal - preGlobal;
-    position = preGlobal + 0.5 * direction;
-  }
-  auto localPosition =
-      touchable->GetHistory()->GetTransform(0).TransformPoint(position);
-
-  // convert G4ThreeVector to itk PointType
-  ImageType::PointType point;
-  point[0] = localPosition[0];
-  point[1] = localPosition[1];
-  point[2] = localPosition[2];
+  // pre, post, middle or random position
+  auto position = fHitPosition(step);
 
-  // get pixel index
+  // get pixel index (the image is placed in the world frame)
   ImageType::IndexType index;
-  bool isInside = cpp_value_image->TransformPhysicalPointToIndex(point, index);
+  bool isInside = fIndexTransform.TransformPointToIndex(position, index);
 
   // set value
   if (isInside) {
     auto w = step->GetTrack()->GetWeight();
-    {
-      G4AutoLock mutex(&SetProdStopPixelMutex);
+    if (fScoringMode == ScoringMode::ThreadLocal) {
+      auto offset = cpp_value_image->ComputeOffset(index);
+      fThreadLocalData.Get().value_worker_flatimg[offset] += w;
+    } else if (fScoringMode == ScoringMode::Atomic) {
+      ImageAtomicAddValue<ImageType>(cpp_value_image, index, w);
+    } else {
+      GateAutoLock mutex(&SetProdStopPixelMutex);
       ImageAddValue<ImageType>(cpp_value_image, index, w);
     }
   } // else : outside the image
@@ -12,6 +12,7 @@
 #include "G4EmCalculator.hh"
 #include "G4NistManager.hh"
 #include "G4VPrimitiveScorer.hh"
+#include "GateHelpersImage.h"
 #include "GateVActor.h"
 #include "itkImage.h"
 #include <pybind11/stl.h>
@@ -21,6 +22,9 @@ namespace py = pybind11;
 class GateProductionAndStoppingActor : public GateVActor {
 
 public:
+  // How the counts are accumulated in the shared image
+  enum ScoringMode { Mutex, ThreadLocal, Atomic };
+
   // Constructor
   GateProductionAndStoppingActor(py::dict &user_info);
 
@@ -31,9 +35,13 @@ public:
   // Main function called every step in attached volume
   void SteppingAction(G4Step *) override;
 
+  void BeginOfRunActionMasterThread(int run_id) override;
+
   // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
 
-  void BeginOfRunActionMasterThread(int run_id) override;
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
 
   // Called every time a Track ends
   void PostUserTrackingAction(const G4Track *track) override;
@@ -62,7 +70,18 @@ private:
   double fVoxelVolume;
 
   G4ThreeVector fInitialTranslation;
-  std::string fHitType;
+  HitType fHitType = HitType::Random;
+  G4ThreeVector (*fHitPosition)(const G4Step *){};
+  GateImageIndexTransform fIndexTransform;
+
+  // Option: mutex, per-thread images or lock-free atomic additions
+  ScoringMode fScoringMode = ScoringMode::Mutex;
+
+  struct threadLocalT {
+    // per-thread copy of the image (ThreadLocal scoring mode only)
+    std::vector<double> value_worker_flatimg;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
 };
 
 #endif // GateProductionAndStoppingActor_h
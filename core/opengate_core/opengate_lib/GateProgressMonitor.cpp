@@ -0,0 +1,275 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateProgressMonitor.h"
+#include "G4Threading.hh"
+#include "indicators.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+GateProgressMonitor *GateProgressMonitor::fInstance = nullptr;
+std::atomic<bool> GateProgressMonitor::fActive{false};
+std::atomic<int> GateProgressMonitor::fCurrentRun{0};
+std::atomic<double> GateProgressMonitor::fUncertainty{-1};
+std::atomic<unsigned long> GateProgressMonitor::fOutputBytes{0};
+
+namespace {
+// events, tracks, steps
+const char *kCountNames[3] = {"events", "tracks", "steps"};
+
+bool IsPrometheusFilename(const std::string &filename) {
+  const std::string ext = ".prom";
+  return filename.size() >= ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+} // namespace
+
+GateProgressMonitor *GateProgressMonitor::GetInstance() {
+  static std::once_flag once;
+  std::call_once(once, []() { fInstance = new GateProgressMonitor(); });
+  return fInstance;
+}
+
+GateProgressMonitor::GateProgressMonitor() {
+  fGeneration = 0;
+  fStopRequested = false;
+  fExpectedEvents = 0;
+  fBarFlag = false;
+  fInterval = 1;
+  std::fill(fTotals, fTotals + 3, 0);
+  std::fill(fRates, fRates + 3, 0);
+  fPreviousTime = 0;
+  fBar = nullptr;
+}
+
+GateProgressMonitor::Counters &GateProgressMonitor::GetCounters() {
+  static G4ThreadLocal Counters *counters = nullptr;
+  static G4ThreadLocal int generation = -1;
+  auto current = fGeneration.load(std::memory_order_acquire);
+  if (generation != current) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCounters.emplace_back();
+    counters = &fCounters.back();
+    counters->fThreadId = G4Threading::G4GetThreadId();
+    generation = current;
+  }
+  return *counters;
+}
+
+void GateProgressMonitor::Start(unsigned long expected_events, bool bar,
+                                const std::string &filename,
+                                double interval) {
+  Stop();
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCounters.clear();
+    fGeneration++;
+    fStopRequested = false;
+    fExpectedEvents = expected_events;
+    fBarFlag = bar;
+    fFilename = filename;
+    fInterval = interval > 0 ? interval : 1;
+    std::fill(fTotals, fTotals + 3, 0);
+    std::fill(fRates, fRates + 3, 0);
+    fPreviousTime = 0;
+  }
+  fCurrentRun = 0;
+  fUncertainty = -1;
+  fOutputBytes = 0;
+  if (fBarFlag) {
+    using namespace indicators;
+    auto n = static_cast<size_t>(std::max(fExpectedEvents, 1ul));
+    fBar = new ProgressBar{option::BarWidth{50},
+                           option::Start{""},
+                           option::Fill{"■"},
+                           option::Lead{"■"},
+                           option::End{""},
+                           option::ShowElapsedTime{true},
+                           option::ShowRemainingTime{true},
+                           option::MaxProgress{n}};
+    show_console_cursor(false);
+  }
+  fActive = true;
+  fReporter = std::thread(&GateProgressMonitor::Report, this);
+}
+
+void GateProgressMonitor::Stop() {
+  if (!fReporter.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStopRequested = true;
+  }
+  fCondition.notify_one();
+  fReporter.join();
+  fActive = false;
+  if (fBar != nullptr) {
+    delete fBar;
+    fBar = nullptr;
+    indicators::show_console_cursor(true);
+  }
+}
+
+unsigned long GateProgressMonitor::GetNumberOfEvents() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  unsigned long n = 0;
+  for (const auto &c : fCounters)
+    n += c.fEvents.load(std::memory_order_relaxed);
+  return n;
+}
+
+unsigned long GateProgressMonitor::GetNumberOfTracks() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  unsigned long n = 0;
+  for (const auto &c : fCounters)
+    n += c.fTracks.load(std::memory_order_relaxed);
+  return n;
+}
+
+void GateProgressMonitor::Report() {
+  auto start = std::chrono::steady_clock::now();
+  auto interval = std::chrono::duration<double>(fInterval);
+  std::unique_lock<std::mutex> lock(fMutex);
+  bool done = false;
+  while (!done) {
+    done = fCondition.wait_for(lock, interval,
+                               [this]() { return fStopRequested; });
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    Update(elapsed.count() - fPreviousTime);
+    if (fBar != nullptr)
+      Render(fTotals[0]);
+    if (!fFilename.empty())
+      WriteFile(elapsed.count(), done);
+    fPreviousTime = elapsed.count();
+  }
+}
+
+void GateProgressMonitor::Update(double dt) {
+  // sum the counters of all the threads, and the rates since the previous
+  // report (per thread and total)
+  unsigned long totals[3] = {0, 0, 0};
+  for (auto &c : fCounters) {
+    unsigned long v[3] = {c.fEvents.load(std::memory_order_relaxed),
+                          c.fTracks.load(std::memory_order_relaxed),
+                          c.fSteps.load(std::memory_order_relaxed)};
+    for (int i = 0; i < 3; i++) {
+      c.fRates[i] = dt > 0 ? (v[i] - c.fPrevious[i]) / dt : 0;
+      c.fPrevious[i] = v[i];
+      totals[i] += v[i];
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    fRates[i] = dt > 0 ? (totals[i] - fTotals[i]) / dt : 0;
+    fTotals[i] = totals[i];
+  }
+}
+
+void GateProgressMonitor::Render(unsigned long events) {
+  auto n = std::min(events, std::max(fExpectedEvents, 1ul));
+  fBar->set_progress(static_cast<size_t>(n));
+}
+
+void GateProgressMonitor::WriteFile(double elapsed, bool done) {
+  auto events = fTotals[0];
+  // remaining time with the mean rate since the start
+  double mean_rate = elapsed > 0 ? events / elapsed : 0;
+  double remaining = 0;
+  if (!done && mean_rate > 0 && fExpectedEvents > events)
+    remaining = (fExpectedEvents - events) / mean_rate;
+  double progress =
+      fExpectedEvents > 0 ? std::min(1.0, (double)events / fExpectedEvents)
+                          : 0;
+  if (done)
+    progress = 1;
+
+  // written in a temporary file, then renamed, so that a reader never gets
+  // a partial file
+  auto tmp = fFilename + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::trunc);
+    if (!f) {
+      // (not a Geant4 thread: no Fatal, the file is ignored)
+      std::cerr << "GateProgressMonitor: cannot write the file '" << tmp
+                << "', the progress is not reported" << std::endl;
+      fFilename.clear();
+      return;
+    }
+    if (IsPrometheusFilename(fFilename))
+      WritePrometheus(f, elapsed, progress, remaining, done);
+    else
+      WriteJson(f, elapsed, progress, remaining, done);
+  }
+  std::rename(tmp.c_str(), fFilename.c_str());
+}
+
+void GateProgressMonitor::WriteJson(std::ostream &f, double elapsed,
+                                    double progress, double remaining,
+                                    bool done) {
+  f << "{\"elapsed_time\": " << elapsed << ", \"events\": " << fTotals[0]
+    << ", \"expected_events\": " << fExpectedEvents
+    << ", \"progress\": " << progress
+    << ", \"events_per_second\": " << fRates[0]
+    << ", \"tracks\": " << fTotals[1]
+    << ", \"tracks_per_second\": " << fRates[1]
+    << ", \"steps\": " << fTotals[2]
+    << ", \"steps_per_second\": " << fRates[2]
+    << ", \"remaining_time\": " << remaining
+    << ", \"run\": " << fCurrentRun.load(std::memory_order_relaxed)
+    << ", \"uncertainty\": " << fUncertainty.load(std::memory_order_relaxed)
+    << ", \"output_bytes\": " << fOutputBytes.load(std::memory_order_relaxed)
+    << ", \"threads\": [";
+  for (auto it = fCounters.begin(); it != fCounters.end(); ++it) {
+    f << (it == fCounters.begin() ? "" : ", ") << "{\"thread\": "
+      << it->fThreadId;
+    for (int i = 0; i < 3; i++)
+      f << ", \"" << kCountNames[i] << "_per_second\": " << it->fRates[i];
+    f << "}";
+  }
+  f << "], \"done\": " << (done ? "true" : "false") << "}\n";
+}
+
+void GateProgressMonitor::WritePrometheus(std::ostream &f, double elapsed,
+                                          double progress, double remaining,
+                                          bool done) {
+  auto metric = [&f](const std::string &name, const char *type,
+                     const char *help) {
+    f << "# HELP opengate_" << name << " " << help << "\n";
+    f << "# TYPE opengate_" << name << " " << type << "\n";
+  };
+  metric("elapsed_seconds", "gauge", "Wall clock time since the start");
+  f << "opengate_elapsed_seconds " << elapsed << "\n";
+  for (int i = 0; i < 3; i++) {
+    std::string name = kCountNames[i];
+    metric(name + "_total", "counter", "Simulated (all threads)");
+    f << "opengate_" << name << "_total " << fTotals[i] << "\n";
+    metric(name + "_per_second", "gauge", "Rate since the last report");
+    f << "opengate_" << name << "_per_second " << fRates[i] << "\n";
+    for (const auto &c : fCounters)
+      f << "opengate_" << name << "_per_second{thread=\"" << c.fThreadId
+        << "\"} " << c.fRates[i] << "\n";
+  }
+  metric("expected_events", "gauge", "Expected number of events");
+  f << "opengate_expected_events " << fExpectedEvents << "\n";
+  metric("progress", "gauge", "Fraction of the expected events");
+  f << "opengate_progress " << progress << "\n";
+  metric("remaining_seconds", "gauge", "Estimated remaining time");
+  f << "opengate_remaining_seconds " << remaining << "\n";
+  metric("run", "gauge", "Current run");
+  f << "opengate_run " << fCurrentRun.load(std::memory_order_relaxed) << "\n";
+  metric("uncertainty", "gauge", "Last dose uncertainty (-1: unknown)");
+  f << "opengate_uncertainty "
+    << fUncertainty.load(std::memory_order_relaxed) << "\n";
+  metric("output_bytes_total", "counter", "Bytes written by the writers");
+  f << "opengate_output_bytes_total "
+    << fOutputBytes.load(std::memory_order_relaxed) << "\n";
+  metric("done", "gauge", "1 when the simulation is done");
+  f << "opengate_done " << (done ? 1 : 0) << "\n";
+}
@@ -0,0 +1,151 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateProgressMonitor_h
+#define GateProgressMonitor_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace indicators {
+class ProgressBar;
+}
+
+/*
+    Global singleton class that reports the progress of the simulation.
+
+    Each thread (master and workers) increments its own counters of events
+    and tracks (relaxed atomics, one cache line per thread, no lock). A
+    reporter thread, started by the master (see
+    GateSourceManager::StartMasterThread), sums the counters at a fixed wall
+    clock interval and renders the progress bar and/or writes the events/s,
+    tracks/s and the estimated remaining time in a json file, so that the
+    rendering cost is never on a Geant4 thread.
+
+    The file also gives the steps/s (counted at the end of each track, not
+    at each step), the rates of each thread, the current run, the current
+    uncertainty of the dose actor (with an uncertainty goal) and the bytes
+    written by the columnar digi writers. With the .prom extension, the file
+    is written in the Prometheus text format (e.g. for the textfile
+    collector of the node exporter) instead of json.
+ */
+
+class GateProgressMonitor {
+public:
+  static GateProgressMonitor *GetInstance();
+
+  // Start the reporter thread (master thread). The bar is not displayed if
+  // bar is false, the file is not written if filename is empty.
+  void Start(unsigned long expected_events, bool bar,
+             const std::string &filename, double interval);
+
+  // Stop the reporter thread, after a last report
+  void Stop();
+
+  // Called by the Geant4 threads (only if the monitor is started)
+  inline static void CountEvent() {
+    if (fActive.load(std::memory_order_relaxed))
+      fInstance->GetCounters().fEvents.fetch_add(
+          1, std::memory_order_relaxed);
+  }
+
+  inline static void CountTrack() {
+    if (fActive.load(std::memory_order_relaxed))
+      fInstance->GetCounters().fTracks.fetch_add(
+          1, std::memory_order_relaxed);
+  }
+
+  // Steps of a track (at the end of the track)
+  inline static void CountSteps(unsigned long n) {
+    if (fActive.load(std::memory_order_relaxed))
+      fInstance->GetCounters().fSteps.fetch_add(
+          n, std::memory_order_relaxed);
+  }
+
+  // Current run (master thread)
+  inline static void SetCurrentRun(int run) {
+    fCurrentRun.store(run, std::memory_order_relaxed);
+  }
+
+  // Mean uncertainty of the last evaluation of a dose actor
+  inline static void SetUncertainty(double u) {
+    fUncertainty.store(u, std::memory_order_relaxed);
+  }
+
+  // Bytes written in the output files
+  inline static void CountOutputBytes(unsigned long n) {
+    fOutputBytes.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  unsigned long GetNumberOfEvents();
+
+  unsigned long GetNumberOfTracks();
+
+protected:
+  GateProgressMonitor();
+
+  static GateProgressMonitor *fInstance;
+  static std::atomic<bool> fActive;
+  static std::atomic<int> fCurrentRun;
+  static std::atomic<double> fUncertainty;
+  static std::atomic<unsigned long> fOutputBytes;
+
+  struct alignas(64) Counters {
+    std::atomic<unsigned long> fEvents{0};
+    std::atomic<unsigned long> fTracks{0};
+    std::atomic<unsigned long> fSteps{0};
+    int fThreadId = 0;
+    // values and rates of the previous report (reporter thread only)
+    unsigned long fPrevious[3] = {0, 0, 0};
+    double fRates[3] = {0, 0, 0};
+  };
+
+  // Counters of the calling thread (created at its first call)
+  Counters &GetCounters();
+
+  // Loop of the reporter thread
+  void Report();
+
+  void Render(unsigned long events);
+
+  // Sum of the counters, per-thread rates (under the lock)
+  void Update(double dt);
+
+  void WriteFile(double elapsed, bool done);
+
+  void WriteJson(std::ostream &f, double elapsed, double progress,
+                 double remaining, bool done);
+
+  void WritePrometheus(std::ostream &f, double elapsed, double progress,
+                       double remaining, bool done);
+
+  std::mutex fMutex;
+  std::condition_variable fCondition;
+  // the counters are never moved (deque), and kept until the next Start
+  std::deque<Counters> fCounters;
+  // incremented by Start, the threads then take new counters
+  std::atomic<int> fGeneration;
+  std::thread fReporter;
+  bool fStopRequested;
+
+  unsigned long fExpectedEvents;
+  bool fBarFlag;
+  std::string fFilename;
+  double fInterval;
+  // totals of the last report, and their rates since the previous one
+  unsigned long fTotals[3];
+  double fRates[3];
+  double fPreviousTime;
+  indicators::ProgressBar *fBar;
+};
+
+#endif // GateProgressMonitor_h
@@ -0,0 +1,256 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateROIDoseActor.h"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "GateHelpers.h"
+#include "GateHelpersDict.h"
+#include "GateMutex.h"
+#include "GateStepContext.h"
+
+#include <algorithm>
+#include <cmath>
+
+GATE_MUTEX(ROIDoseMergeMutex);
+
+GateROIDoseActor::GateROIDoseActor(py::dict &user_info)
+    : GateVActor(user_info, true) {}
+
+void GateROIDoseActor::InitializeUserInfo(py::dict &user_info) {
+  // IMPORTANT: call the base class method
+  GateVActor::InitializeUserInfo(user_info);
+
+  fTranslation = DictGetG4ThreeVector(user_info, "translation");
+  // Hit type (random, pre, post etc), resolved once, not at every step
+  fHitType = StrToHitType(DictGetStr(user_info, "hit_type"));
+  switch (fHitType) {
+  case HitType::Pre:
+    fHitPosition = &GetHitPosition<HitType::Pre>;
+    break;
+  case HitType::Post:
+    fHitPosition = &GetHitPosition<HitType::Post>;
+    break;
+  case HitType::Middle:
+    fHitPosition = &GetHitPosition<HitType::Middle>;
+    break;
+  case HitType::Random:
+    fHitPosition = &GetHitPosition<HitType::Random>;
+    break;
+  case HitType::Segment:
+    Fatal("Error in GateROIDoseActor: hit_type 'segment' is not available, "
+          "use 'pre', 'post', 'middle' or 'random'.");
+    break;
+  }
+
+  // DVH: number of bins (0: no DVH) and upper limit in Gy (0: max voxel
+  // dose)
+  fDVHBins = DictGetInt(user_info, "dvh_bins");
+  fDVHMaxDoseOption = DictGetDouble(user_info, "dvh_max_dose") / CLHEP::gray;
+  if (fDVHBins < 0 || fDVHMaxDoseOption < 0) {
+    std::ostringstream oss;
+    oss << "Error in GateROIDoseActor: dvh_bins and dvh_max_dose cannot be "
+           "negative while "
+        << fDVHBins << " and " << fDVHMaxDoseOption << " are read.";
+    Fatal(oss.str());
+  }
+}
+
+void GateROIDoseActor::InitializeCpp() {
+  GateVActor::InitializeCpp();
+  // the size and spacing are set by SetVoxelROIs
+  if (fLabelImage.IsNull())
+    fLabelImage = Image3DType::New();
+}
+
+void GateROIDoseActor::SetVoxelROIs(const int32_t *rois, int sx, int sy,
+                                    int sz, int nb_rois,
+                                    const std::vector<double> &spacing) {
+  // geometry of the label image, without pixel buffer
+  if (fLabelImage.IsNull())
+    fLabelImage = Image3DType::New();
+  Image3DType::RegionType region;
+  Image3DType::SizeType size;
+  size[0] = sx;
+  size[1] = sy;
+  size[2] = sz;
+  region.SetSize(size);
+  fLabelImage->SetRegions(region);
+  Image3DType::SpacingType sp;
+  for (auto i = 0; i < 3; i++)
+    sp[i] = spacing[i];
+  fLabelImage->SetSpacing(sp);
+  fSize = size;
+  fVoxelVolume = sp[0] * sp[1] * sp[2];
+
+  // counting sort of the voxels by ROI: the voxels of a ROI are contiguous
+  size_t n = size_t(sx) * sy * sz;
+  fNbROIs = nb_rois;
+  fROIOffsets.assign(nb_rois + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    if (rois[i] >= nb_rois) {
+      std::ostringstream oss;
+      oss << "Error in GateROIDoseActor: the ROI index " << rois[i]
+          << " of a voxel is not lower than the number of ROIs " << nb_rois;
+      Fatal(oss.str());
+    }
+    if (rois[i] >= 0)
+      fROIOffsets[rois[i] + 1]++;
+  }
+  for (int r = 0; r < nb_rois; r++)
+    fROIOffsets[r + 1] += fROIOffsets[r];
+  auto next = fROIOffsets;
+  fVoxelSlots.assign(n, -1);
+  fSlotROIs.resize(fROIOffsets[nb_rois]);
+  for (size_t i = 0; i < n; i++) {
+    if (rois[i] < 0)
+      continue;
+    auto slot = next[rois[i]]++;
+    fVoxelSlots[i] = slot;
+    fSlotROIs[slot] = rois[i];
+  }
+}
+
+int GateROIDoseActor::GetNumberOfROIVoxels(int roi) const {
+  if (roi < 0 || roi >= fNbROIs)
+    return 0;
+  return fROIOffsets[roi + 1] - fROIOffsets[roi];
+}
+
+void GateROIDoseActor::StartSimulationAction() {
+  // the statistics are accumulated over all the runs
+  fROIEdep.assign(fNbROIs, 0.0);
+  fROIDose.assign(fNbROIs, 0.0);
+  fROIDoseSquared.assign(fNbROIs, 0.0);
+  fVoxelDose.assign(fDVHBins > 0 ? fSlotROIs.size() : 0, 0.0);
+  fDVH.clear();
+  fNbOfEvents = 0;
+}
+
+void GateROIDoseActor::BeginOfRunActionMasterThread(int run_id) {
+  // Important ! The volume may have moved, so we re-attach each run
+  AttachImageToVolume<Image3DType>(fLabelImage, fPhysicalVolumeName,
+                                   fTranslation);
+  // world to voxel index, computed once per run
+  fIndexTransform.Update(fLabelImage.GetPointer());
+}
+
+void GateROIDoseActor::BeginOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  l.roi_edep.assign(fNbROIs, 0.0);
+  l.roi_dose.assign(fNbROIs, 0.0);
+  l.roi_history_dose.assign(fNbROIs, 0.0);
+  l.roi_last_id.assign(fNbROIs, -1);
+  l.roi_dose_squared.assign(fNbROIs, 0.0);
+  l.voxel_dose.assign(fVoxelDose.size(), 0.0);
+}
+
+void GateROIDoseActor::BeginOfEventAction(const G4Event *) {
+  fNbOfEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GateROIDoseActor::SteppingAction(G4Step *step) {
+  auto edep = step->GetTotalEnergyDeposit();
+  if (edep == 0)
+    return;
+
+  // pre, post, middle or random position, then the ROI of the voxel
+  Image3DType::IndexType index;
+  if (!fIndexTransform.TransformPointToIndex(fHitPosition(step), index))
+    return;
+  auto voxel = index[0] + fSize[0] * (index[1] + fSize[1] * index[2]);
+  auto slot = fVoxelSlots[voxel];
+  if (slot < 0)
+    return;
+  auto roi = fSlotROIs[slot];
+
+  // edep and edep / density (G4 units), converted into Gy at the end
+  edep *= step->GetTrack()->GetWeight();
+  auto dose = edep / GateStepContext::Get(step).GetDensity();
+  auto &l = fThreadLocalData.Get();
+  l.roi_edep[roi] += edep;
+  l.roi_dose[roi] += dose;
+  if (!l.voxel_dose.empty())
+    l.voxel_dose[slot] += dose;
+
+  // history by history: the squared dose of the previous history of this
+  // ROI is summed when a new history deposits in the ROI
+  auto id = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+  if (id != l.roi_last_id[roi]) {
+    auto d = l.roi_history_dose[roi];
+    l.roi_dose_squared[roi] += d * d;
+    l.roi_history_dose[roi] = 0;
+    l.roi_last_id[roi] = id;
+  }
+  l.roi_history_dose[roi] += dose;
+}
+
+void GateROIDoseActor::EndOfRunAction(const G4Run *) {
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&ROIDoseMergeMutex);
+  for (int r = 0; r < fNbROIs; r++) {
+    auto d = l.roi_history_dose[r];
+    fROIEdep[r] += l.roi_edep[r];
+    fROIDose[r] += l.roi_dose[r];
+    fROIDoseSquared[r] += l.roi_dose_squared[r] + d * d;
+  }
+  for (size_t i = 0; i < l.voxel_dose.size(); i++)
+    fVoxelDose[i] += l.voxel_dose[i];
+  l.voxel_dose.clear();
+  l.voxel_dose.shrink_to_fit();
+}
+
+int GateROIDoseActor::EndOfRunActionMasterThread(int run_id) {
+  // the workers have merged their values (EndOfRunAction)
+  if (fDVHBins > 0)
+    BuildDVH();
+  return 0;
+}
+
+void GateROIDoseActor::BuildDVH() {
+  auto to_gray = 1.0 / (fVoxelVolume * CLHEP::gray);
+  fDVHMaxDose = fDVHMaxDoseOption;
+  if (fDVHMaxDose == 0) {
+    for (auto d : fVoxelDose)
+      fDVHMaxDose = std::max(fDVHMaxDose, d * to_gray);
+  }
+  if (fDVHMaxDose == 0)
+    fDVHMaxDose = 1.0;
+
+  // the doses above the upper limit are counted in the last bin
+  fDVH.assign(fNbROIs, std::vector<double>(fDVHBins, 0.0));
+  for (size_t slot = 0; slot < fVoxelDose.size(); slot++) {
+    auto b = int(fVoxelDose[slot] * to_gray / fDVHMaxDose * fDVHBins);
+    fDVH[fSlotROIs[slot]][std::min(b, fDVHBins - 1)] += 1;
+  }
+}
+
+std::vector<double> GateROIDoseActor::GetROIDose() const {
+  std::vector<double> dose(fNbROIs, 0.0);
+  for (int r = 0; r < fNbROIs; r++) {
+    auto n = GetNumberOfROIVoxels(r);
+    if (n > 0)
+      dose[r] = fROIDose[r] / (n * fVoxelVolume * CLHEP::gray);
+  }
+  return dose;
+}
+
+std::vector<double> GateROIDoseActor::GetROIDoseUncertainty() const {
+  // relative standard error of the mean dose per history
+  std::vector<double> uncertainty(fNbROIs, 1.0);
+  double n = fNbOfEvents;
+  if (n < 2)
+    return uncertainty;
+  for (int r = 0; r < fNbROIs; r++) {
+    auto mean = fROIDose[r] / n;
+    if (mean == 0)
+      continue;
+    auto var = (fROIDoseSquared[r] / n - mean * mean) / (n - 1);
+    uncertainty[r] = std::sqrt(std::max(var, 0.0)) / mean;
+  }
+  return uncertainty;
+}
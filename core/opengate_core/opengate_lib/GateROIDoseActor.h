@@ -0,0 +1,141 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateROIDoseActor_h
+#define GateROIDoseActor_h
+
+#include "G4Cache.hh"
+#include "GateHelpersImage.h"
+#include "GateVActor.h"
+#include "itkImage.h"
+#include <atomic>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Dose statistics per region of interest (ROI, e.g. organs), without dose
+ * image. The ROIs are given by a label image, placed like the image of the
+ * DoseActor (centered on the attached volume, plus the translation).
+ *
+ * The label image is converted once into a voxel to ROI table (4 bytes per
+ * voxel, shared by all threads). Each thread accumulates the edep, the dose
+ * and the history-wise squared dose of each ROI (a few values per ROI), and,
+ * only if a DVH is requested, the dose of each voxel inside a ROI. The
+ * per-thread values are added to the shared ones at the end of the run, and
+ * the DVH is built by the master thread from the merged voxel doses.
+ *
+ * The dose of a ROI is the mean of the dose of its voxels (edep / mass of the
+ * voxel, with the density of the material of the step), in Gy.
+ */
+class GateROIDoseActor : public GateVActor {
+
+public:
+  // Constructor
+  GateROIDoseActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  int EndOfRunActionMasterThread(int run_id) override;
+
+  void BeginOfRunAction(const G4Run *run) override;
+
+  void BeginOfEventAction(const G4Event *event) override;
+
+  void SteppingAction(G4Step *step) override;
+
+  void EndOfRunAction(const G4Run *run) override;
+
+  inline std::string GetPhysicalVolumeName() const {
+    return fPhysicalVolumeName;
+  }
+
+  inline void SetPhysicalVolumeName(std::string s) { fPhysicalVolumeName = s; }
+
+  // ROI of each voxel (x fastest, -1 outside all ROIs), size of the label
+  // image in voxels and spacing
+  void SetVoxelROIs(const int32_t *rois, int sx, int sy, int sz,
+                    int nb_rois, const std::vector<double> &spacing);
+
+  int GetNumberOfROIs() const { return fNbROIs; }
+
+  int GetNumberOfROIVoxels(int roi) const;
+
+  // Merged values per ROI (since the start of the simulation)
+  std::vector<double> GetROIEdep() const { return fROIEdep; }
+
+  // mean dose of the voxels of the ROI, in Gy
+  std::vector<double> GetROIDose() const;
+
+  // relative uncertainty of the mean dose (history by history)
+  std::vector<double> GetROIDoseUncertainty() const;
+
+  // Differential DVH: number of voxels of the ROI in each dose bin (built at
+  // the end of the last run), and upper limit of the bins in Gy
+  std::vector<std::vector<double>> GetDVH() const { return fDVH; }
+
+  double GetDVHMaxDose() const { return fDVHMaxDose; }
+
+  long GetNumberOfEvents() const { return fNbOfEvents; }
+
+  typedef itk::Image<double, 3> Image3DType;
+
+protected:
+  void BuildDVH();
+
+  // geometry only (no pixel buffer), to place the label image in the world
+  Image3DType::Pointer fLabelImage;
+  GateImageIndexTransform fIndexTransform;
+  Image3DType::SizeType fSize{};
+
+  // voxel -> slot of the voxel in the ROI voxels (-1: no ROI), the slots of
+  // a ROI are contiguous: [fROIOffsets[r], fROIOffsets[r + 1])
+  std::vector<int32_t> fVoxelSlots;
+  std::vector<int32_t> fSlotROIs;
+  std::vector<int> fROIOffsets;
+  int fNbROIs = 0;
+
+  // merged values (shared, updated at the end of each run)
+  std::vector<double> fROIEdep;
+  std::vector<double> fROIDose;
+  std::vector<double> fROIDoseSquared;
+  std::vector<double> fVoxelDose;
+  std::atomic<long> fNbOfEvents{0};
+
+  std::vector<std::vector<double>> fDVH;
+  double fDVHMaxDose = 0;
+
+  struct threadLocalT {
+    std::vector<double> roi_edep;
+    std::vector<double> roi_dose;
+    // dose of the current history per ROI, its squared values are summed
+    // when another history deposits in the ROI (or at the end of the run)
+    std::vector<double> roi_history_dose;
+    std::vector<int> roi_last_id;
+    std::vector<double> roi_dose_squared;
+    // dose per ROI voxel (DVH only)
+    std::vector<double> voxel_dose;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+
+  // Options
+  std::string fPhysicalVolumeName;
+  G4ThreeVector fTranslation;
+  HitType fHitType = HitType::Random;
+  G4ThreeVector (*fHitPosition)(const G4Step *){};
+  int fDVHBins = 0;
+  double fDVHMaxDoseOption = 0;
+  double fVoxelVolume = 0;
+};
+
+#endif // GateROIDoseActor_h
@@ -1,88 +1,51 @@
-/*------------------------------------
-   Write something professional here
--------------------------------------*/
+/* --------------------------------------------------
+   Copyright (C): OpenGate Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
 
 #include "GateRandomMultiGauss.h"
 #include "G4RandomTools.hh"
-#include <math.h>
-#include <vector>
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 
 GateRandomMultiGauss::GateRandomMultiGauss(vector<double> muVin,
                                            vector<double> sigmaMin) {
-
   muV = muVin;
   sigmaM = sigmaMin;
-
-  a = sigmaM[0];
-  b = sigmaM[1];
-  c = sigmaM[2];
-  d = sigmaM[3];
+  Cholesky();
 }
 
 GateRandomMultiGauss::~GateRandomMultiGauss() {}
 
-void GateRandomMultiGauss::eigenVal() {
-
-  double t1 = (a + d) / 2;
-  double t2 = sqrt(pow((a + d), 2) / 4 - a * d + b * c);
-  eigVal1 = t1 + t2;
-  eigVal2 = t1 - t2;
-}
-vector<double> GateRandomMultiGauss::eigenVector(double eigenValue) {
-  double x = 1;
-  double lam = eigenValue;
-
-  double y = x * ((-(a + c) + lam) / (b + d - lam));
-  vector<double> eV = {x, y};
-  eV[0] /= sqrt(pow(x, 2) + pow(y, 2));
-  eV[1] /= sqrt(pow(x, 2) + pow(y, 2));
-
-  return eV;
+void GateRandomMultiGauss::Cholesky() {
+  // the matrix is symmetric (b == c) and positive semi-definite; a null
+  // variance gives a null column (no division by zero)
+  double a = sigmaM[0];
+  double b = sigmaM[1];
+  double d = sigmaM[3];
+  l11 = sqrt(max(0.0, a));
+  l21 = l11 > 0 ? b / l11 : 0;
+  l22 = sqrt(max(0.0, d - l21 * l21));
 }
-void GateRandomMultiGauss::eigenVectors() {
-
-  // NO SAFETY CHECKS PERFORMED FOR NOW  as only symmetric matrices are used //
-
-  /*double lam = eigenValueV; // which value?
-  if (((b+d -lam) < FLT_EPSILON) && ( (a+c)-lam < FLT_EPSILON)){
-      eigVec1 = {1,0};
-      eigVec2 = {0,1};
-      }
-  else{*/
-  eigVec1 = eigenVector(eigVal1);
-  eigVec2 = eigenVector(eigVal2);
-  //}
-}
-vector<double> GateRandomMultiGauss::SigmaIndex(double x1_o, double x2_o) {
-  double l1 = eigVal1;
-  double l2 = eigVal2;
-
-  double y1 = sqrt(l1) * eigVec1[0] * x1_o + sqrt(l2) * eigVec2[0] * x2_o;
-  double y2 = sqrt(l1) * eigVec1[1] * x1_o + sqrt(l2) * eigVec2[1] * x2_o;
-
-  vector<double> r = {y1, y2};
-
-  return r;
-}
-
-vector<double> GateRandomMultiGauss::Fire() {
 
+vector<double> GateRandomMultiGauss::Fire() const {
   // Generate two random numbers
   double v1 = G4RandGauss::shoot(0., 1.);
   double v2 = G4RandGauss::shoot(0., 1.);
+  return {muV[0] + l11 * v1, muV[1] + l21 * v1 + l22 * v2};
+}
 
-  eigenVal();
-  eigenVectors();
-
-  // #v1 = -0.50166257;
-  // #v2 = -1.08763581;
-
-  vector<double> res = SigmaIndex(v1, v2);
-
-  res[0] += muV[0];
-  res[1] += muV[1];
-
-  return res;
+void GateRandomMultiGauss::FireArray(size_t n, double *x1, double *x2) const {
+  // all the standard Gaussians first: x1 = v1, x2 = v2
+  G4RandGauss::shootArray(static_cast<int>(n), x1, 0., 1.);
+  G4RandGauss::shootArray(static_cast<int>(n), x2, 0., 1.);
+  for (size_t i = 0; i < n; i++) {
+    double v1 = x1[i];
+    x1[i] = muV[0] + l11 * v1;
+    x2[i] = muV[1] + l21 * v1 + l22 * x2[i];
+  }
 }
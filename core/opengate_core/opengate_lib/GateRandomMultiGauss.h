@@ -8,10 +8,17 @@
 #ifndef GateRandomMultiGauss_h
 #define GateRandomMultiGauss_h
 
+#include <cstddef>
 #include <vector>
 
 using namespace std;
 
+/*
+    Correlated 2D Gaussian (mean muV, covariance sigmaM = [a, b, c, d]).
+    The Cholesky factor of the covariance is computed once, in the
+    constructor: a sample costs two standard Gaussians and a 2x2 product.
+ */
+
 class GateRandomMultiGauss {
 
 public:
@@ -19,20 +26,18 @@ public:
 
   ~GateRandomMultiGauss();
 
-  vector<double> Fire();
+  vector<double> Fire() const;
+
+  // n samples at once (vectorized Gaussians), in x1[i], x2[i]
+  void FireArray(size_t n, double *x1, double *x2) const;
 
 protected:
   vector<double> muV;
   vector<double> sigmaM;
-  double a, b, c, d;
-  double eigVal1, eigVal2;
-  vector<double> eigVec1;
-  vector<double> eigVec2;
-
-  void eigenVal();
-  vector<double> eigenVector(double eigenValue);
-  void eigenVectors();
-  vector<double> SigmaIndex(double x1_o, double x2_o);
+  // lower triangular factor L (covariance = L L^T)
+  double l11, l21, l22;
+
+  void Cholesky();
 };
 
 #endif
@@ -0,0 +1,200 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateRangeRejectionActor.h"
+#include "G4EmCalculator.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProductionCutsTable.hh"
+#include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+GateRangeRejectionActor::GateRangeRejectionActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("SteppingAction");
+  fEnergyThreshold = 0;
+  fEnergyMin = 0;
+  fEnergyMax = 0;
+  fNumberOfBins = 0;
+}
+
+void GateRangeRejectionActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fParticleNames = DictGetVecStr(user_info, "particles");
+  fRegionOfInterestNames = DictGetVecStr(user_info, "region_of_interest");
+  fEnergyThreshold = DictGetDouble(user_info, "energy_threshold");
+  fEnergyMin = DictGetDouble(user_info, "energy_min");
+  fEnergyMax = DictGetDouble(user_info, "energy_max");
+  fNumberOfBins = DictGetInt(user_info, "number_of_bins");
+  if (fEnergyMin <= 0 || fEnergyMax <= fEnergyMin || fNumberOfBins < 2) {
+    std::ostringstream oss;
+    oss << "Invalid range tables of the RangeRejectionActor '" << GetName()
+        << "': " << fNumberOfBins << " bins in [" << fEnergyMin << ", "
+        << fEnergyMax << "]";
+    Fatal(oss.str());
+  }
+}
+
+void GateRangeRejectionActor::InitializeCpp() { fNbOfKilled = 0; }
+
+void GateRangeRejectionActor::BeginOfRunActionMasterThread(int /*run_id*/) {
+  // solid and position of the attached volume (may move between runs)
+  const auto *lv =
+      G4LogicalVolumeStore::GetInstance()->GetVolume(fAttachedToVolumeName);
+  fSolid = lv->GetSolid();
+  ComputeTransformationFromWorldToVolume(fAttachedToVolumeName, fTranslation,
+                                         fRotation, true);
+
+  // world bounding boxes of the regions of interest (from the 8 corners of
+  // the local bounding box)
+  fRegionOfInterestBoxes.clear();
+  for (const auto &name : fRegionOfInterestNames) {
+    const auto *roi =
+        G4LogicalVolumeStore::GetInstance()->GetVolume(name, false);
+    if (roi == nullptr) {
+      std::ostringstream oss;
+      oss << "The region of interest '" << name << "' of the "
+          << "RangeRejectionActor '" << GetName() << "' does not exist.";
+      Fatal(oss.str());
+    }
+    G4ThreeVector pmin, pmax;
+    roi->GetSolid()->BoundingLimits(pmin, pmax);
+    G4ThreeVector translation;
+    G4RotationMatrix rotation;
+    ComputeTransformationFromVolumeToWorld(name, translation, rotation, true);
+    G4ThreeVector wmin(DBL_MAX, DBL_MAX, DBL_MAX);
+    G4ThreeVector wmax(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+    for (int i = 0; i < 8; i++) {
+      const G4ThreeVector corner((i & 1) ? pmax.x() : pmin.x(),
+                                 (i & 2) ? pmax.y() : pmin.y(),
+                                 (i & 4) ? pmax.z() : pmin.z());
+      const auto w = rotation * corner + translation;
+      for (int j = 0; j < 3; j++) {
+        wmin[j] = std::min(wmin[j], w[j]);
+        wmax[j] = std::max(wmax[j], w[j]);
+      }
+    }
+    fRegionOfInterestBoxes.emplace_back(wmin, wmax);
+  }
+
+  // the physics tables are built at this point
+  BuildRangeTables();
+}
+
+void GateRangeRejectionActor::BuildRangeTables() {
+  G4EmCalculator calculator;
+  const auto *table = G4ProductionCutsTable::GetProductionCutsTable();
+  fNumberOfCouples = table->GetTableSize();
+  fLogEnergyMin = std::log(fEnergyMin);
+  fLogEnergyStep = std::log(fEnergyMax / fEnergyMin) / (fNumberOfBins - 1);
+  fParticles.clear();
+  fRanges.clear();
+  fThresholdRanges.clear();
+  for (const auto &name : fParticleNames) {
+    const auto *particle =
+        G4ParticleTable::GetParticleTable()->FindParticle(name);
+    if (particle == nullptr || particle->GetPDGCharge() == 0) {
+      std::ostringstream oss;
+      oss << "The RangeRejectionActor '" << GetName()
+          << "' needs charged particles, while '" << name << "' is given.";
+      Fatal(oss.str());
+    }
+    std::vector<double> ranges(fNumberOfCouples * fNumberOfBins);
+    std::vector<double> threshold_ranges(fNumberOfCouples, 0);
+    for (size_t c = 0; c < fNumberOfCouples; c++) {
+      const auto *couple =
+          table->GetMaterialCutsCouple(static_cast<int>(c));
+      const auto *material = couple->GetMaterial();
+      for (int i = 0; i < fNumberOfBins; i++) {
+        const auto e = std::exp(fLogEnergyMin + i * fLogEnergyStep);
+        ranges[c * fNumberOfBins + i] =
+            calculator.GetRangeFromRestricteDEDX(e, particle, material);
+      }
+      if (fEnergyThreshold > 0)
+        threshold_ranges[c] = calculator.GetRangeFromRestricteDEDX(
+            fEnergyThreshold, particle, material);
+    }
+    fParticles.push_back(particle);
+    fRanges.push_back(std::move(ranges));
+    fThresholdRanges.push_back(std::move(threshold_ranges));
+  }
+}
+
+int GateRangeRejectionActor::GetParticleIndex(
+    const G4ParticleDefinition *particle) const {
+  for (size_t p = 0; p < fParticles.size(); p++) {
+    if (fParticles[p] == particle)
+      return static_cast<int>(p);
+  }
+  return -1;
+}
+
+double GateRangeRejectionActor::GetRange(int particle_index,
+                                         size_t couple_index,
+                                         double energy) const {
+  const auto *ranges =
+      fRanges[particle_index].data() + couple_index * fNumberOfBins;
+  // (below the table, the range is at most the one of the first bin)
+  if (energy <= fEnergyMin)
+    return ranges[0];
+  const auto x = (std::log(energy) - fLogEnergyMin) / fLogEnergyStep;
+  const auto i = std::min(static_cast<int>(x), fNumberOfBins - 2);
+  const auto f = x - i;
+  return ranges[i] + f * (ranges[i + 1] - ranges[i]);
+}
+
+double GateRangeRejectionActor::GetDistanceToTravel(
+    const G4ThreeVector &position) const {
+  if (fRegionOfInterestBoxes.empty())
+    return fSolid->DistanceToOut(fRotation * position + fTranslation);
+  double distance = DBL_MAX;
+  for (const auto &[pmin, pmax] : fRegionOfInterestBoxes) {
+    G4ThreeVector d;
+    for (int j = 0; j < 3; j++)
+      d[j] = std::max({pmin[j] - position[j], 0.0, position[j] - pmax[j]});
+    distance = std::min(distance, d.mag());
+  }
+  return distance;
+}
+
+void GateRangeRejectionActor::SteppingAction(G4Step *step) {
+  auto *track = step->GetTrack();
+  if (track->GetTrackStatus() != fAlive)
+    return;
+  const auto *post = step->GetPostStepPoint();
+  const auto energy = post->GetKineticEnergy();
+  const auto *couple = post->GetMaterialCutsCouple();
+  if (couple == nullptr)
+    return;
+  const auto p = GetParticleIndex(track->GetParticleDefinition());
+  if (p < 0 || energy >= fEnergyMax)
+    return;
+  // (the particles in a region of interest are never killed)
+  const auto distance = GetDistanceToTravel(post->GetPosition());
+  if (distance <= 0 && !fRegionOfInterestBoxes.empty())
+    return;
+  // the particle must travel the distance with an energy above threshold
+  if (energy > fEnergyThreshold) {
+    const auto index = couple->GetIndex();
+    const auto range = GetRange(p, index, energy) - fThresholdRanges[p][index];
+    if (range >= distance)
+      return;
+  }
+  Kill(step, energy);
+}
+
+void GateRangeRejectionActor::Kill(G4Step *step, double energy) {
+  // the particle cannot escape: killed, its energy is deposited in place
+  // (only when it is kept in the attached volume)
+  step->GetTrack()->SetTrackStatus(fStopAndKill);
+  if (fRegionOfInterestBoxes.empty())
+    step->AddTotalEnergyDeposit(energy);
+  fNbOfKilled++;
+}
@@ -0,0 +1,99 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateRangeRejectionActor_h
+#define GateRangeRejectionActor_h
+
+#include "G4ParticleDefinition.hh"
+#include "G4VSolid.hh"
+#include "GateVActor.h"
+#include <atomic>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Range rejection of the charged particles. At each step in the attached
+ * volume, the residual range of the particle (down to energy_threshold) is
+ * compared to the distance it must travel:
+ *
+ * - without region of interest: the distance to the boundary of the
+ *   attached volume (e.g. a voxelized phantom). A particle that cannot
+ *   exit it with an energy above the threshold is killed and its kinetic
+ *   energy is deposited at the end of the step.
+ * - with region of interest volumes: the distance to the closest one
+ *   (world bounding box). A particle that cannot reach them is killed,
+ *   without deposit.
+ *
+ * The ranges are the ones of the restricted dE/dx of the physics list
+ * (G4EmCalculator), at least the CSDA range, so that the rejection is
+ * conservative. They are tabulated once per run, for each particle and
+ * material cuts couple, at log-spaced energies. The photons (e.g. brems)
+ * the killed particle would have emitted are lost: this is why the
+ * positrons (annihilation) are usually not selected.
+ */
+
+class GateRangeRejectionActor : public GateVActor {
+
+public:
+  explicit GateRangeRejectionActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  // Called every time a Run starts (master thread)
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  // Main function called every step in attached volume
+  void SteppingAction(G4Step *step) override;
+
+  inline long GetNumberOfKilledParticles() const { return fNbOfKilled; }
+
+protected:
+  void BuildRangeTables();
+
+  // Index of the particle in the tables, -1 if not selected
+  int GetParticleIndex(const G4ParticleDefinition *particle) const;
+
+  // Residual range (mm) of the particle in the material of the couple
+  // (energy below energy_max)
+  double GetRange(int particle_index, size_t couple_index,
+                  double energy) const;
+
+  void Kill(G4Step *step, double energy);
+
+  // Distance from the point to travel to be able to escape (see above)
+  double GetDistanceToTravel(const G4ThreeVector &position) const;
+
+  std::vector<std::string> fParticleNames;
+  std::vector<std::string> fRegionOfInterestNames;
+  double fEnergyThreshold;
+  double fEnergyMin;
+  double fEnergyMax;
+  int fNumberOfBins;
+
+  // tables fRanges[particle][couple * fNumberOfBins + bin], log energy bins
+  std::vector<const G4ParticleDefinition *> fParticles;
+  std::vector<std::vector<double>> fRanges;
+  std::vector<std::vector<double>> fThresholdRanges;
+  size_t fNumberOfCouples = 0;
+  double fLogEnergyMin = 0;
+  double fLogEnergyStep = 0;
+
+  // attached volume solid and world to local transform
+  const G4VSolid *fSolid = nullptr;
+  G4ThreeVector fTranslation;
+  G4RotationMatrix fRotation;
+  // world bounding boxes of the regions of interest
+  std::vector<std::pair<G4ThreeVector, G4ThreeVector>> fRegionOfInterestBoxes;
+
+  // counts of the simulation (all threads)
+  std::atomic<long> fNbOfKilled{0};
+};
+
+#endif // GateRangeRejectionActor_h
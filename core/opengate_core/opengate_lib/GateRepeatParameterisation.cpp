@@ -41,6 +41,25 @@ void GateRepeatParameterisation::SetUserInfo(py::dict &user_info) {
   }
 }
 
+void GateRepeatParameterisation::ComputeRepeatIndex(int no, int &i, int &j,
+                                                    int &k,
+                                                    int &offset) const {
+  k = no % fSz;
+  no /= fSz;
+  j = no % fSy;
+  no /= fSy;
+  i = no % fSx;
+  offset = no / fSx;
+}
+
+G4ThreeVector GateRepeatParameterisation::ComputeTranslation(int no) const {
+  int i, j, k, of;
+  ComputeRepeatIndex(no, i, j, k, of);
+  return {fStart[0] + i * fTranslation[0] + of * fOffset[0],
+          fStart[1] + j * fTranslation[1] + of * fOffset[1],
+          fStart[2] + k * fTranslation[2] + of * fOffset[2]};
+}
+
 void GateRepeatParameterisation::ComputeTransformation(
     const G4int no, G4VPhysicalVolume *currentPV) const {
   currentPV->SetTranslation(fTranslations[no]);
@@ -22,6 +22,16 @@ public:
   virtual void ComputeTransformation(const G4int no,
                                      G4VPhysicalVolume *currentPV) const;
 
+  // Number of copies (repeat x * y * z * offset)
+  int GetNumberOfCopies() const { return fSx * fSy * fSz * fNbOffset; }
+
+  // Repeat indices (i, j, k) and offset of the copy number (no table, same
+  // order as in SetUserInfo: k fastest, then j, i and the offset)
+  void ComputeRepeatIndex(int no, int &i, int &j, int &k, int &offset) const;
+
+  // Translation of the copy number, computed from its repeat indices
+  G4ThreeVector ComputeTranslation(int no) const;
+
   G4ThreeVector fStart;
   G4ThreeVector fTranslation;
   G4RotationMatrix fRotation;
@@ -0,0 +1,199 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateRepeatedDetectorIndex.h"
+#include "G4LogicalVolumeStore.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "GateHelpers.h"
+
+namespace {
+
+// Local to mother transform of a physical volume
+G4AffineTransform LocalToMother(const G4VPhysicalVolume *pv) {
+  // (no rotation is the identity)
+  return {pv->GetRotation(), pv->GetTranslation()};
+}
+
+// All the physical volumes of the logical volume
+std::vector<G4VPhysicalVolume *>
+FindPhysicalVolumes(const G4LogicalVolume *lv) {
+  std::vector<G4VPhysicalVolume *> pvs;
+  for (auto *pv : *G4PhysicalVolumeStore::GetInstance()) {
+    if (pv->GetLogicalVolume() == lv)
+      pvs.push_back(pv);
+  }
+  return pvs;
+}
+
+} // namespace
+
+void GateRepeatedDetectorIndex::Initialize(
+    const std::vector<std::string> &volume_names) {
+  if (volume_names.empty())
+    Fatal("GateRepeatedDetectorIndex: no volume");
+  fLevels.clear();
+  fNumberOfCrystals = 1;
+  const G4LogicalVolume *mother = nullptr;
+  for (const auto &name : volume_names) {
+    Level level;
+    level.fLogicalVolume =
+        G4LogicalVolumeStore::GetInstance()->GetVolume(name, false);
+    if (level.fLogicalVolume == nullptr) {
+      std::ostringstream oss;
+      oss << "GateRepeatedDetectorIndex: no volume named " << name;
+      Fatal(oss.str());
+    }
+    const auto pvs = FindPhysicalVolumes(level.fLogicalVolume);
+    if (pvs.empty()) {
+      std::ostringstream oss;
+      oss << "GateRepeatedDetectorIndex: the volume " << name
+          << " is not placed";
+      Fatal(oss.str());
+    }
+    // all the copies are in the previous level
+    for (const auto *pv : pvs) {
+      if ((mother != nullptr && pv->GetMotherLogical() != mother) ||
+          pv->GetMotherLogical() != pvs[0]->GetMotherLogical()) {
+        std::ostringstream oss;
+        oss << "GateRepeatedDetectorIndex: the volume " << name
+            << " is not (only) a daughter of the previous volume";
+        Fatal(oss.str());
+      }
+    }
+    if (pvs.size() == 1 && pvs[0]->IsParameterised()) {
+      level.fRepeat = dynamic_cast<const GateRepeatParameterisation *>(
+          pvs[0]->GetParameterisation());
+      if (level.fRepeat == nullptr) {
+        std::ostringstream oss;
+        oss << "GateRepeatedDetectorIndex: the volume " << name
+            << " is parameterised but is not a RepeatParametrisedVolume";
+        Fatal(oss.str());
+      }
+      level.fNumberOfCopies = level.fRepeat->GetNumberOfCopies();
+    } else {
+      // placements, by copy number
+      level.fNumberOfCopies = static_cast<int>(pvs.size());
+      level.fTransforms.resize(pvs.size());
+      std::vector<bool> found(pvs.size(), false);
+      for (const auto *pv : pvs) {
+        const auto no = pv->GetCopyNo();
+        if (pv->IsReplicated() || no < 0 || no >= level.fNumberOfCopies ||
+            found[no]) {
+          std::ostringstream oss;
+          oss << "GateRepeatedDetectorIndex: the copies of the volume "
+              << name << " are not numbered 0 ... " << pvs.size() - 1;
+          Fatal(oss.str());
+        }
+        found[no] = true;
+        level.fTransforms[no] = LocalToMother(pv);
+      }
+    }
+    fNumberOfCrystals *= level.fNumberOfCopies;
+    fLevels.push_back(level);
+    mother = level.fLogicalVolume;
+  }
+
+  // mother of the outermost level to world: it must be placed once, as all
+  // its own mothers
+  fMotherToWorld = G4AffineTransform();
+  const auto *lv = FindPhysicalVolumes(fLevels[0].fLogicalVolume)[0]
+                       ->GetMotherLogical();
+  while (lv != nullptr) {
+    const auto pvs = FindPhysicalVolumes(lv);
+    if (pvs.size() != 1 || pvs[0]->IsReplicated()) {
+      std::ostringstream oss;
+      oss << "GateRepeatedDetectorIndex: the volume " << lv->GetName()
+          << " is repeated, the detector must be the outermost repeated "
+             "volume";
+      Fatal(oss.str());
+    }
+    fMotherToWorld = fMotherToWorld * LocalToMother(pvs[0]);
+    lv = pvs[0]->GetMotherLogical();
+  }
+}
+
+int GateRepeatedDetectorIndex::GetNumberOfCopies(size_t level) const {
+  return fLevels.at(level).fNumberOfCopies;
+}
+
+long GateRepeatedDetectorIndex::GetIndex(
+    const G4VTouchable *touchable) const {
+  const auto nb = static_cast<int>(fLevels.size());
+  const auto depth = touchable->GetHistoryDepth();
+  // depth of the crystal (0, or more when the step is in a daughter)
+  int d = 0;
+  const auto *crystal = fLevels.back().fLogicalVolume;
+  while (d <= depth - nb + 1 &&
+         touchable->GetVolume(d)->GetLogicalVolume() != crystal)
+    d++;
+  if (d > depth - nb + 1)
+    return -1;
+  long index = 0;
+  for (auto l = 0; l < nb; l++) {
+    const auto &level = fLevels[l];
+    const auto h = d + nb - 1 - l;
+    if (touchable->GetVolume(h)->GetLogicalVolume() != level.fLogicalVolume)
+      return -1;
+    const auto no = touchable->GetCopyNumber(h);
+    if (no < 0 || no >= level.fNumberOfCopies)
+      return -1;
+    index = index * level.fNumberOfCopies + no;
+  }
+  return index;
+}
+
+long GateRepeatedDetectorIndex::GetIndex(
+    const std::vector<int> &copy_numbers) const {
+  if (copy_numbers.size() != fLevels.size())
+    return -1;
+  long index = 0;
+  for (size_t l = 0; l < fLevels.size(); l++) {
+    const auto no = copy_numbers[l];
+    if (no < 0 || no >= fLevels[l].fNumberOfCopies)
+      return -1;
+    index = index * fLevels[l].fNumberOfCopies + no;
+  }
+  return index;
+}
+
+std::vector<int> GateRepeatedDetectorIndex::GetCopyNumbers(size_t index) const {
+  if (index >= fNumberOfCrystals) {
+    std::ostringstream oss;
+    oss << "GateRepeatedDetectorIndex: no crystal with index " << index << " ("
+        << fNumberOfCrystals << " crystals)";
+    Fatal(oss.str());
+  }
+  std::vector<int> copy_numbers(fLevels.size());
+  for (auto l = fLevels.size(); l-- > 0;) {
+    const auto n = static_cast<size_t>(fLevels[l].fNumberOfCopies);
+    copy_numbers[l] = static_cast<int>(index % n);
+    index /= n;
+  }
+  return copy_numbers;
+}
+
+G4AffineTransform
+GateRepeatedDetectorIndex::GetLevelTransform(const Level &level,
+                                             int no) const {
+  if (level.fRepeat == nullptr)
+    return level.fTransforms[no];
+  return {level.fRepeat->fRotationP, level.fRepeat->ComputeTranslation(no)};
+}
+
+G4AffineTransform
+GateRepeatedDetectorIndex::GetLocalToWorldTransform(size_t index) const {
+  const auto copy_numbers = GetCopyNumbers(index);
+  // from the crystal to the outermost level (A * B is A followed by B)
+  G4AffineTransform t;
+  for (auto l = fLevels.size(); l-- > 0;)
+    t = t * GetLevelTransform(fLevels[l], copy_numbers[l]);
+  return t * fMotherToWorld;
+}
+
+G4ThreeVector GateRepeatedDetectorIndex::GetCenter(size_t index) const {
+  return GetLocalToWorldTransform(index).TransformPoint(G4ThreeVector());
+}
@@ -0,0 +1,80 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateRepeatedDetectorIndex_h
+#define GateRepeatedDetectorIndex_h
+
+#include "G4AffineTransform.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VTouchable.hh"
+#include "GateRepeatParameterisation.h"
+#include <string>
+#include <vector>
+
+/*
+ * Dense index of the crystals of a detector made of nested repeated volumes,
+ * e.g. the module -> stack -> die -> crystal of a PET ring. Each level is a
+ * (logical) volume name, from the outermost to the crystal, and is either
+ * repeated with a RepeatParametrisedVolume (GateRepeatParameterisation), or
+ * placed several times (repeated volume, copy numbers 0 ... n - 1), or
+ * placed once.
+ *
+ * The index of a crystal is the mixed-radix number of the copy numbers of
+ * its levels (the crystal copy number is the fastest), and its transform is
+ * the product of the transforms of the levels: both are computed from the
+ * copy numbers of the touchable, without map lookup.
+ *
+ * Initialize is called once the geometry is constructed, the other
+ * functions are then const and may be called by all the threads.
+ */
+class GateRepeatedDetectorIndex {
+public:
+  void Initialize(const std::vector<std::string> &volume_names);
+
+  size_t GetNumberOfLevels() const { return fLevels.size(); }
+
+  size_t GetNumberOfCrystals() const { return fNumberOfCrystals; }
+
+  // Number of copies of a level (0 is the outermost)
+  int GetNumberOfCopies(size_t level) const;
+
+  // Index of the crystal of the touchable, -1 if the touchable is not in
+  // one of the crystals
+  long GetIndex(const G4VTouchable *touchable) const;
+
+  // Index of the copy numbers of the levels (outermost first), -1 if one
+  // copy number is out of range
+  long GetIndex(const std::vector<int> &copy_numbers) const;
+
+  // Copy numbers of the levels (outermost first) of the crystal index
+  std::vector<int> GetCopyNumbers(size_t index) const;
+
+  // Crystal to world transform, and center of the crystal (world)
+  G4AffineTransform GetLocalToWorldTransform(size_t index) const;
+
+  G4ThreeVector GetCenter(size_t index) const;
+
+protected:
+  struct Level {
+    const G4LogicalVolume *fLogicalVolume = nullptr;
+    int fNumberOfCopies = 1;
+    // repeat parameterisation of the level, if any
+    const GateRepeatParameterisation *fRepeat = nullptr;
+    // otherwise local to mother transform of each copy number
+    std::vector<G4AffineTransform> fTransforms;
+  };
+
+  // Transform of the copy number of the level
+  G4AffineTransform GetLevelTransform(const Level &level, int no) const;
+
+  std::vector<Level> fLevels;
+  size_t fNumberOfCrystals = 0;
+  // mother of the outermost level to world
+  G4AffineTransform fMotherToWorld;
+};
+
+#endif // GateRepeatedDetectorIndex_h
@@ -7,9 +7,13 @@
 
 #include "GateRunAction.h"
 #include "GateHelpers.h"
+#include "GateThreadContext.h"
+#include "GateTimeline.h"
 
 GateRunAction::GateRunAction(GateSourceManager *sm) : G4UserRunAction() {
   fSourceManager = sm;
+  // (one run action is built by each thread)
+  GateThreadContext::Current().Initialize();
 }
 
 void GateRunAction::RegisterActor(GateVActor *actor) {
@@ -26,12 +30,14 @@ void GateRunAction::RegisterActor(GateVActor *actor) {
 }
 
 void GateRunAction::BeginOfRunAction(const G4Run *run) {
+  GateTimeline::Begin("run", "run");
   for (auto actor : fBeginOfRunAction_actors) {
     actor->BeginOfRunAction(run);
   }
 }
 
 void GateRunAction::EndOfRunAction(const G4Run *run) {
+  GateTimeline::EndOfEvents();
   for (auto actor : fEndOfRunAction_actors) {
     actor->EndOfRunAction(run);
   }
@@ -42,4 +48,5 @@ void GateRunAction::EndOfRunAction(const G4Run *run) {
       actor->EndOfSimulationWorkerAction(run);
     }
   }
+  GateTimeline::End("run", "run");
 }
@@ -0,0 +1,115 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateRussianRouletteActor.h"
+#include "GateHelpersDict.h"
+#include "GateMutex.h"
+#include "Randomize.hh"
+
+GATE_MUTEX(RussianRouletteMutex);
+
+GateRussianRouletteActor::GateRussianRouletteActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("StartSimulationAction");
+  fActions.insert("SteppingAction");
+  fActions.insert("EndOfRunAction");
+}
+
+void GateRussianRouletteActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fRoulette.first = DictGetDouble(user_info, "weight_threshold");
+  fRoulette.second = DictGetDouble(user_info, "survival_weight");
+  CheckRoulette("all", fRoulette);
+  DictCheckKey(user_info, "per_particle");
+  fRoulettePerParticle.clear();
+  const auto per_particle =
+      py::cast<std::map<std::string, std::vector<double>>>(
+          user_info["per_particle"]);
+  for (const auto &[name, r] : per_particle) {
+    if (r.size() != 2) {
+      std::ostringstream oss;
+      oss << "Error in the RussianRouletteActor '" << GetName()
+          << "': per_particle must give [weight_threshold, survival_weight] "
+             "for each particle, while "
+          << r.size() << " values are read for " << name;
+      Fatal(oss.str());
+    }
+    fRoulettePerParticle[name] = {r[0], r[1]};
+    CheckRoulette(name, fRoulettePerParticle[name]);
+  }
+}
+
+void GateRussianRouletteActor::CheckRoulette(const std::string &name,
+                                             const RouletteType &r) const {
+  // (no roulette if the threshold is <= 0)
+  if (r.first > 0 && r.second < r.first) {
+    std::ostringstream oss;
+    oss << "Error in the RussianRouletteActor '" << GetName()
+        << "': the survival weight must be at least the weight threshold, "
+           "while "
+        << r.second << " and " << r.first << " are read for " << name;
+    Fatal(oss.str());
+  }
+}
+
+void GateRussianRouletteActor::StartSimulationAction() {
+  fNbOfRoulette = 0;
+  fNbOfKilled = 0;
+  fKilledWeight = 0;
+  fSurvivalAddedWeight = 0;
+}
+
+const GateRussianRouletteActor::RouletteType &
+GateRussianRouletteActor::GetRoulette(const G4ParticleDefinition *particle) {
+  auto &particles = fThreadLocalData.Get().fParticles;
+  auto it = particles.find(particle);
+  if (it == particles.end()) {
+    auto pit = fRoulettePerParticle.find(particle->GetParticleName());
+    const auto &r =
+        pit == fRoulettePerParticle.end() ? fRoulette : pit->second;
+    it = particles.emplace(particle, r).first;
+  }
+  return it->second;
+}
+
+void GateRussianRouletteActor::SteppingAction(G4Step *step) {
+  auto *track = step->GetTrack();
+  if (track->GetTrackStatus() != fAlive)
+    return;
+  const auto weight = track->GetWeight();
+  const auto &[threshold, survival_weight] =
+      GetRoulette(track->GetParticleDefinition());
+  if (weight >= threshold)
+    return;
+
+  // survives with the probability w / ws, with the weight ws
+  auto &l = fThreadLocalData.Get();
+  l.fNbOfRoulette++;
+  if (G4UniformRand() * survival_weight < weight) {
+    track->SetWeight(survival_weight);
+    l.fSurvivalAddedWeight += survival_weight - weight;
+    return;
+  }
+  track->SetTrackStatus(fStopAndKill);
+  l.fNbOfKilled++;
+  l.fKilledWeight += weight;
+}
+
+void GateRussianRouletteActor::EndOfRunAction(const G4Run * /*run*/) {
+  auto &l = fThreadLocalData.Get();
+  {
+    GateAutoLock mutex(&RussianRouletteMutex);
+    fNbOfRoulette += l.fNbOfRoulette;
+    fNbOfKilled += l.fNbOfKilled;
+    fKilledWeight += l.fKilledWeight;
+    fSurvivalAddedWeight += l.fSurvivalAddedWeight;
+  }
+  l.fNbOfRoulette = 0;
+  l.fNbOfKilled = 0;
+  l.fKilledWeight = 0;
+  l.fSurvivalAddedWeight = 0;
+}
@@ -0,0 +1,88 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateRussianRouletteActor_h
+#define GateRussianRouletteActor_h
+
+#include "G4ParticleDefinition.hh"
+#include "GateThreadContext.h"
+#include "GateVActor.h"
+#include <map>
+#include <pybind11/stl.h>
+#include <unordered_map>
+
+namespace py = pybind11;
+
+/*
+ * Russian roulette of the low weight particles (e.g. the photons of a
+ * Compton or bremsstrahlung splitting), a weight window with a lower bound
+ * only. At each step in the attached volume(s), a particle whose weight w is
+ * below the threshold of its type survives with the probability w / ws, with
+ * the survival weight ws, and is killed otherwise: the expected weight is
+ * unchanged.
+ *
+ * The threshold and the survival weight are the same for all the particles,
+ * or given per particle name (a threshold <= 0 disables the roulette of the
+ * particle). The rouletted particles and weights are counted per thread and
+ * added at the end of each run.
+ */
+
+class GateRussianRouletteActor : public GateVActor {
+
+public:
+  explicit GateRussianRouletteActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void StartSimulationAction() override;
+
+  // Main function called every step in attached volume
+  void SteppingAction(G4Step *step) override;
+
+  // The counts of the thread are added to the ones of the actor
+  void EndOfRunAction(const G4Run *run) override;
+
+  inline long GetNumberOfRouletteParticles() const { return fNbOfRoulette; }
+
+  inline long GetNumberOfKilledParticles() const { return fNbOfKilled; }
+
+  // Sum of the weights of the killed particles
+  inline double GetKilledWeight() const { return fKilledWeight; }
+
+  // Sum of the weights given to the surviving particles (ws - w), the same
+  // as the killed weight on average
+  inline double GetSurvivalAddedWeight() const { return fSurvivalAddedWeight; }
+
+protected:
+  // (threshold, survival weight)
+  typedef std::pair<double, double> RouletteType;
+
+  // Threshold and survival weight of the particle (cached per thread)
+  const RouletteType &GetRoulette(const G4ParticleDefinition *particle);
+
+  void CheckRoulette(const std::string &name, const RouletteType &r) const;
+
+  RouletteType fRoulette;
+  std::map<std::string, RouletteType> fRoulettePerParticle;
+
+  // counts of the simulation (all threads, added at the end of each run)
+  long fNbOfRoulette{};
+  long fNbOfKilled{};
+  double fKilledWeight{};
+  double fSurvivalAddedWeight{};
+
+  struct threadLocalT {
+    std::unordered_map<const G4ParticleDefinition *, RouletteType> fParticles;
+    long fNbOfRoulette = 0;
+    long fNbOfKilled = 0;
+    double fKilledWeight = 0;
+    double fSurvivalAddedWeight = 0;
+  };
+  GateThreadLocal<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateRussianRouletteActor_h
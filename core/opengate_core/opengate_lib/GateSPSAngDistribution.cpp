@@ -7,13 +7,95 @@
 
 #include "GateSPSAngDistribution.h"
 #include "GateHelpers.h"
+#include "GateSPSEneDistribution.h"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 G4ThreeVector GateSPSAngDistribution::VGenerateOne() {
   // return GenerateOne();
-  auto direction = GenerateOne();
+  auto direction = IsHistogram2D() ? GenerateHistogram2D() : GenerateOne();
   if (fDirectionRelativeToAttachedVolume) {
     direction = direction / direction.mag();
     direction = fGlobalRotation * direction;
   }
   return direction;
 }
+
+void GateSPSAngDistribution::SetHistogram2D(
+    const std::vector<double> &theta_edges,
+    const std::vector<double> &phi_edges, const std::vector<double> &weights,
+    GateSPSEneDistribution *energy_distribution) {
+  std::vector<AliasEntry>().swap(fHistogramAliasTable);
+  fHistogramEnergyDist = nullptr;
+  fNbHistogramTables = 0;
+  if (theta_edges.size() < 2 || phi_edges.size() < 2) {
+    Fatal("Error in the 2D angular histogram: at least two edges of theta "
+          "and phi are needed.");
+  }
+  fNbHistogramBins = (theta_edges.size() - 1) * (phi_edges.size() - 1);
+  if (weights.empty() || weights.size() % fNbHistogramBins != 0 ||
+      fNbHistogramBins > std::numeric_limits<std::uint32_t>::max()) {
+    std::ostringstream oss;
+    oss << "Error in the 2D angular histogram: the number of weights ("
+        << weights.size() << ") must be a multiple of the number of bins ("
+        << theta_edges.size() - 1 << " x " << phi_edges.size() - 1 << ").";
+    Fatal(oss.str());
+  }
+  fHistogramCosTheta.clear();
+  for (auto theta : theta_edges)
+    fHistogramCosTheta.push_back(std::cos(theta));
+  fHistogramPhi = phi_edges;
+
+  // one alias table per energy, built once
+  fNbHistogramTables = weights.size() / fNbHistogramBins;
+  fHistogramAliasTable.resize(weights.size());
+  for (size_t t = 0; t < fNbHistogramTables; t++) {
+    auto *table = fHistogramAliasTable.data() + t * fNbHistogramBins;
+    const auto *w = weights.data() + t * fNbHistogramBins;
+    double total = 0;
+    for (size_t i = 0; i < fNbHistogramBins; i++)
+      total += std::max(0.0, w[i]);
+    if (total <= 0) {
+      std::ostringstream oss;
+      oss << "Error in the 2D angular histogram: the weights of the table "
+          << t << " are all zero.";
+      Fatal(oss.str());
+    }
+    for (size_t i = 0; i < fNbHistogramBins; i++)
+      table[i].fProbability = std::max(0.0, w[i]) * fNbHistogramBins / total;
+    GateAliasTable::Build(table, fNbHistogramBins);
+  }
+  if (fNbHistogramTables > 1)
+    fHistogramEnergyDist = energy_distribution;
+}
+
+G4ThreeVector GateSPSAngDistribution::GenerateHistogram2D() const {
+  // table of the energy of this particle (sampled before), if any
+  size_t t = 0;
+  if (fHistogramEnergyDist != nullptr) {
+    t = std::min(fHistogramEnergyDist->GetLastBinIndex(),
+                 fNbHistogramTables - 1);
+  }
+  const auto *table = fHistogramAliasTable.data() + t * fNbHistogramBins;
+
+  // bin: the random number selects the entry, and its fractional part
+  // whether the entry or its alias is kept
+  auto const x = G4UniformRand() * fNbHistogramBins;
+  auto const a = std::min(static_cast<size_t>(x), fNbHistogramBins - 1);
+  auto const bin = (x - a) < table[a].fProbability ? a : table[a].fAlias;
+  auto const nb_phi = fHistogramPhi.size() - 1;
+  auto const i = bin / nb_phi;
+  auto const j = bin % nb_phi;
+
+  // isotropic in the bin (uniform in cos(theta) and phi), with the
+  // convention of the G4 angular distributions (towards -z for theta = 0)
+  auto const cos_theta =
+      fHistogramCosTheta[i] +
+      G4UniformRand() * (fHistogramCosTheta[i + 1] - fHistogramCosTheta[i]);
+  auto const sin_theta = std::sqrt(std::max(0.0, 1. - cos_theta * cos_theta));
+  auto const phi = fHistogramPhi[j] +
+                   G4UniformRand() * (fHistogramPhi[j + 1] - fHistogramPhi[j]);
+  return {-sin_theta * std::cos(phi), -sin_theta * std::sin(phi), -cos_theta};
+}
@@ -10,6 +10,11 @@
 
 #include "G4ParticleDefinition.hh"
 #include "G4SPSAngDistribution.hh"
+#include "GateAliasTable.h"
+#include <cstdint>
+#include <vector>
+
+class GateSPSEneDistribution;
 
 class GateSPSAngDistribution : public G4SPSAngDistribution {
 
@@ -19,12 +24,44 @@ public:
   // Cannot inherit from GenerateOne, so we consider VGenerateOne instead
   virtual G4ThreeVector VGenerateOne();
 
+  // 2D (theta, phi) histogram of the directions: the bins are given by the
+  // edges of theta and phi, the weights by bin (theta major, phi minor). The
+  // weights may contain several tables (one after the other): the table is
+  // then selected by the index of the line or bin of the last energy of the
+  // energy distribution (energy-dependent angular distribution).
+  void SetHistogram2D(const std::vector<double> &theta_edges,
+                      const std::vector<double> &phi_edges,
+                      const std::vector<double> &weights,
+                      GateSPSEneDistribution *energy_distribution);
+
+  bool IsHistogram2D() const { return !fHistogramAliasTable.empty(); }
+
+  // The energy must be sampled before the direction
+  bool IsEnergyDependent() const { return fHistogramEnergyDist != nullptr; }
+
+  size_t GetNumberOfHistogramTables() const { return fNbHistogramTables; }
+
   // Store the global orientation that may be applied to the direction
   // in the GenerateOne function.
   // (Must be updated each run)
   bool fDirectionRelativeToAttachedVolume;
   G4ThreeVector fGlobalTranslation;
   G4RotationMatrix fGlobalRotation;
+
+protected:
+  G4ThreeVector GenerateHistogram2D() const;
+
+  // Alias table (Walker/Vose) over the bins of a table, O(1) per sample
+  using AliasEntry = GateAliasTable::Entry;
+
+  // cos(theta) and phi at the edges of the bins
+  std::vector<double> fHistogramCosTheta;
+  std::vector<double> fHistogramPhi;
+  // alias tables of all the energies, one after the other
+  std::vector<AliasEntry> fHistogramAliasTable;
+  size_t fNbHistogramBins = 0;
+  size_t fNbHistogramTables = 0;
+  GateSPSEneDistribution *fHistogramEnergyDist = nullptr;
 };
 
 #endif // GateSPSAngDistribution_h
@@ -11,11 +11,54 @@
 #include "fmt/color.h"
 #include "fmt/core.h"
 #include <Randomize.hh>
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 
 // Parts copied from GateSPSEneDistribution.cc
 
+namespace {
+
+// Fit of the beta+ spectra (E is the kinetic energy + 511 keV), bounded
+// like the previous rejection sampling between 0 and Nmax
+double Fluor18Density(double E) {
+  double a = 10.2088;
+  double b = -30.4551;
+  double c = 28.4376;
+  double d = -7.9828;
+  double n = a * E * E * E + b * E * E + c * E + d;
+  return std::min(std::max(n, 0.0), 0.5209);
+}
+
+double Oxygen15Density(double E) {
+  double a = 3.43874;
+  double b = -9.04016;
+  double c = -7.71579;
+  double d = 13.3147;
+  double e = 32.5321;
+  double f = -18.8379;
+  double n = a * E * E * E * E * E + b * E * E * E * E + c * E * E * E +
+             d * E * E + e * E + f;
+  return std::min(std::max(n, 0.0), 15.88);
+}
+
+double Carbon11Density(double E) {
+  double a = 2.36384;
+  double b = -1.00671;
+  double c = -7.07171;
+  double d = -7.84014;
+  double e = 26.0449;
+  double f = -10.4374;
+  double n = a * E * E * E * E * E + b * E * E * E * E + c * E * E * E +
+             d * E * E + e * E + f;
+  return std::min(std::max(n, 0.0), 2.2);
+}
+
+// number of energies of the inverse CDF of the beta+ spectra
+constexpr size_t kInverseCDFSize = 4096;
+
+} // namespace
+
 G4double GateSPSEneDistribution::VGenerateOne(G4ParticleDefinition *d) {
   if (GetEnergyDisType() == "F18_analytic")
     GenerateFluor18();
@@ -38,77 +81,151 @@ G4double GateSPSEneDistribution::VGenerateOne(G4ParticleDefinition *d) {
   return fParticleEnergy;
 }
 
+void GateSPSEneDistribution::VGenerateBatch(G4ParticleDefinition *d,
+                                            double *energies, size_t n) {
+  if (n == 0)
+    return;
+  const auto type = GetEnergyDisType();
+  if (type == "Mono") {
+    std::fill(energies, energies + n, GetMonoEnergy());
+    fParticleEnergy = energies[n - 1];
+    return;
+  }
+  if (type == "range" || type == "spectrum_discrete" || type == "CDF" ||
+      type == "F18_analytic" || type == "O15_analytic" ||
+      type == "C11_analytic") {
+    // one uniform random number per particle
+    G4Random::getTheEngine()->flatArray(static_cast<int>(n), energies);
+    if (type == "range") {
+      auto e_min = GetEmin();
+      auto e_range = GetEmax() - e_min;
+      for (size_t i = 0; i < n; i++)
+        energies[i] = e_min + energies[i] * e_range;
+    } else if (type == "spectrum_discrete") {
+      for (size_t i = 0; i < n; i++)
+        energies[i] = fEnergyCDF[IndexForProbability(energies[i])];
+    } else if (type != "CDF") {
+      const auto &table = type == "F18_analytic"   ? GetFluor18InverseCDF()
+                          : type == "O15_analytic" ? GetOxygen15InverseCDF()
+                                                   : GetCarbon11InverseCDF();
+      for (size_t i = 0; i < n; i++)
+        energies[i] = EnergyFromInverseCDF(table, energies[i]);
+    } else {
+      for (size_t i = 0; i < n; i++)
+        energies[i] = EnergyFromCDF(energies[i]);
+    }
+    fParticleEnergy = energies[n - 1];
+    return;
+  }
+  // other types, one by one
+  for (size_t i = 0; i < n; i++)
+    energies[i] = VGenerateOne(d);
+}
+
 void GateSPSEneDistribution::GenerateFromCDF() {
-  auto x = G4UniformRand();
-  auto lower =
-      std::lower_bound(fProbabilityCDF.begin(), fProbabilityCDF.end(), x);
-  auto index = std::distance(fProbabilityCDF.begin(), lower) - 1;
+  fParticleEnergy = EnergyFromCDF(G4UniformRand());
+}
+
+double GateSPSEneDistribution::EnergyFromCDF(double x) const {
+  // first element not below x, from the guide table (O(1) on average)
+  // or by binary search
+  std::ptrdiff_t lower;
+  if (fGuideTable.empty()) {
+    lower = std::distance(
+        fProbabilityCDF.begin(),
+        std::lower_bound(fProbabilityCDF.begin(), fProbabilityCDF.end(), x));
+  } else {
+    auto const k = fGuideTable.size();
+    auto const p_min = fProbabilityCDF.front();
+    auto const p_range = fProbabilityCDF.back() - p_min;
+    auto const g = std::min(
+        static_cast<size_t>(std::max(0.0, (x - p_min) / p_range * k)), k - 1);
+    lower = fGuideTable[g];
+    auto const size = static_cast<std::ptrdiff_t>(fProbabilityCDF.size());
+    while (lower < size && fProbabilityCDF[lower] < x)
+      lower++;
+    while (lower > 0 && fProbabilityCDF[lower - 1] >= x)
+      lower--;
+  }
+  auto index = lower - 1;
   // linear interpolation
   auto ratio = (x - fProbabilityCDF[index]) /
                (fProbabilityCDF[index + 1] - fProbabilityCDF[index]);
-  auto E =
-      fEnergyCDF[index] + ratio * (fEnergyCDF[index + 1] - fEnergyCDF[index]);
-  fParticleEnergy = E;
+  return fEnergyCDF[index] +
+         ratio * (fEnergyCDF[index + 1] - fEnergyCDF[index]);
 }
 
 void GateSPSEneDistribution::GenerateFluor18() {
-  // Fit parameters for the Fluor18 spectra
-  G4double a = 10.2088;
-  G4double b = -30.4551;
-  G4double c = 28.4376;
-  G4double d = -7.9828;
-  G4double E;
-  G4double u;
-  G4double energyF18 = 0.;
-  do {
-    E = G4RandFlat::shoot(0.511, 1.144); // Emin = 0.511 ; Emax = 1.144
-    u = G4RandFlat::shoot(0.5209);       // Nmin = 0 ; Nmax = 0.5209
-    energyF18 = E;
-  } while (u > a * E * E * E + b * E * E + c * E + d);
-  G4double energyFluor = energyF18 - 0.511;
-  fParticleEnergy = energyFluor;
+  fParticleEnergy =
+      EnergyFromInverseCDF(GetFluor18InverseCDF(), G4UniformRand());
 }
 
 void GateSPSEneDistribution::GenerateOxygen15() {
-  // Fit parameters for the Oxygen15 spectra
-  G4double a = 3.43874;
-  G4double b = -9.04016;
-  G4double c = -7.71579;
-  G4double d = 13.3147;
-  G4double e = 32.5321;
-  G4double f = -18.8379;
-  G4double E;
-  G4double u;
-  G4double energyO15 = 0.;
-  do {
-    E = CLHEP::RandFlat::shoot(0.511, 2.249); // Emin ; Emax
-    u = CLHEP::RandFlat::shoot(0., 15.88);    // Nmin ; Nmax
-    energyO15 = E;
-  } while (u > a * E * E * E * E * E + b * E * E * E * E + c * E * E * E +
-                   d * E * E + e * E + f);
-  G4double energyOxygen = energyO15 - 0.511;
-  fParticleEnergy = energyOxygen;
+  fParticleEnergy =
+      EnergyFromInverseCDF(GetOxygen15InverseCDF(), G4UniformRand());
 }
 
 void GateSPSEneDistribution::GenerateCarbon11() {
-  // Fit parameters for the Carbon11 spectra
-  G4double a = 2.36384;
-  G4double b = -1.00671;
-  G4double c = -7.07171;
-  G4double d = -7.84014;
-  G4double e = 26.0449;
-  G4double f = -10.4374;
-  G4double E;
-  G4double u;
-  G4double energyC11 = 0.;
-  do {
-    E = CLHEP::RandFlat::shoot(0.511, 1.47); // Emin ; Emax
-    u = CLHEP::RandFlat::shoot(0., 2.2);     // Nmin ; Nmax
-    energyC11 = E;
-  } while (u > a * E * E * E * E * E + b * E * E * E * E + c * E * E * E +
-                   d * E * E + e * E + f);
-  G4double energyCarbon = energyC11 - 0.511;
-  fParticleEnergy = energyCarbon;
+  fParticleEnergy =
+      EnergyFromInverseCDF(GetCarbon11InverseCDF(), G4UniformRand());
+}
+
+const std::vector<double> &GateSPSEneDistribution::GetFluor18InverseCDF() {
+  // built once, shared by all threads (and read-only)
+  static const auto table =
+      BuildInverseCDF(Fluor18Density, 0.511, 1.144, kInverseCDFSize);
+  return table;
+}
+
+const std::vector<double> &GateSPSEneDistribution::GetOxygen15InverseCDF() {
+  static const auto table =
+      BuildInverseCDF(Oxygen15Density, 0.511, 2.249, kInverseCDFSize);
+  return table;
+}
+
+const std::vector<double> &GateSPSEneDistribution::GetCarbon11InverseCDF() {
+  static const auto table =
+      BuildInverseCDF(Carbon11Density, 0.511, 1.47, kInverseCDFSize);
+  return table;
+}
+
+std::vector<double>
+GateSPSEneDistribution::BuildInverseCDF(double (*density)(double),
+                                        double e_min, double e_max, size_t n) {
+  // cumulative integral of the density on a fine grid (midpoint rule)
+  auto const m = 16 * n;
+  auto const width = (e_max - e_min) / m;
+  std::vector<double> cumulative(m + 1, 0.0);
+  for (size_t j = 0; j < m; j++)
+    cumulative[j + 1] =
+        cumulative[j] + density(e_min + (j + 0.5) * width) * width;
+
+  // energy at each k / n of the integral, the density is constant in the
+  // bins of the grid. The table holds the kinetic energy (without 511 keV)
+  std::vector<double> table(n + 1);
+  table[0] = e_min;
+  table[n] = e_max;
+  size_t j = 0;
+  for (size_t k = 1; k < n; k++) {
+    auto const target = cumulative[m] * k / n;
+    while (cumulative[j + 1] <= target)
+      j++;
+    auto const ratio =
+        (target - cumulative[j]) / (cumulative[j + 1] - cumulative[j]);
+    table[k] = e_min + (j + ratio) * width;
+  }
+  for (auto &e : table)
+    e -= 0.511;
+  return table;
+}
+
+double
+GateSPSEneDistribution::EnergyFromInverseCDF(const std::vector<double> &table,
+                                             double u) {
+  auto const n = table.size() - 1;
+  auto const x = u * n;
+  auto const i = std::min(static_cast<size_t>(x), n - 1);
+  return table[i] + (x - i) * (table[i + 1] - table[i]);
 }
 
 void GateSPSEneDistribution::GenerateRange() {
@@ -118,16 +235,19 @@ void GateSPSEneDistribution::GenerateRange() {
 
 void GateSPSEneDistribution::GenerateSpectrumLines() {
   auto const i = IndexForProbability(G4UniformRand());
+  fLastBinIndex = i;
   fParticleEnergy = fEnergyCDF[i];
 }
 
 void GateSPSEneDistribution::GenerateSpectrumHistogram() {
   auto const i = IndexForProbability(G4UniformRand());
+  fLastBinIndex = i;
   fParticleEnergy = G4RandFlat::shoot(fEnergyCDF[i], fEnergyCDF[i + 1]);
 }
 
 void GateSPSEneDistribution::GenerateSpectrumHistogramInterpolated() {
   auto const i = IndexForProbability(G4UniformRand());
+  fLastBinIndex = i;
 
   auto const a = (fEnergyCDF[i] + fEnergyCDF[i + 1]) / 2;
   auto const b = (fEnergyCDF[i + 1] + fEnergyCDF[i + 2]) / 2;
@@ -155,8 +275,69 @@ std::size_t GateSPSEneDistribution::IndexForProbability(double p) const {
   // p in ]0, 1[
   // see
   // https://geant4-forum.web.cern.ch/t/what-is-the-range-of-numbers-generated-by-g4uniformrand/5187
-  auto i = 0;
-  while (p >= (fProbabilityCDF[i])) // TODO -> std::
-    i++;
-  return i;
+  if (!fAliasTable.empty()) {
+    // alias table: p selects the entry, and its fractional part whether the
+    // entry or its alias is kept (a single random number)
+    auto const n = fAliasTable.size();
+    auto const x = p * n;
+    auto const a = std::min(static_cast<size_t>(x), n - 1);
+    auto const &entry = fAliasTable[a];
+    return (x - a) < entry.fProbability ? a : entry.fAlias;
+  }
+  // first bin whose cumulative probability is above p (binary search)
+  auto it =
+      std::upper_bound(fProbabilityCDF.begin(), fProbabilityCDF.end(), p);
+  return std::distance(fProbabilityCDF.begin(), it);
+}
+
+void GateSPSEneDistribution::InitializeSamplingTables() {
+  std::vector<AliasEntry>().swap(fAliasTable);
+  std::vector<std::uint32_t>().swap(fGuideTable);
+  auto const type = GetEnergyDisType();
+  auto const n = fProbabilityCDF.size();
+  if (n == 0 || n > std::numeric_limits<std::uint32_t>::max())
+    return;
+
+  if (type == "CDF") {
+    // one interval of probability per element of the CDF
+    auto const p_min = fProbabilityCDF.front();
+    auto const p_range = fProbabilityCDF.back() - p_min;
+    if (p_range <= 0)
+      return;
+    fGuideTable.resize(n);
+    size_t lower = 0;
+    for (size_t k = 0; k < n; k++) {
+      auto const p = p_min + p_range * k / n;
+      while (lower < n && fProbabilityCDF[lower] < p)
+        lower++;
+      fGuideTable[k] = lower;
+    }
+    return;
+  }
+
+  if (type == "F18_analytic")
+    GetFluor18InverseCDF();
+  if (type == "O15_analytic")
+    GetOxygen15InverseCDF();
+  if (type == "C11_analytic")
+    GetCarbon11InverseCDF();
+
+  if (type != "spectrum_discrete" && type != "spectrum_histogram" &&
+      type != "spectrum_histogram_linear")
+    return;
+
+  // the probability of the index i (see IndexForProbability) is the step of
+  // the cumulative probabilities; scaled so that their mean is 1
+  auto const total = fProbabilityCDF.back();
+  if (total <= 0)
+    return;
+  std::vector<AliasEntry>(n).swap(fAliasTable);
+  double previous = 0;
+  for (size_t i = 0; i < n; i++) {
+    auto const p = std::max(0.0, fProbabilityCDF[i] - previous);
+    previous = fProbabilityCDF[i];
+    fAliasTable[i].fProbability = p * n / total;
+  }
+
+  GateAliasTable::Build(fAliasTable);
 }
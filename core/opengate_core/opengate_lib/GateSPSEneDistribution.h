@@ -9,6 +9,9 @@
 #define GateSPSEneDistribution_h
 
 #include "G4SPSEneDistribution.hh"
+#include "GateAliasTable.h"
+#include <cstdint>
+#include <vector>
 
 class GateSPSEneDistribution : public G4SPSEneDistribution {
 
@@ -34,6 +37,20 @@ public:
   // Cannot inherit from GenerateOne
   virtual G4double VGenerateOne(G4ParticleDefinition *);
 
+  // Generate n energies: the type is resolved once, and the uniform random
+  // numbers drawn in bulk for the types that need one per particle
+  virtual void VGenerateBatch(G4ParticleDefinition *d, double *energies,
+                              size_t n);
+
+  // Build the sampling tables of the current type, once fProbabilityCDF and
+  // fEnergyCDF are set: alias table for the spectra (lines or histograms),
+  // guide table for the CDF. Without them, binary search (slower).
+  void InitializeSamplingTables();
+
+  // Index of the line or bin of the last energy of a spectrum (e.g. to
+  // select an energy-dependent angular distribution)
+  std::size_t GetLastBinIndex() const { return fLastBinIndex; }
+
   double fParticleEnergy;
 
   std::vector<double> fProbabilityCDF;
@@ -41,6 +58,33 @@ public:
 
 private:
   std::size_t IndexForProbability(double p) const;
+
+  double EnergyFromCDF(double u) const;
+
+  // Energies at equally spaced values of the cumulative distribution
+  // function of this density (inverse CDF), sampled by linear interpolation
+  static std::vector<double> BuildInverseCDF(double (*density)(double),
+                                             double e_min, double e_max,
+                                             size_t n);
+
+  static double EnergyFromInverseCDF(const std::vector<double> &table,
+                                     double u);
+
+  // beta+ spectra (fit of the kinetic energy + 511 keV)
+  static const std::vector<double> &GetFluor18InverseCDF();
+  static const std::vector<double> &GetOxygen15InverseCDF();
+  static const std::vector<double> &GetCarbon11InverseCDF();
+
+  // Alias table (Walker/Vose) over the bins of fProbabilityCDF, O(1) per
+  // sample: keep the bin with this probability, otherwise take the alias
+  using AliasEntry = GateAliasTable::Entry;
+  std::vector<AliasEntry> fAliasTable;
+
+  // Guide table of fProbabilityCDF: first index of each of the equally
+  // spaced intervals of probability, the search starts from there
+  std::vector<std::uint32_t> fGuideTable;
+
+  std::size_t fLastBinIndex = 0;
 };
 
 #endif // GateSPSEneDistribution_h
@@ -6,8 +6,13 @@
    -------------------------------------------------- */
 
 #include "GateSPSVoxelsPosDistribution.h"
+#include "GateAliasTable.h"
 #include "GateHelpers.h"
+#include "GateHugePages.h"
 #include <Randomize.hh>
+#include <algorithm>
+#include <limits>
+#include <sstream>
 
 GateSPSVoxelsPosDistribution::GateSPSVoxelsPosDistribution() {
   // Create the image pointer
@@ -22,17 +27,207 @@ GateSPSVoxelsPosDistribution::GateSPSVoxelsPosDistribution() {
 void GateSPSVoxelsPosDistribution::SetCumulativeDistributionFunction(VD vz,
                                                                      VD2 vy,
                                                                      VD3 vx) {
-  // Warning : this is a COPY of all cumulative distribution functions
-  fCDFZ = vz;
-  fCDFY = vy;
-  fCDFX = vx;
+  // The vectors are copies (py to cpp), they are moved, not copied again
+  fCDFZ = std::move(vz);
+  fCDFY = std::move(vy);
+  fCDFX = std::move(vx);
+  std::vector<AliasEntry>().swap(fAliasTable);
+  std::vector<std::uint32_t>().swap(fChannelVoxels);
+  std::vector<size_t>().swap(fChannelOffsets);
 }
 
-G4ThreeVector GateSPSVoxelsPosDistribution::VGenerateOne() {
+void GateSPSVoxelsPosDistribution::SetAliasTable(const double *activity,
+                                                 size_t size_x, size_t size_y,
+                                                 size_t size_z) {
+  // no CDF anymore
+  VD().swap(fCDFZ);
+  VD2().swap(fCDFY);
+  VD3().swap(fCDFX);
+  std::vector<std::uint32_t>().swap(fChannelVoxels);
+  std::vector<size_t>().swap(fChannelOffsets);
+  fSizeX = size_x;
+  fSizeY = size_y;
+
+  // non-zero voxels
+  auto nb_voxels = size_x * size_y * size_z;
+  if (nb_voxels > std::numeric_limits<std::uint32_t>::max()) {
+    std::ostringstream oss;
+    oss << "Too many voxels for the voxel source alias table: " << nb_voxels;
+    Fatal(oss.str());
+  }
+  double total = 0;
+  size_t n = 0;
+  for (size_t v = 0; v < nb_voxels; v++) {
+    if (activity[v] < 0) {
+      std::ostringstream oss;
+      oss << "Negative activity " << activity[v] << " in the voxel " << v
+          << " of the voxel source";
+      Fatal(oss.str());
+    }
+    if (activity[v] > 0) {
+      total += activity[v];
+      n++;
+    }
+  }
+  if (n == 0)
+    Fatal("The activity image of the voxel source is empty (zero everywhere)");
+
+  // the probabilities are scaled so that their mean is 1
+  GateHugePages::Assign(fAliasTable, n, AliasEntry(), "voxel_source");
+  size_t e = 0;
+  for (size_t v = 0; v < nb_voxels; v++) {
+    if (activity[v] > 0) {
+      fAliasTable[e].fProbability = activity[v] * n / total;
+      fAliasTable[e].fVoxel = v;
+      e++;
+    }
+  }
+  GateAliasTable::Build(fAliasTable);
+}
+
+void GateSPSVoxelsPosDistribution::SetChannels(const std::int32_t *channels,
+                                               size_t size_x, size_t size_y,
+                                               size_t size_z,
+                                               size_t nb_channels) {
+  // no CDF nor alias table of the voxels anymore
+  VD().swap(fCDFZ);
+  VD2().swap(fCDFY);
+  VD3().swap(fCDFX);
+  std::vector<AliasEntry>().swap(fAliasTable);
+  fSizeX = size_x;
+  fSizeY = size_y;
+
+  auto nb_voxels = size_x * size_y * size_z;
+  if (nb_voxels > std::numeric_limits<std::uint32_t>::max()) {
+    std::ostringstream oss;
+    oss << "Too many voxels for the multi-channel voxel source: " << nb_voxels;
+    Fatal(oss.str());
+  }
+  // counting sort of the voxels by channel
+  std::vector<size_t> offsets(nb_channels + 1, 0);
+  for (size_t v = 0; v < nb_voxels; v++) {
+    auto c = channels[v];
+    if (c < 0)
+      continue;
+    if (static_cast<size_t>(c) >= nb_channels) {
+      std::ostringstream oss;
+      oss << "Channel " << c << " of the voxel " << v
+          << " is not in the channels of the source (" << nb_channels << ")";
+      Fatal(oss.str());
+    }
+    offsets[c + 1]++;
+  }
+  for (size_t c = 0; c < nb_channels; c++)
+    offsets[c + 1] += offsets[c];
+  std::vector<std::uint32_t> voxels(offsets.back());
+  auto next = offsets;
+  for (size_t v = 0; v < nb_voxels; v++) {
+    if (channels[v] >= 0)
+      voxels[next[channels[v]]++] = v;
+  }
+  fChannelVoxels = std::move(voxels);
+  fChannelOffsets = std::move(offsets);
+}
+
+void GateSPSVoxelsPosDistribution::SetChannelActivities(
+    const std::vector<double> &activities) {
+  auto &l = fThreadLocalData.Get();
+  if (activities == l.fChannelActivities)
+    return;
+  if (activities.size() != GetNumberOfChannels()) {
+    std::ostringstream oss;
+    oss << "The multi-channel voxel source has " << GetNumberOfChannels()
+        << " channels, but " << activities.size() << " activities are given";
+    Fatal(oss.str());
+  }
+  // the empty channels are never sampled
+  double total = 0;
+  for (size_t c = 0; c < activities.size(); c++) {
+    if (activities[c] < 0) {
+      std::ostringstream oss;
+      oss << "Negative activity " << activities[c] << " of the channel " << c
+          << " of the voxel source";
+      Fatal(oss.str());
+    }
+    if (GetNumberOfChannelVoxels(c) > 0)
+      total += activities[c];
+  }
+  if (total <= 0)
+    Fatal("The activity of the multi-channel voxel source is zero in all its "
+          "(non-empty) channels");
+  auto n = activities.size();
+  l.fChannelTable.resize(n);
+  for (size_t c = 0; c < n; c++) {
+    auto a = GetNumberOfChannelVoxels(c) > 0 ? activities[c] : 0;
+    l.fChannelTable[c].fProbability = a * n / total;
+    l.fChannelTable[c].fVoxel = c;
+  }
+  GateAliasTable::Build(l.fChannelTable);
+  l.fChannelActivities = activities;
+}
+
+size_t GateSPSVoxelsPosDistribution::GetNumberOfChannels() const {
+  return fChannelOffsets.empty() ? 0 : fChannelOffsets.size() - 1;
+}
+
+size_t
+GateSPSVoxelsPosDistribution::GetNumberOfChannelVoxels(size_t channel) const {
+  if (channel >= GetNumberOfChannels())
+    return 0;
+  return fChannelOffsets[channel + 1] - fChannelOffsets[channel];
+}
+
+void GateSPSVoxelsPosDistribution::SampleVoxel(int &i, int &j, int &k) const {
+  if (!fChannelOffsets.empty())
+    SampleVoxelWithChannels(i, j, k);
+  else if (fAliasTable.empty())
+    SampleVoxelWithCDF(i, j, k);
+  else
+    SampleVoxelWithAliasTable(i, j, k);
+}
+
+void GateSPSVoxelsPosDistribution::LinearIndexToVoxel(size_t v, int &i,
+                                                      int &j, int &k) const {
+  k = v % fSizeX;
+  j = (v / fSizeX) % fSizeY;
+  i = v / (fSizeX * fSizeY);
+}
+
+void GateSPSVoxelsPosDistribution::SampleVoxelWithAliasTable(int &i, int &j,
+                                                             int &k) const {
+  // G4UniformRand : default boundaries ]0.1[ for operator()().
+  auto n = fAliasTable.size();
+  auto a = std::min(static_cast<size_t>(G4UniformRand() * n), n - 1);
+  const auto &entry = fAliasTable[a];
+  auto v = G4UniformRand() < entry.fProbability
+               ? entry.fVoxel
+               : fAliasTable[entry.fAlias].fVoxel;
+  LinearIndexToVoxel(v, i, j, k);
+}
+
+void GateSPSVoxelsPosDistribution::SampleVoxelWithChannels(int &i, int &j,
+                                                           int &k) const {
+  // channel (alias table of the thread), then a voxel of the channel
+  const auto &table = fThreadLocalData.Get().fChannelTable;
+  if (table.empty())
+    Fatal("The activities of the multi-channel voxel source are not set");
+  auto n = table.size();
+  auto a = std::min(static_cast<size_t>(G4UniformRand() * n), n - 1);
+  const auto &entry = table[a];
+  auto c = G4UniformRand() < entry.fProbability ? entry.fVoxel
+                                                : table[entry.fAlias].fVoxel;
+  auto first = fChannelOffsets[c];
+  auto nv = fChannelOffsets[c + 1] - first;
+  auto v = std::min(static_cast<size_t>(G4UniformRand() * nv), nv - 1);
+  LinearIndexToVoxel(fChannelVoxels[first + v], i, j, k);
+}
+
+void GateSPSVoxelsPosDistribution::SampleVoxelWithCDF(int &i, int &j,
+                                                      int &k) const {
   // G4UniformRand : default boundaries ]0.1[ for operator()().
 
   // Get Cumulative Distribution Function for Z
-  auto i = 0;
+  i = 0;
   do {
     auto p = G4UniformRand();
     auto lower = std::lower_bound(fCDFZ.begin(), fCDFZ.end(), p);
@@ -40,7 +235,7 @@ G4ThreeVector GateSPSVoxelsPosDistribution::VGenerateOne() {
   } while (i >= (int)fCDFX.size());
 
   // Get Cumulative Distribution Function for Y, knowing Z
-  auto j = 0;
+  j = 0;
   do {
     auto p = G4UniformRand();
     auto lower = std::lower_bound(fCDFY[i].begin(), fCDFY[i].end(), p);
@@ -48,12 +243,17 @@ G4ThreeVector GateSPSVoxelsPosDistribution::VGenerateOne() {
   } while (j >= (int)fCDFX[i].size());
 
   // Get Cumulative Distribution Function for X, knowing X and Y
-  auto k = 0;
+  k = 0;
   do {
     auto p = G4UniformRand();
     auto lower = std::lower_bound(fCDFX[i][j].begin(), fCDFX[i][j].end(), p);
     k = std::distance(fCDFX[i][j].begin(), lower);
   } while (k >= (int)fCDFX[i][j].size());
+}
+
+G4ThreeVector GateSPSVoxelsPosDistribution::VGenerateOne() {
+  int i, j, k;
+  SampleVoxel(i, j, k);
 
   // convert to physical coordinate
   // (warning to the numpy order Z Y X)
@@ -75,33 +275,9 @@ G4ThreeVector GateSPSVoxelsPosDistribution::VGenerateOne() {
 }
 
 std::vector<int> GateSPSVoxelsPosDistribution::VGenerateOneDebug() {
-  // G4UniformRand : default boundaries ]0.1[ for operator()().
-
-  // Get Cumulative Distribution Function for Z
-  auto i = 0;
-  do {
-    auto p = G4UniformRand();
-    auto lower = std::lower_bound(fCDFZ.begin(), fCDFZ.end(), p);
-    i = std::distance(fCDFZ.begin(), lower);
-  } while (i >= (int)fCDFX.size());
-
-  // Get Cumulative Distribution Function for Y, knowing Z
-  auto j = 0;
-  do {
-    auto p = G4UniformRand();
-    auto lower = std::lower_bound(fCDFY[i].begin(), fCDFY[i].end(), p);
-    j = std::distance(fCDFY[i].begin(), lower);
-  } while (j >= (int)fCDFX[i].size());
-
-  // Get Cumulative Distribution Function for X, knowing X and Y
-  auto k = 0;
-  do {
-    auto p = G4UniformRand();
-    auto lower = std::lower_bound(fCDFX[i][j].begin(), fCDFX[i][j].end(), p);
-    k = std::distance(fCDFX[i][j].begin(), lower);
-  } while (k >= (int)fCDFX[i][j].size());
+  int i, j, k;
+  SampleVoxel(i, j, k);
 
-  // convert to physical coordinate
   // (warning to the numpy order Z Y X)
   std::vector<int> index = {k, j, i};
 
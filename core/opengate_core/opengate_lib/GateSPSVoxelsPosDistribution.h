@@ -8,8 +8,10 @@
 #ifndef GateSPSVoxelsPosDistribution_h
 #define GateSPSVoxelsPosDistribution_h
 
+#include <cstdint>
 #include <utility>
 
+#include "G4Cache.hh"
 #include "G4ParticleDefinition.hh"
 #include "GateSPSPosDistribution.h"
 #include "itkImage.h"
@@ -34,6 +36,30 @@ public:
 
   void SetCumulativeDistributionFunction(VD vz, VD2 vy, VD3 vx);
 
+  // Alternative to the CDF: alias table (Walker/Vose) over the non-zero
+  // voxels, O(1) per sample. The activity is a contiguous array in numpy
+  // order (Z Y X). Replaces the CDF (and conversely).
+  void SetAliasTable(const double *activity, size_t size_x, size_t size_y,
+                     size_t size_z);
+
+  size_t GetNumberOfAliasEntries() const { return fAliasTable.size(); }
+
+  // Multi-channel mode (see GateMultiChannelVoxelSource): the channel of
+  // each voxel (numpy order Z Y X, -1 for no channel) is given once and the
+  // voxels of a channel are sampled uniformly. The channel is sampled with
+  // an alias table on the channel activities. Replaces the CDF and the alias
+  // table of the voxels.
+  void SetChannels(const std::int32_t *channels, size_t size_x, size_t size_y,
+                   size_t size_z, size_t nb_channels);
+
+  // Alias table of the channels of the current thread, only built again if
+  // the activities change (e.g. TAC, between two runs)
+  void SetChannelActivities(const std::vector<double> &activities);
+
+  size_t GetNumberOfChannels() const;
+
+  size_t GetNumberOfChannelVoxels(size_t channel) const;
+
   // Image type is 3D float by default (the pixel data are not used
   // nor even allocated. Only useful to convert pixel coordinates
   // to physical coordinates.
@@ -47,9 +73,43 @@ public:
   G4RotationMatrix fGlobalRotation;
 
 protected:
+  // voxel (i, j, k) index, in numpy order Z Y X
+  void SampleVoxel(int &i, int &j, int &k) const;
+
+  void SampleVoxelWithCDF(int &i, int &j, int &k) const;
+
+  void SampleVoxelWithAliasTable(int &i, int &j, int &k) const;
+
+  void SampleVoxelWithChannels(int &i, int &j, int &k) const;
+
+  void LinearIndexToVoxel(size_t v, int &i, int &j, int &k) const;
+
   VD3 fCDFX;
   VD2 fCDFY;
   VD fCDFZ;
+
+  // One entry per non-zero voxel: keep the voxel with this probability,
+  // otherwise take the voxel of the alias entry
+  struct AliasEntry {
+    double fProbability;
+    std::uint32_t fAlias;
+    std::uint32_t fVoxel; // linear index in the Z Y X array
+  };
+  std::vector<AliasEntry> fAliasTable;
+  size_t fSizeX = 0;
+  size_t fSizeY = 0;
+
+  // multi-channel mode: the voxels (linear index) sorted by channel, the
+  // voxels of the channel c are [offsets[c], offsets[c+1][
+  std::vector<std::uint32_t> fChannelVoxels;
+  std::vector<size_t> fChannelOffsets;
+
+  // alias table of the channels (fVoxel: channel), per thread
+  struct threadLocalT {
+    std::vector<AliasEntry> fChannelTable;
+    std::vector<double> fChannelActivities;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
 };
 
 #endif // GateSPSVoxelsPosDistribution_h
@@ -6,13 +6,22 @@
    -------------------------------------------------- */
 
 #include "GateSimulationStatisticsActor.h"
+#include "GateActorProfiler.h"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
+#include "GateMemoryAccounting.h"
+#include "GatePerfCounters.h"
+#include "digitizer/GateDigiCollectionsRootManager.h"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4VProcess.hh"
+#include "GateMutex.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <sstream>
 
-G4Mutex GateSimulationStatisticsActorMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(GateSimulationStatisticsActorMutex);
 
 using namespace pybind11::literals;
 
@@ -40,6 +49,21 @@ void GateSimulationStatisticsActor::InitializeUserInfo(py::dict &user_info) {
   GateVActor::InitializeUserInfo(user_info);
 
   fTrackTypesFlag = DictGetBool(user_info, "track_types_flag");
+  // steps per (volume, particle, process), with a sampled time (0: no time)
+  fStepTypesFlag = DictGetBool(user_info, "step_types_flag");
+  fStepTypesTimeSampling = DictGetInt(user_info, "step_types_time_sampling");
+  // timing of the callbacks of the actors and sources (see GateActorProfiler)
+  fProfileFlag = DictGetBool(user_info, "profile_actors");
+  GateActorProfiler::Enable(fProfileFlag,
+                            DictGetInt(user_info, "profile_sampling_interval"));
+  // memory of the components (see GateMemoryAccounting). Reset here: some
+  // components allocate before the start of the simulation
+  fMemoryFlag = DictGetBool(user_info, "memory_flag");
+  GateMemoryAccounting::Enable(fMemoryFlag);
+  GateMemoryAccounting::Reset();
+  // hardware counters per thread and phase (see GatePerfCounters)
+  fPerfCountersFlag = DictGetBool(user_info, "perf_counters_flag");
+  GatePerfCounters::Enable(fPerfCountersFlag);
 }
 
 void GateSimulationStatisticsActor::StartSimulationAction() {
@@ -61,6 +85,13 @@ void GateSimulationStatisticsActor::StartSimulationAction() {
   fCounts["events"] = 0;
   fCounts["tracks"] = 0;
   fCounts["steps"] = 0;
+  fStepTypes.clear();
+  if (fProfileFlag)
+    GateActorProfiler::Reset();
+  if (fPerfCountersFlag) {
+    GatePerfCounters::Reset();
+    GatePerfCounters::StartPhase("init");
+  }
 }
 
 py::dict GateSimulationStatisticsActor::GetCounts() {
@@ -70,29 +101,58 @@ py::dict GateSimulationStatisticsActor::GetCounts() {
       "duration"_a = fCountsD["duration"], "init"_a = fCountsD["init"],
       "start_time"_a = fCountsStr["start_time"],
       "stop_time"_a = fCountsStr["stop_time"], "track_types"_a = fTrackTypes);
+  if (fProfileFlag)
+    dd["profile"] = GateActorProfiler::GetResults();
+  if (fMemoryFlag)
+    dd["memory"] = GateMemoryAccounting::GetResults();
+  if (fPerfCountersFlag)
+    dd["perf_counters"] = GatePerfCounters::GetResults();
+  if (fStepTypesFlag) {
+    // {volume: {particle: {process: counts}}}, the time of all the steps is
+    // estimated from the sampled ones
+    py::dict step_types;
+    for (const auto &v : fStepTypes) {
+      auto volume = py::str(std::get<0>(v.first));
+      auto particle = py::str(std::get<1>(v.first));
+      auto process = py::str(std::get<2>(v.first));
+      if (!step_types.contains(volume))
+        step_types[volume] = py::dict();
+      py::dict particles = step_types[volume];
+      if (!particles.contains(particle))
+        particles[particle] = py::dict();
+      py::dict processes = particles[particle];
+      const auto &c = v.second;
+      double time = 0;
+      if (c.fSampledSteps > 0)
+        time = c.fSampledTime * c.fSteps / c.fSampledSteps;
+      processes[process] =
+          py::dict("steps"_a = c.fSteps, "sampled_steps"_a = c.fSampledSteps,
+                   "sampled_time"_a = c.fSampledTime, "time"_a = time);
+    }
+    dd["step_types"] = step_types;
+  }
+  // basket and compression of the ROOT files written by the digitizers
+  auto root_output =
+      GateDigiCollectionsRootManager::GetInstance()->GetRootFileOptions();
+  if (!root_output.empty())
+    dd["root_output"] = root_output;
   return dd;
 }
 
-void GateSimulationStatisticsActor::BeginOfRunAction(const G4Run *run) {
+void GateSimulationStatisticsActor::BeginOfRunAction(const G4Run * /*run*/) {
   // Called every time a run starts
-  if (run->GetRunID() == 0) {
-    if (!G4Threading::IsMultithreadedApplication())
-      fStartRunTime = std::chrono::system_clock::now();
-    else {
-      if (!fStartRunTimeIsSet) {
-        // StartRunTime for the first run to start
-        G4AutoLock mutex(&GateSimulationStatisticsActorMutex);
-        fStartRunTime = std::chrono::system_clock::now();
-        fStartRunTimeIsSet = true;
-      }
-    }
-    // Initialise the thread local data
-    threadLocal_t &data = threadLocalData.Get();
-    data.fRunCount = 0;
-    data.fEventCount = 0;
-    data.fTrackCount = 0;
-    data.fStepCount = 0;
+  // (the first run is not always the run 0, e.g. for a resumed simulation)
+  GateAutoLock mutex(&GateSimulationStatisticsActorMutex);
+  if (!fStartRunTimeIsSet) {
+    // StartRunTime for the first run to start
+    fStartRunTime = std::chrono::system_clock::now();
+    fStartRunTimeIsSet = true;
+    // (the initialization is done by the master thread)
+    if (fPerfCountersFlag)
+      GatePerfCounters::StopPhase("init", -1);
   }
+  if (fPerfCountersFlag)
+    GatePerfCounters::StartPhase("tracking");
 }
 
 void GateSimulationStatisticsActor::PreUserTrackingAction(
@@ -100,46 +160,145 @@ void GateSimulationStatisticsActor::PreUserTrackingAction(
   // Called every time a track starts
   threadLocal_t &data = threadLocalData.Get();
   data.fTrackCount++;
-  if (fTrackTypesFlag) {
-    auto p = track->GetParticleDefinition()->GetParticleName();
-    data.fTrackTypes[p]++;
+  if (fTrackTypesFlag)
+    CountTrackType(track->GetParticleDefinition());
+  // the time between two tracks is not the one of a step
+  if (data.fTimeNextStep)
+    data.fLastStepTime = std::chrono::steady_clock::now();
+}
+
+void GateSimulationStatisticsActor::CountTrackType(
+    const G4ParticleDefinition *particle) {
+  // No lock and no string: a counter per particle definition id, in a
+  // vector of the thread (a few dozen particles, more with the ions)
+  threadLocal_t &data = threadLocalData.Get();
+  auto id = particle->GetParticleDefinitionID();
+  if (id < 0) {
+    data.fOtherTrackTypes[particle]++;
+    return;
+  }
+  if (id >= static_cast<int>(data.fTrackTypeCounts.size())) {
+    data.fTrackTypeCounts.resize(id + 1, 0);
+    data.fTrackTypeParticles.resize(id + 1, nullptr);
   }
+  data.fTrackTypeCounts[id]++;
+  data.fTrackTypeParticles[id] = particle;
 }
 
-void GateSimulationStatisticsActor::SteppingAction(G4Step *) {
+void GateSimulationStatisticsActor::SteppingAction(G4Step *step) {
   // Called every step
   threadLocalData.Get().fStepCount++;
+  if (fStepTypesFlag)
+    CountStepType(step);
 }
 
-void GateSimulationStatisticsActor::EndOfRunAction(const G4Run *run) {
-  // Called every time a run ends
+void GateSimulationStatisticsActor::CountStepType(G4Step *step) {
+  // No lock: each thread counts in its own map, merged at the end of run.
+  // The time of a step is the time since the previous stepping action of the
+  // thread: it includes the transportation and the physics of the step, and
+  // the stepping actions of the actors.
   threadLocal_t &data = threadLocalData.Get();
-  data.fRunCount++;
-  data.fEventCount += run->GetNumberOfEvent();
+  const auto *volume =
+      step->GetPreStepPoint()->GetTouchable()->GetVolume()->GetLogicalVolume();
+  const auto *particle = step->GetTrack()->GetParticleDefinition();
+  const auto *process = step->GetPostStepPoint()->GetProcessDefinedStep();
+  auto &c = data.fStepTypes[StepTypeKey(volume, particle, process)];
+  c.fSteps++;
+  if (fStepTypesTimeSampling <= 0)
+    return;
+  if (data.fTimeNextStep) {
+    auto d = std::chrono::steady_clock::now() - data.fLastStepTime;
+    c.fSampledSteps++;
+    c.fSampledTime +=
+        std::chrono::duration<double, std::nano>(d).count() * CLHEP::ns;
+  }
+  data.fStepTypesSampleCounter++;
+  data.fTimeNextStep =
+      data.fStepTypesSampleCounter % fStepTypesTimeSampling == 0;
+  if (data.fTimeNextStep)
+    data.fLastStepTime = std::chrono::steady_clock::now();
 }
 
-void GateSimulationStatisticsActor::EndOfSimulationWorkerAction(
-    const G4Run * /*lastRun*/) {
-  // Called every time the simulation is about to end, by ALL threads
-  // So, the data are merged (need a mutex lock)
-  G4AutoLock mutex(&GateSimulationStatisticsActorMutex);
+void GateSimulationStatisticsActor::EndOfRunAction(const G4Run *run) {
+  // Called every time a run ends, by ALL threads
+  // The counts of the run are merged (need a mutex lock), so that they are
+  // available at the end of each run (e.g. for a checkpoint)
   threadLocal_t &data = threadLocalData.Get();
-  // merge all threads (need mutex)
-  fCounts["runs"] += data.fRunCount;
-  fCounts["events"] += data.fEventCount;
+  if (fPerfCountersFlag) {
+    GatePerfCounters::StopPhase("tracking");
+    // the output phase of the master thread starts at the end of the last
+    // run of the threads
+    GatePerfCounters::StartPhase("output", -1);
+  }
+  GateAutoLock mutex(&GateSimulationStatisticsActorMutex);
+  fCounts["runs"] += 1;
+  fCounts["events"] += run->GetNumberOfEvent();
   fCounts["tracks"] += data.fTrackCount;
   fCounts["steps"] += data.fStepCount;
+  data.fTrackCount = 0;
+  data.fStepCount = 0;
   if (fTrackTypesFlag) {
-    for (auto v : data.fTrackTypes) {
-      if (fTrackTypes.count(v.first) == 0)
-        fTrackTypes[v.first] = 0;
-      fTrackTypes[v.first] = v.second + fTrackTypes[v.first];
+    // the particle names are only used here, once per particle and run
+    for (size_t i = 0; i < data.fTrackTypeCounts.size(); i++) {
+      if (data.fTrackTypeCounts[i] > 0)
+        fTrackTypes[data.fTrackTypeParticles[i]->GetParticleName()] +=
+            data.fTrackTypeCounts[i];
+    }
+    for (const auto &v : data.fOtherTrackTypes)
+      fTrackTypes[v.first->GetParticleName()] += v.second;
+    std::fill(data.fTrackTypeCounts.begin(), data.fTrackTypeCounts.end(), 0);
+    data.fOtherTrackTypes.clear();
+  }
+  if (fStepTypesFlag) {
+    for (const auto &v : data.fStepTypes) {
+      const auto *process = std::get<2>(v.first);
+      auto name = StepTypeName(
+          std::get<0>(v.first)->GetName(),
+          std::get<1>(v.first)->GetParticleName(),
+          process != nullptr ? process->GetProcessName() : "none");
+      auto &c = fStepTypes[name];
+      c.fSteps += v.second.fSteps;
+      c.fSampledSteps += v.second.fSampledSteps;
+      c.fSampledTime += v.second.fSampledTime;
+    }
+    data.fStepTypes.clear();
+    data.fTimeNextStep = false;
+  }
+}
+
+void GateSimulationStatisticsActor::EndOfSimulationWorkerAction(
+    const G4Run * /*lastRun*/) {
+  // Called every time the simulation is about to end, by ALL threads
+  // (the counts are merged at the end of each run)
+}
+
+void GateSimulationStatisticsActor::SetCounts(py::dict &counts) {
+  // Restore the counts, e.g. from a checkpoint (after StartSimulationAction)
+  for (auto k : {"runs", "events", "tracks", "steps"})
+    fCounts[k] = counts[k].cast<long int>();
+  fTrackTypes = counts["track_types"].cast<std::map<std::string, long int>>();
+  if (!counts.contains("step_types"))
+    return;
+  fStepTypes.clear();
+  for (auto volume : counts["step_types"].cast<py::dict>()) {
+    for (auto particle : volume.second.cast<py::dict>()) {
+      for (auto process : particle.second.cast<py::dict>()) {
+        auto c = process.second.cast<py::dict>();
+        auto &s = fStepTypes[StepTypeName(volume.first.cast<std::string>(),
+                                          particle.first.cast<std::string>(),
+                                          process.first.cast<std::string>())];
+        s.fSteps = c["steps"].cast<long int>();
+        s.fSampledSteps = c["sampled_steps"].cast<long int>();
+        s.fSampledTime = c["sampled_time"].cast<double>();
+      }
     }
   }
 }
 
 void GateSimulationStatisticsActor::EndSimulationAction() {
   // Called when the simulation end (only by the master thread)
+  if (fPerfCountersFlag)
+    GatePerfCounters::StopPhase("output");
   fStopTime = std::chrono::system_clock::now();
   fDuration = std::chrono::duration_cast<std::chrono::microseconds>(
                   fStopTime - fStartRunTime)
@@ -10,10 +10,16 @@
 
 #include "GateHelpers.h"
 #include "GateVActor.h"
+#include <chrono>
 #include <pybind11/stl.h>
+#include <tuple>
 
 namespace py = pybind11;
 
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4VProcess;
+
 class GateSimulationStatisticsActor : public GateVActor {
 
 public:
@@ -47,14 +53,43 @@ public:
 
   py::dict GetCounts();
 
+  // Set the counts (runs, events, tracks, steps, track_types and
+  // step_types)
+  void SetCounts(py::dict &counts);
+
 protected:
+  // Steps of a (volume, particle, process): count, and sampled time
+  struct StepTypeCounts {
+    long int fSteps = 0;
+    long int fSampledSteps = 0;
+    double fSampledTime = 0;
+  };
+
+  // Thread-local key: pointers, the names are only used at the merge
+  typedef std::tuple<const G4LogicalVolume *, const G4ParticleDefinition *,
+                     const G4VProcess *>
+      StepTypeKey;
+  typedef std::tuple<std::string, std::string, std::string> StepTypeName;
+
+  void CountStepType(G4Step *step);
+
+  void CountTrackType(const G4ParticleDefinition *particle);
+
   // Local data for the threads (each one has a copy)
+  // (tracks and steps of the current run)
   struct threadLocal_t {
-    int fRunCount;
-    long int fEventCount;
-    long int fTrackCount;
-    long int fStepCount;
-    std::map<std::string, long int> fTrackTypes;
+    long int fTrackCount = 0;
+    long int fStepCount = 0;
+    // tracks per particle, indexed by the particle definition id (the
+    // names are only used at the merge), and the particles without id
+    std::vector<long int> fTrackTypeCounts;
+    std::vector<const G4ParticleDefinition *> fTrackTypeParticles;
+    std::map<const G4ParticleDefinition *, long int> fOtherTrackTypes;
+    std::map<StepTypeKey, StepTypeCounts> fStepTypes;
+    // the next step is timed (one step every fStepTypesTimeSampling)
+    long int fStepTypesSampleCounter = 0;
+    bool fTimeNextStep = false;
+    std::chrono::steady_clock::time_point fLastStepTime;
   };
   G4Cache<threadLocal_t> threadLocalData;
 
@@ -65,8 +100,14 @@ protected:
 
   bool fTrackTypesFlag;
   std::map<std::string, long int> fTrackTypes;
+  bool fStepTypesFlag = false;
+  int fStepTypesTimeSampling = 0;
+  std::map<StepTypeName, StepTypeCounts> fStepTypes;
   double fDuration;
   double fInitDuration;
+  bool fProfileFlag = false;
+  bool fMemoryFlag = false;
+  bool fPerfCountersFlag = false;
   std::chrono::system_clock::time_point fStartTime;
   std::chrono::system_clock::time_point fStartRunTime;
   std::chrono::system_clock::time_point fStopTime;
@@ -7,10 +7,15 @@
 
 #include "GateSingleParticleSource.h"
 #include "G4Event.hh"
+#include "G4ParticleTable.hh"
+#include "G4PhysicalConstants.hh"
 #include "G4PrimaryVertex.hh"
+#include "G4RandomDirection.hh"
 #include "G4RunManager.hh"
 #include "GateHelpers.h"
 #include "GateRandomMultiGauss.h"
+#include <Randomize.hh>
+#include <cmath>
 
 GateSingleParticleSource::GateSingleParticleSource(
     std::string /*mother_volume*/) {
@@ -32,6 +37,22 @@ GateSingleParticleSource::GateSingleParticleSource(
   fBackToBackMode = false;
   fAccolinearityFlag = false;
   fAccolinearitySigma = 0.0;
+  fPositronRangeFlag = false;
+  fPositronRangeP1 = 0;
+  fPositronRangeK1 = 0;
+  fPositronRangeK2 = 0;
+  fGamma = nullptr;
+  fAAManager = nullptr;
+  fPositionSampler = PositionSampler::Generic;
+  fDirectionSampler = DirectionSampler::Generic;
+  fEnergySampler = EnergySampler::Generic;
+  fCustomPositionGenerator = false;
+  fCosMinTheta = 1;
+  fCosMaxTheta = -1;
+  fMinPhi = 0;
+  fDeltaPhi = 0;
+  fRotateDirection = false;
+  fMonoEnergy = 0;
 }
 
 GateSingleParticleSource::~GateSingleParticleSource() {
@@ -44,6 +65,99 @@ void GateSingleParticleSource::SetPosGenerator(GateSPSPosDistribution *pg) {
   fPositionGenerator = pg;
   fPositionGenerator->SetBiasRndm(fBiasRndm);
   fDirectionGenerator->SetPosDistribution(fPositionGenerator);
+  fCustomPositionGenerator = true;
+  fPositionSampler = PositionSampler::Generic;
+}
+
+void GateSingleParticleSource::SelectSamplers(bool fast_position) {
+  // position: the G4 point source is the centre, the G4 parallelepiped
+  // (without shear) is a box rotated with the rotation of the distribution
+  auto *pos = fPositionGenerator;
+  fPositionSampler = PositionSampler::Generic;
+  if (fast_position && !fCustomPositionGenerator) {
+    if (pos->GetPosDisType() == "Point")
+      fPositionSampler = PositionSampler::Point;
+    if (pos->GetPosDisType() == "Volume" && pos->GetPosDisShape() == "Para")
+      fPositionSampler = PositionSampler::Box;
+  }
+  fCentre = pos->GetCentreCoords();
+  fRotX = pos->GetRotx();
+  fRotY = pos->GetRoty();
+  fRotZ = pos->GetRotz();
+  fHalfSize = G4ThreeVector(pos->GetHalfX(), pos->GetHalfY(), pos->GetHalfZ());
+
+  // direction: the G4 planar flux is the momentum, the G4 isotropic flux is
+  // sampled between the min and max theta and phi
+  auto *ang = fDirectionGenerator;
+  fDirectionSampler = DirectionSampler::Generic;
+  if (ang->GetDistType() == "planar")
+    fDirectionSampler = DirectionSampler::Momentum;
+  if (ang->GetDistType() == "iso")
+    fDirectionSampler = DirectionSampler::Iso;
+  fMomentum = ang->GetDirection();
+  fCosMinTheta = std::cos(ang->GetMinTheta());
+  fCosMaxTheta = std::cos(ang->GetMaxTheta());
+  fMinPhi = ang->GetMinPhi();
+  fDeltaPhi = ang->GetMaxPhi() - ang->GetMinPhi();
+  fRotateDirection = ang->fDirectionRelativeToAttachedVolume;
+  fDirectionRotation = ang->fGlobalRotation;
+
+  // energy
+  fEnergySampler = fEnergyGenerator->GetEnergyDisType() == "Mono"
+                       ? EnergySampler::Mono
+                       : EnergySampler::Generic;
+  fMonoEnergy = fEnergyGenerator->GetMonoEnergy();
+}
+
+G4ThreeVector GateSingleParticleSource::SamplePosition() {
+  if (fPositionSampler == PositionSampler::Point)
+    return fCentre;
+  if (fPositionSampler == PositionSampler::Box) {
+    // (same random numbers and operations as G4SPSPosDistribution)
+    double x = G4UniformRand();
+    double y = G4UniformRand();
+    double z = G4UniformRand();
+    x = (x * 2. * fHalfSize.x()) - fHalfSize.x();
+    y = (y * 2. * fHalfSize.y()) - fHalfSize.y();
+    z = (z * 2. * fHalfSize.z()) - fHalfSize.z();
+    G4ThreeVector p(x * fRotX.x() + y * fRotY.x() + z * fRotZ.x(),
+                    x * fRotX.y() + y * fRotY.y() + z * fRotZ.y(),
+                    x * fRotX.z() + y * fRotY.z() + z * fRotZ.z());
+    return fCentre + p;
+  }
+  return fPositionGenerator->VGenerateOne();
+}
+
+G4ThreeVector GateSingleParticleSource::SampleDirection() {
+  G4ThreeVector direction;
+  if (fDirectionSampler == DirectionSampler::Momentum) {
+    direction = fMomentum;
+  } else if (fDirectionSampler == DirectionSampler::Iso) {
+    // (same random numbers and operations as G4SPSAngDistribution)
+    auto cos_theta =
+        fCosMinTheta - G4UniformRand() * (fCosMinTheta - fCosMaxTheta);
+    auto sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+    auto phi = fMinPhi + fDeltaPhi * G4UniformRand();
+    double x = -sin_theta * std::cos(phi);
+    double y = -sin_theta * std::sin(phi);
+    double z = -cos_theta;
+    auto mag = std::sqrt(x * x + y * y + z * z);
+    direction.set(x / mag, y / mag, z / mag);
+  } else {
+    return fDirectionGenerator->VGenerateOne();
+  }
+  // see GateSPSAngDistribution::VGenerateOne
+  if (fRotateDirection) {
+    direction = direction / direction.mag();
+    direction = fDirectionRotation * direction;
+  }
+  return direction;
+}
+
+double GateSingleParticleSource::SampleEnergy() {
+  if (fEnergySampler == EnergySampler::Mono)
+    return fMonoEnergy;
+  return fEnergyGenerator->VGenerateOne(fParticleDefinition);
 }
 
 void GateSingleParticleSource::SetParticleDefinition(
@@ -64,7 +178,7 @@ GateSingleParticleSource::GenerateDirectionWithAA(const G4ThreeVector &position,
   fAAManager->StartAcceptLoop();
   while (!accept_angle) {
     // direction
-    direction = fDirectionGenerator->VGenerateOne();
+    direction = SampleDirection();
 
     // accept ?
     accept_angle = fAAManager->TestIfAccept(position, direction);
@@ -81,21 +195,117 @@ void GateSingleParticleSource::GeneratePrimaryVertex(G4Event *event) {
   // (No mutex needed because variables (position, etc.) are local)
 
   // Generate position
-  auto position = fPositionGenerator->VGenerateOne();
+  auto position = SamplePosition();
+
+  // annihilation point (the acceptance angle is tested from there)
+  if (fBackToBackMode && fPositronRangeFlag)
+    position += SamplePositronRange();
+
+  // the energy first if the direction depends on it (energy-dependent
+  // angular histogram)
+  double energy = 0;
+  if (fDirectionGenerator->IsEnergyDependent())
+    energy = SampleEnergy();
 
   // Generate direction (until angle is ok)
   bool zero_energy_flag;
   auto direction = GenerateDirectionWithAA(position, zero_energy_flag);
 
   // energy
-  double energy = zero_energy_flag
-                      ? 0
-                      : fEnergyGenerator->VGenerateOne(fParticleDefinition);
+  if (!fDirectionGenerator->IsEnergyDependent())
+    energy = zero_energy_flag ? 0 : SampleEnergy();
+  else if (zero_energy_flag)
+    energy = 0;
+
+  AddPrimaryVertex(event, position, direction, energy);
+}
+
+void GateSingleParticleSource::GenerateBatch(GatePrimaryBatch &batch,
+                                             size_t n) {
+  if (fBackToBackMode)
+    return GenerateBatchBackToBack(batch, n);
+  batch.Resize(n);
+  // the direction may depend on the position (e.g. focused)
+  for (size_t i = 0; i < n; i++) {
+    auto position = SamplePosition();
+    batch.SetPosition(i, position);
+    batch.SetDirection(i, SampleDirection());
+  }
+  fEnergyGenerator->VGenerateBatch(fParticleDefinition, batch.fEnergy.data(),
+                                   n);
+  batch.SetFilled(n);
+}
+
+void GateSingleParticleSource::GeneratePrimaryVertexFromBatch(
+    G4Event *event, GatePrimaryBatch &batch) {
+  auto i = batch.Next();
+  auto position = batch.GetPosition(i);
+  auto direction = batch.GetDirection(i);
+  if (fBackToBackMode)
+    return AddBackToBackVertex(event, position, direction,
+                               batch.GetDirection2(i), batch.fEnergy[i]);
+  AddPrimaryVertex(event, position, direction, batch.fEnergy[i]);
+}
+
+void GateSingleParticleSource::GenerateBatchBackToBack(GatePrimaryBatch &batch,
+                                                       size_t n) {
+  batch.Resize(n, true);
+  // emission points and directions of the first photons
+  for (size_t i = 0; i < n; i++) {
+    batch.SetPosition(i, SamplePosition());
+    batch.SetDirection(i, SampleDirection());
+  }
 
+  // annihilation points: 5 uniform numbers per pair (component, distance
+  // and direction of the positron range)
+  if (fPositronRangeFlag) {
+    fBatchRandom.resize(5 * n);
+    G4Random::getTheEngine()->flatArray(static_cast<int>(5 * n),
+                                        fBatchRandom.data());
+    for (size_t i = 0; i < n; i++) {
+      const double *u = fBatchRandom.data() + 5 * i;
+      double k = u[0] < fPositronRangeP1 ? fPositronRangeK1 : fPositronRangeK2;
+      double r = -std::log(u[1] * u[2]) / k;
+      double cos_theta = 2 * u[3] - 1;
+      double r_sin_theta = r * std::sqrt(1 - cos_theta * cos_theta);
+      double phi = CLHEP::twopi * u[4];
+      batch.fPositionX[i] += r_sin_theta * std::cos(phi);
+      batch.fPositionY[i] += r_sin_theta * std::sin(phi);
+      batch.fPositionZ[i] += r * cos_theta;
+    }
+  }
+
+  // second photons: 2 Gaussian angles per pair for the accolinearity
+  if (fAccolinearityFlag) {
+    fBatchRandom.resize(2 * n);
+    G4RandGauss::shootArray(static_cast<int>(2 * n), fBatchRandom.data(), 0.0,
+                            fAccolinearitySigma);
+    for (size_t i = 0; i < n; i++)
+      batch.SetDirection2(i, BackToBackDirection(batch.GetDirection(i),
+                                                 fBatchRandom[2 * i],
+                                                 fBatchRandom[2 * i + 1]));
+  } else {
+    for (size_t i = 0; i < n; i++)
+      batch.SetDirection2(i, -batch.GetDirection(i));
+  }
+
+  fEnergyGenerator->VGenerateBatch(fParticleDefinition, batch.fEnergy.data(),
+                                   n);
+  batch.SetFilled(n);
+}
+
+void GateSingleParticleSource::AddPrimaryVertex(G4Event *event,
+                                                G4ThreeVector &position,
+                                                G4ThreeVector &direction,
+                                                double energy) {
   // back to back photon ?
   if (fBackToBackMode)
     return GeneratePrimaryVertexBackToBack(event, position, direction, energy);
 
+  // emissions of a decay ?
+  if (!fDecayBranches.empty())
+    return GeneratePrimaryVertexDecay(event, position, direction, energy);
+
   // create a new vertex (time must have been set before with SetParticleTime)
   auto *vertex = new G4PrimaryVertex(position, particle_time);
 
@@ -124,31 +334,61 @@ void GateSingleParticleSource::SetAccolinearityFWHM(double accolinearityFWHM) {
   fAccolinearitySigma = accolinearityFWHM / CLHEP::rad * fwhm_to_sigma;
 }
 
+void GateSingleParticleSource::SetPositronRange(double p1, double k1,
+                                                double k2) {
+  fPositronRangeFlag = k1 > 0 && k2 > 0;
+  fPositronRangeP1 = p1;
+  fPositronRangeK1 = k1;
+  fPositronRangeK2 = k2;
+}
+
+G4ThreeVector GateSingleParticleSource::SamplePositronRange() const {
+  double k =
+      G4UniformRand() < fPositronRangeP1 ? fPositronRangeK1 : fPositronRangeK2;
+  double r = -std::log(G4UniformRand() * G4UniformRand()) / k;
+  return r * G4RandomDirection();
+}
+
+G4ThreeVector
+GateSingleParticleSource::BackToBackDirection(const G4ThreeVector &direction,
+                                              double phi, double psi) const {
+  double theta = sqrt(pow(phi, 2.0) + pow(psi, 2.0));
+  if (theta == 0)
+    return -direction;
+  G4ThreeVector direction2(sin(theta) * phi / theta, sin(theta) * psi / theta,
+                           cos(theta));
+  // Apply accolinearity deviation relative to the colinear case
+  direction2.rotateUz(-1.0 * direction.unit());
+  return direction2;
+}
+
 void GateSingleParticleSource::GeneratePrimaryVertexBackToBack(
     G4Event *event, G4ThreeVector &position, G4ThreeVector &direction,
     double energy) {
+  G4ThreeVector direction2 = -direction;
+  if (fAccolinearityFlag) {
+    double phi = G4RandGauss::shoot(0.0, fAccolinearitySigma);
+    double psi = G4RandGauss::shoot(0.0, fAccolinearitySigma);
+    direction2 = BackToBackDirection(direction, phi, psi);
+  }
+  AddBackToBackVertex(event, position, direction, direction2, energy);
+}
+
+void GateSingleParticleSource::AddBackToBackVertex(
+    G4Event *event, const G4ThreeVector &position,
+    const G4ThreeVector &direction1, const G4ThreeVector &direction2,
+    double energy) {
   // create the primary vertex with 2 associated primary particles
   auto *vertex = new G4PrimaryVertex(position, particle_time);
 
   auto *particle1 = new G4PrimaryParticle(fParticleDefinition);
   particle1->SetKineticEnergy(energy);
-  particle1->SetMomentumDirection(direction);
+  particle1->SetMomentumDirection(direction1);
 
+  // TODO: What to do with the magnitude of momemtum?
   auto *particle2 = new G4PrimaryParticle(fParticleDefinition);
   particle2->SetKineticEnergy(energy);
-  if (fAccolinearityFlag) {
-    double phi = G4RandGauss::shoot(0.0, fAccolinearitySigma);
-    double psi = G4RandGauss::shoot(0.0, fAccolinearitySigma);
-    double theta = sqrt(pow(phi, 2.0) + pow(psi, 2.0));
-    G4ThreeVector particle2_direction(sin(theta) * phi / theta,
-                                      sin(theta) * psi / theta, cos(theta));
-    // TODO: What to do with the magnitude of momemtum?
-    // Apply accolinearity deviation relative to the colinear case
-    particle2_direction.rotateUz(-1.0 * particle1->GetMomentum().unit());
-    particle2->SetMomentumDirection(particle2_direction);
-  } else {
-    particle2->SetMomentumDirection(-direction);
-  }
+  particle2->SetMomentumDirection(direction2);
 
   // Associate the two primaries to the vertex
   vertex->SetPrimary(particle1);
@@ -156,6 +396,49 @@ void GateSingleParticleSource::GeneratePrimaryVertexBackToBack(
   event->AddPrimaryVertex(vertex);
 }
 
+void GateSingleParticleSource::SetDecayBranches(
+    const std::vector<DecayBranch> &branches) {
+  fDecayBranches = branches;
+  fDecayBranchCDF.clear();
+  double total = 0;
+  for (const auto &b : fDecayBranches) {
+    total += b.fProbability;
+    fDecayBranchCDF.push_back(total);
+  }
+  for (auto &p : fDecayBranchCDF)
+    p /= total;
+  fGamma = G4ParticleTable::GetParticleTable()->FindParticle("gamma");
+}
+
+void GateSingleParticleSource::GeneratePrimaryVertexDecay(
+    G4Event *event, G4ThreeVector &position, G4ThreeVector &direction,
+    double energy) {
+  // branch of the decay (a few branches, linear search)
+  auto u = G4UniformRand();
+  size_t i = 0;
+  while (i + 1 < fDecayBranchCDF.size() && fDecayBranchCDF[i] < u)
+    i++;
+  const auto &branch = fDecayBranches[i];
+
+  auto *vertex = new G4PrimaryVertex(position, particle_time);
+  if (branch.fParticle) {
+    auto *particle = new G4PrimaryParticle(fParticleDefinition);
+    particle->SetKineticEnergy(energy);
+    particle->SetMass(fMass);
+    particle->SetMomentumDirection(direction);
+    particle->SetCharge(fCharge);
+    vertex->SetPrimary(particle);
+  }
+  // the prompt gammas (the angular correlations are not considered)
+  for (auto e : branch.fGammaEnergies) {
+    auto *gamma = new G4PrimaryParticle(fGamma);
+    gamma->SetKineticEnergy(e);
+    gamma->SetMomentumDirection(G4RandomDirection());
+    vertex->SetPrimary(gamma);
+  }
+  event->AddPrimaryVertex(vertex);
+}
+
 void GateSingleParticleSource::SetAAManager(
     GateAcceptanceAngleTesterManager *aa_manager) {
   fAAManager = aa_manager;
@@ -14,6 +14,7 @@
 #include "GateAcceptanceAngleTester.h"
 #include "GateAcceptanceAngleTesterManager.h"
 #include "GateHelpers.h"
+#include "GatePrimaryBatch.h"
 #include "GateRandomMultiGauss.h"
 #include "GateSPSAngDistribution.h"
 #include "GateSPSEneDistribution.h"
@@ -51,6 +52,31 @@ public:
   G4ThreeVector GenerateDirectionWithAA(const G4ThreeVector &position,
                                         bool &accept);
 
+  // Select the samplers of the position, direction and energy, once the
+  // distributions are set for the run (per thread). The most common
+  // distributions (point or box, momentum or iso, mono) are then sampled
+  // inline, with the same random numbers as the Geant4 distributions, the
+  // other ones with the SPS distributions. The position is always sampled
+  // with its distribution if fast_position is false (e.g. confined source).
+  void SelectSamplers(bool fast_position);
+
+  G4ThreeVector SamplePosition();
+
+  G4ThreeVector SampleDirection();
+
+  double SampleEnergy();
+
+  // Batch mode (without acceptance angle): the positions and directions are
+  // generated first, then all the energies at once (not possible when the
+  // direction depends on the energy)
+  virtual bool CanGenerateBatch() const {
+    return !fDirectionGenerator->IsEnergyDependent();
+  }
+
+  virtual void GenerateBatch(GatePrimaryBatch &batch, size_t n);
+
+  void GeneratePrimaryVertexFromBatch(G4Event *event, GatePrimaryBatch &batch);
+
   void GeneratePrimaryVertexBackToBack(G4Event *event, G4ThreeVector &position,
                                        G4ThreeVector &direction, double energy);
 
@@ -60,7 +86,43 @@ public:
   // value (Moses 2011)
   void SetAccolinearityFWHM(double accolinearityFWHM);
 
+  // Positron range of the back to back mode: the annihilation point is
+  // moved from the emission point, isotropically, with a distance sampled
+  // from the sum of two Gamma(2, 1/k) (the 3D kernel of the bi-exponential
+  // projected distribution). p1 is the probability of the first component.
+  void SetPositronRange(double p1, double k1, double k2);
+
+  G4ThreeVector SamplePositronRange() const;
+
+  // Precomputed decay: one branch is sampled per event, with the particle of
+  // the source (e.g. e+) if fParticle, and the prompt gammas of the branch
+  // (isotropic), all in the same vertex
+  struct DecayBranch {
+    double fProbability;
+    bool fParticle;
+    std::vector<double> fGammaEnergies;
+  };
+
+  void SetDecayBranches(const std::vector<DecayBranch> &branches);
+
+  void GeneratePrimaryVertexDecay(G4Event *event, G4ThreeVector &position,
+                                  G4ThreeVector &direction, double energy);
+
 protected:
+  void AddPrimaryVertex(G4Event *event, G4ThreeVector &position,
+                        G4ThreeVector &direction, double energy);
+
+  // direction of the second photon: -direction with the accolinearity
+  G4ThreeVector BackToBackDirection(const G4ThreeVector &direction, double phi,
+                                    double psi) const;
+
+  void AddBackToBackVertex(G4Event *event, const G4ThreeVector &position,
+                           const G4ThreeVector &direction1,
+                           const G4ThreeVector &direction2, double energy);
+
+  // back to back mode: all the random numbers of the batch at once
+  void GenerateBatchBackToBack(GatePrimaryBatch &batch, size_t n);
+
   G4ParticleDefinition *fParticleDefinition;
   double fCharge;
   double fMass;
@@ -71,9 +133,45 @@ protected:
   bool fAccolinearityFlag;
   bool fBackToBackMode;
   double fAccolinearitySigma;
+  bool fPositronRangeFlag;
+  double fPositronRangeP1;
+  double fPositronRangeK1;
+  double fPositronRangeK2;
+  // buffer of the random numbers of a batch
+  std::vector<double> fBatchRandom;
+
+  // precomputed decay mode (empty: one single particle)
+  std::vector<DecayBranch> fDecayBranches;
+  std::vector<double> fDecayBranchCDF;
+  G4ParticleDefinition *fGamma;
 
   // for acceptance angle
   GateAcceptanceAngleTesterManager *fAAManager;
+
+  // samplers of the run (Generic: the SPS distribution)
+  enum class PositionSampler { Generic, Point, Box };
+  enum class DirectionSampler { Generic, Momentum, Iso };
+  enum class EnergySampler { Generic, Mono };
+  PositionSampler fPositionSampler;
+  DirectionSampler fDirectionSampler;
+  EnergySampler fEnergySampler;
+  // the position generator is not a GateSPSPosDistribution (e.g. voxels)
+  bool fCustomPositionGenerator;
+
+  // parameters of the samplers, copied from the distributions
+  G4ThreeVector fCentre;
+  G4ThreeVector fRotX;
+  G4ThreeVector fRotY;
+  G4ThreeVector fRotZ;
+  G4ThreeVector fHalfSize;
+  G4ThreeVector fMomentum;
+  double fCosMinTheta;
+  double fCosMaxTheta;
+  double fMinPhi;
+  double fDeltaPhi;
+  bool fRotateDirection;
+  G4RotationMatrix fDirectionRotation;
+  double fMonoEnergy;
 };
 
 #endif // GateSingleParticleSource_h
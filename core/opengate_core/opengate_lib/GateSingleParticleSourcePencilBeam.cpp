@@ -10,27 +10,32 @@
 
 GateSingleParticleSourcePencilBeam::GateSingleParticleSourcePencilBeam(
     std::string motherVolume, std::string)
-    : GateSingleParticleSource(motherVolume) {
-  // Specific init for PBS
-  mUXTheta = {0, 0};
-  mUYPhi = {0, 0};
-  mSXTheta = {0, 0, 0, 0};
-  mSYPhi = {0, 0, 0, 0};
-}
+    : GateSingleParticleSource(motherVolume) {}
 
 void GateSingleParticleSourcePencilBeam::SetPBSourceParam(
     std::vector<double> x_param, std::vector<double> y_param) {
+  // convert user input into a 2D Matrix, one sigma
+  // note: the mean remains zero
+  mOwnedXTheta = PhaseSpaceGaussian(x_param);
+  mOwnedYPhi = PhaseSpaceGaussian(y_param);
+  SetPhaseSpace(&mOwnedXTheta, &mOwnedYPhi);
+}
+
+void GateSingleParticleSourcePencilBeam::SetPhaseSpace(
+    const GateRandomMultiGauss *gaussianXTheta,
+    const GateRandomMultiGauss *gaussianYPhi) {
+  mGaussian2DXTheta = gaussianXTheta;
+  mGaussian2DYPhi = gaussianYPhi;
+}
 
+GateRandomMultiGauss GateSingleParticleSourcePencilBeam::PhaseSpaceGaussian(
+    const std::vector<double> &param) {
   // pi = 3.14159265358979323846; # CLHEP value
-  sigmaX = x_param[0];
-  sigmaY = y_param[0];
-  thetaX = x_param[1];
-  thetaY = y_param[1];
-  epsilonX =
-      x_param[2] / 3.14159265358979323846; // same formalism used in Gate-9
-  epsilonY = y_param[2] / 3.14159265358979323846;
-  convX = x_param[3];
-  convY = y_param[3];
+  // same formalism used in Gate-9
+  double epsilon = param[2] / 3.14159265358979323846;
+  std::vector<double> symM = {0, 0, 0, 0};
+  PhaseSpace(param[0], param[1], epsilon, param[3], symM);
+  return {{0, 0}, symM};
 }
 
 void GateSingleParticleSourcePencilBeam::SetSourceRotTransl(
@@ -41,43 +46,49 @@ void GateSingleParticleSourcePencilBeam::SetSourceRotTransl(
 }
 
 void GateSingleParticleSourcePencilBeam::GeneratePrimaryVertex(G4Event *event) {
-  if (!mIsInitialized) {
-
-    //---------INITIALIZATION - START----------------------
-
-    //==============================================================
-    // Generates primary vertex: pos and dir are correlated and sampled from 2D
-    // Gaussian x-direction
-    delete mGaussian2DXTheta;
-    // convert user input into a 2D Matrix, one sigma;
-    // note: matrix mUX remains zero as initialized
-    PhaseSpace(sigmaX, thetaX, epsilonX, convX, mSXTheta);
-    mGaussian2DXTheta = new GateRandomMultiGauss(mUXTheta, mSXTheta);
-
-    //==============================================================
-    // y-direction
-    delete mGaussian2DYPhi;
-    PhaseSpace(sigmaY, thetaY, epsilonY, convY, mSYPhi);
-    mGaussian2DYPhi = new GateRandomMultiGauss(mUYPhi, mSYPhi);
-
-    //---------INITIALIZATION - END-----------------------
+  // position/direction sampling: pos and dir are correlated and sampled from
+  // 2D Gaussian
+  std::vector<double> XTheta = mGaussian2DXTheta->Fire();
+  std::vector<double> YPhi = mGaussian2DYPhi->Fire();
+
+  // (do not test for acceptance angle)
+  auto energy = fEnergyGenerator->VGenerateOne(fParticleDefinition);
+
+  AddPencilBeamVertex(event, XTheta[0], XTheta[1], YPhi[0], YPhi[1], energy);
+}
+
+void GateSingleParticleSourcePencilBeam::GenerateBatch(GatePrimaryBatch &batch,
+                                                       size_t n) {
+  batch.Resize(n);
+  mBatchX.resize(n);
+  mBatchTheta.resize(n);
+  mBatchY.resize(n);
+  mBatchPhi.resize(n);
+  mGaussian2DXTheta->FireArray(n, mBatchX.data(), mBatchTheta.data());
+  mGaussian2DYPhi->FireArray(n, mBatchY.data(), mBatchPhi.data());
+  for (size_t i = 0; i < n; i++) {
+    G4ThreeVector position(mBatchX[i], mBatchY[i], 0);
+    G4ThreeVector direction(tan(mBatchTheta[i]), tan(mBatchPhi[i]), 1);
+    batch.SetPosition(i, source_rot * position + source_transl);
+    batch.SetDirection(i, source_rot * direction.unit());
   }
-  //=======================================================
+  fEnergyGenerator->VGenerateBatch(fParticleDefinition, batch.fEnergy.data(),
+                                   n);
+  batch.SetFilled(n);
+}
 
-  //-------- PARTICLE SAMPLING - START------------------
+void GateSingleParticleSourcePencilBeam::AddPencilBeamVertex(
+    G4Event *event, double x, double theta, double y, double phi,
+    double energy) {
   G4ThreeVector position, direction;
 
-  // position/direction sampling
-  std::vector<double> XTheta = mGaussian2DXTheta->Fire();
-  std::vector<double> YPhi = mGaussian2DYPhi->Fire();
-
-  position[2] = 0;         // Pz
-  position[0] = XTheta[0]; // Px
-  position[1] = YPhi[0];   // Py
+  position[2] = 0; // Pz
+  position[0] = x; // Px
+  position[1] = y; // Py
 
-  direction[2] = 1;              // Dz
-  direction[0] = tan(XTheta[1]); // Dx
-  direction[1] = tan(YPhi[1]);   // Dy
+  direction[2] = 1;          // Dz
+  direction[0] = tan(theta); // Dx
+  direction[1] = tan(phi);   // Dy
 
   // move position according to mother volume
   position = source_rot * position + source_transl;
@@ -88,14 +99,6 @@ void GateSingleParticleSourcePencilBeam::GeneratePrimaryVertex(G4Event *event) {
   // move according to mother volume
   direction = source_rot * direction;
 
-  // (do not test for acceptance angle)
-  auto energy = fEnergyGenerator->VGenerateOne(fParticleDefinition);
-
-  //-------- PARTICLE SAMPLING - END------------------
-
-  //=======================================================
-
-  //-------- PARTICLE GENERATION - START------------------
   // create a new vertex (time must have been set before with SetParticleTime)
   auto *vertex = new G4PrimaryVertex(position, particle_time);
 
@@ -108,8 +111,6 @@ void GateSingleParticleSourcePencilBeam::GeneratePrimaryVertex(G4Event *event) {
 
   vertex->SetPrimary(particle);
   event->AddPrimaryVertex(vertex);
-
-  //-------- PARTICLE GENERATION - END------------------
 }
 
 void GateSingleParticleSourcePencilBeam::PhaseSpace(double sigma, double theta,
@@ -119,6 +120,12 @@ void GateSingleParticleSourcePencilBeam::PhaseSpace(double sigma, double theta,
   // Notations - P35
   double alpha, beta, gamma;
 
+  if (epsilon == 0) {
+    // no phase space (not initialized)
+    symM = {0, 0, 0, 0};
+    return;
+  }
+
   beta = sigma * sigma / epsilon;
   gamma = theta * theta / epsilon;
   alpha = sqrt(beta * gamma - 1.);
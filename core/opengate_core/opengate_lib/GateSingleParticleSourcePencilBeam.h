@@ -28,31 +28,45 @@ public:
 
   void GeneratePrimaryVertex(G4Event *evt) override;
 
+  // the phase space of a batch is sampled with vectorized Gaussians
+  void GenerateBatch(GatePrimaryBatch &batch, size_t n) override;
+
+  // Phase space of the beam, the Gaussians are built here (once)
   void SetPBSourceParam(std::vector<double> x_param,
                         std::vector<double> y_param);
 
-  void PhaseSpace(double sigma, double theta, double epsilon, double conv,
-                  std::vector<double> &symM);
+  // Phase space from prebuilt Gaussians (e.g. a table of spots, built at
+  // initialization): no computation, they are not copied and must outlive
+  // the source
+  void SetPhaseSpace(const GateRandomMultiGauss *gaussianXTheta,
+                     const GateRandomMultiGauss *gaussianYPhi);
+
+  // Gaussian of (position, angle) from the parameters sigma, theta,
+  // epsilon (ellipse area, with pi) and convergence (0 or 1)
+  static GateRandomMultiGauss
+  PhaseSpaceGaussian(const std::vector<double> &param);
+
+  static void PhaseSpace(double sigma, double theta, double epsilon,
+                         double conv, std::vector<double> &symM);
 
   void SetSourceRotTransl(G4ThreeVector t, G4RotationMatrix r);
 
 protected:
-  // PBS specific parameters
-  bool mIsInitialized = false;
-  double sigmaX, sigmaY, thetaX, thetaY, epsilonX, epsilonY, convX, convY;
+  void AddPencilBeamVertex(G4Event *event, double x, double theta, double y,
+                           double phi, double energy);
+
   G4ThreeVector source_transl;
   G4RotationMatrix source_rot;
 
-  // Gaussian distribution generation for direction
-  std::vector<double> mUXTheta = {0, 0};
-  std::vector<double> mUYPhi = {0, 0};
-  std::vector<double> mSXTheta = {0, 0, 0, 0};
-  std::vector<double> mSYPhi = {0, 0, 0, 0};
+  // Gaussian distribution generation for position/direction (owned when
+  // set with SetPBSourceParam)
+  GateRandomMultiGauss mOwnedXTheta{{0, 0}, {0, 0, 0, 0}};
+  GateRandomMultiGauss mOwnedYPhi{{0, 0}, {0, 0, 0, 0}};
+  const GateRandomMultiGauss *mGaussian2DXTheta = &mOwnedXTheta;
+  const GateRandomMultiGauss *mGaussian2DYPhi = &mOwnedYPhi;
 
-  GateRandomMultiGauss *mGaussian2DXTheta =
-      new GateRandomMultiGauss(mUXTheta, mSXTheta);
-  GateRandomMultiGauss *mGaussian2DYPhi =
-      new GateRandomMultiGauss(mUYPhi, mSYPhi);
+  // buffers of the batches: x, theta, y, phi
+  std::vector<double> mBatchX, mBatchTheta, mBatchY, mBatchPhi;
 };
 
 #endif // GatePencilBeamSingleParticleSource_h
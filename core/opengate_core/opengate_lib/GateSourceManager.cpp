@@ -14,17 +14,24 @@
 
 #endif
 
+#include "GateActorProfiler.h"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
 #include "GateSignalHandler.h"
 #include "GateSourceManager.h"
-#include "indicators.hpp"
+#include "GateTimeline.h"
+#include <G4Geantino.hh>
 #include <G4MTRunManager.hh>
 #include <G4RunManager.hh>
 #include <G4TransportationManager.hh>
 #include <G4UIExecutive.hh>
 #include <G4UImanager.hh>
 #include <G4UnitsTable.hh>
+#include <Randomize.hh>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
 
 /* There will be one SourceManager per thread */
 
@@ -41,6 +48,7 @@ GateSourceManager::GateSourceManager() {
   fVerboseLevel = 0;
   fUserEventInformationFlag = false;
   fProgressBarFlag = false;
+  fProgressInterval = 1;
   auto &l = fThreadLocalData.Get();
   l.fStartNewRun = true;
   l.fNextRunId = 0;
@@ -49,19 +57,10 @@ GateSourceManager::GateSourceManager() {
   l.fNextActiveSource = nullptr;
   l.fNextSimulationTime = 0;
   fExpectedNumberOfEvents = 0;
-  fProgressBarStep = 1000;
-  fCurrentEvent = 0;
 }
 
 GateSourceManager::~GateSourceManager() {
   // fUIEx is already deleted
-  if (fProgressBarFlag) {
-    if (!G4Threading::IsMultithreadedApplication() ||
-        G4Threading::G4GetThreadId() == 0) {
-      auto &l = fThreadLocalData.Get();
-      delete l.fProgressBar;
-    }
-  }
 }
 
 void GateSourceManager::SetRunTerminationFlag(bool flag) {
@@ -71,9 +70,11 @@ void GateSourceManager::SetRunTerminationFlag(bool flag) {
 void GateSourceManager::Initialize(TimeIntervals simulation_times,
                                    py::dict &options) {
   fSimulationTimes = simulation_times;
+  // resumed simulation: the runs before the checkpoint are skipped
+  fFirstRunId = DictGetInt(options, "first_run_id");
   auto &l = fThreadLocalData.Get();
   l.fStartNewRun = true;
-  l.fNextRunId = 0;
+  l.fNextRunId = fFirstRunId;
   fOptions = options;
   fVisualizationFlag = DictGetBool(options, "visu");
   fVisualizationVerboseFlag = DictGetBool(options, "visu_verbose");
@@ -88,6 +89,9 @@ void GateSourceManager::Initialize(TimeIntervals simulation_times,
     fVisCommands = DictGetVecStr(options, "visu_commands");
   fVerboseLevel = DictGetInt(options, "running_verbose_level");
   fProgressBarFlag = DictGetBool(options, "progress_bar");
+  fProgressFilename = DictGetStr(options, "progress_filename");
+  fProgressInterval = DictGetDouble(options, "progress_interval");
+  fAggregateSourcesFlag = DictGetBool(options, "aggregate_sources");
   InstallSignalHandler();
   InitializeProgressBar();
 
@@ -104,6 +108,43 @@ void GateSourceManager::AddSource(GateVSource *source) {
   fSources.push_back(source);
 }
 
+void GateSourceManager::InitializeSourceGroups() {
+  fSourceGroups.clear();
+  // groups of shared sources, by start time, end time and half-life
+  std::map<std::tuple<double, double, double>, size_t> shared;
+  for (auto *source : fSources) {
+    if (fAggregateSourcesFlag && source->CanShareTimeProfile()) {
+      auto key = std::make_tuple(source->fStartTime, source->fEndTime,
+                                 source->GetHalfLife());
+      auto it = shared.find(key);
+      if (it != shared.end()) {
+        fSourceGroups[it->second].fSources.push_back(source);
+        continue;
+      }
+      shared[key] = fSourceGroups.size();
+    }
+    // the groups are in the order of their first source
+    SourceGroup group;
+    group.fSources.push_back(source);
+    fSourceGroups.push_back(group);
+  }
+  for (auto &group : fSourceGroups) {
+    if (!group.IsShared())
+      continue;
+    double total = 0;
+    for (auto *source : group.fSources) {
+      total += source->GetInitialActivity();
+      group.fCumulativeActivities.push_back(total);
+    }
+    auto *first = group.fSources.front();
+    group.fTotalActivity = total;
+    group.fStartTime = first->fStartTime;
+    group.fEndTime = first->fEndTime;
+    auto half_life = first->GetHalfLife();
+    group.fDecayConstant = half_life > 0 ? std::log(2) / half_life : 0;
+  }
+}
+
 void GateSourceManager::SetActors(std::vector<GateVActor *> &actors) {
   fActors = actors;
   for (auto actor : actors) {
@@ -111,6 +152,49 @@ void GateSourceManager::SetActors(std::vector<GateVActor *> &actors) {
   }
 }
 
+void GateSourceManager::SetPrimaryCache(
+    std::shared_ptr<GatePrimaryCache> cache) {
+  fPrimaryCache = cache;
+}
+
+void GateSourceManager::SetEventScheduler(
+    std::shared_ptr<GateEventScheduler> scheduler) {
+  fEventScheduler = scheduler;
+}
+
+void GateSourceManager::SetEndOfRunCallback(
+    std::function<void(int)> callback) {
+  fEndOfRunCallback = callback;
+}
+
+void GateSourceManager::StartNewJob(TimeIntervals simulation_times) {
+  // (the threads are waiting: the thread-local data are reset by each thread
+  // at its first event of the job, see GeneratePrimaries)
+  fSimulationTimes = simulation_times;
+  fFirstRunId = 0;
+  fJobId++;
+  auto &l = fThreadLocalData.Get();
+  l.fStartNewRun = true;
+  l.fNextRunId = 0;
+}
+
+void GateSourceManager::SetNewJobCallback(std::function<void()> callback) {
+  fNewJobCallback = callback;
+}
+
+void GateSourceManager::SetMotionTable(
+    std::shared_ptr<GateMotionTable> table) {
+  fMotionTable = table;
+}
+
+void GateSourceManager::UpdateMotion(double time) {
+  if (!fMotionTable->Update(time))
+    return;
+  // the global transforms of the sources attached to the moved volumes
+  for (auto *source : fSources)
+    source->UpdateTransformOfAttachedVolume();
+}
+
 GateVSource *GateSourceManager::FindSourceByName(std::string name) const {
   for (auto *source : fSources) {
     if (source->fName == name)
@@ -136,18 +220,63 @@ void GateSourceManager::StartMasterThread() {
     }
   }
 
+  // The volumes are moved between two events by the thread that simulates
+  // them, the geometry is shared by the threads
+  if (fMotionTable != nullptr && G4Threading::IsMultithreadedApplication()) {
+    Fatal("The sub-runs (option dynamic_sub_runs) are only available for a "
+          "sequential simulation (one thread)");
+  }
+
   std::ostringstream oss;
   oss << "/run/beamOn " << INT32_MAX;
   std::string run = oss.str();
+
+  // Progress of all the threads, reported by a separate thread (stopped
+  // even if the simulation fails)
+  struct ProgressGuard {
+    bool fStarted = false;
+    ~ProgressGuard() {
+      if (fStarted)
+        GateProgressMonitor::GetInstance()->Stop();
+    }
+  } progress;
+  if (fProgressBarFlag || !fProgressFilename.empty()) {
+    // the sources of each worker emit the expected number of events
+    auto n = fExpectedNumberOfEvents;
+    if (G4Threading::IsMultithreadedApplication()) {
+      auto mt = static_cast<G4MTRunManager *>(G4RunManager::GetRunManager());
+      n *= mt->GetNumberOfThreads();
+    }
+    GateProgressMonitor::GetInstance()->Start(
+        n, fProgressBarFlag, fProgressFilename, fProgressInterval);
+    progress.fStarted = true;
+  }
+
+  // Resumed simulation or new job: the Geant4 run ids are kept equal to the
+  // run index (some actors use them)
+  if (fFirstRunId > 0 || fJobId > 0)
+    G4RunManager::GetRunManager()->SetRunIDCounter(fFirstRunId);
+
   // Loop on run
   auto &l = fThreadLocalData.Get();
   l.fStartNewRun = true;
-  for (size_t run_id = 0; run_id < fSimulationTimes.size(); run_id++) {
+  for (size_t run_id = fFirstRunId; run_id < fSimulationTimes.size();
+       run_id++) {
+    // [sub-runs] the volumes at the start of the run, seen by the actors
+    // (the sources are prepared when the run starts)
+    if (fMotionTable != nullptr) {
+      fMotionTable->Reset();
+      fMotionTable->Update(fSimulationTimes[run_id].first);
+    }
     // Start Begin Of Run for MasterThread
     // (both for multi-thread and mono-thread app)
     // The conventional (threaded) BeginOfRun will be called
     // for all threads by the Action loop
+    GateProgressMonitor::SetCurrentRun(run_id);
     for (auto &actor : fActors) {
+      GateTimelineScope timeline(GateTimeline::Intern(actor->GetName()),
+                                 "BeginOfRunActionMasterThread");
+      actor->ResetTerminationCount();
       actor->BeginOfRunActionMasterThread(run_id);
     }
     InitializeVisualization();
@@ -155,43 +284,25 @@ void GateSourceManager::StartMasterThread() {
     uim->ApplyCommand(run);
 
     for (auto &actor : fActors) {
+      GateTimelineScope timeline(GateTimeline::Intern(actor->GetName()),
+                                 "EndOfRunActionMasterThread");
       int ret = actor->EndOfRunActionMasterThread(run_id);
     }
+    // e.g. write a checkpoint, once all actors have their data of the run
+    if (fEndOfRunCallback) {
+      GateTimelineScope timeline("end of run callback", "master");
+      fEndOfRunCallback(run_id);
+    }
     StartVisualization();
   }
-
-  // progress bar (only thread 0)
-  if (fProgressBarFlag) {
-    if (G4Threading::IsMultithreadedApplication() &&
-        G4Threading::G4GetThreadId() != 0)
-      return;
-    // l.fProgressBar->mark_as_completed(); // seems to 'duplicate' progress bar
-    show_console_cursor(true);
-  }
 }
 
 void GateSourceManager::InitializeProgressBar() {
-  if (!fProgressBarFlag)
+  if (!fProgressBarFlag && fProgressFilename.empty())
     return;
-  // (the expected number is computed by all thread)
+  // (the expected number is computed by all thread, the bar is rendered by
+  // GateProgressMonitor)
   ComputeExpectedNumberOfEvents();
-
-  // the progress bar is only for one thread (id ==0)
-  if (G4Threading::IsMultithreadedApplication() &&
-      G4Threading::G4GetThreadId() != 0)
-    return;
-  auto &l = fThreadLocalData.Get();
-  l.fProgressBar =
-      new ProgressBar{option::BarWidth{50},
-                      option::Start{""},
-                      option::Fill{"■"},
-                      option::Lead{"■"},
-                      option::End{""},
-                      option::ShowElapsedTime{true},
-                      option::ShowRemainingTime{true},
-                      option::MaxProgress{fExpectedNumberOfEvents}};
-  // show_console_cursor(true);
-  fCurrentEvent = 0;
 }
 
 void GateSourceManager::ComputeExpectedNumberOfEvents() {
@@ -200,13 +311,6 @@ void GateSourceManager::ComputeExpectedNumberOfEvents() {
     fExpectedNumberOfEvents +=
         source->GetExpectedNumberOfEvents(fSimulationTimes);
   }
-  fProgressBarStep = (long)round((double)fExpectedNumberOfEvents / 100.0);
-  if (fExpectedNumberOfEvents > 1e7)
-    fProgressBarStep = (long)round((double)fExpectedNumberOfEvents / 1000.0);
-
-  if (fProgressBarStep < 1) {
-    fProgressBarStep = 1;
-  }
 }
 
 long int GateSourceManager::GetExpectedNumberOfEvents() const {
@@ -225,11 +329,41 @@ void GateSourceManager::PrepareRunToStart(int run_id) {
   l.fCurrentSimulationTime = l.fCurrentTimeInterval.first;
   // reset abort run flag to false
   fRunTerminationFlag = false;
+  // Replay: the events of the cache, the sources are not used
+  if (fPrimaryCache != nullptr && fPrimaryCache->IsReplaying()) {
+    PrepareNextCachedEvent();
+    if (l.fNextCachedEvent < 0)
+      return;
+    l.fStartNewRun = false;
+    Log(LogLevel_RUN, "Starting run {} from the primary cache\n", run_id);
+    return;
+  }
+  // Shared events: the thread takes chunks of events of all the sources
+  if (fEventScheduler != nullptr) {
+    for (auto *source : fSources) {
+      source->PrepareNextRun();
+    }
+    InitializeSharedEvents();
+    l.fChunkNext = 0;
+    l.fChunkEnd = 0;
+    PrepareNextSharedEvent();
+    if (l.fNextActiveSource == nullptr)
+      return;
+    l.fStartNewRun = false;
+    Log(LogLevel_RUN, "Starting run {} (shared events)\n", run_id);
+    return;
+  }
   // Prepare the run for all sources
   for (auto *source : fSources) {
     source->PrepareNextRun();
   }
-  // Check next time
+  // Check next time: all groups are scheduled
+  InitializeSourceGroups();
+  l.fNextActiveGroup = -1;
+  l.fSchedule.Reset(fSourceGroups.size());
+  for (size_t i = 0; i < fSourceGroups.size(); i++) {
+    ScheduleNextTime(static_cast<int>(i));
+  }
   PrepareNextSource();
   if (l.fNextActiveSource == nullptr) {
     return;
@@ -243,24 +377,138 @@ void GateSourceManager::PrepareRunToStart(int run_id) {
 
 void GateSourceManager::PrepareNextSource() {
   auto &l = fThreadLocalData.Get();
+  // Only the group of the source that fired is asked again for its next time
+  // (all groups are scheduled at the start of the run, see
+  // PrepareRunToStart), the other next times do not change
+  if (l.fNextActiveGroup >= 0) {
+    if (fSourceGroups[l.fNextActiveGroup].IsShared()) {
+      l.fNextActiveSource->PrepareNextTimeInGroup();
+    }
+    ScheduleNextTime(l.fNextActiveGroup);
+  }
+  // Keep the closest one
   l.fNextActiveSource = nullptr;
-  double min_time = l.fCurrentTimeInterval.first;
-  double max_time = l.fCurrentTimeInterval.second;
-  // Ask all sources their next time, keep the closest one
+  l.fNextActiveGroup = -1;
+  if (l.fSchedule.Empty()) {
+    // If no next time in the current interval, active source is NULL
+    return;
+  }
+  l.fNextActiveGroup = l.fSchedule.Top();
+  l.fNextSimulationTime = l.fSchedule.TopKey();
+  l.fNextActiveSource = SelectSourceOfGroup(l.fNextActiveGroup);
+}
+
+void GateSourceManager::ScheduleNextTime(int group) {
+  auto &l = fThreadLocalData.Get();
+  auto &g = fSourceGroups[group];
+  double t;
+  if (g.IsShared())
+    t = PrepareNextTimeOfSharedGroup(group, l.fCurrentSimulationTime);
+  else
+    t = g.fSources.front()->PrepareNextTime(l.fCurrentSimulationTime);
+  if ((t >= l.fCurrentTimeInterval.first) &&
+      (t < l.fCurrentTimeInterval.second))
+    l.fSchedule.Update(group, t);
+  else
+    l.fSchedule.Remove(group);
+}
+
+double
+GateSourceManager::PrepareNextTimeOfSharedGroup(int group,
+                                                double current_time) const {
+  // Same as GateGenericSource::PrepareNextTime with the total activity
+  auto &g = fSourceGroups[group];
+  if (current_time < g.fStartTime)
+    return g.fStartTime;
+  if (current_time >= g.fEndTime)
+    return -1;
+  double activity = g.fTotalActivity;
+  if (g.fDecayConstant > 0)
+    activity *= std::exp(-g.fDecayConstant * (current_time - g.fStartTime));
+  double next_time = current_time - std::log(G4UniformRand()) / activity;
+  if (next_time >= g.fEndTime)
+    return -1;
+  return next_time;
+}
+
+GateVSource *GateSourceManager::SelectSourceOfGroup(int group) const {
+  auto &g = fSourceGroups[group];
+  if (!g.IsShared())
+    return g.fSources.front();
+  // the ratio of the activities is constant, the initial ones are used
+  auto u = G4UniformRand() * g.fTotalActivity;
+  auto it = std::upper_bound(g.fCumulativeActivities.begin(),
+                             g.fCumulativeActivities.end(), u);
+  auto i = std::min<size_t>(it - g.fCumulativeActivities.begin(),
+                            g.fSources.size() - 1);
+  return g.fSources[i];
+}
+
+void GateSourceManager::PrepareNextCachedEvent() {
+  auto &l = fThreadLocalData.Get();
+  // the events are shared by the threads: the index is reserved here, the
+  // event is generated by the next call to GeneratePrimaries
+  l.fNextCachedEvent = fPrimaryCache->Next(l.fNextRunId);
+  if (l.fNextCachedEvent >= 0)
+    l.fNextSimulationTime = fPrimaryCache->GetTime(l.fNextCachedEvent);
+}
+
+void GateSourceManager::InitializeSharedEvents() {
+  auto &l = fThreadLocalData.Get();
+  fSharedSources.clear();
+  fSharedCumulativeEvents.clear();
+  unsigned long total = 0;
+  auto threads = fEventScheduler->GetNumberOfThreads();
   for (auto *source : fSources) {
-    auto t = source->PrepareNextTime(l.fCurrentSimulationTime);
-    if ((t >= min_time) && (t < max_time)) {
-      max_time = t;
-      l.fNextActiveSource = source;
-      l.fNextSimulationTime = t;
+    if (!source->CanShareEvents()) {
+      std::ostringstream oss;
+      oss << "The source '" << source->fName
+          << "' cannot be used with event_scheduling = 'guided': only the "
+             "sources defined by a number of events (n) are allowed";
+      Fatal(oss.str());
     }
+    source->SetEventSharing(true);
+    // the sources with n emit all their events at their start time
+    if (source->fStartTime < l.fCurrentTimeInterval.first ||
+        source->fStartTime >= l.fCurrentTimeInterval.second)
+      continue;
+    // n is the number of events per thread, the total is kept
+    total += source->GetMaxN() * threads;
+    fSharedSources.push_back(source);
+    fSharedCumulativeEvents.push_back(total);
+  }
+}
+
+void GateSourceManager::PrepareNextSharedEvent() {
+  auto &l = fThreadLocalData.Get();
+  l.fNextActiveSource = nullptr;
+  if (l.fChunkNext >= l.fChunkEnd) {
+    unsigned long total =
+        fSharedCumulativeEvents.empty() ? 0 : fSharedCumulativeEvents.back();
+    unsigned long first = 0;
+    unsigned long count = 0;
+    if (!fEventScheduler->NextChunk(l.fNextRunId, total, first, count))
+      return;
+    l.fChunkNext = first;
+    l.fChunkEnd = first + count;
   }
-  // If no next time in the current interval, active source is NULL
+  // the source of the event, according to its number
+  l.fNextSharedEvent = l.fChunkNext++;
+  auto it =
+      std::upper_bound(fSharedCumulativeEvents.begin(),
+                       fSharedCumulativeEvents.end(), l.fNextSharedEvent);
+  auto *source = fSharedSources[it - fSharedCumulativeEvents.begin()];
+  l.fNextActiveSource = source;
+  l.fNextSimulationTime =
+      std::max(source->fStartTime, l.fCurrentTimeInterval.first);
 }
 
 void GateSourceManager::CheckForNextRun() {
   auto &l = fThreadLocalData.Get();
-  if (l.fNextActiveSource == nullptr || fRunTerminationFlag) {
+  bool replay = fPrimaryCache != nullptr && fPrimaryCache->IsReplaying();
+  bool no_next_event =
+      replay ? l.fNextCachedEvent < 0 : l.fNextActiveSource == nullptr;
+  if (no_next_event || fRunTerminationFlag) {
     G4RunManager::GetRunManager()->AbortRun(true); // FIXME true or false ?
     l.fStartNewRun = true;
     l.fNextRunId++;
@@ -277,6 +525,15 @@ void GateSourceManager::CheckForNextRun() {
 
 void GateSourceManager::GeneratePrimaries(G4Event *event) {
   auto &l = fThreadLocalData.Get();
+  // [server mode] first event of a new job in this thread
+  if (l.fJobId != fJobId) {
+    l.fJobId = fJobId;
+    l.fStartNewRun = true;
+    l.fNextRunId = 0;
+    if (fNewJobCallback)
+      fNewJobCallback();
+  }
+
   // Needed to initialize a new Run (all threads)
   if (l.fStartNewRun) {
     PrepareRunToStart(l.fNextRunId);
@@ -285,22 +542,37 @@ void GateSourceManager::GeneratePrimaries(G4Event *event) {
   // update the current time
   l.fCurrentSimulationTime = l.fNextSimulationTime;
 
-  // Sometimes (rarely), there is no active source,
-  // so we create a fake geantino particle
-  // It may happen when the number of primary is fixed (with source.n = XX)
-  // and several runs are used.
-  if (l.fNextActiveSource == nullptr) {
-    auto *particle_table = G4ParticleTable::GetParticleTable();
-    auto *particle_def = particle_table->FindParticle("geantino");
-    auto *particle = new G4PrimaryParticle(particle_def);
-    auto p = G4ThreeVector();
-    auto *vertex = new G4PrimaryVertex(p, l.fCurrentSimulationTime);
+  // [sub-runs] move the volumes if the event is in a new time interval
+  if (fMotionTable != nullptr)
+    UpdateMotion(l.fCurrentSimulationTime);
+
+  bool replay = fPrimaryCache != nullptr && fPrimaryCache->IsReplaying();
+  if (replay && l.fNextCachedEvent >= 0) {
+    // the primaries of the cache, no source
+    fPrimaryCache->Replay(l.fNextCachedEvent, event);
+  } else if (replay || l.fNextActiveSource == nullptr) {
+    // Sometimes (rarely), there is no active source,
+    // so we create a fake geantino particle
+    // It may happen when the number of primary is fixed (with source.n = XX)
+    // and several runs are used.
+    // (the vertex and the particle are deleted with the event, both use the
+    // G4Allocator of the thread)
+    auto *particle = new G4PrimaryParticle(G4Geantino::Geantino());
+    auto *vertex =
+        new G4PrimaryVertex(G4ThreeVector(), l.fCurrentSimulationTime);
     vertex->SetPrimary(particle);
     event->AddPrimaryVertex(vertex);
-    // (allocated memory is leaked)
   } else {
-    // shoot particle
-    l.fNextActiveSource->GeneratePrimaries(event, l.fCurrentSimulationTime);
+    // shoot particle (the shared events do not depend on the thread)
+    if (fEventScheduler != nullptr)
+      fEventScheduler->SeedEvent(l.fNextRunId, l.fNextSharedEvent);
+    {
+      GateActorProfilerScope profile(l.fNextActiveSource,
+                                     GateActorProfiler::GeneratePrimaries);
+      l.fNextActiveSource->GeneratePrimaries(event, l.fCurrentSimulationTime);
+    }
+    if (fPrimaryCache != nullptr && fPrimaryCache->IsRecording())
+      fPrimaryCache->Record(l.fNextRunId, l.fCurrentSimulationTime, event);
     // log (after particle creation)
     if (LogLevel_EVENT <= GateSourceManager::fVerboseLevel) {
       auto *prim = event->GetPrimaryVertex(0)->GetPrimary(0);
@@ -319,31 +591,26 @@ void GateSourceManager::GeneratePrimaries(G4Event *event) {
   // Add user information ?
   if (fUserEventInformationFlag) {
     // the user info is deleted by the event destructor, so
-    // we need to create a new one everytime
+    // we need to create a new one everytime (from the pool of the thread,
+    // see GateUserEventInformation)
     l.fUserEventInformation = new GateUserEventInformation;
     l.fUserEventInformation->BeginOfEventAction(event);
     event->SetUserInformation(l.fUserEventInformation);
   }
 
-  // prepare the next source
-  PrepareNextSource();
+  // prepare the next source (or the next event of the cache)
+  if (replay)
+    PrepareNextCachedEvent();
+  else if (fEventScheduler != nullptr)
+    PrepareNextSharedEvent();
+  else
+    PrepareNextSource();
 
   // check if this is not the end of the run
   CheckForNextRun();
 
-  // progress bar
-  if (fProgressBarFlag) {
-    // do nothing if not the first thread
-    if (G4Threading::IsMultithreadedApplication() &&
-        G4Threading::G4GetThreadId() != 0)
-      return;
-    // count the number of event already generated
-    fCurrentEvent = fCurrentEvent + 1;
-    // update the bar sometimes
-    if (fCurrentEvent % fProgressBarStep == 0) {
-      l.fProgressBar->set_progress(fCurrentEvent);
-    }
-  }
+  // progress (counter of the thread, no lock)
+  GateProgressMonitor::CountEvent();
 }
 
 void GateSourceManager::InitializeVisualization() {
@@ -8,21 +8,23 @@
 #ifndef GateSourceManager_h
 #define GateSourceManager_h
 
-#include <G4Cache.hh>
 #include <G4ParticleGun.hh>
 #include <G4Threading.hh>
 #include <G4UIExecutive.hh>
 #include <G4UIsession.hh>
 #include <G4VUserPrimaryGeneratorAction.hh>
 #include <G4VisExecutive.hh>
-
+#include <functional>
+
+#include "GateEventScheduler.h"
+#include "GateIndexedMinHeap.h"
+#include "GateMotionTable.h"
+#include "GatePrimaryCache.h"
+#include "GateProgressMonitor.h"
+#include "GateThreadContext.h"
 #include "GateUserEventInformation.h"
 #include "GateVActor.h"
 #include "GateVSource.h"
-#include "indicators.hpp"
-
-using namespace indicators;
-
 // Temporary: later option will be used to control the verbosity
 class UIsessionSilent : public G4UIsession {
 public:
@@ -42,6 +44,24 @@ public:
  * - select one source according to the time
  * - check end of run
  *
+ * The next times of the sources are kept in a min-heap (per thread): after
+ * an event, only the source that fired is asked for its next time.
+ * With the option aggregate_sources, the sources with the same time
+ * profile (see GateVSource::CanShareTimeProfile) are scheduled as a single
+ * Poisson process, whose total activity is the sum of the activities; the
+ * emitting source is then selected according to its activity.
+ *
+ * With a primary cache (see GatePrimaryCache), the primaries are recorded,
+ * or replayed instead of being generated by the sources.
+ *
+ * With an event scheduler (see GateEventScheduler), the events of the
+ * sources defined by n are shared by all the threads and taken by chunks,
+ * instead of n events per thread.
+ *
+ * With a motion table (see GateMotionTable, sequential only), all the time
+ * intervals are simulated in a single run (sub-runs): the volumes are moved
+ * before the first event of each interval.
+ *
  */
 
 class GateSourceManager : public G4VUserPrimaryGeneratorAction {
@@ -62,6 +82,31 @@ public:
   // [py side] set the list of actors
   void SetActors(std::vector<GateVActor *> &actors);
 
+  // [py side] record or replay the primaries (shared by all threads)
+  void SetPrimaryCache(std::shared_ptr<GatePrimaryCache> cache);
+
+  // [py side] share the events between the threads (guided scheduling)
+  void SetEventScheduler(std::shared_ptr<GateEventScheduler> scheduler);
+
+  // [py side] move the volumes during the run (sub-runs, sequential only)
+  void SetMotionTable(std::shared_ptr<GateMotionTable> table);
+
+  // [py side] function called by the master thread at the end of each run,
+  // after the actors (e.g. to write a checkpoint)
+  void SetEndOfRunCallback(std::function<void(int)> callback);
+
+  // [py side] server mode: start a new job (new list of runs) in the same
+  // initialized simulation. Called for all the source managers (master and
+  // threads) between two jobs.
+  void StartNewJob(TimeIntervals simulation_times);
+
+  // [py side] function called by each thread before its first event of a
+  // new job (e.g. to initialize again the sources in the thread)
+  void SetNewJobCallback(std::function<void()> callback);
+
+  // [sub-runs] move the volumes (and the sources) for this time
+  void UpdateMotion(double time);
+
   // Return a source
   GateVSource *FindSourceByName(std::string name) const;
 
@@ -77,6 +122,28 @@ public:
   // After an event, prepare for the next
   void PrepareNextSource();
 
+  // Ask the next time of a group of sources, and (re-)insert it in the heap
+  // if it is in the current time interval
+  void ScheduleNextTime(int group);
+
+  // Next time of a group of sources sharing a Poisson process
+  double PrepareNextTimeOfSharedGroup(int group, double current_time) const;
+
+  // Source of the group that emits the next event (weighted by activity)
+  GateVSource *SelectSourceOfGroup(int group) const;
+
+  // Build the groups of sources sharing a Poisson process
+  void InitializeSourceGroups();
+
+  // [replay] reserve the next event of the cache
+  void PrepareNextCachedEvent();
+
+  // [shared events] sources of the run and their number of events
+  void InitializeSharedEvents();
+
+  // [shared events] next event of the chunk of the thread (or a new chunk)
+  void PrepareNextSharedEvent();
+
   // Check if the current run is terminated
   void CheckForNextRun();
 
@@ -103,10 +170,11 @@ public:
   std::vector<std::string> fVisCommands;
   UIsessionSilent fSilent;
 
+  // Progress (bar and/or json file), see GateProgressMonitor
   bool fProgressBarFlag;
+  std::string fProgressFilename;
+  double fProgressInterval;
   long int fExpectedNumberOfEvents;
-  long int fProgressBarStep;
-  long int fCurrentEvent;
 
   // The following variables must be local to each threads
   struct threadLocalT {
@@ -126,23 +194,79 @@ public:
     // Next active source
     GateVSource *fNextActiveSource;
 
+    // Group of the next active source (-1 if none)
+    int fNextActiveGroup = -1;
+
+    // Next event of the primary cache (replay, -1 if none)
+    long fNextCachedEvent = -1;
+
+    // Shared events: next event, and the chunk [next, end) of the thread
+    unsigned long fNextSharedEvent = 0;
+    unsigned long fChunkNext = 0;
+    unsigned long fChunkEnd = 0;
+
+    // Next time of each group of sources, see PrepareNextSource
+    GateIndexedMinHeap fSchedule;
+
     // User information data
     GateUserEventInformation *fUserEventInformation;
 
-    // progress bar
-    indicators::ProgressBar *fProgressBar{};
+    // Last job started by the thread (server mode, see StartNewJob)
+    int fJobId = 0;
   };
-  G4Cache<threadLocalT> fThreadLocalData;
+  GateThreadLocal<threadLocalT> fThreadLocalData;
 
   // List of managed sources
   std::vector<GateVSource *> fSources;
 
+  // Sources scheduled together: one source queried with PrepareNextTime, or
+  // several sources with the same time profile (option aggregate_sources)
+  struct SourceGroup {
+    std::vector<GateVSource *> fSources;
+    // cumulative activities of the sources, to select the emitting one
+    std::vector<double> fCumulativeActivities;
+    double fTotalActivity = 0;
+    double fStartTime = 0;
+    double fEndTime = 0;
+    // 0 for a constant activity
+    double fDecayConstant = 0;
+
+    bool IsShared() const { return fSources.size() > 1; }
+  };
+  std::vector<SourceGroup> fSourceGroups;
+
+  // Option: sources with the same time profile share a Poisson process
+  bool fAggregateSourcesFlag = false;
+
+  // Primaries recorded or replayed (nullptr if none)
+  std::shared_ptr<GatePrimaryCache> fPrimaryCache;
+
+  // Events shared by the threads (nullptr if none), with the sources of the
+  // current run and their cumulative number of events (all threads)
+  std::shared_ptr<GateEventScheduler> fEventScheduler;
+  std::vector<GateVSource *> fSharedSources;
+  std::vector<unsigned long> fSharedCumulativeEvents;
+
+  // Motion of the volumes during the run (nullptr if none)
+  std::shared_ptr<GateMotionTable> fMotionTable;
+
   // List of actors (for PreRunMaster callback)
   std::vector<GateVActor *> fActors;
 
   // List of run time intervals
   TimeIntervals fSimulationTimes;
 
+  // First run to simulate (> 0 when resuming from a checkpoint)
+  int fFirstRunId = 0;
+
+  // Called at the end of each run by the master thread (may be empty)
+  std::function<void(int)> fEndOfRunCallback;
+
+  // Current job (server mode), and function called by each thread when it
+  // starts a new job (may be empty)
+  int fJobId = 0;
+  std::function<void()> fNewJobCallback;
+
   // static verbose level
   static int fVerboseLevel;
 
@@ -0,0 +1,80 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateSparseImage_h
+#define GateSparseImage_h
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/*
+    Sparse 3D image made of tiles of TileSize^3 voxels. A tile is only
+    allocated the first time one of its voxels is accessed, so the memory is
+    proportional to the scored region instead of the full image. Voxels are
+    identified by their (x,y,z) index, the flat index used by the ForEach
+    functions is the same as in the corresponding itk image (x fastest).
+
+    This class is not thread safe: it is intended to be used as a thread local
+    accumulator, merged into a shared sparse image (with a lock) at the end of
+    the run, and added to the dense output image once all threads are done.
+ */
+
+template <class T> class GateSparseImage {
+public:
+  // Tiles of 8x8x8 voxels
+  static constexpr int TileShift = 3;
+  static constexpr int TileSize = 1 << TileShift;
+  static constexpr int TileMask = TileSize - 1;
+  static constexpr int TileNumberOfVoxels = TileSize * TileSize * TileSize;
+
+  // Set the image size (in voxels) and release all tiles
+  void Initialize(long size_x, long size_y, long size_z);
+
+  // Release all tiles (the size is kept)
+  void Clear();
+
+  // Get the value of a voxel, allocate (with zeros) its tile if needed
+  inline T &GetValue(long x, long y, long z);
+
+  // Add the values of other (same size) and release its tiles. The tiles
+  // not yet allocated here are moved, without copy.
+  void Merge(GateSparseImage &other);
+
+  // Call f(flat_index, value) for all voxels of the allocated tiles
+  template <class F> void ForEachValue(F f) const;
+
+  // Same for the tiles of the slices [z_begin, z_end[, the limits are
+  // multiples of TileSize (or the size)
+  template <class F>
+  void ForEachValueInSlices(long z_begin, long z_end, F f) const;
+
+  // Add all values to a dense buffer with the same size (x fastest)
+  template <class PixelType> void AddToBuffer(PixelType *buffer) const;
+
+  // Same for the slices [z_begin, z_end[ (see ForEachValueInSlices)
+  template <class PixelType>
+  void AddToBuffer(PixelType *buffer, long z_begin, long z_end) const;
+
+  size_t GetNumberOfAllocatedTiles() const { return fNumberOfAllocatedTiles; }
+
+  // Bytes of the allocated tiles and of the table of tiles
+  size_t GetMemoryBytes() const {
+    return fTiles.capacity() * sizeof(std::unique_ptr<T[]>) +
+           fNumberOfAllocatedTiles * TileNumberOfVoxels * sizeof(T);
+  }
+
+protected:
+  long fSize[3] = {0, 0, 0};
+  long fNumberOfTiles[3] = {0, 0, 0};
+  size_t fNumberOfAllocatedTiles = 0;
+  std::vector<std::unique_ptr<T[]>> fTiles;
+};
+
+#include "GateSparseImage.txx"
+
+#endif // GateSparseImage_h
@@ -0,0 +1,101 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+template<class T>
+void GateSparseImage<T>::Initialize(long size_x, long size_y, long size_z) {
+  fSize[0] = size_x;
+  fSize[1] = size_y;
+  fSize[2] = size_z;
+  for (auto i = 0; i < 3; i++)
+    fNumberOfTiles[i] = (fSize[i] + TileSize - 1) >> TileShift;
+  Clear();
+}
+
+template<class T>
+void GateSparseImage<T>::Clear() {
+  fTiles.clear();
+  fTiles.resize(fNumberOfTiles[0] * fNumberOfTiles[1] * fNumberOfTiles[2]);
+  fNumberOfAllocatedTiles = 0;
+}
+
+template<class T>
+T &GateSparseImage<T>::GetValue(long x, long y, long z) {
+  auto t = (x >> TileShift) +
+           fNumberOfTiles[0] * ((y >> TileShift) + fNumberOfTiles[1] * (z >> TileShift));
+  auto &tile = fTiles[t];
+  if (tile == nullptr) {
+    // first touch: allocate the tile and fill with zeros
+    tile.reset(new T[TileNumberOfVoxels]());
+    fNumberOfAllocatedTiles++;
+  }
+  auto v = (x & TileMask) + TileSize * ((y & TileMask) + TileSize * (z & TileMask));
+  return tile[v];
+}
+
+template<class T>
+void GateSparseImage<T>::Merge(GateSparseImage &other) {
+  for (size_t t = 0; t < other.fTiles.size(); t++) {
+    auto &tile = other.fTiles[t];
+    if (tile == nullptr) continue;
+    if (fTiles[t] == nullptr) {
+      fTiles[t] = std::move(tile);
+      fNumberOfAllocatedTiles++;
+      continue;
+    }
+    for (int v = 0; v < TileNumberOfVoxels; v++)
+      fTiles[t][v] += tile[v];
+  }
+  other.Clear();
+}
+
+template<class T>
+template<class F>
+void GateSparseImage<T>::ForEachValue(F f) const {
+  ForEachValueInSlices(0, fSize[2], f);
+}
+
+template<class T>
+template<class F>
+void GateSparseImage<T>::ForEachValueInSlices(long z_begin, long z_end, F f) const {
+  auto tz_end = std::min<long>((z_end + TileSize - 1) >> TileShift, fNumberOfTiles[2]);
+  for (long tz = z_begin >> TileShift; tz < tz_end; tz++) {
+    for (long ty = 0; ty < fNumberOfTiles[1]; ty++) {
+      for (long tx = 0; tx < fNumberOfTiles[0]; tx++) {
+        auto &tile = fTiles[tx + fNumberOfTiles[0] * (ty + fNumberOfTiles[1] * tz)];
+        if (tile == nullptr) continue;
+        // the last tiles may be partially outside the image
+        auto x0 = tx << TileShift;
+        auto y0 = ty << TileShift;
+        auto z0 = tz << TileShift;
+        auto nx = std::min<long>(TileSize, fSize[0] - x0);
+        auto ny = std::min<long>(TileSize, fSize[1] - y0);
+        auto nz = std::min<long>(TileSize, fSize[2] - z0);
+        for (long k = 0; k < nz; k++) {
+          for (long j = 0; j < ny; j++) {
+            auto flat = x0 + fSize[0] * ((y0 + j) + fSize[1] * (z0 + k));
+            const T *values = &tile[TileSize * (j + TileSize * k)];
+            for (long i = 0; i < nx; i++)
+              f(flat + i, values[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+template<class T>
+template<class PixelType>
+void GateSparseImage<T>::AddToBuffer(PixelType *buffer) const {
+  ForEachValue([buffer](long flat, const T &value) { buffer[flat] += value; });
+}
+
+template<class T>
+template<class PixelType>
+void GateSparseImage<T>::AddToBuffer(PixelType *buffer, long z_begin, long z_end) const {
+  ForEachValueInSlices(z_begin, z_end,
+                       [buffer](long flat, const T &value) { buffer[flat] += value; });
+}
@@ -0,0 +1,26 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateSpotInformation.h"
+#include "G4ios.hh"
+
+G4ThreadLocal G4Allocator<GateSpotInformation> *GateSpotInformationAllocator =
+    nullptr;
+
+void GateSpotInformation::Print() const {
+  G4cout << "Spot " << fSpotIndex << G4endl;
+}
+
+int GateSpotInformation::GetSpotIndex(const G4Event *event) {
+  if (event == nullptr || event->GetNumberOfPrimaryVertex() == 0)
+    return -1;
+  auto *info = dynamic_cast<const GateSpotInformation *>(
+      event->GetPrimaryVertex(0)->GetUserInformation());
+  if (info == nullptr)
+    return -1;
+  return info->GetSpotIndex();
+}
@@ -0,0 +1,57 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateSpotInformation_h
+#define GateSpotInformation_h
+
+#include "G4Allocator.hh"
+#include "G4Event.hh"
+#include "G4VUserPrimaryVertexInformation.hh"
+
+/*
+ * Index of the spot (or beamlet) of a treatment plan that generated a
+ * primary vertex (see GateTreatmentPlanPBSource). The object is deleted with
+ * the vertex, so it is allocated with a per-thread G4Allocator (no heap
+ * allocation per event), like GateUserEventInformation.
+ */
+
+class GateSpotInformation : public G4VUserPrimaryVertexInformation {
+
+public:
+  explicit GateSpotInformation(int spot) : fSpotIndex(spot) {}
+
+  ~GateSpotInformation() override = default;
+
+  inline void *operator new(size_t);
+
+  inline void operator delete(void *info);
+
+  void Print() const override;
+
+  int GetSpotIndex() const { return fSpotIndex; }
+
+  // Spot of the first primary vertex of the event, -1 if it has none
+  static int GetSpotIndex(const G4Event *event);
+
+protected:
+  int fSpotIndex;
+};
+
+extern G4ThreadLocal G4Allocator<GateSpotInformation>
+    *GateSpotInformationAllocator;
+
+inline void *GateSpotInformation::operator new(size_t) {
+  if (GateSpotInformationAllocator == nullptr)
+    GateSpotInformationAllocator = new G4Allocator<GateSpotInformation>;
+  return (void *)GateSpotInformationAllocator->MallocSingle();
+}
+
+inline void GateSpotInformation::operator delete(void *info) {
+  GateSpotInformationAllocator->FreeSingle((GateSpotInformation *)info);
+}
+
+#endif // GateSpotInformation_h
@@ -0,0 +1,92 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateStepBatchActor.h"
+#include "GateHelpersDict.h"
+#include "GateTimeline.h"
+#include "digitizer/GateDigiAttributeManager.h"
+
+GateStepBatchActor::GateStepBatchActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("SteppingAction");
+  fActions.insert("EndOfEventAction");
+  fActions.insert("EndOfRunAction");
+  fBatchSize = 0;
+  fApplyAtEndOfEvent = false;
+  fNumberOfBatches = 0;
+}
+
+GateStepBatchActor::~GateStepBatchActor() {
+  for (auto *att : fAttributes)
+    delete att;
+}
+
+void GateStepBatchActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fAttributeNames = DictGetVecStr(user_info, "attributes");
+  fBatchSize = DictGetInt(user_info, "batch_size");
+  fApplyAtEndOfEvent = DictGetBool(user_info, "apply_at_end_of_event");
+}
+
+void GateStepBatchActor::InitializeCpp() {
+  GateVActor::InitializeCpp();
+  // (copies of the attributes, their values are stored per thread)
+  for (auto *att : fAttributes)
+    delete att;
+  fAttributes.clear();
+  auto *am = GateDigiAttributeManager::GetInstance();
+  for (const auto &name : fAttributeNames) {
+    auto *att = am->GetDigiAttribute(name);
+    if (att->GetDigiAttributeType() == 'U') {
+      std::ostringstream oss;
+      oss << "The attribute '" << name << "' of the actor " << GetName()
+          << " cannot be given to Python (volume ID)";
+      Fatal(oss.str());
+    }
+    fAttributes.push_back(att);
+  }
+  fNumberOfBatches = 0;
+}
+
+void GateStepBatchActor::SetStepBatchFunction(StepBatchFunctionType &f) {
+  fApply = f;
+}
+
+size_t GateStepBatchActor::GetBatchSize() const {
+  if (fAttributes.empty())
+    return 0;
+  return fAttributes[0]->GetSize();
+}
+
+void GateStepBatchActor::SteppingAction(G4Step *step) {
+  for (auto *att : fAttributes)
+    att->ProcessHits(step);
+  if (GetBatchSize() >= fBatchSize)
+    ApplyCurrentBatch();
+}
+
+void GateStepBatchActor::EndOfEventAction(const G4Event * /*event*/) {
+  if (fApplyAtEndOfEvent && GetBatchSize() > 0)
+    ApplyCurrentBatch();
+}
+
+void GateStepBatchActor::EndOfRunAction(const G4Run * /*run*/) {
+  // the remaining steps of the run
+  if (GetBatchSize() > 0)
+    ApplyCurrentBatch();
+}
+
+void GateStepBatchActor::ApplyCurrentBatch() {
+  if (fApply) {
+    GateTimelineScope timeline("step batch", "callback");
+    fApply(this);
+  }
+  fNumberOfBatches++;
+  // (the capacity is kept for the next batch)
+  for (auto *att : fAttributes)
+    att->Clear();
+}
@@ -0,0 +1,77 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateStepBatchActor_h
+#define GateStepBatchActor_h
+
+#include "GateVActor.h"
+#include "digitizer/GateVDigiAttribute.h"
+#include <atomic>
+#include <functional>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Python prototyping of step scoring without one Python callback per step.
+ * The selected attributes of the steps (the digi attributes, e.g.
+ * "TotalEnergyDeposit", "PostPosition", "TrackID") are stored in columns,
+ * in each thread. Every batch_size steps (and at the end of the event if
+ * requested, and at the end of the run) the Python "apply" function is
+ * called once with the whole batch, read as numpy arrays without copy (see
+ * pyGateStepBatchActor.cpp). The batch is then cleared.
+ */
+
+class GateStepBatchActor : public GateVActor {
+
+public:
+  // Callback function
+  using StepBatchFunctionType = std::function<void(GateStepBatchActor *)>;
+
+  explicit GateStepBatchActor(py::dict &user_info);
+
+  ~GateStepBatchActor() override;
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  void EndOfEventAction(const G4Event *event) override;
+
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Main function called every step in attached volume
+  void SteppingAction(G4Step *step) override;
+
+  // set the user "apply" function (python)
+  void SetStepBatchFunction(StepBatchFunctionType &f);
+
+  // Number of steps in the current batch of the calling thread
+  size_t GetBatchSize() const;
+
+  // Attributes (columns) of the batch, their values are the ones of the
+  // calling thread
+  const std::vector<GateVDigiAttribute *> &GetAttributes() const {
+    return fAttributes;
+  }
+
+  // Number of batches given to the apply function (all threads)
+  unsigned long GetNumberOfBatches() const { return fNumberOfBatches; }
+
+protected:
+  // Give the current batch to the "apply" function, then clear it
+  void ApplyCurrentBatch();
+
+  std::vector<std::string> fAttributeNames;
+  std::vector<GateVDigiAttribute *> fAttributes;
+  size_t fBatchSize;
+  bool fApplyAtEndOfEvent;
+  StepBatchFunctionType fApply;
+  std::atomic<unsigned long> fNumberOfBatches;
+};
+
+#endif // GateStepBatchActor_h
@@ -0,0 +1,81 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateStepContext.h"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+
+thread_local GateStepContext GateStepContext::fCurrent;
+
+void GateStepContext::Reset(const G4Step *step, unsigned long serial) {
+  fStep = step;
+  fStepSerial = serial;
+  fFlags = 0;
+  fNumberOfVoxels = 0;
+  fNumberOfDEDX = 0;
+}
+
+const G4Material *GateStepContext::GetMaterial() {
+  if ((fFlags & Material) == 0) {
+    fMaterial = fStep->GetPreStepPoint()->GetMaterial();
+    fFlags |= Material;
+  }
+  return fMaterial;
+}
+
+double GateStepContext::GetDensity() { return GetMaterial()->GetDensity(); }
+
+double GateStepContext::GetMeanKineticEnergy() {
+  if ((fFlags & Energy) == 0) {
+    auto energy1 = fStep->GetPreStepPoint()->GetKineticEnergy();
+    auto energy2 = fStep->GetPostStepPoint()->GetKineticEnergy();
+    fMeanKineticEnergy = (energy1 + energy2) / 2;
+    // for gamma, the dE/dx of the electrons is used
+    fDEDXParticle = fStep->GetTrack()->GetParticleDefinition();
+    if (fDEDXParticle == G4Gamma::Gamma())
+      fDEDXParticle = G4Electron::Electron();
+    fFlags |= Energy;
+  }
+  return fMeanKineticEnergy;
+}
+
+const G4ParticleDefinition *GateStepContext::GetDEDXParticle() {
+  GetMeanKineticEnergy();
+  return fDEDXParticle;
+}
+
+double GateStepContext::GetDEDX(GateStoppingPowerTable &table,
+                                const G4Material *mat) {
+  return GetCachedDEDX(table, mat, nullptr);
+}
+
+double GateStepContext::GetDEDXRatio(GateStoppingPowerTable &table,
+                                     const G4Material *mat,
+                                     const G4Material *ref) {
+  return GetCachedDEDX(table, mat, ref);
+}
+
+double GateStepContext::GetCachedDEDX(GateStoppingPowerTable &table,
+                                      const G4Material *mat,
+                                      const G4Material *ref) {
+  const auto type = table.GetType();
+  const auto use_table = table.GetUseTable();
+  for (auto i = 0; i < fNumberOfDEDX; i++) {
+    const auto &d = fDEDX[i];
+    if (d.fMaterial == mat && d.fRef == ref && d.fType == type &&
+        d.fUseTable == use_table)
+      return d.fValue;
+  }
+  const auto energy = GetMeanKineticEnergy();
+  const auto value =
+      ref == nullptr
+          ? table.GetDEDX(energy, fDEDXParticle, mat)
+          : table.GetDEDXRatio(energy, fDEDXParticle, mat, ref);
+  if (fNumberOfDEDX < fMaxEntries)
+    fDEDX[fNumberOfDEDX++] = {type, use_table, mat, ref, value};
+  return value;
+}
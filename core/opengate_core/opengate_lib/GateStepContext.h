@@ -0,0 +1,103 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateStepContext_h
+#define GateStepContext_h
+
+#include "G4Material.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Step.hh"
+#include "GateHelpersImage.h"
+#include "GateStoppingPowerTable.h"
+#include "GateThreadContext.h"
+
+/*
+ * Quantities derived from the current step (hit positions, voxel index,
+ * material, dE/dx), computed on first request and shared by all the actors
+ * that receive this step. Several actors are often attached to the same
+ * volume (dose, LET, ...): the voxel index of an image geometry or the
+ * dE/dx of a material is then computed once per step.
+ *
+ * There is one context per thread, reset when a new step reaches the actors
+ * (see GateMultiFunctionalDetector::ProcessHits).
+ *
+ * The random hit position is not shared: each actor draws its own.
+ */
+class GateStepContext {
+public:
+  // The context of the step in the current thread
+  static GateStepContext &Get(const G4Step *step);
+
+  template <HitType H> G4ThreeVector GetHitPosition();
+
+  // Same as t.TransformPointToIndex(GetHitPosition<H>(), index)
+  template <HitType H, class IndexType>
+  bool GetVoxelIndex(const GateImageIndexTransform &t, IndexType &index);
+
+  // Material and density of the pre-step point
+  const G4Material *GetMaterial();
+  double GetDensity();
+
+  // (pre + post) / 2 kinetic energy and particle used for the dE/dx
+  // (electron for gamma), see GetDEDX
+  double GetMeanKineticEnergy();
+  const G4ParticleDefinition *GetDEDXParticle();
+
+  // dE/dx in mat (or ratio dE/dx(ref) / dE/dx(mat)) of the dE/dx
+  // particle at the mean kinetic energy. The value is shared by the tables
+  // of the same type and mode.
+  double GetDEDX(GateStoppingPowerTable &table, const G4Material *mat);
+  double GetDEDXRatio(GateStoppingPowerTable &table, const G4Material *mat,
+                      const G4Material *ref);
+
+protected:
+  void Reset(const G4Step *step, unsigned long serial);
+
+  double GetCachedDEDX(GateStoppingPowerTable &table, const G4Material *mat,
+                       const G4Material *ref);
+
+  // bits of the quantities already computed for this step (with the bits
+  // 1 << H for the pre, post and middle positions)
+  enum Flag : unsigned { Material = 8, Energy = 16 };
+
+  // a few voxel indices and dE/dx per step are enough (one entry per image
+  // geometry or per material)
+  static constexpr int fMaxEntries = 4;
+
+  struct VoxelEntry {
+    int fTransformId;
+    HitType fHitType;
+    bool fInside;
+    long fIndex[3];
+  };
+
+  struct DEDXEntry {
+    GateStoppingPowerTable::DEDXType fType;
+    bool fUseTable;
+    const G4Material *fMaterial;
+    const G4Material *fRef;
+    double fValue;
+  };
+
+  const G4Step *fStep = nullptr;
+  unsigned long fStepSerial = 0;
+  unsigned fFlags = 0;
+  G4ThreeVector fPositions[3];
+  const G4Material *fMaterial = nullptr;
+  double fMeanKineticEnergy = 0;
+  const G4ParticleDefinition *fDEDXParticle = nullptr;
+  VoxelEntry fVoxels[fMaxEntries]{};
+  int fNumberOfVoxels = 0;
+  DEDXEntry fDEDX[fMaxEntries]{};
+  int fNumberOfDEDX = 0;
+
+  static thread_local GateStepContext fCurrent;
+};
+
+#include "GateStepContext.txx"
+
+#endif // GateStepContext_h
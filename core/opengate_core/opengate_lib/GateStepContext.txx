@@ -0,0 +1,58 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+inline GateStepContext &GateStepContext::Get(const G4Step *step) {
+  const auto serial = GateThreadContext::Current().fStepSerial;
+  if (fCurrent.fStepSerial != serial || fCurrent.fStep != step)
+    fCurrent.Reset(step, serial);
+  return fCurrent;
+}
+
+template <HitType H> G4ThreeVector GateStepContext::GetHitPosition() {
+  if constexpr (H == HitType::Pre || H == HitType::Post ||
+                H == HitType::Middle) {
+    constexpr auto i = static_cast<int>(H);
+    constexpr unsigned flag = 1u << i;
+    if ((fFlags & flag) == 0) {
+      fPositions[i] = ::GetHitPosition<H>(fStep);
+      fFlags |= flag;
+    }
+    return fPositions[i];
+  } else {
+    // (random position: a new one for each call)
+    return ::GetHitPosition<H>(fStep);
+  }
+}
+
+template <HitType H, class IndexType>
+bool GateStepContext::GetVoxelIndex(const GateImageIndexTransform &t,
+                                    IndexType &index) {
+  if constexpr (H == HitType::Random || H == HitType::Segment) {
+    return t.TransformPointToIndex(GetHitPosition<H>(), index);
+  } else {
+    const auto id = t.GetId();
+    for (auto i = 0; i < fNumberOfVoxels; i++) {
+      const auto &v = fVoxels[i];
+      if (v.fTransformId == id && v.fHitType == H) {
+        for (auto j = 0; j < 3; j++)
+          index[j] = static_cast<typename IndexType::IndexValueType>(
+              v.fIndex[j]);
+        return v.fInside;
+      }
+    }
+    const bool inside = t.TransformPointToIndex(GetHitPosition<H>(), index);
+    if (fNumberOfVoxels < fMaxEntries && id >= 0) {
+      auto &v = fVoxels[fNumberOfVoxels++];
+      v.fTransformId = id;
+      v.fHitType = H;
+      v.fInside = inside;
+      for (auto j = 0; j < 3; j++)
+        v.fIndex[j] = inside ? static_cast<long>(index[j]) : 0;
+    }
+    return inside;
+  }
+}
@@ -0,0 +1,112 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateStoppingPowerTable.h"
+#include <cfloat>
+#include <cmath>
+
+GateStoppingPowerTable::GateStoppingPowerTable(DEDXType type) {
+  fType = type;
+  fUseTable = true;
+  fLogMinEnergy = std::log(fMinEnergy);
+  auto nb_decades = std::log10(fMaxEnergy / fMinEnergy);
+  fNumberOfBins = static_cast<int>(std::ceil(nb_decades * fBinsPerDecade));
+  fLogBinWidth = (std::log(fMaxEnergy) - fLogMinEnergy) / fNumberOfBins;
+  fLastKey = KeyType(nullptr, nullptr);
+  fLastTable = nullptr;
+  fLastRatioKey = RatioKeyType(fLastKey, nullptr);
+  fLastRatioTable = nullptr;
+}
+
+double GateStoppingPowerTable::ComputeDEDX(double energy,
+                                           const G4ParticleDefinition *p,
+                                           const G4Material *mat) {
+  double dedx_cut = DBL_MAX;
+  if (fType == Electronic)
+    return fEmCalculator.ComputeElectronicDEDX(energy, p, mat, dedx_cut);
+  return fEmCalculator.ComputeTotalDEDX(energy, p, mat, dedx_cut);
+}
+
+double GateStoppingPowerTable::ComputeDEDXRatio(double energy,
+                                                const G4ParticleDefinition *p,
+                                                const G4Material *mat,
+                                                const G4Material *ref) {
+  auto dedx_mat = ComputeDEDX(energy, p, mat);
+  auto dedx_ref = ComputeDEDX(energy, p, ref);
+  if (dedx_mat == 0 || dedx_ref == 0)
+    return 0.0;
+  return dedx_ref / dedx_mat;
+}
+
+const GateStoppingPowerTable::TableType &
+GateStoppingPowerTable::GetTable(const G4ParticleDefinition *p,
+                                 const G4Material *mat) {
+  auto key = KeyType(p, mat);
+  if (fLastTable != nullptr && key == fLastKey)
+    return *fLastTable;
+  auto it = fTables.find(key);
+  if (it == fTables.end()) {
+    // first time for this particle/material: fill the table
+    TableType table(fNumberOfBins + 1);
+    for (auto i = 0; i <= fNumberOfBins; i++) {
+      auto e = std::exp(fLogMinEnergy + i * fLogBinWidth);
+      table[i] = ComputeDEDX(e, p, mat);
+    }
+    it = fTables.emplace(key, std::move(table)).first;
+  }
+  fLastKey = key;
+  fLastTable = &it->second;
+  return it->second;
+}
+
+const GateStoppingPowerTable::TableType &
+GateStoppingPowerTable::GetRatioTable(const G4ParticleDefinition *p,
+                                      const G4Material *mat,
+                                      const G4Material *ref) {
+  auto key = RatioKeyType(KeyType(p, mat), ref);
+  if (fLastRatioTable != nullptr && key == fLastRatioKey)
+    return *fLastRatioTable;
+  auto it = fRatioTables.find(key);
+  if (it == fRatioTables.end()) {
+    TableType table(fNumberOfBins + 1);
+    for (auto i = 0; i <= fNumberOfBins; i++) {
+      auto e = std::exp(fLogMinEnergy + i * fLogBinWidth);
+      table[i] = ComputeDEDXRatio(e, p, mat, ref);
+    }
+    it = fRatioTables.emplace(key, std::move(table)).first;
+  }
+  fLastRatioKey = key;
+  fLastRatioTable = &it->second;
+  return it->second;
+}
+
+double GateStoppingPowerTable::Interpolate(const TableType &table,
+                                           double energy) const {
+  auto x = (std::log(energy) - fLogMinEnergy) / fLogBinWidth;
+  auto i = static_cast<int>(x);
+  if (i >= fNumberOfBins)
+    return table[fNumberOfBins];
+  auto w = x - i;
+  return table[i] * (1.0 - w) + table[i + 1] * w;
+}
+
+double GateStoppingPowerTable::GetDEDX(double energy,
+                                       const G4ParticleDefinition *p,
+                                       const G4Material *mat) {
+  if (!fUseTable || energy < fMinEnergy || energy > fMaxEnergy)
+    return ComputeDEDX(energy, p, mat);
+  return Interpolate(GetTable(p, mat), energy);
+}
+
+double GateStoppingPowerTable::GetDEDXRatio(double energy,
+                                            const G4ParticleDefinition *p,
+                                            const G4Material *mat,
+                                            const G4Material *ref) {
+  if (!fUseTable || energy < fMinEnergy || energy > fMaxEnergy)
+    return ComputeDEDXRatio(energy, p, mat, ref);
+  return Interpolate(GetRatioTable(p, mat, ref), energy);
+}
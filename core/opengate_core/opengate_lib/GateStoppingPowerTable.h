@@ -0,0 +1,91 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateStoppingPowerTable_h
+#define GateStoppingPowerTable_h
+
+#include "CLHEP/Units/SystemOfUnits.h"
+#include "G4EmCalculator.hh"
+#include "G4Material.hh"
+#include "G4ParticleDefinition.hh"
+#include <map>
+#include <vector>
+
+/*
+    Cache of G4EmCalculator stopping powers (total or electronic dE/dx).
+
+    For each (particle, material) pair, the dE/dx is computed once, lazily,
+    on a log-energy grid and then linearly interpolated (in log(E)). The
+    ratios of stopping powers between two materials (e.g. water/material to
+    convert to dose to water) are tabulated in the same way.
+
+    G4EmCalculator is not thread safe: one table must be used per thread
+    (e.g. in a G4Cache).
+ */
+
+class GateStoppingPowerTable {
+public:
+  enum DEDXType { Total, Electronic };
+
+  explicit GateStoppingPowerTable(DEDXType type = Total);
+
+  // If false, no table: the dE/dx is computed at each call (reference mode)
+  void SetUseTable(bool b) { fUseTable = b; }
+  bool GetUseTable() const { return fUseTable; }
+
+  DEDXType GetType() const { return fType; }
+
+  // dE/dx of the particle in the material
+  double GetDEDX(double energy, const G4ParticleDefinition *p,
+                 const G4Material *mat);
+
+  // dE/dx(ref) / dE/dx(mat). Zero if one of the dE/dx is zero.
+  double GetDEDXRatio(double energy, const G4ParticleDefinition *p,
+                      const G4Material *mat, const G4Material *ref);
+
+  // Energy range of the tables (outside, the dE/dx is computed)
+  static constexpr double fMinEnergy = 1.0 * CLHEP::keV;
+  static constexpr double fMaxEnergy = 10.0 * CLHEP::GeV;
+  static constexpr int fBinsPerDecade = 50;
+
+protected:
+  typedef std::vector<double> TableType;
+  typedef std::pair<const G4ParticleDefinition *, const G4Material *> KeyType;
+  typedef std::pair<KeyType, const G4Material *> RatioKeyType;
+
+  double ComputeDEDX(double energy, const G4ParticleDefinition *p,
+                     const G4Material *mat);
+
+  double ComputeDEDXRatio(double energy, const G4ParticleDefinition *p,
+                          const G4Material *mat, const G4Material *ref);
+
+  const TableType &GetTable(const G4ParticleDefinition *p,
+                            const G4Material *mat);
+
+  const TableType &GetRatioTable(const G4ParticleDefinition *p,
+                                 const G4Material *mat, const G4Material *ref);
+
+  double Interpolate(const TableType &table, double energy) const;
+
+  DEDXType fType;
+  bool fUseTable;
+  int fNumberOfBins;
+  double fLogMinEnergy;
+  double fLogBinWidth;
+  G4EmCalculator fEmCalculator;
+  std::map<KeyType, TableType> fTables;
+  std::map<RatioKeyType, TableType> fRatioTables;
+
+  // Consecutive steps are often for the same particle in the same material:
+  // the last table found is kept to avoid the map lookup
+  KeyType fLastKey;
+  const TableType *fLastTable;
+  RatioKeyType fLastRatioKey;
+  const TableType *fLastRatioTable;
+};
+
+#endif // GateStoppingPowerTable_h
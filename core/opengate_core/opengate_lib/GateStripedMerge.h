@@ -0,0 +1,88 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateStripedMerge_h
+#define GateStripedMerge_h
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+/*
+    Merge of the per-thread buffers into a shared image at the end of a run,
+    by stripes of slices (z) instead of a single lock on the whole image.
+
+    The slices are grouped in stripes of whole tiles (see GateSparseImage),
+    each stripe has its own lock. A thread adds its buffer stripe by stripe,
+    starting with the stripe of its thread id and skipping the stripes that
+    are locked by other threads (they are done later). When the workers end
+    their run at the same time, they add different stripes concurrently: the
+    reduction is shared by all the (otherwise idle) threads instead of being
+    a serial tail of the run.
+ */
+
+class GateStripedMerge {
+public:
+  static constexpr int MaxNumberOfStripes = 64;
+
+  // Set the number of slices of the image, the stripes are made of whole
+  // groups of slice_multiple slices (to be called by a single thread)
+  void Initialize(long size_z, long slice_multiple) {
+    long groups = (size_z + slice_multiple - 1) / slice_multiple;
+    groups = std::max<long>(groups, 1);
+    auto groups_per_stripe =
+        (groups + MaxNumberOfStripes - 1) / MaxNumberOfStripes;
+    fSlicesPerStripe = groups_per_stripe * slice_multiple;
+    fSizeZ = size_z;
+    fNumberOfStripes =
+        std::max<long>((size_z + fSlicesPerStripe - 1) / fSlicesPerStripe, 1);
+  }
+
+  int GetNumberOfStripes() const { return fNumberOfStripes; }
+
+  // Call add(z_begin, z_end) once per stripe, with the lock of the stripe.
+  // The first stripe is first % number of stripes (e.g. the thread id).
+  template <class F> void Merge(int first, F add) {
+    std::vector<int> pending;
+    for (int i = 0; i < fNumberOfStripes; i++)
+      pending.push_back((std::max(first, 0) + i) % fNumberOfStripes);
+    std::vector<int> busy;
+    while (!pending.empty()) {
+      busy.clear();
+      for (auto s : pending) {
+        std::unique_lock<std::mutex> lock(fMutexes[s], std::try_to_lock);
+        if (!lock.owns_lock()) {
+          busy.push_back(s);
+          continue;
+        }
+        add(Begin(s), End(s));
+      }
+      if (!busy.empty() && busy.size() == pending.size()) {
+        // all the remaining stripes are in use: wait for the first one
+        std::lock_guard<std::mutex> lock(fMutexes[busy.front()]);
+        add(Begin(busy.front()), End(busy.front()));
+        busy.erase(busy.begin());
+      }
+      pending.swap(busy);
+    }
+  }
+
+protected:
+  long Begin(int stripe) const { return stripe * fSlicesPerStripe; }
+
+  long End(int stripe) const {
+    return std::min(fSizeZ, (stripe + 1) * fSlicesPerStripe);
+  }
+
+  long fSizeZ = 0;
+  long fSlicesPerStripe = 1;
+  int fNumberOfStripes = 1;
+  std::array<std::mutex, MaxNumberOfStripes> fMutexes;
+};
+
+#endif // GateStripedMerge_h
@@ -6,6 +6,7 @@
    ------------------------------------ -------------- */
 
 #include "G4EmCalculator.hh"
+#include "G4Gamma.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4RandomTools.hh"
 #include "G4RunManager.hh"
@@ -17,16 +18,24 @@
 #include "GateMaterialMuHandler.h"
 #include "GateTLEDoseActor.h"
 
+#include <algorithm>
 #include <iostream>
 #include <itkAddImageFilter.h>
 #include <itkImageRegionIterator.h>
 #include <vector>
 
-G4Mutex SetPixelTLEMutex = G4MUTEX_INITIALIZER;
-
 GateTLEDoseActor::GateTLEDoseActor(py::dict &user_info)
     : GateDoseActor(user_info) {
   fMultiThreadReady = true;
+  fGamma = G4Gamma::Gamma();
+}
+
+G4int &GateTLEDoseActor::SecondaryCount(threadLocalT &l, G4int track_id) {
+  // track ids are dense within an event, so a flat vector indexed by id is
+  // enough; -1 marks a track without pending secondaries
+  if (track_id >= static_cast<G4int>(l.fSecNbWhichDeposit.size()))
+    l.fSecNbWhichDeposit.resize(track_id + 1, -1);
+  return l.fSecNbWhichDeposit[track_id];
 }
 
 void GateTLEDoseActor::InitializeUserInfo(py::dict &user_info) {
@@ -35,6 +44,10 @@ void GateTLEDoseActor::InitializeUserInfo(py::dict &user_info) {
   fEnergyMax = py::cast<double>(user_info["energy_max"]);
   auto database = py::cast<std::string>(user_info["database"]);
   fMaterialMuHandler = GateMaterialMuHandler::GetInstance(database, fEnergyMax);
+  if (!user_info["mu_table_cache_folder"].is_none()) {
+    fMaterialMuHandler->SetCacheFolder(
+        DictGetStr(user_info, "mu_table_cache_folder"));
+  }
 }
 
 void GateTLEDoseActor::BeginOfEventAction(const G4Event *event) {
@@ -46,14 +59,13 @@ void GateTLEDoseActor::BeginOfEventAction(const G4Event *event) {
 void GateTLEDoseActor::PreUserTrackingAction(const G4Track *track) {
   auto &l = fThreadLocalData.Get();
 
-  // if the particle is a gamma, we associate a map which will associate the
-  // gamma TID with the number of secondaries created when the particle is in
-  // TLE mode
+  // if the particle is a gamma, we associate its TID with the number of
+  // secondaries created when the particle is in TLE mode
 
-  if (track->GetDefinition()->GetParticleName() == "gamma") {
+  if (track->GetDefinition() == fGamma) {
     l.fIsTLEGamma = false;
     l.fIsTLESecondary = false;
-    l.fSecNbWhichDeposit[track->GetTrackID()] = 0;
+    SecondaryCount(l, track->GetTrackID()) = 0;
   }
 
   // if the particle is not a gamma, we want to associate a secondary boolean to
@@ -71,34 +83,30 @@ void GateTLEDoseActor::PreUserTrackingAction(const G4Track *track) {
 
   else {
     auto parent_id = track->GetParentID();
-    // std::cout<<"begin"<<std::endl;
-    for (auto it = l.fSecNbWhichDeposit.begin();
-         it != l.fSecNbWhichDeposit.end(); ++it) {
-      // std::cout <<it->first<<"  "<<it->second<<std::endl;
-      if (parent_id == it->first) {
-        if (it->second > 0) {
-          l.fIsTLESecondary = true;
-        }
-        if (it->second == 0) {
-          l.fSecNbWhichDeposit.erase(it);
-          l.fIsTLESecondary = false;
-          break;
-        }
-        it->second--;
+    if (parent_id < static_cast<G4int>(l.fSecNbWhichDeposit.size())) {
+      auto &nb = l.fSecNbWhichDeposit[parent_id];
+      if (nb == 0) {
+        // no remaining secondary for this gamma: forget it
+        nb = -1;
+        l.fIsTLESecondary = false;
+      } else if (nb > 0) {
+        l.fIsTLESecondary = true;
+        nb--;
       }
     }
-    // std::cout<<"end"<<std::endl;
   }
 }
 
 void GateTLEDoseActor::SteppingAction(G4Step *step) {
   auto &l = fThreadLocalData.Get();
+  // (pointer comparison, no string per step)
+  const bool is_gamma = step->GetTrack()->GetDefinition() == fGamma;
 
   auto pre_step = step->GetPreStepPoint();
   double energy = 0;
   if (pre_step != 0)
     energy = pre_step->GetKineticEnergy();
-  if (step->GetTrack()->GetDefinition()->GetParticleName() == "gamma") {
+  if (is_gamma) {
 
     // For too high energy, no TLE
     if (energy > fEnergyMax) {
@@ -114,14 +122,15 @@ void GateTLEDoseActor::SteppingAction(G4Step *step) {
       auto nbSec = step->GetSecondaryInCurrentStep()->size();
       if (nbSec > 0) {
         l.fIsTLESecondary = true;
-        l.fSecNbWhichDeposit[step->GetTrack()->GetTrackID()] += nbSec;
+        auto &nb = SecondaryCount(l, step->GetTrack()->GetTrackID());
+        nb = std::max(nb, 0) + static_cast<G4int>(nbSec);
       }
       // l.fLastTrackId += step->GetSecondaryInCurrentStep()->size();
     }
   }
 
   // For non-gamma particle, no TLE
-  if (step->GetTrack()->GetDefinition()->GetParticleName() != "gamma") {
+  if (!is_gamma) {
     if (l.fIsTLESecondary == true) {
       return;
     }
@@ -144,29 +153,24 @@ void GateTLEDoseActor::SteppingAction(G4Step *step) {
   }
   double dose = edep / density;
 
+  // counts are not scored for TLE gamma deposits
+  auto time = GetStepTime(step);
+  if (fHitType == HitType::Segment) {
+    // spread along the photon step, proportionally to the length in each voxel
+    fIndexTransform.ForEachVoxelOnSegment<Image3DType::IndexType>(
+        pre_step->GetPosition(), step->GetPostStepPoint()->GetPosition(),
+        [&](const Image3DType::IndexType &index, double fraction) {
+          ScoreVoxel(index, edep * fraction, dose * fraction, false, time);
+        });
+    return;
+  }
+
   // Get the voxel index and check if the step was within the 3D image
   G4ThreeVector position;
   bool isInside;
   Image3DType::IndexType index;
   GetVoxelPosition(step, position, isInside, index);
-  auto event_id =
-      G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
   if (isInside) {
-    G4AutoLock mutex(&SetPixelTLEMutex); // mutex is bound to the if-scope
-    if (fDoseFlag) {
-      ImageAddValue<Image3DType>(cpp_dose_image, index, dose);
-    }
-    ImageAddValue<Image3DType>(cpp_edep_image, index, edep);
-
-    if (fEdepSquaredFlag || fDoseSquaredFlag) {
-      if (fEdepSquaredFlag) {
-        ScoreSquaredValue(fThreadLocalDataEdep.Get(), cpp_edep_squared_image,
-                          edep, event_id, index);
-      }
-      if (fDoseSquaredFlag) {
-        ScoreSquaredValue(fThreadLocalDataDose.Get(), cpp_dose_squared_image,
-                          dose, event_id, index);
-      }
-    }
+    ScoreVoxel(index, edep, dose, false, time);
   }
 }
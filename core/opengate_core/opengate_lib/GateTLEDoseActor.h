@@ -10,10 +10,11 @@
 
 #include "GateDoseActor.h"
 #include "GateMaterialMuHandler.h"
+#include "GateThreadContext.h"
 
-#include "G4Cache.hh"
 #include "G4EmCalculator.hh"
 #include "G4NistManager.hh"
+#include "G4ParticleDefinition.hh"
 #include "G4VPrimitiveScorer.hh"
 
 #include <pybind11/stl.h>
@@ -45,9 +46,17 @@ public:
     // Bool if current track is a TLE gamma or not
     bool fIsTLEGamma;
     bool fIsTLESecondary;
-    std::map<G4int, G4int> fSecNbWhichDeposit;
+    // Number of secondaries still to track, indexed by the gamma track id
+    // (-1 if the track is not a gamma with pending secondaries)
+    std::vector<G4int> fSecNbWhichDeposit;
   };
-  G4Cache<threadLocalT> fThreadLocalData;
+  GateThreadLocal<threadLocalT> fThreadLocalData;
+
+  // Access (and create if needed) the secondary counter of a gamma track
+  static G4int &SecondaryCount(threadLocalT &l, G4int track_id);
+
+  // Cached gamma definition, to avoid comparing particle names
+  G4ParticleDefinition *fGamma;
 
   // Database of mu
   std::shared_ptr<GateMaterialMuHandler> fMaterialMuHandler;
@@ -0,0 +1,132 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateThreadContext.h"
+#include "G4AutoLock.hh"
+#include "GateMutex.h"
+#include <algorithm>
+
+namespace {
+GATE_MUTEX(SlotsMutex);
+
+struct SlotFunctions {
+  void *(*fCreate)();
+  void (*fDelete)(void *);
+};
+
+// The slots (nullptr functions: released), the released slots to be reused
+// and the contexts of the threads that have blocks
+struct Registry {
+  std::vector<SlotFunctions> fSlots;
+  std::vector<size_t> fFreeSlots;
+  std::vector<GateThreadContext *> fContexts;
+};
+
+Registry &GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+} // namespace
+
+thread_local GateThreadContext GateThreadContext::fCurrent;
+
+GateThreadContext::~GateThreadContext() {
+  std::vector<Block> blocks;
+  {
+    GateAutoLock mutex(&SlotsMutex);
+    if (fRegistered) {
+      auto &contexts = GetRegistry().fContexts;
+      contexts.erase(std::remove(contexts.begin(), contexts.end(), this),
+                     contexts.end());
+    }
+    for (size_t i = 0; i < fBlocks.size(); i++)
+      TakeBlock(i, blocks);
+  }
+  DeleteBlocks(blocks);
+}
+
+size_t GateThreadContext::NewSlot(CreateFunction create, DeleteFunction del) {
+  GateAutoLock mutex(&SlotsMutex);
+  auto &registry = GetRegistry();
+  if (!registry.fFreeSlots.empty()) {
+    auto slot = registry.fFreeSlots.back();
+    registry.fFreeSlots.pop_back();
+    registry.fSlots[slot] = {create, del};
+    return slot;
+  }
+  registry.fSlots.push_back({create, del});
+  return registry.fSlots.size() - 1;
+}
+
+void GateThreadContext::ReleaseSlot(size_t slot) {
+  // (the owner is destroyed: no thread uses its blocks anymore)
+  std::vector<Block> blocks;
+  {
+    GateAutoLock mutex(&SlotsMutex);
+    auto &registry = GetRegistry();
+    for (auto *context : registry.fContexts)
+      context->TakeBlock(slot, blocks);
+    registry.fSlots[slot] = {nullptr, nullptr};
+    registry.fFreeSlots.push_back(slot);
+  }
+  DeleteBlocks(blocks);
+}
+
+void GateThreadContext::Initialize() {
+  size_t n;
+  {
+    GateAutoLock mutex(&SlotsMutex);
+    n = GetRegistry().fSlots.size();
+  }
+  for (size_t slot = 0; slot < n; slot++)
+    if (slot >= fBlocks.size() || fBlocks[slot] == nullptr)
+      NewBlock(slot);
+}
+
+void *GateThreadContext::NewBlock(size_t slot) {
+  SlotFunctions f{};
+  {
+    GateAutoLock mutex(&SlotsMutex);
+    f = GetRegistry().fSlots[slot];
+    if (f.fCreate == nullptr)
+      return nullptr;
+    Register();
+    if (slot >= fBlocks.size()) {
+      fBlocks.resize(slot + 1, nullptr);
+      fDeleteFunctions.resize(slot + 1, nullptr);
+    }
+  }
+  // (the block may use other GateThreadLocal: created without the lock)
+  auto *block = f.fCreate();
+  GateAutoLock mutex(&SlotsMutex);
+  fBlocks[slot] = block;
+  fDeleteFunctions[slot] = f.fDelete;
+  return block;
+}
+
+void GateThreadContext::Register() {
+  // (called with the lock)
+  if (fRegistered)
+    return;
+  GetRegistry().fContexts.push_back(this);
+  fRegistered = true;
+}
+
+void GateThreadContext::TakeBlock(size_t slot, std::vector<Block> &blocks) {
+  // (called with the lock, by the thread of the context or by ReleaseSlot)
+  if (slot >= fBlocks.size() || fBlocks[slot] == nullptr)
+    return;
+  blocks.push_back({fBlocks[slot], fDeleteFunctions[slot]});
+  fBlocks[slot] = nullptr;
+  fDeleteFunctions[slot] = nullptr;
+}
+
+void GateThreadContext::DeleteBlocks(const std::vector<Block> &blocks) {
+  // (without the lock: a block may own other GateThreadLocal)
+  for (const auto &b : blocks)
+    b.second(b.first);
+}
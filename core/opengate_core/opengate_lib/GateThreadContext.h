@@ -0,0 +1,99 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateThreadContext_h
+#define GateThreadContext_h
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*
+ * Per-thread context: one object for each thread, that holds the per-thread
+ * blocks of all the GateThreadLocal (actors, sources, digi attributes). A
+ * block is found with a single thread_local access and its slot index. The
+ * blocks known when the actions of a worker are built (see GateRunAction)
+ * are allocated at once, the other ones on first use.
+ *
+ * The slot of a GateThreadLocal is released when it is destroyed: the blocks
+ * of all the threads are deleted, and the slot is reused by the next
+ * GateThreadLocal (e.g. the actors of the next simulation of the process).
+ *
+ * GateThreadLocal<T> is used like G4Cache<T> (only Get).
+ */
+class GateThreadContext {
+public:
+  ~GateThreadContext();
+
+  // The context of the current thread
+  static GateThreadContext &Current() { return fCurrent; }
+
+  // New slot for the blocks of type T (one block for each thread)
+  template <class T> static size_t NewSlot() {
+    return NewSlot([]() -> void * { return new T(); },
+                   [](void *p) { delete static_cast<T *>(p); });
+  }
+
+  // Delete the blocks of the slot in all the threads, the slot can be reused
+  static void ReleaseSlot(size_t slot);
+
+  // Allocate the blocks of all the slots in use
+  void Initialize();
+
+  // Increased for every step that reaches an actor, see GateVFilter
+  unsigned long fStepSerial = 0;
+
+  template <class T> T &GetBlock(size_t slot) {
+    if (slot < fBlocks.size() && fBlocks[slot] != nullptr)
+      return *static_cast<T *>(fBlocks[slot]);
+    return *static_cast<T *>(NewBlock(slot));
+  }
+
+protected:
+  typedef void *(*CreateFunction)();
+  typedef void (*DeleteFunction)(void *);
+
+  static size_t NewSlot(CreateFunction create, DeleteFunction del);
+
+  void *NewBlock(size_t slot);
+
+  typedef std::pair<void *, DeleteFunction> Block;
+
+  // the contexts are known by ReleaseSlot once they have a block
+  void Register();
+
+  // Remove the block of the slot, to be deleted by DeleteBlocks
+  void TakeBlock(size_t slot, std::vector<Block> &blocks);
+
+  static void DeleteBlocks(const std::vector<Block> &blocks);
+
+  bool fRegistered = false;
+  std::vector<void *> fBlocks;
+  std::vector<DeleteFunction> fDeleteFunctions;
+
+  static thread_local GateThreadContext fCurrent;
+};
+
+template <class T> class GateThreadLocal {
+public:
+  GateThreadLocal() : fSlot(GateThreadContext::NewSlot<T>()) {}
+
+  // a copy has its own blocks
+  GateThreadLocal(const GateThreadLocal &)
+      : fSlot(GateThreadContext::NewSlot<T>()) {}
+
+  GateThreadLocal &operator=(const GateThreadLocal &) { return *this; }
+
+  ~GateThreadLocal() { GateThreadContext::ReleaseSlot(fSlot); }
+
+  T &Get() const { return GateThreadContext::Current().GetBlock<T>(fSlot); }
+
+protected:
+  size_t fSlot;
+};
+
+#endif // GateThreadContext_h
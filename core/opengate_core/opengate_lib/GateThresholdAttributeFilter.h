@@ -32,6 +32,9 @@ public:
 
   bool Accept(G4Step *step) const override;
 
+  // (the attribute is computed with its generic function)
+  int GetCost() const override { return 3; }
+
   std::string fAttributeName;
   std::string fPolicy;
   double fValueMin{};
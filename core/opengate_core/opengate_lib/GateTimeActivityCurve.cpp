@@ -0,0 +1,119 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateTimeActivityCurve.h"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+std::shared_ptr<const GateTimeActivityCurve>
+GateTimeActivityCurve::Get(const std::vector<double> &times,
+                           const std::vector<double> &activities) {
+  // the curves are shared as long as one source uses them
+  using Key = std::pair<std::vector<double>, std::vector<double>>;
+  static std::mutex mutex;
+  static std::map<Key, std::weak_ptr<const GateTimeActivityCurve>> curves;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &weak = curves[Key(times, activities)];
+  auto curve = weak.lock();
+  if (curve == nullptr) {
+    curve = std::make_shared<const GateTimeActivityCurve>(times, activities);
+    weak = curve;
+  }
+  return curve;
+}
+
+GateTimeActivityCurve::GateTimeActivityCurve(
+    const std::vector<double> &times, const std::vector<double> &activities) {
+  if (times.size() < 2 || times.size() != activities.size()) {
+    std::ostringstream oss;
+    oss << "The TAC must have at least 2 times, and the same number of times "
+        << "and activities, while it has " << times.size() << " times and "
+        << activities.size() << " activities";
+    Fatal(oss.str());
+  }
+  for (size_t i = 0; i < times.size(); i++) {
+    if ((i > 0 && times[i] <= times[i - 1]) || activities[i] < 0) {
+      std::ostringstream oss;
+      oss << "The times of the TAC must be increasing and the activities "
+          << "positive (element " << i << ": time " << times[i]
+          << ", activity " << activities[i] << ")";
+      Fatal(oss.str());
+    }
+  }
+  fTimes = times;
+  fActivities = activities;
+  fSlopes.resize(times.size() - 1);
+  fCumulative.resize(times.size());
+  fCumulative[0] = 0;
+  for (size_t i = 0; i < fSlopes.size(); i++) {
+    double dt = fTimes[i + 1] - fTimes[i];
+    fSlopes[i] = (fActivities[i + 1] - fActivities[i]) / dt;
+    // trapezoid: exact for a linear activity
+    fCumulative[i + 1] =
+        fCumulative[i] + 0.5 * (fActivities[i] + fActivities[i + 1]) * dt;
+  }
+}
+
+size_t GateTimeActivityCurve::FindBin(double time, size_t &cursor) const {
+  size_t last_bin = fSlopes.size() - 1;
+  // the time went backward: search from the start
+  if (cursor > last_bin || fTimes[cursor] > time) {
+    auto upper = std::upper_bound(fTimes.begin(), fTimes.end(), time);
+    auto i = std::distance(fTimes.begin(), upper) - 1;
+    cursor = std::min(static_cast<size_t>(std::max<long>(i, 0)), last_bin);
+  }
+  // the time increases: the bin is the current one or one of the next ones
+  while (cursor < last_bin && fTimes[cursor + 1] <= time)
+    cursor++;
+  return cursor;
+}
+
+double GateTimeActivityCurve::GetBinIntegral(size_t i, double time) const {
+  double tau = time - fTimes[i];
+  return fActivities[i] * tau + 0.5 * fSlopes[i] * tau * tau;
+}
+
+double GateTimeActivityCurve::GetActivity(double time, size_t &cursor) const {
+  if (time < fTimes.front() || time > fTimes.back())
+    return 0;
+  auto i = FindBin(time, cursor);
+  return fActivities[i] + fSlopes[i] * (time - fTimes[i]);
+}
+
+double GateTimeActivityCurve::SampleNextTime(double time, double u,
+                                             size_t &cursor) const {
+  if (time >= fTimes.back())
+    return -1;
+  // no decay before the first time
+  time = std::max(time, fTimes.front());
+
+  // expected number of decays at the next decay: current + Exp(1)
+  auto i = FindBin(time, cursor);
+  double target = fCumulative[i] + GetBinIntegral(i, time) - std::log(u);
+  if (target >= fCumulative.back())
+    return -1;
+
+  // bin of the next decay (the cursor follows the time)
+  while (fCumulative[i + 1] < target)
+    i++;
+  cursor = i;
+
+  // solve a * tau + slope * tau^2 / 2 = r in the bin (stable form, also
+  // when the slope is zero or negative)
+  double r = target - fCumulative[i];
+  double a = fActivities[i];
+  double d = std::max(0.0, a * a + 2 * fSlopes[i] * r);
+  double denominator = a + std::sqrt(d);
+  double t = fTimes[i + 1];
+  if (denominator > 0)
+    t = std::min(t, fTimes[i] + 2 * r / denominator);
+  return t;
+}
@@ -0,0 +1,61 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateTimeActivityCurve_h
+#define GateTimeActivityCurve_h
+
+#include <memory>
+#include <vector>
+
+/*
+    Time Activity Curve (TAC): piecewise linear activity between the given
+    times, zero outside. The cumulative integral of the activity (number of
+    expected decays) is tabulated at each time, so that the time of the next
+    decay of the inhomogeneous Poisson process is sampled exactly, by
+    inversion of the cumulative integral.
+
+    The tables are read-only and shared by all the sources with the same TAC
+    (see Get). Each thread keeps its own cursor (index of the current time
+    bin): as the simulation time increases, the search of the bin is O(1).
+ */
+
+class GateTimeActivityCurve {
+public:
+  // Shared curve for these times and activities (created once)
+  static std::shared_ptr<const GateTimeActivityCurve>
+  Get(const std::vector<double> &times, const std::vector<double> &activities);
+
+  GateTimeActivityCurve(const std::vector<double> &times,
+                        const std::vector<double> &activities);
+
+  // Activity at this time (linear interpolation)
+  double GetActivity(double time, size_t &cursor) const;
+
+  // Time of the next decay after this time, with u uniform in ]0, 1].
+  // Return -1 if there is no more decay (after the last time).
+  double SampleNextTime(double time, double u, size_t &cursor) const;
+
+  double GetFirstTime() const { return fTimes.front(); }
+
+  double GetLastTime() const { return fTimes.back(); }
+
+protected:
+  // index i of the bin [t_i, t_i+1] of this time, starting at the cursor
+  size_t FindBin(double time, size_t &cursor) const;
+
+  // integral of the activity from the start of the bin i to this time
+  double GetBinIntegral(size_t i, double time) const;
+
+  std::vector<double> fTimes;
+  std::vector<double> fActivities;
+  // slope of the activity in each bin
+  std::vector<double> fSlopes;
+  // integral of the activity from the first time to each time
+  std::vector<double> fCumulative;
+};
+
+#endif // GateTimeActivityCurve_h
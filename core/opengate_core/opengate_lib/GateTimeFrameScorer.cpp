@@ -0,0 +1,82 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateTimeFrameScorer.h"
+#include "GateHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+void GateTimeFrameScorer::Configure(double start, double duration,
+                                    int nb_frames, int max_active_frames) {
+  if (nb_frames > 0 && (duration <= 0 || max_active_frames < 1)) {
+    std::ostringstream oss;
+    oss << "Error in the time frames: the duration of the frames must be "
+           "positive and the number of active frames at least 1, while "
+        << duration << " and " << max_active_frames << " are read.";
+    Fatal(oss.str());
+  }
+  fStart = start;
+  fDuration = duration;
+  fNumberOfFrames = std::max(nb_frames, 0);
+  fMaxActiveFrames = max_active_frames;
+}
+
+void GateTimeFrameScorer::Open(const std::string &filename,
+                               const size_t size[3], const double spacing[3],
+                               const double origin[3]) {
+  for (int i = 0; i < 3; i++)
+    fSize[i] = static_cast<long>(size[i]);
+  fFile.Open(filename, size, spacing, origin);
+  // all the frames exist from the start (holes of the file until written)
+  fFile.UpdateFrame(fNumberOfFrames - 1, [](double *) {});
+  fNumberOfFlushes = 0;
+}
+
+void GateTimeFrameScorer::Close() { fFile.Close(); }
+
+int GateTimeFrameScorer::GetFrame(double time) const {
+  auto f = std::floor((time - fStart) / fDuration);
+  if (f < 0 || f >= fNumberOfFrames)
+    return -1;
+  return static_cast<int>(f);
+}
+
+void GateTimeFrameScorer::AddValue(double time, long x, long y, long z,
+                                   double value) {
+  auto frame = GetFrame(time);
+  if (frame < 0)
+    return;
+  auto &frames = fThreadLocalData.Get().frames;
+  auto it = frames.find(frame);
+  if (it == frames.end()) {
+    // release the oldest frame of the thread first
+    if (frames.size() >= fMaxActiveFrames) {
+      auto oldest = frames.begin();
+      FlushFrame(oldest->first, oldest->second);
+      frames.erase(oldest);
+    }
+    it = frames.emplace(frame, GateSparseImage<double>()).first;
+    it->second.Initialize(fSize[0], fSize[1], fSize[2]);
+  }
+  it->second.GetValue(x, y, z) += value;
+}
+
+void GateTimeFrameScorer::Flush() {
+  auto &frames = fThreadLocalData.Get().frames;
+  for (auto &f : frames)
+    FlushFrame(f.first, f.second);
+  frames.clear();
+}
+
+void GateTimeFrameScorer::FlushFrame(int frame,
+                                     const GateSparseImage<double> &image) {
+  // only the allocated tiles are added to the mapped frame
+  std::lock_guard<std::mutex> lock(fFileMutex);
+  fFile.UpdateFrame(frame, [&](double *pixels) { image.AddToBuffer(pixels); });
+  fNumberOfFlushes++;
+}
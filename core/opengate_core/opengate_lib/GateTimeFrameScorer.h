@@ -0,0 +1,86 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateTimeFrameScorer_h
+#define GateTimeFrameScorer_h
+
+#include "G4Cache.hh"
+#include "GateMappedImageFile.h"
+#include "GateSparseImage.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+/*
+    Image scored per time frame (e.g. edep or fluence as a function of time),
+    written in a 4D memory-mapped file (x, y, z, frame), see
+    GateMappedImageFile. A value goes to the frame of its global time, the
+    values outside [start, start + nb_frames * duration[ are ignored.
+
+    Each thread only keeps its active frames in memory, as sparse images
+    (tiles allocated on the fly). When a thread has more active frames than
+    the buffer size, its oldest frame (lowest time) is added to the file and
+    released: the times of the deposits of a thread mostly increase, so the
+    released frames are usually complete for this thread. A frame released
+    too early is only added to the file again later, the sums are the same.
+    The pages of the file are written to disk asynchronously by the system.
+ */
+
+class GateTimeFrameScorer {
+public:
+  // Frames [start + i * duration, start + (i + 1) * duration[, i < nb_frames
+  // (nb_frames = 0: disabled), and number of active frames per thread
+  void Configure(double start, double duration, int nb_frames,
+                 int max_active_frames);
+
+  bool IsEnabled() const { return fNumberOfFrames > 0; }
+
+  // Master thread: create the file with all the frames (zeros), with the
+  // geometry of the scored image
+  void Open(const std::string &filename, const size_t size[3],
+            const double spacing[3], const double origin[3]);
+
+  bool IsOpen() const { return fFile.IsOpen(); }
+
+  // Master thread, end of simulation: write the header, release the file
+  void Close();
+
+  // Frame of the time, -1 if outside the frames
+  int GetFrame(double time) const;
+
+  // Worker thread: add the value to the voxel (x, y, z) of the frame of
+  // the time
+  void AddValue(double time, long x, long y, long z, double value);
+
+  // Worker thread, end of run: add all the active frames of the thread to
+  // the file
+  void Flush();
+
+  // Number of frames added to the file (for the tests)
+  unsigned long GetNumberOfFlushes() const { return fNumberOfFlushes; }
+
+protected:
+  void FlushFrame(int frame, const GateSparseImage<double> &image);
+
+  double fStart = 0;
+  double fDuration = 0;
+  int fNumberOfFrames = 0;
+  size_t fMaxActiveFrames = 4;
+  long fSize[3] = {0, 0, 0};
+
+  GateMappedImageFile fFile;
+  std::mutex fFileMutex;
+  std::atomic<unsigned long> fNumberOfFlushes{0};
+
+  struct threadLocalT {
+    std::map<int, GateSparseImage<double>> frames;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateTimeFrameScorer_h
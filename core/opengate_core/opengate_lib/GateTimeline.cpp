@@ -0,0 +1,166 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateTimeline.h"
+#include "G4Threading.hh"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <vector>
+
+std::atomic<bool> GateTimeline::fEnabled{false};
+
+namespace {
+struct Marker {
+  const char *fName;
+  const char *fCategory;
+  char fPhase;
+  long long fTime;
+};
+
+// ring buffer of the markers of a thread
+struct Buffer {
+  int fThreadId = 0;
+  std::vector<Marker> fMarkers;
+  size_t fNext = 0;
+  size_t fDropped = 0;
+  // chunks of events
+  int fEvents = 0;
+  bool fEventsOpen = false;
+};
+
+std::mutex &TimelineMutex() {
+  static std::mutex m;
+  return m;
+}
+
+// the buffers are never moved (deque), and kept until the next Reset
+std::deque<Buffer> &Buffers() {
+  static std::deque<Buffer> buffers;
+  return buffers;
+}
+
+std::set<std::string> &Names() {
+  static std::set<std::string> names;
+  return names;
+}
+
+std::atomic<size_t> MarkersCapacity{100000};
+std::atomic<int> EventsChunk{1000};
+std::atomic<int> Generation{0};
+std::chrono::steady_clock::time_point Origin;
+
+// Buffer of the calling thread (created at its first marker)
+Buffer &GetBuffer() {
+  static G4ThreadLocal Buffer *buffer = nullptr;
+  static G4ThreadLocal int generation = -1;
+  auto current = Generation.load(std::memory_order_acquire);
+  if (generation != current) {
+    std::lock_guard<std::mutex> lock(TimelineMutex());
+    Buffers().emplace_back();
+    buffer = &Buffers().back();
+    buffer->fThreadId = G4Threading::G4GetThreadId();
+    buffer->fMarkers.reserve(MarkersCapacity.load());
+    generation = current;
+  }
+  return *buffer;
+}
+
+void AddMarker(const char *name, const char *category, char phase) {
+  auto &b = GetBuffer();
+  auto t = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - Origin)
+               .count();
+  Marker m{name, category, phase, t};
+  auto capacity = b.fMarkers.capacity();
+  if (b.fMarkers.size() < capacity) {
+    b.fMarkers.push_back(m);
+    return;
+  }
+  // full: overwrite the oldest marker
+  if (capacity == 0)
+    return;
+  b.fMarkers[b.fNext] = m;
+  b.fNext = (b.fNext + 1) % capacity;
+  b.fDropped++;
+}
+} // namespace
+
+void GateTimeline::Enable(bool flag, size_t capacity, int chunk) {
+  MarkersCapacity = capacity;
+  EventsChunk = chunk;
+  fEnabled.store(flag, std::memory_order_relaxed);
+}
+
+void GateTimeline::Reset() {
+  std::lock_guard<std::mutex> lock(TimelineMutex());
+  Buffers().clear();
+  Origin = std::chrono::steady_clock::now();
+  Generation++;
+}
+
+const char *GateTimeline::Intern(const std::string &name) {
+  if (!IsEnabled())
+    return "";
+  std::lock_guard<std::mutex> lock(TimelineMutex());
+  return Names().insert(name).first->c_str();
+}
+
+void GateTimeline::Begin(const char *name, const char *category) {
+  if (IsEnabled())
+    AddMarker(name, category, 'B');
+}
+
+void GateTimeline::End(const char *name, const char *category) {
+  if (IsEnabled())
+    AddMarker(name, category, 'E');
+}
+
+void GateTimeline::BeginOfEvent() {
+  if (!IsEnabled())
+    return;
+  auto &b = GetBuffer();
+  if (b.fEvents % EventsChunk.load(std::memory_order_relaxed) == 0) {
+    if (b.fEventsOpen)
+      AddMarker("events", "run", 'E');
+    AddMarker("events", "run", 'B');
+    b.fEventsOpen = true;
+  }
+  b.fEvents++;
+}
+
+void GateTimeline::EndOfEvents() {
+  if (!IsEnabled())
+    return;
+  auto &b = GetBuffer();
+  if (b.fEventsOpen)
+    AddMarker("events", "run", 'E');
+  b.fEventsOpen = false;
+  b.fEvents = 0;
+}
+
+py::list GateTimeline::GetEvents() {
+  std::lock_guard<std::mutex> lock(TimelineMutex());
+  py::list results;
+  for (const auto &b : Buffers()) {
+    py::list events;
+    // oldest first
+    auto n = b.fMarkers.size();
+    for (size_t i = 0; i < n; i++) {
+      const auto &m = b.fMarkers[(b.fNext + i) % n];
+      events.append(py::make_tuple(m.fName, m.fCategory,
+                                   std::string(1, m.fPhase), m.fTime));
+    }
+    py::dict d;
+    d["thread"] = b.fThreadId;
+    d["dropped"] = b.fDropped;
+    d["events"] = events;
+    results.append(d);
+  }
+  return results;
+}
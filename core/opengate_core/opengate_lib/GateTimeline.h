@@ -0,0 +1,91 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateTimeline_h
+#define GateTimeline_h
+
+#include <atomic>
+#include <pybind11/pybind11.h>
+#include <string>
+
+namespace py = pybind11;
+
+/*
+    Optional timeline of the simulation (option timeline_filename of the
+    Simulation): begin/end markers of the runs, chunks of events, batch
+    callbacks (ARF, GAN, phase space), flushes of the digi collections, merges
+    and master thread hooks of the actors. It shows the threads idling at the
+    end of a run, the master merges and the Python callbacks.
+
+    Each thread records its markers in its own ring buffer (no lock, the
+    oldest markers are overwritten when it is full). The names are not
+    copied: they must be literals or interned with Intern. The markers are
+    read with GetEvents when the threads are stopped (end of the simulation)
+    and written as a Chrome trace (json) on the Python side. When disabled,
+    the cost is one test per marker.
+ */
+
+class GateTimeline {
+public:
+  // capacity: number of markers per thread, chunk: number of events per
+  // "events" marker
+  static void Enable(bool flag, size_t capacity, int chunk);
+
+  inline static bool IsEnabled() {
+    return fEnabled.load(std::memory_order_relaxed);
+  }
+
+  // Remove the markers (master thread, when the simulation starts)
+  static void Reset();
+
+  // Stable copy of a name (e.g. an actor name), under a lock
+  static const char *Intern(const std::string &name);
+
+  static void Begin(const char *name, const char *category);
+
+  static void End(const char *name, const char *category);
+
+  // Called at each event: a marker every chunk events (all threads)
+  static void BeginOfEvent();
+
+  // Close the current chunk of events (end of run, all threads)
+  static void EndOfEvents();
+
+  // [{thread: id, dropped: n, events: [(name, category, phase, time)]}],
+  // phase "B" or "E", time in ns since the Reset
+  static py::list GetEvents();
+
+protected:
+  static std::atomic<bool> fEnabled;
+};
+
+// Begin/end markers of a scope (if the timeline is enabled and the name is
+// not null)
+class GateTimelineScope {
+public:
+  GateTimelineScope(const char *name, const char *category)
+      : fName(name), fCategory(category),
+        fEnabled(name != nullptr && GateTimeline::IsEnabled()) {
+    if (fEnabled)
+      GateTimeline::Begin(fName, fCategory);
+  }
+
+  ~GateTimelineScope() {
+    if (fEnabled)
+      GateTimeline::End(fName, fCategory);
+  }
+
+  GateTimelineScope(const GateTimelineScope &) = delete;
+  GateTimelineScope &operator=(const GateTimelineScope &) = delete;
+
+protected:
+  const char *fName;
+  const char *fCategory;
+  bool fEnabled;
+};
+
+#endif // GateTimeline_h
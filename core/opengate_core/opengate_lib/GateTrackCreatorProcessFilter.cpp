@@ -13,16 +13,19 @@
 void GateTrackCreatorProcessFilter::InitializeUserInfo(py::dict &user_info) {
   fProcessName = DictGetStr(user_info, "process_name");
   fPolicy = DictGetStr(user_info, "policy");
+  fAcceptProcess = fPolicy == "accept";
 }
 
 bool GateTrackCreatorProcessFilter::Accept(G4Step *step) const {
   const auto *p = step->GetTrack()->GetCreatorProcess();
-  std::string name = "none";
-  if (p != nullptr)
-    name = p->GetProcessName();
-  if (fPolicy == "accept" && name == fProcessName)
-    return true;
-  if (fPolicy == "reject" && name != fProcessName)
-    return true;
-  return false;
+  auto &last = fLastProcess.Get();
+  if (!last.fValid || p != last.fProcess) {
+    std::string name = "none";
+    if (p != nullptr)
+      name = p->GetProcessName();
+    last.fProcess = p;
+    last.fAccept = (name == fProcessName) == fAcceptProcess;
+    last.fValid = true;
+  }
+  return last.fAccept;
 }
@@ -8,6 +8,7 @@
 #ifndef GateTrackCreatorProcessFilter_h
 #define GateTrackCreatorProcessFilter_h
 
+#include "G4VProcess.hh"
 #include "GateVFilter.h"
 #include <pybind11/stl.h>
 
@@ -28,6 +29,17 @@ public:
 
   std::string fProcessName;
   std::string fPolicy;
+  bool fAcceptProcess = true;
+
+protected:
+  // the processes are different in each thread: the result of the last
+  // creator process is kept, to compare the names only when it changes
+  struct LastProcess {
+    const G4VProcess *fProcess = nullptr;
+    bool fValid = false;
+    bool fAccept = false;
+  };
+  GateThreadLocal<LastProcess> fLastProcess;
 };
 
 #endif // GateTrackCreatorProcessFilter_h
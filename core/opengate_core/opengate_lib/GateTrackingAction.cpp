@@ -6,8 +6,34 @@
    -------------------------------------------------- */
 
 #include "GateTrackingAction.h"
+#include "GateActorProfiler.h"
+#include "G4Navigator.hh"
+#include "G4PhysicalVolumeStore.hh"
 #include "G4RunManager.hh"
+#include "G4TransportationManager.hh"
+#include "GateProgressMonitor.h"
 #include "GateUserEventInformation.h"
+#include <algorithm>
+
+namespace {
+// The volume of a track is a volume of the mass world: the volume-only
+// actors attached to a parallel world are called for all the tracks
+bool IsInMassWorld(const G4LogicalVolume *lv) {
+  const auto *world = G4TransportationManager::GetTransportationManager()
+                          ->GetNavigatorForTracking()
+                          ->GetWorldVolume();
+  if (world == nullptr)
+    return false;
+  const auto *world_lv = world->GetLogicalVolume();
+  if (lv == world_lv)
+    return true;
+  for (const auto *pv : *G4PhysicalVolumeStore::GetInstance()) {
+    if (pv->GetLogicalVolume() == lv && world_lv->IsAncestor(pv))
+      return true;
+  }
+  return false;
+}
+} // namespace
 
 GateTrackingAction::GateTrackingAction() : G4UserTrackingAction() {
   fUserEventInformationFlag = false;
@@ -15,27 +41,88 @@ GateTrackingAction::GateTrackingAction() : G4UserTrackingAction() {
 
 void GateTrackingAction::RegisterActor(GateVActor *actor) {
   if (actor->HasAction("PreUserTrackingAction")) {
-    fPreUserTrackingActionActors.push_back(actor);
+    fPreUserTrackingActionActors.fActors.push_back(actor);
   }
   if (actor->HasAction("PostUserTrackingAction")) {
-    fPostUserTrackingActionActors.push_back(actor);
+    fPostUserTrackingActionActors.fActors.push_back(actor);
   }
 }
 
 void GateTrackingAction::PreUserTrackingAction(const G4Track *track) {
+  // (the volumes of the actors are known once the run has started)
+  if (!fVolumeActorsFlag) {
+    fPreUserTrackingActionActors.Initialize();
+    fPostUserTrackingActionActors.Initialize();
+    fVolumeActorsFlag = true;
+  }
+  GateProgressMonitor::CountTrack();
   if (fUserEventInformationFlag) {
     const auto *event = G4RunManager::GetRunManager()->GetCurrentEvent();
     auto info =
         dynamic_cast<GateUserEventInformation *>(event->GetUserInformation());
     info->PreUserTrackingAction(track);
   }
-  for (auto actor : fPreUserTrackingActionActors) {
+  for (auto actor : fPreUserTrackingActionActors.Get(track)) {
+    GateActorProfilerScope profile(actor,
+                                   GateActorProfiler::PreUserTrackingAction);
     actor->PreUserTrackingAction(track);
   }
 }
 
 void GateTrackingAction::PostUserTrackingAction(const G4Track *track) {
-  for (auto actor : fPostUserTrackingActionActors) {
+  // (the steps are counted per track, not at each step)
+  GateProgressMonitor::CountSteps(track->GetCurrentStepNumber());
+  for (auto actor : fPostUserTrackingActionActors.Get(track)) {
+    GateActorProfilerScope profile(actor,
+                                   GateActorProfiler::PostUserTrackingAction);
     actor->PostUserTrackingAction(track);
   }
 }
+
+void GateTrackingAction::VolumeActors::Initialize() {
+  // The volumes are known by the registered actors
+  std::vector<std::set<const G4LogicalVolume *>> volumes_of_actor;
+  std::set<const G4LogicalVolume *> volumes;
+  for (auto *actor : fActors) {
+    std::set<const G4LogicalVolume *> v;
+    if (actor->fTrackingActionsInVolumesOnly) {
+      v = actor->GetLogicalVolumes();
+      if (!std::all_of(v.begin(), v.end(), IsInMassWorld))
+        v.clear();
+    }
+    volumes.insert(v.begin(), v.end());
+    volumes_of_actor.push_back(v);
+  }
+
+  // (an actor without volume is called for all the tracks)
+  ActorsType actors;
+  for (size_t i = 0; i < fActors.size(); i++) {
+    if (volumes_of_actor[i].empty())
+      actors.push_back(fActors[i]);
+  }
+  for (const auto *lv : volumes) {
+    auto &list = fActorsOfVolume[lv];
+    for (size_t i = 0; i < fActors.size(); i++) {
+      if (volumes_of_actor[i].empty() || volumes_of_actor[i].count(lv) > 0)
+        list.push_back(fActors[i]);
+    }
+  }
+  fActors = actors;
+  fLastVolume = nullptr;
+  fLastActors = nullptr;
+}
+
+const GateTrackingAction::ActorsType &
+GateTrackingAction::VolumeActors::Get(const G4Track *track) {
+  if (fActorsOfVolume.empty())
+    return fActors;
+  // volume where the track starts (or ends), none out of the world
+  const auto *pv = track->GetVolume();
+  const auto *lv = pv == nullptr ? nullptr : pv->GetLogicalVolume();
+  if (fLastActors == nullptr || lv != fLastVolume) {
+    auto it = fActorsOfVolume.find(lv);
+    fLastActors = it == fActorsOfVolume.end() ? &fActors : &it->second;
+    fLastVolume = lv;
+  }
+  return *fLastActors;
+}
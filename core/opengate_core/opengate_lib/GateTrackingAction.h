@@ -11,6 +11,7 @@
 #include "G4Track.hh"
 #include "G4UserTrackingAction.hh"
 #include "GateVActor.h"
+#include <unordered_map>
 
 class GateTrackingAction : public G4UserTrackingAction {
 
@@ -28,8 +29,29 @@ public:
   bool fUserEventInformationFlag;
 
 protected:
-  std::vector<GateVActor *> fPreUserTrackingActionActors;
-  std::vector<GateVActor *> fPostUserTrackingActionActors;
+  typedef std::vector<GateVActor *> ActorsType;
+
+  // Actors of one tracking action. The actors with
+  // fTrackingActionsInVolumesOnly are only in the lists of their volumes:
+  // a track then triggers the actors for all the tracks and the ones of its
+  // volume (in the order of registration), with a single lookup.
+  struct VolumeActors {
+    // actors for the tracks outside the volumes of the volume-only actors
+    ActorsType fActors;
+    std::unordered_map<const G4LogicalVolume *, ActorsType> fActorsOfVolume;
+    // (consecutive tracks are often in the same volume)
+    const G4LogicalVolume *fLastVolume = nullptr;
+    const ActorsType *fLastActors = nullptr;
+
+    // Build the lists, once in each thread
+    void Initialize();
+
+    const ActorsType &Get(const G4Track *track);
+  };
+
+  VolumeActors fPreUserTrackingActionActors;
+  VolumeActors fPostUserTrackingActionActors;
+  bool fVolumeActorsFlag = false;
 };
 
 #endif // GateTrackingAction_h
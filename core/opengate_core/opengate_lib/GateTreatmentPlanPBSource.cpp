@@ -3,7 +3,10 @@
 #include "G4ParticleTable.hh"
 #include "G4RandomTools.hh"
 #include "GateHelpersDict.h"
+#include "GateSpotInformation.h"
 #include <G4UnitsTable.hh>
+#include <algorithm>
+#include <numeric>
 
 GateTreatmentPlanPBSource::GateTreatmentPlanPBSource() : GateVSource() {
   // fNumberOfGeneratedEvents = 0; // Keeps truck of nb events per RUN
@@ -14,6 +17,8 @@ GateTreatmentPlanPBSource::GateTreatmentPlanPBSource() : GateVSource() {
   fEngine = nullptr;
   fDistriGeneral = nullptr;
   fSortedSpotGenerationFlag = false;
+  fPartitionedSpotGenerationFlag = false;
+  fBatchSize = 1;
   fPDF = nullptr;
   fTotalNumberOfSpots = 0;
 }
@@ -35,9 +40,12 @@ void GateTreatmentPlanPBSource::InitializeUserInfo(py::dict &user_info) {
 
   // common to all spots
   InitializeParticle(user_info);
-  std::vector<double> mPDFVector = DictGetVecDouble(user_info, "pdf");
-  fPDF = mPDFVector.data(); // returns pointer to first element of the array
+  fSpotPDF = DictGetVecDouble(user_info, "pdf");
+  fPDF = fSpotPDF.data(); // returns pointer to first element of the array
   fSortedSpotGenerationFlag = DictGetBool(user_info, "sorted_spot_generation");
+  fPartitionedSpotGenerationFlag =
+      DictGetBool(user_info, "partitioned_spot_generation");
+  fBatchSize = DictGetInt(user_info, "batch_size");
 
   // vectors with info for each spot
   fSpotWeight = DictGetVecDouble(user_info, "weights");
@@ -52,32 +60,98 @@ void GateTreatmentPlanPBSource::InitializeUserInfo(py::dict &user_info) {
   fTotalNumberOfSpots = fSpotWeight.size();
   ll.fNbGeneratedSpots.resize(fTotalNumberOfSpots,
                               0); // keep track for debug
+  InitSpotGaussians();
 
   // Init the random fEngine
   InitRandomEngine();
   // assign n_particles to each spot, in case of sorted generation
-  if (fSortedSpotGenerationFlag) {
+  if (fPartitionedSpotGenerationFlag) {
+    InitThreadSpotRange(user_info);
+    InitNbPrimariesVecInThreadRange();
+  } else if (fSortedSpotGenerationFlag) {
     InitNbPrimariesVec();
   }
 }
 
+void GateTreatmentPlanPBSource::InitThreadSpotRange(py::dict &user_info) {
+  auto &ll = GetThreadLocalDataTPSource();
+  // the ranges are computed on the python side (balanced by expected cost)
+  auto ranges = DictGetVecInt(user_info, "thread_spot_ranges");
+  auto primaries = DictGetVecInt(user_info, "thread_primaries");
+  // (the master thread id is -1, its range is never used)
+  int thread = std::max(0, G4Threading::G4GetThreadId());
+  if (thread + 1 >= (int)ranges.size() || thread >= (int)primaries.size()) {
+    std::ostringstream oss;
+    oss << "The treatment plan source '" << fName << "' has "
+        << primaries.size() << " spot ranges, but thread " << thread
+        << " is used. Check number_of_threads.";
+    Fatal(oss.str());
+  }
+  ll.fFirstSpot = ranges[thread];
+  ll.fEndSpot = std::min(ranges[thread + 1], fTotalNumberOfSpots);
+  ll.fNbPrimaries = primaries[thread];
+  ll.fCurrentSpot = ll.fFirstSpot;
+}
+
+void GateTreatmentPlanPBSource::InitNbPrimariesVecInThreadRange() {
+  auto &ll = GetThreadLocalDataTPSource();
+  // Initialize all spots to zero particles, only the spots of the range of
+  // the thread are then sampled, with the pdf restricted to the range
+  ll.fNbIonsToGenerate.assign(fTotalNumberOfSpots, 0);
+  if (ll.fFirstSpot >= ll.fEndSpot)
+    return;
+  std::vector<double> cdf(fSpotPDF.begin() + ll.fFirstSpot,
+                          fSpotPDF.begin() + ll.fEndSpot);
+  std::partial_sum(cdf.begin(), cdf.end(), cdf.begin());
+  for (long int i = 0; i < ll.fNbPrimaries; i++) {
+    double u = G4UniformRand() * cdf.back();
+    auto it = std::upper_bound(cdf.begin(), cdf.end(), u);
+    int bin = std::min((int)(it - cdf.begin()), (int)cdf.size() - 1);
+    ++ll.fNbIonsToGenerate[ll.fFirstSpot + bin];
+  }
+}
+
 void GateTreatmentPlanPBSource::InitNbPrimariesVec() {
   auto &ll = GetThreadLocalDataTPSource();
   // Initialize all spots to zero particles
   ll.fNbIonsToGenerate.resize(fTotalNumberOfSpots, 0);
   for (long int i = 0; i < fMaxN; i++) {
-    int bin = fTotalNumberOfSpots * fDistriGeneral->fire();
+    int bin =
+        fTotalNumberOfSpots * fDistriGeneral->shoot(G4Random::getTheEngine());
     ++ll.fNbIonsToGenerate[bin];
   }
 }
+void GateTreatmentPlanPBSource::InitSpotGaussians() {
+  // a spot change only points to its Gaussians (no decomposition)
+  auto &ll = GetThreadLocalDataTPSource();
+  ll.fSpotGaussiansX.clear();
+  ll.fSpotGaussiansY.clear();
+  ll.fSpotGaussiansX.reserve(fTotalNumberOfSpots);
+  ll.fSpotGaussiansY.reserve(fTotalNumberOfSpots);
+  for (int i = 0; i < fTotalNumberOfSpots; i++) {
+    ll.fSpotGaussiansX.push_back(
+        GateSingleParticleSourcePencilBeam::PhaseSpaceGaussian(fPhSpaceX[i]));
+    ll.fSpotGaussiansY.push_back(
+        GateSingleParticleSourcePencilBeam::PhaseSpaceGaussian(fPhSpaceY[i]));
+  }
+}
+
 void GateTreatmentPlanPBSource::InitRandomEngine() {
+  // The engine is only needed to build the distribution: the spots are
+  // sampled with the engine of the thread (seeded by Geant4 like the other
+  // sources, so the results follow the random_engine and the seed)
   fEngine = new CLHEP::HepJamesRandom();
   fDistriGeneral =
       new CLHEP::RandGeneral(fEngine, fPDF, fTotalNumberOfSpots, 0);
 }
 
 double GateTreatmentPlanPBSource::CalcNextTime(double current_simulation_time) {
-  double fakeActivity = (double)fMaxN * CLHEP::Bq; // 1e-9;
+  double n = fMaxN;
+  if (fPartitionedSpotGenerationFlag) {
+    // each thread generates the primaries of its own range
+    n = GetThreadLocalDataTPSource().fNbPrimaries;
+  }
+  double fakeActivity = n * CLHEP::Bq; // 1e-9;
   double timeDelta = (1.0 / fakeActivity);
   double next_time = current_simulation_time + timeDelta;
   return next_time;
@@ -85,6 +159,11 @@ double GateTreatmentPlanPBSource::CalcNextTime(double current_simulation_time) {
 
 double
 GateTreatmentPlanPBSource::PrepareNextTime(double current_simulation_time) {
+  // no spot for this thread
+  if (fPartitionedSpotGenerationFlag &&
+      GetThreadLocalDataTPSource().fNbPrimaries <= 0) {
+    return -1;
+  }
   if (current_simulation_time < fStartTime) {
     return fStartTime;
   }
@@ -101,10 +180,17 @@ GateTreatmentPlanPBSource::PrepareNextTime(double current_simulation_time) {
   return next_time;
 }
 
+bool GateTreatmentPlanPBSource::CanShareEvents() const {
+  return fMaxN > 0 && !fSortedSpotGenerationFlag &&
+         !fPartitionedSpotGenerationFlag;
+}
+
 void GateTreatmentPlanPBSource::PrepareNextRun() {
   // The following compute the global transformation from
   // the local volume (attached_to) to the world
   GateVSource::PrepareNextRun();
+  // the primaries of the previous run are in the previous coordinate system
+  GetThreadLocalDataTPSource().fBatch.Clear();
 }
 
 void GateTreatmentPlanPBSource::GeneratePrimaries(
@@ -116,11 +202,29 @@ void GateTreatmentPlanPBSource::GeneratePrimaries(
   // if we moved to a new spot, we need to update the SPS parameters
   if (ll.fCurrentSpot != ll.fPreviousSpot) {
     ConfigureSingleSpot();
+    ll.fBatch.Clear();
   }
 
-  // Generate vertex
+  // Generate vertex. With the sorted (or partitioned) generation, the
+  // primaries of the spot may be generated in advance, by batch
+  auto first_vertex = event->GetNumberOfPrimaryVertex();
   ll.fSPS_PB->SetParticleTime(current_simulation_time);
-  ll.fSPS_PB->GeneratePrimaryVertex(event);
+  bool sorted = fSortedSpotGenerationFlag || fPartitionedSpotGenerationFlag;
+  if (sorted && fBatchSize > 1) {
+    if (ll.fBatch.IsEmpty()) {
+      auto n = std::min(fBatchSize, ll.fNbIonsToGenerate[ll.fCurrentSpot]);
+      ll.fSPS_PB->GenerateBatch(ll.fBatch, std::max(1, n));
+    }
+    ll.fSPS_PB->GeneratePrimaryVertexFromBatch(event, ll.fBatch);
+  } else {
+    ll.fSPS_PB->GeneratePrimaryVertex(event);
+  }
+
+  // the spot of the vertex, for the beamlet scoring (GateBeamletDoseActor)
+  for (auto i = first_vertex; i < event->GetNumberOfPrimaryVertex(); i++) {
+    event->GetPrimaryVertex(i)->SetUserInformation(
+        new GateSpotInformation(ll.fCurrentSpot));
+  }
 
   // weight
   double w = fSpotWeight[ll.fCurrentSpot];
@@ -132,7 +236,7 @@ void GateTreatmentPlanPBSource::GeneratePrimaries(
   // fNumberOfGeneratedEvents++;
   ll.fNbGeneratedSpots[ll.fCurrentSpot]++;
 
-  if (fSortedSpotGenerationFlag) {
+  if (fSortedSpotGenerationFlag || fPartitionedSpotGenerationFlag) {
     // we generated an ion from this spot, so we remove it from the vector
     --ll.fNbIonsToGenerate[ll.fCurrentSpot];
   }
@@ -142,7 +246,7 @@ void GateTreatmentPlanPBSource::GeneratePrimaries(
 
 void GateTreatmentPlanPBSource::FindNextSpot() {
   auto &ll = GetThreadLocalDataTPSource();
-  if (fSortedSpotGenerationFlag) {
+  if (fSortedSpotGenerationFlag || fPartitionedSpotGenerationFlag) {
     // move to next spot if there are no more particles to generate in the
     // current one
     while ((ll.fCurrentSpot < fTotalNumberOfSpots) &&
@@ -151,8 +255,10 @@ void GateTreatmentPlanPBSource::FindNextSpot() {
     }
 
   } else {
-    // select random spot according to PDF
-    int bin = fTotalNumberOfSpots * fDistriGeneral->fire();
+    // select random spot according to PDF (with the engine of the thread,
+    // it is seeded for each event)
+    double u = fDistriGeneral->shoot(G4Random::getTheEngine());
+    int bin = fTotalNumberOfSpots * u;
     ll.fCurrentSpot = bin;
   }
 }
@@ -176,10 +282,9 @@ void GateTreatmentPlanPBSource::ConfigureSingleSpot() {
   G4RotationMatrix rotation = fSpotRotation[ll.fCurrentSpot];
   UpdatePositionSPS(translation, rotation);
 
-  // Phase space parameters
-  std::vector<double> x_param = fPhSpaceX[ll.fCurrentSpot];
-  std::vector<double> y_param = fPhSpaceY[ll.fCurrentSpot];
-  ll.fSPS_PB->SetPBSourceParam(x_param, y_param);
+  // Phase space (prebuilt Gaussians)
+  ll.fSPS_PB->SetPhaseSpace(&ll.fSpotGaussiansX[ll.fCurrentSpot],
+                            &ll.fSpotGaussiansY[ll.fCurrentSpot]);
 }
 
 void GateTreatmentPlanPBSource::UpdatePositionSPS(
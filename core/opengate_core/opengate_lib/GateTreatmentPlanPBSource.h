@@ -28,6 +28,9 @@ public:
   void InitializeUserInfo(py::dict &user_info) override;
   void GeneratePrimaries(G4Event *event, double time) override;
   double PrepareNextTime(double current_simulation_time) override;
+
+  // Only when the spot of each event is sampled from the pdf
+  bool CanShareEvents() const override;
   void PrepareNextRun() override;
   double CalcNextTime(double current_simulation_time) override;
 
@@ -43,6 +46,16 @@ protected:
     int fCurrentSpot = 0;
     int fPreviousSpot = -1;
     bool fInitGenericIon = false;
+    // spot range [fFirstSpot, fEndSpot) of the thread (partitioned generation)
+    int fFirstSpot = 0;
+    int fEndSpot = 0;
+    long int fNbPrimaries = 0;
+    // phase space Gaussians of each spot (built once, at initialization)
+    std::vector<GateRandomMultiGauss> fSpotGaussiansX;
+    std::vector<GateRandomMultiGauss> fSpotGaussiansY;
+    // primaries of the current spot, generated in advance (sorted or
+    // partitioned generation only)
+    GatePrimaryBatch fBatch;
   };
   G4Cache<threadLocalTPSource> fThreadLocalDataTPSource;
 
@@ -53,9 +66,12 @@ protected:
   CLHEP::RandGeneral *fDistriGeneral;
   G4String fParticleType;
   bool fSortedSpotGenerationFlag;
+  bool fPartitionedSpotGenerationFlag;
+  int fBatchSize;
 
   // vectors collecting spot-specific variables
   double *fPDF;
+  std::vector<double> fSpotPDF;
   std::vector<double> fSpotWeight;
   std::vector<double> fSpotEnergy;
   std::vector<double> fSigmaEnergy;
@@ -81,5 +97,8 @@ protected:
   void InitializeIon(py::dict &user_info);
   void InitRandomEngine();
   void InitNbPrimariesVec();
+  void InitThreadSpotRange(py::dict &user_info);
+  void InitNbPrimariesVecInThreadRange();
+  void InitSpotGaussians();
 };
 #endif // GateTreatmentPlanPBSource_h
@@ -13,7 +13,11 @@
 #include "GateHelpers.h"
 #include "GateUniqueVolumeID.h"
 
-GateUniqueVolumeID::GateUniqueVolumeID() { fID = "undefined"; }
+GateUniqueVolumeID::GateUniqueVolumeID() {
+  fID = "undefined";
+  // (no string to build)
+  std::call_once(fStringIDsFlag, []() {});
+}
 
 GateUniqueVolumeID::~GateUniqueVolumeID() {}
 
@@ -24,33 +28,67 @@ GateUniqueVolumeID::New(const G4VTouchable *touchable, bool debug) {
   return std::make_shared<GateUniqueVolumeID>(touchable, debug);
 }
 
+const GateUniqueVolumeID::Pointer &GateUniqueVolumeID::GetEmpty() {
+  static const Pointer empty = std::make_shared<GateUniqueVolumeID>();
+  return empty;
+}
+
 GateUniqueVolumeID::GateUniqueVolumeID(const G4VTouchable *touchable,
                                        bool debug)
-    : GateUniqueVolumeID() {
+    : GateUniqueVolumeID(touchable, ComputeArrayID(touchable)) {
+  if (debug) {
+    for (const auto &v : fVolumeDepthID) {
+      DDE(v.fDepth);
+      DDE(v.GetVolumeName());
+      DDE(v.fCopyNb);
+      DDE(v.fLocalToWorld.NetTranslation());
+    }
+  }
+}
+
+GateUniqueVolumeID::GateUniqueVolumeID(const G4VTouchable *touchable,
+                                       const IDArrayType &id) {
   // retrieve the tree of embedded volumes
   // See ComputeArrayID warning for explanation.
-  const auto *hist = touchable->GetHistory();
-  for (auto i = 0; i <= (int)hist->GetDepth(); i++) {
-    int index = (int)hist->GetDepth() - i;
+  const auto depth = (int)touchable->GetHistory()->GetDepth();
+  fVolumeDepthID.reserve(depth + 1);
+  for (auto i = 0; i <= depth; i++) {
+    int index = depth - i;
     auto v = GateUniqueVolumeID::VolumeDepthID();
-    v.fVolumeName = touchable->GetVolume(index)->GetName();
     v.fCopyNb = touchable->GetCopyNumber(index);
     v.fDepth = i; // Start at world (depth=0), and increase
-    v.fTranslation = touchable->GetTranslation(index); // copy the translation
-    v.fRotation = G4RotationMatrix(
-        *touchable->GetRotation(index)); // copy of the rotation
     v.fVolume = touchable->GetVolume(index);
+    v.fLocalToWorld = G4AffineTransform(*touchable->GetRotation(index),
+                                        touchable->GetTranslation(index));
     fVolumeDepthID.push_back(v);
-    if (debug) {
-      DDE(i);
-      DDE(index);
-      DDE(v.fVolumeName);
-      DDE(v.fCopyNb);
-      DDE(v.fTranslation);
-    }
   }
-  fArrayID = ComputeArrayID(touchable);
-  fID = touchable->GetVolume()->GetName() + "-" + ArrayIDToStr(fArrayID);
+  fArrayID = id;
+}
+
+void GateUniqueVolumeID::ComputeStringIDs() const {
+  std::call_once(fStringIDsFlag, [this]() {
+    fID = fVolumeDepthID.back().GetVolumeName() + "-" +
+          ArrayIDToStr(fArrayID);
+    // ids up to each depth
+    fIdUpToDepth.reserve(fVolumeDepthID.size());
+    for (const auto &v : fVolumeDepthID) {
+      std::ostringstream oss;
+      oss << v.GetVolumeName() << "-";
+      int i = 0;
+      while (i <= v.fDepth && fArrayID[i] != -1) {
+        oss << fArrayID[i] << "_";
+        i++;
+      }
+      auto s = oss.str();
+      s.pop_back();
+      fIdUpToDepth.push_back(s);
+    }
+  });
+}
+
+const std::string &GateUniqueVolumeID::GetID() const {
+  ComputeStringIDs();
+  return fID;
 }
 
 GateUniqueVolumeID::IDArrayType
@@ -86,7 +124,7 @@ std::string GateUniqueVolumeID::ArrayIDToStr(IDArrayType id) {
 
 std::ostream &operator<<(std::ostream &os,
                          const GateUniqueVolumeID::VolumeDepthID &v) {
-  os << v.fDepth << " " << v.fVolumeName << " " << v.fCopyNb;
+  os << v.fDepth << " " << v.GetVolumeName() << " " << v.fCopyNb;
   return os;
 }
 
@@ -95,8 +133,9 @@ GateUniqueVolumeID::GetVolumeDepthID() const {
   return fVolumeDepthID;
 }
 
-G4AffineTransform *GateUniqueVolumeID::GetWorldToLocalTransform(size_t depth) {
-  auto t = GetLocalToWorldTransform(depth);
+G4AffineTransform *
+GateUniqueVolumeID::GetWorldToLocalTransform(size_t depth) const {
+  const auto *t = GetLocalToWorldTransform(depth);
   auto translation = t->NetTranslation();
   auto rotation = t->NetRotation();
   rotation.invert();
@@ -106,37 +145,27 @@ G4AffineTransform *GateUniqueVolumeID::GetWorldToLocalTransform(size_t depth) {
   return tt;
 }
 
-G4AffineTransform *GateUniqueVolumeID::GetLocalToWorldTransform(size_t depth) {
+void GateUniqueVolumeID::CheckDepth(size_t depth) const {
   if (depth >= fVolumeDepthID.size()) {
     std::ostringstream oss;
     oss << "Error depth = " << depth << " while vol depth is "
-        << fVolumeDepthID.size() << " " << fID
+        << fVolumeDepthID.size() << " " << GetID()
         << ". It can happens for example when centroid is outside a deep "
            "volume (crystal) and in";
     Fatal(oss.str());
   }
-  auto &rotation = fVolumeDepthID[depth].fRotation;
-  auto &translation = fVolumeDepthID[depth].fTranslation;
-  auto t = new G4AffineTransform(rotation, translation);
-  return t;
 }
 
-std::string GateUniqueVolumeID::GetIdUpToDepth(int depth) {
+const G4AffineTransform *
+GateUniqueVolumeID::GetLocalToWorldTransform(size_t depth) const {
+  CheckDepth(depth);
+  return &fVolumeDepthID[depth].fLocalToWorld;
+}
+
+const std::string &GateUniqueVolumeID::GetIdUpToDepth(int depth) const {
+  ComputeStringIDs();
   if (depth == -1)
     return fID;
-  if (fCachedIdDepth.count(depth) != 0) {
-    return fCachedIdDepth[depth];
-  }
-  std::ostringstream oss;
-  oss << fVolumeDepthID[depth].fVolumeName << "-";
-  int i = 0;
-  auto id = fArrayID;
-  while (i <= depth && id[i] != -1) {
-    oss << id[i] << "_";
-    i++;
-  }
-  auto s = oss.str();
-  s.pop_back();
-  fCachedIdDepth[depth] = s;
-  return s;
+  CheckDepth(depth);
+  return fIdUpToDepth[depth];
 }
@@ -13,6 +13,7 @@
 #include "G4VTouchable.hh"
 #include "GateUniqueVolumeID.h"
 #include <array>
+#include <mutex>
 #include <string>
 
 /*
@@ -22,8 +23,15 @@
    tree, starting from world. Information about volume name and transform are
    stored for convenience.
 
-    A string fID, of the form 0_0_1_4 (with copyNb at all depth separated with
-   _) is also computed.
+    A string ID (GetID), of the form name-0_0_1_4 (with copyNb at all depth
+   separated with _) is also available.
+
+    Only the copy numbers, the volumes and the local to world transforms are
+   computed at construction (the touchable is not kept). The string IDs (full
+   and up to each depth) are built the first time one of them is asked (once,
+   thread-safe), so that a volume ID can be shared by all threads without
+   lock. fIndex is the dense index of the volume ID, set by
+   GateUniqueVolumeIDManager (-1 if not managed).
  */
 
 class GateUniqueVolumeID {
@@ -33,15 +41,14 @@ public:
 
   // Internal structure to keep information at each depth level
   // in the volume hierarchy
-  typedef struct {
-    std::string fVolumeName;
+  struct VolumeDepthID {
     int fCopyNb;
     int fDepth;
-    G4ThreeVector fTranslation;
-    G4RotationMatrix fRotation;
     G4VPhysicalVolume *fVolume;
+    G4AffineTransform fLocalToWorld;
 
-  } VolumeDepthID;
+    const G4String &GetVolumeName() const { return fVolume->GetName(); }
+  };
 
   // Fixed sized array of CopyNo for all depth levels
   static const int MaxDepth = 15;
@@ -54,11 +61,17 @@ public:
   explicit GateUniqueVolumeID(const G4VTouchable *touchable,
                               bool debug = false);
 
+  // Same with the ID array of the touchable, already computed
+  GateUniqueVolumeID(const G4VTouchable *touchable, const IDArrayType &id);
+
   static IDArrayType ComputeArrayID(const G4VTouchable *touchable);
 
   static Pointer New(const G4VTouchable *touchable = nullptr,
                      bool debug = false);
 
+  // The undefined volume ID, shared (e.g. empty digi values)
+  static const Pointer &GetEmpty();
+
   const std::vector<VolumeDepthID> &GetVolumeDepthID() const;
 
   size_t GetDepth() const { return fVolumeDepthID.size(); }
@@ -68,16 +81,29 @@ public:
   friend std::ostream &operator<<(std::ostream &,
                                   const GateUniqueVolumeID::VolumeDepthID &v);
 
-  G4AffineTransform *GetLocalToWorldTransform(size_t depth);
+  const G4AffineTransform *GetLocalToWorldTransform(size_t depth) const;
+
+  G4AffineTransform *GetWorldToLocalTransform(size_t depth) const;
 
-  G4AffineTransform *GetWorldToLocalTransform(size_t depth);
+  const std::string &GetIdUpToDepth(int depth) const;
 
-  std::string GetIdUpToDepth(int depth);
+  // String ID: name-0_0_1_4
+  const std::string &GetID() const;
 
   std::vector<VolumeDepthID> fVolumeDepthID;
   IDArrayType fArrayID{};
-  std::string fID;
-  std::map<int, std::string> fCachedIdDepth;
+  int fIndex = -1;
+
+protected:
+  void CheckDepth(size_t depth) const;
+
+  // Build fID and fIdUpToDepth
+  void ComputeStringIDs() const;
+
+  // built on demand (once), one per depth
+  mutable std::once_flag fStringIDsFlag;
+  mutable std::string fID;
+  mutable std::vector<std::string> fIdUpToDepth;
 };
 
 #endif // GateUniqueVolumeID_h
@@ -21,7 +21,7 @@ GateUniqueVolumeIDManager *GateUniqueVolumeIDManager::GetInstance() {
 
 GateUniqueVolumeIDManager::GateUniqueVolumeIDManager() = default;
 
-GateUniqueVolumeID::Pointer
+const GateUniqueVolumeID::Pointer &
 GateUniqueVolumeIDManager::GetVolumeID(const G4VTouchable *touchable) {
   // Since this function can be called from different threads,
   // the map fToVolumeID must be protected against concurrent modifications.
@@ -31,9 +31,29 @@ GateUniqueVolumeIDManager::GetVolumeID(const G4VTouchable *touchable) {
   // hit), locks need to be in place as briefly as possible.
 
   // https://geant4-forum.web.cern.ch/t/identification-of-unique-physical-volumes-with-ids/2568/3
-  const auto name = touchable->GetVolume()->GetName();
   const auto id = GateUniqueVolumeID::ComputeArrayID(touchable);
 
+  // Cache of the thread: no lock, and no copy of the shared pointer
+  auto &l = fThreadLocalData.Get();
+  const auto *volume = touchable->GetVolume();
+  if (l.fLastKey != nullptr && l.fLastKey->first == volume &&
+      l.fLastKey->second == id)
+    return *l.fLastVolumeID;
+  KeyType key{volume, id};
+  auto cached = l.fCache.find(key);
+  if (cached == l.fCache.end())
+    cached =
+        l.fCache.emplace(std::move(key), GetSharedVolumeID(touchable, id))
+            .first;
+  l.fLastKey = &cached->first;
+  l.fLastVolumeID = &cached->second;
+  return cached->second;
+}
+
+GateUniqueVolumeID::Pointer GateUniqueVolumeIDManager::GetSharedVolumeID(
+    const G4VTouchable *touchable, const GateUniqueVolumeID::IDArrayType &id) {
+  const auto name = touchable->GetVolume()->GetName();
+
   // Gain read access before checking if the touchable has already
   // been associated with a unique volume ID.
   std::shared_lock<std::shared_mutex> readLock(GetVolumeIDMutex);
@@ -43,7 +63,7 @@ GateUniqueVolumeIDManager::GetVolumeID(const G4VTouchable *touchable) {
   } else {
     // The volume ID does not exist yet, so we will create it.
     readLock.unlock();
-    const auto uid = GateUniqueVolumeID::New(touchable);
+    const auto uid = std::make_shared<GateUniqueVolumeID>(touchable, id);
     // Before modifying the map, we must obtain exclusive write access.
     std::unique_lock<std::shared_mutex> writeLock(GetVolumeIDMutex);
     // There is a chance that another thread has already created the volume ID
@@ -54,14 +74,45 @@ GateUniqueVolumeIDManager::GetVolumeID(const G4VTouchable *touchable) {
       return it->second;
     } else {
       // Add the new ID to the map and return it.
+      uid->fIndex = static_cast<int>(fVolumeIDs.size());
+      fVolumeIDs.push_back(uid);
       fToVolumeID[{name, id}] = uid;
       return uid;
     }
   }
 }
 
+size_t GateUniqueVolumeIDManager::KeyHash::operator()(
+    const KeyType &key) const {
+  auto h = std::hash<const void *>()(key.first);
+  for (auto i : key.second) {
+    if (i == -1)
+      break;
+    h ^= std::hash<int>()(i) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  }
+  return h;
+}
+
+size_t GateUniqueVolumeIDManager::GetNumberOfVolumeIDs() const {
+  std::shared_lock<std::shared_mutex> readLock(GetVolumeIDMutex);
+  return fVolumeIDs.size();
+}
+
+GateUniqueVolumeID::Pointer
+GateUniqueVolumeIDManager::GetVolumeIDByIndex(size_t index) const {
+  std::shared_lock<std::shared_mutex> readLock(GetVolumeIDMutex);
+  if (index >= fVolumeIDs.size()) {
+    std::ostringstream oss;
+    oss << "GateUniqueVolumeIDManager: no volume ID with index " << index
+        << " (" << fVolumeIDs.size() << " volume IDs)";
+    Fatal(oss.str());
+  }
+  return fVolumeIDs[index];
+}
+
 std::vector<GateUniqueVolumeID::Pointer>
 GateUniqueVolumeIDManager::GetAllVolumeIDs() const {
+  std::shared_lock<std::shared_mutex> readLock(GetVolumeIDMutex);
   std::vector<GateUniqueVolumeID::Pointer> l;
   for (const auto &x : fToVolumeID) {
     l.push_back(x.second);
@@ -8,27 +8,50 @@
 #ifndef GateUniqueVolumeIDManager_h
 #define GateUniqueVolumeIDManager_h
 
+#include "G4Cache.hh"
 #include "G4VTouchable.hh"
 #include "GateUniqueVolumeID.h"
+#include <deque>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 /*
     Global singleton class that manage a correspondence between touchable
     pointer and unique volume ID.
+
+    Each volume ID gets a dense index (0, 1, 2 ... in the order of creation,
+    see GetVolumeIDByIndex), e.g. to index crystal tables.
+    Each thread keeps its own cache (physical volume + copy numbers to
+    volume ID), so that the shared lock is only taken the first time a
+    thread meets a volume. The last volume ID found by the thread is
+    checked first (consecutive hits are often in the same crystal).
  */
 
 class GateUniqueVolumeIDManager {
 public:
   static GateUniqueVolumeIDManager *GetInstance();
 
-  GateUniqueVolumeID::Pointer GetVolumeID(const G4VTouchable *touchable);
+  // The returned pointer is the one of the cache of the thread (valid until
+  // the end of the thread): copy it only to keep it, since each copy
+  // updates the reference count shared by all the threads.
+  const GateUniqueVolumeID::Pointer &
+  GetVolumeID(const G4VTouchable *touchable);
 
   std::vector<GateUniqueVolumeID::Pointer> GetAllVolumeIDs() const;
 
+  size_t GetNumberOfVolumeIDs() const;
+
+  GateUniqueVolumeID::Pointer GetVolumeIDByIndex(size_t index) const;
+
 protected:
   GateUniqueVolumeIDManager();
 
+  // Look up (or create) the volume ID in the shared map (with the lock)
+  GateUniqueVolumeID::Pointer
+  GetSharedVolumeID(const G4VTouchable *touchable,
+                    const GateUniqueVolumeID::IDArrayType &id);
+
   static GateUniqueVolumeIDManager *fInstance;
 
   // Index of name + ID array to VolumeID
@@ -36,6 +59,25 @@ protected:
   std::map<std::pair<std::string, GateUniqueVolumeID::IDArrayType>,
            GateUniqueVolumeID::Pointer>
       fToVolumeID;
+
+  // All the volume IDs, by dense index
+  std::deque<GateUniqueVolumeID::Pointer> fVolumeIDs;
+
+  // Key of the cache of the threads: volume and copy numbers
+  typedef std::pair<const G4VPhysicalVolume *, GateUniqueVolumeID::IDArrayType>
+      KeyType;
+
+  struct KeyHash {
+    size_t operator()(const KeyType &key) const;
+  };
+
+  struct threadLocalT {
+    std::unordered_map<KeyType, GateUniqueVolumeID::Pointer, KeyHash> fCache;
+    // last entry found in the cache (the nodes of the map are never moved)
+    const KeyType *fLastKey = nullptr;
+    const GateUniqueVolumeID::Pointer *fLastVolumeID = nullptr;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
 };
 
 #endif // GateUniqueVolumeIDManager_h
@@ -8,22 +8,40 @@
 #include "GateUserEventInformation.h"
 #include "GateHelpers.h"
 
+G4ThreadLocal G4Allocator<GateUserEventInformation>
+    *GateUserEventInformationAllocator = nullptr;
+
+std::vector<const G4ParticleDefinition *> &
+GateUserEventInformation::GetParticles() {
+  // the capacity is kept from one event to the next
+  static G4ThreadLocal std::vector<const G4ParticleDefinition *> *particles =
+      nullptr;
+  if (particles == nullptr)
+    particles = new std::vector<const G4ParticleDefinition *>;
+  return *particles;
+}
+
 void GateUserEventInformation::Print() const {
   // FIXME
 }
 
 std::string GateUserEventInformation::GetParticleName(G4int track_id) {
-  if (fMapOfParticleName.count(track_id) > 0) {
-    return fMapOfParticleName.at(track_id);
+  const auto &particles = GetParticles();
+  if (track_id >= 0 && track_id < static_cast<G4int>(particles.size()) &&
+      particles[track_id] != nullptr) {
+    return particles[track_id]->GetParticleName();
   } else
     return "unknown";
 }
 
 void GateUserEventInformation::BeginOfEventAction(const G4Event *event) {
-  fMapOfParticleName.clear();
+  GetParticles().clear();
 }
 
 void GateUserEventInformation::PreUserTrackingAction(const G4Track *track) {
-  fMapOfParticleName[track->GetTrackID()] =
-      track->GetParticleDefinition()->GetParticleName();
+  auto &particles = GetParticles();
+  auto track_id = track->GetTrackID();
+  if (track_id >= static_cast<G4int>(particles.size()))
+    particles.resize(track_id + 1, nullptr);
+  particles[track_id] = track->GetParticleDefinition();
 }
@@ -8,9 +8,18 @@
 #ifndef GateEventUserInfo_h
 #define GateEventUserInfo_h
 
+#include "G4Allocator.hh"
 #include "G4VUserEventInformation.hh"
 #include "GateVActor.h"
-#include <map>
+#include <vector>
+
+/*
+ * One object per event (the G4Event deletes it), so the objects are
+ * allocated with a per-thread G4Allocator (no heap allocation per event).
+ * The particle of each track is stored in a table of the thread, reused by
+ * all the events of the thread (cleared by BeginOfEventAction): only the
+ * current event of the thread can be queried.
+ */
 
 class GateUserEventInformation : public G4VUserEventInformation {
 
@@ -19,6 +28,10 @@ public:
 
   ~GateUserEventInformation() override = default;
 
+  inline void *operator new(size_t);
+
+  inline void operator delete(void *info);
+
   void Print() const override;
 
   std::string GetParticleName(G4int track_id);
@@ -28,7 +41,23 @@ public:
   void PreUserTrackingAction(const G4Track *track);
 
 protected:
-  std::map<G4int, std::string> fMapOfParticleName;
+  // particle of each track id (null if unknown), for the current thread
+  static std::vector<const G4ParticleDefinition *> &GetParticles();
 };
 
+extern G4ThreadLocal G4Allocator<GateUserEventInformation>
+    *GateUserEventInformationAllocator;
+
+inline void *GateUserEventInformation::operator new(size_t) {
+  if (GateUserEventInformationAllocator == nullptr)
+    GateUserEventInformationAllocator =
+        new G4Allocator<GateUserEventInformation>;
+  return (void *)GateUserEventInformationAllocator->MallocSingle();
+}
+
+inline void GateUserEventInformation::operator delete(void *info) {
+  GateUserEventInformationAllocator->FreeSingle(
+      (GateUserEventInformation *)info);
+}
+
 #endif // GateEventUserInfo_h
@@ -6,13 +6,18 @@
    -------------------------------------------------- */
 
 #include "GateVActor.h"
+#include "G4AutoLock.hh"
 #include "G4SDManager.hh"
+#include "GateActorProfiler.h"
 #include "GateActorManager.h"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
 #include "GateMultiFunctionalDetector.h"
+#include "GateMutex.h"
 #include "GateSourceManager.h"
 
+GATE_MUTEX(LogicalVolumesMutex);
+
 GateVActor::GateVActor(py::dict &user_info, bool MT_ready)
     : G4VPrimitiveScorer(DictGetStr(user_info, "name")) {
   // register this actor to the global list of actors
@@ -20,6 +25,9 @@ GateVActor::GateVActor(py::dict &user_info, bool MT_ready)
   fOperatorIsAnd = true;
   fSourceManager = nullptr;
   fWriteToDisk = false;
+  fTrackingActionsInVolumesOnly = false;
+  fTerminationTarget = 0;
+  fTerminationCount = 0;
 }
 
 GateVActor::~GateVActor() = default;
@@ -132,26 +140,32 @@ G4bool GateVActor::ProcessHits(G4Step *step, G4TouchableHistory *) {
    */
 
   // if the operator is AND, we perform the SteppingAction only if ALL filters
-  // are true (If only one is false, we stop and return)
-  if (fOperatorIsAnd) {
-    for (auto f : fFilters) {
-      if (!f->Accept(step))
-        return true;
-    }
-    SteppingAction(step);
-    return true;
+  // are true, if the operator is OR as soon as one filter is true (see
+  // GateFilterProgram)
+  bool accepted;
+  {
+    GateActorProfilerScope profile(this, GateActorProfiler::Filters);
+    accepted = fStepFilters.Accept(step);
   }
-  // if the operator is OR, we accept as soon as one filter is OK
-  for (auto f : fFilters) {
-    if (f->Accept(step)) {
-      SteppingAction(step);
-      return true;
-    }
+  if (accepted) {
+    GateActorProfilerScope profile(this, GateActorProfiler::SteppingAction);
+    SteppingAction(step);
   }
   return true;
 }
 
+std::set<const G4LogicalVolume *> GateVActor::GetLogicalVolumes() {
+  GateAutoLock mutex(&LogicalVolumesMutex);
+  return fLogicalVolumes;
+}
+
 void GateVActor::RegisterSD(G4LogicalVolume *lv) {
+  // (the logical volumes are shared by all the threads)
+  {
+    GateAutoLock mutex(&LogicalVolumesMutex);
+    fLogicalVolumes.insert(lv);
+  }
+
   // Look is a SD already exist for this LV
   auto currentSD = lv->GetSensitiveDetector();
   GateMultiFunctionalDetector *mfd;
@@ -174,6 +188,7 @@ void GateVActor::RegisterSD(G4LogicalVolume *lv) {
     }
   }
   // Register the actor to the GateMultiFunctionalDetector
+  fStepFilters.Compile(fFilters, fOperatorIsAnd);
   mfd->RegisterPrimitive(this);
 }
 
@@ -208,3 +223,14 @@ void GateVActor::RegisterSD(G4LogicalVolume *lv) {
 // }
 
 void GateVActor::SetSourceManager(GateSourceManager *s) { fSourceManager = s; }
+
+void GateVActor::ResetTerminationCount() { fTerminationCount = 0; }
+
+long GateVActor::GetTerminationCount() const { return fTerminationCount; }
+
+void GateVActor::AddTerminationCount(long n) {
+  if (fTerminationTarget <= 0 || n <= 0)
+    return;
+  if (fTerminationCount.fetch_add(n) + n >= fTerminationTarget)
+    fSourceManager->SetRunTerminationFlag(true);
+}
@@ -8,10 +8,12 @@
 #ifndef GateVActor_h
 #define GateVActor_h
 
+#include "GateFilterProgram.h"
 #include "GateVFilter.h"
 #include <G4Event.hh>
 #include <G4Run.hh>
 #include <G4VPrimitiveScorer.hh>
+#include <atomic>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -96,7 +98,7 @@ public:
   virtual void EndOfEventAction(const G4Event * /*event*/) {}
 
   // Called every time a Track starts (even if not in the volume attached to
-  // this actor)
+  // this actor, unless fTrackingActionsInVolumesOnly is set)
   virtual void PreUserTrackingAction(const G4Track *track);
 
   // Called every time a Track ends
@@ -135,6 +137,17 @@ public:
 
   void SetSourceManager(GateSourceManager *s);
 
+  // Termination criterion: the actor counts something (e.g. the digi of a
+  // projection, the entries of a phase space) and the run is ended as soon
+  // as the count reaches the target, like the uncertainty goal of the dose
+  // actor. The count is reset at the start of each run (master thread).
+  void ResetTerminationCount();
+
+  long GetTerminationCount() const;
+
+  // Target of the criterion (0: no criterion)
+  long fTerminationTarget;
+
   // List of actions (set to trigger some actions)
   // Can be set either on cpp or py side
   std::set<std::string> fActions;
@@ -142,9 +155,21 @@ public:
   // Name of the mother volume (logical volume)
   std::string fAttachedToVolumeName;
 
+  // If true, the tracking actions are only called for the tracks that start
+  // (PreUserTrackingAction) or end (PostUserTrackingAction) in one of the
+  // volumes where the actor receives the steps (see GateTrackingAction)
+  bool fTrackingActionsInVolumesOnly;
+
+  // Logical volumes where the actor receives the steps: the attached volume
+  // and its daughters (see RegisterSD)
+  std::set<const G4LogicalVolume *> GetLogicalVolumes();
+
   // List of active filters
   std::vector<GateVFilter *> fFilters;
 
+  // The filters of the steps, compiled when the actor is registered
+  GateFilterProgram fStepFilters;
+
   // callback functions
   //  typedef CallbackMap std::map<std::string, std::function>;
   //  CallbackMap fcallBacks;
@@ -156,6 +181,16 @@ public:
   bool fWriteToDisk;
 
   GateSourceManager *fSourceManager;
+
+protected:
+  // Add n to the count of the criterion, called by the threads (e.g. once
+  // per event): a single atomic addition, and the run is ended when the
+  // target is reached
+  void AddTerminationCount(long n);
+
+  std::set<const G4LogicalVolume *> fLogicalVolumes;
+
+  std::atomic<long> fTerminationCount;
 };
 
 #endif // GateVActor_h
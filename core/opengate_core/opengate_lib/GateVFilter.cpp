@@ -20,3 +20,14 @@ bool GateVFilter::Accept(const G4Event *) const { return true; }
 bool GateVFilter::Accept(const G4Track *) const { return true; }
 
 bool GateVFilter::Accept(G4Step *) const { return true; }
+
+bool GateVFilter::AcceptOncePerStep(G4Step *step) const {
+  // (the serial is increased by GateMultiFunctionalDetector for every step)
+  auto &r = fStepResult.Get();
+  const auto serial = GateThreadContext::Current().fStepSerial;
+  if (r.fStepSerial != serial) {
+    r.fAccept = Accept(step);
+    r.fStepSerial = serial;
+  }
+  return r.fAccept;
+}
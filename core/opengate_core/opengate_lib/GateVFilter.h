@@ -11,6 +11,7 @@
 #include "G4Event.hh"
 #include "G4Run.hh"
 #include "G4Step.hh"
+#include "GateThreadContext.h"
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
@@ -31,6 +32,25 @@ public:
   virtual bool Accept(const G4Track *track) const;
 
   virtual bool Accept(G4Step *step) const;
+
+  // Relative cost of Accept(step), used to order the filters of an actor
+  // (see GateFilterProgram). From 2, the result is computed once per step
+  // and shared by all the actors that use this filter.
+  virtual int GetCost() const { return 1; }
+
+  bool AcceptOncePerStep(G4Step *step) const;
+
+  // Called once before the first step, to cache what is needed by Accept
+  virtual void Compile() {}
+
+  bool fCompiled = false;
+
+protected:
+  struct StepResult {
+    unsigned long fStepSerial = 0;
+    bool fAccept = false;
+  };
+  GateThreadLocal<StepResult> fStepResult;
 };
 
 #endif // GateVFilter_h
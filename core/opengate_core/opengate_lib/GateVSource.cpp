@@ -8,6 +8,7 @@
 #include "GateVSource.h"
 #include "G4PhysicalVolumeStore.hh"
 #include "G4RandomTools.hh"
+#include "G4Threading.hh"
 #include "GateHelpers.h"
 #include "GateHelpersDict.h"
 #include "GateHelpersGeometry.h"
@@ -49,6 +50,21 @@ void GateVSource::InitializeUserInfo(py::dict &user_info) {
   fDecayConstant = log(2) / fHalfLife;
 }
 
+void GateVSource::InitializeUserInfoOfThread(py::dict &user_info) {
+  // (the master thread initializes the sources before the workers start)
+  const bool replay = G4Threading::IsWorkerThread();
+  if (!replay)
+    fUserInfoSnapshot = std::make_shared<GateUserInfoSnapshot>();
+  GateUserInfoSnapshotScope scope(fUserInfoSnapshot.get(), replay);
+  InitializeUserInfo(user_info);
+}
+
+long GateVSource::GetNumberOfReplayedUserInfoValues() const {
+  if (fUserInfoSnapshot == nullptr)
+    return 0;
+  return fUserInfoSnapshot->GetNumberOfReplayedValues();
+}
+
 void GateVSource::UpdateActivity(double time) {
   if (fHalfLife <= 0)
     return;
@@ -65,6 +81,10 @@ void GateVSource::PrepareNextRun() {
   SetOrientationAccordingToAttachedVolume();
 }
 
+void GateVSource::UpdateTransformOfAttachedVolume() {
+  SetOrientationAccordingToAttachedVolume();
+}
+
 double GateVSource::PrepareNextTime(double current_simulation_time) {
   Fatal("PrepareNextTime must be overloaded");
   return current_simulation_time;
@@ -11,10 +11,14 @@
 #include "G4Cache.hh"
 #include "G4Event.hh"
 #include "G4RotationMatrix.hh"
+#include "GatePrimaryBatch.h"
+#include <memory>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
 
+class GateUserInfoSnapshot;
+
 class GateVSource {
 
 public:
@@ -32,16 +36,60 @@ public:
   // Called at initialisation to set the source properties from a single dict
   virtual void InitializeUserInfo(py::dict &user_info);
 
+  // InitializeUserInfo, called by each thread with the same dict: the values
+  // are converted by the master thread (or in mono-thread), the workers read
+  // them back from a snapshot (see GateUserInfoSnapshot)
+  void InitializeUserInfoOfThread(py::dict &user_info);
+
+  // Number of values of the user info read from the snapshot (all threads)
+  long GetNumberOfReplayedUserInfoValues() const;
+
   virtual void UpdateActivity(double time);
 
   virtual double CalcNextTime(double current_simulation_time);
 
   virtual void PrepareNextRun();
 
+  // The attached volume has moved during the run (sub-runs, see
+  // GateMotionTable): update the global transform of the source
+  virtual void UpdateTransformOfAttachedVolume();
+
   virtual double PrepareNextTime(double current_simulation_time);
 
+  // Sources with the same start/end time and half-life have a constant
+  // ratio of activities: they may share a single Poisson process (see
+  // GateSourceManager, option aggregate_sources). False if the source
+  // computes its own times (number of events, TAC, etc).
+  virtual bool CanShareTimeProfile() const { return false; }
+
+  // Called instead of PrepareNextTime, after an event of this source, when
+  // the time is sampled by the group of sources
+  virtual void PrepareNextTimeInGroup() {}
+
+  // Sources with a number of events (n) whose events do not depend on the
+  // events before: the events of all the threads may be shared and taken
+  // by chunks (see GateSourceManager, option event_scheduling)
+  virtual bool CanShareEvents() const { return false; }
+
+  // Set by the source manager when the events are shared
+  void SetEventSharing(bool flag) { fEventSharingFlag = flag; }
+
+  unsigned long GetMaxN() const { return fMaxN; }
+
+  double GetInitialActivity() const { return fInitialActivity; }
+
+  double GetHalfLife() const { return fHalfLife; }
+
   virtual void GeneratePrimaries(G4Event *event, double time);
 
+  // Optional: fill the batch with the position, direction and energy of the
+  // next n primaries. Return false if the source cannot generate them in
+  // advance (default)
+  virtual bool GeneratePrimaryBatch(GatePrimaryBatch & /*batch*/,
+                                    size_t /*n*/) {
+    return false;
+  }
+
   virtual void SetOrientationAccordingToAttachedVolume();
 
   virtual unsigned long
@@ -70,6 +118,10 @@ protected:
   double fInitialActivity;
   double fHalfLife;
   double fDecayConstant;
+  bool fEventSharingFlag = false;
+
+  // values of the user info, recorded by the master thread
+  std::shared_ptr<GateUserInfoSnapshot> fUserInfoSnapshot;
 
   struct threadLocalT {
     unsigned long fNumberOfGeneratedEvents = 0;
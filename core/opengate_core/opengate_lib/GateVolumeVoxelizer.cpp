@@ -6,33 +6,51 @@
    -------------------------------------------------- */
 
 #include "GateVolumeVoxelizer.h"
-#include "G4Navigator.hh"
+#include "G4AutoLock.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4WorkerThread.hh"
+#include "GateMutex.h"
 #include "indicators.hpp"
-#include "itkImageRegionIteratorWithIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+namespace {
+GATE_MUTEX(VoxelizerLabelMutex);
+}
 
 GateVolumeVoxelizer::GateVolumeVoxelizer() { fImage = ImageType::New(); }
 
 void GateVolumeVoxelizer::Voxelize() {
-  // get navigator for world
-  auto pvs = G4PhysicalVolumeStore::GetInstance();
-  auto world = pvs->GetVolume("world");
-  auto nav = new G4Navigator();
-  nav->SetWorldVolume(world);
-
   // init to loop the image
   fImage->FillBuffer(0);
-  auto index = ImageType::IndexType();
-  auto point = ImageType::PointType();
+  const auto size = fImage->GetLargestPossibleRegion().GetSize();
+  for (int i = 0; i < 3; i++)
+    fSize[i] = size[i];
+  fBuffer = fImage->GetBufferPointer();
 
   // init labels
   fLabels.clear();
   fLabels["world"] = 0;
+  fVolumeLabels.clear();
+
+  // Find isocenter
+  auto point = ImageType::PointType();
+  fIndexIsoCenter = GateVolumeVoxelizer::ContinuousIndexType();
+  point[0] = 0;
+  point[1] = 0;
+  point[2] = 0;
+  fImage->TransformPhysicalPointToContinuousIndex(point, fIndexIsoCenter);
+
+  // the tasks are slabs of slices (one block thick), then the slices for
+  // the supersampling
+  const size_t block = std::max(fRefinementBlockSize, 1);
+  const size_t nb_slabs = (fSize[2] + block - 1) / block;
+  const bool supersampling = fSupersampling > 1;
 
   // progress bar
   using namespace indicators;
-  int interval = 1000;
-  auto n = fImage->GetLargestPossibleRegion().GetNumberOfPixels() / interval;
   ProgressBar bar{option::BarWidth{50},
                   option::Start{""},
                   option::Fill{"■"},
@@ -40,40 +58,247 @@ void GateVolumeVoxelizer::Voxelize() {
                   option::End{""},
                   option::ShowElapsedTime{true},
                   option::ShowRemainingTime{true},
-                  option::MaxProgress{n}};
+                  option::MaxProgress{nb_slabs +
+                                      (supersampling ? fSize[2] : 0)}};
+  indicators::show_console_cursor(false);
+  RunTasks(
+      nb_slabs,
+      [&](G4Navigator &nav, CacheType &cache, size_t t) {
+        VoxelizeSlab(nav, cache, t * block,
+                     std::min(fSize[2], (t + 1) * block));
+      },
+      [&]() { bar.tick(); });
+  SortLabels();
 
-  // Find isocenter
-  fIndexIsoCenter = GateVolumeVoxelizer::ContinuousIndexType();
-  point[0] = 0;
-  point[1] = 0;
-  point[3] = 0;
-  fImage->TransformPhysicalPointToContinuousIndex(point, fIndexIsoCenter);
+  fFractionVoxels.clear();
+  fFractionLabels.clear();
+  fFractions.clear();
+  if (supersampling) {
+    std::vector<SliceFractionsType> slices(fSize[2]);
+    RunTasks(
+        fSize[2],
+        [&](G4Navigator &nav, CacheType &cache, size_t iz) {
+          SupersampleSlice(nav, cache, iz, slices[iz]);
+        },
+        [&]() { bar.tick(); });
+    // (in the order of the voxels)
+    for (auto &f : slices) {
+      fFractionVoxels.insert(fFractionVoxels.end(), f.fVoxels.begin(),
+                             f.fVoxels.end());
+      fFractionLabels.insert(fFractionLabels.end(), f.fLabels.begin(),
+                             f.fLabels.end());
+      fFractions.insert(fFractions.end(), f.fFractions.begin(),
+                        f.fFractions.end());
+    }
+  }
+  indicators::show_console_cursor(true);
+}
 
-  // main loop
-  using IteratorType = itk::ImageRegionIteratorWithIndex<ImageType>;
-  IteratorType outputIt(fImage, fImage->GetRequestedRegion());
-  outputIt.GoToBegin();
-  int i = 0;
-  indicators::show_console_cursor(false);
-  while (!outputIt.IsAtEnd()) {
-    index = outputIt.GetIndex();
-    fImage->TransformIndexToPhysicalPoint(index, point);
-    G4ThreeVector p = {point[0], point[1], point[2]};
-    auto phys = nav->LocateGlobalPointAndSetup(p);
-    if (phys != nullptr) {
-      auto name = phys->GetName();
-      if (fLabels.count(name) == 0) {
-        fLabels[name] = fLabels.size();
+void GateVolumeVoxelizer::RunTasks(size_t nb_tasks, const TaskType &task,
+                                   const std::function<void()> &done) {
+  auto *world = G4PhysicalVolumeStore::GetInstance()->GetVolume("world");
+  size_t nb_threads = fNumberOfThreads > 0
+                          ? fNumberOfThreads
+                          : std::max(1u, std::thread::hardware_concurrency());
+  nb_threads = std::max<size_t>(1, std::min(nb_threads, nb_tasks));
+
+  // each thread takes the next task until there is none left. The other
+  // threads need their own copy of the geometry data (replicas and
+  // parameterisations move the shared volumes).
+  std::atomic<size_t> next(0);
+  auto worker = [&](bool is_worker_thread) {
+    if (is_worker_thread)
+      G4WorkerThread::BuildGeometryAndPhysicsVector();
+    {
+      G4Navigator nav;
+      nav.SetWorldVolume(world);
+      CacheType cache;
+      for (auto t = next++; t < nb_tasks; t = next++) {
+        task(nav, cache, t);
+        done();
+      }
+    }
+    if (is_worker_thread)
+      G4WorkerThread::DestroyGeometryAndPhysicsVector();
+  };
+  if (nb_threads == 1)
+    worker(false);
+  else {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nb_threads; t++)
+      threads.emplace_back(worker, true);
+    for (auto &t : threads)
+      t.join();
+  }
+}
+
+unsigned char GateVolumeVoxelizer::LocateLabel(G4Navigator &nav,
+                                               CacheType &cache, size_t ix,
+                                               size_t iy, size_t iz) {
+  auto index = ImageType::IndexType();
+  index[0] = ix;
+  index[1] = iy;
+  index[2] = iz;
+  auto point = ImageType::PointType();
+  fImage->TransformIndexToPhysicalPoint(index, point);
+  return LocateLabel(nav, cache, point);
+}
+
+unsigned char
+GateVolumeVoxelizer::LocateLabel(G4Navigator &nav, CacheType &cache,
+                                 const ImageType::PointType &point) {
+  G4ThreeVector p = {point[0], point[1], point[2]};
+  // (relative search: the previous voxel of the thread is a neighbour)
+  const auto *phys = nav.LocateGlobalPointAndSetup(p);
+  if (phys == nullptr)
+    return 0;
+  auto it = cache.find(phys);
+  if (it != cache.end())
+    return it->second;
+  const auto label = GetLabelOfVolume(phys);
+  cache[phys] = label;
+  return label;
+}
+
+unsigned char
+GateVolumeVoxelizer::GetLabelOfVolume(const G4VPhysicalVolume *phys) {
+  GateAutoLock lock(&VoxelizerLabelMutex);
+  auto it = fVolumeLabels.find(phys);
+  if (it != fVolumeLabels.end())
+    return it->second;
+  // the volumes with the same name have the same label
+  const auto &name = phys->GetName();
+  if (fLabels.count(name) == 0) {
+    if (fLabels.size() > std::numeric_limits<unsigned char>::max()) {
+      std::ostringstream oss;
+      oss << "GateVolumeVoxelizer: too many volumes (more than "
+          << fLabels.size() << ") to voxelize in an 8-bit label image.";
+      Fatal(oss.str());
+    }
+    const auto label = static_cast<unsigned char>(fLabels.size());
+    fLabels[name] = label;
+  }
+  fVolumeLabels[phys] = fLabels[name];
+  return fLabels[name];
+}
+
+void GateVolumeVoxelizer::VoxelizeSlab(G4Navigator &nav, CacheType &cache,
+                                       size_t z0, size_t z1) {
+  const size_t nx = fSize[0];
+  const size_t nxy = fSize[0] * fSize[1];
+  const size_t block = std::max(fRefinementBlockSize, 1);
+  for (size_t y0 = 0; y0 < fSize[1]; y0 += block) {
+    const auto y1 = std::min(fSize[1], y0 + block);
+    for (size_t x0 = 0; x0 < fSize[0]; x0 += block) {
+      const auto x1 = std::min(fSize[0], x0 + block);
+      if (block > 1) {
+        // the 8 corners of the block
+        const auto label = LocateLabel(nav, cache, x0, y0, z0);
+        bool homogeneous = true;
+        for (int c = 1; c < 8 && homogeneous; c++) {
+          const auto ix = (c & 1) != 0 ? x1 - 1 : x0;
+          const auto iy = (c & 2) != 0 ? y1 - 1 : y0;
+          const auto iz = (c & 4) != 0 ? z1 - 1 : z0;
+          homogeneous = LocateLabel(nav, cache, ix, iy, iz) == label;
+        }
+        if (homogeneous) {
+          for (auto iz = z0; iz < z1; iz++)
+            for (auto iy = y0; iy < y1; iy++)
+              std::fill(fBuffer + iz * nxy + iy * nx + x0,
+                        fBuffer + iz * nxy + iy * nx + x1, label);
+          continue;
+        }
       }
-      ImageType::PixelType l = fLabels[name];
-      outputIt.Set(l);
+      // all the voxels of the block
+      for (auto iz = z0; iz < z1; iz++)
+        for (auto iy = y0; iy < y1; iy++)
+          for (auto ix = x0; ix < x1; ix++)
+            fBuffer[iz * nxy + iy * nx + ix] =
+                LocateLabel(nav, cache, ix, iy, iz);
     }
-    ++outputIt;
-    ++i;
-    if (i == interval) {
-      bar.tick(); // very slow if too often
-      i = 0;
+  }
+}
+
+void GateVolumeVoxelizer::SortLabels() {
+  // new label of each label, in the order of the first voxel
+  const auto nb = fLabels.size();
+  std::vector<int> new_label(nb, -1);
+  new_label[0] = 0;
+  size_t n = 1;
+  const auto nb_pixels = fSize[0] * fSize[1] * fSize[2];
+  for (size_t i = 0; i < nb_pixels && n < nb; i++) {
+    if (new_label[fBuffer[i]] < 0)
+      new_label[fBuffer[i]] = static_cast<int>(n++);
+  }
+  // (the volumes met only by a corner are not in the image)
+  for (auto &l : new_label)
+    if (l < 0)
+      l = static_cast<int>(n++);
+  for (size_t i = 0; i < nb_pixels; i++)
+    fBuffer[i] = static_cast<unsigned char>(new_label[fBuffer[i]]);
+  for (auto &l : fLabels)
+    l.second = static_cast<unsigned char>(new_label[l.second]);
+  for (auto &l : fVolumeLabels)
+    l.second = static_cast<unsigned char>(new_label[l.second]);
+}
+
+bool GateVolumeVoxelizer::IsBoundaryVoxel(size_t ix, size_t iy,
+                                          size_t iz) const {
+  // 26 neighbours: a voxel crossed by a boundary near one of its corners
+  // may have its 6 face neighbours in its own volume
+  const size_t nx = fSize[0];
+  const size_t nxy = fSize[0] * fSize[1];
+  const auto label = fBuffer[iz * nxy + iy * nx + ix];
+  const auto x0 = ix > 0 ? ix - 1 : ix;
+  const auto y0 = iy > 0 ? iy - 1 : iy;
+  const auto z0 = iz > 0 ? iz - 1 : iz;
+  const auto x1 = std::min(ix + 1, fSize[0] - 1);
+  const auto y1 = std::min(iy + 1, fSize[1] - 1);
+  const auto z1 = std::min(iz + 1, fSize[2] - 1);
+  for (auto z = z0; z <= z1; z++)
+    for (auto y = y0; y <= y1; y++)
+      for (auto x = x0; x <= x1; x++)
+        if (fBuffer[z * nxy + y * nx + x] != label)
+          return true;
+  return false;
+}
+
+void GateVolumeVoxelizer::SupersampleSlice(G4Navigator &nav,
+                                           CacheType &cache, size_t iz,
+                                           SliceFractionsType &fractions) {
+  const size_t s = fSupersampling;
+  const auto nb_samples = static_cast<float>(s * s * s);
+  std::vector<int> counts(std::numeric_limits<unsigned char>::max() + 1, 0);
+  std::vector<unsigned char> touched;
+  auto cindex = ContinuousIndexType();
+  auto point = ImageType::PointType();
+  for (size_t iy = 0; iy < fSize[1]; iy++) {
+    for (size_t ix = 0; ix < fSize[0]; ix++) {
+      if (!IsBoundaryVoxel(ix, iy, iz))
+        continue;
+      // s^3 points at the center of the sub-voxels
+      for (size_t k = 0; k < s; k++) {
+        cindex[2] = iz + (k + 0.5) / s - 0.5;
+        for (size_t j = 0; j < s; j++) {
+          cindex[1] = iy + (j + 0.5) / s - 0.5;
+          for (size_t i = 0; i < s; i++) {
+            cindex[0] = ix + (i + 0.5) / s - 0.5;
+            fImage->TransformContinuousIndexToPhysicalPoint(cindex, point);
+            const auto label = LocateLabel(nav, cache, point);
+            if (counts[label]++ == 0)
+              touched.push_back(label);
+          }
+        }
+      }
+      std::sort(touched.begin(), touched.end());
+      const auto voxel = (iz * fSize[1] + iy) * fSize[0] + ix;
+      for (auto label : touched) {
+        fractions.fVoxels.push_back(voxel);
+        fractions.fLabels.push_back(label);
+        fractions.fFractions.push_back(counts[label] / nb_samples);
+        counts[label] = 0;
+      }
+      touched.clear();
     }
   }
-  indicators::show_console_cursor(true);
 }
@@ -8,9 +8,33 @@
 #ifndef GateVolumeVoxelizer_h
 #define GateVolumeVoxelizer_h
 
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
 #include "GateHelpers.h"
 #include "itkImage.h"
+#include <functional>
+#include <unordered_map>
 
+/*
+ * Label image of the volumes of the geometry: each voxel gets the label of
+ * the physical volume (by name) at its center, 0 for the world.
+ *
+ * The slices are shared between fNumberOfThreads threads (0: all the
+ * cores), each with its own navigator (and its own copy of the geometry
+ * data, as a Geant4 worker thread). With fRefinementBlockSize > 1, the
+ * image is first voxelized by blocks of this size: a block whose 8 corner
+ * voxels have the same label is filled with it, the voxels of the other
+ * blocks are all located (faster, but a structure inside a block that
+ * does not reach its corners is missed).
+ *
+ * The labels are numbered in the order the volumes are met in the image
+ * (x first), whatever the number of threads.
+ *
+ * With fSupersampling = s > 1, the boundary voxels (a label different
+ * from one of their 26 neighbours) are then sampled with s x s x s points
+ * and the fraction of each label in these voxels is stored (sparse: the
+ * other voxels are fully in their label).
+ */
 class GateVolumeVoxelizer {
 public:
   GateVolumeVoxelizer();
@@ -23,6 +47,55 @@ public:
 
   std::map<std::string, unsigned char> fLabels;
   ContinuousIndexType fIndexIsoCenter;
+
+  int fNumberOfThreads = 0;
+  int fRefinementBlockSize = 1;
+  int fSupersampling = 1;
+
+  // Fractions of the labels in the boundary voxels (supersampling), sorted
+  // by voxel (index in the buffer)
+  std::vector<size_t> fFractionVoxels;
+  std::vector<unsigned char> fFractionLabels;
+  std::vector<float> fFractions;
+
+protected:
+  typedef std::unordered_map<const G4VPhysicalVolume *, unsigned char>
+      CacheType;
+  typedef std::function<void(G4Navigator &, CacheType &, size_t)> TaskType;
+
+  // Run the tasks [0, nb_tasks[ in the threads
+  void RunTasks(size_t nb_tasks, const TaskType &task,
+                const std::function<void()> &done);
+
+  // Label of the volume at a point / at the center of the voxel
+  unsigned char LocateLabel(G4Navigator &nav, CacheType &cache,
+                            const ImageType::PointType &point);
+  unsigned char LocateLabel(G4Navigator &nav, CacheType &cache, size_t ix,
+                            size_t iy, size_t iz);
+
+  // Label of a volume met for the first time by the thread
+  unsigned char GetLabelOfVolume(const G4VPhysicalVolume *phys);
+
+  // Voxelize the slices [z0, z1[ (blocks of fRefinementBlockSize)
+  void VoxelizeSlab(G4Navigator &nav, CacheType &cache, size_t z0, size_t z1);
+
+  // Renumber the labels in the order of the image
+  void SortLabels();
+
+  bool IsBoundaryVoxel(size_t ix, size_t iy, size_t iz) const;
+
+  // Fractions of the labels in the boundary voxels of the slice
+  struct SliceFractionsType {
+    std::vector<size_t> fVoxels;
+    std::vector<unsigned char> fLabels;
+    std::vector<float> fFractions;
+  };
+  void SupersampleSlice(G4Navigator &nav, CacheType &cache, size_t iz,
+                        SliceFractionsType &fractions);
+
+  ImageType::PixelType *fBuffer = nullptr;
+  size_t fSize[3] = {0, 0, 0};
+  std::unordered_map<const G4VPhysicalVolume *, unsigned char> fVolumeLabels;
 };
 
 #endif // GateVolumeVoxelizer_h
@@ -38,6 +38,10 @@ void GateVoxelSource::PrepareNextRun() {
   fVoxelPositionGenerator->fGlobalRotation = l.fGlobalRotation;
   fVoxelPositionGenerator->fGlobalTranslation = l.fGlobalTranslation;
   // the direction is 'isotropic' so we don't care about rotating the direction.
+  ll.fSPS->SelectSamplers(false);
+
+  // the primaries of the previous run are in the previous coordinate system
+  ll.fBatch.Clear();
 }
 
 void GateVoxelSource::InitializePosition(py::dict) {
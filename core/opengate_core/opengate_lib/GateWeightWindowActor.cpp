@@ -0,0 +1,178 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateWeightWindowActor.h"
+#include "G4LogicalVolumeStore.hh"
+#include "GateHelpersDict.h"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+
+GateWeightWindowActor::GateWeightWindowActor(py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("SteppingAction");
+  fUseImage = true;
+  fMaxSplit = 1;
+}
+
+void GateWeightWindowActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fTranslation = DictGetG4ThreeVector(user_info, "translation");
+  DictCheckKey(user_info, "volume_importances");
+  fVolumeImportances = py::cast<std::map<std::string, double>>(
+      user_info["volume_importances"]);
+  fUseImage = fVolumeImportances.empty();
+  fEnergyBounds = DictGetVecDouble(user_info, "energy_bounds");
+  fLowerWeightBounds = DictGetVecDouble(user_info, "lower_weight_bounds");
+  fUpperWeightBounds = DictGetVecDouble(user_info, "upper_weight_bounds");
+  fMaxSplit = DictGetInt(user_info, "max_split");
+  if (fLowerWeightBounds.size() != fEnergyBounds.size() + 1 ||
+      fUpperWeightBounds.size() != fEnergyBounds.size() + 1) {
+    std::ostringstream oss;
+    oss << "The WeightWindowActor '" << GetName() << "' needs one lower and "
+        << "one upper weight bound per energy group ("
+        << fEnergyBounds.size() + 1 << " groups), while "
+        << fLowerWeightBounds.size() << " and " << fUpperWeightBounds.size()
+        << " are given.";
+    Fatal(oss.str());
+  }
+  for (size_t g = 0; g < fLowerWeightBounds.size(); g++) {
+    if (fLowerWeightBounds[g] <= 0 ||
+        fUpperWeightBounds[g] <= fLowerWeightBounds[g]) {
+      std::ostringstream oss;
+      oss << "The weight window of the energy group " << g
+          << " of the WeightWindowActor '" << GetName()
+          << "' is invalid: lower = " << fLowerWeightBounds[g]
+          << " upper = " << fUpperWeightBounds[g];
+      Fatal(oss.str());
+    }
+  }
+  if (!std::is_sorted(fEnergyBounds.begin(), fEnergyBounds.end())) {
+    std::ostringstream oss;
+    oss << "The energy bounds of the WeightWindowActor '" << GetName()
+        << "' must be sorted.";
+    Fatal(oss.str());
+  }
+}
+
+void GateWeightWindowActor::InitializeCpp() {
+  cpp_importance_image = ImageType::New();
+  fNbOfSplit = 0;
+  fNbOfKilled = 0;
+}
+
+void GateWeightWindowActor::SetPhysicalVolumeName(std::string name) {
+  fPhysicalVolumeName = name;
+}
+
+void GateWeightWindowActor::BeginOfRunActionMasterThread(int /*run_id*/) {
+  if (fUseImage) {
+    // Important ! The volume may have moved, so we re-attach each run
+    AttachImageToVolume<ImageType>(cpp_importance_image, fPhysicalVolumeName,
+                                   fTranslation);
+    fIndexTransform.Update(cpp_importance_image.GetPointer());
+    const auto &region = cpp_importance_image->GetLargestPossibleRegion();
+    const auto size = region.GetSize();
+    fSizeX = size[0];
+    fSliceSize = size[0] * size[1];
+    return;
+  }
+  // the importances are searched by logical volume, not by name
+  fLogicalVolumeImportances.clear();
+  auto *store = G4LogicalVolumeStore::GetInstance();
+  for (const auto &[name, importance] : fVolumeImportances) {
+    const auto *lv = store->GetVolume(name, false);
+    if (lv == nullptr) {
+      std::ostringstream oss;
+      oss << "The volume '" << name << "' of the importances of the "
+          << "WeightWindowActor '" << GetName() << "' does not exist.";
+      Fatal(oss.str());
+    }
+    fLogicalVolumeImportances[lv] = importance;
+  }
+}
+
+double GateWeightWindowActor::GetImportanceOfNewCell(const G4Step *step) const {
+  const auto *post = step->GetPostStepPoint();
+  if (!fUseImage) {
+    if (post->GetStepStatus() != fGeomBoundary)
+      return 0;
+    const auto *pv = post->GetPhysicalVolume();
+    if (pv == nullptr)
+      return 0;
+    const auto it = fLogicalVolumeImportances.find(pv->GetLogicalVolume());
+    return it == fLogicalVolumeImportances.end() ? 0 : it->second;
+  }
+  ImageType::IndexType index;
+  if (!fIndexTransform.TransformPointToIndex(post->GetPosition(), index))
+    return 0;
+  ImageType::IndexType pre_index;
+  if (fIndexTransform.TransformPointToIndex(
+          step->GetPreStepPoint()->GetPosition(), pre_index) &&
+      pre_index == index)
+    return 0;
+  return cpp_importance_image->GetBufferPointer()[index[2] * fSliceSize +
+                                                  index[1] * fSizeX + index[0]];
+}
+
+size_t GateWeightWindowActor::GetEnergyGroup(double energy) const {
+  return std::upper_bound(fEnergyBounds.begin(), fEnergyBounds.end(), energy) -
+         fEnergyBounds.begin();
+}
+
+void GateWeightWindowActor::SteppingAction(G4Step *step) {
+  auto *track = step->GetTrack();
+  if (track->GetTrackStatus() != fAlive)
+    return;
+  const auto importance = GetImportanceOfNewCell(step);
+  if (importance <= 0)
+    return;
+
+  // window of the cell for the energy of the particle
+  const auto g = GetEnergyGroup(track->GetKineticEnergy());
+  const auto lower = fLowerWeightBounds[g] / importance;
+  const auto upper = fUpperWeightBounds[g] / importance;
+  const auto survival_weight = 0.5 * (lower + upper);
+  const auto weight = track->GetWeight();
+
+  if (weight > upper) {
+    const auto n = std::min(
+        fMaxSplit, static_cast<int>(std::ceil(weight / survival_weight)));
+    if (n > 1)
+      Split(step, weight, n);
+    return;
+  }
+  if (weight < lower) {
+    // Russian roulette
+    if (G4UniformRand() * survival_weight < weight) {
+      track->SetWeight(survival_weight);
+      return;
+    }
+    track->SetTrackStatus(fStopAndKill);
+    fNbOfKilled++;
+  }
+}
+
+void GateWeightWindowActor::Split(G4Step *step, double weight, int n) {
+  auto *track = step->GetTrack();
+  const auto w = weight / n;
+  track->SetWeight(w);
+  // the copies start at the end of the step, in the entered cell
+  auto *secondaries = step->GetfSecondary();
+  const auto &touchable = step->GetPostStepPoint()->GetTouchableHandle();
+  for (int i = 1; i < n; i++) {
+    auto *particle = new G4DynamicParticle(*track->GetDynamicParticle());
+    auto *copy =
+        new G4Track(particle, track->GetGlobalTime(), track->GetPosition());
+    copy->SetWeight(w);
+    copy->SetParentID(track->GetTrackID());
+    copy->SetCreatorProcess(track->GetCreatorProcess());
+    copy->SetTouchableHandle(touchable);
+    secondaries->push_back(copy);
+  }
+  fNbOfSplit += n - 1;
+}
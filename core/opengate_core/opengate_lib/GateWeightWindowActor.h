@@ -0,0 +1,97 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateWeightWindowActor_h
+#define GateWeightWindowActor_h
+
+#include "GateHelpersImage.h"
+#include "GateVActor.h"
+#include "itkImage.h"
+#include <atomic>
+#include <map>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Geometry based weight windows (splitting and Russian roulette driven by
+ * an importance map). The importance I of a position is either the value
+ * of the voxel of an importance image (centered on the attached volume,
+ * like the dose actor image) or the importance of the (daughter) volume.
+ * For a particle of the energy group g, the window is:
+ *
+ *   [lower_weight_bounds[g] / I, upper_weight_bounds[g] / I]
+ *
+ * The window is checked when the particle enters a new voxel of the map or
+ * a new volume (end of the step). A particle above the window is split in
+ * n copies (n at most max_split), of weight w / n close to the survival
+ * weight, the middle of the window. A particle below the window survives
+ * with the probability w / survival weight, with the survival weight. The
+ * positions without importance (outside the map, other volumes, or an
+ * importance <= 0) have no window.
+ *
+ * The copies are secondaries of the particle (same position, energy and
+ * direction, parent ID = track ID of the particle).
+ */
+
+class GateWeightWindowActor : public GateVActor {
+
+public:
+  explicit GateWeightWindowActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  // Called every time a Run starts (master thread)
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  // Called every time a step occurs in the attached volume (all threads)
+  void SteppingAction(G4Step *step) override;
+
+  void SetPhysicalVolumeName(std::string name);
+
+  inline long GetNumberOfSplitParticles() const { return fNbOfSplit; }
+
+  inline long GetNumberOfKilledParticles() const { return fNbOfKilled; }
+
+  // Importance image, 3D float
+  typedef itk::Image<float, 3> ImageType;
+  ImageType::Pointer cpp_importance_image;
+
+protected:
+  // Importance of the voxel/volume entered by the step, 0 if the step does
+  // not enter a new one (or if it has no importance)
+  double GetImportanceOfNewCell(const G4Step *step) const;
+
+  // Index of the energy group of the energy
+  size_t GetEnergyGroup(double energy) const;
+
+  // Split the particle in n copies of weight / n
+  void Split(G4Step *step, double weight, int n);
+
+  std::string fPhysicalVolumeName;
+  G4ThreeVector fTranslation;
+  bool fUseImage;
+  std::map<std::string, double> fVolumeImportances;
+  std::map<const G4LogicalVolume *, double> fLogicalVolumeImportances;
+  std::vector<double> fEnergyBounds;
+  std::vector<double> fLowerWeightBounds;
+  std::vector<double> fUpperWeightBounds;
+  int fMaxSplit;
+
+  // world to voxel index of the importance image
+  GateImageIndexTransform fIndexTransform;
+  size_t fSizeX = 0;
+  size_t fSliceSize = 0;
+
+  // counts of the simulation (all threads)
+  std::atomic<long> fNbOfSplit{0};
+  std::atomic<long> fNbOfKilled{0};
+};
+
+#endif // GateWeightWindowActor_h
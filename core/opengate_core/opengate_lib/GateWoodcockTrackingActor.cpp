@@ -0,0 +1,268 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateWoodcockTrackingActor.h"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4ParticleChangeForGamma.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4RandomDirection.hh"
+#include "G4Region.hh"
+#include "GateHelpers.h"
+#include "GateHelpersDict.h"
+#include <cmath>
+
+GateWoodcockTrackingActor::GateWoodcockTrackingActor(py::dict &user_info)
+    : GateVActor(user_info, true) {}
+
+void GateWoodcockTrackingActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fDatabase = DictGetStr(user_info, "database");
+  fEnergyMax = DictGetDouble(user_info, "energy_max");
+}
+
+void GateWoodcockTrackingActor::SetPhantomVolumeName(std::string name) {
+  fPhantomVolumeName = name;
+}
+
+void GateWoodcockTrackingActor::SetImageParameterisation(
+    GateImageNestedParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateWoodcockTrackingActor::SetImageParameterisation(
+    GateImageRegularParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->GetLabelMaterials();
+}
+
+void GateWoodcockTrackingActor::SetImageParameterisation(
+    GateImageRunParameterisation *param) {
+  fLabelImage = param->cpp_image.GetPointer();
+  fLabelMaterials = &param->fMaterials;
+}
+
+void GateWoodcockTrackingActor::StartSimulationAction() {
+  fNbRealInteractions = 0;
+  fNbFictitiousInteractions = 0;
+}
+
+void GateWoodcockTrackingActor::BeginOfRunActionMasterThread(int /*run_id*/) {
+  // phantom geometry and labels (the image may change between runs)
+  fAttenuation.Initialize(
+      fLabelImage, *fLabelMaterials, fPhantomVolumeName,
+      GateMaterialMuHandler::GetInstance(fDatabase, fEnergyMax));
+
+  // couple of each label, with the production cuts of the phantom region
+  const auto *pv =
+      G4PhysicalVolumeStore::GetInstance()->GetVolume(fPhantomVolumeName);
+  const auto *cuts = pv->GetLogicalVolume()->GetRegion()->GetProductionCuts();
+  const auto *table = G4ProductionCutsTable::GetProductionCutsTable();
+  fLabelCouples.clear();
+  for (auto *material : *fLabelMaterials) {
+    const auto *couple = table->GetMaterialCutsCouple(material, cuts);
+    if (couple == nullptr) {
+      std::ostringstream oss;
+      oss << "Error in the actor " << GetName()
+          << ": no material cuts couple for the material "
+          << material->GetName() << " of the volume " << fPhantomVolumeName;
+      Fatal(oss.str());
+    }
+    fLabelCouples.push_back(couple);
+  }
+}
+
+void GateWoodcockTrackingActor::InitializeProcesses() {
+  auto &l = fThreadLocalData.Get();
+  if (!l.processes.empty())
+    return;
+  // (the process manager of the thread)
+  auto *manager = G4Gamma::Gamma()->GetProcessManager();
+  const auto *list = manager->GetProcessList();
+  for (size_t i = 0; i < list->size(); i++) {
+    auto *process = dynamic_cast<G4VEmProcess *>((*list)[i]);
+    if (process != nullptr && manager->GetProcessActivation(process))
+      l.processes.push_back(process);
+  }
+  if (l.processes.empty()) {
+    std::ostringstream oss;
+    oss << "Error in the actor " << GetName()
+        << ": no electromagnetic process for the gammas (the processes "
+           "wrapped for biasing are not supported).";
+    Fatal(oss.str());
+  }
+  l.cross_sections.resize(l.processes.size());
+}
+
+void GateWoodcockTrackingActor::SteppingAction(G4Step *step) {
+  // the first step of a photon in the phantom: the photon is then replaced,
+  // there is no other step in the phantom
+  if (step->GetTrack()->GetParticleDefinition() != G4Gamma::Gamma())
+    return;
+  WoodcockFlight(step);
+}
+
+void GateWoodcockTrackingActor::WoodcockFlight(G4Step *step) {
+  auto *track = step->GetTrack();
+  const auto *pre = step->GetPreStepPoint();
+
+  // the interaction of this step (if any) is suppressed: its secondaries
+  // are removed (they are the last ones of the track) and its deposit is
+  // ignored by the next actors
+  auto *secondaries = step->GetfSecondary();
+  for (auto n = step->GetNumberOfSecondariesInCurrentStep(); n > 0; n--) {
+    delete secondaries->back();
+    secondaries->pop_back();
+  }
+  step->ResetTotalEnergyDeposit();
+  track->SetTrackStatus(fStopAndKill);
+
+  auto position = pre->GetPosition();
+  const auto &direction = pre->GetMomentumDirection();
+  const auto energy = pre->GetKineticEnergy();
+  auto time = pre->GetGlobalTime();
+
+  // majorant at the photon energy, constant during the flight
+  auto &l = fThreadLocalData.Get();
+  if (energy != l.last_energy) {
+    l.last_energy = energy;
+    l.last_mu_max = fAttenuation.GetMaxMu(energy);
+  }
+  const auto mu_max = l.last_mu_max;
+
+  auto remaining = fAttenuation.DistanceToExit(position, direction);
+  unsigned long nb_fictitious = 0;
+  while (mu_max > 0) {
+    const auto s = -std::log(G4UniformRand()) / mu_max;
+    if (s >= remaining)
+      break;
+    position += s * direction;
+    remaining -= s;
+    time += s / CLHEP::c_light;
+
+    // real interaction with the probability mu / mu_max
+    const auto label = fAttenuation.GetLabel(position);
+    if (label < 0 ||
+        G4UniformRand() * mu_max >= fAttenuation.GetMu(label, energy)) {
+      nb_fictitious++;
+      continue;
+    }
+    G4Track photon(new G4DynamicParticle(G4Gamma::Gamma(), direction, energy),
+                   time, position);
+    photon.SetPolarization(pre->GetPolarization());
+    photon.SetWeight(pre->GetWeight());
+    photon.SetTrackID(track->GetTrackID());
+    photon.SetParentID(track->GetParentID());
+    photon.SetCreatorProcess(track->GetCreatorProcess());
+    Interact(&photon, label, *secondaries);
+    fNbRealInteractions++;
+    fNbFictitiousInteractions += nb_fictitious;
+    return;
+  }
+  fNbFictitiousInteractions += nb_fictitious;
+
+  // the same photon at the exit, just outside the phantom (so that it is
+  // not located in the phantom again)
+  auto *particle = new G4DynamicParticle(G4Gamma::Gamma(), direction, energy);
+  particle->SetPolarization(pre->GetPolarization());
+  const auto exit = position + (remaining + CLHEP::nanometer) * direction;
+  auto *photon =
+      new G4Track(particle, time + remaining / CLHEP::c_light, exit);
+  photon->SetWeight(pre->GetWeight());
+  photon->SetParentID(track->GetTrackID());
+  photon->SetCreatorProcess(track->GetCreatorProcess());
+  secondaries->push_back(photon);
+}
+
+void GateWoodcockTrackingActor::Interact(G4Track *track, int label,
+                                         std::vector<G4Track *> &secondaries) {
+  InitializeProcesses();
+  auto &l = fThreadLocalData.Get();
+  const auto *couple = fLabelCouples[label];
+  const auto energy = track->GetKineticEnergy();
+
+  // process selected with the cross-sections of the physics list (a single
+  // process, e.g. the general gamma process, is selected directly)
+  auto *process = l.processes[0];
+  if (l.processes.size() > 1) {
+    double total = 0;
+    for (size_t i = 0; i < l.processes.size(); i++) {
+      l.cross_sections[i] =
+          l.processes[i]->CrossSectionPerVolume(energy, couple);
+      total += l.cross_sections[i];
+    }
+    auto u = G4UniformRand() * total;
+    for (size_t i = 0; i < l.processes.size(); i++) {
+      process = l.processes[i];
+      u -= l.cross_sections[i];
+      if (u < 0)
+        break;
+    }
+  }
+
+  // step of the track at the interaction point, in the material of the
+  // voxel (no touchable: the new tracks are located by the navigator)
+  G4Step step;
+  for (auto *point : {step.GetPreStepPoint(), step.GetPostStepPoint()}) {
+    point->SetPosition(track->GetPosition());
+    point->SetGlobalTime(track->GetGlobalTime());
+    point->SetKineticEnergy(energy);
+    point->SetMomentumDirection(track->GetMomentumDirection());
+    point->SetWeight(track->GetWeight());
+    point->SetMaterial(const_cast<G4Material *>(couple->GetMaterial()));
+    point->SetMaterialCutsCouple(couple);
+  }
+  step.SetTrack(track);
+  track->SetStep(&step);
+
+  // state of the process at this point (material, cross-section), then
+  // final state
+  G4ForceCondition condition;
+  process->PostStepGetPhysicalInteractionLength(*track, 0, &condition);
+  auto *change = static_cast<G4ParticleChangeForGamma *>(
+      process->PostStepDoIt(*track, step));
+
+  for (auto i = 0; i < change->GetNumberOfSecondaries(); i++) {
+    auto *t = change->GetSecondary(i);
+    t->SetParentID(track->GetTrackID());
+    t->SetCreatorProcess(process);
+    secondaries.push_back(t);
+  }
+  change->Clear();
+
+  // the scattered photon starts a new flight
+  const auto e = change->GetProposedKineticEnergy();
+  if (change->GetTrackStatus() == fAlive && e > 0) {
+    auto *particle = new G4DynamicParticle(
+        G4Gamma::Gamma(), change->GetProposedMomentumDirection(), e);
+    particle->SetPolarization(change->GetProposedPolarization());
+    auto *photon =
+        new G4Track(particle, track->GetGlobalTime(), track->GetPosition());
+    photon->SetWeight(track->GetWeight());
+    photon->SetParentID(track->GetTrackID());
+    photon->SetCreatorProcess(process);
+    secondaries.push_back(photon);
+  }
+
+  // local deposit, carried by an electron
+  const auto edep = change->GetLocalEnergyDeposit();
+  if (edep > 0) {
+    auto *particle = new G4DynamicParticle(G4Electron::Electron(),
+                                           G4RandomDirection(), edep);
+    auto *electron =
+        new G4Track(particle, track->GetGlobalTime(), track->GetPosition());
+    electron->SetWeight(track->GetWeight());
+    electron->SetParentID(track->GetTrackID());
+    electron->SetCreatorProcess(process);
+    secondaries.push_back(electron);
+  }
+  track->SetStep(nullptr);
+}
@@ -0,0 +1,105 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateWoodcockTrackingActor_h
+#define GateWoodcockTrackingActor_h
+
+#include "G4Cache.hh"
+#include "G4VEmProcess.hh"
+#include "GateAttenuationRayMarcher.h"
+#include "GateVActor.h"
+#include <atomic>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Woodcock (delta) tracking of the photons in a voxelized phantom
+ * (ImageVolume): the photons cross the phantom without stopping at the voxel
+ * boundaries.
+ *
+ * A photon that enters the phantom (or is created in it) is replaced by a
+ * Woodcock flight from the start of its first step: the flight lengths are
+ * sampled with the majorant mu_max, the largest mu of the phantom materials
+ * at the photon energy (GateMaterialMuHandler tables), and an interaction at
+ * a point of attenuation mu is real with the probability mu / mu_max,
+ * fictitious otherwise (the photon goes on unchanged). At a real interaction,
+ * the process is selected among the gamma processes of the physics list with
+ * their cross-sections in the material of the voxel, and its PostStepDoIt
+ * gives the final state (Geant4 physics): the secondaries and the scattered
+ * photon are new tracks at the interaction point (the scattered photon starts
+ * a new Woodcock flight). A photon that reaches the boundary is moved just
+ * outside the phantom.
+ *
+ * The local energy deposit of the interaction (e.g. binding energy, when
+ * there is no atomic relaxation) is given to an electron at the
+ * interaction point, so that it is scored by the actors of the voxel.
+ */
+class GateWoodcockTrackingActor : public GateVActor {
+
+public:
+  explicit GateWoodcockTrackingActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void StartSimulationAction() override;
+
+  void BeginOfRunActionMasterThread(int run_id) override;
+
+  void SteppingAction(G4Step *step) override;
+
+  void SetPhantomVolumeName(std::string name);
+
+  void SetImageParameterisation(GateImageNestedParameterisation *param);
+
+  void SetImageParameterisation(GateImageRegularParameterisation *param);
+
+  void SetImageParameterisation(GateImageRunParameterisation *param);
+
+  unsigned long GetNumberOfRealInteractions() const {
+    return fNbRealInteractions;
+  }
+
+  unsigned long GetNumberOfFictitiousInteractions() const {
+    return fNbFictitiousInteractions;
+  }
+
+protected:
+  // Woodcock flight of the photon of the step, from its pre step point
+  void WoodcockFlight(G4Step *step);
+
+  // Real interaction at the position of the track, the secondaries are
+  // added to the list
+  void Interact(G4Track *track, int label,
+                std::vector<G4Track *> &secondaries);
+
+  // Gamma processes of the thread (the first time)
+  void InitializeProcesses();
+
+  std::string fDatabase;
+  double fEnergyMax = 0;
+  std::string fPhantomVolumeName;
+  const GateAttenuationRayMarcher::LabelImageType *fLabelImage = nullptr;
+  const std::vector<G4Material *> *fLabelMaterials = nullptr;
+  GateAttenuationRayMarcher fAttenuation;
+  // couple of the material of each label, in the region of the phantom
+  std::vector<const G4MaterialCutsCouple *> fLabelCouples;
+
+  std::atomic<unsigned long> fNbRealInteractions{0};
+  std::atomic<unsigned long> fNbFictitiousInteractions{0};
+
+  struct threadLocalT {
+    std::vector<G4VEmProcess *> processes;
+    std::vector<double> cross_sections;
+    // majorant of the last energy (the same for a monoenergetic beam)
+    double last_energy = -1;
+    double last_mu_max = 0;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateWoodcockTrackingActor_h
@@ -0,0 +1,30 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateWorkerThreadInitialization.h"
+#include "G4Threading.hh"
+#include "GateNuma.h"
+#include "GatePhiloxEngine.h"
+#include "Randomize.hh"
+
+void GateWorkerThreadInitialization::SetupRNGEngine(
+    const CLHEP::HepRandomEngine *aRNGEngine) const {
+  if (dynamic_cast<const GatePhiloxEngine *>(aRNGEngine) == nullptr) {
+    G4UserWorkerThreadInitialization::SetupRNGEngine(aRNGEngine);
+    return;
+  }
+  // the engine is owned by the thread, the seeds are set later by the master
+  G4Random::setTheEngine(new GatePhiloxEngine());
+}
+
+G4WorkerRunManager *
+GateWorkerThreadInitialization::CreateWorkerRunManager() const {
+  // (in the worker thread) first, so that all the memory of the thread is
+  // allocated on its node
+  GateNuma::PinCurrentThread(G4Threading::G4GetThreadId());
+  return G4UserWorkerThreadInitialization::CreateWorkerRunManager();
+}
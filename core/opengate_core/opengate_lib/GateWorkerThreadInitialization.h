@@ -0,0 +1,31 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateWorkerThreadInitialization_h
+#define GateWorkerThreadInitialization_h
+
+#include "G4UserWorkerThreadInitialization.hh"
+
+/*
+    Creation of the random engine of the worker threads. Geant4 only clones
+    its own engines: when the engine of the master is a GatePhiloxEngine, the
+    workers get a new GatePhiloxEngine (seeded by the master at each event
+    like the other engines).
+
+    The worker threads are also pinned to their NUMA node (see GateNuma)
+    before their run manager is created.
+ */
+
+class GateWorkerThreadInitialization
+    : public G4UserWorkerThreadInitialization {
+public:
+  void SetupRNGEngine(const CLHEP::HepRandomEngine *aRNGEngine) const override;
+
+  G4WorkerRunManager *CreateWorkerRunManager() const override;
+};
+
+#endif // GateWorkerThreadInitialization_h
@@ -7,6 +7,7 @@
 
 #include "GateDigiAdderInVolume.h"
 #include "G4UnitsTable.hh"
+#include <algorithm>
 
 GateDigiAdderInVolume::GateDigiAdderInVolume() {
   fFinalEdep = 0.0;
@@ -77,6 +78,70 @@ void GateDigiAdderInVolume::Update(size_t i, double edep,
     fNumberOfHits++;
 }
 
+void GateDigiAdderInVolume::Reduce(size_t n, const size_t *index,
+                                   const double *edep, const double *x,
+                                   const double *y, const double *z,
+                                   const double *time) {
+  /*
+   * Segmented version of Update: one pass per quantity over the columns of
+   * the segment. The min/max passes have no dependency between the hits
+   * (vectorized by the compiler); the sums are kept in the order of the hits
+   * so that the values are the same as with Update.
+   */
+  if (n == 0)
+    return;
+
+  double sum = fFinalEdep;
+  for (size_t k = 0; k < n; k++)
+    sum += edep[k];
+  fFinalEdep = sum;
+
+  if (fPolicy == GateDigitizerAdderActor::AdderPolicy::EnergyWinnerPosition) {
+    // max, then the first hit with this max
+    double max_edep = edep[0];
+    for (size_t k = 1; k < n; k++)
+      max_edep = edep[k] > max_edep ? edep[k] : max_edep;
+    if (max_edep > fMaxEdep) {
+      size_t k = 0;
+      while (edep[k] != max_edep)
+        k++;
+      fFinalPosition.set(x[k], y[k], z[k]);
+      fFinalIndex = index[k];
+      fMaxEdep = max_edep;
+    }
+  }
+
+  if (fPolicy ==
+      GateDigitizerAdderActor::AdderPolicy::EnergyWeightedCentroidPosition) {
+    double sx = fFinalPosition.x();
+    double sy = fFinalPosition.y();
+    double sz = fFinalPosition.z();
+    for (size_t k = 0; k < n; k++) {
+      sx += x[k] * edep[k];
+      sy += y[k] * edep[k];
+      sz += z[k] * edep[k];
+    }
+    fFinalPosition.set(sx, sy, sz);
+    fFinalIndex = index[n - 1];
+  }
+
+  double min_time = fFinalTime;
+  double max_time = fLatestTime;
+  for (size_t k = 0; k < n; k++) {
+    min_time = time[k] < min_time ? time[k] : min_time;
+    max_time = time[k] > max_time ? time[k] : max_time;
+  }
+  fFinalTime = min_time;
+
+  if (fTimeDifferenceFlag) {
+    fEarliestTime = std::min(fEarliestTime, min_time);
+    fLatestTime = max_time;
+  }
+
+  if (fNumberOfHitsFlag)
+    fNumberOfHits += static_cast<int>(n);
+}
+
 void GateDigiAdderInVolume::Terminate() {
   if (fPolicy ==
       GateDigitizerAdderActor::AdderPolicy::EnergyWeightedCentroidPosition) {
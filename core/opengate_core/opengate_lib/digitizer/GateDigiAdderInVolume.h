@@ -38,6 +38,13 @@ public:
 
   void Update(size_t i, double edep, const G4ThreeVector &pos, double time);
 
+  // Merge n hits at once, given as contiguous columns (the index, edep,
+  // position and time of each hit, without zero edep): same result as Update
+  // on each hit in this order
+  void Reduce(size_t n, const size_t *index, const double *edep,
+              const double *x, const double *y, const double *z,
+              const double *time);
+
   void Terminate();
 };
 
@@ -0,0 +1,96 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigiAsyncWriter.h"
+#include "G4RootAnalysisManager.hh"
+
+GateDigiAsyncWriter::GateDigiAsyncWriter(size_t maxQueueDepth) {
+  fMaxQueueDepth = std::max<size_t>(1, maxQueueDepth);
+  fIsWriting = false;
+  fIsStopped = false;
+  fThread = std::thread(&GateDigiAsyncWriter::Run, this);
+}
+
+GateDigiAsyncWriter::~GateDigiAsyncWriter() { Stop(); }
+
+GateDigiAsyncWriter::Batch
+GateDigiAsyncWriter::GetFreeBatch(GateDigiCollection *hc) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto &free = fFreeBatches[hc];
+  if (free.empty()) {
+    Batch batch;
+    batch.fCollection = hc;
+    return batch;
+  }
+  auto batch = std::move(free.back());
+  free.pop_back();
+  return batch;
+}
+
+void GateDigiAsyncWriter::Push(Batch &&batch) {
+  std::unique_lock<std::mutex> lock(fMutex);
+  // back-pressure: the worker waits for the writer
+  fWrittenCondition.wait(lock,
+                         [this] { return fQueue.size() < fMaxQueueDepth; });
+  fQueue.push_back(std::move(batch));
+  fPushedCondition.notify_one();
+}
+
+void GateDigiAsyncWriter::Flush() {
+  std::unique_lock<std::mutex> lock(fMutex);
+  fWrittenCondition.wait(lock,
+                         [this] { return fQueue.empty() && !fIsWriting; });
+}
+
+void GateDigiAsyncWriter::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fIsStopped)
+      return;
+    fIsStopped = true;
+  }
+  // (the remaining batches are written before the end of the thread)
+  fPushedCondition.notify_one();
+  if (fThread.joinable())
+    fThread.join();
+}
+
+void GateDigiAsyncWriter::Run() {
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (true) {
+    fPushedCondition.wait(lock,
+                          [this] { return !fQueue.empty() || fIsStopped; });
+    if (fQueue.empty())
+      return;
+    auto batch = std::move(fQueue.front());
+    fQueue.pop_front();
+    fIsWriting = true;
+    // the worker can push the next batch while this one is written
+    fWrittenCondition.notify_all();
+    lock.unlock();
+    WriteBatch(batch);
+    lock.lock();
+    fIsWriting = false;
+    fFreeBatches[batch.fCollection].push_back(std::move(batch));
+    fWrittenCondition.notify_all();
+  }
+}
+
+void GateDigiAsyncWriter::WriteBatch(Batch &batch) {
+  auto *ram = batch.fManager;
+  const auto n = batch.fValues.size();
+  for (size_t i = 0; i < batch.fSize; i++) {
+    for (size_t a = 0; a < n; a++)
+      batch.fValues[a]->FillToRoot(ram, batch.fAttributeTupleIds[a],
+                                   batch.fAttributeIds[a], i);
+    ram->AddNtupleRow(batch.fTupleId);
+  }
+  // the buffers keep their capacity for the next swap
+  for (auto &v : batch.fValues)
+    v->Clear();
+  batch.fSize = 0;
+}
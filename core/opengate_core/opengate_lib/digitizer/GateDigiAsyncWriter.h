@@ -0,0 +1,81 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigiAsyncWriter_h
+#define GateDigiAsyncWriter_h
+
+#include "GateVDigiAttribute.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+class GateDigiCollection;
+
+/*
+ * Background writer of the digi collections of one thread (see
+ * GateDigiCollection::SetAsyncWriteFlag and GateDigiCollectionsRootManager).
+ *
+ * Instead of filling the root tuple row by row, the worker thread swaps the
+ * values of all the attributes of the collection into a batch (no copy) and
+ * pushes it in the queue. The writer thread fills the rows in the tuple (and
+ * G4 compresses the baskets) while the worker continues the tracking. The
+ * batches are then cleared and recycled: the worker swaps its next values
+ * with them, so the capacities are kept.
+ *
+ * The root analysis manager of the worker is used by the writer thread: the
+ * worker must not use it at the same time (Flush before any other use, e.g.
+ * Write). The queue is bounded: Push waits when it is full.
+ */
+
+class GateDigiAsyncWriter {
+public:
+  struct Batch {
+    GateDigiCollection *fCollection = nullptr;
+    G4RootAnalysisManager *fManager = nullptr;
+    int fTupleId = -1;
+    size_t fSize = 0;
+    // one buffer per attribute, with the tuple and column ids
+    std::vector<std::unique_ptr<GateVDigiValuesBuffer>> fValues;
+    std::vector<int> fAttributeTupleIds;
+    std::vector<int> fAttributeIds;
+  };
+
+  explicit GateDigiAsyncWriter(size_t maxQueueDepth);
+
+  ~GateDigiAsyncWriter();
+
+  // A recycled batch of this collection (or a new one)
+  Batch GetFreeBatch(GateDigiCollection *hc);
+
+  // Queue the batch (wait if the queue is full)
+  void Push(Batch &&batch);
+
+  // Wait until all the queued batches are written
+  void Flush();
+
+  // Flush and stop the writer thread
+  void Stop();
+
+protected:
+  void Run();
+
+  void WriteBatch(Batch &batch);
+
+  size_t fMaxQueueDepth;
+  std::thread fThread;
+  std::mutex fMutex;
+  std::condition_variable fPushedCondition;
+  std::condition_variable fWrittenCondition;
+  std::deque<Batch> fQueue;
+  std::map<GateDigiCollection *, std::vector<Batch>> fFreeBatches;
+  bool fIsWriting;
+  bool fIsStopped;
+};
+
+#endif // GateDigiAsyncWriter_h
@@ -184,13 +184,15 @@ void GateDigiAttributeManager::InitializeAllDigiAttributes() {
   DefineDigiAttribute(
       "PreStepUniqueVolumeID", 'U', FILLF {
         auto *m = GateUniqueVolumeIDManager::GetInstance();
-        auto uid = m->GetVolumeID(step->GetPreStepPoint()->GetTouchable());
+        const auto &uid =
+            m->GetVolumeID(step->GetPreStepPoint()->GetTouchable());
         att->FillUValue(uid);
       });
   DefineDigiAttribute(
       "PostStepUniqueVolumeID", 'U', FILLF {
         auto *m = GateUniqueVolumeIDManager::GetInstance();
-        auto uid = m->GetVolumeID(step->GetPostStepPoint()->GetTouchable());
+        const auto &uid =
+            m->GetVolumeID(step->GetPostStepPoint()->GetTouchable());
         att->FillUValue(uid);
       });
   DefineDigiAttribute(
@@ -210,10 +212,12 @@ void GateDigiAttributeManager::InitializeAllDigiAttributes() {
         if (step->GetPostStepPoint()
                 ->GetProcessDefinedStep()
                 ->GetProcessName() == "Transportation") {
-          auto uid = m->GetVolumeID(step->GetPreStepPoint()->GetTouchable());
+          const auto &uid =
+              m->GetVolumeID(step->GetPreStepPoint()->GetTouchable());
           att->FillUValue(uid);
         } else {
-          auto uid = m->GetVolumeID(step->GetPostStepPoint()->GetTouchable());
+          const auto &uid =
+              m->GetVolumeID(step->GetPostStepPoint()->GetTouchable());
           att->FillUValue(uid);
         }
       });
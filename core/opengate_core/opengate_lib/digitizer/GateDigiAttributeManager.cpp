@@ -90,30 +90,26 @@ void GateDigiAttributeManager::DefineDigiAttribute(
 
 GateVDigiAttribute *GateDigiAttributeManager::CopyDigiAttribute(
     GateVDigiAttribute *att) { // FIXME to move elsewhere !!!!!
-  GateVDigiAttribute *a = nullptr;
-  if (att->GetDigiAttributeType() == 'D') {
-    a = new GateTDigiAttribute<double>(att->GetDigiAttributeName());
-  }
-  if (att->GetDigiAttributeType() == 'I') {
-    a = new GateTDigiAttribute<int>(att->GetDigiAttributeName());
-  }
-  if (att->GetDigiAttributeType() == 'S') {
-    a = new GateTDigiAttribute<std::string>(att->GetDigiAttributeName());
-  }
-  if (att->GetDigiAttributeType() == '3') {
-    a = new GateTDigiAttribute<G4ThreeVector>(att->GetDigiAttributeName());
-  }
-  if (att->GetDigiAttributeType() == 'U') {
-    a = new GateTDigiAttribute<GateUniqueVolumeID::Pointer>(
-        att->GetDigiAttributeName());
-  }
-  if (a != nullptr) {
-    a->fProcessHitsFunction = att->fProcessHitsFunction;
-    return a;
-  }
-  DDE(att->GetDigiAttributeName());
-  DDE(att->GetDigiAttributeType());
-  DDE(att->GetDigiAttributeTupleId());
-  Fatal("Error in CopyDigiAttribute");
+  auto *a = NewDigiAttribute(att->GetDigiAttributeType(),
+                             att->GetDigiAttributeName());
+  a->fProcessHitsFunction = att->fProcessHitsFunction;
+  return a;
+}
+
+GateVDigiAttribute *
+GateDigiAttributeManager::NewDigiAttribute(char type, const std::string &name) {
+  if (type == 'D')
+    return new GateTDigiAttribute<double>(name);
+  if (type == 'I')
+    return new GateTDigiAttribute<int>(name);
+  if (type == 'S')
+    return new GateTDigiAttribute<std::string>(name);
+  if (type == '3')
+    return new GateTDigiAttribute<G4ThreeVector>(name);
+  if (type == 'U')
+    return new GateTDigiAttribute<GateUniqueVolumeID::Pointer>(name);
+  DDE(name);
+  DDE(type);
+  Fatal("Error in NewDigiAttribute");
   return nullptr;
 }
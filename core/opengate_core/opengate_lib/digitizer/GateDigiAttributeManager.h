@@ -41,6 +41,10 @@ public:
 
   GateVDigiAttribute *CopyDigiAttribute(GateVDigiAttribute *);
 
+  // New attribute of the given type (D I S 3 U), without process hits
+  // function
+  GateVDigiAttribute *NewDigiAttribute(char type, const std::string &name);
+
 protected:
   GateDigiAttributeManager();
 
@@ -6,21 +6,38 @@
    -------------------------------------------------- */
 
 #include "GateDigiCollection.h"
+#include "../GateMemoryAccounting.h"
+#include "../GateTimeline.h"
+#include "G4RootAnalysisManager.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
 #include "G4Step.hh"
 #include "GateDigiAttributeManager.h"
 #include "GateDigiCollectionIterator.h"
 #include "GateDigiCollectionsRootManager.h"
+#include "GateDigiColumnarWriter.h"
+#include "GateDigiSchema.h"
 
 GateDigiCollection::GateDigiCollection(const std::string &collName)
     : G4VHitsCollection("", collName), fDigiCollectionName(collName) {
   fTupleId = -1;
   fDigiCollectionTitle = "Digi collection";
   fCurrentDigiAttributeId = 0;
+  fCapacityHint = 0;
+  fAsyncWriteFlag = false;
+  fWriter = nullptr;
+  fSelectionSource = nullptr;
+  fRetentionNbEvents = 0;
+  fRetentionTime = 0;
   SetFilenameAndInitRoot("");
   threadLocalData.Get().fBeginOfEventIndex = 0;
 }
 
-GateDigiCollection::~GateDigiCollection() {}
+GateDigiCollection::~GateDigiCollection() { delete fWriter; }
+
+std::vector<size_t> &GateDigiCollection::GetSelectionIndices() {
+  return threadLocalData.Get().fSelectionIndices;
+}
 
 size_t GateDigiCollection::GetBeginOfEventIndex() const {
   return threadLocalData.Get().fBeginOfEventIndex;
@@ -38,6 +55,14 @@ void GateDigiCollection::SetWriteToRootFlag(bool f) { fWriteToRootFlag = f; }
 
 void GateDigiCollection::SetFilenameAndInitRoot(std::string filename) {
   fFilename = filename;
+  delete fWriter;
+  fWriter = nullptr;
+  if (GateDigiColumnarWriter::IsColumnarFilename(fFilename)) {
+    // no root tuple
+    fWriter = new GateDigiColumnarWriter(fFilename, this);
+    SetWriteToRootFlag(false);
+    return;
+  }
   if (fFilename.empty())
     SetWriteToRootFlag(false);
   else
@@ -83,41 +108,197 @@ void GateDigiCollection::FillToRootIfNeeded(bool clear) {
       - can write to root or not according to the flag
       - can clear every N calls
    */
+  // (before the clear: the values are at their largest; not at each event)
+  if (clear)
+    UpdateMemoryAccounting();
+  GateTimelineScope timeline(
+      clear ? GateTimeline::Intern(fDigiCollectionName) : nullptr, "flush");
+  if (fWriter != nullptr) {
+    fWriter->Fill();
+    Clear();
+    ReserveIfNeeded();
+    return;
+  }
   if (!fWriteToRootFlag) {
     // need to set the index before (in case we don't clear)
     if (clear)
       Clear();
     else
       SetBeginOfEventIndex();
+    ReserveIfNeeded();
     return;
   }
   FillToRoot();
+  ReserveIfNeeded();
 }
 
 void GateDigiCollection::FillToRoot() {
+  if (fAsyncWriteFlag) {
+    FillToRootAsync();
+    return;
+  }
+  // (the digi discarded by the retention are already written)
+  FillRowsToRoot(threadLocalData.Get().fDiscardedSize, GetSize());
+  // required ! Cannot fill without clear
+  Clear();
+}
+
+void GateDigiCollection::FillRowsToRoot(size_t begin, size_t end) {
   /*
    * maybe not very efficient to loop that way (row then column)
    * but I don't manage to do elsewhere
    */
   auto *am = GateDigiCollectionsRootManager::GetInstance();
-  for (size_t i = 0; i < GetSize(); i++) {
-    for (auto *att : fDigiAttributes) {
-      att->FillToRoot(i);
+  // the writer of the thread may use the root manager
+  am->FlushAsyncWriter();
+  const auto *schema = GetSchemaColumns();
+  if (schema != nullptr) {
+    auto *ram = G4RootAnalysisManager::Instance();
+    for (size_t i = begin; i < end; i++) {
+      schema->FillToRoot(ram, fTupleId, i);
+      am->AddNtupleRow(fTupleId);
+    }
+  } else {
+    for (size_t i = begin; i < end; i++) {
+      for (auto *att : fDigiAttributes) {
+        att->FillToRoot(i);
+      }
+      am->AddNtupleRow(fTupleId);
     }
-    am->AddNtupleRow(fTupleId);
   }
-  // required ! Cannot fill without clear
-  Clear();
+}
+
+void GateDigiCollection::FillToRootAsync() {
+  auto &l = threadLocalData.Get();
+  const auto n = GetSize();
+  l.fHighWaterMark = std::max(l.fHighWaterMark, n);
+  l.fBeginOfEventIndex = 0;
+  if (n == 0)
+    return;
+  auto *am = GateDigiCollectionsRootManager::GetInstance();
+  auto *writer = am->GetAsyncWriter();
+  auto batch = writer->GetFreeBatch(this);
+  batch.fManager = G4RootAnalysisManager::Instance();
+  batch.fTupleId = fTupleId;
+  batch.fSize = n;
+  batch.fValues.resize(fDigiAttributes.size());
+  batch.fAttributeTupleIds.clear();
+  batch.fAttributeIds.clear();
+  for (size_t i = 0; i < fDigiAttributes.size(); i++) {
+    auto *att = fDigiAttributes[i];
+    // (the attribute gets the cleared values of the batch: it is now empty)
+    att->SwapValues(batch.fValues[i]);
+    batch.fAttributeTupleIds.push_back(att->GetDigiAttributeTupleId());
+    batch.fAttributeIds.push_back(att->GetDigiAttributeId());
+  }
+  writer->Push(std::move(batch));
+  // the capacity of the new values is checked again (ReserveIfNeeded)
+  l.fReservedSize = 0;
 }
 
 void GateDigiCollection::Clear() {
+  auto &l = threadLocalData.Get();
+  l.fHighWaterMark = std::max(l.fHighWaterMark, GetSize());
   for (auto *att : fDigiAttributes) {
     att->Clear();
   }
-  SetBeginOfEventIndex(0);
+  l.fBeginOfEventIndex = 0;
+  l.fRetainedEvents.clear();
+  l.fDiscardedSize = 0;
+}
+
+void GateDigiCollection::SetRetention(size_t nb_events, double time_window) {
+  fRetentionNbEvents = nb_events;
+  fRetentionTime = time_window;
+  if (!IsRetentionEnabled())
+    return;
+  // (the other writers take all the values of the thread)
+  if (fAsyncWriteFlag || fWriter != nullptr) {
+    std::ostringstream oss;
+    oss << "Error in the digi collection " << fDigiCollectionName
+        << ": the retention of the past events cannot be used with the "
+           "async write or the columnar (.json) output.";
+    Fatal(oss.str());
+  }
+}
+
+void GateDigiCollection::RetainEvents() {
+  auto &l = threadLocalData.Get();
+  auto &events = l.fRetainedEvents;
+  const auto time = l.fEvent.fTime;
+
+  // past events out of the retention (the current one counts for one)
+  while (!events.empty() &&
+         ((fRetentionNbEvents > 0 && events.size() >= fRetentionNbEvents) ||
+          (fRetentionTime > 0 && time - events.front().fTime > fRetentionTime)))
+    events.pop_front();
+
+  // their digi are written (once) and discarded
+  const auto size = GetSize();
+  const auto end = events.empty() ? size : events.front().fBeginIndex;
+  if (end > l.fDiscardedSize) {
+    if (fWriteToRootFlag)
+      FillRowsToRoot(l.fDiscardedSize, end);
+    l.fDiscardedSize = end;
+  }
+
+  // the values are compacted when at least half of them are discarded: each
+  // retained digi is moved at most once per discarded digi (amortized)
+  if (l.fDiscardedSize > 0 && 2 * l.fDiscardedSize >= size) {
+    l.fHighWaterMark = std::max(l.fHighWaterMark, size);
+    for (auto *att : fDigiAttributes)
+      att->EraseFirst(l.fDiscardedSize);
+    for (auto &e : events)
+      e.fBeginIndex -= l.fDiscardedSize;
+    l.fDiscardedSize = 0;
+    ReserveIfNeeded();
+  }
+
+  // the current event starts
+  events.push_back({GetSize(), time});
+  SetBeginOfEventIndex();
+}
+
+size_t GateDigiCollection::GetNumberOfRetainedEvents() const {
+  return threadLocalData.Get().fRetainedEvents.size();
+}
+
+size_t GateDigiCollection::GetRetainedEventBeginIndex(size_t i) const {
+  return threadLocalData.Get().fRetainedEvents[i].fBeginIndex;
+}
+
+void GateDigiCollection::SetCapacityHint(size_t n) {
+  fCapacityHint = std::min(n, fMaxCapacityHint);
+}
+
+void GateDigiCollection::ReserveIfNeeded() {
+  auto &l = threadLocalData.Get();
+  const auto n = std::max(fCapacityHint, l.fHighWaterMark);
+  if (n <= l.fReservedSize)
+    return;
+  // (the vectors are not moved: the fill plan pointers remain valid)
+  for (auto *att : fDigiAttributes)
+    att->Reserve(n);
+  l.fReservedSize = n;
+}
+
+size_t GateDigiCollection::GetMemoryBytes() const {
+  size_t bytes = 0;
+  for (const auto *att : fDigiAttributes)
+    bytes += att->GetMemoryBytes();
+  return bytes;
+}
+
+void GateDigiCollection::UpdateMemoryAccounting() const {
+  if (!GateMemoryAccounting::IsEnabled())
+    return;
+  GateMemoryAccounting::Update("digi_collection", fDigiCollectionName,
+                               GetMemoryBytes());
 }
 
 void GateDigiCollection::Write() const {
+  if (fWriter != nullptr)
+    fWriter->Write();
   if (!fWriteToRootFlag)
     return;
   auto *am = GateDigiCollectionsRootManager::GetInstance();
@@ -177,9 +358,168 @@ void GateDigiCollection::InitDigiAttributesFromCopy(
   }
 }
 
-void GateDigiCollection::FillHits(G4Step *step) {
+void GateDigiCollection::BeginOfEvent(const G4Event *event) {
+  auto &l = threadLocalData.Get();
+  auto &c = l.fEvent;
+  const auto *vertex = event->GetPrimaryVertex(0);
+  const auto *primary = vertex->GetPrimary(0);
+  c.fEventID = event->GetEventID();
+  c.fRunID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  c.fKineticEnergy = primary->GetKineticEnergy();
+  c.fTime = vertex->GetT0();
+  c.fPosition = vertex->GetPosition();
+  c.fDirection = primary->GetMomentumDirection();
+  // the plan is compiled again with the per-event attributes
+  if (!c.fIsSet)
+    l.fFillPlan.clear();
+  c.fIsSet = true;
+}
+
+std::vector<GateDigiCollection::FillEntry> &GateDigiCollection::GetFillPlan() {
+  auto &l = threadLocalData.Get();
+  auto &plan = l.fFillPlan;
+  if (plan.size() == fDigiAttributes.size())
+    return plan;
+  // same values as the process hits functions of GateDigiAttributeList
+  static const std::map<std::string, std::pair<FillKind, char>> kinds = {
+      {"TotalEnergyDeposit", {FillKind::TotalEnergyDeposit, 'D'}},
+      {"KineticEnergy", {FillKind::PreKineticEnergy, 'D'}},
+      {"PreKineticEnergy", {FillKind::PreKineticEnergy, 'D'}},
+      {"PostKineticEnergy", {FillKind::PostKineticEnergy, 'D'}},
+      {"GlobalTime", {FillKind::GlobalTime, 'D'}},
+      {"LocalTime", {FillKind::LocalTime, 'D'}},
+      {"PreGlobalTime", {FillKind::PreGlobalTime, 'D'}},
+      {"Weight", {FillKind::Weight, 'D'}},
+      {"StepLength", {FillKind::StepLength, 'D'}},
+      {"TrackID", {FillKind::TrackID, 'I'}},
+      {"ParentID", {FillKind::ParentID, 'I'}},
+      {"PrePosition", {FillKind::PrePosition, '3'}},
+      {"Position", {FillKind::PostPosition, '3'}},
+      {"PostPosition", {FillKind::PostPosition, '3'}},
+      {"PreDirection", {FillKind::PreDirection, '3'}},
+      {"Direction", {FillKind::PostDirection, '3'}},
+      {"PostDirection", {FillKind::PostDirection, '3'}}};
+  // only if BeginOfEvent is called for each event
+  static const std::map<std::string, std::pair<FillKind, char>> event_kinds = {
+      {"EventID", {FillKind::EventID, 'I'}},
+      {"RunID", {FillKind::RunID, 'I'}},
+      {"EventKineticEnergy", {FillKind::EventKineticEnergy, 'D'}},
+      {"EventPosition", {FillKind::EventPosition, '3'}},
+      {"EventDirection", {FillKind::EventDirection, '3'}},
+      {"TimeFromBeginOfEvent", {FillKind::TimeFromBeginOfEvent, 'D'}}};
+  plan.clear();
   for (auto *att : fDigiAttributes) {
-    att->ProcessHits(step);
+    FillEntry entry;
+    entry.fAttribute = att;
+    auto name = att->GetDigiAttributeName();
+    const std::pair<FillKind, char> *kind = nullptr;
+    auto it = kinds.find(name);
+    if (it != kinds.end())
+      kind = &it->second;
+    auto eit = event_kinds.find(name);
+    if (l.fEvent.fIsSet && eit != event_kinds.end())
+      kind = &eit->second;
+    if (kind != nullptr && kind->second == att->GetDigiAttributeType()) {
+      entry.fKind = kind->first;
+      // the values of this thread (never reallocated, only cleared)
+      if (att->GetDigiAttributeType() == 'D')
+        entry.fDValues = &att->GetDValues();
+      if (att->GetDigiAttributeType() == 'I')
+        entry.fIValues = &att->GetIValues();
+      if (att->GetDigiAttributeType() == '3')
+        entry.f3Values = &att->Get3Values();
+    }
+    plan.push_back(entry);
+  }
+  return plan;
+}
+
+GateVDigiSchemaColumns *GateDigiCollection::GetSchemaColumns() {
+  auto &l = threadLocalData.Get();
+  if (l.fSchemaSize != fDigiAttributes.size()) {
+    l.fSchema = GateNewDigiSchemaColumns(this, GetDigiAttributeNames());
+    l.fSchemaSize = fDigiAttributes.size();
+  }
+  return l.fSchema.get();
+}
+
+void GateDigiCollection::FillHits(G4Step *step) {
+  // typed record of a built-in schema
+  auto *schema = GetSchemaColumns();
+  if (schema != nullptr) {
+    schema->FillHits(step);
+    return;
+  }
+  const auto *pre = step->GetPreStepPoint();
+  const auto *post = step->GetPostStepPoint();
+  const auto *track = step->GetTrack();
+  auto &plan = GetFillPlan();
+  const auto &c = threadLocalData.Get().fEvent;
+  for (auto &e : plan) {
+    switch (e.fKind) {
+    case FillKind::TotalEnergyDeposit:
+      e.fDValues->push_back(step->GetTotalEnergyDeposit());
+      break;
+    case FillKind::PreKineticEnergy:
+      e.fDValues->push_back(pre->GetKineticEnergy());
+      break;
+    case FillKind::PostKineticEnergy:
+      e.fDValues->push_back(post->GetKineticEnergy());
+      break;
+    case FillKind::GlobalTime:
+      e.fDValues->push_back(post->GetGlobalTime());
+      break;
+    case FillKind::LocalTime:
+      e.fDValues->push_back(post->GetLocalTime());
+      break;
+    case FillKind::PreGlobalTime:
+      e.fDValues->push_back(pre->GetGlobalTime());
+      break;
+    case FillKind::Weight:
+      e.fDValues->push_back(track->GetWeight());
+      break;
+    case FillKind::StepLength:
+      e.fDValues->push_back(step->GetStepLength());
+      break;
+    case FillKind::TrackID:
+      e.fIValues->push_back(track->GetTrackID());
+      break;
+    case FillKind::ParentID:
+      e.fIValues->push_back(track->GetParentID());
+      break;
+    case FillKind::PrePosition:
+      e.f3Values->push_back(pre->GetPosition());
+      break;
+    case FillKind::PostPosition:
+      e.f3Values->push_back(post->GetPosition());
+      break;
+    case FillKind::PreDirection:
+      e.f3Values->push_back(pre->GetMomentumDirection());
+      break;
+    case FillKind::PostDirection:
+      e.f3Values->push_back(post->GetMomentumDirection());
+      break;
+    case FillKind::EventID:
+      e.fIValues->push_back(c.fEventID);
+      break;
+    case FillKind::RunID:
+      e.fIValues->push_back(c.fRunID);
+      break;
+    case FillKind::EventKineticEnergy:
+      e.fDValues->push_back(c.fKineticEnergy);
+      break;
+    case FillKind::EventPosition:
+      e.f3Values->push_back(c.fPosition);
+      break;
+    case FillKind::EventDirection:
+      e.f3Values->push_back(c.fDirection);
+      break;
+    case FillKind::TimeFromBeginOfEvent:
+      e.fDValues->push_back(track->GetGlobalTime() - c.fTime);
+      break;
+    default:
+      e.fAttribute->ProcessHits(step);
+    }
   }
 }
 
@@ -189,6 +529,12 @@ void GateDigiCollection::FillDigiWithEmptyValue() {
   }
 }
 
+void GateDigiCollection::MoveLastDigiTo(size_t index) {
+  for (auto *att : fDigiAttributes) {
+    att->MoveLastTo(index);
+  }
+}
+
 size_t GateDigiCollection::GetSize() const {
   if (fDigiAttributes.empty())
     return 0;
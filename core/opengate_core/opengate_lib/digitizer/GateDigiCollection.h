@@ -8,14 +8,21 @@
 #ifndef GateDigiCollection_h
 #define GateDigiCollection_h
 
+#include "G4Event.hh"
 #include "G4TouchableHistory.hh"
+#include "../GateThreadContext.h"
 #include "GateVDigiAttribute.h"
+#include "GateVDigiCollectionWriter.h"
+#include <deque>
+#include <memory>
 #include <pybind11/stl.h>
 
 class GateDigiCollectionManager;
 
 class GateDigiCollectionIterator;
 
+class GateVDigiSchemaColumns;
+
 /*
  * Management of a Digi Collection.
  * See usage example in GateDigitizerHitsCollectionActor
@@ -40,6 +47,43 @@ class GateDigiCollectionIterator;
  *       (EndSimulationAction) *
       6) Close may not be needed (unsure)
  *
+ *  FillHits uses a fill plan, compiled once per thread: the most common
+ *  attributes (energies, times, positions, directions, IDs, weight) are
+ *  directly appended to the values of the thread, the others use the
+ *  process hits function of the attribute.
+ *  The per-event attributes (EventID, RunID, EventKineticEnergy, ...) are
+ *  read from the event context of the thread, set once per event by
+ *  BeginOfEvent (to be called in the BeginOfEventAction of the actor).
+ *
+ *  The values are never deallocated when cleared. The capacity of the values
+ *  of each thread is reserved for the largest number of digi between two
+ *  clears (high-water mark of the thread) or for the capacity hint (e.g.
+ *  from the clear_every option of the actor), so that they do not grow at
+ *  each FillToRootIfNeeded.
+ *
+ *  When the attributes are exactly the ones of a built-in schema (e.g. the
+ *  PET/SPECT hits, see GateDigiSchema), the hits are filled and the digi are
+ *  written to the root tuple with the compile-time schema instead.
+ *
+ *  With a .json filename, the values are not written in a root tuple but by a
+ *  GateDigiColumnarWriter (per thread files and a manifest).
+ *
+ *  With the async write flag, FillToRoot does not fill the tuple: the values
+ *  are swapped into a batch written by the background writer of the thread
+ *  (see GateDigiAsyncWriter), and the tracking continues.
+ *
+ *  With a retention (SetRetention), the collection is a ring buffer of the
+ *  last events of the thread instead of being cleared every N events: at the
+ *  beginning of each event (RetainEvents), the digi of the events older than
+ *  the last K events or than the time window are written and discarded. The
+ *  bounds of the retained events are kept, so that other actors can read a
+ *  sliding window of past events with a bounded memory.
+ *
+ *  A collection can be a selection of another one (source): its attributes
+ *  are declared but have no values, only the indices (in the source) of the
+ *  selected digi of the current event are stored (e.g. the energy windows
+ *  channels read by a projection, see GateDigitizerEnergyWindowsActor).
+ *
  */
 
 class GateDigiCollection : public G4VHitsCollection {
@@ -74,6 +118,9 @@ public:
 
   void SetWriteToRootFlag(bool f);
 
+  // Write the values with the background writer of the thread
+  void SetAsyncWriteFlag(bool f) { fAsyncWriteFlag = f; }
+
   void SetFilenameAndInitRoot(std::string filename);
 
   std::string GetFilename() const { return fFilename; }
@@ -88,6 +135,12 @@ public:
 
   void Clear();
 
+  // Expected number of digi between two clears (capped to
+  // fMaxCapacityHint), reserved in all threads
+  void SetCapacityHint(size_t n);
+
+  size_t GetCapacityHint() const { return fCapacityHint; }
+
   std::vector<GateVDigiAttribute *> &GetDigiAttributes() {
     return fDigiAttributes;
   }
@@ -98,20 +151,62 @@ public:
 
   bool IsDigiAttributeExists(const std::string &name) const;
 
+  // Cache the per-event values of the thread (see FillHits)
+  void BeginOfEvent(const G4Event *event);
+
   void FillHits(G4Step *step);
 
   void FillDigiWithEmptyValue();
 
+  // Replace the digi at index by the last digi, removed (e.g. reservoir
+  // sampling of the hits)
+  void MoveLastDigiTo(size_t index);
+
   std::string DumpLastDigi() const;
 
+  // Bytes allocated for the values of the thread (all attributes)
+  size_t GetMemoryBytes() const;
+
+  // Columns of the built-in schema for the thread (nullptr if the attributes
+  // do not match a schema), bound again if the attributes changed
+  GateVDigiSchemaColumns *GetSchemaColumns();
+
   Iterator NewIterator();
 
+  // Selection of the digi of the current event of the source collection
+  void SetSelectionSource(GateDigiCollection *source) {
+    fSelectionSource = source;
+  }
+
+  GateDigiCollection *GetSelectionSource() const { return fSelectionSource; }
+
+  // Indices (in the source) of the selected digi of the current event
+  std::vector<size_t> &GetSelectionIndices();
+
   size_t GetBeginOfEventIndex() const;
 
   void SetBeginOfEventIndex(size_t index);
 
   void SetBeginOfEventIndex();
 
+  // Keep the digi of the last nb_events events (0: no limit) and of the
+  // events in the time window before the current one (0: no limit)
+  void SetRetention(size_t nb_events, double time_window);
+
+  bool IsRetentionEnabled() const {
+    return fRetentionNbEvents > 0 || fRetentionTime > 0;
+  }
+
+  // At the beginning of an event, after BeginOfEvent (time of the event):
+  // discard the events out of the retention, the current event starts
+  void RetainEvents();
+
+  // Retained events of the thread, the oldest first, the current one last
+  size_t GetNumberOfRetainedEvents() const;
+
+  // Index of the first digi of the retained event i
+  size_t GetRetainedEventBeginIndex(size_t i) const;
+
 protected:
   // Can only be created by GateDigiCollectionManager
   explicit GateDigiCollection(const std::string &collName);
@@ -124,15 +219,105 @@ protected:
   int fTupleId;
   int fCurrentDigiAttributeId;
   bool fWriteToRootFlag;
+  bool fAsyncWriteFlag;
+  // other backend than root (nullptr: root)
+  GateVDigiCollectionWriter *fWriter;
+  size_t fCapacityHint;
+  // not nullptr: selection of the digi of this collection
+  GateDigiCollection *fSelectionSource;
+  static constexpr size_t fMaxCapacityHint = 1 << 14;
+  size_t fRetentionNbEvents;
+  double fRetentionTime;
+
+  // Attributes filled by FillHits without their process hits function
+  enum class FillKind {
+    Generic,
+    TotalEnergyDeposit,
+    PreKineticEnergy,
+    PostKineticEnergy,
+    GlobalTime,
+    LocalTime,
+    PreGlobalTime,
+    Weight,
+    StepLength,
+    TrackID,
+    ParentID,
+    EventID,
+    PrePosition,
+    PostPosition,
+    PreDirection,
+    PostDirection,
+    // per-event attributes (event context)
+    RunID,
+    EventKineticEnergy,
+    EventPosition,
+    EventDirection,
+    TimeFromBeginOfEvent
+  };
+
+  // Values of the current event, shared by all its hits
+  struct EventContext {
+    bool fIsSet = false;
+    int fEventID = 0;
+    int fRunID = 0;
+    double fKineticEnergy = 0;
+    double fTime = 0;
+    G4ThreeVector fPosition;
+    G4ThreeVector fDirection;
+  };
+
+  // One attribute of the fill plan, with the values of the thread
+  struct FillEntry {
+    FillKind fKind = FillKind::Generic;
+    GateVDigiAttribute *fAttribute = nullptr;
+    std::vector<double> *fDValues = nullptr;
+    std::vector<int> *fIValues = nullptr;
+    std::vector<G4ThreeVector> *f3Values = nullptr;
+  };
+
+  // Retained event: index of its first digi and time of its primary vertex
+  struct RetainedEvent {
+    size_t fBeginIndex;
+    double fTime;
+  };
 
   // thread local: the index of the beginning
   // of event is specific for each thread
   struct threadLocal_t {
     size_t fBeginOfEventIndex = 0;
+    // largest number of digi between two clears, reserved capacity
+    size_t fHighWaterMark = 0;
+    size_t fReservedSize = 0;
+    std::vector<FillEntry> fFillPlan;
+    EventContext fEvent;
+    std::vector<size_t> fSelectionIndices;
+    // built-in schema of the attributes (nullptr: none), bound to the values
+    // of the thread for fSchemaSize attributes
+    std::shared_ptr<GateVDigiSchemaColumns> fSchema;
+    size_t fSchemaSize = 0;
+    // retention: retained events, and number of digi at the front of the
+    // values that are written and discarded (not yet erased)
+    std::deque<RetainedEvent> fRetainedEvents;
+    size_t fDiscardedSize = 0;
   };
-  G4Cache<threadLocal_t> threadLocalData;
+  GateThreadLocal<threadLocal_t> threadLocalData;
 
   void FillToRoot();
+
+  // Write the digi [begin, end[ of the thread in the root tuple
+  void FillRowsToRoot(size_t begin, size_t end);
+
+  // Give the values to the background writer (no copy)
+  void FillToRootAsync();
+
+  // Reserve the values of the thread if the target capacity increased
+  void ReserveIfNeeded();
+
+  // Report the bytes of the thread to GateMemoryAccounting (if enabled)
+  void UpdateMemoryAccounting() const;
+
+  // Fill plan of the thread, (re)compiled if the attributes changed
+  std::vector<FillEntry> &GetFillPlan();
 };
 
 #endif // GateDigiCollection_h
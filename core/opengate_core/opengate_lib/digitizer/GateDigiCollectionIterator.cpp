@@ -16,6 +16,26 @@ GateDigiCollectionIterator::GateDigiCollectionIterator(GateDigiCollection *h,
 
 GateDigiCollectionIterator::GateDigiCollectionIterator() { fIndex = 0; }
 
+void GateDigiCollectionIterator::BindColumn(const std::string &name,
+                                            Column<double> &column) const {
+  column.fValues = &fDigiCollection->GetDigiAttribute(name)->GetDValues();
+}
+
+void GateDigiCollectionIterator::BindColumn(
+    const std::string &name, Column<G4ThreeVector> &column) const {
+  column.fValues = &fDigiCollection->GetDigiAttribute(name)->Get3Values();
+}
+
+void GateDigiCollectionIterator::BindColumn(
+    const std::string &name,
+    Column<GateUniqueVolumeID::Pointer> &column) const {
+  column.fValues = &fDigiCollection->GetDigiAttribute(name)->GetUValues();
+}
+
+size_t GateDigiCollectionIterator::GetEventBeginIndex() const {
+  return fDigiCollection->GetBeginOfEventIndex();
+}
+
 void GateDigiCollectionIterator::TrackAttribute(const std::string &name,
                                                 double **value) {
   auto *att = fDigiCollection->GetDigiAttribute(name);
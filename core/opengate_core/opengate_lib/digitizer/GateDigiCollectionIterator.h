@@ -10,11 +10,18 @@
 
 #include "G4TouchableHistory.hh"
 #include "GateDigiCollection.h"
+#include <algorithm>
 #include <cstddef>
 #include <iterator>
 
 /*
  Used to iterate along a DigiCollection.
+
+ The typed columns are an alternative to TrackAttribute: a column is bound
+ once per thread (BindColumn, e.g. at the first run), then GetEventSpan
+ gives the values of the current event, from GetBeginOfEventIndex to
+ GetSize, as one contiguous array (no virtual call nor thread local lookup
+ per digi). A span is only valid until the collection is filled or cleared.
  */
 
 class GateDigiCollectionIterator {
@@ -23,6 +30,39 @@ public:
 
   GateDigiCollectionIterator(GateDigiCollection *h, size_t index);
 
+  // Typed column of the collection (values of the calling thread)
+  template <class T> struct Column {
+    const std::vector<T> *fValues = nullptr;
+  };
+
+  // Values of a column for the current event
+  template <class T> struct Span {
+    const T *fData = nullptr;
+    size_t fSize = 0;
+    const T &operator[](size_t i) const { return fData[i]; }
+    const T *begin() const { return fData; }
+    const T *end() const { return fData + fSize; }
+    size_t size() const { return fSize; }
+  };
+
+  void BindColumn(const std::string &name, Column<double> &column) const;
+
+  void BindColumn(const std::string &name,
+                  Column<G4ThreeVector> &column) const;
+
+  void BindColumn(const std::string &name,
+                  Column<GateUniqueVolumeID::Pointer> &column) const;
+
+  // Index (in the collection) of the first value of the spans
+  size_t GetEventBeginIndex() const;
+
+  template <class T> Span<T> GetEventSpan(const Column<T> &column) const {
+    const auto &v = *column.fValues;
+    const auto begin = std::min(fDigiCollection->GetBeginOfEventIndex(),
+                                v.size());
+    return {v.data() + begin, v.size() - begin};
+  }
+
   void TrackAttribute(const std::string &name, double **value);
 
   void TrackAttribute(const std::string &name, G4ThreeVector **value);
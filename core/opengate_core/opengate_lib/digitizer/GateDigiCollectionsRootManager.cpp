@@ -19,21 +19,70 @@ GateDigiCollectionsRootManager *GateDigiCollectionsRootManager::GetInstance() {
   return fInstance;
 }
 
-GateDigiCollectionsRootManager::GateDigiCollectionsRootManager() {}
+GateDigiCollectionsRootManager::GateDigiCollectionsRootManager() {
+  fNtupleMergingFlag = true;
+  fBasketSize = -1;
+  fBasketEntries = -1;
+  fCompressionLevel = -1;
+}
+
+void GateDigiCollectionsRootManager::SetNtupleMergingFlag(bool b) {
+  fNtupleMergingFlag = b;
+}
+
+bool GateDigiCollectionsRootManager::GetNtupleMergingFlag() const {
+  return fNtupleMergingFlag;
+}
+
+void GateDigiCollectionsRootManager::SetRootFileOptions(int basketSize,
+                                                        int basketEntries,
+                                                        int compressionLevel) {
+  fBasketSize = basketSize;
+  fBasketEntries = basketEntries;
+  fCompressionLevel = compressionLevel;
+  std::lock_guard<std::mutex> lock(fRootFilenamesMutex);
+  fRootFilenames.clear();
+}
+
+py::dict GateDigiCollectionsRootManager::GetRootFileOptions() {
+  std::lock_guard<std::mutex> lock(fRootFilenamesMutex);
+  py::dict results;
+  for (const auto &filename : fRootFilenames) {
+    py::dict d;
+    d["basket_size"] = fBasketSize;
+    d["basket_entries"] = fBasketEntries;
+    d["compression"] = fCompressionLevel == 0 ? "none" : "zlib";
+    d["compression_level"] = fCompressionLevel;
+    results[filename.c_str()] = d;
+  }
+  return results;
+}
+
+bool GateDigiCollectionsRootManager::IsMasterWithoutOutput() const {
+  return G4Threading::IsMultithreadedApplication() &&
+         G4Threading::IsMasterThread() && !fNtupleMergingFlag;
+}
 
 void GateDigiCollectionsRootManager::OpenFile(int tupleId,
                                               std::string filename) {
   // Warning : this pointer is not the same for all workers in MT mode
   auto *ram = G4RootAnalysisManager::Instance();
   if (!ram->IsOpenFile()) {
-    // The following does not seems to work (default is 4000)
-    // ram->SetBasketEntries(8000);
-    // ram->SetBasketSize(5e6);
+    // The basket and compression options are read when the file is opened
+    // and when the ntuples are created, for the manager of this thread only:
+    // they are set on each thread, before OpenFile.
+    if (fBasketSize > 0)
+      ram->SetBasketSize(fBasketSize);
+    if (fBasketEntries > 0)
+      ram->SetBasketEntries(fBasketEntries);
+    if (fCompressionLevel >= 0)
+      ram->SetCompressionLevel(fCompressionLevel);
 
     // SetNtupleMerging must be called before OpenFile
     // To avoid a warning, the flag is only set for the master thread
     // and for the first opened tuple only.
-    if (G4Threading::IsMultithreadedApplication()) {
+    // Without merging, the workers write their own <name>_t<N> files.
+    if (G4Threading::IsMultithreadedApplication() && fNtupleMergingFlag) {
       auto *run = G4RunManager::GetRunManager()->GetCurrentRun();
       if (run) {
         if (run->GetRunID() == 0 && tupleId == 0)
@@ -75,13 +124,31 @@ void GateDigiCollectionsRootManager::AddNtupleRow(int tupleId) {
   ram->AddNtupleRow(tupleId);
 }
 
+GateDigiAsyncWriter *GateDigiCollectionsRootManager::GetAsyncWriter() {
+  auto &tl = threadLocalData.Get();
+  if (tl.fAsyncWriter == nullptr)
+    tl.fAsyncWriter = new GateDigiAsyncWriter(fAsyncWriterQueueDepth);
+  return tl.fAsyncWriter;
+}
+
+void GateDigiCollectionsRootManager::FlushAsyncWriter() {
+  auto &tl = threadLocalData.Get();
+  if (tl.fAsyncWriter != nullptr)
+    tl.fAsyncWriter->Flush();
+}
+
 void GateDigiCollectionsRootManager::Write(int tupleId) {
   auto &tl = threadLocalData.Get();
+  // all the rows must be in the tuples before
+  FlushAsyncWriter();
   // Do nothing if already Write
   if (G4Threading::IsMasterThread() && tl.fFileHasBeenWrittenByMaster)
     return;
   if (!G4Threading::IsMasterThread() && tl.fFileHasBeenWrittenByWorker)
     return;
+  // (sharded output: nothing to write for the master)
+  if (IsMasterWithoutOutput())
+    return;
   auto &tupleShouldBeWritten = tl.fTupleShouldBeWritten;
   tupleShouldBeWritten[tupleId] = true;
   bool shouldWrite = true;
@@ -91,6 +158,9 @@ void GateDigiCollectionsRootManager::Write(int tupleId) {
   if (shouldWrite) {
     auto *ram = G4RootAnalysisManager::Instance();
     ram->Write();
+    // the writer thread is no longer needed
+    delete tl.fAsyncWriter;
+    tl.fAsyncWriter = nullptr;
     // reset flags (not sure needed)
     for (auto &m : tupleShouldBeWritten)
       m.second = false;
@@ -121,6 +191,22 @@ void GateDigiCollectionsRootManager::CreateRootTuple(GateDigiCollection *hc) {
     Fatal(oss.str());
   }
 
+  // Need to initialize the map for all threads
+  auto &tl = threadLocalData.Get();
+  tl.fTupleShouldBeWritten[hc->GetTupleId()] = false;
+  tl.fFileHasBeenWrittenByWorker = false;
+  tl.fFileHasBeenWrittenByMaster = false;
+
+  {
+    // (for the statistics output)
+    std::lock_guard<std::mutex> lock(fRootFilenamesMutex);
+    fRootFilenames.insert(hc->GetFilename());
+  }
+
+  // (sharded output: the master has no file, so no empty file is written)
+  if (IsMasterWithoutOutput())
+    return;
+
   // Later, the verbosity could be an option
   ram->SetVerboseLevel(0);
   OpenFile(hc->GetTupleId(), hc->GetFilename());
@@ -136,13 +222,6 @@ void GateDigiCollectionsRootManager::CreateRootTuple(GateDigiCollection *hc) {
     CreateNtupleColumn(id, att);
   }
   ram->FinishNtuple(id);
-
-  // Need to initialize the map for all threads
-  auto &fAlreadyWriteThread = threadLocalData.Get().fTupleShouldBeWritten;
-  fAlreadyWriteThread[hc->GetTupleId()] = false;
-  auto &tl = threadLocalData.Get();
-  tl.fFileHasBeenWrittenByWorker = false;
-  tl.fFileHasBeenWrittenByMaster = false;
 }
 
 void GateDigiCollectionsRootManager::CreateNtupleColumn(
@@ -182,8 +261,9 @@ void GateDigiCollectionsRootManager::CloseFile(int tupleId) {
     } else
       ++iter;
   }
+  FlushAsyncWriter();
   // close only when the last tuple is done
-  if (fTupleNameIdMap.empty()) {
+  if (fTupleNameIdMap.empty() && !IsMasterWithoutOutput()) {
     auto *ram = G4RootAnalysisManager::Instance();
     ram->CloseFile();
   }
@@ -9,9 +9,12 @@
 #define GateDigiCollectionsRootManager_h
 
 #include "../GateHelpers.h"
+#include "GateDigiAsyncWriter.h"
 #include "GateDigiCollection.h"
 #include "GateVDigiAttribute.h"
+#include <mutex>
 #include <pybind11/stl.h>
+#include <set>
 
 class GateDigiCollectionsRootManager {
   /*
@@ -26,6 +29,23 @@ class GateDigiCollectionsRootManager {
    If there are several NTuples and one single filename,
    each tuple is in a different branch.
 
+   The collections with the async write flag are written by a background
+   writer, one per thread (GateDigiAsyncWriter). It is flushed before any
+   other use of the root manager of the thread (Write, CloseFile, and the
+   synchronous collections).
+
+   In MT, the rows of the workers are merged into the file of the master
+   at the end of the simulation. Without the ntuple merging flag (sharded
+   output), each worker writes its own file (<name>_t<N>.root) and the
+   master writes nothing: no serial merge, and the rows are not kept until
+   the end. The files are then read as one dataset from Python (see
+   read_root_output in digitizers.py).
+
+   The basket size, basket entries and compression level are set on the
+   analysis manager of each thread before its file is opened: they apply to
+   all the ROOT files of the simulation (Geant4 has one analysis manager per
+   thread, and only zlib compression).
+
    */
 public:
   static GateDigiCollectionsRootManager *
@@ -46,11 +66,44 @@ public:
 
   void AddNtupleRow(int tupleId);
 
+  // Merge the tuples of the workers (MT only, default is true)
+  void SetNtupleMergingFlag(bool b);
+
+  bool GetNtupleMergingFlag() const;
+
+  // Basket and compression of the ROOT files (-1: Geant4 default). Must be
+  // set before the tuples are created; the list of written files is reset.
+  void SetRootFileOptions(int basketSize, int basketEntries,
+                          int compressionLevel);
+
+  // The options and the files written with them: {filename: {options}}
+  py::dict GetRootFileOptions();
+
+  // Background writer of the thread (created the first time)
+  GateDigiAsyncWriter *GetAsyncWriter();
+
+  // Wait until all the rows of the thread are written by the writer
+  void FlushAsyncWriter();
+
+  // Maximum number of batches waiting in the queue of a writer
+  static constexpr size_t fAsyncWriterQueueDepth = 4;
+
 protected:
   GateDigiCollectionsRootManager();
 
   static GateDigiCollectionsRootManager *fInstance;
 
+  // True for the master in MT when the workers write their own files
+  bool IsMasterWithoutOutput() const;
+
+  bool fNtupleMergingFlag;
+
+  int fBasketSize;
+  int fBasketEntries;
+  int fCompressionLevel;
+  std::set<std::string> fRootFilenames;
+  std::mutex fRootFilenamesMutex;
+
   struct threadLocal_t {
     // std::map<std::string, int> fTupleNameIdMap;
     //  This is required to manage the Write process :
@@ -58,6 +111,7 @@ protected:
     std::map<int, bool> fTupleShouldBeWritten;
     bool fFileHasBeenWrittenByWorker;
     bool fFileHasBeenWrittenByMaster;
+    GateDigiAsyncWriter *fAsyncWriter = nullptr;
   };
   G4Cache<threadLocal_t> threadLocalData;
 
@@ -0,0 +1,263 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigiColumnarWriter.h"
+#include "../GateProgressMonitor.h"
+#include "GateDigiCollection.h"
+#include <algorithm>
+
+std::mutex GateDigiColumnarWriter::fMutex;
+
+std::map<std::string, std::vector<GateDigiColumnarWriter *>>
+    GateDigiColumnarWriter::fWritersOfManifest;
+
+namespace {
+
+template <class T> void AppendRaw(std::string &data, const T &v) {
+  data.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+void AppendString(std::string &data, std::vector<std::int32_t> &offsets,
+                  const std::string &s) {
+  data.append(s);
+  offsets.push_back(static_cast<std::int32_t>(data.size()));
+}
+
+std::string ArrowType(char type) {
+  switch (type) {
+  case 'D':
+  case '3':
+    return "float64";
+  case 'I':
+    return "int32";
+  default:
+    return "utf8";
+  }
+}
+
+// the names are written as JSON strings
+std::string Quote(const std::string &s) {
+  std::string q = "\"";
+  for (auto c : s) {
+    if (c == '"' || c == '\\')
+      q += '\\';
+    q += c;
+  }
+  return q + "\"";
+}
+
+std::string BaseName(const std::string &path) {
+  auto p = path.find_last_of("/\\");
+  return p == std::string::npos ? path : path.substr(p + 1);
+}
+
+} // namespace
+
+GateDigiColumnarWriter::GateDigiColumnarWriter(std::string filename,
+                                               GateDigiCollection *hc)
+    : fFilename(std::move(filename)), fCollection(hc),
+      fCollectionName(fCollection->GetName()) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fWritersOfManifest[fFilename].push_back(this);
+}
+
+GateDigiColumnarWriter::~GateDigiColumnarWriter() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto &writers = fWritersOfManifest[fFilename];
+  writers.erase(std::remove(writers.begin(), writers.end(), this),
+                writers.end());
+  if (writers.empty())
+    fWritersOfManifest.erase(fFilename);
+}
+
+bool GateDigiColumnarWriter::IsColumnarFilename(const std::string &filename) {
+  const std::string ext = ".json";
+  return filename.size() > ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void GateDigiColumnarWriter::OpenThreadFile() {
+  auto &l = threadLocalData.Get();
+  const auto thread = std::max(0, G4Threading::G4GetThreadId());
+  const auto stem = fFilename.substr(0, fFilename.size() - 5);
+  std::ostringstream oss;
+  oss << stem << "." << fCollectionName << ".t" << thread << ".bin";
+  l.fFile.fFilename = oss.str();
+  l.fFile.fThread = thread;
+  l.fFile.fChunks.clear();
+  l.fStream = new std::ofstream(l.fFile.fFilename, std::ios::binary);
+  if (!l.fStream->is_open()) {
+    std::ostringstream err;
+    err << "Error, cannot open the file '" << l.fFile.fFilename
+        << "' for the collection '" << fCollectionName << "'";
+    Fatal(err.str());
+  }
+  l.fOffset = 0;
+  l.fRows = 0;
+  l.fColumns.clear();
+  l.fColumns.resize(fCollection->GetDigiAttributes().size());
+  for (size_t i = 0; i < l.fColumns.size(); i++) {
+    auto type = fCollection->GetDigiAttributes()[i]->GetDigiAttributeType();
+    if (type == 'S' || type == 'U')
+      l.fColumns[i].fOffsets.push_back(0);
+  }
+}
+
+void GateDigiColumnarWriter::Fill() {
+  auto &l = threadLocalData.Get();
+  if (l.fStream == nullptr)
+    OpenThreadFile();
+  AppendValues();
+  if (l.fRows >= fChunkSize)
+    WriteChunk();
+}
+
+void GateDigiColumnarWriter::AppendValues() {
+  auto &l = threadLocalData.Get();
+  const auto n = fCollection->GetSize();
+  const auto &attributes = fCollection->GetDigiAttributes();
+  for (size_t i = 0; i < attributes.size(); i++) {
+    auto *att = attributes[i];
+    auto &c = l.fColumns[i];
+    switch (att->GetDigiAttributeType()) {
+    case 'D': {
+      const auto &v = att->GetDValues();
+      c.fData.append(reinterpret_cast<const char *>(v.data()),
+                     v.size() * sizeof(double));
+      break;
+    }
+    case 'I': {
+      for (auto v : att->GetIValues())
+        AppendRaw(c.fData, static_cast<std::int32_t>(v));
+      break;
+    }
+    case '3': {
+      for (const auto &v : att->Get3Values()) {
+        AppendRaw(c.fData, v.x());
+        AppendRaw(c.fData, v.y());
+        AppendRaw(c.fData, v.z());
+      }
+      break;
+    }
+    case 'S': {
+      for (const auto &v : att->GetSValues())
+        AppendString(c.fData, c.fOffsets, v);
+      break;
+    }
+    case 'U': {
+      for (const auto &v : att->GetUValues())
+        AppendString(c.fData, c.fOffsets, v->GetID());
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  l.fRows += n;
+}
+
+void GateDigiColumnarWriter::WriteBuffer(const char *data, size_t length,
+                                         Chunk &chunk) {
+  auto &l = threadLocalData.Get();
+  l.fStream->write(data, static_cast<std::streamsize>(length));
+  chunk.fBuffers.emplace_back(l.fOffset, length);
+  l.fOffset += length;
+  GateProgressMonitor::CountOutputBytes(length);
+}
+
+void GateDigiColumnarWriter::WriteChunk() {
+  auto &l = threadLocalData.Get();
+  Chunk chunk;
+  chunk.fRows = l.fRows;
+  for (auto &c : l.fColumns) {
+    // (utf8: the offsets then the characters)
+    if (!c.fOffsets.empty()) {
+      WriteBuffer(reinterpret_cast<const char *>(c.fOffsets.data()),
+                  c.fOffsets.size() * sizeof(std::int32_t), chunk);
+      c.fOffsets.clear();
+      c.fOffsets.push_back(0);
+    }
+    WriteBuffer(c.fData.data(), c.fData.size(), chunk);
+    // (the capacity is kept for the next chunk)
+    c.fData.clear();
+  }
+  l.fFile.fChunks.push_back(chunk);
+  l.fRows = 0;
+}
+
+void GateDigiColumnarWriter::Write() {
+  auto &l = threadLocalData.Get();
+  if (l.fStream != nullptr) {
+    if (l.fRows > 0)
+      WriteChunk();
+    l.fStream->close();
+    delete l.fStream;
+    l.fStream = nullptr;
+    std::lock_guard<std::mutex> lock(fMutex);
+    fFiles.push_back(l.fFile);
+  }
+  if (!G4Threading::IsMasterThread())
+    return;
+  // the master writes the manifest, with the files of all the threads
+  std::lock_guard<std::mutex> lock(fMutex);
+  fColumnTypes.clear();
+  for (auto *att : fCollection->GetDigiAttributes())
+    fColumnTypes.emplace_back(att->GetDigiAttributeName(),
+                              att->GetDigiAttributeType());
+  std::sort(fFiles.begin(), fFiles.end(), [](const File &a, const File &b) {
+    return a.fThread < b.fThread;
+  });
+  WriteManifest();
+}
+
+void GateDigiColumnarWriter::WriteManifest() {
+  std::ofstream os(fFilename);
+  if (!os.is_open()) {
+    std::ostringstream oss;
+    oss << "Error, cannot write the manifest '" << fFilename << "'";
+    Fatal(oss.str());
+  }
+  os << "{\n  \"format\": \"opengate-columnar\",\n  \"version\": 1,\n"
+     << "  \"chunk_size\": " << fChunkSize << ",\n  \"collections\": {";
+  const auto &writers = fWritersOfManifest[fFilename];
+  for (size_t w = 0; w < writers.size(); w++) {
+    os << (w == 0 ? "\n" : ",\n");
+    writers[w]->WriteCollectionDescription(os);
+  }
+  os << "\n  }\n}\n";
+}
+
+void GateDigiColumnarWriter::WriteCollectionDescription(
+    std::ostream &os) const {
+  os << "    " << Quote(fCollectionName) << ": {\n      \"columns\": [";
+  for (size_t i = 0; i < fColumnTypes.size(); i++) {
+    const auto &c = fColumnTypes[i];
+    os << (i == 0 ? "\n" : ",\n") << "        {\"name\": " << Quote(c.first)
+       << ", \"type\": \"" << ArrowType(c.second) << "\"";
+    if (c.second == '3')
+      os << ", \"list_size\": 3";
+    os << "}";
+  }
+  os << "\n      ],\n      \"files\": [";
+  for (size_t f = 0; f < fFiles.size(); f++) {
+    const auto &file = fFiles[f];
+    os << (f == 0 ? "\n" : ",\n") << "        {\"filename\": "
+       << Quote(BaseName(file.fFilename)) << ", \"thread\": " << file.fThread
+       << ", \"chunks\": [";
+    for (size_t k = 0; k < file.fChunks.size(); k++) {
+      const auto &chunk = file.fChunks[k];
+      os << (k == 0 ? "" : ", ") << "{\"rows\": " << chunk.fRows
+         << ", \"buffers\": [";
+      for (size_t b = 0; b < chunk.fBuffers.size(); b++)
+        os << (b == 0 ? "" : ", ") << "[" << chunk.fBuffers[b].first << ", "
+           << chunk.fBuffers[b].second << "]";
+      os << "]}";
+    }
+    os << "]}";
+  }
+  os << "\n      ]\n    }";
+}
@@ -0,0 +1,104 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigiColumnarWriter_h
+#define GateDigiColumnarWriter_h
+
+#include "../GateHelpers.h"
+#include "GateVDigiCollectionWriter.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+/*
+ * Columnar output of a digi collection (filename with the .json extension):
+ * no merge of the threads, each thread writes its own binary file, and the
+ * master writes the JSON manifest that describes all the files.
+ *
+ * The values are appended in columns and written by chunks of fChunkSize
+ * rows. The buffers of the columns have the Arrow layout, so that they can
+ * be read without conversion (see read_columnar_output in digitizers.py):
+ * - D: float64, I: int32
+ * - 3: fixed size list of 3 float64 (x y z for each digi)
+ * - S and U (the volume ID string): utf8, i.e. int32 offsets (rows + 1)
+ *   then the characters
+ *
+ * Several collections can have the same filename: they are all described
+ * by the same manifest. Files: <name>.json and <name>.<collection>.t<N>.bin
+ */
+
+class GateDigiColumnarWriter : public GateVDigiCollectionWriter {
+public:
+  GateDigiColumnarWriter(std::string filename, GateDigiCollection *hc);
+
+  ~GateDigiColumnarWriter() override;
+
+  static bool IsColumnarFilename(const std::string &filename);
+
+  void Fill() override;
+
+  void Write() override;
+
+  // Number of rows of the chunks (row groups)
+  static constexpr size_t fChunkSize = 1 << 16;
+
+protected:
+  struct Column {
+    std::string fData;
+    std::vector<std::int32_t> fOffsets;
+  };
+
+  struct Chunk {
+    size_t fRows = 0;
+    // offset and length in the file of each buffer of each column
+    std::vector<std::pair<size_t, size_t>> fBuffers;
+  };
+
+  struct File {
+    std::string fFilename;
+    int fThread = 0;
+    std::vector<Chunk> fChunks;
+  };
+
+  struct threadLocal_t {
+    std::ofstream *fStream = nullptr;
+    File fFile;
+    std::vector<Column> fColumns;
+    size_t fRows = 0;
+    size_t fOffset = 0;
+  };
+  G4Cache<threadLocal_t> threadLocalData;
+
+  void OpenThreadFile();
+
+  void AppendValues();
+
+  void WriteChunk();
+
+  void WriteBuffer(const char *data, size_t length, Chunk &chunk);
+
+  // (lock held)
+  void WriteManifest();
+
+  void WriteCollectionDescription(std::ostream &os) const;
+
+  std::string fFilename;
+  GateDigiCollection *fCollection;
+  std::string fCollectionName;
+  // name and type of the columns
+  std::vector<std::pair<std::string, char>> fColumnTypes;
+  // files of the threads that ended
+  std::vector<File> fFiles;
+
+  static std::mutex fMutex;
+  // all the writers of a manifest
+  static std::map<std::string, std::vector<GateDigiColumnarWriter *>>
+      fWritersOfManifest;
+};
+
+#endif // GateDigiColumnarWriter_h
@@ -0,0 +1,161 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigiEventBuffer.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Values of the input attribute, according to the type of the column
+template <class T> std::vector<T> &GetInputValues(GateVDigiAttribute *att);
+
+template <> std::vector<double> &GetInputValues(GateVDigiAttribute *att) {
+  return att->GetDValues();
+}
+
+template <>
+std::vector<G4ThreeVector> &GetInputValues(GateVDigiAttribute *att) {
+  return att->Get3Values();
+}
+
+template <>
+std::vector<GateUniqueVolumeID::Pointer> &
+GetInputValues(GateVDigiAttribute *att) {
+  return att->GetUValues();
+}
+
+} // namespace
+
+void GateDigiEventBuffer::Reset(GateDigiCollection *input, size_t begin,
+                                size_t end) {
+  fInput = input;
+  fInputIndex.resize(end - begin);
+  std::iota(fInputIndex.begin(), fInputIndex.end(), begin);
+  // (the values are kept to reuse the memory)
+  for (auto &c : fDColumns)
+    c.second.fIsSet = false;
+  for (auto &c : f3Columns)
+    c.second.fIsSet = false;
+  for (auto &c : fUColumns)
+    c.second.fIsSet = false;
+}
+
+std::vector<double> &GateDigiEventBuffer::GetDValues(const std::string &name) {
+  return GetColumnValues(fDColumns, name, 'D');
+}
+
+std::vector<G4ThreeVector> &
+GateDigiEventBuffer::Get3Values(const std::string &name) {
+  return GetColumnValues(f3Columns, name, '3');
+}
+
+std::vector<GateUniqueVolumeID::Pointer> &
+GateDigiEventBuffer::GetUValues(const std::string &name) {
+  return GetColumnValues(fUColumns, name, 'U');
+}
+
+template <class T>
+std::vector<T> &
+GateDigiEventBuffer::GetColumnValues(std::map<std::string, Column<T>> &columns,
+                                     const std::string &name, char type) {
+  auto &c = columns[name];
+  if (c.fIsSet)
+    return c.fValues;
+  c.fIsSet = true;
+  c.fValues.resize(GetSize());
+  // attribute created by a module of the chain (e.g. TimeDifference)
+  if (!fInput->IsDigiAttributeExists(name)) {
+    std::fill(c.fValues.begin(), c.fValues.end(), T());
+    return c.fValues;
+  }
+  auto *att = fInput->GetDigiAttribute(name);
+  if (att->GetDigiAttributeType() != type) {
+    std::ostringstream oss;
+    oss << "Error in the fused digitizer chain: the attribute '" << name
+        << "' is of type " << att->GetDigiAttributeType() << " while "
+        << type << " is expected";
+    Fatal(oss.str());
+  }
+  const auto &values = GetInputValues<T>(att);
+  for (size_t i = 0; i < fInputIndex.size(); i++)
+    c.fValues[i] = values[fInputIndex[i]];
+  return c.fValues;
+}
+
+template <class T>
+void GateDigiEventBuffer::Gather(std::vector<T> &values, std::vector<T> &temp,
+                                 const std::vector<size_t> &indices) {
+  temp.resize(indices.size());
+  // (a digi is selected only once)
+  for (size_t k = 0; k < indices.size(); k++)
+    temp[k] = std::move(values[indices[k]]);
+  values.swap(temp);
+}
+
+void GateDigiEventBuffer::Select(const std::vector<size_t> &indices) {
+  Gather(fInputIndex, fTempIndex, indices);
+  for (auto &c : fDColumns) {
+    if (c.second.fIsSet)
+      Gather(c.second.fValues, c.second.fTemp, indices);
+  }
+  for (auto &c : f3Columns) {
+    if (c.second.fIsSet)
+      Gather(c.second.fValues, c.second.fTemp, indices);
+  }
+  for (auto &c : fUColumns) {
+    if (c.second.fIsSet)
+      Gather(c.second.fValues, c.second.fTemp, indices);
+  }
+}
+
+void GateDigiEventBuffer::InitializeOutput(GateDigiCollection *output) {
+  fOutputAttributes.clear();
+  for (auto *att : output->GetDigiAttributes()) {
+    OutputAttribute a{att, nullptr, nullptr, nullptr, nullptr};
+    const auto name = att->GetDigiAttributeName();
+    auto dit = fDColumns.find(name);
+    auto tit = f3Columns.find(name);
+    auto uit = fUColumns.find(name);
+    if (dit != fDColumns.end() && dit->second.fIsSet)
+      a.fDValues = &dit->second.fValues;
+    else if (tit != f3Columns.end() && tit->second.fIsSet)
+      a.f3Values = &tit->second.fValues;
+    else if (uit != fUColumns.end() && uit->second.fIsSet)
+      a.fUValues = &uit->second.fValues;
+    else
+      a.fInput = fInput->GetDigiAttribute(name);
+    fOutputAttributes.push_back(a);
+  }
+}
+
+void GateDigiEventBuffer::FillDigi(size_t i) {
+  // (all "Fill" calls are thread local)
+  for (const auto &a : fOutputAttributes) {
+    if (a.fDValues != nullptr)
+      a.fOutput->FillDValue((*a.fDValues)[i]);
+    else if (a.f3Values != nullptr)
+      a.fOutput->Fill3Value((*a.f3Values)[i]);
+    else if (a.fUValues != nullptr)
+      a.fOutput->FillUValue((*a.fUValues)[i]);
+    else
+      a.fOutput->Fill(a.fInput, fInputIndex[i]);
+  }
+}
+
+void GateDigiEventBuffer::Fill(GateDigiCollection *output) {
+  InitializeOutput(output);
+  for (size_t i = 0; i < GetSize(); i++)
+    FillDigi(i);
+}
+
+void GateDigiEventBuffer::Fill(GateDigiCollection *output,
+                               const std::vector<size_t> &indices) {
+  InitializeOutput(output);
+  for (auto i : indices)
+    FillDigi(i);
+}
@@ -0,0 +1,118 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigiEventBuffer_h
+#define GateDigiEventBuffer_h
+
+#include "GateDigiCollection.h"
+#include <map>
+
+/*
+ * Digi of the current event in a fused digitizer chain (see
+ * GateDigitizerFusedChainActor). The modules of the chain process the digi in
+ * place: they read or modify the values of some attributes (the columns of
+ * the buffer), remove digi or keep one digi per group (Select).
+ *
+ * A column is only created when a module uses the attribute: the values are
+ * then copied from the input digi (zero if the input has no such attribute).
+ * The other attributes are never copied by the modules: the last module fills
+ * them in the output collection from the input digi (GetInputIndex).
+ *
+ * The buffer is thread local and reused for all the events: once the columns
+ * are created, there is no allocation anymore.
+ */
+
+class GateDigiEventBuffer {
+public:
+  // New event: the digi [begin, end) of the input collection
+  void Reset(GateDigiCollection *input, size_t begin, size_t end);
+
+  size_t GetSize() const { return fInputIndex.size(); }
+
+  // Index of the input digi of the digi i (for the attributes not in columns)
+  size_t GetInputIndex(size_t i) const { return fInputIndex[i]; }
+
+  // Values of the attribute for all the digi (the column is created the first
+  // time in the event)
+  std::vector<double> &GetDValues(const std::string &name);
+
+  std::vector<G4ThreeVector> &Get3Values(const std::string &name);
+
+  std::vector<GateUniqueVolumeID::Pointer> &GetUValues(const std::string &name);
+
+  // Keep only the given digi, in this order (indices in the buffer)
+  void Select(const std::vector<size_t> &indices);
+
+  // Append all the digi (or the given ones) to the output collection
+  void Fill(GateDigiCollection *output);
+
+  void Fill(GateDigiCollection *output, const std::vector<size_t> &indices);
+
+protected:
+  template <class T> struct Column {
+    bool fIsSet = false;
+    std::vector<T> fValues;
+    std::vector<T> fTemp;
+  };
+
+  template <class T>
+  std::vector<T> &GetColumnValues(std::map<std::string, Column<T>> &columns,
+                                  const std::string &name, char type);
+
+  template <class T>
+  static void Gather(std::vector<T> &values, std::vector<T> &temp,
+                     const std::vector<size_t> &indices);
+
+  // An attribute of the output collection, with its values: a column or the
+  // input attribute
+  struct OutputAttribute {
+    GateVDigiAttribute *fOutput;
+    GateVDigiAttribute *fInput;
+    const std::vector<double> *fDValues;
+    const std::vector<G4ThreeVector> *f3Values;
+    const std::vector<GateUniqueVolumeID::Pointer> *fUValues;
+  };
+
+  void InitializeOutput(GateDigiCollection *output);
+
+  void FillDigi(size_t i);
+
+  GateDigiCollection *fInput = nullptr;
+  std::vector<size_t> fInputIndex;
+  std::vector<size_t> fTempIndex;
+  std::map<std::string, Column<double>> fDColumns;
+  std::map<std::string, Column<G4ThreeVector>> f3Columns;
+  std::map<std::string, Column<GateUniqueVolumeID::Pointer>> fUColumns;
+  std::vector<OutputAttribute> fOutputAttributes;
+};
+
+/*
+ * Digitizer module that can be part of a fused chain: it processes the digi of
+ * the event in the buffer instead of its input collection. The last module of
+ * the chain fills its output collection(s) from the buffer.
+ */
+
+class GateVFusedDigitizerModule {
+public:
+  virtual ~GateVFusedDigitizerModule() = default;
+
+  // Process the digi of the event in place (thread local)
+  virtual void ProcessEventBuffer(GateDigiEventBuffer &buffer) = 0;
+
+  // Last module of the chain: fill the output from the buffer
+  virtual void FillOutputFromEventBuffer(GateDigiEventBuffer &buffer) = 0;
+
+  // Set by the chain when the module is added
+  void SetFusedFlag(bool b) { fFusedFlag = b; }
+
+  bool IsFusedModule() const { return fFusedFlag; }
+
+protected:
+  bool fFusedFlag = false;
+};
+
+#endif // GateDigiEventBuffer_h
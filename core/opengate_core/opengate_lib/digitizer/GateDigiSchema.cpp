@@ -0,0 +1,26 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigiSchema.h"
+
+std::unique_ptr<GateVDigiSchemaColumns>
+GateNewDigiSchemaColumns(GateDigiCollection *c,
+                         const std::set<std::string> &names) {
+  if (GateDigiHitsSchema::Matches(names))
+    return std::make_unique<GateDigiHitsSchema>("Hits", c);
+  if (GateDigiChainHitsSchema::Matches(names))
+    return std::make_unique<GateDigiChainHitsSchema>("ChainHits", c);
+  if (GateDigiPhaseSpaceSchema::Matches(names))
+    return std::make_unique<GateDigiPhaseSpaceSchema>("PhaseSpace", c);
+  return nullptr;
+}
+
+std::map<std::string, std::vector<std::string>> GateGetDigiSchemas() {
+  return {{"Hits", GateDigiHitsSchema::GetFieldNames()},
+          {"ChainHits", GateDigiChainHitsSchema::GetFieldNames()},
+          {"PhaseSpace", GateDigiPhaseSpaceSchema::GetFieldNames()}};
+}
@@ -0,0 +1,271 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigiSchema_h
+#define GateDigiSchema_h
+
+#include "../GateUniqueVolumeIDManager.h"
+#include "G4RootAnalysisManager.hh"
+#include "G4Step.hh"
+#include "GateDigiCollection.h"
+#include <memory>
+#include <set>
+#include <tuple>
+#include <utility>
+
+/*
+ * Compile-time digi schemas: the attributes of the common digi collections
+ * (PET/SPECT hits and singles, phase space) as a typed record.
+ *
+ * A field is an attribute of GateDigiAttributeList with its value type and
+ * the value of a step (same as its process hits function). A schema is a list
+ * of fields, GateTDigiSchemaColumns binds it to the values of a collection for
+ * the calling thread: filling a hit, copying a digi to another collection of
+ * the same schema or writing a digi to the root tuple are then unrolled at
+ * compile time, without the process hits functions or the virtual Fill of the
+ * attributes.
+ *
+ * A collection uses a schema only if its attributes are exactly the fields
+ * of the schema (in any order), see GateNewDigiSchemaColumns. The other
+ * collections use the generic attributes (fill plan of GateDigiCollection).
+ * The strings and the per-event attributes are not in the schemas.
+ */
+
+// Value type of the fields
+template <class T> struct GateDigiFieldType;
+
+template <> struct GateDigiFieldType<double> {
+  static constexpr char code = 'D';
+  static std::vector<double> &Values(GateVDigiAttribute *att) {
+    return att->GetDValues();
+  }
+  static void FillToRoot(G4RootAnalysisManager *ram, int tupleId, int id,
+                         const double &v) {
+    ram->FillNtupleDColumn(tupleId, id, v);
+  }
+};
+
+template <> struct GateDigiFieldType<int> {
+  static constexpr char code = 'I';
+  static std::vector<int> &Values(GateVDigiAttribute *att) {
+    return att->GetIValues();
+  }
+  static void FillToRoot(G4RootAnalysisManager *ram, int tupleId, int id,
+                         const int &v) {
+    ram->FillNtupleIColumn(tupleId, id, v);
+  }
+};
+
+template <> struct GateDigiFieldType<G4ThreeVector> {
+  static constexpr char code = '3';
+  static std::vector<G4ThreeVector> &Values(GateVDigiAttribute *att) {
+    return att->Get3Values();
+  }
+  static void FillToRoot(G4RootAnalysisManager *ram, int tupleId, int id,
+                         const G4ThreeVector &v) {
+    ram->FillNtupleDColumn(tupleId, id, v[0]);
+    ram->FillNtupleDColumn(tupleId, id + 1, v[1]);
+    ram->FillNtupleDColumn(tupleId, id + 2, v[2]);
+  }
+};
+
+template <> struct GateDigiFieldType<GateUniqueVolumeID::Pointer> {
+  static constexpr char code = 'U';
+  static std::vector<GateUniqueVolumeID::Pointer> &
+  Values(GateVDigiAttribute *att) {
+    return att->GetUValues();
+  }
+  static void FillToRoot(G4RootAnalysisManager *ram, int tupleId, int id,
+                         const GateUniqueVolumeID::Pointer &v) {
+    ram->FillNtupleSColumn(tupleId, id, v->GetID());
+  }
+};
+
+// Fields: the same values as the process hits functions of
+// GateDigiAttributeList
+namespace GateDigiFields {
+
+#define GATE_DIGI_FIELD(NAME, TYPE, VALUE)                                     \
+  struct NAME {                                                                \
+    typedef TYPE type;                                                         \
+    static constexpr const char *name = #NAME;                                 \
+    static type Get(const G4Step *step) { return VALUE; }                      \
+  }
+
+GATE_DIGI_FIELD(TotalEnergyDeposit, double, step->GetTotalEnergyDeposit());
+GATE_DIGI_FIELD(KineticEnergy, double,
+                step->GetPreStepPoint()->GetKineticEnergy());
+GATE_DIGI_FIELD(GlobalTime, double, step->GetPostStepPoint()->GetGlobalTime());
+GATE_DIGI_FIELD(Weight, double, step->GetTrack()->GetWeight());
+GATE_DIGI_FIELD(PDGCode, int,
+                step->GetTrack()->GetParticleDefinition()->GetPDGEncoding());
+GATE_DIGI_FIELD(Position, G4ThreeVector,
+                step->GetPostStepPoint()->GetPosition());
+GATE_DIGI_FIELD(PostPosition, G4ThreeVector,
+                step->GetPostStepPoint()->GetPosition());
+GATE_DIGI_FIELD(Direction, G4ThreeVector,
+                step->GetPostStepPoint()->GetMomentumDirection());
+GATE_DIGI_FIELD(PreStepUniqueVolumeID, GateUniqueVolumeID::Pointer,
+                GateUniqueVolumeIDManager::GetInstance()->GetVolumeID(
+                    step->GetPreStepPoint()->GetTouchable()));
+GATE_DIGI_FIELD(PostStepUniqueVolumeID, GateUniqueVolumeID::Pointer,
+                GateUniqueVolumeIDManager::GetInstance()->GetVolumeID(
+                    step->GetPostStepPoint()->GetTouchable()));
+
+#undef GATE_DIGI_FIELD
+
+} // namespace GateDigiFields
+
+// Columns of a schema bound to a collection (values of one thread)
+class GateVDigiSchemaColumns {
+public:
+  virtual ~GateVDigiSchemaColumns() = default;
+
+  virtual std::string GetSchemaName() const = 0;
+
+  // Append the values of the step (one digi)
+  virtual void FillHits(const G4Step *step) = 0;
+
+  // Append the digi of this collection to the output, of the same schema
+  virtual void CopyTo(size_t index, GateVDigiSchemaColumns *output) const = 0;
+
+  // Fill the columns of the digi in the root tuple (the row is not added)
+  virtual void FillToRoot(G4RootAnalysisManager *ram, int tupleId,
+                          size_t index) const = 0;
+};
+
+template <class... Fields>
+class GateTDigiSchemaColumns : public GateVDigiSchemaColumns {
+public:
+  typedef std::tuple<typename Fields::type...> Record;
+
+  static constexpr size_t NumberOfFields = sizeof...(Fields);
+
+  static std::vector<std::string> GetFieldNames() { return {Fields::name...}; }
+
+  // The attributes are exactly the fields of the schema
+  static bool Matches(const std::set<std::string> &names) {
+    return names.size() == NumberOfFields &&
+           (... && (names.count(Fields::name) == 1));
+  }
+
+  GateTDigiSchemaColumns(const std::string &name, GateDigiCollection *c)
+      : fName(name) {
+    Bind(c, std::index_sequence_for<Fields...>());
+  }
+
+  std::string GetSchemaName() const override { return fName; }
+
+  static Record FromStep(const G4Step *step) {
+    return Record(Fields::Get(step)...);
+  }
+
+  Record Get(size_t index) const {
+    return Get(index, std::index_sequence_for<Fields...>());
+  }
+
+  void Append(const Record &r) {
+    Append(r, std::index_sequence_for<Fields...>());
+  }
+
+  void FillHits(const G4Step *step) override {
+    FillHits(step, std::index_sequence_for<Fields...>());
+  }
+
+  void CopyTo(size_t index, GateVDigiSchemaColumns *output) const override {
+    // (same schema, see GateDigiAttributesFiller)
+    auto *o = static_cast<GateTDigiSchemaColumns *>(output);
+    CopyTo(index, o, std::index_sequence_for<Fields...>());
+  }
+
+  void FillToRoot(G4RootAnalysisManager *ram, int tupleId,
+                  size_t index) const override {
+    FillToRoot(ram, tupleId, index, std::index_sequence_for<Fields...>());
+  }
+
+protected:
+  template <size_t... I>
+  void Bind(GateDigiCollection *c, std::index_sequence<I...>) {
+    (BindField<I, Fields>(c), ...);
+  }
+
+  template <size_t I, class F> void BindField(GateDigiCollection *c) {
+    typedef GateDigiFieldType<typename F::type> FieldType;
+    auto *att = c->GetDigiAttribute(F::name);
+    if (att->GetDigiAttributeType() != FieldType::code) {
+      std::ostringstream oss;
+      oss << "Error in the digi schema " << fName << ": the attribute '"
+          << F::name << "' is of type " << att->GetDigiAttributeType();
+      Fatal(oss.str());
+    }
+    std::get<I>(fValues) = &FieldType::Values(att);
+    fAttributeIds[I] = att->GetDigiAttributeId();
+  }
+
+  template <size_t... I>
+  Record Get(size_t index, std::index_sequence<I...>) const {
+    return Record((*std::get<I>(fValues))[index]...);
+  }
+
+  template <size_t... I>
+  void Append(const Record &r, std::index_sequence<I...>) {
+    (std::get<I>(fValues)->push_back(std::get<I>(r)), ...);
+  }
+
+  template <size_t... I>
+  void FillHits(const G4Step *step, std::index_sequence<I...>) {
+    (std::get<I>(fValues)->push_back(Fields::Get(step)), ...);
+  }
+
+  template <size_t... I>
+  void CopyTo(size_t index, GateTDigiSchemaColumns *o,
+              std::index_sequence<I...>) const {
+    (std::get<I>(o->fValues)->push_back((*std::get<I>(fValues))[index]), ...);
+  }
+
+  template <size_t... I>
+  void FillToRoot(G4RootAnalysisManager *ram, int tupleId, size_t index,
+                  std::index_sequence<I...>) const {
+    (GateDigiFieldType<typename Fields::type>::FillToRoot(
+         ram, tupleId, fAttributeIds[I], (*std::get<I>(fValues))[index]),
+     ...);
+  }
+
+  std::string fName;
+  // values of the thread (never moved, see GateDigiCollection::GetFillPlan)
+  std::tuple<std::vector<typename Fields::type> *...> fValues;
+  int fAttributeIds[NumberOfFields] = {};
+};
+
+// Built-in schemas
+typedef GateTDigiSchemaColumns<
+    GateDigiFields::PostPosition, GateDigiFields::TotalEnergyDeposit,
+    GateDigiFields::PreStepUniqueVolumeID, GateDigiFields::GlobalTime>
+    GateDigiHitsSchema;
+
+typedef GateTDigiSchemaColumns<
+    GateDigiFields::PostPosition, GateDigiFields::TotalEnergyDeposit,
+    GateDigiFields::PreStepUniqueVolumeID,
+    GateDigiFields::PostStepUniqueVolumeID, GateDigiFields::GlobalTime>
+    GateDigiChainHitsSchema;
+
+typedef GateTDigiSchemaColumns<
+    GateDigiFields::Position, GateDigiFields::Direction,
+    GateDigiFields::KineticEnergy, GateDigiFields::Weight,
+    GateDigiFields::PDGCode>
+    GateDigiPhaseSpaceSchema;
+
+// Columns of the built-in schema of these attributes of the collection,
+// bound for the calling thread (nullptr if no schema matches)
+std::unique_ptr<GateVDigiSchemaColumns>
+GateNewDigiSchemaColumns(GateDigiCollection *c,
+                         const std::set<std::string> &names);
+
+// Names of the built-in schemas, with their attributes
+std::map<std::string, std::vector<std::string>> GateGetDigiSchemas();
+
+#endif // GateDigiSchema_h
@@ -105,63 +105,201 @@ void GateDigitizerAdderActor::DigitInitialize(
     fOutputNumberOfHitsAttribute =
         fOutputDigiCollection->GetDigiAttribute("NumberOfHits");
 
-  // set input pointers to the attributes needed for computation
+  // bind the input columns needed for computation
   auto &lr = fThreadLocalVDigitizerData.Get();
   lr.fInputIter = fInputDigiCollection->NewIterator();
-  lr.fInputIter.TrackAttribute("TotalEnergyDeposit", &l.edep);
-  lr.fInputIter.TrackAttribute("PostPosition", &l.pos);
-  lr.fInputIter.TrackAttribute("PreStepUniqueVolumeID", &l.volID);
-  lr.fInputIter.TrackAttribute("GlobalTime", &l.time);
+  lr.fInputIter.BindColumn("TotalEnergyDeposit", l.fEdep);
+  lr.fInputIter.BindColumn("PostPosition", l.fPos);
+  lr.fInputIter.BindColumn("PreStepUniqueVolumeID", l.fVolID);
+  lr.fInputIter.BindColumn("GlobalTime", l.fTime);
 }
 
 void GateDigitizerAdderActor::EndOfEventAction(const G4Event * /*unused*/) {
-  // loop on all hits to group per volume ID
+  // loop on all hits of the event to group per volume ID
+  auto &l = fThreadLocalData.Get();
   auto &lr = fThreadLocalVDigitizerData.Get();
-  auto &iter = lr.fInputIter;
-  iter.GoToBegin();
-  while (!iter.IsAtEnd()) {
-    AddDigiPerVolume();
-    iter++;
-  }
+  const auto &iter = lr.fInputIter;
+  const auto begin = iter.GetEventBeginIndex();
+  const auto edep = iter.GetEventSpan(l.fEdep);
+  const auto pos = iter.GetEventSpan(l.fPos);
+  const auto volID = iter.GetEventSpan(l.fVolID);
+  const auto time = iter.GetEventSpan(l.fTime);
+  ReduceDigiPerVolume(begin, edep.size(), edep.begin(), pos.begin(),
+                      volID.begin(), time.begin());
 
   // create the output hits collection for grouped hits
+  for (size_t n = 0; n < l.fNumberOfAdders; n++) {
+    auto &hit = l.fAdders[n];
+    if (!TerminateDigi(hit))
+      continue;
+    // (all "Fill" calls are thread local)
+    fOutputEdepAttribute->FillDValue(hit.fFinalEdep);
+    fOutputPosAttribute->Fill3Value(hit.fFinalPosition);
+    fOutputGlobalTimeAttribute->FillDValue(hit.fFinalTime);
+    if (fTimeDifferenceFlag)
+      fOutputTimeDifferenceAttribute->FillDValue(hit.fDifferenceTime);
+    if (fNumberOfHitsFlag)
+      fOutputNumberOfHitsAttribute->FillDValue(hit.fNumberOfHits);
+    lr.fDigiAttributeFiller->Fill(hit.fFinalIndex);
+  }
+
+  // reset the structure of hits (the adders are kept for the next event)
+  l.fMapOfDigiInVolume.clear();
+  l.fNumberOfAdders = 0;
+}
+
+void GateDigitizerAdderActor::ProcessEventBuffer(GateDigiEventBuffer &buffer) {
+  // group per volume ID (the index of the digi is the one in the buffer)
   auto &l = fThreadLocalData.Get();
-  for (auto &h : l.fMapOfDigiInVolume) {
-    auto &hit = h.second;
-    // terminate the merge
-    hit->Terminate();
-    // Don't store anything if edep is zero
-    if (hit->fFinalEdep > 0) {
-      // (all "Fill" calls are thread local)
-      fOutputEdepAttribute->FillDValue(hit->fFinalEdep);
-      fOutputPosAttribute->Fill3Value(hit->fFinalPosition);
-      fOutputGlobalTimeAttribute->FillDValue(hit->fFinalTime);
-      if (fTimeDifferenceFlag)
-        fOutputTimeDifferenceAttribute->FillDValue(hit->fDifferenceTime);
-      if (fNumberOfHitsFlag)
-        fOutputNumberOfHitsAttribute->FillDValue(hit->fNumberOfHits);
-      lr.fDigiAttributeFiller->Fill(hit->fFinalIndex);
-    }
+  {
+    const auto &edep = buffer.GetDValues("TotalEnergyDeposit");
+    const auto &pos = buffer.Get3Values("PostPosition");
+    const auto &volID = buffer.GetUValues("PreStepUniqueVolumeID");
+    const auto &time = buffer.GetDValues("GlobalTime");
+    ReduceDigiPerVolume(0, buffer.GetSize(), edep.data(), pos.data(),
+                        volID.data(), time.data());
+  }
+
+  // keep one digi per volume: the other attributes are the ones of the final
+  // digi of each volume
+  l.fStoredAdders.clear();
+  l.fStoredIndices.clear();
+  for (size_t n = 0; n < l.fNumberOfAdders; n++) {
+    if (!TerminateDigi(l.fAdders[n]))
+      continue;
+    l.fStoredAdders.push_back(n);
+    l.fStoredIndices.push_back(l.fAdders[n].fFinalIndex);
   }
+  buffer.Select(l.fStoredIndices);
 
-  // reset the structure of hits
+  // set the values computed by the adders
+  auto &edep = buffer.GetDValues("TotalEnergyDeposit");
+  auto &pos = buffer.Get3Values("PostPosition");
+  auto &time = buffer.GetDValues("GlobalTime");
+  for (size_t k = 0; k < l.fStoredAdders.size(); k++) {
+    const auto &hit = l.fAdders[l.fStoredAdders[k]];
+    edep[k] = hit.fFinalEdep;
+    pos[k] = hit.fFinalPosition;
+    time[k] = hit.fFinalTime;
+  }
+  if (fTimeDifferenceFlag) {
+    auto &td = buffer.GetDValues("TimeDifference");
+    for (size_t k = 0; k < l.fStoredAdders.size(); k++)
+      td[k] = l.fAdders[l.fStoredAdders[k]].fDifferenceTime;
+  }
+  if (fNumberOfHitsFlag) {
+    auto &nh = buffer.GetDValues("NumberOfHits");
+    for (size_t k = 0; k < l.fStoredAdders.size(); k++)
+      nh[k] = l.fAdders[l.fStoredAdders[k]].fNumberOfHits;
+  }
+
+  // reset the structure of hits (the adders are kept for the next event)
   l.fMapOfDigiInVolume.clear();
+  l.fNumberOfAdders = 0;
+}
+
+bool GateDigitizerAdderActor::TerminateDigi(GateDigiAdderInVolume &adder) {
+  // terminate the merge, don't store anything if edep is zero
+  adder.Terminate();
+  return adder.fFinalEdep > 0;
 }
 
-void GateDigitizerAdderActor::AddDigiPerVolume() {
+size_t GateDigitizerAdderActor::VolumeKeyHash::operator()(
+    const VolumeKey &key) const {
+  auto h = std::hash<const void *>()(key.fVolume);
+  for (auto id : key.fArrayID) {
+    if (id == -1)
+      break;
+    h ^= std::hash<int>()(id) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  }
+  return h;
+}
+
+GateDigitizerAdderActor::VolumeKey
+GateDigitizerAdderActor::GetVolumeKey(const GateUniqueVolumeID &uid) const {
+  // same grouping as GateUniqueVolumeID::GetIdUpToDepth: the volume at the
+  // depth and the copy numbers up to this depth (all of them if -1)
+  VolumeKey key{nullptr, uid.fArrayID};
+  const auto &depths = uid.GetVolumeDepthID();
+  if (fGroupVolumeDepth == -1) {
+    if (!depths.empty())
+      key.fVolume = depths.back().fVolume;
+    return key;
+  }
+  key.fVolume = depths[fGroupVolumeDepth].fVolume;
+  for (size_t i = fGroupVolumeDepth + 1; i < key.fArrayID.size(); i++)
+    key.fArrayID[i] = -1;
+  return key;
+}
+
+size_t GateDigitizerAdderActor::GetAdderIndex(const GateUniqueVolumeID &uid) {
   auto &l = fThreadLocalData.Get();
-  auto &lr = fThreadLocalVDigitizerData.Get();
-  const auto &i = lr.fInputIter.fIndex;
-  if (*l.edep == 0)
-    return;
   // uid and fGroupVolumeDepth are only used for repeated volume (such as in
   // PET)
-  auto uid = l.volID->get()->GetIdUpToDepth(fGroupVolumeDepth);
-  if (l.fMapOfDigiInVolume.count(uid) == 0) {
-    // l.fMapOfDigiInVolume[uid] =
-    // std::make_shared<GateDigiAdderInVolume>(fPolicy, fTimeDifferenceFlag);
-    l.fMapOfDigiInVolume[uid] = new GateDigiAdderInVolume(
-        fPolicy, fTimeDifferenceFlag, fNumberOfHitsFlag);
+  auto key = GetVolumeKey(uid);
+  auto it = l.fMapOfDigiInVolume.find(key);
+  if (it == l.fMapOfDigiInVolume.end()) {
+    // take the next adder of the pool, reset for this volume
+    GateDigiAdderInVolume adder(fPolicy, fTimeDifferenceFlag,
+                                fNumberOfHitsFlag);
+    if (l.fNumberOfAdders < l.fAdders.size())
+      l.fAdders[l.fNumberOfAdders] = adder;
+    else
+      l.fAdders.push_back(adder);
+    it = l.fMapOfDigiInVolume.emplace(key, l.fNumberOfAdders).first;
+    l.fNumberOfAdders++;
+  }
+  return it->second;
+}
+
+void GateDigitizerAdderActor::ReduceDigiPerVolume(
+    size_t begin, size_t n, const double *edep, const G4ThreeVector *pos,
+    const GateUniqueVolumeID::Pointer *volID, const double *time) {
+  auto &l = fThreadLocalData.Get();
+
+  // adder of each digi (the digi without deposited energy are ignored)
+  l.fDigiAdders.clear();
+  l.fDigiIndices.clear();
+  for (size_t k = 0; k < n; k++) {
+    if (edep[k] == 0)
+      continue;
+    l.fDigiAdders.push_back(GetAdderIndex(*volID[k]));
+    l.fDigiIndices.push_back(k);
+  }
+
+  // segment of each adder: counting sort, stable so that the digi of a
+  // volume stay in their order
+  const auto nb = l.fNumberOfAdders;
+  l.fSegmentOffsets.assign(nb + 1, 0);
+  for (auto a : l.fDigiAdders)
+    l.fSegmentOffsets[a + 1]++;
+  for (size_t a = 0; a < nb; a++)
+    l.fSegmentOffsets[a + 1] += l.fSegmentOffsets[a];
+  l.fSegmentCursors.assign(l.fSegmentOffsets.begin(),
+                           l.fSegmentOffsets.end() - 1);
+  const auto m = l.fDigiAdders.size();
+  l.fSortedIndex.resize(m);
+  l.fSortedEdep.resize(m);
+  l.fSortedX.resize(m);
+  l.fSortedY.resize(m);
+  l.fSortedZ.resize(m);
+  l.fSortedTime.resize(m);
+  for (size_t h = 0; h < m; h++) {
+    const auto k = l.fDigiIndices[h];
+    const auto p = l.fSegmentCursors[l.fDigiAdders[h]]++;
+    l.fSortedIndex[p] = begin + k;
+    l.fSortedEdep[p] = edep[k];
+    l.fSortedX[p] = pos[k].x();
+    l.fSortedY[p] = pos[k].y();
+    l.fSortedZ[p] = pos[k].z();
+    l.fSortedTime[p] = time[k];
+  }
+
+  // one reduction per segment
+  for (size_t a = 0; a < nb; a++) {
+    const auto o = l.fSegmentOffsets[a];
+    l.fAdders[a].Reduce(l.fSegmentOffsets[a + 1] - o, &l.fSortedIndex[o],
+                        &l.fSortedEdep[o], &l.fSortedX[o], &l.fSortedY[o],
+                        &l.fSortedZ[o], &l.fSortedTime[o]);
   }
-  l.fMapOfDigiInVolume[uid]->Update(i, *l.edep, *l.pos, *l.time);
 }
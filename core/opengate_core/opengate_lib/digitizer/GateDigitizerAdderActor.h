@@ -16,6 +16,7 @@
 #include "GateTDigiAttribute.h"
 #include "GateVDigitizerWithOutputActor.h"
 #include <pybind11/stl.h>
+#include <unordered_map>
 
 namespace py = pybind11;
 
@@ -34,6 +35,15 @@ namespace py = pybind11;
  *
  *  Warning: digi are gathered per Event, not per time.
  *
+ *  The digi of a volume are identified by the physical volume at the group
+ *  depth and the copy numbers up to this depth (no string), and the adders
+ *  are reused from one event to the next. The singles of an event are
+ *  created in the order of the first digi in each volume.
+ *
+ *  The digi of the event are first bucketed per volume, then the policy is
+ *  applied as a reduction over the contiguous edep/position/time columns of
+ *  each volume (see GateDigiAdderInVolume::Reduce).
+ *
  */
 
 class GateDigiAdderInVolume;
@@ -61,6 +71,9 @@ public:
   // Called every time an Event ends (all threads)
   void EndOfEventAction(const G4Event *event) override;
 
+  // Fused chain: one digi per volume in the buffer
+  void ProcessEventBuffer(GateDigiEventBuffer &buffer) override;
+
   void SetGroupVolumeDepth(int depth);
 
 protected:
@@ -78,17 +91,64 @@ protected:
   void DigitInitialize(
       const std::vector<std::string> &attributes_not_in_filler) override;
 
-  void AddDigiPerVolume();
+  // Index of the adder of the volume (a new one for the first digi of the
+  // volume in the event)
+  size_t GetAdderIndex(const GateUniqueVolumeID &uid);
+
+  // Group the digi of the event per volume (n digi, the index of the first
+  // one is begin): the digi are bucketed by adder (stable counting sort),
+  // then each adder reduces its contiguous segment
+  void ReduceDigiPerVolume(size_t begin, size_t n, const double *edep,
+                           const G4ThreeVector *pos,
+                           const GateUniqueVolumeID::Pointer *volID,
+                           const double *time);
+
+  // Terminate the merge of the digi of a volume, false if the digi must not
+  // be stored (e.g. zero energy)
+  virtual bool TerminateDigi(GateDigiAdderInVolume &adder);
+
+  // Volume of a digi at the group depth (see GateUniqueVolumeID)
+  struct VolumeKey {
+    const G4VPhysicalVolume *fVolume;
+    GateUniqueVolumeID::IDArrayType fArrayID;
+    bool operator==(const VolumeKey &other) const {
+      return fVolume == other.fVolume && fArrayID == other.fArrayID;
+    }
+  };
+
+  struct VolumeKeyHash {
+    size_t operator()(const VolumeKey &key) const;
+  };
+
+  VolumeKey GetVolumeKey(const GateUniqueVolumeID &uid) const;
 
   // During computation (thread local)
   struct threadLocalT {
-    // std::map<std::string, std::shared_ptr<GateDigiAdderInVolume>>
-    // fMapOfDigiInVolume;
-    std::map<std::string, GateDigiAdderInVolume *> fMapOfDigiInVolume;
-    double *edep;
-    G4ThreeVector *pos;
-    GateUniqueVolumeID::Pointer *volID;
-    double *time;
+    // index of the adder of each volume hit during the current event
+    std::unordered_map<VolumeKey, size_t, VolumeKeyHash> fMapOfDigiInVolume;
+    // pool of adders, the first fNumberOfAdders are used by the event
+    std::vector<GateDigiAdderInVolume> fAdders;
+    size_t fNumberOfAdders = 0;
+    // digi of the event with an edep: adder of each, then the segment of
+    // each adder and the columns sorted by segment
+    std::vector<size_t> fDigiAdders;
+    std::vector<size_t> fDigiIndices;
+    std::vector<size_t> fSegmentOffsets;
+    std::vector<size_t> fSegmentCursors;
+    std::vector<size_t> fSortedIndex;
+    std::vector<double> fSortedEdep;
+    std::vector<double> fSortedX;
+    std::vector<double> fSortedY;
+    std::vector<double> fSortedZ;
+    std::vector<double> fSortedTime;
+    // fused chain: the adders and the final digi that are stored
+    std::vector<size_t> fStoredAdders;
+    std::vector<size_t> fStoredIndices;
+    // input columns (values of the current event)
+    GateDigiCollection::Iterator::Column<double> fEdep;
+    GateDigiCollection::Iterator::Column<G4ThreeVector> fPos;
+    GateDigiCollection::Iterator::Column<GateUniqueVolumeID::Pointer> fVolID;
+    GateDigiCollection::Iterator::Column<double> fTime;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
@@ -10,12 +10,15 @@
 #include "GateDigiAdderInVolume.h"
 #include "GateDigiCollectionManager.h"
 #include <Randomize.hh>
+#include <algorithm>
 #include <iostream>
 
 GateDigitizerBlurringActor::GateDigitizerBlurringActor(py::dict &user_info)
     : GateVDigitizerWithOutputActor(user_info, true) {
   // actions
   fActions.insert("EndOfEventAction");
+  fBlurMapFlag = false;
+  fBlurMapVolumeDepth = -1;
 }
 
 GateDigitizerBlurringActor::~GateDigitizerBlurringActor() = default;
@@ -30,11 +33,35 @@ void GateDigitizerBlurringActor::InitializeUserInfo(py::dict &user_info) {
   fBlurResolution = DictGetDouble(user_info, "blur_resolution");
   fBlurSlope = DictGetDouble(user_info, "blur_slope");
   if (fBlurMethod == "Gaussian")
-    fBlurValue = [&](double v) { return this->GaussianBlur(v); };
-  if (fBlurMethod == "InverseSquare")
-    fBlurValue = [&](double v) { return this->InverseSquare(v); };
-  if (fBlurMethod == "Linear")
-    fBlurValue = [&](double v) { return this->Linear(v); };
+    fBlurMethodId = Gaussian;
+  else if (fBlurMethod == "InverseSquare")
+    fBlurMethodId = InverseSquare;
+  else if (fBlurMethod == "Linear")
+    fBlurMethodId = Linear;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerBlurringActor: unknown blur method. Must be "
+           "Gaussian, InverseSquare or Linear"
+        << " while '" << fBlurMethod << "' is read.";
+    Fatal(oss.str());
+  }
+
+  // parameter of the law per crystal
+  fBlurMapFlag = !user_info["blur_map"].is_none();
+  fBlurMap.clear();
+  if (fBlurMapFlag) {
+    fBlurMap = DictGetVecDouble(user_info, "blur_map");
+    if (fBlurMap.empty()) {
+      std::ostringstream oss;
+      oss << "Error in GateDigitizerBlurringActor '" << GetName()
+          << "': the blur map is empty";
+      Fatal(oss.str());
+    }
+  }
+}
+
+void GateDigitizerBlurringActor::SetBlurMapVolumeDepth(int depth) {
+  fBlurMapVolumeDepth = depth;
 }
 
 void GateDigitizerBlurringActor::DigitInitialize(
@@ -47,46 +74,141 @@ void GateDigitizerBlurringActor::DigitInitialize(
   fOutputBlurAttribute =
       fOutputDigiCollection->GetDigiAttribute(fBlurAttributeName);
 
-  // set input pointers to the attributes needed for computation
-  auto &l = fThreadLocalData.Get();
+  // the values of an event are read directly from the input column
   auto &lr = fThreadLocalVDigitizerData.Get();
-  lr.fInputIter.TrackAttribute(fBlurAttributeName, &l.fAttDValue);
+  lr.fInputIter.BindColumn(fBlurAttributeName, fThreadLocalData.Get().fInput);
+  if (fBlurMapFlag) {
+    CheckRequiredAttribute(fInputDigiCollection, "PreStepUniqueVolumeID");
+    lr.fInputIter.BindColumn("PreStepUniqueVolumeID",
+                             fThreadLocalData.Get().fVolID);
+  }
 }
 
 void GateDigitizerBlurringActor::EndOfEventAction(const G4Event * /*unused*/) {
-  // loop on all digi of this events
+  // all the digi of this event
   auto &l = fThreadLocalData.Get();
   auto &lr = fThreadLocalVDigitizerData.Get();
-  auto &iter = lr.fInputIter;
-  iter.GoToBegin();
-  while (!iter.IsAtEnd()) {
-    // blur the current value
-    auto v = fBlurValue(*l.fAttDValue);
-    fOutputBlurAttribute->FillDValue(v);
-    // copy the other attributes
-    auto &i = lr.fInputIter.fIndex;
-    lr.fDigiAttributeFiller->Fill(i);
-    iter++;
+  const auto begin = lr.fInputIter.GetEventBeginIndex();
+  const auto input = lr.fInputIter.GetEventSpan(l.fInput);
+  if (input.size() == 0)
+    return;
+
+  // blur the values in one pass
+  l.fValues.assign(input.begin(), input.end());
+  const GateUniqueVolumeID::Pointer *volID = nullptr;
+  if (fBlurMapFlag)
+    volID = lr.fInputIter.GetEventSpan(l.fVolID).begin();
+  BlurValues(l.fValues, volID);
+
+  // store the values and copy the other attributes
+  for (size_t k = 0; k < l.fValues.size(); k++) {
+    fOutputBlurAttribute->FillDValue(l.fValues[k]);
+    lr.fDigiAttributeFiller->Fill(begin + k);
   }
 }
 
-double GateDigitizerBlurringActor::GaussianBlur(double value) {
-  // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateLocalTimeResolution.cc
-  return G4RandGauss::shoot(value, fBlurSigma);
+void GateDigitizerBlurringActor::ProcessEventBuffer(
+    GateDigiEventBuffer &buffer) {
+  const GateUniqueVolumeID::Pointer *volID = nullptr;
+  if (fBlurMapFlag)
+    volID = buffer.GetUValues("PreStepUniqueVolumeID").data();
+  BlurValues(buffer.GetDValues(fBlurAttributeName), volID);
 }
 
-double GateDigitizerBlurringActor::InverseSquare(double value) {
-  // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateBlurring.cc
-  // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateInverseSquareBlurringLaw.cc
-  auto v = fBlurResolution * (sqrt(fBlurReferenceValue) / sqrt(value));
-  auto x = G4RandGauss::shoot(value, (v * value) * fwhm_to_sigma);
-  return x;
+size_t
+GateDigitizerBlurringActor::GetCrystal(const GateUniqueVolumeID &uid) const {
+  const auto &depths = uid.fVolumeDepthID;
+  const auto crystal = fBlurMapVolumeDepth == -1
+                           ? depths.back().fCopyNb
+                           : depths[fBlurMapVolumeDepth].fCopyNb;
+  if (crystal < 0 || static_cast<size_t>(crystal) >= fBlurMap.size()) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerBlurringActor '" << GetName()
+        << "': the crystal " << crystal << " of the volume " << uid.GetID()
+        << " is not in the blur map (" << fBlurMap.size() << " crystals)";
+    Fatal(oss.str());
+  }
+  return static_cast<size_t>(crystal);
 }
 
-double GateDigitizerBlurringActor::Linear(double value) {
-  // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateBlurring.cc
-  // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateLinearBlurringLaw.cc
-  auto v = fBlurSlope * (value - fBlurReferenceValue) + fBlurResolution;
-  auto x = G4RandGauss::shoot(value, (v * value) * fwhm_to_sigma);
-  return x;
+void GateDigitizerBlurringActor::BlurValues(
+    std::vector<double> &values, const GateUniqueVolumeID::Pointer *volID) {
+  auto &l = fThreadLocalData.Get();
+  const auto n = values.size();
+  if (n == 0)
+    return;
+  l.fSigmas.resize(n);
+  l.fGauss.resize(n);
+  // gather the parameter of the crystal of each value
+  const double *params = nullptr;
+  if (volID != nullptr) {
+    l.fParams.resize(n);
+    for (size_t i = 0; i < n; i++)
+      l.fParams[i] = fBlurMap[GetCrystal(*volID[i])];
+    params = l.fParams.data();
+  }
+  ComputeSigmas(values.data(), params, l.fSigmas.data(), n);
+  // (same numbers as G4RandGauss::shoot(value, sigma) for each value)
+  G4RandGauss::shootArray(static_cast<int>(n), l.fGauss.data());
+  const auto *g = l.fGauss.data();
+  const auto *sigmas = l.fSigmas.data();
+  auto *v = values.data();
+  for (size_t i = 0; i < n; i++)
+    v[i] = g[i] * sigmas[i] + v[i];
+}
+
+void GateDigitizerBlurringActor::ComputeSigmas(const double *values,
+                                               const double *params,
+                                               double *sigmas,
+                                               size_t n) const {
+  if (params != nullptr) {
+    // same laws, with the parameter of each value
+    const auto sqrt_ref = sqrt(fBlurReferenceValue);
+    switch (fBlurMethodId) {
+    case Gaussian:
+      std::copy(params, params + n, sigmas);
+      break;
+    case InverseSquare:
+      for (size_t i = 0; i < n; i++) {
+        const auto r = params[i] * (sqrt_ref / sqrt(values[i]));
+        sigmas[i] = (r * values[i]) * fwhm_to_sigma;
+      }
+      break;
+    case Linear:
+      for (size_t i = 0; i < n; i++) {
+        const auto r =
+            fBlurSlope * (values[i] - fBlurReferenceValue) + params[i];
+        sigmas[i] = (r * values[i]) * fwhm_to_sigma;
+      }
+      break;
+    }
+    return;
+  }
+  switch (fBlurMethodId) {
+  case Gaussian: {
+    // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateLocalTimeResolution.cc
+    std::fill(sigmas, sigmas + n, fBlurSigma);
+    break;
+  }
+  case InverseSquare: {
+    // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateBlurring.cc
+    // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateInverseSquareBlurringLaw.cc
+    const auto sqrt_ref = sqrt(fBlurReferenceValue);
+    for (size_t i = 0; i < n; i++) {
+      const auto r = fBlurResolution * (sqrt_ref / sqrt(values[i]));
+      sigmas[i] = (r * values[i]) * fwhm_to_sigma;
+    }
+    break;
+  }
+  case Linear: {
+    // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateBlurring.cc
+    // https://github.com/OpenGATE/Gate/blob/develop/source/digits_hits/src/GateLinearBlurringLaw.cc
+    for (size_t i = 0; i < n; i++) {
+      const auto r =
+          fBlurSlope * (values[i] - fBlurReferenceValue) + fBlurResolution;
+      sigmas[i] = (r * values[i]) * fwhm_to_sigma;
+    }
+    break;
+  }
+  }
 }
@@ -22,6 +22,18 @@ namespace py = pybind11;
 /*
  * Digitizer module for blurring an attribute (single value only, not a vector).
  * Usually for energy or time.
+ *
+ * All the values of an event are blurred in one pass: the sigma of the
+ * resolution law is computed for all the values (simple loops, vectorized
+ * by the compiler), then the Gaussian numbers are drawn in bulk. The random
+ * sequence is the same as with one G4RandGauss::shoot per value.
+ *
+ * With a blur map, the parameter of the law (sigma for Gaussian, resolution
+ * for InverseSquare and Linear) is given per crystal, in a dense table
+ * indexed by the copy number of the volume at fBlurMapVolumeDepth (the
+ * deepest volume if -1), e.g. the energy resolution or the time resolution
+ * of each crystal. The parameters of the event are gathered (one lookup per
+ * digi) before the same vectorized loops.
  */
 
 class GateDigitizerBlurringActor : public GateVDigitizerWithOutputActor {
@@ -38,6 +50,11 @@ public:
   // Called every time an Event ends (all threads)
   void EndOfEventAction(const G4Event *event) override;
 
+  // Fused chain: blur the values in the buffer
+  void ProcessEventBuffer(GateDigiEventBuffer &buffer) override;
+
+  void SetBlurMapVolumeDepth(int depth);
+
 protected:
   void DigitInitialize(
       const std::vector<std::string> &attributes_not_in_filler) override;
@@ -50,18 +67,37 @@ protected:
   double fBlurResolution;
   double fBlurSlope;
 
-  // This member store the function used to blur (Gaussian, InverseSquare etc)
-  std::function<double(double)> fBlurValue;
+  // The resolution law (Gaussian, InverseSquare or Linear)
+  enum BlurMethod { Gaussian, InverseSquare, Linear };
+  BlurMethod fBlurMethodId;
+
+  // parameter of the law per crystal
+  bool fBlurMapFlag;
+  std::vector<double> fBlurMap;
+  int fBlurMapVolumeDepth;
 
-  double GaussianBlur(double value);
+  // Index of the crystal of a digi in the blur map
+  size_t GetCrystal(const GateUniqueVolumeID &uid) const;
 
-  double InverseSquare(double value);
+  // Blur all the values (in place), with the volumes of the digi if there is
+  // a blur map
+  void BlurValues(std::vector<double> &values,
+                  const GateUniqueVolumeID::Pointer *volID);
 
-  double Linear(double value);
+  // Sigma of the blur of each value, according to the resolution law, with
+  // the parameter of each value (nullptr: the parameter of the actor)
+  void ComputeSigmas(const double *values, const double *params,
+                     double *sigmas, size_t n) const;
 
   // During computation (thread local)
   struct threadLocalT {
-    double *fAttDValue{};
+    // input values of the blurred attribute
+    GateDigiCollection::Iterator::Column<double> fInput;
+    GateDigiCollection::Iterator::Column<GateUniqueVolumeID::Pointer> fVolID;
+    std::vector<double> fValues;
+    std::vector<double> fParams;
+    std::vector<double> fSigmas;
+    std::vector<double> fGauss;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
@@ -0,0 +1,310 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigitizerCoincidenceSorterActor.h"
+#include "../GateHelpersDict.h"
+#include "G4SystemOfUnits.hh"
+#include "GateDigiAttributeManager.h"
+#include <algorithm>
+#include <fstream>
+
+GateDigitizerCoincidenceSorterActor::GateDigitizerCoincidenceSorterActor(
+    py::dict &user_info)
+    : GateVDigitizerTimeOrderedActor(user_info) {
+  fTimeWindow = 0;
+  fPolicy = MultiplesPolicy::KeepAll;
+  fNumberOfCoincidences = 0;
+  fKeepCoincidences = true;
+  fSinogramMode = SinogramMode::NoSinogram;
+  fRadialBins = 0;
+  fNumberOfRings = 0;
+  fCrystalsPerRing = 0;
+  fNumberOfSkippedLORs = 0;
+}
+
+void GateDigitizerCoincidenceSorterActor::InitializeUserInfo(
+    py::dict &user_info) {
+  GateVDigitizerTimeOrderedActor::InitializeUserInfo(user_info);
+  fTimeWindow = DictGetDouble(user_info, "window");
+  auto policy = DictGetStr(user_info, "policy");
+  if (policy == "keepAll")
+    fPolicy = MultiplesPolicy::KeepAll;
+  else if (policy == "removeMultiples")
+    fPolicy = MultiplesPolicy::RemoveMultiples;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerCoincidenceSorterActor: unknown policy. "
+           "Must be keepAll or removeMultiples"
+        << " while '" << policy << "' is read.";
+    Fatal(oss.str());
+  }
+  fKeepCoincidences = DictGetBool(user_info, "keep_coincidences");
+  fSinogramMode = SinogramMode::NoSinogram;
+  if (!user_info["sinogram"].is_none()) {
+    auto mode = DictGetStr(user_info, "sinogram");
+    fSinogramMode =
+        mode == "3D" ? SinogramMode::Sinogram3D : SinogramMode::Sinogram2D;
+  }
+  fRadialBins = DictGetInt(user_info, "radial_bins");
+  fTerminationTarget = DictGetInt(user_info, "termination_count");
+}
+
+void GateDigitizerCoincidenceSorterActor::SetListmodeFilename(
+    std::string filename) {
+  fListmodeFilename = std::move(filename);
+}
+
+void GateDigitizerCoincidenceSorterActor::SetCrystalIndex(
+    std::vector<int> depths, std::vector<int> strides) {
+  fCrystalIndexDepths = std::move(depths);
+  fCrystalIndexStrides = std::move(strides);
+}
+
+void GateDigitizerCoincidenceSorterActor::SetLORTable(
+    std::vector<int> rings, std::vector<int> positions) {
+  fCrystalRing = std::move(rings);
+  fCrystalPosition = std::move(positions);
+  fNumberOfRings = 0;
+  fCrystalsPerRing = 0;
+  for (size_t i = 0; i < fCrystalRing.size(); i++) {
+    fNumberOfRings = std::max(fNumberOfRings, fCrystalRing[i] + 1);
+    fCrystalsPerRing = std::max(fCrystalsPerRing, fCrystalPosition[i] + 1);
+  }
+}
+
+void GateDigitizerCoincidenceSorterActor::StartSimulationAction() {
+  GateVDigitizerTimeOrderedActor::StartSimulationAction();
+  if (fPolicy == MultiplesPolicy::RemoveMultiples)
+    CheckRequiredAttribute(fInputDigiCollection, "EventID");
+}
+
+void GateDigitizerCoincidenceSorterActor::InitializeOutputAttributes() {
+  // two attributes for each input attribute
+  auto *dam = GateDigiAttributeManager::GetInstance();
+  fOutputAttributes1.clear();
+  fOutputAttributes2.clear();
+  for (auto *att : fInputAttributes) {
+    const auto name = att->GetDigiAttributeName();
+    auto skip = std::find(fUserSkipDigiAttributeNames.begin(),
+                          fUserSkipDigiAttributeNames.end(),
+                          name) != fUserSkipDigiAttributeNames.end();
+    if (skip) {
+      fOutputAttributes1.push_back(nullptr);
+      fOutputAttributes2.push_back(nullptr);
+      continue;
+    }
+    auto *att1 = dam->NewDigiAttribute(att->GetDigiAttributeType(), name + "1");
+    auto *att2 = dam->NewDigiAttribute(att->GetDigiAttributeType(), name + "2");
+    fOutputDigiCollection->InitDigiAttribute(att1);
+    fOutputDigiCollection->InitDigiAttribute(att2);
+    fOutputAttributes1.push_back(att1);
+    fOutputAttributes2.push_back(att2);
+  }
+}
+
+void GateDigitizerCoincidenceSorterActor::InitializeStream() {
+  fWindow.clear();
+  fPendingCoincidences.clear();
+  fNumberOfCoincidences = 0;
+  fNumberOfSkippedLORs = 0;
+  fListmode.clear();
+  fSinogram.clear();
+  if (fSinogramMode != SinogramMode::NoSinogram || !fListmodeFilename.empty()) {
+    if (fCrystalIndexDepths.empty() || fCrystalRing.empty()) {
+      std::ostringstream oss;
+      oss << "Error in GateDigitizerCoincidenceSorterActor '" << GetName()
+          << "': the sinogram and the listmode need a LOR table";
+      Fatal(oss.str());
+    }
+  }
+  if (fSinogramMode != SinogramMode::NoSinogram) {
+    auto shape = GetSinogramShape();
+    fSinogram.assign(static_cast<size_t>(shape[0]) * shape[1] * shape[2], 0);
+  }
+  // the file is written at the end of each run
+  if (!fListmodeFilename.empty())
+    std::ofstream(fListmodeFilename, std::ios::binary | std::ios::trunc);
+}
+
+void GateDigitizerCoincidenceSorterActor::DigiPushed(const Digi &digi) {
+  if (fPolicy == MultiplesPolicy::RemoveMultiples)
+    fPendingCoincidences[digi.fEventID].fNumberOfSingles++;
+}
+
+void GateDigitizerCoincidenceSorterActor::ProcessDigi(Digi &&digi) {
+  fWindow.push_back(std::move(digi));
+}
+
+void GateDigitizerCoincidenceSorterActor::EndOfMerge(double watermark,
+                                                     bool flush) {
+  while (!fWindow.empty()) {
+    const auto &s1 = fWindow.front();
+    if (!flush && s1.fTime + fTimeWindow >= watermark &&
+        fWindow.back().fTime - s1.fTime <= fTimeWindow)
+      break;
+
+    // open the window: pair with the next singles until the end of the
+    // window or a single in the same volume
+    for (auto jt = std::next(fWindow.begin()); jt != fWindow.end(); ++jt) {
+      const auto &s2 = *jt;
+      if (s2.fTime - s1.fTime > fTimeWindow)
+        break;
+      // (the volume IDs are shared, see GateUniqueVolumeIDManager)
+      if (s2.fVolume == s1.fVolume)
+        break;
+      AddCoincidence(s1, s2);
+    }
+
+    // removeMultiples: the coincidences of the event are complete once all
+    // its singles opened their window
+    if (fPolicy == MultiplesPolicy::RemoveMultiples) {
+      auto pit = fPendingCoincidences.find(s1.fEventID);
+      pit->second.fNumberOfSingles--;
+      if (pit->second.fNumberOfSingles == 0) {
+        if (pit->second.fPairs.size() == 1)
+          OutputCoincidence(pit->second.fPairs[0].first,
+                            pit->second.fPairs[0].second);
+        fPendingCoincidences.erase(pit);
+      }
+    }
+    fWindow.pop_front();
+  }
+  if (flush || fListmode.size() >= 65536)
+    WriteListmode();
+}
+
+void GateDigitizerCoincidenceSorterActor::AddCoincidence(const Digi &s1,
+                                                         const Digi &s2) {
+  if (fPolicy == MultiplesPolicy::KeepAll)
+    OutputCoincidence(s1, s2);
+  else
+    fPendingCoincidences[s1.fEventID].fPairs.emplace_back(s1, s2);
+}
+
+void GateDigitizerCoincidenceSorterActor::OutputCoincidence(const Digi &s1,
+                                                            const Digi &s2) {
+  // (all "Fill" calls are thread local: the values are written to the root
+  // tuple of the thread that sorts)
+  if (fKeepCoincidences) {
+    for (size_t i = 0; i < fInputAttributes.size(); i++) {
+      if (fOutputAttributes1[i] == nullptr)
+        continue;
+      FillValue(fOutputAttributes1[i], s1.fValues[i]);
+      FillValue(fOutputAttributes2[i], s2.fValues[i]);
+    }
+  }
+  fNumberOfCoincidences++;
+  AddTerminationCount(1);
+
+  // sinogram and listmode (lock of the stream held)
+  if (fSinogramMode == SinogramMode::NoSinogram && fListmodeFilename.empty())
+    return;
+  const auto c1 = GetCrystal(s1.fVolume);
+  const auto c2 = GetCrystal(s2.fVolume);
+  if (fSinogramMode != SinogramMode::NoSinogram) {
+    size_t bin;
+    if (GetSinogramBin(c1, c2, bin))
+      fSinogram[bin]++;
+    else
+      fNumberOfSkippedLORs++;
+  }
+  if (!fListmodeFilename.empty()) {
+    const auto dt = (s2.fTime - s1.fTime) / CLHEP::ns;
+    fListmode.push_back({c1, c2, static_cast<float>(s1.fTime / CLHEP::s),
+                         static_cast<float>(dt)});
+  }
+}
+
+int GateDigitizerCoincidenceSorterActor::GetCrystal(
+    const GateUniqueVolumeID *volume) const {
+  const auto &depths = volume->fVolumeDepthID;
+  int crystal = 0;
+  for (size_t k = 0; k < fCrystalIndexDepths.size(); k++) {
+    const auto d = static_cast<size_t>(fCrystalIndexDepths[k]);
+    if (d < depths.size())
+      crystal += depths[d].fCopyNb * fCrystalIndexStrides[k];
+  }
+  if (crystal < 0 || static_cast<size_t>(crystal) >= fCrystalRing.size()) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerCoincidenceSorterActor '" << GetName()
+        << "': the crystal " << crystal << " of the volume " << volume->GetID()
+        << " is not in the LOR table (" << fCrystalRing.size()
+        << " crystals)";
+    Fatal(oss.str());
+  }
+  return crystal;
+}
+
+bool GateDigitizerCoincidenceSorterActor::GetSinogramBin(int crystal1,
+                                                         int crystal2,
+                                                         size_t &bin) const {
+  const auto n = fCrystalsPerRing;
+  auto i = fCrystalPosition[crystal1];
+  auto j = fCrystalPosition[crystal2];
+  auto ri = fCrystalRing[crystal1];
+  auto rj = fCrystalRing[crystal2];
+  if (i == j)
+    return false;
+  if (i > j) {
+    std::swap(i, j);
+    std::swap(ri, rj);
+  }
+  const auto view = ((i + j) % n) / 2;
+  // a = i, b = j if the bisector is in [0, pi[, else the reverse
+  int ra = ri;
+  int rb = rj;
+  int offset = j - i - n / 2;
+  if (i + j >= n) {
+    std::swap(ra, rb);
+    offset = -offset;
+  }
+  const auto shape = GetSinogramShape();
+  auto radial = offset + (n - 1) / 2;
+  radial -= (n - 1 - shape[2]) / 2;
+  if (radial < 0 || radial >= shape[2])
+    return false;
+  const auto axial =
+      fSinogramMode == SinogramMode::Sinogram3D ? ra * fNumberOfRings + rb
+                                                : ra + rb;
+  bin = (static_cast<size_t>(axial) * shape[1] + view) * shape[2] + radial;
+  return true;
+}
+
+void GateDigitizerCoincidenceSorterActor::WriteListmode() {
+  if (fListmode.empty())
+    return;
+  std::ofstream f(fListmodeFilename, std::ios::binary | std::ios::app);
+  f.write(reinterpret_cast<const char *>(fListmode.data()),
+          static_cast<std::streamsize>(fListmode.size() *
+                                       sizeof(ListmodeRecord)));
+  fListmode.clear();
+}
+
+std::vector<int> GateDigitizerCoincidenceSorterActor::GetSinogramShape() const {
+  const auto axial = fSinogramMode == SinogramMode::Sinogram3D
+                         ? fNumberOfRings * fNumberOfRings
+                         : 2 * fNumberOfRings - 1;
+  auto radial = fCrystalsPerRing - 1;
+  if (fRadialBins > 0)
+    radial = std::min(radial, fRadialBins);
+  return {axial, fCrystalsPerRing / 2, radial};
+}
+
+py::array_t<std::uint32_t>
+GateDigitizerCoincidenceSorterActor::GetSinogram() const {
+  return py::array_t<std::uint32_t>(fSinogram.size(), fSinogram.data());
+}
+
+unsigned long
+GateDigitizerCoincidenceSorterActor::GetNumberOfSkippedLORs() const {
+  return fNumberOfSkippedLORs;
+}
+
+unsigned long
+GateDigitizerCoincidenceSorterActor::GetNumberOfCoincidences() const {
+  return fNumberOfCoincidences;
+}
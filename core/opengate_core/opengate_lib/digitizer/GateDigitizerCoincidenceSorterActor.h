@@ -0,0 +1,154 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigitizerCoincidenceSorterActor_h
+#define GateDigitizerCoincidenceSorterActor_h
+
+#include "GateVDigitizerTimeOrderedActor.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Online coincidence sorter. Input: a collection of singles (with at least
+ * GlobalTime and PreStepUniqueVolumeID). Output: a collection of pairs of
+ * singles, each input attribute X is stored as X1 and X2.
+ *
+ * The singles of all the threads are merged in time order (see
+ * GateVDigitizerTimeOrderedActor). A merged single opens its window once
+ * the window is complete: a later single is merged, or the window is before
+ * the watermark.
+ *
+ * Same pairing as the offline sorter (coincidences.py): the window is opened
+ * by each single, all the next singles in the window are paired with it,
+ * until a single in the same volume. With the removeMultiples policy, the
+ * coincidences are kept only if they are the only one for the EventID of
+ * their first single. They are output once all the singles of this event
+ * have opened their window (the singles of an event are all added to the
+ * buffer at the end of the event), so the EventID are considered per run.
+ *
+ * The coincidences can also be binned into a sinogram, or written as a
+ * compact listmode file, while they are sorted (the coincidence collection
+ * can then be left empty, see keep_coincidences). The crystal of a single is
+ * a dense index, sum of the copy numbers of some volumes of its ID times
+ * their strides (SetCrystalIndex). A table gives the ring and the position
+ * in the ring (angular index, N per ring) of each crystal (SetLORTable).
+ * For two crystals i < j (positions), a = i, b = j if i + j < N, else the
+ * reverse, then: view = ((i + j) mod N) / 2 (N/2 views), radial offset
+ * ((b - a) mod N) - N/2 (N - 1 bins, 0 is the LOR through the axis), and
+ * ring(a) + ring(b) (2D, single slice rebinning) or ring(a) * rings +
+ * ring(b) (3D) for the sinogram. The coincidences are output with the lock
+ * of the stream, so there is a single histogram for all the threads.
+ *
+ * Termination criterion (see GateVActor): the number of coincidences. They
+ * are sorted after the end of their events, so the run ends a few events
+ * after the target is reached (the sorted coincidences are all kept).
+ */
+
+class GateDigitizerCoincidenceSorterActor
+    : public GateVDigitizerTimeOrderedActor {
+
+public:
+  explicit GateDigitizerCoincidenceSorterActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  // Called when the simulation start (master thread only)
+  void StartSimulationAction() override;
+
+  unsigned long GetNumberOfCoincidences() const;
+
+  // Crystal index = sum of copy number at depths[k] * strides[k]
+  void SetCrystalIndex(std::vector<int> depths, std::vector<int> strides);
+
+  // Ring and position in the ring of each crystal
+  void SetLORTable(std::vector<int> rings, std::vector<int> positions);
+
+  // Path of the listmode file (empty: no listmode)
+  void SetListmodeFilename(std::string filename);
+
+  // (axial, views, radial) counts, flattened
+  py::array_t<std::uint32_t> GetSinogram() const;
+
+  std::vector<int> GetSinogramShape() const;
+
+  // Coincidences that are not in the sinogram (same position, or out of the
+  // radial bins)
+  unsigned long GetNumberOfSkippedLORs() const;
+
+protected:
+  enum MultiplesPolicy { KeepAll, RemoveMultiples };
+  enum SinogramMode { NoSinogram, Sinogram2D, Sinogram3D };
+
+  // One coincidence of the listmode file (16 bytes)
+  struct ListmodeRecord {
+    std::int32_t fCrystal1;
+    std::int32_t fCrystal2;
+    // time of the first single (s), time difference t2 - t1 (ns)
+    float fTime;
+    float fTimeDifference;
+  };
+
+  // Coincidences of the same EventID1, not yet output (removeMultiples)
+  struct PendingCoincidences {
+    // singles of this event in the buffer, that did not open their window
+    size_t fNumberOfSingles = 0;
+    std::vector<std::pair<Digi, Digi>> fPairs;
+  };
+
+  void InitializeOutputAttributes() override;
+
+  void InitializeStream() override;
+
+  void DigiPushed(const Digi &digi) override;
+
+  void ProcessDigi(Digi &&digi) override;
+
+  // Sort the complete windows (all if flush)
+  void EndOfMerge(double watermark, bool flush) override;
+
+  void AddCoincidence(const Digi &s1, const Digi &s2);
+
+  void OutputCoincidence(const Digi &s1, const Digi &s2);
+
+  int GetCrystal(const GateUniqueVolumeID *volume) const;
+
+  // Bin of the LOR in the sinogram, false if it is not in the sinogram
+  bool GetSinogramBin(int crystal1, int crystal2, size_t &bin) const;
+
+  void WriteListmode();
+
+  double fTimeWindow;
+  MultiplesPolicy fPolicy;
+  bool fKeepCoincidences;
+  SinogramMode fSinogramMode;
+  int fRadialBins;
+  std::string fListmodeFilename;
+  std::vector<int> fCrystalIndexDepths;
+  std::vector<int> fCrystalIndexStrides;
+  std::vector<int> fCrystalRing;
+  std::vector<int> fCrystalPosition;
+  int fNumberOfRings;
+  int fCrystalsPerRing;
+  std::vector<GateVDigiAttribute *> fOutputAttributes1;
+  std::vector<GateVDigiAttribute *> fOutputAttributes2;
+
+  // Shared by all the threads (lock of the stream)
+  // merged singles, that did not open their window yet
+  std::deque<Digi> fWindow;
+  std::map<int, PendingCoincidences> fPendingCoincidences;
+  unsigned long fNumberOfCoincidences;
+  std::vector<std::uint32_t> fSinogram;
+  unsigned long fNumberOfSkippedLORs;
+  std::vector<ListmodeRecord> fListmode;
+};
+
+#endif // GateDigitizerCoincidenceSorterActor_h
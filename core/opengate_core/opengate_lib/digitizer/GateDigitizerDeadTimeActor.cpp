@@ -0,0 +1,64 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigitizerDeadTimeActor.h"
+#include "../GateHelpersDict.h"
+
+GateDigitizerDeadTimeActor::GateDigitizerDeadTimeActor(py::dict &user_info)
+    : GateVDigitizerTimeOrderedActor(user_info) {
+  fDeadTime = 0;
+  fPolicy = DeadTimePolicy::NonParalyzable;
+  fNumberOfKeptSingles = 0;
+  fNumberOfRemovedSingles = 0;
+}
+
+void GateDigitizerDeadTimeActor::InitializeUserInfo(py::dict &user_info) {
+  GateVDigitizerTimeOrderedActor::InitializeUserInfo(user_info);
+  fDeadTime = DictGetDouble(user_info, "dead_time");
+  auto policy = DictGetStr(user_info, "policy");
+  if (policy == "NonParalyzable")
+    fPolicy = DeadTimePolicy::NonParalyzable;
+  else if (policy == "Paralyzable")
+    fPolicy = DeadTimePolicy::Paralyzable;
+  else {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerDeadTimeActor: unknown policy. Must be "
+           "NonParalyzable or Paralyzable"
+        << " while '" << policy << "' is read.";
+    Fatal(oss.str());
+  }
+}
+
+void GateDigitizerDeadTimeActor::InitializeStream() {
+  fEndOfDeadTime.clear();
+  fNumberOfKeptSingles = 0;
+  fNumberOfRemovedSingles = 0;
+}
+
+void GateDigitizerDeadTimeActor::ProcessDigi(Digi &&digi) {
+  const auto unit = GetUnitIndex(digi);
+  if (unit >= fEndOfDeadTime.size())
+    fEndOfDeadTime.resize(unit + 1, fStream.Lowest());
+  auto &end = fEndOfDeadTime[unit];
+  if (digi.fTime < end) {
+    fNumberOfRemovedSingles++;
+    if (fPolicy == DeadTimePolicy::Paralyzable)
+      end = digi.fTime + fDeadTime;
+    return;
+  }
+  end = digi.fTime + fDeadTime;
+  fNumberOfKeptSingles++;
+  OutputDigi(digi);
+}
+
+unsigned long GateDigitizerDeadTimeActor::GetNumberOfKeptSingles() const {
+  return fNumberOfKeptSingles;
+}
+
+unsigned long GateDigitizerDeadTimeActor::GetNumberOfRemovedSingles() const {
+  return fNumberOfRemovedSingles;
+}
@@ -0,0 +1,56 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigitizerDeadTimeActor_h
+#define GateDigitizerDeadTimeActor_h
+
+#include "GateVDigitizerTimeOrderedActor.h"
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Dead time of the detector units (e.g. crystals or blocks, see
+ * SetGroupVolumeDepth), on the singles in time order (see
+ * GateVDigitizerTimeOrderedActor).
+ *
+ * After a kept single, the unit is dead during the dead time: the singles
+ * in this period are removed.
+ * - NonParalyzable: the dead time starts at each kept single only.
+ * - Paralyzable: each single (kept or not) starts a new dead time.
+ *
+ * The state of a unit is the end of its dead time (indexed by unit).
+ */
+
+class GateDigitizerDeadTimeActor : public GateVDigitizerTimeOrderedActor {
+
+public:
+  enum DeadTimePolicy { NonParalyzable, Paralyzable };
+
+  explicit GateDigitizerDeadTimeActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  unsigned long GetNumberOfKeptSingles() const;
+
+  unsigned long GetNumberOfRemovedSingles() const;
+
+protected:
+  void InitializeStream() override;
+
+  void ProcessDigi(Digi &&digi) override;
+
+  double fDeadTime;
+  DeadTimePolicy fPolicy;
+
+  // Shared by all the threads (lock of the stream)
+  std::vector<double> fEndOfDeadTime;
+  unsigned long fNumberOfKeptSingles;
+  unsigned long fNumberOfRemovedSingles;
+};
+
+#endif // GateDigitizerDeadTimeActor_h
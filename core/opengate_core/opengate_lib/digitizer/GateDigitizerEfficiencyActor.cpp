@@ -10,6 +10,8 @@
 #include "GateDigiAdderInVolume.h"
 #include "GateDigiCollectionManager.h"
 #include <Randomize.hh>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 GateDigitizerEfficiencyActor::GateDigitizerEfficiencyActor(py::dict &user_info)
@@ -17,17 +19,91 @@ GateDigitizerEfficiencyActor::GateDigitizerEfficiencyActor(py::dict &user_info)
 
   // actions
   fActions.insert("EndOfEventAction");
+  fEfficiency = 1.0;
+  fEfficiencyMapFlag = false;
+  fNumberOfCrystals = 0;
+  fNumberOfEnergyBins = 0;
+  fEfficiencyMapVolumeDepth = -1;
+  fEnergyMin = 0;
+  fInverseEnergyBinWidth = 0;
 }
 
 void GateDigitizerEfficiencyActor::InitializeUserInfo(py::dict &user_info) {
   GateVDigitizerWithOutputActor::InitializeUserInfo(user_info);
   // efficiency method
   fEfficiency = DictGetDouble(user_info, "efficiency");
+
+  // efficiency map (crystals x energy bins)
+  fEfficiencyMapFlag = !user_info["efficiency_map"].is_none();
+  fEfficiencyMap.clear();
+  if (!fEfficiencyMapFlag)
+    return;
+  auto m = DictGetMatrix(user_info, "efficiency_map");
+  if (m.ndim() != 2 || m.shape(0) == 0 || m.shape(1) == 0) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerEfficiencyActor '" << GetName()
+        << "': the efficiency map must be a 2D array (crystals x energy "
+           "bins)";
+    Fatal(oss.str());
+  }
+  fNumberOfCrystals = m.shape(0);
+  fNumberOfEnergyBins = m.shape(1);
+  fEfficiencyMap.resize(fNumberOfCrystals * fNumberOfEnergyBins);
+  for (size_t i = 0; i < fNumberOfCrystals; i++)
+    for (size_t j = 0; j < fNumberOfEnergyBins; j++)
+      fEfficiencyMap[i * fNumberOfEnergyBins + j] = *m.data(i, j);
+  fEnergyMin = 0;
+  fInverseEnergyBinWidth = 0;
+  if (fNumberOfEnergyBins > 1) {
+    auto range = DictGetVecDouble(user_info, "efficiency_map_energy_range");
+    if (range.size() != 2 || range[1] <= range[0]) {
+      std::ostringstream oss;
+      oss << "Error in GateDigitizerEfficiencyActor '" << GetName()
+          << "': the energy range of the efficiency map must be [min, max]";
+      Fatal(oss.str());
+    }
+    fEnergyMin = range[0];
+    fInverseEnergyBinWidth = fNumberOfEnergyBins / (range[1] - range[0]);
+  }
+}
+
+void GateDigitizerEfficiencyActor::SetEfficiencyMapVolumeDepth(int depth) {
+  fEfficiencyMapVolumeDepth = depth;
 }
 
 void GateDigitizerEfficiencyActor::DigitInitialize(
     const std::vector<std::string> &attributes_not_in_filler) {
   GateVDigitizerWithOutputActor::DigitInitialize(attributes_not_in_filler);
+  if (!fEfficiencyMapFlag)
+    return;
+  CheckRequiredAttribute(fInputDigiCollection, "TotalEnergyDeposit");
+  CheckRequiredAttribute(fInputDigiCollection, "PreStepUniqueVolumeID");
+  auto &l = fThreadLocalData.Get();
+  auto &lr = fThreadLocalVDigitizerData.Get();
+  lr.fInputIter.BindColumn("TotalEnergyDeposit", l.fEdep);
+  lr.fInputIter.BindColumn("PreStepUniqueVolumeID", l.fVolID);
+}
+
+double
+GateDigitizerEfficiencyActor::GetEfficiency(const GateUniqueVolumeID &uid,
+                                            double edep) const {
+  const auto &depths = uid.fVolumeDepthID;
+  const auto crystal = fEfficiencyMapVolumeDepth == -1
+                           ? depths.back().fCopyNb
+                           : depths[fEfficiencyMapVolumeDepth].fCopyNb;
+  if (crystal < 0 || static_cast<size_t>(crystal) >= fNumberOfCrystals) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerEfficiencyActor '" << GetName()
+        << "': the crystal " << crystal << " of the volume " << uid.GetID()
+        << " is not in the efficiency map (" << fNumberOfCrystals
+        << " crystals)";
+    Fatal(oss.str());
+  }
+  // (the energies out of the range are in the first or last bin)
+  const auto b = std::floor((edep - fEnergyMin) * fInverseEnergyBinWidth);
+  const auto bin = static_cast<size_t>(
+      std::clamp(b, 0.0, static_cast<double>(fNumberOfEnergyBins - 1)));
+  return fEfficiencyMap[crystal * fNumberOfEnergyBins + bin];
 }
 
 void GateDigitizerEfficiencyActor::EndOfEventAction(
@@ -36,6 +112,16 @@ void GateDigitizerEfficiencyActor::EndOfEventAction(
   auto &l = fThreadLocalData.Get();
   auto &lr = fThreadLocalVDigitizerData.Get();
   auto &iter = lr.fInputIter;
+  if (fEfficiencyMapFlag) {
+    const auto begin = iter.GetEventBeginIndex();
+    const auto edep = iter.GetEventSpan(l.fEdep);
+    const auto volID = iter.GetEventSpan(l.fVolID);
+    for (size_t k = 0; k < edep.size(); k++) {
+      if (G4UniformRand() < GetEfficiency(*volID[k], edep[k]))
+        lr.fDigiAttributeFiller->Fill(begin + k);
+    }
+    return;
+  }
   iter.GoToBegin();
   while (!iter.IsAtEnd()) {
     if (G4UniformRand() < fEfficiency) {
@@ -45,3 +131,25 @@ void GateDigitizerEfficiencyActor::EndOfEventAction(
     iter++;
   }
 }
+
+void GateDigitizerEfficiencyActor::ProcessEventBuffer(
+    GateDigiEventBuffer &buffer) {
+  // (same random numbers as EndOfEventAction)
+  auto &kept = fThreadLocalData.Get().fKeptIndices;
+  kept.clear();
+  if (fEfficiencyMapFlag) {
+    const auto &edep = buffer.GetDValues("TotalEnergyDeposit");
+    const auto &volID = buffer.GetUValues("PreStepUniqueVolumeID");
+    for (size_t i = 0; i < buffer.GetSize(); i++) {
+      if (G4UniformRand() < GetEfficiency(*volID[i], edep[i]))
+        kept.push_back(i);
+    }
+    buffer.Select(kept);
+    return;
+  }
+  for (size_t i = 0; i < buffer.GetSize(); i++) {
+    if (G4UniformRand() < fEfficiency)
+      kept.push_back(i);
+  }
+  buffer.Select(kept);
+}
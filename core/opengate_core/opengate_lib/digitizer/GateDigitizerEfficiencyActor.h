@@ -21,6 +21,13 @@ namespace py = pybind11;
 
 /*
  * Digitizer module for simulating detector efficiency.
+ *
+ * The efficiency is either one value for all the digi, or an efficiency map:
+ * a dense table of crystals x energy bins (row major). The crystal of a digi
+ * is the copy number of its volume at fEfficiencyMapVolumeDepth (the deepest
+ * volume if -1), the energy bins are uniform in fEfficiencyMapEnergyRange
+ * (the energies out of the range are in the first or last bin). In both
+ * cases, one uniform random number is drawn per digi.
  */
 
 class GateDigitizerEfficiencyActor : public GateVDigitizerWithOutputActor {
@@ -34,6 +41,11 @@ public:
   // Called every time an Event ends (all threads)
   void EndOfEventAction(const G4Event *event) override;
 
+  // Fused chain: remove the digi from the buffer
+  void ProcessEventBuffer(GateDigiEventBuffer &buffer) override;
+
+  void SetEfficiencyMapVolumeDepth(int depth);
+
 protected:
   void DigitInitialize(
       const std::vector<std::string> &attributes_not_in_filler) override;
@@ -42,9 +54,25 @@ protected:
   GateVDigiAttribute *fOutputEfficiencyAttribute{};
   double fEfficiency;
 
+  // efficiency map (crystals x energy bins)
+  bool fEfficiencyMapFlag;
+  std::vector<double> fEfficiencyMap;
+  size_t fNumberOfCrystals;
+  size_t fNumberOfEnergyBins;
+  int fEfficiencyMapVolumeDepth;
+  double fEnergyMin;
+  double fInverseEnergyBinWidth;
+
+  // Efficiency of a digi, from the map
+  double GetEfficiency(const GateUniqueVolumeID &uid, double edep) const;
+
   // During computation (thread local)
   struct threadLocalT {
     double *fAttDValue{};
+    std::vector<size_t> fKeptIndices;
+    // input columns for the efficiency map
+    GateDigiCollection::Iterator::Column<double> fEdep;
+    GateDigiCollection::Iterator::Column<GateUniqueVolumeID::Pointer> fVolID;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
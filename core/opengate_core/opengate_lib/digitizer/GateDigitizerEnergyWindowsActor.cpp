@@ -29,6 +29,7 @@ void GateDigitizerEnergyWindowsActor::InitializeUserInfo(py::dict &user_info) {
   fInputDigiCollectionName = DictGetStr(user_info, "input_digi_collection");
   fUserSkipDigiAttributeNames = DictGetVecStr(user_info, "skip_attributes");
   fClearEveryNEvents = DictGetInt(user_info, "clear_every");
+  fSelectionOnlyFlag = DictGetBool(user_info, "selection_only");
 
   // Get information for all channels
   auto dv = DictGetVecDict(user_info, "channels");
@@ -42,6 +43,7 @@ void GateDigitizerEnergyWindowsActor::InitializeUserInfo(py::dict &user_info) {
 void GateDigitizerEnergyWindowsActor::InitializeCpp() {
   GateVActor::InitializeCpp();
   fInputDigiCollection = nullptr;
+  fIsSelection = false;
 }
 
 // Called when the simulation start
@@ -50,6 +52,11 @@ void GateDigitizerEnergyWindowsActor::StartSimulationAction() {
   auto *hcm = GateDigiCollectionManager::GetInstance();
   fInputDigiCollection = hcm->GetDigiCollection(fInputDigiCollectionName);
   CheckRequiredAttribute(fInputDigiCollection, "TotalEnergyDeposit");
+  CheckIsNotSelection(fInputDigiCollection, GetName());
+  // The channels are only selections when they are not written
+  // (the fused chain fills the channels from its buffer, not the input)
+  fIsSelection = fSelectionOnlyFlag && !GetWriteToDisk(fOutputNameRoot) &&
+                 !IsFusedModule();
   // Create the list of output attributes
   auto names = fInputDigiCollection->GetDigiAttributeNames();
   for (const auto &n : fUserSkipDigiAttributeNames) {
@@ -70,6 +77,10 @@ void GateDigitizerEnergyWindowsActor::StartSimulationAction() {
     hc->InitDigiAttributesFromCopy(fInputDigiCollection,
                                    fUserSkipDigiAttributeNames);
     hc->RootInitializeTupleForMaster();
+    if (fIsSelection)
+      hc->SetSelectionSource(fInputDigiCollection);
+    else
+      hc->SetCapacityHint(fClearEveryNEvents);
     fChannelDigiCollections.push_back(hc);
   }
 }
@@ -102,31 +113,61 @@ void GateDigitizerEnergyWindowsActor::BeginOfEventAction(const G4Event *event) {
 
 void GateDigitizerEnergyWindowsActor::EndOfEventAction(
     const G4Event * /*event*/) {
+  auto &l = fThreadLocalData.Get();
   auto index = fInputDigiCollection->GetBeginOfEventIndex();
-  auto n = fInputDigiCollection->GetSize() - index;
+  auto end = fInputDigiCollection->GetSize();
   // If no new hits, do nothing
-  if (n <= 0)
+  if (index >= end) {
+    for (auto *hc : fChannelDigiCollections)
+      hc->GetSelectionIndices().clear();
     return;
-  // init last energy windows to 'outside' (-1)
+  }
+  // last energy windows is 'outside' (-1) if no channel is selected
+  const auto *edep = l.fInputEdep->data();
   for (size_t i = 0; i < fChannelDigiCollections.size(); i++) {
-    ApplyThreshold(i, fChannelMin[i], fChannelMax[i]);
+    auto *hc = fChannelDigiCollections[i];
+    // (selection: the index lists are the channels)
+    auto &indices =
+        fIsSelection ? hc->GetSelectionIndices() : l.fChannelIndices;
+    ComputeChannelIndices(edep, index, end, fChannelMin[i], fChannelMax[i],
+                          indices);
+    if (indices.empty())
+      continue;
+    l.fLastEnergyWindowId = i;
+    if (fIsSelection)
+      continue;
+    auto *filler = l.fFillers[i];
+    for (auto n : indices)
+      filler->Fill(n);
+  }
+}
+
+void GateDigitizerEnergyWindowsActor::ComputeChannelIndices(
+    const double *edep, size_t begin, size_t end, double min, double max,
+    std::vector<size_t> &indices) {
+  // branch-free: the index is always written, and kept if in the window
+  indices.resize(end - begin);
+  auto *p = indices.data();
+  size_t k = 0;
+  // FIXME put in doc. strictly or not ?
+  for (size_t n = begin; n < end; n++) {
+    p[k] = n;
+    k += (edep[n] >= min) & (edep[n] < max);
   }
+  indices.resize(k);
 }
 
-void GateDigitizerEnergyWindowsActor::ApplyThreshold(size_t i, double min,
-                                                     double max) {
+void GateDigitizerEnergyWindowsActor::FillOutputFromEventBuffer(
+    GateDigiEventBuffer &buffer) {
   auto &l = fThreadLocalData.Get();
-  // get the vector of values
-  auto &edep = *l.fInputEdep;
-  // get the index of the first hit for this event
-  auto index = fInputDigiCollection->GetBeginOfEventIndex();
-  // fill all the hits
-  for (size_t n = index; n < fInputDigiCollection->GetSize(); n++) {
-    auto e = edep[n];
-    if (e >= min && e < max) { // FIXME put in doc. strictly or not ?
-      l.fFillers[i]->Fill(n);
+  const auto &edep = buffer.GetDValues("TotalEnergyDeposit");
+  for (size_t i = 0; i < fChannelDigiCollections.size(); i++) {
+    auto &indices = l.fChannelIndices;
+    ComputeChannelIndices(edep.data(), 0, edep.size(), fChannelMin[i],
+                          fChannelMax[i], indices);
+    if (!indices.empty())
       l.fLastEnergyWindowId = i;
-    }
+    buffer.Fill(fChannelDigiCollections[i], indices);
   }
 }
 
@@ -11,6 +11,7 @@
 #include "../GateVActor.h"
 #include "G4Cache.hh"
 #include "GateDigiCollection.h"
+#include "GateDigiEventBuffer.h"
 #include "GateHelpersDigitizer.h"
 #include <pybind11/stl.h>
 
@@ -18,10 +19,19 @@ namespace py = pybind11;
 
 /*
  * Simple actor that use a input Hits Collection and split into several ones
- * with some thresholds on the TotalEnergyDeposit
+ * with some thresholds on the TotalEnergyDeposit. Can be the last module of a
+ * fused chain (see GateDigitizerFusedChainActor).
+ *
+ * The digi of an event are classified once per channel over the energy
+ * column (branch-free index lists). With the selection only flag (and no
+ * output written to disk, not in a fused chain), the channels do not copy
+ * the digi: they are selections of the input collection that only keep the
+ * index lists (see GateDigiCollection::SetSelectionSource), read by the
+ * projection actor.
  */
 
-class GateDigitizerEnergyWindowsActor : public GateVActor {
+class GateDigitizerEnergyWindowsActor : public GateVActor,
+                                        public GateVFusedDigitizerModule {
 
 public:
   explicit GateDigitizerEnergyWindowsActor(py::dict &user_info);
@@ -51,6 +61,12 @@ public:
   // Called when the simulation end (master thread only)
   void EndSimulationAction() override;
 
+  // Fused chain: the digi are not modified
+  void ProcessEventBuffer(GateDigiEventBuffer & /*buffer*/) override {}
+
+  // Fused chain: fill the channels with the digi of the buffer
+  void FillOutputFromEventBuffer(GateDigiEventBuffer &buffer) override;
+
   // Get the id of the last energy window
   int GetLastEnergyWindowId();
 
@@ -63,14 +79,20 @@ protected:
   std::vector<double> fChannelMin;
   std::vector<double> fChannelMax;
   int fClearEveryNEvents;
+  bool fSelectionOnlyFlag;
+  bool fIsSelection;
 
-  void ApplyThreshold(size_t i, double min, double max);
+  // Indices (between begin and end) of the digi in [min, max[
+  static void ComputeChannelIndices(const double *edep, size_t begin,
+                                    size_t end, double min, double max,
+                                    std::vector<size_t> &indices);
 
   // During computation
   struct threadLocalT {
     std::vector<GateDigiAttributesFiller *> fFillers;
     std::vector<double> *fInputEdep;
     int fLastEnergyWindowId;
+    std::vector<size_t> fChannelIndices;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
@@ -0,0 +1,71 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigitizerFusedChainActor.h"
+#include "../GateHelpersDict.h"
+#include "GateDigiCollectionManager.h"
+#include "GateHelpersDigitizer.h"
+
+GateDigitizerFusedChainActor::GateDigitizerFusedChainActor(
+    py::dict &user_info)
+    : GateVActor(user_info, true) {
+  fActions.insert("StartSimulationAction");
+  fActions.insert("EndOfEventAction");
+  fInputDigiCollection = nullptr;
+  fChainDigiCollection = nullptr;
+}
+
+void GateDigitizerFusedChainActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fInputDigiCollectionName = DictGetStr(user_info, "input_digi_collection");
+  fChainDigiCollectionName = DictGetStr(user_info, "name");
+  fModules.clear();
+}
+
+void GateDigitizerFusedChainActor::AddModule(GateVActor *module) {
+  auto *m = dynamic_cast<GateVFusedDigitizerModule *>(module);
+  if (m == nullptr) {
+    std::ostringstream oss;
+    oss << "Error in the fused digitizer chain '" << fChainDigiCollectionName
+        << "': this actor cannot be part of a fused chain";
+    Fatal(oss.str());
+  }
+  m->SetFusedFlag(true);
+  fModules.push_back(m);
+}
+
+void GateDigitizerFusedChainActor::StartSimulationAction() {
+  if (fModules.empty()) {
+    std::ostringstream oss;
+    oss << "Error in the fused digitizer chain '" << fChainDigiCollectionName
+        << "': no module";
+    Fatal(oss.str());
+  }
+  // the collection of the chain: input of the first module, never filled
+  auto *hcm = GateDigiCollectionManager::GetInstance();
+  fInputDigiCollection = hcm->GetDigiCollection(fInputDigiCollectionName);
+  CheckIsNotSelection(fInputDigiCollection, GetName());
+  fChainDigiCollection = hcm->NewDigiCollection(fChainDigiCollectionName);
+  fChainDigiCollection->SetFilenameAndInitRoot("");
+  fChainDigiCollection->InitDigiAttributesFromCopy(fInputDigiCollection);
+}
+
+void GateDigitizerFusedChainActor::EndOfEventAction(const G4Event * /*event*/) {
+  auto begin = fInputDigiCollection->GetBeginOfEventIndex();
+  auto end = fInputDigiCollection->GetSize();
+  // If no new digi, do nothing
+  if (begin >= end)
+    return;
+  auto &buffer = fThreadLocalData.Get().fBuffer;
+  buffer.Reset(fInputDigiCollection, begin, end);
+  for (auto *m : fModules) {
+    m->ProcessEventBuffer(buffer);
+    if (buffer.GetSize() == 0)
+      return;
+  }
+  fModules.back()->FillOutputFromEventBuffer(buffer);
+}
@@ -0,0 +1,63 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigitizerFusedChainActor_h
+#define GateDigitizerFusedChainActor_h
+
+#include "../GateVActor.h"
+#include "G4Cache.hh"
+#include "GateDigiCollection.h"
+#include "GateDigiEventBuffer.h"
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Run a chain of digitizer modules (adder, readout, efficiency, blurring,
+ * spatial blurring, energy windows) in one pass per event.
+ *
+ * At the end of each event, the digi of the input collection (usually the
+ * hits) are processed in place, by all the modules in turn, in a thread local
+ * buffer (GateDigiEventBuffer). Only the output of the last module is filled.
+ *
+ * The modules are configured as usual, but the input of the first one is the
+ * collection of the chain (same attributes as the input, always empty): the
+ * intermediate collections are never filled, and the EndOfEventAction of the
+ * modules do nothing.
+ */
+
+class GateDigitizerFusedChainActor : public GateVActor {
+
+public:
+  explicit GateDigitizerFusedChainActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  // Called when the simulation start (master thread only)
+  void StartSimulationAction() override;
+
+  // Called every time an Event ends (all threads)
+  void EndOfEventAction(const G4Event *event) override;
+
+  // Add a module at the end of the chain (before the simulation)
+  void AddModule(GateVActor *module);
+
+protected:
+  std::string fInputDigiCollectionName;
+  std::string fChainDigiCollectionName;
+  GateDigiCollection *fInputDigiCollection;
+  GateDigiCollection *fChainDigiCollection;
+  std::vector<GateVFusedDigitizerModule *> fModules;
+
+  // During computation (thread local)
+  struct threadLocalT {
+    GateDigiEventBuffer fBuffer;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateDigitizerFusedChainActor_h
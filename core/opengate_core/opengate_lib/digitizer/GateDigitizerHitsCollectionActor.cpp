@@ -9,6 +9,8 @@
 #include "../GateHelpersDict.h"
 #include "G4RunManager.hh"
 #include "GateDigiCollectionManager.h"
+#include "Randomize.hh"
+#include <algorithm>
 
 GateDigitizerHitsCollectionActor::GateDigitizerHitsCollectionActor(
     py::dict &user_info)
@@ -23,6 +25,7 @@ GateDigitizerHitsCollectionActor::GateDigitizerHitsCollectionActor(
   fActions.insert("EndSimulationAction");
   fDebug = false;
   fKeepZeroEdep = false;
+  fAsyncWrite = false;
   fClearEveryNEvents = 100000;
 }
 
@@ -36,6 +39,64 @@ void GateDigitizerHitsCollectionActor::InitializeUserInfo(py::dict &user_info) {
   fDebug = DictGetBool(user_info, "debug");
   fClearEveryNEvents = DictGetInt(user_info, "clear_every");
   fKeepZeroEdep = DictGetBool(user_info, "keep_zero_edep");
+  fAsyncWrite = DictGetBool(user_info, "async_write");
+  fRetentionNbEvents = DictGetInt(user_info, "retention_events");
+  fRetentionTime = DictGetDouble(user_info, "retention_time");
+
+  // sampling
+  fSamplingProbability = DictGetDouble(user_info, "sampling_probability");
+  DictCheckKey(user_info, "sampling_probability_per_particle");
+  fSamplingProbabilityPerParticle = py::cast<std::map<std::string, double>>(
+      user_info["sampling_probability_per_particle"]);
+  fSamplingProbabilityPerEnergy.clear();
+  for (const auto &b :
+       DictGetVecofVecDouble(user_info, "sampling_probability_per_energy")) {
+    if (b.size() != 2) {
+      std::ostringstream oss;
+      oss << "Error in the actor " << GetName()
+          << ": sampling_probability_per_energy must be a list of [energy, "
+             "probability]";
+      Fatal(oss.str());
+    }
+    fSamplingProbabilityPerEnergy.emplace_back(b[0], b[1]);
+  }
+  std::sort(fSamplingProbabilityPerEnergy.begin(),
+            fSamplingProbabilityPerEnergy.end());
+  fReservoirSize = DictGetInt(user_info, "reservoir_size");
+  std::vector<double> probabilities = {fSamplingProbability};
+  for (const auto &p : fSamplingProbabilityPerParticle)
+    probabilities.push_back(p.second);
+  for (const auto &b : fSamplingProbabilityPerEnergy)
+    probabilities.push_back(b.second);
+  for (auto p : probabilities) {
+    if (p <= 0 || p > 1) {
+      std::ostringstream oss;
+      oss << "Error in the actor " << GetName()
+          << ": the sampling probabilities must be in ]0, 1], while " << p
+          << " is read.";
+      Fatal(oss.str());
+    }
+  }
+  fSamplingFlag = fSamplingProbability < 1 ||
+                  !fSamplingProbabilityPerParticle.empty() ||
+                  !fSamplingProbabilityPerEnergy.empty() || fReservoirSize > 0;
+
+  // retention
+  if (fRetentionNbEvents < 0 || fRetentionTime < 0) {
+    std::ostringstream oss;
+    oss << "Error in the actor " << GetName()
+        << ": retention_events and retention_time must be positive (or 0 for "
+           "no limit), while "
+        << fRetentionNbEvents << " and " << fRetentionTime << " are read.";
+    Fatal(oss.str());
+  }
+  if ((fRetentionNbEvents > 0 || fRetentionTime > 0) && fReservoirSize > 0) {
+    std::ostringstream oss;
+    oss << "Error in the actor " << GetName()
+        << ": the retention of the past events cannot be used with the "
+           "reservoir sampling";
+    Fatal(oss.str());
+  }
 }
 
 void GateDigitizerHitsCollectionActor::InitializeCpp() {
@@ -58,6 +119,24 @@ void GateDigitizerHitsCollectionActor::StartSimulationAction() {
   fHits->SetFilenameAndInitRoot(outputPath);
   fHits->InitDigiAttributesFromNames(fUserDigiAttributeNames);
   fHits->RootInitializeTupleForMaster();
+  // (at least one hit per event is expected between two clears)
+  fHits->SetCapacityHint(fReservoirSize > 0 ? fReservoirSize
+                                            : fClearEveryNEvents);
+  fHits->SetAsyncWriteFlag(fAsyncWrite);
+  fHits->SetRetention(fRetentionNbEvents, fRetentionTime);
+  fNbCandidateHits = 0;
+  fNbSampledHits = 0;
+  // the weights of the sampled hits are corrected
+  fWeightAttribute = nullptr;
+  if (fSamplingFlag) {
+    if (!fHits->IsDigiAttributeExists("Weight")) {
+      std::ostringstream oss;
+      oss << "Error in the actor " << GetName()
+          << ": the Weight attribute is required with the sampling options";
+      Fatal(oss.str());
+    }
+    fWeightAttribute = fHits->GetDigiAttribute("Weight");
+  }
 }
 
 // Called every time a Run starts
@@ -78,15 +157,32 @@ void GateDigitizerHitsCollectionActor::BeginOfEventAction(
      actors may need hits from several events, so we leave the option to keep
      more events. It only fills to root if needed.
    */
-  bool must_clear = event->GetEventID() % fClearEveryNEvents == 0;
-  fHits->FillToRootIfNeeded(must_clear);
+  if (fHits->IsRetentionEnabled()) {
+    // the past events out of the retention are written and discarded (the
+    // time of the event is needed)
+    fHits->BeginOfEvent(event);
+    fHits->RetainEvents();
+    return;
+  }
+  if (fReservoirSize > 0) {
+    // the reservoir is written at the end of the run
+    fHits->SetBeginOfEventIndex();
+  } else {
+    bool must_clear = event->GetEventID() % fClearEveryNEvents == 0;
+    fHits->FillToRootIfNeeded(must_clear);
+  }
+  fHits->BeginOfEvent(event);
 }
 
 // Called every time a batch of step must be processed
 void GateDigitizerHitsCollectionActor::SteppingAction(G4Step *step) {
   // Do not store step with zero edep
-  if (fKeepZeroEdep || step->GetTotalEnergyDeposit() > 0)
-    fHits->FillHits(step);
+  if (fKeepZeroEdep || step->GetTotalEnergyDeposit() > 0) {
+    if (fSamplingFlag)
+      FillSampledHit(step);
+    else
+      fHits->FillHits(step);
+  }
   if (fDebug) {
     // nb edep = 0
     auto s = fHits->DumpLastDigi();
@@ -108,8 +204,81 @@ void GateDigitizerHitsCollectionActor::SteppingAction(G4Step *step) {
   }
 }
 
+double
+GateDigitizerHitsCollectionActor::GetSamplingProbability(const G4Step *step) {
+  auto p = fSamplingProbability;
+  if (!fSamplingProbabilityPerParticle.empty()) {
+    const auto *def = step->GetTrack()->GetParticleDefinition();
+    auto &particles = fThreadLocalData.Get().fParticles;
+    auto it = particles.find(def);
+    if (it == particles.end()) {
+      const auto &m = fSamplingProbabilityPerParticle;
+      auto pit = m.find(def->GetParticleName());
+      it = particles.emplace(def, pit == m.end() ? 1.0 : pit->second).first;
+    }
+    p *= it->second;
+  }
+  if (!fSamplingProbabilityPerEnergy.empty()) {
+    // first bin with an upper energy above the kinetic energy
+    const auto e = step->GetPreStepPoint()->GetKineticEnergy();
+    auto it = std::upper_bound(
+        fSamplingProbabilityPerEnergy.begin(),
+        fSamplingProbabilityPerEnergy.end(), e,
+        [](double v, const std::pair<double, double> &b) {
+          return v < b.first;
+        });
+    if (it != fSamplingProbabilityPerEnergy.end())
+      p *= it->second;
+  }
+  return p;
+}
+
+void GateDigitizerHitsCollectionActor::FillSampledHit(G4Step *step) {
+  auto &l = fThreadLocalData.Get();
+  l.fNbCandidateHits++;
+  const auto p = GetSamplingProbability(step);
+  if (p < 1 && G4UniformRand() >= p)
+    return;
+  l.fNbSampledHits++;
+  // reservoir full: the hit replaces a random one with the probability N / n
+  size_t replaced = fReservoirSize;
+  if (fReservoirSize > 0) {
+    const auto n = ++l.fNbReservoirHits;
+    if (n > fReservoirSize) {
+      replaced = static_cast<size_t>(G4UniformRand() * n);
+      if (replaced >= fReservoirSize)
+        return;
+    }
+  }
+  fHits->FillHits(step);
+  if (p < 1)
+    fWeightAttribute->GetDValues().back() /= p;
+  if (replaced < fReservoirSize)
+    fHits->MoveLastDigiTo(replaced);
+}
+
+void GateDigitizerHitsCollectionActor::CorrectReservoirWeights() {
+  auto &l = fThreadLocalData.Get();
+  const auto n = l.fNbReservoirHits;
+  l.fNbReservoirHits = 0;
+  if (n <= fReservoirSize)
+    return;
+  const auto f = static_cast<double>(n) / static_cast<double>(fReservoirSize);
+  for (auto &w : fWeightAttribute->GetDValues())
+    w *= f;
+}
+
 // Called every time a Run ends
 void GateDigitizerHitsCollectionActor::EndOfRunAction(const G4Run * /*run*/) {
+  if (fSamplingFlag) {
+    auto &l = fThreadLocalData.Get();
+    fNbCandidateHits += l.fNbCandidateHits;
+    fNbSampledHits += l.fNbSampledHits;
+    l.fNbCandidateHits = 0;
+    l.fNbSampledHits = 0;
+    if (fReservoirSize > 0)
+      CorrectReservoirWeights();
+  }
   /*
    * We consider flushing values every run.
    * If a process need to access hits across different run, this should be move
@@ -9,11 +9,34 @@
 #define GateHitsCollectionActor_h
 
 #include "../GateVActor.h"
+#include "G4Cache.hh"
 #include "GateDigiCollection.h"
+#include <atomic>
 #include <pybind11/stl.h>
+#include <unordered_map>
 
 namespace py = pybind11;
 
+/*
+ * Hits of the steps in the attached volume(s).
+ *
+ * Sampling: a hit is kept with the probability p, the product of the global
+ * probability, of the one of the particle and of the one of the kinetic
+ * energy (pre step) of the particle (1 if not defined). The Weight of the
+ * kept hit is divided by p. With a reservoir size N, at most N hits are kept
+ * per thread and per run, uniformly among all the (sampled) hits of the run
+ * (reservoir sampling): the collection is then written at the end of the run
+ * only, and the Weight of the hits is multiplied by the number of hits divided
+ * by N. The collection is then not meant to be the input of other digitizer
+ * modules (the hits of the past events are replaced).
+ *
+ * Retention: with a number of events K and/or a time window, the hits of the
+ * last K events (and of the events in the time window before the current
+ * one, with the time of the primary vertex) are kept in the collection, the
+ * older ones are written and discarded at the beginning of each event (see
+ * GateDigiCollection::RetainEvents) instead of the clear every N events.
+ */
+
 class GateDigitizerHitsCollectionActor : public GateVActor {
 
 public:
@@ -37,6 +60,12 @@ public:
   // Called every time a batch of step must be processed
   void SteppingAction(G4Step * /*unused*/) override;
 
+  // With sampling: number of hits (non-zero edep or all) before the
+  // sampling, and kept by the sampling probability (before the reservoir)
+  unsigned long GetNumberOfCandidateHits() const { return fNbCandidateHits; }
+
+  unsigned long GetNumberOfSampledHits() const { return fNbSampledHits; }
+
   // Called every time a Run ends (all threads)
   void EndOfRunAction(const G4Run *run) override;
 
@@ -52,7 +81,41 @@ protected:
   GateDigiCollection *fHits{};
   bool fDebug{};
   bool fKeepZeroEdep{};
+  bool fAsyncWrite{};
   int fClearEveryNEvents{};
+  int fRetentionNbEvents{};
+  double fRetentionTime{};
+
+  // Sampling (see above)
+  bool fSamplingFlag{};
+  double fSamplingProbability{};
+  std::map<std::string, double> fSamplingProbabilityPerParticle;
+  // (upper kinetic energy, probability), sorted by energy
+  std::vector<std::pair<double, double>> fSamplingProbabilityPerEnergy;
+  size_t fReservoirSize{};
+  GateVDigiAttribute *fWeightAttribute{};
+  std::atomic<unsigned long> fNbCandidateHits{0};
+  std::atomic<unsigned long> fNbSampledHits{0};
+
+  // Sampling probability of the hit of the step
+  double GetSamplingProbability(const G4Step *step);
+
+  // Fill the hit of the step according to the sampling
+  void FillSampledHit(G4Step *step);
+
+  // Correct the weights of the reservoir of the thread, end of run
+  void CorrectReservoirWeights();
+
+  struct threadLocalT {
+    // sampling probability of each particle met by the thread
+    std::unordered_map<const G4ParticleDefinition *, double> fParticles;
+    // number of sampled hits of the run (reservoir)
+    unsigned long fNbReservoirHits = 0;
+    // counts of the run (added to the totals at the end of the run)
+    unsigned long fNbCandidateHits = 0;
+    unsigned long fNbSampledHits = 0;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
 };
 
 #endif // GateHitsCollectionActor_h
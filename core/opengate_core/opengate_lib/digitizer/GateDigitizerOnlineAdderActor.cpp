@@ -0,0 +1,223 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigitizerOnlineAdderActor.h"
+#include "../GateHelpersDict.h"
+#include "../GateUniqueVolumeIDManager.h"
+#include "GateDigiCollectionManager.h"
+#include "GateTDigiAttribute.h"
+
+GateDigitizerOnlineAdderActor::GateDigitizerOnlineAdderActor(
+    py::dict &user_info)
+    : GateVActor(user_info, true) {
+  // actions
+  fActions.insert("StartSimulationAction");
+  fActions.insert("BeginOfRunAction");
+  fActions.insert("BeginOfEventAction");
+  fActions.insert("SteppingAction");
+  fActions.insert("EndOfEventAction");
+  fActions.insert("EndOfRunAction");
+  fActions.insert("EndOfSimulationWorkerAction");
+  fActions.insert("EndSimulationAction");
+  fGroupVolumeDepth = -1;
+  fPolicy = GateDigitizerAdderActor::AdderPolicy::EnergyWinnerPosition;
+  fTimeDifferenceFlag = false;
+  fNumberOfHitsFlag = false;
+  fClearEveryNEvents = 100000;
+}
+
+GateDigitizerOnlineAdderActor::~GateDigitizerOnlineAdderActor() = default;
+
+void GateDigitizerOnlineAdderActor::InitializeUserInfo(py::dict &user_info) {
+  GateVActor::InitializeUserInfo(user_info);
+  fOutputDigiCollectionName = DictGetStr(user_info, "name");
+  // policy (same as GateDigitizerAdderActor)
+  fPolicy = GateDigitizerAdderActor::AdderPolicy::Error;
+  auto policy = DictGetStr(user_info, "policy");
+  if (policy == "EnergyWinnerPosition")
+    fPolicy = GateDigitizerAdderActor::AdderPolicy::EnergyWinnerPosition;
+  else if (policy == "EnergyWeightedCentroidPosition")
+    fPolicy =
+        GateDigitizerAdderActor::AdderPolicy::EnergyWeightedCentroidPosition;
+  if (fPolicy == GateDigitizerAdderActor::AdderPolicy::Error) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerOnlineAdderActor: unknown policy. Must be "
+           "EnergyWinnerPosition or EnergyWeightedCentroidPosition"
+        << " while '" << policy << "' is read.";
+    Fatal(oss.str());
+  }
+
+  // options
+  fTimeDifferenceFlag = DictGetBool(user_info, "time_difference");
+  fNumberOfHitsFlag = DictGetBool(user_info, "number_of_hits");
+  fClearEveryNEvents = DictGetInt(user_info, "clear_every");
+
+  // init
+  fGroupVolumeDepth = -1;
+}
+
+void GateDigitizerOnlineAdderActor::InitializeCpp() {
+  GateVActor::InitializeCpp();
+  fOutputDigiCollection = nullptr;
+}
+
+void GateDigitizerOnlineAdderActor::SetGroupVolumeDepth(int depth) {
+  fGroupVolumeDepth = depth;
+}
+
+void GateDigitizerOnlineAdderActor::StartSimulationAction() {
+  auto *dcm = GateDigiCollectionManager::GetInstance();
+  fOutputDigiCollection = dcm->NewDigiCollection(fOutputDigiCollectionName);
+  // This order is important: filename and attributes must be set before Root
+  // initialization
+  std::string outputPath;
+  if (!GetWriteToDisk(fOutputNameRoot)) {
+    outputPath = "";
+  } else {
+    outputPath = GetOutputPath(fOutputNameRoot);
+  }
+  fOutputDigiCollection->SetFilenameAndInitRoot(outputPath);
+  fOutputDigiCollection->InitDigiAttributesFromNames(
+      {"TotalEnergyDeposit", "PostPosition", "GlobalTime",
+       "PreStepUniqueVolumeID", "EventID"});
+  if (fTimeDifferenceFlag) {
+    auto *att = new GateTDigiAttribute<double>("TimeDifference");
+    fOutputDigiCollection->InitDigiAttribute(att);
+  }
+  if (fNumberOfHitsFlag) {
+    auto *att = new GateTDigiAttribute<double>("NumberOfHits");
+    fOutputDigiCollection->InitDigiAttribute(att);
+  }
+  fOutputDigiCollection->RootInitializeTupleForMaster();
+  // (at least one single per event is expected between two clears)
+  fOutputDigiCollection->SetCapacityHint(fClearEveryNEvents);
+
+  // all the attributes are filled explicitly
+  fOutputEdepAttribute =
+      fOutputDigiCollection->GetDigiAttribute("TotalEnergyDeposit");
+  fOutputPosAttribute = fOutputDigiCollection->GetDigiAttribute("PostPosition");
+  fOutputGlobalTimeAttribute =
+      fOutputDigiCollection->GetDigiAttribute("GlobalTime");
+  fOutputVolumeIDAttribute =
+      fOutputDigiCollection->GetDigiAttribute("PreStepUniqueVolumeID");
+  fOutputEventIDAttribute = fOutputDigiCollection->GetDigiAttribute("EventID");
+  if (fTimeDifferenceFlag)
+    fOutputTimeDifferenceAttribute =
+        fOutputDigiCollection->GetDigiAttribute("TimeDifference");
+  if (fNumberOfHitsFlag)
+    fOutputNumberOfHitsAttribute =
+        fOutputDigiCollection->GetDigiAttribute("NumberOfHits");
+}
+
+void GateDigitizerOnlineAdderActor::BeginOfRunAction(const G4Run *run) {
+  // Needed to create the root output (only the first run)
+  if (run->GetRunID() == 0)
+    fOutputDigiCollection->RootInitializeTupleForWorker();
+}
+
+void GateDigitizerOnlineAdderActor::BeginOfEventAction(const G4Event *event) {
+  bool must_clear = event->GetEventID() % fClearEveryNEvents == 0;
+  fOutputDigiCollection->FillToRootIfNeeded(must_clear);
+}
+
+size_t GateDigitizerOnlineAdderActor::AddVolumeID(
+    const GateUniqueVolumeID::Pointer &uid) {
+  auto &l = fThreadLocalData.Get();
+  const auto index = static_cast<size_t>(uid->fIndex);
+  if (index >= l.fAdderOfVolumeID.size()) {
+    l.fAdderOfVolumeID.resize(index + 1, -1);
+    l.fVolumeIDs.resize(index + 1);
+  }
+  l.fVolumeIDs[index] = uid;
+
+  // same grouping as GateDigitizerAdderActor: the volume at the depth and
+  // the copy numbers up to this depth (all of them if -1)
+  const auto &depths = uid->GetVolumeDepthID();
+  std::pair<const G4VPhysicalVolume *, std::string> key;
+  if (fGroupVolumeDepth == -1) {
+    key.first = depths.empty() ? nullptr : depths.back().fVolume;
+    key.second = uid->GetID();
+  } else {
+    key.first = depths[fGroupVolumeDepth].fVolume;
+    key.second = uid->GetIdUpToDepth(fGroupVolumeDepth);
+  }
+  auto it = l.fAdderOfGroup.find(key);
+  if (it == l.fAdderOfGroup.end()) {
+    it = l.fAdderOfGroup.emplace(key, l.fAdders.size()).first;
+    l.fAdders.emplace_back(fPolicy, fTimeDifferenceFlag, fNumberOfHitsFlag);
+    l.fAdderIsUsed.push_back(0);
+  }
+  l.fAdderOfVolumeID[index] = static_cast<int>(it->second);
+  return it->second;
+}
+
+void GateDigitizerOnlineAdderActor::SteppingAction(G4Step *step) {
+  const auto edep = step->GetTotalEnergyDeposit();
+  if (edep == 0)
+    return;
+  auto &l = fThreadLocalData.Get();
+  auto *m = GateUniqueVolumeIDManager::GetInstance();
+  const auto &uid = m->GetVolumeID(step->GetPreStepPoint()->GetTouchable());
+  const auto index = static_cast<size_t>(uid->fIndex);
+  size_t n;
+  if (index < l.fAdderOfVolumeID.size() && l.fAdderOfVolumeID[index] >= 0)
+    n = l.fAdderOfVolumeID[index];
+  else
+    n = AddVolumeID(uid);
+
+  // first step in this volume for the current event: reset the adder
+  if (l.fAdderIsUsed[n] == 0) {
+    l.fAdders[n] = GateDigiAdderInVolume(fPolicy, fTimeDifferenceFlag,
+                                         fNumberOfHitsFlag);
+    l.fAdderIsUsed[n] = 1;
+    l.fUsedAdders.push_back(n);
+  }
+  // (the index of the "digi" is the one of its volume ID)
+  const auto *post = step->GetPostStepPoint();
+  l.fAdders[n].Update(index, edep, post->GetPosition(), post->GetGlobalTime());
+}
+
+void GateDigitizerOnlineAdderActor::EndOfEventAction(const G4Event *event) {
+  auto &l = fThreadLocalData.Get();
+  const auto eventID = event->GetEventID();
+  for (auto n : l.fUsedAdders) {
+    auto &adder = l.fAdders[n];
+    l.fAdderIsUsed[n] = 0;
+    // don't store anything if edep is zero
+    adder.Terminate();
+    if (adder.fFinalEdep <= 0)
+      continue;
+    // (all "Fill" calls are thread local)
+    fOutputEdepAttribute->FillDValue(adder.fFinalEdep);
+    fOutputPosAttribute->Fill3Value(adder.fFinalPosition);
+    fOutputGlobalTimeAttribute->FillDValue(adder.fFinalTime);
+    fOutputVolumeIDAttribute->FillUValue(l.fVolumeIDs[adder.fFinalIndex]);
+    fOutputEventIDAttribute->FillIValue(eventID);
+    if (fTimeDifferenceFlag)
+      fOutputTimeDifferenceAttribute->FillDValue(adder.fDifferenceTime);
+    if (fNumberOfHitsFlag)
+      fOutputNumberOfHitsAttribute->FillDValue(adder.fNumberOfHits);
+  }
+  l.fUsedAdders.clear();
+}
+
+// Called every time a Run ends
+void GateDigitizerOnlineAdderActor::EndOfRunAction(const G4Run * /*run*/) {
+  fOutputDigiCollection->FillToRootIfNeeded(true);
+}
+
+void GateDigitizerOnlineAdderActor::EndOfSimulationWorkerAction(
+    const G4Run * /*lastRun*/) {
+  // Write only once per worker thread
+  fOutputDigiCollection->Write();
+}
+
+// Called when the simulation end
+void GateDigitizerOnlineAdderActor::EndSimulationAction() {
+  fOutputDigiCollection->Write();
+  fOutputDigiCollection->Close();
+}
@@ -0,0 +1,108 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigitizerOnlineAdderActor_h
+#define GateDigitizerOnlineAdderActor_h
+
+#include "../GateVActor.h"
+#include "G4Cache.hh"
+#include "GateDigiAdderInVolume.h"
+#include "GateDigiCollection.h"
+#include <map>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Create a collection of "singles" directly from the steps, without the
+ * hits collection: same singles as a DigitizerHitsCollectionActor followed
+ * by a DigitizerAdderActor, with only the attributes computed by the adder
+ * (TotalEnergyDeposit, PostPosition, GlobalTime, PreStepUniqueVolumeID,
+ * EventID and optionally TimeDifference and NumberOfHits).
+ *
+ * Every step with a deposited energy updates the adder of its volume: the
+ * adders are indexed by the dense index of the volume ID (see
+ * GateUniqueVolumeIDManager), the group of a volume ID (fGroupVolumeDepth)
+ * is only looked up the first time a thread meets it. The singles of an
+ * event are created in the order of the first step in each volume.
+ */
+
+class GateDigitizerOnlineAdderActor : public GateVActor {
+
+public:
+  explicit GateDigitizerOnlineAdderActor(py::dict &user_info);
+
+  ~GateDigitizerOnlineAdderActor() override;
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  void InitializeCpp() override;
+
+  // Called when the simulation start (master thread only)
+  void StartSimulationAction() override;
+
+  // Called every time a Run starts (all threads)
+  void BeginOfRunAction(const G4Run *run) override;
+
+  // Called every time an Event starts
+  void BeginOfEventAction(const G4Event *event) override;
+
+  // Called every time a batch of step must be processed
+  void SteppingAction(G4Step *step) override;
+
+  // Called every time an Event ends (all threads)
+  void EndOfEventAction(const G4Event *event) override;
+
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Called by every worker when the simulation is about to end
+  void EndOfSimulationWorkerAction(const G4Run * /*lastRun*/) override;
+
+  // Called when the simulation end (master thread only)
+  void EndSimulationAction() override;
+
+  void SetGroupVolumeDepth(int depth);
+
+protected:
+  std::string fOutputDigiCollectionName;
+  GateDigiCollection *fOutputDigiCollection{};
+  int fGroupVolumeDepth;
+  GateDigitizerAdderActor::AdderPolicy fPolicy;
+  bool fTimeDifferenceFlag;
+  bool fNumberOfHitsFlag;
+  int fClearEveryNEvents;
+
+  GateVDigiAttribute *fOutputEdepAttribute{};
+  GateVDigiAttribute *fOutputPosAttribute{};
+  GateVDigiAttribute *fOutputGlobalTimeAttribute{};
+  GateVDigiAttribute *fOutputVolumeIDAttribute{};
+  GateVDigiAttribute *fOutputEventIDAttribute{};
+  GateVDigiAttribute *fOutputTimeDifferenceAttribute{};
+  GateVDigiAttribute *fOutputNumberOfHitsAttribute{};
+
+  // Adder of a volume ID (first time the thread meets it)
+  size_t AddVolumeID(const GateUniqueVolumeID::Pointer &uid);
+
+  // During computation (thread local)
+  struct threadLocalT {
+    // adder of each volume ID (by dense index), -1 if not met yet
+    std::vector<int> fAdderOfVolumeID;
+    // the volume IDs met by this thread (by dense index)
+    std::vector<GateUniqueVolumeID::Pointer> fVolumeIDs;
+    // adder of each group: volume at the group depth and copy numbers
+    std::map<std::pair<const G4VPhysicalVolume *, std::string>, size_t>
+        fAdderOfGroup;
+    // one adder per group, and the adders used by the current event
+    std::vector<GateDigiAdderInVolume> fAdders;
+    std::vector<char> fAdderIsUsed;
+    std::vector<size_t> fUsedAdders;
+  };
+  G4Cache<threadLocalT> fThreadLocalData;
+};
+
+#endif // GateDigitizerOnlineAdderActor_h
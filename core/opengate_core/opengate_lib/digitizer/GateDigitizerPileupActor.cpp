@@ -0,0 +1,68 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateDigitizerPileupActor.h"
+#include "../GateHelpersDict.h"
+
+GateDigitizerPileupActor::GateDigitizerPileupActor(py::dict &user_info)
+    : GateVDigitizerTimeOrderedActor(user_info) {
+  fWindow = 0;
+  fEnergyIndex = 0;
+  fNumberOfPileupSingles = 0;
+}
+
+void GateDigitizerPileupActor::InitializeUserInfo(py::dict &user_info) {
+  GateVDigitizerTimeOrderedActor::InitializeUserInfo(user_info);
+  fWindow = DictGetDouble(user_info, "window");
+}
+
+void GateDigitizerPileupActor::StartSimulationAction() {
+  GateVDigitizerTimeOrderedActor::StartSimulationAction();
+  CheckRequiredAttribute(fInputDigiCollection, "TotalEnergyDeposit");
+  fEnergyIndex = GetInputAttributeIndex("TotalEnergyDeposit");
+}
+
+void GateDigitizerPileupActor::InitializeStream() {
+  fUnits.clear();
+  fOpenWindows.clear();
+  fNumberOfPileupSingles = 0;
+}
+
+void GateDigitizerPileupActor::ProcessDigi(Digi &&digi) {
+  CloseWindows(digi.fTime);
+  const auto index = GetUnitIndex(digi);
+  if (index >= fUnits.size())
+    fUnits.resize(index + 1);
+  auto &unit = fUnits[index];
+  if (unit.fIsOpen) {
+    // pile-up: the energy is added to the first single
+    unit.fDigi.fValues[fEnergyIndex].fD += digi.fValues[fEnergyIndex].fD;
+    fNumberOfPileupSingles++;
+    return;
+  }
+  fOpenWindows.emplace_back(digi.fTime + fWindow, index);
+  unit.fDigi = std::move(digi);
+  unit.fIsOpen = true;
+}
+
+void GateDigitizerPileupActor::EndOfMerge(double watermark, bool flush) {
+  // no single can be merged before the watermark anymore
+  CloseWindows(flush ? fStream.Highest() : watermark);
+}
+
+void GateDigitizerPileupActor::CloseWindows(double time) {
+  while (!fOpenWindows.empty() && fOpenWindows.front().first < time) {
+    auto &unit = fUnits[fOpenWindows.front().second];
+    OutputDigi(unit.fDigi);
+    unit.fIsOpen = false;
+    fOpenWindows.pop_front();
+  }
+}
+
+unsigned long GateDigitizerPileupActor::GetNumberOfPileupSingles() const {
+  return fNumberOfPileupSingles;
+}
@@ -0,0 +1,66 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateDigitizerPileupActor_h
+#define GateDigitizerPileupActor_h
+
+#include "GateVDigitizerTimeOrderedActor.h"
+#include <deque>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Pile-up in the detector units (e.g. crystals or blocks, see
+ * SetGroupVolumeDepth), on the singles in time order (see
+ * GateVDigitizerTimeOrderedActor).
+ *
+ * The singles of a unit within the pile-up window after a first single are
+ * merged into this single: the energies are summed, all the other
+ * attributes are the ones of the first single. The merged single is output
+ * once its window ends, so the output is also in time order.
+ *
+ * The state of a unit is its current merged single (indexed by unit).
+ */
+
+class GateDigitizerPileupActor : public GateVDigitizerTimeOrderedActor {
+
+public:
+  explicit GateDigitizerPileupActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  // Called when the simulation start (master thread only)
+  void StartSimulationAction() override;
+
+  unsigned long GetNumberOfPileupSingles() const;
+
+protected:
+  void InitializeStream() override;
+
+  void ProcessDigi(Digi &&digi) override;
+
+  void EndOfMerge(double watermark, bool flush) override;
+
+  // Output the merged singles whose window ends before the time
+  void CloseWindows(double time);
+
+  double fWindow;
+  size_t fEnergyIndex;
+
+  // Shared by all the threads (lock of the stream)
+  struct Unit {
+    bool fIsOpen = false;
+    Digi fDigi;
+  };
+  std::vector<Unit> fUnits;
+  // end of the open windows, in time order, with their unit
+  std::deque<std::pair<double, size_t>> fOpenWindows;
+  unsigned long fNumberOfPileupSingles;
+};
+
+#endif // GateDigitizerPileupActor_h
@@ -8,18 +8,24 @@
 #include "GateDigitizerProjectionActor.h"
 #include "../GateHelpersDict.h"
 #include "../GateHelpersImage.h"
-#include "G4RunManager.hh"
+#include "../GateMutex.h"
 #include "GateDigiCollectionManager.h"
+#include <cmath>
 #include <iostream>
 
-G4Mutex DigitizerProjectionActorMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(DigitizerProjectionActorMutex);
 
 GateDigitizerProjectionActor::GateDigitizerProjectionActor(py::dict &user_info)
     : GateVActor(user_info, true) {
   fActions.insert("StartSimulationAction");
   fActions.insert("EndOfEventAction");
   fActions.insert("BeginOfRunAction");
+  fActions.insert("EndOfRunAction");
   fPhysicalVolumeName = "None";
+  fSliceSize = 0;
+  fSizeX = 0;
+  fTerminationChannel = -1;
+  fTerminationSNR = 0;
 }
 
 GateDigitizerProjectionActor::~GateDigitizerProjectionActor() = default;
@@ -30,6 +36,19 @@ void GateDigitizerProjectionActor::InitializeUserInfo(py::dict &user_info) {
   fDetectorOrientationMatrix = ConvertToG4RotationMatrix(r);
   fInputDigiCollectionNames =
       DictGetVecStr(user_info, "input_digi_collections");
+  fWindowMin.clear();
+  fWindowMax.clear();
+  auto dv = DictGetVecDict(user_info, "energy_windows");
+  for (auto d : dv) {
+    fWindowMin.push_back(DictGetDouble(d, "min"));
+    fWindowMax.push_back(DictGetDouble(d, "max"));
+  }
+  fTerminationTarget = DictGetInt(user_info, "termination_count");
+  fTerminationSNR = DictGetDouble(user_info, "termination_snr");
+  fTerminationChannel = DictGetInt(user_info, "termination_channel");
+  fTerminationROI.clear();
+  for (auto v : DictGetVecInt(user_info, "termination_roi"))
+    fTerminationROI.push_back(v);
 }
 
 void GateDigitizerProjectionActor::InitializeCpp() {
@@ -48,6 +67,46 @@ void GateDigitizerProjectionActor::StartSimulationAction() {
     auto *hc = hcm->GetDigiCollection(name);
     fInputDigiCollections.push_back(hc);
     CheckRequiredAttribute(hc, "PostPosition");
+    if (!fWindowMin.empty())
+      CheckRequiredAttribute(hc, "TotalEnergyDeposit");
+  }
+  if (!fWindowMin.empty() && fInputDigiCollections.size() != 1) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerProjectionActor '" << GetName()
+        << "': with energy windows, there must be a single input collection";
+    Fatal(oss.str());
+  }
+  // size of the projections (the image is allocated before)
+  auto size = fImage->GetLargestPossibleRegion().GetSize();
+  fSizeX = size[0];
+  fSliceSize = size[0] * size[1];
+
+  // termination criterion: ROI (whole projection by default) and target
+  if (fTerminationROI.empty())
+    fTerminationROI = {0, static_cast<long>(size[0]), 0,
+                       static_cast<long>(size[1])};
+  const auto &roi = fTerminationROI;
+  if (roi.size() != 4 || roi[0] < 0 || roi[0] >= roi[1] ||
+      roi[1] > static_cast<long>(size[0]) || roi[2] < 0 || roi[2] >= roi[3] ||
+      roi[3] > static_cast<long>(size[1])) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerProjectionActor '" << GetName()
+        << "': the termination ROI must be [x0, x1, y0, y1] pixels, with "
+           "0 <= x0 < x1 <= "
+        << size[0] << " and 0 <= y0 < y1 <= " << size[1];
+    Fatal(oss.str());
+  }
+  if (fTerminationChannel >= static_cast<int>(GetNumberOfChannels())) {
+    std::ostringstream oss;
+    oss << "Error in GateDigitizerProjectionActor '" << GetName()
+        << "': the termination channel " << fTerminationChannel
+        << " is not one of the " << GetNumberOfChannels() << " channels";
+    Fatal(oss.str());
+  }
+  if (fTerminationSNR > 0) {
+    auto pixels = (roi[1] - roi[0]) * (roi[3] - roi[2]);
+    fTerminationTarget = static_cast<long>(
+        std::ceil(fTerminationSNR * fTerminationSNR * pixels));
   }
 }
 
@@ -55,6 +114,8 @@ void GateDigitizerProjectionActor::BeginOfRunActionMasterThread(int run_id) {
   // Set the image to the correct position/orientation
   AttachImageToVolume<ImageType>(fImage, fPhysicalVolumeName, G4ThreeVector(),
                                  fDetectorOrientationMatrix);
+  // world to pixel index, computed once per run
+  fIndexTransform.Update(fImage.GetPointer());
 }
 
 void GateDigitizerProjectionActor::BeginOfRunAction(const G4Run *run) {
@@ -63,57 +124,155 @@ void GateDigitizerProjectionActor::BeginOfRunAction(const G4Run *run) {
     // The first time here we need to initialize the input position
     l.fInputPos.resize(fInputDigiCollectionNames.size());
     for (size_t slice = 0; slice < fInputDigiCollections.size(); slice++) {
-      auto *att_pos =
-          fInputDigiCollections[slice]->GetDigiAttribute("PostPosition");
+      // (a selection is read through its indices in the source)
+      auto *hc = fInputDigiCollections[slice];
+      if (hc->GetSelectionSource() != nullptr)
+        hc = hc->GetSelectionSource();
+      auto *att_pos = hc->GetDigiAttribute("PostPosition");
       l.fInputPos[slice] = &att_pos->Get3Values();
+      if (!fWindowMin.empty())
+        l.fInputEdep =
+            &hc->GetDigiAttribute("TotalEnergyDeposit")->GetDValues();
     }
   }
+  l.fStack.assign(fSliceSize * GetNumberOfChannels(), 0);
 }
 
 void GateDigitizerProjectionActor::EndOfEventAction(const G4Event * /*event*/) {
-  G4AutoLock mutex(&DigitizerProjectionActorMutex);
-  auto run = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
-  for (size_t channel = 0; channel < fInputDigiCollections.size(); channel++) {
-    auto slice = channel + run * fInputDigiCollections.size();
-    ProcessSlice(slice, channel);
+  // (thread local stack, no lock)
+  if (!fWindowMin.empty()) {
+    ProcessWindows();
+  } else {
+    for (size_t channel = 0; channel < fInputDigiCollections.size();
+         channel++)
+      ProcessChannel(channel);
   }
+  // (one atomic addition per event with counts)
+  auto &l = fThreadLocalData.Get();
+  if (l.fTerminationCount > 0) {
+    AddTerminationCount(l.fTerminationCount);
+    l.fTerminationCount = 0;
+  }
+}
+
+void GateDigitizerProjectionActor::EndOfRunAction(const G4Run *run) {
+  // add the stack of the thread to the slices of this run
+  auto &l = fThreadLocalData.Get();
+  GateAutoLock mutex(&DigitizerProjectionActorMutex);
+  auto offset = run->GetRunID() * GetNumberOfChannels() * fSliceSize;
+  auto *buffer = fImage->GetBufferPointer() + offset;
+  for (size_t i = 0; i < l.fStack.size(); i++)
+    buffer[i] += l.fStack[i];
 }
 
-void GateDigitizerProjectionActor::ProcessSlice(long slice, size_t channel) {
+void GateDigitizerProjectionActor::ProcessChannel(size_t channel) {
   auto &l = fThreadLocalData.Get();
   auto *hc = fInputDigiCollections[channel];
+  // FIXME store other attributes somewhere ?
+  const auto &pos = *l.fInputPos[channel];
+  auto *projection = l.fStack.data() + channel * fSliceSize;
+  const bool count = fTerminationTarget > 0 && IsTerminationChannel(channel);
+
+  // selection: the positions of the selected digi of the source
+  if (hc->GetSelectionSource() != nullptr) {
+    for (auto i : hc->GetSelectionIndices()) {
+      auto pixel = AddPositionToProjection(pos[i], projection);
+      if (count)
+        l.fTerminationCount += IsInTerminationROI(pixel);
+    }
+    return;
+  }
+
   auto index = hc->GetBeginOfEventIndex();
   auto n = hc->GetSize() - index;
   // If no new hits, do nothing
   if (n <= 0)
     return;
 
-  // FIXME store other attributes somewhere ?
-  const auto &pos = *l.fInputPos[channel];
-  ImageType::PointType point;
-  ImageType::IndexType pindex;
-
   // loop on channels
   for (size_t i = index; i < hc->GetSize(); i++) {
     // get position from input collection
-    for (auto j = 0; j < 3; j++)
-      point[j] = pos[i][j];
-
-    bool isInside = fImage->TransformPhysicalPointToIndex(point, pindex);
-    if (isInside) {
-      // force the slice according to the channel
-      pindex[2] = slice;
-      ImageAddValue<ImageType>(fImage, pindex, 1);
-    } else {
-      // Should never be here (?)
-      /*DDDV(pos);
-      DDE(point);
-      DDE(isInside);
-      DDE(pindex);
-      DDE(slice);
-      DDE(fImage->GetLargestPossibleRegion().GetSize());
-      nout++;
-      DDE(nout);*/
-    }
+    auto pixel = AddPositionToProjection(pos[i], projection);
+    if (count)
+      l.fTerminationCount += IsInTerminationROI(pixel);
+  }
+}
+
+void GateDigitizerProjectionActor::ProcessWindows() {
+  auto &l = fThreadLocalData.Get();
+  auto *hc = fInputDigiCollections[0];
+  const auto &pos = *l.fInputPos[0];
+  const auto &edep = *l.fInputEdep;
+  auto *stack = l.fStack.data();
+
+  // selection: the selected digi of the source
+  if (hc->GetSelectionSource() != nullptr) {
+    for (auto i : hc->GetSelectionIndices())
+      l.fTerminationCount += AddDigiToWindows(pos[i], edep[i], stack);
+    return;
+  }
+  for (size_t i = hc->GetBeginOfEventIndex(); i < hc->GetSize(); i++)
+    l.fTerminationCount += AddDigiToWindows(pos[i], edep[i], stack);
+}
+
+long GateDigitizerProjectionActor::AddDigiToWindows(const G4ThreeVector &p,
+                                                    double edep,
+                                                    float *stack) const {
+  ImageType::IndexType pindex;
+  if (!fIndexTransform.TransformPointToIndex(p, pindex))
+    return 0;
+  // the pixel is the same in all the slices (windows may overlap)
+  const auto pixel = pindex[1] * fSizeX + pindex[0];
+  long counts = 0;
+  for (size_t w = 0; w < fWindowMin.size(); w++) {
+    const int in = (edep >= fWindowMin[w]) & (edep < fWindowMax[w]);
+    stack[w * fSliceSize + pixel] += in;
+    counts += in * IsTerminationChannel(w);
+  }
+  if (fTerminationTarget <= 0 || !IsInTerminationROI(pixel))
+    return 0;
+  return counts;
+}
+
+size_t GateDigitizerProjectionActor::GetNumberOfChannels() const {
+  if (!fWindowMin.empty())
+    return fWindowMin.size();
+  return fInputDigiCollectionNames.size();
+}
+
+bool GateDigitizerProjectionActor::IsInTerminationROI(long pixel) const {
+  if (pixel < 0)
+    return false;
+  const long x = pixel % fSizeX;
+  const long y = pixel / fSizeX;
+  const auto &roi = fTerminationROI;
+  return x >= roi[0] && x < roi[1] && y >= roi[2] && y < roi[3];
+}
+
+bool GateDigitizerProjectionActor::IsTerminationChannel(size_t channel) const {
+  return fTerminationChannel < 0 ||
+         static_cast<size_t>(fTerminationChannel) == channel;
+}
+
+long GateDigitizerProjectionActor::AddPositionToProjection(
+    const G4ThreeVector &p, float *projection) const {
+  ImageType::IndexType pindex;
+  bool isInside = fIndexTransform.TransformPointToIndex(p, pindex);
+  if (isInside) {
+    // (the slice is the one of the channel)
+    const long pixel = pindex[1] * fSizeX + pindex[0];
+    projection[pixel] += 1;
+    return pixel;
+  } else {
+    // Should never be here (?)
+    /*DDDV(pos);
+    DDE(point);
+    DDE(isInside);
+    DDE(pindex);
+    DDE(slice);
+    DDE(fImage->GetLargestPossibleRegion().GetSize());
+    nout++;
+    DDE(nout);*/
   }
+  return -1;
 }
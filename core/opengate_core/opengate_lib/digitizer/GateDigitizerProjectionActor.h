@@ -8,6 +8,7 @@
 #ifndef OPENGATE_CORE_OPENGATEDIGITIZERPROJECTIONACTOR_H
 #define OPENGATE_CORE_OPENGATEDIGITIZERPROJECTIONACTOR_H
 
+#include "../GateHelpersImage.h"
 #include "../GateVActor.h"
 #include "G4Cache.hh"
 #include "GateDigiCollection.h"
@@ -19,7 +20,22 @@ namespace py = pybind11;
 
 /*
  * Actor that create some projections (2D images) from several Digi Collections
- * in the same volume.
+ * in the same volume. The collections can be selections (index lists) of
+ * another one, e.g. the channels of the energy windows with selection_only.
+ *
+ * Each thread counts the digi of the run in its own stack of 2D projections
+ * (one per channel), without lock. The stacks are added to the slices of
+ * the run of the image at the end of the run.
+ *
+ * With energy windows, the channels are the windows of a single input
+ * collection (e.g. the readout digi): the pixel of each digi is computed
+ * once, and the digi is counted in the slices of all its windows, without
+ * an energy windows actor that copies (or selects) the digi per channel.
+ *
+ * Termination criterion (see GateVActor): the counts of one channel (or of
+ * all the channels) in a rectangular ROI of pixels. A target SNR of the ROI
+ * is converted to counts: with Poisson counts, the SNR of the mean pixel of
+ * the ROI is sqrt(N / pixels), so N = SNR^2 * pixels.
  */
 
 class GateDigitizerProjectionActor : public GateVActor {
@@ -45,6 +61,9 @@ public:
   // Called every time an Event ends (all threads)
   void EndOfEventAction(const G4Event *event) override;
 
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
   void SetPhysicalVolumeName(std::string name);
 
   // Image type is 3D float by default
@@ -56,8 +75,42 @@ protected:
   std::vector<std::string> fInputDigiCollectionNames;
   std::vector<GateDigiCollection *> fInputDigiCollections;
   G4RotationMatrix fDetectorOrientationMatrix;
+  // energy windows [min, max[ (empty: one channel per input collection)
+  std::vector<double> fWindowMin;
+  std::vector<double> fWindowMax;
+
+  void ProcessChannel(size_t channel);
+
+  // All the windows of the single input collection, in one pass
+  void ProcessWindows();
+
+  // Count the position in the projections of the windows of the energy
+  // (return the counts of the termination channel, in the ROI)
+  long AddDigiToWindows(const G4ThreeVector &p, double edep,
+                        float *stack) const;
+
+  size_t GetNumberOfChannels() const;
+
+  // Count the position in the projection of a channel (thread local),
+  // return the pixel (-1 if outside)
+  long AddPositionToProjection(const G4ThreeVector &p,
+                               float *projection) const;
+
+  bool IsInTerminationROI(long pixel) const;
+
+  bool IsTerminationChannel(size_t channel) const;
+
+  // world to pixel index transform of the projection image
+  GateImageIndexTransform fIndexTransform;
+  // number of pixels of one projection (one slice)
+  size_t fSliceSize;
+  size_t fSizeX;
 
-  void ProcessSlice(long slice, size_t channel);
+  // termination criterion: channel (-1: all), ROI [x0, x1[ x [y0, y1[ in
+  // pixels, and target SNR (0: the target is a number of counts)
+  int fTerminationChannel;
+  std::vector<long> fTerminationROI;
+  double fTerminationSNR;
 
   G4ThreeVector fPreviousTranslation;
   G4RotationMatrix fPreviousRotation;
@@ -65,6 +118,11 @@ protected:
   // During computation
   struct threadLocalT {
     std::vector<std::vector<G4ThreeVector> *> fInputPos;
+    std::vector<double> *fInputEdep = nullptr;
+    // counts of the run, one projection per channel
+    std::vector<float> fStack;
+    // counts of the event for the termination criterion
+    long fTerminationCount = 0;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
@@ -7,13 +7,18 @@
 
 #include "GateDigitizerReadoutActor.h"
 #include "../GateHelpersDict.h"
+#include "../GateMutex.h"
+#include "G4LogicalVolume.hh"
 #include "G4Navigator.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4VoxelLimits.hh"
 #include "GateDigiAdderInVolume.h"
 #include "GateDigiCollectionManager.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-G4Mutex SetIgnoredHitsMutex = G4MUTEX_INITIALIZER;
+GATE_MUTEX(SetIgnoredHitsMutex);
 
 GateDigitizerReadoutActor::GateDigitizerReadoutActor(py::dict &user_info)
     : GateDigitizerAdderActor(user_info) {
@@ -50,62 +55,130 @@ void GateDigitizerReadoutActor::BeginOfRunAction(const G4Run *run) {
     auto &lr = fThreadLocalReadoutData.Get();
     lr.fNavigator->ResetStackAndState();
   }
+  // (the geometry may change between runs)
+  auto &lr = fThreadLocalReadoutData.Get();
+  lr.fCrystals.clear();
+  lr.fCrystalIndices.clear();
+  lr.fGrid.clear();
+  lr.fGridCellSize = 0;
 }
 
-void GateDigitizerReadoutActor::EndOfEventAction(const G4Event * /*unused*/) {
-  // get thread local data
-  auto &l = fThreadLocalData.Get();
-  auto &lr = fThreadLocalVDigitizerData.Get();
+bool GateDigitizerReadoutActor::TerminateDigi(GateDigiAdderInVolume &adder) {
+  if (!GateDigitizerAdderActor::TerminateDigi(adder))
+    return false;
+
+  // Discretize: first the crystals already met by the thread
+  const auto *crystal = FindCrystal(adder.fFinalPosition);
+  if (crystal != nullptr) {
+    adder.fFinalPosition = crystal->fCenter;
+    return true;
+  }
+
+  // otherwise, find the volume that contains the position
   auto &lro = fThreadLocalReadoutData.Get();
-  // loop on all digi to group per volume ID
-  auto &iter = lr.fInputIter;
-  iter.GoToBegin();
-  while (!iter.IsAtEnd()) {
-    AddDigiPerVolume();
-    iter++;
+  G4TouchableHistory fTouchableHistory;
+  lro.fNavigator->LocateGlobalPointAndUpdateTouchable(adder.fFinalPosition,
+                                                      &fTouchableHistory);
+  auto *vm = GateUniqueVolumeIDManager::GetInstance();
+  const auto &vid = vm->GetVolumeID(&fTouchableHistory);
+
+  /* When computing the centroid, the final position maybe outside the
+   * DiscretizeVolume. In that case, we ignore the hits */
+  if (fDiscretizeVolumeDepth >= vid->GetDepth()) {
+    lro.fIgnoredHitsCount++;
+    return false;
+  }
+  crystal = AddCrystal(vid);
+  if (crystal != nullptr) {
+    adder.fFinalPosition = crystal->fCenter;
+    return true;
   }
+  auto tr = vid->GetLocalToWorldTransform(fDiscretizeVolumeDepth);
+  G4ThreeVector c; // 0,0,0 is the center of the shape
+  tr->ApplyPointTransform(c);
+  adder.fFinalPosition.set(c.getX(), c.getY(), c.getZ());
+  return true;
+}
+
+long long GateDigitizerReadoutActor::GridCellKey(long long i, long long j,
+                                                 long long k) {
+  // 21 bits per axis
+  const long long m = (1LL << 21) - 1;
+  return ((i & m) << 42) | ((j & m) << 21) | (k & m);
+}
 
-  // create the output digi collection for grouped digi
-  for (auto &h : l.fMapOfDigiInVolume) {
-    auto &digi = h.second;
-    // terminate the merge
-    digi->Terminate();
-
-    // Don't store if edep is zero
-    if (digi->fFinalEdep > 0) {
-      // Discretize: find the volume that contains the position
-      G4TouchableHistory fTouchableHistory;
-      lro.fNavigator->LocateGlobalPointAndUpdateTouchable(digi->fFinalPosition,
-                                                          &fTouchableHistory);
-      auto vid = GateUniqueVolumeID::New(&fTouchableHistory);
-
-      /* When computing the centroid, the final position maybe outside the
-       * DiscretizeVolume. In that case, we ignore the hits */
-      if (fDiscretizeVolumeDepth >= vid->GetDepth()) {
-        lro.fIgnoredHitsCount++;
-        continue;
-      }
-      auto tr = vid->GetLocalToWorldTransform(fDiscretizeVolumeDepth);
-      G4ThreeVector c; // 0,0,0 is the center of the shape
-      tr->ApplyPointTransform(c);
-      digi->fFinalPosition.set(c.getX(), c.getY(), c.getZ());
-
-      // (all "Fill" calls are thread local)
-      fOutputEdepAttribute->FillDValue(digi->fFinalEdep);
-      fOutputPosAttribute->Fill3Value(digi->fFinalPosition);
-      fOutputGlobalTimeAttribute->FillDValue(digi->fFinalTime);
-      lr.fDigiAttributeFiller->Fill(digi->fFinalIndex);
-    }
+const GateDigitizerReadoutActor::Crystal *
+GateDigitizerReadoutActor::FindCrystal(const G4ThreeVector &p) {
+  auto &lr = fThreadLocalReadoutData.Get();
+  if (lr.fGridCellSize <= 0)
+    return nullptr;
+  auto cell = [&](double x) {
+    return static_cast<long long>(std::floor(x / lr.fGridCellSize));
+  };
+  auto it = lr.fGrid.find(GridCellKey(cell(p.x()), cell(p.y()), cell(p.z())));
+  if (it == lr.fGrid.end())
+    return nullptr;
+  for (auto index : it->second) {
+    const auto &crystal = lr.fCrystals[index];
+    const auto local = crystal.fWorldToLocal.TransformPoint(p);
+    // (on the surface, the navigator decides)
+    if (crystal.fSolid->Inside(local) == kInside)
+      return &crystal;
   }
+  return nullptr;
+}
+
+const GateDigitizerReadoutActor::Crystal *
+GateDigitizerReadoutActor::AddCrystal(const GateUniqueVolumeID::Pointer &vid) {
+  auto &lr = fThreadLocalReadoutData.Get();
+  const auto depth = fDiscretizeVolumeDepth;
+  const auto &id = vid->GetIdUpToDepth(static_cast<int>(depth));
+  auto found = lr.fCrystalIndices.find(id);
+  if (found != lr.fCrystalIndices.end())
+    return &lr.fCrystals[found->second];
+  // the solid of a parameterised volume depends on the copy
+  auto *pv = vid->GetVolumeDepthID()[depth].fVolume;
+  if (pv->IsParameterised())
+    return nullptr;
+
+  Crystal crystal;
+  const auto *tr = vid->GetLocalToWorldTransform(depth);
+  crystal.fWorldToLocal = tr->Inverse();
+  crystal.fSolid = pv->GetLogicalVolume()->GetSolid();
+  crystal.fCenter = tr->TransformPoint(G4ThreeVector()); // center of the shape
 
-  // reset the structure of digi
-  l.fMapOfDigiInVolume.clear();
+  // bounding box in the world
+  G4VoxelLimits limits;
+  double min[3], max[3];
+  crystal.fSolid->CalculateExtent(kXAxis, limits, *tr, min[0], max[0]);
+  crystal.fSolid->CalculateExtent(kYAxis, limits, *tr, min[1], max[1]);
+  crystal.fSolid->CalculateExtent(kZAxis, limits, *tr, min[2], max[2]);
+  // the cells have the size of the first crystal
+  if (lr.fGridCellSize <= 0)
+    lr.fGridCellSize =
+        std::max({max[0] - min[0], max[1] - min[1], max[2] - min[2]});
+  if (lr.fGridCellSize <= 0)
+    return nullptr;
+
+  const auto index = lr.fCrystals.size();
+  lr.fCrystals.push_back(crystal);
+  lr.fCrystalIndices[id] = index;
+  long long c0[3], c1[3];
+  for (auto a = 0; a < 3; a++) {
+    c0[a] = static_cast<long long>(std::floor(min[a] / lr.fGridCellSize));
+    c1[a] = static_cast<long long>(std::floor(max[a] / lr.fGridCellSize));
+  }
+  for (auto i = c0[0]; i <= c1[0]; i++)
+    for (auto j = c0[1]; j <= c1[1]; j++)
+      for (auto k = c0[2]; k <= c1[2]; k++)
+        lr.fGrid[GridCellKey(i, j, k)].push_back(index);
+  return &lr.fCrystals[index];
 }
 
 void GateDigitizerReadoutActor::EndOfSimulationWorkerAction(
     const G4Run * /*lastRun*/) {
   auto &lr = fThreadLocalReadoutData.Get();
-  G4AutoLock mutex(&SetIgnoredHitsMutex);
+  GateAutoLock mutex(&SetIgnoredHitsMutex);
   fIgnoredHitsCount += lr.fIgnoredHitsCount;
   fOutputDigiCollection->Write();
 }
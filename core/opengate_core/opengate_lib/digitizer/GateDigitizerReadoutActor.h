@@ -11,13 +11,16 @@
 #include "../GateVActor.h"
 #include "G4Cache.hh"
 #include "G4Navigator.hh"
+#include "G4VSolid.hh"
 #include "GateDigiAdderInVolume.h"
 #include "GateDigiCollection.h"
 #include "GateDigiCollectionIterator.h"
 #include "GateDigitizerAdderActor.h"
 #include "GateHelpersDigitizer.h"
 #include "GateTDigiAttribute.h"
+#include <map>
 #include <pybind11/stl.h>
+#include <unordered_map>
 
 namespace py = pybind11;
 
@@ -27,6 +30,13 @@ namespace py = pybind11;
  *
  * The final position is computed according to the center of the given volume
  *
+ * The discretize volumes (crystals) met by a thread are kept in a table
+ * (world to local transform, solid and world center), rebuilt for each
+ * run, with a uniform grid over their bounding boxes. A final position
+ * strictly inside a known crystal gets its center without any navigator
+ * walk, the navigator is only used for the other ones (the crystal is then
+ * added to the table). Parameterised crystals always use the navigator.
+ *
  */
 
 class GateDigiAdderInVolume;
@@ -44,9 +54,6 @@ public:
   // Called every time a Run starts (all threads)
   void BeginOfRunAction(const G4Run *run) override;
 
-  // Called every time an Event ends
-  void EndOfEventAction(const G4Event *event) override;
-
   // Called by every worker when the simulation is about to end
   // (after last run)
   void EndOfSimulationWorkerAction(const G4Run * /*lastRun*/) override;
@@ -56,12 +63,36 @@ public:
   unsigned long GetIgnoredHitsCount() const { return fIgnoredHitsCount; }
 
 protected:
+  // Discretize the final position (false if outside the discretize volume)
+  bool TerminateDigi(GateDigiAdderInVolume &adder) override;
+
+  // A discretize volume met by the thread
+  struct Crystal {
+    G4AffineTransform fWorldToLocal;
+    const G4VSolid *fSolid;
+    G4ThreeVector fCenter;
+  };
+
+  // Find the crystal that contains the point in the table (nullptr if none)
+  const Crystal *FindCrystal(const G4ThreeVector &p);
+
+  // Add the crystal at the discretize depth of the volume ID to the table
+  const Crystal *AddCrystal(const GateUniqueVolumeID::Pointer &vid);
+
+  static long long GridCellKey(long long i, long long j, long long k);
+
   size_t fDiscretizeVolumeDepth;
   unsigned long fIgnoredHitsCount; // global instance
 
   struct threadLocalReadoutT {
     G4Navigator *fNavigator = nullptr;
     unsigned long fIgnoredHitsCount; // thread local instance
+    // crystals of this run, by id up to the discretize depth
+    std::vector<Crystal> fCrystals;
+    std::map<std::string, size_t> fCrystalIndices;
+    // uniform grid: cell key to the crystals that overlap the cell
+    std::unordered_map<long long, std::vector<size_t>> fGrid;
+    double fGridCellSize = 0;
   };
   G4Cache<threadLocalReadoutT> fThreadLocalReadoutData;
 };
@@ -46,12 +46,9 @@ void GateDigitizerSpatialBlurringActor::DigitInitialize(
   // set output pointers to the attributes needed for computation
   fOutputBlurAttribute =
       fOutputDigiCollection->GetDigiAttribute(fBlurAttributeName);
-
-  // set input pointers to the attributes needed for computation
-  auto &l = fThreadLocalData.Get();
+  // the positions of an event are read directly from the input column
   auto &lr = fThreadLocalVDigitizerData.Get();
-  lr.fInputIter.TrackAttribute(fBlurAttributeName, &l.fAtt3Value);
-  lr.fInputIter.TrackAttribute("PostStepUniqueVolumeID", &l.fVolumeId);
+  lr.fInputIter.BindColumn(fBlurAttributeName, fThreadLocalData.Get().fInput);
 }
 
 void GateDigitizerSpatialBlurringActor::BeginOfRunAction(const G4Run *run) {
@@ -77,83 +74,114 @@ void GateDigitizerSpatialBlurringActor::BeginOfRunAction(const G4Run *run) {
     auto &l = fThreadLocalData.Get();
     l.fNavigator->ResetStackAndState();
   }
+  // (the geometry may change between runs)
+  fThreadLocalData.Get().fSolidExtents.clear();
 }
 
 void GateDigitizerSpatialBlurringActor::EndOfEventAction(
     const G4Event * /*unused*/) {
-  // loop on all digi of this events
-  // auto &l = fThreadLocalData.Get();
+  // all the digi of this event
+  auto &l = fThreadLocalData.Get();
   auto &lr = fThreadLocalVDigitizerData.Get();
-  auto &iter = lr.fInputIter;
-  iter.GoToBegin();
-  while (!iter.IsAtEnd()) {
-    // blur the current value
-    BlurCurrentThreeVectorValue();
-    // copy the other attributes
-    auto &i = lr.fInputIter.fIndex;
-    lr.fDigiAttributeFiller->Fill(i);
-    iter++;
+  const auto begin = lr.fInputIter.GetEventBeginIndex();
+  const auto input = lr.fInputIter.GetEventSpan(l.fInput);
+  if (input.size() == 0)
+    return;
+
+  // blur the positions in one pass
+  l.fValues.assign(input.begin(), input.end());
+  BlurThreeVectorValues(l.fValues);
+
+  // store the positions and copy the other attributes
+  for (size_t k = 0; k < l.fValues.size(); k++) {
+    fOutputBlurAttribute->Fill3Value(l.fValues[k]);
+    lr.fDigiAttributeFiller->Fill(begin + k);
   }
 }
 
-void GateDigitizerSpatialBlurringActor::BlurCurrentThreeVectorValue() {
-  // Get the current position
+void GateDigitizerSpatialBlurringActor::ProcessEventBuffer(
+    GateDigiEventBuffer &buffer) {
+  BlurThreeVectorValues(buffer.Get3Values(fBlurAttributeName));
+}
+
+void GateDigitizerSpatialBlurringActor::BlurThreeVectorValues(
+    std::vector<G4ThreeVector> &values) {
+  auto &l = fThreadLocalData.Get();
+  const auto n = values.size();
+  if (n == 0)
+    return;
+  // (x y z of each position, same order as one shoot per component)
+  l.fGauss.resize(3 * n);
+  G4RandGauss::shootArray(static_cast<int>(3 * n), l.fGauss.data());
+  for (size_t i = 0; i < n; i++)
+    values[i] = BlurThreeVectorValue(values[i], &l.fGauss[3 * i]);
+}
+
+const std::array<double, 6> &
+GateDigitizerSpatialBlurringActor::GetSolidExtent(const G4ThreeVector &vec) {
   auto &l = fThreadLocalData.Get();
-  auto &vec = *l.fAtt3Value;
 
   // locate to find the volume that contains the point
-  G4VPhysicalVolume *phys_vol;
-  if (fKeepInSolidLimits) {
-    G4TouchableHistory fTouchableHistory;
-    l.fNavigator->LocateGlobalPointAndUpdateTouchable(vec, &fTouchableHistory);
-    auto vid = GateUniqueVolumeID::New(&fTouchableHistory);
-    phys_vol = vid->GetVolumeDepthID().back().fVolume;
-    // If the volume is parameterised, we consider the parent volume to compute
-    // the extent (otherwise the keep in solid will consider one single instance
-    // of the repeated solid, instead of the whole parameterised volume).
-    if (phys_vol->IsParameterised()) {
-      auto n = vid->GetVolumeDepthID().size();
-      phys_vol = vid->GetVolumeDepthID()[n - 2].fVolume;
-    }
+  G4TouchableHistory fTouchableHistory;
+  l.fNavigator->LocateGlobalPointAndUpdateTouchable(vec, &fTouchableHistory);
+  auto *vm = GateUniqueVolumeIDManager::GetInstance();
+  const auto &vid = vm->GetVolumeID(&fTouchableHistory);
+  auto *phys_vol = vid->GetVolumeDepthID().back().fVolume;
+  // If the volume is parameterised, we consider the parent volume to compute
+  // the extent (otherwise the keep in solid will consider one single instance
+  // of the repeated solid, instead of the whole parameterised volume).
+  if (phys_vol->IsParameterised()) {
+    auto n = vid->GetVolumeDepthID().size();
+    phys_vol = vid->GetVolumeDepthID()[n - 2].fVolume;
   }
 
+  // the extent of a solid is only computed once
+  const auto *solid = phys_vol->GetLogicalVolume()->GetSolid();
+  auto it = l.fSolidExtents.find(solid);
+  if (it != l.fSolidExtents.end())
+    return it->second;
+  G4VoxelLimits limits;
+  G4AffineTransform at;
+  std::array<double, 6> e{};
+  solid->CalculateExtent(kXAxis, limits, at, e[0], e[1]);
+  solid->CalculateExtent(kYAxis, limits, at, e[2], e[3]);
+  solid->CalculateExtent(kZAxis, limits, at, e[4], e[5]);
+  return l.fSolidExtents.emplace(solid, e).first->second;
+}
+
+G4ThreeVector GateDigitizerSpatialBlurringActor::BlurThreeVectorValue(
+    const G4ThreeVector &vec, const double *gauss) {
+  // limits of the volume that contains the point (before blurring)
+  const std::array<double, 6> *extent = nullptr;
+  if (fKeepInSolidLimits)
+    extent = &GetSolidExtent(vec);
+
   // consider local position
   auto v = fWorldToVolume.TransformPoint(vec);
-  G4ThreeVector p(G4RandGauss::shoot(v.getX(), fBlurSigma3.getX()),
-                  G4RandGauss::shoot(v.getY(), fBlurSigma3.getY()),
-                  G4RandGauss::shoot(v.getZ(), fBlurSigma3.getZ()));
+  G4ThreeVector p(gauss[0] * fBlurSigma3.getX() + v.getX(),
+                  gauss[1] * fBlurSigma3.getY() + v.getY(),
+                  gauss[2] * fBlurSigma3.getZ() + v.getZ());
 
   if (fKeepInSolidLimits) {
     // check limits according to the volume
-    G4VoxelLimits limits;
-    G4double Xmin, Xmax, Ymin, Ymax, Zmin, Zmax;
-    G4AffineTransform at;
-
-    auto solid = phys_vol->GetLogicalVolume()->GetSolid();
-    solid->CalculateExtent(kXAxis, limits, at, Xmin, Xmax);
-    solid->CalculateExtent(kYAxis, limits, at, Ymin, Ymax);
-    solid->CalculateExtent(kZAxis, limits, at, Zmin, Zmax);
-
+    const auto &e = *extent;
     static const double tiny = 1 * CLHEP::nm;
 
-    if (p.getX() < Xmin)
-      p.setX(Xmin + tiny);
-    if (p.getY() < Ymin)
-      p.setY(Ymin + tiny);
-    if (p.getZ() < Zmin)
-      p.setZ(Zmin + tiny);
-
-    if (p.getX() > Xmax)
-      p.setX(Xmax - tiny);
-    if (p.getY() > Ymax)
-      p.setY(Ymax - tiny);
-    if (p.getZ() > Zmax)
-      p.setZ(Zmax - tiny);
+    if (p.getX() < e[0])
+      p.setX(e[0] + tiny);
+    if (p.getY() < e[2])
+      p.setY(e[2] + tiny);
+    if (p.getZ() < e[4])
+      p.setZ(e[4] + tiny);
+
+    if (p.getX() > e[1])
+      p.setX(e[1] - tiny);
+    if (p.getY() > e[3])
+      p.setY(e[3] - tiny);
+    if (p.getZ() > e[5])
+      p.setZ(e[5] - tiny);
   }
 
   // convert back to global position
-  p = fVolumeToWorld.TransformPoint(p);
-
-  // store
-  fOutputBlurAttribute->Fill3Value(p);
+  return fVolumeToWorld.TransformPoint(p);
 }
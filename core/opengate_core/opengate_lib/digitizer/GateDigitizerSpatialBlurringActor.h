@@ -16,12 +16,19 @@
 #include "GateVDigitizerWithOutputActor.h"
 #include <G4Cache.hh>
 #include <G4Navigator.hh>
+#include <array>
+#include <map>
 #include <pybind11/stl.h>
 
 namespace py = pybind11;
 
 /*
  * Digitizer module for blurring a (global) spatial position.
+ *
+ * All the positions of an event are blurred in one pass: the Gaussian
+ * numbers (x y z of each position) are drawn in bulk, in the same order as
+ * with one G4RandGauss::shoot per component. With keep_in_solid_limits, the
+ * extent of each solid is computed once per run.
  */
 
 class GateDigitizerSpatialBlurringActor : public GateVDigitizerWithOutputActor {
@@ -41,11 +48,21 @@ public:
   // Called every time an Event ends (all threads)
   void EndOfEventAction(const G4Event *event) override;
 
+  // Fused chain: blur the positions in the buffer
+  void ProcessEventBuffer(GateDigiEventBuffer &buffer) override;
+
 protected:
   void DigitInitialize(
       const std::vector<std::string> &attributes_not_in_filler) override;
 
-  void BlurCurrentThreeVectorValue();
+  // Blur all the positions (in place)
+  void BlurThreeVectorValues(std::vector<G4ThreeVector> &values);
+
+  G4ThreeVector BlurThreeVectorValue(const G4ThreeVector &vec,
+                                     const double *gauss);
+
+  // Limits of the solid that contains the (global) position
+  const std::array<double, 6> &GetSolidExtent(const G4ThreeVector &vec);
 
   std::string fBlurAttributeName;
   G4ThreeVector fBlurSigma3;
@@ -56,9 +73,13 @@ protected:
 
   // During computation (thread local)
   struct threadLocalT {
-    GateUniqueVolumeID::Pointer *fVolumeId;
-    G4ThreeVector *fAtt3Value{};
+    // input positions of the blurred attribute
+    GateDigiCollection::Iterator::Column<G4ThreeVector> fInput;
     G4Navigator *fNavigator = nullptr;
+    std::vector<G4ThreeVector> fValues;
+    std::vector<double> fGauss;
+    // xmin xmax ymin ymax zmin zmax of the solids (reset for each run)
+    std::map<const G4VSolid *, std::array<double, 6>> fSolidExtents;
   };
   G4Cache<threadLocalT> fThreadLocalData;
 };
@@ -6,6 +6,7 @@
    -------------------------------------------------- */
 
 #include "GateHelpersDigitizer.h"
+#include "GateDigiSchema.h"
 
 // Check attribute
 void CheckRequiredAttribute(const GateDigiCollection *hc,
@@ -18,6 +19,19 @@ void CheckRequiredAttribute(const GateDigiCollection *hc,
   }
 }
 
+void CheckIsNotSelection(const GateDigiCollection *hc,
+                         const std::string &actorName) {
+  if (hc->GetSelectionSource() != nullptr) {
+    std::ostringstream oss;
+    oss << "The DigiCollection '" << hc->GetName()
+        << "' is only a selection of '" << hc->GetSelectionSource()->GetName()
+        << "' (selection_only option of the energy windows) and cannot be "
+           "the input of '"
+        << actorName << "'. Abort";
+    Fatal(oss.str());
+  }
+}
+
 GateDigiAttributesFiller::GateDigiAttributesFiller(
     GateDigiCollection *input, GateDigiCollection *output,
     const std::set<std::string> &names) {
@@ -25,9 +39,16 @@ GateDigiAttributesFiller::GateDigiAttributesFiller(
     fInputDigiAttributes.push_back(input->GetDigiAttribute(att_name));
     fOutputDigiAttributes.push_back(output->GetDigiAttribute(att_name));
   }
+  fInputSchema = GateNewDigiSchemaColumns(input, names);
+  if (fInputSchema != nullptr)
+    fOutputSchema = GateNewDigiSchemaColumns(output, names);
 }
 
 void GateDigiAttributesFiller::Fill(size_t index) {
+  if (fOutputSchema != nullptr) {
+    fInputSchema->CopyTo(index, fOutputSchema.get());
+    return;
+  }
   for (size_t i = 0; i < fInputDigiAttributes.size(); i++) {
     fOutputDigiAttributes[i]->Fill(fInputDigiAttributes[i], index);
   }
@@ -11,11 +11,21 @@
 #include "G4TouchableHistory.hh"
 #include "GateDigiCollection.h"
 #include "GateVDigiAttribute.h"
+#include <memory>
 #include <pybind11/stl.h>
 
 void CheckRequiredAttribute(const GateDigiCollection *hc,
                             const std::string &name);
 
+// The collection must have values (not only a selection of another one)
+void CheckIsNotSelection(const GateDigiCollection *hc,
+                         const std::string &actorName);
+
+class GateVDigiSchemaColumns;
+
+// Copy the given attributes of the input digi to the output. When the
+// attributes are the ones of a built-in schema (see GateDigiSchema), the digi
+// is copied as a typed record. Must be created in the thread that fills.
 class GateDigiAttributesFiller {
 public:
   GateDigiAttributesFiller(GateDigiCollection *input,
@@ -26,6 +36,8 @@ public:
 
   std::vector<GateVDigiAttribute *> fInputDigiAttributes;
   std::vector<GateVDigiAttribute *> fOutputDigiAttributes;
+  std::shared_ptr<GateVDigiSchemaColumns> fInputSchema;
+  std::shared_ptr<GateVDigiSchemaColumns> fOutputSchema;
 };
 
 #endif // OPENGATE_CORE_OPENGATEHELPERDIGITIZER_H
@@ -8,6 +8,86 @@
 #include "GateTDigiAttribute.h"
 #include "G4RootAnalysisManager.hh"
 #include "GateDigiCollectionsRootManager.h"
+#include <algorithm>
+
+namespace {
+
+// Code of the string in the dictionary of the thread (added if needed).
+// Consecutive digis often have the same value, it is checked first.
+template <class L> std::uint32_t Encode(L &l, const std::string &value) {
+  if (!l.fDictionary.empty() && l.fDictionary[l.fLastCode] == value)
+    return l.fLastCode;
+  auto it = l.fCodes.find(value);
+  if (it != l.fCodes.end()) {
+    l.fLastCode = it->second;
+    return it->second;
+  }
+  auto code = static_cast<std::uint32_t>(l.fDictionary.size());
+  l.fDictionary.push_back(value);
+  l.fCodes[value] = code;
+  l.fLastCode = code;
+  return code;
+}
+
+// Fill the value of the digi in the column(s) of the tuple
+template <class T>
+void FillValueToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                     const GateTDigiAttributeValues<T> &l, size_t index);
+
+template <>
+void FillValueToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                     const GateTDigiAttributeValues<double> &l, size_t index) {
+  ram->FillNtupleDColumn(tupleId, attributeId, l.fValues[index]);
+}
+
+template <>
+void FillValueToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                     const GateTDigiAttributeValues<int> &l, size_t index) {
+  ram->FillNtupleIColumn(tupleId, attributeId, l.fValues[index]);
+}
+
+template <>
+void FillValueToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                     const GateTDigiAttributeValues<std::string> &l,
+                     size_t index) {
+  ram->FillNtupleSColumn(tupleId, attributeId, l.fDictionary[l.fValues[index]]);
+}
+
+template <>
+void FillValueToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                     const GateTDigiAttributeValues<G4ThreeVector> &l,
+                     size_t index) {
+  const auto &v = l.fValues[index];
+  ram->FillNtupleDColumn(tupleId, attributeId, v[0]);
+  ram->FillNtupleDColumn(tupleId, attributeId + 1, v[1]);
+  ram->FillNtupleDColumn(tupleId, attributeId + 2, v[2]);
+}
+
+template <>
+void FillValueToRoot(
+    G4RootAnalysisManager *ram, int tupleId, int attributeId,
+    const GateTDigiAttributeValues<GateUniqueVolumeID::Pointer> &l,
+    size_t index) {
+  ram->FillNtupleSColumn(tupleId, attributeId, l.fValues[index]->GetID());
+}
+
+} // namespace
+
+template <class T>
+void GateTDigiValuesBuffer<T>::FillToRoot(G4RootAnalysisManager *ram,
+                                          int tupleId, int attributeId,
+                                          size_t index) const {
+  FillValueToRoot(ram, tupleId, attributeId, fValues, index);
+}
+
+template <class T> void GateTDigiValuesBuffer<T>::Clear() {
+  fValues.fValues.clear();
+}
+
+template <> void GateTDigiValuesBuffer<std::string>::Clear() {
+  fValues.fValues.clear();
+  fValues.fDictionary.clear();
+}
 
 template <class T>
 GateTDigiAttribute<T>::GateTDigiAttribute(std::string vname)
@@ -33,7 +113,8 @@ template <class T> void GateTDigiAttribute<T>::FillDValue(double) {
   Fatal("Cannot use FillDValue for this type");
 }
 
-template <class T> void GateTDigiAttribute<T>::FillSValue(std::string) {
+template <class T>
+void GateTDigiAttribute<T>::FillSValue(const std::string & /*unused*/) {
   DDE(fDigiAttributeType);
   DDE(fDigiAttributeName);
   Fatal("Cannot use FillSValue for this type");
@@ -52,7 +133,7 @@ template <class T> void GateTDigiAttribute<T>::Fill3Value(G4ThreeVector) {
 }
 
 template <class T>
-void GateTDigiAttribute<T>::FillUValue(GateUniqueVolumeID::Pointer) {
+void GateTDigiAttribute<T>::FillUValue(const GateUniqueVolumeID::Pointer &) {
   DDE(fDigiAttributeType);
   DDE(fDigiAttributeName);
   Fatal("Cannot use FillUValue for this type");
@@ -87,9 +168,35 @@ std::vector<GateUniqueVolumeID::Pointer> &GateTDigiAttribute<T>::GetUValues() {
 }
 
 template <class T> void GateTDigiAttribute<T>::Clear() {
+  // (clear keeps the capacity: no allocation for the next digi)
   threadLocalData.Get().fValues.clear();
 }
 
+template <class T> void GateTDigiAttribute<T>::MoveLastTo(size_t index) {
+  // (for the strings, the code is moved)
+  auto &values = threadLocalData.Get().fValues;
+  if (index + 1 < values.size())
+    values[index] = std::move(values.back());
+  values.pop_back();
+}
+
+template <class T> void GateTDigiAttribute<T>::EraseFirst(size_t n) {
+  // (for the strings, the codes are erased, the dictionary is kept)
+  auto &values = threadLocalData.Get().fValues;
+  n = std::min(n, values.size());
+  values.erase(values.begin(), values.begin() + n);
+}
+
+template <class T> void GateTDigiAttribute<T>::Reserve(size_t n) {
+  auto &values = threadLocalData.Get().fValues;
+  if (values.capacity() < n)
+    values.reserve(n);
+}
+
+template <class T> size_t GateTDigiAttribute<T>::GetMemoryBytes() const {
+  return threadLocalData.Get().fValues.capacity() * sizeof(T);
+}
+
 template <class T>
 const std::vector<T> &GateTDigiAttribute<T>::GetValues() const {
   return threadLocalData.Get().fValues;
@@ -109,12 +216,18 @@ template <class T> void GateTDigiAttribute<T>::FillDigiWithEmptyValue() {
         "type");
 }
 
+template <class T> void GateTDigiAttribute<T>::FillToRoot(size_t index) const {
+  FillValueToRoot(G4RootAnalysisManager::Instance(), fTupleId, fDigiAttributeId,
+                  threadLocalData.Get(), index);
+}
+
 template <class T>
-void GateTDigiAttribute<T>::FillToRoot(size_t /*index*/) const {
-  DDE(fDigiAttributeType);
-  DDE(fDigiAttributeName);
-  Fatal(
-      "Must not be here, FillToRootIfNeeded must be specialized for this type");
+void GateTDigiAttribute<T>::SwapValues(
+    std::unique_ptr<GateVDigiValuesBuffer> &buffer) {
+  if (buffer == nullptr)
+    buffer = std::make_unique<GateTDigiValuesBuffer<T>>();
+  auto *b = static_cast<GateTDigiValuesBuffer<T> *>(buffer.get());
+  threadLocalData.Get().fValues.swap(b->fValues.fValues);
 }
 
 template <class T> std::string GateTDigiAttribute<T>::Dump(int i) const {
@@ -163,7 +276,8 @@ template <> void GateTDigiAttribute<int>::FillDigiWithEmptyValue() {
 }
 
 template <> void GateTDigiAttribute<std::string>::FillDigiWithEmptyValue() {
-  threadLocalData.Get().fValues.push_back("");
+  auto &l = threadLocalData.Get();
+  l.fValues.push_back(Encode(l, ""));
 }
 
 template <> void GateTDigiAttribute<G4ThreeVector>::FillDigiWithEmptyValue() {
@@ -172,8 +286,8 @@ template <> void GateTDigiAttribute<G4ThreeVector>::FillDigiWithEmptyValue() {
 
 template <>
 void GateTDigiAttribute<GateUniqueVolumeID::Pointer>::FillDigiWithEmptyValue() {
-  auto t = GateUniqueVolumeID::New();
-  threadLocalData.Get().fValues.push_back(t);
+  // (shared undefined volume ID, no allocation per digi)
+  threadLocalData.Get().fValues.push_back(GateUniqueVolumeID::GetEmpty());
 }
 
 template <> void GateTDigiAttribute<double>::FillDValue(double value) {
@@ -181,8 +295,9 @@ template <> void GateTDigiAttribute<double>::FillDValue(double value) {
 }
 
 template <>
-void GateTDigiAttribute<std::string>::FillSValue(std::string value) {
-  threadLocalData.Get().fValues.push_back(value);
+void GateTDigiAttribute<std::string>::FillSValue(const std::string &value) {
+  auto &l = threadLocalData.Get();
+  l.fValues.push_back(Encode(l, value));
 }
 
 template <> void GateTDigiAttribute<int>::FillIValue(int value) {
@@ -196,57 +311,74 @@ void GateTDigiAttribute<G4ThreeVector>::Fill3Value(G4ThreeVector value) {
 
 template <>
 void GateTDigiAttribute<GateUniqueVolumeID::Pointer>::FillUValue(
-    GateUniqueVolumeID::Pointer value) {
+    const GateUniqueVolumeID::Pointer &value) {
   threadLocalData.Get().fValues.push_back(value);
 }
 
-template <> void GateTDigiAttribute<double>::FillToRoot(size_t index) const {
-  auto *ram = G4RootAnalysisManager::Instance();
-  auto v = threadLocalData.Get().fValues[index];
-  ram->FillNtupleDColumn(fTupleId, fDigiAttributeId, v);
+template <> std::vector<double> &GateTDigiAttribute<double>::GetDValues() {
+  return threadLocalData.Get().fValues;
 }
 
-template <> void GateTDigiAttribute<int>::FillToRoot(size_t index) const {
-  auto *ram = G4RootAnalysisManager::Instance();
-  auto v = threadLocalData.Get().fValues[index];
-  ram->FillNtupleIColumn(fTupleId, fDigiAttributeId, v);
+template <> std::vector<int> &GateTDigiAttribute<int>::GetIValues() {
+  return threadLocalData.Get().fValues;
 }
 
 template <>
-void GateTDigiAttribute<std::string>::FillToRoot(size_t index) const {
-  auto *ram = G4RootAnalysisManager::Instance();
-  auto v = threadLocalData.Get().fValues[index];
-  ram->FillNtupleSColumn(fTupleId, fDigiAttributeId, v);
+std::vector<std::string> &GateTDigiAttribute<std::string>::GetSValues() {
+  auto &l = threadLocalData.Get();
+  l.fDecodedValues.clear();
+  for (auto code : l.fValues)
+    l.fDecodedValues.push_back(l.fDictionary[code]);
+  return l.fDecodedValues;
 }
 
 template <>
-void GateTDigiAttribute<G4ThreeVector>::FillToRoot(size_t index) const {
-  auto *ram = G4RootAnalysisManager::Instance();
-  auto v = threadLocalData.Get().fValues[index];
-  ram->FillNtupleDColumn(fTupleId, fDigiAttributeId, v[0]);
-  ram->FillNtupleDColumn(fTupleId, fDigiAttributeId + 1, v[1]);
-  ram->FillNtupleDColumn(fTupleId, fDigiAttributeId + 2, v[2]);
+const std::vector<std::string> &
+GateTDigiAttribute<std::string>::GetValues() const {
+  auto &l = threadLocalData.Get();
+  l.fDecodedValues.clear();
+  for (auto code : l.fValues)
+    l.fDecodedValues.push_back(l.fDictionary[code]);
+  return l.fDecodedValues;
 }
 
 template <>
-void GateTDigiAttribute<GateUniqueVolumeID::Pointer>::FillToRoot(
-    size_t index) const {
-  auto *ram = G4RootAnalysisManager::Instance();
-  auto v = threadLocalData.Get().fValues[index]->fID;
-  ram->FillNtupleSColumn(fTupleId, fDigiAttributeId, v);
+void GateTDigiAttribute<std::string>::Fill(GateVDigiAttribute *input,
+                                           size_t index) {
+  // the dictionaries of the two attributes are not the same
+  auto tinput = static_cast<GateTDigiAttribute<std::string> *>(input);
+  const auto &li = tinput->threadLocalData.Get();
+  auto &l = threadLocalData.Get();
+  l.fValues.push_back(Encode(l, li.fDictionary[li.fValues[index]]));
 }
 
-template <> std::vector<double> &GateTDigiAttribute<double>::GetDValues() {
-  return threadLocalData.Get().fValues;
-}
-
-template <> std::vector<int> &GateTDigiAttribute<int>::GetIValues() {
-  return threadLocalData.Get().fValues;
+template <>
+void GateTDigiAttribute<std::string>::SwapValues(
+    std::unique_ptr<GateVDigiValuesBuffer> &buffer) {
+  if (buffer == nullptr)
+    buffer = std::make_unique<GateTDigiValuesBuffer<std::string>>();
+  auto *b = static_cast<GateTDigiValuesBuffer<std::string> *>(buffer.get());
+  auto &l = threadLocalData.Get();
+  l.fValues.swap(b->fValues.fValues);
+  // the codes are decoded with a copy of the dictionary of the thread
+  b->fValues.fDictionary = l.fDictionary;
 }
 
 template <>
-std::vector<std::string> &GateTDigiAttribute<std::string>::GetSValues() {
-  return threadLocalData.Get().fValues;
+size_t GateTDigiAttribute<std::string>::GetMemoryBytes() const {
+  // codes, dictionary (the hash table is not counted) and decoded values
+  const auto &l = threadLocalData.Get();
+  auto bytes = l.fValues.capacity() * sizeof(std::uint32_t);
+  bytes += l.fDictionary.capacity() * sizeof(std::string);
+  for (const auto &s : l.fDictionary)
+    bytes += s.capacity();
+  bytes += l.fDecodedValues.capacity() * sizeof(std::string);
+  return bytes;
+}
+
+template <> std::string GateTDigiAttribute<std::string>::Dump(int i) const {
+  const auto &l = threadLocalData.Get();
+  return l.fDictionary[l.fValues[i]];
 }
 
 template <>
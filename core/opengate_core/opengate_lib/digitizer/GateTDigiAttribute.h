@@ -9,9 +9,40 @@
 #define GateTDigiAttribute_h
 
 #include "../GateHelpers.h"
+#include "../GateThreadContext.h"
 #include "../GateUniqueVolumeID.h"
 #include "GateVDigiAttribute.h"
+#include <cstdint>
 #include <pybind11/stl.h>
+#include <unordered_map>
+
+// Values of an attribute for one thread
+template <class T> struct GateTDigiAttributeValues {
+  std::vector<T> fValues;
+};
+
+// The strings are dictionary-encoded: each thread keeps the table of the
+// distinct values, and stores only the index in this table for each digi
+// (no string allocated per digi). The values are decoded in FillToRoot.
+template <> struct GateTDigiAttributeValues<std::string> {
+  std::vector<std::uint32_t> fValues;
+  std::vector<std::string> fDictionary;
+  std::unordered_map<std::string, std::uint32_t> fCodes;
+  std::uint32_t fLastCode = 0;
+  // decoded copy of the values (GetSValues and GetValues only)
+  std::vector<std::string> fDecodedValues;
+};
+
+// Values of an attribute moved out of a thread
+template <class T> class GateTDigiValuesBuffer : public GateVDigiValuesBuffer {
+public:
+  void FillToRoot(G4RootAnalysisManager *ram, int tupleId, int attributeId,
+                  size_t index) const override;
+
+  void Clear() override;
+
+  GateTDigiAttributeValues<T> fValues;
+};
 
 template <class T> class GateTDigiAttribute : public GateVDigiAttribute {
 public:
@@ -35,13 +66,13 @@ public:
 
   void FillDValue(double v) override;
 
-  void FillSValue(std::string v) override;
+  void FillSValue(const std::string &v) override;
 
   void FillIValue(int v) override;
 
   void Fill3Value(G4ThreeVector v) override;
 
-  void FillUValue(GateUniqueVolumeID::Pointer v) override;
+  void FillUValue(const GateUniqueVolumeID::Pointer &v) override;
 
   void Fill(GateVDigiAttribute *input, size_t index) override;
 
@@ -49,13 +80,22 @@ public:
 
   void Clear() override;
 
+  void MoveLastTo(size_t index) override;
+
+  void EraseFirst(size_t n) override;
+
+  void Reserve(size_t n) override;
+
+  size_t GetMemoryBytes() const override;
+
+  void SwapValues(std::unique_ptr<GateVDigiValuesBuffer> &buffer) override;
+
   std::string Dump(int i) const override;
 
 protected:
-  struct threadLocal_t {
-    std::vector<T> fValues;
-  };
-  G4Cache<threadLocal_t> threadLocalData;
+  // values of the thread (see GateTDigiAttributeValues)
+  typedef GateTDigiAttributeValues<T> threadLocal_t;
+  GateThreadLocal<threadLocal_t> threadLocalData;
 
   void InitDefaultProcessHitsFunction();
 };
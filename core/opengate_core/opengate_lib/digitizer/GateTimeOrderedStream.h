@@ -0,0 +1,178 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateTimeOrderedStream_h
+#define GateTimeOrderedStream_h
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/*
+ * Merge the items (e.g. singles) of all the threads into one stream in
+ * global time order.
+ *
+ * Each thread pushes its items (in any order within an event) and
+ * publishes a watermark: the time before which it will not push anything
+ * anymore, e.g. the T0 of its current event (the events of a thread are in
+ * time order, as with the sources with an activity). An item is ready once
+ * it is before the watermark of all the threads: Merge outputs the ready
+ * items, in time order, with a k-way merge (heap of the first item of each
+ * thread).
+ *
+ * The memory is bounded: when more than the maximum number of items are
+ * waiting, the oldest ones are output anyway (forced items). Items pushed
+ * before an item already output are late: they are output as soon as
+ * possible, out of order. Both are counted.
+ *
+ * The stream is shared by the threads: all the functions, except the
+ * configuration ones, must be called with the lock (GetMutex) held. The
+ * consumer of the stream (Merge output) is then also protected.
+ */
+
+template <class T> class GateTimeOrderedStream {
+public:
+  explicit GateTimeOrderedStream(size_t max_size = 1000000) {
+    fMaximumSize = max_size;
+    SetNumberOfThreads(1);
+  }
+
+  std::mutex &GetMutex() { return fMutex; }
+
+  // Configuration (before the simulation, no lock)
+  void SetNumberOfThreads(int n) {
+    fQueues.assign(std::max(1, n), {});
+    fWatermarks.assign(fQueues.size(), Lowest());
+    Clear();
+  }
+
+  void SetMaximumSize(size_t n) { fMaximumSize = std::max<size_t>(1, n); }
+
+  size_t GetNumberOfThreads() const { return fQueues.size(); }
+
+  // Remove all the items and set all the watermarks to the lowest time
+  void Clear() {
+    for (auto &q : fQueues)
+      q.clear();
+    fHeads = {};
+    Restart();
+    fSize = 0;
+    fLastTime = Lowest();
+    fNumberOfForcedItems = 0;
+    fNumberOfLateItems = 0;
+  }
+
+  // All the threads start again (e.g. next run): lowest watermarks
+  void Restart() {
+    std::fill(fWatermarks.begin(), fWatermarks.end(), Lowest());
+  }
+
+  // The thread will not push items before this time (never decreases)
+  void SetWatermark(int thread, double time) {
+    auto &w = fWatermarks[thread];
+    w = std::max(w, time);
+  }
+
+  // The thread will not push anything anymore (e.g. end of run)
+  void EndOfStream(int thread) { fWatermarks[thread] = Highest(); }
+
+  bool IsEnded() const {
+    return std::all_of(fWatermarks.begin(), fWatermarks.end(),
+                       [](double w) { return w == Highest(); });
+  }
+
+  // Minimum of the watermarks: all the items before are known
+  double GetWatermark() const {
+    return *std::min_element(fWatermarks.begin(), fWatermarks.end());
+  }
+
+  void Push(int thread, double time, T item) {
+    if (time < fLastTime)
+      fNumberOfLateItems++;
+    auto &q = fQueues[thread];
+    // the items of a thread are nearly sorted: insert from the end
+    if (q.empty() || time >= q.back().first) {
+      q.emplace_back(time, std::move(item));
+    } else {
+      auto it = std::upper_bound(
+          q.begin(), q.end(), time,
+          [](double t, const Item &i) { return t < i.first; });
+      q.emplace(it, time, std::move(item));
+    }
+    // new first item of the queue
+    if (q.front().first == time)
+      fHeads.emplace(time, thread);
+    fSize++;
+  }
+
+  // Output (output(time, item)) the ready items in time order, or all of
+  // them if flush
+  template <class F> void Merge(F &&output, bool flush = false) {
+    const auto watermark = flush ? Highest() : GetWatermark();
+    while (!fHeads.empty()) {
+      auto head = fHeads.top();
+      auto &q = fQueues[head.second];
+      // outdated head (the first item of the queue changed)
+      if (q.empty() || q.front().first != head.first) {
+        fHeads.pop();
+        continue;
+      }
+      if (head.first >= watermark) {
+        if (fSize <= fMaximumSize)
+          break;
+        fNumberOfForcedItems++;
+      }
+      fHeads.pop();
+      auto item = std::move(q.front());
+      q.pop_front();
+      fSize--;
+      if (!q.empty())
+        fHeads.emplace(q.front().first, head.second);
+      fLastTime = std::max(fLastTime, item.first);
+      output(item.first, std::move(item.second));
+    }
+  }
+
+  size_t GetSize() const { return fSize; }
+
+  // Items output before the watermark, because the stream was full
+  unsigned long GetNumberOfForcedItems() const { return fNumberOfForcedItems; }
+
+  // Items pushed before an item already output (out of order)
+  unsigned long GetNumberOfLateItems() const { return fNumberOfLateItems; }
+
+  static constexpr double Lowest() {
+    return std::numeric_limits<double>::lowest();
+  }
+
+  static constexpr double Highest() {
+    return std::numeric_limits<double>::max();
+  }
+
+protected:
+  typedef std::pair<double, T> Item;
+  typedef std::pair<double, int> Head;
+
+  std::mutex fMutex;
+  size_t fMaximumSize;
+  // items of each thread, in time order
+  std::vector<std::deque<Item>> fQueues;
+  // first item of the queues (earliest first)
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> fHeads;
+  std::vector<double> fWatermarks;
+  size_t fSize;
+  double fLastTime;
+  unsigned long fNumberOfForcedItems;
+  unsigned long fNumberOfLateItems;
+};
+
+#endif // GateTimeOrderedStream_h
@@ -11,8 +11,23 @@
 #include "../GateHelpers.h"
 #include "../GateUniqueVolumeID.h"
 #include "G4TouchableHistory.hh"
+#include <memory>
 #include <pybind11/stl.h>
 
+class G4RootAnalysisManager;
+
+// Values of an attribute moved out of a thread (see SwapValues), to be written
+// in the root tuple by another thread (GateDigiAsyncWriter)
+class GateVDigiValuesBuffer {
+public:
+  virtual ~GateVDigiValuesBuffer() = default;
+
+  virtual void FillToRoot(G4RootAnalysisManager *ram, int tupleId,
+                          int attributeId, size_t index) const = 0;
+
+  virtual void Clear() = 0;
+};
+
 class GateVDigiAttribute {
 public:
   GateVDigiAttribute(std::string vname, char vtype);
@@ -35,13 +50,13 @@ public:
 
   virtual void FillDValue(double) {}
 
-  virtual void FillSValue(std::string) {}
+  virtual void FillSValue(const std::string &) {}
 
   virtual void FillIValue(int) {}
 
   virtual void Fill3Value(G4ThreeVector) {}
 
-  virtual void FillUValue(GateUniqueVolumeID::Pointer) {}
+  virtual void FillUValue(const GateUniqueVolumeID::Pointer &) {}
 
   virtual void Fill(GateVDigiAttribute * /*unused*/, size_t /*unused*/) {}
 
@@ -51,6 +66,23 @@ public:
 
   virtual void Clear() = 0;
 
+  // Replace the value of the digi at index by the last one, removed
+  virtual void MoveLastTo(size_t index) = 0;
+
+  // Remove the values of the first n digi (the others are moved to the front)
+  virtual void EraseFirst(size_t n) = 0;
+
+  // Capacity of the values of the thread (kept when cleared)
+  virtual void Reserve(size_t /*unused*/) {}
+
+  // Bytes allocated for the values of the thread (capacity, see
+  // GateMemoryAccounting)
+  virtual size_t GetMemoryBytes() const { return 0; }
+
+  // Exchange the values of the thread with the (cleared) ones of the buffer,
+  // created if null: no copy, the attribute is then empty
+  virtual void SwapValues(std::unique_ptr<GateVDigiValuesBuffer> &buffer) = 0;
+
   void SetDigiAttributeId(int id) { fDigiAttributeId = id; }
 
   void SetTupleId(int id) { fTupleId = id; }
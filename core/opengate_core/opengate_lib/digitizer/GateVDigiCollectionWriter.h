@@ -0,0 +1,32 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateVDigiCollectionWriter_h
+#define GateVDigiCollectionWriter_h
+
+class GateDigiCollection;
+
+/*
+ * Output backend of a digi collection, instead of the root tuples of
+ * GateDigiCollectionsRootManager (chosen from the filename, see
+ * GateDigiCollection::SetFilenameAndInitRoot). There is one writer per
+ * collection (created and owned by the collection), shared by all the
+ * threads.
+ */
+
+class GateVDigiCollectionWriter {
+public:
+  virtual ~GateVDigiCollectionWriter() = default;
+
+  // Append the values of the calling thread (then cleared by the collection)
+  virtual void Fill() = 0;
+
+  // End of the simulation for the calling thread (worker or master)
+  virtual void Write() = 0;
+};
+
+#endif // GateVDigiCollectionWriter_h
@@ -0,0 +1,260 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GateVDigitizerTimeOrderedActor.h"
+#include "../GateHelpersDict.h"
+#include "GateDigiAttributeManager.h"
+#include "GateDigiCollectionManager.h"
+#include <algorithm>
+
+GateVDigitizerTimeOrderedActor::GateVDigitizerTimeOrderedActor(
+    py::dict &user_info)
+    : GateVDigitizerWithOutputActor(user_info, true) {
+  // actions (in addition of the ones in GateVDigitizerWithOutputActor)
+  fActions.insert("EndOfEventAction");
+  fTimeIndex = 0;
+  fVolumeIndex = 0;
+  fEventIDIndex = -1;
+  fGroupVolumeDepth = -1;
+}
+
+void GateVDigitizerTimeOrderedActor::InitializeUserInfo(py::dict &user_info) {
+  GateVDigitizerWithOutputActor::InitializeUserInfo(user_info);
+  fStream.SetMaximumSize(DictGetInt(user_info, "buffer_size"));
+  fGroupVolumeDepth = -1;
+}
+
+void GateVDigitizerTimeOrderedActor::SetNumberOfThreads(int n) {
+  fStream.SetNumberOfThreads(n);
+}
+
+void GateVDigitizerTimeOrderedActor::SetGroupVolumeDepth(int depth) {
+  fGroupVolumeDepth = depth;
+}
+
+void GateVDigitizerTimeOrderedActor::StartSimulationAction() {
+  // Get the input collection
+  auto *hcm = GateDigiCollectionManager::GetInstance();
+  fInputDigiCollection = hcm->GetDigiCollection(fInputDigiCollectionName);
+  CheckIsNotSelection(fInputDigiCollection, GetName());
+  CheckRequiredAttribute(fInputDigiCollection, "GlobalTime");
+  CheckRequiredAttribute(fInputDigiCollection, "PreStepUniqueVolumeID");
+  fInputAttributes = fInputDigiCollection->GetDigiAttributes();
+  fTimeIndex = GetInputAttributeIndex("GlobalTime");
+  fVolumeIndex = GetInputAttributeIndex("PreStepUniqueVolumeID");
+  fEventIDIndex = -1;
+  if (fInputDigiCollection->IsDigiAttributeExists("EventID"))
+    fEventIDIndex = static_cast<int>(GetInputAttributeIndex("EventID"));
+
+  // Create the output collection
+  fOutputDigiCollection = hcm->NewDigiCollection(fOutputDigiCollectionName);
+  std::string outputPath;
+  if (GetWriteToDisk(fOutputNameRoot))
+    outputPath = GetOutputPath(fOutputNameRoot);
+  fOutputDigiCollection->SetFilenameAndInitRoot(outputPath);
+  InitializeOutputAttributes();
+  fOutputDigiCollection->RootInitializeTupleForMaster();
+
+  // init the stream
+  fStream.Clear();
+  fUnitOfVolume.clear();
+  fUnitKeys.clear();
+  InitializeStream();
+}
+
+void GateVDigitizerTimeOrderedActor::InitializeOutputAttributes() {
+  auto *dam = GateDigiAttributeManager::GetInstance();
+  fOutputAttributes.clear();
+  for (auto *att : fInputAttributes) {
+    const auto name = att->GetDigiAttributeName();
+    auto skip = std::find(fUserSkipDigiAttributeNames.begin(),
+                          fUserSkipDigiAttributeNames.end(),
+                          name) != fUserSkipDigiAttributeNames.end();
+    if (skip) {
+      fOutputAttributes.push_back(nullptr);
+      continue;
+    }
+    auto *copy = dam->CopyDigiAttribute(att);
+    fOutputDigiCollection->InitDigiAttribute(copy);
+    fOutputAttributes.push_back(copy);
+  }
+}
+
+size_t GateVDigitizerTimeOrderedActor::GetInputAttributeIndex(
+    const std::string &name) const {
+  for (size_t i = 0; i < fInputAttributes.size(); i++) {
+    if (fInputAttributes[i]->GetDigiAttributeName() == name)
+      return i;
+  }
+  std::ostringstream oss;
+  oss << "Error in the digitizer '" << fOutputDigiCollectionName
+      << "': the input collection has no attribute '" << name << "'";
+  Fatal(oss.str());
+  return 0;
+}
+
+void GateVDigitizerTimeOrderedActor::DigitInitialize(
+    const std::vector<std::string> & /*unused*/) {
+  // no filler: the output values are copied from the merged digi
+  fOutputDigiCollection->RootInitializeTupleForWorker();
+  auto &l = fThreadLocalVDigitizerData.Get();
+  l.fInputIter = fInputDigiCollection->NewIterator();
+}
+
+void GateVDigitizerTimeOrderedActor::BeginOfEventAction(const G4Event *event) {
+  GateVDigitizerWithOutputActor::BeginOfEventAction(event);
+  // the digi of the thread are now after the T0 of this event
+  const auto t0 = event->GetPrimaryVertex(0)->GetT0();
+  const auto thread = std::max(0, G4Threading::G4GetThreadId());
+  std::lock_guard<std::mutex> lock(fStream.GetMutex());
+  fStream.SetWatermark(thread, t0);
+}
+
+void GateVDigitizerTimeOrderedActor::EndOfEventAction(
+    const G4Event * /*unused*/) {
+  // copy the digi of the event (without the lock)
+  auto &iter = fThreadLocalVDigitizerData.Get().fInputIter;
+  std::vector<Digi> digis;
+  iter.GoToBegin();
+  while (!iter.IsAtEnd()) {
+    digis.push_back(CopyDigi(iter.fIndex));
+    iter++;
+  }
+  if (digis.empty())
+    return;
+
+  // add them to the stream and process the ones that are ready
+  const auto thread = std::max(0, G4Threading::G4GetThreadId());
+  std::lock_guard<std::mutex> lock(fStream.GetMutex());
+  for (auto &d : digis) {
+    DigiPushed(d);
+    const auto time = d.fTime;
+    fStream.Push(thread, time, std::move(d));
+  }
+  MergeDigi(false);
+}
+
+void GateVDigitizerTimeOrderedActor::EndOfRunAction(const G4Run *run) {
+  {
+    std::lock_guard<std::mutex> lock(fStream.GetMutex());
+    const auto thread = std::max(0, G4Threading::G4GetThreadId());
+    fStream.EndOfStream(thread);
+    // the last thread of the run processes all the remaining digi
+    bool last = fStream.IsEnded();
+    MergeDigi(last);
+    if (last)
+      fStream.Restart();
+  }
+  GateVDigitizerWithOutputActor::EndOfRunAction(run);
+}
+
+void GateVDigitizerTimeOrderedActor::MergeDigi(bool flush) {
+  fStream.Merge([this](double, Digi &&d) { ProcessDigi(std::move(d)); },
+                flush);
+  EndOfMerge(flush ? fStream.Highest() : fStream.GetWatermark(), flush);
+}
+
+GateVDigitizerTimeOrderedActor::Digi
+GateVDigitizerTimeOrderedActor::CopyDigi(size_t index) const {
+  Digi d;
+  d.fValues.resize(fInputAttributes.size());
+  for (size_t i = 0; i < fInputAttributes.size(); i++) {
+    auto *att = fInputAttributes[i];
+    auto &v = d.fValues[i];
+    switch (att->GetDigiAttributeType()) {
+    case 'D':
+      v.fD = att->GetDValues()[index];
+      break;
+    case 'I':
+      v.fI = att->GetIValues()[index];
+      break;
+    case 'S':
+      // (Dump does not decode all the values)
+      v.fS = att->Dump(index);
+      break;
+    case '3':
+      v.f3 = att->Get3Values()[index];
+      break;
+    case 'U':
+      v.fU = att->GetUValues()[index];
+      break;
+    default:
+      break;
+    }
+  }
+  d.fTime = d.fValues[fTimeIndex].fD;
+  d.fVolume = d.fValues[fVolumeIndex].fU.get();
+  d.fEventID = fEventIDIndex >= 0 ? d.fValues[fEventIDIndex].fI : 0;
+  return d;
+}
+
+void GateVDigitizerTimeOrderedActor::FillValue(GateVDigiAttribute *att,
+                                               const DigiValue &v) {
+  switch (att->GetDigiAttributeType()) {
+  case 'D':
+    att->FillDValue(v.fD);
+    break;
+  case 'I':
+    att->FillIValue(v.fI);
+    break;
+  case 'S':
+    att->FillSValue(v.fS);
+    break;
+  case '3':
+    att->Fill3Value(v.f3);
+    break;
+  case 'U':
+    att->FillUValue(v.fU);
+    break;
+  default:
+    break;
+  }
+}
+
+void GateVDigitizerTimeOrderedActor::OutputDigi(const Digi &digi) {
+  // (all "Fill" calls are thread local: the values are written to the root
+  // tuple of the thread that merges)
+  for (size_t i = 0; i < fOutputAttributes.size(); i++) {
+    if (fOutputAttributes[i] != nullptr)
+      FillValue(fOutputAttributes[i], digi.fValues[i]);
+  }
+}
+
+size_t GateVDigitizerTimeOrderedActor::GetUnitIndex(const Digi &digi) {
+  // known volume: direct lookup by the dense index of the volume ID
+  const auto *uid = digi.fVolume;
+  const auto vindex = uid->fIndex;
+  if (vindex >= 0 && vindex < (int)fUnitOfVolume.size() &&
+      fUnitOfVolume[vindex] >= 0)
+    return fUnitOfVolume[vindex];
+
+  // the unit is the volume at the group depth, with its copy numbers
+  auto depth = fGroupVolumeDepth;
+  if (depth == -1)
+    depth = static_cast<int>(uid->GetDepth()) - 1;
+  const auto *pv = uid->GetVolumeDepthID()[depth].fVolume;
+  auto key = std::make_pair(pv, uid->GetIdUpToDepth(depth));
+  auto unit = fUnitKeys.emplace(key, fUnitKeys.size()).first->second;
+  if (vindex >= 0) {
+    if (vindex >= (int)fUnitOfVolume.size())
+      fUnitOfVolume.resize(vindex + 1, -1);
+    fUnitOfVolume[vindex] = static_cast<int>(unit);
+  }
+  return unit;
+}
+
+size_t GateVDigitizerTimeOrderedActor::GetNumberOfUnits() const {
+  return fUnitKeys.size();
+}
+
+unsigned long GateVDigitizerTimeOrderedActor::GetNumberOfForcedDigi() const {
+  return fStream.GetNumberOfForcedItems();
+}
+
+unsigned long GateVDigitizerTimeOrderedActor::GetNumberOfLateDigi() const {
+  return fStream.GetNumberOfLateItems();
+}
@@ -0,0 +1,139 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#ifndef GateVDigitizerTimeOrderedActor_h
+#define GateVDigitizerTimeOrderedActor_h
+
+#include "GateTimeOrderedStream.h"
+#include "GateVDigitizerWithOutputActor.h"
+#include <map>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+/*
+ * Base class for the digitizer modules that consider the digi (usually the
+ * singles) in time order, across the events and the threads (coincidences,
+ * dead time, pile-up). Input: a collection with at least GlobalTime and
+ * PreStepUniqueVolumeID.
+ *
+ * At the end of each event, the digi of the thread are copied and pushed
+ * to a GateTimeOrderedStream, with the T0 of the current event of the
+ * threads as watermarks. ProcessDigi is then called for each merged digi,
+ * in time order, then EndOfMerge. Both are called with the lock of the
+ * stream held, by any thread: OutputDigi fills the output values of the
+ * calling thread. At the end of the run, the last thread flushes the
+ * stream.
+ *
+ * The digi can be grouped by detector unit (e.g. crystal or block, see
+ * SetGroupVolumeDepth): GetUnitIndex gives a dense index (0, 1, 2 ...) to
+ * each unit, so that the state of a unit can be kept in a vector.
+ */
+
+class GateVDigitizerTimeOrderedActor : public GateVDigitizerWithOutputActor {
+
+public:
+  explicit GateVDigitizerTimeOrderedActor(py::dict &user_info);
+
+  void InitializeUserInfo(py::dict &user_info) override;
+
+  // Called when the simulation start (master thread only)
+  void StartSimulationAction() override;
+
+  // Called every time an Event starts
+  void BeginOfEventAction(const G4Event *event) override;
+
+  // Called every time an Event ends (all threads)
+  void EndOfEventAction(const G4Event *event) override;
+
+  // Called every time a Run ends (all threads)
+  void EndOfRunAction(const G4Run *run) override;
+
+  // Number of threads that run the events (set before the first run)
+  void SetNumberOfThreads(int n);
+
+  // Depth of the volume of the detector units (-1: the volume of the digi)
+  void SetGroupVolumeDepth(int depth);
+
+  // Number of digi merged before the other threads reached them
+  // (buffer full)
+  unsigned long GetNumberOfForcedDigi() const;
+
+  // Number of digi merged out of order (before a digi of a previous event
+  // of their thread, or after a forced digi)
+  unsigned long GetNumberOfLateDigi() const;
+
+protected:
+  // All the values of one digi (only the field of the attribute type is
+  // used)
+  struct DigiValue {
+    double fD = 0;
+    int fI = 0;
+    std::string fS;
+    G4ThreeVector f3;
+    GateUniqueVolumeID::Pointer fU;
+  };
+
+  struct Digi {
+    double fTime;
+    int fEventID;
+    GateUniqueVolumeID *fVolume;
+    std::vector<DigiValue> fValues;
+  };
+
+  // Create the output attributes (default: the same as the input, except
+  // the skipped ones, in fOutputAttributes)
+  virtual void InitializeOutputAttributes();
+
+  // Called at the start of the simulation (the stream is cleared)
+  virtual void InitializeStream() {}
+
+  // Called for each digi of the event, before it is pushed (lock held)
+  virtual void DigiPushed(const Digi & /*unused*/) {}
+
+  // Called for each merged digi, in time order (lock held)
+  virtual void ProcessDigi(Digi &&digi) = 0;
+
+  // Called after the merge: all the digi before the watermark (lock held)
+  virtual void EndOfMerge(double /*watermark*/, bool /*flush*/) {}
+
+  // Fill the output attributes with the values of the digi
+  void OutputDigi(const Digi &digi);
+
+  static void FillValue(GateVDigiAttribute *att, const DigiValue &v);
+
+  // Dense index of the detector unit of the digi
+  size_t GetUnitIndex(const Digi &digi);
+
+  size_t GetNumberOfUnits() const;
+
+  size_t GetInputAttributeIndex(const std::string &name) const;
+
+  Digi CopyDigi(size_t index) const;
+
+  // Merge the ready digi (all of them if flush), lock held
+  void MergeDigi(bool flush);
+
+  void DigitInitialize(
+      const std::vector<std::string> &attributes_not_in_filler) override;
+
+  std::vector<GateVDigiAttribute *> fInputAttributes;
+  // one per input attribute (nullptr if skipped)
+  std::vector<GateVDigiAttribute *> fOutputAttributes;
+  size_t fTimeIndex;
+  size_t fVolumeIndex;
+  int fEventIDIndex;
+  int fGroupVolumeDepth;
+
+  // Shared by all the threads (lock of the stream)
+  GateTimeOrderedStream<Digi> fStream;
+  // unit index of each volume ID (by the dense index of the volume ID)
+  std::vector<int> fUnitOfVolume;
+  std::map<std::pair<const G4VPhysicalVolume *, std::string>, size_t> fUnitKeys;
+};
+
+#endif // GateVDigitizerTimeOrderedActor_h
@@ -52,6 +52,7 @@ void GateVDigitizerWithOutputActor::StartSimulationAction() {
   // Get the input hits collection
   auto *hcm = GateDigiCollectionManager::GetInstance();
   fInputDigiCollection = hcm->GetDigiCollection(fInputDigiCollectionName);
+  CheckIsNotSelection(fInputDigiCollection, GetName());
 
   // Create the list of output attributes
   fOutputDigiCollection = hcm->NewDigiCollection(fOutputDigiCollectionName);
@@ -64,6 +65,8 @@ void GateVDigitizerWithOutputActor::StartSimulationAction() {
   fOutputDigiCollection->SetFilenameAndInitRoot(outputPath);
   fOutputDigiCollection->InitDigiAttributesFromCopy(
       fInputDigiCollection, fUserSkipDigiAttributeNames);
+  // (at least one digi per event is expected between two clears)
+  fOutputDigiCollection->SetCapacityHint(fClearEveryNEvents);
 
   if (fInitializeRootTupleForMasterFlag)
     fOutputDigiCollection->RootInitializeTupleForMaster();
@@ -112,6 +115,19 @@ void GateVDigitizerWithOutputActor::EndOfRunAction(const G4Run * /*unused*/) {
   iter.Reset();
 }
 
+void GateVDigitizerWithOutputActor::ProcessEventBuffer(
+    GateDigiEventBuffer & /*unused*/) {
+  std::ostringstream oss;
+  oss << "Error, the digitizer '" << fOutputDigiCollectionName
+      << "' cannot be part of a fused digitizer chain";
+  Fatal(oss.str());
+}
+
+void GateVDigitizerWithOutputActor::FillOutputFromEventBuffer(
+    GateDigiEventBuffer &buffer) {
+  buffer.Fill(fOutputDigiCollection);
+}
+
 // Called every time a Run ends
 void GateVDigitizerWithOutputActor::EndOfSimulationWorkerAction(
     const G4Run * /*unused*/) {
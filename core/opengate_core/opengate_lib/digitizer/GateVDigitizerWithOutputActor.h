@@ -12,6 +12,7 @@
 #include "G4Cache.hh"
 #include "GateDigiCollection.h"
 #include "GateDigiCollectionIterator.h"
+#include "GateDigiEventBuffer.h"
 #include "GateHelpersDigitizer.h"
 #include "GateTDigiAttribute.h"
 #include <pybind11/stl.h>
@@ -20,10 +21,12 @@ namespace py = pybind11;
 
 /*
  * Base class for simple digitizer module with one input and one output
- * DigitCollections
+ * DigitCollections. The modules that override ProcessEventBuffer can also be
+ * part of a fused chain (see GateDigitizerFusedChainActor).
  */
 
-class GateVDigitizerWithOutputActor : public GateVActor {
+class GateVDigitizerWithOutputActor : public GateVActor,
+                                      public GateVFusedDigitizerModule {
 
 public:
   explicit GateVDigitizerWithOutputActor(py::dict &user_info, bool MT_ready);
@@ -53,6 +56,12 @@ public:
 
   void EndOfSimulationWorkerAction(const G4Run * /*unused*/) override;
 
+  // Fused chain (default: this module cannot be fused)
+  void ProcessEventBuffer(GateDigiEventBuffer &buffer) override;
+
+  // Fused chain: fill the output collection with the digi of the buffer
+  void FillOutputFromEventBuffer(GateDigiEventBuffer &buffer) override;
+
 protected:
   std::string fInputDigiCollectionName;
   std::string fOutputDigiCollectionName;
@@ -12,6 +12,7 @@ namespace py = pybind11;
 
 #include "G4Step.hh"
 #include "GateDigiAttributeManager.h"
+#include "GateDigiSchema.h"
 #include "GateVDigiAttribute.h"
 
 void init_GateDigiAttributeManager(py::module &m) {
@@ -28,4 +29,6 @@ void init_GateDigiAttributeManager(py::module &m) {
            &GateDigiAttributeManager::GetDigiAttributeByName)
       .def("GetAvailableDigiAttributeNames",
            &GateDigiAttributeManager::GetAvailableDigiAttributeNames);
+
+  m.def("GateGetDigiSchemas", &GateGetDigiSchemas);
 }
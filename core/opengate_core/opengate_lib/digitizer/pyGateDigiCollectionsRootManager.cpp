@@ -0,0 +1,28 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateDigiCollectionsRootManager.h"
+
+void init_GateDigiCollectionsRootManager(py::module &m) {
+
+  py::class_<GateDigiCollectionsRootManager,
+             std::unique_ptr<GateDigiCollectionsRootManager, py::nodelete>>(
+      m, "GateDigiCollectionsRootManager")
+      .def("GetInstance", &GateDigiCollectionsRootManager::GetInstance)
+      .def("SetNtupleMergingFlag",
+           &GateDigiCollectionsRootManager::SetNtupleMergingFlag)
+      .def("GetNtupleMergingFlag",
+           &GateDigiCollectionsRootManager::GetNtupleMergingFlag)
+      .def("SetRootFileOptions",
+           &GateDigiCollectionsRootManager::SetRootFileOptions)
+      .def("GetRootFileOptions",
+           &GateDigiCollectionsRootManager::GetRootFileOptions);
+}
@@ -17,5 +17,7 @@ void init_GateDigitizerBlurringActor(py::module &m) {
   py::class_<GateDigitizerBlurringActor,
              std::unique_ptr<GateDigitizerBlurringActor, py::nodelete>,
              GateVDigitizerWithOutputActor>(m, "GateDigitizerBlurringActor")
-      .def(py::init<py::dict &>());
+      .def(py::init<py::dict &>())
+      .def("SetBlurMapVolumeDepth",
+           &GateDigitizerBlurringActor::SetBlurMapVolumeDepth);
 }
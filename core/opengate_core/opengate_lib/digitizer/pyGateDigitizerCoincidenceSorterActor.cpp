@@ -0,0 +1,35 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateDigitizerCoincidenceSorterActor.h"
+
+void init_GateDigitizerCoincidenceSorterActor(py::module &m) {
+
+  py::class_<GateDigitizerCoincidenceSorterActor,
+             std::unique_ptr<GateDigitizerCoincidenceSorterActor, py::nodelete>,
+             GateVDigitizerTimeOrderedActor>(
+      m, "GateDigitizerCoincidenceSorterActor")
+      .def(py::init<py::dict &>())
+      .def("GetNumberOfCoincidences",
+           &GateDigitizerCoincidenceSorterActor::GetNumberOfCoincidences)
+      .def("SetCrystalIndex",
+           &GateDigitizerCoincidenceSorterActor::SetCrystalIndex)
+      .def("SetLORTable", &GateDigitizerCoincidenceSorterActor::SetLORTable)
+      .def("SetListmodeFilename",
+           &GateDigitizerCoincidenceSorterActor::SetListmodeFilename)
+      .def("GetSinogram", &GateDigitizerCoincidenceSorterActor::GetSinogram)
+      .def("GetSinogramShape",
+           &GateDigitizerCoincidenceSorterActor::GetSinogramShape)
+      .def("GetNumberOfSkippedLORs",
+           &GateDigitizerCoincidenceSorterActor::GetNumberOfSkippedLORs);
+}
@@ -17,5 +17,7 @@ void init_GateDigitizerEfficiencyActor(py::module &m) {
   py::class_<GateDigitizerEfficiencyActor,
              std::unique_ptr<GateDigitizerEfficiencyActor, py::nodelete>,
              GateVDigitizerWithOutputActor>(m, "GateDigitizerEfficiencyActor")
-      .def(py::init<py::dict &>());
+      .def(py::init<py::dict &>())
+      .def("SetEfficiencyMapVolumeDepth",
+           &GateDigitizerEfficiencyActor::SetEfficiencyMapVolumeDepth);
 }
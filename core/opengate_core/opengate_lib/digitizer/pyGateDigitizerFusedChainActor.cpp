@@ -0,0 +1,21 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateDigitizerFusedChainActor.h"
+
+void init_GateDigitizerFusedChainActor(py::module &m) {
+
+  py::class_<GateDigitizerFusedChainActor,
+             std::unique_ptr<GateDigitizerFusedChainActor, py::nodelete>,
+             GateVActor>(m, "GateDigitizerFusedChainActor")
+      .def(py::init<py::dict &>())
+      .def("AddModule", &GateDigitizerFusedChainActor::AddModule);
+}
@@ -0,0 +1,23 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateDigitizerOnlineAdderActor.h"
+
+void init_GateDigitizerOnlineAdderActor(py::module &m) {
+
+  py::class_<GateDigitizerOnlineAdderActor,
+             std::unique_ptr<GateDigitizerOnlineAdderActor, py::nodelete>,
+             GateVActor>(m, "GateDigitizerOnlineAdderActor")
+      .def(py::init<py::dict &>())
+      .def("SetGroupVolumeDepth",
+           &GateDigitizerOnlineAdderActor::SetGroupVolumeDepth);
+}
@@ -0,0 +1,28 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateVDigitizerTimeOrderedActor.h"
+
+void init_GateVDigitizerTimeOrderedActor(py::module &m) {
+
+  py::class_<GateVDigitizerTimeOrderedActor,
+             std::unique_ptr<GateVDigitizerTimeOrderedActor, py::nodelete>,
+             GateVDigitizerWithOutputActor>(m, "GateVDigitizerTimeOrderedActor")
+      .def("SetNumberOfThreads",
+           &GateVDigitizerTimeOrderedActor::SetNumberOfThreads)
+      .def("SetGroupVolumeDepth",
+           &GateVDigitizerTimeOrderedActor::SetGroupVolumeDepth)
+      .def("GetNumberOfForcedDigi",
+           &GateVDigitizerTimeOrderedActor::GetNumberOfForcedDigi)
+      .def("GetNumberOfLateDigi",
+           &GateVDigitizerTimeOrderedActor::GetNumberOfLateDigi);
+}
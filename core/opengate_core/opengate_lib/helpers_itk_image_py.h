@@ -12,11 +12,13 @@
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include "GateHugePages.h"
 #include "itkImage.h"
 #include "itkImportImageFilter.h"
 #include "itkSmartPointer.h"
 
-/** For now make copies of data to numpy arrays.
+/** The pixels are copied to numpy arrays (to_pyarray) or viewed without copy
+ * (as_pyarray), see below.
  * Some examples (pybind11 source code docs are non-existant)
  * From: https://github.com/pybind/pybind11/issues/323
  * Also: https://github.com/pybind/pybind11/issues/1042
@@ -49,7 +51,8 @@ inline void set_region(TImagePointer &img,
                            index,
                        pybind11::array_t<int, pybind11::array::c_style |
                                                   pybind11::array::forcecast>
-                           size) {
+                           size,
+                       bool allocate = true) {
   using RegionType = typename TImagePointer::ObjectType::RegionType;
   typename RegionType::IndexType itk_index;
   const auto *data_index =
@@ -68,7 +71,21 @@ inline void set_region(TImagePointer &img,
   itk_size[2] = data_size[2];
   RegionType itk_region(itk_index, itk_size);
   img->SetRegions(itk_region);
+  // The pixels of a numpy view (see as_pyarray) are kept by the view: the
+  // image gets a new buffer instead of overwriting them
+  using ContainerType = typename TImagePointer::ObjectType::PixelContainer;
+  if (!allocate || img->GetPixelContainer()->GetReferenceCount() > 1)
+    img->SetPixelContainer(ContainerType::New());
+  // (without allocation: only the geometry, the buffer is allocated later,
+  // e.g. by the actor at the end of the run)
+  if (!allocate)
+    return;
   img->Allocate();
+  // (the pixels are not initialized by Allocate: not yet touched)
+  using PixelType = typename TImagePointer::ObjectType::PixelType;
+  GateHugePages::Advise(img->GetBufferPointer(),
+                        itk_region.GetNumberOfPixels() * sizeof(PixelType),
+                        "images");
 };
 
 template <typename TImagePointer>
@@ -104,10 +121,11 @@ void declare_itk_image_ptr(pybind11::module &m, const std::string &typestr) {
           "set_region",
           [](TImagePointer &img,
              py::array_t<int, py::array::c_style | py::array::forcecast> index,
-             py::array_t<int, py::array::c_style | py::array::forcecast> size) {
-            return set_region<TImagePointer>(img, index, size);
+             py::array_t<int, py::array::c_style | py::array::forcecast> size,
+             bool allocate) {
+            return set_region<TImagePointer>(img, index, size, allocate);
           },
-          py::arg("index"), py::arg("size"))
+          py::arg("index"), py::arg("size"), py::arg("allocate") = true)
       .def("spacing",
            [](const TImagePointer &img) {
              return py::array(img->ImageDimension, // shape
@@ -182,14 +200,29 @@ void declare_itk_image_ptr(pybind11::module &m, const std::string &typestr) {
                 shape, img->GetBufferPointer());
           },
           py::arg("contig") = "F")
-      // TODO: Create a view (non-copy) of the data
-      // Problems will arise with the contig differences between numpy(fortran)
-      // and c.
+      // View (no copy) of the pixels, same shape as to_pyarray. The array
+      // keeps a reference to the pixel container, so the memory stays valid
+      // when the image is deleted or allocated again by set_region (the
+      // image then gets a new buffer); but the values change with the image
+      // until then.
       .def(
           "as_pyarray",
-          [](const TImagePointer & /* img */,
-             const std::string & /* contiguous */) {
-            throw std::runtime_error("not implemented, use to_pyarray");
+          [](const TImagePointer &img, const std::string &contiguous) {
+            using ContainerType =
+                typename TImagePointer::ObjectType::PixelContainer;
+            const auto size = img->GetLargestPossibleRegion().GetSize();
+            const auto shape =
+                (contiguous == "F")
+                    ? std::vector<size_t>{size[2], size[1], size[0]}
+                    : std::vector<size_t>{size[0], size[1], size[2]};
+            auto *container = img->GetPixelContainer();
+            container->Register();
+            py::capsule owner(container, [](void *p) {
+              static_cast<ContainerType *>(p)->UnRegister();
+            });
+            return py::array(
+                py::dtype::of<typename TImagePointer::ObjectType::PixelType>(),
+                shape, img->GetBufferPointer(), owner);
           },
           py::arg("contig") = "F")
 
@@ -204,14 +237,7 @@ void declare_itk_image_ptr(pybind11::module &m, const std::string &typestr) {
             using ImporterType =
                 itk::ImportImageFilter<PixelType, Image::ImageDimension>;
             auto info = np_array.request();
-
-            // Create a copy of the numpy array's data
             size_t numberOfPixels = np_array.size();
-            PixelType *copied_data = new PixelType[numberOfPixels];
-            std::memcpy(copied_data, info.ptr,
-                        numberOfPixels * sizeof(PixelType));
-
-            auto importer = ImporterType::New();
             auto region = img->GetLargestPossibleRegion();
             auto size = region.GetSize();
 
@@ -223,6 +249,24 @@ void declare_itk_image_ptr(pybind11::module &m, const std::string &typestr) {
               throw std::runtime_error("Unknown parameter contig: " +
                                        contiguous + ". Valid: F or C.");
             }
+
+            // Same size as the allocated image (e.g. after set_region): the
+            // pixels are copied in place, without a new buffer
+            if (size == img->GetLargestPossibleRegion().GetSize() &&
+                img->GetBufferPointer() != nullptr &&
+                img->GetPixelContainer()->Size() == numberOfPixels) {
+              std::memcpy(img->GetBufferPointer(), info.ptr,
+                          numberOfPixels * sizeof(PixelType));
+              img->Modified();
+              return;
+            }
+
+            // Create a copy of the numpy array's data
+            PixelType *copied_data = new PixelType[numberOfPixels];
+            std::memcpy(copied_data, info.ptr,
+                        numberOfPixels * sizeof(PixelType));
+
+            auto importer = ImporterType::New();
             region.SetSize(size);
             // Note that region index is kept from the staring img.
             importer->SetRegion(region);
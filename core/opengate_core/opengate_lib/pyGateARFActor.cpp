@@ -6,6 +6,7 @@
    -------------------------------------------------- */
 
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -27,6 +28,51 @@ public:
   }
 };
 
+/*
+ * The batch of the calling thread is given as numpy arrays without copy:
+ * they are only valid during the "apply" function (the batch is then cleared
+ * or moved). With float32, the batch is converted (one copy).
+ */
+
+py::array GetBatch(GateARFActor &a, bool float32) {
+  const auto &batch = a.GetBatch();
+  const std::vector<size_t> shape = {
+      batch.size() / GateARFActor::fNumberOfColumns,
+      GateARFActor::fNumberOfColumns};
+  if (!float32)
+    return py::array_t<double>(shape, batch.data(), py::cast(&a));
+  py::array_t<float> values(shape);
+  auto *v = values.mutable_data();
+  for (size_t i = 0; i < batch.size(); i++)
+    v[i] = static_cast<float>(batch[i]);
+  return values;
+}
+
+py::array_t<double> GetBatchColumn(GateARFActor &a, size_t column) {
+  const auto &batch = a.GetBatch();
+  const auto n = batch.size() / GateARFActor::fNumberOfColumns;
+  if (n == 0)
+    return py::array_t<double>(0);
+  // (strided view of one column of the row major batch)
+  const std::vector<size_t> shape = {n};
+  const std::vector<size_t> strides = {GateARFActor::fNumberOfColumns *
+                                       sizeof(double)};
+  return py::array_t<double>(shape, strides, batch.data() + column,
+                             py::cast(&a));
+}
+
+py::array_t<double> GetProjection(GateARFActor &a) {
+  // (view of the projection of the native inference, valid with the actor)
+  const auto &projection = a.GetProjection();
+  if (projection.empty())
+    return py::array_t<double>(0);
+  const auto size_u = static_cast<size_t>(a.GetImageSize()[0]);
+  const auto size_v = static_cast<size_t>(a.GetImageSize()[1]);
+  const std::vector<size_t> shape = {projection.size() / (size_u * size_v),
+                                     size_u, size_v};
+  return py::array_t<double>(shape, projection.data(), py::cast(&a));
+}
+
 void init_GateARFActor(py::module &m) {
   py::class_<GateARFActor, PyGateARFActor,
              std::unique_ptr<GateARFActor, py::nodelete>, GateVActor>(
@@ -37,13 +83,35 @@ void init_GateARFActor(py::module &m) {
       .def("EndOfRunActionMasterThread",
            &GateARFActor::EndOfRunActionMasterThread)
       .def("SetARFFunction", &GateARFActor::SetARFFunction)
+      .def("InitializeNativeInference",
+           &GateARFActor::InitializeNativeInference)
+      .def("IsNativeInference", &GateARFActor::IsNativeInference)
+      .def("GetNumberOfEnergyWindows",
+           &GateARFActor::GetNumberOfEnergyWindows)
+      .def("GetProjection", &GetProjection)
+      .def("GetNumberOfNativeBatches",
+           &GateARFActor::GetNumberOfNativeBatches)
+      .def("GetNumberOfNativeHits", &GateARFActor::GetNumberOfNativeHits)
       .def("GetCurrentNumberOfHits", &GateARFActor::GetCurrentNumberOfHits)
       .def("GetCurrentRunId", &GateARFActor::GetCurrentRunId)
-      .def("GetEnergy", &GateARFActor::GetEnergy)
-      .def("GetPositionX", &GateARFActor::GetPositionX)
-      .def("GetPositionY", &GateARFActor::GetPositionY)
-      .def("GetDirectionX", &GateARFActor::GetDirectionX)
-      .def("GetDirectionY", &GateARFActor::GetDirectionY)
+      .def("GetBatch", &GetBatch, py::arg("float32") = false)
+      .def("GetEnergy", [](GateARFActor &a) { return GetBatchColumn(a, 4); })
+      .def("GetPositionX",
+           [](GateARFActor &a) { return GetBatchColumn(a, 0); })
+      .def("GetPositionY",
+           [](GateARFActor &a) { return GetBatchColumn(a, 1); })
+      .def("GetDirectionX",
+           [](GateARFActor &a) {
+             // (computed from the angles of the batch)
+             const auto v = a.GetDirectionX();
+             return py::array_t<double>(v.size(), v.data());
+           })
+      .def("GetDirectionY",
+           [](GateARFActor &a) {
+             // (computed from the angles of the batch)
+             const auto v = a.GetDirectionY();
+             return py::array_t<double>(v.size(), v.data());
+           })
       .def("GetDirectionZ", &GateARFActor::GetDirectionZ)
-      .def("GetWeights", &GateARFActor::GetWeights);
+      .def("GetWeights", [](GateARFActor &a) { return GetBatchColumn(a, 5); });
 }
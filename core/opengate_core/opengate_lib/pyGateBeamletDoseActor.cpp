@@ -0,0 +1,65 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateBeamletDoseActor.h"
+
+class PyGateBeamletDoseActor : public GateBeamletDoseActor {
+public:
+  // Inherit the constructors
+  using GateBeamletDoseActor::GateBeamletDoseActor;
+
+  void BeginOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(void, GateBeamletDoseActor, BeginOfRunActionMasterThread,
+                      run_id);
+  }
+
+  int EndOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(int, GateBeamletDoseActor, EndOfRunActionMasterThread,
+                      run_id);
+  }
+};
+
+void init_GateBeamletDoseActor(py::module &m) {
+  py::class_<GateBeamletDoseActor, PyGateBeamletDoseActor,
+             std::unique_ptr<GateBeamletDoseActor, py::nodelete>, GateVActor>(
+      m, "GateBeamletDoseActor")
+      .def(py::init<py::dict &>())
+      .def("BeginOfRunActionMasterThread",
+           &GateBeamletDoseActor::BeginOfRunActionMasterThread)
+      .def("EndOfRunActionMasterThread",
+           &GateBeamletDoseActor::EndOfRunActionMasterThread)
+      .def("GetNumberOfElements", &GateBeamletDoseActor::GetNumberOfElements)
+      // COO arrays of the matrix: voxel (flat index), spot, value
+      .def("GetMatrix",
+           [](const GateBeamletDoseActor &a) {
+             auto elements = a.GetSortedElements();
+             auto n = static_cast<py::ssize_t>(elements.size());
+             py::array_t<std::int64_t> voxels(n);
+             py::array_t<std::int32_t> spots(n);
+             py::array_t<double> values(n);
+             auto v = voxels.mutable_unchecked<1>();
+             auto s = spots.mutable_unchecked<1>();
+             auto x = values.mutable_unchecked<1>();
+             for (py::ssize_t i = 0; i < n; i++) {
+               v(i) = GateBeamletDoseActor::KeyToVoxel(elements[i].first);
+               s(i) = GateBeamletDoseActor::KeyToSpot(elements[i].first);
+               x(i) = elements[i].second;
+             }
+             return py::make_tuple(voxels, spots, values);
+           })
+      .def_readwrite("cpp_dose_image", &GateBeamletDoseActor::cpp_dose_image)
+      .def("GetPhysicalVolumeName",
+           &GateBeamletDoseActor::GetPhysicalVolumeName)
+      .def("SetPhysicalVolumeName",
+           &GateBeamletDoseActor::SetPhysicalVolumeName);
+}
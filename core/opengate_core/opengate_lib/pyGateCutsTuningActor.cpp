@@ -0,0 +1,24 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateCutsTuningActor.h"
+
+void init_GateCutsTuningActor(py::module &m) {
+  py::class_<GateCutsTuningActor,
+             std::unique_ptr<GateCutsTuningActor, py::nodelete>, GateVActor>(
+      m, "GateCutsTuningActor")
+      .def(py::init<py::dict &>())
+      .def("StartSimulationAction", &GateCutsTuningActor::StartSimulationAction)
+      .def("GetRegionStatistics", &GateCutsTuningActor::GetRegionStatistics)
+      .def_static("ConvertRangeToEnergy",
+                  &GateCutsTuningActor::ConvertRangeToEnergy);
+}
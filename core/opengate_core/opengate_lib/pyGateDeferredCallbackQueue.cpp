@@ -0,0 +1,26 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateDeferredCallbackQueue.h"
+
+void init_GateDeferredCallbackQueue(py::module &m) {
+  py::class_<GateDeferredCallbackQueue,
+             std::unique_ptr<GateDeferredCallbackQueue, py::nodelete>>(
+      m, "GateDeferredCallbackQueue")
+      .def_static("GetInstance", &GateDeferredCallbackQueue::GetInstance,
+                  py::return_value_policy::reference)
+      .def("Start", &GateDeferredCallbackQueue::Start)
+      .def("Stop", &GateDeferredCallbackQueue::Stop)
+      .def("IsRunning", &GateDeferredCallbackQueue::IsRunning)
+      // the consumer thread waits for the tasks without the GIL
+      .def("RunConsumer", &GateDeferredCallbackQueue::RunConsumer,
+           py::call_guard<py::gil_scoped_release>());
+}
@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -12,6 +13,20 @@ namespace py = pybind11;
 
 #include "GateDoseActor.h"
 
+namespace {
+// View of the values of the snapshot (no copy), shaped as the image
+// (z, y, x). The actor owns the memory.
+py::array_t<double> SnapshotView(GateDoseActor &a, GateImageSnapshot &s) {
+  auto &size = a.size_edep;
+  if (s.GetValues().size() != size[0] * size[1] * size[2])
+    return py::array_t<double>(0);
+  std::vector<py::ssize_t> shape = {(py::ssize_t)size[2],
+                                    (py::ssize_t)size[1],
+                                    (py::ssize_t)size[0]};
+  return py::array_t<double>(shape, s.GetValuesPointer(), py::cast(&a));
+}
+} // namespace
+
 class PyGateDoseActor : public GateDoseActor {
 public:
   // Inherit the constructors
@@ -51,9 +66,23 @@ void init_GateDoseActor(py::module &m) {
       .def("SetThreshEdepPerc", &GateDoseActor::SetThreshEdepPerc)
       .def("SetOvershoot", &GateDoseActor::SetOvershoot)
       .def("SetNbEventsFirstCheck", &GateDoseActor::SetNbEventsFirstCheck)
+      .def("TakeSnapshot", &GateDoseActor::TakeSnapshot)
+      .def("WriteEdepPerRun", &GateDoseActor::WriteEdepPerRun)
+      .def("GetNumberOfQueueFlushes", &GateDoseActor::GetNumberOfQueueFlushes)
+      .def("GetEdepSnapshot",
+           [](GateDoseActor &a) { return SnapshotView(a, a.fEdepSnapshot); })
+      .def("GetDoseSnapshot",
+           [](GateDoseActor &a) { return SnapshotView(a, a.fDoseSnapshot); })
+      .def("GetSnapshotNumberOfEvents",
+           [](const GateDoseActor &a) {
+             return a.fEdepSnapshot.GetNumberOfEvents();
+           })
       .def("GetPhysicalVolumeName", &GateDoseActor::GetPhysicalVolumeName)
       .def("SetPhysicalVolumeName", &GateDoseActor::SetPhysicalVolumeName)
-      .def_readwrite("NbOfEvent", &GateDoseActor::NbOfEvent)
+      .def_property(
+          "NbOfEvent", &GateDoseActor::GetNumberOfEvents,
+          [](GateDoseActor &a, int n) { a.NbOfEvent = n; })
+      .def_readwrite("NbOfBatches", &GateDoseActor::NbOfBatches)
       .def_readwrite("cpp_edep_image", &GateDoseActor::cpp_edep_image)
       .def_readwrite("cpp_edep_squared_image",
                      &GateDoseActor::cpp_edep_squared_image)
@@ -0,0 +1,65 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateDoseRateActor.h"
+
+class PyGateDoseRateActor : public GateDoseRateActor {
+public:
+  // Inherit the constructors
+  using GateDoseRateActor::GateDoseRateActor;
+
+  void BeginOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(void, GateDoseRateActor, BeginOfRunActionMasterThread,
+                      run_id);
+  }
+
+  int EndOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(int, GateDoseRateActor, EndOfRunActionMasterThread,
+                      run_id);
+  }
+};
+
+void init_GateDoseRateActor(py::module &m) {
+  py::class_<GateDoseRateActor, PyGateDoseRateActor,
+             std::unique_ptr<GateDoseRateActor, py::nodelete>,
+             GateTLEDoseActor>(m, "GateDoseRateActor")
+      .def(py::init<py::dict &>())
+      .def("InitializeUserInfo", &GateDoseRateActor::InitializeUserInfo)
+      .def("BeginOfRunActionMasterThread",
+           &GateDoseRateActor::BeginOfRunActionMasterThread)
+      .def("EndOfRunActionMasterThread",
+           &GateDoseRateActor::EndOfRunActionMasterThread)
+      .def("StartSimulationAction", &GateDoseRateActor::StartSimulationAction)
+      .def("SetFrameWeights",
+           [](GateDoseRateActor &a,
+              py::array_t<double, py::array::c_style | py::array::forcecast>
+                  weights,
+              const std::vector<double> &spacing) {
+             // (z, y, x, frame) array, as read with itk/numpy
+             if (weights.ndim() != 4)
+               throw std::runtime_error("The weights must be a 4D array");
+             a.SetFrameWeights(weights.data(), weights.shape(2),
+                               weights.shape(1), weights.shape(0),
+                               weights.shape(3), spacing);
+           })
+      .def("PrepareFramesForRun", &GateDoseRateActor::PrepareFramesForRun)
+      .def("GetNumberOfFrames", &GateDoseRateActor::GetNumberOfFrames)
+      .def("GetFrameDose",
+           [](const GateDoseRateActor &a) {
+             // copy, frame major (frame, z, y, x once reshaped)
+             auto &d = a.GetFrameDose();
+             return py::array_t<double>(d.size(), d.data());
+           })
+      .def("GetNumberOfSimulatedEvents",
+           &GateDoseRateActor::GetNumberOfSimulatedEvents);
+}
@@ -0,0 +1,36 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateDynamicGeometryActor.h"
+
+class PyGateDynamicGeometryActor : public GateDynamicGeometryActor {
+public:
+  // Inherit the constructors
+  using GateDynamicGeometryActor::GateDynamicGeometryActor;
+
+  void ApplyPythonChanges(int run_id) override {
+    PYBIND11_OVERLOAD(void, GateDynamicGeometryActor, ApplyPythonChanges,
+                      run_id);
+  }
+};
+
+void init_GateDynamicGeometryActor(py::module &m) {
+  py::class_<GateDynamicGeometryActor, PyGateDynamicGeometryActor,
+             std::unique_ptr<GateDynamicGeometryActor, py::nodelete>,
+             GateVActor>(m, "GateDynamicGeometryActor")
+      .def(py::init<py::dict &>())
+      .def("SetMotionTable", &GateDynamicGeometryActor::SetMotionTable)
+      .def("SetPythonChangesFlag",
+           &GateDynamicGeometryActor::SetPythonChangesFlag)
+      .def("ApplyPythonChanges",
+           &GateDynamicGeometryActor::ApplyPythonChanges);
+}
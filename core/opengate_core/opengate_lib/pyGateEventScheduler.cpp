@@ -0,0 +1,20 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateEventScheduler.h"
+
+void init_GateEventScheduler(py::module &m) {
+  py::class_<GateEventScheduler, std::shared_ptr<GateEventScheduler>>(
+      m, "GateEventScheduler")
+      .def(py::init<int, std::int64_t>())
+      .def("GetNumberOfThreads", &GateEventScheduler::GetNumberOfThreads)
+      .def("GetNumberOfChunks", &GateEventScheduler::GetNumberOfChunks);
+}
@@ -0,0 +1,83 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateFlatGeometryActor.h"
+
+namespace {
+// copy of a flat array as a numpy array of the given shape
+template <class T>
+py::array_t<T> ToArray(const std::vector<T> &v,
+                       const std::vector<py::ssize_t> &shape) {
+  py::array_t<T> a(shape);
+  std::copy(v.begin(), v.end(), a.mutable_data());
+  return a;
+}
+} // namespace
+
+void init_GateFlatGeometryActor(py::module &m) {
+  py::class_<GateFlatGeometryActor,
+             std::unique_ptr<GateFlatGeometryActor, py::nodelete>,
+             GateVActor>(m, "GateFlatGeometryActor")
+      .def(py::init<py::dict &>())
+      .def("SetPhantomVolumeName", &GateFlatGeometryActor::SetPhantomVolumeName)
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageNestedParameterisation *>(
+               &GateFlatGeometryActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRegularParameterisation *>(
+               &GateFlatGeometryActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRunParameterisation *>(
+               &GateFlatGeometryActor::SetImageParameterisation))
+      .def("IsBuilt", &GateFlatGeometryActor::IsBuilt)
+      .def_readonly("fSize", &GateFlatGeometryActor::fSize)
+      .def_readonly("fSpacing", &GateFlatGeometryActor::fSpacing)
+      .def_readonly("fOrigin", &GateFlatGeometryActor::fOrigin)
+      .def_readonly("fMaterialNames", &GateFlatGeometryActor::fMaterialNames)
+      .def_readonly("fCrystalHalfSize",
+                    &GateFlatGeometryActor::fCrystalHalfSize)
+      .def("GetDirection",
+           [](const GateFlatGeometryActor &self) {
+             return ToArray(self.fDirection, {3, 3});
+           })
+      .def("GetLabels",
+           [](const GateFlatGeometryActor &self) {
+             // (z, y, x) as the numpy arrays of the itk images
+             const auto &s = self.fSize;
+             return ToArray(self.fLabels, {static_cast<py::ssize_t>(s[2]),
+                                           static_cast<py::ssize_t>(s[1]),
+                                           static_cast<py::ssize_t>(s[0])});
+           })
+      .def("GetEnergies",
+           [](const GateFlatGeometryActor &self) {
+             return ToArray(self.fEnergies, {static_cast<py::ssize_t>(
+                                                self.fEnergies.size())});
+           })
+      .def("GetMu",
+           [](const GateFlatGeometryActor &self) {
+             const auto nb = static_cast<py::ssize_t>(self.fEnergies.size());
+             const auto n = static_cast<py::ssize_t>(self.fMu.size()) / nb;
+             return ToArray(self.fMu, {n, nb});
+           })
+      .def("GetCrystalCenters",
+           [](const GateFlatGeometryActor &self) {
+             const auto n =
+                 static_cast<py::ssize_t>(self.fCrystalCenters.size() / 3);
+             return ToArray(self.fCrystalCenters, {n, 3});
+           })
+      .def("GetCrystalRotations", [](const GateFlatGeometryActor &self) {
+        const auto n =
+            static_cast<py::ssize_t>(self.fCrystalRotations.size() / 9);
+        return ToArray(self.fCrystalRotations, {n, 3, 3});
+      });
+}
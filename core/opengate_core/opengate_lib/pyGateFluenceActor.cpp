@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -39,6 +40,39 @@ void init_GateFluenceActor(py::module &m) {
            &GateFluenceActor::EndOfRunActionMasterThread)
       .def("GetPhysicalVolumeName", &GateFluenceActor::GetPhysicalVolumeName)
       .def("SetPhysicalVolumeName", &GateFluenceActor::SetPhysicalVolumeName)
-      .def_readwrite("NbOfEvent", &GateFluenceActor::NbOfEvent)
+      .def_property(
+          "NbOfEvent", &GateFluenceActor::GetNumberOfEvents,
+          [](GateFluenceActor &a, int n) { a.NbOfEvent = n; })
+      .def("GetNumberOfEnergyBins", &GateFluenceActor::GetNumberOfEnergyBins)
+      .def("GetSpectralFluence",
+           [](const GateFluenceActor &a) {
+             // copy as a (voxels, bins) array, voxels in the itk order
+             const auto &v = a.GetSpectralFluence();
+             auto nb_bins = a.GetNumberOfEnergyBins();
+             auto nb_voxels = nb_bins > 0 ? v.size() / nb_bins : 0;
+             py::array_t<double> arr({nb_voxels, nb_bins});
+             std::copy(v.begin(), v.end(), arr.mutable_data());
+             return arr;
+           })
+      .def("ClearSpectralFluence", &GateFluenceActor::ClearSpectralFluence)
+      .def("TakeSnapshot", &GateFluenceActor::TakeSnapshot)
+      .def("GetFluenceSnapshot",
+           [](GateFluenceActor &a) {
+             // view (no copy) shaped as the image (z, y, x)
+             auto size =
+                 a.cpp_fluence_image->GetLargestPossibleRegion().GetSize();
+             auto &s = a.fFluenceSnapshot;
+             if (s.GetValues().size() != size[0] * size[1] * size[2])
+               return py::array_t<double>(0);
+             std::vector<py::ssize_t> shape = {(py::ssize_t)size[2],
+                                               (py::ssize_t)size[1],
+                                               (py::ssize_t)size[0]};
+             return py::array_t<double>(shape, s.GetValuesPointer(),
+                                        py::cast(&a));
+           })
+      .def("GetSnapshotNumberOfEvents",
+           [](const GateFluenceActor &a) {
+             return a.fFluenceSnapshot.GetNumberOfEvents();
+           })
       .def_readwrite("cpp_fluence_image", &GateFluenceActor::cpp_fluence_image);
 }
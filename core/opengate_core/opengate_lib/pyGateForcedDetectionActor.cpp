@@ -0,0 +1,34 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateForcedDetectionActor.h"
+
+void init_GateForcedDetectionActor(py::module &m) {
+  py::class_<GateForcedDetectionActor,
+             std::unique_ptr<GateForcedDetectionActor, py::nodelete>,
+             GateVActor>(m, "GateForcedDetectionActor")
+      .def(py::init<py::dict &>())
+      .def_readwrite("fImage", &GateForcedDetectionActor::fImage)
+      .def("SetPhantomVolumeName",
+           &GateForcedDetectionActor::SetPhantomVolumeName)
+      .def("SetDetectorVolumeName",
+           &GateForcedDetectionActor::SetDetectorVolumeName)
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageNestedParameterisation *>(
+               &GateForcedDetectionActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRegularParameterisation *>(
+               &GateForcedDetectionActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRunParameterisation *>(
+               &GateForcedDetectionActor::SetImageParameterisation));
+}
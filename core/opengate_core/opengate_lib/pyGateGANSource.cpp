@@ -20,6 +20,7 @@ void init_GateGANSource(py::module &m) {
       .def("InitializeUserInfo", &GateGANSource::InitializeUserInfo)
       .def("SetGeneratorFunction", &GateGANSource::SetGeneratorFunction)
       .def("SetGeneratorInfo", &GateGANSource::SetGeneratorInfo)
+      .def("SetNativeGeneratorInfo", &GateGANSource::SetNativeGeneratorInfo)
 
       .def_readwrite("fPositionX", &GateGANSource::fPositionX)
       .def_readwrite("fPositionY", &GateGANSource::fPositionY)
@@ -10,7 +10,26 @@
 namespace py = pybind11;
 
 #include "GateHelpersDict.h"
+#include "GateHelpersGeometry.h"
+#include "GateMutex.h"
+#include "GatePerfCounters.h"
+#include "GateTimeline.h"
 
 void init_GateHelpers(py::module &m) {
   m.def("DictGetG4RotationMatrix", DictGetG4RotationMatrix);
+  m.def("InvalidateVolumeTransformCache", InvalidateVolumeTransformCache);
+  m.def("IsMutexStatisticsEnabled", IsMutexStatisticsEnabled);
+  m.def("ResetMutexStatistics", ResetMutexStatistics);
+  m.def("GetMutexStatistics", GetMutexStatistics);
+  m.def("IsPerfCountersAvailable", GatePerfCounters::IsAvailable);
+  m.def("EnableTimeline", GateTimeline::Enable);
+  m.def("ResetTimeline", GateTimeline::Reset);
+  m.def("GetTimelineEvents", GateTimeline::GetEvents);
+  // markers of the Python side (the names are interned)
+  m.def("TimelineBegin", [](const std::string &name, const std::string &cat) {
+    GateTimeline::Begin(GateTimeline::Intern(name), GateTimeline::Intern(cat));
+  });
+  m.def("TimelineEnd", [](const std::string &name, const std::string &cat) {
+    GateTimeline::End(GateTimeline::Intern(name), GateTimeline::Intern(cat));
+  });
 }
@@ -0,0 +1,17 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateHugePages.h"
+
+void init_GateHugePages(py::module &m) {
+  m.def("GateHugePagesEnable", &GateHugePages::Enable);
+  m.def("GateHugePagesIsEnabled", &GateHugePages::IsEnabled);
+}
@@ -0,0 +1,28 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "G4VPVParameterisation.hh"
+#include "GateImageRunParameterisation.h"
+
+void init_GateImageRunParameterisation(py::module &m) {
+
+  py::class_<GateImageRunParameterisation, G4VPVParameterisation>(
+      m, "GateImageRunParameterisation")
+      .def(py::init<>())
+      .def_readwrite("cpp_edep_image", &GateImageRunParameterisation::cpp_image)
+      .def_readwrite("max_run_length",
+                     &GateImageRunParameterisation::fMaxRunLength)
+      .def("initialize_image", &GateImageRunParameterisation::initialize_image)
+      .def("initialize_material",
+           &GateImageRunParameterisation::initialize_material)
+      .def("GetNumberOfRuns", &GateImageRunParameterisation::GetNumberOfRuns);
+}
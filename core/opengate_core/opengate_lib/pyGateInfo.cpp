@@ -21,5 +21,6 @@ void init_GateInfo(py::module &m) {
       .def("get_G4VIS_USE_OPENGLQT", &GateInfo::get_G4VIS_USE_OPENGLQT)
       .def("get_QT_VERSION", &GateInfo::get_QT_VERSION)
       .def("test", &GateInfo::test)
-      .def("get_G4GDML", &GateInfo::get_G4GDML);
+      .def("get_G4GDML", &GateInfo::get_G4GDML)
+      .def("get_ONNXRuntime", &GateInfo::get_ONNXRuntime);
 }
@@ -17,5 +17,7 @@ void init_GateKillAccordingProcessesActor(py::module &m) {
              GateVActor>(m, "GateKillAccordingProcessesActor")
       .def_readwrite("fListOfVolumeAncestor",
                      &GateKillAccordingProcessesActor::fListOfVolumeAncestor)
-      .def(py::init<py::dict &>());
+      .def(py::init<py::dict &>())
+      .def("GetNumberOfKilledParticles",
+           &GateKillAccordingProcessesActor::GetNumberOfKilledParticles);
 }
@@ -6,6 +6,7 @@
    -------------------------------------------------- */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -16,5 +17,6 @@ void init_GateKillActor(py::module &m) {
              GateVActor>(m, "GateKillActor")
       .def(py::init<py::dict &>())
       .def("GetNumberOfKilledParticles",
-           &GateKillActor::GetNumberOfKilledParticles);
+           &GateKillActor::GetNumberOfKilledParticles)
+      .def("GetKillSpectra", &GateKillActor::GetKillSpectra);
 }
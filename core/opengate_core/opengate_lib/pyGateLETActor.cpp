@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -12,6 +13,20 @@ namespace py = pybind11;
 
 #include "GateLETActor.h"
 
+namespace {
+// View of the values of the snapshot (no copy), shaped as the image
+// (z, y, x). The actor owns the memory.
+py::array_t<double> SnapshotView(GateLETActor &a, GateImageSnapshot &s) {
+  auto size = a.cpp_numerator_image->GetLargestPossibleRegion().GetSize();
+  if (s.GetValues().size() != size[0] * size[1] * size[2])
+    return py::array_t<double>(0);
+  std::vector<py::ssize_t> shape = {(py::ssize_t)size[2],
+                                    (py::ssize_t)size[1],
+                                    (py::ssize_t)size[0]};
+  return py::array_t<double>(shape, s.GetValuesPointer(), py::cast(&a));
+}
+} // namespace
+
 class PyGateLETActor : public GateLETActor {
 public:
   // Inherit the constructors
@@ -39,6 +54,39 @@ void init_GateLETActor(py::module &m) {
       .def_readwrite("cpp_denominator_image",
                      &GateLETActor::cpp_denominator_image)
       .def_readwrite("NbOfEvent", &GateLETActor::NbOfEvent)
+      .def("TakeSnapshot", &GateLETActor::TakeSnapshot)
+      .def("GetNumeratorSnapshot",
+           [](GateLETActor &a) {
+             return SnapshotView(a, a.fNumeratorSnapshot);
+           })
+      .def("GetDenominatorSnapshot",
+           [](GateLETActor &a) {
+             return SnapshotView(a, a.fDenominatorSnapshot);
+           })
+      .def("GetSnapshotNumberOfEvents",
+           [](const GateLETActor &a) {
+             return a.fNumeratorSnapshot.GetNumberOfEvents();
+           })
+      .def("GetNumberOfSpectrumElements",
+           &GateLETActor::GetNumberOfSpectrumElements)
+      // COO arrays of the spectra: voxel (flat index), bin, value
+      .def("GetSpectrum",
+           [](const GateLETActor &a) {
+             auto elements = a.GetSortedSpectrumElements();
+             auto n = static_cast<py::ssize_t>(elements.size());
+             py::array_t<std::int64_t> voxels(n);
+             py::array_t<std::int32_t> bins(n);
+             py::array_t<double> values(n);
+             auto v = voxels.mutable_unchecked<1>();
+             auto b = bins.mutable_unchecked<1>();
+             auto x = values.mutable_unchecked<1>();
+             for (py::ssize_t i = 0; i < n; i++) {
+               v(i) = GateLETActor::SpectrumKeyToVoxel(elements[i].first);
+               b(i) = GateLETActor::SpectrumKeyToBin(elements[i].first);
+               x(i) = elements[i].second;
+             }
+             return py::make_tuple(voxels, bins, values);
+           })
       .def("GetPhysicalVolumeName", &GateLETActor::GetPhysicalVolumeName)
       .def("SetPhysicalVolumeName", &GateLETActor::SetPhysicalVolumeName);
   //      .def_readwrite("fPhysicalVolumeName",
@@ -6,6 +6,7 @@
    -------------------------------------------------- */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -16,5 +17,6 @@ void init_GateMaterialMuHandler(py::module &m) {
              std::unique_ptr<GateMaterialMuHandler, py::nodelete>>(
       m, "GateMaterialMuHandler")
       .def("GetInstance", &GateMaterialMuHandler::GetInstance)
-      .def("GetMu", &GateMaterialMuHandler::GetMu);
+      .def("GetMu", &GateMaterialMuHandler::GetMu)
+      .def("GetMuOfAllCouples", &GateMaterialMuHandler::GetMuOfAllCouples);
 }
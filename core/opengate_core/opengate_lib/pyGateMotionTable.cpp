@@ -0,0 +1,27 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateMotionTable.h"
+
+void init_GateMotionTable(py::module &m) {
+  py::class_<GateMotionTable, std::shared_ptr<GateMotionTable>>(
+      m, "GateMotionTable")
+      .def(py::init())
+      .def("SetStepTimes", &GateMotionTable::SetStepTimes)
+      .def("SetGeometryOpenClose", &GateMotionTable::SetGeometryOpenClose)
+      .def("AddTranslations", &GateMotionTable::AddTranslations)
+      .def("AddRotations", &GateMotionTable::AddRotations)
+      .def("FindStep", &GateMotionTable::FindStep)
+      .def("GetNumberOfSteps", &GateMotionTable::GetNumberOfSteps)
+      .def("GetNumberOfVolumes", &GateMotionTable::GetNumberOfVolumes)
+      .def("GetNumberOfMoves", &GateMotionTable::GetNumberOfMoves);
+}
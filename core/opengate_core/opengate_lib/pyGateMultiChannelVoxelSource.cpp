@@ -0,0 +1,24 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateMultiChannelVoxelSource.h"
+
+void init_GateMultiChannelVoxelSource(py::module &m) {
+
+  py::class_<GateMultiChannelVoxelSource, GateVoxelSource>(
+      m, "GateMultiChannelVoxelSource")
+      .def(py::init())
+      .def("SetRunChannelActivities",
+           &GateMultiChannelVoxelSource::SetRunChannelActivities)
+      .def("InitializeUserInfo",
+           &GateMultiChannelVoxelSource::InitializeUserInfo);
+}
@@ -0,0 +1,30 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateOpticalFastResponseActor.h"
+
+void init_GateOpticalFastResponseActor(py::module &m) {
+  py::class_<GateOpticalFastResponseActor,
+             std::unique_ptr<GateOpticalFastResponseActor, py::nodelete>,
+             GateVActor>(m, "GateOpticalFastResponseActor")
+      .def(py::init<py::dict &>())
+      .def("SetLookupTable", &GateOpticalFastResponseActor::SetLookupTable)
+      .def("GetCreatedPhotons",
+           &GateOpticalFastResponseActor::GetCreatedPhotons)
+      .def("GetDetectedPhotons",
+           &GateOpticalFastResponseActor::GetDetectedPhotons)
+      .def("GetTransitHistograms",
+           &GateOpticalFastResponseActor::GetTransitHistograms)
+      .def("GetBoxMin", &GateOpticalFastResponseActor::GetBoxMin)
+      .def("GetBoxMax", &GateOpticalFastResponseActor::GetBoxMax)
+      .def("GetResults", &GateOpticalFastResponseActor::GetResults);
+}
@@ -16,5 +16,16 @@ void init_GateOptrFreeFlightActor(py::module &m) {
              std::unique_ptr<GateOptrFreeFlightActor, py::nodelete>>(
       m, "GateOptrFreeFlightActor")
       .def(py::init<py::dict &>())
-      .def("ConfigureForWorker", &GateOptrFreeFlightActor::ConfigureForWorker);
+      .def("ConfigureForWorker", &GateOptrFreeFlightActor::ConfigureForWorker)
+      .def("SetPhantomVolumeName",
+           &GateOptrFreeFlightActor::SetPhantomVolumeName)
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageNestedParameterisation *>(
+               &GateOptrFreeFlightActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRegularParameterisation *>(
+               &GateOptrFreeFlightActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRunParameterisation *>(
+               &GateOptrFreeFlightActor::SetImageParameterisation));
 }
@@ -0,0 +1,22 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "G4VPhysicsConstructor.hh"
+#include "GateParallelWorldPhysics.h"
+
+void init_GateParallelWorldPhysics(py::module &m) {
+  py::class_<GateParallelWorldPhysics, G4VPhysicsConstructor,
+             std::unique_ptr<GateParallelWorldPhysics, py::nodelete>>(
+      m, "GateParallelWorldPhysics")
+      .def(py::init<const std::string &, bool,
+                    const std::vector<std::string> &>());
+}
@@ -0,0 +1,94 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateHelpers.h"
+#include "GateParticleBank.h"
+#include <sstream>
+
+namespace {
+
+using DoubleArray =
+    py::array_t<double, py::array::c_style | py::array::forcecast>;
+using IntArray =
+    py::array_t<std::int32_t, py::array::c_style | py::array::forcecast>;
+
+// the arrays are copied in the particles (with the GIL), then the producer
+// waits for some room in the bank without the GIL (the Geant4 threads may
+// need it meanwhile)
+size_t Push(GateParticleBank &bank, const IntArray &pdg,
+            const DoubleArray &energy, const DoubleArray &position,
+            const DoubleArray &direction, const py::object &weight,
+            const py::object &time) {
+  auto n = static_cast<size_t>(energy.size());
+  auto check = [n](const py::array &a, size_t m, const std::string &name) {
+    if (static_cast<size_t>(a.size()) != n * m) {
+      std::ostringstream oss;
+      oss << "GateParticleBank: " << n << " energies, but " << a.size()
+          << " values for '" << name << "' (" << n * m << " expected)";
+      Fatal(oss.str());
+    }
+  };
+  check(position, 3, "position");
+  check(direction, 3, "direction");
+  // pdg, weight and time are optional (a single value is used for all)
+  auto optional = [&](const py::object &o, const std::string &name) {
+    if (o.is_none())
+      return DoubleArray();
+    auto a = DoubleArray::ensure(o);
+    if (a.size() > 1)
+      check(a, 1, name);
+    return a;
+  };
+  auto w = optional(weight, "weight");
+  auto t = optional(time, "time");
+  if (pdg.size() > 1)
+    check(pdg, 1, "pdg");
+
+  std::vector<GateParticleBank::Particle> particles(n);
+  const auto *e = energy.data();
+  const auto *pos = position.data();
+  const auto *dir = direction.data();
+  for (size_t i = 0; i < n; i++) {
+    auto &p = particles[i];
+    p.fPDGCode = pdg.size() == 0 ? 0 : pdg.data()[pdg.size() > 1 ? i : 0];
+    p.fEnergy = e[i];
+    for (size_t j = 0; j < 3; j++) {
+      p.fPosition[j] = pos[3 * i + j];
+      p.fDirection[j] = dir[3 * i + j];
+    }
+    if (w.size() > 0)
+      p.fWeight = w.data()[w.size() > 1 ? i : 0];
+    if (t.size() > 0)
+      p.fTime = t.data()[t.size() > 1 ? i : 0];
+  }
+  py::gil_scoped_release release;
+  return bank.Push(particles.data(), n);
+}
+
+} // namespace
+
+void init_GateParticleBank(py::module &m) {
+  py::class_<GateParticleBank, std::shared_ptr<GateParticleBank>>(
+      m, "GateParticleBank")
+      .def(py::init<size_t>())
+      .def("Push", &Push, py::arg("pdg"), py::arg("energy"),
+           py::arg("position"), py::arg("direction"),
+           py::arg("weight") = py::none(), py::arg("time") = py::none())
+      .def("Close", &GateParticleBank::Close)
+      .def("IsClosed", &GateParticleBank::IsClosed)
+      .def("GetSize", &GateParticleBank::GetSize)
+      .def("GetCapacity", &GateParticleBank::GetCapacity)
+      .def("GetNumberOfPushedParticles",
+           &GateParticleBank::GetNumberOfPushedParticles)
+      .def("GetNumberOfPoppedParticles",
+           &GateParticleBank::GetNumberOfPoppedParticles);
+}
@@ -0,0 +1,20 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateParticleBankSource.h"
+
+void init_GateParticleBankSource(py::module &m) {
+
+  py::class_<GateParticleBankSource, GateVSource>(m, "GateParticleBankSource")
+      .def(py::init())
+      .def("InitializeUserInfo", &GateParticleBankSource::InitializeUserInfo)
+      .def("SetBank", &GateParticleBankSource::SetBank);
+}
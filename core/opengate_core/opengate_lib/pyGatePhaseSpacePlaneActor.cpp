@@ -0,0 +1,16 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include "GatePhaseSpacePlaneActor.h"
+#include <pybind11/pybind11.h>
+
+void init_GatePhaseSpacePlaneActor(py::module &m) {
+
+  py::class_<GatePhaseSpacePlaneActor, GatePhaseSpaceActor>(
+      m, "GatePhaseSpacePlaneActor")
+      .def(py::init<py::dict &>());
+}
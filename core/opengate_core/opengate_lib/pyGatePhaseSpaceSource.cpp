@@ -18,6 +18,11 @@ void init_GatePhaseSpaceSource(py::module &m) {
       .def(py::init())
       .def("InitializeUserInfo", &GatePhaseSpaceSource::InitializeUserInfo)
       .def("SetGeneratorFunction", &GatePhaseSpaceSource::SetGeneratorFunction)
+      .def("InitializeNativeReader",
+           &GatePhaseSpaceSource::InitializeNativeReader)
+      .def("SetEntryStart", &GatePhaseSpaceSource::SetEntryStart)
+      .def("GetNumberOfEntries", &GatePhaseSpaceSource::GetNumberOfEntries)
+      .def("GetCycleCount", &GatePhaseSpaceSource::GetCycleCount)
 
       .def("SetEnergyBatch", &GatePhaseSpaceSource::SetEnergyBatch)
       .def("SetWeightBatch", &GatePhaseSpaceSource::SetWeightBatch)
@@ -0,0 +1,32 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "G4MTRunManager.hh"
+#include "GateNuma.h"
+#include "GatePhiloxEngine.h"
+#include "GateWorkerThreadInitialization.h"
+
+void init_GatePhiloxEngine(py::module &m) {
+  py::class_<GatePhiloxEngine, CLHEP::HepRandomEngine>(m, "GatePhiloxEngine")
+      .def(py::init())
+      .def("SetStream", &GatePhiloxEngine::SetStream);
+
+  // the workers need a GatePhiloxEngine when the master has one (the run
+  // manager deletes the initialization)
+  m.def("SetGateWorkerThreadInitialization", [](G4MTRunManager *rm) {
+    rm->SetUserInitialization(new GateWorkerThreadInitialization());
+  });
+
+  // NUMA placement of the workers (used by GateWorkerThreadInitialization)
+  m.def("GateNumaConfigure", &GateNuma::Configure);
+  m.def("GateNumaGetNumberOfNodes", &GateNuma::GetNumberOfNodes);
+  m.def("GateNumaGetNodeOfThread", &GateNuma::GetNodeOfThread);
+}
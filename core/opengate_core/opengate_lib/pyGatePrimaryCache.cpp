@@ -0,0 +1,26 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GatePrimaryCache.h"
+
+void init_GatePrimaryCache(py::module &m) {
+  py::class_<GatePrimaryCache, std::shared_ptr<GatePrimaryCache>>(
+      m, "GatePrimaryCache")
+      .def(py::init())
+      .def("OpenForRecording", &GatePrimaryCache::OpenForRecording)
+      .def("OpenForReplay", &GatePrimaryCache::OpenForReplay)
+      .def("Close", &GatePrimaryCache::Close)
+      .def("IsRecording", &GatePrimaryCache::IsRecording)
+      .def("IsReplaying", &GatePrimaryCache::IsReplaying)
+      .def("GetNumberOfRecordedEvents",
+           &GatePrimaryCache::GetNumberOfRecordedEvents)
+      .def("GetNumberOfEvents", &GatePrimaryCache::GetNumberOfEvents);
+}
@@ -0,0 +1,61 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateROIDoseActor.h"
+
+class PyGateROIDoseActor : public GateROIDoseActor {
+public:
+  // Inherit the constructors
+  using GateROIDoseActor::GateROIDoseActor;
+
+  void BeginOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(void, GateROIDoseActor, BeginOfRunActionMasterThread,
+                      run_id);
+  }
+
+  int EndOfRunActionMasterThread(int run_id) override {
+    PYBIND11_OVERLOAD(int, GateROIDoseActor, EndOfRunActionMasterThread,
+                      run_id);
+  }
+};
+
+void init_GateROIDoseActor(py::module &m) {
+  py::class_<GateROIDoseActor, PyGateROIDoseActor,
+             std::unique_ptr<GateROIDoseActor, py::nodelete>, GateVActor>(
+      m, "GateROIDoseActor")
+      .def(py::init<py::dict &>())
+      .def("BeginOfRunActionMasterThread",
+           &GateROIDoseActor::BeginOfRunActionMasterThread)
+      .def("EndOfRunActionMasterThread",
+           &GateROIDoseActor::EndOfRunActionMasterThread)
+      .def("SetVoxelROIs",
+           [](GateROIDoseActor &a,
+              py::array_t<std::int32_t,
+                          py::array::c_style | py::array::forcecast>
+                  rois,
+              int nb_rois, std::vector<double> spacing) {
+             // 3D array in numpy order (Z Y X)
+             a.SetVoxelROIs(rois.data(), rois.shape(2), rois.shape(1),
+                            rois.shape(0), nb_rois, spacing);
+           })
+      .def("GetNumberOfROIs", &GateROIDoseActor::GetNumberOfROIs)
+      .def("GetNumberOfROIVoxels", &GateROIDoseActor::GetNumberOfROIVoxels)
+      .def("GetROIEdep", &GateROIDoseActor::GetROIEdep)
+      .def("GetROIDose", &GateROIDoseActor::GetROIDose)
+      .def("GetROIDoseUncertainty", &GateROIDoseActor::GetROIDoseUncertainty)
+      .def("GetDVH", &GateROIDoseActor::GetDVH)
+      .def("GetDVHMaxDose", &GateROIDoseActor::GetDVHMaxDose)
+      .def("GetNumberOfEvents", &GateROIDoseActor::GetNumberOfEvents)
+      .def("GetPhysicalVolumeName", &GateROIDoseActor::GetPhysicalVolumeName)
+      .def("SetPhysicalVolumeName", &GateROIDoseActor::SetPhysicalVolumeName);
+}
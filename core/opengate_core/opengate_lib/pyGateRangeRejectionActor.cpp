@@ -0,0 +1,21 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateRangeRejectionActor.h"
+
+void init_GateRangeRejectionActor(py::module &m) {
+  py::class_<GateRangeRejectionActor,
+             std::unique_ptr<GateRangeRejectionActor, py::nodelete>,
+             GateVActor>(m, "GateRangeRejectionActor")
+      .def(py::init<py::dict &>())
+      .def("GetNumberOfKilledParticles",
+           &GateRangeRejectionActor::GetNumberOfKilledParticles);
+}
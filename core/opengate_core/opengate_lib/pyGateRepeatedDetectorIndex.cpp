@@ -0,0 +1,29 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateRepeatedDetectorIndex.h"
+
+void init_GateRepeatedDetectorIndex(py::module &m) {
+  py::class_<GateRepeatedDetectorIndex>(m, "GateRepeatedDetectorIndex")
+      .def(py::init<>())
+      .def("Initialize", &GateRepeatedDetectorIndex::Initialize)
+      .def("GetNumberOfLevels", &GateRepeatedDetectorIndex::GetNumberOfLevels)
+      .def("GetNumberOfCrystals",
+           &GateRepeatedDetectorIndex::GetNumberOfCrystals)
+      .def("GetNumberOfCopies", &GateRepeatedDetectorIndex::GetNumberOfCopies)
+      .def("GetIndex", py::overload_cast<const std::vector<int> &>(
+                           &GateRepeatedDetectorIndex::GetIndex, py::const_))
+      .def("GetCopyNumbers", &GateRepeatedDetectorIndex::GetCopyNumbers)
+      .def("GetLocalToWorldTransform",
+           &GateRepeatedDetectorIndex::GetLocalToWorldTransform)
+      .def("GetCenter", &GateRepeatedDetectorIndex::GetCenter);
+}
@@ -0,0 +1,27 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateRussianRouletteActor.h"
+
+void init_GateRussianRouletteActor(py::module &m) {
+  py::class_<GateRussianRouletteActor,
+             std::unique_ptr<GateRussianRouletteActor, py::nodelete>,
+             GateVActor>(m, "GateRussianRouletteActor")
+      .def(py::init<py::dict &>())
+      .def("GetNumberOfRouletteParticles",
+           &GateRussianRouletteActor::GetNumberOfRouletteParticles)
+      .def("GetNumberOfKilledParticles",
+           &GateRussianRouletteActor::GetNumberOfKilledParticles)
+      .def("GetKilledWeight", &GateRussianRouletteActor::GetKilledWeight)
+      .def("GetSurvivalAddedWeight",
+           &GateRussianRouletteActor::GetSurvivalAddedWeight);
+}
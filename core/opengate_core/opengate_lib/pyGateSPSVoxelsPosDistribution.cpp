@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -20,6 +21,33 @@ void init_GateSPSVoxelsPosDistribution(py::module &m) {
       .def(py::init())
       .def("SetCumulativeDistributionFunction",
            &GateSPSVoxelsPosDistribution::SetCumulativeDistributionFunction)
+      .def("SetAliasTable",
+           [](GateSPSVoxelsPosDistribution &pg,
+              py::array_t<double, py::array::c_style | py::array::forcecast>
+                  activity) {
+             // 3D array in numpy order (Z Y X)
+             pg.SetAliasTable(activity.data(), activity.shape(2),
+                              activity.shape(1), activity.shape(0));
+           })
+      .def("GetNumberOfAliasEntries",
+           &GateSPSVoxelsPosDistribution::GetNumberOfAliasEntries)
+      .def("SetChannels",
+           [](GateSPSVoxelsPosDistribution &pg,
+              py::array_t<std::int32_t,
+                          py::array::c_style | py::array::forcecast>
+                  channels,
+              size_t nb_channels) {
+             // 3D array in numpy order (Z Y X)
+             pg.SetChannels(channels.data(), channels.shape(2),
+                            channels.shape(1), channels.shape(0),
+                            nb_channels);
+           })
+      .def("SetChannelActivities",
+           &GateSPSVoxelsPosDistribution::SetChannelActivities)
+      .def("GetNumberOfChannels",
+           &GateSPSVoxelsPosDistribution::GetNumberOfChannels)
+      .def("GetNumberOfChannelVoxels",
+           &GateSPSVoxelsPosDistribution::GetNumberOfChannelVoxels)
       .def("VGenerateOne", &GateSPSVoxelsPosDistribution::VGenerateOne)
       .def("VGenerateOneDebug",
            &GateSPSVoxelsPosDistribution::VGenerateOneDebug)
@@ -74,5 +74,6 @@ void init_GateSimulationStatisticsActor(py::module &m) {
       .def(py::init<py::dict &>())
       .def("InitializeUserInfo",
            &GateSimulationStatisticsActor::InitializeUserInfo)
-      .def("GetCounts", &GateSimulationStatisticsActor::GetCounts);
+      .def("GetCounts", &GateSimulationStatisticsActor::GetCounts)
+      .def("SetCounts", &GateSimulationStatisticsActor::SetCounts);
 }
@@ -4,6 +4,7 @@
    of the GNU Lesser General  Public Licence (LGPL)
    See LICENSE.md for further details
    -------------------------------------------------- */
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 
 namespace py = pybind11;
@@ -19,6 +20,12 @@ void init_GateSourceManager(py::module &m) {
       .def("AddSource", &GateSourceManager::AddSource)
       .def("Initialize", &GateSourceManager::Initialize)
       .def("SetActors", &GateSourceManager::SetActors)
+      .def("SetPrimaryCache", &GateSourceManager::SetPrimaryCache)
+      .def("SetEventScheduler", &GateSourceManager::SetEventScheduler)
+      .def("SetMotionTable", &GateSourceManager::SetMotionTable)
+      .def("SetEndOfRunCallback", &GateSourceManager::SetEndOfRunCallback)
+      .def("StartNewJob", &GateSourceManager::StartNewJob)
+      .def("SetNewJobCallback", &GateSourceManager::SetNewJobCallback)
       .def("GetExpectedNumberOfEvents",
            &GateSourceManager::GetExpectedNumberOfEvents)
       .def_readwrite("fUserEventInformationFlag",
@@ -0,0 +1,66 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateStepBatchActor.h"
+
+/*
+ * The batch of the calling thread is given as a dict of numpy arrays, without
+ * copy (except the strings, as a list): the arrays are only valid during the
+ * "apply" function (the batch is then cleared). The 3D values are (n, 3)
+ * arrays.
+ */
+
+py::dict GetBatch(GateStepBatchActor &a) {
+  py::dict batch;
+  auto base = py::cast(&a);
+  for (auto *att : a.GetAttributes()) {
+    const auto name = att->GetDigiAttributeName();
+    const auto n = static_cast<size_t>(att->GetSize());
+    switch (att->GetDigiAttributeType()) {
+    case 'D':
+      batch[name.c_str()] =
+          py::array_t<double>(n, att->GetDValues().data(), base);
+      break;
+    case 'I':
+      batch[name.c_str()] = py::array_t<int>(n, att->GetIValues().data(), base);
+      break;
+    case '3': {
+      // (a G4ThreeVector is three contiguous doubles)
+      const std::vector<size_t> shape = {n, 3};
+      const std::vector<size_t> strides = {sizeof(G4ThreeVector),
+                                           sizeof(double)};
+      const auto *p = n > 0 ? &att->Get3Values()[0][0] : nullptr;
+      batch[name.c_str()] = py::array_t<double>(shape, strides, p, base);
+      break;
+    }
+    case 'S':
+      batch[name.c_str()] = py::cast(att->GetSValues());
+      break;
+    default:
+      break;
+    }
+  }
+  return batch;
+}
+
+void init_GateStepBatchActor(py::module &m) {
+  py::class_<GateStepBatchActor,
+             std::unique_ptr<GateStepBatchActor, py::nodelete>, GateVActor>(
+      m, "GateStepBatchActor")
+      .def(py::init<py::dict &>())
+      .def("SetStepBatchFunction", &GateStepBatchActor::SetStepBatchFunction)
+      .def("GetBatchSize", &GateStepBatchActor::GetBatchSize)
+      .def("GetNumberOfBatches", &GateStepBatchActor::GetNumberOfBatches)
+      .def("GetBatch", &GetBatch);
+}
@@ -51,7 +51,9 @@ void init_GateTLEDoseActor(py::module &m) {
       .def("SetCountsFlag", &GateTLEDoseActor::SetCountsFlag)
       .def("GetPhysicalVolumeName", &GateTLEDoseActor::GetPhysicalVolumeName)
       .def("SetPhysicalVolumeName", &GateTLEDoseActor::SetPhysicalVolumeName)
-      .def_readwrite("NbOfEvent", &GateTLEDoseActor::NbOfEvent)
+      .def_property(
+          "NbOfEvent", &GateTLEDoseActor::GetNumberOfEvents,
+          [](GateTLEDoseActor &a, int n) { a.NbOfEvent = n; })
       .def_readwrite("cpp_edep_image", &GateTLEDoseActor::cpp_edep_image)
       .def_readwrite("cpp_edep_squared_image",
                      &GateTLEDoseActor::cpp_edep_squared_image)
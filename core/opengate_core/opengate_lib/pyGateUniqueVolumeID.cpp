@@ -19,5 +19,6 @@ void init_GateUniqueVolumeID(py::module &m) {
              std::unique_ptr<GateUniqueVolumeID, py::nodelete>>(
       m, "GateUniqueVolumeID")
       .def("GetVolumeDepthID", &GateUniqueVolumeID::GetVolumeDepthID)
-      .def_readonly("fID", &GateUniqueVolumeID::fID);
+      .def_property_readonly("fID", &GateUniqueVolumeID::GetID)
+      .def_readonly("fIndex", &GateUniqueVolumeID::fIndex);
 }
@@ -101,6 +101,7 @@ void init_GateVActor(py::module &m) {
       .def("GetWriteToDisk", &GateVActor::GetWriteToDisk)
       .def("SetWriteToDisk", &GateVActor::SetWriteToDisk)
       .def("AddActorOutputInfo", &GateVActor::AddActorOutputInfo)
+      .def("GetTerminationCount", &GateVActor::GetTerminationCount)
       .def("SteppingAction", &GateVActor::SteppingAction);
   //      .def("RegisterCallBack", &GateVActor::RegisterCallBack);
 }
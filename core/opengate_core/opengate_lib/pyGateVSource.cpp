@@ -18,6 +18,10 @@ void init_GateVSource(py::module &m) {
       m, "GateVSource")
       .def(py::init())
       .def("InitializeUserInfo", &GateVSource::InitializeUserInfo)
+      .def("InitializeUserInfoOfThread",
+           &GateVSource::InitializeUserInfoOfThread)
+      .def("GetNumberOfReplayedUserInfoValues",
+           &GateVSource::GetNumberOfReplayedUserInfoValues)
       .def("SetOrientationAccordingToAttachedVolume",
            &GateVSource::SetOrientationAccordingToAttachedVolume);
 }
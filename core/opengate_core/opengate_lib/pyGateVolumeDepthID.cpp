@@ -15,12 +15,20 @@ namespace py = pybind11;
 
 void init_GateVolumeDepthID(py::module &m) {
   py::class_<GateUniqueVolumeID::VolumeDepthID>(m, "GateVolumeDepthID")
-      .def_readonly("fVolumeName",
-                    &GateUniqueVolumeID::VolumeDepthID::fVolumeName)
+      .def_property_readonly(
+          "fVolumeName",
+          [](const GateUniqueVolumeID::VolumeDepthID &v) -> std::string {
+            return v.GetVolumeName();
+          })
       .def_readonly("fCopyNb", &GateUniqueVolumeID::VolumeDepthID::fCopyNb)
       .def_readonly("fDepth", &GateUniqueVolumeID::VolumeDepthID::fDepth)
-      .def_readonly("fTranslation",
-                    &GateUniqueVolumeID::VolumeDepthID::fTranslation)
-      .def_readonly("fRotation", &GateUniqueVolumeID::VolumeDepthID::fRotation)
+      .def_property_readonly("fTranslation",
+                             [](const GateUniqueVolumeID::VolumeDepthID &v) {
+                               return v.fLocalToWorld.NetTranslation();
+                             })
+      .def_property_readonly("fRotation",
+                             [](const GateUniqueVolumeID::VolumeDepthID &v) {
+                               return v.fLocalToWorld.NetRotation();
+                             })
       .def_readonly("fVolume", &GateUniqueVolumeID::VolumeDepthID::fVolume);
 }
@@ -5,6 +5,7 @@
    See LICENSE.md for further details
    -------------------------------------------------- */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -18,6 +19,26 @@ void init_GateVolumeVoxelizer(py::module &m) {
       .def(py::init<>())
       .def_readwrite("fImage", &GateVolumeVoxelizer::fImage)
       .def_readonly("fLabels", &GateVolumeVoxelizer::fLabels)
+      .def_readwrite("fNumberOfThreads", &GateVolumeVoxelizer::fNumberOfThreads)
+      .def_readwrite("fRefinementBlockSize",
+                     &GateVolumeVoxelizer::fRefinementBlockSize)
+      .def_readwrite("fSupersampling", &GateVolumeVoxelizer::fSupersampling)
+      .def("GetFractions",
+           [](const GateVolumeVoxelizer &self) {
+             // (voxel index in the buffer, label, fraction) of the
+             // boundary voxels, as numpy arrays
+             const auto n = static_cast<py::ssize_t>(self.fFractions.size());
+             py::array_t<uint64_t> voxels(n);
+             py::array_t<uint8_t> labels(n);
+             py::array_t<float> fractions(n);
+             std::copy(self.fFractionVoxels.begin(),
+                       self.fFractionVoxels.end(), voxels.mutable_data());
+             std::copy(self.fFractionLabels.begin(),
+                       self.fFractionLabels.end(), labels.mutable_data());
+             std::copy(self.fFractions.begin(), self.fFractions.end(),
+                       fractions.mutable_data());
+             return py::make_tuple(voxels, labels, fractions);
+           })
       .def("GetIndexIsoCenter",
            [](const GateVolumeVoxelizer &self) -> std::vector<float> {
              std::vector<float> c = {self.fIndexIsoCenter[0],
@@ -0,0 +1,28 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include "GateWeightWindowActor.h"
+
+void init_GateWeightWindowActor(py::module &m) {
+  py::class_<GateWeightWindowActor,
+             std::unique_ptr<GateWeightWindowActor, py::nodelete>,
+             GateVActor>(m, "GateWeightWindowActor")
+      .def(py::init<py::dict &>())
+      .def_readwrite("cpp_importance_image",
+                     &GateWeightWindowActor::cpp_importance_image)
+      .def("SetPhysicalVolumeName",
+           &GateWeightWindowActor::SetPhysicalVolumeName)
+      .def("GetNumberOfSplitParticles",
+           &GateWeightWindowActor::GetNumberOfSplitParticles)
+      .def("GetNumberOfKilledParticles",
+           &GateWeightWindowActor::GetNumberOfKilledParticles);
+}
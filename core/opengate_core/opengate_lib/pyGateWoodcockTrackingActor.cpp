@@ -0,0 +1,36 @@
+/* --------------------------------------------------
+   Copyright (C): OpenGATE Collaboration
+   This software is distributed under the terms
+   of the GNU Lesser General  Public Licence (LGPL)
+   See LICENSE.md for further details
+   -------------------------------------------------- */
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include "GateWoodcockTrackingActor.h"
+
+void init_GateWoodcockTrackingActor(py::module &m) {
+  py::class_<GateWoodcockTrackingActor,
+             std::unique_ptr<GateWoodcockTrackingActor, py::nodelete>,
+             GateVActor>(m, "GateWoodcockTrackingActor")
+      .def(py::init<py::dict &>())
+      .def("StartSimulationAction",
+           &GateWoodcockTrackingActor::StartSimulationAction)
+      .def("SetPhantomVolumeName",
+           &GateWoodcockTrackingActor::SetPhantomVolumeName)
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageNestedParameterisation *>(
+               &GateWoodcockTrackingActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRegularParameterisation *>(
+               &GateWoodcockTrackingActor::SetImageParameterisation))
+      .def("SetImageParameterisation",
+           py::overload_cast<GateImageRunParameterisation *>(
+               &GateWoodcockTrackingActor::SetImageParameterisation))
+      .def("GetNumberOfRealInteractions",
+           &GateWoodcockTrackingActor::GetNumberOfRealInteractions)
+      .def("GetNumberOfFictitiousInteractions",
+           &GateWoodcockTrackingActor::GetNumberOfFictitiousInteractions);
+}
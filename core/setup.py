@@ -132,6 +132,19 @@ class CMakeBuild(build_ext):
         cmake_args += ["-DGeant4_DIR=" + sconfig["G4INSTALL"]]
         cmake_args += ["-DITK_DIR=" + sconfig["ITKDIR"]]
 
+        # optional, native inference of the GAN sources
+        if "ONNXRUNTIME_DIR" in env:
+            cmake_args += ["-DOPENGATE_USE_ONNXRUNTIME=ON"]
+            cmake_args += ["-Donnxruntime_DIR=" + env["ONNXRUNTIME_DIR"]]
+
+        # optional, statistics of the mutexes (contention)
+        if env.get("OPENGATE_MUTEX_STATISTICS", "0") == "1":
+            cmake_args += ["-DOPENGATE_MUTEX_STATISTICS=ON"]
+
+        # optional, hardware performance counters (Linux only)
+        if env.get("OPENGATE_PERF_COUNTERS", "0") == "1":
+            cmake_args += ["-DOPENGATE_PERF_COUNTERS=ON"]
+
         print("CMAKE args", cmake_args)
         print()
 
@@ -180,6 +180,7 @@ import opengate.image
 import opengate.physics
 import opengate.base
 import opengate.engines
+import opengate.server
 
 # import opengate.postprocessors
 
@@ -8,6 +8,7 @@ import opengate_core as g4
 from ..base import GateObject, process_cls
 from ..utility import insert_suffix_before_extension, ensure_filename_is_str
 from ..exception import warning, fatal, GateImplementationError
+from ..distributed import get_distributed_context
 from .dataitems import (
     SingleItkImage,
     SingleMeanItkImage,
@@ -272,6 +273,52 @@ class UserInterfaceToActorOutputImage(UserInterfaceToActorOutputUsingDataItemCon
         return self._user_output.get_data(**self._kwargs_for_interface_calls)
 
 
+class UserInterfaceToActorOutputRoot(BaseUserInterfaceToActorOutput):
+
+    @classmethod
+    def __get_docstring_attributes__(cls):
+        docstring = super().__get_docstring_attributes__()
+        for k in ("basket_size", "basket_entries", "compression", "compression_level"):
+            docstring += get_formatted_docstring_rst(cls, k)
+        return docstring
+
+    @property
+    def basket_size(self):
+        """Size in bytes of the baskets of the ROOT tree (None: Geant4 default)."""
+        return self._user_output.basket_size
+
+    @basket_size.setter
+    def basket_size(self, value):
+        self._user_output.basket_size = value
+
+    @property
+    def basket_entries(self):
+        """Number of entries per basket of the ROOT tree (None: Geant4 default)."""
+        return self._user_output.basket_entries
+
+    @basket_entries.setter
+    def basket_entries(self, value):
+        self._user_output.basket_entries = value
+
+    @property
+    def compression(self):
+        """Compression algorithm of the ROOT file, 'zlib' or 'none'."""
+        return self._user_output.compression
+
+    @compression.setter
+    def compression(self, value):
+        self._user_output.compression = value
+
+    @property
+    def compression_level(self):
+        """Compression level of the ROOT file (None: Geant4 default)."""
+        return self._user_output.compression_level
+
+    @compression_level.setter
+    def compression_level(self, value):
+        self._user_output.compression_level = value
+
+
 def _setter_hook_belongs_to(self, belongs_to):
     if belongs_to is None:
         fatal("The belongs_to attribute of an ActorOutput cannot be None.")
@@ -794,6 +841,17 @@ class ActorOutputUsingDataItemContainer(ActorOutputBase):
             self.merged_data = self.data_container_class(belongs_to=self)
 
     def end_of_simulation(self, item="all", **kwargs):
+        # distributed simulation: the data of all processes are merged,
+        # and only written by the process of rank 0
+        context = get_distributed_context()
+        if context.is_distributed:
+            self.merged_data = context.reduce_data_container(self.merged_data)
+            for run_index in sorted(self.data_per_run.keys()):
+                self.data_per_run[run_index] = context.reduce_data_container(
+                    self.data_per_run[run_index]
+                )
+            if not context.is_root:
+                return
         try:
             self.write_data_if_requested(item="all", **kwargs)
         except NotImplementedError:
@@ -899,9 +957,41 @@ class ActorOutputRoot(ActorOutputBase):
                 "read_only": True,
             },
         ),
+        "basket_size": (
+            None,
+            {
+                "doc": "Size in bytes of the buffer of each branch (basket) of the "
+                "ROOT tree. Larger baskets mean fewer, larger compressed blocks: "
+                "faster writes and better compression, but more memory per column "
+                "and per thread. None: Geant4 default (32000).",
+            },
+        ),
+        "basket_entries": (
+            None,
+            {
+                "doc": "Number of entries per basket of the ROOT tree. Geant4 has no "
+                "auto-flush (the baskets are written when they are full): this is "
+                "the closest setting. None: Geant4 default (4000).",
+            },
+        ),
+        "compression": (
+            "zlib",
+            {
+                "doc": "Compression algorithm of the ROOT file: 'zlib' or 'none'. The "
+                "Geant4 ROOT writer only supports zlib, 'lz4' and 'zstd' are rejected.",
+            },
+        ),
+        "compression_level": (
+            None,
+            {
+                "doc": "Compression level of the ROOT file (0 to 9, 0: no "
+                "compression). None: Geant4 default (1).",
+            },
+        ),
     }
 
     default_suffix = "root"
+    _default_interface_class = UserInterfaceToActorOutputRoot
 
     @classmethod
     def get_user_info_default_values_interface(cls, **kwargs):
@@ -941,9 +1031,51 @@ class ActorOutputRoot(ActorOutputBase):
         # for ROOT output, not output_filename means no output to disk (legacy Gate 9 behavior)
         if self.output_filename == "" or self.output_filename is None:
             self.write_to_disk = False
+        self.check_root_file_options()
         self.initialize_cpp_parameters()
         super().initialize()
 
+    def check_root_file_options(self):
+        if self.compression in ("lz4", "zstd"):
+            fatal(
+                f"The compression '{self.compression}' of the output '{self.name}' "
+                f"of the actor '{self.belongs_to_actor.name}' is not available: "
+                f"the ROOT files are written by Geant4 (not by ROOT), which only "
+                f"supports zlib. Use compression='zlib' and compression_level."
+            )
+        if self.compression not in ("zlib", "none"):
+            fatal(
+                f"Unknown compression '{self.compression}' for the output "
+                f"'{self.name}' of the actor '{self.belongs_to_actor.name}', "
+                f"use 'zlib' or 'none'."
+            )
+        if self.compression_level is not None and not 0 <= self.compression_level <= 9:
+            fatal(
+                f"The compression_level of the output '{self.name}' of the actor "
+                f"'{self.belongs_to_actor.name}' must be in [0, 9], while it is "
+                f"{self.compression_level}."
+            )
+        for k in ("basket_size", "basket_entries"):
+            v = getattr(self, k)
+            if v is not None and v <= 0:
+                fatal(
+                    f"The {k} of the output '{self.name}' of the actor "
+                    f"'{self.belongs_to_actor.name}' must be positive, while it is {v}."
+                )
+
+    def get_root_file_options(self):
+        """Options of the ROOT file, -1 for the Geant4 defaults."""
+        level = self.compression_level
+        if self.compression == "none":
+            level = 0
+        return {
+            "basket_size": -1 if self.basket_size is None else int(self.basket_size),
+            "basket_entries": (
+                -1 if self.basket_entries is None else int(self.basket_entries)
+            ),
+            "compression_level": -1 if level is None else int(level),
+        }
+
     def initialize_cpp_parameters(self):
         self.belongs_to_actor.AddActorOutputInfo(self.name)
         self.belongs_to_actor.SetWriteToDisk(self.name, self.write_to_disk)
@@ -951,11 +1083,42 @@ class ActorOutputRoot(ActorOutputBase):
             # this test avoid a warning in get_output_path when it is None
             self.belongs_to_actor.SetOutputPath(self.name, "None")
         else:
+            # distributed simulation: one file per process, merged at the end
             self.belongs_to_actor.SetOutputPath(
-                self.name, self.get_output_path_as_string()
+                self.name,
+                get_distributed_context().get_process_path(
+                    self.get_output_path_as_string()
+                ),
             )
 
 
+def merge_root_file_options(root_outputs):
+    """Options of all the ROOT outputs written to disk.
+
+    The Geant4 analysis manager of a thread writes all the ROOT files with the
+    same basket and compression settings: the outputs that set an option must
+    agree on its value. Return the options with -1 for the Geant4 defaults.
+    """
+    options = {"basket_size": -1, "basket_entries": -1, "compression_level": -1}
+    owners = {}
+    for u in root_outputs:
+        if u.write_to_disk is not True:
+            continue
+        for k, v in u.get_root_file_options().items():
+            if v == -1:
+                continue
+            if options[k] not in (-1, v):
+                fatal(
+                    f"The ROOT outputs '{owners[k]}' and "
+                    f"'{u.belongs_to_actor.name}' have a different {k} ({options[k]} "
+                    f"and {v}): Geant4 writes all the ROOT files of a simulation "
+                    f"with the same settings."
+                )
+            options[k] = v
+            owners[k] = u.belongs_to_actor.name
+    return options
+
+
 process_cls(ActorOutputBase)
 process_cls(ActorOutputUsingDataItemContainer)
 process_cls(ActorOutputImage)
@@ -5,15 +5,17 @@ import threading
 
 import opengate_core as g4
 from ..utility import g4_units, LazyModuleLoader
-from ..exception import fatal
+from ..exception import fatal, warning
 from .base import ActorBase
 from .digitizers import (
     DigitizerEnergyWindowsActor,
+    check_clear_every,
 )
 from .actoroutput import ActorOutputSingleImage, ActorOutputRoot
 from ..base import process_cls
 
 garf = LazyModuleLoader("garf")
+torch = LazyModuleLoader("torch")
 
 
 def check_channel_overlap(ch1, ch2):
@@ -30,11 +32,38 @@ def check_channel_overlap(ch1, ch2):
     return False
 
 
+def read_arf_training_dataset(filename):
+    """
+    Read an ARF training dataset written in the compact format (output filename
+    with the .bin extension): chunks of float32 columns, the number of rows
+    (uint32) then E, Theta, Phi, window and weight. Return a dict of numpy arrays.
+    """
+    columns = ["E", "Theta", "Phi", "window", "weight"]
+    data = np.fromfile(filename, dtype=np.uint8)
+    values = {c: [] for c in columns}
+    offset = 0
+    while offset < len(data):
+        rows = int(data[offset : offset + 4].view(np.uint32)[0])
+        offset += 4
+        for c in columns:
+            n = rows * 4
+            values[c].append(data[offset : offset + n].view(np.float32))
+            offset += n
+    return {
+        c: np.concatenate(v) if len(v) > 0 else np.zeros(0, dtype=np.float32)
+        for c, v in values.items()
+    }
+
+
 class ARFTrainingDatasetActor(ActorBase, g4.GateARFTrainingDatasetActor):
     """
     The ARFTrainingDatasetActor build a root file with energy, angles, positions and energy windows
     of a spect detector. To be used by garf_train to train a ARF neural network.
 
+    With an output filename with the .bin extension, the dataset is streamed in a compact
+    float32 columnar file instead (E, Theta, Phi, window and weight, the weight corrects the
+    russian roulette of the samples outside the windows), see read_arf_training_dataset.
+
     Note: Must inherit from ActorBase not from HitsCollectionActor, even if the
     cpp part inherit from HitsCollectionActor
     """
@@ -73,7 +102,14 @@ class ARFTrainingDatasetActor(ActorBase, g4.GateARFTrainingDatasetActor):
                 "doc": "FIXME",
             },
         ),
-        "russian_roulette": (1, {"doc": "Russian roulette factor. "}),
+        "russian_roulette": (
+            1,
+            {
+                "doc": "Russian roulette factor: the samples outside the energy windows "
+                "are kept with a probability 1/russian_roulette (their weight is "
+                "russian_roulette in the compact output). ",
+            },
+        ),
     }
 
     user_output_config = {
@@ -100,6 +136,7 @@ class ARFTrainingDatasetActor(ActorBase, g4.GateARFTrainingDatasetActor):
 
     def initialize(self):
         ActorBase.initialize(self)
+        check_clear_every(self)
         self.check_energy_window_actor()
         # initialize C++ side
         print(self.plane_axis)
@@ -211,6 +248,43 @@ class ARFActor(ActorBase, g4.GateARFActor):
             "auto",
             {"doc": "FIXME", "allowed_values": ("cpu", "gpu", "auto")},
         ),
+        "deferred_apply": (
+            True,
+            {
+                "doc": "The batches of hits are given to a single Python "
+                "thread, the Geant4 threads continue the simulation without "
+                "waiting for the GIL (at most two pending batches per thread). "
+                "If False, the ARF is applied by the Geant4 thread itself.",
+            },
+        ),
+        "coalesced_batch_size": (
+            0,
+            {
+                "doc": "With deferred_apply, the batches of all the threads are gathered into "
+                "one request of (at least) this number of hits before the ARF is applied, "
+                "e.g. 1e6 to use a GPU with many threads. 0 means that each batch of a "
+                "thread is applied alone.",
+            },
+        ),
+        "backend": (
+            "torch",
+            {
+                "doc": "Inference of the ARF network: in Python with torch (garf, "
+                "pth_filename), or in C++ with ONNX Runtime (onnx_filename): each "
+                "Geant4 thread runs the network on its batches and adds them to the "
+                "projection, without Python during the run. If opengate_core is "
+                "compiled without ONNX Runtime, the 'onnx' backend falls back to "
+                "torch when pth_filename is set.",
+                "allowed_values": ("torch", "onnx"),
+            },
+        ),
+        "onnx_filename": (
+            None,
+            {
+                "doc": "Filename of the ARF network exported with export_arf_to_onnx "
+                "(for the 'onnx' backend)",
+            },
+        ),
     }
 
     user_output_config = {
@@ -240,6 +314,7 @@ class ARFActor(ActorBase, g4.GateARFActor):
         self.output_array = None
         self.output_size = None
         self.nb_ene = None
+        self.native_inference = False
 
         # self._add_user_output(ActorOutputSingleImage, "arf_projection")
         self.__initcpp__()
@@ -271,24 +346,66 @@ class ARFActor(ActorBase, g4.GateARFActor):
 
         self.debug_nb_hits_before = 0
         self.debug_nb_hits = 0
+        self.batch_nb = 0
+        self.detected_particles = 0
 
-        self.initialize_model()
+        # initialize C++ side
+        self.InitializeUserInfo(self.user_info)
+        self.native_inference = self.use_native_inference()
+        self.initialize_image_plane()
+        if self.native_inference:
+            # the network is read and run on the cpp side
+            nb_runs = len(self.simulation.run_timing_intervals)
+            self.InitializeNativeInference(
+                str(self.onnx_filename), self.gpu_mode, nb_runs
+            )
+            self.model_data = {
+                "n_ene_win": self.GetNumberOfEnergyWindows(),
+                "current_gpu_mode": self.gpu_mode,
+            }
+        else:
+            self.initialize_model()
         self.initialize_params()
-        self.initialize_device()
+        if not self.native_inference:
+            self.initialize_device()
 
         self.output_array = np.zeros(self.output_size, dtype=np.float64)
 
-        # initialize C++ side
-        self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
         self.SetARFFunction(self.apply)
 
+    def use_native_inference(self):
+        if self.backend != "onnx":
+            return False
+        if self.onnx_filename is None:
+            fatal(
+                f"The actor '{self.name}' uses the onnx backend, "
+                f"but onnx_filename is not set (see export_arf_to_onnx)"
+            )
+        if g4.GateInfo.get_ONNXRuntime():
+            return True
+        if self.pth_filename is None:
+            fatal(
+                f"The actor '{self.name}' uses the onnx backend, but opengate_core is "
+                f"compiled without ONNX Runtime, and there is no pth_filename for "
+                f"the torch backend"
+            )
+        warning(
+            f"opengate_core is compiled without ONNX Runtime, the ARF of the actor "
+            f"'{self.name}' is applied in Python with torch ({self.pth_filename})"
+        )
+        return False
+
     def initialize_model(self):
         # load the pth file
         self.nn, self.model = garf.load_nn(
             self.pth_filename, verbose=False, gpu_mode=self.gpu_mode
         )
 
+        # shortcut to model_data
+        self.model_data = self.nn["model_data"]
+
+    def initialize_image_plane(self):
         # size and spacing (2D)
         self.image_plane_spacing = np.array(
             [self.user_info.image_spacing[0], self.user_info.image_spacing[1]]
@@ -300,9 +417,6 @@ class ARFActor(ActorBase, g4.GateARFActor):
             self.image_plane_size_pixel * self.image_plane_spacing
         )
 
-        # shortcut to model_data
-        self.model_data = self.nn["model_data"]
-
     def initialize_device(self):
         # which device for GARF : cpu cuda mps ?
         # we recommend CPU only
@@ -346,38 +460,23 @@ class ARFActor(ActorBase, g4.GateARFActor):
 
     def arf_build_image_from_projected_points(self, actor):
 
-        # get values from cpp side
-        energy = np.array(actor.GetEnergy())
-        pos_x = np.array(actor.GetPositionX())
-        pos_y = np.array(actor.GetPositionY())
-        dir_x = np.array(actor.GetDirectionX())
-        dir_y = np.array(actor.GetDirectionY())
-        weights = np.array(actor.GetWeights())
+        # view of the batch of the cpp side (no copy), one row per hit:
+        # pos_x, pos_y, theta, phi (direction angles in degree), energy, weight
+        px = actor.GetBatch()
 
         # do nothing if no hits
-        if energy.size == 0:
+        if px.shape[0] == 0:
             return
 
-        # convert direction in angles
-        degree = g4_units.degree
-        theta = np.arccos(dir_y) / degree
-        phi = np.arccos(dir_x) / degree
-
         # update
         self.batch_nb += 1
-        self.detected_particles += energy.shape[0]
-
-        # build the data
-        if len(weights) == 0:
-            px = np.column_stack((pos_x, pos_y, theta, phi, energy))
-        else:
-            px = np.column_stack((pos_x, pos_y, theta, phi, energy, weights))
+        self.detected_particles += px.shape[0]
         self.debug_nb_hits_before += len(px)
 
         # verbose current batch
         if self.verbose_batch:
             print(
-                f"Apply ARF to {energy.shape[0]} hits (device = {self.model_data['current_gpu_mode']})"
+                f"Apply ARF to {px.shape[0]} hits (device = {self.model_data['current_gpu_mode']})"
             )
 
         # from projected points to image counts
@@ -404,6 +503,12 @@ class ARFActor(ActorBase, g4.GateARFActor):
     def EndOfRunActionMasterThread(self, run_index):
         nb_slice = self.nb_ene
 
+        # the native inference fills the projection on the cpp side
+        if self.native_inference:
+            self.output_array = self.GetProjection()
+            self.batch_nb = self.GetNumberOfNativeBatches()
+            self.detected_particles = self.GetNumberOfNativeHits()
+
         # convert to itk image
         # FIXME: this should probably go into EndOfRunAction
         output_image = itk.image_from_array(self.output_array)
@@ -442,3 +547,48 @@ class ARFActor(ActorBase, g4.GateARFActor):
 
 process_cls(ARFActor)
 process_cls(ARFTrainingDatasetActor)
+
+
+def export_arf_to_onnx(pth_filename, onnx_filename):
+    """
+    Export the ARF network of a garf .pth file to an ONNX file, for the
+    inference on the cpp side (ARFActor with backend = "onnx").
+    The model computes the same probabilities as garf.nn_predict: the input
+    (theta, phi, energy) is normalized, the output is converted to
+    probabilities (softmax) and the first window (outside the energy windows,
+    under-represented by the russian roulette of the training) is corrected.
+    """
+    nn, model = garf.load_nn(pth_filename, verbose=False, gpu_mode="cpu")
+    model_data = nn["model_data"]
+    model = model.cpu()
+    model.eval()
+    rr = model_data["rr"] if "rr" in model_data else model_data["RR"]
+    n_ene_win = model_data["n_ene_win"]
+
+    class ARFProbabilities(torch.nn.Module):
+        def __init__(self):
+            super().__init__()
+            self.model = model
+            x_mean = np.asarray(model_data["x_mean"], dtype=np.float32)
+            x_std = np.asarray(model_data["x_std"], dtype=np.float32)
+            rr_scale = np.ones(n_ene_win, dtype=np.float32)
+            rr_scale[0] = rr
+            self.register_buffer("x_mean", torch.from_numpy(x_mean.reshape(1, -1)))
+            self.register_buffer("x_std", torch.from_numpy(x_std.reshape(1, -1)))
+            self.register_buffer("rr", torch.from_numpy(rr_scale.reshape(1, -1)))
+
+        def forward(self, x):
+            p = torch.softmax(self.model((x - self.x_mean) / self.x_std), dim=1)
+            p = p * self.rr
+            return p / torch.sum(p, dim=1, keepdim=True)
+
+    x = torch.zeros((2, 3), dtype=torch.float32)
+    with torch.no_grad():
+        torch.onnx.export(
+            ARFProbabilities(),
+            x,
+            str(onnx_filename),
+            input_names=["x"],
+            output_names=["p"],
+            dynamic_axes={"x": {0: "n"}, "p": {0: "n"}},
+        )
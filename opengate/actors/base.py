@@ -5,7 +5,8 @@ from ..definitions import __world_name__
 from ..exception import fatal, GateImplementationError
 from ..base import GateObject, process_cls
 from ..utility import insert_suffix_before_extension
-from .actoroutput import ActorOutputRoot
+from ..checkpoint import get_output_checkpoint_state, set_output_checkpoint_state
+from .actoroutput import ActorOutputRoot, ActorOutputUsingDataItemContainer
 
 
 def _setter_hook_attached_to(self, attached_to):
@@ -588,6 +589,29 @@ class ActorBase(GateObject):
     def get_output_path_for_item_string(self, output_name, which, item):
         return str(self.user_output[output_name].get_output_path(which, item))
 
+    def get_checkpoint_state(self):
+        """State of the actor at the end of a run, written in the checkpoints
+        (see Simulation.checkpoint_filename). By default, the data of the outputs
+        (e.g. images), which must all use data item containers. Actors with
+        another kind of output, or with data accumulated on the C++ side over
+        several runs, must override this method and set_checkpoint_state."""
+        state = {}
+        for name, output in self.user_output.items():
+            if not isinstance(output, ActorOutputUsingDataItemContainer):
+                fatal(
+                    f"The actor '{self.name}' ({self.type_name}) cannot be saved "
+                    f"in a checkpoint: its output '{name}' is not supported. "
+                    f"Remove the option checkpoint_filename of the simulation."
+                )
+            state[name] = get_output_checkpoint_state(output)
+        return state
+
+    def set_checkpoint_state(self, state):
+        """Restore the state of get_checkpoint_state, at the start of a simulation
+        resumed from a checkpoint (after StartSimulationAction)."""
+        for name, output_state in state.items():
+            set_output_checkpoint_state(self.user_output[name], output_state)
+
     def StartSimulationAction(self):
         """Default virtual method for inheritance"""
         pass
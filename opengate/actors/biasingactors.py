@@ -1,6 +1,11 @@
+import itk
+import numpy as np
+from pathlib import Path
 import opengate_core as g4
 from .base import ActorBase
-from ..utility import g4_units
+from ..utility import g4_units, ensure_filename_is_str
+from ..image import update_image_py_to_cpp, itk_image_from_array
+from ..exception import fatal
 from ..base import process_cls
 
 
@@ -82,6 +87,7 @@ class ComptSplittingActor(SplittingActorBase, g4.GateOptrComptSplittingActor):
     rotation_vector_director: bool
     vector_director: list
     max_theta: float
+    splitting_mode: str
 
     user_info_defaults = {
         "min_weight_of_particle": (
@@ -114,6 +120,16 @@ class ComptSplittingActor(SplittingActorBase, g4.GateOptrComptSplittingActor):
                 "doc": "Sets the angular range (in degrees) around vector_director within which the Russian roulette mechanism is not applied.",
             },
         ),
+        "splitting_mode": (
+            "model",
+            {
+                "doc": "With 'model', each split photon is generated by the Compton model of the physics list. "
+                "With 'klein_nishina', the split photons and electrons are sampled from the Klein-Nishina "
+                "cross-section (free electron at rest, no Doppler broadening nor fluorescence), which is much faster "
+                "for large splitting factors.",
+                "allowed_values": ("model", "klein_nishina"),
+            },
+        ),
     }
 
     processes = ("compt",)
@@ -140,6 +156,9 @@ class BremSplittingActor(SplittingActorBase, g4.GateBOptrBremSplittingActor):
 
     # hints for IDE
     processes: list
+    russian_roulette: bool
+    vector_director: list
+    max_theta: float
 
     user_info_defaults = {
         "processes": (
@@ -148,6 +167,24 @@ class BremSplittingActor(SplittingActorBase, g4.GateBOptrBremSplittingActor):
                 "doc": "Specifies the process split by this actor. This parameter is set to eBrem, as the actor is specifically developed for this process. It is recommended not to modify this setting.",
             },
         ),
+        "russian_roulette": (
+            False,
+            {
+                "doc": "Directional splitting: if True, the split photons emitted outside the cone of half angle max_theta around vector_director (e.g. toward the field aperture) are kept with the probability 1 / splitting_factor, with the weight of the electron",
+            },
+        ),
+        "vector_director": (
+            [0, 0, 1],
+            {
+                "doc": "Direction of interest of the Russian roulette (world coordinates)",
+            },
+        ),
+        "max_theta": (
+            90 * g4_units.deg,
+            {
+                "doc": "Half angle of the cone around vector_director where the Russian roulette is not applied",
+            },
+        ),
     }
 
     processes = ("eBrem",)
@@ -181,10 +218,39 @@ class FreeFlightActor(GenericBiasingActorBase, g4.GateOptrFreeFlightActor):
 
     # hints for IDE FIXME
     processes: list
-    # user info FIXME
+    free_flight_mode: str
+    database: str
+    energy_max: float
 
     processes = ("compt", "Rayl", "phot", "conv", "GammaGeneralProc")
 
+    user_info_defaults = {
+        "free_flight_mode": (
+            "biasing",
+            {
+                "doc": "'biasing': free flight through the Geant4 biasing operation, "
+                "updated at every step in the volume and its daughters. "
+                "'voxel': the volume must be an ImageVolume, the weight is "
+                "computed at once along the line to the phantom exit, where the "
+                "photon is moved (no per voxel biasing).",
+                "allowed_values": ("biasing", "voxel"),
+            },
+        ),
+        "database": (
+            "EPDL",
+            {
+                "doc": "Voxel mode: the database source for attenuation coefficients, either 'EPDL' or 'NIST'",
+                "allowed_values": ("EPDL", "NIST"),
+            },
+        ),
+        "energy_max": (
+            10 * g4_units.MeV,
+            {
+                "doc": "Voxel mode: maximum photon energy of the attenuation tables",
+            },
+        ),
+    }
+
     def __init__(self, *args, **kwargs):
         GenericBiasingActorBase.__init__(self, *args, **kwargs)
         self.__initcpp__()
@@ -200,15 +266,317 @@ class FreeFlightActor(GenericBiasingActorBase, g4.GateOptrFreeFlightActor):
 
     def initialize(self):
         GenericBiasingActorBase.initialize(self)
+        if (
+            self.free_flight_mode == "voxel"
+            and self.attached_to_volume.volume_type != "ImageVolume"
+        ):
+            fatal(
+                f"The FreeFlightActor '{self.name}' in voxel mode must be attached "
+                f"to an ImageVolume, while '{self.attached_to}' is a "
+                f"{self.attached_to_volume.volume_type}."
+            )
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
     def StartSimulationAction(self):
+        if self.free_flight_mode == "voxel":
+            self.SetPhantomVolumeName(
+                str(self.attached_to_volume.g4_physical_volumes[0].GetName())
+            )
+            self.SetImageParameterisation(self.attached_to_volume.g4_voxel_param)
         g4.GateOptrFreeFlightActor.StartSimulationAction(self)
 
 
+class WoodcockTrackingActor(ActorBase, g4.GateWoodcockTrackingActor):
+    """
+    Woodcock (delta) tracking of the photons in an ImageVolume: the photons cross the phantom
+    without stopping at the voxel boundaries. The flight lengths are sampled with the largest
+    attenuation coefficient of the phantom materials (majorant), and an interaction is real with
+    the probability mu(voxel) / majorant, fictitious otherwise. The real interactions are done by
+    the gamma processes of the physics list. The actor should be added before the actors that
+    score in the phantom.
+    """
+
+    # hints for IDE
+    database: str
+    energy_max: float
+
+    user_info_defaults = {
+        "database": (
+            "EPDL",
+            {
+                "doc": "The database source for the attenuation coefficients of the materials, "
+                "'EPDL', 'NIST' or 'simulated' (computed with the physics list)",
+                "allowed_values": ("EPDL", "NIST", "simulated"),
+            },
+        ),
+        "energy_max": (
+            10 * g4_units.MeV,
+            {
+                "doc": "Maximum photon energy of the attenuation tables",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.number_of_real_interactions = 0
+        self.number_of_fictitious_interactions = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateWoodcockTrackingActor.__init__(self, {"name": self.name})
+        self.AddActions(
+            {"StartSimulationAction", "SteppingAction", "EndSimulationAction"}
+        )
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if self.attached_to_volume.volume_type != "ImageVolume":
+            fatal(
+                f"The WoodcockTrackingActor '{self.name}' must be attached to an "
+                f"ImageVolume, while '{self.attached_to}' is a "
+                f"{self.attached_to_volume.volume_type}."
+            )
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        self.SetPhantomVolumeName(
+            str(self.attached_to_volume.g4_physical_volumes[0].GetName())
+        )
+        self.SetImageParameterisation(self.attached_to_volume.g4_voxel_param)
+        g4.GateWoodcockTrackingActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        self.number_of_real_interactions = self.GetNumberOfRealInteractions()
+        self.number_of_fictitious_interactions = (
+            self.GetNumberOfFictitiousInteractions()
+        )
+
+
+class WeightWindowActor(ActorBase, g4.GateWeightWindowActor):
+    """
+    Geometry based weight windows: the particles are split (above the window) or submitted to a
+    Russian roulette (below the window) when they enter a new cell. The importance of a cell is either
+    a voxel of an importance map (centered on the attached volume) or the importance of a daughter
+    volume. The window of a cell of importance I, for the energy group g, is
+    [lower_weight_bounds[g] / I, upper_weight_bounds[g] / I]. The cells without importance
+    (or with importance <= 0) have no window.
+    """
+
+    # hints for IDE
+    importance_map: str
+    volume_importances: dict
+    translation: list
+    energy_bounds: list
+    lower_weight_bounds: list
+    upper_weight_bounds: list
+    max_split: int
+
+    user_info_defaults = {
+        "importance_map": (
+            None,
+            {
+                "doc": "Filename of the importance image (one importance per voxel), centered on the attached volume. "
+                "It may also be an itk image (e.g. from importance_map_from_fluence).",
+            },
+        ),
+        "volume_importances": (
+            {},
+            {
+                "doc": "Importance of the volumes, as a dict volume name: importance (the volumes must be "
+                "the attached volume or its daughters). Used instead of the importance_map.",
+            },
+        ),
+        "translation": (
+            [0, 0, 0],
+            {
+                "doc": "Translation of the importance map from the center of the attached volume.",
+            },
+        ),
+        "energy_bounds": (
+            [],
+            {
+                "doc": "Energy bounds between the energy groups (sorted, their number is the number of groups minus one).",
+            },
+        ),
+        "lower_weight_bounds": (
+            [0.5],
+            {
+                "doc": "Lower weight bound of each energy group, for an importance of 1.",
+            },
+        ),
+        "upper_weight_bounds": (
+            [2.0],
+            {
+                "doc": "Upper weight bound of each energy group, for an importance of 1.",
+            },
+        ),
+        "max_split": (
+            10,
+            {
+                "doc": "Maximum number of copies of a particle split at a cell entrance.",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.number_of_split_particles = 0
+        self.number_of_killed_particles = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateWeightWindowActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if (self.importance_map is None) == (len(self.volume_importances) == 0):
+            fatal(
+                f"The WeightWindowActor '{self.name}' needs either an importance_map "
+                f"or volume_importances (and not both)."
+            )
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        if self.importance_map is not None:
+            image = self.importance_map
+            if isinstance(image, (str, Path)):
+                image = itk.imread(ensure_filename_is_str(image))
+            # (the cpp image is float)
+            arr = itk.array_view_from_image(image).astype(np.float32)
+            float_image = itk_image_from_array(arr, view=False)
+            float_image.CopyInformation(image)
+            update_image_py_to_cpp(float_image, self.cpp_importance_image, True)
+            self.SetPhysicalVolumeName(
+                str(self.attached_to_volume.g4_physical_volumes[0].GetName())
+            )
+        g4.GateWeightWindowActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        g4.GateWeightWindowActor.EndSimulationAction(self)
+        self.number_of_split_particles = self.GetNumberOfSplitParticles()
+        self.number_of_killed_particles = self.GetNumberOfKilledParticles()
+
+
+class RussianRouletteActor(ActorBase, g4.GateRussianRouletteActor):
+    """
+    Russian roulette of the low weight particles (e.g. after a Compton or bremsstrahlung
+    splitting): at each step in the attached volume(s), a particle of weight w below
+    weight_threshold survives with the probability w / survival_weight, with the
+    survival_weight, and is killed otherwise. The threshold and the survival weight may
+    be given per particle name. The filters of the actor may be used to select the
+    particles.
+    """
+
+    # hints for IDE
+    weight_threshold: float
+    survival_weight: float
+    per_particle: dict
+
+    user_info_defaults = {
+        "weight_threshold": (
+            0.01,
+            {
+                "doc": "The particles with a weight below this threshold are submitted to the "
+                "Russian roulette (no roulette if <= 0).",
+            },
+        ),
+        "survival_weight": (
+            None,
+            {
+                "doc": "Weight of the surviving particles (at least the threshold). None: two "
+                "times the weight_threshold.",
+            },
+        ),
+        "per_particle": (
+            {},
+            {
+                "doc": "Threshold and survival weight per particle name, as a dict name: "
+                "[weight_threshold, survival_weight] (e.g. {'e-': [0, 0]} to disable the "
+                "roulette of the electrons). The other particles use weight_threshold and "
+                "survival_weight.",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.number_of_roulette_particles = 0
+        self.number_of_killed_particles = 0
+        self.killed_weight = 0
+        self.survival_added_weight = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateRussianRouletteActor.__init__(self, self.user_info)
+        self.AddActions({"EndSimulationAction"})
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if self.survival_weight is None:
+            self.survival_weight = 2 * self.weight_threshold
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def EndSimulationAction(self):
+        self.number_of_roulette_particles = self.GetNumberOfRouletteParticles()
+        self.number_of_killed_particles = self.GetNumberOfKilledParticles()
+        self.killed_weight = self.GetKilledWeight()
+        self.survival_added_weight = self.GetSurvivalAddedWeight()
+
+    def __str__(self):
+        s = (
+            f"{self.name}: {self.number_of_roulette_particles} rouletted particles, "
+            f"{self.number_of_killed_particles} killed, killed weight "
+            f"{self.killed_weight:.4g}, survival added weight "
+            f"{self.survival_added_weight:.4g}"
+        )
+        return s
+
+
+def importance_map_from_fluence(
+    fluence, max_importance=1000, round_to_power_of_two=True
+):
+    """
+    Importance map of a WeightWindowActor computed from the fluence of a pilot run (e.g. the
+    'fluence' output of a FluenceActor, or the edep of a DoseActor, with the same size and spacing
+    as the map, attached to the same volume).
+
+    The importance is inversely proportional to the pilot fluence, 1 in the voxel of maximum
+    fluence (the source side), so that the population of particles stays roughly constant
+    across the volume. It is limited to max_importance and (by default) rounded to a power of 2,
+    so that a particle is not split and rouletted again in the neighbor voxel of a slightly
+    different importance. The voxels not reached by the pilot run have no importance (0, no
+    weight window).
+
+    This is a forward estimate (particle density), not the adjoint importance toward a given
+    detector: it is suited to deep penetration problems where the flux decreases along the
+    path to the region of interest.
+    """
+    if isinstance(fluence, (str, Path)):
+        fluence = itk.imread(ensure_filename_is_str(fluence))
+    phi = itk.array_view_from_image(fluence).astype(np.float64)
+    importance = np.zeros_like(phi)
+    reached = phi > 0
+    if not np.any(reached):
+        fatal("Cannot compute an importance map from an empty pilot fluence.")
+    importance[reached] = np.clip(phi.max() / phi[reached], 1, max_importance)
+    if round_to_power_of_two:
+        importance[reached] = np.power(2, np.floor(np.log2(importance[reached])))
+    image = itk_image_from_array(importance.astype(np.float32), view=False)
+    image.CopyInformation(fluence)
+    return image
+
+
 process_cls(GenericBiasingActorBase)
 process_cls(SplittingActorBase)
 process_cls(ComptSplittingActor)
 process_cls(BremSplittingActor)
 process_cls(FreeFlightActor)
+process_cls(WoodcockTrackingActor)
+process_cls(WeightWindowActor)
+process_cls(RussianRouletteActor)
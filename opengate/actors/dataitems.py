@@ -8,6 +8,7 @@ from ..utility import ensure_filename_is_str, calculate_variance
 from ..image import (
     sum_itk_images,
     divide_itk_images,
+    apply_by_chunks,
     multiply_itk_images,
     scale_itk_image,
     create_3d_image,
@@ -671,21 +672,32 @@ class SingleItkImageWithVariance(DataItemContainer):
                 output_arr = np.zeros_like(value_array)
             else:
                 squared_value_array = np.asarray(self.data[1].data)
-                output_arr = calculate_variance(
-                    value_array, squared_value_array, number_of_samples
+                output_arr = np.empty(
+                    value_array.shape,
+                    dtype=np.result_type(value_array, squared_value_array, 1.0),
                 )
-                if which_quantity in (
-                    "std",
-                    "uncertainty",
-                ):
-                    output_arr = np.sqrt(output_arr)
-                if which_quantity in ("uncertainty",):
-                    output_arr = np.divide(
-                        output_arr,
-                        value_array / number_of_samples,
-                        out=np.zeros_like(output_arr),
-                        where=value_array != 0,
+
+                # (by slices, concurrently at the end of the simulation)
+                def compute(b, e):
+                    values = value_array[b:e]
+                    arr = calculate_variance(
+                        values, squared_value_array[b:e], number_of_samples
                     )
+                    if which_quantity in (
+                        "std",
+                        "uncertainty",
+                    ):
+                        arr = np.sqrt(arr)
+                    if which_quantity in ("uncertainty",):
+                        arr = np.divide(
+                            arr,
+                            values / number_of_samples,
+                            out=np.zeros_like(arr),
+                            where=values != 0,
+                        )
+                    output_arr[b:e] = arr
+
+                apply_by_chunks(compute, output_arr.shape)
             output_image = itk.image_view_from_array(output_arr)
             output_image.CopyInformation(self.data[0].data)
         except AttributeError as e:
@@ -137,13 +137,202 @@ def get_simplified_digitizer_channels_rad(spect_name, rad, scatter_flag):
     return available_rad[rad](spect_name, scatter_flag)
 
 
+def read_columnar_output(filename, collection=None, library="np"):
+    """
+    Read a digi collection written in the columnar format (output filename with
+    the .json extension): the manifest and the files of all the threads.
+    With library="np", return a dict of numpy arrays (shape (n, 3) for the
+    3-vectors). With library="arrow", return a pyarrow Table (fixed size lists
+    for the 3-vectors), e.g. to be written with pyarrow.parquet.write_table.
+    """
+    import json
+    from pathlib import Path
+
+    filename = Path(filename)
+    with open(filename) as f:
+        manifest = json.load(f)
+    collections = manifest["collections"]
+    if collection is None:
+        if len(collections) != 1:
+            fatal(
+                f"The columnar output {filename} contains several collections "
+                f"{list(collections.keys())}, one must be chosen"
+            )
+        collection = next(iter(collections))
+    if collection not in collections:
+        fatal(f"No collection '{collection}' in the columnar output {filename}")
+    desc = collections[collection]
+    dtypes = {"float64": np.float64, "int32": np.int32, "utf8": np.int32}
+
+    # all the chunks of all the threads, in the order of the threads
+    values = {c["name"]: [] for c in desc["columns"]}
+    for file in desc["files"]:
+        data = np.fromfile(filename.parent / file["filename"], dtype=np.uint8)
+        for chunk in file["chunks"]:
+            buffers = iter(chunk["buffers"])
+            for c in desc["columns"]:
+                offset, length = next(buffers)
+                b = data[offset : offset + length].view(dtypes[c["type"]])
+                if c["type"] == "utf8":
+                    offset, length = next(buffers)
+                    chars = data[offset : offset + length].tobytes()
+                    b = [
+                        chars[b[i] : b[i + 1]].decode()
+                        for i in range(chunk["rows"])
+                    ]
+                elif "list_size" in c:
+                    b = b.reshape(-1, c["list_size"])
+                values[c["name"]].append(b)
+
+    # concatenate the chunks
+    arrays = {}
+    for c in desc["columns"]:
+        v = values[c["name"]]
+        if c["type"] == "utf8":
+            arrays[c["name"]] = np.array([s for b in v for s in b], dtype=object)
+        elif len(v) > 0:
+            arrays[c["name"]] = np.concatenate(v)
+        else:
+            shape = (0, c["list_size"]) if "list_size" in c else (0,)
+            arrays[c["name"]] = np.zeros(shape, dtype=dtypes[c["type"]])
+    if library == "np":
+        return arrays
+    if library != "arrow":
+        fatal(f"Unknown library '{library}', must be 'np' or 'arrow'")
+    try:
+        import pyarrow as pa
+    except ImportError:
+        fatal("pyarrow is needed to read the columnar output as an Arrow table")
+    columns = {}
+    for c in desc["columns"]:
+        v = arrays[c["name"]]
+        if "list_size" in c:
+            columns[c["name"]] = pa.FixedSizeListArray.from_arrays(
+                pa.array(v.reshape(-1)), c["list_size"]
+            )
+        else:
+            columns[c["name"]] = pa.array(v)
+    return pa.table(columns)
+
+
+def write_root_shards_manifest(path, number_of_threads, context):
+    """
+    Sharded ROOT output (Simulation.sharded_root_output): write the manifest
+    <name>.shards.json that lists the files written by the threads (and the
+    ranks if distributed) instead of the merged file <name>.root.
+    """
+    import json
+    from pathlib import Path
+
+    # all the files must be closed
+    context.barrier()
+    if context.is_root:
+        path = Path(path)
+        stems = [path.stem]
+        if context.is_distributed:
+            stems = [f"{path.stem}_rank{r}" for r in range(context.size)]
+        shards = []
+        for stem in stems:
+            if number_of_threads > 1:
+                names = [f"{stem}_t{t}{path.suffix}" for t in range(number_of_threads)]
+            else:
+                names = [f"{stem}{path.suffix}"]
+            shards += [n for n in names if (path.parent / n).exists()]
+        manifest = {"format": "opengate-root-shards", "version": 1, "files": shards}
+        with open(path.with_suffix(".shards.json"), "w") as f:
+            json.dump(manifest, f, indent=2)
+    context.barrier()
+
+
+def get_root_output_files(path):
+    """
+    The ROOT files of an output: the file itself, or, for a sharded output,
+    the files listed in the manifest <name>.shards.json.
+    """
+    import json
+    from pathlib import Path
+
+    path = Path(path)
+    manifest = path.with_suffix(".shards.json")
+    if manifest.exists():
+        with open(manifest) as f:
+            return [path.parent / n for n in json.load(f)["files"]]
+    if not path.exists():
+        fatal(f"No ROOT output {path} (and no manifest {manifest})")
+    return [path]
+
+
+def read_root_output(path, tree):
+    """
+    Read a tree of a ROOT output as one dataset, merged or sharded (see
+    Simulation.sharded_root_output): the rows of all the files are concatenated
+    (in the order of the threads). Return a dict of numpy arrays, like
+    uproot arrays(library="np").
+    """
+    import uproot
+
+    arrays = {}
+    for filename in get_root_output_files(path):
+        with uproot.open(filename) as f:
+            if tree not in f:
+                continue
+            for k, v in f[tree].arrays(library="np").items():
+                arrays.setdefault(k, []).append(v)
+    return {k: np.concatenate(v) for k, v in arrays.items()}
+
+
+def check_termination_count(actor):
+    # termination criterion of the actor (see GateVActor), 0: no criterion
+    if actor.termination_count < 0:
+        fatal(
+            f"Error, the termination_count of the actor {actor.name} must be "
+            f"positive or 0, while it is {actor.termination_count}"
+        )
+
+
+# option of the digitizers that write their digi collection during the run
+_clear_every_user_info_defaults = {
+    "clear_every": (
+        1e5,
+        {
+            "doc": "Number of events between two flushes of the digi collection: the "
+            "digi of each thread are kept in memory, then written to the output and "
+            "cleared every clear_every events (and at the end of each run). A lower "
+            "value needs less memory, a higher value fewer writes. It must be a "
+            "positive integer, 0 or None is an error.",
+        },
+    ),
+}
+
+
+def check_clear_every(actor):
+    # the digi are flushed at the events whose ID is a multiple of clear_every
+    clear_every = actor.user_info.get("clear_every")
+    if clear_every is None or int(clear_every) < 1:
+        fatal(
+            f"Error, the clear_every of the actor {actor.name} must be a "
+            f"positive number of events, while it is {clear_every}"
+        )
+
+
 class Digitizer:
     """
     Simple helper class to reduce the code size when creating a digitizer.
     It only avoids repeating attached_to, output and input_digi_collection parameters.
+    If fused is True, the modules that can be fused (until the first one that cannot,
+    e.g. the projection) are run in one pass per event by a DigitizerFusedChainActor.
     """
 
-    def __init__(self, sim, volume_name, digit_name):
+    fused_module_types = (
+        "DigitizerAdderActor",
+        "DigitizerReadoutActor",
+        "DigitizerEfficiencyActor",
+        "DigitizerBlurringActor",
+        "DigitizerSpatialBlurringActor",
+        "DigitizerEnergyWindowsActor",
+    )
+
+    def __init__(self, sim, volume_name, digit_name, fused=False):
         # input param
         self.simulation = sim
         self.volume_name = volume_name
@@ -154,6 +343,17 @@ class Digitizer:
         # start by the hit collection
         self.hc = self.set_hit_collection()
 
+        # the fused chain is open until a module that cannot be fused
+        self.chain = None
+        self.chain_is_open = fused
+        if fused:
+            self.chain = self.simulation.add_actor(
+                "DigitizerFusedChainActor", f"{self.name}_chain"
+            )
+            self.chain.attached_to = self.volume_name
+            self.chain.input_digi_collection = self.hc.name
+            self.actors.append(self.chain)
+
     def __str__(self):
         s = ""
         for a in self.actors:
@@ -189,6 +389,15 @@ class Digitizer:
             mod.user_output[first_key].set_write_to_disk(False)
         else:
             mod.user_output[first_key].write_to_disk = False
+        # add the module to the fused chain, until one that cannot be fused
+        if self.chain_is_open:
+            if module_type in self.fused_module_types:
+                self.chain.modules = self.chain.modules + [mod.name]
+            if (
+                module_type not in self.fused_module_types
+                or module_type == "DigitizerEnergyWindowsActor"
+            ):
+                self.chain_is_open = False
         self.actors.append(mod)
         return mod
 
@@ -245,6 +454,8 @@ class DigitizerBase(ActorBase):
 
     def initialize(self):
         ActorBase.initialize(self)
+        if "clear_every" in self.user_info:
+            check_clear_every(self)
         if self.authorize_repeated_volumes is True:
             return
         att = self.attached_to
@@ -382,6 +593,440 @@ class DigitizerAdderActor(DigitizerWithRootOutput, g4.GateDigitizerAdderActor):
         g4.GateDigitizerAdderActor.EndSimulationAction(self)
 
 
+class DigitizerOnlineAdderActor(
+    DigitizerWithRootOutput, g4.GateDigitizerOnlineAdderActor
+):
+    """Same singles as a DigitizerHitsCollectionActor followed by a DigitizerAdderActor,
+    but computed directly from the steps, without storing the hits.
+    Output: a Single collection with TotalEnergyDeposit, PostPosition, GlobalTime,
+    PreStepUniqueVolumeID and EventID (and optionally TimeDifference and NumberOfHits).
+    Use the DigitizerAdderActor when other attributes of the hits are needed.
+    """
+
+    user_info_defaults = {
+        "policy": (
+            "EnergyWinnerPosition",
+            {
+                "doc": "Position of the single (see DigitizerAdderActor). ",
+                "allowed_values": (
+                    "EnergyWeightedCentroidPosition",
+                    "EnergyWinnerPosition",
+                ),
+            },
+        ),
+        "time_difference": (
+            False,
+            {
+                "doc": "Store the time between the first and the last step of the single. ",
+            },
+        ),
+        "number_of_hits": (
+            False,
+            {
+                "doc": "Store the number of steps with a deposited energy of the single. ",
+            },
+        ),
+        **_clear_every_user_info_defaults,
+        "group_volume": (
+            None,
+            {
+                "doc": "Name of the volume that groups the steps (default: the volume of the steps). ",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        DigitizerBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateDigitizerOnlineAdderActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        DigitizerBase.initialize(self)
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        DigitizerAdderActor.set_group_by_depth(self)
+        DigitizerBase.StartSimulationAction(self)
+        g4.GateDigitizerOnlineAdderActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        DigitizerBase.EndSimulationAction(self)
+        g4.GateDigitizerOnlineAdderActor.EndSimulationAction(self)
+
+
+class DigitizerTimeOrderedBase(DigitizerWithRootOutput):
+    """Base for the digitizer modules that consider the singles in time order, across the events
+    and the threads (GateVDigitizerTimeOrderedActor): coincidences, dead time, pile-up.
+    The singles of all threads are merged in time order in a bounded buffer (GateTimeOrderedStream).
+    Input: a Single collection, needs at least GlobalTime and PreStepUniqueVolumeID
+    """
+
+    user_info_defaults = {
+        "input_digi_collection": (
+            "Singles",
+            {
+                "doc": "Digi collection of the singles to be used as input. ",
+            },
+        ),
+        "buffer_size": (
+            1000000,
+            {
+                "doc": "Maximum number of singles waiting for the other threads. When the buffer is "
+                "full, the oldest single is processed anyway (the time order may be lost, see "
+                "number_of_forced_singles).",
+            },
+        ),
+        "skip_attributes": (
+            [],
+            {
+                "doc": "Attributes of the singles that are not stored in the output. ",
+            },
+        ),
+        **_clear_every_user_info_defaults,
+    }
+
+    def __init__(self, *args, **kwargs):
+        DigitizerBase.__init__(self, *args, **kwargs)
+        self.number_of_forced_singles = 0
+        self.number_of_late_singles = 0
+
+    def initialize(self):
+        if self.buffer_size < 1:
+            fatal(
+                f"Error, the buffer_size of the digitizer '{self.name}' must be at least 1"
+            )
+        DigitizerBase.initialize(self)
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def set_number_of_threads(self):
+        self.SetNumberOfThreads(self.simulation.number_of_threads)
+
+    def set_group_by_depth(self):
+        depth = -1
+        group_volume = self.user_info.get("group_volume")
+        if group_volume is not None:
+            volume = self.simulation.volume_manager.get_volume(group_volume)
+            depth = volume.volume_depth_in_tree
+        self.SetGroupVolumeDepth(depth)
+
+    def check_time_order(self):
+        self.number_of_forced_singles = self.GetNumberOfForcedDigi()
+        self.number_of_late_singles = self.GetNumberOfLateDigi()
+        if self.number_of_forced_singles > 0:
+            self.warn_user(
+                f"The buffer of the digitizer '{self.name}' was full for "
+                f"{self.number_of_forced_singles} singles, they may not be in time order. "
+                f"Increase buffer_size."
+            )
+        if self.number_of_late_singles > 0:
+            self.warn_user(
+                f"{self.number_of_late_singles} singles were merged out of time order by the "
+                f"digitizer '{self.name}' (the events of a thread are not in time order?)."
+            )
+
+
+class DigitizerCoincidenceSorterActor(
+    DigitizerTimeOrderedBase, g4.GateDigitizerCoincidenceSorterActor
+):
+    """Online coincidence sorter: pairs of singles in a time window, during the simulation.
+    Input: a Single collection, needs at least GlobalTime and PreStepUniqueVolumeID (and EventID for removeMultiples)
+    Output: a Coincidence collection, each attribute X of the singles is stored as X1 and X2
+
+    Same sorting as the offline coincidences_sorter (opengate.actors.coincidences), but on the
+    singles in time order (see DigitizerTimeOrderedBase), so the singles do not need to be stored.
+    Some coincidences may be missed if number_of_forced_singles is not zero.
+
+    Policies:
+    - keepAll: all the coincidences are kept
+    - removeMultiples: the coincidences are kept only if they are the only one for their EventID1
+
+    The coincidences may also be binned into a sinogram, or written as a compact listmode file,
+    with a LOR table (crystal index, ring and position in the ring of each crystal, see
+    opengate.contrib.pet.siemensbiograph.get_lor_table).
+    """
+
+    user_info_defaults = {
+        "window": (
+            10 * g4_units.ns,
+            {
+                "doc": "Time window of the coincidences. ",
+            },
+        ),
+        "policy": (
+            "keepAll",
+            {
+                "doc": "Policy for the multiple coincidences. ",
+                "allowed_values": (
+                    "keepAll",
+                    "removeMultiples",
+                ),
+            },
+        ),
+        "keep_coincidences": (
+            True,
+            {
+                "doc": "Fill the coincidence collection (it may be useless with a sinogram or a "
+                "listmode file). ",
+            },
+        ),
+        "lor_table": (
+            None,
+            {
+                "doc": "Dict with 'crystal_index' (list of (volume name, stride), the crystal "
+                "index is the sum of the copy numbers of these volumes times their strides), "
+                "'ring' and 'position' (ring and position in the ring of each crystal). "
+                "Needed for the sinogram and the listmode. ",
+            },
+        ),
+        "sinogram": (
+            None,
+            {
+                "doc": "Bin the coincidences into a sinogram (axial, views, radial): '2D' "
+                "(single slice rebinning, 2 x rings - 1 slices) or '3D' (rings x rings). ",
+                "allowed_values": (None, "2D", "3D"),
+            },
+        ),
+        "radial_bins": (
+            0,
+            {
+                "doc": "Number of central radial bins of the sinogram (0: all, crystals per "
+                "ring - 1). ",
+            },
+        ),
+        "sinogram_filename": (
+            "sinogram.npy",
+            {
+                "doc": "Filename of the sinogram (npy, in the output directory). ",
+            },
+        ),
+        "listmode_filename": (
+            None,
+            {
+                "doc": "Filename of the listmode file (in the output directory): one record "
+                "per coincidence, see listmode_dtype. ",
+            },
+        ),
+        "termination_count": (
+            0,
+            {
+                "doc": "End each run once this number of coincidences is sorted (0: "
+                "never). The coincidences are sorted a few events after their singles, "
+                "so the run may end with a few more coincidences. ",
+            },
+        ),
+    }
+
+    # records of the listmode file: crystal indexes, time of the first single (s),
+    # time difference t2 - t1 (ns)
+    listmode_dtype = np.dtype(
+        [("crystal1", "<i4"), ("crystal2", "<i4"), ("time", "<f4"), ("dt", "<f4")]
+    )
+
+    def __init__(self, *args, **kwargs):
+        DigitizerTimeOrderedBase.__init__(self, *args, **kwargs)
+        self.number_of_coincidences = 0
+        self.number_of_skipped_lors = 0
+        self.sinogram_counts = None
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateDigitizerCoincidenceSorterActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        if self.window is None or self.window <= 0:
+            fatal(
+                f"Error, the window of the coincidence sorter '{self.name}' must be positive, "
+                f"while it is {self.window}"
+            )
+        if self.sinogram is not None or self.listmode_filename is not None:
+            self.initialize_lor_table()
+        check_termination_count(self)
+        DigitizerTimeOrderedBase.initialize(self)
+
+    def initialize_lor_table(self):
+        t = self.lor_table
+        if t is None or any(k not in t for k in ("crystal_index", "ring", "position")):
+            fatal(
+                f"Error, the coincidence sorter '{self.name}' needs a lor_table with "
+                f"'crystal_index', 'ring' and 'position' for the sinogram or the listmode"
+            )
+        rings = np.asarray(t["ring"], dtype=np.int32)
+        positions = np.asarray(t["position"], dtype=np.int32)
+        if rings.shape != positions.shape or rings.ndim != 1 or rings.size == 0:
+            fatal(
+                f"Error, the 'ring' and 'position' of the lor_table of '{self.name}' must "
+                f"be 1D arrays of the same size (one value per crystal)"
+            )
+        if (positions.max() + 1) % 2 != 0:
+            fatal(
+                f"Error, the number of crystals per ring of the lor_table of '{self.name}' "
+                f"must be even, while it is {positions.max() + 1}"
+            )
+        self.SetLORTable(rings.tolist(), positions.tolist())
+
+    def set_crystal_index(self):
+        depths = []
+        strides = []
+        for name, stride in self.lor_table["crystal_index"]:
+            volume = self.simulation.volume_manager.get_volume(name)
+            depths.append(volume.volume_depth_in_tree)
+            strides.append(int(stride))
+        self.SetCrystalIndex(depths, strides)
+
+    def StartSimulationAction(self):
+        self.set_number_of_threads()
+        if self.sinogram is not None or self.listmode_filename is not None:
+            self.set_crystal_index()
+        if self.listmode_filename is not None:
+            path = self.simulation.get_output_path(self.listmode_filename)
+            self.SetListmodeFilename(str(path))
+        DigitizerBase.StartSimulationAction(self)
+        g4.GateDigitizerCoincidenceSorterActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        self.number_of_coincidences = self.GetNumberOfCoincidences()
+        self.check_time_order()
+        if self.sinogram is not None:
+            self.number_of_skipped_lors = self.GetNumberOfSkippedLORs()
+            shape = tuple(self.GetSinogramShape())
+            self.sinogram_counts = np.array(self.GetSinogram()).reshape(shape)
+            np.save(
+                self.simulation.get_output_path(self.sinogram_filename),
+                self.sinogram_counts,
+            )
+        g4.GateDigitizerCoincidenceSorterActor.EndSimulationAction(self)
+
+    @staticmethod
+    def read_listmode(path):
+        return np.fromfile(path, dtype=DigitizerCoincidenceSorterActor.listmode_dtype)
+
+
+class DigitizerDeadTimeActor(
+    DigitizerTimeOrderedBase, g4.GateDigitizerDeadTimeActor
+):
+    """Dead time of the detector units (the volume given by group_volume, e.g. crystal or block),
+    on the singles in time order (see DigitizerTimeOrderedBase).
+    Output: the singles that are not in the dead time of their unit
+
+    Policies:
+    - NonParalyzable: the unit is dead during dead_time after each kept single
+    - Paralyzable: each single, kept or not, starts a new dead time
+    """
+
+    user_info_defaults = {
+        "dead_time": (
+            None,
+            {
+                "doc": "Dead time of the detector units. ",
+            },
+        ),
+        "policy": (
+            "NonParalyzable",
+            {
+                "doc": "Dead time model. ",
+                "allowed_values": (
+                    "NonParalyzable",
+                    "Paralyzable",
+                ),
+            },
+        ),
+        "group_volume": (
+            None,
+            {
+                "doc": "Volume of the detector units (the volume of the singles if None). ",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        DigitizerTimeOrderedBase.__init__(self, *args, **kwargs)
+        self.number_of_kept_singles = 0
+        self.number_of_removed_singles = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateDigitizerDeadTimeActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        if self.dead_time is None or self.dead_time < 0:
+            fatal(
+                f"Error, the dead_time of the digitizer '{self.name}' must be positive, "
+                f"while it is {self.dead_time}"
+            )
+        DigitizerTimeOrderedBase.initialize(self)
+
+    def StartSimulationAction(self):
+        self.set_number_of_threads()
+        self.set_group_by_depth()
+        DigitizerBase.StartSimulationAction(self)
+        g4.GateDigitizerDeadTimeActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        self.number_of_kept_singles = self.GetNumberOfKeptSingles()
+        self.number_of_removed_singles = self.GetNumberOfRemovedSingles()
+        self.check_time_order()
+        g4.GateDigitizerDeadTimeActor.EndSimulationAction(self)
+
+
+class DigitizerPileupActor(DigitizerTimeOrderedBase, g4.GateDigitizerPileupActor):
+    """Pile-up in the detector units (the volume given by group_volume, e.g. crystal or block),
+    on the singles in time order (see DigitizerTimeOrderedBase).
+    Output: the singles of a unit within the window after a first single are merged into it:
+    the energies are summed, the other attributes are the ones of the first single.
+    Needs TotalEnergyDeposit.
+    """
+
+    user_info_defaults = {
+        "window": (
+            None,
+            {
+                "doc": "Pile-up time window, after the first single. ",
+            },
+        ),
+        "group_volume": (
+            None,
+            {
+                "doc": "Volume of the detector units (the volume of the singles if None). ",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        DigitizerTimeOrderedBase.__init__(self, *args, **kwargs)
+        self.number_of_pileup_singles = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateDigitizerPileupActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        if self.window is None or self.window < 0:
+            fatal(
+                f"Error, the window of the pile-up digitizer '{self.name}' must be positive, "
+                f"while it is {self.window}"
+            )
+        DigitizerTimeOrderedBase.initialize(self)
+
+    def StartSimulationAction(self):
+        self.set_number_of_threads()
+        self.set_group_by_depth()
+        DigitizerBase.StartSimulationAction(self)
+        g4.GateDigitizerPileupActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        self.number_of_pileup_singles = self.GetNumberOfPileupSingles()
+        self.check_time_order()
+        g4.GateDigitizerPileupActor.EndSimulationAction(self)
+
+
 class DigitizerBlurringActor(DigitizerWithRootOutput, g4.GateDigitizerBlurringActor):
     """
     Digitizer module for blurring an attribute (single value only, not a vector).
@@ -454,6 +1099,21 @@ class DigitizerBlurringActor(DigitizerWithRootOutput, g4.GateDigitizerBlurringAc
                 "doc": "FIXME",
             },
         ),
+        "blur_map": (
+            None,
+            {
+                "doc": "Parameter of the blurring law per crystal (1D array, one value per "
+                "crystal): sigma for Gaussian, resolution for InverseSquare and Linear. "
+                "Replaces blur_sigma/blur_fwhm or blur_resolution. ",
+            },
+        ),
+        "blur_map_volume": (
+            None,
+            {
+                "doc": "Name of the volume whose copy number is the crystal index in the "
+                "blur map (default: the volume of the digi). ",
+            },
+        ),
     }
 
     type_name = "DigitizerBlurringActor"
@@ -468,11 +1128,33 @@ class DigitizerBlurringActor(DigitizerWithRootOutput, g4.GateDigitizerBlurringAc
         self.AddActions({"StartSimulationAction", "EndSimulationAction"})
 
     def initialize(self):
+        self.initialize_blur_map()
         self.initialize_blurring_parameters()
         DigitizerBase.initialize(self)
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
+    def initialize_blur_map(self):
+        if self.blur_map is None:
+            return
+        m = np.asarray(self.blur_map, dtype=np.float64)
+        if m.ndim != 1 or m.size == 0:
+            fatal(
+                f"Error, the blur map of '{self.name}' must be a 1D array "
+                f"(one value per crystal), while its shape is {m.shape}"
+            )
+        if np.any(m < 0):
+            fatal(f"Error, the blur map of '{self.name}' has negative values")
+        self.user_info.blur_map = np.ascontiguousarray(m)
+        # the parameter of the law is in the map
+        if self.blur_method == "Gaussian":
+            if self.blur_sigma is not None or self.blur_fwhm is not None:
+                fatal(
+                    f"Error, use blur_map or blur_sigma/blur_fwhm, not both, "
+                    f"for '{self.name}'"
+                )
+            self.blur_sigma = -1
+
     def initialize_blurring_parameters(self):
         if self.blur_method == "Gaussian":
             self.set_param_gauss()
@@ -520,6 +1202,12 @@ class DigitizerBlurringActor(DigitizerWithRootOutput, g4.GateDigitizerBlurringAc
             )
 
     def StartSimulationAction(self):
+        depth = -1
+        if self.blur_map_volume is not None:
+            depth = self.simulation.volume_manager.get_volume(
+                self.blur_map_volume
+            ).volume_depth_in_tree
+        self.SetBlurMapVolumeDepth(depth)
         DigitizerBase.StartSimulationAction(self)
         g4.GateDigitizerBlurringActor.StartSimulationAction(self)
 
@@ -672,6 +1360,27 @@ class DigitizerEfficiencyActor(
                 "doc": "FIXME",
             },
         ),
+        "efficiency_map": (
+            None,
+            {
+                "doc": "Efficiency per crystal and energy bin (2D array crystals x energy bins, "
+                "or 1D array with one value per crystal), replaces the efficiency value. ",
+            },
+        ),
+        "efficiency_map_volume": (
+            None,
+            {
+                "doc": "Name of the volume whose copy number is the crystal index in the "
+                "efficiency map (default: the volume of the digi). ",
+            },
+        ),
+        "efficiency_map_energy_range": (
+            None,
+            {
+                "doc": "Energy range [min, max] of the uniform energy bins of the efficiency map "
+                "(needed when there are several bins). ",
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -690,13 +1399,42 @@ class DigitizerEfficiencyActor(
                 f"Efficency set to {self.efficiency}, which is not in [0;1]."
             )
 
+    def initialize_efficiency_map(self):
+        if self.efficiency_map is None:
+            return
+        m = np.asarray(self.efficiency_map, dtype=np.float64)
+        if m.ndim == 1:
+            m = m.reshape(-1, 1)
+        if m.ndim != 2 or m.size == 0:
+            fatal(
+                f"Error, the efficiency map of '{self.name}' must be a 2D array "
+                f"(crystals x energy bins), while its shape is {m.shape}"
+            )
+        if m.shape[1] > 1 and self.efficiency_map_energy_range is None:
+            fatal(
+                f"Error, the efficiency map of '{self.name}' has {m.shape[1]} energy bins, "
+                f"the option efficiency_map_energy_range must be set"
+            )
+        if np.any(m < 0) or np.any(m > 1):
+            self.warn_user(
+                f"Some values of the efficiency map of '{self.name}' are not in [0;1]."
+            )
+        self.user_info.efficiency_map = np.ascontiguousarray(m)
+
     def initialize(self):
         self.initialize_blurring_parameters()
+        self.initialize_efficiency_map()
         DigitizerBase.initialize(self)
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
     def StartSimulationAction(self):
+        depth = -1
+        if self.efficiency_map_volume is not None:
+            depth = self.simulation.volume_manager.get_volume(
+                self.efficiency_map_volume
+            ).volume_depth_in_tree
+        self.SetEfficiencyMapVolumeDepth(depth)
         DigitizerBase.StartSimulationAction(self)
         g4.GateDigitizerEfficiencyActor.StartSimulationAction(self)
 
@@ -744,6 +1482,16 @@ class DigitizerEnergyWindowsActor(
                 "doc": "FIXME",
             },
         ),
+        "selection_only": (
+            False,
+            {
+                "doc": "If True and the output is not written to disk (and the actor is not "
+                "in a fused chain), the digi are not copied in the channels: each channel "
+                "only keeps the indices of the digi of the input collection of the current "
+                "event in its energy window. Requires less memory and is faster, but the "
+                "channels can only be read by a DigitizerProjectionActor. ",
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -803,6 +1551,66 @@ class DigitizerHitsCollectionActor(
                 "doc": "FIXME",
             },
         ),
+        "async_write": (
+            False,
+            {
+                "doc": "Write the root output with a background thread (one per thread): "
+                "the tracking continues while the hits are written and compressed.",
+            },
+        ),
+        "sampling_probability": (
+            1.0,
+            {
+                "doc": "Probability to keep a hit (sampling at fill time). The "
+                "probability of a hit is the product of this one, of the one of its "
+                "particle and of the one of its kinetic energy. The Weight of a kept "
+                "hit is divided by its probability (the Weight attribute is required).",
+            },
+        ),
+        "sampling_probability_per_particle": (
+            {},
+            {
+                "doc": "Probability to keep a hit, per particle name "
+                "(e.g. {'e-': 0.1}), 1 for the other particles.",
+            },
+        ),
+        "sampling_probability_per_energy": (
+            [],
+            {
+                "doc": "Probability to keep a hit according to the kinetic energy "
+                "(pre step) of the particle: list of [energy, probability], the "
+                "probability of the first energy above the kinetic energy is used "
+                "(1 above the last energy).",
+            },
+        ),
+        "reservoir_size": (
+            0,
+            {
+                "doc": "If not zero, keep at most this number of hits per thread and "
+                "per run, uniformly among the sampled hits (reservoir sampling), with "
+                "the Weight multiplied by the number of sampled hits divided by this "
+                "size. The hits are then written at the end of each run and should "
+                "not be the input of other digitizer modules.",
+            },
+        ),
+        "retention_events": (
+            0,
+            {
+                "doc": "If not zero, keep the hits of the last N events of each thread "
+                "(ring buffer of events) instead of clearing them every clear_every "
+                "events: the hits of the older events are written and discarded at "
+                "the beginning of each event. For the actors that need a sliding "
+                "window of past events, with a bounded memory.",
+            },
+        ),
+        "retention_time": (
+            0,
+            {
+                "doc": "If not zero, keep the hits of the events whose time (primary "
+                "vertex) is in this time window before the current event, see "
+                "retention_events (both limits can be set).",
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -832,6 +1640,8 @@ class DigitizerProjectionActor(DigitizerBase, g4.GateDigitizerProjectionActor):
     """
     This actor takes as input HitsCollections and performed binning in 2D images.
     If there are several HitsCollection as input, the slices will correspond to each HC.
+    With energy_windows, there is a single input collection and the slices correspond to
+    the windows (one pass on the digi, no energy windows actor needed).
     If there are several runs, images will also be slice-stacked.
     """
 
@@ -878,6 +1688,44 @@ class DigitizerProjectionActor(DigitizerBase, g4.GateDigitizerProjectionActor):
                 "doc": "FIXME",
             },
         ),
+        "energy_windows": (
+            [],
+            {
+                "doc": "Energy windows, same format as the channels of the "
+                "DigitizerEnergyWindowsActor (list of dict with name, min and max): one "
+                "slice per window, for the digi of the single input collection whose "
+                "TotalEnergyDeposit is in [min, max[. ",
+            },
+        ),
+        "termination_count": (
+            0,
+            {
+                "doc": "End each run once the projection has this number of counts in "
+                "the termination_roi, for the termination_channel (0: never). ",
+            },
+        ),
+        "termination_snr": (
+            0,
+            {
+                "doc": "End each run once the mean pixel of the termination_roi "
+                "reaches this signal to noise ratio (Poisson counts: SNR^2 x pixels "
+                "counts, 0: never). Replaces termination_count. ",
+            },
+        ),
+        "termination_roi": (
+            [],
+            {
+                "doc": "Pixels [x0, x1, y0, y1] of the termination criterion, "
+                "x0 <= x < x1 and y0 <= y < y1 (empty: the whole projection). ",
+            },
+        ),
+        "termination_channel": (
+            -1,
+            {
+                "doc": "Channel (input collection or energy window) of the termination "
+                "criterion (-1: all the channels). ",
+            },
+        ),
     }
 
     user_output_config = {
@@ -909,10 +1757,41 @@ class DigitizerProjectionActor(DigitizerBase, g4.GateDigitizerProjectionActor):
                 f"Sorry, cannot (yet) use ProjectionActor with repeated volumes, "
                 f"set 'authorize_repeated_volumes' to False"
             )
+        if len(self.energy_windows) > 0:
+            if len(self.input_digi_collections) != 1:
+                fatal(
+                    f"Error, with energy_windows, the DigitizerProjectionActor {self.name} "
+                    f"must have a single input collection, while there are "
+                    f"{self.input_digi_collections}"
+                )
+            for w in self.energy_windows:
+                if any(k not in w for k in ("name", "min", "max")):
+                    fatal(
+                        f"Error, the energy windows of the DigitizerProjectionActor "
+                        f"{self.name} must have a name, min and max, while one is {w}"
+                    )
+        check_termination_count(self)
+        if self.termination_snr < 0:
+            fatal(
+                f"Error, the termination_snr of the actor {self.name} must be "
+                f"positive or 0, while it is {self.termination_snr}"
+            )
+        if self.termination_channel >= self.number_of_channels:
+            fatal(
+                f"Error, the termination_channel of the actor {self.name} must be "
+                f"-1 or one of the {self.number_of_channels} channels, "
+                f"while it is {self.termination_channel}"
+            )
         DigitizerBase.initialize(self)
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
+    @property
+    def number_of_channels(self):
+        if len(self.energy_windows) > 0:
+            return len(self.energy_windows)
+        return len(self.input_digi_collections)
+
     @property
     def output_size(self):
         # consider 3D images, third dimension can be the energy windows
@@ -975,9 +1854,7 @@ class DigitizerProjectionActor(DigitizerBase, g4.GateDigitizerProjectionActor):
         # and according to the volume shape
         size = self.output_size
         spacing = self.output_spacing
-        size[2] = len(self.input_digi_collections) * len(
-            self.simulation.run_timing_intervals
-        )
+        size[2] = self.number_of_channels * len(self.simulation.run_timing_intervals)
         spacing[2] = self.compute_thickness(self.attached_to, size[2])
 
         # we use the image associated with run 0 for the entire simulation
@@ -1050,6 +1927,154 @@ class DigitizerProjectionActor(DigitizerBase, g4.GateDigitizerProjectionActor):
         self.user_output.projection.write_data_if_requested(which="merged")
 
 
+class ForcedDetectionActor(ActorBase, g4.GateForcedDetectionActor):
+    """
+    Forced detection (next-event estimator) of the photons scattered in a voxelized
+    phantom. At each Compton (and optionally Rayleigh) interaction in the phantom,
+    the probability that the photon is scattered toward the detector and leaves the
+    phantom without any other interaction is scored in the pixel of the detector it
+    would reach. The detector is an ideal parallel collimator (the only accepted
+    direction is the normal of the detector plane), the result is thus a projection
+    in counts per steradian of collimator acceptance. There is no attenuation
+    outside the phantom.
+    One slice per run.
+    """
+
+    # hints for IDE
+    detector: str
+    spacing: List[float]
+    size: List[int]
+    energy_min: float
+    energy_max: float
+    interactions: List[str]
+    database: str
+    detector_orientation_matrix: np.ndarray
+    primary: bool
+
+    user_info_defaults = {
+        "detector": (
+            None,
+            {
+                "doc": "Name of the detector volume. The projection is in the plane "
+                "of the center of this volume.",
+            },
+        ),
+        "spacing": (
+            [4 * g4_units.mm, 4 * g4_units.mm],
+            {"doc": "Pixel spacing of the projection"},
+        ),
+        "size": (
+            [128, 128],
+            {"doc": "Number of pixels of the projection"},
+        ),
+        "energy_min": (
+            0,
+            {"doc": "Lower bound of the energy window of the scattered photons"},
+        ),
+        "energy_max": (
+            1 * g4_units.MeV,
+            {"doc": "Upper bound of the energy window of the scattered photons"},
+        ),
+        "interactions": (
+            ["compt"],
+            {
+                "doc": "Interactions where the scattered photon is forced toward "
+                "the detector ('compt' and/or 'Rayl')",
+            },
+        ),
+        "primary": (
+            False,
+            {
+                "doc": "Also project analytically the primary photons emitted in the "
+                "phantom (isotropic emission, attenuation from the emission point), "
+                "if their energy is in the energy window. The projection is then "
+                "primary + scatter.",
+            },
+        ),
+        "database": (
+            "EPDL",
+            {
+                "doc": "The database source for attenuation coefficients, either 'EPDL' or 'NIST'",
+                "allowed_values": ("EPDL", "NIST"),
+            },
+        ),
+        "detector_orientation_matrix": (
+            Rotation.from_euler("x", 0).as_matrix(),
+            {
+                "doc": "Orientation of the projection in the detector volume "
+                "(the normal of the detector plane is the third axis)",
+            },
+        ),
+    }
+
+    user_output_config = {
+        "projection": {
+            "actor_output_class": ActorOutputSingleImage,
+        },
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateForcedDetectionActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if self.attached_to_volume.volume_type != "ImageVolume":
+            fatal(
+                f"The ForcedDetectionActor '{self.name}' must be attached to an "
+                f"ImageVolume, while '{self.attached_to}' is a "
+                f"{self.attached_to_volume.volume_type}."
+            )
+        if self.detector is None:
+            fatal(f"The ForcedDetectionActor '{self.name}' needs a detector volume.")
+        if len(self.size) != 2 or len(self.spacing) != 2:
+            fatal(
+                f"The size and spacing of the ForcedDetectionActor '{self.name}' "
+                f"must be 2-vectors, while they are {self.size} and {self.spacing}."
+            )
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        volume_engine = self.actor_engine.simulation_engine.volume_engine
+        detector = volume_engine.get_volume(self.detector)
+
+        # one slice per run
+        size = list(self.size) + [len(self.simulation.run_timing_intervals)]
+        spacing = list(self.spacing) + [1]
+        self.user_output.projection.create_empty_image(0, size, spacing)
+        align_image_with_physical_volume(
+            detector, self.user_output.projection.data_per_run[0].image
+        )
+        update_image_py_to_cpp(
+            self.user_output.projection.data_per_run[0].image, self.fImage, True
+        )
+
+        self.SetDetectorVolumeName(str(detector.g4_physical_volumes[0].GetName()))
+        self.SetPhantomVolumeName(
+            str(self.attached_to_volume.g4_physical_volumes[0].GetName())
+        )
+        self.SetImageParameterisation(self.attached_to_volume.g4_voxel_param)
+
+    def EndSimulationAction(self):
+        self.user_output.projection.store_data(
+            "merged", get_py_image_from_cpp_image(self.fImage)
+        )
+        # origin at the image center, as the projection actor
+        info = self.user_output.projection.data_per_run[0].get_image_properties()[0]
+        spacing = info.spacing
+        origin = -info.size * spacing / 2.0 + spacing / 2.0
+        origin[2] = 0
+        self.user_output.projection.merged_data.SetSpacing(list(spacing))
+        self.user_output.projection.merged_data.SetOrigin(list(origin))
+        self.user_output.projection.data_per_run.pop(0)
+        self.user_output.projection.write_data_if_requested(which="merged")
+
+
 class DigitizerReadoutActor(DigitizerAdderActor, g4.GateDigitizerReadoutActor):
     """
     This actor is a DigitizerAdderActor + a discretization step:
@@ -1094,6 +2119,101 @@ class DigitizerReadoutActor(DigitizerAdderActor, g4.GateDigitizerReadoutActor):
         g4.GateDigitizerReadoutActor.EndSimulationAction(self)
 
 
+class DigitizerFusedChainActor(DigitizerBase, g4.GateDigitizerFusedChainActor):
+    """Run a chain of digitizer modules in one pass per event, without filling the
+    intermediate digi collections. The modules (adder, readout, efficiency, blurring,
+    spatial blurring, energy windows) are created and configured as usual, and their
+    names are given in 'modules', in order. The input of the first module must be this
+    actor, and the input of each next module the previous one. Only the output of the
+    last module is filled (and maybe written), an energy windows module can only be the last.
+    This actor must be created before the modules. See Digitizer(..., fused=True).
+    """
+
+    # hints for IDE
+    input_digi_collection: str
+    modules: List[str]
+
+    user_info_defaults = {
+        "input_digi_collection": (
+            "Hits",
+            {
+                "doc": "Digi collection to be used as input (usually the hits). ",
+            },
+        ),
+        "modules": (
+            [],
+            {
+                "doc": "Names of the digitizer modules of the chain, in order. ",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        DigitizerBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateDigitizerFusedChainActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        DigitizerBase.initialize(self)
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+        self.initialize_modules()
+
+    def initialize_modules(self):
+        if len(self.modules) == 0:
+            fatal(f"The fused digitizer chain '{self.name}' has no module")
+        fusable = (
+            DigitizerAdderActor,
+            DigitizerEfficiencyActor,
+            DigitizerBlurringActor,
+            DigitizerSpatialBlurringActor,
+            DigitizerEnergyWindowsActor,
+        )
+        sorted_names = [a.name for a in self.simulation.actor_manager.sorted_actors]
+        previous = self.name
+        for i, name in enumerate(self.modules):
+            m = self.simulation.actor_manager.get_actor(name)
+            last = i == len(self.modules) - 1
+            if not isinstance(m, fusable):
+                fatal(
+                    f"The actor '{name}' ({m.type_name}) cannot be part of the fused "
+                    f"digitizer chain '{self.name}'"
+                )
+            if m.input_digi_collection != previous:
+                fatal(
+                    f"In the fused digitizer chain '{self.name}', the input of the module "
+                    f"'{name}' must be '{previous}', while it is '{m.input_digi_collection}'"
+                )
+            if sorted_names.index(name) < sorted_names.index(self.name):
+                fatal(
+                    f"The fused digitizer chain '{self.name}' must be created before "
+                    f"its module '{name}'"
+                )
+            if not last:
+                if isinstance(m, DigitizerEnergyWindowsActor):
+                    fatal(
+                        f"The energy windows '{name}' must be the last module of the "
+                        f"fused digitizer chain '{self.name}'"
+                    )
+                if m.user_output["root_output"].write_to_disk:
+                    fatal(
+                        f"The module '{name}' of the fused digitizer chain '{self.name}' "
+                        f"is not the last one, its output cannot be written to disk"
+                    )
+            self.AddModule(m)
+            previous = name
+
+    def StartSimulationAction(self):
+        DigitizerBase.StartSimulationAction(self)
+        g4.GateDigitizerFusedChainActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        g4.GateDigitizerFusedChainActor.EndSimulationAction(self)
+
+
 class PhaseSpaceActor(DigitizerWithRootOutput, g4.GatePhaseSpaceActor):
     """Similar to HitsCollectionActor : store a list of hits.
     However only the first hit of given event is stored here.
@@ -1124,6 +2244,29 @@ class PhaseSpaceActor(DigitizerWithRootOutput, g4.GatePhaseSpaceActor):
                 "doc": "FIXME entering exiting first (can be combined)",
             },
         ),
+        "quantize_directions": (
+            False,
+            {
+                "doc": "With a .gphsp output file, store the direction attributes "
+                "(e.g. PreDirection) as one quantized column (two int16, octahedral "
+                "encoding, about 1e-4 rad) instead of three float32 columns.",
+            },
+        ),
+        "chunk_size": (
+            100000,
+            {
+                "doc": "With a .gphsp output file, the entries of each thread are "
+                "written by chunks of at least this size, so that the memory does not "
+                "grow with the number of entries.",
+            },
+        ),
+        "termination_count": (
+            0,
+            {
+                "doc": "End each run once this number of entries is stored (0: never). "
+                "The events are complete, so the run may end with a few more entries.",
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -1144,6 +2287,9 @@ class PhaseSpaceActor(DigitizerWithRootOutput, g4.GatePhaseSpaceActor):
             self.SetStoreExitingStepFlag(True)
         if "first" in self.steps_to_store:
             self.SetStoreFirstStepInVolumeFlag(True)
+        if self.chunk_size < 1:
+            fatal(f"The chunk_size of the actor {self.name} must be at least 1")
+        check_termination_count(self)
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
@@ -1161,14 +2307,77 @@ class PhaseSpaceActor(DigitizerWithRootOutput, g4.GatePhaseSpaceActor):
         g4.GatePhaseSpaceActor.EndSimulationAction(self)
 
 
+
+class PhaseSpacePlaneActor(PhaseSpaceActor, g4.GatePhaseSpacePlaneActor):
+    """Phase-space of the particles crossing a virtual plane, without scoring volume.
+    The crossings are computed from the pre and post step points of the steps in the
+    attached volume (and its daughters), so the plane must lie in this volume. The
+    plane is defined by a point and a normal in the coordinate system of the attached
+    volume. The position is the one of the crossing, the other values are the ones of
+    the pre step point.
+    """
+
+    user_info_defaults = {
+        "attributes": (
+            ["Position", "Direction", "KineticEnergy", "Weight", "PDGCode"],
+            {
+                "doc": "Values stored for each crossing: Position, Direction, "
+                "KineticEnergy, Weight, PDGCode, EventID, TrackID, GlobalTime.",
+            },
+        ),
+        "plane_position": (
+            [0, 0, 0],
+            {
+                "doc": "A point of the plane, in the coordinate system of the "
+                "attached volume.",
+            },
+        ),
+        "plane_normal": (
+            [0, 0, 1],
+            {
+                "doc": "Normal of the plane, in the coordinate system of the attached "
+                "volume. The particles crossing the plane along the normal are stored.",
+            },
+        ),
+        "both_directions": (
+            False,
+            {
+                "doc": "Also store the particles crossing the plane against the normal.",
+            },
+        ),
+    }
+
+    def __initcpp__(self):
+        # see DigitizerReadoutActor: explicit call to the base class
+        g4.GatePhaseSpaceActor.__init__(self, self.user_info)
+        g4.GatePhaseSpacePlaneActor.__init__(self, self.user_info)
+
+    def initialize(self):
+        if self.store_absorbed_event:
+            fatal(f"The actor {self.name} cannot store the absorbed events")
+        PhaseSpaceActor.initialize(self)
+
+    def StartSimulationAction(self):
+        DigitizerBase.StartSimulationAction(self)
+        g4.GatePhaseSpacePlaneActor.StartSimulationAction(self)
+
+
 process_cls(DigitizerBase)
 process_cls(DigitizerWithRootOutput)
 process_cls(DigitizerAdderActor)
+process_cls(DigitizerOnlineAdderActor)
+process_cls(DigitizerTimeOrderedBase)
+process_cls(DigitizerCoincidenceSorterActor)
+process_cls(DigitizerDeadTimeActor)
+process_cls(DigitizerPileupActor)
 process_cls(DigitizerBlurringActor)
 process_cls(DigitizerSpatialBlurringActor)
 process_cls(DigitizerEfficiencyActor)
 process_cls(DigitizerEnergyWindowsActor)
 process_cls(DigitizerHitsCollectionActor)
 process_cls(DigitizerProjectionActor)
+process_cls(ForcedDetectionActor)
 process_cls(DigitizerReadoutActor)
+process_cls(DigitizerFusedChainActor)
 process_cls(PhaseSpaceActor)
+process_cls(PhaseSpacePlaneActor)
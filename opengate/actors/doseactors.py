@@ -1,4 +1,7 @@
+import json
+import itk
 import numpy as np
+import scipy.sparse
 from scipy.spatial.transform import Rotation
 
 import opengate_core as g4
@@ -7,16 +10,22 @@ from ..exception import fatal, warning
 from ..utility import (
     g4_units,
     standard_error_c4_correction,
+    insert_suffix_before_extension,
 )
+from ..distributed import get_distributed_context
 from ..image import (
     update_image_py_to_cpp,
     get_py_image_from_cpp_image,
     images_have_same_domain,
+    create_3d_image,
     resample_itk_image_like,
 )
 from ..geometry.utility import get_transform_world_to_local
+from ..geometry.materials import create_mass_img_like
 from ..base import process_cls
+from ..checkpoint import get_output_checkpoint_state
 from .actoroutput import (
+    ActorOutputBase,
     ActorOutputSingleImage,
     ActorOutputSingleMeanImage,
     ActorOutputQuotientMeanImage,
@@ -25,6 +34,51 @@ from .actoroutput import (
 )
 
 
+# options of the actors that can score their image per time frame (4D)
+_time_frame_user_info_defaults = {
+    "number_of_time_frames": (
+        0,
+        {
+            "doc": "Number of time frames (0: none). If set, the scored quantity is also written per "
+            "frame of the global time of the steps, as a 4D image (x, y, z, frame) in a memory-mapped "
+            "file next to the main output (suffix 'per_time_frame', mhd/raw). The frames cover all the "
+            "runs of the simulation; the deposits outside the frames are not counted in the 4D image. ",
+        },
+    ),
+    "time_frame_duration": (
+        0,
+        {
+            "doc": "Duration of each time frame (with units), required with number_of_time_frames. ",
+        },
+    ),
+    "time_frame_start": (
+        0,
+        {
+            "doc": "Global time of the start of the first time frame (with units). ",
+        },
+    ),
+    "time_frame_buffer": (
+        4,
+        {
+            "doc": "Number of time frames kept in memory per thread, as sparse images. When a thread "
+            "reaches a new frame, its oldest frame is added to the file and released. ",
+        },
+    ),
+}
+
+# options of the actors that accept scoring_mode='queue'
+_queue_size_user_info_defaults = {
+    "queue_size": (
+        4096,
+        {
+            "doc": "For advanced users, with scoring_mode='queue' only: number of deposits kept per thread "
+            "before they are applied to the image(s). For the DoseActor with an uncertainty_goal, the queue "
+            "is also applied at the end of each event. ",
+        },
+    ),
+}
+
+
 class VoxelDepositActor(ActorBase):
     """Base class which holds user input parameters common to all actors
     that deposit quantities in a voxel grid, e.g. the DoseActor.
@@ -79,8 +133,10 @@ class VoxelDepositActor(ActorBase):
             "random",
             {
                 "doc": "For advanced users: define the position of interaction to which the deposited quantity is associated to, "
-                "i.e. at the Geant4 PreStepPoint, PostStepPoint, or somewhere in between (middle or (uniform) random). In doubt use/start with random.",
-                "allowed_values": ("random", "pre", "post", "middle"),
+                "i.e. at the Geant4 PreStepPoint, PostStepPoint, or somewhere in between (middle or (uniform) random). In doubt use/start with random. "
+                "With 'segment', the deposited quantity is distributed over all the voxels crossed by the step, proportionally to the step length "
+                "inside each voxel (DoseActor, TLEDoseActor and FluenceActor only; the FluenceActor then uses the track length estimator).",
+                "allowed_values": ("random", "pre", "post", "middle", "segment"),
             },
         ),
         "output": (
@@ -124,6 +180,30 @@ class VoxelDepositActor(ActorBase):
                     f"{self.attached_to} ({self.attached_to_volume.volume_type})"
                 )
 
+    def check_snapshot_options(self):
+        # snapshots (see snapshot_event_interval) are defined for the dense images only
+        enabled = self.snapshot_event_interval > 0 or self.snapshot_time_interval > 0
+        if enabled and self.scoring_mode == "sparse":
+            fatal(
+                f"The actor '{self.name}' cannot take snapshots (snapshot_event_interval "
+                f"or snapshot_time_interval) with scoring_mode='sparse'. "
+            )
+
+    def check_buffer_precision_options(self):
+        # float buffers (see buffer_precision) are defined for scoring_mode='thread_local' only
+        if self.buffer_precision != "float":
+            return
+        if self.scoring_mode != "thread_local":
+            fatal(
+                f"The actor '{self.name}' can use buffer_precision='float' only "
+                f"with scoring_mode='thread_local', while scoring_mode='{self.scoring_mode}'. "
+            )
+        if self.snapshot_event_interval > 0 or self.snapshot_time_interval > 0:
+            fatal(
+                f"The actor '{self.name}' cannot take snapshots (snapshot_event_interval "
+                f"or snapshot_time_interval) with buffer_precision='float'. "
+            )
+
     def initialize(self):
         super().initialize()
 
@@ -141,6 +221,30 @@ class VoxelDepositActor(ActorBase):
                 fatal("size = 'like_image_volume' " + msg)
             self.size = self.attached_to_volume.size_pix
 
+    def initialize_time_frames(self, output_name, cpp_output_name):
+        """Set the path of the 4D image written per time frame by the C++ side
+        (see number_of_time_frames), next to the output named output_name."""
+        if self.number_of_time_frames <= 0:
+            return
+        if self.time_frame_duration <= 0:
+            fatal(
+                f"The actor '{self.name}' needs a positive time_frame_duration "
+                f"with number_of_time_frames={self.number_of_time_frames}."
+            )
+        if get_distributed_context().mode == "fork":
+            fatal(
+                f"The time frames of the actor {self.name} "
+                f"cannot be used with the distributed mode 'fork'"
+            )
+        path = insert_suffix_before_extension(
+            self.user_output[output_name].get_output_path(item=0),
+            "per_time_frame",
+        ).with_suffix(".mhd")
+        self.AddActorOutputInfo(cpp_output_name)
+        self.SetOutputPath(
+            cpp_output_name, get_distributed_context().get_process_path(str(path))
+        )
+
     def get_physical_volume_name(self):
         # init the origin and direction according to the physical volume
         # (will be updated in the BeginOfRun)
@@ -232,7 +336,9 @@ class VoxelDepositActor(ActorBase):
         data = []
         for i, cppi in enumerate(cpp_image):
             if self.user_output[output_name].get_active(item=i):
-                py_image = get_py_image_from_cpp_image(cppi, view=False)
+                # the cpp image gets a new buffer in push_to_cpp_image at the
+                # next run, so its buffer is shared (not copied) with python
+                py_image = get_py_image_from_cpp_image(cppi, view=True, share=True)
                 # FIXME: not needed, I think, because get_py_image_from_cpp_image copies spacing and origin
                 # There is an empty image already which has served as storage for meta info like size and spacing.
                 # So we get this info back
@@ -244,7 +350,9 @@ class VoxelDepositActor(ActorBase):
                 data.append(None)
         self.user_output[output_name].store_data(run_index, *data)
 
-    def push_to_cpp_image(self, output_name, run_index, *cpp_image, copy_data=True):
+    def push_to_cpp_image(
+        self, output_name, run_index, *cpp_image, copy_data=True, allocate=True
+    ):
         self._assert_output_exists(output_name)
         for i, cppi in enumerate(cpp_image):
             if self.user_output[output_name].get_active(item=i):
@@ -252,6 +360,7 @@ class VoxelDepositActor(ActorBase):
                     self.user_output[output_name].get_data(run_index, item=i),
                     cppi,
                     copy_data,
+                    allocate,
                 )
 
     def EndOfRunActionMasterThread(self, run_index):
@@ -417,7 +526,9 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
         "uncertainty_goal": (
             None,
             {
-                "doc": "If set, it defines the statistical uncertainty goal. The simulation will stop once the statistical uncertainty is smaller or equal this value.",
+                "doc": "If set, it defines the statistical uncertainty goal. The simulation will stop once the statistical uncertainty is smaller or equal this value. "
+                "The uncertainty is evaluated in the background while the simulation continues, "
+                "mostly from the voxels found above the threshold at the previous evaluation.",
                 "setter_hook": _setter_hook_uncertainty_goal,
             },
         ),
@@ -440,6 +551,15 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
                 "doc": "Only applies if uncertainty_goal is set True: Factor multiplying the estimated N events needed to achieve the uncertainty goal, to ensure convergence.",
             },
         ),
+        "uncertainty_batch_size": (
+            1,
+            {
+                "doc": "Number of consecutive events (per thread) that are grouped into one sample to compute the squared values. "
+                "With 1 (default), the uncertainty is estimated history by history. "
+                "Larger values are cheaper (fewer squared values to accumulate) and the uncertainty is then estimated from the batches. "
+                "Cannot be used with uncertainty_goal.",
+            },
+        ),
         "dose_calc_on_the_fly": (
             False,
             {
@@ -447,6 +567,83 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
                 "deactivated": True,
             },
         ),
+        "dose_mass": (
+            "step",
+            {
+                "doc": "How the dose is computed from the deposited energy. With 'step' (default), the energy of each "
+                "step is divided by the density of the material of the step (and by the voxel volume). "
+                "With 'voxel', the edep of each voxel is divided by the mass of the voxel, computed once from "
+                "the overlaps of the voxel with the voxels of the image volume to which the actor is attached "
+                "(no resampling). This gives the exact dose when the scoring grid differs from the image grid; "
+                "use it with hit_type='segment' to spread the deposits over the voxels crossed by the steps. ",
+                "allowed_values": ("step", "voxel"),
+            },
+        ),
+        "stopping_power_table": (
+            True,
+            {
+                "doc": "Only applies if score_in is not 'material': the stopping power ratios used for the conversion "
+                "are tabulated (log-energy grid, per particle and material, filled on the fly) and interpolated, "
+                "instead of being computed with the G4EmCalculator at each step. Set to False to compute them at each step. ",
+            },
+        ),
+        "scoring_mode": (
+            "mutex",
+            {
+                "doc": "For advanced users: define how the threads accumulate the deposited quantities. "
+                "With 'mutex', all threads write in the same images, protected by a lock. "
+                "With 'thread_local', each thread fills its own copy of the images, "
+                "which are summed at the end of the run. This avoids the lock contention with many threads, "
+                "but requires one additional image per scored quantity and per thread. "
+                "With 'atomic', all threads write in the same images with lock-free atomic additions, "
+                "which avoids both the lock and the additional memory (preferred for very large images). "
+                "With 'sparse', each thread fills its own sparse images, made of tiles of 8x8x8 voxels "
+                "allocated only when a voxel is hit for the first time, which are summed at the end of the run. "
+                "It is efficient when only a small part of the image receives deposits (e.g. pencil beams). "
+                "With 'queue', each thread keeps its deposits in a queue (see queue_size), which is sorted "
+                "by tile of 8x8x8 voxels and applied to the shared images with a single lock when full. "
+                "The images are written in a cache-friendly order and the lock is taken once per batch. ",
+                "allowed_values": ("mutex", "thread_local", "atomic", "sparse", "queue"),
+            },
+        ),
+        **_queue_size_user_info_defaults,
+        "buffer_precision": (
+            "double",
+            {
+                "doc": "For advanced users, with scoring_mode='thread_local' only: precision of the per-thread "
+                "copies of the images. With 'float', they need half of the memory, but each thread "
+                "accumulates its deposits with about 7 significant digits (counts are exact up to 2^24 "
+                "per voxel and per thread). The per-thread values are summed in the final images in double. "
+                "Cannot be used with snapshots. ",
+                "allowed_values": ("double", "float"),
+            },
+        ),
+        "write_edep_per_run": (
+            False,
+            {
+                "doc": "The edep of each run is also written as one frame of a 4D image (x, y, z, run), "
+                "in a memory-mapped file next to the edep output (suffix 'per_run', mhd/raw). The frames are "
+                "written to disk when the runs end, so that the edep of all runs does not need to fit in "
+                "memory (use it with keep_data_per_run=False). The spacing and origin are the ones of the "
+                "first run, in the coordinate system of the attached volume. ",
+            },
+        ),
+        "snapshot_event_interval": (
+            0,
+            {
+                "doc": "During the run, copy the current edep (and dose) into a snapshot every given number of events, "
+                "while the threads keep on scoring. The snapshot can be read from python with get_snapshot(), "
+                "e.g. to monitor long runs. 0 (default) means no snapshot. Cannot be used with scoring_mode='sparse'. ",
+            },
+        ),
+        "snapshot_time_interval": (
+            0,
+            {
+                "doc": "Same as snapshot_event_interval, with an interval in seconds of wall clock time. "
+                "0 (default) means no snapshot. ",
+            },
+        ),
+        **_time_frame_user_info_defaults,
     }
 
     user_output_config = {
@@ -502,6 +699,8 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
 
     def __init__(self, *args, **kwargs):
         VoxelDepositActor.__init__(self, *args, **kwargs)
+        # 1 / mass of the voxels (dose_mass='voxel'), computed at the first run
+        self._inverse_voxel_mass = None
         self.__initcpp__()
 
     def __initcpp__(self):
@@ -532,6 +731,51 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
             )
         return density_image
 
+    def get_inverse_voxel_mass(self):
+        """1 / mass of the voxels of the scoring grid, in G4 units (0 where the
+        voxel does not overlap the image volume), see dose_mass='voxel'.
+        The mass is computed from the overlaps of the scoring voxels with the voxels
+        of the image volume, in the coordinate system of the volume."""
+        if self._inverse_voxel_mass is not None:
+            return self._inverse_voxel_mass
+        volume = self.attached_to_volume
+        rho = itk.GetArrayFromImage(volume.create_density_image())
+        density = itk.GetImageFromArray(rho)
+        sp = np.array(volume.itk_image.GetSpacing(), dtype=float)
+        density.SetSpacing(sp.tolist())
+        density.SetOrigin((-np.array(rho.shape[::-1]) * sp / 2 + sp / 2).tolist())
+        size = np.array(self.size)
+        spacing = np.array(self.spacing, dtype=float)
+        origin = np.array(self.translation) - size * spacing / 2 + spacing / 2
+        grid = create_3d_image(size, spacing.tolist(), origin.tolist(), allocate=False)
+        mass = itk.GetArrayFromImage(create_mass_img_like(density, grid))
+        mass *= g4_units.g
+        self._inverse_voxel_mass = np.divide(
+            1.0, mass, out=np.zeros_like(mass), where=mass > 0
+        )
+        return self._inverse_voxel_mass
+
+    def store_dose_from_voxel_mass(self, run_index):
+        """dose_mass='voxel': the dose (and squared dose) of the run is the edep (and
+        squared edep) divided by the mass of the voxel (squared)."""
+        edep = self.user_output.edep_with_uncertainty
+        dose = self.user_output.dose_with_uncertainty
+        inverse_mass = self.get_inverse_voxel_mass() / g4_units.Gy
+        data = []
+        for item, power in ((0, 1), (1, 2)):
+            if not dose.get_active(item=item):
+                data.append(None)
+                continue
+            edep_image = edep.get_data(run_index, item=item)
+            a = itk.array_view_from_image(edep_image) * inverse_mass**power
+            image = itk.GetImageFromArray(a)
+            image.CopyInformation(edep_image)
+            data.append(image)
+        dose.store_data(run_index, *data)
+        dose.store_meta_data(
+            run_index, number_of_samples=self.number_of_uncertainty_samples
+        )
+
     def initialize(self, *args):
         """
         At the start of the run, the image is centered according to the coordinate system of
@@ -579,6 +823,49 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
                     True, item=1
                 )  # activate squared component
 
+        if self.uncertainty_goal is not None and self.scoring_mode in (
+            "thread_local",
+            "sparse",
+        ):
+            fatal(
+                f"The dose actor '{self.name}' cannot use uncertainty_goal "
+                f"with scoring_mode='{self.scoring_mode}' because the images are only "
+                f"merged at the end of the run. Use scoring_mode='mutex' or 'atomic'. "
+            )
+
+        self.check_snapshot_options()
+        self.check_buffer_precision_options()
+
+        if self.uncertainty_goal is not None and self.uncertainty_batch_size > 1:
+            fatal(
+                f"The dose actor '{self.name}' cannot use uncertainty_goal "
+                f"with uncertainty_batch_size={self.uncertainty_batch_size}. "
+                f"Use uncertainty_batch_size=1 (history by history)."
+            )
+
+        if self.dose_mass == "voxel":
+            if self.attached_to_volume.volume_type != "ImageVolume":
+                fatal(
+                    f"The dose actor '{self.name}' can only use dose_mass='voxel' "
+                    f"if it is attached to an ImageVolume. This actor is attached "
+                    f"to a {self.attached_to_volume.volume_type} volume. "
+                )
+            if self.score_in != "material" or not np.allclose(
+                self.rotation, np.identity(3)
+            ):
+                fatal(
+                    f"The dose actor '{self.name}' cannot use dose_mass='voxel' "
+                    f"with score_in='{self.score_in}' or with a rotation. "
+                )
+            # the dose is computed from the edep (and squared edep) at the end
+            # of the run, the squared edep is then needed but not written
+            if self.user_output.dose_with_uncertainty.get_active(item=1):
+                if not self.user_output.edep_with_uncertainty.get_active(item=1):
+                    self.user_output.edep_with_uncertainty.set_write_to_disk(
+                        False, item=1
+                    )
+                    self.user_output.edep_with_uncertainty.set_active(True, item=1)
+
         if (
             self.user_output.density.get_active() is True
             and self.attached_to_volume.volume_type != "ImageVolume"
@@ -589,13 +876,34 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
             )
 
         self.InitializeUserInfo(self.user_info)  # C++ side
+        if self.write_edep_per_run:
+            if get_distributed_context().mode == "fork":
+                fatal(
+                    f"The option write_edep_per_run of the actor {self.name} "
+                    f"cannot be used with the distributed mode 'fork'"
+                )
+            # the frames are written by the C++ side (see WriteEdepPerRun)
+            path = insert_suffix_before_extension(
+                self.user_output.edep_with_uncertainty.get_output_path(item=0),
+                "per_run",
+            ).with_suffix(".mhd")
+            self.AddActorOutputInfo("edep_per_run")
+            self.SetOutputPath(
+                "edep_per_run", get_distributed_context().get_process_path(str(path))
+            )
+        # the edep per time frame is also written by the C++ side
+        self.initialize_time_frames("edep_with_uncertainty", "edep_per_time_frame")
         # Set the flags on C++ side so the C++ knows which quantities need to be scored
         self.SetEdepSquaredFlag(
             self.user_output.edep_with_uncertainty.get_active(item=1)
         )
-        self.SetDoseFlag(self.user_output.dose_with_uncertainty.get_active(item=0))
+        # (with dose_mass='voxel', the dose is not scored on the C++ side)
+        score_dose = self.dose_mass == "step"
+        self.SetDoseFlag(
+            score_dose and self.user_output.dose_with_uncertainty.get_active(item=0)
+        )
         self.SetDoseSquaredFlag(
-            self.user_output.dose_with_uncertainty.get_active(item=1)
+            score_dose and self.user_output.dose_with_uncertainty.get_active(item=1)
         )
         # item=0 is the default
         self.SetCountsFlag(self.user_output.counts.get_active())
@@ -615,31 +923,53 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
         self.SetPhysicalVolumeName(self.get_physical_volume_name())
         self.InitializeCpp()
 
+    @property
+    def number_of_uncertainty_samples(self):
+        # the squared values are accumulated per event or per batch of events
+        if self.uncertainty_batch_size > 1:
+            return self.NbOfBatches
+        return self.NbOfEvent
+
     def BeginOfRunActionMasterThread(self, run_index):
+        # with scoring_mode='sparse', the cpp side allocates the dense images
+        # at the end of the run only
+        allocate = self.scoring_mode != "sparse"
         self.prepare_output_for_run("edep_with_uncertainty", run_index)
         self.push_to_cpp_image(
             "edep_with_uncertainty",
             run_index,
             self.cpp_edep_image,
             self.cpp_edep_squared_image,
+            allocate=allocate,
         )
 
-        if self.user_output.dose_with_uncertainty.get_active(item="any"):
+        if (
+            self.user_output.dose_with_uncertainty.get_active(item="any")
+            and self.dose_mass == "step"
+        ):
             self.prepare_output_for_run("dose_with_uncertainty", run_index)
             self.push_to_cpp_image(
                 "dose_with_uncertainty",
                 run_index,
                 self.cpp_dose_image,
                 self.cpp_dose_squared_image,
+                allocate=allocate,
             )
 
         if self.user_output.counts.get_active():
             self.prepare_output_for_run("counts", run_index)
-            self.push_to_cpp_image("counts", run_index, self.cpp_counts_image)
+            self.push_to_cpp_image(
+                "counts", run_index, self.cpp_counts_image, allocate=allocate
+            )
 
         g4.GateDoseActor.BeginOfRunActionMasterThread(self, run_index)
 
     def EndOfRunActionMasterThread(self, run_index):
+        # the pending evaluation of the uncertainty goal is joined, the
+        # active voxels are reset for the next run, and the dense images are
+        # created with scoring_mode='sparse' (before the fetch)
+        g4.GateDoseActor.EndOfRunActionMasterThread(self, run_index)
+        self.WriteEdepPerRun(run_index)
         self.fetch_from_cpp_image(
             "edep_with_uncertainty",
             run_index,
@@ -648,10 +978,15 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
         )
         self._update_output_coordinate_system("edep_with_uncertainty", run_index)
         self.user_output.edep_with_uncertainty.store_meta_data(
-            run_index, number_of_samples=self.NbOfEvent
+            run_index, number_of_samples=self.number_of_uncertainty_samples
         )
 
-        if self.user_output.dose_with_uncertainty.get_active(item="any"):
+        if (
+            self.user_output.dose_with_uncertainty.get_active(item="any")
+            and self.dose_mass == "voxel"
+        ):
+            self.store_dose_from_voxel_mass(run_index)
+        elif self.user_output.dose_with_uncertainty.get_active(item="any"):
             self.fetch_from_cpp_image(
                 "dose_with_uncertainty",
                 run_index,
@@ -660,7 +995,7 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
             )
             self._update_output_coordinate_system("dose_with_uncertainty", run_index)
             self.user_output.dose_with_uncertainty.store_meta_data(
-                run_index, number_of_samples=self.NbOfEvent
+                run_index, number_of_samples=self.number_of_uncertainty_samples
             )
             # divide by voxel volume and scale to unit Gy
             if self.user_output.dose_with_uncertainty.get_active(item=0):
@@ -694,12 +1029,44 @@ class DoseActor(VoxelDepositActor, g4.GateDoseActor):
                 run_index, number_of_samples=self.NbOfEvent
             )
 
+        # outputs of the derived actors, before the end of run of the outputs
+        self.store_additional_outputs(run_index)
+
         VoxelDepositActor.EndOfRunActionMasterThread(self, run_index)
 
         # FIXME: should check if uncertainty goal is reached (return value: 0),
         # but the current mechanism is quite hacky and it is therefore temporarily not in use!
         return 0
 
+    def store_additional_outputs(self, run_index):
+        """Store the outputs of the run computed by the derived actors (none here)."""
+        pass
+
+    def get_checkpoint_state(self):
+        if self.write_edep_per_run:
+            fatal(
+                f"The dose actor '{self.name}' cannot be saved in a checkpoint "
+                f"with write_edep_per_run (the 4D image is written by the C++ side)."
+            )
+        return VoxelDepositActor.get_checkpoint_state(self)
+
+    def get_snapshot(self, quantity="edep"):
+        """Last snapshot of the current run (see snapshot_event_interval), as a numpy
+        array (z, y, x). The edep is a view (no copy) updated by the next snapshots,
+        the dose is converted to Gy (copy). Call TakeSnapshot() to take one now.
+        """
+        if quantity == "edep":
+            return self.GetEdepSnapshot()
+        if quantity == "dose" and self.dose_mass == "voxel":
+            return self.GetEdepSnapshot() * self.get_inverse_voxel_mass() / g4_units.Gy
+        if quantity == "dose":
+            voxel_volume = self.spacing[0] * self.spacing[1] * self.spacing[2]
+            return self.GetDoseSnapshot() / (g4_units.Gy * voxel_volume)
+        fatal(
+            f"Unknown snapshot quantity '{quantity}' for actor '{self.name}', "
+            f"use 'edep' or 'dose'."
+        )
+
     def EndSimulationAction(self):
         g4.GateDoseActor.EndSimulationAction(self)
         VoxelDepositActor.EndSimulationAction(self)
@@ -711,6 +1078,7 @@ class TLEDoseActor(DoseActor, g4.GateTLEDoseActor):
     energy_min: float
     energy_max: float
     database: str
+    mu_table_cache_folder: str
 
     user_info_defaults = {
         "energy_min": (
@@ -726,8 +1094,17 @@ class TLEDoseActor(DoseActor, g4.GateTLEDoseActor):
         "database": (
             "EPDL",
             {
-                "doc": "which database to use",
-                "allowed_values": ("EPDL", "NIST"),  # "simulated" does not work
+                "doc": "Database of the mu/mu_en tables: 'EPDL' or 'NIST', or "
+                "'simulated' to compute them by sampling the photon processes of "
+                "the physics list for each material (slow, see "
+                "mu_table_cache_folder)",
+                "allowed_values": ("EPDL", "NIST", "simulated"),
+            },
+        ),
+        "mu_table_cache_folder": (
+            None,
+            {
+                "doc": "Folder where the mu/mu_en tables computed by sampling the photon processes ('simulated' database) are stored, one file per material, keyed by the material composition, the database, the energy range, the gamma cut and the physics. Later jobs with the same materials read them instead of simulating them again. None (default) disables the cache.",
             },
         ),
     }
@@ -742,6 +1119,7 @@ class TLEDoseActor(DoseActor, g4.GateTLEDoseActor):
                 "EndOfRunAction",
                 "BeginOfEventAction",
                 "SteppingAction",
+                "EndOfEventAction",
                 "PreUserTrackingAction",
             }
         )
@@ -754,6 +1132,193 @@ class TLEDoseActor(DoseActor, g4.GateTLEDoseActor):
         super().initialize(args)
 
 
+def _trapezoid_weights(times):
+    # weight of each time point in the integral of a piecewise linear function
+    dt = np.diff(np.asarray(times, dtype=float))
+    c = np.zeros(len(times))
+    c[:-1] += dt / 2
+    c[1:] += dt / 2
+    return c
+
+
+def create_time_integrated_activity_image(activity_images, activity_times):
+    """Time-integrated activity (number of decays per voxel) of a sequence of activity
+    images (in Bq) at the given times (with units), integrated with the trapezoid rule
+    between the first and the last time. Use it as the image of the VoxelSource of a
+    DoseRateActor. The geometry is the one of the first image."""
+    first = itk.imread(str(activity_images[0]))
+    arrays = np.stack(
+        [itk.array_view_from_image(itk.imread(str(f))) for f in activity_images]
+    ).astype(np.float64)
+    c = _trapezoid_weights(activity_times) / g4_units.s
+    image = itk.image_from_array(np.tensordot(c, arrays, axes=1).astype(np.float32))
+    image.CopyInformation(first)
+    return image
+
+
+class DoseRateActor(TLEDoseActor, g4.GateDoseRateActor):
+    """TLE dose actor that scores, in a single simulation, the dose rate at the times
+    of a sequence of activity images (e.g. SPECT at several time points) and the
+    time-integrated dose. The source must be a VoxelSource whose image is the
+    time-integrated activity (see create_time_integrated_activity_image). Each event
+    contributes to the dose rate at the time t_k with the weight A_k(v) / I(v) of its
+    source voxel v, applied when the dose is scored, so that the sequence is simulated
+    once instead of once per activity image."""
+
+    # hints for IDE
+    activity_images: list
+    activity_times: list
+    activity_translation: list
+
+    user_info_defaults = {
+        "activity_images": (
+            None,
+            {
+                "doc": "Filenames of the activity images (in Bq per voxel, same geometry), "
+                "one per time of activity_times.",
+            },
+        ),
+        "activity_times": (
+            None,
+            {
+                "doc": "Increasing times (with units) of the activity images. The activity is "
+                "linear between two times and zero outside the first and the last time.",
+            },
+        ),
+        "activity_translation": (
+            [0, 0, 0],
+            {
+                "doc": "Translation of the activity images in the volume the actor is "
+                "attached to, as the position.translation of the VoxelSource.",
+            },
+        ),
+    }
+
+    user_output_config = {
+        **DoseActor.user_output_config,
+        "dose_rate": {
+            "actor_output_class": ActorOutputSingleImage,
+        },
+        "integrated_dose": {
+            "actor_output_class": ActorOutputSingleImage,
+        },
+    }
+
+    def __initcpp__(self):
+        g4.GateDoseRateActor.__init__(self, self.user_info)
+        self.AddActions(
+            {
+                "BeginOfRunActionMasterThread",
+                "EndOfRunActionMasterThread",
+                "BeginOfRunAction",
+                "EndOfRunAction",
+                "BeginOfEventAction",
+                "SteppingAction",
+                "EndOfEventAction",
+                "PreUserTrackingAction",
+            }
+        )
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        # number of decays of the time-integrated activity (normalization)
+        self.number_of_decays = 0
+        self._time_weights = None
+
+    def initialize_frame_weights(self):
+        if self.activity_images is None or self.activity_times is None:
+            fatal(f"The actor '{self.name}' needs activity_images and activity_times.")
+        times = np.asarray(self.activity_times, dtype=float)
+        if len(times) < 2 or len(times) != len(self.activity_images):
+            fatal(
+                f"The actor '{self.name}' needs one time per activity image, and at "
+                f"least two images, while {len(self.activity_images)} images and "
+                f"{len(times)} times are given."
+            )
+        if np.any(np.diff(times) <= 0):
+            fatal(f"The activity_times of the actor '{self.name}' must be increasing.")
+        if get_distributed_context().is_distributed:
+            fatal(
+                f"The actor {self.name} cannot be used in a distributed simulation "
+                f"(the normalization needs the events of all the processes)"
+            )
+        first = itk.imread(str(self.activity_images[0]))
+        arrays = np.stack(
+            [
+                itk.array_view_from_image(itk.imread(str(f)))
+                for f in self.activity_images
+            ]
+        ).astype(np.float64)
+        # weights A_k(v) / I(v) in 1/s, (z, y, x, frame) for the cpp side
+        self._time_weights = _trapezoid_weights(times) / g4_units.s
+        integrated = np.tensordot(self._time_weights, arrays, axes=1)
+        self.number_of_decays = float(np.sum(integrated))
+        weights = np.divide(
+            arrays,
+            integrated,
+            out=np.zeros_like(arrays),
+            where=integrated > 0,
+        )
+        self.SetFrameWeights(
+            np.ascontiguousarray(np.moveaxis(weights, 0, -1)),
+            list(first.GetSpacing()),
+        )
+
+    def initialize(self, *args):
+        # the frames are computed from the dose of the steps
+        self.user_output.dose_with_uncertainty.set_active(True, item=0)
+        if self.dose_mass != "step":
+            fatal(f"The actor '{self.name}' only allows dose_mass='step'.")
+        self.initialize_frame_weights()
+        super().initialize(*args)
+
+    def StartSimulationAction(self):
+        TLEDoseActor.StartSimulationAction(self)
+        g4.GateDoseRateActor.StartSimulationAction(self)
+
+    def BeginOfRunActionMasterThread(self, run_index):
+        TLEDoseActor.BeginOfRunActionMasterThread(self, run_index)
+        self.PrepareFramesForRun()
+
+    def store_additional_outputs(self, run_index):
+        # dose of the frames of the run, per simulated event, in Gy/s
+        size = list(self.size)
+        voxel_volume = self.spacing[0] * self.spacing[1] * self.spacing[2]
+        frames = np.asarray(self.GetFrameDose()).reshape(
+            -1, size[2], size[1], size[0]
+        ) / (g4_units.Gy * voxel_volume)
+        dose = self.user_output.dose_with_uncertainty.get_data(run_index, item=0)
+        integrated = itk.image_from_array(
+            np.tensordot(self._time_weights, frames, axes=1).astype(np.float32)
+        )
+        integrated.CopyInformation(dose)
+        self.user_output.integrated_dose.store_data(run_index, integrated)
+        # as a 4D image: the 4th axis is the index of the activity image
+        image = itk.image_from_array(frames.astype(np.float32))
+        spacing = list(dose.GetSpacing()) + [1.0]
+        origin = list(dose.GetOrigin()) + [0.0]
+        direction = np.eye(4)
+        direction[:3, :3] = itk.array_from_matrix(dose.GetDirection())
+        image.SetSpacing(spacing)
+        image.SetOrigin(origin)
+        image.SetDirection(itk.matrix_from_array(direction))
+        self.user_output.dose_rate.store_data(run_index, image)
+        for name in ("dose_rate", "integrated_dose"):
+            self.user_output[name].store_meta_data(
+                run_index, number_of_samples=self.NbOfEvent
+            )
+
+    def EndSimulationAction(self):
+        # from the dose per simulated event to the dose of all the decays
+        n = self.GetNumberOfSimulatedEvents()
+        factor = self.number_of_decays / n if n > 0 else 0.0
+        for name in ("dose_rate", "integrated_dose"):
+            merged = self.user_output[name].merged_data
+            if merged is not None and merged.data[0] is not None:
+                merged.data[0] *= factor
+        TLEDoseActor.EndSimulationAction(self)
+
+
 def _setter_hook_score_in_let_actor(self, value):
     if value.lower() in ("g4_water", "g4water"):
         """Assuming a misspelling of G4_WATER and correcting it to correct spelling; Note that this is rather dangerous operation."""
@@ -762,12 +1327,67 @@ def _setter_hook_score_in_let_actor(self, value):
         return value
 
 
+class ActorOutputSparseMatrix(ActorOutputBase):
+    """Scipy sparse matrix scored by an actor (e.g. one row per voxel), written
+    in a npz file with scipy.sparse.save_npz."""
+
+    # hints for IDE
+    output_filename: str
+    write_to_disk: bool
+
+    user_info_defaults = {
+        "output_filename": (
+            "auto",
+            {
+                "doc": "Filename for the data represented by this actor output. "
+                "Relative paths and filenames are taken "
+                "relative to the global simulation output folder "
+                "set via the Simulation.output_dir option. ",
+            },
+        ),
+        "write_to_disk": (
+            True,
+            {
+                "doc": "Should the output be written to disk, or only kept in memory? ",
+            },
+        ),
+    }
+
+    default_suffix = "npz"
+
+    def store_data(self, data, **kwargs):
+        self.merged_data = data
+
+    def get_data(self, **kwargs):
+        return self.merged_data
+
+    def write_data(self, **kwargs):
+        scipy.sparse.save_npz(self.get_output_path(which="merged"), self.merged_data)
+
+    def write_data_if_requested(self, **kwargs):
+        if self.write_to_disk is True and self.merged_data is not None:
+            self.write_data(**kwargs)
+
+    # (the matrix is stored by the actor at the end of the simulation)
+    def start_of_simulation(self, **kwargs):
+        self.merged_data = None
+
+    def end_of_run(self, run_index):
+        pass
+
+    def end_of_simulation(self, **kwargs):
+        self.write_data_if_requested(**kwargs)
+
+
 class LETActor(VoxelDepositActor, g4.GateLETActor):
     """This actor scores the Linear Energy Transfer (LET) on a voxel grid in the volume to which the actor is attached. Note that the LET Actor puts a virtual grid on the volume it is attached to. Any changes on the LET Actor will not influence the geometry/material or physics of the particle tranpsort simulation."""
 
     # hints for IDE
     averaging_method: str
     score_in: str
+    spectrum_number_of_bins: int
+    spectrum_let_min: float
+    spectrum_let_max: float
 
     user_info_defaults = {
         "averaging_method": (
@@ -798,6 +1418,78 @@ class LETActor(VoxelDepositActor, g4.GateLETActor):
                 "deprecated": "Denominator and numerator images are automatically handled and stored. ",
             },
         ),
+        "stopping_power_table": (
+            True,
+            {
+                "doc": "The stopping powers are tabulated (log-energy grid, per particle and material, filled on the fly) "
+                "and interpolated, instead of being computed with the G4EmCalculator at each step. "
+                "Set to False to compute them at each step. ",
+            },
+        ),
+        "scoring_mode": (
+            "mutex",
+            {
+                "doc": "For advanced users: define how the threads accumulate the numerator and denominator images. "
+                "With 'mutex', all threads write in the same images, protected by a lock. "
+                "With 'thread_local', each thread fills its own copy of the numerator and denominator "
+                "(stored side by side for each voxel), which are summed at the end of the run. "
+                "With 'atomic', the lock is replaced by lock-free atomic additions. "
+                "With 'sparse', each thread fills its own sparse image(s) (tiles of 8x8x8 voxels allocated "
+                "when first hit), which are summed at the end of the run. "
+                "With 'queue', each thread keeps its deposits in a queue (see queue_size), which is sorted "
+                "by tile of 8x8x8 voxels and applied to the shared images with a single lock when full. ",
+                "allowed_values": ("mutex", "thread_local", "atomic", "sparse", "queue"),
+            },
+        ),
+        **_queue_size_user_info_defaults,
+        "buffer_precision": (
+            "double",
+            {
+                "doc": "For advanced users, with scoring_mode='thread_local' only: precision of the per-thread "
+                "copies of the images. With 'float', they need half of the memory, but each thread "
+                "accumulates its deposits with about 7 significant digits (counts are exact up to 2^24 "
+                "per voxel and per thread). The per-thread values are summed in the final images in double. "
+                "Cannot be used with snapshots. ",
+                "allowed_values": ("double", "float"),
+            },
+        ),
+        "snapshot_event_interval": (
+            0,
+            {
+                "doc": "During the run, copy the current numerator and denominator into a snapshot every given "
+                "number of events, while the threads keep on scoring. The snapshot LET can be read from python "
+                "with get_snapshot(). 0 (default) means no snapshot. Cannot be used with scoring_mode='sparse'. ",
+            },
+        ),
+        "snapshot_time_interval": (
+            0,
+            {
+                "doc": "Same as snapshot_event_interval, with an interval in seconds of wall clock time. "
+                "0 (default) means no snapshot. ",
+            },
+        ),
+        "spectrum_number_of_bins": (
+            0,
+            {
+                "doc": "Also score the LET spectrum of each voxel (output 'let_spectrum'), with this number of "
+                "bins of constant width in log(LET) between spectrum_let_min and spectrum_let_max. "
+                "The LET outside this range are counted in the first or last bin. The spectrum is weighted "
+                "like the mean LET: by the edep with averaging_method='dose_average' (d(L), in MeV), by the "
+                "track length with 'track_average' (t(L), in mm). 0 (default) means no spectrum. ",
+            },
+        ),
+        "spectrum_let_min": (
+            0.1 * g4_units.keV / g4_units.um,
+            {
+                "doc": "Lower edge of the first bin of the LET spectrum. ",
+            },
+        ),
+        "spectrum_let_max": (
+            1000 * g4_units.keV / g4_units.um,
+            {
+                "doc": "Upper edge of the last bin of the LET spectrum. ",
+            },
+        ),
     }
 
     user_output_config = {
@@ -825,6 +1517,9 @@ class LETActor(VoxelDepositActor, g4.GateLETActor):
                 },
             },
         },
+        "let_spectrum": {
+            "actor_output_class": ActorOutputSparseMatrix,
+        },
     }
 
     def __init__(self, *args, **kwargs):
@@ -851,6 +1546,8 @@ class LETActor(VoxelDepositActor, g4.GateLETActor):
         VoxelDepositActor.initialize(self)
 
         self.check_user_input()
+        self.check_snapshot_options()
+        self.check_buffer_precision_options()
 
         self.InitializeUserInfo(self.user_info)
         # Set the physical volume name on the C++ side
@@ -862,12 +1559,19 @@ class LETActor(VoxelDepositActor, g4.GateLETActor):
         # self.prepare_output_for_run("let_numerator", run_index)
         # self.prepare_output_for_run("let_denominator", run_index)
 
+        # with scoring_mode='sparse', the cpp side allocates the dense images
+        # at the end of the run only
         self.push_to_cpp_image(
-            "let", run_index, self.cpp_numerator_image, self.cpp_denominator_image
+            "let",
+            run_index,
+            self.cpp_numerator_image,
+            self.cpp_denominator_image,
+            allocate=self.scoring_mode != "sparse",
         )
         g4.GateLETActor.BeginOfRunActionMasterThread(self, run_index)
 
     def EndOfRunActionMasterThread(self, run_index):
+        g4.GateLETActor.EndOfRunActionMasterThread(self, run_index)
         self.fetch_from_cpp_image(
             "let", run_index, self.cpp_numerator_image, self.cpp_denominator_image
         )
@@ -879,8 +1583,46 @@ class LETActor(VoxelDepositActor, g4.GateLETActor):
         VoxelDepositActor.EndOfRunActionMasterThread(self, run_index)
         return 0
 
+    def get_snapshot(self):
+        """LET of the last snapshot of the current run (see snapshot_event_interval),
+        as a numpy array (z, y, x), 0 where the denominator is 0.
+        """
+        num = self.GetNumeratorSnapshot()
+        den = self.GetDenominatorSnapshot()
+        return np.divide(num, den, out=np.zeros_like(num), where=den != 0)
+
+    def get_checkpoint_state(self):
+        # the spectra are accumulated on the C++ side over all runs
+        if self.spectrum_number_of_bins > 0:
+            fatal(
+                f"The LET actor '{self.name}' cannot be saved in a checkpoint "
+                f"with spectrum_number_of_bins > 0."
+            )
+        return {"let": get_output_checkpoint_state(self.user_output.let)}
+
+    def get_spectrum_bin_edges(self):
+        """Edges of the bins of the LET spectrum (spectrum_number_of_bins + 1 values)."""
+        return np.geomspace(
+            self.spectrum_let_min,
+            self.spectrum_let_max,
+            self.spectrum_number_of_bins + 1,
+        )
+
+    def get_spectrum(self):
+        """LET spectra scored so far, as a scipy CSR sparse matrix with one row per
+        voxel (flat index, x fastest, i.e. the order of the numpy array (z, y, x) of
+        the output 'let') and one column per bin (see get_spectrum_bin_edges).
+        """
+        voxels, bins, values = self.GetSpectrum()
+        return scipy.sparse.csr_matrix(
+            (values, (voxels, bins)),
+            shape=(int(np.prod(self.size)), self.spectrum_number_of_bins),
+        )
+
     def EndSimulationAction(self):
         g4.GateLETActor.EndSimulationAction(self)
+        if self.spectrum_number_of_bins > 0:
+            self.user_output.let_spectrum.store_data(self.get_spectrum())
         VoxelDepositActor.EndSimulationAction(self)
 
 
@@ -897,7 +1639,18 @@ class ProductionAndStoppingActor(VoxelDepositActor, g4.GateProductionAndStopping
                 "doc": "Want to score production or stopping of particles?",
                 "allowed_values": ("production", "stopping"),
             },
-        )
+        ),
+        "scoring_mode": (
+            "mutex",
+            {
+                "doc": "For advanced users: define how the threads accumulate the counts. "
+                "With 'mutex', all threads write in the same image, protected by a lock. "
+                "With 'thread_local', each thread fills its own copy of the image, "
+                "which are summed at the end of the run. "
+                "With 'atomic', the lock is replaced by lock-free atomic additions. ",
+                "allowed_values": ("mutex", "thread_local", "atomic"),
+            },
+        ),
     }
 
     user_output_config = {
@@ -967,6 +1720,7 @@ class FluenceActor(VoxelDepositActor, g4.GateFluenceActor):
     # hints for IDE
     uncertainty: bool
     scatter: bool
+    energy_bins: list
 
     user_info_defaults = {
         "uncertainty": (
@@ -981,12 +1735,55 @@ class FluenceActor(VoxelDepositActor, g4.GateFluenceActor):
                 "doc": "FIXME",
             },
         ),
+        "scoring_mode": (
+            "mutex",
+            {
+                "doc": "For advanced users: define how the threads accumulate the fluence image. "
+                "With 'mutex', all threads write in the same image, protected by a lock. "
+                "With 'atomic', the lock is replaced by lock-free atomic additions. "
+                "With 'sparse', each thread fills its own sparse image(s) (tiles of 8x8x8 voxels allocated "
+                "when first hit), which are summed at the end of the run. "
+                "With 'queue', each thread keeps its deposits in a queue (see queue_size), which is sorted "
+                "by tile of 8x8x8 voxels and applied to the shared image with a single lock when full. ",
+                "allowed_values": ("mutex", "atomic", "sparse", "queue"),
+            },
+        ),
+        **_queue_size_user_info_defaults,
+        "energy_bins": (
+            None,
+            {
+                "doc": "Edges (N+1 strictly increasing energies) of the N energy bins of the spectral fluence. "
+                "If set, the output 'fluence_spectrum' is a 4D image (the 4th axis is the energy bin) "
+                "scored together with the integral fluence, using the kinetic energy at the pre-step point. "
+                "Log-uniform edges (e.g. np.geomspace) are the fastest. None (default): integral fluence only. ",
+            },
+        ),
+        "snapshot_event_interval": (
+            0,
+            {
+                "doc": "During the run, copy the current fluence into a snapshot every given number of events, "
+                "while the threads keep on scoring. The snapshot can be read from python with get_snapshot(). "
+                "0 (default) means no snapshot. Cannot be used with scoring_mode='sparse'. ",
+            },
+        ),
+        "snapshot_time_interval": (
+            0,
+            {
+                "doc": "Same as snapshot_event_interval, with an interval in seconds of wall clock time. "
+                "0 (default) means no snapshot. ",
+            },
+        ),
+        **_time_frame_user_info_defaults,
     }
 
     user_output_config = {
         "fluence": {
             "actor_output_class": ActorOutputSingleImage,
         },
+        "fluence_spectrum": {
+            "actor_output_class": ActorOutputSingleImage,
+            "active": False,
+        },
     }
 
     def __init__(self, *args, **kwargs):
@@ -1012,33 +1809,422 @@ class FluenceActor(VoxelDepositActor, g4.GateFluenceActor):
         if self.uncertainty or self.scatter:
             fatal("FluenceActor : uncertainty and scatter not implemented yet")
 
+        if self.energy_bins is not None:
+            self.energy_bins = [float(e) for e in self.energy_bins]
+            if len(self.energy_bins) < 2 or np.any(np.diff(self.energy_bins) <= 0):
+                fatal(
+                    f"The fluence actor '{self.name}' needs at least two strictly "
+                    f"increasing energy_bins edges, while {self.energy_bins} is given."
+                )
+            self.user_output.fluence_spectrum.set_active(True)
+
+        self.check_snapshot_options()
+
         self.InitializeUserInfo(self.user_info)
+        # the fluence per time frame is written by the C++ side
+        self.initialize_time_frames("fluence", "fluence_per_time_frame")
         # Set the physical volume name on the C++ side
         self.SetPhysicalVolumeName(self.get_physical_volume_name())
         self.InitializeCpp()
 
     def BeginOfRunActionMasterThread(self, run_index):
         self.prepare_output_for_run("fluence", run_index)
-        self.push_to_cpp_image("fluence", run_index, self.cpp_fluence_image)
+        # with scoring_mode='sparse', the cpp side allocates the dense image
+        # at the end of the run only
+        self.push_to_cpp_image(
+            "fluence",
+            run_index,
+            self.cpp_fluence_image,
+            allocate=self.scoring_mode != "sparse",
+        )
         g4.GateFluenceActor.BeginOfRunActionMasterThread(self, run_index)
 
     def EndOfRunActionMasterThread(self, run_index):
+        g4.GateFluenceActor.EndOfRunActionMasterThread(self, run_index)
         self.fetch_from_cpp_image("fluence", run_index, self.cpp_fluence_image)
+        if self.hit_type == "segment":
+            # track length estimator: sum of the track lengths / voxel volume
+            self.user_output.fluence.data_per_run[run_index].data[0] /= (
+                self.spacing[0] * self.spacing[1] * self.spacing[2]
+            )
         self._update_output_coordinate_system("fluence", run_index)
         self.user_output.fluence.store_meta_data(
             run_index, number_of_samples=self.NbOfEvent
         )
+        if self.energy_bins is not None:
+            self.fetch_spectral_fluence(run_index)
         VoxelDepositActor.EndOfRunActionMasterThread(self, run_index)
         return 0
 
+    def fetch_spectral_fluence(self, run_index):
+        # (voxels, bins) array with the voxels in the itk order (x fastest)
+        size = list(self.size)
+        spectrum = np.asarray(self.GetSpectralFluence())
+        self.ClearSpectralFluence()
+        spectrum = spectrum.reshape(size[2], size[1], size[0], -1)
+        # as a 4D image: the energy bin is the 4th (slowest) axis
+        arr = np.ascontiguousarray(np.moveaxis(spectrum, -1, 0), dtype=np.float32)
+        if self.hit_type == "segment":
+            arr /= self.spacing[0] * self.spacing[1] * self.spacing[2]
+        image = itk.image_from_array(arr)
+        # same geometry as the fluence image, unit spacing along the bins
+        fluence = self.user_output.fluence.get_data(run_index)
+        spacing = list(fluence.GetSpacing()) + [1.0]
+        origin = list(fluence.GetOrigin()) + [0.0]
+        direction = np.eye(4)
+        direction[:3, :3] = itk.array_from_matrix(fluence.GetDirection())
+        image.SetSpacing(spacing)
+        image.SetOrigin(origin)
+        image.SetDirection(itk.matrix_from_array(direction))
+        self.user_output.fluence_spectrum.store_data(run_index, image)
+        self.user_output.fluence_spectrum.store_meta_data(
+            run_index, number_of_samples=self.NbOfEvent
+        )
+
+    def get_snapshot(self):
+        """Fluence of the last snapshot of the current run (see snapshot_event_interval),
+        as a numpy array (z, y, x). This is a view (no copy) updated by the next snapshots,
+        except with hit_type 'segment' (divided by the voxel volume).
+        """
+        snapshot = self.GetFluenceSnapshot()
+        if self.hit_type == "segment":
+            return snapshot / (self.spacing[0] * self.spacing[1] * self.spacing[2])
+        return snapshot
+
     def EndSimulationAction(self):
         g4.GateFluenceActor.EndSimulationAction(self)
         VoxelDepositActor.EndSimulationAction(self)
 
 
+class ActorOutputBeamletMatrix(ActorOutputSparseMatrix):
+    """Dose influence matrix of the BeamletDoseActor (scipy sparse matrix,
+    written in a npz file with scipy.sparse.save_npz)."""
+
+
+class BeamletDoseActor(VoxelDepositActor, g4.GateBeamletDoseActor):
+    """
+    Dose influence matrix for the optimization of treatment plans: the dose (or edep)
+    of each spot of a TreatmentPlanPBSource in each voxel, scored in a single simulation.
+
+    The output 'beamlet_matrix' is a scipy sparse matrix (CSR) with one row per voxel
+    and one column per spot. The row of a voxel is its flat index in the image
+    (x fastest, i.e. the order of the numpy array (z, y, x) of the output 'dose').
+    The output 'dose' is the sum over all spots. The events that do not come from
+    a TreatmentPlanPBSource are not scored.
+    """
+
+    # hints for IDE
+    quantity: str
+    number_of_spots: int
+
+    user_info_defaults = {
+        "quantity": (
+            "dose",
+            {
+                "doc": "Scored quantity: 'dose' (in Gy, in the material of the step) or 'edep' (in MeV). ",
+                "allowed_values": ("dose", "edep"),
+            },
+        ),
+        "number_of_spots": (
+            None,
+            {
+                "doc": "Number of columns of the matrix, i.e. the number of spots of the plan. "
+                "None (default): the largest spot index that deposited something, plus one. ",
+            },
+        ),
+    }
+
+    user_output_config = {
+        "dose": {
+            "actor_output_class": ActorOutputSingleImage,
+        },
+        "beamlet_matrix": {
+            "actor_output_class": ActorOutputBeamletMatrix,
+        },
+    }
+
+    def __init__(self, *args, **kwargs):
+        VoxelDepositActor.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateBeamletDoseActor.__init__(self, self.user_info)
+        self.AddActions(
+            {
+                "StartSimulationAction",
+                "EndSimulationAction",
+                "BeginOfRunActionMasterThread",
+                "EndOfRunActionMasterThread",
+                "EndOfRunAction",
+                "BeginOfEventAction",
+                "SteppingAction",
+            }
+        )
+
+    def initialize(self):
+        VoxelDepositActor.initialize(self)
+        self.check_user_input()
+        self.InitializeUserInfo(self.user_info)
+        # Set the physical volume name on the C++ side
+        self.SetPhysicalVolumeName(self.get_physical_volume_name())
+        self.InitializeCpp()
+
+    def _unit(self):
+        # the cpp side scores the dose in G4 units (edep / mass)
+        return g4_units.Gy if self.quantity == "dose" else 1.0
+
+    def StartSimulationAction(self):
+        g4.GateBeamletDoseActor.StartSimulationAction(self)
+        self.user_output.dose.start_of_simulation()
+
+    def BeginOfRunActionMasterThread(self, run_index):
+        self.prepare_output_for_run("dose", run_index)
+        self.push_to_cpp_image("dose", run_index, self.cpp_dose_image)
+        g4.GateBeamletDoseActor.BeginOfRunActionMasterThread(self, run_index)
+
+    def EndOfRunActionMasterThread(self, run_index):
+        self.fetch_from_cpp_image("dose", run_index, self.cpp_dose_image)
+        self._update_output_coordinate_system("dose", run_index)
+        self.user_output.dose.data_per_run[run_index].data[0] /= self._unit()
+        self.user_output.dose.store_meta_data(run_index)
+        self.user_output.dose.end_of_run(run_index)
+        return 0
+
+    def get_matrix(self):
+        """The (voxel, spot) matrix scored so far, as a scipy CSR sparse matrix."""
+        voxels, spots, values = self.GetMatrix()
+        number_of_voxels = int(np.prod(self.size))
+        number_of_spots = self.number_of_spots
+        if number_of_spots is None:
+            number_of_spots = int(spots.max()) + 1 if len(spots) > 0 else 0
+        return scipy.sparse.csr_matrix(
+            (values / self._unit(), (voxels, spots)),
+            shape=(number_of_voxels, number_of_spots),
+        )
+
+    def EndSimulationAction(self):
+        self.user_output.beamlet_matrix.store_data(self.get_matrix())
+        self.user_output.beamlet_matrix.write_data_if_requested()
+        self.user_output.dose.end_of_simulation()
+
+
+class ActorOutputROIDose(ActorOutputBase):
+    """Statistics per ROI of the ROIDoseActor (one dict per ROI), written in a
+    json file."""
+
+    # hints for IDE
+    output_filename: str
+    write_to_disk: bool
+
+    user_info_defaults = {
+        "output_filename": (
+            "auto",
+            {
+                "doc": "Filename for the data represented by this actor output. "
+                "Relative paths and filenames are taken "
+                "relative to the global simulation output folder "
+                "set via the Simulation.output_dir option. ",
+            },
+        ),
+        "write_to_disk": (
+            True,
+            {
+                "doc": "Should the output be written to disk, or only kept in memory? ",
+            },
+        ),
+    }
+
+    default_suffix = "json"
+
+    def store_data(self, data, **kwargs):
+        self.merged_data = data
+
+    def get_data(self, **kwargs):
+        return self.merged_data
+
+    def write_data(self, **kwargs):
+        with open(self.get_output_path(which="merged"), "w") as f:
+            json.dump(self.merged_data, f, indent=4)
+
+    def write_data_if_requested(self, **kwargs):
+        if self.write_to_disk is True and self.merged_data is not None:
+            self.write_data(**kwargs)
+
+
+class ROIDoseActor(ActorBase, g4.GateROIDoseActor):
+    """
+    Dose statistics per region of interest (ROI, e.g. organs) without dose image:
+    mean dose, relative uncertainty (history by history) and, optionally, a
+    differential dose volume histogram (DVH) per ROI.
+
+    The ROIs are the labels of a label image, placed like the image of a DoseActor
+    (centered on the attached volume, plus the translation). The dose of a ROI is
+    the mean of the dose of its voxels, in Gy.
+    """
+
+    # hints for IDE
+    image: str
+    labels: list
+    roi_names: list
+    translation: list
+    repeated_volume_index: int
+    hit_type: str
+    dvh_bins: int
+    dvh_max_dose: float
+
+    user_info_defaults = {
+        "image": (
+            None,
+            {
+                "doc": "Filename of the label image: each ROI is the set of the voxels "
+                "with a given label. ",
+            },
+        ),
+        "labels": (
+            None,
+            {
+                "doc": "Labels of the ROIs. None (default): all the non-zero labels of "
+                "the image, in increasing order. ",
+            },
+        ),
+        "roi_names": (
+            None,
+            {
+                "doc": "Names of the ROIs in the output, one per label. None (default): "
+                "the labels. ",
+            },
+        ),
+        "translation": (
+            [0 * g4_units.mm, 0 * g4_units.mm, 0 * g4_units.mm],
+            {
+                "doc": "Translation of the label image from the center of the attached volume. ",
+            },
+        ),
+        "repeated_volume_index": (
+            0,
+            {
+                "doc": "Index of the repeated volume (G4PhysicalVolume) to which this actor is attached. "
+                "For non-repeated volumes, this value is always 0. ",
+            },
+        ),
+        "hit_type": (
+            "random",
+            {
+                "doc": "Position of the step used to find the voxel of the deposit, "
+                "see the DoseActor. ",
+                "allowed_values": ("random", "pre", "post", "middle"),
+            },
+        ),
+        "dvh_bins": (
+            0,
+            {
+                "doc": "Number of dose bins of the DVH (0: no DVH). The DVH needs one "
+                "value per voxel of the ROIs and per thread. ",
+            },
+        ),
+        "dvh_max_dose": (
+            0,
+            {
+                "doc": "Upper limit of the DVH bins, with units (0: maximum voxel dose). "
+                "The voxels above the limit are counted in the last bin. ",
+            },
+        ),
+    }
+
+    user_output_config = {
+        "roi_dose": {
+            "actor_output_class": ActorOutputROIDose,
+        },
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateROIDoseActor.__init__(self, self.user_info)
+        self.AddActions(
+            {
+                "StartSimulationAction",
+                "EndSimulationAction",
+                "BeginOfRunActionMasterThread",
+                "EndOfRunActionMasterThread",
+                "BeginOfRunAction",
+                "EndOfRunAction",
+                "BeginOfEventAction",
+                "SteppingAction",
+            }
+        )
+
+    def initialize_rois(self):
+        if self.image is None:
+            fatal(f"The actor '{self.name}' needs a label image (image option).")
+        image = itk.imread(str(self.image))
+        labels_array = itk.array_view_from_image(image)
+        if self.labels is None:
+            self.labels = [int(v) for v in np.unique(labels_array) if v != 0]
+        if self.roi_names is None:
+            self.roi_names = [str(v) for v in self.labels]
+        if len(self.roi_names) != len(self.labels):
+            fatal(
+                f"The actor '{self.name}' has {len(self.labels)} labels but "
+                f"{len(self.roi_names)} roi_names."
+            )
+        # voxel -> ROI table (-1: no ROI), built once on the cpp side
+        rois = np.full(labels_array.shape, -1, dtype=np.int32)
+        for i, label in enumerate(self.labels):
+            rois[labels_array == label] = i
+        self.SetVoxelROIs(rois, len(self.labels), list(image.GetSpacing()))
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        self.initialize_rois()
+        self.InitializeUserInfo(self.user_info)
+        self.SetPhysicalVolumeName(VoxelDepositActor.get_physical_volume_name(self))
+        self.InitializeCpp()
+
+    def get_roi_statistics(self):
+        """One dict per ROI: name, label, number of voxels, edep (MeV), mean dose and
+        relative uncertainty, and the DVH if requested (number of voxels per dose
+        bin, upper limits of the bins in Gy)."""
+        edep = self.GetROIEdep()
+        dose = self.GetROIDose()
+        uncertainty = self.GetROIDoseUncertainty()
+        dvh = self.GetDVH()
+        rois = []
+        for i, (name, label) in enumerate(zip(self.roi_names, self.labels)):
+            roi = {
+                "name": name,
+                "label": int(label),
+                "number_of_voxels": self.GetNumberOfROIVoxels(i),
+                "edep": edep[i] / g4_units.MeV,
+                "dose": dose[i],
+                "uncertainty": uncertainty[i],
+            }
+            if len(dvh) > 0:
+                m = self.GetDVHMaxDose()
+                roi["dvh_dose"] = list(np.linspace(0, m, self.dvh_bins + 1)[1:])
+                roi["dvh_voxels"] = [int(v) for v in dvh[i]]
+            rois.append(roi)
+        return rois
+
+    def StartSimulationAction(self):
+        g4.GateROIDoseActor.StartSimulationAction(self)
+
+    def EndSimulationAction(self):
+        self.user_output.roi_dose.store_data(self.get_roi_statistics())
+        self.user_output.roi_dose.write_data_if_requested()
+
+
 process_cls(VoxelDepositActor)
 process_cls(DoseActor)
 process_cls(TLEDoseActor)
+process_cls(DoseRateActor)
+process_cls(ActorOutputSparseMatrix)
 process_cls(LETActor)
 process_cls(FluenceActor)
 process_cls(ProductionAndStoppingActor)
+process_cls(ActorOutputBeamletMatrix)
+process_cls(BeamletDoseActor)
+process_cls(ActorOutputROIDose)
+process_cls(ROIDoseActor)
@@ -9,24 +9,42 @@ from .base import ActorBase
 from ..decorators import requires_fatal
 
 
-class DynamicGeometryActor(ActorBase, g4.GateVActor):
+class DynamicGeometryActor(ActorBase, g4.GateDynamicGeometryActor):
+    """
+    Apply the geometry changers before each run. The translations and rotations
+    of all the runs are stored in a C++ motion table and applied by the C++ actor
+    (opening and closing the geometry only for the moving volumes); only the
+    other changers (e.g. images) are applied by Python, in ApplyPythonChanges.
+    With sub-runs (option dynamic_sub_runs), the table is used by the source
+    manager during the single run.
+    """
 
     def __init__(self, *args, **kwargs):
         kwargs["attached_to"] = __world_name__
         ActorBase.__init__(self, *args, **kwargs)
         self.geometry_changers = []
+        self.python_changers = []
+        self.g4_motion_table = None
         self.__initcpp__()
 
     def __initcpp__(self):
-        g4.GateVActor.__init__(self, {"name": self.name})
+        g4.GateDynamicGeometryActor.__init__(self, {"name": self.name})
         self.AddActions({"BeginOfRunActionMasterThread"})
 
     def close(self):
         for c in self.geometry_changers:
             c.close()
         self.geometry_changers = []
+        self.python_changers = []
+        self.g4_motion_table = None
         super().close()
 
+    def __getstate__(self):
+        return_dict = super().__getstate__()
+        return_dict["python_changers"] = []
+        return_dict["g4_motion_table"] = None
+        return return_dict
+
     def to_dictionary(self):
         return_dict = super().to_dictionary()
         return_dict["geometry_changers"] = dict(
@@ -40,14 +58,46 @@ class DynamicGeometryActor(ActorBase, g4.GateVActor):
             if c.volume_manager is None:
                 c.volume_manager = self.simulation.volume_manager
             c.initialize()
+        self.initialize_motion_table()
+
+    def initialize_motion_table(self):
+        # one step per run (or per sub-run)
+        self.g4_motion_table = g4.GateMotionTable()
+        self.g4_motion_table.SetStepTimes(
+            [i[0] for i in self.simulation.run_timing_intervals]
+        )
+        self.g4_motion_table.SetGeometryOpenClose(
+            self.simulation.dyn_geom_open_close, self.simulation.dyn_geom_optimise
+        )
+        self.python_changers = [
+            c
+            for c in self.geometry_changers
+            if not c.add_to_motion_table(self.g4_motion_table)
+        ]
+        if self.simulation.dynamic_sub_runs:
+            if len(self.python_changers) > 0:
+                fatal(
+                    f"The geometry changers {[c.name for c in self.python_changers]} "
+                    f"cannot be used with the option dynamic_sub_runs: only "
+                    f"translations and rotations are allowed."
+                )
+            # the volumes are moved by the source manager during the run
+            source_engine = self.actor_engine.simulation_engine.source_engine
+            source_engine.g4_master_source_manager.SetMotionTable(
+                self.g4_motion_table
+            )
+        else:
+            self.SetMotionTable(self.g4_motion_table)
+        self.SetPythonChangesFlag(len(self.python_changers) > 0)
 
-    def BeginOfRunActionMasterThread(self, run_id):
+    def ApplyPythonChanges(self, run_id):
         if self.simulation.dyn_geom_open_close:
             gm = g4.G4GeometryManager.GetInstance()
             # OpenGeometry (G4VPhysicalVolume *vol=0)
             gm.OpenGeometry(None)
-        for c in self.geometry_changers:
+        for c in self.python_changers:
             c.apply_change(run_id)
+        g4.InvalidateVolumeTransformCache()
         if self.simulation.dyn_geom_open_close:
             # CloseGeometry: pOptimise=true, verbose=false, G4VPhysicalVolume *vol=0
             gm.CloseGeometry(self.simulation.dyn_geom_optimise, False, None)
@@ -135,6 +185,10 @@ class GeometryChanger(GateObject):
             f"but it is only available in classes inheriting from it. "
         )
 
+    def add_to_motion_table(self, motion_table):
+        # return False if the change must be applied by apply_change (Python)
+        return False
+
 
 class VolumeImageChanger(GeometryChanger):
 
@@ -213,6 +267,13 @@ class VolumeTranslationChanger(GeometryChanger):
     def apply_change(self, run_id):
         self.g4_physical_volume.SetTranslation(self.g4_translations[run_id])
 
+    def add_to_motion_table(self, motion_table):
+        # (a changer with its own apply_change is applied by Python)
+        if type(self).apply_change is not VolumeTranslationChanger.apply_change:
+            return False
+        motion_table.AddTranslations(self.g4_physical_volume, self.g4_translations)
+        return True
+
 
 class VolumeRotationChanger(GeometryChanger):
 
@@ -266,6 +327,15 @@ class VolumeRotationChanger(GeometryChanger):
     def apply_change(self, run_id):
         self.g4_physical_volume.SetRotationHepRep3x3(self.g4_rotations[run_id])
 
+    def add_to_motion_table(self, motion_table):
+        if type(self).apply_change is not VolumeRotationChanger.apply_change:
+            return False
+        # (the table keeps the inverse, as SetRotationHepRep3x3)
+        motion_table.AddRotations(
+            self.g4_physical_volume, [rot_np_as_g4(r) for r in self.rotations]
+        )
+        return True
+
 
 process_cls(DynamicGeometryActor)
 process_cls(GeometryChanger)
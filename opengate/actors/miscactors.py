@@ -1,17 +1,22 @@
+from typing import List
 from box import Box
 import platform
+import numpy as np
 import opengate_core as g4
 from .base import ActorBase
-from ..utility import g4_units, g4_best_unit_tuple
+from ..utility import g4_units, g4_best_unit, g4_best_unit_tuple
 from .actoroutput import ActorOutputBase, ActorOutputSingleImage
 from ..serialization import dump_json
 from ..exception import fatal, warning
 from ..base import process_cls
+from ..distributed import get_distributed_context
+from ..physics import cut_particle_names
 
 """
     It is feasible to get callback every Run, Event, Track, Step in the python side.
     However, it is VERY time consuming. For SteppingAction, expect large performance drop.
     It could be however useful for prototyping or tests.
+    For prototyping, prefer the StepBatchActor: one callback per batch of steps.
 
     it requires "trampoline functions" on the cpp side.
 
@@ -31,6 +36,10 @@ def _setter_hook_stats_actor_output_filename(self, output_filename):
     return output_filename
 
 
+def _mb(nbytes):
+    return f"{nbytes / 1024**2:.2f} MB"
+
+
 class ActorOutputStatisticsActor(ActorOutputBase):
     """This is a hand-crafted ActorOutput specifically for the SimulationStatisticsActor."""
 
@@ -88,6 +97,11 @@ class ActorOutputStatisticsActor(ActorOutputBase):
         self.merged_data.init = 0
         self.merged_data.track_types = {}
         self.merged_data.nb_threads = 1
+        self.merged_data.profile = {}
+        self.merged_data.step_types = {}
+        self.merged_data.memory = {}
+        self.merged_data.perf_counters = {}
+        self.merged_data.root_output = {}
 
     @property
     def pps(self):
@@ -170,6 +184,16 @@ class ActorOutputStatisticsActor(ActorOutputBase):
         d["arch"] = {"value": platform.system(), "unit": None}
         d["python"] = {"value": platform.python_version(), "unit": None}
         d["track_types"] = {"value": self.merged_data.track_types, "unit": None}
+        if len(self.merged_data.profile) > 0:
+            d["profile"] = {"value": self.merged_data.profile, "unit": "ns"}
+        if len(self.merged_data.step_types) > 0:
+            d["step_types"] = {"value": self.merged_data.step_types, "unit": "ns"}
+        if len(self.merged_data.memory) > 0:
+            d["memory"] = {"value": self.merged_data.memory, "unit": "bytes"}
+        if len(self.merged_data.perf_counters) > 0:
+            d["perf_counters"] = {"value": self.merged_data.perf_counters, "unit": None}
+        if len(self.merged_data.root_output) > 0:
+            d["root_output"] = {"value": self.merged_data.root_output, "unit": None}
         return d
 
     def __str__(self):
@@ -180,6 +204,44 @@ class ActorOutputStatisticsActor(ActorOutputBase):
                     s += "track_types\n"
                     for t, n in v["value"].items():
                         s += f"{' ' * 24}{t}: {n}\n"
+            elif k == "profile":
+                s += "profile (time per call)\n"
+                for name, callbacks in v["value"].items():
+                    for c, p in callbacks.items():
+                        t = g4_best_unit(p["time_per_call"], "Time")
+                        s += f"{' ' * 24}{name} {c}: {p['calls']} calls, {t}\n"
+            elif k == "step_types":
+                s += "step_types\n"
+                for volume, particles in v["value"].items():
+                    for particle, processes in particles.items():
+                        for process, c in processes.items():
+                            s += f"{' ' * 24}{volume} {particle} {process}: "
+                            s += f"{c['steps']} steps"
+                            if c["sampled_steps"] > 0:
+                                s += f", {g4_best_unit(c['time'], 'Time')}"
+                            s += "\n"
+            elif k == "memory":
+                s += "memory (current, peak)\n"
+                for t, components in v["value"].items():
+                    for name, m in components.items():
+                        s += f"{' ' * 24}{t} {name}: {_mb(m['current'])}, "
+                        s += f"{_mb(m['peak'])} ({len(m['threads'])} threads)\n"
+            elif k == "perf_counters":
+                s += "perf_counters (ipc, cache misses, branch misses, bandwidth)\n"
+                for phase, threads in v["value"].items():
+                    for t, c in threads.items():
+                        s += f"{' ' * 24}{phase} thread {t}: {c['ipc']:.2f}, "
+                        s += f"{c['cache_misses']}, {c['branch_misses']}, "
+                        s += f"{_mb(c['bandwidth'])}/s\n"
+            elif k == "root_output":
+                s += "root_output (basket size, entries, compression)\n"
+                for filename, o in v["value"].items():
+                    options = [
+                        o[n] if o[n] >= 0 else "default"
+                        for n in ("basket_size", "basket_entries", "compression_level")
+                    ]
+                    s += f"{' ' * 24}{filename}: {options[0]}, {options[1]}, "
+                    s += f"{o['compression']} {options[2]}\n"
             else:
                 if v["unit"] is None:
                     unit = ""
@@ -207,6 +269,12 @@ class SimulationStatisticsActor(ActorBase, g4.GateSimulationStatisticsActor):
 
     # hints for IDE
     track_types_flag: bool
+    profile_actors: bool
+    profile_sampling_interval: int
+    step_types_flag: bool
+    step_types_time_sampling: int
+    memory_flag: bool
+    perf_counters_flag: bool
 
     user_info_defaults = {
         "track_types_flag": (
@@ -215,6 +283,62 @@ class SimulationStatisticsActor(ActorBase, g4.GateSimulationStatisticsActor):
                 "doc": "Should the type of tracks be counted?",
             },
         ),
+        "profile_actors": (
+            False,
+            {
+                "doc": "Measure the time spent in the callbacks of each actor "
+                "(stepping, filters, event and tracking actions) and in the "
+                "GeneratePrimaries of each source. The calls, the total time and the "
+                "time per call are stored in counts.profile.",
+            },
+        ),
+        "profile_sampling_interval": (
+            1,
+            {
+                "doc": "With profile_actors, only one call every "
+                "profile_sampling_interval calls is timed (lower overhead), "
+                "the total time is estimated from the timed calls.",
+            },
+        ),
+        "step_types_flag": (
+            False,
+            {
+                "doc": "Count the steps per volume, particle and process (the "
+                "process that limited the step), stored in counts.step_types as "
+                "{volume: {particle: {process: counts}}}.",
+            },
+        ),
+        "step_types_time_sampling": (
+            0,
+            {
+                "doc": "With step_types_flag, time one step every "
+                "step_types_time_sampling steps (0: no time). The time of all "
+                "the steps of a (volume, particle, process) is estimated from the "
+                "timed ones.",
+            },
+        ),
+        "memory_flag": (
+            False,
+            {
+                "doc": "Report the memory (bytes) allocated by the digi collections, "
+                "the dose actors images and per-thread buffers, the phase space "
+                "source batches and the mu tables, stored in counts.memory as "
+                "{type: {name: {current, peak, threads: {id: {current, peak}}}}}. "
+                "The digi collections report when they are flushed (see "
+                "clear_every), before being cleared.",
+            },
+        ),
+        "perf_counters_flag": (
+            False,
+            {
+                "doc": "Read the hardware performance counters (cycles, instructions, "
+                "cache misses, branch misses) of each thread during the "
+                "initialization, the tracking and the output phases, stored in "
+                "counts.perf_counters as {phase: {thread id: values}} with the "
+                "IPC and the estimated memory bandwidth (bytes/s). Linux only, "
+                "requires the compilation option OPENGATE_PERF_COUNTERS.",
+            },
+        ),
     }
 
     user_output_config = {
@@ -245,6 +369,11 @@ class SimulationStatisticsActor(ActorBase, g4.GateSimulationStatisticsActor):
 
     def initialize(self):
         ActorBase.initialize(self)
+        if self.perf_counters_flag and not g4.IsPerfCountersAvailable():
+            warning(
+                f"The actor {self.name} has perf_counters_flag but opengate_core "
+                f"was compiled without OPENGATE_PERF_COUNTERS: ignored."
+            )
         self.InitializeUserInfo(self.user_info)
         self.InitializeCpp()
 
@@ -254,6 +383,15 @@ class SimulationStatisticsActor(ActorBase, g4.GateSimulationStatisticsActor):
             self.simulation.number_of_threads
         )
 
+    def get_checkpoint_state(self):
+        # the counts are merged at the end of each run
+        counts = self.GetCounts()
+        keys = ["runs", "events", "tracks", "steps", "track_types", "step_types"]
+        return {k: counts[k] for k in keys if k in counts}
+
+    def set_checkpoint_state(self, state):
+        self.SetCounts(state)
+
     def EndSimulationAction(self):
         g4.GateSimulationStatisticsActor.EndSimulationAction(self)
         self.user_output.stats.store_data(self.GetCounts())
@@ -280,7 +418,11 @@ class SimulationStatisticsActor(ActorBase, g4.GateSimulationStatisticsActor):
         self.user_output.stats.merged_data.nb_threads = (
             self.simulation.number_of_threads
         )
-        self.user_output.stats.write_data_if_requested()
+        # distributed simulation: counts of all the processes, written by rank 0
+        context = get_distributed_context()
+        context.reduce_statistics(self.user_output.stats.merged_data)
+        if context.is_root:
+            self.user_output.stats.write_data_if_requested()
 
 
 class ActorOutputKillAccordingProcessesActor(ActorOutputBase):
@@ -346,10 +488,12 @@ class KillAccordingProcessesActor(ActorBase, g4.GateKillAccordingProcessesActor)
         g4.GateKillAccordingProcessesActor.__init__(self, self.user_info)
         self.AddActions(
             {
+                "StartSimulationAction",
                 "BeginOfRunAction",
                 "BeginOfEventAction",
                 "PreUserTrackingAction",
                 "SteppingAction",
+                "EndOfRunAction",
                 "EndSimulationAction",
             }
         )
@@ -362,6 +506,7 @@ class KillAccordingProcessesActor(ActorBase, g4.GateKillAccordingProcessesActor)
             fatal("You have to select at least one process ! ")
 
     def EndSimulationAction(self):
+        self.number_of_killed_particles = self.GetNumberOfKilledParticles()
         self.user_output.kill_according_processes.number_of_killed_particles = (
             self.number_of_killed_particles
         )
@@ -374,15 +519,35 @@ class KillAccordingProcessesActor(ActorBase, g4.GateKillAccordingProcessesActor)
 class KillActor(ActorBase, g4.GateKillActor):
     """Actor which kills a particle entering a volume."""
 
+    # hints for IDE
+    energy_bins: list
+
+    user_info_defaults = {
+        "energy_bins": (
+            None,
+            {
+                "doc": "Edges (N+1 strictly increasing energies) of the N energy bins of the kill spectra: "
+                "number of killed particles per bin, for each particle, according to their energy when "
+                "entering the volume. None (default): no spectra, only the number of killed particles.",
+            },
+        ),
+    }
+
     def __init__(self, *args, **kwargs):
         ActorBase.__init__(self, *args, **kwargs)
         self.number_of_killed_particles = 0
+        self.kill_spectra = {}
         self.__initcpp__()
 
     def __initcpp__(self):
         g4.GateKillActor.__init__(self, self.user_info)
         self.AddActions(
-            {"StartSimulationAction", "EndSimulationAction", "SteppingAction"}
+            {
+                "StartSimulationAction",
+                "EndSimulationAction",
+                "SteppingAction",
+                "EndOfRunAction",
+            }
         )
 
     def initialize(self):
@@ -392,6 +557,328 @@ class KillActor(ActorBase, g4.GateKillActor):
 
     def EndSimulationAction(self):
         self.number_of_killed_particles = self.GetNumberOfKilledParticles()
+        self.kill_spectra = dict(
+            (p, np.array(s)) for p, s in self.GetKillSpectra().items()
+        )
+
+
+class RangeRejectionActor(ActorBase, g4.GateRangeRejectionActor):
+    """
+    Range rejection: the charged particles of the attached volume whose residual range
+    (down to energy_threshold) is shorter than the distance to the volume boundary are killed,
+    and their energy is deposited in place. With region_of_interest volumes, the particles
+    that cannot reach the closest one are killed (without deposit). The ranges are tabulated
+    per material at the beginning of each run. The photons that the killed particles would
+    have emitted (bremsstrahlung, annihilation) are lost.
+    """
+
+    # hints for IDE
+    particles: list
+    region_of_interest: list
+    energy_threshold: float
+    energy_min: float
+    energy_max: float
+    number_of_bins: int
+
+    user_info_defaults = {
+        "particles": (
+            ["e-", "proton"],
+            {
+                "doc": "Charged particles submitted to the range rejection (the positrons are not "
+                "included by default, their annihilation photons would be lost).",
+            },
+        ),
+        "region_of_interest": (
+            [],
+            {
+                "doc": "Volume names: the particles that cannot reach any of them (distance to their "
+                "bounding box) are killed. If empty, the particles that cannot exit the attached volume "
+                "are killed.",
+            },
+        ),
+        "energy_threshold": (
+            0,
+            {
+                "doc": "The particle is killed if it cannot travel the distance with an energy above this "
+                "threshold (and always killed below it).",
+            },
+        ),
+        "energy_min": (
+            1 * g4_units.keV,
+            {
+                "doc": "Minimum energy of the range tables.",
+            },
+        ),
+        "energy_max": (
+            1 * g4_units.GeV,
+            {
+                "doc": "Maximum energy of the range tables, the particles above it are never killed.",
+            },
+        ),
+        "number_of_bins": (
+            300,
+            {
+                "doc": "Number of log-spaced energies of the range tables.",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.number_of_killed_particles = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateRangeRejectionActor.__init__(self, self.user_info)
+        self.AddActions({"EndSimulationAction"})
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def EndSimulationAction(self):
+        self.number_of_killed_particles = self.GetNumberOfKilledParticles()
+
+
+class StepBatchActor(ActorBase, g4.GateStepBatchActor):
+    """
+    Prototyping of step scoring in Python. The selected attributes of the steps in the
+    attached volume (the same ones as the digitizers, e.g. "TotalEnergyDeposit",
+    "PostPosition", "TrackID") are stored in columns by each thread, in C++. Every
+    batch_size steps (and at the end of each event with apply_at_end_of_event, and at
+    the end of each run), batch_function(actor, batch) is called once with the whole
+    batch: a dict of numpy arrays (one per attribute, (n, 3) for the 3D values, a list
+    for the strings). The arrays are views of the C++ buffers: they are only valid
+    during the call (copy them to keep them). The function is called by the thread of
+    the steps (one call at a time per thread, with the GIL).
+    """
+
+    # hints for IDE
+    attributes: list
+    batch_size: int
+    apply_at_end_of_event: bool
+    batch_function: object
+
+    user_info_defaults = {
+        "attributes": (
+            [],
+            {
+                "doc": "Names of the attributes of the steps in the batch "
+                "(see the digitizer attributes).",
+            },
+        ),
+        "batch_size": (
+            100000,
+            {
+                "doc": "Number of steps of a batch (per thread).",
+            },
+        ),
+        "apply_at_end_of_event": (
+            False,
+            {
+                "doc": "If True, the batch is also given at the end of each event "
+                "(e.g. to score per event).",
+            },
+        ),
+        "batch_function": (
+            None,
+            {
+                "doc": "Function batch_function(actor, batch) called with each batch.",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.number_of_batches = 0
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateStepBatchActor.__init__(self, self.user_info)
+        self.AddActions(
+            {
+                "SteppingAction",
+                "EndOfEventAction",
+                "EndOfRunAction",
+                "EndSimulationAction",
+            }
+        )
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if len(self.attributes) == 0:
+            fatal(f"The StepBatchActor {self.name} needs at least one attribute")
+        if self.batch_size < 1:
+            fatal(f"The batch_size of the StepBatchActor {self.name} must be >= 1")
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+        self.SetStepBatchFunction(self.apply_batch)
+
+    def apply_batch(self, _actor):
+        if self.batch_function is not None:
+            self.batch_function(self, self.GetBatch())
+
+    def EndSimulationAction(self):
+        self.number_of_batches = self.GetNumberOfBatches()
+
+
+class OpticalFastResponseActor(ActorBase, g4.GateOpticalFastResponseActor):
+    """
+    Light collection of scintillation crystals without tracking the optical photons.
+    The actor is attached to the crystal (the copies of a crystal share the same
+    table), divided into bins. In "calibration" mode, with the optical physics, the
+    scintillation photons created in each bin and the ones that end in a detector
+    volume are counted, with their transit time: the table is written to
+    lookup_table_filename. In "fast" mode, the scintillation photons are not created
+    (in any volume); at each step with an energy deposit in the crystal, the number
+    of photons is sampled from the yield of the material, then the number of
+    detected ones and their times from the table. In both modes, the number of
+    detected photons and the first times are recorded per event and crystal copy.
+    """
+
+    # hints for IDE
+    mode: str
+    lookup_table_filename: str
+    detector_volumes: list
+    bins: list
+    time_bins: int
+    time_max: float
+    number_of_times: int
+
+    user_info_defaults = {
+        "mode": (
+            "fast",
+            {
+                "doc": "'calibration': full optical simulation, the lookup table is "
+                "computed and written. 'fast': the optical photons are replaced by the "
+                "lookup table.",
+                "allowed_values": ("calibration", "fast"),
+            },
+        ),
+        "lookup_table_filename": (
+            "optical_lut.npz",
+            {
+                "doc": "Lookup table (npz), written in calibration mode and read in fast "
+                "mode. A relative path is relative to the output directory.",
+            },
+        ),
+        "detector_volumes": (
+            [],
+            {
+                "doc": "(calibration) Volumes where the detected photons end, e.g. the "
+                "photosensor (absorbing the photons).",
+            },
+        ),
+        "bins": (
+            [4, 4, 8],
+            {
+                "doc": "(calibration) Number of bins of the crystal (bounding box, local "
+                "coordinates) in x, y and z.",
+            },
+        ),
+        "time_bins": (
+            200,
+            {"doc": "(calibration) Number of bins of the transit time histograms."},
+        ),
+        "time_max": (
+            10 * g4_units.ns,
+            {
+                "doc": "(calibration) Maximum transit time of the histograms (the "
+                "longer times are in the last bin).",
+            },
+        ),
+        "number_of_times": (
+            1,
+            {
+                "doc": "Number of first photon times recorded per event and crystal "
+                "(-1 when fewer photons are detected).",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.results = None
+        self.lookup_table = None
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateOpticalFastResponseActor.__init__(self, self.user_info)
+        self.AddActions({"EndSimulationAction"})
+
+    @property
+    def lookup_table_path(self):
+        return self.simulation.get_output_path(self.lookup_table_filename)
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+        if self.mode == "calibration":
+            if len(self.detector_volumes) == 0:
+                fatal(
+                    f"The OpticalFastResponseActor {self.name} needs detector_volumes "
+                    f"in calibration mode."
+                )
+            return
+        path = self.lookup_table_path
+        if not path.is_file():
+            fatal(
+                f"The OpticalFastResponseActor {self.name} cannot find its lookup "
+                f"table {path}, run it first in calibration mode."
+            )
+        with np.load(path) as lut:
+            self.lookup_table = dict(lut)
+        lut = self.lookup_table
+        created = lut["created"]
+        probability = np.divide(
+            lut["detected"],
+            created,
+            out=np.zeros_like(created, dtype=float),
+            where=created > 0,
+        )
+        if np.any(created == 0):
+            warning(
+                f"The lookup table of the OpticalFastResponseActor {self.name} has "
+                f"{np.count_nonzero(created == 0)} bins without calibration photons "
+                f"(no light is detected from them)."
+            )
+        self.SetLookupTable(
+            lut["box_min"].tolist(),
+            lut["box_max"].tolist(),
+            lut["bins"].tolist(),
+            float(lut["time_max"]),
+            probability.ravel().tolist(),
+            lut["transit"].ravel().tolist(),
+        )
+
+    def EndSimulationAction(self):
+        r = self.GetResults()
+        self.results = Box(
+            {
+                "event_id": np.array(r["event_id"], dtype=int),
+                "copy": np.array(r["copy"], dtype=int),
+                "photons": np.array(r["photons"], dtype=int),
+                "times": np.array(r["times"]).reshape(-1, self.number_of_times),
+            }
+        )
+        if self.mode != "calibration":
+            return
+        # bins in x fastest (see GateOpticalFastResponseActor::GetBin)
+        shape = tuple(reversed(self.bins))
+        self.lookup_table = {
+            "box_min": np.array(self.GetBoxMin()),
+            "box_max": np.array(self.GetBoxMax()),
+            "bins": np.array(self.bins),
+            "time_max": self.time_max,
+            "created": np.array(self.GetCreatedPhotons()).reshape(shape),
+            "detected": np.array(self.GetDetectedPhotons()).reshape(shape),
+            "transit": np.array(self.GetTransitHistograms()).reshape(
+                shape + (self.time_bins,)
+            ),
+        }
+        np.savez(self.lookup_table_path, **self.lookup_table)
 
 
 class AttenuationImageActor(ActorBase, g4.GateAttenuationImageActor):
@@ -458,9 +945,386 @@ class AttenuationImageActor(ActorBase, g4.GateAttenuationImageActor):
         self.user_output.attenuation_image.end_of_simulation()
 
 
+class ActorOutputFlatGeometryActor(ActorOutputBase):
+    """Flat arrays of the geometry exported by the FlatGeometryActor (numpy
+    arrays, written in a single npz file)."""
+
+    # hints for IDE
+    output_filename: str
+    write_to_disk: bool
+
+    user_info_defaults = {
+        "output_filename": (
+            "auto",
+            {
+                "doc": "Filename for the data represented by this actor output. "
+                "Relative paths and filenames are taken "
+                "relative to the global simulation output folder "
+                "set via the Simulation.output_dir option. ",
+            },
+        ),
+        "write_to_disk": (
+            True,
+            {
+                "doc": "Should the output be written to disk, or only kept in memory? ",
+            },
+        ),
+    }
+
+    default_suffix = "npz"
+
+    def store_data(self, data, **kwargs):
+        self.merged_data = data
+
+    def get_data(self, **kwargs):
+        return self.merged_data
+
+    def write_data(self, **kwargs):
+        np.savez(self.get_output_path(which="merged"), **self.merged_data)
+
+    def write_data_if_requested(self, **kwargs):
+        if self.write_to_disk is True and self.merged_data is not None:
+            self.write_data(**kwargs)
+
+
+class FlatGeometryActor(ActorBase, g4.GateFlatGeometryActor):
+    """
+    Export of the geometry of a photon imaging simulation as flat arrays, for
+    an external photon transport kernel (CPU SIMD or GPU). The actor is
+    attached to a voxelized phantom (ImageVolume):
+
+    - phantom: size, spacing, origin (center of the first voxel) and direction of
+      the label image in the world, labels (z, y, x)
+    - materials: name of each label, log-spaced bin energies and mu (1/mm) of each
+      label at each energy (labels x bins)
+    - detector (optional): crystal half size, center (N, 3) and rotation (N, 3, 3,
+      local to world) of each crystal of a detector made of nested repeated volumes
+
+    The arrays are built at the beginning of the first run. The particles coming
+    out of the kernel are given back to Geant4 with a ParticleBankSource.
+    """
+
+    # hints for IDE
+    detector: List[str]
+    energy_min: float
+    energy_max: float
+    energy_bins: int
+    database: str
+
+    user_info_defaults = {
+        "detector": (
+            [],
+            {
+                "doc": "Names of the nested repeated volumes of the detector, from the "
+                "outermost to the crystal (a box). For a RepeatParametrisedVolume, "
+                "the name of its repeated volume. Empty: no detector.",
+            },
+        ),
+        "energy_min": (
+            10 * g4_units.keV,
+            {"doc": "Energy of the first bin of the mu tables"},
+        ),
+        "energy_max": (
+            1 * g4_units.MeV,
+            {"doc": "Energy of the last bin of the mu tables"},
+        ),
+        "energy_bins": (
+            200,
+            {"doc": "Number of (log-spaced) energy bins of the mu tables"},
+        ),
+        "database": (
+            "EPDL",
+            {
+                "doc": "The database source for attenuation coefficients, either 'EPDL' or 'NIST'",
+                "allowed_values": ("EPDL", "NIST"),
+            },
+        ),
+    }
+
+    user_output_config = {
+        "flat_geometry": {
+            "actor_output_class": ActorOutputFlatGeometryActor,
+        },
+    }
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateFlatGeometryActor.__init__(self, self.user_info)
+        self.AddActions({"StartSimulationAction", "EndSimulationAction"})
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if self.attached_to_volume.volume_type != "ImageVolume":
+            fatal(
+                f"The FlatGeometryActor '{self.name}' must be attached to an "
+                f"ImageVolume, while '{self.attached_to}' is a "
+                f"{self.attached_to_volume.volume_type}."
+            )
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        self.SetPhantomVolumeName(
+            str(self.attached_to_volume.g4_physical_volumes[0].GetName())
+        )
+        self.SetImageParameterisation(self.attached_to_volume.g4_voxel_param)
+
+    def EndSimulationAction(self):
+        if not self.IsBuilt():
+            fatal(f"The FlatGeometryActor '{self.name}' was not built (no run).")
+        data = {
+            "size": np.array(self.fSize),
+            "spacing": np.array(self.fSpacing),
+            "origin": np.array(self.fOrigin),
+            "direction": self.GetDirection(),
+            "labels": self.GetLabels(),
+            "material_names": np.array(self.fMaterialNames),
+            "energies": self.GetEnergies(),
+            "mu": self.GetMu(),
+        }
+        if len(self.detector) > 0:
+            data["crystal_half_size"] = np.array(self.fCrystalHalfSize)
+            data["crystal_centers"] = self.GetCrystalCenters()
+            data["crystal_rotations"] = self.GetCrystalRotations()
+        self.user_output.flat_geometry.store_data(data)
+        self.user_output.flat_geometry.write_data_if_requested()
+
+
+class ActorOutputCutsTuning(ActorOutputBase):
+    """Statistics per region and proposed production cuts of the CutsTuningActor,
+    written in a json file."""
+
+    # hints for IDE
+    output_filename: str
+    write_to_disk: bool
+
+    user_info_defaults = {
+        "output_filename": (
+            "auto",
+            {
+                "doc": "Filename for the data represented by this actor output. "
+                "Relative paths and filenames are taken "
+                "relative to the global simulation output folder "
+                "set via the Simulation.output_dir option. ",
+            },
+        ),
+        "write_to_disk": (
+            True,
+            {
+                "doc": "Should the output be written to disk, or only kept in memory? ",
+            },
+        ),
+    }
+
+    default_suffix = "json"
+
+    def store_data(self, data, **kwargs):
+        self.merged_data = data
+
+    def get_data(self, **kwargs):
+        return self.merged_data
+
+    def write_data(self, **kwargs):
+        with open(self.get_output_path(which="merged"), "w") as f:
+            dump_json(self.merged_data, f, indent=4)
+
+    def write_data_if_requested(self, **kwargs):
+        if self.write_to_disk is True and self.merged_data is not None:
+            self.write_data(**kwargs)
+
+
+class CutsTuningActor(ActorBase, g4.GateCutsTuningActor):
+    """
+    Pilot run to tune the production cuts per region for speed. For each region, it
+    counts the steps and the edep, and the secondaries that a production cut would
+    suppress (delta rays and bremsstrahlung photons), per bin of initial energy:
+    their number, energy and number of steps. At the end of the simulation, it
+    proposes for each region and particle the largest candidate cut such that the
+    energy of the suppressed secondaries stays below a fraction (tolerance) of the
+    edep of the region, or, for the electrons, such that the cut is not larger than
+    the scoring resolution (the suppressed electrons deposit their energy within a
+    voxel). Run the pilot with cuts lower than the candidate cuts.
+    """
+
+    # hints for IDE
+    candidate_cuts: list
+    tolerance: float
+    resolution: float
+    energy_min: float
+    energy_max: float
+    number_of_energy_bins: int
+
+    user_info_defaults = {
+        "candidate_cuts": (
+            [
+                x * g4_units.mm
+                for x in (0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10, 20, 50)
+            ],
+            {
+                "doc": "Candidate production cuts (range, increasing), the largest "
+                "admissible one is proposed.",
+            },
+        ),
+        "tolerance": (
+            0.01,
+            {
+                "doc": "Maximum energy of the suppressed secondaries, as a fraction "
+                "of the edep in the region.",
+            },
+        ),
+        "resolution": (
+            None,
+            {
+                "doc": "Scoring resolution (e.g. voxel size). The electron cuts not "
+                "larger than it are always admissible. None: not used.",
+            },
+        ),
+        "energy_min": (
+            1 * g4_units.keV,
+            {"doc": "Lowest energy of the (log) energy bins of the secondaries."},
+        ),
+        "energy_max": (
+            10 * g4_units.MeV,
+            {"doc": "Highest energy of the (log) energy bins of the secondaries."},
+        ),
+        "number_of_energy_bins": (
+            80,
+            {"doc": "Number of energy bins of the secondaries."},
+        ),
+    }
+
+    user_output_config = {
+        "cuts_tuning": {
+            "actor_output_class": ActorOutputCutsTuning,
+        },
+    }
+
+    # particle names of the production cuts in GATE and in Geant4
+    cut_particles = {"gamma": "gamma", "electron": "e-", "positron": "e+"}
+
+    def __init__(self, *args, **kwargs):
+        ActorBase.__init__(self, *args, **kwargs)
+        self.__initcpp__()
+
+    def __initcpp__(self):
+        g4.GateCutsTuningActor.__init__(self, self.user_info)
+        self.AddActions(
+            {
+                "StartSimulationAction",
+                "BeginOfRunAction",
+                "PreUserTrackingAction",
+                "SteppingAction",
+                "EndOfRunAction",
+            }
+        )
+
+    def initialize(self):
+        ActorBase.initialize(self)
+        if np.any(np.diff(self.candidate_cuts) <= 0):
+            fatal(f"The candidate_cuts of the actor '{self.name}' must be increasing.")
+        self.InitializeUserInfo(self.user_info)
+        self.InitializeCpp()
+
+    def StartSimulationAction(self):
+        g4.GateCutsTuningActor.StartSimulationAction(self)
+
+    def propose_cuts(self, region):
+        """Proposed cut per particle for the statistics of a region (see the class
+        documentation), with the energy threshold, the fraction of the edep of the
+        region carried by the suppressed secondaries and the fraction of the steps
+        of the region saved. None if no candidate is admissible."""
+        edges = np.geomspace(
+            self.energy_min, self.energy_max, self.number_of_energy_bins + 1
+        )
+        log_edges = np.log(edges)
+        proposed = {}
+        for name, g4_name in self.cut_particles.items():
+            energy = np.array(region["secondary_energy"][g4_name])
+            steps = np.array(region["secondary_steps"][g4_name])
+            best = None
+            for cut in self.candidate_cuts:
+                # highest energy threshold among the materials of the region
+                threshold = max(
+                    self.ConvertRangeToEnergy(g4_name, m, cut)
+                    for m in region["materials"]
+                )
+                # part of each bin below the threshold (log interpolation)
+                f = (np.log(max(threshold, edges[0])) - log_edges[:-1]) / np.diff(
+                    log_edges
+                )
+                f = np.clip(f, 0, 1)
+                suppressed = np.sum(f * energy)
+                in_resolution = (
+                    g4_name == "e-"
+                    and self.resolution is not None
+                    and cut <= self.resolution
+                )
+                if not in_resolution and suppressed > self.tolerance * region["edep"]:
+                    break
+                best = {
+                    "cut": cut,
+                    "energy_threshold": threshold,
+                    "suppressed_energy_fraction": (
+                        suppressed / region["edep"] if region["edep"] > 0 else 0.0
+                    ),
+                    "saved_steps_fraction": (
+                        np.sum(f * steps) / region["steps"]
+                        if region["steps"] > 0
+                        else 0.0
+                    ),
+                }
+            proposed[name] = best
+        return proposed
+
+    def get_proposed_cuts(self):
+        """{region: {particle: cut}} for the regions seen during the pilot run."""
+        data = self.user_output.cuts_tuning.get_data()
+        cuts = {}
+        for region_name, region in data.items():
+            cuts[region_name] = {
+                p: c["cut"] for p, c in region["proposed_cuts"].items() if c is not None
+            }
+        return cuts
+
+    def apply_proposed_cuts(self, physics_manager):
+        """Set the proposed cuts in the physics manager of a simulation: the default
+        region of the world sets the global cuts, the other regions are the regions
+        of the same name of the physics manager (e.g. 'volume_region')."""
+        for region_name, cuts in self.get_proposed_cuts().items():
+            if region_name == "DefaultRegionForTheWorld":
+                production_cuts = physics_manager.global_production_cuts
+            elif region_name in physics_manager.regions:
+                production_cuts = physics_manager.regions[region_name].production_cuts
+            else:
+                continue
+            # the cut for 'all' overrides the cuts per particle: split it first
+            if production_cuts.get("all") is not None:
+                for particle in cut_particle_names:
+                    production_cuts[particle] = production_cuts["all"]
+                production_cuts["all"] = None
+            for particle, cut in cuts.items():
+                production_cuts[particle] = cut
+
+    def EndSimulationAction(self):
+        regions = self.GetRegionStatistics()
+        for region in regions.values():
+            region["proposed_cuts"] = self.propose_cuts(region)
+        self.user_output.cuts_tuning.store_data(regions)
+        self.user_output.cuts_tuning.write_data_if_requested()
+
+
 process_cls(ActorOutputStatisticsActor)
 process_cls(SimulationStatisticsActor)
 process_cls(KillActor)
+process_cls(RangeRejectionActor)
+process_cls(OpticalFastResponseActor)
 process_cls(ActorOutputKillAccordingProcessesActor)
 process_cls(KillAccordingProcessesActor)
 process_cls(AttenuationImageActor)
+process_cls(ActorOutputFlatGeometryActor)
+process_cls(FlatGeometryActor)
+process_cls(ActorOutputCutsTuning)
+process_cls(CutsTuningActor)
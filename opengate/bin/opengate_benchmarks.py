@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import os
+import sys
+import json
+import time
+import click
+import subprocess
+from datetime import datetime
+from importlib.metadata import version
+from pathlib import Path
+
+from opengate.exception import fatal, colored, color_ok, color_error, color_warning
+from opengate_core.testsDataSetup import check_tests_data_folder
+from opengate.bin.opengate_library_path import return_tests_path
+from opengate_core import GateInfo
+
+CONTEXT_SETTINGS = dict(help_option_names=["-h", "--help"])
+
+
+@click.command(context_settings=CONTEXT_SETTINGS)
+@click.option(
+    "--threads",
+    "-t",
+    default="auto",
+    help="Numbers of threads, e.g. '1,2,4,8'. Default 'auto': 1, 2, 4 ... up "
+    "to the number of cores",
+)
+@click.option(
+    "--bench",
+    "-b",
+    multiple=True,
+    help="Only run the benchmarks whose file name contains this string "
+    "(can be repeated)",
+)
+@click.option(
+    "--scale",
+    "-s",
+    default=1.0,
+    help="Multiplier of the number of primaries of all the benchmarks",
+)
+@click.option(
+    "--output",
+    "-o",
+    default=None,
+    help="Output json file (default in tests/output_dashboard)",
+)
+@click.option(
+    "--reference",
+    "-r",
+    default=None,
+    help="Json file of a previous evaluation: fail if the events/s of one "
+    "benchmark is lower than the reference (minus the tolerance)",
+)
+@click.option(
+    "--tolerance",
+    default=0.1,
+    help="Relative tolerance of the comparison with the reference",
+)
+def go(threads, bench, scale, output, reference, tolerance):
+    """
+    Run the reference simulations (tests/src/bench*.py) with several numbers
+    of threads and report, for each one: events/s, parallel efficiency, peak
+    RSS, initialization time and output writing time.
+    """
+    path_tests_src = return_tests_path()
+    if not check_tests_data_folder():
+        fatal("The data of the tests are not available")
+
+    files = get_benchmark_files(path_tests_src, bench)
+    threads = get_threads(threads)
+    print(f"Running {len(files)} benchmarks with {threads} threads")
+    print("-" * 70)
+
+    start = time.time()
+    results = {}
+    failures = []
+    for f in files:
+        results[f.stem] = []
+        for n in threads:
+            r = run_one_benchmark(f, n, scale)
+            if r is None:
+                failures.append(f"{f.stem} ({n} threads)")
+            else:
+                results[f.stem].append(r)
+        add_parallel_efficiency(results[f.stem])
+    print(f"Benchmarks took {(time.time() - start) / 60:5.1f} min")
+
+    # summary
+    print_summary(results)
+    summary = {
+        "date": datetime.now().isoformat(timespec="seconds"),
+        "platform": sys.platform,
+        "python": sys.version.split()[0],
+        "opengate": version("opengate"),
+        "geant4": GateInfo.get_G4Version().replace("$Name: ", "").replace("$", ""),
+        "cpu_count": os.cpu_count(),
+        "scale": scale,
+        "benchmarks": results,
+    }
+    if output is None:
+        output = (
+            path_tests_src.parent
+            / "output_dashboard"
+            / f"benchmarks_{sys.platform}.json"
+        )
+    os.makedirs(Path(output).parent, exist_ok=True)
+    with open(output, "w") as fp:
+        json.dump(summary, fp, indent=4)
+    print(f"Results in {output}")
+
+    # regressions
+    if reference is not None:
+        failures += compare_to_reference(results, reference, tolerance)
+    if len(failures) > 0:
+        print(colored.stylize("Failed benchmarks:", color_error))
+        for f in failures:
+            print(colored.stylize(f"  {f}", color_error))
+        sys.exit(1)
+    print(colored.stylize("All benchmarks ok", color_ok))
+
+
+def get_benchmark_files(path_tests_src, bench):
+    files = sorted(Path(path_tests_src).glob("bench[0-9]*.py"))
+    if len(bench) > 0:
+        files = [f for f in files if any(b in f.name for b in bench)]
+    if len(files) == 0:
+        fatal(f"No benchmark found in {path_tests_src}")
+    return files
+
+
+def get_threads(threads):
+    if threads != "auto":
+        return [int(t) for t in threads.split(",")]
+    n = os.cpu_count()
+    t = [1]
+    while t[-1] * 2 < n:
+        t.append(t[-1] * 2)
+    if t[-1] != n:
+        t.append(n)
+    return t
+
+
+def run_one_benchmark(f, threads, scale):
+    print(f"Running: {f.name:<36} {threads:>3} threads  ", end="", flush=True)
+    log_dir = f.parent.parent / "log"
+    os.makedirs(log_dir, exist_ok=True)
+    log = log_dir / f"{f.stem}_{threads}t.log"
+    json_output = log_dir / f"{f.stem}_{threads}t.json"
+    if json_output.exists():
+        json_output.unlink()
+    cmd = [
+        sys.executable,
+        str(f),
+        "--threads",
+        str(threads),
+        "--scale",
+        str(scale),
+        "--output",
+        str(json_output),
+    ]
+    start = time.time()
+    with open(log, "w") as fp:
+        r = subprocess.run(cmd, stdout=fp, stderr=subprocess.STDOUT, cwd=f.parent)
+    if r.returncode != 0 or not json_output.exists():
+        print(colored.stylize(" FAILED !", color_error), end="")
+        print(f"   {time.time() - start:5.1f} s     {log.name}")
+        return None
+    with open(json_output) as fp:
+        result = json.load(fp)
+    print(colored.stylize(" OK", color_ok), end="")
+    print(f"   {time.time() - start:5.1f} s     {log.name}")
+    return result
+
+
+def add_parallel_efficiency(results):
+    """Events/s relative to the smallest number of threads, divided by the
+    ratio of the numbers of threads (1.0 is a perfect scaling)"""
+    if len(results) == 0:
+        return
+    ref = min(results, key=lambda r: r["threads"])
+    for r in results:
+        if ref["events_per_second"] > 0:
+            r["parallel_efficiency"] = (
+                r["events_per_second"]
+                * ref["threads"]
+                / (ref["events_per_second"] * r["threads"])
+            )
+        else:
+            r["parallel_efficiency"] = 0
+
+
+def print_summary(results):
+    print("-" * 90)
+    print(
+        f"{'benchmark':<28} {'threads':>7} {'events/s':>10} {'effic.':>7} "
+        f"{'RSS MB':>8} {'init s':>7} {'run s':>7} {'output s':>8}"
+    )
+    for name, rr in results.items():
+        for r in rr:
+            print(
+                f"{name:<28} {r['threads']:>7} {r['events_per_second']:>10.1f} "
+                f"{r['parallel_efficiency']:>7.2f} {r['peak_rss_mb']:>8.0f} "
+                f"{r['init_time']:>7.1f} {r['run_time']:>7.1f} "
+                f"{r['output_time']:>8.2f}"
+            )
+    print("-" * 90)
+
+
+def compare_to_reference(results, reference, tolerance):
+    with open(reference) as fp:
+        ref = json.load(fp)["benchmarks"]
+    failures = []
+    for name, rr in results.items():
+        if name not in ref:
+            print(colored.stylize(f"{name}: no reference", color_warning))
+            continue
+        ref_eps = {r["threads"]: r["events_per_second"] for r in ref[name]}
+        for r in rr:
+            n = r["threads"]
+            if n not in ref_eps:
+                continue
+            ratio = r["events_per_second"] / ref_eps[n] if ref_eps[n] > 0 else 1
+            s = f"{name} ({n} threads): {ratio:.2f} x the reference events/s"
+            if ratio < 1 - tolerance:
+                failures.append(s)
+            else:
+                print(colored.stylize(s, color_ok))
+    return failures
+
+
+if __name__ == "__main__":
+    go()
@@ -32,7 +32,31 @@ CONTEXT_SETTINGS = dict(help_option_names=["-h", "--help"])
     default=False,
     help="If set, do not consider the shell of the sphere (for high resolution)",
 )
-def go(output, spacing, output_source, activities, no_shell, bg, cyl):
+@click.option(
+    "--threads", "-t", default=0, help="Number of threads (0: all the cores)"
+)
+@click.option(
+    "--refine",
+    default=1,
+    help="Voxelize first by blocks of this size, then refine the non-homogeneous blocks",
+)
+@click.option(
+    "--supersampling",
+    default=1,
+    help="Sample the boundary voxels with n^3 points (partial volume of the source)",
+)
+def go(
+    output,
+    spacing,
+    output_source,
+    activities,
+    no_shell,
+    bg,
+    cyl,
+    threads,
+    refine,
+    supersampling,
+):
     # create the simulation
     sim = Simulation()
     sim.verbose_level = logger.INFO
@@ -49,7 +73,16 @@ def go(output, spacing, output_source, activities, no_shell, bg, cyl):
     # voxelized the iec volume
     print("Starting voxelization ...")
     spacing = (spacing, spacing, spacing)
-    volume_labels, image = sim.voxelize_geometry(extent=iec, spacing=spacing, margin=1)
+    output_vox = sim.voxelize_geometry(
+        extent=iec,
+        spacing=spacing,
+        margin=1,
+        number_of_threads=threads,
+        refinement_block_size=refine,
+        supersampling=supersampling,
+    )
+    volume_labels, image = output_vox[0], output_vox[1]
+    fractions = output_vox[2] if supersampling > 1 else None
 
     info = get_info_from_image(image)
     print(f"Image size={info.size}")
@@ -83,7 +116,7 @@ def go(output, spacing, output_source, activities, no_shell, bg, cyl):
         a["iec_sphere_shell_37mm"] = activities[5]
 
     if output_source is not None:
-        itk_source = voxelized_source(image, volume_labels, a)
+        itk_source = voxelized_source(image, volume_labels, a, fractions)
         print(f"Write image source {output_source}")
         itk.imwrite(itk_source, output_source)
 
@@ -0,0 +1,164 @@
+import os
+import pickle
+import time
+from pathlib import Path
+
+from .exception import fatal
+from .logger import global_log
+from .distributed import _get_container_state, _set_container_state
+
+# version of the content of the checkpoint files
+checkpoint_version = 1
+
+
+class SimulationCheckpoint:
+    """State of a simulation at the end of a run, written in a binary file
+    (see the options checkpoint_filename, checkpoint_interval and
+    resume_from_checkpoint of the Simulation).
+
+    The file contains the index of the next run, the state of the (master)
+    random engine, and the state of each actor (see
+    ActorBase.get_checkpoint_state). In multithreading, the random engines
+    of the threads are seeded by the master engine at the start of each run,
+    so a resumed simulation gives the same results as the simulation without
+    interruption (same number of threads). The checkpoints are written between
+    two runs only: the sources and the thread-local data of the actors are
+    not saved during a run.
+    """
+
+    def __init__(self, simulation_engine):
+        self.simulation_engine = simulation_engine
+        simulation = simulation_engine.simulation
+        path = simulation.get_output_path(simulation.checkpoint_filename)
+        # distributed simulation: one file per process
+        context = simulation_engine.distributed_context
+        self.path = Path(context.get_process_path(str(path)))
+        self.interval = simulation.checkpoint_interval
+        self.first_run_index = 0
+        self.state = None
+        self.last_write_time = None
+        if simulation.resume_from_checkpoint and self.path.exists():
+            self.read()
+
+    @property
+    def simulation(self):
+        return self.simulation_engine.simulation
+
+    @property
+    def actors(self):
+        return self.simulation.actor_manager.actors
+
+    @property
+    def source_manager(self):
+        return self.simulation_engine.source_engine.g4_master_source_manager
+
+    def read(self):
+        with open(self.path, "rb") as f:
+            state = pickle.load(f)
+        if state.get("version") != checkpoint_version:
+            fatal(f"The checkpoint {self.path} has an unknown version")
+        s = self.simulation
+        expected = {
+            "run_timing_intervals": [list(i) for i in s.run_timing_intervals],
+            "number_of_threads": s.number_of_threads,
+            "random_engine": s.random_engine,
+            "actors": sorted(self.actors.keys()),
+        }
+        for k, v in expected.items():
+            value = state[k] if k != "actors" else sorted(state[k].keys())
+            if value != v:
+                fatal(
+                    f"Cannot resume from the checkpoint {self.path}: "
+                    f"the {k} of the simulation ({v}) is not the one "
+                    f"of the checkpoint ({value})"
+                )
+        self.state = state
+        self.first_run_index = state["next_run_index"]
+
+    def start(self):
+        """Called by the master thread, once the actors have started
+        the simulation and before the first run."""
+        # fail before the first run if an actor cannot be checkpointed
+        for actor in self.actors.values():
+            actor.get_checkpoint_state()
+        if self.state is not None:
+            self.restore()
+        self.last_write_time = time.time()
+        self.source_manager.SetEndOfRunCallback(self.end_of_run)
+
+    def close(self):
+        # release the python function kept by the C++ source manager
+        if self.source_manager is not None:
+            self.source_manager.SetEndOfRunCallback(None)
+
+    def restore(self):
+        engine = self.simulation_engine.g4_HepRandomEngine
+        if not engine.get(self.state["random_engine_state"]):
+            fatal(f"Cannot restore the random engine from {self.path}")
+        for name, actor_state in self.state["actors"].items():
+            self.actors[name].set_checkpoint_state(actor_state)
+        global_log.info(
+            f"Simulation: resume from checkpoint {self.path} "
+            f"(run {self.first_run_index})"
+        )
+
+    def end_of_run(self, run_index):
+        """Called by the master thread at the end of each run,
+        after the actors."""
+        # the last run: the simulation is about to end
+        # (the run index is the one of the source engine, see dynamic_sub_runs)
+        intervals = self.simulation_engine.source_engine.run_timing_intervals
+        if run_index + 1 >= len(intervals):
+            return
+        if time.time() - self.last_write_time < self.interval:
+            return
+        self.write(run_index + 1)
+        self.last_write_time = time.time()
+
+    def write(self, next_run_index):
+        s = self.simulation
+        engine = self.simulation_engine.g4_HepRandomEngine
+        state = {
+            "version": checkpoint_version,
+            "next_run_index": next_run_index,
+            "run_timing_intervals": [list(i) for i in s.run_timing_intervals],
+            "number_of_threads": s.number_of_threads,
+            "random_engine": s.random_engine,
+            "random_engine_state": list(engine.put()),
+            "actors": {
+                name: actor.get_checkpoint_state()
+                for name, actor in self.actors.items()
+            },
+        }
+        # the previous checkpoint is replaced only once the new one is complete
+        tmp = self.path.with_name(self.path.name + ".tmp")
+        with open(tmp, "wb") as f:
+            pickle.dump(state, f, protocol=pickle.HIGHEST_PROTOCOL)
+        os.replace(tmp, self.path)
+        global_log.info(
+            f"Simulation: checkpoint {self.path} (next run {next_run_index})"
+        )
+
+
+def get_output_checkpoint_state(output):
+    """State of the data (merged and per run) of an actor output using data
+    item containers (e.g. images)"""
+
+    def state(container):
+        return None if container is None else _get_container_state(container)
+
+    return {
+        "merged": state(output.merged_data),
+        "runs": {k: state(v) for k, v in output.data_per_run.items()},
+    }
+
+
+def set_output_checkpoint_state(output, state):
+    def container(s):
+        if s is None:
+            return None
+        c = output.data_container_class(belongs_to=output)
+        return _set_container_state(c, s)
+
+    output.merged_data = container(state["merged"])
+    output.data_per_run = {k: container(v) for k, v in state["runs"].items()}
@@ -7,6 +7,8 @@ from opengate.utility import g4_units, g4_best_unit
 from opengate.image import get_translation_between_images_center, read_image_info
 from opengate.logger import INFO
 from opengate.geometry.materials import HounsfieldUnit_to_material
+from opengate.actors.doseactors import create_time_integrated_activity_image
+import itk
 
 
 def create_simulation(param):
@@ -22,6 +24,11 @@ def create_simulation(param):
     - verbose:
     - radionuclide
     - activity_bq
+    - activity_image
+    or, for the dose rate at several times in a single simulation:
+    - activity_images (list of filenames)
+    - activity_times_h (list of times in hours)
+    - mu_table_cache_folder (optional)
     """
     # create the simulation
     sim = Simulation()
@@ -37,6 +44,7 @@ def create_simulation(param):
 
     # units
     m = g4_units.m
+    h = g4_units.h
     mm = g4_units.mm
     keV = g4_units.keV
     Bq = g4_units.Bq
@@ -79,6 +87,15 @@ def create_simulation(param):
         "I131": {"Z": 53, "A": 131, "name": "Iodine 131"},
     }
 
+    # sequence of activity images: the source is the time-integrated activity
+    dose_rate = "activity_images" in param
+    if dose_rate:
+        image = create_time_integrated_activity_image(
+            param.activity_images, [t * h for t in param.activity_times_h]
+        )
+        param.activity_image = str(param.output_folder / "integrated_activity.mhd")
+        itk.imwrite(image, param.activity_image)
+
     # Activity source from an image
     source = sim.add_source("VoxelSource", "vox")
     source.attached_to = ct.name
@@ -103,13 +120,22 @@ def create_simulation(param):
 
     # add dose actor (get the same size as the source)
     source_info = read_image_info(param.activity_image)
-    dose = sim.add_actor("DoseActor", "dose")
+    if dose_rate:
+        # dose rate at each time and time-integrated dose (TLE for the gamma)
+        dose = sim.add_actor("DoseRateActor", "dose")
+        dose.activity_images = param.activity_images
+        dose.activity_times = [t * h for t in param.activity_times_h]
+        dose.mu_table_cache_folder = param.get("mu_table_cache_folder", None)
+    else:
+        dose = sim.add_actor("DoseActor", "dose")
     dose.output_filename = "edep.mhd"
     dose.attached_to = ct.name
     dose.size = source_info.size
     dose.spacing = source_info.spacing
     # translate the dose the same way as the source
     dose.translation = source.position.translation
+    if dose_rate:
+        dose.activity_translation = source.position.translation
     # set the origin of the dose like the source
     if not sim.visu:
         dose.output_coordinate_system = "attached_to_image"
@@ -1,3 +1,4 @@
+import numpy as np
 from scipy.spatial.transform import Rotation
 from opengate.utility import g4_units
 from opengate.geometry.utility import get_grid_repetition, get_circular_repetition
@@ -188,6 +189,36 @@ def add_pet(sim, name="pet", create_housing=True, create_mat=True, debug=False):
     return pet
 
 
+def get_lor_table(pet_name="pet", debug=False):
+    """
+    LOR table of the geometry of add_pet, for the online coincidence sorter
+    (sinogram and listmode): 40 rings of 18 x 32 = 576 crystals (20 rings of 288
+    crystals in debug mode). Crystal index: module copy (18), stack copy (4 x 5),
+    die copy (4 x 4), crystal copy (2 x 2, or 1 in debug mode), y then z.
+    """
+    c = 1 if debug else 2
+    module, sy, sz, dy, dz, cy, cz = np.meshgrid(
+        np.arange(18),
+        np.arange(4),
+        np.arange(5),
+        np.arange(4),
+        np.arange(4),
+        np.arange(c),
+        np.arange(c),
+        indexing="ij",
+    )
+    return {
+        "crystal_index": [
+            (f"{pet_name}_module", 20 * 16 * c * c),
+            (f"{pet_name}_stack", 16 * c * c),
+            (f"{pet_name}_die", c * c),
+            (f"{pet_name}_crystal", 1),
+        ],
+        "ring": ((sz * 4 + dz) * c + cz).ravel(),
+        "position": (((module * 4 + sy) * 4 + dy) * c + cy).ravel(),
+    }
+
+
 def add_table(sim, name="pet"):
     """
     Add a patient table
@@ -1,4 +1,5 @@
 import pathlib
+import numpy as np
 from opengate.utility import g4_units
 from opengate.geometry.utility import get_grid_repetition, get_circular_repetition
 
@@ -70,6 +71,26 @@ def add_pet(sim, name="pet", load_db=True):
     return pet
 
 
+def get_lor_table(pet_name="pet"):
+    """
+    LOR table of the geometry of add_pet, for the online coincidence sorter
+    (sinogram and listmode): 4 x 13 = 52 rings of 48 x 13 = 624 crystals.
+    Crystal index: ring copy (4), block copy (48), crystal copy (13 x 13, y then z).
+    """
+    ring, block, y, z = np.meshgrid(
+        np.arange(4), np.arange(48), np.arange(13), np.arange(13), indexing="ij"
+    )
+    return {
+        "crystal_index": [
+            (f"{pet_name}_ring", 48 * 169),
+            (f"{pet_name}_block", 169),
+            (f"{pet_name}_crystal", 1),
+        ],
+        "ring": (ring * 13 + z).ravel(),
+        "position": (block * 13 + y).ravel(),
+    }
+
+
 def add_digitizer(
     sim, pet_name, output_filename, hits_name="Hits", singles_name="Singles"
 ):
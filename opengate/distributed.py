@@ -0,0 +1,325 @@
+import os
+import multiprocessing
+from pathlib import Path
+
+import numpy as np
+
+from .exception import fatal, warning
+
+
+class DistributedContext:
+    """Rank and communicator of a distributed simulation (one process per rank,
+    e.g. started with mpirun). Without distributed mode, there is one single
+    process (rank 0 of size 1) and all the methods do nothing.
+
+    Each rank simulates its share of the primaries (see SourceBase.distribute)
+    with its own seed. At the end of the simulation, the data of the actor
+    outputs are reduced on rank 0, which writes the output files: the
+    simulation looks like one single simulation.
+
+    With the mode 'fork', the processes are forked by the current process once
+    the simulation is initialized (see fork): the geometry, the materials, the
+    physics tables and the data of the sources (e.g. phase spaces) are shared
+    (copy-on-write) instead of being built by each process.
+    """
+
+    def __init__(self, mode=None, number_of_processes=1):
+        self.mode = mode
+        self.comm = None
+        self.rank = 0
+        self.size = 1
+        self.number_of_processes = number_of_processes
+        self.child_pids = []
+        if mode is None:
+            return
+        if mode == "fork":
+            # one single process until fork() is called
+            if number_of_processes < 1:
+                fatal(f"Invalid number_of_processes {number_of_processes}")
+            return
+        if mode != "mpi":
+            fatal(f"Unknown distributed mode '{mode}', use None, 'mpi' or 'fork'")
+        try:
+            from mpi4py import MPI
+        except ImportError:
+            fatal(
+                "The distributed mode 'mpi' requires mpi4py: pip install mpi4py "
+                "(and run the simulation with mpirun)"
+            )
+            return
+        self.comm = MPI.COMM_WORLD
+        self.rank = self.comm.Get_rank()
+        self.size = self.comm.Get_size()
+
+    @property
+    def is_distributed(self):
+        return self.comm is not None
+
+    @property
+    def is_root(self):
+        return self.rank == 0
+
+    def fork(self):
+        """[fork mode] Fork the other processes (the current one is the rank 0).
+        Return in all the processes, with their rank. Only the current thread is
+        forked, so no other thread (e.g. Geant4 worker) must be running."""
+        n = self.number_of_processes
+        pipes = {r: multiprocessing.Pipe() for r in range(1, n)}
+        rank = 0
+        for r in range(1, n):
+            pid = os.fork()
+            if pid == 0:
+                rank = r
+                self.child_pids = []
+                break
+            self.child_pids.append(pid)
+        # one pipe between the rank 0 and each other rank
+        connections = {}
+        for r, (root_end, rank_end) in pipes.items():
+            if rank == 0:
+                connections[r] = root_end
+                rank_end.close()
+            elif rank == r:
+                connections[0] = rank_end
+                root_end.close()
+            else:
+                root_end.close()
+                rank_end.close()
+        self.comm = ForkCommunicator(rank, n, connections)
+        self.rank = rank
+        self.size = n
+
+    def join(self):
+        """[fork mode] Rank 0: wait for the end of the other processes"""
+        failed = []
+        for pid in self.child_pids:
+            _, status = os.waitpid(pid, 0)
+            if os.waitstatus_to_exitcode(status) != 0:
+                failed.append(pid)
+        self.child_pids = []
+        if len(failed) > 0:
+            fatal(f"The forked simulation processes {failed} failed")
+
+    def barrier(self):
+        if self.is_distributed:
+            self.comm.Barrier()
+
+    def broadcast(self, value):
+        if not self.is_distributed:
+            return value
+        return self.comm.bcast(value, root=0)
+
+    def get_seed(self, seed):
+        """Independent seed of this rank, derived from the seed of the
+        simulation (the same on all ranks)"""
+        if not self.is_distributed:
+            return seed
+        seed = self.broadcast(seed)
+        state = np.random.SeedSequence(int(seed), spawn_key=(self.rank,))
+        return int(state.generate_state(1, np.uint64)[0] >> np.uint64(1))
+
+    def get_share(self, n):
+        """Number of elements (among n) of this rank"""
+        n = int(n)
+        return n // self.size + (1 if self.rank < n % self.size else 0)
+
+    def get_process_path(self, path):
+        """Path of the file written by this rank (before merge)"""
+        if not self.is_distributed:
+            return path
+        p = Path(path)
+        return str(p.with_name(f"{p.stem}_rank{self.rank}{p.suffix}"))
+
+    def reduce_data_container(self, container):
+        """Merge the data containers of all ranks (inplace_merge_with) on rank 0.
+        The other ranks keep their own data. The items are sent one rank at a
+        time, as arrays (not the Python objects of the actor)."""
+        if not self.is_distributed or container is None:
+            return container
+        if not self.is_root:
+            self.comm.send(_get_container_state(container), dest=0)
+            return container
+        for rank in range(1, self.size):
+            state = self.comm.recv(source=rank)
+            other = _set_container_state(container, state)
+            container.inplace_merge_with(other)
+        return container
+
+    def reduce_statistics(self, counts):
+        """Counts of the SimulationStatisticsActor of all ranks"""
+        if not self.is_distributed:
+            return counts
+        all_counts = self.comm.gather(dict(counts), root=0)
+        if not self.is_root:
+            return counts
+        for c in all_counts[1:]:
+            for k in ["events", "tracks", "steps", "nb_threads"]:
+                counts[k] += c[k]
+            counts.duration = max(counts.duration, c["duration"])
+            counts.init = max(counts.init, c["init"])
+            for k, v in c["track_types"].items():
+                counts.track_types[k] = counts.track_types.get(k, 0) + v
+            _add_step_types(counts.step_types, c.get("step_types", {}))
+        return counts
+
+    def merge_root_files(self, path):
+        """Merge the ROOT files of the ranks into path (on rank 0), all trees
+        are concatenated. The files of the ranks are then removed."""
+        if not self.is_distributed:
+            return
+        # all the files must be closed
+        self.barrier()
+        if self.is_root:
+            paths = [
+                Path(path).with_name(f"{Path(path).stem}_rank{r}{Path(path).suffix}")
+                for r in range(self.size)
+            ]
+            _merge_root_trees([p for p in paths if p.exists()], path)
+            for p in paths:
+                if p.exists():
+                    os.remove(p)
+        self.barrier()
+
+
+class ForkCommunicator:
+    """Communicator between the processes of the fork mode, with the methods
+    of the mpi4py communicator used by DistributedContext. The messages are
+    sent through a pipe between the rank 0 and each other rank: all the
+    collective operations have their root on the rank 0."""
+
+    def __init__(self, rank, size, connections):
+        self.rank = rank
+        self.size = size
+        self.connections = connections
+
+    def Get_rank(self):
+        return self.rank
+
+    def Get_size(self):
+        return self.size
+
+    def send(self, obj, dest):
+        self.connections[dest].send(obj)
+
+    def recv(self, source):
+        try:
+            return self.connections[source].recv()
+        except EOFError:
+            fatal(f"The forked simulation process of rank {source} has stopped")
+
+    def bcast(self, value, root=0):
+        if self.rank != root:
+            return self.recv(root)
+        for c in self.connections.values():
+            c.send(value)
+        return value
+
+    def gather(self, value, root=0):
+        if self.rank != root:
+            self.send(value, root)
+            return None
+        return [value] + [self.recv(r) for r in range(1, self.size)]
+
+    def Barrier(self):
+        self.gather(None)
+        self.bcast(None)
+
+
+def _get_container_state(container):
+    from .actors.dataitems import ItkImageDataItem
+    import itk
+
+    state = []
+    for item in container.data:
+        if item is None:
+            state.append(None)
+            continue
+        if item.data is None:
+            state.append((None, dict(item.meta_data)))
+            continue
+        if isinstance(item, ItkImageDataItem):
+            image = item.data
+            data = (
+                itk.array_from_image(image),
+                np.array(image.GetSpacing()),
+                np.array(image.GetOrigin()),
+                itk.array_from_matrix(image.GetDirection()),
+            )
+        else:
+            data = item.data
+        state.append((data, dict(item.meta_data)))
+    return state
+
+
+def _set_container_state(container, state):
+    from .actors.dataitems import ItkImageDataItem
+    import itk
+
+    items = []
+    for item, s in zip(container.data, state):
+        if s is None:
+            items.append(None)
+            continue
+        data, meta_data = s
+        if data is not None and isinstance(item, ItkImageDataItem):
+            array, spacing, origin, direction = data
+            image = itk.image_from_array(array)
+            image.SetSpacing(spacing)
+            image.SetOrigin(origin)
+            image.SetDirection(itk.matrix_from_array(direction))
+            data = image
+        items.append(type(item)(data=data, meta_data=meta_data))
+    return type(container)(container.belongs_to, data=items)
+
+
+def _merge_root_trees(paths, output_path):
+    import uproot
+
+    if len(paths) == 0:
+        warning(f"No ROOT file to merge into {output_path}")
+        return
+    with uproot.open(paths[0]) as f:
+        trees = [k.split(";")[0] for k, c in f.classnames().items() if c == "TTree"]
+    with uproot.recreate(output_path) as out:
+        for tree in trees:
+            created = False
+            for p in paths:
+                for arrays in uproot.iterate(f"{p}:{tree}", library="np"):
+                    if created:
+                        out[tree].extend(arrays)
+                    else:
+                        out[tree] = arrays
+                        created = True
+
+
+def _add_step_types(step_types, other):
+    """Add the step_types of the SimulationStatisticsActor of another rank,
+    {volume: {particle: {process: counts}}}"""
+    for volume, particles in other.items():
+        for particle, processes in particles.items():
+            for process, c in processes.items():
+                p = step_types.setdefault(volume, {}).setdefault(particle, {})
+                if process not in p:
+                    p[process] = dict(c)
+                    continue
+                s = p[process]
+                for k in ["steps", "sampled_steps", "sampled_time"]:
+                    s[k] += c[k]
+                if s["sampled_steps"] > 0:
+                    s["time"] = s["sampled_time"] * s["steps"] / s["sampled_steps"]
+
+
+# the context of the current simulation engine (non distributed by default)
+_distributed_context = None
+
+
+def get_distributed_context():
+    global _distributed_context
+    if _distributed_context is None:
+        _distributed_context = DistributedContext()
+    return _distributed_context
+
+
+def set_distributed_context(context):
+    global _distributed_context
+    _distributed_context = context
@@ -2,14 +2,21 @@ import time
 import random
 import sys
 import os
+import threading
+import traceback
 import weakref
+import shutil
+import hashlib
+import json
+from pathlib import Path
 from box import Box
 from anytree import PreOrderIter
 
 import opengate_core as g4
 from .exception import fatal, warning, GateImplementationError
 from .decorators import requires_fatal, requires_warning
-from .runtiming import assert_run_timing
+from .runtiming import assert_run_timing, merge_sub_runs
+from .utility import g4_best_unit
 from .uisessions import UIsessionSilent, UIsessionVerbose
 from .exception import ExceptionHandler
 from .physics import (
@@ -21,6 +28,9 @@ from .physics import (
 )
 from .base import GateSingletonFatal
 from .logger import global_log
+from .distributed import DistributedContext, set_distributed_context
+from .checkpoint import SimulationCheckpoint
+from .image import deferred_image_writes, parallel_image_reductions
 
 
 class EngineBase:
@@ -79,6 +89,12 @@ class SourceEngine(EngineBase):
         self.g4_master_source_manager = None
         self.g4_thread_source_managers = []
 
+        # Primaries recorded or replayed (shared by all source managers)
+        self.g4_primary_cache = None
+
+        # Guided scheduling of the events (shared by all source managers)
+        self.g4_event_scheduler = None
+
         # Options dict for cpp SourceManager
         # will be set in create_g4_source_manager
         # FIXME: Why is this separate dictionary needed? Would be better to access the source manager directly
@@ -87,24 +103,76 @@ class SourceEngine(EngineBase):
     def close(self):
         if self.verbose_close:
             warning("Closing SourceEngine")
+        # the sources get back the values of the user (see distribute)
+        source_manager = self.simulation_engine.simulation.source_manager
+        for source in source_manager.sources.values():
+            source.restore_undistributed_values()
         self.release_g4_references()
         super().close()
 
     def release_g4_references(self):
+        # release the python function kept by the C++ source managers
+        for ms in self.all_g4_source_managers():
+            ms.SetNewJobCallback(None)
         self.g4_master_source_manager = None
         self.g4_thread_source_managers = None
+        self.g4_primary_cache = None
+        self.g4_event_scheduler = None
         # a source object contains a reference to a G4 source
         self.sources = None
 
     def initialize(self, run_timing_intervals, progress_bar=False):
         self.run_timing_intervals = run_timing_intervals
         assert_run_timing(self.run_timing_intervals)
+        # sub-runs: all the intervals are simulated in a single Geant4 run, the
+        # volumes are moved by the motion table (see DynamicGeometryActor)
+        simulation = self.simulation_engine.simulation
+        if simulation.dynamic_sub_runs:
+            if simulation.multithreaded:
+                fatal("The option dynamic_sub_runs requires a single thread")
+            self.run_timing_intervals = merge_sub_runs(run_timing_intervals)
         # if len(self.simulation_engine.simulation.source_manager.sources) == 0:
         #    self.simulation_engine.simulation.warn_user(
         #        "No source: no particle will be generated"
         #    )
         self.progress_bar = progress_bar
 
+        # distributed run: each process only simulates its share of the primaries
+        context = self.simulation_engine.distributed_context
+        if context.is_distributed:
+            source_manager = self.simulation_engine.simulation.source_manager
+            for source in source_manager.sources.values():
+                source.distribute(context)
+
+        self.initialize_primary_cache()
+        self.initialize_event_scheduler()
+
+    def initialize_primary_cache(self):
+        simulation = self.simulation_engine.simulation
+        mode = simulation.primary_cache_mode
+        if mode is None:
+            return
+        if self.simulation_engine.distributed_context.is_distributed:
+            fatal("The primary cache cannot be used with a distributed simulation")
+        path = simulation.get_output_path(simulation.primary_cache_filename)
+        self.g4_primary_cache = g4.GatePrimaryCache()
+        if mode == "record":
+            self.g4_primary_cache.OpenForRecording(str(path))
+        else:
+            if not path.exists():
+                fatal(f"The primary cache file {path} does not exist")
+            self.g4_primary_cache.OpenForReplay(str(path))
+
+    def initialize_event_scheduler(self):
+        simulation = self.simulation_engine.simulation
+        if simulation.event_scheduling != "guided" or not simulation.multithreaded:
+            return
+        # the seed of each event is derived from the seed of the simulation
+        seed = self.simulation_engine.current_random_seed % pow(2, 63)
+        self.g4_event_scheduler = g4.GateEventScheduler(
+            simulation.number_of_threads, seed
+        )
+
     def initialize_actors(self):
         """
         Parameters
@@ -150,12 +218,34 @@ class SourceEngine(EngineBase):
             if "verbose_" in k:
                 self.source_manager_options[k] = v
 
-        # progress bar
-        self.source_manager_options["progress_bar"] = (
-            self.simulation_engine.simulation.progress_bar
+        # progress bar and/or progress file (all threads)
+        simulation = self.simulation_engine.simulation
+        self.source_manager_options["progress_bar"] = simulation.progress_bar
+        self.source_manager_options["progress_filename"] = ""
+        if simulation.progress_filename is not None:
+            self.source_manager_options["progress_filename"] = str(
+                simulation.get_output_path(simulation.progress_filename)
+            )
+        self.source_manager_options["progress_interval"] = (
+            simulation.progress_interval
+        )
+
+        # sources sharing a single Poisson process
+        self.source_manager_options["aggregate_sources"] = (
+            self.simulation_engine.simulation.aggregate_sources
+        )
+
+        # resumed simulation: the runs before the checkpoint are skipped
+        checkpoint = self.simulation_engine.checkpoint
+        self.source_manager_options["first_run_id"] = (
+            checkpoint.first_run_index if checkpoint is not None else 0
         )
 
         ms.Initialize(self.run_timing_intervals, self.source_manager_options)
+        if self.g4_primary_cache is not None:
+            ms.SetPrimaryCache(self.g4_primary_cache)
+        if self.g4_event_scheduler is not None:
+            ms.SetEventScheduler(self.g4_event_scheduler)
         self.expected_number_of_events = (
             ms.GetExpectedNumberOfEvents()
             * self.simulation_engine.simulation.number_of_threads
@@ -170,12 +260,53 @@ class SourceEngine(EngineBase):
 
         return ms
 
+    def all_g4_source_managers(self):
+        managers = list(self.g4_thread_source_managers or [])
+        if self.g4_master_source_manager is not None:
+            managers.append(self.g4_master_source_manager)
+        return managers
+
+    def start_new_job(self, run_timing_intervals):
+        """Server mode: the next call to start() simulates these runs, with
+        the sources initialized again from their (modified) user info.
+        The sources are initialized by each thread, before its first event."""
+        assert_run_timing(run_timing_intervals)
+        self.run_timing_intervals = run_timing_intervals
+        # the master thread parses the configurations shared (read only) by
+        # the sources of the workers, e.g. the acceptance angle
+        if self.simulation_engine.simulation.multithreaded:
+            self.initialize_sources_of_thread()
+        for ms in self.all_g4_source_managers():
+            ms.StartNewJob(self.run_timing_intervals)
+            ms.SetNewJobCallback(self.initialize_sources_of_thread)
+
+    def initialize_sources_of_thread(self):
+        source_manager = self.simulation_engine.simulation.source_manager
+        for source in source_manager.sources.values():
+            source.initialize(self.run_timing_intervals)
+
     def start(self):
         # FIXME (1) later : may replace BeamOn with DoEventLoop
         # to allow better control on geometry between the different runs
         # FIXME (2) : check estimated nb of particle, warning if too large
+        # the Python callbacks of the Geant4 threads (e.g. the ARF) are
+        # executed by this consumer thread, so that the Geant4 threads do
+        # not wait for the GIL
+        queue = g4.GateDeferredCallbackQueue.GetInstance()
+        consumer = threading.Thread(
+            target=queue.RunConsumer, name="gate_deferred_callbacks"
+        )
+        queue.Start()
+        consumer.start()
+
         # start the master thread (only main thread)
-        self.g4_master_source_manager.StartMasterThread()
+        try:
+            self.g4_master_source_manager.StartMasterThread()
+        finally:
+            queue.Stop()
+            consumer.join()
+            if self.g4_primary_cache is not None:
+                self.g4_primary_cache.Close()
 
         # once terminated, packup the sources (if needed)
         for source in self.sources:
@@ -226,6 +357,10 @@ class PhysicsEngine(EngineBase):
 
         self.optical_surfaces_properties_dict = {}
 
+        # folder where the physics tables will be stored at the end of the
+        # simulation (None if they are retrieved from the cache, or no cache)
+        self.physics_tables_to_store = None
+
     def close(self):
         if self.verbose_close:
             warning("Closing PhysicsEngine")
@@ -295,11 +430,90 @@ class PhysicsEngine(EngineBase):
         self.initialize_optical_surfaces()
         self.initialize_ionisation_options()
 
+    def get_physics_tables_key(self):
+        """Hash of everything the physics tables depend on: Geant4 version,
+        physics list, cuts, EM parameters, regions and materials (the materials
+        must be built, i.e. after the G4RunManager initialization)."""
+        simulation = self.simulation_engine.simulation
+        material_database = simulation.volume_manager.material_database
+        materials = [
+            (
+                name,
+                m.GetDensity(),
+                m.GetTotNbOfElectPerVolume(),
+                m.GetRadlen(),
+            )
+            for name, m in sorted(material_database.g4_materials.items())
+        ]
+        regions = {
+            name: dict(region.user_info)
+            for name, region in self.physics_manager.regions.items()
+        }
+        info = {
+            "g4_version": g4.GateInfo.get_G4Version(),
+            "physics_manager": dict(self.physics_manager.user_info),
+            "regions": regions,
+            "materials": materials,
+        }
+        # physics_tables_cache_dir itself is not part of the key
+        info["physics_manager"].pop("physics_tables_cache_dir", None)
+        s = json.dumps(info, sort_keys=True, default=str)
+        return hashlib.sha1(s.encode()).hexdigest()[:16]
+
+    def initialize_physics_tables_cache(self):
+        """Retrieve the physics tables from physics_tables_cache_dir if they have
+        been stored by a previous simulation with the same physics, otherwise
+        they will be stored at the end of this simulation.
+        Called after the G4RunManager initialization, before the tables are built.
+        """
+        self.physics_tables_to_store = None
+        cache_dir = self.physics_manager.physics_tables_cache_dir
+        if cache_dir is None:
+            return
+        path = Path(cache_dir) / self.get_physics_tables_key()
+        if (path / "done").exists():
+            # (Geant4 builds the tables that cannot be retrieved)
+            self.simulation_engine.add_g4_command_after_init(
+                f"/run/particle/retrievePhysicsTable {path}"
+            )
+        else:
+            self.physics_tables_to_store = path
+
+    def store_physics_tables(self):
+        """Store the physics tables built by this simulation in the cache"""
+        path = self.physics_tables_to_store
+        if path is None or not self.simulation_engine.distributed_context.is_root:
+            return
+        # several simulations may store the same tables at the same time:
+        # the folder is written under a temporary name, then renamed
+        tmp = path.with_name(f"{path.name}.tmp{os.getpid()}")
+        tmp.mkdir(parents=True, exist_ok=True)
+        self.simulation_engine.add_g4_command_after_init(
+            f"/run/particle/storePhysicsTable {tmp}"
+        )
+        (tmp / "done").touch()
+        try:
+            tmp.rename(path)
+        except OSError:
+            # already stored by another simulation
+            shutil.rmtree(tmp, ignore_errors=True)
+        self.physics_tables_to_store = None
+
     def initialize_parallel_world_physics(self):
         for (
             world
         ) in self.physics_manager.simulation.volume_manager.parallel_world_names:
-            pwp = g4.G4ParallelWorldPhysics(world, True)
+            particles = self.physics_manager.user_info.parallel_world_particles.get(
+                world
+            )
+            if particles is None:
+                pwp = g4.G4ParallelWorldPhysics(world, True)
+            else:
+                # only these particles see the parallel world
+                particles = [
+                    translate_particle_name_gate_to_geant4(p) for p in particles
+                ]
+                pwp = g4.GateParallelWorldPhysics(world, True, particles)
             self.g4_parallel_world_physics.append(pwp)
             self.g4_physics_list.RegisterPhysics(pwp)
 
@@ -631,14 +845,67 @@ class ActorEngine(EngineBase):
                 actor.ConfigureForWorker()
 
     def start_simulation(self):
+        # before the root tuples are created by the actors
+        simulation = self.simulation_engine.simulation
+        root_manager = g4.GateDigiCollectionsRootManager.GetInstance()
+        root_manager.SetNtupleMergingFlag(not simulation.sharded_root_output)
+        self.set_root_file_options(root_manager)
         # consider the priority value of the actors
         for actor in self.actor_manager.sorted_actors:
+            g4.TimelineBegin(actor.name, "StartSimulationAction")
             actor.StartSimulationAction()
+            g4.TimelineEnd(actor.name, "StartSimulationAction")
+
+    def set_root_file_options(self, root_manager):
+        # basket and compression of all the ROOT files (see ActorOutputRoot)
+        from .actors.actoroutput import ActorOutputRoot, merge_root_file_options
+
+        root_outputs = [
+            u
+            for actor in self.actor_manager.sorted_actors
+            for u in actor.user_output.values()
+            if isinstance(u, ActorOutputRoot)
+        ]
+        o = merge_root_file_options(root_outputs)
+        root_manager.SetRootFileOptions(
+            o["basket_size"], o["basket_entries"], o["compression_level"]
+        )
 
     def stop_simulation(self):
-        # consider the priority value of the actors
+        # the images of all the actors are written concurrently, and all
+        # written when the loop is over
+        simulation = self.simulation_engine.simulation
+        with deferred_image_writes(
+            simulation.number_of_output_threads, simulation.compress_output_images
+        ):
+            # consider the priority value of the actors
+            for actor in self.actor_manager.sorted_actors:
+                g4.TimelineBegin(actor.name, "EndSimulationAction")
+                actor.EndSimulationAction()
+                g4.TimelineEnd(actor.name, "EndSimulationAction")
+
+    def merge_distributed_root_outputs(self):
+        # (the ROOT files are closed at the end of the simulation)
+        from .actors.actoroutput import ActorOutputRoot
+        from .actors.digitizers import write_root_shards_manifest
+
+        simulation = self.simulation_engine.simulation
+        context = self.simulation_engine.distributed_context
+        if not context.is_distributed and not simulation.sharded_root_output:
+            return
         for actor in self.actor_manager.sorted_actors:
-            actor.EndSimulationAction()
+            for u in actor.user_output.values():
+                if not isinstance(u, ActorOutputRoot) or u.write_to_disk is not True:
+                    continue
+                if simulation.sharded_root_output:
+                    # no merge at all, only the list of the files
+                    write_root_shards_manifest(
+                        u.get_output_path(),
+                        simulation.number_of_threads,
+                        context,
+                    )
+                else:
+                    context.merge_root_files(u.get_output_path())
 
 
 class FilterEngine(EngineBase):
@@ -775,6 +1042,8 @@ class VolumeEngine(g4.G4VUserDetectorConstruction, EngineBase):
         # The world volume is the first item
 
         self.volume_manager.update_volume_tree()
+        # (the cached volume to world transforms are from a previous geometry)
+        g4.InvalidateVolumeTransformCache()
         for volume in PreOrderIter(self.volume_manager.world_volume):
             volume.construct()
 
@@ -911,6 +1180,66 @@ class VisualisationEngine(EngineBase):
                 pass
 
 
+def mutex_statistics_report(statistics):
+    """Total of the threads for each mutex, most contended first"""
+    totals = []
+    for name, threads in statistics.items():
+        keys = ["acquisitions", "contended", "wait", "hold"]
+        t = {k: sum(s[k] for s in threads.values()) for k in keys}
+        totals.append((name, len(threads), t))
+    totals.sort(key=lambda v: v[2]["wait"], reverse=True)
+    s = "Simulation: mutex statistics (acquisitions, contended, wait, hold)"
+    for name, n, t in totals:
+        wait = g4_best_unit(t["wait"], "Time")
+        hold = g4_best_unit(t["hold"], "Time")
+        s += f"\n{name} ({n} threads): {t['acquisitions']} {t['contended']} "
+        s += f"{wait} {hold}"
+    return s
+
+
+def write_timeline_chrome_trace(threads, filename):
+    """Chrome trace (json) of the markers of the timeline, one track per
+    thread. It can be opened with https://ui.perfetto.dev or chrome://tracing
+    """
+    pid = os.getpid()
+    trace = []
+    dropped = {}
+    for tid, t in enumerate(threads):
+        name = "master" if t["thread"] < 0 else f"worker {t['thread']}"
+        trace.append(
+            {
+                "name": "thread_name",
+                "ph": "M",
+                "pid": pid,
+                "tid": tid,
+                "args": {"name": name},
+            }
+        )
+        dropped[name] = t["dropped"]
+        # the oldest begin markers may have been overwritten (ring buffer)
+        depth = {}
+        for marker_name, category, phase, ns in t["events"]:
+            key = (marker_name, category)
+            if phase == "E":
+                if depth.get(key, 0) == 0:
+                    continue
+                depth[key] -= 1
+            else:
+                depth[key] = depth.get(key, 0) + 1
+            trace.append(
+                {
+                    "name": marker_name,
+                    "cat": category,
+                    "ph": phase,
+                    "ts": ns / 1000,
+                    "pid": pid,
+                    "tid": tid,
+                }
+            )
+    with open(filename, "w") as f:
+        json.dump({"traceEvents": trace, "otherData": {"dropped": dropped}}, f)
+
+
 class SimulationOutput:
     """
     FIXME
@@ -924,6 +1253,9 @@ class SimulationOutput:
         self.pid = os.getpid()
         self.ppid = os.getppid()
         self.current_random_seed = None
+        self.initialization_timings = {}
+        self.run_timings = {}
+        self.mutex_statistics = {}
         self.user_hook_log = []
         self.warnings = None
 
@@ -1029,6 +1361,27 @@ class SimulationEngine(GateSingletonFatal):
         self.g4_HepRandomEngine = None
         self.current_random_seed = None
 
+        # rank of this process in a distributed simulation (see distributed_mode)
+        self.distributed_context = DistributedContext(
+            simulation.distributed_mode, simulation.number_of_processes
+        )
+        set_distributed_context(self.distributed_context)
+
+        # checkpoints written at the end of the runs (see checkpoint_filename)
+        self.checkpoint = None
+
+        # wall clock time (in seconds) of each initialization step
+        self.initialization_timings = {}
+        self._initialization_step_start = None
+
+        # wall clock time (in seconds) of the run ("run") and of the end of
+        # the simulation, where the actors write their outputs ("output")
+        self.run_timings = {}
+
+        # contention of the mutexes of the last simulation (empty if
+        # opengate_core is compiled without OPENGATE_MUTEX_STATISTICS)
+        self.mutex_statistics = {}
+
         # Main Run Manager
         self.g4_RunManager = None
         self.g4_StateManager = g4.G4StateManager.GetStateManager()
@@ -1049,6 +1402,8 @@ class SimulationEngine(GateSingletonFatal):
         self.user_hook_log = []  # FIXME: turn this into dictionary
 
     def close_engines(self):
+        if self.checkpoint:
+            self.checkpoint.close()
         if self.volume_engine:
             self.volume_engine.close()
         if self.physics_engine:
@@ -1063,6 +1418,7 @@ class SimulationEngine(GateSingletonFatal):
             self.visu_engine.close()
 
     def release_engines(self):
+        self.checkpoint = None
         self.volume_engine = None
         self.physics_engine = None
         self.source_engine = None
@@ -1091,6 +1447,7 @@ class SimulationEngine(GateSingletonFatal):
             self.notify_managers()
             if self.g4_RunManager:
                 self.g4_RunManager.SetVerboseLevel(0)
+            set_distributed_context(None)
             self._is_closed = True
         self.g4_RunManager = None
 
@@ -1145,25 +1502,16 @@ class SimulationEngine(GateSingletonFatal):
             self.simulation.reset_warnings()
 
         # initialization
-        self.initialize()
-
-        # things to do after init and before run
-        self.apply_all_g4_commands_after_init()
+        self.initialize_and_run_user_hook()
         log = global_log
 
-        if self.user_hook_after_init:
-            log.info("Simulation: initialize user fct")
-            if self.user_hook_after_init_arg is not None:
-                self.user_hook_after_init(self, self.user_hook_after_init_arg)
-            else:
-                self.user_hook_after_init(self)
-
         # if init only, we stop
         if self.simulation.init_only:
             output.store_actors(self)
             output.store_sources(self)
             output.store_hook_log(self)
             output.current_random_seed = self.current_random_seed
+            output.initialization_timings = self.initialization_timings
             output.expected_number_of_events = (
                 self.source_engine.expected_number_of_events
             )
@@ -1171,7 +1519,10 @@ class SimulationEngine(GateSingletonFatal):
             return output
 
         # go
-        self.start_and_stop()
+        if self.distributed_context.mode == "fork":
+            self.start_and_stop_forked_processes()
+        else:
+            self.start_and_stop()
 
         # start visualization if vrml or gdml
         self.visu_engine.start_visualisation()
@@ -1184,11 +1535,27 @@ class SimulationEngine(GateSingletonFatal):
         output.store_sources(self)
         output.store_hook_log(self)
         output.current_random_seed = self.current_random_seed
+        output.initialization_timings = self.initialization_timings
+        output.run_timings = self.run_timings
+        output.mutex_statistics = self.mutex_statistics
         output.expected_number_of_events = self.source_engine.expected_number_of_events
         output.warnings = self.simulation.warnings
 
         return output
 
+    def initialize_and_run_user_hook(self):
+        self.initialize()
+
+        # things to do after init and before run
+        self.apply_all_g4_commands_after_init()
+
+        if self.user_hook_after_init:
+            global_log.info("Simulation: initialize user fct")
+            if self.user_hook_after_init_arg is not None:
+                self.user_hook_after_init(self, self.user_hook_after_init_arg)
+            else:
+                self.user_hook_after_init(self)
+
     def start_and_stop(self):
         """
         Start the simulation. The runs are managed in the SourceManager.
@@ -1206,16 +1573,51 @@ class SimulationEngine(GateSingletonFatal):
                 s2 = f"(cannot predict the number of events, max is {n}, e.g. acceptance_angle is enabled)"
         log.info("-" * 80 + f"\nSimulation: START {s}{s2}")
 
+        # mutex statistics (if compiled with OPENGATE_MUTEX_STATISTICS)
+        if g4.IsMutexStatisticsEnabled():
+            g4.ResetMutexStatistics()
+
+        # timeline of the threads (see timeline_filename)
+        sim = self.simulation
+        if sim.timeline_filename is not None:
+            g4.EnableTimeline(
+                True, sim.timeline_buffer_size, sim.timeline_events_per_chunk
+            )
+            g4.ResetTimeline()
+
         # actor: start simulation (only the master thread)
         self.actor_engine.start_simulation()
 
-        # go !
-        start = time.time()
-        self.source_engine.start()
-        end = time.time()
-
-        # actor: stop simulation (only the master thread)
-        self.actor_engine.stop_simulation()
+        # checkpoints: restore the state (if resumed) and write at the end of runs
+        if self.checkpoint is not None:
+            self.checkpoint.start()
+
+        # the image reductions of the master (merge of the runs, uncertainty)
+        # are split on a pool of threads: they are done between the runs and at
+        # the end, when the workers are idle
+        with parallel_image_reductions(sim.number_of_threads):
+            # go !
+            start = time.time()
+            g4.TimelineBegin("runs", "master")
+            self.source_engine.start()
+            g4.TimelineEnd("runs", "master")
+            end = time.time()
+
+            # actor: stop simulation (only the master thread)
+            self.actor_engine.stop_simulation()
+            self.actor_engine.merge_distributed_root_outputs()
+        self.run_timings = {"run": end - start, "output": time.time() - end}
+        if g4.IsMutexStatisticsEnabled():
+            self.mutex_statistics = g4.GetMutexStatistics()
+            log.info(mutex_statistics_report(self.mutex_statistics))
+        if sim.timeline_filename is not None:
+            g4.EnableTimeline(False, 0, 1)
+            f = sim.get_output_path(sim.timeline_filename)
+            write_timeline_chrome_trace(g4.GetTimelineEvents(), f)
+            log.info(f"Simulation: timeline in {f}")
+
+        # physics tables cache (see physics_tables_cache_dir)
+        self.physics_engine.store_physics_tables()
 
         # this is the end
         log.info(
@@ -1225,6 +1627,93 @@ class SimulationEngine(GateSingletonFatal):
             + "-" * 80
         )
 
+    def run_job(self, run_timing_intervals=None, random_seed=None):
+        """Server mode (see SimulationServer): simulate again, in this initialized
+        engine, the runs with the current user info of the sources and actors.
+        The geometry and the physics are the ones of the initialization."""
+        if not self.is_initialized:
+            fatal("The simulation engine must be initialized before a new job")
+        if run_timing_intervals is None:
+            run_timing_intervals = self.simulation.run_timing_intervals
+        self.run_timing_intervals = [list(i) for i in run_timing_intervals]
+        self.source_engine.start_new_job(self.run_timing_intervals)
+        if random_seed is not None:
+            self.current_random_seed = random_seed
+            g4.G4Random.setTheSeed(self.current_random_seed, 0)
+        # the data of the previous job are not kept
+        for actor in self.simulation.actor_manager.actors.values():
+            for output in actor.user_output.values():
+                if hasattr(output, "data_per_run"):
+                    output.data_per_run = {}
+        self.start_and_stop()
+
+    def check_fork_mode(self):
+        if self.distributed_context.mode != "fork":
+            return
+        s = self.simulation
+        if s.multithreaded:
+            fatal(
+                "The distributed mode 'fork' requires number_of_threads = 1: "
+                "the Geant4 threads cannot be forked"
+            )
+        options = {
+            "checkpoint_filename": s.checkpoint_filename,
+            "primary_cache_mode": s.primary_cache_mode,
+        }
+        for k, v in options.items():
+            if v is not None:
+                fatal(f"The option {k} cannot be used with the distributed mode 'fork'")
+        # (the background thread of a prefetcher is not in the forked processes)
+        for source in s.source_manager.sources.values():
+            if source.user_info.get("prefetch", False):
+                fatal(
+                    f"The option prefetch of the source '{source.name}' cannot be "
+                    f"used with the distributed mode 'fork'"
+                )
+
+    def start_and_stop_forked_processes(self):
+        """Distributed mode 'fork': the initialized simulation is forked, each
+        process simulates its share of the primaries, and the outputs are
+        merged by the current process (rank 0)."""
+        context = self.distributed_context
+        context.fork()
+        if context.is_root:
+            try:
+                self.initialize_forked_process()
+                self.start_and_stop()
+            finally:
+                context.join()
+            return
+        # the other processes stop once their data have been sent
+        exit_code = 0
+        try:
+            self.initialize_forked_process()
+            self.start_and_stop()
+        except BaseException:
+            traceback.print_exc()
+            exit_code = 1
+        finally:
+            sys.stdout.flush()
+            sys.stderr.flush()
+            os._exit(exit_code)
+
+    def initialize_forked_process(self):
+        context = self.distributed_context
+        # seed and share of the primaries of this process
+        self.current_random_seed = context.get_seed(self.current_random_seed)
+        g4.G4Random.setTheSeed(self.current_random_seed, 0)
+        for source in self.simulation.source_manager.sources.values():
+            source.distribute(context)
+        # the sources are initialized again with their share (see run_job)
+        self.source_engine.start_new_job(self.source_engine.run_timing_intervals)
+        # the ROOT outputs are written by each process (merged at the end)
+        from .actors.actoroutput import ActorOutputRoot
+
+        for actor in self.simulation.actor_manager.actors.values():
+            for u in actor.user_output.values():
+                if isinstance(u, ActorOutputRoot):
+                    u.initialize_cpp_parameters()
+
     def initialize_random_engine(self):
         engine_name = self.simulation.random_engine
         self.g4_HepRandomEngine = None
@@ -1232,9 +1721,11 @@ class SimulationEngine(GateSingletonFatal):
             self.g4_HepRandomEngine = g4.MixMaxRng()
         if engine_name == "MersenneTwister":
             self.g4_HepRandomEngine = g4.MTwistEngine()
+        if engine_name == "Philox":
+            self.g4_HepRandomEngine = g4.GatePhiloxEngine()
         if not self.g4_HepRandomEngine:
             s = f"Cannot find the random engine {engine_name}\n"
-            s += "Use: MersenneTwister or MixMaxRng"
+            s += "Use: MersenneTwister, MixMaxRng or Philox"
             fatal(s)
 
         # set the random engine
@@ -1244,6 +1735,11 @@ class SimulationEngine(GateSingletonFatal):
         else:
             self.current_random_seed = self.simulation.random_seed
 
+        # independent seed for each process of a distributed simulation
+        self.current_random_seed = self.distributed_context.get_seed(
+            self.current_random_seed
+        )
+
         # if windows, the long are 4 bytes instead of 8 bytes for python and unix system
         if os.name == "nt":
             self.current_random_seed = int(
@@ -1280,6 +1776,8 @@ class SimulationEngine(GateSingletonFatal):
         """
         # get log
         log = global_log
+        self.start_initialization_timings()
+        self.check_fork_mode()
 
         # g4 verbose
         self.initialize_g4_verbose()
@@ -1290,9 +1788,18 @@ class SimulationEngine(GateSingletonFatal):
         # init random engine (before the MTRunManager creation)
         self.initialize_random_engine()
 
+        # before any image or table is allocated
+        g4.GateHugePagesEnable(self.simulation.huge_pages)
+
+        # read the checkpoint if the simulation is resumed
+        # (before the sources, which skip the runs already simulated)
+        if self.simulation.checkpoint_filename is not None:
+            self.checkpoint = SimulationCheckpoint(self)
+
         # Some sources (e.g. PHID) need to perform computation once everything is defined in user_info but *before* the
         # initialization of the G4 engine starts. This can be done via this function.
         self.simulation.initialize_source_before_g4_engine()
+        self.end_initialization_step("sources_before_g4_engine")
 
         # create the run manager (assigned to self.g4_RunManager)
         if self.g4_RunManager:
@@ -1314,10 +1821,12 @@ class SimulationEngine(GateSingletonFatal):
         # check if some actors need UserEventInformation
         # FIXME: should go to ActorEngine
         self.initialize_user_event_information_flag()
+        self.end_initialization_step("run_manager")
 
         # Geometry initialization
         log.info("Simulation: initialize Geometry")
         self.volume_engine.initialize()
+        self.end_initialization_step("geometry")
 
         # Physics initialization
         log.info("Simulation: initialize Physics")
@@ -1325,12 +1834,14 @@ class SimulationEngine(GateSingletonFatal):
 
         # Apply G4 commands *before* init (after phys init)
         self.apply_all_g4_commands_before_init()
+        self.end_initialization_step("physics_list")
 
         # sources
         log.info("Simulation: initialize Source")
         self.source_engine.initialize(
             self.simulation.run_timing_intervals, self.simulation.progress_bar
         )
+        self.end_initialization_step("sources")
 
         # action
 
@@ -1359,14 +1870,19 @@ class SimulationEngine(GateSingletonFatal):
             self.g4_RunManager.InitializeWithoutFakeRun()
         else:
             self.g4_RunManager.Initialize()
+        # (geometry construction, materials and physics processes)
+        self.end_initialization_step("g4_run_manager")
 
         log.info("Simulation: initialize PhysicsEngine after RunManager initialization")
         self.physics_engine.initialize_after_runmanager()
         self.g4_RunManager.PhysicsHasBeenModified()
+        self.physics_engine.initialize_physics_tables_cache()
 
         # G4's MT RunManager needs an empty run to initialize workers
+        # (the physics tables are built here in MT, at the first run otherwise)
         if self.simulation.multithreaded is True:
             self.g4_RunManager.FakeBeamOn()
+        self.end_initialization_step("physics_tables")
 
         # Actions initialization
         # This must come after the G4RunManager initialization
@@ -1378,6 +1894,7 @@ class SimulationEngine(GateSingletonFatal):
         self.source_engine.initialize_actors()
         self.actor_engine.initialize()
         self.filter_engine.initialize()
+        self.end_initialization_step("actors")
 
         self.is_initialized = True
 
@@ -1385,9 +1902,13 @@ class SimulationEngine(GateSingletonFatal):
         if self.simulation.check_volumes_overlap:
             log.info("Simulation: check volumes overlap")
             self.check_volumes_overlap(verbose=False)
+            self.end_initialization_step("check_overlaps")
         else:
             log.info("Simulation: (no volumes overlap checking)")
 
+        s = ", ".join(f"{k} {v:.2f}" for k, v in self.initialization_timings.items())
+        log.info(f"Simulation: initialization timings (s): {s}")
+
         # Register sensitive detector.
         # if G4 was compiled with MT (regardless if it is used or not)
         # ConstructSDandField (in VolumeManager) will be automatically called
@@ -1395,6 +1916,16 @@ class SimulationEngine(GateSingletonFatal):
             fatal("DEBUG Register sensitive detector in no MT mode")
             # todo : self.actor_engine.register_sensitive_detectors()
 
+    def start_initialization_timings(self):
+        self.initialization_timings = {}
+        self._initialization_step_start = time.time()
+
+    def end_initialization_step(self, name):
+        """Store the wall clock time since the end of the previous step"""
+        t = time.time()
+        self.initialization_timings[name] = t - self._initialization_step_start
+        self._initialization_step_start = t
+
     def create_run_manager(self):
         """Get the correct RunManager according to the requested threads
         and make some basic settings.
@@ -1414,6 +1945,21 @@ class SimulationEngine(GateSingletonFatal):
             )
             g4_RunManager = g4.WrappedG4MTRunManager()
             g4_RunManager.SetNumberOfThreads(self.simulation.number_of_threads)
+            # NUMA placement of the workers, when they are created
+            numa_policy = self.simulation.numa_policy
+            g4.GateNumaConfigure(
+                numa_policy if numa_policy is not None else "",
+                self.simulation.numa_replicate_tables,
+            )
+            if numa_policy is not None:
+                log.info(
+                    f"Simulation: NUMA policy '{numa_policy}' on "
+                    f"{g4.GateNumaGetNumberOfNodes()} node(s)"
+                )
+            # Geant4 cannot clone the Philox engine for the workers, and the
+            # workers are pinned to their node when they start
+            if self.simulation.random_engine == "Philox" or numa_policy is not None:
+                g4.SetGateWorkerThreadInitialization(g4_RunManager)
         else:
             log.info("Simulation: create RunManager (single thread)")
             g4_RunManager = g4.WrappedG4RunManager()
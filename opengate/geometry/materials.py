@@ -3,6 +3,7 @@ import numpy as np
 import re
 from box import Box
 import itk
+import scipy.sparse
 
 import opengate_core as g4
 from ..utility import fatal, g4_units, g4_best_unit
@@ -144,12 +145,53 @@ def HU_find_max_density_difference(hu_min, hu_max, d_min, d_max, densities):
     return d_max - d_min
 
 
-def HounsfieldUnit_to_material(simulation, density_tolerance, file_mat, file_density):
+# materials created by HounsfieldUnit_to_material, per tables and tolerance
+# (the same CT tables are usually converted at each simulation of a process)
+HU_materials_cache = {}
+
+
+def HU_materials_cache_key(density_tolerance, file_mat, file_density, density_scaling):
+    key = [density_tolerance, density_scaling]
+    for f in (file_mat, file_density):
+        st = os.stat(f)
+        key += [os.path.abspath(f), st.st_mtime_ns, st.st_size]
+    return tuple(key)
+
+
+def HounsfieldUnit_to_material(
+    simulation, density_tolerance, file_mat, file_density, density_scaling=False
+):
     """
     Same function than in GateHounsfieldToMaterialsBuilder class.
     Probably far from optimal, put we keep the compatibility
+
+    With density_scaling, the density bins of the same composition are built
+    from a single base material (the first bin) with another density: Geant4
+    and the mu tables then only compute the physics tables once per
+    composition, instead of once per density bin.
+
+    The result is cached: converting again the same (unmodified) tables with
+    the same options only adds the materials to the database.
     """
 
+    db = simulation.volume_manager.material_database
+    key = HU_materials_cache_key(
+        density_tolerance, file_mat, file_density, density_scaling
+    )
+    if key in HU_materials_cache:
+        voxel_materials, material_args = HU_materials_cache[key]
+        for with_base, args in material_args:
+            if with_base:
+                db.add_material_with_base(*args)
+            else:
+                db.add_material_weights(*args)
+        created_materials = [m[1][0] for m in material_args]
+        return [list(c) for c in voxel_materials], created_materials
+
+    # (with_base, args) of the created materials, and the base material of
+    # each composition (element symbols and weights)
+    material_args = []
+    base_materials = {}
     materials, elements = HU_read_materials_table(file_mat)
     densities = HU_read_density_table(file_density)
     voxel_materials = []
@@ -215,9 +257,16 @@ def HounsfieldUnit_to_material(simulation, density_tolerance, file_mat, file_den
                 weights_nz[k] = weights_nz[k] / sum_of_weights
             # define a new material (will be created later at MaterialDatabase initialize)
             name = f'{mat["name"]}_{num}'
-            simulation.volume_manager.material_database.add_material_weights(
-                name, elems_symbol_nz, weights_nz, d * gcm3
-            )
+            composition = (tuple(elems_symbol_nz), tuple(weights_nz))
+            if density_scaling and composition in base_materials:
+                args = (name, base_materials[composition], d * gcm3)
+                db.add_material_with_base(*args)
+                material_args.append((True, args))
+            else:
+                args = (name, elems_symbol_nz, weights_nz, d * gcm3)
+                db.add_material_weights(*args)
+                material_args.append((False, args))
+                base_materials[composition] = name
             # get the final correspondence
             c = [h1, h2, name]
             voxel_materials.append(c)
@@ -225,6 +274,7 @@ def HounsfieldUnit_to_material(simulation, density_tolerance, file_mat, file_den
             num = num + 1
         #
         i = i + 1
+    HU_materials_cache[key] = ([list(c) for c in voxel_materials], material_args)
     return voxel_materials, created_materials
 
 
@@ -383,6 +433,76 @@ def create_mass_img(ct_itk, hu_density_file, overrides=dict()):
     return mass
 
 
+def overlap_weights_1d(origin_a, spacing_a, size_a, origin_b, spacing_b, size_b):
+    """
+    Length of the overlap between the voxels of two grids along one axis,
+    as a scipy sparse matrix (size_a, size_b). The origins are the centers of
+    the first voxels, like in ITK.
+    """
+    b_lo = origin_b - spacing_b / 2.0
+    b_edges = b_lo + np.arange(size_b + 1) * spacing_b
+    rows, cols, values = [], [], []
+    for i in range(size_a):
+        a_lo = origin_a - spacing_a / 2.0 + i * spacing_a
+        a_hi = a_lo + spacing_a
+        first = max(int(np.floor((a_lo - b_lo) / spacing_b)), 0)
+        last = min(int(np.ceil((a_hi - b_lo) / spacing_b)), size_b)
+        j = np.arange(first, last)
+        length = np.minimum(b_edges[j + 1], a_hi) - np.maximum(b_edges[j], a_lo)
+        m = length > 0
+        rows.append(np.full(np.count_nonzero(m), i))
+        cols.append(j[m])
+        values.append(length[m])
+    if size_a > 0:
+        rows, cols, values = (np.concatenate(x) for x in (rows, cols, values))
+    return scipy.sparse.csr_matrix((values, (rows, cols)), shape=(size_a, size_b))
+
+
+def create_mass_img_like(density_img, like_img):
+    """
+    Mass of the voxels of a grid (e.g. a dose scoring grid) from the overlaps
+    with the voxels of a density image (e.g. from a CT), without resampling.
+
+    Parameters
+    ----------
+    density_img : itk.Image
+        density in g/cm3, see create_density_img
+    like_img : itk.Image
+        the grid of the masses, in the same coordinate system as the density
+        image. Both images must have the identity direction.
+
+    Returns
+    -------
+    mass : itk.Image
+        image with the geometry of like_img. The voxel value is the mass of the
+        part of the voxel inside the density image, in grams.
+
+    """
+    rho = itk.array_view_from_image(density_img).astype(np.float64)
+    mass = rho
+    # the overlap of two voxels is the product of the overlaps along each
+    # axis, so the weights are applied one axis at a time (x is the last axis
+    # of the numpy array)
+    for axis in range(3):
+        w = overlap_weights_1d(
+            like_img.GetOrigin()[axis],
+            like_img.GetSpacing()[axis],
+            like_img.GetLargestPossibleRegion().GetSize()[axis],
+            density_img.GetOrigin()[axis],
+            density_img.GetSpacing()[axis],
+            density_img.GetLargestPossibleRegion().GetSize()[axis],
+        )
+        a = np.moveaxis(mass, 2 - axis, 0)
+        rest = a.shape[1:]
+        a = w @ a.reshape(a.shape[0], -1)
+        mass = np.moveaxis(a.reshape((w.shape[0],) + rest), 0, 2 - axis)
+    mass *= 1e-3  # density in g/cm3 -> volume in mm3
+
+    mass_img = itk.GetImageFromArray(np.ascontiguousarray(mass))
+    mass_img.CopyInformation(like_img)
+    return mass_img
+
+
 class ElementBuilder:
     """
     A description of a G4Element that can be build.
@@ -616,6 +736,7 @@ class MaterialDatabase:
         # additional manually added materials
         self.new_materials_nb_atoms = {}
         self.new_materials_weights = {}
+        self.new_materials_base = {}
         # built materials
         self.g4_materials = {}
         # built elements
@@ -715,6 +836,16 @@ class MaterialDatabase:
         name = args[0]
         self.new_materials_weights[name] = args
 
+    def add_material_with_base(self, name, base_name, density):
+        """
+        Same composition than the (user or NIST) material base_name, with
+        another density. The physics tables of the base material are used,
+        scaled by the density.
+        Usage example :
+        add_material_with_base("bone_2", "bone_1", 1.6 * gcm3)
+        """
+        self.new_materials_base[name] = (name, base_name, density)
+
     def initialize(self):
         self.init_NIST()
         self.init_user_mat()
@@ -740,6 +871,17 @@ class MaterialDatabase:
                 fatal(f"Cannot construct the material (weights): {mat_info}")
             self.g4_materials[mat_name] = mat
         self.new_materials_weights = []
+        # after the other materials, that may be their base materials
+        new_materials_base = self.new_materials_base
+        self.new_materials_base = {}
+        for mat_name, mat_info in new_materials_base.items():
+            if mat_name in self.g4_materials:
+                fatal(f"Material {mat_name} is already constructed")
+            self.FindOrBuildMaterial(mat_info[1])
+            mat = self.g4_NistManager.BuildMaterialWithNewDensity(*mat_info)
+            if mat is None:
+                fatal(f"Cannot construct the material (base): {mat_info}")
+            self.g4_materials[mat_name] = mat
 
     def FindOrBuildMaterial(self, material_name):
         self.init_NIST()
@@ -815,6 +815,12 @@ def _setter_hook_image(self, image):
     return image
 
 
+def _setter_hook_label_downsampling(self, factors):
+    if np.isscalar(factors):
+        return [int(factors)] * 3
+    return [int(f) for f in factors]
+
+
 class ImageVolume(VolumeBase, solids.ImageSolid):
     """
     Store information about a voxelized volume
@@ -823,6 +829,9 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
     voxel_materials: List
     image: str
     dump_label_image: str
+    navigation: str
+    max_run_length: int
+    label_downsampling: List
 
     user_info_defaults = {
         "voxel_materials": (
@@ -847,6 +856,39 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
                 "Set to None to dump no image."
             },
         ),
+        "navigation": (
+            "nested",
+            {
+                "doc": "How the voxels are placed and navigated. 'nested': replicas along X and Y "
+                "and a nested parameterisation along Z (one step per voxel). "
+                "'regular': one parameterised volume of all the voxels, navigated with the "
+                "Geant4 regular navigation, which skips the boundaries between voxels of "
+                "the same material (much fewer steps in CT images). "
+                "'runs': the voxels of each row (X) are merged in runs of the same "
+                "material, one parameterised box per run (one step per run).",
+                "allowed_values": ("nested", "regular", "runs"),
+            },
+        ),
+        "max_run_length": (
+            0,
+            {
+                "doc": "With navigation = 'runs', maximum number of voxels of a run "
+                "(granularity of the material runs). 0 means no limit: a run may cover a "
+                "whole row of the image.",
+            },
+        ),
+        "label_downsampling": (
+            [1, 1, 1],
+            {
+                "doc": "Factors (x, y, z) of the grid navigated by Geant4: each navigated voxel is "
+                "a block of factors voxels of the image, with the most frequent material of the "
+                "block. The image size must be a multiple of the factors. With a parallel world "
+                "copy of the volume at full resolution, restricted to the charged particles "
+                "(see PhysicsManager.set_parallel_world_particles), the photons cross the "
+                "coarse grid and the electrons the full grid.",
+                "setter_hook": _setter_hook_label_downsampling,
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -858,6 +900,8 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
         # ITK images
         self._itk_image = None  # the input
         self.label_image = None  # image storing material labels
+        # labels of the voxels navigated by Geant4 (label_downsampling)
+        self.navigation_label_image = None
         # G4 references (additionally to those in base class)
         self.g4_physical_x = None
         self.g4_physical_y = None
@@ -921,6 +965,16 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
             self.load_input_image()
         return np.array(self.itk_image.GetSpacing())
 
+    @property
+    def navigation_size_pix(self):
+        """Number of voxels of the grid navigated by Geant4"""
+        return self.size_pix // np.array(self.label_downsampling)
+
+    @property
+    def navigation_spacing(self):
+        """Spacing of the grid navigated by Geant4"""
+        return self.spacing * np.array(self.label_downsampling)
+
     # @requires_fatal("itk_image")
     @property
     def native_translation(self):
@@ -976,25 +1030,54 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
         self.label_image = self.create_label_image()
         if self.dump_label_image:
             self.save_label_image()
+        self.navigation_label_image = self.downsample_label_image(self.label_image)
         # set attributes of the solid
         self.half_size_mm = 0.5 * self.size_pix * self.spacing
-        self.half_spacing = 0.5 * self.spacing
+        self.half_spacing = 0.5 * self.navigation_spacing
         self.construct_material()
         self.construct_solid()
         self.construct_logical_volume()
-        self.g4_voxel_param = self.create_image_parametrisation()
+        self.g4_voxel_param = self.create_image_parametrisation(
+            self.navigation_label_image
+        )
         self.construct_physical_volume()
 
     def construct_physical_volume(self):
         super().construct_physical_volume()
 
+        if self.navigation == "regular":
+            # all the voxels in the image volume, regular navigation
+            self.g4_physical_z = g4.G4PVParameterised(
+                self.name + "_Z",
+                self.g4_logical_z,
+                self.g4_logical_volume,
+                g4.EAxis.kUndefined,
+                int(np.prod(self.navigation_size_pix)),
+                self.g4_voxel_param,
+                False,
+            )  # overlaps checking
+            self.g4_physical_z.SetRegularStructureId(1)
+            return
+        if self.navigation == "runs":
+            # one box per run of the same material
+            self.g4_physical_z = g4.G4PVParameterised(
+                self.name + "_Z",
+                self.g4_logical_z,
+                self.g4_logical_volume,
+                g4.EAxis.kUndefined,
+                self.g4_voxel_param.GetNumberOfRuns(),
+                self.g4_voxel_param,
+                False,
+            )  # overlaps checking
+            return
+
         self.g4_physical_y = g4.G4PVReplica(
             self.name + "_Y",
             self.g4_logical_y,
             self.g4_logical_volume,
             g4.EAxis.kYAxis,
-            self.size_pix[1],  # nReplicas
-            self.spacing[1],  # width
+            self.navigation_size_pix[1],  # nReplicas
+            self.navigation_spacing[1],  # width
             0.0,
         )  # offset
 
@@ -1004,8 +1087,8 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
             self.g4_logical_x,
             self.g4_logical_y,
             g4.EAxis.kXAxis,
-            self.size_pix[0],
-            self.spacing[0],
+            self.navigation_size_pix[0],
+            self.navigation_spacing[0],
             0.0,
         )
 
@@ -1014,22 +1097,24 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
             self.g4_logical_z,
             self.g4_logical_x,
             g4.EAxis.kZAxis,  # g4.EAxis.kUndefined, ## FIXME ?
-            self.size_pix[2],
+            self.navigation_size_pix[2],
             self.g4_voxel_param,
             False,
         )  # overlaps checking
 
     def construct_logical_volume(self):
         super().construct_logical_volume()
+        self.g4_logical_z = g4.G4LogicalVolume(
+            self.g4_solid_z, self.g4_material, self.name + "_log_Z"
+        )
+        if self.navigation != "nested":
+            return
         self.g4_logical_x = g4.G4LogicalVolume(
             self.g4_solid_x, self.g4_material, self.name + "_log_X"
         )
         self.g4_logical_y = g4.G4LogicalVolume(
             self.g4_solid_y, self.g4_material, self.name + "_log_Y"
         )
-        self.g4_logical_z = g4.G4LogicalVolume(
-            self.g4_solid_z, self.g4_material, self.name + "_log_Z"
-        )
 
     def create_material_to_label_lut(self, material=None, voxel_materials=None):
         if voxel_materials is None:
@@ -1066,21 +1151,21 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
         return itk_image
 
     def create_attenuation_image(self, database, energy):
-        # convert all materials to mu
-        label_to_mu = {}
+        # convert all materials to mu, once per label
         mu_handler = g4.GateMaterialMuHandler.GetInstance(database, 200)  # max in MeV
         prod_cuts_table = g4.G4ProductionCutsTable.GetProductionCutsTable()
+        # one batch lookup for all couples (ordered by couple index)
+        mu_of_couples = mu_handler.GetMuOfAllCouples(energy)
+        label_to_mu = np.zeros(max(self.material_to_label_lut.values()) + 1)
         for i in range(prod_cuts_table.GetTableSize()):
             couple = prod_cuts_table.GetMaterialCutsCouple(i)
             mat_name = str(couple.GetMaterial().GetName())
             label = self.material_to_label_lut[mat_name]
-            mu = mu_handler.GetMu(couple, energy)
-            label_to_mu[label] = mu
+            label_to_mu[label] = mu_of_couples[i]
 
+        # fill the image by gathering the mu of the label of each voxel
         arr = itk.GetArrayViewFromImage(self.label_image)
-        mu_arr = arr.copy().astype("float")
-        for label, mu in label_to_mu.items():
-            mu_arr[mu_arr == label] = mu
+        mu_arr = label_to_mu[arr]
         itk_mu_img = itk.GetImageFromArray(mu_arr)
         itk_mu_img.CopyInformation(self.itk_image)
         return itk_mu_img
@@ -1130,25 +1215,80 @@ class ImageVolume(VolumeBase, solids.ImageSolid):
         label_image.CopyInformation(itk_image)
         return label_image
 
+    def downsample_label_image(self, label_image):
+        """Labels of the grid navigated by Geant4: blocks of label_downsampling voxels,
+        with the most frequent label of the block (the same image without downsampling).
+        """
+        f = np.array(self.label_downsampling, dtype=int)
+        if np.all(f == 1):
+            return label_image
+        arr = itk.array_view_from_image(label_image)
+        size = np.array(arr.shape[::-1])
+        if len(f) != 3 or np.any(f < 1) or np.any(size % f != 0):
+            fatal(
+                f"The label_downsampling {self.label_downsampling} of the ImageVolume "
+                f"{self.name} must be 3 positive factors of the image size {size}."
+            )
+        n = size // f
+        # (z, y, x, voxels of the block)
+        blocks = (
+            arr.reshape(n[2], f[2], n[1], f[1], n[0], f[0])
+            .transpose(0, 2, 4, 1, 3, 5)
+            .reshape(n[2], n[1], n[0], -1)
+        )
+        counts = [
+            np.count_nonzero(blocks == label, axis=-1)
+            for label in range(int(arr.max()) + 1)
+        ]
+        coarse = np.argmax(np.stack(counts, axis=-1), axis=-1).astype(np.ushort)
+
+        # same extent: the first block center is moved by (f - 1) / 2 voxels
+        image = itk.image_from_array(coarse)
+        spacing = np.array(label_image.GetSpacing())
+        direction = np.array(label_image.GetDirection())
+        origin = np.array(label_image.GetOrigin()) + direction @ ((f - 1) * spacing / 2)
+        image.SetSpacing((spacing * f).tolist())
+        image.SetOrigin(origin.tolist())
+        image.SetDirection(label_image.GetDirection())
+        return image
+
     def create_image_parametrisation(self, label_image=None):
         if label_image is None:
             if self.label_image is None:
                 self.label_image = self.create_label_image()
             label_image = self.label_image
         # initialize parametrisation
-        g4_voxel_param = g4.GateImageNestedParameterisation()
+        if self.navigation == "regular":
+            g4_voxel_param = g4.GateImageRegularParameterisation()
+        elif self.navigation == "runs":
+            g4_voxel_param = g4.GateImageRunParameterisation()
+            g4_voxel_param.max_run_length = self.max_run_length
+        else:
+            g4_voxel_param = g4.GateImageNestedParameterisation()
 
         # send image to cpp size
         update_image_py_to_cpp(label_image, g4_voxel_param.cpp_edep_image, True)
         g4_voxel_param.initialize_image()
         g4_voxel_param.initialize_material(list(self.material_to_label_lut.keys()))
+        if self.navigation == "regular":
+            # the voxels fill the solid of the image volume
+            g4_voxel_param.initialize_container(self.g4_solid)
 
         return g4_voxel_param
 
     def update_label_image(self, label_image):
         """Needed for dynamic image parametrisation."""
+        if self.navigation == "runs":
+            fatal(
+                f"The label image of the ImageVolume {self.name} cannot be changed "
+                f"with navigation = 'runs' (the number of runs is fixed when the "
+                f"geometry is built). Use the 'nested' or 'regular' navigation."
+            )
+        self.navigation_label_image = self.downsample_label_image(label_image)
         # send image to cpp size
-        update_image_py_to_cpp(label_image, self.g4_voxel_param.cpp_edep_image, True)
+        update_image_py_to_cpp(
+            self.navigation_label_image, self.g4_voxel_param.cpp_edep_image, True
+        )
         self.g4_voxel_param.initialize_image()
 
     def save_label_image(self, path=None):
@@ -2,6 +2,8 @@ import itk
 import numpy as np
 from box import Box
 from scipy.spatial.transform import Rotation
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
 import math
 
 from .exception import fatal
@@ -12,23 +14,29 @@ from .geometry.utility import (
 from .definitions import __gate_list_objects__
 
 
-def update_image_py_to_cpp(py_img, cpp_img, copy_data=False):
-    cpp_img.set_size(py_img.GetLargestPossibleRegion().GetSize())
+def update_image_py_to_cpp(py_img, cpp_img, copy_data=False, allocate=True):
+    """
+    With allocate=False, only the geometry of the cpp image is set: it has no
+    pixel buffer until the cpp side allocates it (copy_data is ignored).
+    """
+    if allocate:
+        cpp_img.set_size(py_img.GetLargestPossibleRegion().GetSize())
     cpp_img.set_spacing(py_img.GetSpacing())
     cpp_img.set_origin(py_img.GetOrigin())
     # this is needed !
     cpp_img.set_region(
         py_img.GetLargestPossibleRegion().GetIndex(),
         py_img.GetLargestPossibleRegion().GetSize(),
+        allocate,
     )
     # It is really a pain to convert GetDirection into
     # something that can be read by SetDirection !
     d = py_img.GetDirection().GetVnlMatrix().as_matrix()
     rotation = itk.GetArrayFromVnlMatrix(d)
     cpp_img.set_direction(rotation)
-    if copy_data:
-        # FIXME: do we need to return arr to keep reference ?
-        # (on cpp side, a copy is made while it should not be needed)
+    if copy_data and allocate:
+        # the pixels are copied into the buffer allocated by set_region above
+        # (no second allocation on the cpp side)
         arr = itk.array_view_from_image(py_img)
         cpp_img.from_pyarray(arr)
 
@@ -158,8 +166,17 @@ def get_origin_wrt_images_g4_position(img_info1, img_info2, translation):
     return origin
 
 
-def get_py_image_from_cpp_image(cpp_image, view=True):
-    arr = cpp_image.to_pyarray()
+def get_py_image_from_cpp_image(cpp_image, view=True, share=False):
+    """
+    With share=True, the py image uses the pixel buffer of the cpp image
+    without copy. The cpp image keeps its buffer; it gets a new one when it is
+    allocated again (e.g. by update_image_py_to_cpp at the next run), so the
+    py image keeps its values.
+    """
+    if share:
+        arr = cpp_image.as_pyarray()
+    else:
+        arr = cpp_image.to_pyarray()
     image = itk_image_from_array(arr, view=view)
     image.SetOrigin(cpp_image.origin())
     image.SetSpacing(cpp_image.spacing())
@@ -308,6 +325,80 @@ def scale_itk_image(img, scale):
     return img2
 
 
+class ImageReductionPool:
+    """
+    Pool of threads for the voxel-wise operations on large images (sum of
+    the images of the runs, division, uncertainty): the slices of the images
+    are processed concurrently, numpy releases the GIL in its loops.
+    """
+
+    # below this number of voxels per chunk, the operation is not split
+    min_voxels_per_chunk = 1 << 18
+
+    def __init__(self, number_of_threads):
+        self.number_of_threads = max(1, number_of_threads)
+        self.executor = ThreadPoolExecutor(
+            max_workers=self.number_of_threads,
+            thread_name_prefix="gate_image_reduction",
+        )
+
+    def apply(self, func, shape):
+        """Call func(begin, end) on chunks of the first axis of an array."""
+        n = shape[0] if len(shape) > 0 else 0
+        voxels = int(np.prod(shape))
+        chunks = min(self.number_of_threads, n, voxels // self.min_voxels_per_chunk)
+        if chunks <= 1:
+            func(0, n)
+            return
+        bounds = np.linspace(0, n, chunks + 1).astype(int)
+        futures = [
+            self.executor.submit(func, b, e) for b, e in zip(bounds[:-1], bounds[1:])
+        ]
+        for future in futures:
+            future.result()
+
+    def shutdown(self):
+        self.executor.shutdown(wait=True)
+
+
+# pool used by the image reductions, if any (see parallel_image_reductions)
+_reduction_pool = None
+
+
+@contextmanager
+def parallel_image_reductions(number_of_threads):
+    """
+    The image reductions of this module (sum_itk_images, divide_itk_images,
+    apply_by_chunks) done in this context are split by slices on a pool of
+    threads, e.g. the idle worker threads at the end of the runs.
+    """
+    global _reduction_pool
+    if _reduction_pool is not None or number_of_threads <= 1:
+        # nested context, or nothing to change
+        yield
+        return
+    pool = ImageReductionPool(number_of_threads)
+    _reduction_pool = pool
+    try:
+        yield
+    finally:
+        _reduction_pool = None
+        pool.shutdown()
+
+
+def apply_by_chunks(func, shape):
+    """
+    Call func(begin, end) for chunks [begin, end[ of the first axis of the
+    arrays of this shape: all of them at once, or concurrently in the
+    context of parallel_image_reductions. The chunks must be independent.
+    """
+    pool = _reduction_pool
+    if pool is None:
+        func(0, shape[0] if len(shape) > 0 else 0)
+    else:
+        pool.apply(func, shape)
+
+
 def divide_itk_images(
     img1_numerator, img2_denominator, filterVal=0, replaceFilteredVal=0
 ):
@@ -318,10 +409,14 @@ def divide_itk_images(
             f"Cannot divide images of different shape. Found {imgarr1.shape} vs. {imgarr2.shape}."
         )
     imgarrOut = imgarr1.copy()
-    L_filterInv = imgarr2 != filterVal
-    imgarrOut[L_filterInv] = np.divide(imgarr1[L_filterInv], imgarr2[L_filterInv])
 
-    imgarrOut[np.invert(L_filterInv)] = replaceFilteredVal
+    def divide(b, e):
+        num, den, out = imgarr1[b:e], imgarr2[b:e], imgarrOut[b:e]
+        L_filterInv = den != filterVal
+        out[L_filterInv] = np.divide(num[L_filterInv], den[L_filterInv])
+        out[np.invert(L_filterInv)] = replaceFilteredVal
+
+    apply_by_chunks(divide, imgarrOut.shape)
     imgarrOut = itk_image_from_array(imgarrOut)
     imgarrOut.CopyInformation(img1_numerator)
     return imgarrOut
@@ -330,10 +425,15 @@ def divide_itk_images(
 def sum_itk_images(itk_image_list):
     if not itk_image_list:
         raise ValueError("The image list is empty.")
-    summed_image = itk.GetArrayFromImage(itk_image_list[0])
-    for itk_image in itk_image_list[1:]:
-        array = itk.GetArrayFromImage(itk_image)
-        summed_image = np.add(summed_image, array)
+    arrays = [itk.array_view_from_image(img) for img in itk_image_list]
+    # (same type as the successive np.add of the arrays)
+    summed_image = np.array(arrays[0], dtype=np.result_type(*arrays))
+
+    def add(b, e):
+        for array in arrays[1:]:
+            np.add(summed_image[b:e], array[b:e], out=summed_image[b:e])
+
+    apply_by_chunks(add, summed_image.shape)
     image = itk.GetImageFromArray(summed_image)
     image.CopyInformation(itk_image_list[0])
     return image
@@ -424,10 +524,72 @@ def compare_itk_image(filename1, filename2):
     return compare_itk_image_info(im1, im2) and compare_itk_image_content(im1, im2)
 
 
-def write_itk_image(img, file_path):
+def write_itk_image(img, file_path, compression=None):
     # TODO: check if filepath exists
     # TODO: add metadata to file header
-    itk.imwrite(img, str(file_path))
+    if _image_writer is not None:
+        _image_writer.write(img, file_path, compression)
+    else:
+        itk.imwrite(img, str(file_path), compression=bool(compression))
+
+
+class ImageWriterPool:
+    """
+    Write the images on a pool of threads: ITK releases the GIL while
+    writing (and compressing) an image, so several images are written
+    concurrently. The images must not be modified until wait() returns.
+    """
+
+    def __init__(self, number_of_threads, compression=False):
+        self.compression = compression
+        self.futures = []
+        # (the ITK writer module is loaded lazily: load it in this thread)
+        itk.ImageFileWriter
+        self.executor = ThreadPoolExecutor(
+            max_workers=max(1, number_of_threads),
+            thread_name_prefix="gate_image_writer",
+        )
+
+    def write(self, img, file_path, compression=None):
+        if compression is None:
+            compression = self.compression
+        self.futures.append(
+            self.executor.submit(
+                itk.imwrite, img, str(file_path), compression=bool(compression)
+            )
+        )
+
+    def wait(self):
+        futures, self.futures = self.futures, []
+        self.executor.shutdown(wait=True)
+        # the first error, if any, once all the images are written
+        for future in futures:
+            future.result()
+
+
+# writer used by write_itk_image, if any (see deferred_image_writes)
+_image_writer = None
+
+
+@contextmanager
+def deferred_image_writes(number_of_threads, compression=False):
+    """
+    The images written by write_itk_image in this context are written
+    concurrently (and compressed if requested), all of them are written when
+    the context exits.
+    """
+    global _image_writer
+    if _image_writer is not None or (number_of_threads <= 1 and not compression):
+        # nested context, or nothing to change
+        yield
+        return
+    pool = ImageWriterPool(number_of_threads, compression)
+    _image_writer = pool
+    try:
+        yield
+    finally:
+        _image_writer = None
+        pool.wait()
 
 
 def images_have_same_domain(image1, image2, tolerance=1e-5):
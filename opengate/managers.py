@@ -40,21 +40,24 @@ from .processing import dispatch_to_subprocess
 
 from .sources.generic import SourceBase, GenericSource
 from .sources.phspsources import PhaseSpaceSource
-from .sources.voxelsources import VoxelSource
+from .sources.voxelsources import VoxelSource, MultiChannelVoxelSource
 from .sources.gansources import GANSource, GANPairsSource
 from .sources.beamsources import IonPencilBeamSource, TreatmentPlanPBSource
 from .sources.phidsources import PhotonFromIonDecaySource
+from .sources.banksources import ParticleBankSource
 from .voxelize import voxelize_geometry
 
 source_types = {
     "GenericSource": GenericSource,
     "PhaseSpaceSource": PhaseSpaceSource,
     "VoxelSource": VoxelSource,
+    "MultiChannelVoxelSource": MultiChannelVoxelSource,
     "GANSource": GANSource,
     "GANPairsSource": GANPairsSource,
     "IonPencilBeamSource": IonPencilBeamSource,
     "PhotonFromIonDecaySource": PhotonFromIonDecaySource,
     "TreatmentPlanPBSource": TreatmentPlanPBSource,
+    "ParticleBankSource": ParticleBankSource,
 }
 
 from .geometry.volumes import (
@@ -79,8 +82,11 @@ from .actors.base import ActorBase
 from .actors.doseactors import (
     DoseActor,
     TLEDoseActor,
+    DoseRateActor,
     LETActor,
     FluenceActor,
+    BeamletDoseActor,
+    ROIDoseActor,
     ProductionAndStoppingActor,
 )
 from .actors.dynamicactors import DynamicGeometryActor
@@ -88,25 +94,40 @@ from .actors.arfactors import ARFActor, ARFTrainingDatasetActor
 from .actors.miscactors import (
     SimulationStatisticsActor,
     KillActor,
+    StepBatchActor,
     KillAccordingProcessesActor,
+    RangeRejectionActor,
+    OpticalFastResponseActor,
     AttenuationImageActor,
+    FlatGeometryActor,
+    CutsTuningActor,
 )
 from .actors.biasingactors import (
     GenericBiasingActorBase,
     ComptSplittingActor,
     BremSplittingActor,
     FreeFlightActor,
+    WoodcockTrackingActor,
+    WeightWindowActor,
+    RussianRouletteActor,
 )
 from .actors.digitizers import (
     DigitizerAdderActor,
+    DigitizerOnlineAdderActor,
     DigitizerBlurringActor,
     DigitizerSpatialBlurringActor,
     DigitizerReadoutActor,
     DigitizerEfficiencyActor,
     DigitizerProjectionActor,
+    ForcedDetectionActor,
     DigitizerEnergyWindowsActor,
     DigitizerHitsCollectionActor,
+    DigitizerCoincidenceSorterActor,
+    DigitizerDeadTimeActor,
+    DigitizerPileupActor,
+    DigitizerFusedChainActor,
     PhaseSpaceActor,
+    PhaseSpacePlaneActor,
 )
 
 particle_names_Gate_to_G4 = {
@@ -121,31 +142,49 @@ actor_types = {
     # dose related
     "DoseActor": DoseActor,
     "TLEDoseActor": TLEDoseActor,
+    "DoseRateActor": DoseRateActor,
     "LETActor": LETActor,
     "ProductionAndStoppingActor": ProductionAndStoppingActor,
     "FluenceActor": FluenceActor,
+    "BeamletDoseActor": BeamletDoseActor,
+    "ROIDoseActor": ROIDoseActor,
     # misc
     "AttenuationImageActor": AttenuationImageActor,
+    "FlatGeometryActor": FlatGeometryActor,
     "SimulationStatisticsActor": SimulationStatisticsActor,
     "KillActor": KillActor,
+    "StepBatchActor": StepBatchActor,
+    "CutsTuningActor": CutsTuningActor,
     "KillAccordingProcessesActor": KillAccordingProcessesActor,
+    "RangeRejectionActor": RangeRejectionActor,
+    "OpticalFastResponseActor": OpticalFastResponseActor,
     "DynamicGeometryActor": DynamicGeometryActor,
     "ARFActor": ARFActor,
     "ARFTrainingDatasetActor": ARFTrainingDatasetActor,
     # digit
     "PhaseSpaceActor": PhaseSpaceActor,
+    "PhaseSpacePlaneActor": PhaseSpacePlaneActor,
     "DigitizerAdderActor": DigitizerAdderActor,
+    "DigitizerOnlineAdderActor": DigitizerOnlineAdderActor,
     "DigitizerBlurringActor": DigitizerBlurringActor,
     "DigitizerSpatialBlurringActor": DigitizerSpatialBlurringActor,
     "DigitizerReadoutActor": DigitizerReadoutActor,
     "DigitizerEfficiencyActor": DigitizerEfficiencyActor,
     "DigitizerProjectionActor": DigitizerProjectionActor,
+    "ForcedDetectionActor": ForcedDetectionActor,
     "DigitizerEnergyWindowsActor": DigitizerEnergyWindowsActor,
     "DigitizerHitsCollectionActor": DigitizerHitsCollectionActor,
+    "DigitizerCoincidenceSorterActor": DigitizerCoincidenceSorterActor,
+    "DigitizerDeadTimeActor": DigitizerDeadTimeActor,
+    "DigitizerPileupActor": DigitizerPileupActor,
+    "DigitizerFusedChainActor": DigitizerFusedChainActor,
     # biasing
     "BremSplittingActor": BremSplittingActor,
     "ComptSplittingActor": ComptSplittingActor,
     "FreeFlightActor": FreeFlightActor,
+    "WoodcockTrackingActor": WoodcockTrackingActor,
+    "WeightWindowActor": WeightWindowActor,
+    "RussianRouletteActor": RussianRouletteActor,
 }
 
 
@@ -639,6 +678,15 @@ class PhysicsManager(GateObject):
                 "doc": "Switch on (True) or off (False) UserLimits, e.g. step limiter, for individual particles. Default: Step limiter is applied to all charged particles (in accordance with G4 default)."
             },
         ),
+        "parallel_world_particles": (
+            Box(),
+            {
+                "doc": "Dict of parallel world name: list of particles. The parallel world "
+                "(with its layered materials) is only seen by these particles, e.g. "
+                "sim.physics_manager.parallel_world_particles['fine_world'] = ['e-', 'e+']. "
+                "The parallel worlds that are not in the dict are seen by all the particles.",
+            },
+        ),
         "em_parameters": (
             Box(
                 [
@@ -676,6 +724,16 @@ class PhysicsManager(GateObject):
                 "Mostly used for using acolinearity during annihilation in some materials"
             },
         ),
+        "physics_tables_cache_dir": (
+            None,
+            {
+                "doc": "Folder where the Geant4 physics tables are stored and retrieved. "
+                "The tables are stored at the end of a simulation, in a sub-folder named "
+                "after a hash of the physics list, cuts, EM parameters, regions and materials, "
+                "and the next simulations with the same physics retrieve them instead of "
+                "building them (faster initialization). None (default): no cache. ",
+            },
+        ),
         # "processes_to_bias": (
         #     Box(
         #         [
@@ -940,6 +998,20 @@ class PhysicsManager(GateObject):
         region = self.find_or_create_region(volume_name)
         region.user_limits["min_range"] = min_range
 
+    def set_parallel_world_particles(self, world_name, particle_names):
+        """Only the given particles (e.g. the charged ones) see the parallel world."""
+        if world_name not in self.simulation.volume_manager.parallel_world_names:
+            fatal(
+                f"Cannot set the particles of the parallel world '{world_name}': "
+                f"it does not exist. Parallel worlds: "
+                f"{self.simulation.volume_manager.parallel_world_names}"
+            )
+        if isinstance(particle_names, str):
+            particle_names = [particle_names]
+        self.user_info.parallel_world_particles[world_name] = [
+            translate_particle_name_gate_to_geant4(p) for p in particle_names
+        ]
+
     def set_user_limits_particles(self, particle_names):
         if not isinstance(particle_names, (list, set, tuple)):
             particle_names = list([particle_names])
@@ -1284,8 +1356,26 @@ class Simulation(GateObject):
     g4_commands_after_init: List[str]
     init_only: bool
     progress_bar: bool
+    progress_filename: Optional[Path]
+    progress_interval: float
+    aggregate_sources: bool
+    event_scheduling: str
+    primary_cache_mode: Optional[str]
+    primary_cache_filename: Path
+    distributed_mode: Optional[str]
+    number_of_processes: int
+    sharded_root_output: bool
+    numa_policy: Optional[str]
+    numa_replicate_tables: bool
+    huge_pages: bool
+    number_of_output_threads: int
+    compress_output_images: bool
     dyn_geom_open_close: bool
     dyn_geom_optimise: bool
+    dynamic_sub_runs: bool
+    checkpoint_filename: Optional[Path]
+    checkpoint_interval: float
+    resume_from_checkpoint: bool
 
     user_info_defaults = {
         "verbose_level": (
@@ -1421,7 +1511,11 @@ class Simulation(GateObject):
             "MixMaxRng",
             {
                 "doc": "Name of the Geant4 random engine to be used. "
-                "MixMaxRng is recommended for multithreaded applications."
+                "MixMaxRng is recommended for multithreaded applications. "
+                "Philox is a counter-based engine: with event_scheduling='guided', "
+                "each event has its own stream (seed, run, event), so the results "
+                "do not depend on the number of threads.",
+                "allowed_values": ("MixMaxRng", "MersenneTwister", "Philox"),
             },
         ),
         "random_seed": (
@@ -1489,6 +1583,171 @@ class Simulation(GateObject):
                 "doc": "Display a progress bar during the simulation",
             },
         ),
+        "progress_filename": (
+            None,
+            {
+                "doc": "If set, the progress of the simulation (events, events/s, tracks/s, "
+                "steps/s, per-thread rates, current run, estimated remaining time, dose "
+                "uncertainty, output bytes) is written in this json file (relative to the "
+                "output_dir) at every progress_interval, e.g. for a job scheduler. With "
+                "the .prom extension, the file is written in the Prometheus text format.",
+            },
+        ),
+        "progress_interval": (
+            1.0,
+            {
+                "doc": "Wall clock interval (in seconds) between two updates of the progress "
+                "bar and of the progress_filename.",
+            },
+        ),
+        "timeline_filename": (
+            None,
+            {
+                "doc": "If set, the begin/end of the runs, of the chunks of events, of the "
+                "batch callbacks (ARF, GAN, phase space), of the flushes of the digi "
+                "collections, of the merges and of the master thread hooks of the actors "
+                "are recorded for each thread and written at the end of the simulation "
+                "in this Chrome trace json file (relative to the output_dir), to be opened "
+                "with https://ui.perfetto.dev or chrome://tracing.",
+            },
+        ),
+        "timeline_buffer_size": (
+            100000,
+            {
+                "doc": "Number of markers kept per thread for the timeline_filename "
+                "(ring buffer: the oldest markers are overwritten).",
+            },
+        ),
+        "timeline_events_per_chunk": (
+            1000,
+            {
+                "doc": "Number of events of each 'events' marker of the timeline_filename.",
+            },
+        ),
+        "aggregate_sources": (
+            False,
+            {
+                "doc": "For advanced users: the sources defined by an activity (without TAC), "
+                "with the same start time, end time and half-life, share a single Poisson process: "
+                "the time of the next event is sampled once with the total activity of these sources, "
+                "and the emitting source is selected according to its activity. "
+                "This is statistically equivalent and much faster with many sources (e.g. one per lesion), "
+                "but the sequence of random numbers (hence the results) is not the same.",
+            },
+        ),
+        "event_scheduling": (
+            "static",
+            {
+                "doc": "Multithreading only. With 'static', each thread simulates n events of each "
+                "source (n x number_of_threads events). With 'guided', the same total number of "
+                "events is shared by all the threads: each thread takes chunks of events, smaller "
+                "at the end of the run, so that the threads end at the same time, and the random "
+                "engine is seeded for each event, so that the results do not depend on the number "
+                "of threads. Only for the sources defined by n (not by an activity).",
+                "allowed_values": ("static", "guided"),
+            },
+        ),
+        "primary_cache_mode": (
+            None,
+            {
+                "doc": "With 'record', the primaries generated by the sources (vertices, particles, "
+                "energies, directions, times and weights) are stored in the binary file "
+                "primary_cache_filename. With 'replay', the primaries of this file are simulated "
+                "instead of the sources (no sampling at all), e.g. to simulate the same primaries "
+                "with several geometries. Each event is replayed once, in the same run, whatever "
+                "the number of threads.",
+                "allowed_values": (None, "record", "replay"),
+            },
+        ),
+        "primary_cache_filename": (
+            "primaries.cache",
+            {
+                "doc": "File of the primary cache (see primary_cache_mode), relative to the "
+                "output_dir unless it is an absolute path.",
+            },
+        ),
+        "distributed_mode": (
+            None,
+            {
+                "doc": "For cluster jobs: with 'mpi', the simulation is distributed over the "
+                "processes started by mpirun (requires mpi4py). Each process simulates "
+                "its share of the primaries, with its own seed derived from random_seed. "
+                "At the end, the images, the statistics and the ROOT outputs are "
+                "merged on the process of rank 0, which writes the output files, "
+                "like one single simulation. With 'fork', the current process forks "
+                "number_of_processes processes (itself included) once the simulation "
+                "is initialized: the geometry, materials, physics tables and source "
+                "data are shared (copy-on-write) instead of being duplicated. "
+                "The fork mode requires a single thread (Linux and macOS only).",
+                "allowed_values": (None, "mpi", "fork"),
+            },
+        ),
+        "number_of_processes": (
+            1,
+            {
+                "doc": "Number of processes of the distributed mode 'fork' "
+                "(including the current process).",
+            },
+        ),
+        "sharded_root_output": (
+            False,
+            {
+                "doc": "Multithreading only. If True, the ROOT outputs of the digitizers and "
+                "phase spaces are not merged at the end of the simulation: each thread writes its own file "
+                "(<name>_t<N>.root, and <name>_rank<R>_t<N>.root if distributed), and a small "
+                "manifest <name>.shards.json lists all these files. This avoids the (long, serial) "
+                "merge and the memory used by the rows until the end. "
+                "Use read_root_output (opengate.actors.digitizers) to read them as one dataset.",
+            },
+        ),
+        "numa_policy": (
+            None,
+            {
+                "doc": "Multithreading only (Linux). Placement of the worker threads on the NUMA "
+                "nodes (sockets) of the machine: 'compact' fills the cpus of a node before the "
+                "next one, 'spread' places the threads on the nodes in turn. Each thread is "
+                "pinned to the cpus of its node before it allocates its memory (physics tables, "
+                "buffers of the actors and sources), which is then on its own node. "
+                "None (default): the threads are not pinned.",
+                "allowed_values": (None, "compact", "spread"),
+            },
+        ),
+        "numa_replicate_tables": (
+            False,
+            {
+                "doc": "With numa_policy, the shared read-only tables (mu tables of the TLE "
+                "dose actor) are copied on each NUMA node, so that the threads only read "
+                "the memory of their node.",
+            },
+        ),
+        "huge_pages": (
+            False,
+            {
+                "doc": "Linux only. If True, the large buffers read or written at random "
+                "positions during the tracking (images of the actors and of the voxelized "
+                "volumes, per-thread dose buffers, mu tables, alias tables of the voxel "
+                "sources) are backed by transparent huge pages (madvise), which lowers the "
+                "TLB misses. The bytes are reported by the memory accounting (type "
+                "'huge_pages') of the SimulationStatisticsActor.",
+            },
+        ),
+        "number_of_output_threads": (
+            4,
+            {
+                "doc": "Number of threads used to write the output images (e.g. dose, "
+                "uncertainty, counts) at the end of the simulation: the images of all the "
+                "actors are written concurrently. 1 writes them one after the other.",
+            },
+        ),
+        "compress_output_images": (
+            False,
+            {
+                "doc": "If True, the output images are written compressed (zlib, e.g. "
+                ".mhd with a .zraw file). Slower to write, but much smaller for sparse "
+                "images; the compression of different images runs in parallel "
+                "(see number_of_output_threads).",
+            },
+        ),
         "dyn_geom_open_close": (
             True,
             {
@@ -1499,6 +1758,47 @@ class Simulation(GateObject):
             True,
             {"doc": "'Optimise' geometry when open/close during dynamic simulation. "},
         ),
+        "dynamic_sub_runs": (
+            False,
+            {
+                "doc": "For dynamic simulations with many (contiguous) run timing intervals, e.g. "
+                "a SPECT gantry rotation. If True, all the intervals are simulated in a single Geant4 "
+                "run: the translations and rotations of the dynamic volumes (and the sources attached "
+                "to them) are changed in C++ before the first event of each interval, from a motion "
+                "table built at initialization, instead of starting a new run for each interval. "
+                "The actors see one single run. Sequential simulation only (one thread), and no "
+                "dynamic image.",
+            },
+        ),
+        "checkpoint_filename": (
+            None,
+            {
+                "doc": "For long simulations that may be stopped (e.g. preempted cluster jobs). "
+                "If set, the state of the simulation is written in this (binary) file at the end "
+                "of the runs: the state of the random engine, the index of the next run, the "
+                "counts of the SimulationStatisticsActor and the data of the image actors. "
+                "Relative paths are taken relative to the output_dir. "
+                "See resume_from_checkpoint and checkpoint_interval. The checkpoints are written "
+                "between two runs only: split a long simulation in several run_timing_intervals.",
+            },
+        ),
+        "checkpoint_interval": (
+            0,
+            {
+                "doc": "Minimum wall clock time (in seconds) between two checkpoints. "
+                "With 0 (default), a checkpoint is written at the end of every run "
+                "(except the last one).",
+            },
+        ),
+        "resume_from_checkpoint": (
+            False,
+            {
+                "doc": "If True and the checkpoint_filename exists, the simulation restarts "
+                "from the checkpoint: the runs already simulated are skipped, and the results "
+                "are the same as the ones of the simulation without interruption "
+                "(same number of threads and random_engine required).",
+            },
+        ),
     }
 
     def __init__(self, name="simulation", **kwargs):
@@ -1536,6 +1836,15 @@ class Simulation(GateObject):
 
         self.expected_number_of_events = None
 
+        # wall clock time (in seconds) of each initialization step
+        self.initialization_timings = {}
+
+        # wall clock time (in seconds) of the run and of the outputs writing
+        self.run_timings = {}
+
+        # contention of the mutexes (see OPENGATE_MUTEX_STATISTICS)
+        self.mutex_statistics = {}
+
     def __str__(self):
         s = (
             f"Simulation name: {self.name} \n"
@@ -1756,6 +2065,20 @@ class Simulation(GateObject):
             )
 
         # prepare sub process
+        if start_new_process is True and self.distributed_mode == "mpi":
+            fatal(
+                "A distributed simulation (distributed_mode) cannot be run "
+                "with start_new_process=True: each process started by mpirun "
+                "runs its own simulation engine."
+            )
+        if start_new_process is True and any(
+            isinstance(s, ParticleBankSource)
+            for s in self.source_manager.sources.values()
+        ):
+            fatal(
+                "A ParticleBankSource cannot be used with start_new_process=True: "
+                "the particles are pushed in memory by the current process."
+            )
         if start_new_process is True:
             """Important: put:
                 if __name__ == '__main__':
@@ -1799,6 +2122,9 @@ class Simulation(GateObject):
         # store the hook log
         self.user_hook_log = output.user_hook_log
         self._current_random_seed = output.current_random_seed
+        self.initialization_timings = output.initialization_timings
+        self.run_timings = output.run_timings
+        self.mutex_statistics = output.mutex_statistics
 
         if self.store_json_archive is True:
             self.to_json_file()
@@ -1823,8 +2149,21 @@ class Simulation(GateObject):
         margin=0,
         filename=None,
         return_path=False,
+        number_of_threads=0,
+        refinement_block_size=1,
+        supersampling=1,
     ):
-        return voxelize_geometry(self, extent, spacing, margin, filename, return_path)
+        return voxelize_geometry(
+            self,
+            extent,
+            spacing,
+            margin,
+            filename,
+            return_path,
+            number_of_threads,
+            refinement_block_size,
+            supersampling,
+        )
 
     def initialize_source_before_g4_engine(self):
         """
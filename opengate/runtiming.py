@@ -55,3 +55,18 @@ def range_timing(start, end, n):
         t.append(interval)
         start = start + step
     return t
+
+
+def merge_sub_runs(run_timing_intervals):
+    """
+    Return the single time interval covering all the intervals (sub-runs,
+    see the option dynamic_sub_runs). The intervals must be contiguous.
+    """
+    assert_run_timing(run_timing_intervals)
+    for previous, i in zip(run_timing_intervals[:-1], run_timing_intervals[1:]):
+        if i[0] != previous[1]:
+            fatal(
+                f"With dynamic_sub_runs, the run timing intervals must be contiguous, "
+                f"while {info_timing(i)} does not start at the end of {info_timing(previous)}"
+            )
+    return [[run_timing_intervals[0][0], run_timing_intervals[-1][1]]]
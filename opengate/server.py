@@ -0,0 +1,161 @@
+import time
+from multiprocessing.connection import Listener, Client
+
+from .engines import SimulationEngine
+from .exception import fatal
+from .logger import global_log
+
+# message sent by a client to stop the server
+stop_message = "stop"
+
+
+def set_attribute(obj, name, value):
+    """Set an attribute of a source or an actor, the name may be dotted
+    (e.g. "energy.mono" for the energy of a GenericSource)"""
+    *parents, last = name.split(".")
+    for p in parents:
+        obj = getattr(obj, p)
+    setattr(obj, last, value)
+
+
+class SimulationServer:
+    """Keep an initialized simulation alive, and simulate the jobs sent by the
+    clients (see SimulationClient) without initializing again: only the runs
+    of each job are executed. This is useful for many small simulations with
+    the same geometry and physics (e.g. QA pipelines).
+
+    A job is a dict with the (optional) keys:
+
+    - "sources": {source name: {attribute: value}}
+    - "actors": {actor name: {attribute: value}}
+    - "output_dir": output folder of the job
+    - "run_timing_intervals": the runs of the job
+    - "random_seed": seed of the job (int)
+
+    The attribute names may be dotted (e.g. "energy.mono"). The changes are
+    kept for the next jobs. The geometry, the physics and the list of sources
+    and actors are the ones of the initialization: they cannot be changed.
+    The sources are initialized again by each thread at the start of a job.
+    The attributes of the actors used at the initialization (e.g. the size
+    of an image) cannot be changed, the ones used to write the outputs can
+    (e.g. output_filename).
+
+    The jobs are received with multiprocessing.connection: the address is a
+    (host, port) tuple or the path of a Unix socket, the authkey (bytes) is
+    required because the messages are pickled.
+    """
+
+    def __init__(self, simulation, address, authkey):
+        self.simulation = simulation
+        self.address = address
+        self.authkey = authkey
+        self.simulation_engine = None
+        self.number_of_jobs = 0
+        self.stopped = False
+        self.check_simulation()
+
+    def check_simulation(self):
+        s = self.simulation
+        options = {
+            "checkpoint_filename": s.checkpoint_filename,
+            "primary_cache_mode": s.primary_cache_mode,
+            "distributed_mode": s.distributed_mode,
+        }
+        for k, v in options.items():
+            if v is not None:
+                fatal(f"The option {k} cannot be used by a SimulationServer")
+        if s.dynamic_sub_runs:
+            fatal("The option dynamic_sub_runs cannot be used by a SimulationServer")
+        if s.event_scheduling == "guided" and s.multithreaded:
+            fatal("The guided event scheduling cannot be used by a SimulationServer")
+
+    def serve(self):
+        """Initialize the simulation, then simulate the jobs until a client
+        sends the stop message. Must be called in the main thread."""
+        with SimulationEngine(self.simulation) as se:
+            self.simulation_engine = se
+            se.initialize_and_run_user_hook()
+            with Listener(self.address, authkey=self.authkey) as listener:
+                global_log.info(f"Simulation server: listening on {self.address}")
+                while not self.stopped:
+                    with listener.accept() as connection:
+                        self.handle_connection(connection)
+            self.simulation_engine = None
+        global_log.info(f"Simulation server: stop after {self.number_of_jobs} jobs")
+
+    def handle_connection(self, connection):
+        # the jobs of a client, until it closes the connection
+        while True:
+            try:
+                job = connection.recv()
+            except EOFError:
+                return
+            if job == stop_message:
+                self.stopped = True
+                connection.send({"stopped": True})
+                return
+            try:
+                result = self.run_job(job)
+            except Exception as e:
+                result = {"error": f"{type(e).__name__}: {e}"}
+            connection.send(result)
+
+    def run_job(self, job):
+        s = self.simulation
+        for name, attributes in job.get("sources", {}).items():
+            source = s.source_manager.get_source(name)
+            for k, v in attributes.items():
+                set_attribute(source, k, v)
+        for name, attributes in job.get("actors", {}).items():
+            actor = s.actor_manager.get_actor(name)
+            for k, v in attributes.items():
+                set_attribute(actor, k, v)
+        if "output_dir" in job:
+            s.output_dir = job["output_dir"]
+
+        start = time.time()
+        self.simulation_engine.run_job(
+            job.get("run_timing_intervals"), job.get("random_seed")
+        )
+        self.number_of_jobs += 1
+
+        # the counts of the statistics actors are sent back
+        counts = {
+            actor.name: dict(actor.counts)
+            for actor in s.actor_manager.actors.values()
+            if actor.type_name == "SimulationStatisticsActor"
+        }
+        return {"duration": time.time() - start, "counts": counts}
+
+
+class SimulationClient:
+    """Send jobs to a SimulationServer (see SimulationServer for the content
+    of a job). The jobs are simulated one after the other."""
+
+    def __init__(self, address, authkey):
+        self.connection = Client(address, authkey=authkey)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, _type, value, traceback):
+        self.close()
+
+    def close(self):
+        if self.connection is not None:
+            self.connection.close()
+            self.connection = None
+
+    def run(self, job):
+        """Simulate a job, return a dict with its duration and the counts of
+        the statistics actors"""
+        self.connection.send(job)
+        result = self.connection.recv()
+        if "error" in result:
+            fatal(f"The job failed on the simulation server: {result['error']}")
+        return result
+
+    def stop_server(self):
+        self.connection.send(stop_message)
+        self.connection.recv()
+        self.close()
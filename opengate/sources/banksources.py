@@ -0,0 +1,128 @@
+import numpy as np
+
+import opengate_core as g4
+from .base import SourceBase
+from ..base import process_cls
+from ..exception import fatal
+
+
+class ParticleBankSource(SourceBase, g4.GateParticleBankSource):
+    """
+    Source of particles pushed in memory during the simulation by an external
+    producer (e.g. a beamline code running in another Python thread), through
+    a bounded bank of particles (no file).
+
+    The producer calls source.push(...) to add particles (it waits while the
+    bank is full) and source.close_bank() at the end of the stream. The Geant4
+    threads wait while the bank is empty. The run stops when the bank is
+    closed and empty (or after 'n' particles per thread, if n > 0).
+
+    If "global flag" is True, the position/direction are global, ie in the world
+    coordinate system. If it is False, it uses the coordinate system of the volume
+    it is attached to.
+    """
+
+    # hints for IDE
+    particle: str
+    global_flag: bool
+    capacity: int
+    batch_size: int
+    timeout: float
+
+    user_info_defaults = {
+        "particle": (
+            None,
+            {
+                "doc": "Particle of the source, used for the particles pushed without "
+                "PDGCode (or with a PDGCode 0)",
+            },
+        ),
+        "global_flag": (
+            False,
+            {
+                "doc": "If true, the positions of the pushed particles are in the world "
+                "coordinate system. If false, they are relative to the volume "
+                "this source is attached to",
+            },
+        ),
+        "capacity": (
+            100000,
+            {
+                "doc": "Maximum number of particles in the bank. When the bank is full, "
+                "the producer waits for the Geant4 threads (back-pressure)",
+            },
+        ),
+        "batch_size": (
+            1000,
+            {
+                "doc": "Number of particles taken from the bank at once by each thread",
+            },
+        ),
+        "timeout": (
+            0,
+            {
+                "doc": "Maximum time (in seconds, not in Geant4 units) a thread waits "
+                "for particles when the bank is empty. After that, the stream is "
+                "considered finished. 0 means wait until the bank is closed",
+            },
+        ),
+    }
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(self, *args, **kwargs)
+        self.__initcpp__()
+        self._bank = None
+
+    def __initcpp__(self):
+        g4.GateParticleBankSource.__init__(self)
+
+    def __getstate__(self):
+        # the bank (and the particles in it) is not pickled
+        self._bank = None
+        return super().__getstate__()
+
+    @property
+    def bank(self):
+        """The bank of particles shared by the producer and the Geant4 threads
+        (created at the first access)."""
+        if self._bank is None:
+            capacity = int(self.capacity)
+            if capacity < 1:
+                fatal(f"ParticleBankSource {self.name}: capacity must be at least 1")
+            self._bank = g4.GateParticleBank(capacity)
+        return self._bank
+
+    def push(self, energy, position, direction, pdg=None, weight=None, time=None):
+        """Add particles to the bank: energy (N), position (N, 3) and direction
+        (N, 3). pdg, weight and time are a single value or N values (by default,
+        the particle of the source, weight 1 and the time of the source).
+        Wait while the bank is full. Return the number of added particles (less
+        than N if the bank is closed meanwhile)."""
+        energy = np.ascontiguousarray(energy, dtype=np.float64).ravel()
+        position = np.ascontiguousarray(position, dtype=np.float64)
+        direction = np.ascontiguousarray(direction, dtype=np.float64)
+        pdg = np.zeros(0, dtype=np.int32) if pdg is None else pdg
+        pdg = np.ascontiguousarray(pdg, dtype=np.int32).ravel()
+        return self.bank.Push(pdg, energy, position, direction, weight, time)
+
+    def close_bank(self):
+        """End of the stream: the threads stop when the bank is empty."""
+        self.bank.Close()
+
+    def initialize(self, run_timing_intervals):
+        self.batch_size = int(self.batch_size)
+        if self.batch_size < 1:
+            fatal(f"ParticleBankSource {self.name}: batch_size must be at least 1")
+        if self.activity > 0:
+            fatal(
+                f"ParticleBankSource {self.name}: the activity is not used, the "
+                f"particles are the ones of the bank (use 'n' to limit them)"
+            )
+        SourceBase.initialize(self, run_timing_intervals)
+        self.SetBank(self.bank)
+
+    def can_predict_number_of_events(self):
+        return False
+
+
+process_cls(ParticleBankSource)
@@ -1,6 +1,9 @@
 from box import Box
 import os
 import pathlib
+import threading
+import collections
+from concurrent.futures import ThreadPoolExecutor
 import numpy as np
 import json
 
@@ -128,6 +131,67 @@ def get_rad_beta_spectrum(rad: str):
     return data
 
 
+def get_rad_beta_plus_decay(Z, A):
+    """
+    Decay branches of the beta+ radionuclide (Z, A), see rad_beta_plus_decay.json.
+    Return the name of the radionuclide and the list of branches (probability
+    per decay, positron or not, energies of the prompt gammas), or None if the
+    radionuclide is not tabulated.
+    """
+    path = (
+        pathlib.Path(os.path.dirname(__file__))
+        / ".."
+        / "data"
+        / "rad_beta_plus_decay.json"
+    )
+    with open(path, "r") as f:
+        data = json.load(f)
+
+    for rad, d in data.items():
+        if d["Z"] == int(Z) and d["A"] == int(A):
+            branches = []
+            for b in d["branches"]:
+                b = Box(b)
+                b.gammas = [g * g4_units.MeV for g in b.gammas]
+                branches.append(b)
+            return rad, branches
+    return None, None
+
+
+# Positron range in water: bi-exponential fit of the projected (1D)
+# annihilation distribution C exp(-k1 x) + (1 - C) exp(-k2 x), k in 1/mm
+# (Levin and Hoffman, PMB 44, 1999)
+positron_range_kernels = {
+    "F18": (0.516, 37.9, 3.10),
+    "C11": (0.488, 23.8, 1.8),
+    "N13": (0.426, 20.2, 1.4),
+    "O15": (0.379, 18.1, 0.9),
+}
+
+
+def get_positron_range_kernel(isotope, density):
+    """
+    3D kernel of the positron range of the isotope in a material of the given
+    density (the range scales as 1/density, relative to the water): the
+    distance is the mixture of two Gamma(2, 1/k) distributions (the 3D
+    distribution of each exponential of the projected one).
+    Return [probability of the first component, k1, k2] (k in 1/length).
+    """
+    if isotope not in positron_range_kernels:
+        fatal(
+            f"No positron range kernel for the isotope '{isotope}'. "
+            f"Available: {list(positron_range_kernels.keys())}"
+        )
+    c, k1, k2 = positron_range_kernels[isotope]
+    scale = density / (g4_units.g / g4_units.cm3) / g4_units.mm
+    k1 *= scale
+    k2 *= scale
+    # weights of the normalized components
+    w1 = c / k1
+    w2 = (1 - c) / k2
+    return [w1 / (w1 + w2), k1, k2]
+
+
 def set_source_rad_energy_spectrum(source, rad):
     rad_spectrum = get_rad_gamma_spectrum(rad)
 
@@ -137,6 +201,54 @@ def set_source_rad_energy_spectrum(source, rad):
     source.energy.spectrum_energies = rad_spectrum.energies
 
 
+class BatchPrefetcher:
+    """
+    Produce the next batches of particles in a background thread, while the
+    current batch is used by the source (double buffering). The function
+    'produce' is called sequentially in a single background thread, so it
+    must not use the thread-local data of the Geant4 threads. 'next' returns
+    the oldest batch, waiting only if it is not ready yet, and asks for a new
+    one. When the prefetcher is shared by several threads, depth is the
+    number of batches produced in advance (e.g. one per thread).
+    """
+
+    def __init__(self, produce, depth=1):
+        self.produce = produce
+        self.depth = max(1, int(depth))
+        self.pending = collections.deque()
+        self.lock = threading.Lock()
+        self.executor = None
+
+    def start(self):
+        with self.lock:
+            self._fill()
+
+    def _fill(self):
+        if self.executor is None:
+            self.executor = ThreadPoolExecutor(
+                max_workers=1, thread_name_prefix="gate_batch_prefetch"
+            )
+        while len(self.pending) < self.depth:
+            self.pending.append(self.executor.submit(self.produce))
+
+    def next(self):
+        with self.lock:
+            self._fill()
+            future = self.pending.popleft()
+            self._fill()
+        # (the GIL is released while waiting)
+        return future.result()
+
+    def close(self):
+        with self.lock:
+            for future in self.pending:
+                future.cancel()
+            self.pending.clear()
+            if self.executor is not None:
+                self.executor.shutdown(wait=True)
+            self.executor = None
+
+
 class SourceBase(GateObject):
     """
     Base class for all source types.
@@ -192,6 +304,8 @@ class SourceBase(GateObject):
         GateObject.__init__(self, *args, **kwargs)
         # all times intervals
         self.run_timing_intervals = None
+        # values of the user replaced by the share of this process (distribute)
+        self.undistributed_values = {}
 
     def __initcpp__(self):
         """Nothing to do in the base class."""
@@ -232,11 +346,37 @@ class SourceBase(GateObject):
     def initialize(self, run_timing_intervals):
         self.initialize_start_end_time(run_timing_intervals)
         # this will initialize and set user_info to the cpp side
-        self.InitializeUserInfo(self.user_info)
+        # (called by each thread, the values are converted once by the master)
+        self.InitializeUserInfoOfThread(self.user_info)
 
     def add_to_source_manager(self, source_manager):
         source_manager.AddSource(self)
 
+    def distribute(self, context):
+        """Distributed simulation: only keep the share of the primaries of this
+        process (see DistributedContext). The processes are independent Poisson
+        processes, so the activity is divided by the number of processes.
+        The share is always computed from the values of the user, which are
+        restored at the end of the simulation (see restore_undistributed_values).
+        """
+        n, activity = self.get_undistributed_values("n", "activity")
+        if n > 0:
+            self.n = context.get_share(n)
+        if activity > 0:
+            self.activity = activity / context.size
+
+    def get_undistributed_values(self, *names):
+        # the values of the user are kept the first time, before being divided
+        for name in names:
+            if name not in self.undistributed_values:
+                self.undistributed_values[name] = getattr(self, name)
+        return [self.undistributed_values[name] for name in names]
+
+    def restore_undistributed_values(self):
+        for name, value in self.undistributed_values.items():
+            setattr(self, name, value)
+        self.undistributed_values = {}
+
     def prepare_output(self):
         pass
 
@@ -10,6 +10,7 @@ from ..contrib.tps.ionbeamtherapy import (
     BeamsetInfo,
 )
 from ..base import process_cls
+from ..exception import fatal
 
 
 def _check_ph_space_params(param_v):
@@ -69,6 +70,28 @@ class TreatmentPlanPBSource(SourceBase, g4.GateTreatmentPlanPBSource):
         "beam_nr": (1, {"doc": "FIXME"}),
         "gantry_rot_axis": ("z", {"doc": "FIXME"}),
         "flat_generation": (False, {"doc": "FIXME"}),
+        "partitioned_spot_generation": (
+            False,
+            {
+                "doc": "If True, the plan is split into contiguous ranges of spots, "
+                "one per thread, balanced by the expected cost of the spots "
+                "(probability x energy^2). Each thread generates the spots of its "
+                "own range one by one (like sorted_spot_generation), so it only "
+                "reconfigures the beam on its own spot transitions. The total "
+                "number of primaries is still n x number_of_threads.",
+            },
+        ),
+        "batch_size": (
+            1,
+            {
+                "doc": "With sorted_spot_generation or partitioned_spot_generation, "
+                "number of primaries of a spot generated at once (phase space with "
+                "vectorized Gaussians, then energies in bulk) and then used one per "
+                "event. 1 means one per event. As the random numbers are drawn in a "
+                "different order, the results differ (statistically equivalent) from "
+                "the default.",
+            },
+        ),
         "particle": (None, {"doc": "FIXME"}),
         "ion": (Box({"Z": 0, "A": 0, "E": 0}), {"doc": "FIXME"}),
         "position": (
@@ -85,6 +108,14 @@ class TreatmentPlanPBSource(SourceBase, g4.GateTreatmentPlanPBSource):
         "pdf": ([], {"doc": "FIXME"}),
         "partPhSp_xV": ([], {"doc": "FIXME"}),
         "partPhSp_yV": ([], {"doc": "FIXME"}),
+        "thread_spot_ranges": (
+            [],
+            {"doc": "(internal) first spot of each thread range, and the last one + 1"},
+        ),
+        "thread_primaries": (
+            [],
+            {"doc": "(internal) number of primaries of each thread range"},
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -113,9 +144,24 @@ class TreatmentPlanPBSource(SourceBase, g4.GateTreatmentPlanPBSource):
         # if len(self.user_info.n_primaries_vector) != len(self.user_info.run_timing_intervals):
         #     raise ValueError("Particles per run must have the same length of the number of runs")
 
+        if self.batch_size < 1:
+            fatal(f"For the source {self.name}, batch_size must be at least 1.")
+        if self.batch_size > 1 and not (
+            self.sorted_spot_generation or self.partitioned_spot_generation
+        ):
+            fatal(
+                f"For the source {self.name}, batch_size needs sorted_spot_generation "
+                f"or partitioned_spot_generation (otherwise the spot changes at "
+                f"each event)."
+            )
+
         # set pbs param
         self._set_pbs_param_all_spots()
 
+        # split the spots between the threads
+        if self.partitioned_spot_generation:
+            self._set_thread_spot_ranges(self.simulation.number_of_threads)
+
         # set ion param
         if self.particle.startswith("ion"):
             words = self.particle.split(" ")
@@ -238,6 +284,27 @@ class TreatmentPlanPBSource(SourceBase, g4.GateTreatmentPlanPBSource):
 
         return list(pdf)
 
+    def _set_thread_spot_ranges(self, n_threads):
+        # expected cost of each spot: number of primaries x energy^2
+        pdf = np.asarray(self.pdf)
+        cost = pdf * np.asarray(self.energies) ** 2
+        if np.sum(cost) <= 0:
+            cost = pdf
+        cum_cost = np.cumsum(cost) / np.sum(cost)
+        # a spot goes to the thread of the middle of its cost interval, so that
+        # the ranges are contiguous and have (nearly) the same cost
+        middle = cum_cost - 0.5 * cost / np.sum(cost)
+        ranges = np.searchsorted(middle, np.arange(n_threads + 1) / n_threads)
+        ranges[-1] = len(pdf)
+        # all threads together generate n x n_threads primaries: each range
+        # receives its share, according to its probability
+        n_total = int(self.n) * n_threads
+        cum_pdf = np.concatenate(([0], np.cumsum(pdf) / np.sum(pdf)))
+        cum_n = np.floor(n_total * cum_pdf[ranges] + 0.5).astype(int)
+        cum_n[-1] = n_total
+        self.thread_spot_ranges = [int(r) for r in ranges]
+        self.thread_primaries = [int(n) for n in np.diff(cum_n)]
+
     def _get_pbs_position(self, spot):
         # (x,y) refer to isocenter plane.
         # Need to be corrected to refer to nozzle plane
@@ -1,5 +1,7 @@
 import sys
 import time
+import json
+import pathlib
 import scipy
 from scipy.spatial.transform import Rotation
 import numpy as np
@@ -11,6 +13,7 @@ import random
 
 import opengate_core as g4
 from .phspsources import PhaseSpaceSource
+from .base import BatchPrefetcher
 from ..exception import fatal
 from .generic import GenericSource
 from ..image import get_info_from_image
@@ -280,6 +283,23 @@ class GANSource(GenericSource, g4.GateGANSource):
             None,
             {"doc": "Filename of the Generator (.pth), train with gaga_train"},
         ),
+        "backend": (
+            "torch",
+            {
+                "doc": "Inference of the generator: in Python with torch (gaga_phsp), "
+                "or in C++ (without Python during the run) with ONNX Runtime. "
+                "The 'onnx' backend needs onnx_filename, and opengate_core "
+                "compiled with ONNX Runtime. ",
+                "allowed_values": ("torch", "onnx"),
+            },
+        ),
+        "onnx_filename": (
+            None,
+            {
+                "doc": "Filename of the Generator exported with export_gan_to_onnx "
+                "(for the 'onnx' backend)",
+            },
+        ),
         "backward_distance": (
             None,
             {
@@ -384,6 +404,14 @@ class GANSource(GenericSource, g4.GateGANSource):
                 "allowed_values": ("auto", "cpu", "gpu"),
             },
         ),
+        "prefetch": (
+            False,
+            {
+                "doc": "The next batch is generated by the GAN in a background "
+                "thread while the current one is used, so that the Geant4 "
+                "thread does not wait for the inference. ",
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -408,11 +436,21 @@ class GANSource(GenericSource, g4.GateGANSource):
         gen.initialize()
 
         # set the function pointer to the cpp side
-        self.SetGeneratorFunction(gen.generator)
+        # (or the GAN model, for the inference on the cpp side)
+        if self.user_info.backend == "onnx":
+            self.SetNativeGeneratorInfo(gen.get_native_generator_info())
+        else:
+            self.SetGeneratorFunction(gen.generator)
 
         # set the parameters to the cpp side
         self.SetGeneratorInfo(gen.gan_info)
 
+    def prepare_output(self):
+        # stop generating in the background
+        close = getattr(self.user_info.generator, "close", None)
+        if close is not None:
+            close()
+
     def set_default_generator(self):
         # non-conditional generator
         if self.cond_image is None:
@@ -485,11 +523,14 @@ class GANSourceDefaultGenerator:
         self.keys_output = None
         self.gan_info = None
         self.gpu_mode = None
+        # next batches generated in the background (user_info.prefetch)
+        self.prefetcher = None
 
     def __getstate__(self):
         self.lock = None
         # self.gaga = None
         self.gan_info = None
+        self.prefetcher = None
         return self.__dict__
 
     def initialize(self):
@@ -499,6 +540,16 @@ class GANSourceDefaultGenerator:
             if not self.initialize_is_done:
                 self.read_gan_and_keys()
                 self.initialize_is_done = True
+            # a single background thread for all the threads (the GAN is
+            # shared)
+            prefetch = self.user_info.prefetch and self.user_info.backend == "torch"
+            if prefetch and self.prefetcher is None:
+                self.prefetcher = BatchPrefetcher(self.generate_batch)
+
+    def close(self):
+        if self.prefetcher is not None:
+            self.prefetcher.close()
+            self.prefetcher = None
 
     def read_gan_and_keys(self):
         # allow converting str like 1e5 to int
@@ -507,11 +558,16 @@ class GANSourceDefaultGenerator:
         # FIXME check the number of params
 
         # read pth and create the gan info structure
+        # (only the keys with the onnx backend, the GAN is read on the cpp side)
         self.gan_info = Box()
         g = self.gan_info
-        g.params, g.G, g.D, g.optim = gaga.load(
-            self.user_info.pth_filename, self.gpu_mode
-        )
+        if self.user_info.backend == "onnx":
+            g.params = read_gan_onnx_info(self.user_info.onnx_filename)
+            g.G, g.D, g.optim = None, None, None
+        else:
+            g.params, g.G, g.D, g.optim = gaga.load(
+                self.user_info.pth_filename, self.gpu_mode
+            )
 
         """
         gan_info structure
@@ -641,6 +697,76 @@ class GANSourceDefaultGenerator:
                     )
         return p, o
 
+    def get_native_generator_info(self):
+        """
+        Parameters of the inference on the cpp side (onnx backend): the model,
+        and the columns of the output copied to the source.
+        """
+        if type(self) not in (
+            GANSourceDefaultGenerator,
+            GANSourceDefaultPairsGenerator,
+        ):
+            self.fatal(
+                f"the onnx backend can only be used with the default (non "
+                f"conditional) generators, while it is {type(self).__name__}"
+            )
+        g = self.gan_info
+        back = self.user_info.backward_distance
+        if back and not g.time_is_set_by_GAN and not self.user_info.backward_force:
+            fatal(
+                f"If backward is enabled the time is not managed by GAN,"
+                f" time is wrong. IT can be forced, however, with the option 'backward_force'"
+            )
+        self.get_output_keys()
+        return {
+            "model": str(self.user_info.onnx_filename),
+            "gpu_mode": self.gpu_mode,
+            "batch_size": self.user_info.batch_size,
+            "z_uniform": g.params.z_rand_type == "rand",
+            "backward_distance": float(back) if back else 0.0,
+            "columns": self.get_native_columns(g),
+        }
+
+    def get_native_columns(self, g):
+        # (name of the cpp vector, index in the output of the GAN, fixed value)
+        columns = []
+        if g.position_is_set_by_GAN:
+            columns += self.get_native_vector_columns(
+                "Position",
+                g.position_gan_index,
+                g.position_use_index,
+                self.user_info.position_keys,
+            )
+        if g.direction_is_set_by_GAN:
+            columns += self.get_native_vector_columns(
+                "Direction",
+                g.direction_gan_index,
+                g.direction_use_index,
+                self.user_info.direction_keys,
+            )
+        for name, is_set, index in (
+            ("Energy", g.energy_is_set_by_GAN, g.energy_gan_index),
+            ("Time", g.time_is_set_by_GAN, g.time_gan_index),
+            ("Weight", g.weight_is_set_by_GAN, g.weight_gan_index),
+        ):
+            if is_set:
+                columns += self.get_native_scalar_columns(name, index)
+        return columns
+
+    def get_native_vector_columns(self, name, gan_index, use_index, user_keys):
+        columns = []
+        for i in range(len(gan_index)):
+            # X Y Z, then X2 Y2 Z2 for the pairs
+            n = f"{name}{'XYZ'[i % 3]}{'2' if i >= 3 else ''}"
+            if use_index[i]:
+                columns.append((n, int(gan_index[i]), 0.0))
+            else:
+                columns.append((n, -1, float(user_keys[i])))
+        return columns
+
+    def get_native_scalar_columns(self, name, index):
+        return [(name, int(index), 0.0)]
+
     def generator(self, source):
         """
         Main function that will be called from the cpp side every time a batch
@@ -648,6 +774,20 @@ class GANSourceDefaultGenerator:
         Once created here, the particles are copied to cpp.
         (Yes maybe the copy could be avoided, but I did not manage to do it)
         """
+        # the next batch is generated now, or was generated in the background
+        if self.prefetcher is not None:
+            fake = self.prefetcher.next()
+        else:
+            fake = self.generate_batch()
+
+        # copy to cpp
+        self.copy_generated_particle_to_g4(source, self.gan_info, fake)
+
+    def generate_batch(self):
+        """
+        Generate a batch of particles with the GAN (with the prefetch option,
+        this is called in a background thread).
+        """
         # get the info
         g = self.gan_info
         n = self.user_info.batch_size
@@ -675,14 +815,13 @@ class GANSourceDefaultGenerator:
         # move particle backward ?
         self.move_backward(g, fake)
 
-        # copy to cpp
-        self.copy_generated_particle_to_g4(source, g, fake)
-
         # verbose
         if self.user_info.verbose_generator:
             end = time.time()
             print(f"in {end - start:0.1f} sec (GPU={g.params.current_gpu_mode})")
 
+        return fake
+
     def copy_generated_particle_to_g4(self, source, g, fake):
         # get the index of from the GAN vector
         # (or some fixed values)
@@ -768,8 +907,12 @@ class GANSourceDefaultPairsGenerator(GANSourceDefaultGenerator):
     def __getstate__(self):
         self.lock = None
         self.gan_info = None
+        self.prefetcher = None
         return self.__dict__
 
+    def get_native_scalar_columns(self, name, index):
+        return [(name, int(index[0]), 0.0), (f"{name}2", int(index[1]), 0.0)]
+
     def check_parameters(self, g):
         # position
         if g.position_is_set_by_GAN and len(self.user_info.position_keys) != 6:
@@ -810,12 +953,9 @@ class GANSourceDefaultPairsGenerator(GANSourceDefaultGenerator):
             self.fatal(f"you must provide 2 values for weight, while it was {dim}")
         g.weight_gan_index = [the_keys.index(ek[0]), the_keys.index(ek[1])]
 
-    def generator(self, source):
+    def generate_batch(self):
         """
-        Main function that will be called from the cpp side every time a batch
-        of particles should be created.
-        Once created here, the particles are copied to cpp.
-        (Yes maybe the copy could be avoided, but I did not manage to do it)
+        Like GANSourceDefaultGenerator.generate_batch, for pairs
         """
         # get the info
         g = self.gan_info
@@ -844,14 +984,13 @@ class GANSourceDefaultPairsGenerator(GANSourceDefaultGenerator):
         # move particle backward ?
         self.move_backward(g, fake)
 
-        # copy to cpp
-        self.copy_generated_particle_to_g4(source, g, fake)
-
         # verbose
         if self.user_info.verbose_generator:
             end = time.time()
             print(f"in {end - start:0.1f} sec (device={g.params.current_gpu_device})")
 
+        return fake
+
     def copy_generated_particle_to_g4(self, source, g, fake):
         # position
         if g.position_is_set_by_GAN:
@@ -952,7 +1091,7 @@ class GANSourceConditionalGenerator(GANSourceDefaultGenerator):
         )
         return None
 
-    def generator(self, source):
+    def generate_batch(self):
         """
         Generate particles with a GAN, considering conditional vectors.
         """
@@ -996,14 +1135,13 @@ class GANSourceConditionalGenerator(GANSourceDefaultGenerator):
         # move particle backward ?
         self.move_backward(g, fake)
 
-        # copy to cpp (g4)
-        self.copy_generated_particle_to_g4(source, g, fake)
-
         # verbose
         if self.user_info.verbose_generator:
             end = time.time()
             print(f"in {end - start:0.2f} sec (GPU={g.params.current_gpu_mode})")
 
+        return fake
+
 
 class GANSourceConditionalPairsGenerator(GANSourceDefaultPairsGenerator):
     """
@@ -1024,6 +1162,7 @@ class GANSourceConditionalPairsGenerator(GANSourceDefaultPairsGenerator):
         self.gan = None
         self.generate_condition = None
         self.lock = None
+        self.prefetcher = None
         return self.__dict__
 
     def generate_condition(self, n):
@@ -1034,7 +1173,7 @@ class GANSourceConditionalPairsGenerator(GANSourceDefaultPairsGenerator):
         )
         return None
 
-    def generator(self, source):
+    def generate_batch(self):
         # get the info
         g = self.gan_info
         n = self.user_info.batch_size
@@ -1075,9 +1214,6 @@ class GANSourceConditionalPairsGenerator(GANSourceDefaultPairsGenerator):
         # back from torch to numpy
         fake = fake.cpu().data.numpy()
 
-        # copy to cpp
-        self.copy_generated_particle_to_g4(source, g, fake)
-
         # verbose
         if self.user_info.verbose_generator:
             end = time.time()
@@ -1085,6 +1221,68 @@ class GANSourceConditionalPairsGenerator(GANSourceDefaultPairsGenerator):
                 f"in {end - start_time:0.1f} sec (device={g.params.current_gpu_device})"
             )
 
+        return fake
+
 
 process_cls(GANSource)
 process_cls(GANPairsSource)
+
+
+def export_gan_to_onnx(pth_filename, onnx_filename, gpu_mode="cpu"):
+    """
+    Export the Generator of a GAN (.pth file of gaga_phsp) to an ONNX file,
+    for the inference on the cpp side (GANSource with backend = "onnx").
+    The de-normalization of the output is included in the model. The keys of
+    the output and the type of the random input are stored in a json file
+    with the same name (.json extension).
+    """
+    params, G, D, optim = gaga.load(pth_filename, gpu_mode)
+    G = G.cpu()
+    G.eval()
+
+    class DenormalizedGenerator(torch.nn.Module):
+        def __init__(self):
+            super().__init__()
+            self.G = G
+            x_mean = np.asarray(params["x_mean"], dtype=np.float32).reshape(1, -1)
+            x_std = np.asarray(params["x_std"], dtype=np.float32).reshape(1, -1)
+            self.register_buffer("x_mean", torch.from_numpy(x_mean))
+            self.register_buffer("x_std", torch.from_numpy(x_std))
+
+        def forward(self, z):
+            return self.G(z) * self.x_std + self.x_mean
+
+    model = DenormalizedGenerator()
+    z = torch.zeros((2, params["z_dim"]), dtype=torch.float32)
+    with torch.no_grad():
+        torch.onnx.export(
+            model,
+            z,
+            str(onnx_filename),
+            input_names=["z"],
+            output_names=["x"],
+            dynamic_axes={"z": {0: "n"}, "x": {0: "n"}},
+        )
+
+    info = {
+        "keys_list": list(params["keys_list"]),
+        "z_rand_type": params.get("z_rand_type", "randn"),
+    }
+    with open(pathlib.Path(onnx_filename).with_suffix(".json"), "w") as f:
+        json.dump(info, f, indent=2)
+
+
+def read_gan_onnx_info(onnx_filename):
+    """
+    Read the keys of a GAN exported with export_gan_to_onnx
+    """
+    if onnx_filename is None:
+        fatal(f"The onnx backend of the GAN source needs the option 'onnx_filename'")
+    filename = pathlib.Path(onnx_filename).with_suffix(".json")
+    if not filename.is_file():
+        fatal(
+            f"Cannot find the file {filename} with the keys of the GAN "
+            f"{onnx_filename} (see export_gan_to_onnx)"
+        )
+    with open(filename) as f:
+        return Box(json.load(f))
@@ -1,3 +1,4 @@
+import numpy as np
 from box import Box
 from scipy.spatial.transform import Rotation
 
@@ -6,6 +7,8 @@ from .base import (
     SourceBase,
     all_beta_plus_radionuclides,
     read_beta_plus_spectra,
+    get_rad_beta_plus_decay,
+    get_positron_range_kernel,
     compute_cdf_and_total_yield,
 )
 from ..base import process_cls
@@ -44,6 +47,9 @@ def _generic_source_default_direction():
             "histogram_theta_angles": [],
             "histogram_phi_weights": [],
             "histogram_phi_angles": [],
+            "histogram2d_theta_angles": [],
+            "histogram2d_phi_angles": [],
+            "histogram2d_weights": [],
         }
     )
 
@@ -113,6 +119,7 @@ class GenericSource(SourceBase, g4.GateGenericSource):
     tac_times: list
     tac_activities: list
     direction_relative_to_attached_volume: bool
+    decay_mode: str
     position: Box
     direction: Box
     energy: Box
@@ -164,6 +171,48 @@ class GenericSource(SourceBase, g4.GateGenericSource):
                 "when the volume is moved (with dynamic parametrisation)?"
             },
         ),
+        "decay_mode": (
+            "geant4",
+            {
+                "doc": "For a beta+ radionuclide ion (e.g. 'ion 31 68'): 'geant4' "
+                "tracks the ion with the Geant4 radioactive decay. 'precomputed' "
+                "does not create the ion: each decay directly emits the positron "
+                "(beta+ spectrum) and the prompt gammas of the same decay branch, "
+                "from tabulated data (see rad_beta_plus_decay.json). The activity "
+                "is the one of the radionuclide (the decays without emission are "
+                "not simulated).",
+                "allowed_values": ("geant4", "precomputed"),
+            },
+        ),
+        "decay_branches": (
+            [],
+            {"doc": "(internal) decay branches of the 'precomputed' decay mode"},
+        ),
+        "positron_range": (
+            Box({"isotope": None, "material": "G4_WATER"}),
+            {
+                "doc": "For a 'back_to_back' source: the annihilation point is moved "
+                "from the emission point by the positron range of the isotope "
+                "(F18, C11, N13 or O15) in the material (the kernel in water is "
+                "scaled by the density). None: no positron range.",
+            },
+        ),
+        "positron_range_kernel": (
+            [],
+            {"doc": "(internal) kernel of the positron range, see positron_range"},
+        ),
+        "batch_size": (
+            1,
+            {
+                "doc": "Number of primaries generated at once (positions and directions, "
+                "then energies in bulk) and then used one per event. 1 means one per "
+                "event. Not compatible with the acceptance angle. As the random numbers "
+                "are drawn in a different order, the results differ (statistically "
+                "equivalent) from the default. For a 'back_to_back' source, the "
+                "positron range and the accolinearity of the whole batch are also "
+                "sampled at once.",
+            },
+        ),
         "position": (
             _generic_source_default_position(),
             {"doc": "Define the position of the primary particles"},
@@ -210,10 +259,14 @@ class GenericSource(SourceBase, g4.GateGenericSource):
                 f"Generic Source: user_info.energy must be a Box, but is: {self.energy}"
             )
 
+        if self.decay_mode == "precomputed":
+            self.initialize_precomputed_decay()
+
         if self.particle == "back_to_back":
             # force the energy to 511 keV
             self.energy.type = "mono"
             self.energy.mono = 511 * g4_units.keV
+        self.initialize_positron_range()
 
         # check energy type
         l = [
@@ -273,14 +326,32 @@ class GenericSource(SourceBase, g4.GateGenericSource):
                 )
 
         # check direction type
-        l = ["iso", "histogram", "momentum", "focused", "beam2d"]
+        l = [
+            "iso",
+            "histogram",
+            "histogram2d",
+            "momentum",
+            "focused",
+            "beam2d",
+        ]
         if not self.direction.type in l:
             fatal(
                 f"Cannot find the direction type {self.direction.type} for the source {self.name}.\n"
                 f"Available types are {l}"
             )
+        if self.direction.type == "histogram2d":
+            self.check_direction_histogram2d()
 
         # logic for half life and user_particle_life_time
+        if self.batch_size < 1:
+            fatal(f"For the source {self.name}, batch_size must be at least 1.")
+        aa = self.direction.acceptance_angle
+        if self.batch_size > 1 and (aa.intersection_flag or aa.normal_flag):
+            fatal(
+                f"For the source {self.name}, batch_size cannot be used with the "
+                f"acceptance angle."
+            )
+
         if self.half_life > 0:
             # if the user set the half life and not the user_particle_life_time
             # we force the latter to zero
@@ -310,6 +381,81 @@ class GenericSource(SourceBase, g4.GateGenericSource):
                     f"confine is used, while position.type is point ... really ?"
                 )
 
+    def check_direction_histogram2d(self):
+        d = self.direction
+        nb_theta = len(d.histogram2d_theta_angles) - 1
+        nb_phi = len(d.histogram2d_phi_angles) - 1
+        if nb_theta < 1 or nb_phi < 1:
+            fatal(
+                f"For the source {self.name}, the direction histogram2d needs at "
+                f"least two theta and two phi angles (bin edges)."
+            )
+        shape = np.shape(d.histogram2d_weights)
+        if len(shape) == 2 and shape == (nb_theta, nb_phi):
+            return
+        if len(shape) != 3 or shape[1:] != (nb_theta, nb_phi):
+            fatal(
+                f"For the source {self.name}, the direction histogram2d_weights "
+                f"must be of shape ({nb_theta}, {nb_phi}), or (n, {nb_theta}, "
+                f"{nb_phi}) with one table per energy, while {shape} is read."
+            )
+        # one table per line (spectrum_discrete) or bin (spectrum_histogram)
+        e = self.energy
+        if e.type == "spectrum_discrete":
+            n = len(e.spectrum_energies)
+        elif e.type == "spectrum_histogram":
+            n = len(e.spectrum_energy_bin_edges) - 1
+        else:
+            fatal(
+                f"For the source {self.name}, energy dependent direction "
+                f"histograms need an energy of type spectrum_discrete or "
+                f"spectrum_histogram, while {e.type} is read."
+            )
+        if shape[0] != n:
+            fatal(
+                f"For the source {self.name}, the direction histogram2d_weights "
+                f"has {shape[0]} tables while the energy spectrum has {n} "
+                f"lines or bins."
+            )
+
+    def initialize_positron_range(self):
+        self.positron_range_kernel = []
+        if self.positron_range.isotope is None:
+            return
+        if self.particle != "back_to_back":
+            fatal(
+                f"For the source {self.name}, the positron range can only be used "
+                f"with the 'back_to_back' particle, not '{self.particle}'"
+            )
+        material = self.simulation.volume_manager.find_or_build_material(
+            self.positron_range.material
+        )
+        self.positron_range_kernel = get_positron_range_kernel(
+            self.positron_range.isotope, material.GetDensity()
+        )
+
+    def initialize_precomputed_decay(self):
+        # the ion is replaced by its emissions: e+ with the beta+ spectrum of
+        # the radionuclide, and the prompt gammas of the same branch
+        if self.particle == "e+" and len(self.decay_branches) > 0:
+            # already done
+            return
+        if not self.particle.startswith("ion"):
+            fatal(
+                f"For the source {self.name}, the precomputed decay mode needs an "
+                f"ion (e.g. 'ion 31 68'), while the particle is '{self.particle}'"
+            )
+        rad, branches = get_rad_beta_plus_decay(self.ion.Z, self.ion.A)
+        if rad is None or self.ion.E != 0:
+            fatal(
+                f"For the source {self.name}, no precomputed decay data for the ion "
+                f"Z={self.ion.Z} A={self.ion.A} E={self.ion.E}. "
+                f"Available radionuclides are {all_beta_plus_radionuclides}"
+            )
+        self.particle = "e+"
+        self.energy.type = rad
+        self.decay_branches = branches
+
     def check_ui_activity(self, ui):
         # FIXME: This should rather be a function than a method
         # FIXME: self actually holds the parameters n and activity, but the ones from ui are used here.
@@ -338,6 +484,12 @@ class GenericSource(SourceBase, g4.GateGenericSource):
         self.total_zero_events = self.GetTotalZeroEvents()
         self.total_skipped_events = self.GetTotalSkippedEvents()
 
+    def distribute(self, context):
+        SourceBase.distribute(self, context)
+        (tac_activities,) = self.get_undistributed_values("tac_activities")
+        if tac_activities is not None:
+            self.tac_activities = [a / context.size for a in tac_activities]
+
     def update_tac_activity(self):
         if self.tac_times is None and self.tac_activities is None:
             return
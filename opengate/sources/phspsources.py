@@ -1,6 +1,8 @@
 import uproot
 import numpy as np
 import numbers
+import struct
+from pathlib import Path
 from scipy.spatial.transform import Rotation
 from box import Box
 import sys
@@ -8,6 +10,7 @@ import sys
 import opengate_core as g4
 from ..exception import fatal, warning
 from .generic import SourceBase
+from .base import BatchPrefetcher
 from ..base import process_cls
 
 
@@ -25,9 +28,9 @@ class PhaseSpaceSourceGenerator:
         self.cycle_count = 0
         # used during generation
         self.batch = None
-        self.points = None
         self.current_index = 0
-        self.w = None
+        # next batches read in the background (source.prefetch)
+        self.prefetcher = None
 
     def initialize(self, phsp_source):
         self.phsp_source = phsp_source
@@ -45,6 +48,12 @@ class PhaseSpaceSourceGenerator:
             # do nothing for master thread
             return
 
+        if Path(self.phsp_source.phsp_file).suffix == ".gphsp":
+            fatal(
+                f"PhaseSpaceSource {self.name}: a .gphsp file needs "
+                f'source.reader = "native"'
+            )
+
         # open root file and get the first branch
         # FIXME could have an option to select the branch
         self.root_file = uproot.open(self.phsp_source.phsp_file)
@@ -66,41 +75,20 @@ class PhaseSpaceSourceGenerator:
         # initialize counters
         self.cycle_count = 0
 
-    def get_entry_start(self, entry_start):
-        if not g4.IsMultithreadedApplication():
-            if not isinstance(entry_start, numbers.Number):
-                fatal("entry_start must be a simple number is mono-thread mode")
-            n = int(entry_start % self.num_entries)
-            if entry_start > self.num_entries:
-                warning(
-                    f"In source {self.name} "
-                    f"entry_start = {entry_start} while "
-                    f"the phsp contains {self.num_entries}. "
-                    f"We consider {n} instead (modulo)"
-                )
-            return n
-        tid = g4.G4GetThreadId()
-
-        if tid < 0:
-            # no entry start needed for master thread
-            return 0
-        n_threads = g4.GetNumberOfRunningWorkerThreads()
-        if isinstance(entry_start, numbers.Number):
-            fatal(f"entry_start must be a list in multi-thread mode")
-        if len(entry_start) != n_threads:
-            fatal(
-                f"Error: entry_start must be a vector of length the nb of threads, "
-                f"but it is {len(entry_start)} instead of {n_threads}"
-            )
-        n = int(entry_start[self.tid] % self.num_entries)
-        if entry_start[tid] > self.num_entries:
-            warning(
-                f"In source {self.name} "
-                f"entry_start = {entry_start} (thread {tid}) "
-                f"while the phsp contains {self.num_entries}. "
-                f"We consider {n} instead (modulo)"
+        # the first batch is read now, in the background
+        if self.phsp_source.prefetch:
+            self.prefetcher = BatchPrefetcher(
+                lambda: self.read_batch(self.phsp_source)
             )
-        return n
+            self.prefetcher.start()
+
+    def close(self):
+        if self.prefetcher is not None:
+            self.prefetcher.close()
+            self.prefetcher = None
+
+    def get_entry_start(self, entry_start):
+        return get_phsp_entry_start(self.name, entry_start, self.num_entries)
 
     def generate(self, source, pid):
         """
@@ -109,6 +97,58 @@ class PhaseSpaceSourceGenerator:
         Once created here, the particles are copied to cpp.
         (Yes maybe the copy could be avoided, but I did not manage to do it)
         """
+        # the next batch is read now, or was read in the background
+        if self.prefetcher is not None:
+            batch, current_batch_size = self.prefetcher.next()
+        else:
+            batch, current_batch_size = self.read_batch(source)
+
+        # keep the reference (the cpp side uses the arrays)
+        self.batch = batch
+
+        # send to cpp
+        # set position
+        source.SetPositionXBatch(batch[source.position_key_x])
+        source.SetPositionYBatch(batch[source.position_key_y])
+        source.SetPositionZBatch(batch[source.position_key_z])
+
+        # set direction
+        source.SetDirectionXBatch(batch[source.direction_key_x])
+        source.SetDirectionYBatch(batch[source.direction_key_y])
+        source.SetDirectionZBatch(batch[source.direction_key_z])
+
+        # set energy
+        source.SetEnergyBatch(batch[source.energy_key])
+
+        # set PDGCode
+        if source.PDGCode_key in batch:
+            source.SetPDGCodeBatch(batch[source.PDGCode_key])
+        # set weight
+        source.SetWeightBatch(batch[source.weight_key])
+
+        if source.verbose:
+            print("PhaseSpaceSourceGenerator: batch generated: ")
+            print("particle name: ", source.particle)
+            if source.PDGCode_key in batch:
+                print("source.fPDGCode: ", batch[source.PDGCode_key])
+            print("source.fEnergy: ", batch[source.energy_key])
+            print("source.fWeight: ", batch[source.weight_key])
+            print("source.fPositionX: ", batch[source.position_key_x])
+            print("source.fPositionY: ", batch[source.position_key_y])
+            print("source.fPositionZ: ", batch[source.position_key_z])
+            print("source.fDirectionX: ", batch[source.direction_key_x])
+            print("source.fDirectionY: ", batch[source.direction_key_y])
+            print("source.fDirectionZ: ", batch[source.direction_key_z])
+            print("source.fEnergy dtype: ", batch[source.energy_key].dtype)
+
+        return current_batch_size
+
+    def read_batch(self, source):
+        """
+        Read the next batch of particles in the phsp and prepare the arrays
+        for the cpp side. With source.prefetch, this is called in a
+        background thread.
+        """
 
         # read data from root tree
         current_batch_size = source.batch_size
@@ -117,18 +157,17 @@ class PhaseSpaceSourceGenerator:
 
         if source.verbose_batch:
             print(
-                f"Thread {g4.G4GetThreadId()} "
+                f"Thread {self.tid} "
                 f"generate {current_batch_size} starting {self.current_index} "
                 f" (phsp as n = {self.num_entries} entries)"
             )
 
-        # read a batch of particles in the phsp (keep the reference)
-        self.batch = self.root_file.arrays(
+        # read a batch of particles in the phsp
+        batch = self.root_file.arrays(
             entry_start=self.current_index,
             entry_stop=self.current_index + current_batch_size,
             library="numpy",
         )
-        batch = self.batch
 
         # ensure encoding is float32
         for key in batch:
@@ -160,7 +199,8 @@ class PhaseSpaceSourceGenerator:
 
         # if translate_position is set to True, the position
         # supplied will be added to the phsp file position
-        if source.translate_position:
+        # (with symmetries, this is done per particle in C++, see recycling)
+        if source.translate_position and not source.transform_in_cpp:
             batch[source.position_key_x] += float(source.position.translation[0])
             batch[source.position_key_y] += float(source.position.translation[1])
             batch[source.position_key_z] += float(source.position.translation[2])
@@ -168,9 +208,9 @@ class PhaseSpaceSourceGenerator:
         # direction is a rotation of the stored direction
         # if rotate_direction is set to True, the direction
         # in the root file will be rotated based on the supplied rotation matrix
-        if source.rotate_direction:
+        if source.rotate_direction and not source.transform_in_cpp:
             # create point vectors
-            self.points = np.column_stack(
+            points = np.column_stack(
                 (
                     batch[source.direction_key_x],
                     batch[source.direction_key_y],
@@ -182,7 +222,7 @@ class PhaseSpaceSourceGenerator:
             if source.verbose:
                 print("Rotation matrix: ", r.as_matrix())
             # rotate vector with rotation matrix
-            points = r.apply(self.points)
+            points = r.apply(points)
             # source.fDirectionX, source.fDirectionY, source.fDirectionZ = points.T
             batch[source.direction_key_x] = points[:, 0].astype(np.float32)
             batch[source.direction_key_y] = points[:, 1].astype(np.float32)
@@ -195,45 +235,288 @@ class PhaseSpaceSourceGenerator:
                     f"PhaseSpaceSource: no Weight key ({source.weight_key}) in the phsp file."
                 )
         else:
-            self.w = np.ones(current_batch_size, dtype=np.float32)
-            batch[source.weight_key] = self.w.astype(np.float32)
+            w = np.ones(current_batch_size, dtype=np.float32)
+            batch[source.weight_key] = w
 
-        # send to cpp
-        # set position
-        source.SetPositionXBatch(batch[source.position_key_x])
-        source.SetPositionYBatch(batch[source.position_key_y])
-        source.SetPositionZBatch(batch[source.position_key_z])
+        return batch, current_batch_size
 
-        # set direction
-        source.SetDirectionXBatch(batch[source.direction_key_x])
-        source.SetDirectionYBatch(batch[source.direction_key_y])
-        source.SetDirectionZBatch(batch[source.direction_key_z])
 
-        # set energy
-        source.SetEnergyBatch(batch[source.energy_key])
+def get_phsp_entry_start(source_name, entry_start, num_entries):
+    """
+    Entry of the phase-space where the current thread starts
+    (entry_start is a number in mono-thread, a list with one value per thread in MT)
+    """
+    if not g4.IsMultithreadedApplication():
+        if not isinstance(entry_start, numbers.Number):
+            fatal("entry_start must be a simple number is mono-thread mode")
+        n = int(entry_start % num_entries)
+        if entry_start > num_entries:
+            warning(
+                f"In source {source_name} "
+                f"entry_start = {entry_start} while "
+                f"the phsp contains {num_entries}. "
+                f"We consider {n} instead (modulo)"
+            )
+        return n
+    tid = g4.G4GetThreadId()
+
+    if tid < 0:
+        # no entry start needed for master thread
+        return 0
+    n_threads = g4.GetNumberOfRunningWorkerThreads()
+    if isinstance(entry_start, numbers.Number):
+        fatal(f"entry_start must be a list in multi-thread mode")
+    if len(entry_start) != n_threads:
+        fatal(
+            f"Error: entry_start must be a vector of length the nb of threads, "
+            f"but it is {len(entry_start)} instead of {n_threads}"
+        )
+    n = int(entry_start[tid] % num_entries)
+    if entry_start[tid] > num_entries:
+        warning(
+            f"In source {source_name} "
+            f"entry_start = {entry_start} (thread {tid}) "
+            f"while the phsp contains {num_entries}. "
+            f"We consider {n} instead (modulo)"
+        )
+    return n
 
-        # set PDGCode
-        if source.PDGCode_key in batch:
-            source.SetPDGCodeBatch(batch[source.PDGCode_key])
-        # set weight
-        source.SetWeightBatch(batch[source.weight_key])
 
-        if source.verbose:
-            print("PhaseSpaceSourceGenerator: batch generated: ")
-            print("particle name: ", source.particle)
-            if source.PDGCode_key in batch:
-                print("source.fPDGCode: ", batch[source.PDGCode_key])
-            print("source.fEnergy: ", batch[source.energy_key])
-            print("source.fWeight: ", batch[source.weight_key])
-            print("source.fPositionX: ", batch[source.position_key_x])
-            print("source.fPositionY: ", batch[source.position_key_y])
-            print("source.fPositionZ: ", batch[source.position_key_z])
-            print("source.fDirectionX: ", batch[source.direction_key_x])
-            print("source.fDirectionY: ", batch[source.direction_key_y])
-            print("source.fDirectionZ: ", batch[source.direction_key_z])
-            print("source.fEnergy dtype: ", batch[source.energy_key].dtype)
+# see GatePhaseSpaceFileReader.h for the columnar file format
+_PHSP_VERSION = 2
+_PHSP_FLOAT32 = 0
+_PHSP_INT32 = 1
+_PHSP_DIRECTION = 2
+_PHSP_HEADER = struct.Struct("<8sIIQQQ")
+_PHSP_COLUMN_HEADER = struct.Struct("<64sII")
+_PHSP_CHUNK_INDEX = struct.Struct("<QQQQ")
+_PHSP_DIRECTION_SCALE = 32767.0
+
+
+def _sign_not_zero(v):
+    return np.where(v >= 0, 1.0, -1.0)
 
-        return current_batch_size
+
+def encode_phsp_directions(x, y, z):
+    """
+    Quantize unit vectors in two int16 packed in an uint32 (octahedral
+    encoding, about 1e-4 rad), as the direction columns of the .gphsp files.
+    """
+    x, y, z = (np.asarray(a, dtype=np.float64) for a in (x, y, z))
+    norm = np.abs(x) + np.abs(y) + np.abs(z)
+    norm[norm == 0] = 1
+    u = x / norm
+    v = y / norm
+    # the lower half of the octahedron is folded over the upper one
+    neg = z < 0
+    u, v = (
+        np.where(neg, (1 - np.abs(v)) * _sign_not_zero(u), u),
+        np.where(neg, (1 - np.abs(u)) * _sign_not_zero(v), v),
+    )
+    qu = np.round(u * _PHSP_DIRECTION_SCALE).astype(np.int16).view(np.uint16)
+    qv = np.round(v * _PHSP_DIRECTION_SCALE).astype(np.int16).view(np.uint16)
+    return qu.astype(np.uint32) | (qv.astype(np.uint32) << 16)
+
+
+def decode_phsp_directions(codes):
+    """Unit vectors (x, y, z) of the quantized directions (float32)."""
+    codes = np.asarray(codes, dtype=np.uint32)
+    u = (codes & 0xFFFF).astype(np.uint16).view(np.int16) / _PHSP_DIRECTION_SCALE
+    v = (codes >> 16).astype(np.uint16).view(np.int16) / _PHSP_DIRECTION_SCALE
+    z = 1 - np.abs(u) - np.abs(v)
+    neg = z < 0
+    u, v = (
+        np.where(neg, (1 - np.abs(v)) * _sign_not_zero(u), u),
+        np.where(neg, (1 - np.abs(u)) * _sign_not_zero(v), v),
+    )
+    norm = np.sqrt(u * u + v * v + z * z)
+    return tuple((a / norm).astype(np.float32) for a in (u, v, z))
+
+
+def _phsp_columns(arrays, quantized_directions):
+    # (name, type, keys of the values) of each column of the file
+    quantized_keys = {}
+    for d in quantized_directions:
+        keys = [f"{d}_X", f"{d}_Y", f"{d}_Z"]
+        for k in keys:
+            if k not in arrays:
+                fatal(f"Phase-space: no key {k} for the quantized direction {d}")
+            quantized_keys[k] = (d, keys)
+    columns = []
+    for name, array in arrays.items():
+        if name in quantized_keys:
+            d, keys = quantized_keys[name]
+            if name == keys[0]:
+                columns.append((d, _PHSP_DIRECTION, keys))
+            continue
+        if np.issubdtype(array.dtype, np.floating):
+            columns.append((name, _PHSP_FLOAT32, [name]))
+        elif np.issubdtype(array.dtype, np.integer) or array.dtype == bool:
+            columns.append((name, _PHSP_INT32, [name]))
+        else:
+            fatal(f"Phase-space column {name}: type {array.dtype} is not supported")
+    for name, _, _ in columns:
+        if len(name.encode()) > 63:
+            fatal(f"Phase-space column name is too long (63 max): {name}")
+    return columns
+
+
+def _write_phsp_columnar(
+    filename, num_entries, get_chunk, quantized_directions, chunk_size
+):
+    # get_chunk(start, stop) is a dict of the arrays of the entries [start, stop)
+    chunk_size = int(chunk_size)
+    if chunk_size < 1:
+        fatal(f"Phase-space: the chunk size must be at least 1 ({chunk_size})")
+    arrays = get_chunk(0, min(chunk_size, num_entries))
+    columns = _phsp_columns(arrays, quantized_directions)
+    index = []
+    with open(filename, "wb") as f:
+        # the header is written at the end, with the index of the chunks
+        f.seek(_PHSP_HEADER.size + _PHSP_COLUMN_HEADER.size * len(columns))
+        for start in range(0, num_entries, chunk_size):
+            stop = min(start + chunk_size, num_entries)
+            if start > 0:
+                arrays = get_chunk(start, stop)
+            n = stop - start
+            offset = -(-f.tell() // 8) * 8
+            f.seek(offset)
+            for name, column_type, keys in columns:
+                values = [np.asarray(arrays[k]) for k in keys]
+                for k, v in zip(keys, values):
+                    if v.ndim != 1 or len(v) != n:
+                        fatal(
+                            f"Phase-space column {k} must be a 1D array of "
+                            f"{n} values, while its shape is {v.shape}"
+                        )
+                if column_type == _PHSP_DIRECTION:
+                    data = encode_phsp_directions(*values).astype("<u4")
+                elif column_type == _PHSP_FLOAT32:
+                    data = values[0].astype("<f4")
+                else:
+                    data = values[0].astype("<i4")
+                f.write(data.tobytes())
+                f.write(b"\0" * (-(n * 4) % 8))
+            index.append((start, n, offset, f.tell() - offset))
+        index_offset = -(-f.tell() // 8) * 8
+        f.seek(index_offset)
+        for chunk in index:
+            f.write(_PHSP_CHUNK_INDEX.pack(*chunk))
+        f.seek(0)
+        f.write(
+            _PHSP_HEADER.pack(
+                b"GATEPHSP",
+                _PHSP_VERSION,
+                len(columns),
+                num_entries,
+                len(index),
+                index_offset,
+            )
+        )
+        for name, column_type, _ in columns:
+            f.write(_PHSP_COLUMN_HEADER.pack(name.encode(), column_type, 0))
+
+
+def write_phsp_columnar(
+    filename, arrays, quantized_directions=(), chunk_size=1000000
+):
+    """
+    Write a phase space in the columnar file format (.gphsp) of the native
+    reader of PhaseSpaceSource (source.reader = "native"). arrays is a dict of
+    1D arrays with the same length: floating point values are stored as
+    float32, integer values (e.g. PDGCode) as int32. For each name in
+    quantized_directions (e.g. "PreDirection"), the three arrays <name>_X,
+    <name>_Y and <name>_Z are stored as one quantized direction column.
+    The entries are stored by chunks of chunk_size entries.
+    """
+    names = list(arrays.keys())
+    num_entries = len(arrays[names[0]]) if len(names) > 0 else 0
+    arrays = {k: np.asarray(v) for k, v in arrays.items()}
+    _write_phsp_columnar(
+        filename,
+        num_entries,
+        lambda start, stop: {k: v[start:stop] for k, v in arrays.items()},
+        quantized_directions,
+        chunk_size,
+    )
+
+
+def convert_phsp_root_to_columnar(
+    root_filename,
+    output_filename,
+    keys=None,
+    quantized_directions=(),
+    chunk_size=1000000,
+):
+    """
+    Convert the first tree of a root phase space to the columnar file format of
+    the native reader (see write_phsp_columnar). Only the given keys are
+    converted (all keys by default), one chunk at a time.
+    """
+    root_file = uproot.open(root_filename)
+    branches = root_file.keys()
+    if len(branches) == 0:
+        fatal(f"No usable branches in the root file {root_filename}")
+    tree = root_file[branches[0]]
+    if keys is None:
+        keys = tree.keys()
+    for k in keys:
+        if k not in tree:
+            fatal(f"No key {k} in the phase-space file {root_filename}")
+    _write_phsp_columnar(
+        output_filename,
+        int(tree.num_entries),
+        lambda start, stop: tree.arrays(
+            keys, entry_start=start, entry_stop=stop, library="np"
+        ),
+        quantized_directions,
+        chunk_size,
+    )
+
+
+def read_phsp_columnar(filename, decode_directions=True):
+    """
+    Read a columnar phase-space file (.gphsp) in a dict of numpy arrays. The
+    quantized directions are decoded in three float32 arrays <name>_X,
+    <name>_Y and <name>_Z (or kept as uint32 codes if decode_directions is
+    False, see decode_phsp_directions).
+    """
+    with open(filename, "rb") as f:
+        data = f.read()
+    magic, version, nb_columns, num_entries, nb_chunks, index_offset = (
+        _PHSP_HEADER.unpack_from(data, 0)
+    )
+    if magic != b"GATEPHSP":
+        fatal(f"The file {filename} is not a phase-space file")
+    if version != _PHSP_VERSION:
+        fatal(f"The phase-space file {filename}: version {version} is not supported")
+    columns = []
+    for c in range(nb_columns):
+        name, column_type, _ = _PHSP_COLUMN_HEADER.unpack_from(
+            data, _PHSP_HEADER.size + c * _PHSP_COLUMN_HEADER.size
+        )
+        columns.append((name.rstrip(b"\0").decode(), column_type))
+    dtypes = {_PHSP_FLOAT32: "<f4", _PHSP_INT32: "<i4", _PHSP_DIRECTION: "<u4"}
+    values = {name: [] for name, _ in columns}
+    for i in range(nb_chunks):
+        _, n, offset, _ = _PHSP_CHUNK_INDEX.unpack_from(
+            data, index_offset + i * _PHSP_CHUNK_INDEX.size
+        )
+        for name, column_type in columns:
+            values[name].append(
+                np.frombuffer(data, dtype=dtypes[column_type], count=n, offset=offset)
+            )
+            offset += -(-(n * 4) // 8) * 8
+    arrays = {}
+    for name, column_type in columns:
+        a = np.concatenate(values[name]) if nb_chunks > 0 else np.zeros(0)
+        a = a.astype(dtypes[column_type].replace("<", "="))
+        if column_type == _PHSP_DIRECTION and decode_directions:
+            x, y, z = decode_phsp_directions(a)
+            arrays[f"{name}_X"], arrays[f"{name}_Y"], arrays[f"{name}_Z"] = x, y, z
+        else:
+            arrays[name] = a
+    return arrays
 
 
 class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
@@ -255,6 +538,7 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
     translate_position: bool
     rotate_direction: bool
     batch_size: int
+    reader: str
     position_key: str
     position_key_x: str
     position_key_y: str
@@ -266,6 +550,10 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
     energy_key: str
     weight_key: str
     PDGCode_key: str
+    prefetch: bool
+    recycling: int
+    recycling_rotation: bool
+    recycling_mirror: bool
     generate_until_next_primary: bool
     primary_lower_energy_threshold: float
     primary_PDGCode: int
@@ -274,7 +562,10 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
     user_info_defaults = {
         "phsp_file": (
             None,
-            {"doc": "Filename of the phase-space file (root). This is required"},
+            {
+                "doc": "Filename of the phase-space file (root, or columnar .gphsp file "
+                "with the native reader). This is required"
+            },
         ),
         "entry_start": (
             None,
@@ -309,6 +600,18 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
                 "doc": "Batch size to read the phsp",
             },
         ),
+        "reader": (
+            "python",
+            {
+                "doc": "How the phsp is read. 'python': each thread reads its batches "
+                "with uproot (Python callback). 'native': the phsp is memory-mapped "
+                "once in C++ and shared by all threads, without Python during the "
+                "run (no GIL, no copy). A root phsp is first converted to the "
+                "columnar format (file <phsp_name>_<source_name>.gphsp in the output "
+                "folder); a .gphsp file is used directly (see write_phsp_columnar).",
+                "allowed_values": ("python", "native"),
+            },
+        ),
         "position_key": (
             "PrePositionLocal",
             {
@@ -388,6 +691,40 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
                 "see https://pdg.lbl.gov/2007/reviews/montecarlorpp.pdf",
             },
         ),
+        "prefetch": (
+            False,
+            {
+                "doc": "With the python reader, the next batch is read in a background "
+                "thread while the current one is used, so that the Geant4 thread does "
+                "not wait for the file. (The native reader always asks the system to "
+                "read the next batch in advance.)",
+            },
+        ),
+        "recycling": (
+            1,
+            {
+                "doc": "Each particle of the phsp is used this number of times (one "
+                "event each) before the next one. Useful with recycling_rotation "
+                "and/or recycling_mirror to increase the statistics without reading "
+                "more of the file. Not compatible with generate_until_next_primary.",
+            },
+        ),
+        "recycling_rotation": (
+            False,
+            {
+                "doc": "Each time a particle is used, its position and direction are "
+                "rotated by a random angle around the Z axis of the phsp (the beam "
+                "axis), before translate_position and rotate_direction.",
+            },
+        ),
+        "recycling_mirror": (
+            False,
+            {
+                "doc": "Each time a particle is used, its position and direction are "
+                "mirrored (x -> -x) with a probability 1/2, in the coordinate system "
+                "of the phsp.",
+            },
+        ),
         "generate_until_next_primary": (
             False,
             {
@@ -427,14 +764,22 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
         self.particle_generator = {}
         # number of entries in the phsp root file
         self.num_entries = None
+        # columnar file of the native reader
+        self.native_phsp_file = None
 
     def __initcpp__(self):
         g4.GatePhaseSpaceSource.__init__(self)
 
     def initialize(self, run_timing_intervals):
-        # create a generator for each thread
-        tid = g4.G4GetThreadId()
-        self.particle_generator[tid] = PhaseSpaceSourceGenerator(tid)
+        # convert str like 1e3 to int (before the C++ side reads it)
+        self.recycling = int(self.recycling)
+        if self.recycling < 1:
+            fatal(f"PhaseSpaceSource {self.name}: recycling must be at least 1")
+        if self.recycling > 1 and self.generate_until_next_primary:
+            fatal(
+                f"PhaseSpaceSource {self.name}: recycling is not compatible with "
+                f"generate_until_next_primary"
+            )
 
         # initialize source
         SourceBase.initialize(self, run_timing_intervals)
@@ -480,6 +825,15 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
                 step = np.ceil(self.n / n_threads) + 1  # Specify the increment value
                 self.entry_start = [i * step for i in range(n_threads)]
 
+        # native reader: no generator in Python
+        if self.reader == "native":
+            self.initialize_native_reader()
+            return
+
+        # create a generator for each thread
+        tid = g4.G4GetThreadId()
+        self.particle_generator[tid] = PhaseSpaceSourceGenerator(tid)
+
         # initialize the generator (read the phsp file)
         self.particle_generator[tid].initialize(self)
 
@@ -489,8 +843,66 @@ class PhaseSpaceSource(SourceBase, g4.GatePhaseSpaceSource):
         # set the function pointer to the cpp side
         self.SetGeneratorFunction(self.particle_generator[tid].generate)
 
+    def initialize_native_reader(self):
+        # convert str like 1e5 to int
+        self.batch_size = int(self.batch_size)
+        if self.batch_size < 1:
+            fatal(f"PhaseSpaceSource {self.name}: Batch size should be > 0")
+
+        # the first thread (master in MT) converts the root file
+        if self.native_phsp_file is None:
+            self.native_phsp_file = self.get_native_phsp_file()
+
+        # the file is opened once and shared by all threads
+        self.InitializeNativeReader(self.user_info, str(self.native_phsp_file))
+        self.num_entries = self.GetNumberOfEntries()
+        n = get_phsp_entry_start(self.name, self.entry_start, self.num_entries)
+        self.SetEntryStart(n)
+
+    def get_native_phsp_file(self):
+        phsp_file = Path(self.phsp_file)
+        if phsp_file.suffix == ".gphsp":
+            return phsp_file
+        keys = [
+            self.position_key_x,
+            self.position_key_y,
+            self.position_key_z,
+            self.direction_key_x,
+            self.direction_key_y,
+            self.direction_key_z,
+            self.energy_key,
+        ]
+        tree = uproot.open(phsp_file)
+        branches = tree.keys()
+        if len(branches) == 0:
+            fatal(f"PhaseSpaceSource: no usable branches in the root file {phsp_file}")
+        tree = tree[branches[0]]
+        for k in [self.weight_key, self.PDGCode_key]:
+            if k is not None and k != "" and k in tree:
+                keys.append(k)
+        output = self.simulation.get_output_path(
+            f"{phsp_file.stem}_{self.name}.gphsp"
+        )
+        convert_phsp_root_to_columnar(phsp_file, output, keys)
+        return output
+
+    def prepare_output(self):
+        # stop reading in the background
+        for generator in self.particle_generator.values():
+            generator.close()
+
+    @property
+    def transform_in_cpp(self):
+        # see GatePhaseSpaceSource::InitializeUserInfo
+        return (
+            self.reader == "native" or self.recycling_rotation or self.recycling_mirror
+        )
+
     @property
     def cycle_count(self):
+        if self.reader == "native":
+            # all threads
+            return self.GetCycleCount()
         if not g4.IsMultithreadedApplication():
             tid = g4.G4GetThreadId()
             return self.particle_generator[tid].cycle_count
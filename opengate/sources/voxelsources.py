@@ -1,4 +1,5 @@
 import itk
+import numpy as np
 
 import opengate_core as g4
 from .generic import GenericSource
@@ -9,16 +10,18 @@ from ..image import (
 )
 from ..utility import ensure_filename_is_str
 from ..base import process_cls
+from ..exception import fatal
 
 
 class VoxelSource(GenericSource, g4.GateVoxelSource):
     """
     VoxelSource = 3D activity distribution.
-    Sampled with cumulative distribution functions.
+    Sampled with an alias table (default) or cumulative distribution functions.
     """
 
     # hints for IDE
     image: str
+    sampling: str
 
     user_info_defaults = {
         "image": (
@@ -28,7 +31,18 @@ class VoxelSource(GenericSource, g4.GateVoxelSource):
                 "(will be automatically normalized to sum=1)",
                 "is_input_file": True,
             },
-        )
+        ),
+        "sampling": (
+            "alias",
+            {
+                "doc": "Method to sample the voxel of each particle. 'alias': alias table "
+                "over the non-zero voxels (constant time per particle, one entry of "
+                "16 bytes per non-zero voxel). 'cdf': cumulative distribution "
+                "functions along Z, Y and X (previous method, e.g. to reproduce "
+                "older results).",
+                "allowed_values": ("alias", "cdf"),
+            },
+        ),
     }
 
     def __init__(self, *args, **kwargs):
@@ -68,6 +82,17 @@ class VoxelSource(GenericSource, g4.GateVoxelSource):
         pg = self.GetSPSVoxelPosDistribution()
         pg.SetCumulativeDistributionFunction(cdf_z, cdf_y, cdf_x)
 
+    def alias_table(self):
+        """
+        Build the alias table of the non-zero voxels of the image
+        (no need to normalize, no CDF)
+        """
+        array = itk.array_view_from_image(self.itk_image)
+        if array.ndim != 3:
+            fatal(f"The image of the voxel source {self.name} must be 3D")
+        pg = self.GetSPSVoxelPosDistribution()
+        pg.SetAliasTable(array)
+
     def initialize(self, run_timing_intervals):
         # read source image
         self.itk_image = itk.imread(ensure_filename_is_str(self.image))
@@ -75,8 +100,11 @@ class VoxelSource(GenericSource, g4.GateVoxelSource):
         # compute position
         self.set_transform_from_user_info()
 
-        # create Cumulative Distribution Function
-        self.cumulative_distribution_functions()
+        # create the alias table or the Cumulative Distribution Functions
+        if self.sampling == "alias":
+            self.alias_table()
+        else:
+            self.cumulative_distribution_functions()
 
         # FIXME -> check other option in position not used here
 
@@ -87,3 +115,185 @@ class VoxelSource(GenericSource, g4.GateVoxelSource):
 
 
 process_cls(VoxelSource)
+
+
+def tac_integral(times, activities, t0, t1):
+    """
+    Integral of the piecewise linear TAC between t0 and t1 (zero outside the
+    times of the TAC, as GateTimeActivityCurve)
+    """
+    times = np.asarray(times, dtype=float)
+    if t1 <= t0:
+        return 0.0
+    inside = times[(times > t0) & (times < t1)]
+    x = np.concatenate(([t0], inside, [t1]))
+    y = np.interp(x, times, activities, left=0, right=0)
+    return float(np.sum((y[1:] + y[:-1]) * np.diff(x)) / 2)
+
+
+class MultiChannelVoxelSource(VoxelSource, g4.GateMultiChannelVoxelSource):
+    """
+    Voxel source with several channels (e.g. one per organ) in a single label
+    image: each channel is the set of voxels with a given label, with its own
+    activity (uniform in the voxels of the channel) or its own TAC. A single
+    source replaces one VoxelSource per channel: the voxels of the channels
+    are stored once and the channel of each particle is sampled with an alias
+    table, built again only when the activities of the channels change (between
+    two runs, with TACs).
+    """
+
+    # hints for IDE
+    labels: list
+    activities: list
+    channel_tac_times: list
+    channel_tac_activities: list
+
+    user_info_defaults = {
+        "labels": (
+            None,
+            {
+                "doc": "Label values of the channels, in the image. By default, all "
+                "the non-zero labels of the image, in increasing order.",
+            },
+        ),
+        "activities": (
+            None,
+            {
+                "doc": "Total activity of each channel (uniform in the voxels of the "
+                "channel). The activity of the source is their sum.",
+            },
+        ),
+        "channel_tac_times": (
+            None,
+            {
+                "doc": "Times of the TACs of the channels (the same times for all "
+                "the channels). Must be used with channel_tac_activities.",
+            },
+        ),
+        "channel_tac_activities": (
+            None,
+            {
+                "doc": "TAC of each channel: total activity of the channel at each "
+                "time of channel_tac_times. Replaces 'activities'. The TAC of the "
+                "source is their sum, and the channels are sampled according to "
+                "the number of decays of each channel during the current run.",
+            },
+        ),
+    }
+
+    def __initcpp__(self):
+        g4.GateMultiChannelVoxelSource.__init__(self)
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        # the label image of the channels (only read once)
+        self.channels_filename = None
+
+    def initialize_channels(self):
+        filename = ensure_filename_is_str(self.image)
+        if self.channels_filename == filename:
+            return
+        self.itk_image = itk.imread(filename)
+        labels = itk.array_view_from_image(self.itk_image)
+        if labels.ndim != 3:
+            fatal(f"The label image of the source {self.name} must be 3D")
+        if self.labels is None:
+            self.labels = [int(l) for l in np.unique(labels) if l != 0]
+        # index of the channel of each voxel (-1: none)
+        channels = np.full(labels.shape, -1, dtype=np.int32)
+        for c, label in enumerate(self.labels):
+            channels[labels == label] = c
+        pg = self.GetSPSVoxelPosDistribution()
+        pg.SetChannels(channels, len(self.labels))
+        for c, label in enumerate(self.labels):
+            if pg.GetNumberOfChannelVoxels(c) == 0:
+                fatal(
+                    f"The label {label} of the source {self.name} is not in "
+                    f"the image {filename}"
+                )
+        self.channels_filename = filename
+
+    def get_run_channel_activities(self, run_timing_intervals):
+        """
+        Activities of the channels in each run: the constant activities, or the
+        number of decays of each channel during the run (TAC)
+        """
+        if self.channel_tac_activities is None:
+            return [list(self.activities)] * len(run_timing_intervals)
+        run_activities = []
+        for t0, t1 in run_timing_intervals:
+            a = [
+                tac_integral(self.channel_tac_times, tac, t0, t1)
+                for tac in self.channel_tac_activities
+            ]
+            # no decay in this run: any (non-zero) weights
+            if sum(a) <= 0:
+                a = [1.0] * len(a)
+            run_activities.append(a)
+        return run_activities
+
+    def check_channel_activities(self):
+        n = len(self.labels)
+        if self.channel_tac_activities is None:
+            if self.activities is None or len(self.activities) != n:
+                fatal(
+                    f"The source {self.name} needs one activity per channel "
+                    f"({n} labels), in 'activities' or 'channel_tac_activities'"
+                )
+            return
+        if self.tac_times is not None or self.tac_activities is not None:
+            fatal(
+                f"The source {self.name} cannot use tac_times/tac_activities with "
+                f"channel_tac_activities (the TAC of the source is their sum)"
+            )
+        if self.channel_tac_times is None or len(self.channel_tac_activities) != n:
+            fatal(
+                f"The source {self.name} needs channel_tac_times and one TAC per "
+                f"channel ({n} labels) in channel_tac_activities"
+            )
+        for tac in self.channel_tac_activities:
+            if len(tac) != len(self.channel_tac_times):
+                fatal(
+                    f"The TACs of the source {self.name} must have the same size "
+                    f"as channel_tac_times"
+                )
+
+    def initialize(self, run_timing_intervals):
+        self.initialize_channels()
+        self.check_channel_activities()
+
+        # compute position
+        self.set_transform_from_user_info()
+
+        # activity of the source: sum of the channels (with n, the activities
+        # of the channels are only relative)
+        if self.channel_tac_activities is None:
+            if self.n == 0:
+                self.activity = float(np.sum(self.activities))
+        else:
+            # as update_tac_activity does for the TAC of a GenericSource
+            tac = np.sum(np.asarray(self.channel_tac_activities), axis=0)
+            self.start_time = self.channel_tac_times[0]
+            self.activity = float(tac[0])
+            self.SetTAC(self.channel_tac_times, list(tac))
+        self.SetRunChannelActivities(
+            self.get_run_channel_activities(run_timing_intervals)
+        )
+
+        # initialize standard options (particle energy, etc.)
+        GenericSource.initialize(self, run_timing_intervals)
+
+    def distribute(self, context):
+        super().distribute(context)
+        activities, channel_tac_activities = self.get_undistributed_values(
+            "activities", "channel_tac_activities"
+        )
+        if activities is not None:
+            self.activities = [a / context.size for a in activities]
+        if channel_tac_activities is not None:
+            self.channel_tac_activities = [
+                [a / context.size for a in tac] for tac in channel_tac_activities
+            ]
+
+
+process_cls(MultiChannelVoxelSource)
@@ -0,0 +1,85 @@
+"""
+Helpers of the reference simulations used to measure the performance of
+opengate (tests/src/bench*.py), started by the opengate_benchmarks command.
+
+Each benchmark script creates its simulation with the number of threads and
+the scale (multiplier of the number of primaries) given on the command line,
+then calls run_benchmark that runs it and writes the measurements in a json
+file (or prints them).
+"""
+
+import argparse
+import json
+import resource
+import sys
+
+from ..actors.miscactors import SimulationStatisticsActor
+from ..exception import fatal
+
+
+def parse_benchmark_args(description=""):
+    parser = argparse.ArgumentParser(description=description)
+    parser.add_argument(
+        "--threads", "-t", type=int, default=1, help="Number of threads"
+    )
+    parser.add_argument(
+        "--scale",
+        "-s",
+        type=float,
+        default=1.0,
+        help="Multiplier of the number of primaries",
+    )
+    parser.add_argument(
+        "--output", "-o", default=None, help="Output json file of the results"
+    )
+    return parser.parse_args()
+
+
+def get_peak_rss():
+    """Peak resident set size (in MB) of this process and of its (waited)
+    child processes, e.g. the processes of the 'fork' distributed mode."""
+    rss = max(
+        resource.getrusage(resource.RUSAGE_SELF).ru_maxrss,
+        resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss,
+    )
+    # bytes on macOS, kilobytes on linux
+    if sys.platform == "darwin":
+        return rss / 1024**2
+    return rss / 1024
+
+
+def run_benchmark(sim, args, name):
+    # the number of events is given by the statistics actor (added if needed)
+    stats = [
+        a
+        for a in sim.actor_manager.actors.values()
+        if isinstance(a, SimulationStatisticsActor)
+    ]
+    if len(stats) == 0:
+        stats = [sim.add_actor("SimulationStatisticsActor", "benchmark_stats")]
+    stats = stats[0]
+
+    sim.run()
+
+    events = stats.counts.events
+    run_time = sim.run_timings["run"]
+    if events == 0:
+        fatal(f"Benchmark {name}: no event was simulated")
+    results = {
+        "name": name,
+        "threads": sim.number_of_threads,
+        "scale": args.scale,
+        "events": events,
+        "init_time": sum(sim.initialization_timings.values()),
+        "run_time": run_time,
+        "output_time": sim.run_timings["output"],
+        "events_per_second": events / run_time if run_time > 0 else 0,
+        "peak_rss_mb": get_peak_rss(),
+        "initialization_timings": sim.initialization_timings,
+    }
+    if args.output is None:
+        print(json.dumps(results, indent=4))
+    else:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=4)
+    return results
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.tests.benchmarks import parse_benchmark_args, run_benchmark
+
+if __name__ == "__main__":
+    args = parse_benchmark_args("Proton beam in a CT image, dose actor")
+    paths = utility.get_default_test_paths(
+        __file__, "gate_test009_voxels", output_folder="bench001"
+    )
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.random_seed = 123654
+    sim.number_of_threads = args.threads
+    sim.output_dir = paths.output
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+    gcm3 = gate.g4_units.g_cm3
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # CT image, materials from the Hounsfield units
+    patient = sim.add_volume("Image", "patient")
+    patient.image = paths.data / "patient-4mm.mhd"
+    patient.material = "G4_AIR"
+    f1 = str(paths.gate_data / "Schneider2000MaterialsTable.txt")
+    f2 = str(paths.gate_data / "Schneider2000DensitiesTable.txt")
+    patient.voxel_materials, materials = (
+        gate.geometry.materials.HounsfieldUnit_to_material(sim, 0.05 * gcm3, f1, f2)
+    )
+
+    # physics
+    sim.physics_manager.physics_list_name = "QGSP_BIC_EMZ"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # proton beam
+    source = sim.add_source("GenericSource", "proton_beam")
+    source.particle = "proton"
+    source.energy.mono = 150 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 2e4 * args.scale / sim.number_of_threads
+
+    # dose actor, 2 mm voxels
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.output_filename = "bench001_dose.mhd"
+    dose.attached_to = patient
+    dose.size = [125, 125, 125]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.dose.active = True
+    dose.edep_uncertainty.active = True
+
+    run_benchmark(sim, args, "ct_proton_dose")
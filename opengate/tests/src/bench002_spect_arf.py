@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+import opengate.contrib.spect.ge_discovery_nm670 as gate_spect
+from opengate.tests import utility
+from opengate.tests.benchmarks import parse_benchmark_args, run_benchmark
+import test043_garf_helpers as test43
+from scipy.spatial.transform import Rotation
+
+if __name__ == "__main__":
+    args = parse_benchmark_args("Tc99m SPECT with two ARF heads")
+    paths = utility.get_default_test_paths(
+        __file__, "gate_test043_garf", output_folder="bench002"
+    )
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.random_seed = 321654987
+    sim.number_of_threads = args.threads
+    sim.output_dir = paths.output
+
+    # units
+    nm = gate.g4_units.nm
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    # world, physics and the three Tc99m spheres of test043
+    sim.volume_manager.add_material_database(paths.gate_data / "GateMaterials.db")
+    test43.sim_set_world(sim)
+    test43.sim_phys(sim)
+    test43.sim_source_test(sim, 2e5 * args.scale * Bq / sim.number_of_threads)
+
+    # two (fake) heads, the detector plane of each one has an ARF actor
+    pos, crystal_dist, psd = gate_spect.get_plane_position_and_distance_to_crystal(
+        "lehr"
+    )
+    for i, z in enumerate([-15 * cm, 15 * cm]):
+        head = gate_spect.add_fake_spect_head(sim, f"spect{i}")
+        head.translation = [0, 0, z]
+        if z > 0:
+            head.rotation = Rotation.from_euler("x", 180, degrees=True).as_matrix()
+        plane = test43.sim_add_detector_plane(
+            sim, head.name, pos + 1 * nm, f"det_plane{i}"
+        )
+        arf = sim.add_actor("ARFActor", f"arf{i}")
+        arf.attached_to = plane
+        arf.output_filename = f"bench002_projection_{i}.mhd"
+        arf.batch_size = 2e5
+        arf.image_size = [128, 128]
+        arf.image_spacing = [4.41806 * mm, 4.41806 * mm]
+        arf.distance_to_crystal = 74.625 * mm
+        arf.pth_filename = paths.gate_data / "pth" / "arf_Tc99m_v034.pth"
+        arf.flip_plane = True
+        arf.gpu_mode = utility.get_gpu_mode_for_tests()
+
+    sim.run_timing_intervals = [[0, 1 * sec]]
+
+    run_benchmark(sim, args, "spect_arf")
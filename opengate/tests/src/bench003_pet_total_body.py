@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.tests.benchmarks import parse_benchmark_args, run_benchmark
+
+if __name__ == "__main__":
+    args = parse_benchmark_args("Total-body PET with coincidences")
+    paths = utility.get_default_test_paths(__file__, output_folder="bench003")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.random_seed = 654321
+    sim.number_of_threads = args.threads
+    sim.output_dir = paths.output
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    ns = gate.g4_units.ns
+    sec = gate.g4_units.s
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+    gcm3 = gate.g4_units.g_cm3
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 2.5 * m]
+    sim.world.material = "G4_AIR"
+    sim.volume_manager.material_database.add_material_weights(
+        "LYSO",
+        ["Lu", "Y", "Si", "O"],
+        [0.31101534, 0.368765605, 0.083209699, 0.237009356],
+        5.37 * gcm3,
+    )
+
+    # 1 m long scanner: 40 rings of 80 blocks of 4x4 crystals (as test106)
+    pet = sim.add_volume("Tubs", "pet")
+    pet.rmin = 380 * mm
+    pet.rmax = 430 * mm
+    pet.dz = 50 * cm
+    pet.material = "G4_AIR"
+
+    ring = sim.add_volume("Tubs", "ring")
+    ring.mother = pet
+    ring.rmin = pet.rmin
+    ring.rmax = pet.rmax
+    ring.dz = 12.5 * mm
+    ring.material = "G4_AIR"
+    ring.translation = gate.geometry.utility.get_grid_repetition(
+        [1, 1, 40], [0, 0, 25 * mm]
+    )
+
+    block = sim.add_volume("Box", "block")
+    block.mother = ring
+    block.size = [20 * mm, 28 * mm, 24 * mm]
+    block.material = "G4_AIR"
+    block.translation, block.rotation = gate.geometry.utility.get_circular_repetition(
+        80, [400 * mm, 0, 0], start_angle_deg=180, axis=[0, 0, 1]
+    )
+
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.mother = block
+    crystal.size = [20 * mm, 7 * mm, 6 * mm]
+    crystal.material = "LYSO"
+    crystal.translation = gate.geometry.utility.get_grid_repetition(
+        [1, 4, 4], [0, 7 * mm, 6 * mm]
+    )
+
+    # water cylinder with the F18 activity (back to back gammas)
+    phantom = sim.add_volume("Tubs", "phantom")
+    phantom.rmax = 15 * cm
+    phantom.dz = 45 * cm
+    phantom.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "b2b")
+    source.attached_to = phantom
+    source.particle = "back_to_back"
+    source.energy.mono = 511 * keV
+    source.position.type = "cylinder"
+    source.position.radius = 15 * cm
+    source.position.dz = 45 * cm
+    source.direction.type = "iso"
+    source.activity = 2e5 * args.scale * Bq / sim.number_of_threads
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # hits, singles and coincidences sorted during the simulation
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.authorize_repeated_volumes = True
+    hc.output_filename = "bench003_pet.root"
+    hc.attributes = [
+        "EventID",
+        "PostPosition",
+        "TotalEnergyDeposit",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+    ]
+    hc.root_output.write_to_disk = False
+
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.authorize_repeated_volumes = True
+    sc.input_digi_collection = hc.name
+    sc.policy = "EnergyWinnerPosition"
+    sc.output_filename = hc.output_filename
+
+    cc = sim.add_actor("DigitizerCoincidenceSorterActor", "coincidences")
+    cc.input_digi_collection = sc.name
+    cc.window = 4 * ns
+    cc.policy = "removeMultiples"
+    cc.output_filename = hc.output_filename
+
+    sim.run_timing_intervals = [[0, 1 * sec]]
+
+    run_benchmark(sim, args, "pet_total_body")
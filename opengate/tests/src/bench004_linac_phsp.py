@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.tests.benchmarks import parse_benchmark_args, run_benchmark
+
+if __name__ == "__main__":
+    args = parse_benchmark_args("Replay of a linac phase space, dose in water")
+    paths = utility.get_default_test_paths(
+        __file__, "gate_test019_linac_phsp", output_folder="bench004"
+    )
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.random_seed = 987654321
+    sim.number_of_threads = args.threads
+    sim.output_dir = paths.output
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # water tank below the phase space plane (at -300 mm, see test019)
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [30 * cm, 30 * cm, 30 * cm]
+    waterbox.translation = [0, 0, -46 * cm]
+    waterbox.material = "G4_WATER"
+
+    # phase space of the linac head (test019), replayed (cycled) as needed
+    source = sim.add_source("PhaseSpaceSource", "phsp")
+    source.attached_to = sim.world
+    source.phsp_file = paths.output_ref.parent / "test019" / "test019_hits.root"
+    source.position_key = "PrePosition"
+    source.direction_key = "PreDirection"
+    source.global_flag = True
+    source.particle = "gamma"
+    source.n = 2e5 * args.scale / sim.number_of_threads
+    source.batch_size = 1e5
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.enable_decay = False
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # dose actor, 2 mm voxels
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.output_filename = "bench004_dose.mhd"
+    dose.attached_to = waterbox
+    dose.size = [150, 150, 150]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.dose.active = True
+
+    run_benchmark(sim, args, "linac_phsp")
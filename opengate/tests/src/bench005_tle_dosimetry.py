@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.tests.benchmarks import parse_benchmark_args, run_benchmark
+from opengate.tests.src.test081_tle_helpers import add_source
+
+if __name__ == "__main__":
+    args = parse_benchmark_args("Track length estimator dose in a voxelized phantom")
+    paths = utility.get_default_test_paths(__file__, output_folder="bench005")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.random_seed = 321654
+    sim.number_of_threads = args.threads
+    sim.output_dir = paths.output
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # voxelized waterbox with inserts (test081)
+    waterbox = sim.add_volume("Image", "waterbox")
+    fn = paths.data / "test081_tle" / "waterbox_with_inserts_8mm_"
+    waterbox.image = f"{fn}image.mhd"
+    waterbox.set_materials_from_voxelisation(f"{fn}labels.json")
+    waterbox_size = [30 * cm, 30 * cm, 20 * cm]
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # low energy photons (see test081)
+    add_source(sim, n=2e5 * args.scale)
+
+    # TLE dose actor
+    tle = sim.add_actor("TLEDoseActor", "tle")
+    tle.output_filename = "bench005_tle.mhd"
+    tle.attached_to = waterbox
+    tle.dose.active = True
+    tle.dose_uncertainty.active = True
+    tle.size = [100, 100, 100]
+    tle.spacing = [x / y for x, y in zip(waterbox_size, tle.size)]
+    tle.score_in = "material"
+
+    run_benchmark(sim, args, "tle_dosimetry")
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test088")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 4
+    sim.random_seed = 123456
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # default source for tests
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    # reference dose actor: shared images protected by a mutex
+    # (hit_type must not be random, otherwise both actors would not score at the same position)
+    dose_ref = sim.add_actor("DoseActor", "dose_ref")
+    dose_ref.attached_to = waterbox
+    dose_ref.size = [50, 50, 50]
+    dose_ref.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose_ref.hit_type = "middle"
+    dose_ref.dose.active = True
+    dose_ref.counts.active = True
+    dose_ref.scoring_mode = "mutex"
+    dose_ref.output_filename = "test088_mutex.mhd"
+
+    # same actor, with per-thread buffers
+    dose_tl = sim.add_actor("DoseActor", "dose_tl")
+    dose_tl.attached_to = waterbox
+    dose_tl.size = [50, 50, 50]
+    dose_tl.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose_tl.hit_type = "middle"
+    dose_tl.dose.active = True
+    dose_tl.counts.active = True
+    dose_tl.scoring_mode = "thread_local"
+    dose_tl.output_filename = "test088_thread_local.mhd"
+
+    # same actor, with per-thread buffers in float
+    dose_tlf = sim.add_actor("DoseActor", "dose_tlf")
+    dose_tlf.attached_to = waterbox
+    dose_tlf.size = [50, 50, 50]
+    dose_tlf.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose_tlf.hit_type = "middle"
+    dose_tlf.dose.active = True
+    dose_tlf.counts.active = True
+    dose_tlf.scoring_mode = "thread_local"
+    dose_tlf.buffer_precision = "float"
+    dose_tlf.output_filename = "test088_thread_local_float.mhd"
+
+    # same actor, with lock-free atomic additions
+    dose_at = sim.add_actor("DoseActor", "dose_at")
+    dose_at.attached_to = waterbox
+    dose_at.size = [50, 50, 50]
+    dose_at.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose_at.hit_type = "middle"
+    dose_at.dose.active = True
+    dose_at.counts.active = True
+    dose_at.scoring_mode = "atomic"
+    dose_at.output_filename = "test088_atomic.mhd"
+
+    # same actor, with per-thread sparse images
+    dose_sp = sim.add_actor("DoseActor", "dose_sp")
+    dose_sp.attached_to = waterbox
+    dose_sp.size = [50, 50, 50]
+    dose_sp.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose_sp.hit_type = "middle"
+    dose_sp.dose.active = True
+    dose_sp.dose_uncertainty.active = True
+    dose_sp.counts.active = True
+    dose_sp.scoring_mode = "sparse"
+    dose_sp.output_filename = "test088_sparse.mhd"
+    dose_ref.dose_uncertainty.active = True
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # both modes must lead to the same images (up to the summation order)
+    is_ok = True
+    for actor in (dose_tl, dose_at, dose_sp):
+        for output in ("edep", "dose", "counts"):
+            print(f"Compare {output} with scoring_mode={actor.scoring_mode}")
+            is_ok = (
+                utility.assert_images(
+                    dose_ref.get_output_path(output),
+                    actor.get_output_path(output),
+                    stats,
+                    tolerance=1e-6,
+                    sum_tolerance=1e-6,
+                )
+                and is_ok
+            )
+
+    # the float buffers only lose precision in the per-thread sums
+    for output in ("edep", "dose", "counts"):
+        print(f"Compare {output} with buffer_precision=float")
+        is_ok = (
+            utility.assert_images(
+                dose_ref.get_output_path(output),
+                dose_tlf.get_output_path(output),
+                stats,
+                tolerance=1e-4,
+                sum_tolerance=1e-4,
+            )
+            and is_ok
+        )
+
+    # the sparse mode also handles the squared values (history by history)
+    print("Compare dose_uncertainty with scoring_mode=sparse")
+    is_ok = (
+        utility.assert_images(
+            dose_ref.get_output_path("dose_uncertainty"),
+            dose_sp.get_output_path("dose_uncertainty"),
+            stats,
+            tolerance=1e-6,
+            sum_tolerance=1e-6,
+        )
+        and is_ok
+    )
+
+    utility.test_ok(is_ok)
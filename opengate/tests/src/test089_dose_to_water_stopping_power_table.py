@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test089")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 987654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # bone slab (the conversion to water is not trivial)
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [10 * cm, 10 * cm, 10 * cm]
+    phantom.material = "G4_BONE_COMPACT_ICRU"
+
+    # proton beam
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 120 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 2 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 2000
+
+    # dose to water, stopping power ratios computed at each step
+    # (hit_type must not be random, otherwise both actors would not score at the same position)
+    dose_ref = sim.add_actor("DoseActor", "dose_ref")
+    dose_ref.attached_to = phantom
+    dose_ref.size = [1, 1, 100]
+    dose_ref.spacing = [10 * cm, 10 * cm, 1 * mm]
+    dose_ref.hit_type = "middle"
+    dose_ref.score_in = "G4_WATER"
+    dose_ref.dose.active = True
+    dose_ref.stopping_power_table = False
+    dose_ref.output_filename = "test089_computed.mhd"
+
+    # dose to water, tabulated stopping power ratios
+    dose_tab = sim.add_actor("DoseActor", "dose_tab")
+    dose_tab.attached_to = phantom
+    dose_tab.size = [1, 1, 100]
+    dose_tab.spacing = [10 * cm, 10 * cm, 1 * mm]
+    dose_tab.hit_type = "middle"
+    dose_tab.score_in = "G4_WATER"
+    dose_tab.dose.active = True
+    dose_tab.stopping_power_table = True
+    dose_tab.output_filename = "test089_table.mhd"
+
+    # LET in water, computed and tabulated
+    let_ref = sim.add_actor("LETActor", "let_ref")
+    let_ref.attached_to = phantom
+    let_ref.size = [1, 1, 100]
+    let_ref.spacing = [10 * cm, 10 * cm, 1 * mm]
+    let_ref.hit_type = "middle"
+    let_ref.stopping_power_table = False
+    let_ref.output_filename = "test089_let_computed.mhd"
+
+    let_tab = sim.add_actor("LETActor", "let_tab")
+    let_tab.attached_to = phantom
+    let_tab.size = [1, 1, 100]
+    let_tab.spacing = [10 * cm, 10 * cm, 1 * mm]
+    let_tab.hit_type = "middle"
+    let_tab.stopping_power_table = True
+    let_tab.output_filename = "test089_let_table.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # the interpolation error of the tables is expected to be very small
+    is_ok = utility.assert_images(
+        dose_ref.dose.get_output_path(),
+        dose_tab.dose.get_output_path(),
+        stats,
+        tolerance=0.5,
+        sum_tolerance=0.5,
+    )
+    is_ok = (
+        utility.assert_images(
+            let_ref.let.get_output_path(),
+            let_tab.let.get_output_path(),
+            stats,
+            tolerance=1.0,
+            sum_tolerance=1.0,
+        )
+        and is_ok
+    )
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def mean_uncertainty_in_high_dose_region(actor, threshold=0.5):
+    edep = itk.GetArrayFromImage(itk.imread(actor.get_output_path("edep")))
+    unc = itk.GetArrayFromImage(
+        itk.imread(actor.get_output_path("edep_uncertainty"))
+    )
+    mask = edep > threshold * np.max(edep)
+    return np.mean(unc[mask])
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test090")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 4
+    sim.random_seed = 654321
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # default source for tests
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 4000
+
+    # reference: uncertainty estimated history by history
+    dose_hist = sim.add_actor("DoseActor", "dose_hist")
+    dose_hist.attached_to = waterbox
+    dose_hist.size = [1, 1, 50]
+    dose_hist.spacing = [10 * cm, 10 * cm, 2 * mm]
+    dose_hist.hit_type = "middle"
+    dose_hist.edep_uncertainty.active = True
+    dose_hist.output_filename = "test090_history.mhd"
+
+    # same actor, uncertainty estimated from batches of 20 events
+    dose_batch = sim.add_actor("DoseActor", "dose_batch")
+    dose_batch.attached_to = waterbox
+    dose_batch.size = [1, 1, 50]
+    dose_batch.spacing = [10 * cm, 10 * cm, 2 * mm]
+    dose_batch.hit_type = "middle"
+    dose_batch.edep_uncertainty.active = True
+    dose_batch.uncertainty_batch_size = 20
+    dose_batch.output_filename = "test090_batch.mhd"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # the scored edep does not depend on the way the squared values are summed
+    is_ok = utility.assert_images(
+        dose_hist.get_output_path("edep"),
+        dose_batch.get_output_path("edep"),
+        stats,
+        tolerance=1e-6,
+        sum_tolerance=1e-6,
+    )
+
+    # both estimators of the relative uncertainty must be close
+    unc_hist = mean_uncertainty_in_high_dose_region(dose_hist)
+    unc_batch = mean_uncertainty_in_high_dose_region(dose_batch)
+    diff = abs(unc_batch - unc_hist) / unc_hist
+    b = diff < 0.2
+    utility.print_test(
+        b,
+        f"Mean uncertainty history by history {unc_hist:.4f}, "
+        f"by batch {unc_batch:.4f}, relative difference {diff:.3f}",
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
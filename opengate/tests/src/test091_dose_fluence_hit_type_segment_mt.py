@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test091")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # proton beam
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    n = 1000
+    source.n = n / sim.number_of_threads
+
+    # reference: the deposit of each step is scored at the middle of the step
+    dose_middle = sim.add_actor("DoseActor", "dose_middle")
+    dose_middle.attached_to = waterbox
+    dose_middle.size = [1, 1, 100]
+    dose_middle.spacing = [10 * cm, 10 * cm, 1 * mm]
+    dose_middle.hit_type = "middle"
+    dose_middle.output_filename = "test091_middle.mhd"
+
+    # the deposit of each step is spread over the crossed voxels
+    dose_segment = sim.add_actor("DoseActor", "dose_segment")
+    dose_segment.attached_to = waterbox
+    dose_segment.size = [1, 1, 100]
+    dose_segment.spacing = [10 * cm, 10 * cm, 1 * mm]
+    dose_segment.hit_type = "segment"
+    dose_segment.output_filename = "test091_segment.mhd"
+
+    # track length fluence
+    fluence = sim.add_actor("FluenceActor", "fluence")
+    fluence.attached_to = waterbox
+    fluence.size = [1, 1, 100]
+    fluence.spacing = [10 * cm, 10 * cm, 1 * mm]
+    fluence.hit_type = "segment"
+    fluence.output_filename = "test091_fluence.mhd"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # both hit types must lead to the same total edep and to close profiles
+    is_ok = utility.assert_images(
+        dose_middle.edep.get_output_path(),
+        dose_segment.edep.get_output_path(),
+        stats,
+        tolerance=5,
+        sum_tolerance=0.5,
+    )
+
+    # at the entrance, the fluence is the number of protons over the area
+    # of the image (10 x 10 cm)
+    img = itk.imread(fluence.fluence.get_output_path())
+    arr = itk.GetArrayFromImage(img).ravel()
+    expected = n / (10 * cm * 10 * cm)
+    entrance = np.mean(arr[:5])
+    diff = abs(entrance - expected) / expected
+    b = diff < 0.05
+    utility.print_test(
+        b,
+        f"Entrance fluence {entrance:.6f} /mm2 vs expected {expected:.6f} /mm2, "
+        f"relative difference {diff:.3f}",
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
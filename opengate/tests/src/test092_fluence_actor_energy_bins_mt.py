@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test092")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 87654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    eV = gate.g4_units.eV
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # two lines gamma beam
+    source = sim.add_source("GenericSource", "mysource")
+    source.particle = "gamma"
+    source.energy.type = "spectrum_discrete"
+    source.energy.spectrum_energies = [140 * keV, 364 * keV]
+    source.energy.spectrum_weights = [0.5, 0.5]
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    n = 20000
+    source.n = n / sim.number_of_threads
+
+    # spectral fluence, log-uniform bins covering all the particles
+    fluence = sim.add_actor("FluenceActor", "fluence")
+    fluence.attached_to = waterbox
+    fluence.size = [1, 1, 50]
+    fluence.spacing = [10 * cm, 10 * cm, 2 * mm]
+    fluence.energy_bins = np.geomspace(1 * eV, 10 * MeV, 71)
+    fluence.output_filename = "test092_fluence.mhd"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    integral = itk.GetArrayFromImage(
+        itk.imread(fluence.fluence.get_output_path())
+    ).ravel()
+    spectrum = itk.GetArrayFromImage(
+        itk.imread(fluence.fluence_spectrum.get_output_path())
+    )
+    print(f"Spectral fluence image shape (bins, z, y, x): {spectrum.shape}")
+    is_ok = spectrum.shape == (70, 50, 1, 1)
+    utility.print_test(is_ok, "Spectral fluence image has 70 energy bins")
+
+    # the sum over the bins is the integral fluence in every voxel
+    summed = spectrum.sum(axis=0).ravel()
+    diff = np.max(np.abs(summed - integral)) / np.max(integral)
+    b = diff < 1e-4
+    utility.print_test(
+        b, f"Sum over the energy bins vs integral fluence: max diff {diff:.2e}"
+    )
+    is_ok = is_ok and b
+
+    # at the entrance, half of the particles are in the bin of each line
+    edges = np.array(fluence.energy_bins)
+    entrance = spectrum[:, 0, 0, 0]
+    for e in (140 * keV, 364 * keV):
+        i = np.searchsorted(edges, e, side="right") - 1
+        fraction = entrance[i] / entrance.sum()
+        b = abs(fraction - 0.5) < 0.03
+        utility.print_test(
+            b, f"Entrance fraction in the bin of {e / keV:.0f} keV: {fraction:.3f}"
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
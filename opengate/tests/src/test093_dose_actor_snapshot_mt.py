@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test093")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # proton beam
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    n = 2000
+    source.n = n / sim.number_of_threads
+
+    # dose actor with per-thread buffers and a snapshot every 300 events
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [1, 1, 50]
+    dose.spacing = [10 * cm, 10 * cm, 2 * mm]
+    dose.dose.active = True
+    dose.scoring_mode = "thread_local"
+    dose.snapshot_event_interval = 300
+    dose.output_filename = "test093.mhd"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # the last snapshot is taken by the first thread while the other one is running
+    nb_events = dose.GetSnapshotNumberOfEvents()
+    print(f"Number of events of the last snapshot: {nb_events} / {n}")
+    is_ok = 0 < nb_events <= n
+    utility.print_test(is_ok, "At least one snapshot has been taken")
+
+    snapshot = dose.get_snapshot("edep")
+    final = itk.GetArrayFromImage(itk.imread(dose.edep.get_output_path()))
+    print(f"Snapshot shape: {snapshot.shape}")
+    b = snapshot.shape == final.shape
+    utility.print_test(b, "Snapshot has the shape of the edep image")
+    is_ok = is_ok and b
+
+    # the snapshot is a partial sum of the final image (same events, fewer)
+    ratio = snapshot.sum() / final.sum()
+    b = 0 < ratio <= 1 + 1e-9 and np.all(snapshot <= final * (1 + 1e-9))
+    utility.print_test(b, f"Snapshot edep is a part of the final edep: {ratio:.3f}")
+    is_ok = is_ok and b
+
+    # with similar profiles, normalized by the number of events
+    expected = nb_events / n
+    b = abs(ratio - expected) < 0.1
+    utility.print_test(
+        b, f"Fraction of the edep vs fraction of the events: {ratio:.3f} {expected:.3f}"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test094")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.random_seed = 97531
+    sim.output_dir = paths.output
+    # the sources with the same time profile share one Poisson process
+    sim.aggregate_sources = True
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # the first step of each primary is stored in this volume
+    box = sim.add_volume("Box", "box")
+    box.size = [20 * cm, 20 * cm, 20 * cm]
+    box.material = "G4_Galactic"
+
+    # 12 point sources, identified by their energy: 8 with the same half-life
+    # (one shared process) and 4 with a constant activity (another one)
+    duration = 2 * sec
+    half_life = 1 * sec
+    expected = []
+    for i in range(12):
+        source = sim.add_source("GenericSource", f"source_{i}")
+        source.attached_to = box
+        source.particle = "gamma"
+        source.energy.mono = (i + 1) * 10 * keV
+        source.position.type = "point"
+        source.position.translation = [(i - 6) * cm, 0, 0]
+        source.direction.type = "iso"
+        source.activity = (500 + 250 * (i % 4)) * Bq
+        if i < 8:
+            source.half_life = half_life
+            decay = np.log(2) / half_life
+            n = source.activity / Bq * (1 - np.exp(-decay * duration)) / decay
+        else:
+            n = source.activity / Bq * duration / sec
+        expected.append(n)
+    expected = np.array(expected)
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = box
+    phsp.attributes = ["KineticEnergy", "GlobalTime"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test094.root"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    sim.run_timing_intervals = [[0, duration]]
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # number of events of each source
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    energies = data["KineticEnergy"]
+    index = np.round(energies / (10 * keV)).astype(int) - 1
+    counts = np.bincount(index, minlength=12)
+
+    is_ok = True
+    for i in range(12):
+        sigma = np.sqrt(expected[i])
+        d = abs(counts[i] - expected[i]) / sigma
+        b = d < 4
+        utility.print_test(
+            b,
+            f"Source {i:2d}: {counts[i]:5d} events, expected {expected[i]:7.1f} "
+            f"({d:.1f} sigma)",
+        )
+        is_ok = is_ok and b
+
+    # the decaying sources emit earlier than the constant ones
+    times = data["GlobalTime"] / sec
+    mean_decay = np.mean(times[index < 8])
+    decay = np.log(2) / (half_life / sec)
+    d = duration / sec
+    ref = 1 / decay - d * np.exp(-decay * d) / (1 - np.exp(-decay * d))
+    b = abs(mean_decay - ref) < 0.02
+    utility.print_test(
+        b, f"Mean time of the decaying sources: {mean_decay:.3f} s vs {ref:.3f} s"
+    )
+    is_ok = is_ok and b
+
+    mean_constant = np.mean(times[index >= 8])
+    b = abs(mean_constant - d / 2) < 0.03
+    utility.print_test(
+        b, f"Mean time of the constant sources: {mean_constant:.3f} s vs {d / 2:.3f} s"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
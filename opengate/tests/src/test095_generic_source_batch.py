@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.sources.base import get_rad_gamma_spectrum
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test095")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 123987
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # the first step of each primary is stored in this volume
+    box = sim.add_volume("Box", "box")
+    box.size = [20 * cm, 20 * cm, 20 * cm]
+    box.material = "G4_Galactic"
+
+    # gamma source, primaries generated by batches of 1000 (the last one is
+    # partially used)
+    spectrum = get_rad_gamma_spectrum("Lu177")
+    source = sim.add_source("GenericSource", "source")
+    source.attached_to = box
+    source.particle = "gamma"
+    source.position.type = "box"
+    source.position.size = [10 * cm, 6 * cm, 2 * cm]
+    source.direction.type = "iso"
+    source.energy.type = "spectrum_discrete"
+    source.energy.spectrum_energies = spectrum.energies
+    source.energy.spectrum_weights = spectrum.weights
+    n = 100500
+    source.n = n
+    source.batch_size = 1000
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = box
+    phsp.attributes = ["KineticEnergy", "PrePosition", "PreDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test095.root"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    energies = data["KineticEnergy"]
+    nb = len(energies)
+    b = nb == n
+    utility.print_test(b, f"Number of primaries: {nb}")
+    is_ok = b
+
+    # energy lines
+    weights = np.array(spectrum.weights) / np.sum(spectrum.weights)
+    for e, w in zip(spectrum.energies, weights):
+        count = np.count_nonzero(energies == e)
+        expected = w * nb
+        d = abs(count - expected) / np.sqrt(expected)
+        b = d < 4
+        utility.print_test(
+            b, f"Energy {e:.4f} MeV: {count} vs {expected:.1f} ({d:.1f} sigma)"
+        )
+        is_ok = is_ok and b
+    b = np.all(np.isin(energies, spectrum.energies))
+    utility.print_test(b, "All energies are lines of the spectrum")
+    is_ok = is_ok and b
+
+    # uniform positions in the box: mean 0 and std = size / sqrt(12)
+    for axis, size in zip(["X", "Y", "Z"], source.position.size):
+        p = data[f"PrePosition_{axis}"]
+        ref_std = size / np.sqrt(12)
+        mean_ok = abs(np.mean(p)) < 4 * ref_std / np.sqrt(nb)
+        std_ok = abs(np.std(p) - ref_std) / ref_std < 0.01
+        b = mean_ok and std_ok and np.all(np.abs(p) <= size / 2)
+        utility.print_test(
+            b,
+            f"Position {axis}: mean {np.mean(p):.3f} std {np.std(p):.3f} "
+            f"(ref {ref_std:.3f})",
+        )
+        is_ok = is_ok and b
+
+    # isotropic directions: each component has a mean 0 and a variance 1/3
+    for axis in ["X", "Y", "Z"]:
+        d = data[f"PreDirection_{axis}"]
+        b = abs(np.mean(d)) < 4 / np.sqrt(3 * nb) and abs(np.var(d) - 1 / 3) < 0.01
+        utility.print_test(
+            b, f"Direction {axis}: mean {np.mean(d):.4f} var {np.var(d):.4f}"
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
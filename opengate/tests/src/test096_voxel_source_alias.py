@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate_core as g4
+from opengate.tests import utility
+from opengate.image import compute_image_3D_CDF
+import itk
+import numpy as np
+
+
+def sample_voxels(sps, n, shape):
+    p = np.array([sps.VGenerateOneDebug() for _ in range(n)])
+    # the indices are k, j, i (X Y Z), the counts in numpy order (Z Y X)
+    linear = np.ravel_multi_index((p[:, 2], p[:, 1], p[:, 0]), shape)
+    return np.bincount(linear, minlength=np.prod(shape)).reshape(shape)
+
+
+def check_counts(counts, pdf, n, name):
+    expected = pdf * n
+    nz = pdf > 0
+    z = np.abs(counts[nz] - expected[nz]) / np.sqrt(expected[nz] * (1 - pdf[nz]))
+    b = np.max(z) < 5 and np.all(counts[~nz] == 0)
+    utility.print_test(
+        b,
+        f"{name}: {np.count_nonzero(counts)} voxels sampled "
+        f"({np.count_nonzero(nz)} non-zero), max deviation {np.max(z):.2f} sigma",
+    )
+    return b
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test096")
+
+    # sparse activity with a large dynamic range, numpy order Z Y X
+    rs = np.random.RandomState(42)
+    shape = (6, 5, 8)
+    activity = rs.exponential(1.0, size=shape)
+    activity[rs.uniform(size=shape) < 0.6] = 0
+    activity[2, 3, 4] = 100
+    pdf = activity / np.sum(activity)
+    n = 200000
+
+    # alias table
+    sps = g4.GateSPSVoxelsPosDistribution()
+    sps.SetAliasTable(activity.astype(np.float32))
+    nb = sps.GetNumberOfAliasEntries()
+    is_ok = nb == np.count_nonzero(activity)
+    utility.print_test(is_ok, f"Alias table with {nb} entries")
+    counts = sample_voxels(sps, n, shape)
+    is_ok = check_counts(counts, pdf, n, "Alias table") and is_ok
+
+    # same distribution with the CDF
+    image = itk.image_from_array(activity.astype(np.float32))
+    cdf_x, cdf_y, cdf_z = compute_image_3D_CDF(image)
+    sps = g4.GateSPSVoxelsPosDistribution()
+    sps.SetCumulativeDistributionFunction(cdf_z, cdf_y, cdf_x)
+    counts_cdf = sample_voxels(sps, n, shape)
+    is_ok = check_counts(counts_cdf, pdf, n, "CDF") and is_ok
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test097")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+
+    # reference phsp: gammas toward +Z, one distinct energy per entry
+    n = 1000
+    phsp_ref = {
+        "KineticEnergy": (10 + 0.1 * np.arange(n)) * keV,
+        "PrePosition_X": np.linspace(-5, 5, n) * cm,
+        "PrePosition_Y": np.zeros(n),
+        "PrePosition_Z": np.full(n, -10 * cm),
+        "PreDirection_X": np.zeros(n),
+        "PreDirection_Y": np.zeros(n),
+        "PreDirection_Z": np.ones(n),
+        "Weight": np.ones(n),
+        "PDGCode": np.full(n, 22, dtype=np.int32),
+    }
+    root_filename = paths.output / "test097_input.root"
+    with uproot.recreate(root_filename) as f:
+        f["phsp"] = phsp_ref
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 654987
+    sim.output_dir = paths.output
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # all the particles cross this plane
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.material = "G4_Galactic"
+
+    # the root file is converted once and read by both threads, each one
+    # with its own half of the entries
+    source = sim.add_source("PhaseSpaceSource", "phsp_source")
+    source.attached_to = world
+    source.phsp_file = root_filename
+    source.reader = "native"
+    source.position_key = "PrePosition"
+    source.direction_key = "PreDirection"
+    source.global_flag = True
+    source.particle = ""
+    source.batch_size = 128
+    source.entry_start = [0, n / 2]
+    source.n = n / 2
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["KineticEnergy", "PrePosition", "PDGCode"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test097.root"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # every entry of the phsp is used exactly once
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    energies = np.sort(data["KineticEnergy"])
+    ref = phsp_ref["KineticEnergy"].astype(np.float32).astype(np.float64)
+    is_ok = len(energies) == n and np.allclose(energies, ref, rtol=1e-6)
+    utility.print_test(is_ok, f"All the {n} entries are used once: {len(energies)}")
+
+    # position: same entries
+    order = np.argsort(data["KineticEnergy"])
+    x = data["PrePosition_X"][order]
+    b = np.allclose(x, phsp_ref["PrePosition_X"], atol=1e-3)
+    utility.print_test(b, "Positions of the entries")
+    is_ok = is_ok and b
+
+    # particle type from the file
+    b = np.all(data["PDGCode"] == 22)
+    utility.print_test(b, "Particle type from the PDGCode")
+    is_ok = is_ok and b
+
+    b = source.cycle_count == 0
+    utility.print_test(b, f"Cycle count: {source.cycle_count}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.sources.phspsources import read_phsp_columnar
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, seed):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = seed
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.material = "G4_Galactic"
+    return sim, plane
+
+
+def add_phsp_actor(sim, plane, name, filename):
+    phsp = sim.add_actor("PhaseSpaceActor", name)
+    phsp.attached_to = plane
+    phsp.attributes = [
+        "KineticEnergy",
+        "PrePosition",
+        "PreDirection",
+        "PDGCode",
+        "EventID",
+    ]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = filename
+    return phsp
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test098")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+
+    # 1) the same phsp is stored in root and in the columnar format
+    sim, plane = create_simulation(paths, 321654)
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "gamma"
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "iso"
+    # toward +Z, at most 30 deg from the axis
+    source.direction.theta = [150 * gate.g4_units.deg, 180 * gate.g4_units.deg]
+    source.direction.phi = [0, 360 * gate.g4_units.deg]
+    source.energy.type = "range"
+    source.energy.min_energy = 100 * keV
+    source.energy.max_energy = 1 * MeV
+    source.n = 20000
+
+    phsp_root = add_phsp_actor(sim, plane, "phsp_root", "test098.root")
+    # small chunks: each thread writes many of them during the run
+    phsp = add_phsp_actor(sim, plane, "phsp", "test098.gphsp")
+    phsp.quantize_directions = True
+    phsp.chunk_size = 1000
+    sim.run(start_new_process=True)
+
+    ref = uproot.open(phsp_root.get_output_path())["phsp_root"].arrays(library="np")
+    data = read_phsp_columnar(phsp.get_output_path())
+    n = len(ref["EventID"])
+    nb = len(data["EventID"])
+    is_ok = n == nb and n > 0
+    utility.print_test(is_ok, f"Number of entries: {nb} vs {n}")
+
+    # same entries (the order of the chunks depends on the threads)
+    o_ref = np.argsort(ref["EventID"], kind="stable")
+    o = np.argsort(data["EventID"], kind="stable")
+    b = np.all(ref["EventID"][o_ref] == data["EventID"][o])
+    b = b and np.all(ref["PDGCode"][o_ref] == data["PDGCode"][o])
+    utility.print_test(b, "Same events and particles")
+    is_ok = is_ok and b
+
+    for k in ["KineticEnergy", "PrePosition_X", "PrePosition_Y", "PrePosition_Z"]:
+        b = np.allclose(ref[k][o_ref], data[k][o], rtol=1e-6, atol=1e-4)
+        utility.print_test(b, f"Same values for {k} (float32)")
+        is_ok = is_ok and b
+
+    # quantized directions
+    d_ref = np.stack([ref[f"PreDirection_{a}"][o_ref] for a in "XYZ"], axis=1)
+    d = np.stack([data[f"PreDirection_{a}"][o] for a in "XYZ"], axis=1)
+    angle = np.arccos(np.clip(np.sum(d_ref * d, axis=1), -1, 1))
+    b = np.max(angle) < 2e-4
+    utility.print_test(b, f"Quantized directions, max error {np.max(angle):.2e} rad")
+    is_ok = is_ok and b
+
+    # 2) the columnar phsp is used by the native reader of the phsp source
+    sim, plane = create_simulation(paths, 987321)
+    source = sim.add_source("PhaseSpaceSource", "phsp_source")
+    source.attached_to = sim.world
+    source.phsp_file = phsp.get_output_path()
+    source.reader = "native"
+    source.position_key = "PrePosition"
+    source.direction_key = "PreDirection"
+    source.weight_key = None
+    source.global_flag = True
+    source.particle = ""
+    source.batch_size = 700
+    half = nb // 2
+    source.entry_start = [0, half]
+    source.n = half
+
+    # the particles start at the plane, they are stored in a second plane
+    plane2 = sim.add_volume("Box", "plane2")
+    plane2.size = [80 * cm, 80 * cm, 1 * cm]
+    plane2.translation = [0, 0, 20 * cm]
+    plane2.material = "G4_Galactic"
+    phsp2 = add_phsp_actor(sim, plane2, "phsp2", "test098_replay.root")
+    sim.run()
+
+    replay = uproot.open(phsp2.get_output_path())["phsp2"].arrays(library="np")
+    e_ref = np.sort(data["KineticEnergy"][: 2 * half])
+    e = np.sort(replay["KineticEnergy"])
+    b = len(e) == 2 * half and np.allclose(e, e_ref, rtol=1e-6)
+    utility.print_test(b, f"All the {2 * half} entries are replayed once: {len(e)}")
+    is_ok = is_ok and b
+
+    b = source.cycle_count == 0
+    utility.print_test(b, f"Cycle count: {source.cycle_count}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test099")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+
+    # reference phsp: gammas on the +X axis, tilted toward +X, one distinct
+    # energy per entry
+    n = 500
+    rs = np.random.RandomState(12)
+    radius = rs.uniform(0.5, 5, n) * cm
+    tilt = rs.uniform(0, 0.15, n)
+    phsp_ref = {
+        "KineticEnergy": (10 + 0.1 * np.arange(n)) * keV,
+        "PrePosition_X": radius,
+        "PrePosition_Y": np.zeros(n),
+        "PrePosition_Z": np.zeros(n),
+        "PreDirection_X": np.sin(tilt),
+        "PreDirection_Y": np.zeros(n),
+        "PreDirection_Z": np.cos(tilt),
+        "Weight": np.ones(n),
+    }
+    root_filename = paths.output / "test099_input.root"
+    with uproot.recreate(root_filename) as f:
+        f["phsp"] = phsp_ref
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 741852
+    sim.output_dir = paths.output
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # all the particles cross this plane
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.material = "G4_Galactic"
+
+    # each entry is used 8 times, with random rotations around the beam axis
+    # and mirroring; the translation is applied after the symmetries
+    recycling = 8
+    source = sim.add_source("PhaseSpaceSource", "phsp_source")
+    source.attached_to = world
+    source.phsp_file = root_filename
+    source.position_key = "PrePosition"
+    source.direction_key = "PreDirection"
+    source.global_flag = True
+    source.particle = "gamma"
+    source.batch_size = 100
+    source.recycling = recycling
+    source.recycling_rotation = True
+    source.recycling_mirror = True
+    source.translate_position = True
+    source.position.translation = [0, 0, -10 * cm]
+    source.n = n * recycling
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["EventKineticEnergy", "EventPosition", "EventDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test099.root"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+
+    # each entry is used exactly 'recycling' times, without restarting the file
+    ref_energies = phsp_ref["KineticEnergy"].astype(np.float32)
+    energies = data["EventKineticEnergy"].astype(np.float32)
+    index = np.searchsorted(ref_energies, energies)
+    counts = np.bincount(index, minlength=n)
+    is_ok = len(energies) == n * recycling and np.all(counts == recycling)
+    utility.print_test(is_ok, f"Each entry is used {recycling} times")
+    b = source.cycle_count == 0
+    utility.print_test(b, f"Cycle count: {source.cycle_count}")
+    is_ok = is_ok and b
+
+    # the symmetries preserve the radius and the radial component of the
+    # direction, the translation is applied after them
+    x = data["EventPosition_X"]
+    y = data["EventPosition_Y"]
+    r = np.sqrt(x**2 + y**2)
+    b = np.allclose(r, radius[index], atol=1e-3)
+    b = b and np.allclose(data["EventPosition_Z"], -10 * cm, atol=1e-3)
+    utility.print_test(b, "Radius and translation of the positions")
+    is_ok = is_ok and b
+
+    dx = data["EventDirection_X"]
+    dy = data["EventDirection_Y"]
+    b = np.allclose((x * dx + y * dy) / r, np.sin(tilt[index]), atol=1e-5)
+    b = b and np.allclose((x * dy - y * dx) / r, 0, atol=1e-5)
+    b = b and np.allclose(data["EventDirection_Z"], np.cos(tilt[index]), atol=1e-5)
+    utility.print_test(b, "Directions rotated with the positions")
+    is_ok = is_ok and b
+
+    # uniform azimuthal angle
+    phi = np.arctan2(y, x)
+    hist, _ = np.histogram(phi, bins=8, range=(-np.pi, np.pi))
+    expected = len(phi) / 8
+    chi2 = np.sum((hist - expected) ** 2 / expected)
+    b = chi2 < 24  # 7 degrees of freedom, p ~ 0.001
+    utility.print_test(b, f"Uniform azimuthal angle: chi2 = {chi2:.1f} {hist}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import sys
+import opengate as gate
+import opengate_core as g4
+from opengate.tests import utility
+from opengate.sources.gansources import export_gan_to_onnx
+import uproot
+import numpy as np
+
+
+def create_simulation(paths, name):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 123654
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [2 * m, 2 * m, 2 * m]
+    world.material = "G4_Galactic"
+
+    # origin of the coordinate system of the GAN source (like test034)
+    plane = sim.add_volume("Box", "phase_space_plane")
+    plane.material = "G4_Galactic"
+    plane.size = [3 * cm, 4 * cm, 5 * cm]
+
+    # the particles are stored in a second plane
+    plane2 = sim.add_volume("Box", "plane2")
+    plane2.size = [1.5 * m, 1.5 * m, 1 * cm]
+    plane2.translation = [0, 0, 60 * cm]
+    plane2.material = "G4_Galactic"
+
+    gsource = sim.add_source("GANSource", "gaga")
+    gsource.particle = "gamma"
+    gsource.attached_to = plane
+    gsource.n = 2e4
+    gsource.pth_filename = paths.data / "003_v3_40k.pth"
+    gsource.position_keys = ["X", "Y", 271.1 * mm]
+    gsource.direction_keys = ["dX", "dY", "dZ"]
+    gsource.energy_key = "Ekine"
+    gsource.weight_key = None
+    gsource.time_key = None
+    gsource.batch_size = 5e3
+    gsource.gpu_mode = utility.get_gpu_mode_for_tests()
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane2
+    phsp.attributes = ["KineticEnergy", "PrePosition"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = f"test100_{name}.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+    return sim, gsource, phsp, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(
+        __file__, "gate_test034_gan_phsp_linac", "test100"
+    )
+
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    if not g4.GateInfo.get_ONNXRuntime():
+        print("opengate_core is compiled without ONNX Runtime, nothing to test")
+        utility.test_ok(True)
+        sys.exit(0)
+
+    # export the generator
+    onnx_filename = paths.output / "test100_gan.onnx"
+    export_gan_to_onnx(paths.data / "003_v3_40k.pth", onnx_filename)
+
+    # reference: inference in Python with torch
+    sim, gsource, phsp_ref, stats = create_simulation(paths, "torch")
+    sim.run(start_new_process=True)
+    print(stats)
+
+    # inference on the cpp side
+    sim, gsource, phsp, stats = create_simulation(paths, "onnx")
+    gsource.backend = "onnx"
+    gsource.onnx_filename = onnx_filename
+    sim.run()
+    print(stats)
+
+    # same distributions (not the same particles: the random inputs differ)
+    ref = uproot.open(phsp_ref.get_output_path())["phsp"].arrays(library="np")
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    n_ref = len(ref["KineticEnergy"])
+    n = len(data["KineticEnergy"])
+    is_ok = n > 0 and abs(n - n_ref) / n_ref < 0.05
+    utility.print_test(is_ok, f"Number of particles: {n} vs {n_ref}")
+
+    for k in ["KineticEnergy", "PrePosition_X", "PrePosition_Y"]:
+        mean_ref, std_ref = np.mean(ref[k]), np.std(ref[k])
+        mean, std = np.mean(data[k]), np.std(data[k])
+        b = abs(mean - mean_ref) < 0.05 * std_ref
+        b = b and abs(std - std_ref) / std_ref < 0.05
+        utility.print_test(
+            b, f"{k}: mean {mean:.3f} vs {mean_ref:.3f}, std {std:.3f} vs {std_ref:.3f}"
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
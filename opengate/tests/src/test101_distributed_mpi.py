@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import sys
+import json
+import shutil
+import subprocess
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, name, distributed_mode=None):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+    sim.distributed_mode = distributed_mode
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_AIR"
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.translation = [0, 0, 20 * cm]
+    plane.material = "G4_AIR"
+
+    # n is the total of all the processes
+    source = sim.add_source("GenericSource", "gamma")
+    source.particle = "gamma"
+    source.energy.mono = 1 * MeV
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 20000
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 20]
+    dose.spacing = [1 * cm, 1 * cm, 1 * cm]
+    dose.edep_uncertainty.active = True
+    dose.output_filename = f"test101_{name}.mhd"
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["KineticEnergy"]
+    phsp.output_filename = f"test101_{name}.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.output_filename = f"test101_{name}_stats.json"
+    stats.write_to_disk = True
+    return sim, dose, phsp, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test101")
+
+    # one process of the distributed simulation (started by mpirun below)
+    if len(sys.argv) > 1 and sys.argv[1] == "--mpi-process":
+        sim, dose, phsp, stats = create_simulation(paths, "mpi", "mpi")
+        sim.run()
+        # the source of the user keeps the total number of primaries
+        sys.exit(0 if sim.source_manager.sources["gamma"].n == 20000 else 1)
+
+    try:
+        import mpi4py
+    except ImportError:
+        mpi4py = None
+    if mpi4py is None or shutil.which("mpirun") is None:
+        print("mpi4py or mpirun is not available, nothing to test")
+        utility.test_ok(True)
+        sys.exit(0)
+
+    # distributed simulation with 2 processes
+    cmd = ["mpirun", "-np", "2", sys.executable, __file__, "--mpi-process"]
+    print(" ".join(cmd))
+    r = subprocess.call(cmd)
+    is_ok = r == 0
+    utility.print_test(is_ok, f"mpirun exit code: {r}")
+
+    # reference: one single process
+    sim, dose, phsp, stats = create_simulation(paths, "ref")
+    sim.run()
+    print(stats)
+
+    # the statistics are the ones of the whole simulation
+    with open(paths.output / "test101_mpi_stats.json") as f:
+        s = json.load(f)
+    n = s["events"]["value"]
+    b = n == stats.counts.events
+    utility.print_test(b, f"Number of events: {n} vs {stats.counts.events}")
+    is_ok = is_ok and b
+
+    # one single merged ROOT file (the files of the processes are removed)
+    data = uproot.open(paths.output / "test101_mpi.root")["phsp"].arrays(library="np")
+    ref = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    n, n_ref = len(data["KineticEnergy"]), len(ref["KineticEnergy"])
+    b = abs(n - n_ref) / n_ref < 0.05
+    b = b and len(list(paths.output.glob("test101_mpi_rank*"))) == 0
+    utility.print_test(b, f"Number of particles in the phsp: {n} vs {n_ref}")
+    is_ok = is_ok and b
+
+    # merged dose (the sum of the processes)
+    ref_path = str(dose.edep.get_output_path())
+    edep_ref = itk.array_from_image(itk.imread(ref_path))
+    edep = itk.array_from_image(itk.imread(ref_path.replace("_ref", "_mpi")))
+    b = abs(np.sum(edep) - np.sum(edep_ref)) / np.sum(edep_ref) < 0.03
+    utility.print_test(b, f"Total edep: {np.sum(edep)} vs {np.sum(edep_ref)}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import threading
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test102")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 963852
+    sim.output_dir = paths.output
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # all the particles cross this plane
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.material = "G4_Galactic"
+
+    # the particles are pushed by the producer during the simulation, the
+    # bank is small so that the producer waits for the Geant4 threads
+    source = sim.add_source("ParticleBankSource", "bank_source")
+    source.particle = "gamma"
+    source.global_flag = True
+    source.capacity = 500
+    source.batch_size = 100
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["EventKineticEnergy", "EventPosition", "EventDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test102.root"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # producer: one distinct energy per particle, positions on a disc
+    n = 20000
+    chunk = 1000
+    rs = np.random.RandomState(42)
+    energies = (10 + 0.01 * np.arange(n)) * keV
+    radius = 5 * cm * np.sqrt(rs.uniform(0, 1, n))
+    theta = rs.uniform(0, 2 * np.pi, n)
+    positions = np.column_stack(
+        [radius * np.cos(theta), radius * np.sin(theta), np.full(n, -10 * cm)]
+    )
+    directions = np.tile([0.0, 0.0, 1.0], (n, 1))
+
+    def produce():
+        for i in range(0, n, chunk):
+            source.push(
+                energies[i : i + chunk],
+                positions[i : i + chunk],
+                directions[i : i + chunk],
+            )
+        source.close_bank()
+
+    producer = threading.Thread(target=produce)
+    producer.start()
+
+    # start simulation
+    sim.run()
+    producer.join()
+    print(stats)
+
+    # all the particles of the producer are simulated once, then the run stops
+    b = stats.counts.events == n
+    utility.print_test(b, f"Number of events: {stats.counts.events} vs {n}")
+    is_ok = b
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    e = np.sort(data["EventKineticEnergy"])
+    b = len(e) == n and np.allclose(e, energies, rtol=1e-6)
+    utility.print_test(b, f"Each particle is used once: {len(e)} particles")
+    is_ok = is_ok and b
+
+    # the positions are the ones of the producer
+    index = np.searchsorted(energies, data["EventKineticEnergy"] - 0.001 * keV)
+    b = np.allclose(data["EventPosition_X"], positions[index, 0], atol=1e-3)
+    b = b and np.allclose(data["EventPosition_Y"], positions[index, 1], atol=1e-3)
+    b = b and np.allclose(data["EventDirection_Z"], 1, atol=1e-6)
+    utility.print_test(b, "Positions and directions of the particles")
+    is_ok = is_ok and b
+
+    bank = source.bank
+    b = bank.GetNumberOfPushedParticles() == n
+    b = b and bank.GetNumberOfPoppedParticles() == n and bank.GetSize() == 0
+    utility.print_test(b, f"Bank: {bank.GetNumberOfPoppedParticles()} popped")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test103")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    # simulation
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 147258
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    box = sim.add_volume("Box", "box")
+    box.size = [1 * cm, 1 * cm, 1 * cm]
+    box.material = "G4_Galactic"
+
+    # Ga68 without the Geant4 radioactive decay: e+ and 1077 keV gammas
+    activity = 50000 * Bq
+    source = sim.add_source("GenericSource", "ga68")
+    source.attached_to = box
+    source.particle = "ion 31 68"
+    source.decay_mode = "precomputed"
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.activity = activity
+
+    # all the primaries exit the box
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = box
+    phsp.attributes = ["EventID", "ParticleName", "TrackVertexKineticEnergy"]
+    phsp.steps_to_store = "exiting"
+    phsp.output_filename = "test103.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.run_timing_intervals = [[0, 1 * sec]]
+    sim.run()
+    print(stats)
+
+    # number of decays with an emission (ENSDF: 88.91% e+, 3.22% 1077 keV,
+    # 2.03% 1077 keV without e+)
+    yield_emission = 0.8891 + 0.0203
+    n = stats.counts.events
+    expected = activity / Bq * yield_emission
+    b = abs(n - expected) < 4 * np.sqrt(expected)
+    utility.print_test(b, f"Number of events: {n} vs {expected:.0f}")
+    is_ok = b
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    names = data["ParticleName"]
+    events = data["EventID"]
+    energies = data["TrackVertexKineticEnergy"]
+    positrons = np.unique(events[names == "e+"])
+    gammas = np.unique(events[(names == "gamma") & (np.abs(energies - 1077 * keV) < 1)])
+
+    def check(value, ref, name):
+        sigma = np.sqrt(ref * (1 - ref) / n)
+        t = abs(value - ref) < 4 * sigma
+        utility.print_test(t, f"{name}: {value:.4f} vs {ref:.4f}")
+        return t
+
+    is_ok = check(len(positrons) / n, 0.8891 / yield_emission, "e+ per event") and is_ok
+    b = check(len(gammas) / n, 0.0322 / yield_emission, "1077 keV per event")
+    is_ok = b and is_ok
+    both = len(np.intersect1d(positrons, gammas)) / n
+    is_ok = check(both, 0.0119 / yield_emission, "e+ and 1077 keV") and is_ok
+
+    # mean energy of the beta+ spectrum (LNHB: 828.4 keV)
+    e = energies[names == "e+"] / keV
+    b = abs(np.mean(e) - 828.4) / 828.4 < 0.01
+    utility.print_test(b, f"Mean e+ energy: {np.mean(e):.1f} keV vs 828.4 keV")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, seed, threads, z):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = threads
+    sim.random_seed = seed
+    sim.output_dir = paths.output
+    sim.run_timing_intervals = [[0, 0.5 * sec], [0.5 * sec, 1 * sec]]
+    sim.primary_cache_filename = "test104.cache"
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # all the primaries cross this plane (its position changes)
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [80 * cm, 80 * cm, 1 * cm]
+    plane.translation = [0, 0, z]
+    plane.material = "G4_Galactic"
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = [
+        "EventKineticEnergy",
+        "EventPosition",
+        "EventDirection",
+        "ParticleName",
+    ]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = f"test104_{z / cm:.0f}.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim, phsp, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test104")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+    deg = gate.g4_units.deg
+
+    # 1) the primaries of two sources are recorded
+    sim, phsp_rec, stats_rec = create_simulation(paths, 123654, 2, 10 * cm)
+    sim.primary_cache_mode = "record"
+    for name, particle in [("gammas", "gamma"), ("electrons", "e-")]:
+        source = sim.add_source("GenericSource", name)
+        source.particle = particle
+        source.position.type = "disc"
+        source.position.radius = 5 * cm
+        source.position.translation = [0, 0, -20 * cm]
+        # toward +Z, at most 30 deg from the axis
+        source.direction.type = "iso"
+        source.direction.theta = [150 * deg, 180 * deg]
+        source.direction.phi = [0, 360 * deg]
+        source.energy.type = "range"
+        source.energy.min_energy = 100 * keV
+        source.energy.max_energy = 1 * MeV
+        source.activity = 10000 * Bq
+    sim.run(start_new_process=True)
+    print(stats_rec)
+
+    # 2) the primaries are replayed with another geometry and another number
+    # of threads, the sources are not used
+    sim, phsp, stats = create_simulation(paths, 987456, 3, 20 * cm)
+    sim.primary_cache_mode = "replay"
+    sim.run()
+    print(stats)
+
+    n_rec = stats_rec.counts.events
+    n = stats.counts.events
+    # (a thread without any event left in a run generates one empty event)
+    is_ok = n_rec <= n <= n_rec + 3 * 2 and n_rec > 0
+    utility.print_test(is_ok, f"Number of events: {n} vs {n_rec}")
+    b = stats.counts.runs == stats_rec.counts.runs
+    utility.print_test(b, f"Number of runs: {stats.counts.runs}")
+    is_ok = is_ok and b
+
+    # the same primaries (the order depends on the threads)
+    ref = uproot.open(phsp_rec.get_output_path())["phsp"].arrays(library="np")
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    o_ref = np.argsort(ref["EventKineticEnergy"])
+    o = np.argsort(data["EventKineticEnergy"])
+    b = len(o) == len(o_ref)
+    b = b and np.all(ref["ParticleName"][o_ref] == data["ParticleName"][o])
+    utility.print_test(b, f"Same particles: {len(o)} vs {len(o_ref)}")
+    is_ok = is_ok and b
+    for k in [
+        "EventKineticEnergy",
+        "EventPosition_X",
+        "EventPosition_Y",
+        "EventPosition_Z",
+        "EventDirection_Z",
+    ]:
+        b = np.allclose(ref[k][o_ref], data[k][o], rtol=1e-6, atol=1e-6)
+        utility.print_test(b, f"Same values for {k}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, threads, n):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = threads
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+    sim.event_scheduling = "guided"
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # all the primaries cross this plane
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [80 * cm, 80 * cm, 1 * cm]
+    plane.translation = [0, 0, 10 * cm]
+    plane.material = "G4_Galactic"
+
+    # n events per thread: the same total with 2 and 4 threads
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "iso"
+    source.direction.theta = [150 * deg, 180 * deg]
+    source.direction.phi = [0, 360 * deg]
+    source.energy.type = "range"
+    source.energy.min_energy = 100 * keV
+    source.energy.max_energy = 1 * MeV
+    source.n = n
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["EventKineticEnergy", "EventPosition", "EventDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = f"test105_{threads}.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim, phsp, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test105")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    deg = gate.g4_units.deg
+
+    total = 8000
+    sim2, phsp2, stats2 = create_simulation(paths, 2, total // 2)
+    sim2.run(start_new_process=True)
+    print(stats2)
+    sim4, phsp4, stats4 = create_simulation(paths, 4, total // 4)
+    sim4.run()
+    print(stats4)
+
+    # all the events are simulated once
+    # (a thread without any event left generates one empty event)
+    is_ok = True
+    for stats, threads in [(stats2, 2), (stats4, 4)]:
+        n = stats.counts.events
+        b = total <= n <= total + threads
+        utility.print_test(b, f"Number of events with {threads} threads: {n}")
+        is_ok = is_ok and b
+
+    # the primaries do not depend on the number of threads
+    ref = uproot.open(phsp2.get_output_path())["phsp"].arrays(library="np")
+    data = uproot.open(phsp4.get_output_path())["phsp"].arrays(library="np")
+    o_ref = np.argsort(ref["EventKineticEnergy"])
+    o = np.argsort(data["EventKineticEnergy"])
+    b = len(o) == len(o_ref) and len(o) > 0
+    utility.print_test(b, f"Same number of primaries: {len(o)} vs {len(o_ref)}")
+    is_ok = is_ok and b
+    if b:
+        for k in [
+            "EventKineticEnergy",
+            "EventPosition_X",
+            "EventPosition_Y",
+            "EventDirection_Z",
+        ]:
+            b = np.allclose(ref[k][o_ref], data[k][o], rtol=1e-9, atol=1e-9)
+            utility.print_test(b, f"Same values for {k}")
+            is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.actors.coincidences import coincidences_sorter
+import numpy as np
+import uproot
+
+if __name__ == "__main__":
+    sim = gate.Simulation()
+
+    # units
+    mm = gate.g4_units.mm
+    sec = gate.g4_units.s
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+    gcm3 = gate.g4_units.g_cm3
+    deg = gate.g4_units.deg
+
+    # folders
+    paths = utility.get_default_test_paths(__file__, output_folder="test106")
+
+    # options
+    sim.random_seed = 123456
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [450 * mm, 450 * mm, 70 * mm]
+    sim.world.material = "G4_AIR"
+
+    # create the material
+    sim.volume_manager.material_database.add_material_weights(
+        "LYSO",
+        ["Lu", "Y", "Si", "O"],
+        [0.31101534, 0.368765605, 0.083209699, 0.237009356],
+        5.37 * gcm3,
+    )
+
+    # ring volume
+    pet = sim.add_volume("Tubs", "pet")
+    pet.rmax = 200 * mm
+    pet.rmin = 127 * mm
+    pet.dz = 32 * mm
+    pet.material = "G4_AIR"
+
+    # block
+    block = sim.add_volume("Box", "block")
+    block.mother = pet
+    block.size = [60 * mm, 10 * mm, 10 * mm]
+    translations_ring, rotations_ring = gate.geometry.utility.get_circular_repetition(
+        80, [160 * mm, 0.0 * mm, 0], start_angle_deg=180, axis=[0, 0, 1]
+    )
+    block.translation = translations_ring
+    block.rotation = rotations_ring
+    block.material = "G4_AIR"
+
+    # Crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.mother = block
+    crystal.size = [60 * mm, 10 * mm, 10 * mm]
+    crystal.material = "LYSO"
+
+    # source
+    source = sim.add_source("GenericSource", "b2b")
+    source.particle = "back_to_back"
+    source.activity = 20 * Bq
+    source.position.type = "sphere"
+    source.position.radius = 0.0000000000000005 * mm
+    source.energy.mono = 511 * keV
+    source.direction.theta = [90 * deg, 90 * deg]
+    source.direction.phi = [0, 360 * deg]
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+
+    # actors
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # Hits
+    hc = sim.add_actor("DigitizerHitsCollectionActor", f"Hits_{crystal.name}")
+    hc.attached_to = crystal
+    hc.authorize_repeated_volumes = True
+    hc.output_filename = "test106_singles.root"
+    hc.attributes = [
+        "EventID",
+        "PostPosition",
+        "TotalEnergyDeposit",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+    ]
+
+    # Singles
+    sc = sim.add_actor("DigitizerAdderActor", f"Singles_{crystal.name}")
+    sc.attached_to = hc.attached_to
+    sc.authorize_repeated_volumes = True
+    sc.input_digi_collection = hc.name
+    sc.policy = "EnergyWinnerPosition"
+    sc.output_filename = hc.output_filename
+
+    # Coincidences, sorted during the simulation
+    ns = gate.g4_units.nanosecond
+    coinc = {}
+    for policy in ["keepAll", "removeMultiples"]:
+        cc = sim.add_actor(
+            "DigitizerCoincidenceSorterActor", f"Coincidences_{policy}"
+        )
+        cc.input_digi_collection = sc.name
+        cc.window = 3 * ns
+        cc.policy = policy
+        cc.output_filename = hc.output_filename
+        coinc[policy] = cc
+
+    # timing
+    sim.run_timing_intervals = [[0, 200 * sec]]
+
+    # go
+    sim.run()
+    print(stats)
+
+    # compare with the offline sorter, on the same singles
+    root_file = uproot.open(paths.output / hc.output_filename)
+    singles_tree = root_file["Singles_crystal"]
+    print(f"There are {singles_tree.num_entries} singles")
+    is_ok = True
+    for policy, cc in coinc.items():
+        offline = coincidences_sorter(singles_tree, 3 * ns, 1, policy, 1000000)
+        n_offline = len(offline["GlobalTime1"])
+        online = root_file[cc.name].arrays(library="np")
+        n_online = len(online["GlobalTime1"])
+        print(f"Policy {policy}: {n_online} coincidences, offline {n_offline}")
+        b = n_online == cc.number_of_coincidences
+        utility.print_test(b, f"Number of coincidences in the root file {n_online}")
+        is_ok = is_ok and b
+        # the singles of the offline sorter are in event order, not in time
+        # order: a few coincidences may differ
+        b = utility.check_diff_abs(
+            n_online, n_offline, tolerance=n_offline * 0.01, txt=policy
+        )
+        is_ok = is_ok and b
+        dt = online["GlobalTime2"] - online["GlobalTime1"]
+        b = np.all(dt >= 0) and np.all(dt <= 3 * ns)
+        v1 = online["PreStepUniqueVolumeID1"]
+        v2 = online["PreStepUniqueVolumeID2"]
+        b = b and np.all(v1 != v2)
+        utility.print_test(b, "Time difference in [0, window], different volumes")
+        is_ok = is_ok and b
+        n = cc.number_of_forced_singles + cc.number_of_late_singles
+        b = n == 0
+        utility.print_test(b, f"Number of forced or late singles {n}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test107")
+
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    sec = gate.g4_units.s
+    us = gate.g4_units.us
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 654321
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # one crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [50 * mm, 50 * mm, 20 * mm]
+    crystal.translation = [0, 0, 10 * cm]
+    crystal.material = "G4_BGO"
+
+    # gammas toward the crystal, high count rate
+    # (each thread has its own source: the activity is per thread)
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 511 * keV
+    source.position.type = "point"
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 2e5 * Bq / sim.number_of_threads
+    duration = 0.05 * sec
+    sim.run_timing_intervals = [[0, duration]]
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.output_filename = "test107.root"
+    hc.attributes = [
+        "EventID",
+        "PostPosition",
+        "TotalEnergyDeposit",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+    ]
+
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.input_digi_collection = hc.name
+    sc.output_filename = hc.output_filename
+
+    # dead time and pile-up of the crystal
+    tau = 2 * us
+    dead_times = {}
+    for policy in ["NonParalyzable", "Paralyzable"]:
+        dt = sim.add_actor("DigitizerDeadTimeActor", f"dead_time_{policy}")
+        dt.input_digi_collection = sc.name
+        dt.dead_time = tau
+        dt.policy = policy
+        dt.group_volume = crystal.name
+        dt.output_filename = hc.output_filename
+        dead_times[policy] = dt
+
+    pu = sim.add_actor("DigitizerPileupActor", "pileup")
+    pu.input_digi_collection = sc.name
+    pu.window = tau
+    pu.group_volume = crystal.name
+    pu.output_filename = hc.output_filename
+
+    sim.run()
+    print(stats)
+
+    root_file = uproot.open(paths.output / hc.output_filename)
+    singles = root_file[sc.name].arrays(library="np")
+    n_singles = len(singles["GlobalTime"])
+    rate = n_singles / duration
+    print(f"Singles: {n_singles}, rate {rate * sec:.0f} cps, n.tau={rate * tau:.3f}")
+
+    # compare with the count rates of the dead time models
+    expected = {
+        "NonParalyzable": rate / (1 + rate * tau),
+        "Paralyzable": rate * np.exp(-rate * tau),
+    }
+    is_ok = True
+    for policy, dt in dead_times.items():
+        out = root_file[dt.name].arrays(library="np")
+        n = len(out["GlobalTime"])
+        b = n == dt.number_of_kept_singles
+        b = b and n + dt.number_of_removed_singles == n_singles
+        utility.print_test(b, f"{policy}: {n} kept singles")
+        is_ok = is_ok and b
+        m = n / duration
+        is_ok = (
+            utility.check_diff_abs(
+                m * sec,
+                expected[policy] * sec,
+                tolerance=expected[policy] * sec * 0.05,
+                txt=f"{policy} count rate",
+            )
+            and is_ok
+        )
+        # the kept singles are in time order, separated by the dead time
+        times = out["GlobalTime"]
+        b = np.all(np.diff(np.sort(times)) >= tau)
+        utility.print_test(b, "Kept singles separated by the dead time")
+        is_ok = is_ok and b
+        n = dt.number_of_forced_singles + dt.number_of_late_singles
+        b = n == 0
+        utility.print_test(b, f"Number of forced or late singles {n}")
+        is_ok = is_ok and b
+
+    # pile-up: the energy is kept, the number of singles is the one of the
+    # non-paralyzable model (a window is opened by each output single)
+    out = root_file[pu.name].arrays(library="np")
+    n = len(out["GlobalTime"])
+    b = n + pu.number_of_pileup_singles == n_singles
+    edep = np.sum(out["TotalEnergyDeposit"])
+    edep_ref = np.sum(singles["TotalEnergyDeposit"])
+    b = b and np.fabs(edep - edep_ref) < 1e-6 * edep_ref
+    utility.print_test(b, f"Pile-up: {n} singles, energy {edep / keV:.1f} keV")
+    is_ok = is_ok and b
+    b = np.all(np.diff(np.sort(out["GlobalTime"])) >= tau)
+    utility.print_test(b, "Pile-up singles separated by the window")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
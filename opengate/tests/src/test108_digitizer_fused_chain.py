@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.actors.digitizers import Digitizer
+from opengate.tests import utility
+import numpy as np
+import uproot
+import itk
+
+
+def create_simulation(paths, fused):
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 123456
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water phantom (scatter)
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [20 * cm, 20 * cm, 10 * cm]
+    phantom.material = "G4_WATER"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [30 * cm, 30 * cm, 1 * cm]
+    crystal.translation = [0, 0, 15 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # Tc99m gammas in the phantom
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 140.5 * keV
+    source.position.type = "sphere"
+    source.position.radius = 3 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 5e4 * Bq
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # the SPECT digitizer chain
+    name = "fused" if fused else "chain"
+    digitizer = Digitizer(sim, crystal.name, name, fused=fused)
+    sc = digitizer.add_module("DigitizerAdderActor", f"{name}_singles")
+    sc.policy = "EnergyWinnerPosition"
+    ea = digitizer.add_module("DigitizerEfficiencyActor")
+    ea.efficiency = 0.8
+    eb = digitizer.add_module("DigitizerBlurringActor")
+    eb.blur_attribute = "TotalEnergyDeposit"
+    eb.blur_method = "InverseSquare"
+    eb.blur_resolution = 0.1
+    eb.blur_reference_value = 140.57 * keV
+    sb = digitizer.add_module("DigitizerSpatialBlurringActor")
+    sb.blur_attribute = "PostPosition"
+    sb.blur_fwhm = 5 * mm
+    sb.keep_in_solid_limits = True
+    ew = digitizer.add_module("DigitizerEnergyWindowsActor", f"{name}_ew")
+    channels = [
+        {"name": f"{name}_scatter", "min": 108.578 * keV, "max": 129.057 * keV},
+        {"name": f"{name}_peak140", "min": 129.057 * keV, "max": 149.536 * keV},
+    ]
+    ew.channels = channels
+    ew.output_filename = f"test108_{name}.root"
+    ew.user_output["root_output"].write_to_disk = True
+    proj = digitizer.add_module("DigitizerProjectionActor", f"{name}_projection")
+    proj.input_digi_collections = [c["name"] for c in channels]
+    proj.spacing = [4 * mm, 4 * mm]
+    proj.size = [64, 64]
+    proj.output_filename = f"test108_{name}_projection.mhd"
+    proj.user_output["projection"].set_write_to_disk(True)
+
+    return sim, stats, ew, proj, channels
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test108")
+
+    # the same simulation, with and without the fused chain
+    outputs = {}
+    for fused in [False, True]:
+        sim, stats, ew, proj, channels = create_simulation(paths, fused)
+        sim.run(start_new_process=True)
+        print(stats)
+        outputs[fused] = (ew.get_output_path(), proj.get_output_path(), channels)
+
+    # same digi in all the channels
+    is_ok = True
+    ref_file = uproot.open(outputs[False][0])
+    fused_file = uproot.open(outputs[True][0])
+    for c_ref, c_fused in zip(outputs[False][2], outputs[True][2]):
+        ref = ref_file[c_ref["name"]].arrays(library="np")
+        out = fused_file[c_fused["name"]].arrays(library="np")
+        b = sorted(ref.keys()) == sorted(out.keys())
+        b = b and len(ref["TotalEnergyDeposit"]) > 0
+        for k in ref.keys():
+            b = b and len(ref[k]) == len(out[k])
+            if ref[k].dtype.kind in "fi":
+                b = b and np.allclose(ref[k], out[k])
+            else:
+                b = b and np.array_equal(ref[k], out[k])
+        n = len(out["TotalEnergyDeposit"])
+        utility.print_test(b, f"Channel {c_fused['name']}: {n} digi")
+        is_ok = is_ok and b
+
+    # same projections
+    ref = itk.array_view_from_image(itk.imread(outputs[False][1]))
+    out = itk.array_view_from_image(itk.imread(outputs[True][1]))
+    b = ref.shape == out.shape and np.array_equal(ref, out)
+    utility.print_test(b, f"Same projections ({np.sum(out)} counts)")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
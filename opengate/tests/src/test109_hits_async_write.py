@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, async_write):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 987654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water box
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    # gammas in the box
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.activity = 5000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # many attributes
+    name = "async" if async_write else "sync"
+    hc = sim.add_actor("DigitizerHitsCollectionActor", f"hits_{name}")
+    hc.attached_to = waterbox
+    hc.output_filename = f"test109_{name}.root"
+    hc.async_write = async_write
+    hc.attributes = [
+        "EventID",
+        "TrackID",
+        "ParentID",
+        "RunID",
+        "ThreadID",
+        "TotalEnergyDeposit",
+        "PreKineticEnergy",
+        "PostKineticEnergy",
+        "GlobalTime",
+        "LocalTime",
+        "Weight",
+        "StepLength",
+        "PrePosition",
+        "PostPosition",
+        "PreDirection",
+        "PostDirection",
+        "EventPosition",
+        "EventKineticEnergy",
+        "ProcessDefinedStep",
+        "ParticleName",
+        "PreStepUniqueVolumeID",
+    ]
+
+    return sim, stats, hc
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test109")
+
+    # the same simulation, with and without the background writer
+    outputs = {}
+    for async_write in [False, True]:
+        sim, stats, hc = create_simulation(paths, async_write)
+        sim.run(start_new_process=True)
+        print(stats)
+        outputs[async_write] = (hc.get_output_path(), hc.name)
+
+    # same hits (the order of the rows of the threads may differ)
+    ref = uproot.open(outputs[False][0])[outputs[False][1]].arrays(library="np")
+    out = uproot.open(outputs[True][0])[outputs[True][1]].arrays(library="np")
+    n = len(ref["EventID"])
+    is_ok = sorted(ref.keys()) == sorted(out.keys()) and n > 0
+    utility.print_test(is_ok, f"Same branches, {n} hits")
+    for k in ref.keys():
+        b = len(ref[k]) == len(out[k])
+        b = b and np.array_equal(np.sort(ref[k]), np.sort(out[k]))
+        utility.print_test(b, f"Branch {k}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.actors.digitizers import read_columnar_output
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, filename):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [20 * cm, 20 * cm, 2 * cm]
+    crystal.translation = [0, 0, 10 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # gammas toward the crystal
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 511 * keV
+    source.position.type = "sphere"
+    source.position.radius = 2 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 5000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits and singles in the same output
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.output_filename = filename
+    hc.attributes = [
+        "EventID",
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "GlobalTime",
+        "ParticleName",
+        "PreStepUniqueVolumeID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.input_digi_collection = hc.name
+    sc.output_filename = filename
+
+    return sim, stats, hc, sc
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test110")
+
+    # the same simulation, with the root and the columnar outputs
+    outputs = {}
+    for filename in ["test110.root", "test110.json"]:
+        sim, stats, hc, sc = create_simulation(paths, filename)
+        sim.run(start_new_process=True)
+        print(stats)
+        outputs[filename] = (hc.get_output_path(), [hc.name, sc.name])
+
+    # same values in the two outputs (the order of the threads may differ)
+    is_ok = True
+    root_file = uproot.open(outputs["test110.root"][0])
+    for name in outputs["test110.json"][1]:
+        ref = root_file[name].arrays(library="np")
+        out = read_columnar_output(outputs["test110.json"][0], name)
+        n = len(out["EventID"])
+        b = n == len(ref["EventID"]) and n > 0
+        utility.print_test(b, f"Collection {name}: {n} digi")
+        is_ok = is_ok and b
+        for k, v in out.items():
+            if v.ndim == 2:
+                # 3-vectors: one fixed size column instead of _X _Y _Z
+                r = np.stack([ref[f"{k}_{a}"] for a in "XYZ"], axis=1)
+                b = np.array_equal(np.sort(r, axis=0), np.sort(v, axis=0))
+            else:
+                b = np.array_equal(np.sort(ref[k]), np.sort(v))
+            utility.print_test(b, f"Column {k}")
+            is_ok = is_ok and b
+
+    # as an Arrow table (if pyarrow is installed)
+    try:
+        import pyarrow
+
+        filename = outputs["test110.json"][0]
+        table = read_columnar_output(filename, hc.name, "arrow")
+        hits = read_columnar_output(filename, hc.name)
+        b = table.num_rows == len(hits["EventID"])
+        b = b and table.column_names == list(hits.keys())
+        utility.print_test(b, f"Arrow table with {table.num_rows} rows")
+        is_ok = is_ok and b
+    except ImportError:
+        print("pyarrow is not installed, the Arrow table is not tested")
+
+    utility.test_ok(is_ok)
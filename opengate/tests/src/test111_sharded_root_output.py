@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.actors.digitizers import read_root_output, get_root_output_files
+from opengate.tests import utility
+import numpy as np
+
+
+def create_simulation(paths, sharded):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 4
+    sim.output_dir = paths.output
+    sim.sharded_root_output = sharded
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [20 * cm, 20 * cm, 2 * cm]
+    crystal.translation = [0, 0, 10 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # gammas toward the crystal
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 140 * keV
+    source.position.type = "sphere"
+    source.position.radius = 2 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 8000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits and singles in the same output
+    name = "sharded" if sharded else "merged"
+    filename = f"test111_{name}.root"
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.output_filename = filename
+    hc.attributes = [
+        "EventID",
+        "ThreadID",
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "GlobalTime",
+        "PreStepUniqueVolumeID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.input_digi_collection = hc.name
+    sc.output_filename = filename
+
+    return sim, stats, hc, sc
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test111")
+
+    # the same simulation, with and without the merge of the threads
+    outputs = {}
+    for sharded in [False, True]:
+        sim, stats, hc, sc = create_simulation(paths, sharded)
+        sim.run(start_new_process=True)
+        print(stats)
+        outputs[sharded] = (hc.get_output_path(), [hc.name, sc.name])
+
+    # one file per thread, and no merged file
+    path = outputs[True][0]
+    files = get_root_output_files(path)
+    print(f"Shards: {[f.name for f in files]}")
+    is_ok = len(files) == 4 and not path.exists()
+    utility.print_test(is_ok, f"{len(files)} shards, no merged file")
+
+    # same rows (the order of the threads may differ)
+    for name in outputs[True][1]:
+        ref = read_root_output(outputs[False][0], name)
+        out = read_root_output(outputs[True][0], name)
+        n = len(out["EventID"])
+        b = sorted(ref.keys()) == sorted(out.keys())
+        b = b and n == len(ref["EventID"]) and n > 0
+        utility.print_test(b, f"Tree {name}: {n} digi")
+        is_ok = is_ok and b
+        for k in ref.keys():
+            b = np.array_equal(np.sort(ref[k]), np.sort(out[k]))
+            utility.print_test(b, f"Branch {k}")
+            is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
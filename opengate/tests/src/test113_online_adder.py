@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test113")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # two crystals
+    crystals = []
+    for i, z in enumerate([10 * cm, 14 * cm]):
+        crystal = sim.add_volume("Box", f"crystal{i}")
+        crystal.size = [20 * cm, 20 * cm, 2 * cm]
+        crystal.translation = [0, 0, z]
+        crystal.material = "G4_SODIUM_IODIDE"
+        crystals.append(crystal.name)
+
+    # gammas toward the crystals
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 511 * keV
+    source.position.type = "sphere"
+    source.position.radius = 2 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 5000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # reference: hits then adder
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystals
+    hc.output_filename = "test113_ref.root"
+    hc.attributes = [
+        "EventID",
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "GlobalTime",
+        "PreStepUniqueVolumeID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.input_digi_collection = hc.name
+    sc.output_filename = hc.output_filename
+    sc.policy = "EnergyWeightedCentroidPosition"
+    sc.number_of_hits = True
+
+    # the same singles, without the hits
+    oc = sim.add_actor("DigitizerOnlineAdderActor", "online_singles")
+    oc.attached_to = crystals
+    oc.output_filename = "test113_online.root"
+    oc.policy = sc.policy
+    oc.number_of_hits = True
+
+    sim.run()
+    print(stats)
+
+    # same singles (the order of the threads may differ)
+    ref = uproot.open(sc.get_output_path())[sc.name].arrays(library="np")
+    out = uproot.open(oc.get_output_path())[oc.name].arrays(library="np")
+    n = len(out["EventID"])
+    is_ok = n == len(ref["EventID"]) and n > 0
+    utility.print_test(is_ok, f"Number of singles: {n} vs {len(ref['EventID'])}")
+    for k in out.keys():
+        if k == "PreStepUniqueVolumeID":
+            b = np.array_equal(np.sort(ref[k]), np.sort(out[k]))
+        else:
+            b = np.allclose(np.sort(ref[k]), np.sort(out[k]))
+        utility.print_test(b, f"Branch {k}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
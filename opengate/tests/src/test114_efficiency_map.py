@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test114")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 963852
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # 4 repeated crystals (copy number 0 to 3)
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [5 * cm, 20 * cm, 2 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+    crystal.translation = gate.geometry.utility.get_grid_repetition(
+        [4, 1, 1], [5 * cm, 0, 0], start=[-7.5 * cm, 0, 10 * cm]
+    )
+
+    # gammas toward the crystals
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 511 * keV
+    source.position.type = "box"
+    source.position.size = [20 * cm, 10 * cm, 1 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 5000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits and singles
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.output_filename = "test114.root"
+    hc.attributes = [
+        "EventID",
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "GlobalTime",
+        "PreStepUniqueVolumeID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.input_digi_collection = hc.name
+    sc.output_filename = hc.output_filename
+
+    # efficiency per crystal, below and above 300 keV
+    efficiency_map = np.array([[1, 1], [0, 0], [1, 1], [1, 0]])
+    ea = sim.add_actor("DigitizerEfficiencyActor", "efficiency")
+    ea.input_digi_collection = sc.name
+    ea.output_filename = hc.output_filename
+    ea.efficiency_map = efficiency_map
+    ea.efficiency_map_volume = crystal.name
+    ea.efficiency_map_energy_range = [0, 600 * keV]
+
+    sim.run()
+    print(stats)
+
+    # the kept singles are the ones with an efficiency of 1
+    root_file = uproot.open(ea.get_output_path())
+    singles = root_file[sc.name].arrays(library="np")
+    out = root_file[ea.name].arrays(library="np")
+
+    def crystal_index(ids):
+        return np.array([int(i.split("_")[-1]) for i in ids])
+
+    energy_bin = np.clip(
+        (singles["TotalEnergyDeposit"] / (300 * keV)).astype(int), 0, 1
+    )
+    crystals = crystal_index(singles["PreStepUniqueVolumeID"])
+    kept = efficiency_map[crystals, energy_bin]
+    ref_edep = np.sort(singles["TotalEnergyDeposit"][kept == 1])
+    n = len(out["TotalEnergyDeposit"])
+    is_ok = n == len(ref_edep) and 0 < n < len(singles["TotalEnergyDeposit"])
+    utility.print_test(
+        is_ok, f"Kept singles: {n} / {len(singles['TotalEnergyDeposit'])}"
+    )
+    b = np.array_equal(ref_edep, np.sort(out["TotalEnergyDeposit"]))
+    utility.print_test(b, "Same energies as the expected singles")
+    is_ok = is_ok and b
+    c = crystal_index(out["PreStepUniqueVolumeID"])
+    b = np.all(c != 1) and np.all(out["TotalEnergyDeposit"][c == 3] < 300 * keV)
+    utility.print_test(b, "No single in crystal 1, only low energies in crystal 3")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
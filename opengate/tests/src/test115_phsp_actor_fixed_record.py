@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.sources.phspsources import read_phsp_columnar
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test115")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    deg = gate.g4_units.deg
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 258147
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_AIR"
+
+    # scoring plane
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [50 * cm, 50 * cm, 1 * cm]
+    plane.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "e-"
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "iso"
+    source.direction.theta = [150 * deg, 180 * deg]
+    source.direction.phi = [0, 360 * deg]
+    source.energy.type = "range"
+    source.energy.min_energy = 500 * keV
+    source.energy.max_energy = 6 * MeV
+    source.n = 10000
+
+    # the same exiting particles: root, fixed record, and attributes
+    attributes = [
+        "PostKineticEnergy",
+        "Weight",
+        "PostPosition",
+        "PostDirection",
+        "PDGCode",
+        "EventID",
+    ]
+    actors = {}
+    for name, filename, extra in [
+        ("phsp_root", "test115.root", []),
+        ("phsp_fixed", "test115_fixed.gphsp", []),
+        ("phsp_generic", "test115_generic.gphsp", ["TrackID"]),
+    ]:
+        phsp = sim.add_actor("PhaseSpaceActor", name)
+        phsp.attached_to = plane
+        phsp.attributes = attributes + extra
+        phsp.steps_to_store = "exiting"
+        phsp.output_filename = filename
+        phsp.chunk_size = 500
+        actors[name] = phsp
+    sim.run(start_new_process=True)
+
+    ref = uproot.open(actors["phsp_root"].get_output_path())["phsp_root"]
+    ref = ref.arrays(library="np")
+    fixed = read_phsp_columnar(actors["phsp_fixed"].get_output_path())
+    generic = read_phsp_columnar(actors["phsp_generic"].get_output_path())
+    n = len(ref["EventID"])
+    b = n > 0 and len(fixed["EventID"]) == n and len(generic["EventID"]) == n
+    utility.print_test(
+        b, f"Number of entries: {len(fixed['EventID'])} {len(generic['EventID'])} {n}"
+    )
+    is_ok = b
+
+    # same entries (the order of the chunks depends on the threads)
+    def sort_order(data):
+        e = data["PostKineticEnergy"].astype(np.float32)
+        return np.lexsort([e, data["PDGCode"], data["EventID"]])
+
+    o_ref = sort_order(ref)
+    for name, data in [("fixed", fixed), ("attributes", generic)]:
+        o = sort_order(data)
+        b = np.all(ref["EventID"][o_ref] == data["EventID"][o])
+        b = b and np.all(ref["PDGCode"][o_ref] == data["PDGCode"][o])
+        for k in data.keys():
+            if k in ["EventID", "PDGCode", "TrackID"]:
+                continue
+            b = b and np.allclose(ref[k][o_ref], data[k][o], rtol=1e-6, atol=1e-4)
+        utility.print_test(b, f"Same values with the {name}")
+        is_ok = is_ok and b
+
+    # the columns of the fixed record are the ones of the attributes
+    b = [k for k in fixed.keys()] == [k for k in generic.keys() if k != "TrackID"]
+    utility.print_test(b, f"Same columns: {list(fixed.keys())}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
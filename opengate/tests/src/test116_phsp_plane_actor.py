@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test116")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    um = gate.g4_units.um
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    deg = gate.g4_units.deg
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 741852
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    # reference: a thin scoring volume, its entrance face is at z = 10 cm
+    thickness = 1 * um
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [80 * cm, 80 * cm, thickness]
+    plane.translation = [0, 0, 10 * cm + thickness / 2]
+    plane.material = "G4_Galactic"
+
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "gamma"
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.direction.type = "iso"
+    # toward +Z, at most 30 deg from the axis
+    source.direction.theta = [150 * deg, 180 * deg]
+    source.direction.phi = [0, 360 * deg]
+    source.energy.type = "range"
+    source.energy.min_energy = 100 * keV
+    source.energy.max_energy = 2 * MeV
+    source.n = 10000
+
+    phsp_ref = sim.add_actor("PhaseSpaceActor", "phsp_ref")
+    phsp_ref.attached_to = plane
+    phsp_ref.attributes = ["PrePosition", "PreDirection", "KineticEnergy", "EventID"]
+    phsp_ref.steps_to_store = "entering"
+    phsp_ref.output_filename = "test116_ref.root"
+
+    # the same plane, without volume (in the world coordinate system)
+    phsp = sim.add_actor("PhaseSpacePlaneActor", "phsp_plane")
+    phsp.attached_to = world
+    phsp.plane_position = [0, 0, 10 * cm]
+    phsp.plane_normal = [0, 0, 1]
+    phsp.attributes = ["Position", "Direction", "KineticEnergy", "EventID"]
+    phsp.output_filename = "test116_plane.root"
+    sim.run()
+
+    ref = uproot.open(phsp_ref.get_output_path())["phsp_ref"].arrays(library="np")
+    data = uproot.open(phsp.get_output_path())["phsp_plane"].arrays(library="np")
+    n = len(ref["EventID"])
+    is_ok = n > 0 and len(data["EventID"]) == n
+    utility.print_test(is_ok, f"Number of crossings: {len(data['EventID'])} vs {n}")
+
+    o_ref = np.argsort(ref["EventID"], kind="stable")
+    o = np.argsort(data["EventID"], kind="stable")
+    b = np.all(ref["EventID"][o_ref] == data["EventID"][o])
+    b = b and np.allclose(ref["KineticEnergy"][o_ref], data["KineticEnergy"][o])
+    utility.print_test(b, "Same events and energies")
+    is_ok = is_ok and b
+
+    for a in "XYZ":
+        b = np.allclose(
+            ref[f"PrePosition_{a}"][o_ref], data[f"Position_{a}"][o], atol=1e-3
+        )
+        b = b and np.allclose(
+            ref[f"PreDirection_{a}"][o_ref], data[f"Direction_{a}"][o], atol=1e-6
+        )
+        utility.print_test(b, f"Same position and direction along {a}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def read(path):
+    return itk.array_from_image(itk.imread(str(path)))
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test118")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [0.5 * m, 0.5 * m, 0.5 * m]
+    sim.world.material = "G4_AIR"
+
+    # water box with a bone slab
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+    bonebox = sim.add_volume("Box", "bonebox")
+    bonebox.mother = waterbox.name
+    bonebox.size = [10 * cm, 10 * cm, 2 * cm]
+    bonebox.material = "G4_BONE_CORTICAL_ICRP"
+
+    sim.physics_manager.physics_list_name = "QGSP_BERT_EMV"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # protons
+    source = sim.add_source("GenericSource", "protons")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 1 * cm
+    source.position.translation = [0, 0, -80 * mm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 2000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # several actors with the same image geometry share the voxel index, the
+    # material and the dE/dx of each step
+    doses = []
+    for i, score_in in enumerate(["G4_WATER", "G4_WATER", "material"]):
+        dose = sim.add_actor("DoseActor", f"dose{i}")
+        dose.attached_to = waterbox
+        dose.output_filename = f"test118_dose{i}.mhd"
+        dose.size = [10, 10, 50]
+        dose.spacing = [10 * mm, 10 * mm, 2 * mm]
+        dose.hit_type = "middle"
+        dose.score_in = score_in
+        dose.dose.active = True
+        doses.append(dose)
+    let = sim.add_actor("LETActor", "let")
+    let.attached_to = waterbox
+    let.output_filename = "test118_let.mhd"
+    let.size = [10, 10, 50]
+    let.spacing = [10 * mm, 10 * mm, 2 * mm]
+    let.hit_type = "middle"
+    let.averaging_method = "dose_average"
+    let.score_in = "G4_WATER"
+
+    # another geometry: the same edep summed over larger voxels
+    coarse = sim.add_actor("DoseActor", "coarse")
+    coarse.attached_to = waterbox
+    coarse.output_filename = "test118_coarse.mhd"
+    coarse.size = [5, 5, 25]
+    coarse.spacing = [20 * mm, 20 * mm, 4 * mm]
+    coarse.hit_type = "middle"
+
+    sim.run()
+    print(stats)
+
+    # the same options give the same images
+    d0 = read(doses[0].dose.get_output_path())
+    d1 = read(doses[1].dose.get_output_path())
+    is_ok = np.array_equal(d0, d1) and d0.sum() > 0
+    utility.print_test(is_ok, "Same dose to water for the two same actors")
+
+    # dose to water differs from dose in the bone only (slices 20 to 29)
+    d2 = read(doses[2].dose.get_output_path())
+    e0 = read(doses[0].edep.get_output_path())
+    e2 = read(doses[2].edep.get_output_path())
+    b = np.allclose(e0[:20], e2[:20]) and not np.allclose(d0[20:30], d2[20:30])
+    utility.print_test(b, "Dose to water differs only in the bone")
+    is_ok = is_ok and b
+
+    # edep of the coarse image equals the sum of the fine edep (2x2x2 voxels)
+    c = read(coarse.edep.get_output_path())
+    s = e2.reshape(25, 2, 5, 2, 5, 2).sum(axis=(1, 3, 5))
+    b = np.allclose(c, s, rtol=1e-6, atol=1e-9)
+    utility.print_test(b, f"Coarse edep {c.sum():.3f} vs fine {e2.sum():.3f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
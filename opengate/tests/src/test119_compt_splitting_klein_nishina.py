@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def run_simulation(paths, name, nb_split, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    um = gate.g4_units.um
+    km = gate.g4_units.km
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 741852
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # water slab
+    slab = sim.add_volume("Box", "slab")
+    slab.size = [20 * cm, 20 * cm, 5 * cm]
+    slab.material = "G4_WATER"
+
+    # phase space on a sphere around the slab
+    shell = sim.add_volume("Sphere", "shell")
+    shell.rmin = 40 * cm
+    shell.rmax = 40 * cm + 1 * mm
+    shell.material = "G4_Galactic"
+
+    # photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    if nb_split > 1:
+        split = sim.add_actor("ComptSplittingActor", "split")
+        split.attached_to = slab
+        split.splitting_factor = nb_split
+        split.splitting_mode = "klein_nishina"
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = shell
+    phsp.output_filename = f"test119_{name}.root"
+    phsp.attributes = ["KineticEnergy", "Weight", "PDGCode", "PreDirection"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option2"
+    # (the compt process must not be hidden by the general gamma process)
+    sim.g4_commands_before_init.append("/process/em/UseGeneralProcess false")
+    sim.physics_manager.global_production_cuts.gamma = 1 * m
+    sim.physics_manager.global_production_cuts.electron = 1 * um
+    sim.physics_manager.global_production_cuts.positron = 1 * km
+
+    sim.run(start_new_process=True)
+    return phsp.get_output_path()
+
+
+def scattered_photons(path, n):
+    a = uproot.open(path)["phsp"].arrays(library="np")
+    MeV = gate.g4_units.MeV
+    s = (a["PDGCode"] == 22) & (a["KineticEnergy"] < 0.999 * MeV)
+    w = a["Weight"][s]
+    e = a["KineticEnergy"][s]
+    z = a["PreDirection_Z"][s]
+    return w.sum() / n, np.average(e, weights=w), np.average(z, weights=w)
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test119")
+
+    # analog reference and Klein-Nishina splitting
+    n_ref = 50000
+    n_split = 5000
+    ref = scattered_photons(run_simulation(paths, "ref", 1, n_ref), n_ref)
+    kn = scattered_photons(run_simulation(paths, "kn", 20, n_split), n_split)
+
+    is_ok = True
+    tols = [0.05, 0.03, 0.05]
+    names = ["Scattered photons per primary", "Mean energy", "Mean cos(z)"]
+    for name, r, k, tol in zip(names, ref, kn, tols):
+        b = abs(k - r) / abs(r) < tol
+        utility.print_test(b, f"{name}: {k:.4f} vs {r:.4f} (tol {tol})")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def run_simulation(paths, mode, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    keV = gate.g4_units.keV
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test121_phantom.mhd"
+    phantom.material = "G4_WATER"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+
+    # plane behind the phantom
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [1 * m, 1 * m, 1 * mm]
+    plane.translation = [0, 0, 20 * cm]
+    plane.material = "G4_Galactic"
+
+    # parallel photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 140.5 * keV
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    ff = sim.add_actor("FreeFlightActor", "ff")
+    ff.attached_to = phantom
+    ff.particles = "gamma"
+    ff.free_flight_mode = mode
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.output_filename = f"test121_{mode}.root"
+    phsp.attributes = ["KineticEnergy", "Weight"]
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    print(stats)
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    return a["Weight"], a["KineticEnergy"]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test121")
+    utility.create_water_bone_phantom(paths.output / "test121_phantom.mhd", spacing=5)
+    keV = gate.g4_units.keV
+
+    n = 20000
+    w_ref, e_ref = run_simulation(paths, "biasing", n)
+    w, e = run_simulation(paths, "voxel", n)
+
+    # no interaction: all the photons reach the plane, with the initial energy
+    is_ok = len(w) == len(w_ref) and np.allclose(e, 140.5 * keV)
+    utility.print_test(is_ok, f"Number of photons {len(w)} vs {len(w_ref)}")
+
+    # same transmission (the weight is exp(-sum mu l) in both modes)
+    t_ref = w_ref.sum() / n
+    t = w.sum() / n
+    tol = 0.02
+    b = abs(t - t_ref) / t_ref < tol
+    utility.print_test(b, f"Transmission voxel {t:.5f} vs biasing {t_ref:.5f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
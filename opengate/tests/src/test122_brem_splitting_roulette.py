@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import uproot
+import numpy as np
+
+
+def run_simulation(paths, name, russian_roulette):
+    # units
+    m = gate.g4_units.m
+    km = gate.g4_units.km
+    mm = gate.g4_units.mm
+    um = gate.g4_units.um
+    nm = gate.g4_units.nm
+    MeV = gate.g4_units.MeV
+    deg = gate.g4_units.deg
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 1
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    sim.world.size = [1 * m, 1 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+
+    # thin tungsten wire along z, a single brem per electron
+    target = sim.add_volume("Tubs", "target")
+    target.material = "G4_W"
+    target.rmin = 0
+    target.rmax = 0.1 * um
+    target.dz = 0.5 * m
+
+    brem = sim.add_actor("BremSplittingActor", "brem")
+    brem.attached_to = target
+    brem.splitting_factor = 100
+    brem.particles = "e-"
+    brem.russian_roulette = russian_roulette
+    brem.vector_director = [0, 0, 1]
+    brem.max_theta = 5 * deg
+
+    # phase space around the wire
+    plane = sim.add_volume("Tubs", "plane")
+    plane.material = "G4_Galactic"
+    plane.rmin = 0.11 * um
+    plane.rmax = 0.11 * um + 1 * nm
+    plane.dz = 0.5 * m
+
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "e-"
+    source.n = 20000
+    source.position.type = "sphere"
+    source.position.radius = 1 * nm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.energy.mono = 6 * MeV
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["EventID", "Weight", "ParticleName", "PreDirection"]
+    phsp.output_filename = f"test122_{name}.root"
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.gamma = 1 * mm
+    sim.physics_manager.global_production_cuts.electron = 1 * um
+    sim.physics_manager.global_production_cuts.positron = 1 * km
+
+    sim.run(start_new_process=True)
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    s = a["ParticleName"] == "gamma"
+    return a["Weight"][s], a["PreDirection_Z"][s]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test122")
+    cos_max = np.cos(np.radians(5))
+
+    w_ref, dz_ref = run_simulation(paths, "ref", False)
+    w, dz = run_simulation(paths, "roulette", True)
+
+    # same weighted number of photons, in and out of the cone
+    is_ok = True
+    for name, s_ref, s in [
+        ("in the cone", dz_ref >= cos_max, dz >= cos_max),
+        ("outside the cone", dz_ref < cos_max, dz < cos_max),
+    ]:
+        ref = w_ref[s_ref].sum()
+        v = w[s].sum()
+        b = abs(v - ref) / ref < 0.05
+        utility.print_test(b, f"Weight {name}: {v:.2f} vs {ref:.2f}")
+        is_ok = is_ok and b
+
+    # far fewer photons to track outside the cone
+    n_ref = (dz_ref < cos_max).sum()
+    n = (dz < cos_max).sum()
+    b = n < n_ref / 20
+    utility.print_test(b, f"Photons outside the cone: {n} vs {n_ref}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
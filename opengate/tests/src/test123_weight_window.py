@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import uproot
+
+
+def create_importance_map(path):
+    # 4 slices along z, importance x2 per 5 cm of concrete
+    arr = np.ones((4, 1, 1), dtype=np.float32)
+    arr[:, 0, 0] = [1, 2, 4, 8]
+    img = gate.image.itk_image_from_array(arr)
+    img.SetSpacing([500, 500, 50])
+    itk.imwrite(img, str(path))
+
+
+def run_simulation(paths, name, n, mode=None):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 852741
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [2 * m, 2 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+
+    # 20 cm concrete shield, in 4 layers
+    shield = sim.add_volume("Box", "shield")
+    shield.size = [50 * cm, 50 * cm, 20 * cm]
+    shield.material = "G4_CONCRETE"
+    for i in range(4):
+        layer = sim.add_volume("Box", f"layer{i}")
+        layer.mother = shield
+        layer.size = [50 * cm, 50 * cm, 5 * cm]
+        layer.translation = [0, 0, (i - 1.5) * 5 * cm]
+        layer.material = "G4_CONCRETE"
+
+    # plane behind the shield
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [1 * m, 1 * m, 1 * mm]
+    plane.translation = [0, 0, 20 * cm]
+    plane.material = "G4_Galactic"
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 1 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -50 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    if mode == "volumes":
+        ww = sim.add_actor("WeightWindowActor", "ww")
+        ww.attached_to = "world"
+        ww.volume_importances = {f"layer{i}": 2**i for i in range(4)}
+    if mode == "image":
+        ww = sim.add_actor("WeightWindowActor", "ww")
+        ww.attached_to = shield
+        ww.importance_map = paths.output / "test123_importance.mhd"
+    if mode is not None:
+        ww.lower_weight_bounds = [0.5]
+        ww.upper_weight_bounds = [2]
+        f = sim.add_filter("ParticleFilter", "f")
+        f.particle = "gamma"
+        ww.filters.append(f)
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.output_filename = f"test123_{name}.root"
+    phsp.attributes = ["KineticEnergy", "Weight"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    return a["Weight"]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test123")
+    create_importance_map(paths.output / "test123_importance.mhd")
+
+    n_ref = 200000
+    w_ref = run_simulation(paths, "analog", n_ref)
+    t_ref = w_ref.sum() / n_ref
+    t_ref_error = np.sqrt(len(w_ref)) / n_ref
+
+    is_ok = True
+    n = 20000
+    for mode in ["volumes", "image"]:
+        w = run_simulation(paths, mode, n, mode)
+        t = w.sum() / n
+        b = abs(t - t_ref) / t_ref < 0.05
+        utility.print_test(
+            b,
+            f"Transmission with {mode} weight windows {t:.5f} vs analog "
+            f"{t_ref:.5f} +/- {t_ref_error:.5f}",
+        )
+        is_ok = is_ok and b
+
+        # more particles reach the plane (for fewer primaries)
+        b = len(w) / n > 2 * len(w_ref) / n_ref
+        utility.print_test(
+            b, f"Photons per primary {len(w) / n:.4f} vs {len(w_ref) / n_ref:.4f}"
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
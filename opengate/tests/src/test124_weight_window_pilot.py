@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.actors.biasingactors import importance_map_from_fluence
+import itk
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, name, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 159357
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [2 * m, 2 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+
+    # 20 cm concrete shield
+    shield = sim.add_volume("Box", "shield")
+    shield.size = [50 * cm, 50 * cm, 20 * cm]
+    shield.material = "G4_CONCRETE"
+
+    # plane behind the shield
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [1 * m, 1 * m, 1 * mm]
+    plane.translation = [0, 0, 20 * cm]
+    plane.material = "G4_Galactic"
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 1 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -50 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.output_filename = f"test124_{name}.root"
+    phsp.attributes = ["KineticEnergy", "Weight"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+    return sim
+
+
+def get_weights(phsp):
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    return a["Weight"]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test124")
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+
+    # analog reference
+    n_ref = 200000
+    sim = create_simulation(paths, "analog", n_ref)
+    sim.run(start_new_process=True)
+    w_ref = get_weights(sim.actor_manager.get_actor("phsp"))
+    t_ref = w_ref.sum() / n_ref
+
+    # pilot run: fluence along the depth of the shield
+    sim = create_simulation(paths, "pilot", 5000)
+    fluence = sim.add_actor("FluenceActor", "fluence")
+    fluence.attached_to = "shield"
+    fluence.size = [1, 1, 40]
+    fluence.spacing = [50 * cm, 50 * cm, 5 * mm]
+    fluence.output_filename = "test124_pilot_fluence.mhd"
+    sim.run(start_new_process=True)
+    importance = importance_map_from_fluence(fluence.fluence.get_output_path())
+    arr = itk.array_view_from_image(importance).ravel()
+    print(f"Importances along the depth: {arr}")
+
+    # the importance increases along the depth
+    is_ok = arr[0] == 1 and arr[-1] > 8 and np.all(np.diff(arr) >= 0)
+    utility.print_test(is_ok, f"Importance from 1 to {arr[-1]}")
+
+    # production run with the weight windows of the pilot run
+    n = 20000
+    sim = create_simulation(paths, "ww", n)
+    ww = sim.add_actor("WeightWindowActor", "ww")
+    ww.attached_to = "shield"
+    # (written to disk, the simulation runs in a new process)
+    ww.importance_map = paths.output / "test124_importance.mhd"
+    itk.imwrite(importance, str(ww.importance_map))
+    sim.run(start_new_process=True)
+    w = get_weights(sim.actor_manager.get_actor("phsp"))
+    t = w.sum() / n
+
+    b = abs(t - t_ref) / t_ref < 0.05
+    utility.print_test(b, f"Transmission {t:.5f} vs analog {t_ref:.5f}")
+    is_ok = is_ok and b
+
+    b = len(w) / n > 2 * len(w_ref) / n_ref
+    utility.print_test(
+        b, f"Photons per primary {len(w) / n:.4f} vs {len(w_ref) / n_ref:.4f}"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def run_simulation(paths, name, range_rejection):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 753951
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # electron beam entering the water box
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "e-"
+    source.n = 5000 / sim.number_of_threads
+    source.energy.mono = 2 * MeV
+    source.position.type = "disc"
+    source.position.radius = 1 * cm
+    source.position.translation = [0, 0, -6 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    if range_rejection:
+        rr = sim.add_actor("RangeRejectionActor", "rr")
+        rr.attached_to = waterbox
+        rr.particles = ["e-"]
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [1, 1, 50]
+    dose.spacing = [10 * cm, 10 * cm, 2 * mm]
+    dose.output_filename = f"test125_{name}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * m)
+    sim.physics_manager.set_production_cut("waterbox", "all", 0.1 * mm)
+
+    # (the range rejection run is the last one, in this process, to get the
+    # number of killed particles)
+    sim.run(start_new_process=not range_rejection)
+    print(stats)
+    edep = itk.array_from_image(itk.imread(dose.edep.get_output_path())).ravel()
+    killed = rr.number_of_killed_particles if range_rejection else 0
+    return edep, stats.counts.steps, killed
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test125")
+
+    edep_ref, steps_ref, _ = run_simulation(paths, "ref", False)
+    edep, steps, killed = run_simulation(paths, "rr", True)
+
+    # the killed electrons deposit their energy in place
+    d = abs(edep.sum() - edep_ref.sum()) / edep_ref.sum()
+    is_ok = d < 0.02
+    utility.print_test(
+        is_ok, f"Total edep {edep.sum():.2f} vs {edep_ref.sum():.2f} MeV ({d:.3f})"
+    )
+
+    # same depth profile (2 MeV electrons, range ~1 cm)
+    b = np.allclose(edep[:8], edep_ref[:8], rtol=0.1)
+    utility.print_test(b, f"Depth profile {edep[:8]} vs {edep_ref[:8]}")
+    is_ok = is_ok and b
+
+    b = killed > 0 and steps < 0.7 * steps_ref
+    utility.print_test(b, f"Killed {killed}, steps {steps} vs {steps_ref}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
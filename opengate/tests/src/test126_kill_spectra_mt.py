@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test126")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    nm = gate.g4_units.nm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 4
+    sim.random_seed = 456123
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_Galactic"
+
+    plane = sim.add_volume("Box", "kill_plane")
+    plane.material = "G4_Galactic"
+    plane.size = [50 * cm, 50 * cm, 1 * nm]
+
+    # two beams of gammas and one of electrons toward the kill plane
+    n = 3000
+    for name, particle, energy in [
+        ("g1", "gamma", 200 * keV),
+        ("g2", "gamma", 1 * MeV),
+        ("e", "e-", 1 * MeV),
+    ]:
+        source = sim.add_source("GenericSource", name)
+        source.particle = particle
+        source.position.type = "point"
+        source.position.translation = [0, 0, -10 * cm]
+        source.direction.type = "momentum"
+        source.direction.momentum = [0, 0, 1]
+        source.energy.mono = energy
+        source.n = n / sim.number_of_threads
+
+    kill_actor = sim.add_actor("KillActor", "kill")
+    kill_actor.attached_to = plane
+    kill_actor.energy_bins = [0, 500 * keV, 2 * MeV]
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    sim.run()
+    print(stats)
+
+    nk = kill_actor.number_of_killed_particles
+    spectra = kill_actor.kill_spectra
+    print(f"Number of kills = {nk}, spectra = {spectra}")
+    is_ok = nk == 3 * n
+    utility.print_test(is_ok, f"Number of kills {nk} vs {3 * n}")
+
+    b = list(spectra["gamma"]) == [n, n] and list(spectra["e-"]) == [0, n]
+    utility.print_test(b, f"Kill spectra {spectra}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def run_simulation(paths, navigation, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test127_phantom.mhd"
+    phantom.material = "G4_AIR"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+    phantom.navigation = navigation
+
+    # photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n
+    source.energy.mono = 2 * MeV
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    # depth dose profile
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = phantom
+    dose.size = [1, 1, 50]
+    dose.spacing = [20 * cm, 20 * cm, 4 * gate.g4_units.mm]
+    dose.hit_type = "random"
+    dose.output_filename = f"test127_{navigation}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    print(stats)
+    edep = itk.array_from_image(itk.imread(dose.edep.get_output_path()))
+    return edep.ravel(), stats.counts.steps
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test127")
+    utility.create_water_bone_phantom(
+        paths.output / "test127_phantom.mhd",
+        spacing=2,
+        bone_min=(0, 0, 100),
+        bone_max=(200, 200, 120),
+    )
+
+    n = 50000
+    edep_ref, steps_ref = run_simulation(paths, "nested", n)
+    edep, steps = run_simulation(paths, "regular", n)
+
+    # the boundaries between the voxels of the same material are skipped
+    is_ok = steps < steps_ref
+    utility.print_test(is_ok, f"Number of steps regular {steps} vs nested {steps_ref}")
+
+    # same total deposited energy
+    tol = 0.03
+    t_ref = edep_ref.sum()
+    t = edep.sum()
+    b = abs(t - t_ref) / t_ref < tol
+    utility.print_test(b, f"Total edep regular {t:.2f} vs nested {t_ref:.2f} MeV")
+    is_ok = is_ok and b
+
+    # same depth profile (mean relative difference of the bins)
+    mask = edep_ref > 0.05 * edep_ref.max()
+    d = np.mean(np.abs(edep[mask] - edep_ref[mask]) / edep_ref[mask])
+    b = d < 0.05
+    utility.print_test(b, f"Mean relative difference of the profiles {d:.3f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def run_simulation(paths, navigation, max_run_length, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test128_phantom.mhd"
+    phantom.material = "G4_AIR"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+    phantom.navigation = navigation
+    phantom.max_run_length = max_run_length
+
+    # photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n
+    source.energy.mono = 2 * MeV
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    # depth dose profile
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = phantom
+    dose.size = [1, 1, 50]
+    dose.spacing = [20 * cm, 20 * cm, 4 * gate.g4_units.mm]
+    dose.hit_type = "random"
+    dose.output_filename = f"test128_{navigation}_{max_run_length}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    print(stats)
+    edep = itk.array_from_image(itk.imread(dose.edep.get_output_path()))
+    return edep.ravel(), stats.counts.steps
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test128")
+    utility.create_water_bone_phantom(
+        paths.output / "test128_phantom.mhd",
+        spacing=2,
+        bone_min=(0, 0, 100),
+        bone_max=(200, 200, 120),
+    )
+
+    n = 50000
+    edep_ref, steps_ref = run_simulation(paths, "nested", 0, n)
+    is_ok = True
+    steps_previous = 0
+    for max_run_length in [8, 0]:
+        edep, steps = run_simulation(paths, "runs", max_run_length, n)
+
+        # the boundaries between the voxels of a run are skipped, and the
+        # longer the runs, the fewer the steps
+        b = steps < steps_ref and (steps_previous == 0 or steps < steps_previous)
+        utility.print_test(
+            b, f"Number of steps runs({max_run_length}) {steps} vs nested {steps_ref}"
+        )
+        is_ok = is_ok and b
+        steps_previous = steps
+
+        # same total deposited energy
+        tol = 0.03
+        t_ref = edep_ref.sum()
+        t = edep.sum()
+        b = abs(t - t_ref) / t_ref < tol
+        utility.print_test(b, f"Total edep runs {t:.2f} vs nested {t_ref:.2f} MeV")
+        is_ok = is_ok and b
+
+        # same depth profile (mean relative difference of the bins)
+        mask = edep_ref > 0.05 * edep_ref.max()
+        d = np.mean(np.abs(edep[mask] - edep_ref[mask]) / edep_ref[mask])
+        b = d < 0.05
+        utility.print_test(b, f"Mean relative difference of the profiles {d:.3f}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+import opengate.contrib.phantoms.nemaiec as gate_iec
+from opengate.tests import utility
+import itk
+import numpy as np
+import time
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "", output_folder="test129")
+
+    # create the simulation
+    sim = gate.Simulation()
+    sim.output_dir = paths.output
+    gate.logger.global_log.setLevel(gate.logger.NONE)
+
+    m = gate.g4_units.m
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # add a iec phantom
+    iec = gate_iec.add_iec_phantom(sim)
+
+    # reference: one thread, voxel by voxel
+    results = {}
+    for name, threads, block in [
+        ("ref", 1, 1),
+        ("mt", 4, 1),
+        ("refine", 4, 3),
+    ]:
+        t = time.time()
+        labels, image = sim.voxelize_geometry(
+            iec,
+            spacing=(2, 2, 2),
+            margin=1,
+            number_of_threads=threads,
+            refinement_block_size=block,
+        )
+        t = time.time() - t
+        print(f"Voxelization {name}: {threads} threads, block {block}: {t:.1f} s")
+        results[name] = (labels, itk.array_from_image(image))
+
+    labels_ref, arr_ref = results["ref"]
+
+    # same labels and same image with several threads
+    labels, arr = results["mt"]
+    is_ok = labels == labels_ref and np.array_equal(arr, arr_ref)
+    utility.print_test(is_ok, f"Same labels and image with 4 threads")
+
+    # refinement: almost the same image (the labels are compared by volume)
+    labels, arr = results["refine"]
+    b = set(labels.keys()).issubset(labels_ref.keys())
+    lut = np.zeros(256, dtype=arr_ref.dtype)
+    for k in labels:
+        lut[labels[k]["label"]] = labels_ref[k]["label"]
+    diff = np.count_nonzero(lut[arr] != arr_ref) / arr.size
+    b = b and diff < 0.005
+    utility.print_test(b, f"Refinement, fraction of different voxels {diff:.5f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.voxelize import voxelized_source
+import itk
+import numpy as np
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "", output_folder="test130")
+
+    # create the simulation
+    sim = gate.Simulation()
+    sim.output_dir = paths.output
+    gate.logger.global_log.setLevel(gate.logger.NONE)
+
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # a sphere in a box, both with analytic volumes
+    box = sim.add_volume("Box", "box")
+    box.size = [60 * mm, 60 * mm, 60 * mm]
+    box.material = "G4_WATER"
+    sphere = sim.add_volume("Sphere", "sphere")
+    sphere.mother = box
+    sphere.rmax = 13 * mm
+    sphere.material = "G4_BONE_CORTICAL_ICRP"
+    volume = 4 / 3 * np.pi * sphere.rmax**3
+
+    spacing = 4 * mm
+    labels, image = sim.voxelize_geometry(box, spacing=(spacing,) * 3)
+    labels_ss, image_ss, fractions = sim.voxelize_geometry(
+        box, spacing=(spacing,) * 3, supersampling=8
+    )
+
+    # the label image is the same
+    is_ok = np.array_equal(
+        itk.array_view_from_image(image), itk.array_view_from_image(image_ss)
+    )
+    utility.print_test(is_ok, f"Same label image with supersampling")
+
+    # the fractions of each voxel sum to one
+    f_sum = sum(itk.array_view_from_image(f) for f in fractions.values())
+    b = np.allclose(f_sum, 1, atol=1e-5)
+    utility.print_test(b, f"Sum of the fractions: {f_sum.min()} {f_sum.max()}")
+    is_ok = is_ok and b
+
+    # volume of the sphere, with and without partial volume
+    voxel_volume = spacing**3
+    arr = itk.array_view_from_image(image)
+    v_plain = np.count_nonzero(arr == labels["sphere"]["label"]) * voxel_volume
+    v_ss = itk.array_view_from_image(fractions["sphere"]).sum() * voxel_volume
+    e_plain = abs(v_plain - volume) / volume
+    e_ss = abs(v_ss - volume) / volume
+    b = e_ss < 0.01 and e_ss < e_plain
+    utility.print_test(
+        b,
+        f"Sphere volume {volume:.0f} mm3: plain {v_plain:.0f} ({e_plain:.3f}), "
+        f"supersampled {v_ss:.0f} ({e_ss:.3f})",
+    )
+    is_ok = is_ok and b
+
+    # partial volume activity map: the total activity is the one of the sphere
+    src = voxelized_source(image, labels_ss, {"sphere": 1.0}, fractions)
+    total = itk.array_view_from_image(src).sum() * voxel_volume
+    b = abs(total - volume) / volume < 0.01
+    utility.print_test(b, f"Total activity {total:.0f} vs {volume:.0f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.geometry.utility import get_circular_repetition
+import opengate_core as g4
+import numpy as np
+
+
+def check_index(simulation_engine):
+    # the geometry is constructed: index the ring -> module -> crystal levels
+    index = g4.GateRepeatedDetectorIndex()
+    index.Initialize(["module", "crystal"])
+    n = index.GetNumberOfCrystals()
+    copies = [index.GetNumberOfCopies(i) for i in range(index.GetNumberOfLevels())]
+    roundtrip = all(index.GetIndex(index.GetCopyNumbers(i)) == i for i in range(n))
+    centers = []
+    for i in range(n):
+        c = index.GetCenter(i)
+        centers.append([c.x, c.y, c.z])
+    simulation_engine.user_hook_log.append(
+        {"n": n, "copies": copies, "roundtrip": roundtrip, "centers": centers}
+    )
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test131")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+
+    sim = gate.Simulation()
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # ring (placed once, not at the origin)
+    ring = sim.add_volume("Tubs", "ring")
+    ring.rmin = 20 * cm
+    ring.rmax = 30 * cm
+    ring.dz = 5 * cm
+    ring.translation = [0, 0, 10 * cm]
+    ring.material = "G4_AIR"
+
+    # 6 modules around the ring (repeated placements)
+    module = sim.add_volume("Box", "module")
+    module.mother = ring
+    module.size = [4 * cm, 6 * cm, 4 * cm]
+    module.material = "G4_AIR"
+    tr, rot = get_circular_repetition(6, [25 * cm, 0, 0], start_angle_deg=15)
+    module.translation = tr
+    module.rotation = rot
+
+    # 3 x 2 crystals in each module (repeat parameterisation)
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.mother = module
+    crystal.size = [1 * cm, 2 * cm, 2 * cm]
+    crystal.material = "G4_WATER"
+    repeater = gate.geometry.volumes.RepeatParametrisedVolume(repeated_volume=crystal)
+    repeater.linear_repeat = [3, 2, 1]
+    repeater.translation = [1.1 * cm, 2.1 * cm, 0]
+    sim.volume_manager.add_volume(repeater)
+
+    # expected center of each crystal: the crystal copies are numbered k
+    # fastest, then j and i (same order as the repeater)
+    start = [-(x - 1) * y / 2.0 for x, y in zip([3, 2, 1], repeater.translation)]
+    expected = []
+    for t, r in zip(tr, rot):
+        for i in range(3):
+            for j in range(2):
+                c = np.array([start[0] + i * 1.1 * cm, start[1] + j * 2.1 * cm, 0])
+                expected.append(np.array(r) @ c + np.array(t) + [0, 0, 10 * cm])
+
+    sim.user_hook_after_init = check_index
+    sim.init_only = True
+    sim.run(start_new_process=False)
+    log = sim.user_hook_log[0]
+
+    is_ok = log["n"] == 36 and log["copies"] == [6, 6]
+    utility.print_test(is_ok, f"Number of crystals {log['n']} {log['copies']}")
+    b = log["roundtrip"]
+    utility.print_test(b, f"Index of the copy numbers of each crystal")
+    is_ok = is_ok and b
+    d = np.abs(np.array(log["centers"]) - np.array(expected)).max()
+    b = d < 1e-6 * mm
+    utility.print_test(b, f"Crystal centers, max difference {d} mm")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.geometry.utility import get_circular_repetition
+import numpy as np
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test132")
+    utility.create_water_bone_phantom(
+        paths.output / "test132_phantom.mhd",
+        spacing=5,
+        size=(200, 200, 100),
+        bone_min=(120, 0, 0),
+        bone_max=(150, 200, 100),
+    )
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    keV = gate.g4_units.keV
+
+    sim = gate.Simulation()
+    sim.random_seed = 963852
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test132_phantom.mhd"
+    phantom.material = "G4_AIR"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+
+    # ring of 8 modules of 4 x 1 crystals
+    ring = sim.add_volume("Tubs", "ring")
+    ring.rmin = 30 * cm
+    ring.rmax = 40 * cm
+    ring.dz = 5 * cm
+    ring.material = "G4_AIR"
+    module = sim.add_volume("Box", "module")
+    module.mother = ring
+    module.size = [2 * cm, 8 * cm, 2 * cm]
+    module.material = "G4_AIR"
+    tr, rot = get_circular_repetition(8, [35 * cm, 0, 0])
+    module.translation = tr
+    module.rotation = rot
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.mother = module
+    crystal.size = [2 * cm, 2 * cm, 2 * cm]
+    crystal.material = "G4_WATER"
+    crystal.translation = gate.geometry.utility.get_grid_repetition(
+        [1, 4, 1], [0, 2 * cm, 0]
+    )
+
+    # one photon: the export is done at the beginning of the run
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = 1
+    source.energy.mono = 140 * keV
+
+    flat = sim.add_actor("FlatGeometryActor", "flat")
+    flat.attached_to = phantom
+    flat.detector = ["module", "crystal"]
+    flat.energy_min = 10 * keV
+    flat.energy_max = 1000 * keV
+    flat.energy_bins = 201
+    flat.output_filename = "test132_flat.npz"
+
+    sim.run(start_new_process=True)
+    f = np.load(flat.get_output_path())
+
+    # phantom geometry, centered on the world
+    is_ok = list(f["size"]) == [40, 40, 20] and f["labels"].shape == (20, 40, 40)
+    origin = -np.array([40, 40, 20]) * 5 / 2 + 2.5
+    b = np.allclose(f["origin"], origin) and np.allclose(f["direction"], np.eye(3))
+    utility.print_test(b and is_ok, f"Phantom {f['size']} origin {f['origin']}")
+    is_ok = is_ok and b
+    names = list(f["material_names"])
+    water = names.index("G4_WATER")
+    bone = names.index("G4_BONE_CORTICAL_ICRP")
+    b = np.all(f["labels"][:, :, :24] == water) and np.all(
+        f["labels"][:, :, 24:30] == bone
+    )
+    utility.print_test(b, f"Labels of the materials {names}")
+    is_ok = is_ok and b
+
+    # mu of water at 140 keV (NIST: 0.1538 cm2/g)
+    e = f["energies"]
+    mu = np.exp(np.interp(np.log(140 * keV), np.log(e), np.log(f["mu"][water])))
+    ref = 0.1538 / cm
+    b = abs(mu - ref) / ref < 0.03
+    utility.print_test(b, f"mu water 140 keV {mu * cm:.4f} vs {ref * cm:.4f} /cm")
+    is_ok = is_ok and b
+
+    # crystals: module rotation applied to the crystal offset
+    expected = []
+    for t, r in zip(tr, rot):
+        for j in range(4):
+            expected.append(np.array(r) @ [0, -3 * cm + j * 2 * cm, 0] + t)
+    c = f["crystal_centers"]
+    b = c.shape == (32, 3) and np.abs(c - expected).max() < 1e-6 * mm
+    b = b and np.allclose(f["crystal_half_size"], [1 * cm, 1 * cm, 1 * cm])
+    b = b and np.allclose(f["crystal_rotations"], np.repeat(rot, 4, axis=0))
+    utility.print_test(b, f"Crystal boxes {c.shape}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
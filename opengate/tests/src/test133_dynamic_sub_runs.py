@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from scipy.spatial.transform import Rotation
+import itk
+
+
+def run_simulation(paths, sub_runs):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    sec = gate.g4_units.second
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # 4 runs of 1 second, or 4 sub-runs of a single run
+    n = 4
+    sim.run_timing_intervals = gate.runtiming.range_timing(0, n * sec, n)
+    sim.dynamic_sub_runs = sub_runs
+
+    # fixed water slab
+    slab = sim.add_volume("Box", "slab")
+    slab.size = [40 * cm, 10 * cm, 10 * cm]
+    slab.translation = [0, 0, 20 * cm]
+    slab.material = "G4_WATER"
+
+    # the source is attached to a small box, moved (and rotated around the
+    # beam axis) at each interval
+    holder = sim.add_volume("Box", "holder")
+    holder.size = [1 * cm, 1 * cm, 1 * cm]
+    holder.material = "G4_AIR"
+    translations = [[-15 * cm + i * 10 * cm, 0, 0] for i in range(n)]
+    rotations = [
+        Rotation.from_euler("z", 30 * i, degrees=True).as_matrix() for i in range(n)
+    ]
+    holder.add_dynamic_parametrisation(translation=translations, rotation=rotations)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.attached_to = holder
+    source.particle = "gamma"
+    source.activity = 5000 * Bq
+    source.energy.mono = 1 * MeV
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    # edep in 4 bins along x, one per position of the source
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = slab
+    dose.size = [n, 1, 1]
+    dose.spacing = [10 * cm, 10 * cm, 10 * cm]
+    dose.output_filename = f"test133_sub_runs_{sub_runs}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    print(stats)
+    edep = itk.array_from_image(itk.imread(dose.edep.get_output_path()))
+    return edep.ravel(), stats.counts.runs
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test133")
+
+    edep_ref, runs_ref = run_simulation(paths, False)
+    edep, runs = run_simulation(paths, True)
+
+    # a single run instead of 4
+    is_ok = runs == 1 and runs_ref == 4
+    utility.print_test(is_ok, f"Number of runs {runs} (sub-runs) vs {runs_ref}")
+
+    # the source moved: the same edep in each bin (one interval each)
+    tol = 0.1
+    for e, name in [(edep_ref, "runs"), (edep, "sub-runs")]:
+        f = e / e.sum()
+        b = all(abs(x - 0.25) / 0.25 < tol for x in f)
+        utility.print_test(b, f"Fraction of edep per position ({name}) {f}")
+        is_ok = is_ok and b
+
+    # same total edep
+    d = abs(edep.sum() - edep_ref.sum()) / edep_ref.sum()
+    b = d < 0.05
+    utility.print_test(
+        b, f"Total edep {edep.sum():.2f} vs {edep_ref.sum():.2f} MeV ({d:.3f})"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
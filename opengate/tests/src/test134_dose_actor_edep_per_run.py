@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import itk
+import numpy as np
+import opengate as gate
+from opengate.tests import utility
+from opengate.utility import insert_suffix_before_extension
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test134")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 123456
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.second
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 200 * Bq
+
+    # three runs
+    sim.run_timing_intervals = [[0, 1 * sec], [1 * sec, 2 * sec], [2 * sec, 3 * sec]]
+
+    # dose actor, the edep of each run is written in a 4D image
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [40, 40, 50]
+    dose.spacing = [2.5 * mm, 2.5 * mm, 2 * mm]
+    dose.hit_type = "middle"
+    dose.write_edep_per_run = True
+    dose.edep.keep_data_per_run = True
+    dose.output_filename = "test134.mhd"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # each frame must be the edep of the run
+    path = insert_suffix_before_extension(dose.edep.get_output_path(), "per_run")
+    print(f"Read {path}")
+    frames = itk.array_view_from_image(itk.imread(str(path)))
+    print(f"Shape of the 4D image: {frames.shape}")
+    is_ok = frames.shape == (3, 50, 40, 40)
+    utility.print_test(is_ok, f"Number of frames {frames.shape[0]} (expected 3)")
+    for run_index in range(3):
+        edep = itk.array_view_from_image(
+            dose.user_output.edep_with_uncertainty.get_data(run_index, item=0)
+        )
+        b = np.allclose(frames[run_index], edep)
+        utility.print_test(b, f"Frame {run_index} is the edep of run {run_index}")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
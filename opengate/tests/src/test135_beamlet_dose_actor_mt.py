@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import itk
+import numpy as np
+import scipy.sparse
+from scipy.spatial.transform import Rotation
+import opengate as gate
+from opengate.tests import utility
+from opengate.contrib.beamlines.ionbeamline import BeamlineModel
+from opengate.contrib.tps.ionbeamtherapy import spots_info_from_txt
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(
+        __file__, "gate_test044_pbs", output_folder="test135"
+    )
+    output_path = paths.output
+    ref_path = paths.output_ref
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.random_seed = 12365478910
+    sim.number_of_threads = 4
+    sim.output_dir = output_path
+
+    # units
+    km = gate.g4_units.km
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+
+    #  change world size
+    sim.world.size = [600 * cm, 500 * cm, 500 * cm]
+
+    # target
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [100 * mm, 100 * mm, 400 * mm]
+    phantom.rotation = Rotation.from_euler("y", 90, degrees=True).as_matrix()
+    phantom.translation = [-200.0, 0.0, 0]
+    phantom.material = "G4_WATER"
+
+    # physics
+    sim.physics_manager.physics_list_name = "QGSP_BIC_EMZ"
+    sim.physics_manager.set_production_cut("world", "all", 1000 * km)
+
+    # beamlet dose actor: one column per spot
+    beamlet = sim.add_actor("BeamletDoseActor", "beamlet")
+    beamlet.dose.output_filename = "test135_beamlet_dose.mhd"
+    beamlet.beamlet_matrix.output_filename = "test135_beamlet_matrix.npz"
+    beamlet.attached_to = phantom
+    beamlet.size = [20, 20, 40]
+    beamlet.spacing = [5 * mm, 5 * mm, 10 * mm]
+    beamlet.hit_type = "middle"
+
+    # reference dose actor (same grid)
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.output_filename = "test135_dose.mhd"
+    dose.attached_to = phantom
+    dose.size = [20, 20, 40]
+    dose.spacing = [5 * mm, 5 * mm, 10 * mm]
+    dose.hit_type = "middle"
+    dose.dose.active = True
+
+    # beamline model
+    IR2HBL = BeamlineModel()
+    IR2HBL.name = None
+    IR2HBL.radiation_types = "ion 6 12"
+    IR2HBL.distance_nozzle_iso = 1300.00
+    IR2HBL.distance_stearmag_to_isocenter_x = 6700.00
+    IR2HBL.distance_stearmag_to_isocenter_y = 7420.00
+    IR2HBL.energy_mean_coeffs = [11.91893485094217, -9.539517997860457]
+    IR2HBL.energy_spread_coeffs = [0.0004790681841295621, 5.253257865904452]
+    IR2HBL.sigma_x_coeffs = [2.3335753978880014]
+    IR2HBL.theta_x_coeffs = [0.0002944903217664001]
+    IR2HBL.epsilon_x_coeffs = [0.0007872786903040108]
+    IR2HBL.sigma_y_coeffs = [1.9643343053823967]
+    IR2HBL.theta_y_coeffs = [0.0007911780133478402]
+    IR2HBL.epsilon_y_coeffs = [0.0024916149017600447]
+
+    # all spots of the plan in a single simulation
+    nSim = 5000
+    beam_data_dict = spots_info_from_txt(
+        ref_path / "TreatmentPlan4Gate-F5x5cm_E120MeVn.txt", "ion 6 12", beam_nr=1
+    )
+    number_of_spots = len(beam_data_dict["spots"])
+    beamlet.number_of_spots = number_of_spots
+    tps = sim.add_source("TreatmentPlanPBSource", "TPSource")
+    tps.n = nSim / sim.number_of_threads
+    tps.beam_model = IR2HBL
+    tps.beam_data_dict = beam_data_dict
+    tps.beam_nr = 1
+    tps.particle = "ion 6 12"
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # the matrix has one row per voxel and one column per spot
+    matrix = scipy.sparse.load_npz(beamlet.beamlet_matrix.get_output_path())
+    print(f"Matrix shape {matrix.shape}, {matrix.nnz} non zero elements")
+    is_ok = matrix.shape == (20 * 20 * 40, number_of_spots)
+    utility.print_test(is_ok, f"Matrix shape {matrix.shape}")
+
+    # the sum over the spots is the dose of the plan
+    dose_ref = itk.array_view_from_image(itk.imread(dose.get_output_path("dose")))
+    dose_sum = np.asarray(matrix.sum(axis=1)).reshape(dose_ref.shape)
+    b = np.allclose(dose_sum, dose_ref, rtol=1e-6, atol=1e-12 * dose_ref.max())
+    utility.print_test(b, "Sum of the columns is the dose of the DoseActor")
+    is_ok = is_ok and b
+
+    dose_img = itk.array_view_from_image(itk.imread(beamlet.dose.get_output_path()))
+    b = np.allclose(dose_img, dose_ref, rtol=1e-6, atol=1e-12 * dose_ref.max())
+    utility.print_test(b, "Dose image of the BeamletDoseActor")
+    is_ok = is_ok and b
+
+    # each spot deposits in a part of the image only
+    spots_with_dose = np.count_nonzero(np.asarray(matrix.sum(axis=0)))
+    b = spots_with_dose > number_of_spots / 2
+    utility.print_test(b, f"{spots_with_dose} spots out of {number_of_spots} scored")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
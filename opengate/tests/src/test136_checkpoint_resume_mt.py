@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import itk
+import numpy as np
+import opengate as gate
+from opengate.tests import utility
+
+
+def create_simulation(paths, name, checkpoint=False, resume=False):
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 654321
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.second
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 100 * Bq
+
+    # four runs, a checkpoint at the end of each run (except the last one)
+    sim.run_timing_intervals = [[i * sec, (i + 1) * sec] for i in range(4)]
+    if checkpoint:
+        sim.checkpoint_filename = "test136_checkpoint.bin"
+        sim.resume_from_checkpoint = resume
+
+    # dose actor
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [5 * mm, 5 * mm, 2 * mm]
+    dose.hit_type = "middle"
+    dose.edep_uncertainty.active = True
+    dose.output_filename = f"test136_{name}.mhd"
+
+    # add stat actor
+    sim.add_actor("SimulationStatisticsActor", "stats")
+
+    return sim
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test136")
+
+    # reference: the simulation without interruption
+    sim = create_simulation(paths, "ref")
+    sim.run(start_new_process=True)
+    stats_ref = sim.get_actor("stats")
+    edep_ref = sim.get_actor("dose").edep.get_output_path()
+
+    # same simulation, with checkpoints (the last one is before the last run)
+    sim = create_simulation(paths, "checkpoint", checkpoint=True)
+    sim.run(start_new_process=True)
+
+    # resumed from the last checkpoint: only the last run is simulated
+    sim = create_simulation(paths, "resumed", checkpoint=True, resume=True)
+    sim.run(start_new_process=True)
+    stats = sim.get_actor("stats")
+    edep = sim.get_actor("dose").edep.get_output_path()
+    print(stats)
+
+    # the results are the same as the ones without interruption
+    is_ok = True
+    for k in ["runs", "events", "tracks", "steps"]:
+        b = stats.counts[k] == stats_ref.counts[k]
+        utility.print_test(
+            b, f"Number of {k} {stats.counts[k]} vs {stats_ref.counts[k]}"
+        )
+        is_ok = is_ok and b
+
+    a = itk.array_view_from_image(itk.imread(str(edep)))
+    a_ref = itk.array_view_from_image(itk.imread(str(edep_ref)))
+    b = np.allclose(a, a_ref, rtol=1e-9, atol=0)
+    utility.print_test(b, f"Edep of the resumed simulation (total {a.sum()})")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import shutil
+import opengate as gate
+from opengate.tests import utility
+
+
+def create_simulation(paths, cache_dir):
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # physics, the tables are stored in (or retrieved from) the cache
+    sim.physics_manager.physics_list_name = "QGSP_BIC_EMZ"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+    sim.physics_manager.physics_tables_cache_dir = cache_dir
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 10 * MeV
+    source.particle = "gamma"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1000 * Bq
+
+    # add stat actor
+    sim.add_actor("SimulationStatisticsActor", "stats")
+
+    return sim
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test137")
+    cache_dir = paths.output / "physics_tables_cache"
+    shutil.rmtree(cache_dir, ignore_errors=True)
+
+    # first simulation: the tables are built then stored
+    sim = create_simulation(paths, str(cache_dir))
+    sim.run(start_new_process=True)
+    stats_ref = sim.get_actor("stats")
+    print(f"Initialization timings: {sim.initialization_timings}")
+    folders = [f for f in cache_dir.iterdir() if (f / "done").exists()]
+    is_ok = len(folders) == 1
+    utility.print_test(is_ok, f"Physics tables stored in {folders}")
+
+    # second simulation: the tables are retrieved
+    sim = create_simulation(paths, str(cache_dir))
+    sim.run(start_new_process=True)
+    stats = sim.get_actor("stats")
+    print(f"Initialization timings: {sim.initialization_timings}")
+    b = len(list(cache_dir.iterdir())) == 1
+    utility.print_test(b, "The physics tables are not stored again")
+    is_ok = is_ok and b
+
+    # same results
+    for k in ["events", "tracks", "steps"]:
+        b = stats.counts[k] == stats_ref.counts[k]
+        utility.print_test(
+            b, f"Number of {k} {stats.counts[k]} vs {stats_ref.counts[k]}"
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
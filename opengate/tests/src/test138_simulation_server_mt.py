@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import time
+import multiprocessing
+import opengate as gate
+from opengate.tests import utility
+from opengate.server import SimulationServer, SimulationClient
+
+authkey = b"test138"
+
+
+def create_simulation(output):
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 123654
+    sim.output_dir = output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source (the number of events is per thread)
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 50
+
+    # dose actor
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [5 * mm, 5 * mm, 2 * mm]
+    dose.output_filename = "test138_job.mhd"
+
+    # add stat actor
+    sim.add_actor("SimulationStatisticsActor", "stats")
+
+    return sim
+
+
+def serve(address, output):
+    sim = create_simulation(output)
+    server = SimulationServer(sim, address, authkey)
+    server.serve()
+
+
+def connect(address, timeout=300):
+    # wait for the server to be initialized
+    start = time.time()
+    while True:
+        try:
+            return SimulationClient(address, authkey)
+        except (FileNotFoundError, ConnectionRefusedError):
+            if time.time() - start > timeout:
+                raise
+            time.sleep(0.5)
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test138")
+    paths.output.mkdir(parents=True, exist_ok=True)
+    address = str(paths.output / "test138.socket")
+    if (paths.output / "test138.socket").exists():
+        (paths.output / "test138.socket").unlink()
+
+    # the server is initialized once, in another process
+    ctx = multiprocessing.get_context("spawn")
+    p = ctx.Process(target=serve, args=(address, paths.output))
+    p.start()
+
+    # several jobs, with different sources and outputs
+    MeV = gate.g4_units.MeV
+    sec = gate.g4_units.second
+    jobs = [
+        {
+            "sources": {"mysource": {"n": 100}},
+            "actors": {"dose": {"output_filename": "test138_job1.mhd"}},
+        },
+        {
+            "sources": {"mysource": {"n": 200, "energy.mono": 100 * MeV}},
+            "actors": {"dose": {"output_filename": "test138_job2.mhd"}},
+            "run_timing_intervals": [[0, 1 * sec], [1 * sec, 2 * sec]],
+            "random_seed": 987,
+        },
+    ]
+    expected = [(1, 2 * 100), (2, 2 * 2 * 200)]
+    is_ok = True
+    with connect(address) as client:
+        for i, job in enumerate(jobs):
+            result = client.run(job)
+            counts = result["counts"]["stats"]
+            print(f"Job {i + 1}: {result['duration']:.2f} s, {counts}")
+            runs, events = expected[i]
+            b = counts["runs"] == runs and counts["events"] == events
+            utility.print_test(
+                b, f"Job {i + 1}: runs {counts['runs']} events {counts['events']}"
+            )
+            is_ok = is_ok and b
+            f = list(paths.output.glob(f"test138_job{i + 1}*.mhd"))
+            b = len(f) > 0
+            utility.print_test(b, f"Job {i + 1}: outputs {f}")
+            is_ok = is_ok and b
+        client.stop_server()
+    p.join()
+
+    utility.test_ok(is_ok and p.exitcode == 0)
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import json
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test140")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 123456
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 500 * Bq
+
+    # dose actor
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [5 * mm, 5 * mm, 2 * mm]
+    dose.output_filename = "test140.mhd"
+
+    # stat actor, with the timing of the actors (one call every 10 is timed)
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.profile_actors = True
+    stats.profile_sampling_interval = 10
+    stats.output_filename = "test140_stats.json"
+    stats.write_to_disk = True
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # one call of GeneratePrimaries per event
+    profile = stats.counts.profile
+    n = profile["mysource"]["GeneratePrimaries"]["calls"]
+    is_ok = n == stats.counts.events
+    utility.print_test(is_ok, f"GeneratePrimaries calls {n} (events)")
+
+    # the dose actor is called for the steps in the waterbox
+    p = profile["dose"]["SteppingAction"]
+    b = 0 < p["calls"] <= stats.counts.steps and p["time"] > 0
+    utility.print_test(b, f"Dose actor: {p['calls']} steps, {p['time']} ns")
+    is_ok = is_ok and b
+
+    # the profile is also in the json file
+    path = paths.output / "test140_stats.json"
+    with open(path) as f:
+        s = json.load(f)
+    b = "dose" in s["profile"]["value"]
+    utility.print_test(b, f"Profile in {path}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test141")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 500 * Bq
+
+    # two runs: the counts of the threads are merged at the end of each run
+    sec = gate.g4_units.s
+    sim.run_timing_intervals = [[0, 0.5 * sec], [0.5 * sec, 1 * sec]]
+
+    # stat actor, steps per (volume, particle, process), one step every 10 timed
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.track_types_flag = True
+    stats.step_types_flag = True
+    stats.step_types_time_sampling = 10
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # all the steps are counted once
+    step_types = stats.counts.step_types
+    n = 0
+    sampled = 0
+    for particles in step_types.values():
+        for processes in particles.values():
+            for c in processes.values():
+                n += c["steps"]
+                sampled += c["sampled_steps"]
+    is_ok = n == stats.counts.steps
+    utility.print_test(is_ok, f"Steps in step_types {n} vs {stats.counts.steps}")
+
+    # about one step every 10 is timed
+    b = 0.05 < sampled / n < 0.15
+    utility.print_test(b, f"Timed steps {sampled} / {n}")
+    is_ok = is_ok and b
+
+    # the protons of the source enter the waterbox from the world
+    c = step_types["world"]["proton"]["Transportation"]
+    b = c["steps"] >= stats.counts.events and c["time"] > 0
+    utility.print_test(b, f"Proton transportation in the world {c}")
+    is_ok = is_ok and b
+
+    # the particles of the step_types are the ones of the track_types
+    for volume, particles in step_types.items():
+        for particle in particles:
+            b = particle in stats.counts.track_types
+            utility.print_test(b, f"{particle} in {volume} is a track type")
+            is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+import opengate_core as g4
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test142")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 4
+    sim.random_seed = 987654
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 500 * Bq
+
+    # dose actor, the pixels are written under a mutex
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [5 * mm, 5 * mm, 2 * mm]
+    dose.scoring_mode = "mutex"
+    dose.output_filename = "test142.mhd"
+
+    # stat actor (its counts are merged under a mutex at the end of run)
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # start simulation
+    sim.run(start_new_process=True)
+    print(stats)
+
+    # without OPENGATE_MUTEX_STATISTICS, there is no statistics
+    if not g4.IsMutexStatisticsEnabled():
+        is_ok = sim.mutex_statistics == {}
+        utility.print_test(is_ok, "opengate_core without mutex statistics")
+        utility.test_ok(is_ok)
+
+    # the statistics actor locks its mutex at the start and end of each run
+    s = sim.mutex_statistics["GateSimulationStatisticsActorMutex"]
+    n = sum(t["acquisitions"] for t in s.values())
+    is_ok = n >= 2 * sim.number_of_threads
+    utility.print_test(is_ok, f"Statistics actor mutex: {n} acquisitions")
+
+    # the pixels of the dose are locked at most once per step in the box
+    s = sim.mutex_statistics["SetPixelMutex"]
+    n = sum(t["acquisitions"] for t in s.values())
+    c = sum(t["contended"] for t in s.values())
+    b = len(s) == sim.number_of_threads and 0 < n <= stats.counts.steps and c <= n
+    utility.print_test(
+        b, f"Dose mutex: {len(s)} threads, {n} acquisitions, {c} contended"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
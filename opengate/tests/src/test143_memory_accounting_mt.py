@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test143")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 654987
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1000 * Bq
+    sim.run_timing_intervals = [[0, 1 * sec]]
+
+    # dose actor with uncertainty: per-thread squared buffers
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [50, 50, 50]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.edep_uncertainty.active = True
+
+    # hits, flushed every 100 events
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = waterbox
+    hc.attributes = ["TotalEnergyDeposit", "PostPosition"]
+    hc.clear_every = 100
+    hc.root_output.write_to_disk = False
+
+    # stat actor with the memory of the components
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.memory_flag = True
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    memory = stats.counts.memory
+    n = 50**3
+    is_ok = True
+
+    # shared images: at least edep and edep squared
+    m = memory["dose_images"]["dose"]
+    b = m["current"] >= 2 * n * 8 and m["peak"] >= m["current"]
+    utility.print_test(b, f"Dose images {m['current']} bytes")
+    is_ok = is_ok and b
+
+    # per-thread buffers: at least the squared values and the last event ids
+    m = memory["dose_buffers"]["dose"]
+    b = len(m["threads"]) == sim.number_of_threads
+    for t in m["threads"].values():
+        b = b and t["peak"] >= n * (8 + 4)
+    utility.print_test(b, f"Dose per-thread buffers {m['threads']}")
+    is_ok = is_ok and b
+
+    # digi collection: capacity of the values of each thread (never shrunk)
+    m = memory["digi_collection"]["hits"]
+    total = sum(t["current"] for t in m["threads"].values())
+    b = len(m["threads"]) == sim.number_of_threads and m["current"] == total
+    b = b and m["peak"] >= m["current"] > 0
+    utility.print_test(b, f"Digi collection {m}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+import opengate_core as g4
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test144")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 321987
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1000 * Bq
+
+    # dose actor
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [5 * mm, 5 * mm, 2 * mm]
+    dose.output_filename = "test144.mhd"
+
+    # stat actor with the hardware counters
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.perf_counters_flag = True
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # without OPENGATE_PERF_COUNTERS (or if the system does not allow to read
+    # the counters, see perf_event_paranoid), there are no values
+    counters = stats.counts.perf_counters
+    if not g4.IsPerfCountersAvailable() or len(counters) == 0:
+        utility.print_test(True, "No hardware performance counters")
+        utility.test_ok(True)
+
+    # init and output phases: master thread, tracking: each thread
+    is_ok = True
+    for phase, n in [("init", 1), ("tracking", sim.number_of_threads)]:
+        threads = counters[phase]
+        b = len(threads) == n
+        for c in threads.values():
+            b = b and c["instructions"] > 0 and c["cycles"] > 0
+            b = b and c["ipc"] > 0 and c["time"] > 0
+        utility.print_test(b, f"Phase {phase}: {threads}")
+        is_ok = is_ok and b
+    b = -1 in counters["init"] and -1 in counters["output"]
+    utility.print_test(b, f"Phase output: {counters['output']}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import json
+import opengate as gate
+from opengate.tests import utility
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test145")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 147258
+    sim.output_dir = paths.output
+    sim.timeline_filename = "timeline.json"
+    sim.timeline_events_per_chunk = 100
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1000 * Bq
+    sim.run_timing_intervals = [[0, 0.5 * sec], [0.5 * sec, 1 * sec]]
+
+    # hits, flushed every 100 events
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = waterbox
+    hc.attributes = ["TotalEnergyDeposit", "PostPosition"]
+    hc.clear_every = 100
+    hc.root_output.write_to_disk = False
+
+    # stats
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # read the trace
+    with open(sim.get_output_path(sim.timeline_filename)) as f:
+        trace = json.load(f)["traceEvents"]
+    names = {e["tid"]: e["args"]["name"] for e in trace if e["ph"] == "M"}
+    print(f"Threads: {names}")
+
+    def markers(thread, name, phase):
+        tids = [t for t, n in names.items() if n == thread]
+        return [
+            e
+            for e in trace
+            if e["tid"] in tids and e["name"] == name and e["ph"] == phase
+        ]
+
+    # one track per worker, and the master
+    workers = [n for n in names.values() if n.startswith("worker")]
+    is_ok = len(workers) == sim.number_of_threads and "master" in names.values()
+    utility.print_test(is_ok, f"Tracks: {sorted(names.values())}")
+
+    # each worker: both runs, and chunks of events
+    for w in workers:
+        runs = markers(w, "run", "B")
+        b = len(runs) == 2 and len(markers(w, "run", "E")) == 2
+        n = len(markers(w, "events", "B"))
+        b = b and n >= 2 and n == len(markers(w, "events", "E"))
+        flush = len(markers(w, "hits", "B"))
+        b = b and flush >= 2
+        utility.print_test(b, f"{w}: {len(runs)} runs, {n} chunks, {flush} flushes")
+        is_ok = is_ok and b
+
+    # master thread hooks of the actors
+    b = len(markers("master", "stats", "B")) >= 2
+    b = b and len(markers("master", "runs", "E")) == 1
+    utility.print_test(b, "Master thread hooks")
+    is_ok = is_ok and b
+
+    # the markers of a thread are sorted in time
+    for t in names:
+        ts = [e["ts"] for e in trace if e["tid"] == t and e["ph"] != "M"]
+        b = ts == sorted(ts)
+        is_ok = is_ok and b
+    utility.print_test(is_ok, "Sorted markers")
+
+    utility.test_ok(is_ok)
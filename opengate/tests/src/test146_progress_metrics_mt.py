@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import json
+import opengate as gate
+from opengate.tests import utility
+
+
+def create_simulation(paths, progress_filename):
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 963852
+    sim.output_dir = paths.output
+    sim.progress_filename = progress_filename
+    sim.progress_interval = 0.1
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    #  change world size
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # source
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1000 * Bq
+    sim.run_timing_intervals = [[0, 0.5 * sec], [0.5 * sec, 1 * sec]]
+
+    # stats (all the steps)
+    sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test146")
+
+    # json file
+    sim = create_simulation(paths, "progress.json")
+    sim.run(start_new_process=True)
+    stats = sim.get_actor("stats")
+    print(stats)
+    with open(sim.get_output_path("progress.json")) as f:
+        progress = json.load(f)
+    print(json.dumps(progress, indent=4))
+
+    # the last report is written when the simulation is done
+    is_ok = progress["done"] and progress["run"] == 1
+    b = progress["events"] == stats.counts.events
+    b = b and progress["tracks"] == stats.counts.tracks
+    b = b and progress["steps"] == stats.counts.steps
+    utility.print_test(
+        b, f"Events, tracks and steps: {progress['steps']} {stats.counts.steps}"
+    )
+    is_ok = is_ok and b
+
+    # one entry per thread that simulated events
+    threads = [t["thread"] for t in progress["threads"]]
+    b = sorted(threads) == list(range(sim.number_of_threads))
+    b = b and progress["uncertainty"] == -1 and progress["output_bytes"] == 0
+    utility.print_test(b, f"Threads {threads}")
+    is_ok = is_ok and b
+
+    # Prometheus text format
+    sim = create_simulation(paths, "progress.prom")
+    sim.run()
+    with open(sim.get_output_path("progress.prom")) as f:
+        lines = [l for l in f.read().splitlines() if not l.startswith("#")]
+    metrics = {l.split(" ")[0]: float(l.split(" ")[1]) for l in lines}
+    print(metrics)
+    stats = sim.get_actor("stats")
+    b = metrics["opengate_events_total"] == stats.counts.events
+    b = b and metrics["opengate_steps_total"] == stats.counts.steps
+    b = b and metrics["opengate_done"] == 1
+    b = b and 'opengate_steps_per_second{thread="0"}' in metrics
+    utility.print_test(b, "Prometheus metrics")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import itk
+
+
+def create_simulation(paths, threads, n):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = threads
+    sim.random_engine = "Philox"
+    sim.random_seed = 987321
+    sim.output_dir = paths.output
+    sim.event_scheduling = "guided"
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+    world.material = "G4_AIR"
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    # n events per thread: the same total with 2 and 3 threads
+    source = sim.add_source("GenericSource", "protons")
+    source.particle = "proton"
+    source.energy.type = "gauss"
+    source.energy.mono = 120 * MeV
+    source.energy.sigma_gauss = 1 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = n
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [1, 1, 100]
+    dose.spacing = [20 * cm, 20 * cm, 2 * mm]
+    dose.output_filename = f"test147_{threads}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.track_types_flag = True
+    return sim, dose, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test147")
+
+    # shortcuts to units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    total = 1200
+    sim2, dose2, stats2 = create_simulation(paths, 2, total // 2)
+    sim2.run(start_new_process=True)
+    print(stats2)
+    sim3, dose3, stats3 = create_simulation(paths, 3, total // 3)
+    sim3.run()
+    print(stats3)
+
+    # the same events, so the same secondaries, whatever the number of threads
+    # (a thread without any event left generates one empty event)
+    is_ok = True
+    b = stats2.counts.tracks == stats3.counts.tracks
+    b = b and stats2.counts.steps == stats3.counts.steps
+    utility.print_test(
+        b,
+        f"Same tracks and steps: {stats2.counts.tracks} {stats2.counts.steps} "
+        f"vs {stats3.counts.tracks} {stats3.counts.steps}",
+    )
+    is_ok = is_ok and b
+    b = stats2.counts.track_types == stats3.counts.track_types
+    utility.print_test(b, f"Same track types: {stats3.counts.track_types}")
+    is_ok = is_ok and b
+
+    # same depth dose, up to the order of the sums
+    ref = itk.array_from_image(itk.imread(dose2.edep.get_output_path()))
+    data = itk.array_from_image(itk.imread(dose3.edep.get_output_path()))
+    b = ref.sum() > 0 and np.allclose(ref, data, rtol=1e-9, atol=0)
+    utility.print_test(b, f"Same edep: {ref.sum()} vs {data.sum()}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(paths, aa_flag):
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 1
+    sim.random_seed = 123654
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1.5 * m, 1.5 * m, 1.5 * m]
+    world.material = "G4_AIR"
+
+    # a short ring of detection: most of the pairs never reach it
+    detector = sim.add_volume("Tubs", "detector")
+    detector.rmin = 30 * cm
+    detector.rmax = 32 * cm
+    detector.dz = 3 * cm
+    detector.material = "G4_AIR"
+
+    # positions in a small sphere at the center
+    rs = gate.utility.get_rnd_seed(123654)
+
+    def gen_cond(n):
+        u = rs.normal(size=(n, 3))
+        u = u / np.linalg.norm(u, axis=1)[:, None]
+        r = 30 * mm * np.cbrt(rs.uniform(size=(n, 1)))
+        return u * r
+
+    gsource = sim.add_source("GANPairsSource", "gaga")
+    gsource.particle = "gamma"
+    gsource.activity = 2e4 * Bq
+    gsource.pth_filename = paths.data / "test9221_GP_0GP_10.0_100000.pth"
+    gsource.position_keys = ["X1", "Y1", "Z1", "X2", "Y2", "Z2"]
+    gsource.direction_keys = ["dX1", "dY1", "dZ1", "dX2", "dY2", "dZ2"]
+    gsource.energy_key = ["E1", "E2"]
+    gsource.time_key = ["t1", "t2"]
+    gsource.relative_timing = True
+    gsource.weight_key = None
+    gsource.backward_distance = 10 * cm
+    gsource.backward_force = True
+    gsource.energy_min_threshold = 0.1 * keV
+    gsource.energy_max_threshold = 1 * MeV
+    gsource.skip_policy = "ZeroEnergy"
+    gsource.batch_size = 5e4
+    gsource.generator = gate.sources.gansources.GANSourceConditionalPairsGenerator(
+        gsource, 210 * mm, gen_cond
+    )
+    gsource.gpu_mode = utility.get_gpu_mode_for_tests()
+    if aa_flag:
+        gsource.direction.acceptance_angle.volumes = [detector.name]
+        gsource.direction.acceptance_angle.intersection_flag = True
+        gsource.direction.acceptance_angle.skip_policy = "SkipEvents"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = detector
+    phsp.attributes = ["KineticEnergy", "EventID"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = f"test148_phsp_{int(aa_flag)}.root"
+    f = sim.add_filter("KineticEnergyFilter", "f")
+    f.energy_min = 500 * keV
+    phsp.filters.append(f)
+
+    sim.run_timing_intervals = [[0, 1 * sec]]
+    return sim, gsource, stats, phsp
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "", "test148")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.second
+
+    # reference: all the pairs are tracked
+    sim_ref, _, stats_ref, phsp_ref = create_simulation(paths, False)
+    sim_ref.run(start_new_process=True)
+    print(stats_ref)
+
+    # acceptance angle: only the pairs with both photons toward the ring
+    sim, gsource, stats, phsp = create_simulation(paths, True)
+    sim.run()
+    print(stats)
+    s = sim.source_manager.get_source("gaga")
+    skipped = s.GetTotalSkippedEvents()
+    print(f"Skipped pairs: {skipped}")
+
+    # the skipped pairs are counted in the time: same number of pairs
+    is_ok = True
+    n_ref = stats_ref.counts.events
+    n = stats.counts.events + skipped
+    b = skipped > 0 and abs(n - n_ref) / n_ref < 0.05
+    utility.print_test(
+        b, f"Number of pairs {n} vs {n_ref} (tracked {stats.counts.events})"
+    )
+    is_ok = is_ok and b
+
+    # most of the tracking is saved
+    b = stats.counts.tracks < stats_ref.counts.tracks / 2
+    utility.print_test(b, f"Tracks {stats.counts.tracks} vs {stats_ref.counts.tracks}")
+    is_ok = is_ok and b
+
+    # same number of coincidences (both photons in the ring)
+    def coincidences(actor):
+        ids = uproot.open(actor.get_output_path())["phsp"]["EventID"].array(
+            library="np"
+        )
+        _, counts = np.unique(ids, return_counts=True)
+        return np.count_nonzero(counts >= 2)
+
+    ref = coincidences(phsp_ref)
+    data = coincidences(phsp)
+    d = abs(data - ref) / ref if ref > 0 else 1
+    b = ref > 0 and d < 0.1
+    utility.print_test(b, f"Coincidences {data} vs {ref} ({d * 100:.1f}%)")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.sources.base import get_positron_range_kernel
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test149")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    deg = gate.g4_units.deg
+    g_cm3 = gate.g4_units.g / gate.g4_units.cm3
+
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 963852
+    sim.output_dir = paths.output
+
+    # vacuum: the photons are not scattered
+    sim.world.size = [2 * m, 2 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+    shell = sim.add_volume("Sphere", "shell")
+    shell.rmin = 50 * cm
+    shell.rmax = 51 * cm
+    shell.material = "G4_Galactic"
+
+    # point source of F18 in water, by batch
+    source = sim.add_source("GenericSource", "b2b")
+    source.particle = "back_to_back"
+    source.n = 20000
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.direction.accolinearity_flag = True
+    source.positron_range.isotope = "F18"
+    source.positron_range.material = "G4_WATER"
+    source.batch_size = 1000
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = shell
+    phsp.attributes = ["EventID", "EventPosition", "PreDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test149.root"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.run()
+    print(stats)
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    is_ok = True
+
+    # positron range: mean distance of the annihilation points
+    r = np.sqrt(
+        data["EventPosition_X"] ** 2
+        + data["EventPosition_Y"] ** 2
+        + data["EventPosition_Z"] ** 2
+    )
+    p1, k1, k2 = get_positron_range_kernel("F18", 1.0 * g_cm3)
+    expected = p1 * 2 / k1 + (1 - p1) * 2 / k2
+    d = abs(r.mean() - expected) / expected
+    b = d < 0.05
+    utility.print_test(
+        b,
+        f"Positron range: mean {r.mean() / mm:.3f} mm vs {expected / mm:.3f} mm "
+        f"({d * 100:.1f}%)",
+    )
+    is_ok = is_ok and b
+
+    # accolinearity: the deviation is a 2D gaussian (Rayleigh amplitude)
+    order = np.argsort(data["EventID"], kind="stable")
+    ids = data["EventID"][order]
+    dirs = np.column_stack(
+        [data[f"PreDirection_{k}"][order] for k in ("X", "Y", "Z")]
+    )
+    pairs = np.flatnonzero(ids[:-1] == ids[1:])
+    cos = -np.sum(dirs[pairs] * dirs[pairs + 1], axis=1)
+    angles = np.arccos(np.clip(cos, -1, 1))
+    sigma = source.direction.accolinearity_fwhm / 2.355
+    expected = sigma * np.sqrt(np.pi / 2)
+    d = abs(angles.mean() - expected) / expected
+    b = len(pairs) > 0.9 * source.n and d < 0.05
+    utility.print_test(
+        b,
+        f"Accolinearity: {len(pairs)} pairs, mean {angles.mean() / deg:.4f} deg "
+        f"vs {expected / deg:.4f} deg ({d * 100:.1f}%)",
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+import math
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test150")
+
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    um = gate.g4_units.um
+    mrad = gate.g4_units.mrad
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 147258
+    sim.output_dir = paths.output
+
+    # vacuum, the phase space is recorded just after the source
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [500 * mm, 500 * mm, 1 * um]
+    plane.translation = [0, 0, 1 * um]
+    plane.material = "G4_Galactic"
+
+    # divergent beam, correlated position and angle
+    sigma = 2 * mm
+    theta = 3 * mrad
+    epsilon = 0.5 * math.pi * sigma * theta
+    source = sim.add_source("IonPencilBeamSource", "pbs")
+    source.particle = "proton"
+    source.energy.mono = 100 * MeV
+    source.direction.partPhSp_x = [sigma, theta, epsilon, 0]
+    source.direction.partPhSp_y = [sigma, theta, epsilon, 0]
+    source.n = 20000
+    source.batch_size = 1000
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.attributes = ["PrePosition", "PreDirection"]
+    phsp.steps_to_store = "first"
+    phsp.output_filename = "test150.root"
+
+    sim.run()
+
+    data = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+
+    # expected: var(x) = sigma^2, var(angle) = theta^2 and the correlation
+    # sqrt(1 - (eps / (sigma theta))^2), positive when divergent
+    eps = epsilon / math.pi
+    expected_corr = math.sqrt(1 - (eps / (sigma * theta)) ** 2)
+    is_ok = True
+    for axis in ("X", "Y"):
+        x = data[f"PrePosition_{axis}"]
+        angle = np.arctan(data[f"PreDirection_{axis}"] / data["PreDirection_Z"])
+        corr = np.corrcoef(x, angle)[0, 1]
+        b = (
+            len(x) == source.n
+            and abs(np.std(x) / sigma - 1) < 0.03
+            and abs(np.std(angle) / theta - 1) < 0.03
+            and abs(corr - expected_corr) < 0.02
+        )
+        utility.print_test(
+            b,
+            f"{axis}: sigma {np.std(x) / mm:.3f} mm vs {sigma / mm:.3f} mm, "
+            f"theta {np.std(angle) / mrad:.3f} mrad vs {theta / mrad:.3f} mrad, "
+            f"correlation {corr:.3f} vs {expected_corr:.3f}",
+        )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
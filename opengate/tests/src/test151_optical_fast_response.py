@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+
+
+def create_simulation(paths, mode, n):
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    eV = gate.g4_units.eV
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+    sim.volume_manager.add_material_database(paths.data / "GateMaterials.db")
+
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # LYSO crystal read on its +z face by a photosensor (absorbing the photons)
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [3 * mm, 3 * mm, 10 * mm]
+    crystal.material = "LYSO"
+    sipm = sim.add_volume("Box", "sipm")
+    sipm.size = [3 * mm, 3 * mm, 0.5 * mm]
+    sipm.translation = [0, 0, 5.25 * mm]
+    sipm.material = "G4_Si"
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.energy_range_min = 10 * eV
+    sim.physics_manager.energy_range_max = 1 * MeV
+    sim.physics_manager.special_physics_constructors.G4OpticalPhysics = True
+
+    # electrons uniform in the crystal (local deposits)
+    source = sim.add_source("GenericSource", "electrons")
+    source.particle = "e-"
+    source.energy.mono = 100 * keV
+    source.position.type = "box"
+    source.position.size = crystal.size
+    source.direction.type = "iso"
+    source.n = n
+
+    lut = sim.add_actor("OpticalFastResponseActor", "lut")
+    lut.attached_to = crystal
+    lut.mode = mode
+    lut.detector_volumes = [sipm.name]
+    lut.bins = [3, 3, 10]
+    lut.number_of_times = 2
+    lut.lookup_table_filename = "test151_lut.npz"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim, lut, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "", output_folder="test151")
+
+    # calibration: all the optical photons are tracked
+    n_calibration = 200
+    sim, lut, stats = create_simulation(paths, "calibration", n_calibration)
+    sim.run(start_new_process=True)
+
+    table = np.load(lut.lookup_table_path)
+    created = table["created"].sum() / n_calibration
+    detected = table["detected"].sum() / n_calibration
+    print(f"Calibration: {created:.1f} photons created per event")
+    print(f"Calibration: {detected:.1f} photons detected per event")
+
+    # fast: no optical photons
+    n_fast = 2000
+    sim, lut, stats = create_simulation(paths, "fast", n_fast)
+    sim.run()
+    print(stats)
+
+    r = lut.results
+    fast = r.photons.sum() / n_fast
+    d = abs(fast - detected) / detected
+    is_ok = d < 0.05
+    utility.print_test(
+        is_ok,
+        f"Fast: {fast:.1f} photons detected per event vs {detected:.1f} "
+        f"({d * 100:.1f}%)",
+    )
+
+    # no optical photon is tracked, the times are sorted
+    b = stats.counts.tracks < 100 * n_fast
+    b = b and np.all(r.times[:, 0] > 0)
+    b = b and np.all((r.times[:, 1] >= r.times[:, 0]) | (r.times[:, 1] < 0))
+    utility.print_test(
+        b, f"Fast: {stats.counts.tracks} tracks, first times {r.times[:3, 0]}"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
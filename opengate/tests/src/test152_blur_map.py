@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test152")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    ns = gate.g4_units.ns
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # 4 repeated crystals (copy number 0 to 3)
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [5 * cm, 20 * cm, 2 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+    crystal.translation = gate.geometry.utility.get_grid_repetition(
+        [4, 1, 1], [5 * cm, 0, 0], start=[-7.5 * cm, 0, 10 * cm]
+    )
+
+    # gammas toward the crystals
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 511 * keV
+    source.position.type = "box"
+    source.position.size = [20 * cm, 10 * cm, 1 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 20000 * Bq
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits and singles
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.output_filename = "test152.root"
+    hc.attributes = [
+        "EventID",
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "GlobalTime",
+        "PreStepUniqueVolumeID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.input_digi_collection = hc.name
+    sc.output_filename = hc.output_filename
+
+    # time resolution per crystal
+    sigmas = np.array([0, 1, 2, 4]) * ns
+    bc = sim.add_actor("DigitizerBlurringActor", "time_blur")
+    bc.input_digi_collection = sc.name
+    bc.output_filename = hc.output_filename
+    bc.blur_attribute = "GlobalTime"
+    bc.blur_method = "Gaussian"
+    bc.blur_map = sigmas
+    bc.blur_map_volume = crystal.name
+
+    sim.run()
+    print(stats)
+
+    # one thread: the blurred singles are in the same order as the singles
+    root_file = uproot.open(bc.get_output_path())
+    singles = root_file[sc.name].arrays(library="np")
+    out = root_file[bc.name].arrays(library="np")
+    crystals = np.array(
+        [int(i.split("_")[-1]) for i in singles["PreStepUniqueVolumeID"]]
+    )
+    diff = out["GlobalTime"] - singles["GlobalTime"]
+
+    is_ok = len(diff) > 0
+    for c, sigma in enumerate(sigmas):
+        d = diff[crystals == c]
+        if sigma == 0:
+            b = len(d) > 0 and np.all(d == 0)
+            utility.print_test(b, f"Crystal {c}: {len(d)} singles, not blurred")
+        else:
+            s = np.std(d)
+            b = len(d) > 100 and abs(s - sigma) / sigma < 0.1
+            utility.print_test(
+                b,
+                f"Crystal {c}: {len(d)} singles, sigma {s / ns:.3f} ns "
+                f"(expected {sigma / ns:.3f} ns)",
+            )
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
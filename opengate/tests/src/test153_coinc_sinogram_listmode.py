@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+
+if __name__ == "__main__":
+    sim = gate.Simulation()
+
+    # units
+    mm = gate.g4_units.mm
+    sec = gate.g4_units.s
+    ns = gate.g4_units.ns
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+    gcm3 = gate.g4_units.g / gate.g4_units.cm3
+    deg = gate.g4_units.deg
+
+    # folders
+    paths = utility.get_default_test_paths(__file__, output_folder="test153")
+
+    # options
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [450 * mm, 450 * mm, 70 * mm]
+    sim.world.material = "G4_AIR"
+
+    # create the material
+    sim.volume_manager.material_database.add_material_weights(
+        "LYSO",
+        ["Lu", "Y", "Si", "O"],
+        [0.31101534, 0.368765605, 0.083209699, 0.237009356],
+        5.37 * gcm3,
+    )
+
+    # ring volume
+    pet = sim.add_volume("Tubs", "pet")
+    pet.rmax = 200 * mm
+    pet.rmin = 127 * mm
+    pet.dz = 32 * mm
+    pet.material = "G4_AIR"
+
+    # one ring of 80 blocks
+    n = 80
+    block = sim.add_volume("Box", "block")
+    block.mother = pet
+    block.size = [60 * mm, 10 * mm, 10 * mm]
+    translations_ring, rotations_ring = gate.geometry.utility.get_circular_repetition(
+        n, [160 * mm, 0.0 * mm, 0], start_angle_deg=180, axis=[0, 0, 1]
+    )
+    block.translation = translations_ring
+    block.rotation = rotations_ring
+    block.material = "G4_AIR"
+
+    # Crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.mother = block
+    crystal.size = [60 * mm, 10 * mm, 10 * mm]
+    crystal.material = "LYSO"
+
+    # source at the center: the LOR are through the axis
+    source = sim.add_source("GenericSource", "b2b")
+    source.particle = "back_to_back"
+    source.activity = 200 * Bq / sim.number_of_threads
+    source.position.type = "point"
+    source.energy.mono = 511 * keV
+    source.direction.theta = [90 * deg, 90 * deg]
+    source.direction.phi = [0, 360 * deg]
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+
+    # actors
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "Hits")
+    hc.attached_to = crystal
+    hc.authorize_repeated_volumes = True
+    hc.attributes = [
+        "EventID",
+        "PostPosition",
+        "TotalEnergyDeposit",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+    ]
+    hc.output_filename = ""
+
+    sc = sim.add_actor("DigitizerAdderActor", "Singles")
+    sc.attached_to = hc.attached_to
+    sc.authorize_repeated_volumes = True
+    sc.input_digi_collection = hc.name
+    sc.policy = "EnergyWinnerPosition"
+    sc.output_filename = ""
+
+    # coincidences binned during the sorting, not stored
+    cc = sim.add_actor("DigitizerCoincidenceSorterActor", "Coincidences")
+    cc.input_digi_collection = sc.name
+    cc.window = 3 * ns
+    cc.keep_coincidences = False
+    cc.output_filename = ""
+    cc.lor_table = {
+        "crystal_index": [(block.name, 1)],
+        "ring": np.zeros(n, dtype=int),
+        "position": np.arange(n),
+    }
+    cc.sinogram = "2D"
+    cc.sinogram_filename = "test153_sinogram.npy"
+    cc.listmode_filename = "test153.lm"
+
+    sim.run_timing_intervals = [[0, 20 * sec]]
+    sim.run()
+    print(stats)
+
+    # sinogram: 1 slice, n / 2 views, n - 1 radial bins
+    sino = np.load(paths.output / cc.sinogram_filename)
+    nc = cc.number_of_coincidences
+    print(f"Coincidences {nc}, skipped LOR {cc.number_of_skipped_lors}")
+    b = sino.shape == (1, n // 2, n - 1)
+    utility.print_test(b, f"Sinogram shape {sino.shape}")
+    is_ok = b
+    b = nc > 0 and sino.sum() + cc.number_of_skipped_lors == nc
+    utility.print_test(b, f"Counts in the sinogram {sino.sum()} / {nc}")
+    is_ok = is_ok and b
+    f = sino[:, :, n // 2 - 1].sum() / sino.sum()
+    b = f > 0.8
+    utility.print_test(b, f"Fraction of the LOR through the axis {f:.3f}")
+    is_ok = is_ok and b
+
+    # listmode: one record per coincidence
+    lm = cc.read_listmode(paths.output / cc.listmode_filename)
+    b = len(lm) == nc
+    utility.print_test(b, f"Listmode records {len(lm)} / {nc}")
+    is_ok = is_ok and b
+    b = np.all(lm["dt"] >= 0) and np.all(lm["dt"] <= 3)
+    b = b and np.all(lm["crystal1"] != lm["crystal2"])
+    utility.print_test(b, "Time difference in [0, window], different crystals")
+    is_ok = is_ok and b
+    opposite = np.abs(lm["crystal1"] - lm["crystal2"]) == n // 2
+    f2 = np.mean(opposite)
+    b = abs(f2 - f) < 0.05
+    utility.print_test(b, f"Fraction of opposite crystals {f2:.3f}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import itk
+
+
+def create_simulation(paths, windows):
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 852963
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water phantom (scatter)
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [20 * cm, 20 * cm, 10 * cm]
+    phantom.material = "G4_WATER"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [30 * cm, 30 * cm, 1 * cm]
+    crystal.translation = [0, 0, 15 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # Tc99m gammas in the phantom
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 140.5 * keV
+    source.position.type = "sphere"
+    source.position.radius = 3 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 2e4 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits, singles, energy windows and projection
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.attributes = ["PostPosition", "TotalEnergyDeposit", "GlobalTime"]
+    hc.root_output.write_to_disk = False
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.input_digi_collection = hc.name
+    sc.policy = "EnergyWinnerPosition"
+    sc.root_output.write_to_disk = False
+    channels = [
+        {"name": "scatter", "min": 108.578 * keV, "max": 129.057 * keV},
+        {"name": "peak140", "min": 129.057 * keV, "max": 149.536 * keV},
+        {"name": "all", "min": 0 * keV, "max": 200 * keV},
+    ]
+    inputs = [sc.name]
+    name = "windows"
+    if not windows:
+        ew = sim.add_actor("DigitizerEnergyWindowsActor", "ew")
+        ew.attached_to = crystal
+        ew.input_digi_collection = sc.name
+        ew.channels = channels
+        ew.root_output.write_to_disk = False
+        inputs = [c["name"] for c in channels]
+        name = "channels"
+    proj = sim.add_actor("DigitizerProjectionActor", "projection")
+    proj.attached_to = crystal
+    proj.input_digi_collections = inputs
+    if windows:
+        # the windows are computed by the projection, on the singles
+        proj.energy_windows = channels
+    proj.spacing = [4 * mm, 4 * mm]
+    proj.size = [64, 64]
+    proj.output_filename = f"test154_{name}_projection.mhd"
+    proj.user_output["projection"].set_write_to_disk(True)
+
+    return sim, stats, proj
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test154")
+
+    # the same simulation, with energy windows channels or windows of the projection
+    outputs = {}
+    for windows in [False, True]:
+        sim, stats, proj = create_simulation(paths, windows)
+        sim.run(start_new_process=True)
+        print(stats)
+        outputs[windows] = proj.get_output_path()
+
+    # same projections
+    ref = itk.array_view_from_image(itk.imread(outputs[False]))
+    out = itk.array_view_from_image(itk.imread(outputs[True]))
+    is_ok = ref.shape == out.shape and np.sum(out) > 0
+    utility.print_test(is_ok, f"Projections of shape {out.shape}")
+    for c in range(out.shape[0]):
+        b = np.array_equal(ref[c], out[c])
+        utility.print_test(b, f"Channel {c}: {np.sum(out[c])} counts")
+        is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate.contrib.spect.ge_discovery_nm670 as gate_spect
+import opengate as gate
+import test043_garf_helpers as test43
+from opengate.actors.arfactors import read_arf_training_dataset
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def create_simulation(output_filename):
+    sim = gate.Simulation()
+    sim.number_of_threads = 1
+    sim.random_seed = 45678
+    sim.output_dir = paths.output
+
+    # units
+    nm = gate.g4_units.nm
+    cm = gate.g4_units.cm
+    Bq = gate.g4_units.Bq
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+
+    # world, spect head and detector plane
+    test43.sim_set_world(sim)
+    spect, colli, crystal = gate_spect.add_spect_head(
+        sim, "spect", collimator_type="lehr", debug=False
+    )
+    pos, crystal_dist, psd = gate_spect.get_plane_position_and_distance_to_crystal(
+        "lehr"
+    )
+    pos += 1 * nm  # to avoid overlap
+    det_plane = test43.sim_add_detector_plane(sim, spect.name, pos)
+    test43.sim_phys(sim)
+
+    # source
+    s1 = sim.add_source("GenericSource", "s1")
+    s1.particle = "gamma"
+    s1.activity = 1e5 * Bq
+    s1.position.type = "disc"
+    s1.position.radius = 57.6 * cm / 4
+    s1.position.translation = [0, 0, 12 * cm]
+    s1.direction.type = "iso"
+    s1.energy.type = "range"
+    s1.energy.min_energy = 0.01 * MeV
+    s1.energy.max_energy = 0.154 * MeV
+    s1.direction.acceptance_angle.volumes = [det_plane.name]
+    s1.direction.acceptance_angle.intersection_flag = True
+
+    # digitizer
+    channels = [
+        {"name": f"scatter_{spect.name}", "min": 114 * keV, "max": 126 * keV},
+        {"name": f"peak140_{spect.name}", "min": 126 * keV, "max": 154 * keV},
+    ]
+    cc = gate_spect.add_digitizer_energy_windows(sim, crystal.name, channels)
+
+    # arf actor for building the training dataset
+    arf = sim.add_actor("ARFTrainingDatasetActor", "ARF (training)")
+    arf.attached_to = det_plane.name
+    arf.output_filename = output_filename
+    arf.energy_windows_actor = cc.name
+    arf.russian_roulette = 50
+
+    return sim, arf
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "gate_test043_garf", "test155")
+
+    # the same dataset, in a root file and in the compact file
+    outputs = {}
+    for filename in ["test155_dataset.root", "test155_dataset.bin"]:
+        sim, arf = create_simulation(filename)
+        sim.run(start_new_process=True)
+        outputs[filename] = arf.get_output_path()
+
+    ref = uproot.open(outputs["test155_dataset.root"])["ARF (training)"]
+    ref = ref.arrays(library="np")
+    out = read_arf_training_dataset(outputs["test155_dataset.bin"])
+
+    n = len(out["E"])
+    is_ok = n > 0 and n == len(ref["E"])
+    utility.print_test(is_ok, f"Number of samples {n} (root {len(ref['E'])})")
+    for k in ["E", "Theta", "Phi", "window"]:
+        b = n == len(ref[k]) and np.allclose(out[k], ref[k], rtol=1e-6, atol=1e-6)
+        utility.print_test(b, f"Same {k} values (float32)")
+        is_ok = is_ok and b
+    w = np.where(out["window"] == 0, 50, 1)
+    b = np.array_equal(out["weight"], w)
+    utility.print_test(b, "Weight is the russian roulette factor outside the windows")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate_core as g4
+import opengate as gate
+from opengate.sources.voxelsources import tac_integral
+from opengate.tests import utility
+from test096_voxel_source_alias import sample_voxels, check_counts
+import itk
+import numpy as np
+
+
+def channel_pdf(channels, activities):
+    # uniform in the voxels of each channel
+    pdf = np.zeros(channels.shape)
+    for c, a in enumerate(activities):
+        m = channels == c
+        pdf[m] = a / np.count_nonzero(m)
+    return pdf / np.sum(pdf)
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test156")
+
+    # channels of the voxels (numpy order Z Y X), -1: no channel
+    rs = np.random.RandomState(12)
+    shape = (6, 5, 8)
+    channels = rs.randint(-1, 3, size=shape).astype(np.int32)
+    n = 200000
+
+    # the channel alias table of the thread is built again when the activities
+    # change, the voxels are only given once
+    sps = g4.GateSPSVoxelsPosDistribution()
+    sps.SetChannels(channels, 3)
+    nbv = [sps.GetNumberOfChannelVoxels(c) for c in range(3)]
+    is_ok = nbv == [np.count_nonzero(channels == c) for c in range(3)]
+    utility.print_test(is_ok, f"Voxels of the channels {nbv}")
+    for activities in [[1.0, 5.0, 0.2], [0.0, 3.0, 1.0]]:
+        sps.SetChannelActivities(activities)
+        counts = sample_voxels(sps, n, shape)
+        pdf = channel_pdf(channels, activities)
+        b = check_counts(counts, pdf, n, f"Channels {activities}")
+        is_ok = b and is_ok
+
+    # simulation: one label image (two organs), one TAC per organ, two runs
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.s
+
+    labels = np.zeros((10, 20, 20), dtype=np.int16)
+    labels[2:5, 3:10, 3:10] = 4
+    labels[5:9, 10:18, 5:15] = 7
+    image = itk.image_from_array(labels)
+    image.SetSpacing([2.0, 2.0, 2.0])
+    image_filename = paths.output / "test156_labels.mhd"
+    itk.imwrite(image, str(image_filename))
+
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [4 * cm, 4 * cm, 2 * cm]
+    phantom.material = "G4_WATER"
+
+    source = sim.add_source("MultiChannelVoxelSource", "organs")
+    source.attached_to = phantom.name
+    source.image = str(image_filename)
+    source.particle = "alpha"
+    source.energy.mono = 1 * MeV
+    source.direction.type = "iso"
+    source.labels = [4, 7]
+    source.channel_tac_times = [0, 1 * sec, 2 * sec]
+    source.channel_tac_activities = [
+        [3000 * Bq, 1000 * Bq, 0],
+        [0, 1000 * Bq, 2000 * Bq],
+    ]
+    sim.run_timing_intervals = [[0, 1 * sec], [1 * sec, 2 * sec]]
+
+    sim.physics_manager.physics_list_name = "QGSP_BERT_EMZ"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = phantom
+    dose.size = [20, 20, 10]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.output_filename = "test156_edep.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.run()
+
+    # number of events: integral of the sum of the TACs
+    times = source.channel_tac_times
+    expected = [
+        tac_integral(times, tac, 0, 2 * sec) for tac in source.channel_tac_activities
+    ]
+    events = stats.counts.events
+    b = abs(events - sum(expected)) < 5 * np.sqrt(sum(expected))
+    utility.print_test(b, f"Number of events {events}, expected {sum(expected):.0f}")
+    is_ok = b and is_ok
+
+    # the alpha particles deposit their energy in the voxel of their organ
+    edep = itk.array_view_from_image(dose.edep.get_data())
+    e = [np.sum(edep[labels == 4]), np.sum(edep[labels == 7])]
+    total = np.sum(edep)
+    b = (total - e[0] - e[1]) / total < 0.01
+    utility.print_test(b, f"Energy deposited in the organs: {e[0] + e[1]} / {total}")
+    is_ok = b and is_ok
+    for c in range(2):
+        f = e[c] / (e[0] + e[1])
+        ef = expected[c] / sum(expected)
+        b = abs(f - ef) < 0.03
+        utility.print_test(b, f"Fraction of the organ {c}: {f:.3f} (expected {ef:.3f})")
+        is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
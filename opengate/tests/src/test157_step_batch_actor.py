@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import threading
+
+# (the threads call the function one at a time, with the GIL, but a lock is
+# needed as soon as the function releases the GIL)
+lock = threading.Lock()
+
+
+class BatchScorer:
+    """Prototype scoring: total energy deposit and steps, per event"""
+
+    def __init__(self):
+        self.edep = 0
+        self.steps = 0
+        self.batches = 0
+        self.mixed_events = 0
+
+    def __call__(self, actor, batch):
+        # the arrays are only valid during the call: they are reduced here
+        e = float(np.sum(batch["TotalEnergyDeposit"]))
+        n = len(batch["TotalEnergyDeposit"])
+        mixed = len(np.unique(batch["EventID"])) > 1
+        assert batch["PostPosition"].shape == (n, 3)
+        with lock:
+            self.edep += e
+            self.steps += n
+            self.batches += 1
+            self.mixed_events += int(mixed)
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test157")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 987654
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 80 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    # reference: energy deposit of the dose actor
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [1, 1, 100]
+    dose.spacing = [10 * cm, 10 * cm, 1 * mm]
+    dose.output_filename = "test157_edep.mhd"
+
+    # the same scoring, prototyped in Python (one call per batch)
+    scorer = BatchScorer()
+    sba = sim.add_actor("StepBatchActor", "prototype")
+    sba.attached_to = waterbox
+    sba.attributes = ["TotalEnergyDeposit", "PostPosition", "EventID"]
+    sba.batch_size = 5000
+    sba.apply_at_end_of_event = True
+    sba.batch_function = scorer
+
+    sim.run(start_new_process=False)
+
+    ref = float(np.sum(itk.array_view_from_image(dose.edep.get_data())))
+    b = abs(scorer.edep - ref) / ref < 1e-4
+    utility.print_test(
+        b, f"Energy deposit {scorer.edep / MeV:.2f} MeV (ref {ref / MeV:.2f})"
+    )
+    is_ok = b
+    b = scorer.batches == sba.number_of_batches and scorer.batches < scorer.steps / 10
+    utility.print_test(
+        b, f"{scorer.steps} steps in {scorer.batches} batches (Python calls)"
+    )
+    is_ok = b and is_ok
+    b = scorer.mixed_events == 0
+    utility.print_test(b, "Each batch only contains steps of one event")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import json
+import numpy as np
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test158")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 147258
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    # label image: two structures and the rest of the phantom (label 0)
+    labels = np.zeros((10, 20, 20), dtype=np.int16)
+    labels[2:6, 5:15, 5:15] = 3
+    labels[6:9, 8:12, 8:12] = 8
+    image = itk.image_from_array(labels)
+    image.SetSpacing([2.0, 2.0, 2.0])
+    image_filename = paths.output / "test158_labels.mhd"
+    itk.imwrite(image, str(image_filename))
+
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [4 * cm, 4 * cm, 2 * cm]
+    phantom.material = "G4_WATER"
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 40 * MeV
+    source.position.type = "disc"
+    source.position.radius = 8 * mm
+    source.position.translation = [0, 0, -5 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 2000
+
+    # reference: full dose image on the same grid (same hit position)
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = phantom
+    dose.size = [20, 20, 10]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.hit_type = "middle"
+    dose.dose.active = True
+    dose.output_filename = "test158.mhd"
+
+    roi = sim.add_actor("ROIDoseActor", "organs")
+    roi.attached_to = phantom
+    roi.image = str(image_filename)
+    roi.roi_names = ["target", "oar"]
+    roi.hit_type = "middle"
+    roi.dvh_bins = 50
+    roi.roi_dose.output_filename = "test158_organs.json"
+
+    sim.run(start_new_process=False)
+
+    # mean dose per ROI, compared with the dose image
+    dose_arr = itk.array_view_from_image(dose.dose.get_data())
+    with open(roi.user_output.roi_dose.get_output_path()) as f:
+        rois = json.load(f)
+    is_ok = len(rois) == 2 and [r["label"] for r in rois] == [3, 8]
+    utility.print_test(is_ok, f"ROIs {[r['name'] for r in rois]}")
+    for r in rois:
+        m = labels == r["label"]
+        ref = np.mean(dose_arr[m])
+        b = abs(r["dose"] - ref) / ref < 1e-6
+        b = b and r["number_of_voxels"] == np.count_nonzero(m)
+        utility.print_test(
+            b,
+            f"ROI {r['name']}: mean dose {r['dose']:.4g} Gy (ref {ref:.4g}) "
+            f"+/- {r['uncertainty'] * 100:.2f}%",
+        )
+        is_ok = b and is_ok
+
+        # DVH: all the voxels, and the same histogram as the dose image
+        edges = np.concatenate([[0], r["dvh_dose"]])
+        h, _ = np.histogram(np.clip(dose_arr[m], 0, edges[-1]), bins=edges)
+        b = sum(r["dvh_voxels"]) == r["number_of_voxels"]
+        b = b and np.sum(np.abs(h - np.array(r["dvh_voxels"]))) <= 2
+        utility.print_test(b, f"ROI {r['name']}: DVH of {sum(h)} voxels")
+        is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
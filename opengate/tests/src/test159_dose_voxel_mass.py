@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test159")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 1
+    sim.random_seed = 852963
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+    g = gate.g4_units.g
+
+    # CT 10x10x10 voxels of 3 mm: water with a bone slab
+    ct = np.zeros((10, 10, 10), dtype=np.int16)
+    ct[4:6, :, :] = 1000
+    image = itk.image_from_array(ct)
+    image.SetSpacing([3.0, 3.0, 3.0])
+    image_filename = paths.output / "test159_ct.mhd"
+    itk.imwrite(image, str(image_filename))
+
+    patient = sim.add_volume("Image", "patient")
+    patient.image = str(image_filename)
+    patient.material = "G4_WATER"
+    patient.voxel_materials = [
+        [-2000, 500, "G4_WATER"],
+        [500, 3000, "G4_BONE_COMPACT_ICRU"],
+    ]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 60 * MeV
+    source.position.type = "disc"
+    source.position.radius = 6 * mm
+    source.position.translation = [0, 0, -50 * mm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 1000
+
+    # scoring grid not aligned with the CT voxels
+    actors = {}
+    for dose_mass in ["step", "voxel"]:
+        dose = sim.add_actor("DoseActor", f"dose_{dose_mass}")
+        dose.attached_to = patient
+        dose.size = [6, 6, 6]
+        dose.spacing = [4.5 * mm, 4.5 * mm, 4.5 * mm]
+        dose.translation = [1 * mm, 0, 0.5 * mm]
+        dose.hit_type = "segment"
+        dose.dose.active = True
+        dose.dose_mass = dose_mass
+        dose.output_filename = f"test159_{dose_mass}.mhd"
+        actors[dose_mass] = dose
+
+    sim.run(start_new_process=False)
+
+    # expected mass of the scoring voxels, from 0.5 mm sub-voxels
+    fine = np.where(ct > 500, 1.85, 1.0)
+    for axis in range(3):
+        fine = np.repeat(fine, 6, axis=axis)
+    first = [4, 3, 5]  # first sub-voxel of the grid along z, y, x
+    expected = np.zeros((6, 6, 6))
+    for z in range(6):
+        for y in range(6):
+            for x in range(6):
+                z0, y0, x0 = (f + 9 * i for f, i in zip(first, (z, y, x)))
+                block = fine[z0 : z0 + 9, y0 : y0 + 9, x0 : x0 + 9]
+                expected[z, y, x] = np.sum(block) * 0.125e-3
+    voxel = actors["voxel"]
+    mass = 1.0 / voxel.get_inverse_voxel_mass() / g
+    d = np.max(np.abs(mass - expected) / expected)
+    is_ok = d < 1e-4
+    utility.print_test(is_ok, f"Mass of the scoring voxels, max diff {d:.2e}")
+
+    # same edep, and the same dose in the voxels that are only in water
+    edep_step = itk.array_view_from_image(actors["step"].edep.get_data())
+    edep_voxel = itk.array_view_from_image(voxel.edep.get_data())
+    b = np.allclose(edep_step, edep_voxel)
+    utility.print_test(b, "Same edep with both methods")
+    is_ok = b and is_ok
+    dose_step = itk.array_view_from_image(actors["step"].dose.get_data())
+    dose_voxel = itk.array_view_from_image(voxel.dose.get_data())
+    water = np.isclose(expected, 4.5**3 * 1e-3) & (edep_step > 0)
+    d = np.max(np.abs(dose_voxel[water] - dose_step[water]) / dose_step[water])
+    b = d < 1e-6
+    utility.print_test(b, f"Same dose in {np.sum(water)} water voxels, diff {d:.2e}")
+    is_ok = b and is_ok
+
+    # the dose times the mass is the edep, everywhere
+    e = np.sum(dose_voxel * mass * g * gate.g4_units.Gy)
+    b = abs(e - np.sum(edep_voxel)) / np.sum(edep_voxel) < 1e-6
+    utility.print_test(b, f"Energy from the dose {e / MeV:.2f} MeV")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
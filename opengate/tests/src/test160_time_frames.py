@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import itk
+import numpy as np
+import opengate as gate
+from opengate.tests import utility
+from opengate.utility import insert_suffix_before_extension
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test160")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    sec = gate.g4_units.second
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [6 * cm, 6 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 80 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 300 * Bq
+
+    # three runs of 1 s, scored in six frames of 0.5 s
+    sim.run_timing_intervals = [[0, 1 * sec], [1 * sec, 2 * sec], [2 * sec, 3 * sec]]
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [20, 20, 50]
+    dose.spacing = [3 * mm, 3 * mm, 2 * mm]
+    dose.hit_type = "middle"
+    dose.edep.keep_data_per_run = True
+    dose.number_of_time_frames = 6
+    dose.time_frame_duration = 0.5 * sec
+    # fewer active frames than frames: the oldest ones are flushed
+    dose.time_frame_buffer = 1
+    dose.output_filename = "test160.mhd"
+
+    fluence = sim.add_actor("FluenceActor", "fluence")
+    fluence.attached_to = waterbox
+    fluence.size = [20, 20, 50]
+    fluence.spacing = [3 * mm, 3 * mm, 2 * mm]
+    fluence.hit_type = "segment"
+    fluence.number_of_time_frames = 6
+    fluence.time_frame_duration = 0.5 * sec
+    fluence.output_filename = "test160_fluence.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    sim.run()
+    print(stats)
+
+    # two frames per run: their sum is the edep of the run
+    path = insert_suffix_before_extension(
+        dose.edep.get_output_path(), "per_time_frame"
+    )
+    frames = itk.array_view_from_image(itk.imread(str(path)))
+    is_ok = frames.shape == (6, 50, 20, 20)
+    utility.print_test(is_ok, f"Shape of the 4D edep image {frames.shape}")
+    for run_index in range(3):
+        edep = itk.array_view_from_image(
+            dose.user_output.edep_with_uncertainty.get_data(run_index, item=0)
+        )
+        f = frames[2 * run_index] + frames[2 * run_index + 1]
+        b = np.allclose(f, edep) and np.sum(frames[2 * run_index]) > 0
+        utility.print_test(b, f"Frames of run {run_index}: edep {np.sum(f):.4g}")
+        is_ok = is_ok and b
+
+    # the track lengths of all the frames, divided by the voxel volume, are
+    # the fluence
+    path = insert_suffix_before_extension(
+        fluence.fluence.get_output_path(), "per_time_frame"
+    )
+    frames = itk.array_view_from_image(itk.imread(str(path)))
+    total = itk.array_view_from_image(fluence.fluence.get_data())
+    f = np.sum(frames, axis=0) / (3 * 3 * 2)
+    b = frames.shape[0] == 6 and np.allclose(f, total, rtol=1e-5, atol=1e-6)
+    utility.print_test(b, f"Sum of the fluence frames {np.sum(f):.4g}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.actors.doseactors import create_time_integrated_activity_image
+import itk
+import numpy as np
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test161")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 741852
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    h = gate.g4_units.h
+
+    # three activity images (Bq): left half, uniform, right half
+    times = [0, 1 * h, 2 * h]
+    activities = np.zeros((3, 10, 10, 10))
+    activities[0, :, :, :5] = 1000
+    activities[1] = 500
+    activities[2, :, :, 5:] = 1000
+    activity_files = []
+    for k, a in enumerate(activities):
+        image = itk.image_from_array(a.astype(np.float32))
+        image.SetSpacing([10.0, 10.0, 10.0])
+        activity_files.append(paths.output / f"test161_activity_{k}.mhd")
+        itk.imwrite(image, str(activity_files[-1]))
+    integrated = create_time_integrated_activity_image(activity_files, times)
+    integrated_file = paths.output / "test161_integrated_activity.mhd"
+    itk.imwrite(integrated, str(integrated_file))
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+
+    source = sim.add_source("VoxelSource", "vox")
+    source.attached_to = waterbox
+    source.image = str(integrated_file)
+    source.particle = "gamma"
+    source.energy.mono = 140 * keV
+    source.direction.type = "iso"
+    source.n = 20000
+
+    dose = sim.add_actor("DoseRateActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [10, 10, 10]
+    dose.spacing = [10 * mm, 10 * mm, 10 * mm]
+    dose.activity_images = activity_files
+    dose.activity_times = times
+    dose.output_filename = "test161.mhd"
+
+    sim.run(start_new_process=False)
+
+    # number of decays: 1000 Bq in half of the voxels during 1 h, plus 500 Bq in
+    # all the voxels during 1 h
+    decays = 500 * 1000 * 3600 + 500 * 1000 * 3600
+    is_ok = abs(dose.number_of_decays - decays) / decays < 1e-6
+    utility.print_test(is_ok, f"Number of decays {dose.number_of_decays:.4g}")
+
+    # the integrated dose is the dose of all the events, scaled to the decays
+    d = itk.array_view_from_image(dose.dose.get_data())
+    integrated_dose = itk.array_view_from_image(dose.integrated_dose.get_data())
+    ref = d * decays / dose.GetNumberOfSimulatedEvents()
+    b = np.allclose(integrated_dose, ref, rtol=1e-4, atol=1e-12 * np.max(ref))
+    utility.print_test(b, f"Integrated dose {np.sum(integrated_dose):.4g} Gy")
+    is_ok = b and is_ok
+
+    # the dose rate follows the activity: left, uniform, right
+    rate = itk.array_view_from_image(dose.dose_rate.get_data())
+    b = rate.shape == (3, 10, 10, 10)
+    left = [np.sum(r[:, :, :5]) for r in rate]
+    right = [np.sum(r[:, :, 5:]) for r in rate]
+    b = b and left[0] > 3 * right[0] and right[2] > 3 * left[2]
+    b = b and 0.8 < left[1] / right[1] < 1.25
+    utility.print_test(b, f"Dose rate left {left} right {right} Gy/s")
+    is_ok = b and is_ok
+
+    # the trapezoid integral of the dose rate is the integrated dose
+    c = np.array([1800, 3600, 1800])
+    d = np.tensordot(c, rate, axes=1)
+    b = np.allclose(d, integrated_dose, rtol=1e-4, atol=1e-12 * np.max(d))
+    utility.print_test(b, "Integral of the dose rate")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import json
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test162")
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 963852
+    sim.output_dir = paths.output
+
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    # pilot run with low cuts in the phantom
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 1 * mm)
+    sim.physics_manager.set_production_cut("waterbox", "all", 0.01 * mm)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 120 * MeV
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    tuning = sim.add_actor("CutsTuningActor", "tuning")
+    tuning.resolution = 2 * mm
+    tuning.tolerance = 0.01
+    tuning.cuts_tuning.output_filename = "test162_cuts.json"
+
+    sim.run(start_new_process=False)
+
+    with open(tuning.user_output.cuts_tuning.get_output_path()) as f:
+        regions = json.load(f)
+    print(json.dumps(regions["waterbox_region"]["proposed_cuts"], indent=2))
+    region = regions["waterbox_region"]
+    is_ok = region["steps"] > 0 and region["edep"] > 0
+    is_ok = is_ok and sum(region["secondaries"]["e-"]) > 0
+    is_ok = is_ok and region["materials"] == ["G4_WATER"]
+    utility.print_test(
+        is_ok,
+        f"Region waterbox: {region['steps']} steps, "
+        f"{sum(region['secondaries']['e-'])} delta electrons",
+    )
+
+    # the electron cut is at least the resolution, and the cuts are admissible
+    cuts = region["proposed_cuts"]
+    b = cuts["electron"] is not None and cuts["electron"]["cut"] >= 2 * mm
+    for particle, c in cuts.items():
+        if c is None or (particle == "electron" and c["cut"] <= 2 * mm):
+            continue
+        b = b and c["suppressed_energy_fraction"] <= 0.01
+    b = b and cuts["electron"]["saved_steps_fraction"] > 0
+    utility.print_test(b, f"Proposed electron cut {cuts['electron']['cut']} mm")
+    is_ok = b and is_ok
+
+    # the proposed cuts are set in the regions of another simulation
+    sim2 = gate.Simulation()
+    sim2.add_volume("Box", "waterbox")
+    sim2.physics_manager.set_production_cut("waterbox", "all", 0.01 * mm)
+    tuning.apply_proposed_cuts(sim2.physics_manager)
+    c = sim2.physics_manager.regions["waterbox_region"].production_cuts
+    b = c["electron"] == cuts["electron"]["cut"]
+    utility.print_test(b, f"Cuts of the region in the other simulation {c}")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
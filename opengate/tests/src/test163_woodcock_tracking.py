@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import uproot
+
+
+def run_simulation(paths, woodcock, n):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    keV = gate.g4_units.keV
+
+    name = "woodcock" if woodcock else "ref"
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test163_phantom.mhd"
+    phantom.material = "G4_WATER"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+
+    # plane behind the phantom
+    plane = sim.add_volume("Box", "plane")
+    plane.size = [1 * m, 1 * m, 1 * mm]
+    plane.translation = [0, 0, 20 * cm]
+    plane.material = "G4_Galactic"
+
+    # parallel photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 140.5 * keV
+    source.position.type = "disc"
+    source.position.radius = 5 * cm
+    source.position.translation = [0, 0, -30 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    # (before the actors that score in the phantom)
+    if woodcock:
+        wt = sim.add_actor("WoodcockTrackingActor", "woodcock")
+        wt.attached_to = phantom
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = phantom
+    dose.size = [1, 1, 40]
+    dose.spacing = [200 * mm, 200 * mm, 5 * mm]
+    dose.output_filename = f"test163_{name}.mhd"
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = plane
+    phsp.output_filename = f"test163_{name}.root"
+    phsp.attributes = ["KineticEnergy", "Weight"]
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+
+    # (the actor counts are read in this process)
+    sim.run(start_new_process=not woodcock)
+    print(stats)
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    edep = itk.array_from_image(itk.imread(str(dose.edep.get_output_path()))).ravel()
+    counts = None
+    if woodcock:
+        counts = (wt.number_of_real_interactions, wt.number_of_fictitious_interactions)
+        print(f"Real interactions {counts[0]}, fictitious {counts[1]}")
+    return a["KineticEnergy"], edep, counts
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test163")
+    utility.create_water_bone_phantom(paths.output / "test163_phantom.mhd", spacing=5)
+    keV = gate.g4_units.keV
+
+    n = 50000
+    e_ref, edep_ref, _ = run_simulation(paths, False, n)
+    e, edep, counts = run_simulation(paths, True, n)
+
+    # fictitious interactions in the water (the majorant is the bone mu)
+    is_ok = counts[0] > 0 and counts[1] > 0
+    utility.print_test(is_ok, f"Real/fictitious interactions {counts}")
+
+    # same transmission of the uncollided photons
+    t_ref = np.count_nonzero(np.isclose(e_ref, 140.5 * keV)) / n
+    t = np.count_nonzero(np.isclose(e, 140.5 * keV)) / n
+    b = abs(t - t_ref) / t_ref < 0.03
+    utility.print_test(b, f"Uncollided transmission {t:.4f} vs {t_ref:.4f}")
+    is_ok = is_ok and b
+
+    # same scattered photons behind the phantom
+    s_ref = len(e_ref) / n - t_ref
+    s = len(e) / n - t
+    b = abs(s - s_ref) / s_ref < 0.05
+    utility.print_test(b, f"Scattered photons {s:.4f} vs {s_ref:.4f}")
+    is_ok = is_ok and b
+
+    # same energy deposited in the phantom, and same depth profile
+    b = abs(edep.sum() - edep_ref.sum()) / edep_ref.sum() < 0.03
+    utility.print_test(
+        b, f"Total edep {edep.sum() / keV:.0f} keV vs {edep_ref.sum() / keV:.0f} keV"
+    )
+    is_ok = is_ok and b
+    d = np.max(np.abs(edep - edep_ref)) / np.max(edep_ref)
+    b = d < 0.1
+    utility.print_test(b, f"Depth profile, max diff {d * 100:.1f}%")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
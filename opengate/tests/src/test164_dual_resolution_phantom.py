@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def add_image(sim, name, image, mother="world"):
+    ct = sim.add_volume("Image", name)
+    ct.mother = mother
+    ct.image = image
+    ct.material = "G4_WATER"
+    ct.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+    return ct
+
+
+def run_simulation(paths, dual):
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    name = "dual" if dual else "ref"
+    sim = gate.Simulation()
+    sim.random_seed = 963852
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    image = paths.output / "test164_phantom.mhd"
+    patient = add_image(sim, "patient", image)
+    if dual:
+        # photons: 10x10x10 grid, electrons: full grid in the parallel world
+        patient.label_downsampling = 4
+        sim.add_parallel_world("fine_world")
+        add_image(sim, "patient_fine", image, "fine_world")
+        sim.physics_manager.set_parallel_world_particles("fine_world", ["e-", "e+"])
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = 20000
+    source.energy.mono = 1 * MeV
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    # dose on the full grid in both cases
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = patient
+    dose.size = [40, 40, 40]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.output_filename = f"test164_{name}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option4"
+    sim.physics_manager.set_production_cut("world", "all", 0.5 * mm)
+
+    sim.run(start_new_process=True)
+    print(stats)
+    edep = itk.array_from_image(itk.imread(str(dose.edep.get_output_path())))
+    return edep, stats.counts.steps
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test164")
+    utility.create_water_bone_phantom(
+        paths.output / "test164_phantom.mhd",
+        spacing=2,
+        size=(80, 80, 80),
+        bone_min=(16, 16, 32),
+        bone_max=(64, 64, 48),
+    )
+    MeV = gate.g4_units.MeV
+
+    edep_ref, steps_ref = run_simulation(paths, False)
+    edep, steps = run_simulation(paths, True)
+
+    # fewer steps with the coarse grid for the photons
+    is_ok = steps < steps_ref
+    utility.print_test(is_ok, f"Steps {steps} vs {steps_ref}")
+
+    # same energy deposited in the phantom and in the bone block
+    b = abs(edep.sum() - edep_ref.sum()) / edep_ref.sum() < 0.03
+    utility.print_test(
+        b, f"Total edep {edep.sum() / MeV:.1f} MeV vs {edep_ref.sum() / MeV:.1f} MeV"
+    )
+    is_ok = is_ok and b
+    bone = np.s_[16:24, 8:32, 8:32]
+    e, e_ref = edep[bone].sum(), edep_ref[bone].sum()
+    b = abs(e - e_ref) / e_ref < 0.05
+    utility.print_test(b, f"Bone edep {e / MeV:.1f} MeV vs {e_ref / MeV:.1f} MeV")
+    is_ok = is_ok and b
+
+    # same depth profile on the full grid
+    p, p_ref = edep.sum(axis=(1, 2)), edep_ref.sum(axis=(1, 2))
+    d = np.max(np.abs(p - p_ref)) / np.max(p_ref)
+    b = d < 0.1
+    utility.print_test(b, f"Depth profile, max diff {d * 100:.1f}%")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+def run_simulation(paths, density_scaling):
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+    gcm3 = gate.g4_units.g_cm3
+
+    name = "scaling" if density_scaling else "ref"
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    patient = sim.add_volume("Image", "patient")
+    patient.image = paths.data / "patient-4mm.mhd"
+    patient.material = "G4_AIR"
+    f1 = str(paths.gate_data / "Schneider2000MaterialsTable.txt")
+    f2 = str(paths.gate_data / "Schneider2000DensitiesTable.txt")
+    patient.voxel_materials, materials = (
+        gate.geometry.materials.HounsfieldUnit_to_material(
+            sim, 0.05 * gcm3, f1, f2, density_scaling=density_scaling
+        )
+    )
+    patient.set_production_cut(particle_name="electron", value=3 * mm)
+
+    source = sim.add_source("GenericSource", "beam")
+    source.energy.mono = 130 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 10 * mm
+    source.position.translation = [0, 0, -14 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 2000
+
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.output_filename = f"test165_{name}.mhd"
+    dose.attached_to = patient
+    dose.size = [50, 50, 50]
+    dose.spacing = [4 * mm, 4 * mm, 4 * mm]
+    dose.hit_type = "random"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    sim.run(start_new_process=True)
+    return dose, stats
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, "gate_test009_voxels", "test165")
+    gcm3 = gate.g4_units.g_cm3
+
+    # conversion only: same intervals and names, fewer compositions (the
+    # materials of the reference conversion are not built)
+    f1 = str(paths.gate_data / "Schneider2000MaterialsTable.txt")
+    f2 = str(paths.gate_data / "Schneider2000DensitiesTable.txt")
+    hu = gate.geometry.materials.HounsfieldUnit_to_material
+    sim_ref = gate.Simulation()
+    vm_ref, mat_ref = hu(sim_ref, 0.05 * gcm3, f1, f2)
+    sim = gate.Simulation()
+    vm, mat = hu(sim, 0.05 * gcm3, f1, f2, density_scaling=True)
+    is_ok = utility.print_test(
+        vm == vm_ref and mat == mat_ref, f"Same {len(mat)} HU intervals"
+    )
+
+    # the materials of the same composition share a base material, with the
+    # same density as without scaling
+    db = sim.volume_manager.material_database
+    nb_base = 0
+    for m in mat:
+        g4_mat = db.FindOrBuildMaterial(m)
+        if g4_mat.GetBaseMaterial() is None:
+            nb_base += 1
+    b = 0 < nb_base < len(mat)
+    is_ok = utility.print_test(b, f"{nb_base} base materials") and is_ok
+    ref = sim_ref.volume_manager.material_database.new_materials_weights
+    b = True
+    for m in mat:
+        g4_mat = db.FindOrBuildMaterial(m)
+        _, symbols, weights, density = ref[m]
+        b = b and abs(g4_mat.GetDensity() - density) < 1e-9 * gcm3
+        b = b and g4_mat.GetNumberOfElements() == len(weights)
+        for i, w in enumerate(weights):
+            b = b and abs(g4_mat.GetElementFraction(i) - w) < 1e-9
+    is_ok = utility.print_test(b, "Same densities and compositions") and is_ok
+
+    # the dose is the same (statistical uncertainty)
+    dose_ref, stats_ref = run_simulation(paths, False)
+    dose, stats = run_simulation(paths, True)
+    is_ok = utility.assert_stats(stats, stats_ref, 0.1) and is_ok
+    is_ok = (
+        utility.assert_images(
+            dose_ref.edep.get_output_path(),
+            dose.edep.get_output_path(),
+            stats,
+            tolerance=30,
+            ignore_value_data2=0,
+        )
+        and is_ok
+    )
+
+    utility.test_ok(is_ok)
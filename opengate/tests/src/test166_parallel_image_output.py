@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+
+
+def run_simulation(paths, name, number_of_output_threads, compression):
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output / name
+    sim.number_of_output_threads = number_of_output_threads
+    sim.compress_output_images = compression
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 80 * MeV
+    source.position.type = "disc"
+    source.position.radius = 1 * cm
+    source.position.translation = [0, 0, -8 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    # several actors and images (edep, dose, uncertainties, counts, fluence)
+    outputs = []
+    for i in range(3):
+        dose = sim.add_actor("DoseActor", f"dose{i}")
+        dose.attached_to = waterbox
+        dose.size = [50, 50, 50]
+        dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+        dose.edep_uncertainty.active = True
+        dose.dose.active = True
+        dose.counts.active = True
+        dose.output_filename = f"test166_dose{i}.mhd"
+        outputs += [dose.edep, dose.edep_uncertainty, dose.dose, dose.counts]
+    fluence = sim.add_actor("FluenceActor", "fluence")
+    fluence.attached_to = waterbox
+    fluence.size = [50, 50, 50]
+    fluence.spacing = [2 * mm, 2 * mm, 2 * mm]
+    fluence.output_filename = "test166_fluence.mhd"
+    outputs.append(fluence.fluence)
+
+    sim.run(start_new_process=True)
+    return [o.get_output_path() for o in outputs]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test166")
+
+    # reference: one image after the other, not compressed
+    files_ref = run_simulation(paths, "serial", 1, False)
+    files = run_simulation(paths, "parallel", 4, True)
+
+    is_ok = True
+    for f, f_ref in zip(files, files_ref):
+        # compressed: the data is in a .zraw file
+        b = f.with_suffix(".zraw").exists() and not f.with_suffix(".raw").exists()
+        a = itk.array_view_from_image(itk.imread(str(f)))
+        a_ref = itk.array_view_from_image(itk.imread(str(f_ref)))
+        b = b and np.array_equal(a, a_ref)
+        is_ok = utility.print_test(b, f"Same image {f.name}") and is_ok
+
+    utility.test_ok(is_ok)
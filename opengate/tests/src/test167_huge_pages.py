@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from pathlib import Path
+import itk
+import numpy as np
+
+
+def run_simulation(paths, huge_pages):
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+
+    name = "huge" if huge_pages else "ref"
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 321987
+    sim.output_dir = paths.output
+    sim.huge_pages = huge_pages
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "beam")
+    source.energy.mono = 80 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -15 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    # large image (8 MB per double image) with per-thread buffers
+    dose = sim.add_actor("DoseActor", "dose")
+    dose.attached_to = waterbox
+    dose.size = [100, 100, 100]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.scoring_mode = "thread_local"
+    dose.output_filename = f"test167_{name}.mhd"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    stats.memory_flag = True
+
+    sim.run(start_new_process=True)
+    edep = itk.array_from_image(itk.imread(str(dose.edep.get_output_path())))
+    return edep, stats.counts.memory
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test167")
+
+    edep_ref, memory_ref = run_simulation(paths, False)
+    edep, memory = run_simulation(paths, True)
+
+    # the same dose
+    is_ok = utility.print_test(np.allclose(edep, edep_ref, rtol=1e-9), "Same edep")
+
+    # no huge pages without the option
+    b = "huge_pages" not in memory_ref
+    is_ok = utility.print_test(b, "No huge pages without the option") and is_ok
+
+    # the images and the per-thread buffers, if the system allows it
+    thp = Path("/sys/kernel/mm/transparent_hugepage/enabled")
+    if thp.exists() and "[never]" not in thp.read_text():
+        huge = memory.get("huge_pages", {})
+        print(huge)
+        b = "images" in huge and "dose_buffers" in huge
+        b = b and len(huge["dose_buffers"]["threads"]) == 2
+        is_ok = utility.print_test(b, "Huge pages for images and buffers") and is_ok
+    else:
+        print("Transparent huge pages are not available on this system")
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+import opengate_core as g4
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test168")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [20 * cm, 20 * cm, 5 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # gammas toward the crystal
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 0.5 * MeV
+    source.position.type = "point"
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 5000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # the same hits: attributes of the built-in "Hits" schema, and the same
+    # with one more attribute (generic path)
+    schemas = g4.GateGetDigiSchemas()
+    print(f"Digi schemas: {schemas}")
+    attributes = {
+        "schema": schemas["Hits"],
+        "generic": schemas["Hits"] + ["TrackID"],
+    }
+    outputs = {}
+    for name, att in attributes.items():
+        hc = sim.add_actor("DigitizerHitsCollectionActor", f"hits_{name}")
+        hc.attached_to = crystal
+        hc.output_filename = f"test168_{name}.root"
+        hc.attributes = att
+        # copy of all the attributes to the channel
+        ew = sim.add_actor("DigitizerEnergyWindowsActor", f"ew_{name}")
+        ew.attached_to = crystal
+        ew.input_digi_collection = hc.name
+        ew.channels = [{"name": f"window_{name}", "min": 100 * keV, "max": 600 * keV}]
+        ew.output_filename = hc.output_filename
+        outputs[name] = (hc, f"window_{name}")
+
+    sim.run()
+    print(stats)
+
+    # same values for the attributes of the schema
+    is_ok = True
+    for tree_index in range(2):
+        trees = {}
+        for name, (hc, channel) in outputs.items():
+            f = uproot.open(hc.get_output_path())
+            tree = hc.name if tree_index == 0 else channel
+            trees[name] = f[tree].arrays(library="np")
+        ref = trees["generic"]
+        out = trees["schema"]
+        n = len(out["TotalEnergyDeposit"])
+        b = n > 0 and "TrackID" not in out
+        utility.print_test(b, f"Tree {tree_index}: {n} digi")
+        is_ok = is_ok and b
+        for k in out.keys():
+            b = len(ref[k]) == len(out[k])
+            b = b and np.array_equal(np.sort(ref[k]), np.sort(out[k]))
+            utility.print_test(b, f"Branch {k}")
+            is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
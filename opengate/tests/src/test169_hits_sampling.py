@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test169")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 741852
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water box
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    # gammas in the box
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.activity = 5000 * Bq
+
+    # all the hits, sampled hits and a reservoir of hits
+    reservoir_size = 5000
+    actors = {}
+    for name in ["all", "sampled", "particle", "reservoir"]:
+        hc = sim.add_actor("DigitizerHitsCollectionActor", f"hits_{name}")
+        hc.attached_to = waterbox
+        hc.output_filename = f"test169_{name}.root"
+        hc.attributes = ["TotalEnergyDeposit", "Weight", "ParticleName"]
+        actors[name] = hc
+    actors["sampled"].sampling_probability = 0.2
+    actors["particle"].sampling_probability_per_particle = {"e-": 0.1}
+    actors["reservoir"].reservoir_size = reservoir_size
+
+    sim.run(start_new_process=False)
+
+    hits = {}
+    for name, hc in actors.items():
+        hits[name] = uproot.open(hc.get_output_path())[hc.name].arrays(library="np")
+    ref = hits["all"]
+    n = len(ref["Weight"])
+    ref_edep = np.sum(ref["TotalEnergyDeposit"])
+    print(f"All hits: {n}, edep {ref_edep / MeV:.2f} MeV")
+    is_ok = n > 2 * reservoir_size
+
+    # sampled hits: about 20% of the hits, same weighted edep
+    for name in ["sampled", "particle"]:
+        h = hits[name]
+        hc = actors[name]
+        b = hc.GetNumberOfCandidateHits() == n
+        electrons = ref["ParticleName"] == "e-"
+        p = 0.2 if name == "sampled" else 1 - 0.9 * np.mean(electrons)
+        expected = n * p
+        k = hc.GetNumberOfSampledHits()
+        b = b and k == len(h["Weight"])
+        b = b and abs(k - expected) < 5 * np.sqrt(n * p * (1 - p))
+        edep = np.sum(h["TotalEnergyDeposit"] * h["Weight"])
+        d = abs(edep - ref_edep) / ref_edep
+        b = b and d < 0.05
+        utility.print_test(
+            b, f"{name}: {k} hits (expected {expected:.0f}), weighted edep diff {d:.3f}"
+        )
+        is_ok = is_ok and b
+
+    # per particle: the weights are 10 for the electrons, 1 for the others
+    h = hits["particle"]
+    w = np.where(h["ParticleName"] == "e-", 10.0, 1.0)
+    b = np.allclose(h["Weight"], w)
+    utility.print_test(b, "particle: weights of the sampled hits")
+    is_ok = is_ok and b
+
+    # reservoir: N hits, the weights sum to the number of hits
+    h = hits["reservoir"]
+    b = len(h["Weight"]) == reservoir_size
+    b = b and abs(np.sum(h["Weight"]) - n) < 1e-6 * n
+    edep = np.sum(h["TotalEnergyDeposit"] * h["Weight"])
+    d = abs(edep - ref_edep) / ref_edep
+    b = b and d < 0.15
+    utility.print_test(
+        b, f"reservoir: {len(h['Weight'])} hits, weighted edep diff {d:.3f}"
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import uproot
+
+
+def run_simulation(paths, name, n, forced_detection):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    keV = gate.g4_units.keV
+
+    sim = gate.Simulation()
+    sim.random_seed = 258147
+    sim.number_of_threads = 4
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [2 * m, 2 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+
+    # voxelized phantom
+    phantom = sim.add_volume("Image", "phantom")
+    phantom.image = paths.output / "test170_phantom.mhd"
+    phantom.material = "G4_WATER"
+    phantom.voxel_materials = [
+        [-1, 500, "G4_WATER"],
+        [500, 2000, "G4_BONE_CORTICAL_ICRP"],
+    ]
+
+    # detector plane
+    detector = sim.add_volume("Box", "detector")
+    detector.size = [1 * m, 1 * m, 1 * mm]
+    detector.translation = [0, 0, 30 * cm]
+    detector.material = "G4_Galactic"
+
+    # isotropic point source in the phantom, below the bone slab, at the
+    # center of a pixel of the projection
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 140.5 * keV
+    source.position.type = "point"
+    source.position.translation = [2.5 * cm, 0.5 * cm, 1 * cm]
+    source.direction.type = "iso"
+
+    if forced_detection:
+        # primary projection only
+        fd = sim.add_actor("ForcedDetectionActor", "fd")
+        fd.attached_to = phantom
+        fd.detector = detector.name
+        fd.size = [100, 100]
+        fd.spacing = [10 * mm, 10 * mm]
+        fd.energy_min = 130 * keV
+        fd.energy_max = 150 * keV
+        fd.interactions = []
+        fd.primary = True
+        fd.output_filename = f"test170_{name}.mhd"
+    else:
+        phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+        phsp.attached_to = detector
+        phsp.output_filename = f"test170_{name}.root"
+        phsp.attributes = ["KineticEnergy", "Weight", "PreDirection"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics"
+    sim.physics_manager.global_production_cuts.all = 1 * m
+
+    sim.run(start_new_process=True)
+    if forced_detection:
+        return fd.projection.get_output_path()
+    return phsp.get_output_path()
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test170")
+    utility.create_water_bone_phantom(paths.output / "test170_phantom.mhd")
+    keV = gate.g4_units.keV
+
+    # analog reference: unscattered photons reaching the detector plane in a
+    # small cone around its normal, per steradian
+    n_ref = 1000000
+    a = uproot.open(run_simulation(paths, "ref", n_ref, False))["phsp"]
+    a = a.arrays(library="np")
+    alpha = 0.15
+    solid_angle = 2 * np.pi * (1 - np.cos(alpha))
+    s = (a["PreDirection_Z"] > np.cos(alpha)) & (a["KineticEnergy"] > 140 * keV)
+    ref = a["Weight"][s].sum() / n_ref / solid_angle
+    ref_error = np.sqrt(s.sum()) / n_ref / solid_angle
+
+    # analytical primary projection, with very few primaries
+    n_fd = 1000
+    path = run_simulation(paths, "fd", n_fd, True)
+    proj = itk.array_from_image(itk.imread(str(path)))
+    fd = proj.sum() / n_fd
+
+    tol = 0.1
+    is_ok = abs(fd - ref) / ref < tol
+    utility.print_test(
+        is_ok,
+        f"Primary per primary per sr: analytical {fd:.5f}, "
+        f"analog {ref:.5f} +/- {ref_error:.5f} (tol {tol})",
+    )
+
+    # all the primaries are projected in the pixel of the source, with the
+    # same value (same line integral)
+    b = np.count_nonzero(proj) == 1
+    utility.print_test(b, f"Primary projection in {np.count_nonzero(proj)} pixel")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+
+
+def add_dose_actor(sim, name, volume, mode):
+    mm = gate.g4_units.mm
+    dose = sim.add_actor("DoseActor", name)
+    dose.attached_to = volume
+    dose.size = [50, 50, 50]
+    dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+    dose.hit_type = "middle"
+    dose.dose.active = True
+    dose.dose_uncertainty.active = True
+    dose.counts.active = True
+    dose.scoring_mode = mode
+    dose.output_filename = f"test171_{name}.mhd"
+    return dose
+
+
+def add_let_actor(sim, name, volume, mode):
+    mm = gate.g4_units.mm
+    let = sim.add_actor("LETActor", name)
+    let.attached_to = volume
+    let.size = [50, 50, 50]
+    let.spacing = [2 * mm, 2 * mm, 2 * mm]
+    let.hit_type = "middle"
+    let.averaging_method = "dose_average"
+    let.scoring_mode = mode
+    let.output_filename = f"test171_{name}.mhd"
+    return let
+
+
+def add_fluence_actor(sim, name, volume, mode):
+    mm = gate.g4_units.mm
+    fluence = sim.add_actor("FluenceActor", name)
+    fluence.attached_to = volume
+    fluence.size = [50, 50, 50]
+    fluence.spacing = [2 * mm, 2 * mm, 2 * mm]
+    fluence.hit_type = "middle"
+    fluence.scoring_mode = mode
+    fluence.output_filename = f"test171_{name}.mhd"
+    return fluence
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test171")
+
+    # create the simulation
+    sim = gate.Simulation()
+
+    # main options
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 4
+    sim.random_seed = 654321
+    sim.output_dir = paths.output
+
+    # shortcuts to units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+
+    #  change world size
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    # waterbox
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # proton beam
+    source = sim.add_source("GenericSource", "mysource")
+    source.energy.mono = 100 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 5 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 500
+
+    # reference: shared images protected by a mutex at each step
+    dose_ref = add_dose_actor(sim, "mutex", waterbox, "mutex")
+
+    # same images, the deposits are queued and applied by batches (small
+    # queue so that many batches are applied during the run)
+    dose_q = add_dose_actor(sim, "queue", waterbox, "queue")
+    dose_q.queue_size = 256
+
+    # same for the LET (numerator and denominator queued together) and the
+    # fluence
+    let_ref = add_let_actor(sim, "let_mutex", waterbox, "mutex")
+    let_q = add_let_actor(sim, "let_queue", waterbox, "queue")
+    let_q.queue_size = 256
+    fluence_ref = add_fluence_actor(sim, "fluence_mutex", waterbox, "mutex")
+    fluence_q = add_fluence_actor(sim, "fluence_queue", waterbox, "queue")
+    fluence_q.queue_size = 256
+
+    # add stat actor
+    stats = sim.add_actor("SimulationStatisticsActor", "Stats")
+
+    # start simulation
+    sim.run()
+    print(stats)
+
+    # the batches are applied during the run, not only at the end
+    n = dose_q.GetNumberOfQueueFlushes()
+    print(f"Number of batches of deposits applied: {n}")
+    is_ok = n > sim.number_of_threads
+    utility.print_test(is_ok, f"Queue applied during the run: {is_ok}")
+
+    # same images as the mutex (up to the summation order), the squared
+    # values are still scored history by history
+    for output in ("edep", "dose", "counts", "dose_uncertainty"):
+        print(f"Compare {output} with scoring_mode=queue")
+        is_ok = (
+            utility.assert_images(
+                dose_ref.get_output_path(output),
+                dose_q.get_output_path(output),
+                stats,
+                tolerance=1e-6,
+                sum_tolerance=1e-6,
+            )
+            and is_ok
+        )
+    for ref, actor, output in (
+        (let_ref, let_q, "let"),
+        (fluence_ref, fluence_q, "fluence"),
+    ):
+        print(f"Compare {output} with scoring_mode=queue")
+        is_ok = (
+            utility.assert_images(
+                ref.get_output_path(output),
+                actor.get_output_path(output),
+                stats,
+                tolerance=1e-6,
+                sum_tolerance=1e-6,
+            )
+            and is_ok
+        )
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import itk
+import numpy as np
+import scipy.sparse
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, None, output_folder="test172")
+
+    # units
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    keV = gate.g4_units.keV
+    um = gate.g4_units.um
+
+    sim = gate.Simulation()
+    sim.g4_verbose = False
+    sim.visu = False
+    sim.number_of_threads = 2
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+
+    world = sim.world
+    world.size = [1 * m, 1 * m, 1 * m]
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [4 * cm, 4 * cm, 10 * cm]
+    waterbox.material = "G4_WATER"
+
+    # proton beam, stopping in the box (Bragg peak: high LET at the end)
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "proton"
+    source.energy.mono = 80 * MeV
+    source.position.type = "disc"
+    source.position.radius = 2 * mm
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.n = 2000
+
+    # dose averaged LET along the depth, with the spectrum of each voxel
+    let = sim.add_actor("LETActor", "let")
+    let.attached_to = waterbox
+    let.size = [1, 1, 50]
+    let.spacing = [4 * cm, 4 * cm, 2 * mm]
+    let.hit_type = "random"
+    let.averaging_method = "dose_average"
+    let.score_in = "material"
+    let.spectrum_number_of_bins = 200
+    let.spectrum_let_min = 0.1 * keV / um
+    let.spectrum_let_max = 1000 * keV / um
+    let.output_filename = "test172_let.mhd"
+    let.let_spectrum.output_filename = "test172_let_spectrum.npz"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    sim.run()
+    print(stats)
+
+    spectrum = let.get_spectrum()
+    edges = let.get_spectrum_bin_edges()
+    print(f"Spectrum matrix: {spectrum.shape}, {spectrum.nnz} non zero elements")
+    is_ok = spectrum.shape == (50, 200) and len(edges) == 201
+
+    # the sum of the spectrum of a voxel is its edep (the LET denominator)
+    den = itk.array_view_from_image(let.denominator.get_data()).ravel()
+    sums = np.asarray(spectrum.sum(axis=1)).ravel()
+    b = np.allclose(sums, den, rtol=1e-9, atol=0)
+    utility.print_test(b, f"Spectrum sums equal the edep: {b}")
+    is_ok = is_ok and b
+
+    # the mean of the spectrum is the dose averaged LET, up to the bin width
+    # (ratio of the edges: 1.047)
+    letd = itk.array_view_from_image(let.let.get_data()).ravel()
+    centers = np.sqrt(edges[:-1] * edges[1:]) / (keV / um)
+    mask = den > 0
+    mean = (spectrum @ centers)[mask] / sums[mask]
+    ref = letd[mask] / (keV / um)
+    diff = np.max(np.abs(mean - ref) / ref)
+    b = diff < 0.03
+    utility.print_test(b, f"Mean of the spectra vs LETd: max diff {diff:.4f}")
+    is_ok = is_ok and b
+
+    # the LET increases towards the Bragg peak: the spectrum of the last
+    # voxels with edep is shifted to higher LET
+    first = np.flatnonzero(mask)[0]
+    last = np.flatnonzero(mask)[-1]
+    b = mean[-1] > mean[0]
+    utility.print_test(
+        b,
+        f"Mean LET of voxel {first}: {mean[0]:.2f} keV/um, "
+        f"of voxel {last}: {mean[-1]:.2f} keV/um",
+    )
+    is_ok = is_ok and b
+
+    # the matrix is also written in the output
+    written = scipy.sparse.load_npz(let.let_spectrum.get_output_path())
+    b = written.shape == spectrum.shape and np.allclose(
+        written.toarray(), spectrum.toarray()
+    )
+    utility.print_test(b, f"Spectrum written: {b}")
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
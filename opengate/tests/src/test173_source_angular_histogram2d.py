@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def theta_phi(a):
+    # (the directions of the histogram are (-sin cos, -sin sin, -cos))
+    theta = np.arccos(np.clip(-a["PreDirection_Z"], -1, 1))
+    phi = np.arctan2(-a["PreDirection_Y"], -a["PreDirection_X"])
+    return theta, np.mod(phi, 2 * np.pi)
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test173")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+    deg = gate.g4_units.deg
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [2 * m, 2 * m, 2 * m]
+    sim.world.material = "G4_Galactic"
+
+    detector = sim.add_volume("Box", "detector")
+    detector.size = [1.5 * m, 1.5 * m, 1 * mm]
+    detector.translation = [0, 0, -20 * cm]
+    detector.material = "G4_Galactic"
+
+    # two lines, one direction table per line:
+    # 1 MeV: theta in [0, 10] deg, phi in [0, 180] (3/4) or [180, 360] (1/4)
+    # 2 MeV: theta in [10, 20] deg, phi in [180, 360]
+    source = sim.add_source("GenericSource", "source")
+    source.particle = "gamma"
+    source.n = 100000 / sim.number_of_threads
+    source.position.type = "point"
+    source.energy.type = "spectrum_discrete"
+    source.energy.spectrum_energies = [1 * MeV, 2 * MeV]
+    source.energy.spectrum_weights = [0.5, 0.5]
+    source.direction.type = "histogram2d"
+    source.direction.histogram2d_theta_angles = [0, 10 * deg, 20 * deg]
+    source.direction.histogram2d_phi_angles = [0, 180 * deg, 360 * deg]
+    source.direction.histogram2d_weights = [
+        [[3, 1], [0, 0]],
+        [[0, 0], [0, 1]],
+    ]
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = detector
+    phsp.output_filename = "test173_phsp.root"
+    phsp.attributes = ["KineticEnergy", "PreDirection"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics"
+
+    sim.run()
+
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    theta, phi = theta_phi(a)
+    low = a["KineticEnergy"] < 1.5 * MeV
+    high = ~low
+    eps = 1e-6
+
+    is_ok = True
+    print(f"Number of particles: {len(theta)} ({low.sum()} at 1 MeV)")
+    fraction = low.sum() / len(theta)
+    is_ok = utility.check_diff_abs(fraction, 0.5, 0.01, "1 MeV fraction") and is_ok
+
+    # 1 MeV table
+    b = np.all(theta[low] <= 10 * deg + eps)
+    utility.print_test(b, f"1 MeV: theta max {np.degrees(theta[low].max()):.3f}")
+    is_ok = b and is_ok
+    fraction = np.mean(phi[low] < np.pi)
+    is_ok = (
+        utility.check_diff_abs(fraction, 0.75, 0.01, "1 MeV: phi < 180 fraction")
+        and is_ok
+    )
+
+    # 2 MeV table
+    b = np.all((theta[high] >= 10 * deg - eps) & (theta[high] <= 20 * deg + eps))
+    utility.print_test(b, "2 MeV: theta in [10, 20] deg")
+    is_ok = b and is_ok
+    b = np.all(phi[high] >= np.pi - eps)
+    utility.print_test(b, "2 MeV: phi in [180, 360] deg")
+    is_ok = b and is_ok
+
+    # uniform in cos(theta) within the bin: mean of cos theta at its center
+    c = np.cos(theta[high])
+    expected = (np.cos(10 * deg) + np.cos(20 * deg)) / 2
+    is_ok = (
+        utility.check_diff_abs(c.mean(), expected, 5e-4, "2 MeV: mean cos theta")
+        and is_ok
+    )
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test174")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+    ms = gate.g4_units.ms
+
+    sim = gate.Simulation()
+    sim.random_seed = 963852
+    sim.number_of_threads = 1
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water box
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    # gammas in the box
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.activity = 5000 * Bq
+
+    # the same hits, cleared every N events or kept in a ring buffer of the
+    # last events, with an adder on each collection
+    attributes = [
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+        "EventID",
+    ]
+    actors = {}
+    for name in ["clear", "events", "time"]:
+        hc = sim.add_actor("DigitizerHitsCollectionActor", f"hits_{name}")
+        hc.attached_to = waterbox
+        hc.output_filename = f"test174_{name}.root"
+        hc.attributes = attributes
+        sc = sim.add_actor("DigitizerAdderActor", f"singles_{name}")
+        sc.attached_to = waterbox
+        sc.input_digi_collection = hc.name
+        sc.output_filename = f"test174_{name}.root"
+        actors[name] = (hc, sc)
+    actors["events"][0].retention_events = 5
+    actors["time"][0].retention_time = 10 * ms
+    actors["time"][0].retention_events = 50
+
+    sim.run(start_new_process=False)
+
+    def read(actor):
+        f = uproot.open(actor.get_output_path())
+        return f[actor.name].arrays(library="np")
+
+    ref_hits = read(actors["clear"][0])
+    ref_singles = read(actors["clear"][1])
+    n = len(ref_hits["EventID"])
+    print(f"Hits: {n}, singles: {len(ref_singles['EventID'])}")
+    is_ok = n > 1000
+
+    # all the hits are written once, in the same order, and the adder reads
+    # the current event of the retained collections
+    for name in ["events", "time"]:
+        hc, sc = actors[name]
+        hits = read(hc)
+        singles = read(sc)
+        b = len(hits["EventID"]) == n
+        for k in ["EventID", "TotalEnergyDeposit", "GlobalTime"]:
+            b = b and np.array_equal(hits[k], ref_hits[k])
+            b = b and np.array_equal(singles[k], ref_singles[k])
+        utility.print_test(
+            b, f"{name}: {len(hits['EventID'])} hits, same hits and singles"
+        )
+        is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
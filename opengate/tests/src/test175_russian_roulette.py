@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+
+
+def run_simulation(paths, name, nb_split, n, roulette=False):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    um = gate.g4_units.um
+    km = gate.g4_units.km
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 147369
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # water slab
+    slab = sim.add_volume("Box", "slab")
+    slab.size = [20 * cm, 20 * cm, 10 * cm]
+    slab.material = "G4_WATER"
+
+    # phase space on a sphere around the slab
+    shell = sim.add_volume("Sphere", "shell")
+    shell.rmin = 40 * cm
+    shell.rmax = 40 * cm + 1 * mm
+    shell.material = "G4_Galactic"
+
+    # photon beam
+    source = sim.add_source("GenericSource", "beam")
+    source.particle = "gamma"
+    source.n = n / sim.number_of_threads
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.position.translation = [0, 0, -10 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+
+    if nb_split > 1:
+        split = sim.add_actor("ComptSplittingActor", "split")
+        split.attached_to = slab
+        split.splitting_factor = nb_split
+        split.splitting_mode = "klein_nishina"
+
+    # the photons split twice (weight 1/400) are rouletted, the survivors
+    # have the weight of the photons split once (1/20)
+    rr = None
+    if roulette:
+        rr = sim.add_actor("RussianRouletteActor", "rr")
+        rr.attached_to = slab
+        rr.weight_threshold = 0.01
+        rr.survival_weight = 0.05
+        rr.per_particle = {"e-": [0, 0]}
+
+    phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+    phsp.attached_to = shell
+    phsp.output_filename = f"test175_{name}.root"
+    phsp.attributes = ["KineticEnergy", "Weight", "PDGCode"]
+
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option2"
+    # (the compt process must not be hidden by the general gamma process)
+    sim.g4_commands_before_init.append("/process/em/UseGeneralProcess false")
+    sim.physics_manager.global_production_cuts.gamma = 1 * m
+    sim.physics_manager.global_production_cuts.electron = 1 * um
+    sim.physics_manager.global_production_cuts.positron = 1 * km
+
+    sim.run(start_new_process=False)
+    a = uproot.open(phsp.get_output_path())["phsp"].arrays(library="np")
+    s = (a["PDGCode"] == 22) & (a["KineticEnergy"] < 0.999 * MeV)
+    return a["Weight"][s], a["KineticEnergy"][s], rr
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test175")
+
+    # analog reference, splitting, splitting with roulette
+    n_ref = 50000
+    n = 5000
+    w_ref, e_ref, _ = run_simulation(paths, "ref", 1, n_ref)
+    w_split, e_split, _ = run_simulation(paths, "split", 20, n)
+    w_rr, e_rr, rr = run_simulation(paths, "roulette", 20, n, True)
+    print(rr)
+
+    is_ok = True
+    ref = (w_ref.sum() / n_ref, np.average(e_ref, weights=w_ref))
+    rou = (w_rr.sum() / n, np.average(e_rr, weights=w_rr))
+    tols = [0.05, 0.03]
+    names = ["Scattered photons per primary", "Mean energy"]
+    for name, r, k, tol in zip(names, ref, rou, tols):
+        b = abs(k - r) / abs(r) < tol
+        utility.print_test(b, f"{name}: {k:.4f} vs {r:.4f} (tol {tol})")
+        is_ok = is_ok and b
+
+    # fewer photons are tracked, no weight below the threshold
+    b = len(w_rr) < 0.5 * len(w_split) and w_rr.min() >= 0.01
+    utility.print_test(
+        b,
+        f"Scattered photons {len(w_rr)} with roulette vs {len(w_split)}, "
+        f"min weight {w_rr.min():.4f}",
+    )
+    is_ok = is_ok and b
+
+    # the killed weight is restored to the survivors (on average)
+    b = rr.number_of_roulette_particles > 0
+    d = abs(rr.killed_weight - rr.survival_added_weight) / rr.killed_weight
+    b = b and d < 0.05
+    utility.print_test(
+        b,
+        f"Killed weight {rr.killed_weight:.2f} vs survival added weight "
+        f"{rr.survival_added_weight:.2f}",
+    )
+    is_ok = is_ok and b
+
+    utility.test_ok(is_ok)
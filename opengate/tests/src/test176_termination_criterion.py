@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import itk
+import uproot
+
+
+def create_simulation(paths, criterion):
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 741852
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    # world
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    # water phantom (scatter)
+    phantom = sim.add_volume("Box", "phantom")
+    phantom.size = [20 * cm, 20 * cm, 10 * cm]
+    phantom.material = "G4_WATER"
+
+    # crystal
+    crystal = sim.add_volume("Box", "crystal")
+    crystal.size = [30 * cm, 30 * cm, 1 * cm]
+    crystal.translation = [0, 0, 15 * cm]
+    crystal.material = "G4_SODIUM_IODIDE"
+
+    # Tc99m gammas in the phantom, far too many: the runs are ended by the
+    # termination criterion
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 140.5 * keV
+    source.position.type = "sphere"
+    source.position.radius = 3 * cm
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 1e7 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    if criterion == "phsp":
+        phsp = sim.add_actor("PhaseSpaceActor", "phsp")
+        phsp.attached_to = crystal
+        phsp.attributes = ["KineticEnergy", "PrePosition"]
+        phsp.output_filename = "test176_phsp.root"
+        phsp.termination_count = 20000
+        return sim, stats, phsp
+
+    # hits, singles and projection with energy windows
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = crystal
+    hc.attributes = ["PostPosition", "TotalEnergyDeposit", "GlobalTime"]
+    hc.root_output.write_to_disk = False
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = crystal
+    sc.input_digi_collection = hc.name
+    sc.policy = "EnergyWinnerPosition"
+    sc.root_output.write_to_disk = False
+    proj = sim.add_actor("DigitizerProjectionActor", "projection")
+    proj.attached_to = crystal
+    proj.input_digi_collections = [sc.name]
+    proj.energy_windows = [
+        {"name": "scatter", "min": 108.578 * keV, "max": 129.057 * keV},
+        {"name": "peak140", "min": 129.057 * keV, "max": 149.536 * keV},
+    ]
+    proj.spacing = [4 * mm, 4 * mm]
+    proj.size = [64, 64]
+    proj.output_filename = "test176_projection.mhd"
+    proj.user_output["projection"].set_write_to_disk(True)
+    # SNR 4 for the mean pixel of the central 16x16 pixels of the peak
+    proj.termination_channel = 1
+    proj.termination_roi = [24, 40, 24, 40]
+    proj.termination_snr = 4
+    return sim, stats, proj
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test176")
+    is_ok = True
+    expected_events = 1e7
+
+    # phase space: at least the target, a few more (events in progress)
+    sim, stats, phsp = create_simulation(paths, "phsp")
+    sim.run(start_new_process=True)
+    print(stats)
+    f = uproot.open(phsp.get_output_path())
+    n = f[phsp.name].num_entries
+    b = 20000 <= n < 20000 * 1.02
+    utility.print_test(b, f"Phase space: {n} entries (target 20000)")
+    is_ok = b and is_ok
+    b = stats.counts.events < expected_events / 10
+    utility.print_test(b, f"Phase space: {stats.counts.events} events")
+    is_ok = b and is_ok
+
+    # projection: SNR^2 x pixels counts in the ROI of the peak window
+    sim, stats, proj = create_simulation(paths, "projection")
+    sim.run(start_new_process=True)
+    print(stats)
+    img = itk.array_view_from_image(itk.imread(proj.get_output_path()))
+    target = 4 * 4 * 16 * 16
+    n = np.sum(img[1, 24:40, 24:40])
+    b = target <= n < target * 1.02
+    utility.print_test(b, f"Projection: {n} counts in the ROI (target {target})")
+    is_ok = b and is_ok
+    roi = img[1, 24:40, 24:40]
+    snr = roi.mean() / np.sqrt(roi.mean())
+    b = snr >= 4
+    utility.print_test(b, f"Projection: SNR of the mean pixel {snr:.3f}")
+    is_ok = b and is_ok
+    b = stats.counts.events < expected_events / 10
+    utility.print_test(b, f"Projection: {stats.counts.events} events")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import time
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test177")
+
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    keV = gate.g4_units.keV
+
+    sim = gate.Simulation()
+    sim.random_seed = 147258
+    sim.number_of_threads = 4
+    sim.output_dir = paths.output
+
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_Galactic"
+
+    # many sources (e.g. one per lesion), each one with a large spectrum: the
+    # user info is converted by the master thread only
+    rng = np.random.default_rng(123)
+    n_sources = 300
+    n = 5
+    energies = np.linspace(10, 500, 1000) * keV
+    sources = []
+    for i in range(n_sources):
+        source = sim.add_source("GenericSource", f"lesion_{i}")
+        source.particle = "gamma"
+        source.n = n
+        source.position.type = "sphere"
+        source.position.radius = 1 * cm
+        source.position.translation = list(rng.uniform(-20, 20, 3) * cm)
+        source.direction.type = "iso"
+        source.energy.type = "spectrum_discrete"
+        source.energy.spectrum_energies = energies
+        source.energy.spectrum_weights = rng.uniform(0, 1, len(energies))
+        sources.append(source)
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    t = time.time()
+    sim.run(start_new_process=False)
+    print(f"Simulation time: {time.time() - t:.2f} s")
+    print(stats)
+
+    # all the primaries of all the sources (n per thread)
+    expected = n_sources * n * sim.number_of_threads
+    is_ok = stats.counts.events == expected
+    utility.print_test(is_ok, f"Events: {stats.counts.events} (expected {expected})")
+
+    # the workers read the values of the master
+    replayed = [s.GetNumberOfReplayedUserInfoValues() for s in sources]
+    b = min(replayed) > 0
+    utility.print_test(b, f"Values read from the snapshots: {sum(replayed)}")
+    is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
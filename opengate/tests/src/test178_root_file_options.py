@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+import numpy as np
+import uproot
+import os
+
+
+def create_simulation(paths, name):
+    # units
+    m = gate.g4_units.m
+    cm = gate.g4_units.cm
+    MeV = gate.g4_units.MeV
+    Bq = gate.g4_units.Bq
+
+    sim = gate.Simulation()
+    sim.random_seed = 852963
+    sim.number_of_threads = 2
+    sim.output_dir = paths.output
+
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.world.material = "G4_AIR"
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [20 * cm, 20 * cm, 20 * cm]
+    waterbox.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "gammas")
+    source.particle = "gamma"
+    source.energy.mono = 1 * MeV
+    source.position.type = "point"
+    source.direction.type = "iso"
+    source.activity = 20000 * Bq / sim.number_of_threads
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+
+    # hits and singles in the same file
+    hc = sim.add_actor("DigitizerHitsCollectionActor", "hits")
+    hc.attached_to = waterbox
+    hc.output_filename = f"test178_{name}.root"
+    hc.attributes = [
+        "TotalEnergyDeposit",
+        "PostPosition",
+        "PreStepUniqueVolumeID",
+        "GlobalTime",
+        "EventID",
+    ]
+    sc = sim.add_actor("DigitizerAdderActor", "singles")
+    sc.attached_to = waterbox
+    sc.input_digi_collection = hc.name
+    sc.output_filename = f"test178_{name}.root"
+    return sim, stats, hc, sc
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test178")
+    is_ok = True
+
+    # Geant4 defaults
+    sim, stats, hc, sc = create_simulation(paths, "default")
+    sim.run(start_new_process=True)
+    ref = uproot.open(hc.get_output_path())[hc.name].arrays(library="np")
+    ref_size = os.path.getsize(hc.get_output_path())
+
+    # large baskets, no compression
+    sim, stats, hc, sc = create_simulation(paths, "tuned")
+    hc.root_output.basket_size = 256000
+    hc.root_output.basket_entries = 16000
+    hc.root_output.compression_level = 0
+    sc.root_output.compression_level = 0
+    sim.run(start_new_process=True)
+    print(stats)
+    f = uproot.open(hc.get_output_path())
+    a = f[hc.name].arrays(library="np")
+    size = os.path.getsize(hc.get_output_path())
+
+    # same content
+    b = len(a["EventID"]) == len(ref["EventID"]) and len(a["EventID"]) > 1000
+    for k in ["EventID", "TotalEnergyDeposit", "GlobalTime"]:
+        b = b and np.array_equal(np.sort(a[k]), np.sort(ref[k]))
+    utility.print_test(b, f"Same hits: {len(a['EventID'])}")
+    is_ok = b and is_ok
+
+    # not compressed: larger file
+    b = size > ref_size
+    utility.print_test(b, f"File size: {size} (compressed: {ref_size})")
+    is_ok = b and is_ok
+
+    # larger baskets: fewer baskets per branch
+    n = f[hc.name]["EventID"].num_baskets
+    n_ref = uproot.open(paths.output / "test178_default.root")[hc.name][
+        "EventID"
+    ].num_baskets
+    b = n < n_ref
+    utility.print_test(b, f"Number of baskets: {n} (default: {n_ref})")
+    is_ok = b and is_ok
+
+    # the options are in the statistics output
+    o = stats.counts.root_output[str(hc.get_output_path())]
+    b = o["basket_size"] == 256000 and o["basket_entries"] == 16000
+    b = b and o["compression"] == "none" and o["compression_level"] == 0
+    utility.print_test(b, f"Statistics output: {o}")
+    is_ok = b and is_ok
+
+    # the options of the outputs must agree, and only zlib is available
+    for option, value in [("compression_level", 5), ("compression", "lz4")]:
+        sim, stats, hc, sc = create_simulation(paths, "error")
+        hc.root_output.compression_level = 0
+        setattr(sc.root_output, option, value)
+        try:
+            sim.run(start_new_process=True)
+            b = False
+        except Exception:
+            b = True
+        utility.print_test(b, f"Error for {option} = {value}")
+        is_ok = b and is_ok
+
+    utility.test_ok(is_ok)
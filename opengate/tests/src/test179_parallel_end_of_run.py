@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.image import (
+    create_3d_image,
+    sum_itk_images,
+    divide_itk_images,
+    parallel_image_reductions,
+)
+from opengate.actors.dataitems import SingleItkImageWithVariance
+import itk
+import numpy as np
+
+
+def random_image(rng, size):
+    img = create_3d_image(size, [1, 1, 1], pixel_type="double")
+    arr = itk.array_view_from_image(img)
+    arr[:] = rng.uniform(0, 1, arr.shape)
+    # (zeros, filtered by the division and the uncertainty)
+    arr[rng.uniform(0, 1, arr.shape) < 0.2] = 0
+    return img
+
+
+def reductions(images):
+    s = sum_itk_images(images)
+    d = divide_itk_images(images[0], images[1])
+    v = SingleItkImageWithVariance(None, data=[images[0], images[2]])
+    v.data[0].number_of_samples = 1000
+    u = v.uncertainty.data
+    return [itk.array_from_image(i) for i in (s, d, u)]
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test179")
+    is_ok = True
+
+    # the python reductions by slices give the same values
+    rng = np.random.default_rng(789)
+    images = [random_image(rng, [120, 100, 90]) for _ in range(3)]
+    ref = reductions(images)
+    with parallel_image_reductions(4):
+        results = reductions(images)
+    for name, a, b in zip(["sum", "division", "uncertainty"], ref, results):
+        ok = a.dtype == b.dtype and np.array_equal(a, b)
+        utility.print_test(ok, f"Python {name} with 4 threads: same values")
+        is_ok = ok and is_ok
+
+    # the per-thread buffers are merged by stripes of slices, with several
+    # runs and a number of slices that is not a multiple of the tiles
+    mm = gate.g4_units.mm
+    cm = gate.g4_units.cm
+    m = gate.g4_units.m
+    MeV = gate.g4_units.MeV
+    sec = gate.g4_units.s
+
+    sim = gate.Simulation()
+    sim.number_of_threads = 8
+    sim.random_seed = 654987
+    sim.output_dir = paths.output
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    sim.run_timing_intervals = [[0, 1 * sec], [1 * sec, 2 * sec]]
+
+    waterbox = sim.add_volume("Box", "waterbox")
+    waterbox.size = [10 * cm, 10 * cm, 20.2 * cm]
+    waterbox.material = "G4_WATER"
+
+    source = sim.add_source("GenericSource", "protons")
+    source.energy.mono = 120 * MeV
+    source.particle = "proton"
+    source.position.type = "disc"
+    source.position.radius = 2 * cm
+    source.position.translation = [0, 0, -20 * cm]
+    source.direction.type = "momentum"
+    source.direction.momentum = [0, 0, 1]
+    source.activity = 200 / sec
+
+    actors = {}
+    for mode in ["mutex", "thread_local", "sparse"]:
+        dose = sim.add_actor("DoseActor", f"dose_{mode}")
+        dose.attached_to = waterbox
+        dose.size = [50, 50, 101]
+        dose.spacing = [2 * mm, 2 * mm, 2 * mm]
+        dose.hit_type = "middle"
+        dose.dose.active = True
+        dose.dose_uncertainty.active = True
+        dose.scoring_mode = mode
+        dose.output_filename = f"test179_{mode}.mhd"
+        actors[mode] = dose
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    sim.run()
+    print(stats)
+
+    ref = actors["mutex"]
+    for mode in ["thread_local", "sparse"]:
+        for output in ["edep", "dose", "dose_uncertainty"]:
+            print(f"Compare {output} with scoring_mode={mode}")
+            is_ok = (
+                utility.assert_images(
+                    ref.get_output_path(output),
+                    actors[mode].get_output_path(output),
+                    stats,
+                    tolerance=1e-6,
+                    sum_tolerance=1e-6,
+                )
+                and is_ok
+            )
+
+    utility.test_ok(is_ok)
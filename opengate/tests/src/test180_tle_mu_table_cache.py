@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import opengate as gate
+from opengate.tests import utility
+from opengate.tests.src.test081_tle_helpers import (
+    add_waterbox,
+    add_source,
+    plot_pdd,
+    compare_pdd,
+)
+import shutil
+import os
+
+
+def create_simulation(paths, cache_folder):
+    # units
+    m = gate.g4_units.m
+    mm = gate.g4_units.mm
+    MeV = gate.g4_units.MeV
+
+    sim = gate.Simulation()
+    sim.random_seed = 321654
+    sim.output_dir = paths.output
+    sim.number_of_threads = 1
+    sim.world.size = [1 * m, 1 * m, 1 * m]
+    waterbox = add_waterbox(sim)
+
+    # physics
+    sim.physics_manager.physics_list_name = "G4EmStandardPhysics_option3"
+    sim.physics_manager.global_production_cuts.all = 1 * mm
+    sim.physics_manager.set_max_step_size("waterbox", 1 * mm)
+    sim.physics_manager.set_user_limits_particles("gamma")
+
+    add_source(sim, n=2e4, energy=0.3 * MeV, sigma=0.2 * MeV, radius=20 * mm)
+
+    # same TLE dose with the simulated and the EPDL mu/mu_en tables
+    actors = []
+    for database in ["simulated", "EPDL"]:
+        tle = sim.add_actor("TLEDoseActor", f"tle_{database}")
+        tle.output_filename = f"test180_{database}.mhd"
+        tle.attached_to = waterbox
+        tle.dose.active = True
+        tle.dose_uncertainty.active = True
+        tle.size = [1, 1, 200]
+        tle.spacing = [x / y for x, y in zip(waterbox.size, tle.size)]
+        tle.database = database
+        actors.append(tle)
+    actors[0].mu_table_cache_folder = str(cache_folder)
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim, stats, actors
+
+
+def cache_files(cache_folder):
+    # the inode and the modification time change if a file is written again
+    files = sorted(cache_folder.glob("mu_*.bin"))
+    return {f.name: (os.stat(f).st_ino, os.stat(f).st_mtime_ns) for f in files}
+
+
+if __name__ == "__main__":
+    paths = utility.get_default_test_paths(__file__, output_folder="test180")
+    cache_folder = paths.output / "mu_cache"
+    shutil.rmtree(cache_folder, ignore_errors=True)
+
+    # first job: the tables are simulated and written in the cache
+    sim, stats, actors = create_simulation(paths, cache_folder)
+    sim.run(start_new_process=True)
+    print(stats)
+    written = cache_files(cache_folder)
+    # (world, water, propane and pyrex)
+    is_ok = len(written) == 4
+    utility.print_test(is_ok, f"Tables written in the cache: {len(written)}")
+
+    # second job: the tables are read from the cache, not written again
+    sim, stats, actors = create_simulation(paths, cache_folder)
+    sim.run(start_new_process=True)
+    print(stats)
+    reloaded = cache_files(cache_folder)
+    b = reloaded == written
+    utility.print_test(b, f"Tables reloaded from the cache: {len(reloaded)}")
+    is_ok = b and is_ok
+
+    # the dose with the reloaded tables agrees with the EPDL tables
+    ax, plt = plot_pdd(actors[1], actors[0])
+    spacing = actors[0].spacing[2]
+    for i, output in enumerate(["edep", "dose"]):
+        print(f"Compare {output} simulated/EPDL")
+        f1 = actors[1].get_output_path(output)
+        f2 = actors[0].get_output_path(output)
+        is_ok = compare_pdd(f1, f2, spacing, ax[i], tol=0.05) and is_ok
+    f = paths.output / "pdd_mu_table_cache.png"
+    plt.savefig(f)
+    print(f"PDD image saved in {f}")
+
+    utility.test_ok(is_ok)
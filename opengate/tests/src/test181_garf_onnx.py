@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import sys
+import itk
+import numpy as np
+import opengate as gate
+import opengate_core as g4
+import opengate.contrib.spect.ge_discovery_nm670 as gate_spect
+import test043_garf_helpers as test43
+from opengate.actors.arfactors import export_arf_to_onnx
+from opengate.tests import utility
+
+
+def create_simulation(name):
+    sim = gate.Simulation()
+    sim.number_of_threads = 2
+    sim.random_seed = 321654987
+    sim.output_dir = test43.paths.output
+
+    # units
+    nm = gate.g4_units.nm
+    cm = gate.g4_units.cm
+    mm = gate.g4_units.mm
+    Bq = gate.g4_units.Bq
+
+    sim.volume_manager.add_material_database(
+        test43.paths.gate_data / "GateMaterials.db"
+    )
+    test43.sim_set_world(sim)
+    head = gate_spect.add_fake_spect_head(sim, "spect")
+    head.translation = [0, 0, -15 * cm]
+    pos, crystal_dist, psd = gate_spect.get_plane_position_and_distance_to_crystal(
+        "lehr"
+    )
+    det_plane = test43.sim_add_detector_plane(sim, head.name, pos + 1 * nm)
+    test43.sim_phys(sim)
+    test43.sim_source_test(sim, 1e6 * Bq / sim.number_of_threads)
+
+    arf = sim.add_actor("ARFActor", "arf")
+    arf.attached_to = det_plane
+    arf.output_filename = f"test181_projection_{name}.mhd"
+    arf.batch_size = 2e5
+    arf.image_size = [128, 128]
+    arf.image_spacing = [4.41806 * mm, 4.41806 * mm]
+    arf.distance_to_crystal = 74.625 * mm
+    arf.pth_filename = test43.paths.gate_data / "pth" / "arf_Tc99m_v034.pth"
+    arf.flip_plane = True
+    arf.enable_hit_slice = True
+    arf.gpu_mode = "cpu"
+
+    stats = sim.add_actor("SimulationStatisticsActor", "stats")
+    return sim, arf, stats
+
+
+if __name__ == "__main__":
+    if not g4.GateInfo.get_ONNXRuntime():
+        print("opengate_core is compiled without ONNX Runtime, nothing to test")
+        utility.test_ok(True)
+        sys.exit(0)
+
+    # export the ARF network
+    onnx_filename = test43.paths.output / "test181_arf.onnx"
+    export_arf_to_onnx(
+        test43.paths.gate_data / "pth" / "arf_Tc99m_v034.pth", onnx_filename
+    )
+
+    # reference: inference in Python with torch
+    sim, arf_ref, stats = create_simulation("torch")
+    sim.run(start_new_process=True)
+    print(stats)
+
+    # inference on the cpp side, no python during the run
+    sim, arf, stats = create_simulation("onnx")
+    arf.backend = "onnx"
+    arf.onnx_filename = onnx_filename
+    sim.run()
+    print(stats)
+    print(f"Number of batches: {arf.batch_nb}")
+    print(f"Number of detected particles: {arf.detected_particles}")
+
+    # all the hits went through the cpp inference
+    is_ok = arf.native_inference and arf.detected_particles > 0
+    utility.print_test(is_ok, f"Native inference: {arf.native_inference}")
+
+    # the same hits (same seed), the same counts in each energy window
+    ref = itk.array_from_image(itk.imread(arf_ref.get_output_path()))
+    img = itk.array_from_image(itk.imread(arf.get_output_path()))
+    b = ref.shape == img.shape
+    utility.print_test(b, f"Same shape: {img.shape}")
+    is_ok = b and is_ok
+    for i in range(1, img.shape[0]):
+        s_ref = np.sum(ref[i])
+        s = np.sum(img[i])
+        b = s_ref > 0 and abs(s - s_ref) / s_ref < 0.03
+        utility.print_test(b, f"Window {i}: {s:.2f} vs {s_ref:.2f} (torch)")
+        is_ok = b and is_ok
+
+    # and the same projections
+    is_ok = (
+        utility.assert_images(
+            arf_ref.get_output_path(),
+            arf.get_output_path(),
+            stats,
+            tolerance=20,
+            ignore_value_data2=0,
+            axis="x",
+            sum_tolerance=3,
+        )
+        and is_ok
+    )
+
+    utility.test_ok(is_ok)
@@ -780,6 +780,34 @@ def get_default_test_paths(f, gate_folder=None, output_folder=None):
     return p
 
 
+def create_water_bone_phantom(
+    filename,
+    spacing=10,
+    size=(200, 200, 200),
+    bone_min=(0, 0, 120),
+    bone_max=(200, 200, 150),
+    bone_value=1000,
+):
+    """
+    Write the voxelized phantom of the tests: water (value 0) with a bone box
+    (bone_value, the HU of bone), see the voxel_materials of the tests.
+    The size of the image, its (isotropic) spacing and the corners of the bone
+    box (from the corner of the image) are in mm and in x y z order. The
+    default is a 20 cm water cube with 1 cm voxels and a 3 cm bone slab
+    across the image, from 12 to 15 cm along z.
+    """
+    size = np.asarray(size, dtype=float)
+    dims = np.round(size / spacing).astype(int)
+    lo = np.round(np.asarray(bone_min, dtype=float) / spacing).astype(int)
+    hi = np.round(np.asarray(bone_max, dtype=float) / spacing).astype(int)
+    # (numpy arrays of itk images are in z y x order)
+    arr = np.zeros(dims[::-1], dtype=np.float32)
+    arr[lo[2] : hi[2], lo[1] : hi[1], lo[0] : hi[0]] = bone_value
+    img = itk.image_from_array(arr)
+    img.SetSpacing([spacing] * 3)
+    itk.imwrite(img, str(filename))
+
+
 def compare_root2(root1, root2, branch1, branch2, keys, img_filename, n_tol=3):
     if not os.path.isfile(root1):
         fatal(f"Cannot open root file '{root1}'")
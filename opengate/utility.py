@@ -550,6 +550,9 @@ def print_opengate_info():
     print(f"Geant4 data      {g4.get_g4_data_folder()}")
 
     print(f"ITK version      {gi.get_ITKVersion()}")
+    print(f"ONNX Runtime     {gi.get_ONNXRuntime()}")
+    print(f"Mutex statistics {g4.IsMutexStatisticsEnabled()}")
+    print(f"Perf counters    {g4.IsPerfCountersAvailable()}")
 
     print(f"GATE version     {version('opengate')}")
     print(f"GATE folder      {module_path}")
@@ -35,6 +35,9 @@ def voxelize_geometry(
     margin=0,
     filename=None,
     return_path=False,
+    number_of_threads=0,
+    refinement_block_size=1,
+    supersampling=1,
 ):
     """Create a voxelized three-dimensional representation of the simulation geometry.
 
@@ -53,10 +56,21 @@ def voxelize_geometry(
         filename (str, optional) : The filename/path to which the voxelized image and labels are written.
             Suffix added automatically. Path can be relative to the global output directory of the simulation.
         return_path (bool) : Return the absolute path where the voxelized image was written?
+        number_of_threads (int) : Number of threads sharing the slices of the image
+            (0: all the cores).
+        refinement_block_size (int) : If larger than 1, the image is first voxelized by blocks
+            of this size (in voxels): the blocks whose 8 corners are in the same volume are
+            filled with it, only the other blocks are voxelized voxel by voxel. Faster for large
+            images, but a structure inside a block that does not reach its corners is missed.
+        supersampling (int) : If larger than 1, the boundary voxels (with a neighbour in another
+            volume) are sampled with supersampling^3 points to compute the fraction of each
+            volume in the voxel (partial volume).
 
     Returns:
-        dict, itk image, (path) : A dictionary containing the label to volume LUT; the voxelized geometry;
-            optionally: the absolute path where the image was written, if applicable.
+        dict, itk image, (dict), (path) : A dictionary containing the label to volume LUT; the
+            voxelized geometry; if supersampling > 1, a dictionary of the fraction images (float,
+            one per volume name); optionally: the absolute path where the image was written,
+            if applicable.
     """
     # collect volumes which are directly underneath the world/parallel worlds
     if extent in ("auto", "Auto"):
@@ -65,8 +79,15 @@ def voxelize_geometry(
         for pw in sim.volume_manager.parallel_world_volumes.values():
             extent.extend(list(pw.children))
 
-    labels, image = dispatch_to_subprocess(
-        compute_voxelized_geometry, sim, extent, spacing, margin
+    labels, image, fractions = dispatch_to_subprocess(
+        compute_voxelized_geometry,
+        sim,
+        extent,
+        spacing,
+        margin,
+        number_of_threads,
+        refinement_block_size,
+        supersampling,
     )
 
     if filename is not None:
@@ -83,10 +104,12 @@ def voxelize_geometry(
     else:
         outpath_mhd = "not_applicable"
 
+    output = (labels, image)
+    if fractions is not None:
+        output += (fractions,)
     if return_path is True:
-        return labels, image, outpath_mhd
-    else:
-        return labels, image
+        output += (outpath_mhd,)
+    return output
 
 
 def write_voxelized_geometry(
@@ -135,7 +158,15 @@ def write_voxelized_geometry(
     }
 
 
-def compute_voxelized_geometry(sim, extent, spacing, margin):
+def compute_voxelized_geometry(
+    sim,
+    extent,
+    spacing,
+    margin,
+    number_of_threads=0,
+    refinement_block_size=1,
+    supersampling=1,
+):
     """Method which returns a voxelized image of the simulation geometry
     given the extent, spacing and margin.
     The voxelization does not check which volume is voxelized.
@@ -165,25 +196,55 @@ def compute_voxelized_geometry(sim, extent, spacing, margin):
         se.initialize()
         vox = g4.GateVolumeVoxelizer()
         update_image_py_to_cpp(image, vox.fImage, False)
+        vox.fNumberOfThreads = number_of_threads
+        vox.fRefinementBlockSize = refinement_block_size
+        vox.fSupersampling = supersampling
         vox.Voxelize()
         image = get_py_image_from_cpp_image(vox.fImage)
         labels = vox.fLabels
+        fractions = None
+        if supersampling > 1:
+            fractions = create_fraction_images(image, labels, *vox.GetFractions())
         for key in labels.keys():
             vol = se.simulation.volume_manager.get_volume(key)
             labels[key] = {"label": labels[key], "material": vol.material}
 
     sim.verbose_level = vl
-    return labels, image
+    return labels, image, fractions
 
 
-def voxelized_source(itk_image, volumes_labels, activities):
+def create_fraction_images(image, labels, voxels, voxel_labels, voxel_fractions):
+    """Fraction images (one per volume name) from the label image and the fractions of the
+    labels in the boundary voxels (voxel index in the image buffer, label, fraction).
+    """
+    arr = itk.array_view_from_image(image).ravel()
+    fractions = {}
+    for name, label in labels.items():
+        f = (arr == label).astype(np.float32)
+        # the boundary voxels have only their sampled fractions
+        f[voxels] = 0
+        m = voxel_labels == label
+        f[voxels[m]] = voxel_fractions[m]
+        img = itk.image_from_array(f.reshape(itk.array_view_from_image(image).shape))
+        img.CopyInformation(image)
+        fractions[name] = img
+    return fractions
+
+
+def voxelized_source(itk_image, volumes_labels, activities, fractions=None):
     img_label = itk.GetArrayViewFromImage(itk_image)
     img_arr = itk.GetArrayFromImage(itk_image).astype(np.float32)
     img_arr[:, :, :] = 0.0
     for label in volumes_labels:
         l = volumes_labels[label]["label"]
         if label in activities:
-            img_arr[img_label == l] = activities[label]
+            if fractions is not None:
+                # partial volume: activity weighted by the fraction of the volume
+                img_arr += float(activities[label]) * itk.array_view_from_image(
+                    fractions[label]
+                )
+            else:
+                img_arr[img_label == l] = activities[label]
     itk_source = itk.GetImageFromArray(img_arr)
     itk_source.CopyInformation(itk_image)
     return itk_source